@@ -0,0 +1,133 @@
+#include "allocation.hpp"
+
+#include <cerrno>
+#include <cstdlib>
+#include <new>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+namespace blackhole {
+namespace benchmark {
+namespace allocation {
+namespace {
+
+// Plain integers, because counting must neither allocate nor run constructors.
+thread_local std::uint64_t count = 0;
+thread_local std::uint64_t bytes = 0;
+thread_local std::int64_t resident = 0;
+
+inline auto account(std::size_t size) noexcept -> void {
+    ++count;
+    bytes += size;
+}
+
+#if defined(__GLIBC__)
+inline auto retain(void* ptr) noexcept -> void* {
+    resident += static_cast<std::int64_t>(::malloc_usable_size(ptr));
+    return ptr;
+}
+
+inline auto release(void* ptr) noexcept -> void {
+    resident -= static_cast<std::int64_t>(::malloc_usable_size(ptr));
+}
+#endif
+
+}  // namespace
+
+auto enabled() -> bool {
+    static const bool result = std::getenv("BLACKHOLE_BENCH_ALLOCATIONS") != nullptr;
+    return result;
+}
+
+auto current() noexcept -> stats_t {
+    return {count, bytes, resident};
+}
+
+}  // namespace allocation
+}  // namespace benchmark
+}  // namespace blackhole
+
+namespace allocation = blackhole::benchmark::allocation;
+
+#if defined(__GLIBC__)
+
+extern "C" {
+
+auto __libc_malloc(std::size_t size) -> void*;
+auto __libc_calloc(std::size_t count, std::size_t size) -> void*;
+auto __libc_realloc(void* ptr, std::size_t size) -> void*;
+auto __libc_memalign(std::size_t alignment, std::size_t size) -> void*;
+auto __libc_free(void* ptr) -> void;
+
+auto malloc(std::size_t size) -> void* {
+    allocation::account(size);
+    return allocation::retain(__libc_malloc(size));
+}
+
+auto calloc(std::size_t count, std::size_t size) -> void* {
+    allocation::account(count * size);
+    return allocation::retain(__libc_calloc(count, size));
+}
+
+auto realloc(void* ptr, std::size_t size) -> void* {
+    allocation::account(size);
+    allocation::release(ptr);
+
+    if (const auto result = __libc_realloc(ptr, size)) {
+        return allocation::retain(result);
+    }
+
+    // The original block is left intact on failure, except being freed by zero sizes.
+    return size == 0 ? nullptr : allocation::retain(ptr);
+}
+
+// Aligned allocations are interposed as well, since all blocks are released through `free`.
+auto memalign(std::size_t alignment, std::size_t size) -> void* {
+    allocation::account(size);
+    return allocation::retain(__libc_memalign(alignment, size));
+}
+
+auto aligned_alloc(std::size_t alignment, std::size_t size) -> void* {
+    return memalign(alignment, size);
+}
+
+auto posix_memalign(void** ptr, std::size_t alignment, std::size_t size) -> int {
+    if (alignment % sizeof(void*) != 0 || (alignment & (alignment - 1)) != 0) {
+        return EINVAL;
+    }
+
+    if (const auto result = memalign(alignment, size)) {
+        *ptr = result;
+        return 0;
+    }
+
+    return ENOMEM;
+}
+
+auto free(void* ptr) -> void {
+    allocation::release(ptr);
+    __libc_free(ptr);
+}
+
+}  // extern "C"
+
+#else
+
+// Without glibc only C++ allocations are counted.
+auto operator new(std::size_t size) -> void* {
+    allocation::account(size);
+
+    if (const auto ptr = std::malloc(size > 0 ? size : 1)) {
+        return ptr;
+    }
+
+    throw std::bad_alloc();
+}
+
+auto operator delete(void* ptr) noexcept -> void {
+    std::free(ptr);
+}
+
+#endif
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+
+#include <benchmark/benchmark.h>
+
+namespace blackhole {
+namespace benchmark {
+namespace allocation {
+
+/// Allocations made by a thread.
+struct stats_t {
+    std::uint64_t count;
+    std::uint64_t bytes;
+    /// Usable bytes of blocks allocated minus the ones freed by the thread, which is how much memory
+    /// it keeps alive, including allocator rounding. Counted with glibc only, zero otherwise.
+    std::int64_t resident;
+};
+
+/// Returns whether allocations are reported, which is enabled by setting the
+/// `BLACKHOLE_BENCH_ALLOCATIONS` environment variable.
+auto enabled() -> bool;
+
+/// Returns allocations made by the calling thread so far.
+///
+/// Allocations are counted by interposing `malloc`, `calloc` and `realloc`, which every C++
+/// allocation goes through, so that hidden ones, like temporary strings or copied functions, are
+/// visible regardless of their origin.
+auto current() noexcept -> stats_t;
+
+/// Runs the given benchmark, reporting allocations and allocated bytes per iteration as the
+/// `allocs` and `bytes` counters if enabled.
+///
+/// Only allocations of benchmark threads are taken into account, background ones, like sink
+/// workers, are not. Allocations made during the benchmark setup are amortized by the number of
+/// iterations.
+template<void(*F)(::benchmark::State&)>
+void
+tracked(::benchmark::State& state) {
+    if (!enabled()) {
+        return F(state);
+    }
+
+    const auto before = current();
+    F(state);
+    const auto after = current();
+
+    const auto iterations = static_cast<double>(std::max<std::size_t>(1, state.iterations()));
+
+    state.counters["allocs"] = ::benchmark::Counter((after.count - before.count) / iterations,
+        ::benchmark::Counter::kAvgThreads);
+    state.counters["bytes"] = ::benchmark::Counter((after.bytes - before.bytes) / iterations,
+        ::benchmark::Counter::kAvgThreads);
+}
+
+}  // namespace allocation
+}  // namespace benchmark
+}  // namespace blackhole
@@ -6,6 +6,8 @@
 #   include <sys/time.h>
 #endif
 
+#include <blackhole/clock.hpp>
+
 #include "mod.hpp"
 
 namespace blackhole {
@@ -55,6 +57,19 @@ high_resolution_clock(::benchmark::State& state) {
     state.SetItemsProcessed(state.iterations());
 }
 
+static
+void
+clock_source(::benchmark::State& state) {
+    const auto source = static_cast<clock_source_t>(state.range(0));
+    clock::prepare(source);
+
+    while (state.KeepRunning()) {
+        clock::now(source);
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
 #ifdef __linux__
 NBENCHMARK("clock.coarse", monotonic_coarse);
 NBENCHMARK("clock.precise", monotonic_precise);
@@ -63,5 +78,12 @@ NBENCHMARK("clock.precise", monotonic_precise);
 NBENCHMARK("clock.system", system_clock);
 NBENCHMARK("clock.high_resolution", high_resolution_clock);
 
+NBENCHMARK("clock.source[precise]", clock_source)
+    ->Arg(static_cast<int>(clock_source_t::precise));
+NBENCHMARK("clock.source[coarse]", clock_source)
+    ->Arg(static_cast<int>(clock_source_t::coarse));
+NBENCHMARK("clock.source[tsc]", clock_source)
+    ->Arg(static_cast<int>(clock_source_t::tsc));
+
 }  // namespace benchmark
 }  // namespace blackhole
@@ -88,6 +88,23 @@ static void datetime_wheel_microseconds(::benchmark::State& state) {
     state.SetItemsProcessed(state.iterations());
 }
 
+static void datetime_wheel_offset(::benchmark::State& state) {
+    blackhole::detail::datetime::generator_t generator(
+        blackhole::detail::datetime::make_generator("%Y-%m-%dT%H:%M:%S.%f%z")
+    );
+
+    std::time_t time = std::time(0);
+    std::tm tm;
+    localtime_r(&time, &tm);
+
+    while (state.KeepRunning()) {
+        fmt::MemoryWriter wr;
+        generator(wr, tm);
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
 namespace {
 
 template<std::size_t length, char filler = '0'>
@@ -144,6 +161,7 @@ NBENCHMARK("datetime.strftime[locale]", datetime_strftime_with_locale);
 NBENCHMARK("datetime.blackhole", datetime_wheel);
 NBENCHMARK("datetime.blackhole[locale]", datetime_wheel_with_locale);
 NBENCHMARK("datetime.blackhole[with microseconds]", datetime_wheel_microseconds);
+NBENCHMARK("datetime.blackhole[with offset]", datetime_wheel_offset);
 
 }  // namespace benchmark
 }  // namespace blackhole
@@ -0,0 +1,202 @@
+/// Memory footprints of long-living objects, reported as the `resident` counter in bytes.
+///
+/// Each iteration constructs a single instance on the heap and measures usable bytes of blocks the
+/// benchmark thread keeps alive until it's destroyed, including the instance itself and allocator
+/// rounding. Memory allocated by background threads, like consumers of asynchronous sinks, is not
+/// taken into account. Footprints are measured with glibc only.
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <blackhole/attribute.hpp>
+#include <blackhole/attributes.hpp>
+#include <blackhole/formatter.hpp>
+#include <blackhole/formatter/binary.hpp>
+#include <blackhole/formatter/json.hpp>
+#include <blackhole/formatter/logfmt.hpp>
+#include <blackhole/formatter/string.hpp>
+#include <blackhole/handler.hpp>
+#include <blackhole/handler/blocking.hpp>
+#include <blackhole/record.hpp>
+#include <blackhole/root.hpp>
+#include <blackhole/scope/holder.hpp>
+#include <blackhole/sink.hpp>
+#include <blackhole/sink/console.hpp>
+#include <blackhole/sink/file.hpp>
+#include <blackhole/wrapper.hpp>
+#include <blackhole/detail/recordbuf.hpp>
+#include <blackhole/detail/sink/asynchronous.hpp>
+
+#include "mod.hpp"
+
+namespace blackhole {
+namespace benchmark {
+namespace {
+
+typedef std::vector<std::unique_ptr<handler_t>> handlers_t;
+
+class null_t : public sink_t {
+public:
+    auto emit(const record_t&, const string_view&) -> void override {}
+};
+
+/// Returns the given number of attributes with short string values.
+auto make_attributes(std::size_t size) -> attributes_t {
+    attributes_t result;
+    for (std::size_t id = 0; id < size; ++id) {
+        result.emplace_back("key#" + std::to_string(id), "value#" + std::to_string(id));
+    }
+
+    return result;
+}
+
+/// Measures the average footprint of instances constructed by the given function.
+template<typename F>
+auto measure(::benchmark::State& state, const F& make) -> void {
+    std::int64_t total = 0;
+
+    while (state.KeepRunning()) {
+        const auto before = allocation::current().resident;
+        auto instance = make();
+        total += allocation::current().resident - before;
+
+        ::benchmark::DoNotOptimize(instance);
+    }
+
+    const auto iterations = static_cast<double>(std::max<std::size_t>(1, state.iterations()));
+    state.counters["resident"] = ::benchmark::Counter(static_cast<double>(total) / iterations);
+}
+
+auto handlers() -> handlers_t {
+    handlers_t result;
+    result.push_back(builder<handler::blocking_t>()
+        .set(builder<formatter::string_t>("{message}").build())
+        .add(std::unique_ptr<sink_t>(new null_t))
+        .build());
+
+    return result;
+}
+
+}  // namespace
+
+static void root(::benchmark::State& state) {
+    measure(state, [] {
+        return std::unique_ptr<root_logger_t>(new root_logger_t(handlers_t()));
+    });
+}
+
+static void root_handler(::benchmark::State& state) {
+    measure(state, [] {
+        return std::unique_ptr<root_logger_t>(new root_logger_t(handlers()));
+    });
+}
+
+static void wrapper(::benchmark::State& state) {
+    root_logger_t logger{handlers_t()};
+    const auto attributes = make_attributes(static_cast<std::size_t>(state.range_x()));
+
+    measure(state, [&] {
+        return std::unique_ptr<wrapper_t>(new wrapper_t(logger, attributes));
+    });
+}
+
+static void wrapper_compact(::benchmark::State& state) {
+    root_logger_t logger{handlers_t()};
+    const auto attributes = make_attributes(static_cast<std::size_t>(state.range_x()));
+
+    measure(state, [&] {
+        return std::unique_ptr<compact_wrapper_t>(new compact_wrapper_t(logger, attributes));
+    });
+}
+
+static void scope(::benchmark::State& state) {
+    root_logger_t logger{handlers_t()};
+    const auto attributes = make_attributes(static_cast<std::size_t>(state.range_x()));
+
+    // Each holder is destroyed before the next one is constructed, keeping the stack order.
+    measure(state, [&] {
+        return std::unique_ptr<scope::holder_t>(new scope::holder_t(logger, attributes));
+    });
+}
+
+static void recordbuf(::benchmark::State& state) {
+    const string_view message("GET /porn.png HTTP/1.1");
+    const auto attributes = make_attributes(static_cast<std::size_t>(state.range_x()));
+
+    attribute_list list;
+    for (const auto& attribute : attributes) {
+        list.emplace_back(attribute.first, attribute.second);
+    }
+
+    const attribute_pack pack{list};
+    const record_t record(42, message, pack);
+
+    measure(state, [&] {
+        return std::unique_ptr<detail::recordbuf_t>(new detail::recordbuf_t(record));
+    });
+}
+
+static void asynchronous(::benchmark::State& state) {
+    const auto factor = static_cast<std::size_t>(state.range_x());
+
+    measure(state, [&] {
+        return std::unique_ptr<sink_t>(new sink::asynchronous_t(
+            std::unique_ptr<sink_t>(new null_t), factor));
+    });
+}
+
+static void formatter_string(::benchmark::State& state) {
+    measure(state, [] {
+        return builder<formatter::string_t>("[{severity}] {timestamp}: {message}").build();
+    });
+}
+
+static void formatter_json(::benchmark::State& state) {
+    measure(state, [] {
+        return builder<formatter::json_t>().build();
+    });
+}
+
+static void formatter_logfmt(::benchmark::State& state) {
+    measure(state, [] {
+        return builder<formatter::logfmt_t>().build();
+    });
+}
+
+static void formatter_binary(::benchmark::State& state) {
+    measure(state, [] {
+        return builder<formatter::binary_t>().build();
+    });
+}
+
+static void sink_console(::benchmark::State& state) {
+    measure(state, [] {
+        return builder<sink::console_t>().build();
+    });
+}
+
+static void sink_file(::benchmark::State& state) {
+    measure(state, [] {
+        return builder<sink::file_t>("/dev/null").build();
+    });
+}
+
+NBENCHMARK("footprint.root", root);
+NBENCHMARK("footprint.root[handler]", root_handler);
+NBENCHMARK("footprint.wrapper", wrapper)->Arg(0)->Arg(1)->Arg(4)->Arg(16);
+NBENCHMARK("footprint.wrapper[compact]", wrapper_compact)->Arg(0)->Arg(1)->Arg(4)->Arg(16);
+NBENCHMARK("footprint.scope", scope)->Arg(1)->Arg(4)->Arg(16);
+NBENCHMARK("footprint.recordbuf", recordbuf)->Arg(0)->Arg(4)->Arg(16);
+NBENCHMARK("footprint.asynchronous", asynchronous)->DenseRange(4, 12);
+NBENCHMARK("footprint.formatter[string]", formatter_string);
+NBENCHMARK("footprint.formatter[json]", formatter_json);
+NBENCHMARK("footprint.formatter[logfmt]", formatter_logfmt);
+NBENCHMARK("footprint.formatter[binary]", formatter_binary);
+NBENCHMARK("footprint.sink[console]", sink_console);
+NBENCHMARK("footprint.sink[file]", sink_file);
+
+}  // namespace benchmark
+}  // namespace blackhole
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace blackhole {
+namespace latency {
+
+/// High dynamic range histogram of non-negative integer values, nanoseconds usually.
+///
+/// Values are grouped by their highest set bit into power of two ranges, each of which is split
+/// into linear buckets, so the relative error of recorded values is below 0.2% over the whole
+/// 64-bit range while taking constant time to record.
+class histogram_t {
+    /// Number of bits of precision kept, i.e. values below 2^precision are recorded exactly.
+    static constexpr int precision = 10;
+    static constexpr std::uint64_t exact = 1ull << precision;
+    static constexpr std::uint64_t half = exact / 2;
+
+    std::vector<std::uint64_t> counts;
+    std::uint64_t total;
+    std::uint64_t maximum;
+
+public:
+    histogram_t() :
+        counts(index(~0ull) + 1),
+        total(0),
+        maximum(0)
+    {}
+
+    auto record(std::uint64_t value) -> void {
+        ++counts[index(value)];
+        ++total;
+
+        if (value > maximum) {
+            maximum = value;
+        }
+    }
+
+    auto merge(const histogram_t& other) -> void {
+        for (std::size_t id = 0; id < counts.size(); ++id) {
+            counts[id] += other.counts[id];
+        }
+
+        total += other.total;
+
+        if (other.maximum > maximum) {
+            maximum = other.maximum;
+        }
+    }
+
+    auto count() const noexcept -> std::uint64_t {
+        return total;
+    }
+
+    auto max() const noexcept -> std::uint64_t {
+        return maximum;
+    }
+
+    /// Returns the highest value equivalent to the one at the given quantile, which must be within
+    /// [0; 1] range, or zero if the histogram is empty.
+    auto quantile(double q) const -> std::uint64_t {
+        if (total == 0) {
+            return 0;
+        }
+
+        auto rank = static_cast<std::uint64_t>(q * static_cast<double>(total) + 0.5);
+        if (rank == 0) {
+            rank = 1;
+        }
+
+        std::uint64_t accumulated = 0;
+        for (std::size_t id = 0; id < counts.size(); ++id) {
+            accumulated += counts[id];
+
+            if (accumulated >= rank) {
+                const auto value = highest(id);
+                return value < maximum ? value : maximum;
+            }
+        }
+
+        return maximum;
+    }
+
+private:
+    static auto index(std::uint64_t value) noexcept -> std::size_t {
+        if (value < exact) {
+            return static_cast<std::size_t>(value);
+        }
+
+        const auto shift = 63 - __builtin_clzll(value) - (precision - 1);
+        return static_cast<std::size_t>(shift * half + (value >> shift));
+    }
+
+    static auto highest(std::size_t id) noexcept -> std::uint64_t {
+        if (id < exact) {
+            return id;
+        }
+
+        const auto shift = id / half - 1;
+        const auto mantissa = id - shift * half;
+        return ((mantissa + 1) << shift) - 1;
+    }
+};
+
+}  // namespace latency
+}  // namespace blackhole
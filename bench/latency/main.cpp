@@ -0,0 +1,269 @@
+/// Measures the latency distribution of logging calls under a fixed rate load.
+///
+/// Each thread issues logging calls on a fixed schedule instead of back to back, recording both
+/// the service time, measured from the actual start of the call, and the response time, measured
+/// from its intended start. A stalled call delays the following ones, which a closed loop harness
+/// never accounts for, known as coordinated omission. The response time includes such delays,
+/// so both distributions diverge when it happens.
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <blackhole/attribute.hpp>
+#include <blackhole/attributes.hpp>
+#include <blackhole/detail/sink/asynchronous.hpp>
+#include <blackhole/extensions/facade.hpp>
+#include <blackhole/formatter.hpp>
+#include <blackhole/formatter/string.hpp>
+#include <blackhole/handler.hpp>
+#include <blackhole/handler/blocking.hpp>
+#include <blackhole/root.hpp>
+#include <blackhole/sink.hpp>
+
+#include "histogram.hpp"
+
+namespace blackhole {
+namespace latency {
+namespace {
+
+typedef std::chrono::steady_clock clock_type;
+
+/// Sink discarding messages after spending the given time busy on each of them.
+class discard_t : public sink_t {
+    std::chrono::nanoseconds cost;
+
+public:
+    explicit discard_t(std::chrono::nanoseconds cost = std::chrono::nanoseconds(0)) :
+        cost(cost)
+    {}
+
+    auto emit(const record_t&, const string_view&) -> void override {
+        if (cost.count() == 0) {
+            return;
+        }
+
+        const auto deadline = clock_type::now() + cost;
+        while (clock_type::now() < deadline) {
+        }
+    }
+};
+
+struct options_t {
+    /// Calls per second issued by each thread.
+    std::uint64_t rate;
+    std::chrono::milliseconds duration;
+    std::size_t threads;
+    /// Time the slow sink spends on each event to keep the asynchronous queue full.
+    std::chrono::nanoseconds cost;
+
+    options_t() :
+        rate(10000),
+        duration(2000),
+        threads(std::thread::hardware_concurrency()),
+        cost(200000)
+    {}
+};
+
+struct configuration_t {
+    const char* name;
+    std::function<auto(const options_t& options) -> std::unique_ptr<sink_t>> sink;
+};
+
+auto asynchronous(std::unique_ptr<sink_t> sink, const char* policy) -> std::unique_ptr<sink_t> {
+    return std::unique_ptr<sink_t>(new sink::asynchronous_t(std::move(sink), 10,
+        sink::overflow_policy_factory_t().create(policy)));
+}
+
+auto configurations() -> std::vector<configuration_t> {
+    return {
+        {"blocking", [](const options_t&) {
+            return std::unique_ptr<sink_t>(new discard_t);
+        }},
+        {"asynchronous[empty]", [](const options_t&) {
+            return asynchronous(std::unique_ptr<sink_t>(new discard_t), "wait");
+        }},
+        {"asynchronous[full, wait]", [](const options_t& options) {
+            return asynchronous(std::unique_ptr<sink_t>(new discard_t(options.cost)), "wait");
+        }},
+        {"asynchronous[full, drop]", [](const options_t& options) {
+            return asynchronous(std::unique_ptr<sink_t>(new discard_t(options.cost)), "drop");
+        }},
+    };
+}
+
+struct result_t {
+    /// Time from the actual start of each call to its completion.
+    histogram_t service;
+    /// Time from the intended start of each call to its completion.
+    histogram_t response;
+    /// Number of calls started later than a whole period after their intended start.
+    std::uint64_t late;
+
+    result_t() : late(0) {}
+
+    auto merge(const result_t& other) -> void {
+        service.merge(other.service);
+        response.merge(other.response);
+        late += other.late;
+    }
+};
+
+/// Issues logging calls on a fixed schedule from the given start until the stop time.
+auto load(root_logger_t& root, const options_t& options, clock_type::time_point start,
+    clock_type::time_point stop) -> result_t
+{
+    logger_facade<root_logger_t> logger(root);
+
+    const auto period = std::chrono::nanoseconds(1000000000 / options.rate);
+    result_t result;
+
+    for (std::uint64_t id = 0;; ++id) {
+        const auto intended = start + period * id;
+        if (intended >= stop) {
+            break;
+        }
+
+        auto now = clock_type::now();
+        if (intended - now > std::chrono::microseconds(100)) {
+            std::this_thread::sleep_until(intended - std::chrono::microseconds(50));
+        }
+
+        while ((now = clock_type::now()) < intended) {
+        }
+
+        logger.log(0, "{} - {} [{}] 'GET {} HTTP/1.0' {} {}",
+            "[::]", "esafronov", "10/Oct/2000:13:55:36 -0700", "/porn.png", 200, 2326,
+            attribute_list{
+                {"key#6", {42}},
+                {"key#7", {3.1415}},
+                {"key#8", {"value"}}
+            }
+        );
+
+        const auto done = clock_type::now();
+        result.service.record(static_cast<std::uint64_t>((done - now).count()));
+        result.response.record(static_cast<std::uint64_t>((done - intended).count()));
+
+        if (now - intended > period) {
+            ++result.late;
+        }
+    }
+
+    return result;
+}
+
+auto run(const configuration_t& configuration, const options_t& options, std::size_t threads) ->
+    result_t
+{
+    std::vector<std::unique_ptr<handler_t>> handlers;
+    handlers.push_back(builder<handler::blocking_t>()
+        .set(builder<formatter::string_t>("{timestamp} {severity}: {message} {...}").build())
+        .add(configuration.sink(options))
+        .build());
+
+    root_logger_t root(std::move(handlers));
+
+    // Give all threads time to start, so that none of them begins behind the schedule.
+    const auto start = clock_type::now() + std::chrono::milliseconds(10);
+    const auto stop = start + options.duration;
+
+    std::vector<result_t> results(threads);
+    std::vector<std::thread> workers;
+
+    for (std::size_t id = 0; id < threads; ++id) {
+        workers.emplace_back([&, id] {
+            results[id] = load(root, options, start, stop);
+        });
+    }
+
+    result_t result;
+    for (std::size_t id = 0; id < threads; ++id) {
+        workers[id].join();
+        result.merge(results[id]);
+    }
+
+    return result;
+}
+
+auto print(const histogram_t& histogram) -> void {
+    for (auto q : {0.5, 0.99, 0.999}) {
+        std::printf(" %10.1f", static_cast<double>(histogram.quantile(q)) / 1000.0);
+    }
+
+    std::printf(" %10.1f", static_cast<double>(histogram.max()) / 1000.0);
+}
+
+auto usage(const char* name) -> void {
+    std::fprintf(stderr,
+        "Usage: %s [--rate CALLS] [--duration MS] [--threads COUNT] [--cost NS]\n"
+        "  --rate      calls per second issued by each thread, 10000 by default\n"
+        "  --duration  duration of each run in milliseconds, 2000 by default\n"
+        "  --threads   maximum number of threads, doubled from one on each run\n"
+        "  --cost      nanoseconds the slow sink spends on each event, 200000 by default\n",
+        name);
+}
+
+}  // namespace
+}  // namespace latency
+}  // namespace blackhole
+
+auto main(int argc, char** argv) -> int {
+    using namespace blackhole::latency;
+
+    options_t options;
+
+    for (int id = 1; id < argc; ++id) {
+        if (id + 1 == argc) {
+            usage(argv[0]);
+            return 1;
+        }
+
+        const auto value = std::strtoull(argv[id + 1], nullptr, 10);
+
+        if (std::strcmp(argv[id], "--rate") == 0 && value > 0) {
+            options.rate = value;
+        } else if (std::strcmp(argv[id], "--duration") == 0 && value > 0) {
+            options.duration = std::chrono::milliseconds(value);
+        } else if (std::strcmp(argv[id], "--threads") == 0 && value > 0) {
+            options.threads = static_cast<std::size_t>(value);
+        } else if (std::strcmp(argv[id], "--cost") == 0) {
+            options.cost = std::chrono::nanoseconds(value);
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+
+        ++id;
+    }
+
+    std::printf("%-26s %7s %10s %7s | %-43s | %-43s\n", "", "", "", "",
+        "service, us", "response, us");
+    std::printf("%-26s %7s %10s %7s | %10s %10s %10s %10s | %10s %10s %10s %10s\n",
+        "configuration", "threads", "calls", "late", "p50", "p99", "p99.9", "max",
+        "p50", "p99", "p99.9", "max");
+
+    for (const auto& configuration : configurations()) {
+        for (std::size_t threads = 1; threads <= options.threads; threads *= 2) {
+            const auto result = run(configuration, options, threads);
+
+            std::printf("%-26s %7zu %10llu %6.2f%% |", configuration.name, threads,
+                static_cast<unsigned long long>(result.service.count()),
+                100.0 * static_cast<double>(result.late) /
+                    static_cast<double>(result.service.count()));
+            print(result.service);
+            std::printf(" |");
+            print(result.response);
+            // Calls starting behind the schedule mean the previous ones stalled the thread, which
+            // only the response time accounts for.
+            std::printf(result.late != 0 ? " coordinated omission\n" : "\n");
+            std::fflush(stdout);
+        }
+    }
+
+    return 0;
+}
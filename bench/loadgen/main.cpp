@@ -0,0 +1,435 @@
+/// Drives a logger built from the given JSON config with synthetic load described by a profile,
+/// reporting sustained throughput, drops, queue depths and the latency distribution of logging
+/// calls, which helps to size queues, overflow policies and flushers before deploying.
+///
+/// The profile is a JSON object, where all fields are optional, like:
+///     {"threads": 4, "duration": 30, "rate": 200000, "severity": {"min": 0, "max": 3},
+///      "message": {"min": 32, "max": 512},
+///      "attributes": {"count": {"min": 0, "max": 8}, "size": {"mean": 16, "max": 128,
+///          "distribution": "exponential"}},
+///      "burst": {"period": 1000, "length": 100, "factor": 10}}
+///
+/// The rate is the total number of records per second shared by all threads, zero means as fast as
+/// possible. Sizes are either uniformly distributed over [min; max] or exponentially with the given
+/// mean, clamped to [min; max]. During the first `length` milliseconds of each burst `period` the
+/// rate is multiplied by the burst factor.
+///
+/// Events are generated in advance, so only logging calls are measured. Drops and queue depths are
+/// taken from self-metrics of the logger, summing all `*_dropped_total` counters and `*_depth`
+/// gauges respectively.
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/optional/optional.hpp>
+
+#include <blackhole/attribute.hpp>
+#include <blackhole/attributes.hpp>
+#include <blackhole/builder.hpp>
+#include <blackhole/config/json.hpp>
+#include <blackhole/config/node.hpp>
+#include <blackhole/config/option.hpp>
+#include <blackhole/metrics.hpp>
+#include <blackhole/registry.hpp>
+#include <blackhole/root.hpp>
+
+#include "latency/histogram.hpp"
+
+namespace blackhole {
+namespace loadgen {
+namespace {
+
+typedef std::chrono::steady_clock clock_type;
+
+using latency::histogram_t;
+
+/// Number of distinct events generated for each thread, which are logged round-robin.
+constexpr std::size_t pool = 4096;
+
+struct distribution_t {
+    enum class kind_t {
+        uniform,
+        exponential
+    };
+
+    kind_t kind;
+    std::size_t min;
+    std::size_t max;
+    double mean;
+
+    auto sample(std::mt19937_64& random) const -> std::size_t {
+        if (kind == kind_t::uniform) {
+            return std::uniform_int_distribution<std::size_t>(min, max)(random);
+        }
+
+        const auto value = std::exponential_distribution<double>(1.0 / mean)(random);
+        return std::min(max, std::max(min, static_cast<std::size_t>(value)));
+    }
+};
+
+struct burst_t {
+    std::chrono::milliseconds period;
+    std::chrono::milliseconds length;
+    double factor;
+};
+
+struct profile_t {
+    std::size_t threads;
+    std::chrono::seconds duration;
+    /// Total number of records per second, unbounded if zero.
+    double rate;
+    distribution_t severity;
+    distribution_t message;
+    distribution_t count;
+    distribution_t size;
+    burst_t burst;
+};
+
+struct event_t {
+    int severity;
+    std::string message;
+    attributes_t attributes;
+    attribute_list view;
+};
+
+struct options_t {
+    std::string logger;
+    std::chrono::milliseconds interval;
+
+    options_t() :
+        logger("root"),
+        interval(1000)
+    {}
+};
+
+auto distribution_from(const config::option<config::node_t>& config, std::size_t min,
+    std::size_t max) -> distribution_t
+{
+    distribution_t result{distribution_t::kind_t::uniform, min, max, 0.0};
+
+    if (!config.unwrap()) {
+        return result;
+    }
+
+    result.min = static_cast<std::size_t>(config["min"].to_uint64().get_value_or(min));
+    result.max = static_cast<std::size_t>(config["max"].to_uint64().get_value_or(max));
+
+    const auto kind = config["distribution"].to_string().get_value_or("uniform");
+    if (kind == "exponential") {
+        result.kind = distribution_t::kind_t::exponential;
+        result.mean = config["mean"].to_double().get_value_or(
+            static_cast<double>(result.min + result.max) / 2);
+    } else if (kind != "uniform") {
+        throw std::invalid_argument("no distribution with name \"" + kind + "\" found");
+    }
+
+    if (result.min > result.max) {
+        throw std::invalid_argument("distribution minimum must not exceed its maximum");
+    }
+
+    if (result.kind == distribution_t::kind_t::exponential && result.mean <= 0.0) {
+        throw std::invalid_argument("exponential distribution mean must be positive");
+    }
+
+    return result;
+}
+
+auto load(const std::string& path) -> profile_t {
+    std::ifstream stream(path);
+    if (!stream) {
+        throw std::invalid_argument("failed to open profile " + path);
+    }
+
+    const auto factory = config::factory_traits<config::json_t>::construct(stream);
+    const auto& config = factory->config();
+
+    profile_t profile;
+    profile.threads = static_cast<std::size_t>(config["threads"].to_uint64().get_value_or(1));
+    profile.duration = std::chrono::seconds(config["duration"].to_uint64().get_value_or(10));
+    profile.rate = config["rate"].to_double().get_value_or(0.0);
+    profile.severity = distribution_from(config["severity"], 0, 0);
+    profile.message = distribution_from(config["message"], 64, 64);
+    profile.count = distribution_from(config["attributes"]["count"], 0, 0);
+    profile.size = distribution_from(config["attributes"]["size"], 16, 16);
+    profile.burst = burst_t{
+        std::chrono::milliseconds(config["burst"]["period"].to_uint64().get_value_or(0)),
+        std::chrono::milliseconds(config["burst"]["length"].to_uint64().get_value_or(0)),
+        config["burst"]["factor"].to_double().get_value_or(1.0)
+    };
+
+    if (profile.threads == 0) {
+        throw std::invalid_argument("profile requires at least one thread");
+    }
+
+    if (profile.rate < 0.0 || profile.burst.factor <= 0.0) {
+        throw std::invalid_argument("rate and burst factor must be positive");
+    }
+
+    return profile;
+}
+
+auto text(std::mt19937_64& random, std::size_t size) -> std::string {
+    static const char alphabet[] = "abcdefghijklmnopqrstuvwxyz0123456789";
+
+    std::uniform_int_distribution<std::size_t> letter(0, sizeof(alphabet) - 2);
+
+    std::string result(size, ' ');
+    for (auto& ch : result) {
+        ch = alphabet[letter(random)];
+    }
+
+    return result;
+}
+
+auto generate(const profile_t& profile, std::size_t seed) -> std::vector<event_t> {
+    std::mt19937_64 random(seed);
+
+    std::vector<event_t> events(pool);
+    for (auto& event : events) {
+        event.severity = static_cast<int>(profile.severity.sample(random));
+        event.message = text(random, profile.message.sample(random));
+
+        const auto count = profile.count.sample(random);
+        for (std::size_t id = 0; id < count; ++id) {
+            event.attributes.emplace_back("attr#" + std::to_string(id),
+                text(random, profile.size.sample(random)));
+        }
+    }
+
+    // Views are built after generating, since growing the vector moves attributes.
+    for (auto& event : events) {
+        for (const auto& attribute : event.attributes) {
+            event.view.emplace_back(attribute.first, attribute.second);
+        }
+    }
+
+    return events;
+}
+
+/// Returns the rate multiplier at the given time since the start.
+auto factor(const burst_t& burst, clock_type::duration elapsed) -> double {
+    if (burst.period.count() == 0) {
+        return 1.0;
+    }
+
+    return elapsed % burst.period < burst.length ? burst.factor : 1.0;
+}
+
+/// Logs events until the deadline, pacing calls to the rate of this thread.
+auto run(root_logger_t& logger, const std::vector<event_t>& events, const profile_t& profile,
+    clock_type::time_point start, std::atomic<std::uint64_t>& total) -> histogram_t
+{
+    histogram_t histogram;
+
+    const auto deadline = start + profile.duration;
+    const auto rate = profile.rate / static_cast<double>(profile.threads);
+
+    auto next = start;
+
+    for (std::size_t id = 0;; ++id) {
+        auto now = clock_type::now();
+
+        if (rate > 0.0) {
+            // Short gaps are spun instead of slept, since sleeping overshoots them.
+            if (next - now > std::chrono::microseconds(100)) {
+                std::this_thread::sleep_until(next);
+            }
+
+            while ((now = clock_type::now()) < next) {}
+        }
+
+        if (now >= deadline) {
+            break;
+        }
+
+        const auto& event = events[id % events.size()];
+
+        attribute_pack pack{event.view};
+
+        const auto begin = clock_type::now();
+        logger.log(event.severity, string_view(event.message), pack);
+        const auto done = clock_type::now();
+
+        histogram.record(static_cast<std::uint64_t>((done - begin).count()));
+        total.fetch_add(1, std::memory_order_relaxed);
+
+        if (rate > 0.0) {
+            // The schedule is kept even when falling behind, so it catches up after stalls.
+            const auto gap = 1.0 / (rate * factor(profile.burst, next - start));
+            next += std::chrono::duration_cast<clock_type::duration>(
+                std::chrono::duration<double>(gap));
+        }
+    }
+
+    return histogram;
+}
+
+struct totals_t {
+    std::uint64_t dropped;
+    std::uint64_t depth;
+};
+
+auto ends_with(const std::string& value, const char* suffix) -> bool {
+    const auto size = std::strlen(suffix);
+    return value.size() >= size && value.compare(value.size() - size, size, suffix) == 0;
+}
+
+auto totals(const root_logger_t& logger) -> totals_t {
+    totals_t result{0, 0};
+
+    for (const auto& sample : logger.metrics()) {
+        if (sample.kind == metrics::sample_t::kind_t::counter &&
+            ends_with(sample.name, "_dropped_total"))
+        {
+            result.dropped += sample.value;
+        } else if (sample.kind == metrics::sample_t::kind_t::gauge &&
+            ends_with(sample.name, "_depth"))
+        {
+            result.depth += sample.value;
+        }
+    }
+
+    return result;
+}
+
+auto loadgen(const std::string& config, const std::string& path, const options_t& options) ->
+    int
+{
+    const auto profile = load(path);
+
+    std::ifstream stream(config);
+    if (!stream) {
+        throw std::invalid_argument("failed to open config " + config);
+    }
+
+    const auto registry = registry::configured();
+    auto builder = registry->builder<config::json_t>(stream);
+    auto logger = builder.build(options.logger);
+
+    std::vector<std::vector<event_t>> events;
+    for (std::size_t id = 0; id < profile.threads; ++id) {
+        events.push_back(generate(profile, id + 1));
+    }
+
+    std::atomic<std::uint64_t> total(0);
+    std::vector<histogram_t> results(profile.threads);
+    std::vector<std::thread> workers;
+
+    const auto start = clock_type::now() + std::chrono::milliseconds(10);
+
+    for (std::size_t id = 0; id < profile.threads; ++id) {
+        workers.emplace_back([&, id] {
+            results[id] = run(logger, events[id], profile, start, total);
+        });
+    }
+
+    std::printf("%9s %14s %12s %10s\n", "time, s", "records/s", "dropped", "depth");
+
+    std::uint64_t last = 0;
+    std::uint64_t depth = 0;
+
+    for (auto tick = start + options.interval; tick <= start + profile.duration;
+        tick += options.interval)
+    {
+        std::this_thread::sleep_until(tick);
+
+        const auto count = total.load(std::memory_order_relaxed);
+        const auto current = totals(logger);
+        const auto seconds = std::chrono::duration<double>(options.interval).count();
+
+        std::printf("%9.1f %14.0f %12llu %10llu\n",
+            std::chrono::duration<double>(tick - start).count(),
+            static_cast<double>(count - last) / seconds,
+            static_cast<unsigned long long>(current.dropped),
+            static_cast<unsigned long long>(current.depth));
+
+        last = count;
+        depth = std::max(depth, current.depth);
+    }
+
+    histogram_t result;
+    for (std::size_t id = 0; id < profile.threads; ++id) {
+        workers[id].join();
+        result.merge(results[id]);
+    }
+
+    const auto elapsed = std::chrono::duration<double>(clock_type::now() - start).count();
+
+    const auto flushed = logger.flush(std::chrono::seconds(10));
+    const auto summary = totals(logger);
+
+    std::printf("\n%12s %14s %12s %10s | %10s %10s %10s %10s\n",
+        "records", "records/s", "dropped", "max depth", "p50, us", "p99, us", "p99.9, us",
+        "max, us");
+    std::printf("%12llu %14.0f %12llu %10llu |",
+        static_cast<unsigned long long>(result.count()),
+        static_cast<double>(result.count()) / elapsed,
+        static_cast<unsigned long long>(summary.dropped),
+        static_cast<unsigned long long>(depth));
+
+    for (auto q : {0.5, 0.99, 0.999}) {
+        std::printf(" %10.2f", static_cast<double>(result.quantile(q)) / 1000.0);
+    }
+
+    std::printf(" %10.2f\n", static_cast<double>(result.max()) / 1000.0);
+
+    if (!flushed) {
+        std::fprintf(stderr, "loadgen: failed to flush the logger in 10 seconds\n");
+    }
+
+    return 0;
+}
+
+auto usage(const char* name) -> void {
+    std::fprintf(stderr,
+        "Usage: %s [--logger NAME] [--interval MS] CONFIG PROFILE\n"
+        "  --logger    name of the logger built from the config, root by default\n"
+        "  --interval  interval of progress reports in milliseconds, 1000 by default\n",
+        name);
+}
+
+}  // namespace
+}  // namespace loadgen
+}  // namespace blackhole
+
+auto main(int argc, char** argv) -> int {
+    using namespace blackhole::loadgen;
+
+    options_t options;
+
+    int id = 1;
+    for (; id + 1 < argc && std::strncmp(argv[id], "--", 2) == 0; id += 2) {
+        const auto value = std::strtoull(argv[id + 1], nullptr, 10);
+
+        if (std::strcmp(argv[id], "--logger") == 0) {
+            options.logger = argv[id + 1];
+        } else if (std::strcmp(argv[id], "--interval") == 0 && value > 0) {
+            options.interval = std::chrono::milliseconds(value);
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (argc - id != 2) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    try {
+        return loadgen(argv[id], argv[id + 1], options);
+    } catch (const std::exception& err) {
+        std::fprintf(stderr, "loadgen: %s\n", err.what());
+        return 1;
+    }
+}
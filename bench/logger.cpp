@@ -4,6 +4,7 @@
 #include <benchmark/benchmark.h>
 
 #include <blackhole/attribute.hpp>
+#include <blackhole/deferred.hpp>
 #include <blackhole/extensions/facade.hpp>
 #include <blackhole/handler.hpp>
 #include <blackhole/logger.hpp>
@@ -109,6 +110,22 @@ literal_with_args_using_cpp14_formatter(::benchmark::State& state) {
 }
 #endif
 
+static
+void
+literal_with_args_deferred(::benchmark::State& state) {
+    root_logger_t root({});
+    deferred_t logger(root);
+
+    static const deferred::callsite_t callsite("{} - {} [{}] 'GET {} HTTP/1.0' {} {}");
+
+    while (state.KeepRunning()) {
+        logger.log(callsite, 0,
+            "[::]", "esafronov", "10/Oct/2000:13:55:36 -0700", "/porn.png", 200, 2326);
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
 static
 void
 literal_with_attributes(::benchmark::State& state) {
@@ -126,6 +143,52 @@ literal_with_attributes(::benchmark::State& state) {
     state.SetItemsProcessed(state.iterations());
 }
 
+static
+void
+literal_with_typed_attributes(::benchmark::State& state) {
+    root_logger_t root({});
+    logger_facade<root_logger_t> logger(root);
+
+    while (state.KeepRunning()) {
+        logger.log(0, "[::] - esafronov [10/Oct/2000:13:55:36 -0700] 'GET /porn.png HTTP/1.0' 200 2326",
+            attr("key#1", 42), attr("key#2", 3.1415), attr("key#3", "value"));
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+static
+void
+literal_with_attributes_reject_severity(::benchmark::State& state) {
+    root_logger_t root({});
+    root.threshold(1);
+
+    logger_facade<root_logger_t> logger(root);
+
+    while (state.KeepRunning()) {
+        logger.log(0, "[::] - esafronov [10/Oct/2000:13:55:36 -0700] 'GET /porn.png HTTP/1.0' 200 2326",
+            attribute_list{{"key#1", {42}}, {"key#2", {3.1415}}, {"key#3", {"value"}}});
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+static
+void
+literal_with_typed_attributes_reject_severity(::benchmark::State& state) {
+    root_logger_t root({});
+    root.threshold(1);
+
+    logger_facade<root_logger_t> logger(root);
+
+    while (state.KeepRunning()) {
+        logger.log(0, "[::] - esafronov [10/Oct/2000:13:55:36 -0700] 'GET /porn.png HTTP/1.0' 200 2326",
+            attr("key#1", 42), attr("key#2", 3.1415), attr("key#3", "value"));
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
 static
 void
 literal_with_scoped_attributes(::benchmark::State& state) {
@@ -286,7 +349,12 @@ NBENCHMARK("log.lit[args: 6]", literal_with_args);
 NBENCHMARK("log.lit[args: 6 + c++14::fmt]", literal_with_args_using_cpp14_formatter);
 #endif
 
+NBENCHMARK("log.lit[args: 6 + deferred]", literal_with_args_deferred);
+
 NBENCHMARK("log.lit[args: 0 + attr: 3]", literal_with_attributes);
+NBENCHMARK("log.lit[args: 0 + attr(typed): 3]", literal_with_typed_attributes);
+NBENCHMARK("log.lit[args: 0 + attr: 3 + reject(severity)]", literal_with_attributes_reject_severity);
+NBENCHMARK("log.lit[args: 0 + attr(typed): 3 + reject(severity)]", literal_with_typed_attributes_reject_severity);
 NBENCHMARK("log.lit[args: 0 + attr(scope): 3]", literal_with_scoped_attributes);
 NBENCHMARK("log.lit[args: 0 + attr(scope+): 3]", literal_with_scoped_attributes_everytime);
 NBENCHMARK("log.lit[args: 6 + attr: 3]", literal_with_args_and_attributes);
@@ -300,8 +368,29 @@ protected:
     root_logger_t root;
     logger_facade<root_logger_t> logger;
 
+    wrapper_t wrapper;
+    logger_facade<wrapper_t> wrapped;
+
 public:
-    threaded_t(): root({}), logger(root) {}
+    threaded_t():
+        root({}),
+        logger(root),
+        wrapper(root, {{"key#0", {500}}, {"key#1", {"value#1"}}}),
+        wrapped(wrapper)
+    {}
+};
+
+class rejecting_t: public ::benchmark::Fixture {
+protected:
+    root_logger_t root;
+    logger_facade<root_logger_t> logger;
+
+public:
+    rejecting_t(): root({}), logger(root) {
+        root.filter([](const record_t&) -> bool {
+            return false;
+        });
+    }
 };
 
 BENCHMARK_DEFINE_F(threaded_t, facade)(::benchmark::State& state) {
@@ -322,5 +411,94 @@ BENCHMARK_DEFINE_F(threaded_t, facade)(::benchmark::State& state) {
 BENCHMARK_REGISTER_F(threaded_t, facade)
     ->ThreadRange(1, 2 * std::thread::hardware_concurrency());
 
+/// Each thread has its own scope, which is looked up in the scope manager on every event.
+BENCHMARK_DEFINE_F(threaded_t, scoped)(::benchmark::State& state) {
+    const scope::holder_t scoped(root, {
+        {"key#1", {42}},
+        {"key#2", {3.1415}},
+        {"key#3", "value"}
+    });
+
+    while (state.KeepRunning()) {
+        logger.log(0, "[::] - esafronov [10/Oct/2000:13:55:36 -0700] 'GET /porn.png HTTP/1.0' 200 2326");
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_REGISTER_F(threaded_t, scoped)
+    ->ThreadRange(1, 2 * std::thread::hardware_concurrency());
+
+BENCHMARK_DEFINE_F(threaded_t, scoped_everytime)(::benchmark::State& state) {
+    while (state.KeepRunning()) {
+        const scope::holder_t scoped(root, {
+            {"key#1", {42}},
+            {"key#2", {3.1415}},
+            {"key#3", "value"}
+        });
+
+        logger.log(0, "[::] - esafronov [10/Oct/2000:13:55:36 -0700] 'GET /porn.png HTTP/1.0' 200 2326");
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_REGISTER_F(threaded_t, scoped_everytime)
+    ->ThreadRange(1, 2 * std::thread::hardware_concurrency());
+
+/// All threads log through the same wrapper.
+BENCHMARK_DEFINE_F(threaded_t, wrapper)(::benchmark::State& state) {
+    while (state.KeepRunning()) {
+       wrapped.log(0, "{} - {} [{}] 'GET {} HTTP/1.0' {} {}",
+           "[::]", "esafronov", "10/Oct/2000:13:55:36 -0700", "/porn.png", 200, 2326,
+           attribute_list{
+               {"key#6", {42}},
+               {"key#7", {3.1415}},
+               {"key#8", {"value"}}
+           }
+       );
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_REGISTER_F(threaded_t, wrapper)
+    ->ThreadRange(1, 2 * std::thread::hardware_concurrency());
+
+/// The first thread keeps replacing the filter, while the rest ones log, which shows the cost of
+/// configuration swaps for concurrent logging. Only logging events are counted as items.
+BENCHMARK_DEFINE_F(threaded_t, filter_swap)(::benchmark::State& state) {
+    if (state.thread_index == 0) {
+        while (state.KeepRunning()) {
+            root.filter([](const record_t&) -> bool {
+                return true;
+            });
+        }
+
+        return;
+    }
+
+    while (state.KeepRunning()) {
+        logger.log(0, "[::] - esafronov [10/Oct/2000:13:55:36 -0700] 'GET /porn.png HTTP/1.0' 200 2326");
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_REGISTER_F(threaded_t, filter_swap)
+    ->ThreadRange(2, 2 * std::thread::hardware_concurrency());
+
+BENCHMARK_DEFINE_F(rejecting_t, filter)(::benchmark::State& state) {
+    while (state.KeepRunning()) {
+        logger.log(0, "[::] - esafronov [10/Oct/2000:13:55:36 -0700] 'GET /porn.png HTTP/1.0' 200 2326",
+            attribute_list{{"key#1", {42}}, {"key#2", {3.1415}}, {"key#3", {"value"}}});
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_REGISTER_F(rejecting_t, filter)
+    ->ThreadRange(1, 2 * std::thread::hardware_concurrency());
+
 }  // namespace benchmark
 }  // namespace blackhole
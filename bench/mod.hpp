@@ -1,7 +1,15 @@
 #pragma once
 
+#include "allocation.hpp"
+#include "perf.hpp"
+
 // Some private magic, but it's okay, since I manage the library version myself.
+//
+// Each benchmark is tracked, reporting its allocations and hardware counters per iteration if
+// enabled.
 #define NBENCHMARK(name, n) \
-    BENCHMARK_PRIVATE_DECLARE(n) =                               \
-        (::benchmark::internal::RegisterBenchmarkInternal(       \
-            new ::benchmark::internal::FunctionBenchmark(name, n)))
+    BENCHMARK_PRIVATE_DECLARE(n) =                                    \
+        (::benchmark::internal::RegisterBenchmarkInternal(            \
+            new ::benchmark::internal::FunctionBenchmark(name,        \
+                &::blackhole::benchmark::allocation::tracked<         \
+                    &::blackhole::benchmark::perf::counted<n>>)))
@@ -0,0 +1,48 @@
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <benchmark/benchmark.h>
+
+#include <blackhole/detail/mutex.hpp>
+
+#include "mod.hpp"
+
+namespace blackhole {
+namespace benchmark {
+namespace {
+
+/// Critical section of about the size of appending a formatted message to a sink buffer.
+template<typename Mutex>
+auto append(::benchmark::State& state) -> void {
+    static Mutex mutex;
+    static std::string buffer;
+
+    const std::string message(static_cast<std::size_t>(state.range_x()), 'x');
+
+    while (state.KeepRunning()) {
+        std::lock_guard<Mutex> lock(mutex);
+        buffer.append(message);
+
+        if (buffer.size() > 1 << 20) {
+            buffer.clear();
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+// Thread counts up to four times the hardware concurrency emulate oversubscribed containers, where
+// lock holders are descheduled, which is when unbounded spinning hurts the most. Running them
+// inside a cgroup with a CPU quota, i.e. `docker run --cpus=2`, shows the effect of throttling.
+const auto threads = static_cast<int>(4 * std::max(1u, std::thread::hardware_concurrency()));
+
+}  // namespace
+
+NBENCHMARK("mutex.std", append<std::mutex>)
+    ->Arg(64)->Arg(512)->ThreadRange(1, threads)->UseRealTime();
+NBENCHMARK("mutex.adaptive", append<detail::adaptive_mutex_t>)
+    ->Arg(64)->Arg(512)->ThreadRange(1, threads)->UseRealTime();
+
+}  // namespace benchmark
+}  // namespace blackhole
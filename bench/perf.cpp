@@ -0,0 +1,146 @@
+#include "perf.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace blackhole {
+namespace benchmark {
+namespace perf {
+namespace {
+
+#ifdef __linux__
+struct event_t {
+    const char* name;
+    std::uint32_t type;
+    std::uint64_t config;
+};
+
+const event_t events[] = {
+    {"cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {"instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {"l1d_misses", PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D |
+        (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+    {"llc_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+    {"branch_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+    {"context_switches", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES},
+};
+
+auto open(const event_t& event) -> int {
+    struct perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = event.type;
+    attr.config = event.config;
+    attr.disabled = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    // Context switches happen in the kernel, however they are counted for the thread anyway.
+    attr.exclude_kernel = event.type == PERF_TYPE_SOFTWARE ? 0 : 1;
+
+    return static_cast<int>(::syscall(SYS_perf_event_open, &attr, 0, -1, -1,
+        PERF_FLAG_FD_CLOEXEC));
+}
+#endif
+
+/// Reports counters missing on the host once, so that absent columns are not puzzling.
+auto warn(const char* name, int error) -> void {
+    static std::mutex mutex;
+    static std::vector<std::string> reported;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (std::find(reported.begin(), reported.end(), name) != reported.end()) {
+        return;
+    }
+
+    reported.emplace_back(name);
+    std::fprintf(stderr, "perf counter '%s' is unavailable: %s\n", name, std::strerror(error));
+}
+
+}  // namespace
+
+auto enabled() -> bool {
+    static const bool result = std::getenv("BLACKHOLE_BENCH_PERF") != nullptr;
+    return result;
+}
+
+counters_t::counters_t() {
+#ifdef __linux__
+    for (const auto& event : events) {
+        const auto fd = open(event);
+
+        if (fd < 0) {
+            warn(event.name, errno);
+            continue;
+        }
+
+        descriptors.emplace_back(event.name, fd);
+    }
+#else
+    warn("all", ENOSYS);
+#endif
+}
+
+counters_t::~counters_t() {
+#ifdef __linux__
+    for (const auto& descriptor : descriptors) {
+        ::close(descriptor.second);
+    }
+#endif
+}
+
+auto counters_t::start() -> void {
+#ifdef __linux__
+    for (const auto& descriptor : descriptors) {
+        ::ioctl(descriptor.second, PERF_EVENT_IOC_RESET, 0);
+        ::ioctl(descriptor.second, PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+}
+
+auto counters_t::stop() -> void {
+#ifdef __linux__
+    for (const auto& descriptor : descriptors) {
+        ::ioctl(descriptor.second, PERF_EVENT_IOC_DISABLE, 0);
+    }
+#endif
+}
+
+auto counters_t::read() const -> std::vector<std::pair<std::string, double>> {
+    std::vector<std::pair<std::string, double>> result;
+
+#ifdef __linux__
+    for (const auto& descriptor : descriptors) {
+        // Value, time enabled and time running, as requested by the read format.
+        std::uint64_t values[3] = {0, 0, 0};
+
+        if (::read(descriptor.second, values, sizeof(values)) != sizeof(values)) {
+            continue;
+        }
+
+        auto value = static_cast<double>(values[0]);
+        if (values[2] > 0 && values[2] < values[1]) {
+            value *= static_cast<double>(values[1]) / static_cast<double>(values[2]);
+        }
+
+        result.emplace_back(descriptor.first, value);
+    }
+#endif
+
+    return result;
+}
+
+}  // namespace perf
+}  // namespace benchmark
+}  // namespace blackhole
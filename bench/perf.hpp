@@ -0,0 +1,87 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+namespace blackhole {
+namespace benchmark {
+namespace perf {
+
+/// Returns whether hardware counters are reported, which is enabled by setting the
+/// `BLACKHOLE_BENCH_PERF` environment variable.
+auto enabled() -> bool;
+
+/// Hardware and software counters of the calling thread: cycles, instructions, L1 data cache read
+/// misses, last level cache misses, branch misses and context switches.
+///
+/// Counters are opened with `perf_event_open` on linux, counting user space only, so they are
+/// available with the default `perf_event_paranoid` setting. Counters the host lacks, like ones
+/// of virtual machines without a PMU, are skipped. Values are scaled if counters have been
+/// multiplexed.
+class counters_t {
+    std::vector<std::pair<std::string, int>> descriptors;
+
+public:
+    /// Opens available counters disabled.
+    counters_t();
+    ~counters_t();
+
+    counters_t(const counters_t& other) = delete;
+    auto operator=(const counters_t& other) -> counters_t& = delete;
+
+    /// Resets and enables counters.
+    auto start() -> void;
+    auto stop() -> void;
+
+    /// Returns names and values of available counters.
+    auto read() const -> std::vector<std::pair<std::string, double>>;
+};
+
+/// Runs the given benchmark, reporting counters per iteration under their names and instructions
+/// per cycle as `ipc` if enabled.
+///
+/// Like allocations, only events of benchmark threads are counted, and the benchmark setup is
+/// amortized by the number of iterations.
+template<void(*F)(::benchmark::State&)>
+void
+counted(::benchmark::State& state) {
+    if (!enabled()) {
+        return F(state);
+    }
+
+    counters_t counters;
+    counters.start();
+    F(state);
+    counters.stop();
+
+    const auto iterations = static_cast<double>(std::max<std::size_t>(1, state.iterations()));
+
+    double cycles = 0;
+    double instructions = 0;
+
+    for (const auto& counter : counters.read()) {
+        state.counters[counter.first] = ::benchmark::Counter(counter.second / iterations,
+            ::benchmark::Counter::kAvgThreads);
+
+        if (counter.first == "cycles") {
+            cycles = counter.second;
+        } else if (counter.first == "instructions") {
+            instructions = counter.second;
+        }
+    }
+
+    if (cycles > 0) {
+        state.counters["ipc"] = ::benchmark::Counter(instructions / cycles,
+            ::benchmark::Counter::kAvgThreads);
+    }
+}
+
+}  // namespace perf
+}  // namespace benchmark
+}  // namespace blackhole
@@ -1,10 +1,20 @@
+#include <atomic>
+#include <cstring>
+#include <deque>
 #include <memory>
+#include <mutex>
+#include <string>
 #include <thread>
+#include <vector>
 
 #include <boost/asio/io_service.hpp>
 
+#include <cds/container/vyukov_mpmc_cycle_queue.h>
+
 #include <benchmark/benchmark.h>
 
+#include <blackhole/detail/sink/ring.hpp>
+
 #include "mod.hpp"
 
 namespace blackhole {
@@ -33,5 +43,264 @@ static void io_post(::benchmark::State& state) {
 
 NBENCHMARK("I/O post", io_post);
 
+namespace {
+
+/// Number of entries each queue can hold.
+constexpr std::size_t capacity = 1024;
+
+/// Returns the calling thread index, assigned on the first call.
+auto thread_id() -> std::size_t {
+    static std::atomic<std::size_t> counter(0);
+    static thread_local const std::size_t id = counter++;
+    return id;
+}
+
+/// The queue the asynchronous sink uses in the "queue" mode, copying payloads into owned strings.
+class vyukov_t {
+    cds::container::VyukovMPSCCycleQueue<std::string> queue;
+
+public:
+    explicit vyukov_t(std::size_t) : queue(capacity) {}
+
+    auto push(const char* data, std::size_t size) -> bool {
+        return queue.enqueue_with([&](std::string& value) {
+            value.assign(data, size);
+        });
+    }
+
+    auto drain() -> std::size_t {
+        std::size_t result = 0;
+        while (queue.dequeue_with([](std::string&) {})) {
+            ++result;
+        }
+
+        return result;
+    }
+};
+
+/// Independent queues per hardware thread, producers are sharded by thread and the consumer drains
+/// them round-robin, like the asynchronous sink lanes do.
+class lanes_t {
+    std::vector<std::unique_ptr<vyukov_t>> lanes;
+
+public:
+    explicit lanes_t(std::size_t size) {
+        const auto count = std::max(1u, std::thread::hardware_concurrency());
+
+        for (std::size_t id = 0; id < count; ++id) {
+            lanes.emplace_back(new vyukov_t(size));
+        }
+    }
+
+    auto push(const char* data, std::size_t size) -> bool {
+        return lanes[thread_id() % lanes.size()]->push(data, size);
+    }
+
+    auto drain() -> std::size_t {
+        std::size_t result = 0;
+        for (auto& lane : lanes) {
+            result += lane->drain();
+        }
+
+        return result;
+    }
+};
+
+/// Byte ring the asynchronous sink uses in the "ring" mode, sized for the same number of entries.
+class ring_t {
+    sink::ring_t ring;
+
+    static auto round(std::size_t size) -> std::size_t {
+        std::size_t result = 64;
+        while (result < capacity * (size + 16)) {
+            result *= 2;
+        }
+
+        return result;
+    }
+
+public:
+    explicit ring_t(std::size_t size) : ring(round(size)) {}
+
+    auto push(const char* data, std::size_t size) -> bool {
+        const auto reservation = ring.reserve(size);
+        if (reservation.data == nullptr) {
+            return false;
+        }
+
+        std::memcpy(reservation.data, data, size);
+        ring.commit(reservation);
+        return true;
+    }
+
+    auto drain() -> std::size_t {
+        std::size_t result = 0;
+
+        sink::ring_t::slot_t slot;
+        while (ring.read(slot)) {
+            ++result;
+        }
+
+        ring.release();
+        return result;
+    }
+};
+
+/// Baseline bounded queue protected by a mutex.
+class locked_t {
+    std::mutex mutex;
+    std::deque<std::string> queue;
+
+public:
+    explicit locked_t(std::size_t) {}
+
+    auto push(const char* data, std::size_t size) -> bool {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        if (queue.size() == capacity) {
+            return false;
+        }
+
+        queue.emplace_back(data, size);
+        return true;
+    }
+
+    auto drain() -> std::size_t {
+        std::deque<std::string> drained;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            drained.swap(queue);
+        }
+
+        return drained.size();
+    }
+};
+
+/// Queue shared by all producer threads of a benchmark, which is created with its consumer thread
+/// by the first producer entering and destroyed by the last one leaving.
+template<typename Queue>
+class shared_t {
+    std::mutex mutex;
+    std::size_t users;
+    std::unique_ptr<Queue> queue;
+    std::atomic<bool> stopped;
+    std::thread consumer;
+
+public:
+    shared_t() : users(0), stopped(false) {}
+
+    /// Without consuming the queue is filled up before returning, so all pushes then fail.
+    auto acquire(std::size_t size, bool consume) -> Queue& {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        if (users++ == 0) {
+            queue.reset(new Queue(size));
+
+            if (consume) {
+                stopped = false;
+                consumer = std::thread([&] {
+                    while (!stopped.load(std::memory_order_relaxed)) {
+                        if (queue->drain() == 0) {
+                            std::this_thread::yield();
+                        }
+                    }
+                });
+            } else {
+                const std::string payload(size, 'x');
+                while (queue->push(payload.data(), payload.size())) {
+                }
+            }
+        }
+
+        return *queue;
+    }
+
+    auto release() -> void {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        if (--users == 0) {
+            if (consumer.joinable()) {
+                stopped = true;
+                consumer.join();
+            }
+
+            queue.reset();
+        }
+    }
+};
+
+/// Pushes payloads of the benchmark argument size, retrying until accepted while the queue is
+/// consumed, like the "wait" overflow policy. Otherwise measures rejecting pushes into the full
+/// queue, like the "drop" overflow policy.
+template<typename Queue, bool Consume>
+void push(::benchmark::State& state) {
+    static shared_t<Queue> shared;
+
+    const auto size = static_cast<std::size_t>(state.range(0));
+    const std::string payload(size, 'x');
+
+    auto& queue = shared.acquire(size, Consume);
+
+    while (state.KeepRunning()) {
+        while (!queue.push(payload.data(), payload.size()) && Consume) {
+            std::this_thread::yield();
+        }
+    }
+
+    shared.release();
+
+    state.SetItemsProcessed(state.iterations());
+    if (Consume) {
+        state.SetBytesProcessed(state.iterations() * static_cast<std::int64_t>(size));
+    }
+}
+
+void vyukov(::benchmark::State& state) {
+    push<vyukov_t, true>(state);
+}
+
+void vyukov_full(::benchmark::State& state) {
+    push<vyukov_t, false>(state);
+}
+
+void lanes(::benchmark::State& state) {
+    push<lanes_t, true>(state);
+}
+
+void lanes_full(::benchmark::State& state) {
+    push<lanes_t, false>(state);
+}
+
+void ring(::benchmark::State& state) {
+    push<ring_t, true>(state);
+}
+
+void ring_full(::benchmark::State& state) {
+    push<ring_t, false>(state);
+}
+
+void locked(::benchmark::State& state) {
+    push<locked_t, true>(state);
+}
+
+void locked_full(::benchmark::State& state) {
+    push<locked_t, false>(state);
+}
+
+}  // namespace
+
+#define BH_QUEUE_BENCHMARK(name, function)                                                         \
+    NBENCHMARK(name, function)->Arg(64)->Arg(512)->Arg(4096)->ThreadRange(1, 64)->UseRealTime()
+
+BH_QUEUE_BENCHMARK("queue[vyukov]", vyukov);
+BH_QUEUE_BENCHMARK("queue[vyukov, full]", vyukov_full);
+BH_QUEUE_BENCHMARK("queue[lanes]", lanes);
+BH_QUEUE_BENCHMARK("queue[lanes, full]", lanes_full);
+BH_QUEUE_BENCHMARK("queue[ring]", ring);
+BH_QUEUE_BENCHMARK("queue[ring, full]", ring_full);
+BH_QUEUE_BENCHMARK("queue[mutex]", locked);
+BH_QUEUE_BENCHMARK("queue[mutex, full]", locked_full);
+
 }  // namespace benchmark
 }  // namespace blackhole
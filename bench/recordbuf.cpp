@@ -1,6 +1,10 @@
+#include <cstddef>
+#include <type_traits>
+
 #include <benchmark/benchmark.h>
 
 #include <blackhole/attribute.hpp>
+#include <blackhole/attributes.hpp>
 #include <blackhole/record.hpp>
 #include <blackhole/detail/recordbuf.hpp>
 
@@ -23,7 +27,24 @@ static void record(::benchmark::State& state) {
     state.SetItemsProcessed(state.iterations());
 }
 
+static void record_arena(::benchmark::State& state) {
+    const string_view message("GET /porn.png HTTP/1.1");
+    const attribute_list attributes{{"key#1", "value#1"}};
+    const attribute_pack pack{attributes};
+
+    record_t record(42, message, pack);
+
+    std::aligned_storage<4096, alignof(std::max_align_t)>::type memory;
+
+    while (state.KeepRunning()) {
+        detail::recordbuf_t owned(record, &memory, sizeof(memory));
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
 NBENCHMARK("record[into_owned]", record);
+NBENCHMARK("record[into_owned/arena]", record_arena);
 
 }  // namespace benchmark
 }  // namespace blackhole
@@ -0,0 +1,339 @@
+/// Replays a recorded corpus of logging events through a logger built from the given JSON config,
+/// measuring throughput and the latency distribution of logging calls.
+///
+/// Unlike synthetic benchmarks, which log the same line over and over, the corpus reproduces the
+/// actual mix of message lengths, attribute counts, severities and scope depths. It's a file of
+/// JSON objects, one per line, like:
+///     {"severity": 1, "message": "GET {} {}", "args": ["/index.html", 200],
+///      "attributes": {"peer": "[::1]", "id": 42}, "scope": 2}
+///
+/// All fields except the message are optional. Arguments are substituted into `{}` placeholders
+/// only for events passing the filter, like the facade does. Events of each thread are nested into
+/// the given number of scopes with a single attribute each, which are adjusted between calls, so
+/// their construction is not measured.
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/optional/optional.hpp>
+
+#include <blackhole/attribute.hpp>
+#include <blackhole/attributes.hpp>
+#include <blackhole/builder.hpp>
+#include <blackhole/config/json.hpp>
+#include <blackhole/config/node.hpp>
+#include <blackhole/config/option.hpp>
+#include <blackhole/message.hpp>
+#include <blackhole/registry.hpp>
+#include <blackhole/root.hpp>
+#include <blackhole/scope/holder.hpp>
+
+#include "latency/histogram.hpp"
+
+namespace blackhole {
+namespace replay {
+namespace {
+
+typedef std::chrono::steady_clock clock_type;
+
+using latency::histogram_t;
+
+struct event_t {
+    int severity;
+    std::string pattern;
+    /// Arguments rendered in advance, since only substituting them is what formatting costs.
+    std::vector<std::string> args;
+    attributes_t attributes;
+    attribute_list view;
+    std::size_t scope;
+};
+
+struct options_t {
+    std::string logger;
+    std::size_t threads;
+    /// Number of times each thread replays the corpus.
+    std::size_t repeat;
+
+    options_t() :
+        logger("root"),
+        threads(1),
+        repeat(10)
+    {}
+};
+
+auto into_value(const config::node_t& node) -> attribute::value_t {
+    if (node.is_bool()) {
+        return node.to_bool();
+    } else if (node.is_sint64()) {
+        return node.to_sint64();
+    } else if (node.is_uint64()) {
+        return node.to_uint64();
+    } else if (node.is_double()) {
+        return node.to_double();
+    } else if (node.is_string()) {
+        return node.to_string();
+    }
+
+    throw std::invalid_argument("attribute values must be either booleans, numbers or strings");
+}
+
+auto into_string(const config::node_t& node) -> std::string {
+    if (node.is_bool()) {
+        return node.to_bool() ? "true" : "false";
+    } else if (node.is_sint64()) {
+        return std::to_string(node.to_sint64());
+    } else if (node.is_uint64()) {
+        return std::to_string(node.to_uint64());
+    } else if (node.is_double()) {
+        return std::to_string(node.to_double());
+    } else if (node.is_string()) {
+        return node.to_string();
+    }
+
+    throw std::invalid_argument("arguments must be either booleans, numbers or strings");
+}
+
+auto parse(const std::string& line) -> event_t {
+    std::istringstream stream(line);
+
+    const auto factory = config::factory_traits<config::json_t>::construct(stream);
+    const auto& config = factory->config();
+
+    event_t event;
+    event.severity = static_cast<int>(config["severity"].to_sint64().get_value_or(0));
+    event.scope = static_cast<std::size_t>(config["scope"].to_uint64().get_value_or(0));
+
+    const auto message = config["message"].to_string();
+    if (!message) {
+        throw std::invalid_argument("event requires 'message' field");
+    }
+
+    event.pattern = message.get();
+
+    config["args"].each([&](const config::node_t& node) {
+        event.args.push_back(into_string(node));
+    });
+
+    config["attributes"].each_map([&](const std::string& key, const config::node_t& node) {
+        event.attributes.emplace_back(key, into_value(node));
+    });
+
+    return event;
+}
+
+auto load(const std::string& path) -> std::vector<event_t> {
+    std::ifstream stream(path);
+    if (!stream) {
+        throw std::invalid_argument("failed to open corpus " + path);
+    }
+
+    std::vector<event_t> events;
+
+    std::string line;
+    for (std::size_t id = 1; std::getline(stream, line); ++id) {
+        if (line.empty()) {
+            continue;
+        }
+
+        try {
+            events.push_back(parse(line));
+        } catch (const std::exception& err) {
+            throw std::invalid_argument(path + ":" + std::to_string(id) + ": " + err.what());
+        }
+    }
+
+    if (events.empty()) {
+        throw std::invalid_argument("corpus " + path + " contains no events");
+    }
+
+    // Views are built after loading, since growing the vector moves attributes.
+    for (auto& event : events) {
+        for (const auto& attribute : event.attributes) {
+            event.view.emplace_back(attribute.first, attribute.second);
+        }
+    }
+
+    return events;
+}
+
+/// Substitutes arguments of the event into placeholders of its pattern.
+class render_t {
+    const event_t& event;
+    std::string& buffer;
+
+public:
+    render_t(const event_t& event, std::string& buffer) :
+        event(event),
+        buffer(buffer)
+    {}
+
+    auto operator()() const -> string_view {
+        buffer.clear();
+
+        std::size_t position = 0;
+        for (const auto& arg : event.args) {
+            const auto placeholder = event.pattern.find("{}", position);
+            if (placeholder == std::string::npos) {
+                break;
+            }
+
+            buffer.append(event.pattern, position, placeholder - position);
+            buffer.append(arg);
+            position = placeholder + 2;
+        }
+
+        buffer.append(event.pattern, position, std::string::npos);
+        return buffer;
+    }
+};
+
+/// Replays the corpus starting from the given offset, so threads don't log the same event at once.
+auto run(root_logger_t& logger, const std::vector<event_t>& events, const options_t& options,
+    std::size_t offset) -> histogram_t
+{
+    histogram_t histogram;
+    std::string buffer;
+
+    std::vector<std::unique_ptr<scope::holder_t>> scopes;
+
+    for (std::size_t round = 0; round < options.repeat; ++round) {
+        for (std::size_t id = 0; id < events.size(); ++id) {
+            const auto& event = events[(offset + id) % events.size()];
+
+            while (scopes.size() > event.scope) {
+                scopes.pop_back();
+            }
+
+            while (scopes.size() < event.scope) {
+                scopes.emplace_back(new scope::holder_t(logger, {
+                    {"scope", {static_cast<std::uint64_t>(scopes.size())}}
+                }));
+            }
+
+            const render_t render(event, buffer);
+
+            attribute_pack pack{event.view};
+            lazy_message_t message{event.pattern, render};
+
+            const auto start = clock_type::now();
+            logger.log(event.severity, message, pack);
+            const auto done = clock_type::now();
+
+            histogram.record(static_cast<std::uint64_t>((done - start).count()));
+        }
+    }
+
+    // Scopes must be destroyed in the reversed order.
+    while (!scopes.empty()) {
+        scopes.pop_back();
+    }
+
+    return histogram;
+}
+
+auto replay(const std::string& config, const std::string& corpus, const options_t& options) ->
+    int
+{
+    const auto events = load(corpus);
+
+    std::ifstream stream(config);
+    if (!stream) {
+        throw std::invalid_argument("failed to open config " + config);
+    }
+
+    const auto registry = registry::configured();
+    auto builder = registry->builder<config::json_t>(stream);
+    auto logger = builder.build(options.logger);
+
+    std::vector<histogram_t> results(options.threads);
+    std::vector<std::thread> workers;
+
+    const auto start = clock_type::now();
+
+    for (std::size_t id = 0; id < options.threads; ++id) {
+        workers.emplace_back([&, id] {
+            results[id] = run(logger, events, options, id * events.size() / options.threads);
+        });
+    }
+
+    histogram_t result;
+    for (std::size_t id = 0; id < options.threads; ++id) {
+        workers[id].join();
+        result.merge(results[id]);
+    }
+
+    const auto elapsed = std::chrono::duration<double>(clock_type::now() - start).count();
+
+    logger.flush(std::chrono::seconds(10));
+
+    std::printf("%7s %12s %14s | %10s %10s %10s %10s\n",
+        "threads", "calls", "calls/s", "p50, us", "p99, us", "p99.9, us", "max, us");
+    std::printf("%7zu %12llu %14.0f |", options.threads,
+        static_cast<unsigned long long>(result.count()),
+        static_cast<double>(result.count()) / elapsed);
+
+    for (auto q : {0.5, 0.99, 0.999}) {
+        std::printf(" %10.2f", static_cast<double>(result.quantile(q)) / 1000.0);
+    }
+
+    std::printf(" %10.2f\n", static_cast<double>(result.max()) / 1000.0);
+
+    return 0;
+}
+
+auto usage(const char* name) -> void {
+    std::fprintf(stderr,
+        "Usage: %s [--logger NAME] [--threads COUNT] [--repeat COUNT] CONFIG CORPUS\n"
+        "  --logger   name of the logger built from the config, root by default\n"
+        "  --threads  number of threads replaying the corpus, one by default\n"
+        "  --repeat   number of times each thread replays the corpus, 10 by default\n",
+        name);
+}
+
+}  // namespace
+}  // namespace replay
+}  // namespace blackhole
+
+auto main(int argc, char** argv) -> int {
+    using namespace blackhole::replay;
+
+    options_t options;
+
+    int id = 1;
+    for (; id + 1 < argc && std::strncmp(argv[id], "--", 2) == 0; id += 2) {
+        const auto value = std::strtoull(argv[id + 1], nullptr, 10);
+
+        if (std::strcmp(argv[id], "--logger") == 0) {
+            options.logger = argv[id + 1];
+        } else if (std::strcmp(argv[id], "--threads") == 0 && value > 0) {
+            options.threads = static_cast<std::size_t>(value);
+        } else if (std::strcmp(argv[id], "--repeat") == 0 && value > 0) {
+            options.repeat = static_cast<std::size_t>(value);
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (argc - id != 2) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    try {
+        return replay(argv[id], argv[id + 1], options);
+    } catch (const std::exception& err) {
+        std::fprintf(stderr, "replay: %s\n", err.what());
+        return 1;
+    }
+}
@@ -0,0 +1,132 @@
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <blackhole/attribute.hpp>
+#include <blackhole/attribute/table.hpp>
+#include <blackhole/attributes.hpp>
+#include <blackhole/extensions/writer.hpp>
+#include <blackhole/formatter.hpp>
+#include <blackhole/formatter/logfmt.hpp>
+#include <blackhole/record.hpp>
+#include <blackhole/detail/formatter/json/escape.hpp>
+#include <blackhole/detail/simd.hpp>
+
+#include "mod.hpp"
+
+namespace blackhole {
+namespace benchmark {
+namespace {
+
+using detail::simd::isa_t;
+
+/// Binds kernels to the instruction set given as the benchmark argument for the benchmark scope.
+class forced_t {
+    isa_t previous;
+    bool supported;
+
+public:
+    explicit forced_t(::benchmark::State& state) :
+        previous(detail::simd::selected()),
+        supported(detail::simd::select(static_cast<isa_t>(state.range(0))))
+    {
+        if (!supported) {
+            state.SkipWithError("instruction set is not supported");
+        }
+    }
+
+    ~forced_t() {
+        detail::simd::select(previous);
+    }
+
+    explicit operator bool() const noexcept {
+        return supported;
+    }
+};
+
+}  // namespace
+
+static void simd_json_escape(::benchmark::State& state) {
+    forced_t forced(state);
+    if (!forced) {
+        return;
+    }
+
+    const std::string value(1024, 'x');
+    writer_t writer;
+
+    while (state.KeepRunning()) {
+        detail::formatter::json::escape(value, writer);
+        writer.inner.clear();
+    }
+
+    state.SetBytesProcessed(state.iterations() * static_cast<std::int64_t>(value.size()));
+}
+
+static void simd_logfmt_string(::benchmark::State& state) {
+    forced_t forced(state);
+    if (!forced) {
+        return;
+    }
+
+    auto formatter = builder<formatter::logfmt_t>()
+        .build();
+
+    const std::string value(1024, 'x');
+    const string_view message(value);
+    const attribute_pack pack;
+    record_t record(0, message, pack);
+    writer_t writer;
+
+    while (state.KeepRunning()) {
+        formatter->format(record, writer);
+        writer.inner.clear();
+    }
+
+    state.SetBytesProcessed(state.iterations() * static_cast<std::int64_t>(value.size()));
+}
+
+static void simd_table_find(::benchmark::State& state) {
+    forced_t forced(state);
+    if (!forced) {
+        return;
+    }
+
+    std::vector<std::string> names;
+    for (int id = 0; id < 64; ++id) {
+        names.push_back("key#" + std::to_string(id));
+    }
+
+    view_of<attributes_t>::type attributes;
+    for (int id = 0; id < 64; ++id) {
+        attributes.emplace_back(names[id], attribute::view_t(id));
+    }
+
+    const attribute_pack pack{attributes};
+    const unique_attributes_t unique(pack);
+    const attribute::table_t table(unique);
+    const string_view key(names.back());
+
+    while (state.KeepRunning()) {
+        ::benchmark::DoNotOptimize(table.find(key));
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+#define SIMD_BENCHMARK(name, fn)                                                    \
+    NBENCHMARK("simd." name "[scalar]", fn)->Arg(static_cast<int>(isa_t::scalar));  \
+    NBENCHMARK("simd." name "[sse2]", fn)->Arg(static_cast<int>(isa_t::sse2));      \
+    NBENCHMARK("simd." name "[avx2]", fn)->Arg(static_cast<int>(isa_t::avx2));      \
+    NBENCHMARK("simd." name "[avx512]", fn)->Arg(static_cast<int>(isa_t::avx512));  \
+    NBENCHMARK("simd." name "[neon]", fn)->Arg(static_cast<int>(isa_t::neon))
+
+SIMD_BENCHMARK("json.escape[1KiB]", simd_json_escape);
+SIMD_BENCHMARK("logfmt.string[1KiB]", simd_logfmt_string);
+SIMD_BENCHMARK("table.find[64]", simd_table_find);
+
+#undef SIMD_BENCHMARK
+
+}  // namespace benchmark
+}  // namespace blackhole
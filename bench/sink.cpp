@@ -0,0 +1,345 @@
+/// End-to-end pipelines: facade, root logger, blocking handler, formatter and real sinks.
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <benchmark/benchmark.h>
+
+#include <blackhole/attribute.hpp>
+#include <blackhole/attributes.hpp>
+#include <blackhole/detail/sink/asynchronous.hpp>
+#include <blackhole/extensions/facade.hpp>
+#include <blackhole/formatter.hpp>
+#include <blackhole/formatter/json.hpp>
+#include <blackhole/formatter/string.hpp>
+#include <blackhole/handler.hpp>
+#include <blackhole/handler/blocking.hpp>
+#include <blackhole/root.hpp>
+#include <blackhole/sink.hpp>
+#include <blackhole/sink/file.hpp>
+
+#include <src/sink/socket/tcp.hpp>
+#include <src/sink/socket/udp.hpp>
+
+#include "mod.hpp"
+
+namespace blackhole {
+namespace benchmark {
+namespace {
+
+/// Counts bytes passed to the wrapped sink.
+class counting_t : public sink_t {
+    std::unique_ptr<sink_t> wrapped;
+    std::atomic<std::uint64_t>& bytes;
+
+public:
+    counting_t(std::unique_ptr<sink_t> wrapped, std::atomic<std::uint64_t>& bytes) :
+        wrapped(std::move(wrapped)),
+        bytes(bytes)
+    {}
+
+    auto emit(const record_t& record, const string_view& message) -> void override {
+        bytes.fetch_add(message.size(), std::memory_order_relaxed);
+        wrapped->emit(record, message);
+    }
+
+    auto emit_batch(const event_t* events, std::size_t size) -> void override {
+        std::uint64_t total = 0;
+        for (std::size_t id = 0; id < size; ++id) {
+            total += events[id].message->size();
+        }
+
+        bytes.fetch_add(total, std::memory_order_relaxed);
+        wrapped->emit_batch(events, size);
+    }
+};
+
+/// Logging pipeline shared by all threads of a benchmark, which is built by the first thread
+/// entering and destroyed by the last one leaving, so buffered events are flushed before the
+/// number of bytes written is reported.
+class pipeline_t {
+    std::mutex mutex;
+    std::size_t users;
+    std::unique_ptr<root_logger_t> logger;
+    std::atomic<std::uint64_t> bytes;
+
+public:
+    pipeline_t() : users(0), bytes(0) {}
+
+    /// \param factory must build the handler, counting written bytes using the given counter.
+    template<typename F>
+    auto acquire(const F& factory) -> root_logger_t& {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        if (users++ == 0) {
+            bytes = 0;
+
+            std::vector<std::unique_ptr<handler_t>> handlers;
+            handlers.push_back(factory(bytes));
+
+            logger.reset(new root_logger_t(std::move(handlers)));
+        }
+
+        return *logger;
+    }
+
+    /// Returns the number of bytes written for the last thread leaving, zero otherwise.
+    auto release() -> std::uint64_t {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        if (--users != 0) {
+            return 0;
+        }
+
+        logger.reset();
+        return bytes.load();
+    }
+};
+
+/// Loopback TCP server discarding everything it receives.
+class tcp_server_t {
+    int fd;
+    std::uint16_t port_;
+    std::atomic<bool> stopped;
+    std::thread thread;
+
+public:
+    tcp_server_t() : fd(::socket(AF_INET, SOCK_STREAM, 0)), port_(0), stopped(false) {
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t size = sizeof(address);
+
+        ::bind(fd, reinterpret_cast<const sockaddr*>(&address), size);
+        ::listen(fd, 16);
+        ::getsockname(fd, reinterpret_cast<sockaddr*>(&address), &size);
+        port_ = ntohs(address.sin_port);
+
+        thread = std::thread(&tcp_server_t::run, this);
+    }
+
+    ~tcp_server_t() {
+        stopped = true;
+        thread.join();
+        ::close(fd);
+    }
+
+    auto port() const noexcept -> std::uint16_t {
+        return port_;
+    }
+
+private:
+    auto run() -> void {
+        char data[64 * 1024];
+
+        while (!stopped) {
+            pollfd listener{fd, POLLIN, 0};
+            if (::poll(&listener, 1, 100) <= 0) {
+                continue;
+            }
+
+            const auto client = ::accept(fd, nullptr, nullptr);
+            if (client < 0) {
+                continue;
+            }
+
+            while (!stopped) {
+                pollfd connection{client, POLLIN, 0};
+                if (::poll(&connection, 1, 100) <= 0) {
+                    continue;
+                }
+
+                if (::read(client, data, sizeof(data)) <= 0) {
+                    break;
+                }
+            }
+
+            ::close(client);
+        }
+    }
+};
+
+/// Loopback UDP server discarding everything it receives.
+class udp_server_t {
+    int fd;
+    std::uint16_t port_;
+    std::atomic<bool> stopped;
+    std::thread thread;
+
+public:
+    udp_server_t() : fd(::socket(AF_INET, SOCK_DGRAM, 0)), port_(0), stopped(false) {
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t size = sizeof(address);
+
+        ::bind(fd, reinterpret_cast<const sockaddr*>(&address), size);
+        ::getsockname(fd, reinterpret_cast<sockaddr*>(&address), &size);
+        port_ = ntohs(address.sin_port);
+
+        thread = std::thread(&udp_server_t::run, this);
+    }
+
+    ~udp_server_t() {
+        stopped = true;
+        thread.join();
+        ::close(fd);
+    }
+
+    auto port() const noexcept -> std::uint16_t {
+        return port_;
+    }
+
+private:
+    auto run() -> void {
+        char data[64 * 1024];
+
+        while (!stopped) {
+            pollfd socket{fd, POLLIN, 0};
+            if (::poll(&socket, 1, 100) > 0) {
+                ::recv(fd, data, sizeof(data), 0);
+            }
+        }
+    }
+};
+
+/// Path of the file on tmpfs, so the benchmarks measure the pipeline instead of the disk.
+auto path(const char* name) -> std::string {
+    return "/dev/shm/blackhole-bench-" + std::to_string(::getpid()) + "-" + name + ".log";
+}
+
+auto string_formatter() -> std::unique_ptr<formatter_t> {
+    return builder<formatter::string_t>("{timestamp} {severity} {process}/{thread}: {message} {...}")
+        .build();
+}
+
+auto json_formatter() -> std::unique_ptr<formatter_t> {
+    return builder<formatter::json_t>()
+        .build();
+}
+
+auto blocking(std::unique_ptr<formatter_t> formatter, std::unique_ptr<sink_t> sink,
+    std::atomic<std::uint64_t>& bytes) -> std::unique_ptr<handler_t>
+{
+    return builder<handler::blocking_t>()
+        .set(std::move(formatter))
+        .add(std::unique_ptr<sink_t>(new counting_t(std::move(sink), bytes)))
+        .build();
+}
+
+/// Logs an access log like message with a few attributes until stopped.
+template<typename F>
+auto run(::benchmark::State& state, pipeline_t& pipeline, const F& factory) -> void {
+    logger_facade<root_logger_t> logger(pipeline.acquire(factory));
+
+    while (state.KeepRunning()) {
+        logger.log(0, "{} - {} [{}] 'GET {} HTTP/1.0' {} {}",
+            "[::]", "esafronov", "10/Oct/2000:13:55:36 -0700", "/porn.png", 200, 2326,
+            attribute_list{
+                {"key#6", {42}},
+                {"key#7", {3.1415}},
+                {"key#8", {"value"}}
+            }
+        );
+    }
+
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(static_cast<std::int64_t>(pipeline.release()));
+}
+
+auto file(const char* name, std::unique_ptr<formatter_t> formatter,
+    std::atomic<std::uint64_t>& bytes) -> std::unique_ptr<handler_t>
+{
+    return blocking(std::move(formatter), builder<sink::file_t>(path(name)).build(), bytes);
+}
+
+auto asynchronous(const char* name, const std::string& policy,
+    std::atomic<std::uint64_t>& bytes) -> std::unique_ptr<handler_t>
+{
+    std::unique_ptr<sink_t> wrapped(new counting_t(builder<sink::file_t>(path(name)).build(), bytes));
+
+    std::unique_ptr<sink_t> sink(new sink::asynchronous_t(std::move(wrapped), 10,
+        sink::overflow_policy_factory_t().create(policy)));
+
+    return builder<handler::blocking_t>()
+        .set(string_formatter())
+        .add(std::move(sink))
+        .build();
+}
+
+void string_file(::benchmark::State& state) {
+    static pipeline_t pipeline;
+    run(state, pipeline, [](std::atomic<std::uint64_t>& bytes) {
+        return file("string", string_formatter(), bytes);
+    });
+
+    std::remove(path("string").c_str());
+}
+
+void json_file(::benchmark::State& state) {
+    static pipeline_t pipeline;
+    run(state, pipeline, [](std::atomic<std::uint64_t>& bytes) {
+        return file("json", json_formatter(), bytes);
+    });
+
+    std::remove(path("json").c_str());
+}
+
+void asynchronous_drop(::benchmark::State& state) {
+    static pipeline_t pipeline;
+    run(state, pipeline, [](std::atomic<std::uint64_t>& bytes) {
+        return asynchronous("drop", "drop", bytes);
+    });
+
+    std::remove(path("drop").c_str());
+}
+
+void asynchronous_wait(::benchmark::State& state) {
+    static pipeline_t pipeline;
+    run(state, pipeline, [](std::atomic<std::uint64_t>& bytes) {
+        return asynchronous("wait", "wait", bytes);
+    });
+
+    std::remove(path("wait").c_str());
+}
+
+void tcp(::benchmark::State& state) {
+    static tcp_server_t server;
+    static pipeline_t pipeline;
+    run(state, pipeline, [](std::atomic<std::uint64_t>& bytes) {
+        std::unique_ptr<sink_t> sink(new sink::socket::tcp_t("127.0.0.1", server.port()));
+        return blocking(string_formatter(), std::move(sink), bytes);
+    });
+}
+
+void udp(::benchmark::State& state) {
+    static udp_server_t server;
+    static pipeline_t pipeline;
+    run(state, pipeline, [](std::atomic<std::uint64_t>& bytes) {
+        std::unique_ptr<sink_t> sink(new sink::socket::udp_t("127.0.0.1", server.port()));
+        return blocking(string_formatter(), std::move(sink), bytes);
+    });
+}
+
+const int threads = static_cast<int>(2 * std::thread::hardware_concurrency());
+
+}  // namespace
+
+NBENCHMARK("sink.file[string]", string_file)->ThreadRange(1, threads)->UseRealTime();
+NBENCHMARK("sink.file[json]", json_file)->ThreadRange(1, threads)->UseRealTime();
+NBENCHMARK("sink.asynchronous[drop]", asynchronous_drop)->ThreadRange(1, threads)->UseRealTime();
+NBENCHMARK("sink.asynchronous[wait]", asynchronous_wait)->ThreadRange(1, threads)->UseRealTime();
+NBENCHMARK("sink.tcp", tcp)->ThreadRange(1, threads)->UseRealTime();
+NBENCHMARK("sink.udp", udp)->ThreadRange(1, threads)->UseRealTime();
+
+}  // namespace benchmark
+}  // namespace blackhole
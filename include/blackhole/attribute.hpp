@@ -1,7 +1,9 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 #include <functional>
+#include <new>
 #include <string>
 #include <type_traits>
 
@@ -19,6 +21,17 @@ inline namespace v1 {
 template<typename T>
 struct display_traits;
 
+/// Trait that marks user defined types, whose values can be copied when a record is converted into
+/// the owned form for asynchronous processing and formatted later, on the consumer thread, instead
+/// of being formatted eagerly on the logging thread.
+///
+/// Marked types must be copy constructible and trivially destructible, and their display traits
+/// must be safe to apply to such copies on any thread. For example:
+///     template<>
+///     struct deferred_display<endpoint_t> : std::true_type {};
+template<typename T>
+struct deferred_display : std::false_type {};
+
 /// Represents a trait for mapping an owned types to their associated lightweight view types.
 ///
 /// By default all types are transparently mapped to itself, but Blackhole provides some
@@ -33,6 +46,25 @@ struct view_of {
 /// Forward.
 class writer_t;
 
+namespace detail {
+
+/// Collects copies of deferred function attribute values while records are converted into the
+/// owned form.
+class capture_t;
+
+/// Returns the capture, which is in progress on this thread through the given writer, if any.
+auto capture_of(writer_t& writer) noexcept -> capture_t*;
+
+/// Schedules the given value to be copied into the owned record instead of being formatted.
+auto defer(capture_t& capture, const void* value, std::size_t size, std::size_t align,
+    void(*copy)(void* destination, const void* value)) -> void;
+
+template<typename T>
+auto copy(void* destination, const void* value) -> void {
+    new(destination) T(*static_cast<const T*>(value));
+}
+
+}  // namespace detail
 }  // namespace v1
 }  // namespace blackhole
 
@@ -197,6 +229,21 @@ public:
         auto operator==(const function_type& other) const noexcept -> bool {
             return value == other.value && fn.get() == other.fn.get();
         }
+
+        /// Returns a function view invoking the given callable by reference, without wrapping it
+        /// into `std::function`, so it never allocates.
+        ///
+        /// \warning the callable must outlive the view.
+        template<typename F>
+        static auto ref(const F& fn) noexcept -> function_type {
+            return function_type{static_cast<const void*>(&fn), std::ref(invoke<F>)};
+        }
+
+    private:
+        template<typename F>
+        static auto invoke(const void* value, writer_t& wr) -> void {
+            (*static_cast<const F*>(value))(wr);
+        }
     };
 
     /// The type sequence of all available types.
@@ -277,11 +324,22 @@ public:
     /// Constructs a value view from a custom type that implements `display_traits` trait.
     ///
     /// \sa display_traits for more information.
+    ///
+    /// \sa deferred_display for types, which can be formatted on the consumer thread.
     template<typename T>
     view_t(const T& value, decltype(&display_traits<T>::apply)* = nullptr) {
-        construct(function_type{static_cast<const void*>(&value), std::ref(display<T>)});
+        static_assert(!deferred_display<T>::value || std::is_trivially_destructible<T>::value,
+            "deferred types must be trivially destructible");
+        static_assert(!deferred_display<T>::value || alignof(T) <= alignof(std::max_align_t),
+            "deferred types must not be over-aligned");
+
+        construct(function_type{static_cast<const void*>(&value),
+            std::ref(*(deferred_display<T>::value ? &deferred<T> : &display<T>))});
     }
 
+    /// Constructs a value view from the given function value.
+    view_t(const function_type& value);
+
     view_t(const view_t& other) = default;
     view_t(view_t&& other) = default;
 
@@ -308,6 +366,17 @@ private:
     static auto display(const void* value, writer_t& wr) -> void {
         display_traits<T>::apply(*static_cast<const T*>(value), wr);
     }
+
+    /// Formats the value, unless called while capturing an owned record, in which case the value
+    /// is copied into the record to be formatted later.
+    template<typename T>
+    static auto deferred(const void* value, writer_t& wr) -> void {
+        if (auto capture = detail::capture_of(wr)) {
+            detail::defer(*capture, value, sizeof(T), alignof(T), &detail::copy<T>);
+        } else {
+            display<T>(value, wr);
+        }
+    }
 };
 
 /// Retrieves a value of a specified, but yet restricted type, from a given attribute value.
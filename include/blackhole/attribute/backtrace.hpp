@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+#include "blackhole/attribute.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace attribute {
+
+/// Represents a stack trace of the calling thread captured as raw return addresses, which is meant
+/// to be attached to error records as an attribute value.
+///
+/// Capturing only walks the stack using the unwinder, which costs microseconds, while resolving
+/// symbols and demangling them is left to formatting. The type is marked with `deferred_display`,
+/// so records converted into the owned form for asynchronous processing carry a copy of addresses,
+/// which are symbolized on the consumer thread. Symbols are resolved using `dladdr` and demangled
+/// once per address, the results are cached for the process lifetime.
+///
+/// Traces are formatted as frames separated by " <- ", starting from the innermost one. Each frame
+/// is either `symbol+0xoffset`, `module+0xoffset` for functions without exported symbols or just a
+/// hexadecimal address, for example:
+///     handle(request_t const&)+0x4c <- main+0x1d <- libc.so.6+0x29d90
+///
+/// Attribute views just reference values, so the trace must outlive the logging call:
+///     const auto backtrace = attribute::backtrace_t::capture();
+///     log.log(0, "failed to handle request", {{"backtrace", backtrace}});
+///
+/// \note the first capture in the process loads the unwinder, which allocates memory.
+class backtrace_t {
+public:
+    /// Maximum number of frames kept, deeper ones are truncated.
+    static constexpr std::size_t capacity = 32;
+
+private:
+    std::size_t size_;
+    void* frames[capacity];
+
+public:
+    /// Constructs an empty trace.
+    backtrace_t() noexcept;
+
+    /// Captures the stack of the calling thread, skipping the given number of innermost frames
+    /// besides the frame of this function.
+    static auto capture(std::size_t skip = 0) noexcept -> backtrace_t;
+
+    /// Returns the number of captured frames.
+    auto size() const noexcept -> std::size_t;
+
+    /// Returns the return address of the given frame, the innermost one being the first.
+    auto operator[](std::size_t id) const noexcept -> void*;
+
+    /// Writes symbolized frames into the given writer.
+    auto format(writer_t& writer) const -> void;
+};
+
+/// Returns the symbolized frame of the given return address, resolving it only once.
+///
+/// \remark this function is thread-safe.
+auto symbolize(const void* address) -> std::string;
+
+}  // namespace attribute
+
+template<>
+struct display_traits<attribute::backtrace_t> {
+    static auto apply(const attribute::backtrace_t& value, writer_t& writer) -> void {
+        value.format(writer);
+    }
+};
+
+template<>
+struct deferred_display<attribute::backtrace_t> : std::true_type {};
+
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+
+#include "blackhole/attribute.hpp"
+#include "blackhole/attributes.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace attribute {
+
+/// Represents an immutable reference-counted block of attributes with the exact capacity.
+///
+/// Keys, values and string bytes of all attributes are stored in a single allocation of exactly the
+/// required size, unlike attribute lists, which reserve space for 16 pairs inline. Blocks may be
+/// chained to the parent one, which is shared instead of being copied, so a number of blocks
+/// derived from the same parent cost only their own attributes.
+///
+/// Copying a block only increments its reference counter, which is thread-safe.
+///
+/// \warning function values are not owned, their referents must outlive the block.
+class block_t {
+    struct header_t;
+    header_t* inner;
+
+public:
+    typedef view_of<attribute_t>::type value_type;
+
+    /// Constructs an empty block, which allocates nothing.
+    block_t() noexcept;
+
+    /// Constructs a block by copying keys and string values of the given attributes, followed by
+    /// the ones of the given parent block.
+    ///
+    /// \throw std::bad_alloc on memory allocation failure.
+    explicit block_t(const view_of<attributes_t>::type& attributes, block_t parent = block_t());
+
+    block_t(const block_t& other) noexcept;
+    block_t(block_t&& other) noexcept;
+
+    ~block_t();
+
+    auto operator=(const block_t& other) noexcept -> block_t&;
+    auto operator=(block_t&& other) noexcept -> block_t&;
+
+    /// Returns the number of all attributes, including the ones of parent blocks.
+    auto size() const noexcept -> std::size_t;
+
+    /// Returns the number of bytes allocated by this block, excluding parent blocks.
+    auto capacity() const noexcept -> std::size_t;
+
+    /// Returns the parent block, which is empty for root blocks.
+    auto parent() const noexcept -> block_t;
+
+    /// Appends views of own attributes followed by the ones of parent blocks to the given list.
+    ///
+    /// Views are valid while this block is alive.
+    auto append(view_of<attributes_t>::type& attributes) const -> void;
+
+    /// Returns views of all attributes, which are valid while this block is alive.
+    auto attributes() const -> view_of<attributes_t>::type;
+
+private:
+    auto reset() noexcept -> void;
+};
+
+}  // namespace attribute
+}  // namespace v1
+}  // namespace blackhole
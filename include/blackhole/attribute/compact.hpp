@@ -0,0 +1,161 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "blackhole/attribute.hpp"
+#include "blackhole/attributes.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace attribute {
+
+/// Represents a compact owned attribute value holder, designed to be cheap to copy.
+///
+/// Unlike `value_t`, which is built on top of a variant with `std::string` and `std::function`,
+/// this is a 24-byte tagged union. Strings up to `capacity` bytes are stored inline and only longer
+/// ones require a heap allocation, while function values are stored as a raw pointer with its
+/// formatting trampoline, exactly like in views. Hence copying values of all types except long
+/// strings never allocates.
+///
+/// \warning function values are not owned, their referents must outlive the value.
+class compact_t {
+public:
+    /// Maximum size of strings that are stored inline.
+    static constexpr std::size_t capacity = 16;
+
+private:
+    enum class tag_t : std::uint8_t {
+        null,
+        boolean,
+        sint64,
+        uint64,
+        real,
+        small,
+        large,
+        function
+    };
+
+    struct large_t {
+        char* data;
+        std::size_t size;
+    };
+
+    struct function_t {
+        const void* value;
+        auto(*fn)(const void* value, writer_t& writer) -> void;
+    };
+
+    union payload_t {
+        bool boolean;
+        std::int64_t sint64;
+        std::uint64_t uint64;
+        double real;
+        char small[capacity];
+        large_t large;
+        function_t function;
+    };
+
+    payload_t payload;
+    std::uint8_t size;
+    tag_t tag;
+
+public:
+    /// Constructs a null value.
+    compact_t() noexcept;
+
+    compact_t(std::nullptr_t) noexcept;
+
+    /// Constructs a value initialized with the given boolean value.
+    compact_t(bool value) noexcept;
+
+    /// Constructs a value initialized with the given signed integer.
+    compact_t(char value) noexcept;
+    compact_t(short value) noexcept;
+    compact_t(int value) noexcept;
+    compact_t(long value) noexcept;
+    compact_t(long long value) noexcept;
+
+    /// Constructs a value initialized with the given unsigned integer.
+    compact_t(unsigned char value) noexcept;
+    compact_t(unsigned short value) noexcept;
+    compact_t(unsigned int value) noexcept;
+    compact_t(unsigned long value) noexcept;
+    compact_t(unsigned long long value) noexcept;
+
+    compact_t(double value) noexcept;
+
+    /// Constructs a value from the given string literal not including the terminating null
+    /// character.
+    ///
+    /// \note this overload is required to prevent implicit conversion literal values to bool.
+    template<std::size_t N>
+    compact_t(const char(&value)[N]) : compact_t(string_view(value, N - 1)) {}
+
+    /// Constructs a value by copying the given string.
+    ///
+    /// \throw std::bad_alloc if the string is longer than `capacity` and allocation fails.
+    compact_t(const string_view& value);
+    compact_t(const std::string& value);
+
+    /// Constructs a value referring to the given function value.
+    compact_t(const view_t::function_type& value) noexcept;
+
+    /// Constructs a value from the given attribute value view, copying strings.
+    ///
+    /// Function values are referred to, not copied.
+    compact_t(const view_t& value);
+
+    /// Constructs a value from the given owned attribute value.
+    ///
+    /// Function values are referred to, not copied.
+    compact_t(const value_t& value);
+
+    compact_t(const compact_t& other);
+    compact_t(compact_t&& other) noexcept;
+
+    ~compact_t();
+
+    auto operator=(const compact_t& other) -> compact_t&;
+    auto operator=(compact_t&& other) noexcept -> compact_t&;
+
+    /// Returns a lightweight view of this value, which is valid until it's modified or destroyed.
+    auto view() const noexcept -> view_t;
+
+    auto operator==(const compact_t& other) const -> bool;
+    auto operator!=(const compact_t& other) const -> bool;
+
+private:
+    auto assign(const string_view& value) -> void;
+    auto reset() noexcept -> void;
+};
+
+}  // namespace attribute
+}  // namespace v1
+}  // namespace blackhole
+
+namespace blackhole {
+inline namespace v1 {
+
+typedef std::pair<std::string, attribute::compact_t> compact_attribute_t;
+
+#ifdef BLACKHOLE_HAVE_SMALL_VECTOR
+typedef boost::container::small_vector<compact_attribute_t, 16> compact_attributes_t;
+#else
+typedef std::vector<compact_attribute_t> compact_attributes_t;
+#endif
+
+/// Converts the given owned attributes into the compact form.
+///
+/// Since compact function values are not owned, the source is moved into the given holder if it
+/// contains function values, which are then referred to.
+///
+/// \throw std::bad_alloc on memory allocation failure.
+auto into_compact(attributes_t source, std::unique_ptr<const attributes_t>& holder) ->
+    compact_attributes_t;
+
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+
+#include "blackhole/stdext/string_view.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace attribute {
+
+/// Represents an interned attribute key.
+///
+/// All keys with the same name share a process-wide entry, which holds the name, its precomputed
+/// hash and a stable id. Names of interned keys point to the same storage, which lives until the
+/// process exits, so attribute lists built with such keys compare them by pointer instead of
+/// comparing bytes, and formatters, which intern their attribute names, match them without hashing.
+///
+/// Interning requires a lock, so keys are meant to be declared once, usually using `BH_ATTR_KEY`
+/// macro, rather than constructed on each logging event. For example:
+///     BH_ATTR_KEY(request_id);
+///
+///     logger.log(0, "processed", attribute_list{{request_id, 42}});
+class key_t {
+    string_view name_;
+    std::uint64_t hash_;
+    std::uint32_t id_;
+
+public:
+    /// Constructs a key interning the given name.
+    ///
+    /// \throw std::bad_alloc on memory allocation failure.
+    explicit key_t(const string_view& name);
+
+    /// Returns the interned name, which remains valid until the process exits.
+    auto name() const noexcept -> string_view {
+        return name_;
+    }
+
+    /// Returns the name hash, which equals to `std::hash<string_view>` of the name.
+    auto hash() const noexcept -> std::uint64_t {
+        return hash_;
+    }
+
+    /// Returns the id, which is unique for each interned name and dense, starting from zero.
+    auto id() const noexcept -> std::uint32_t {
+        return id_;
+    }
+
+    operator string_view() const noexcept {
+        return name_;
+    }
+
+    auto operator==(const key_t& other) const noexcept -> bool {
+        return id_ == other.id_;
+    }
+
+    auto operator!=(const key_t& other) const noexcept -> bool {
+        return id_ != other.id_;
+    }
+};
+
+}  // namespace attribute
+}  // namespace v1
+}  // namespace blackhole
+
+/// Declares an interned attribute key with the given identifier as its name.
+#define BH_ATTR_KEY(name) \
+    const ::blackhole::attribute::key_t name(::blackhole::string_view(#name, sizeof(#name) - 1))
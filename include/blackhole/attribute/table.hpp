@@ -0,0 +1,114 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <type_traits>
+
+#include "blackhole/attribute.hpp"
+#include "blackhole/attributes.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace attribute {
+
+class key_t;
+
+/// Represents a flattened table of unique record attributes in the structure-of-arrays form.
+///
+/// Key hashes, key views, type tags and pointers to values are kept in separate dense columns, so
+/// lookups scan only the hash column, several hashes at once where SIMD is available, and consumers
+/// iterating all attributes never chase pointers of the nested attribute pack. Attributes keep the
+/// order and the deduplication rules of `unique_attributes_t`.
+///
+/// The table is computed lazily on the first access and then reused, which allows to share a
+/// single instance between all handlers and formatters processing the same record. Tables of up to
+/// `capacity` attributes require no memory allocation.
+///
+/// \warning the view must outlive the table.
+/// \note the table is not thread-safe.
+class table_t {
+public:
+    /// Type tags in the order of `view_t::types`.
+    enum class tag_t : std::uint8_t {
+        null,
+        boolean,
+        sint64,
+        uint64,
+        real,
+        string,
+        function
+    };
+
+    /// Maximum number of attributes kept inline.
+    static constexpr std::size_t capacity = 16;
+
+private:
+    template<typename T>
+    using column = typename std::aligned_storage<sizeof(T) * capacity, alignof(T)>::type;
+
+    struct overflow_t;
+
+    const unique_attributes_t* unique;
+
+    mutable bool ready;
+    mutable std::size_t size_;
+
+    mutable std::uint32_t* hashes_;
+    mutable string_view* keys_;
+    mutable tag_t* tags_;
+    mutable const view_t** values_;
+
+    /// Inline columns, which are used unless there are more than `capacity` attributes. Left
+    /// uninitialized until computed, since all of their types are trivially destructible.
+    mutable column<std::uint32_t> inline_hashes;
+    mutable column<string_view> inline_keys;
+    mutable column<tag_t> inline_tags;
+    mutable column<const view_t*> inline_values;
+
+    mutable std::unique_ptr<overflow_t> overflow;
+
+public:
+    /// Constructs an empty table.
+    table_t() noexcept;
+
+    /// Constructs a table over the given unique attributes view.
+    ///
+    /// \warning constructing from rvalue references is explicitly forbidden.
+    explicit table_t(std::reference_wrapper<const unique_attributes_t> unique) noexcept;
+
+    table_t(const table_t& other) = delete;
+    auto operator=(const table_t& other) -> table_t& = delete;
+
+    ~table_t();
+
+    /// Rebinds the table to the given view, dropping the computed result.
+    auto reset(std::reference_wrapper<const unique_attributes_t> unique) noexcept -> void;
+
+    /// Returns the number of attributes.
+    auto size() const -> std::size_t;
+    auto empty() const -> bool;
+
+    /// Returns columns, each of `size()` elements. Hashes are lower 32 bits of
+    /// `std::hash<string_view>` of keys.
+    auto hashes() const -> const std::uint32_t*;
+    auto keys() const -> const string_view*;
+    auto tags() const -> const tag_t*;
+    auto values() const -> const view_t* const*;
+
+    /// Returns the value of the attribute with the given key or `nullptr` if there is none.
+    auto find(const string_view& key) const -> const view_t*;
+
+    /// Returns the value of the attribute with the given interned key, reusing its precomputed
+    /// hash, or `nullptr` if there is none.
+    auto find(const key_t& key) const -> const view_t*;
+
+private:
+    auto compute() const -> void;
+    auto find(const string_view& key, std::uint32_t hash) const -> const view_t*;
+};
+
+}  // namespace attribute
+}  // namespace v1
+}  // namespace blackhole
@@ -3,6 +3,8 @@
 #include <functional>
 #include <string>
 
+#include <boost/iterator/indirect_iterator.hpp>
+
 #ifdef __has_include
     #if __has_include(<boost/container/small_vector.hpp>)
         #define BLACKHOLE_HAVE_SMALL_VECTOR
@@ -76,5 +78,61 @@ typedef boost::container::small_vector<std::reference_wrapper<const view_of<attr
 typedef std::vector<std::reference_wrapper<const view_of<attributes_t>::type>> attribute_pack;
 #endif
 
+/// Flattened view over an attribute pack with duplicate keys removed.
+///
+/// When several attributes share the same key the first one in the pack order wins, i.e. message
+/// attributes shadow wrapper ones, which in turn shadow scoped attributes.
+///
+/// The view is computed lazily on the first access and then reused, which allows to share a
+/// single instance between all handlers and formatters processing the same record. Pointers to
+/// unique attributes are kept in a small buffer and require no memory allocation in the common
+/// case.
+///
+/// \warning the pack must outlive the view and must not be modified after the first access.
+/// \note the view is not thread-safe.
+class unique_attributes_t {
+public:
+    typedef view_of<attribute_t>::type value_type;
+
+private:
+#ifdef BLACKHOLE_HAVE_SMALL_VECTOR
+    typedef boost::container::small_vector<const value_type*, 32> container_type;
+#else
+    typedef std::vector<const value_type*> container_type;
+#endif
+
+    const attribute_pack* pack;
+
+    mutable bool ready;
+    mutable container_type items;
+
+public:
+    typedef boost::indirect_iterator<container_type::const_iterator> const_iterator;
+
+    /// Constructs an empty view.
+    unique_attributes_t() noexcept;
+
+    /// Constructs a view over the given attribute pack.
+    ///
+    /// \warning constructing from rvalue references is explicitly forbidden.
+    explicit unique_attributes_t(std::reference_wrapper<const attribute_pack> pack) noexcept;
+
+    unique_attributes_t(const unique_attributes_t& other) = delete;
+    auto operator=(const unique_attributes_t& other) -> unique_attributes_t& = delete;
+
+    /// Rebinds the view to the given attribute pack, dropping the computed result.
+    auto reset(std::reference_wrapper<const attribute_pack> pack) noexcept -> void;
+
+    auto begin() const -> const_iterator;
+    auto end() const -> const_iterator;
+
+    /// Returns the number of unique attributes.
+    auto size() const -> std::size_t;
+    auto empty() const -> bool;
+
+private:
+    auto compute() const -> const container_type&;
+};
+
 }  // namespace v1
 }  // namespace blackhole
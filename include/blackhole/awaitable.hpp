@@ -0,0 +1,52 @@
+#pragma once
+
+#include "blackhole/pressure.hpp"
+#include "blackhole/root.hpp"
+
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+#if __has_include(<coroutine>)
+#include <coroutine>
+#define BLACKHOLE_HAVE_COROUTINES
+#endif
+#endif
+
+#ifdef BLACKHOLE_HAVE_COROUTINES
+
+namespace blackhole {
+inline namespace v1 {
+
+/// Awaitable, which completes immediately while the logger pressure is below the given level and
+/// otherwise suspends the awaiting coroutine until it falls below, for example:
+///     co_await blackhole::admission(log);
+///     log.log(0, "processed {} items", count);
+///
+/// \warning the coroutine is resumed on the shared timer thread, use `root_logger_t::async_wait`
+///     with a function posting the resumption to continue on an event loop instead.
+class admission {
+    root_logger_t& logger;
+    pressure_t::level_t level;
+
+public:
+    explicit admission(root_logger_t& logger,
+                       pressure_t::level_t level = pressure_t::level_t::critical) noexcept :
+        logger(logger),
+        level(level)
+    {}
+
+    auto await_ready() const -> bool {
+        return logger.pressure().level < level;
+    }
+
+    auto await_suspend(std::coroutine_handle<> handle) -> bool {
+        return !logger.async_wait(level, [handle] {
+            handle.resume();
+        });
+    }
+
+    auto await_resume() const noexcept -> void {}
+};
+
+}  // namespace v1
+}  // namespace blackhole
+
+#endif
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace blackhole {
+inline namespace v1 {
+namespace budget {
+
+/// Sets the process-wide memory budget of logging in bytes, zero meaning no limit, which is the
+/// default.
+///
+/// Records captured by asynchronous sinks and handlers and preallocated buffers, like rings and
+/// raw file descriptor buffers, are accounted against the budget. Once it's exhausted, enqueueing
+/// new records fails as if queues were full, so overflow policies decide whether to drop records
+/// or to wait, for example dropping low severity ones immediately. Preallocated buffers are
+/// accounted, but never rejected.
+///
+/// \note the budget is checked before records are captured, so it may be exceeded by the records
+///     being captured concurrently.
+auto limit(std::size_t bytes) noexcept -> void;
+
+/// Returns the memory budget in bytes, zero meaning no limit.
+auto limit() noexcept -> std::size_t;
+
+/// Returns the number of bytes currently accounted against the budget.
+auto used() noexcept -> std::size_t;
+
+/// Returns the number of records rejected because of the exhausted budget so far.
+auto rejected() noexcept -> std::uint64_t;
+
+}  // namespace budget
+}  // namespace v1
+}  // namespace blackhole
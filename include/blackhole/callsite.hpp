@@ -0,0 +1,164 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace blackhole {
+inline namespace v1 {
+namespace callsite {
+
+/// Represents a logging statement, which can be enabled or disabled at runtime, much like call
+/// sites of the linux kernel dynamic debug facility.
+///
+/// Sites are meant to be declared as function-local statics by `BH_DYNAMIC_LOG` macro. The
+/// constructor is constexpr, so such statics are constant-initialized and require no guard, and the
+/// site registers itself in the process-wide registry when checked for the first time, picking up
+/// rules set before. After that checking a disabled site is a single relaxed load.
+class site_t {
+    enum : std::uint8_t {
+        unregistered,
+        disabled,
+        enabled
+    };
+
+    const char* file_;
+    const char* function_;
+    const char* pattern_;
+    int line_;
+    std::atomic<std::uint8_t> state;
+
+public:
+    constexpr site_t(const char* file, int line, const char* function, const char* pattern) noexcept :
+        file_(file),
+        function_(function),
+        pattern_(pattern),
+        line_(line),
+        state(unregistered)
+    {}
+
+    site_t(const site_t& other) = delete;
+    auto operator=(const site_t& other) -> site_t& = delete;
+
+    auto file() const noexcept -> const char* {
+        return file_;
+    }
+
+    auto line() const noexcept -> int {
+        return line_;
+    }
+
+    auto function() const noexcept -> const char* {
+        return function_;
+    }
+
+    auto pattern() const noexcept -> const char* {
+        return pattern_;
+    }
+
+    /// Checks whether the site is enabled, registering it on the first call.
+    auto is_enabled() noexcept -> bool {
+        const auto state = this->state.load(std::memory_order_relaxed);
+
+        if (state == disabled) {
+            return false;
+        } else if (state == enabled) {
+            return true;
+        }
+
+        return enroll();
+    }
+
+    /// Enables or disables the site.
+    auto set(bool value) noexcept -> void {
+        state.store(value ? enabled : disabled, std::memory_order_relaxed);
+    }
+
+private:
+    auto enroll() noexcept -> bool;
+};
+
+/// Selects call sites, matching all of them by default.
+struct query_t {
+    /// Substring of the source file path, for example "src/db/".
+    std::string file;
+    /// Function name, compared exactly.
+    std::string function;
+    /// Substring of the message pattern.
+    std::string pattern;
+    /// Line number, zero matches any line.
+    int line;
+
+    query_t() : line(0) {}
+};
+
+/// Enables or disables all registered sites matching the given query and remembers the rule, so
+/// it also applies to sites registered later. Later rules take precedence.
+///
+/// Returns the number of registered sites matched.
+///
+/// \throw std::bad_alloc on memory allocation failure.
+auto set(const query_t& query, bool enabled) -> std::size_t;
+
+/// Parses and applies the given control command.
+///
+/// Commands consist of whitespace separated `field=value` terms, where fields are "file", "func",
+/// "line" and "format" with meaning of the corresponding query fields, followed by either "+" to
+/// enable or "-" to disable matched sites, for example:
+///     file=src/db/ func=connect +
+///
+/// Returns the number of registered sites matched.
+///
+/// \throw std::invalid_argument if the command is malformed.
+auto apply(const std::string& command) -> std::size_t;
+
+/// Removes all rules and disables all registered sites.
+auto reset() -> void;
+
+/// Invokes the given function for each registered site.
+auto each(const std::function<auto(const site_t& site) -> void>& fn) -> void;
+
+/// Serves control commands over a unix stream socket in a background thread.
+///
+/// Each connection may send newline separated commands, for each of which either the number of
+/// matched sites or an error description is written back.
+class control_t {
+    class inner_t;
+    std::unique_ptr<inner_t> d;
+
+public:
+    /// Binds to the given socket path, replacing stale sockets.
+    ///
+    /// \throw std::system_error if the socket can't be bound.
+    /// \throw std::invalid_argument if the path is too long.
+    explicit control_t(const std::string& path);
+
+    control_t(const control_t& other) = delete;
+    auto operator=(const control_t& other) -> control_t& = delete;
+
+    /// Stops serving and removes the socket.
+    ~control_t();
+};
+
+}  // namespace callsite
+}  // namespace v1
+}  // namespace blackhole
+
+#define BH_DETAIL_FIRST(...) BH_DETAIL_FIRST_(__VA_ARGS__, ~)
+#define BH_DETAIL_FIRST_(first, ...) first
+
+/// Logs using the given logger facade if the call site is enabled at runtime, which all sites are
+/// not by default. The first variadic argument must be the pattern string literal, for example:
+///     BH_DYNAMIC_LOG(log, 0, "cache miss for {}", key);
+///
+/// Arguments aren't evaluated while the site is disabled.
+#define BH_DYNAMIC_LOG(logger, severity, ...)                                                      \
+    do {                                                                                           \
+        static ::blackhole::callsite::site_t bh_site_(__FILE__, __LINE__, __func__,                \
+            BH_DETAIL_FIRST(__VA_ARGS__));                                                         \
+        if (bh_site_.is_enabled()) {                                                               \
+            (logger).log((severity), __VA_ARGS__);                                                 \
+        }                                                                                          \
+    } while (false)
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace blackhole {
+inline namespace v1 {
+namespace capture {
+
+/// Represents per-record size limits, where zero means no limit, which is the default.
+struct limits_t {
+    /// Maximum size of the formatted message in bytes.
+    std::size_t message;
+    /// Maximum size of each string attribute value in bytes, including formatted values of
+    /// function attributes once the record is captured.
+    std::size_t value;
+    /// Maximum number of attributes.
+    std::size_t attributes;
+
+    constexpr limits_t() noexcept :
+        message(0),
+        value(0),
+        attributes(0)
+    {}
+};
+
+/// Sets the process-wide limits, which bound the memory and capture cost of a single record, so
+/// that a huge value logged by accident never floods queues.
+///
+/// Records exceeding the limits are bounded before blocking handlers filter and format them and
+/// when they are captured into owned records, like ones queued by asynchronous handlers and sinks
+/// or kept by recorders. Oversized messages and values are cut at the UTF-8 character boundary
+/// not exceeding the limit and followed by the "..." marker, and attributes beyond the limit are
+/// elided, replaced with the "elided" attribute holding their number. Patterns are cut at the same
+/// position without the marker, keeping their identity.
+auto limit(const limits_t& limits) noexcept -> void;
+
+/// Returns the process-wide limits.
+auto limits() noexcept -> limits_t;
+
+/// Returns the number of records bounded so far.
+auto truncated() noexcept -> std::uint64_t;
+
+}  // namespace capture
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "blackhole/attribute.hpp"
+#include "blackhole/attributes.hpp"
+#include "blackhole/logger.hpp"
+#include "blackhole/stdext/string_view.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+
+class root_logger_t;
+
+namespace detail {
+namespace category {
+struct node_t;
+}  // namespace category
+}  // namespace detail
+
+}  // namespace v1
+}  // namespace blackhole
+
+namespace blackhole {
+inline namespace v1 {
+
+/// Logger adaptor representing a named category of the root logger, like "db.pool", which has its
+/// own severity threshold and attaches the "category" attribute with its name to every logging
+/// event.
+///
+/// Categories form a hierarchy by their dot separated names, i.e. "db.pool" inherits the threshold
+/// of "db" unless it has its own one assigned, while categories having no threshold anywhere up in
+/// the hierarchy use the logger threshold. Thresholds are resolved when they change, so handles
+/// check their category with a single relaxed atomic load. An assigned category threshold replaces
+/// the logger one, which allows to enable verbose logging of a single category, while the adaptive
+/// threshold still applies.
+///
+/// Handles are cheap to copy and are intended to be obtained once, for example as class members,
+/// via `root_logger_t::category`.
+///
+/// \warning handles refer to the logger they are obtained from, so they must not outlive it.
+class category_t : public logger_t {
+    root_logger_t* root;
+    const detail::category::node_t* node;
+    attribute_list attributes;
+
+public:
+    /// Returns the full name of this category.
+    auto name() const noexcept -> string_view;
+
+    /// Returns the current effective threshold of this category, which is the minimum integer
+    /// value if the logger threshold applies.
+    auto threshold() const noexcept -> severity_t;
+
+    /// Checks whether logging events with the given severity pass the category threshold.
+    ///
+    /// The logging facade uses this method to avoid message formatting of disabled events.
+    auto enabled(severity_t severity) const noexcept -> bool;
+
+    auto log(severity_t severity, const message_t& message) -> void;
+    auto log(severity_t severity, const message_t& message, attribute_pack& pack) -> void;
+    auto log(severity_t severity, const lazy_message_t& message, attribute_pack& pack) -> void;
+
+    auto manager() -> scope::manager_t&;
+
+private:
+    friend class root_logger_t;
+
+    category_t(root_logger_t& root, const detail::category::node_t& node);
+};
+
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace blackhole {
+inline namespace v1 {
+
+/// Represents a clock source used to timestamp log records.
+enum class clock_source_t {
+    /// Regular `std::chrono::system_clock`, i.e. `CLOCK_REALTIME` on linux.
+    precise,
+    /// Realtime clock with a resolution of a scheduler tick, i.e. `CLOCK_REALTIME_COARSE` on linux.
+    ///
+    /// Falls back to the precise clock on other platforms.
+    coarse,
+    /// CPU timestamp counter based clock calibrated against the realtime clock once.
+    ///
+    /// Assumes the invariant TSC, i.e. synchronized between cores and ticking at a constant rate.
+    /// Falls back to the coarse clock on platforms without TSC.
+    tsc
+};
+
+/// Parses the clock source from its name, i.e. "precise", "coarse" or "tsc".
+///
+/// \throw std::invalid_argument if the name is unknown.
+auto clock_source(const std::string& name) -> clock_source_t;
+
+namespace clock {
+
+/// Returns the current time point obtained using the given clock source.
+auto now(clock_source_t source) noexcept -> std::chrono::system_clock::time_point;
+
+/// Sets the time point records activated by the calling thread are timestamped with instead of
+/// reading the clock, until the thread clears it.
+///
+/// Event loops reading the clock once per iteration may refresh the cached time with that reading,
+/// so records logged within the iteration cost no clock read and share the timestamp, which also
+/// makes caches of formatters keyed by the timestamp second hit more often. Timestamps are as
+/// stale as the cached time is, and records of threads not caching the time may interleave with
+/// them out of timestamp order.
+auto cache(std::chrono::system_clock::time_point timestamp) noexcept -> void;
+
+/// Clears the time point cached by the calling thread, so its records read the clock again.
+auto clear() noexcept -> void;
+
+/// Returns the time point cached by the calling thread if any, or the current time point obtained
+/// using the given clock source otherwise.
+auto timestamp(clock_source_t source) noexcept -> std::chrono::system_clock::time_point;
+
+/// Caches the given time point for the calling thread while alive, restoring the previous cached
+/// time point if any after, which suits a scope of a single event loop iteration.
+class cached_t {
+    std::chrono::system_clock::time_point previous;
+    bool cached;
+
+public:
+    explicit cached_t(std::chrono::system_clock::time_point timestamp) noexcept;
+    ~cached_t();
+
+    cached_t(const cached_t& other) = delete;
+    auto operator=(const cached_t& other) -> cached_t& = delete;
+};
+
+/// Performs one-time initialization required for clock sources to be used, i.e. TSC calibration.
+///
+/// Does nothing when called again.
+///
+/// \note the first TSC calibration blocks the calling thread for about 10 milliseconds.
+auto prepare(clock_source_t source) -> void;
+
+/// Returns the current reading of the cheapest monotonic counter, which is the TSC if available,
+/// or nanoseconds of the steady clock otherwise.
+///
+/// Readings are meaningful only relatively to each other, see `nanoseconds`.
+auto ticks() noexcept -> std::uint64_t;
+
+/// Converts the given difference of counter readings into nanoseconds.
+///
+/// \note the first conversion of TSC ticks blocks the calling thread for calibration, unless the
+///     TSC clock source was prepared before.
+auto nanoseconds(std::uint64_t ticks) noexcept -> std::uint64_t;
+
+}  // namespace clock
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace blackhole {
+inline namespace v1 {
+namespace metrics {
+
+class collector_t;
+
+}  // namespace metrics
+}  // namespace v1
+}  // namespace blackhole
+
+namespace blackhole {
+inline namespace v1 {
+namespace cputime {
+
+/// Enables CPU time accounting of one in every given number of records logged by each thread,
+/// disabling it if zero, which is the default.
+///
+/// The thread CPU clock is read before and after logging sampled records, and the difference
+/// multiplied by the sampling period is attributed to the calling thread as an estimation of the
+/// CPU time it spends logging. Other records cost a single thread-local countdown. While enabled,
+/// asynchronous sinks also account CPU time their consumers spend draining them.
+///
+/// Metrics snapshots of root loggers expose the estimations as
+/// `blackhole_log_cpu_nanoseconds_total{thread="...", tid="..."}` next to the total CPU time of
+/// each thread as `blackhole_thread_cpu_nanoseconds_total`, so that their ratio is the fraction
+/// of the thread CPU going to logging. Estimations of exited threads are summed into
+/// `blackhole_log_cpu_exited_nanoseconds_total`. Asynchronous sinks expose their consumers CPU
+/// time as `blackhole_consumer_cpu_nanoseconds_total`.
+auto sample(std::size_t every) -> void;
+
+/// Returns the sampling period, zero if accounting is disabled.
+auto sampling() noexcept -> std::size_t;
+
+/// Returns the estimated CPU time in nanoseconds the calling thread has spent logging.
+auto spent() noexcept -> std::uint64_t;
+
+/// Collects per-thread accounting into the given collector.
+auto collect(metrics::collector_t& collector) -> void;
+
+}  // namespace cputime
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,35 @@
+#pragma once
+
+namespace blackhole {
+inline namespace v1 {
+namespace crash {
+
+/// Installs handlers of fatal signals, i.e. `SIGSEGV`, `SIGBUS`, `SIGILL`, `SIGFPE` and `SIGABRT`,
+/// which write records still pending in memory into the given preopened file descriptor before
+/// the process dies.
+///
+/// Pending data consists of formatted messages in rings of asynchronous sinks running in "ring"
+/// mode, lines buffered by file sinks and records kept by flight recorder handlers, the latter
+/// written as `[severity] message` lines. Records in asynchronous queues of "queue" mode sinks and
+/// asynchronous handlers are not dumped, since lock-free queues can not be walked safely.
+///
+/// Handlers use async-signal-safe calls only, running on the alternate signal stack if the
+/// crashing thread has one. Once the data is written, previous handlers are restored and the
+/// signal is raised again, so core dumps and other crash reporters keep working.
+///
+/// \note the data is read without synchronization with interrupted threads, so the last records
+///     may be torn.
+/// \throw std::system_error if unable to install handlers.
+auto install(int fd) -> void;
+
+/// Restores handlers of fatal signals replaced by `install`.
+auto uninstall() -> void;
+
+/// Writes records pending in memory into the given file descriptor right now.
+///
+/// \note async-signal-safe, so it can be called from custom signal handlers.
+auto dump(int fd) noexcept -> void;
+
+}  // namespace crash
+}  // namespace v1
+}  // namespace blackhole
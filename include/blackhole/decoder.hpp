@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "blackhole/forward.hpp"
+#include "blackhole/stdext/string_view.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+
+/// Decodes files of records written by the binary formatter, formatting them back using any
+/// formatter, which allows to reuse production formatter configs offline.
+///
+/// The file is memory-mapped and split into chunks, which are decoded and formatted in parallel.
+/// Chunks start at offsets of the time index sidecar if the file has one, which are exact frame
+/// boundaries. Otherwise each chunk resynchronizes at the first well-formed frame, and chunks,
+/// whose frames turn out to be misaligned with the preceding ones, are decoded again after it, so
+/// the output is the same as the sequential decoding gives.
+///
+/// Malformed bytes, like a torn tail or corrupted frames, are skipped and counted.
+class decoder_t {
+public:
+    typedef std::function<auto() -> std::unique_ptr<formatter_t>> factory_type;
+    typedef std::function<auto(const string_view& data) -> void> callback_type;
+
+    struct options_t {
+        /// Number of decoding threads, the number of cores if zero.
+        std::size_t threads;
+        /// Approximate size of a chunk in bytes.
+        std::size_t chunk;
+
+        options_t() :
+            threads(0),
+            chunk(4 * 1024 * 1024)
+        {}
+    };
+
+    struct stats_t {
+        std::uint64_t records;
+        std::uint64_t skipped;
+    };
+
+private:
+    std::string path_;
+
+    const char* data;
+    std::size_t size_;
+
+    /// Frame offsets taken from the time index.
+    std::vector<std::uint64_t> boundaries;
+
+public:
+    /// Maps the given file, reading its time index if present.
+    ///
+    /// \throw std::system_error if unable to open or to map the file.
+    explicit decoder_t(std::string path);
+    ~decoder_t();
+
+    decoder_t(const decoder_t& other) = delete;
+    auto operator=(const decoder_t& other) -> decoder_t& = delete;
+
+    auto path() const noexcept -> const std::string&;
+
+    /// Returns the file size in bytes.
+    auto size() const noexcept -> std::size_t;
+
+    /// Decodes all records, formatting each one followed by a newline.
+    ///
+    /// The factory is called on the calling thread to construct a formatter per thread, so
+    /// formatters need not be thread-safe. Formatted chunks are passed to the callback in the file
+    /// order on the calling thread too.
+    ///
+    /// \throw std::invalid_argument if the chunk size is zero.
+    /// \throw any exception thrown by the factory, formatters or the callback.
+    auto decode(const factory_type& factory, const callback_type& fn,
+                const options_t& options = options_t()) const -> stats_t;
+};
+
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,292 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <type_traits>
+
+#include "blackhole/extensions/writer.hpp"
+#include "blackhole/severity.hpp"
+#include "blackhole/stdext/string_view.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+
+class root_logger_t;
+
+namespace deferred {
+
+/// Represents a registered logging call site, i.e. its format pattern.
+///
+/// Patterns are registered in a process-wide table once, when the call site object is constructed,
+/// and further referred to by a dense id, allowing logging events to carry only the id instead of
+/// the pattern itself. Call sites are meant to be declared as static objects near the logging
+/// statement, for example:
+///     static const deferred::callsite_t callsite("processed {} bytes in {} ms");
+///     log.log(callsite, 0, size, elapsed);
+class callsite_t {
+    const char* pattern_;
+    std::uint32_t id_;
+
+public:
+    /// Registers the given pattern.
+    ///
+    /// \throw std::bad_alloc on memory allocation failure.
+    template<std::size_t N>
+    explicit callsite_t(const char(&pattern)[N]) :
+        pattern_(pattern),
+        id_(enroll(pattern))
+    {}
+
+    callsite_t(const callsite_t& other) = delete;
+    auto operator=(const callsite_t& other) -> callsite_t& = delete;
+
+    auto pattern() const noexcept -> const char* {
+        return pattern_;
+    }
+
+    auto id() const noexcept -> std::uint32_t {
+        return id_;
+    }
+
+private:
+    static auto enroll(const char* pattern) -> std::uint32_t;
+};
+
+/// Returns the pattern of the call site registered with the given id.
+///
+/// \throw std::out_of_range if there is no such call site.
+auto pattern(std::uint32_t id) -> const char*;
+
+namespace detail {
+
+/// Formats the argument bytes written at the call site using the given pattern.
+typedef auto (*format_t)(const char* pattern, const char* data, writer_t& writer) -> void;
+
+/// Describes how an argument is stored in the deferred buffer and restored from there.
+///
+/// Only arithmetic values, which are copied as is, and strings, which are copied with their size
+/// prefixed, are supported, because others may be mutated or destroyed before the actual
+/// formatting.
+template<typename T, typename = void>
+struct traits {
+    static_assert(std::is_arithmetic<T>::value,
+        "deferred logging supports only arithmetic and string arguments");
+};
+
+template<typename T>
+struct traits<T, typename std::enable_if<std::is_arithmetic<T>::value>::type> {
+    static auto size(const T&) noexcept -> std::size_t {
+        return sizeof(T);
+    }
+
+    static auto write(char* it, const T& value) noexcept -> char* {
+        std::memcpy(it, &value, sizeof(T));
+        return it + sizeof(T);
+    }
+
+    static auto read(const char*& it) noexcept -> T {
+        T value;
+        std::memcpy(&value, it, sizeof(T));
+        it += sizeof(T);
+        return value;
+    }
+};
+
+struct string_traits {
+    static auto view(const string_view& value) noexcept -> string_view {
+        return value;
+    }
+
+    static auto view(const char* value) noexcept -> string_view {
+        return string_view(value, std::strlen(value));
+    }
+
+    template<typename T>
+    static auto size(const T& value) noexcept -> std::size_t {
+        return sizeof(std::size_t) + view(value).size();
+    }
+
+    template<typename T>
+    static auto write(char* it, const T& value) noexcept -> char* {
+        const auto string = view(value);
+        const auto size = string.size();
+        std::memcpy(it, &size, sizeof(size));
+        std::memcpy(it + sizeof(size), string.data(), size);
+        return it + sizeof(size) + size;
+    }
+
+    static auto read(const char*& it) noexcept -> fmt::StringRef {
+        std::size_t size;
+        std::memcpy(&size, it, sizeof(size));
+        const fmt::StringRef value(it + sizeof(size), size);
+        it += sizeof(size) + size;
+        return value;
+    }
+};
+
+template<>
+struct traits<string_view> : public string_traits {};
+
+template<>
+struct traits<std::string> : public string_traits {};
+
+template<>
+struct traits<const char*> : public string_traits {};
+
+template<>
+struct traits<char*> : public string_traits {};
+
+template<std::size_t N>
+struct traits<char[N]> : public string_traits {};
+
+inline auto size() noexcept -> std::size_t {
+    return 0;
+}
+
+template<typename T, typename... Args>
+inline auto size(const T& arg, const Args&... args) noexcept -> std::size_t {
+    return traits<T>::size(arg) + size(args...);
+}
+
+inline auto write(char* it) noexcept -> char* {
+    return it;
+}
+
+template<typename T, typename... Args>
+inline auto write(char* it, const T& arg, const Args&... args) noexcept -> char* {
+    return write(traits<T>::write(it, arg), args...);
+}
+
+template<typename... Args>
+struct reader;
+
+template<>
+struct reader<> {
+    template<typename... Values>
+    static auto apply(const char* pattern, const char*, writer_t& writer, const Values&... values) ->
+        void
+    {
+        writer.write(pattern, values...);
+    }
+};
+
+template<typename T, typename... Args>
+struct reader<T, Args...> {
+    template<typename... Values>
+    static auto apply(const char* pattern, const char* it, writer_t& writer, const Values&... values) ->
+        void
+    {
+        // Bind the value first, since the order of function arguments evaluation is unspecified.
+        const auto value = traits<T>::read(it);
+        reader<Args...>::apply(pattern, it, writer, values..., value);
+    }
+};
+
+template<typename... Args>
+auto format(const char* pattern, const char* data, writer_t& writer) -> void {
+    reader<typename std::decay<Args>::type...>::apply(pattern, data, writer);
+}
+
+/// Fixed part of each event stored in the deferred buffer, followed by arguments.
+struct header_t {
+    std::uint32_t size;
+    std::uint32_t callsite;
+    int severity;
+    format_t format;
+};
+
+}  // namespace detail
+}  // namespace deferred
+
+/// Logger adaptor that defers message formatting to a background thread.
+///
+/// Instead of formatting the message with its arguments at the call site, which often is the most
+/// expensive part of a logging event, only the call site id and raw bytes of arguments are copied
+/// into the buffer of the calling thread. A background thread periodically collects these buffers,
+/// formats messages using cppformat and passes them to the underlying logger.
+///
+/// The severity threshold of the underlying root logger is checked at the call site, but the
+/// filter and handlers are invoked on the background thread only.
+///
+/// \note records produced this way are timestamped when being delivered to the underlying logger
+///     and carry the background thread ids; scoped attributes of the calling thread are not
+///     collected either.
+/// \note events are ordered within each thread, but not across threads.
+/// \warning thread buffers are unbounded, the background thread is only woken up earlier when one
+///     of them grows large, so producers must not persistently outpace the formatting.
+class deferred_t {
+    class inner_t;
+    std::unique_ptr<inner_t> d;
+
+public:
+    /// Creates a deferred logger delivering events to the given logger with the given interval.
+    ///
+    /// \warning the underlying logger must outlive the created object.
+    explicit deferred_t(root_logger_t& inner,
+                        std::chrono::milliseconds interval = std::chrono::milliseconds(10));
+
+    deferred_t(const deferred_t& other) = delete;
+    auto operator=(const deferred_t& other) -> deferred_t& = delete;
+
+    /// Stops the background thread, delivering all pending events.
+    ~deferred_t();
+
+    /// Checks whether the underlying logger accepts events with the given severity level.
+    auto enabled(severity_t severity) const noexcept -> bool;
+
+    /// Logs a message with the given call site pattern and arguments, deferring its formatting.
+    ///
+    /// \tparam Args... must be arithmetic or string types.
+    template<typename... Args>
+    auto log(const deferred::callsite_t& callsite, severity_t severity, const Args&... args) ->
+        void;
+
+    /// Delivers all events pending at the moment of the call on the calling thread.
+    auto flush() -> void;
+
+private:
+    /// Appends the given encoded event to the buffer of the calling thread.
+    auto push(const char* data, std::size_t size) -> void;
+};
+
+template<typename... Args>
+inline auto
+deferred_t::log(const deferred::callsite_t& callsite, severity_t severity, const Args&... args) ->
+    void
+{
+    if (!enabled(severity)) {
+        return;
+    }
+
+    typedef deferred::detail::header_t header_t;
+
+    const auto size = sizeof(header_t) + deferred::detail::size(args...);
+
+    const header_t header{
+        static_cast<std::uint32_t>(size),
+        callsite.id(),
+        severity,
+        &deferred::detail::format<Args...>
+    };
+
+    // Events are encoded on stack unless they are large, in which case the heap is used.
+    char stack[256];
+    std::unique_ptr<char[]> heap;
+
+    auto data = stack;
+    if (size > sizeof(stack)) {
+        heap.reset(new char[size]);
+        data = heap.get();
+    }
+
+    std::memcpy(data, &header, sizeof(header));
+    deferred::detail::write(data + sizeof(header), args...);
+
+    push(data, size);
+}
+
+}  // namespace v1
+}  // namespace blackhole
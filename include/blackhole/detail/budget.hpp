@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstddef>
+
+namespace blackhole {
+inline namespace v1 {
+namespace detail {
+namespace budget {
+
+/// Checks whether there is memory left in the budget for capturing a record, counting rejections.
+auto admit() noexcept -> bool;
+
+/// Accounts the given number of bytes against the budget unconditionally.
+auto charge(std::size_t bytes) noexcept -> void;
+
+/// Returns the given number of previously charged bytes to the budget.
+auto release(std::size_t bytes) noexcept -> void;
+
+}  // namespace budget
+}  // namespace detail
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <boost/optional/optional.hpp>
+
+#include "blackhole/attributes.hpp"
+#include "blackhole/record.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace detail {
+namespace capture {
+
+/// The "..." marker following values cut by limits.
+extern const string_view marker;
+
+/// Returns the size of the longest prefix of the given string of at most the given size which
+/// doesn't end in the middle of an UTF-8 character.
+auto cut(const string_view& value, std::size_t size) noexcept -> std::size_t;
+
+/// Accounts a record bounded elsewhere, like one with function values cut when captured.
+auto account() noexcept -> void;
+
+/// Record view bounded by the process-wide capture limits.
+///
+/// Records within limits are referred to as is, which costs a scan over attributes while any limit
+/// is set and nothing otherwise. Others are rebuilt with cut values copied into the bounded view
+/// along with their markers, which therefore must outlive the result.
+///
+/// Values of function attributes are formatted lazily, so they are bounded only when captured.
+class bounded_t {
+    const record_t* source;
+
+    std::string storage;
+    string_view message;
+    string_view formatted;
+    std::vector<attribute_list> lists;
+    attribute_pack pack;
+    boost::optional<record_t> result;
+
+public:
+    explicit bounded_t(const record_t& record);
+
+    bounded_t(const bounded_t& other) = delete;
+    auto operator=(const bounded_t& other) -> bounded_t& = delete;
+
+    /// Returns the bounded record, which is the original one if within limits.
+    auto get() const noexcept -> const record_t&;
+
+private:
+    auto bound(const record_t& record, std::size_t message, std::size_t value,
+               std::size_t attributes) -> void;
+};
+
+}  // namespace capture
+}  // namespace detail
+}  // namespace v1
+}  // namespace blackhole
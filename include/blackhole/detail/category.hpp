@@ -0,0 +1,79 @@
+#pragma once
+
+#include <atomic>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "blackhole/stdext/string_view.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace detail {
+namespace category {
+
+/// Threshold value of categories having no threshold assigned to them or to their ancestors, which
+/// means that the logger threshold applies.
+constexpr int unset = std::numeric_limits<int>::min();
+
+/// Represents a single category in the hierarchy, i.e. "db.pool" is a child of "db".
+///
+/// Nodes are never destroyed while their registry lives, so handles may keep pointers to them.
+struct node_t {
+    const std::string name;
+    node_t* const parent;
+    std::vector<node_t*> children;
+
+    /// Effective threshold, either the own one or the one of the nearest assigned ancestor.
+    ///
+    /// This is the only field read while logging, all others are guarded by the registry lock.
+    std::atomic<int> threshold;
+
+    bool assigned;
+    int own;
+
+    node_t(std::string name, node_t* parent) :
+        name(std::move(name)),
+        parent(parent),
+        threshold(parent ? parent->threshold.load(std::memory_order_relaxed) : unset),
+        assigned(false),
+        own(unset)
+    {}
+};
+
+/// Category hierarchy of a single logger.
+///
+/// Thresholds are resolved on updates rather than while logging, i.e. assigning a threshold to a
+/// category stores it into all its descendants, except the ones that have their own threshold, so
+/// checking a category costs a single relaxed atomic load.
+class registry_t {
+    mutable std::mutex mutex;
+    std::map<std::string, std::unique_ptr<node_t>> nodes;
+
+public:
+    /// Returns the node of the given category, creating it together with its missing ancestors.
+    ///
+    /// \throw std::invalid_argument if the name is empty or has empty components.
+    auto get(const string_view& name) -> const node_t&;
+
+    /// Assigns the threshold to the given category, propagating it down the hierarchy.
+    auto assign(const string_view& name, int threshold) -> void;
+
+    /// Drops the threshold of the given category, which inherits the one of its parent instead.
+    auto inherit(const string_view& name) -> void;
+
+    /// Assigns thresholds of all categories having one assigned in the other registry.
+    auto merge(const registry_t& other) -> void;
+
+private:
+    /// \warning must be called under the lock.
+    auto emplace(const std::string& name) -> node_t&;
+};
+
+}  // namespace category
+}  // namespace detail
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "blackhole/cputime.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace metrics {
+
+class counter_t;
+
+}  // namespace metrics
+}  // namespace v1
+}  // namespace blackhole
+
+namespace blackhole {
+inline namespace v1 {
+namespace detail {
+namespace cputime {
+
+/// Returns the CPU time consumed by the calling thread in nanoseconds.
+auto now() noexcept -> std::uint64_t;
+
+/// Decides whether the record logged by the calling thread is accounted, attributing the CPU time
+/// spent until the scope is destroyed to the calling thread if so.
+class scope_t {
+    /// Sampling period the record is accounted with, zero if it's not sampled.
+    std::size_t every;
+    std::uint64_t start;
+
+public:
+    scope_t() noexcept;
+    ~scope_t();
+
+    scope_t(const scope_t& other) = delete;
+    auto operator=(const scope_t& other) -> scope_t& = delete;
+};
+
+/// Adds the CPU time the calling thread spends until the meter is destroyed to the given counter,
+/// if accounting is enabled.
+class meter_t {
+    metrics::counter_t& counter;
+    bool enabled;
+    std::uint64_t start;
+
+public:
+    explicit meter_t(metrics::counter_t& counter) noexcept;
+    ~meter_t();
+
+    meter_t(const meter_t& other) = delete;
+    auto operator=(const meter_t& other) -> meter_t& = delete;
+};
+
+}  // namespace cputime
+}  // namespace detail
+}  // namespace v1
+}  // namespace blackhole
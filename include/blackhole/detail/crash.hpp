@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "blackhole/stdext/string_view.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace detail {
+namespace crash {
+
+/// Registration of a source of pending log data, which is written out on fatal signals.
+///
+/// Owners declare registrations as their last members, so that they are registered only after
+/// being fully constructed and unregistered before being destroyed. There is a fixed number of
+/// registration slots, so registering never allocates, while sources beyond it are not dumped.
+class registration_t {
+public:
+    /// Writes pending data of the given context into the descriptor.
+    ///
+    /// \warning must use async-signal-safe calls only, i.e. neither allocate nor lock, tolerating
+    ///     data being concurrently modified by interrupted threads.
+    typedef void (*function_type)(const void* context, int fd);
+
+private:
+    function_type fn;
+    const void* context;
+    /// Occupied slot index, negative if all slots are busy.
+    int slot;
+
+public:
+    registration_t(function_type fn, const void* context) noexcept;
+    registration_t(const registration_t& other) = delete;
+
+    ~registration_t();
+
+    auto operator=(const registration_t& other) -> registration_t& = delete;
+
+    /// Writes pending data of all registered sources into the given descriptor.
+    ///
+    /// \note async-signal-safe.
+    static auto dump(int fd) noexcept -> void;
+};
+
+/// Writes the given data as a whole, retrying on interrupts and ignoring errors.
+///
+/// \note async-signal-safe.
+auto write(int fd, const string_view& data) noexcept -> void;
+
+/// Writes the given integer in decimal notation.
+///
+/// \note async-signal-safe.
+auto write(int fd, std::int64_t value) noexcept -> void;
+
+}  // namespace crash
+}  // namespace detail
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <ctime>
+#include <string>
+#include <vector>
+
+#include "blackhole/detail/datetime.hpp"
+#include "blackhole/detail/datetime/zone.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace detail {
+namespace datetime {
+
+/// Cache of formatted timestamps, which is intended to be thread-local.
+///
+/// Broken-down time conversion and datetime generation happen once per second for each pattern
+/// only, while within the same second microseconds are patched directly into the cached result.
+/// Local time is derived from the cached timezone offset without locking, see `zone_t`.
+class cache_t {
+    struct entry_t {
+        std::string pattern;
+        bool gmtime;
+        std::time_t time;
+        bool valid;
+
+        /// Formatted timestamp with the microseconds of the last call.
+        std::string value;
+
+        /// Positions of microsecond digits in the value, six per each "%f".
+        std::vector<std::size_t> digits;
+    };
+
+    std::array<entry_t, 4> entries;
+    std::size_t next;
+    zone_t zone;
+
+public:
+    cache_t();
+
+    /// Formats the given time using the generator, which must be made from the given pattern.
+    ///
+    /// The returned reference is valid until the next call.
+    auto format(const std::string& pattern, const generator_t& generator, bool gmtime,
+                std::time_t time, std::uint64_t usec) -> const std::string&;
+
+private:
+    auto lookup(const std::string& pattern, bool gmtime) -> entry_t&;
+
+    auto generate(entry_t& entry, const generator_t& generator, std::time_t time,
+                  std::uint64_t usec) -> void;
+};
+
+}  // namespace datetime
+}  // namespace detail
+}  // namespace v1
+}  // namespace blackhole
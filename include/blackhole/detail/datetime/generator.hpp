@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <ctime>
+#include <string>
+#include <vector>
+
+namespace blackhole {
+inline namespace v1 {
+namespace detail {
+namespace datetime {
+
+/// Datetime generator compiled from a strftime-like pattern.
+///
+/// Numeric specifiers, i.e. "%Y", "%m", "%d", "%H", "%M", "%S", "%z" and their common
+/// combinations, together with the "%f" microseconds extension, are rendered directly into the
+/// stream. Any other specifier, including localized names and modified ones like "%Ey" or "%-d",
+/// is passed through to strftime as is, so the result is always the same as strftime produces.
+class generator_t {
+public:
+    enum class kind_t {
+        literal,
+        /// Specifier rendered with strftime, the value holds it with a leading percent sign.
+        strftime,
+        year,
+        year_short,
+        century,
+        month,
+        mday,
+        mday_spaced,
+        yday,
+        hour,
+        hour_half,
+        minute,
+        second,
+        usecond,
+        offset
+    };
+
+    struct token_t {
+        kind_t kind;
+        std::string value;
+    };
+
+private:
+    std::vector<token_t> tokens;
+
+public:
+    explicit generator_t(const std::string& pattern);
+
+    template<typename Stream>
+    auto operator()(Stream& stream, const std::tm& tm, std::uint64_t usec = 0) const -> void;
+};
+
+auto make_generator(const std::string& pattern) -> generator_t;
+
+}  // namespace datetime
+}  // namespace detail
+}  // namespace v1
+}  // namespace blackhole
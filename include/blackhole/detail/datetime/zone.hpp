@@ -0,0 +1,43 @@
+#pragma once
+
+#include <ctime>
+
+namespace blackhole {
+inline namespace v1 {
+namespace detail {
+namespace datetime {
+
+/// Converts the given time to UTC broken-down time arithmetically, without any locking unlike
+/// `gmtime_r`.
+auto gmtime(std::time_t time, std::tm& tm) noexcept -> void;
+
+/// Cache of the local timezone offset, which is intended to be thread-local.
+///
+/// The `localtime_r` function takes the global timezone lock on each call, serializing all
+/// threads formatting local timestamps. Instead the offset is computed once for the whole window
+/// until the next daylight saving time transition, which is located by probing up to a month
+/// ahead, and within the window broken-down time is derived from UTC arithmetically.
+///
+/// \warning changes of the TZ environment variable are not observed until the current window
+///     ends.
+class zone_t {
+    std::time_t begin;
+    std::time_t end;
+    long offset;
+    int isdst;
+    const char* name;
+
+public:
+    zone_t() noexcept;
+
+    /// Converts the given time to local broken-down time, the same as `localtime_r` does.
+    auto localtime(std::time_t time, std::tm& tm) -> void;
+
+private:
+    auto update(std::time_t time) -> void;
+};
+
+}  // namespace datetime
+}  // namespace detail
+}  // namespace v1
+}  // namespace blackhole
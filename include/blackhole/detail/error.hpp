@@ -0,0 +1,23 @@
+#pragma once
+
+#include "blackhole/error.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace detail {
+namespace error {
+
+using blackhole::error::kind_t;
+
+/// Counts an error of the given kind, passing it to the reporter unless the rate limit is exceeded.
+auto report(kind_t kind, const char* message) noexcept -> void;
+
+/// Reports the exception currently being handled, describing unknown ones as `unknown`.
+///
+/// \warning must be called inside a catch block.
+auto report(kind_t kind) noexcept -> void;
+
+}  // namespace error
+}  // namespace detail
+}  // namespace v1
+}  // namespace blackhole
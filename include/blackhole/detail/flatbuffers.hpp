@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "blackhole/stdext/string_view.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace detail {
+namespace flatbuffers {
+
+/// Position of a serialized object, measured from the end of the buffer.
+typedef std::uint32_t offset_t;
+
+/// Minimal FlatBuffers builder, see https://flatbuffers.dev/internals.
+///
+/// The buffer is built back to front, so objects must be completed before being referenced:
+/// strings and vectors go first, followed by tables referring to them. Scalar fields are always
+/// stored, even if they are equal to schema defaults.
+class builder_t {
+    std::vector<char> buffer;
+    /// Start of the data written so far, which grows towards the beginning of the buffer.
+    std::size_t head;
+    std::size_t minalign;
+
+    /// Fields of the table being built with their positions.
+    std::vector<std::pair<std::uint16_t, offset_t>> fields;
+    offset_t start;
+
+public:
+    builder_t();
+
+    /// Returns the number of bytes written so far.
+    auto size() const noexcept -> offset_t;
+
+    /// Writes the given string with its length prefix and the trailing zero.
+    auto string(const string_view& value) -> offset_t;
+
+    /// Writes the vector of references to the given objects.
+    auto offsets(const std::vector<offset_t>& values) -> offset_t;
+
+    /// Writes the vector of structs, which are given as raw little-endian bytes.
+    auto structs(const char* data, std::size_t count, std::size_t size, std::size_t alignment) ->
+        offset_t;
+
+    /// Starts building a table, whose fields are added until it ends.
+    auto begin() -> void;
+
+    template<typename T>
+    auto add(std::uint16_t field, T value) -> void {
+        char data[sizeof(T)];
+        std::memcpy(data, &value, sizeof(T));
+        push(data, sizeof(T));
+        fields.emplace_back(field, size());
+    }
+
+    /// Adds the reference to the given object.
+    auto reference(std::uint16_t field, offset_t value) -> void;
+
+    /// Completes the table, writing its vtable.
+    auto end() -> offset_t;
+
+    /// Completes the buffer with the given root table, returning its contents.
+    auto finish(offset_t root) -> std::string;
+
+private:
+    /// Writes padding, so that the given number of bytes written after it end aligned.
+    auto prepare(std::size_t alignment, std::size_t additional) -> void;
+
+    /// Writes the given aligned scalar bytes.
+    auto push(const char* data, std::size_t size) -> void;
+
+    /// Writes the given unaligned bytes.
+    auto put(const char* data, std::size_t size) -> void;
+
+    auto put_offset(offset_t value) -> void;
+};
+
+}  // namespace flatbuffers
+}  // namespace detail
+}  // namespace v1
+}  // namespace blackhole
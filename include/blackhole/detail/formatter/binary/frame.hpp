@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "blackhole/detail/sink/ring.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace detail {
+namespace formatter {
+namespace binary {
+
+/// Frame header preceding each record written by the binary formatter, followed by the record
+/// encoded by `sink::ring::encode`.
+struct frame_t {
+    std::uint32_t size;
+    /// CRC32 of the encoded record, which tells frames from arbitrary bytes while resynchronizing.
+    std::uint32_t checksum;
+};
+
+auto checksum(const char* data, std::size_t size) noexcept -> std::uint32_t;
+
+/// Checks whether a well-formed frame starts at the given offset of the buffer, returning its
+/// encoded record through the slot.
+auto parse(const char* data, std::size_t size, std::size_t offset, sink::ring_t::slot_t& slot)
+    noexcept -> bool;
+
+/// Returns the offset right after the frame of the given slot, skipping the newline following it
+/// unless the next frame starts there.
+///
+/// Line-oriented sinks, like the file one, append newlines to each formatted record.
+auto next(const char* data, std::size_t size, const sink::ring_t::slot_t& slot) noexcept ->
+    std::size_t;
+
+}  // namespace binary
+}  // namespace formatter
+}  // namespace detail
+}  // namespace v1
+}  // namespace blackhole
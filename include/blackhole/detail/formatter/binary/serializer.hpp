@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "blackhole/extensions/writer.hpp"
+#include "blackhole/record.hpp"
+
+#include "blackhole/detail/formatter/json/serializer.hpp"
+#include "blackhole/detail/formatter/layout.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace detail {
+namespace formatter {
+namespace binary {
+
+enum class encoding_t {
+    /// MessagePack, see https://github.com/msgpack/msgpack/blob/master/spec.md.
+    msgpack,
+    /// CBOR, see https://tools.ietf.org/html/rfc7049.
+    cbor
+};
+
+/// Streaming binary serializer, which writes records as nested maps directly into the writer
+/// without building an intermediate document.
+///
+/// It shares the configuration model and the output layout with the streaming JSON serializer, so
+/// the same record is encoded into the same tree, except that integral timestamps and values are
+/// written using the most compact representation and strings are always valid UTF-8, i.e. each
+/// byte of invalid sequences is replaced with U+FFFD replacement character.
+class serializer_t {
+public:
+    typedef json::serializer_t::properties_t properties_t;
+    typedef json::serializer_t::timestamp_type timestamp_type;
+
+private:
+    /// Precomputed destination of a builtin field: the object index and the encoded renamed key.
+    struct route_t {
+        std::uint32_t node;
+        std::string key;
+    };
+
+    enum builtin_t : std::uint32_t {
+        message,
+        thread,
+        process,
+        severity,
+        timestamp,
+        builtins
+    };
+
+    /// Per-record state, defined in the translation unit.
+    class frame_t;
+
+    encoding_t encoding;
+
+    layout_t layout;
+    route_t fields[builtins];
+
+    bool unique;
+
+    /// Precomputed encoded severity key-value pairs.
+    std::vector<std::string> severities;
+    timestamp_type timestamp_;
+
+public:
+    /// \throw std::invalid_argument if any of routing JSON pointers is malformed.
+    serializer_t(encoding_t encoding, properties_t properties);
+
+    auto format(const record_t& record, writer_t& writer) const -> void;
+
+private:
+    auto write(const frame_t& frame, std::uint32_t id, writer_t& writer) const -> void;
+};
+
+}  // namespace binary
+}  // namespace formatter
+}  // namespace detail
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <string>
+
+#include "blackhole/extensions/writer.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace detail {
+namespace formatter {
+namespace json {
+
+/// Writes the given string into the writer escaping quotes, backslashes and control characters
+/// exactly like RapidJSON does, without surrounding quotes.
+///
+/// Input is scanned a vector register at a time when SSE2, AVX2 or NEON is available and a machine
+/// word at a time otherwise, so runs of characters that do not require escaping are copied in
+/// bulk. Invalid UTF-8 sequences are validated in the same pass, each byte of them is replaced with
+/// U+FFFD replacement character.
+auto escape(const string_view& value, writer_t& writer) -> void;
+
+/// Returns the number of leading bytes of the given string forming valid UTF-8, which equals to
+/// its size if the whole string is valid.
+auto validate(const string_view& value) noexcept -> std::size_t;
+
+/// Returns a copy of the given string with each byte of invalid UTF-8 sequences replaced with
+/// U+FFFD replacement character.
+auto sanitize(const string_view& value) -> std::string;
+
+}  // namespace json
+}  // namespace formatter
+}  // namespace detail
+}  // namespace v1
+}  // namespace blackhole
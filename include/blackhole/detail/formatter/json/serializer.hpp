@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "blackhole/extensions/writer.hpp"
+#include "blackhole/record.hpp"
+
+#include "blackhole/detail/formatter/layout.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace detail {
+namespace formatter {
+namespace json {
+
+/// Streaming JSON serializer, which writes records directly into the writer without building an
+/// intermediate document.
+///
+/// The output object layout is precomputed from the routing configuration at construction, so
+/// formatting a record involves neither JSON pointer resolution nor memory allocation in the
+/// common case.
+///
+/// Unlike the document-based formatter, members of each object are written first followed by its
+/// nested objects in the order of their routes, instead of the order of first insertion. Objects
+/// that receive no members are omitted.
+class serializer_t {
+public:
+    typedef std::function<void(const record_t::time_point& time, writer_t& wr)> timestamp_type;
+
+    struct properties_t {
+        /// Routing map from JSON pointers to attribute names.
+        std::map<std::string, std::vector<std::string>> routing;
+
+        /// JSON pointer for attributes that weren't mentioned in the routing map.
+        std::string rest;
+
+        std::unordered_map<std::string, std::string> mapping;
+
+        bool unique;
+
+        std::vector<std::string> severity;
+        timestamp_type timestamp;
+    };
+
+private:
+    /// Precomputed destination of a builtin field: the object index and the renamed key, escaped
+    /// and quoted, followed by a colon.
+    struct route_t {
+        std::uint32_t node;
+        std::string key;
+    };
+
+    enum builtin_t : std::uint32_t {
+        message,
+        thread,
+        process,
+        severity,
+        timestamp,
+        trace_id,
+        span_id,
+        builtins
+    };
+
+    /// Per-record state, defined in the translation unit.
+    class frame_t;
+
+    layout_t layout;
+    route_t fields[builtins];
+
+    bool unique;
+
+    /// Precomputed severity members, like `"severity":"ERROR"`.
+    std::vector<std::string> severities;
+    timestamp_type timestamp_;
+
+public:
+    /// \throw std::invalid_argument if any of routing JSON pointers is malformed.
+    explicit serializer_t(properties_t properties);
+
+    auto format(const record_t& record, writer_t& writer) const -> void;
+
+private:
+    auto write(const frame_t& frame, std::uint32_t id, writer_t& writer) const -> void;
+};
+
+}  // namespace json
+}  // namespace formatter
+}  // namespace detail
+}  // namespace v1
+}  // namespace blackhole
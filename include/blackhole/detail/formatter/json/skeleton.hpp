@@ -0,0 +1,124 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "blackhole/extensions/writer.hpp"
+#include "blackhole/record.hpp"
+
+#include "blackhole/detail/formatter/layout.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace detail {
+namespace formatter {
+namespace json {
+
+/// Output skeletons of the document-based JSON formatter precomputed at build time, which produce
+/// its output without building a document.
+///
+/// The document-based formatter inserts builtin fields in a fixed order followed by attributes, so
+/// braces, keys and nested objects holding builtin fields, as well as mapped severity members, are
+/// the same for all records of a severity. A skeleton is precomputed for each mapped severity, one
+/// more for unmapped ones, and each of them both with and without a trace context, leaving slots
+/// for the message, thread, process, severity and timestamp values and for attributes of each
+/// object. Formatting a record then writes the skeleton filling its slots.
+///
+/// Attributes are appended to objects after builtin fields exactly like the document-based
+/// formatter does, which is the case only if the objects they are routed to hold builtin fields.
+/// Records having attributes routed elsewhere, non-finite doubles or keys which are not valid UTF-8
+/// are declined, leaving them to the document.
+class skeleton_t {
+public:
+    typedef std::function<void(const record_t::time_point& time, writer_t& wr)> timestamp_type;
+
+    /// Writes a finite double exactly like the document serializer does.
+    typedef std::function<void(double value, writer_t& wr)> real_type;
+
+    struct properties_t {
+        /// Routing map from JSON pointers to attribute names.
+        std::map<std::string, std::vector<std::string>> routing;
+
+        /// JSON pointer for attributes that weren't mentioned in the routing map.
+        std::string rest;
+
+        std::unordered_map<std::string, std::string> mapping;
+
+        bool unique;
+
+        std::vector<std::string> severity;
+        timestamp_type timestamp;
+        real_type real;
+    };
+
+private:
+    /// Builtin fields in the order the document-based formatter inserts them.
+    enum builtin_t : std::uint32_t {
+        message,
+        thread,
+        process,
+        trace_id,
+        span_id,
+        severity,
+        timestamp,
+        builtins
+    };
+
+    /// Text written as is followed by a slot to fill.
+    struct op_t {
+        enum class slot_t : std::uint8_t {
+            field,
+            attributes,
+            none
+        };
+
+        std::string text;
+        slot_t slot;
+        /// The builtin field or the object index.
+        std::uint32_t id;
+    };
+
+    struct outline_t {
+        std::vector<op_t> ops;
+        /// Marks objects holding builtin fields, which attributes can be appended to.
+        std::vector<bool> created;
+    };
+
+    /// Per-record state, defined in the translation unit.
+    class frame_t;
+
+    layout_t layout;
+    bool unique;
+
+    /// Outlines of unmapped severities followed by ones of each mapped severity, without a trace
+    /// context and with it for each.
+    std::vector<outline_t> outlines;
+
+    timestamp_type timestamp_;
+    real_type real;
+
+public:
+    /// \throw std::invalid_argument if any of routing JSON pointers is malformed or has array
+    ///     index tokens or a nested object clashes with a builtin field, whose output the document
+    ///     can't be reproduced for.
+    explicit skeleton_t(properties_t properties);
+
+    /// Formats the given record, returning `false` without writing anything if it's declined.
+    auto format(const record_t& record, writer_t& writer) const -> bool;
+
+private:
+    auto outline(const std::vector<std::string>& sevmap, std::size_t id, bool traced) const ->
+        outline_t;
+
+    auto write(const frame_t& frame, const op_t& op, writer_t& writer) const -> void;
+};
+
+}  // namespace json
+}  // namespace formatter
+}  // namespace detail
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include <boost/variant/static_visitor.hpp>
+
+#include "blackhole/attribute.hpp"
+#include "blackhole/extensions/writer.hpp"
+
+#include "blackhole/detail/formatter/json/escape.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace detail {
+namespace formatter {
+namespace json {
+
+/// Writes the given string into the writer as an escaped JSON string surrounded with quotes.
+inline auto write_string(const string_view& value, writer_t& writer) -> void {
+    writer.inner << '"';
+    escape(value, writer);
+    writer.inner << '"';
+}
+
+/// Returns the given name as a JSON object key followed by a colon.
+inline auto key_of(const string_view& name) -> std::string {
+    writer_t writer;
+    write_string(name, writer);
+    writer.inner << ':';
+    return writer.result().to_string();
+}
+
+/// Writes attribute values as JSON, leaving doubles to the given callable accepting a double and
+/// the writer, since their representation differs between formatters.
+template<typename Real>
+class value_visitor_t : public boost::static_visitor<> {
+    typedef fmt::StringRef string_ref;
+
+    writer_t& writer;
+    const Real& real;
+
+public:
+    value_visitor_t(writer_t& writer, const Real& real) noexcept :
+        writer(writer),
+        real(real)
+    {}
+
+    auto operator()(std::nullptr_t) const -> void {
+        writer.inner << string_ref("null", 4);
+    }
+
+    auto operator()(bool value) const -> void {
+        if (value) {
+            writer.inner << string_ref("true", 4);
+        } else {
+            writer.inner << string_ref("false", 5);
+        }
+    }
+
+    auto operator()(std::int64_t value) const -> void {
+        const fmt::FormatInt formatted(value);
+        writer.inner << string_ref(formatted.data(), formatted.size());
+    }
+
+    auto operator()(std::uint64_t value) const -> void {
+        const fmt::FormatInt formatted(value);
+        writer.inner << string_ref(formatted.data(), formatted.size());
+    }
+
+    auto operator()(double value) const -> void {
+        real(value, writer);
+    }
+
+    auto operator()(const string_view& value) const -> void {
+        write_string(value, writer);
+    }
+
+    auto operator()(const attribute::view_t::function_type& value) const -> void {
+        writer_t wr;
+        value(wr);
+        write_string(wr.result(), writer);
+    }
+};
+
+}  // namespace json
+}  // namespace formatter
+}  // namespace detail
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "blackhole/extensions/writer.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace detail {
+namespace formatter {
+
+/// Object tree precomputed from attributes routing and renaming configuration, which is shared by
+/// streaming serializers of structured formatters.
+///
+/// Routes are JSON pointers, see https://tools.ietf.org/html/rfc6901. The root object is always at
+/// zero index and parents always precede their children.
+class layout_t {
+public:
+    struct node_t {
+        std::string name;
+        std::uint32_t parent;
+        std::vector<std::uint32_t> children;
+    };
+
+private:
+    std::vector<node_t> nodes_;
+
+    // Both routing and renaming maps are sorted by name, which allows to look them up by string
+    // views without temporary strings construction.
+    std::vector<std::pair<std::string, std::uint32_t>> routes;
+    std::vector<std::pair<std::string, std::string>> mapping;
+
+    std::uint32_t rest;
+
+public:
+    /// \throw std::invalid_argument if any of routing JSON pointers is malformed.
+    layout_t(const std::map<std::string, std::vector<std::string>>& routing,
+        const std::string& rest,
+        const std::unordered_map<std::string, std::string>& mapping);
+
+    auto nodes() const noexcept -> const std::vector<node_t>&;
+
+    /// Returns the index of the object the given attribute is routed to.
+    auto node_of(const string_view& name) const noexcept -> std::uint32_t;
+
+    /// Returns the name the given attribute is renamed to.
+    auto renamed(const string_view& name) const noexcept -> string_view;
+
+private:
+    /// Returns the index of the object at the given JSON pointer, creating it and its ancestors.
+    auto node(const std::string& pointer) -> std::uint32_t;
+};
+
+}  // namespace formatter
+}  // namespace detail
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+namespace blackhole {
+inline namespace v1 {
+
+class formatter_t;
+
+namespace detail {
+namespace formatter {
+namespace string {
+
+/// Returns a string formatter producing paths of the given pattern from records, or `nullptr` if
+/// the pattern has no placeholders, i.e. the path is fixed.
+///
+/// Lives with the string formatter, since its builder can only be destroyed where its internals
+/// are defined.
+auto path(const std::string& pattern) -> std::unique_ptr<formatter_t>;
+
+}  // namespace string
+}  // namespace formatter
+}  // namespace detail
+}  // namespace v1
+}  // namespace blackhole
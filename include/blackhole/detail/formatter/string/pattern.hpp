@@ -0,0 +1,577 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+#include "blackhole/formatter/string.hpp"
+#include "blackhole/extensions/format.hpp"
+#include "blackhole/extensions/writer.hpp"
+#include "blackhole/record.hpp"
+#include "blackhole/stdext/string_view.hpp"
+
+#include "blackhole/detail/formatter/string/program.hpp"
+#include "blackhole/detail/formatter/string/token.hpp"
+#include "blackhole/detail/process.hpp"
+#include "blackhole/detail/procname.hpp"
+#include "blackhole/detail/trace.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace detail {
+namespace formatter {
+namespace string {
+namespace pattern {
+
+/// Out-of-line parts of compile-time patterns, shared with the string formatter.
+auto emit(writer_t& writer, const spec_t& spec, const string_view& value) -> void;
+auto emit(writer_t& writer, const spec_t& spec, std::int64_t value) -> void;
+auto emit(writer_t& writer, const spec_t& spec, std::uint64_t value) -> void;
+auto thread_name(writer_t& writer, const spec_t& spec, const record_t& record) -> void;
+auto timestamp(writer_t& writer, const spec_t& spec, const ph::timestamp<user>& token,
+               const record_t& record) -> void;
+
+/// \throw std::logic_error if there is no attribute with the given name.
+auto required(writer_t& writer, const spec_t& spec, const interned_t& name, const record_t& record)
+    -> void;
+
+template<typename T>
+struct always_false : public std::false_type {};
+
+/// Pattern characters, null-terminated for passing to cppformat.
+template<char... C>
+struct chars {
+    static constexpr char value[sizeof...(C) + 1] = {C..., '\0'};
+};
+
+template<char... C>
+constexpr char chars<C...>::value[sizeof...(C) + 1];
+
+/// Takes the characters preceding the first null one, i.e. the pattern padded by the macro.
+template<typename Result, char... C>
+struct strip;
+
+template<char... R>
+struct strip<chars<R...>> {
+    typedef chars<R...> type;
+};
+
+template<char... R, char... C>
+struct strip<chars<R...>, '\0', C...> {
+    typedef chars<R...> type;
+};
+
+template<char... R, char H, char... C>
+struct strip<chars<R...>, H, C...> : public strip<chars<R..., H>, C...> {};
+
+template<std::size_t N, char... C>
+struct from_literal : public strip<chars<>, C...> {
+    static_assert(N <= sizeof...(C), "compile-time pattern is too long");
+};
+
+/// Returns the last character of the given specification, which selects the placeholder variant,
+/// or zero if there is none.
+template<typename Spec>
+struct kind {
+    static constexpr char value = 0;
+};
+
+template<char H>
+struct kind<chars<H>> {
+    static constexpr char value = H;
+};
+
+template<char H, char... S>
+struct kind<chars<H, S...>> : public kind<chars<S...>> {};
+
+/// Replaces the last character of the given specification with `s`.
+template<typename Result, typename Rest>
+struct localize;
+
+template<char... R>
+struct localize<chars<R...>, chars<>> {
+    typedef chars<R...> type;
+};
+
+template<char... R, char H>
+struct localize<chars<R...>, chars<H>> {
+    typedef chars<R..., 's'> type;
+};
+
+template<char... R, char H, char... S>
+struct localize<chars<R...>, chars<H, S...>> : public localize<chars<R..., H>, chars<S...>> {};
+
+/// Splits the timestamp specification into the leading braced datetime pattern and the rest.
+template<typename Pattern, typename Rest>
+struct extract;
+
+template<char... P>
+struct extract<chars<P...>, chars<>> {
+    typedef chars<P...> pattern;
+    typedef chars<> spec;
+};
+
+template<char... P, char... R>
+struct extract<chars<P...>, chars<'}', R...>> {
+    typedef chars<P...> pattern;
+    typedef chars<R...> spec;
+};
+
+template<char... P, char H, char... R>
+struct extract<chars<P...>, chars<H, R...>> : public extract<chars<P..., H>, chars<R...>> {};
+
+template<typename Spec>
+struct split {
+    typedef chars<> pattern;
+    typedef Spec spec;
+};
+
+template<char... S>
+struct split<chars<'{', S...>> : public extract<chars<>, chars<S...>> {};
+
+/// Format specification known at compile time, where void means the placeholder has none.
+template<typename Spec, typename Default = chars<'{', '}'>>
+struct spec_of : public Default {
+    static constexpr bool plain = true;
+
+    static auto parsed() -> const spec_t& {
+        static const spec_t spec = string::parse(Default::value);
+        return spec;
+    }
+};
+
+template<char... S, typename Default>
+struct spec_of<chars<S...>, Default> : public chars<'{', ':', S..., '}'> {
+    static constexpr bool plain = sizeof...(S) == 0;
+
+    static auto parsed() -> const spec_t& {
+        static const spec_t spec = string::parse(chars<'{', ':', S..., '}'>::value);
+        return spec;
+    }
+};
+
+template<typename Spec, typename Default>
+constexpr bool spec_of<Spec, Default>::plain;
+
+template<char... S, typename Default>
+constexpr bool spec_of<chars<S...>, Default>::plain;
+
+typedef blackhole::formatter::severity_map severity_map;
+
+template<typename T>
+auto integer(writer_t& writer, T value) -> void {
+    const fmt::FormatInt formatted(value);
+    writer.inner << fmt::StringRef(formatted.data(), formatted.size());
+}
+
+namespace token {
+
+template<char... C>
+struct literal {
+    static auto format(const record_t&, writer_t& writer, const severity_map&) -> void {
+        writer.inner << fmt::StringRef(chars<C...>::value, sizeof...(C));
+    }
+};
+
+template<typename Spec>
+struct message {
+    typedef spec_of<Spec> spec;
+
+    static auto format(const record_t& record, writer_t& writer, const severity_map&) -> void {
+        const auto& value = record.formatted();
+
+        if (spec::plain) {
+            writer.inner << fmt::StringRef(value.data(), value.size());
+        } else {
+            emit(writer, spec::parsed(), value);
+        }
+    }
+};
+
+template<typename Spec>
+struct severity_num {
+    typedef spec_of<Spec> spec;
+
+    static auto format(const record_t& record, writer_t& writer, const severity_map&) -> void {
+        const auto value = static_cast<std::int64_t>(static_cast<int>(record.severity()));
+
+        if (spec::plain) {
+            integer(writer, value);
+        } else {
+            emit(writer, spec::parsed(), value);
+        }
+    }
+};
+
+template<typename Spec>
+struct severity_user {
+    typedef spec_of<Spec> spec;
+
+    static auto format(const record_t& record, writer_t& writer, const severity_map& sevmap) ->
+        void
+    {
+        if (sevmap) {
+            static const std::string pattern(spec::value);
+            sevmap(record.severity(), pattern, writer);
+        } else if (spec::plain) {
+            integer(writer, static_cast<int>(record.severity()));
+        } else {
+            writer.write(spec::value, static_cast<int>(record.severity()));
+        }
+    }
+};
+
+template<typename Spec>
+struct timestamp_num {
+    typedef spec_of<Spec> spec;
+
+    static auto format(const record_t& record, writer_t& writer, const severity_map&) -> void {
+        const auto usec = static_cast<std::int64_t>(std::chrono::duration_cast<
+            std::chrono::microseconds
+        >(record.timestamp().time_since_epoch()).count());
+
+        if (spec::plain) {
+            integer(writer, usec);
+        } else {
+            emit(writer, spec::parsed(), usec);
+        }
+    }
+};
+
+template<typename Pattern, typename Spec, bool Gmtime>
+struct timestamp_user {
+    typedef spec_of<Spec> spec;
+
+    static auto format(const record_t& record, writer_t& writer, const severity_map&) -> void {
+        // Datetime generators are built once, the first time the placeholder is formatted.
+        static const ph::timestamp<user> token(Pattern::value, spec::value, Gmtime);
+        timestamp(writer, spec::parsed(), token, record);
+    }
+};
+
+template<typename Spec>
+struct process_id {
+    typedef spec_of<Spec> spec;
+
+    static auto format(const record_t& record, writer_t& writer, const severity_map&) -> void {
+        if (spec::plain) {
+            integer(writer, record.pid());
+        } else {
+            emit(writer, spec::parsed(), record.pid());
+        }
+    }
+};
+
+template<typename Spec>
+struct process_name {
+    static auto format(const record_t&, writer_t& writer, const severity_map&) -> void {
+        emit(writer, spec_of<Spec>::parsed(), detail::procname());
+    }
+};
+
+template<typename Spec, bool Fqdn>
+struct host {
+    static auto format(const record_t&, writer_t& writer, const severity_map&) -> void {
+        emit(writer, spec_of<Spec>::parsed(),
+            Fqdn ? detail::this_process::fqdn() : detail::this_process::host());
+    }
+};
+
+template<typename Spec>
+struct thread_id {
+    typedef spec_of<Spec> spec;
+
+    static auto format(const record_t& record, writer_t& writer, const severity_map&) -> void {
+        if (spec::plain) {
+            integer(writer, record.lwp());
+        } else {
+            emit(writer, spec::parsed(), record.lwp());
+        }
+    }
+};
+
+template<typename Spec>
+struct thread_hex {
+    typedef spec_of<Spec, chars<'{', ':', '#', 'x', '}'>> spec;
+
+    static auto format(const record_t& record, writer_t& writer, const severity_map&) -> void {
+#ifdef __linux__
+        writer.write(spec::value, record.tid());
+#elif __APPLE__
+        writer.write(spec::value, reinterpret_cast<unsigned long>(record.tid()));
+#endif
+    }
+};
+
+template<typename Spec>
+struct thread_name {
+    static auto format(const record_t& record, writer_t& writer, const severity_map&) -> void {
+        pattern::thread_name(writer, spec_of<Spec>::parsed(), record);
+    }
+};
+
+template<typename Spec>
+struct trace_id {
+    static auto format(const record_t& record, writer_t& writer, const severity_map&) -> void {
+        char buffer[32];
+        emit(writer, spec_of<Spec>::parsed(), detail::trace::trace_id(record.trace(), buffer));
+    }
+};
+
+template<typename Spec>
+struct span_id {
+    static auto format(const record_t& record, writer_t& writer, const severity_map&) -> void {
+        char buffer[16];
+        emit(writer, spec_of<Spec>::parsed(), detail::trace::span_id(record.trace(), buffer));
+    }
+};
+
+template<typename Name, typename Spec>
+struct generic {
+    static auto format(const record_t& record, writer_t& writer, const severity_map&) -> void {
+        static const interned_t name{Name::value,
+            interned_t::hash_of(Name::value, sizeof(Name::value) - 1),
+            blackhole::attribute::key_t(string_view(Name::value, sizeof(Name::value) - 1))};
+
+        required(writer, spec_of<Spec>::parsed(), name, record);
+    }
+};
+
+}  // namespace token
+
+/// Builds the placeholder token of the given name and specification, following the same rules
+/// as the runtime parser.
+template<typename Name, typename Spec>
+struct make {
+    typedef token::generic<Name, Spec> type;
+};
+
+template<typename Spec>
+struct make<chars<'m', 'e', 's', 's', 'a', 'g', 'e'>, Spec> {
+    typedef token::message<Spec> type;
+};
+
+template<typename Spec>
+struct make<chars<'s', 'e', 'v', 'e', 'r', 'i', 't', 'y'>, Spec> {
+    typedef typename std::conditional<kind<Spec>::value == 'd',
+        token::severity_num<Spec>,
+        token::severity_user<Spec>
+    >::type type;
+};
+
+template<typename Spec>
+struct make<chars<'t', 'i', 'm', 'e', 's', 't', 'a', 'm', 'p'>, Spec> {
+    typedef split<Spec> gmtime;
+    typedef split<typename localize<chars<>, Spec>::type> local;
+
+    typedef typename std::conditional<kind<Spec>::value == 'd',
+        token::timestamp_num<Spec>,
+        typename std::conditional<kind<Spec>::value == 'l',
+            token::timestamp_user<typename local::pattern, typename local::spec, false>,
+            token::timestamp_user<typename gmtime::pattern, typename gmtime::spec, true>
+        >::type
+    >::type type;
+};
+
+template<>
+struct make<chars<'t', 'i', 'm', 'e', 's', 't', 'a', 'm', 'p'>, void> {
+    typedef token::timestamp_user<chars<>, void, true> type;
+};
+
+template<typename Spec>
+struct make<chars<'p', 'r', 'o', 'c', 'e', 's', 's'>, Spec> {
+    typedef typename std::conditional<kind<Spec>::value == 's',
+        token::process_name<Spec>,
+        token::process_id<Spec>
+    >::type type;
+};
+
+template<typename Spec>
+struct make<chars<'h', 'o', 's', 't'>, Spec> {
+    typedef typename std::conditional<std::is_same<Spec, chars<'f', 'q', 'd', 'n'>>::value,
+        token::host<void, true>,
+        token::host<Spec, false>
+    >::type type;
+};
+
+template<typename Spec>
+struct make<chars<'t', 'h', 'r', 'e', 'a', 'd'>, Spec> {
+    typedef typename std::conditional<kind<Spec>::value == 'd',
+        token::thread_id<Spec>,
+        typename std::conditional<kind<Spec>::value == 's',
+            token::thread_name<Spec>,
+            token::thread_hex<Spec>
+        >::type
+    >::type type;
+};
+
+template<typename Spec>
+struct make<chars<'t', 'r', 'a', 'c', 'e', '_', 'i', 'd'>, Spec> {
+    typedef token::trace_id<Spec> type;
+};
+
+template<typename Spec>
+struct make<chars<'s', 'p', 'a', 'n', '_', 'i', 'd'>, Spec> {
+    typedef token::span_id<Spec> type;
+};
+
+template<typename Spec>
+struct make<chars<'.', '.', '.'>, Spec> {
+    static_assert(always_false<Spec>::value,
+        "leftover placeholder is not supported by compile-time patterns");
+
+    typedef token::literal<> type;
+};
+
+template<typename... T>
+struct tokens {
+    static auto format(const record_t& record, writer_t& writer, const severity_map& sevmap) ->
+        void
+    {
+        // Braced initializer lists are evaluated in order.
+        const int expand[] = {0, (T::format(record, writer, sevmap), 0)...};
+        (void)expand;
+    }
+};
+
+template<typename Tokens, typename Token>
+struct append;
+
+template<typename... T, typename U>
+struct append<tokens<T...>, U> {
+    typedef tokens<T..., U> type;
+};
+
+template<typename... T>
+struct append<tokens<T...>, token::literal<>> {
+    typedef tokens<T...> type;
+};
+
+/// Parses literal characters, accumulating them until a placeholder starts.
+template<typename Tokens, typename Literal, typename Rest>
+struct parse;
+
+/// Parses placeholder name characters.
+template<typename Tokens, typename Name, typename Rest>
+struct identify;
+
+/// Parses placeholder specification characters, counting open braces, including the one of the
+/// placeholder itself.
+template<typename Tokens, typename Name, typename Spec, std::size_t Open, typename Rest>
+struct specify;
+
+template<typename... T, char... L>
+struct parse<tokens<T...>, chars<L...>, chars<>> {
+    typedef typename append<tokens<T...>, token::literal<L...>>::type type;
+};
+
+template<typename... T, char... L, char... R>
+struct parse<tokens<T...>, chars<L...>, chars<'{', '{', R...>> :
+    public parse<tokens<T...>, chars<L..., '{'>, chars<R...>> {};
+
+template<typename... T, char... L, char... R>
+struct parse<tokens<T...>, chars<L...>, chars<'}', '}', R...>> :
+    public parse<tokens<T...>, chars<L..., '}'>, chars<R...>> {};
+
+template<typename... T, char... L, char... R>
+struct parse<tokens<T...>, chars<L...>, chars<'{', R...>> :
+    public identify<typename append<tokens<T...>, token::literal<L...>>::type, chars<>,
+        chars<R...>> {};
+
+template<typename... T, char... L, char... R>
+struct parse<tokens<T...>, chars<L...>, chars<'}', R...>> {
+    static_assert(always_false<chars<R...>>::value, "unpaired '}' in compile-time pattern");
+
+    typedef tokens<> type;
+};
+
+template<typename... T, char... L, char H, char... R>
+struct parse<tokens<T...>, chars<L...>, chars<H, R...>> :
+    public parse<tokens<T...>, chars<L..., H>, chars<R...>> {};
+
+constexpr auto is_name(char ch) noexcept -> bool {
+    return (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') || (ch >= '0' && ch <= '9') ||
+        ch == '_' || ch == '.';
+}
+
+template<bool Valid, typename Tokens, typename Name, typename Rest>
+struct accept : public identify<Tokens, Name, Rest> {};
+
+template<typename Tokens, typename Name, typename Rest>
+struct accept<false, Tokens, Name, Rest> {
+    static_assert(always_false<Name>::value, "invalid placeholder name in compile-time pattern");
+
+    typedef tokens<> type;
+};
+
+template<typename Tokens, char... N>
+struct identify<Tokens, chars<N...>, chars<>> {
+    static_assert(always_false<chars<N...>>::value, "unclosed placeholder in compile-time pattern");
+
+    typedef tokens<> type;
+};
+
+template<typename Tokens, char... N, char... R>
+struct identify<Tokens, chars<N...>, chars<'}', R...>> :
+    public parse<typename append<Tokens, typename make<chars<N...>, void>::type>::type, chars<>,
+        chars<R...>> {};
+
+template<typename Tokens, char... N, char... R>
+struct identify<Tokens, chars<N...>, chars<':', R...>> :
+    public specify<Tokens, chars<N...>, chars<>, 1, chars<R...>> {};
+
+template<typename Tokens, char... N, char H, char... R>
+struct identify<Tokens, chars<N...>, chars<H, R...>> :
+    public accept<is_name(H), Tokens, chars<N..., H>, chars<R...>> {};
+
+template<typename Tokens, typename Name, char... S, std::size_t Open>
+struct specify<Tokens, Name, chars<S...>, Open, chars<>> {
+    static_assert(always_false<Name>::value, "unclosed placeholder in compile-time pattern");
+
+    typedef tokens<> type;
+};
+
+template<typename Tokens, typename Name, char... S, std::size_t Open, char... R>
+struct specify<Tokens, Name, chars<S...>, Open, chars<'{', R...>> :
+    public specify<Tokens, Name, chars<S..., '{'>, Open + 1, chars<R...>> {};
+
+template<typename Tokens, typename Name, char... S, std::size_t Open, char... R>
+struct specify<Tokens, Name, chars<S...>, Open, chars<'}', R...>> :
+    public specify<Tokens, Name, chars<S..., '}'>, Open - 1, chars<R...>> {};
+
+template<typename Tokens, typename Name, char... S, char... R>
+struct specify<Tokens, Name, chars<S...>, 1, chars<'}', R...>> :
+    public parse<typename append<Tokens, typename make<Name, chars<S...>>::type>::type, chars<>,
+        chars<R...>> {};
+
+template<typename Tokens, typename Name, char... S, std::size_t Open, char H, char... R>
+struct specify<Tokens, Name, chars<S...>, Open, chars<H, R...>> :
+    public specify<Tokens, Name, chars<S..., H>, Open, chars<R...>> {};
+
+}  // namespace pattern
+}  // namespace string
+}  // namespace formatter
+}  // namespace detail
+}  // namespace v1
+}  // namespace blackhole
+
+#define BLACKHOLE_PATTERN_AT(s, i) ((i) < sizeof(s) ? (s)[(i) < sizeof(s) ? (i) : 0] : '\0')
+
+#define BLACKHOLE_PATTERN_AT4(s, i) \
+    BLACKHOLE_PATTERN_AT(s, i), BLACKHOLE_PATTERN_AT(s, i + 1), \
+    BLACKHOLE_PATTERN_AT(s, i + 2), BLACKHOLE_PATTERN_AT(s, i + 3)
+
+#define BLACKHOLE_PATTERN_AT16(s, i) \
+    BLACKHOLE_PATTERN_AT4(s, i), BLACKHOLE_PATTERN_AT4(s, i + 4), \
+    BLACKHOLE_PATTERN_AT4(s, i + 8), BLACKHOLE_PATTERN_AT4(s, i + 12)
+
+#define BLACKHOLE_PATTERN_AT64(s, i) \
+    BLACKHOLE_PATTERN_AT16(s, i), BLACKHOLE_PATTERN_AT16(s, i + 16), \
+    BLACKHOLE_PATTERN_AT16(s, i + 32), BLACKHOLE_PATTERN_AT16(s, i + 48)
+
+/// Expands into the type of the given string literal pattern, which is parsed at compile time by
+/// `formatter::pattern_t`. Patterns are limited to 128 characters.
+#define BLACKHOLE_PATTERN(s) \
+    ::blackhole::detail::formatter::string::pattern::from_literal<sizeof(s) - 1, \
+        BLACKHOLE_PATTERN_AT64(s, 0), BLACKHOLE_PATTERN_AT64(s, 64)>::type
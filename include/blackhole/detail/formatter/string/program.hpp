@@ -0,0 +1,143 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "blackhole/attribute/key.hpp"
+
+#include "blackhole/detail/formatter/string/token.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace detail {
+namespace formatter {
+namespace string {
+
+/// Format specification pre-parsed at pattern compilation time.
+///
+/// Only empty specifications and ones consisting of fill, alignment, width and type characters are
+/// pre-parsed, others are kept as is and passed to cppformat on each call.
+struct spec_t {
+    enum class kind_t : std::uint8_t {
+        /// Empty specification, like "{}" or "{:}".
+        plain,
+        /// Fill, alignment and width only, like "{:>10}" or "{:*^8s}".
+        align,
+        /// Everything else, i.e. precision, sign or alternate forms.
+        custom
+    };
+
+    kind_t kind;
+
+    /// Fill character, space by default.
+    char fill;
+
+    /// Either '<', '>', '^' or zero if the alignment is not specified.
+    char align;
+
+    /// Either 's', 'd' or zero if the type is not specified.
+    char type;
+
+    unsigned int width;
+
+    /// Original specification.
+    std::string pattern;
+};
+
+/// Parses the given format specification.
+auto parse(const std::string& spec) -> spec_t;
+
+/// Represents a single operation of a compiled pattern.
+enum class opcode_t : std::uint8_t {
+    literal,
+    message,
+    process_id,
+    process_name,
+    host_name,
+    host_fqdn,
+    thread_id,
+    thread_hex,
+    thread_name,
+    trace_id,
+    span_id,
+    severity_num,
+    severity_user,
+    timestamp_num,
+    timestamp_user,
+    required,
+    optional,
+    leftover
+};
+
+struct instruction_t {
+    opcode_t opcode;
+
+    /// Literal position in the arena. For optional placeholders it's the position of their prefix,
+    /// which is immediately followed by the suffix of `suffix` bytes. For user severities with
+    /// rendered names it's the position of their bounds and the number of names.
+    std::uint32_t offset;
+    std::uint32_t size;
+    std::uint32_t suffix;
+
+    /// Pre-parsed specification index.
+    std::uint32_t spec;
+
+    /// Either the index of the original token for placeholders carrying additional data, like
+    /// timestamp patterns, or the interned name index for generic placeholders.
+    std::uint32_t operand;
+};
+
+/// Attribute name interned at pattern compilation time.
+///
+/// Both the length and the hash are precomputed, which allows to reject mismatched attribute names
+/// without comparing their bytes. The name is also interned as an attribute key, so attributes
+/// with interned keys are matched by pointer.
+struct interned_t {
+    std::string name;
+    std::uint64_t hash;
+    attribute::key_t key;
+
+    /// FNV-1a hash.
+    static auto hash_of(const char* data, std::size_t size) noexcept -> std::uint64_t;
+};
+
+/// Pattern lowered into a flat instruction stream.
+///
+/// All literals are stored in a single contiguous arena with adjacent ones merged, format
+/// specifications are pre-parsed and generic placeholder names are interned.
+struct program_t {
+    std::string arena;
+    std::vector<instruction_t> code;
+    std::vector<spec_t> specs;
+    std::vector<interned_t> names;
+
+    /// Tokens referenced by instruction operands.
+    std::vector<token_t> tokens;
+
+    /// Arena positions of rendered severity names, with the end of the last name following them.
+    std::vector<std::uint32_t> bounds;
+
+    /// Process id rendered into literals, zero if there is no such one.
+    std::uint64_t pid = 0;
+};
+
+/// Compiles the given tokens into a program.
+///
+/// Placeholders constant during the process lifetime, i.e. the process name and the host name,
+/// are rendered once into literals merged with adjacent ones. So is the process id if `fold` is
+/// set, which makes the program valid only in the process with that id, but not in forked ones.
+/// Placeholders with specifications not applicable to their values are left to fail on each call.
+auto compile(std::vector<token_t> tokens, bool fold = true) -> program_t;
+
+/// Renders the given severity names with specifications of user severity placeholders into the
+/// arena, so that they are written without formatting.
+///
+/// Placeholders with specifications not applicable to strings are left to be formatted.
+auto render(program_t& program, const std::vector<std::string>& names) -> void;
+
+}  // namespace string
+}  // namespace formatter
+}  // namespace detail
+}  // namespace v1
+}  // namespace blackhole
@@ -18,6 +18,8 @@ struct hex;
 struct num;
 struct name;
 struct user;
+struct fqdn;
+struct span;
 struct value;
 struct required;
 struct optional;
@@ -99,6 +101,15 @@ struct process {
     process(std::string spec);
 };
 
+/// Host name, either the short one or the fully qualified domain name.
+template<typename T>
+struct host {
+    std::string spec;
+
+    host();
+    host(std::string spec);
+};
+
 template<typename T>
 struct thread {
     std::string spec;
@@ -115,6 +126,15 @@ struct thread<hex> {
     thread(std::string spec);
 };
 
+/// Trace context, either the trace id or the span id, rendered as fixed-width hex digits.
+template<typename T>
+struct trace {
+    std::string spec;
+
+    trace();
+    trace(std::string spec);
+};
+
 template<typename T>
 struct attribute {
     std::string spec;
@@ -152,9 +172,13 @@ typedef boost::variant<
     ph::leftover_t,
     ph::process<id>,
     ph::process<name>,
+    ph::host<name>,
+    ph::host<fqdn>,
     ph::thread<id>,
     ph::thread<hex>,
     ph::thread<name>,
+    ph::trace<id>,
+    ph::trace<span>,
     ph::message_t,
     ph::severity<num>,
     ph::severity<user>,
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace blackhole {
+inline namespace v1 {
+namespace detail {
+
+/// Mutex doing nothing, for builds where the library is used by a single thread only.
+///
+/// Trying to lock always fails, so that background threads skipping their rounds while the owner
+/// is busy, like flush timers, never touch the protected state.
+class null_mutex_t {
+public:
+    constexpr null_mutex_t() noexcept = default;
+
+    null_mutex_t(const null_mutex_t& other) = delete;
+    auto operator=(const null_mutex_t& other) -> null_mutex_t& = delete;
+
+    auto lock() noexcept -> void {}
+    auto unlock() noexcept -> void {}
+
+    auto try_lock() noexcept -> bool {
+        return false;
+    }
+};
+
+/// Mutex spinning for a bounded time before parking the waiting thread.
+///
+/// Critical sections of sinks are short, so a contended lock is usually released within a few
+/// hundred cycles, which is cheaper to spin through than to sleep. But unbounded spinning, like the
+/// one of spinlocks, burns the CPU quota of throttled containers while the holder is descheduled,
+/// so after about a microsecond of spinning with exponential backoff waiters park on a futex.
+///
+/// The lock word is the classic three-state one: unlocked, locked and locked with possible
+/// waiters, so unlocking an uncontended mutex costs a single atomic exchange without a syscall.
+/// Platforms without futexes yield instead of parking.
+class adaptive_mutex_t {
+    std::atomic<std::uint32_t> state;
+
+public:
+    constexpr adaptive_mutex_t() noexcept :
+        state(0)
+    {}
+
+    adaptive_mutex_t(const adaptive_mutex_t& other) = delete;
+    auto operator=(const adaptive_mutex_t& other) -> adaptive_mutex_t& = delete;
+
+    auto lock() noexcept -> void {
+        std::uint32_t expected = 0;
+        if (!state.compare_exchange_strong(expected, 1, std::memory_order_acquire,
+            std::memory_order_relaxed))
+        {
+            contend();
+        }
+    }
+
+    auto try_lock() noexcept -> bool {
+        std::uint32_t expected = 0;
+        return state.compare_exchange_strong(expected, 1, std::memory_order_acquire,
+            std::memory_order_relaxed);
+    }
+
+    auto unlock() noexcept -> void {
+        if (state.exchange(0, std::memory_order_release) == 2) {
+            wake();
+        }
+    }
+
+private:
+    /// Spins, then parks until the mutex is acquired.
+    auto contend() noexcept -> void;
+
+    /// Unparks a single waiter.
+    auto wake() noexcept -> void;
+};
+
+/// Mutex protecting sink state written by producer threads.
+///
+/// Builds configured with `ENABLE_SINGLE_THREADED` define `BLACKHOLE_SINGLE_THREADED`, which
+/// removes this synchronization for applications logging from a single thread. Asynchronous
+/// sinks and handlers still synchronize with their own consumer threads.
+#ifdef BLACKHOLE_SINGLE_THREADED
+typedef null_mutex_t mutex_t;
+#else
+typedef adaptive_mutex_t mutex_t;
+#endif
+
+}  // namespace detail
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+
+namespace blackhole {
+inline namespace v1 {
+namespace detail {
+
+/// Paging properties of large preallocated buffers.
+struct paging_t {
+    /// Backs the memory with huge pages, taking them from the reserved pool if there are enough of
+    /// them, otherwise advising transparent huge pages.
+    bool huge;
+    /// Prefaults all pages on allocation, so they are never faulted while logging.
+    bool populate;
+    /// Locks all pages in memory, so they are never swapped out.
+    bool lock;
+
+    paging_t() noexcept :
+        huge(false),
+        populate(false),
+        lock(false)
+    {}
+
+    /// Checks whether any property is set, i.e. whether the memory must be mapped explicitly.
+    auto enabled() const noexcept -> bool {
+        return huge || populate || lock;
+    }
+};
+
+/// Zero-initialized memory of a large buffer, allocated either on the heap or, when any paging
+/// property is set, by mapping anonymous pages.
+///
+/// Pages are bound by the memory policy of the allocating thread, i.e. NUMA node, on the first
+/// touch, which happens on allocation if prefaulted.
+class pages_t {
+    char* data_;
+    std::size_t size_;
+    bool mapped;
+
+public:
+    /// Allocates at least the given number of bytes aligned to the given alignment, which must not
+    /// be greater than the base page size.
+    ///
+    /// \throw std::bad_alloc if unable to allocate the memory on the heap.
+    /// \throw std::system_error if unable to either map or lock pages.
+    pages_t(std::size_t size, std::size_t alignment, const paging_t& paging);
+
+    pages_t(const pages_t& other) = delete;
+    auto operator=(const pages_t& other) -> pages_t& = delete;
+
+    ~pages_t();
+
+    auto data() const noexcept -> char*;
+    auto size() const noexcept -> std::size_t;
+};
+
+}  // namespace detail
+}  // namespace v1
+}  // namespace blackhole
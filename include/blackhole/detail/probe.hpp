@@ -0,0 +1,49 @@
+#pragma once
+
+/// USDT probes, which are single no-op instructions unless a tracer, like bpftrace, attaches to
+/// them, so they allow to attribute logging latency in production without rebuilding.
+///
+/// Probes are compiled in only if the library is built with `<sys/sdt.h>` available. Their
+/// arguments are evaluated even when no tracer is attached, so expensive ones, like queue depths,
+/// must be computed only if `BLACKHOLE_PROBE_ENABLED` tells so. Probes are listed in the provider
+/// "blackhole", e.g.:
+///     bpftrace -e 'usdt:libblackhole.so:blackhole:enqueue { @depth = hist(arg2); }'
+#if defined(BLACKHOLE_HAS_USDT)
+
+#define _SDT_HAS_SEMAPHORES 1
+#include <sys/sdt.h>
+
+/// All probes, each of which must have a semaphore defined in the library.
+#define BLACKHOLE_PROBES(X) \
+    X(consume)              \
+    X(filter)               \
+    X(handle_start)         \
+    X(handle_end)           \
+    X(format_start)         \
+    X(format_end)           \
+    X(emit_start)           \
+    X(emit_end)             \
+    X(enqueue)              \
+    X(dequeue)              \
+    X(overflow)             \
+    X(drop)                 \
+    X(flush_start)          \
+    X(flush_end)
+
+#define BLACKHOLE_PROBE_SEMAPHORE(name) blackhole_##name##_semaphore
+#define BLACKHOLE_PROBE_SEMAPHORE_DECLARE(name) extern unsigned short BLACKHOLE_PROBE_SEMAPHORE(name);
+
+extern "C" {
+BLACKHOLE_PROBES(BLACKHOLE_PROBE_SEMAPHORE_DECLARE)
+}
+
+#define BLACKHOLE_PROBE(...) STAP_PROBEV(blackhole, __VA_ARGS__)
+#define BLACKHOLE_PROBE_ENABLED(name) \
+    __builtin_expect(BLACKHOLE_PROBE_SEMAPHORE(name) != 0, 0)
+
+#else
+
+#define BLACKHOLE_PROBE(...) do {} while (false)
+#define BLACKHOLE_PROBE_ENABLED(name) false
+
+#endif
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <thread>
+
+#include "blackhole/stdext/string_view.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace detail {
+namespace this_process {
+
+/// Returns the current process id.
+///
+/// The value is obtained once and cached, being refreshed in a child process after fork.
+auto id() noexcept -> std::uint64_t;
+
+/// Returns the host name or an empty string view if it can't be obtained.
+///
+/// The value is obtained once on the first call.
+auto host() -> string_view;
+
+/// Returns the fully qualified domain name of the host, falling back to the host name if it can't
+/// be resolved.
+///
+/// The name is resolved once on the first call, which may block on DNS.
+auto fqdn() -> string_view;
+
+}  // namespace this_process
+
+namespace this_thread {
+
+/// Returns the native handle of the calling thread, i.e. `pthread_t`.
+///
+/// No caching is required here, because `pthread_self` just reads the thread pointer register.
+auto native_handle() noexcept -> std::thread::native_handle_type;
+
+/// Returns the kernel thread id of the calling thread, i.e. the one `gettid` returns on linux.
+///
+/// The value is obtained once per thread and cached in the thread-local storage.
+auto lwp() noexcept -> std::uint64_t;
+
+/// Returns the name of the thread with the given native handle or an empty string view if it can't
+/// be obtained.
+///
+/// Names are cached in the thread-local storage of the calling thread, until invalidated via
+/// `blackhole::thread::invalidate_names`. The returned view is valid until the next call from the
+/// same thread.
+auto name(std::thread::native_handle_type tid) -> string_view;
+
+/// Returns the given native handle formatted as a hexadecimal number with "0x" prefix.
+///
+/// The result of the last call is cached in the thread-local storage of the calling thread. The
+/// returned view is valid until the next call from the same thread.
+auto hex(std::thread::native_handle_type tid) noexcept -> string_view;
+
+/// Bumps the thread names cache generation, making all cached names stale.
+auto invalidate_names() noexcept -> void;
+
+}  // namespace this_thread
+}  // namespace detail
+}  // namespace v1
+}  // namespace blackhole
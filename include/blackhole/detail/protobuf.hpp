@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace blackhole {
+inline namespace v1 {
+namespace detail {
+namespace protobuf {
+
+/// Protocol Buffers wire types, see https://developers.google.com/protocol-buffers/docs/encoding.
+enum wire_t : std::uint32_t {
+    varint = 0,
+    fixed64 = 1,
+    delimited = 2,
+    fixed32 = 5
+};
+
+/// Maximum number of bytes a varint may occupy.
+constexpr std::size_t max_varint = 10;
+
+/// Returns the field key, which precedes values of the field.
+constexpr auto key(std::uint32_t field, wire_t wire) noexcept -> std::uint64_t {
+    return static_cast<std::uint64_t>(field) << 3 | wire;
+}
+
+/// Returns the number of bytes the given value occupies being encoded as a varint.
+inline auto varint_size(std::uint64_t value) noexcept -> std::size_t {
+    std::size_t size = 1;
+    while (value >= 0x80) {
+        value >>= 7;
+        ++size;
+    }
+
+    return size;
+}
+
+/// Returns the number of bytes a length-delimited field of the given content size occupies,
+/// including its key and length prefix.
+inline auto delimited_size(std::uint32_t field, std::size_t size) noexcept -> std::size_t {
+    return varint_size(key(field, delimited)) + varint_size(size) + size;
+}
+
+/// Encodes the given value as a varint into the buffer of at least `max_varint` bytes.
+///
+/// \returns the number of bytes written.
+inline auto encode(std::uint64_t value, char* buffer) noexcept -> std::size_t {
+    std::size_t size = 0;
+    while (value >= 0x80) {
+        buffer[size++] = static_cast<char>(value | 0x80);
+        value >>= 7;
+    }
+
+    buffer[size++] = static_cast<char>(value);
+    return size;
+}
+
+/// Encodes the given value in little-endian byte order into the buffer of 8 bytes.
+inline auto encode_fixed64(std::uint64_t value, char* buffer) noexcept -> void {
+    for (std::size_t id = 0; id < 8; ++id) {
+        buffer[id] = static_cast<char>(value >> (8 * id));
+    }
+}
+
+}  // namespace protobuf
+}  // namespace detail
+}  // namespace v1
+}  // namespace blackhole
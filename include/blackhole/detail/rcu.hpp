@@ -0,0 +1,88 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace blackhole {
+inline namespace v1 {
+namespace detail {
+namespace rcu {
+
+/// Represents a per-thread reader state.
+///
+/// Each thread that ever entered a read-side critical section owns exactly one instance of this
+/// class, which is registered in the global list of readers during the first use and unregistered
+/// on thread exit.
+struct reader_t {
+    /// Global epoch observed at the moment of entering the outermost critical section, zero if the
+    /// thread is not inside any critical section.
+    ///
+    /// Written only by the owner thread, read by writers during grace period detection.
+    std::atomic<std::uint64_t> epoch;
+
+    /// Critical sections nesting level. Accessed only by the owner thread.
+    std::uint32_t nesting;
+
+    reader_t* prev;
+    reader_t* next;
+
+    reader_t() noexcept;
+    ~reader_t();
+
+    reader_t(const reader_t& other) = delete;
+    auto operator=(const reader_t& other) -> reader_t& = delete;
+};
+
+/// Returns the calling thread's reader state, registering it on the first call.
+auto reader() noexcept -> reader_t&;
+
+/// Returns the current global epoch.
+auto epoch() noexcept -> const std::atomic<std::uint64_t>&;
+
+/// Scoped read-side critical section guard.
+///
+/// While an instance of this class lives on the stack all objects published through RCU-protected
+/// pointers and loaded after its construction are guaranteed to stay alive.
+///
+/// Entering and leaving a critical section involves no atomic read-modify-write operations and no
+/// shared cacheline writes: only a store to the thread-owned reader state and a full fence, which
+/// is required to order that store with further loads of the protected pointers.
+///
+/// Critical sections can be nested.
+class read_lock_t {
+    reader_t& state;
+
+public:
+    read_lock_t() noexcept :
+        state(reader())
+    {
+        if (state.nesting++ == 0) {
+            state.epoch.store(epoch().load(std::memory_order_acquire), std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+        }
+    }
+
+    ~read_lock_t() {
+        if (--state.nesting == 0) {
+            state.epoch.store(0, std::memory_order_release);
+        }
+    }
+
+    read_lock_t(const read_lock_t& other) = delete;
+    auto operator=(const read_lock_t& other) -> read_lock_t& = delete;
+};
+
+/// Blocks the calling thread until all read-side critical sections that were in progress at the
+/// time of the call complete.
+///
+/// After this call returns it is safe to reclaim any object that has been unpublished before the
+/// call.
+///
+/// \warning must not be called from inside a read-side critical section, because it will wait for
+///     itself forever.
+auto synchronize() noexcept -> void;
+
+}  // namespace rcu
+}  // namespace detail
+}  // namespace v1
+}  // namespace blackhole
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "blackhole/record.hpp"
+#include "blackhole/trace.hpp"
 
 namespace blackhole {
 inline namespace v1 {
@@ -13,9 +14,17 @@ struct record_t::inner_t {
     time_point timestamp;
 
     std::thread::native_handle_type tid;
-    char __pad[16];
+    std::uint64_t lwp;
+
+    /// Deduplicated attributes view shared by all handlers, optional.
+    const unique_attributes_t* unique;
+    /// Flattened attributes table shared by all handlers, optional.
+    const attribute::table_t* table;
 
     std::reference_wrapper<const attribute_pack> attributes;
+
+    /// Trace context captured from the creating thread, empty if there is none.
+    trace_t trace;
 };
 
 }  // namespace v1
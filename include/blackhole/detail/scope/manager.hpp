@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+
+#include "blackhole/scope/manager.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace scope {
+
+/// Scoped attributes manager keeping the current watcher of each thread in thread-local slots,
+/// which is used by loggers owning their scoped attributes stack.
+class thread_manager_t : public manager_t {
+    std::uint32_t id;
+    std::uint64_t generation;
+
+public:
+    thread_manager_t();
+    thread_manager_t(const thread_manager_t& other) = delete;
+
+    ~thread_manager_t();
+
+    auto operator=(const thread_manager_t& other) -> thread_manager_t& = delete;
+
+    auto get() const -> watcher_t* override;
+    auto reset(watcher_t* value) -> void override;
+};
+
+}  // namespace scope
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+/// Kernels have x86 implementations compiled with function target attributes, which allows to
+/// select them at runtime regardless of the instruction set the library is compiled for.
+#define BLACKHOLE_SIMD_X86 1
+#define BLACKHOLE_TARGET_SSE2 __attribute__((target("sse2")))
+#define BLACKHOLE_TARGET_AVX2 __attribute__((target("avx2")))
+#define BLACKHOLE_TARGET_AVX512 __attribute__((target("avx512f,avx512bw")))
+#define BLACKHOLE_SIMD_X86_VARIANT(fn) &fn
+#else
+#define BLACKHOLE_SIMD_X86_VARIANT(fn) nullptr
+#endif
+
+#if defined(__ARM_NEON) && defined(__aarch64__)
+/// NEON is mandatory on AArch64, so its implementations need no target attributes.
+#define BLACKHOLE_SIMD_NEON 1
+#define BLACKHOLE_SIMD_NEON_VARIANT(fn) &fn
+#else
+#define BLACKHOLE_SIMD_NEON_VARIANT(fn) nullptr
+#endif
+
+namespace blackhole {
+inline namespace v1 {
+namespace detail {
+namespace simd {
+
+/// Instruction sets kernels have implementations for, ordered by preference within each
+/// architecture.
+enum class isa_t : unsigned char {
+    scalar,
+    sse2,
+    avx2,
+    avx512,
+    neon
+};
+
+constexpr std::size_t isa_count = 5;
+
+/// Returns the lowercase name of the given instruction set, like "avx2".
+auto name(isa_t isa) noexcept -> const char*;
+
+/// Checks whether the running CPU and the operating system support the given instruction set.
+///
+/// The CPU is inspected once on the first call.
+auto supported(isa_t isa) noexcept -> bool;
+
+/// Returns the instruction set kernels are bound to at most, which is the best supported one
+/// unless selected otherwise.
+auto selected() noexcept -> isa_t;
+
+/// Rebinds all kernels to their best implementations not exceeding the given instruction set,
+/// which allows to force each of them for benchmarks and tests.
+///
+/// Kernels running concurrently complete with the implementation they have started with.
+///
+/// \returns false leaving kernels intact if the instruction set is not supported.
+auto select(isa_t isa) noexcept -> bool;
+
+/// Base of kernels, which allows to rebind all of them at once.
+class binding_t {
+    binding_t* next;
+    bool attached;
+
+public:
+    constexpr binding_t() noexcept :
+        next(nullptr),
+        attached(false)
+    {}
+
+    binding_t(const binding_t& other) = delete;
+    auto operator=(const binding_t& other) -> binding_t& = delete;
+
+protected:
+    ~binding_t() = default;
+
+    /// Binds the kernel to the selected implementation, registering it on the first call.
+    auto attach() noexcept -> void;
+
+private:
+    virtual auto bind(isa_t isa) noexcept -> void = 0;
+
+    friend auto select(isa_t isa) noexcept -> bool;
+};
+
+template<typename F>
+class kernel_t;
+
+/// Function with implementations for several instruction sets, which is bound to the best one
+/// supported by the running CPU.
+///
+/// Kernels are constant-initialized, so they are usable during static initialization, and bind
+/// themselves on the first call, which costs a single indirect call afterwards.
+template<typename R, typename... Args>
+class kernel_t<R(Args...)> : public binding_t {
+public:
+    typedef R(*function_type)(Args...);
+
+private:
+    function_type variants[isa_count];
+    std::atomic<function_type> bound;
+
+public:
+    /// Constructs a kernel from implementations, which are null for ones not compiled in.
+    ///
+    /// \param scalar portable implementation, which is required.
+    constexpr kernel_t(function_type scalar,
+                       function_type sse2,
+                       function_type avx2,
+                       function_type avx512,
+                       function_type neon) noexcept :
+        variants{scalar, sse2, avx2, avx512, neon},
+        bound(nullptr)
+    {}
+
+    auto operator()(Args... args) -> R {
+        auto fn = bound.load(std::memory_order_relaxed);
+
+        if (fn == nullptr) {
+            attach();
+            fn = bound.load(std::memory_order_relaxed);
+        }
+
+        return fn(args...);
+    }
+
+private:
+    auto bind(isa_t isa) noexcept -> void override {
+        // Instruction sets of other architectures are never supported, so walking down from the
+        // limit always ends at the best one of the running architecture.
+        for (auto id = static_cast<std::size_t>(isa); id > 0; --id) {
+            if (variants[id] != nullptr && supported(static_cast<isa_t>(id))) {
+                bound.store(variants[id], std::memory_order_relaxed);
+                return;
+            }
+        }
+
+        bound.store(variants[0], std::memory_order_relaxed);
+    }
+};
+
+}  // namespace simd
+}  // namespace detail
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,163 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "blackhole/sink.hpp"
+
+#include "blackhole/detail/mutex.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+namespace file {
+namespace flusher {
+
+class timer_t;
+
+}  // namespace flusher
+}  // namespace file
+
+namespace arrow {
+
+/// Attribute column value types.
+enum class type_t {
+    boolean,
+    sint64,
+    uint64,
+    float64,
+    string
+};
+
+/// Returns the value type with the given name, which is one of "bool", "int64", "uint64",
+/// "double" and "string".
+///
+/// \throw std::invalid_argument if the name is unknown.
+auto type(const std::string& name) -> type_t;
+
+/// Column filled with values of the attribute of the same name.
+///
+/// Numeric values are converted to numeric columns, while any value is formatted into string
+/// columns. Missing attributes and values of other types give nulls.
+struct column_t {
+    std::string name;
+    type_t type;
+
+    /// Whether string values are dictionary encoded, which pays off for repeated ones.
+    bool dictionary;
+};
+
+/// Accumulates records into columns, encoding them as Arrow IPC messages.
+///
+/// Well-known columns go first: "timestamp" in nanoseconds since the epoch in UTC, "severity",
+/// "message", "pid" and "lwp", followed by attribute ones. Dictionaries are built per batch and
+/// sent as replacements before each record batch.
+class batch_t {
+public:
+    /// Values of a single column.
+    class data_t;
+
+private:
+    std::vector<column_t> columns;
+    std::vector<std::unique_ptr<data_t>> data;
+    std::size_t rows_;
+
+public:
+    /// \throw std::invalid_argument if column names repeat.
+    explicit batch_t(std::vector<column_t> columns);
+    ~batch_t();
+
+    /// Returns the number of rows appended since the last encoding.
+    auto rows() const noexcept -> std::size_t;
+
+    /// Returns the approximate size of the encoded batch body in bytes.
+    auto bytes() const noexcept -> std::size_t;
+
+    /// Returns the encapsulated schema message, which starts the stream.
+    auto schema() const -> std::string;
+
+    /// Appends the given record with its formatted message as a row.
+    auto append(const record_t& record, const string_view& message) -> void;
+
+    /// Returns the encapsulated dictionary batches followed by the record batch of all rows
+    /// appended since the last encoding, clearing them.
+    auto encode() -> std::string;
+
+    /// Returns the end-of-stream marker.
+    static auto eos() -> std::string;
+};
+
+}  // namespace arrow
+
+class arrow_t : public sink_t {
+public:
+    struct options_t {
+        std::string path;
+        std::vector<arrow::column_t> columns;
+
+        /// Maximum number of rows in a single batch.
+        std::size_t rows;
+
+        /// Approximate maximum size of a single batch in bytes.
+        std::size_t bytes;
+
+        /// Maximum time records wait in an incomplete batch, zero means waiting for the batch to
+        /// complete or the sink to be flushed.
+        std::chrono::milliseconds interval;
+
+        options_t() :
+            rows(64 * 1024),
+            bytes(16 * 1024 * 1024),
+            interval(1000)
+        {}
+    };
+
+private:
+    const options_t options_;
+
+    arrow::batch_t batch;
+    int fd;
+
+    /// Time the oldest record of the batch was appended at per the timer clock.
+    std::uint64_t since;
+
+    std::shared_ptr<file::flusher::timer_t> timer;
+    std::uint64_t subscription;
+
+    mutable detail::mutex_t mutex;
+
+public:
+    /// Creates the file, replacing an existing one, and writes the stream schema.
+    ///
+    /// \throw std::invalid_argument if either of rows and bytes limits is zero or columns are
+    ///     malformed.
+    /// \throw std::system_error if unable to create the file.
+    explicit arrow_t(options_t options);
+    arrow_t(const arrow_t& other) = delete;
+
+    /// Writes the pending batch followed by the end-of-stream marker.
+    ~arrow_t();
+
+    auto operator=(const arrow_t& other) -> arrow_t& = delete;
+
+    auto options() const noexcept -> const options_t&;
+
+    /// Appends the record to the batch, writing the batch when it is complete.
+    ///
+    /// The formatted message fills the "message" column.
+    auto emit(const record_t& record, const string_view& formatted) -> void override;
+    auto emit_batch(const event_t* events, std::size_t size) -> void override;
+
+    /// Writes the pending batch.
+    auto flush(std::chrono::steady_clock::time_point deadline) -> bool override;
+
+private:
+    auto write() -> void;
+};
+
+}  // namespace sink
+}  // namespace v1
+}  // namespace blackhole
@@ -1,11 +1,27 @@
+#pragma once
+
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
 #include <thread>
+#include <utility>
+#include <vector>
 
-#include <cds/container/vyukov_mpmc_cycle_queue.h>
-
+#include "blackhole/metrics.hpp"
 #include "blackhole/sink.hpp"
 
+#include "blackhole/detail/crash.hpp"
 #include "blackhole/detail/recordbuf.hpp"
+#include "blackhole/detail/sink/elastic.hpp"
+#include "blackhole/detail/sink/ring.hpp"
+#include "blackhole/detail/sink/shared.hpp"
 
 namespace blackhole {
 inline namespace v1 {
@@ -13,7 +29,7 @@ namespace sink {
 
 using detail::recordbuf_t;
 
-/// I can imagine: drop, sleep, wait.
+/// Decides what producers do when the queue is full.
 class overflow_policy_t {
 public:
     enum class action_t {
@@ -21,6 +37,9 @@ public:
         drop
     };
 
+    /// Attempts to enqueue the record again, returning `true` on success.
+    typedef std::function<auto() -> bool> enqueue_type;
+
 public:
     virtual ~overflow_policy_t() {}
 
@@ -28,49 +47,677 @@ public:
     ///
     /// This method is called when the queue is unable to enqueue more items. It's okay to throw
     /// exceptions from here, they will be propagated directly to the sink caller.
-    virtual auto overflow() -> action_t = 0;
+    ///
+    /// The default implementation drops the record.
+    virtual auto overflow() -> action_t;
+
+    /// Resolves the queue overflow for the given record, returning `true` if it was eventually
+    /// enqueued using the given function and `false` if it must be dropped.
+    ///
+    /// Policies that need the record itself or waiting with a deadline should override this method.
+    /// The default implementation retries enqueueing while `overflow` says so.
+    virtual auto resolve(const record_t& record, const enqueue_type& enqueue) -> bool;
 
+    /// Notifies producers that the consumer has made some room in the queue.
+    ///
+    /// This method is called by the consumer after each dequeued batch.
     virtual auto wakeup() -> void = 0;
 };
 
 class overflow_policy_factory_t {
 public:
+    /// Creates either "drop" policy, which drops records on overflow, or "wait" one, which blocks
+    /// until there is room for them.
+    ///
+    /// \throw std::invalid_argument if there is no policy with the given name.
     auto create(const std::string& name) const -> std::unique_ptr<overflow_policy_t>;
+
+    /// Creates a policy blocking producers until there is room for records, but for no longer than
+    /// the given timeout, dropping them after.
+    auto timeout(std::chrono::milliseconds timeout) const -> std::unique_ptr<overflow_policy_t>;
+
+    /// Creates a policy dropping records with severity below the given threshold immediately,
+    /// blocking on others like the timeout policy does.
+    auto severity(std::int64_t threshold, std::chrono::milliseconds timeout) const ->
+        std::unique_ptr<overflow_policy_t>;
+};
+
+/// Decides what the consumer thread does when the queue becomes empty.
+class underflow_policy_t {
+public:
+    typedef std::function<auto() -> bool> predicate_type;
+
+public:
+    virtual ~underflow_policy_t() {}
+
+    /// Handles record queue underflow.
+    ///
+    /// This method is called from the consumer thread when there are no more items in the queue.
+    /// Implementations may block until either the given predicate returns `true` or the `wakeup`
+    /// method is called, but are allowed to return spuriously.
+    virtual auto underflow(const predicate_type& ready) -> void = 0;
+
+    /// Handles record queue underflow like `underflow` does, but returns by the given deadline at
+    /// most, which allows the consumer thread to release spare segments of idle elastic lanes.
+    ///
+    /// The default implementation ignores the deadline.
+    virtual auto underflow_until(const predicate_type& ready,
+                                 std::chrono::steady_clock::time_point deadline) -> void;
+
+    /// Notifies the consumer thread that new items were enqueued.
+    ///
+    /// This method is called by producers after each successful enqueue, so it should be cheap when
+    /// the consumer is not sleeping.
+    virtual auto wakeup() -> void = 0;
+};
+
+class underflow_policy_factory_t {
+public:
+    auto create(const std::string& name) const -> std::unique_ptr<underflow_policy_t>;
+};
+
+/// Decides what the consumer does with a batch the wrapped sink has failed to emit.
+class exception_policy_t {
+public:
+    virtual ~exception_policy_t() {}
+
+    /// Handles an exception thrown by the given sink while emitting the given batch.
+    ///
+    /// This method is called from the consumer thread inside the catch block, so the exception is
+    /// available via `std::current_exception`. Events are valid until the method returns only, so
+    /// implementations must copy them to process later. Exceptions thrown from here are ignored.
+    virtual auto handle(sink_t& sink, const sink_t::event_t* events, std::size_t size) -> void = 0;
+
+    /// Waits until batches handed over to the policy are processed, but no longer than until the
+    /// given deadline.
+    ///
+    /// The default implementation returns `true` immediately.
+    virtual auto flush(std::chrono::steady_clock::time_point deadline) -> bool;
+};
+
+class exception_policy_factory_t {
+public:
+    /// Creates "drop" policy, which drops failed batches, only counting them.
+    ///
+    /// \throw std::invalid_argument if there is no policy with the given name.
+    auto create(const std::string& name) const -> std::unique_ptr<exception_policy_t>;
+
+    /// Creates a policy retrying failed batches up to the given number of attempts, doubling the
+    /// backoff starting from the given one after each of them, and dropping them after.
+    ///
+    /// Retries are made from a separate thread, so the consumer moves on to other records
+    /// meanwhile, which means retried records are emitted out of order. Batches are dropped
+    /// immediately while there are more than `capacity` records waiting to be retried.
+    auto retry(std::size_t attempts, std::chrono::milliseconds backoff,
+               std::size_t capacity = 65536) const -> std::unique_ptr<exception_policy_t>;
+
+    /// Creates a policy emitting failed batches into the given fallback sink from the consumer
+    /// thread, dropping them if the fallback fails too.
+    auto fallback(std::unique_ptr<sink_t> sink) const -> std::unique_ptr<exception_policy_t>;
+};
+
+/// Allows a thread to wait for a condition expressed over some lock-free data structure without
+/// burdening the notifying side with a mutex or a syscall unless someone actually waits.
+///
+/// The waiter must call `prepare`, then recheck the condition and either `cancel` or `wait` with
+/// the key obtained.
+class eventcount_t {
+    std::atomic<std::uint64_t> epoch;
+    std::atomic<std::uint32_t> waiters;
+
+    std::mutex mutex;
+    std::condition_variable cv;
+
+public:
+    eventcount_t() noexcept :
+        epoch(0),
+        waiters(0)
+    {}
+
+    auto prepare() noexcept -> std::uint64_t {
+        waiters.fetch_add(1, std::memory_order_seq_cst);
+        return epoch.load(std::memory_order_seq_cst);
+    }
+
+    auto cancel() noexcept -> void {
+        waiters.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    auto wait(std::uint64_t key) -> void {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [&] {
+            return epoch.load(std::memory_order_relaxed) != key;
+        });
+
+        waiters.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    /// Waits like `wait` does, but until the given deadline at most, returning `false` on timeout.
+    template<typename Clock, typename Duration>
+    auto wait_until(std::uint64_t key, const std::chrono::time_point<Clock, Duration>& deadline) ->
+        bool
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        const auto notified = cv.wait_until(lock, deadline, [&] {
+            return epoch.load(std::memory_order_relaxed) != key;
+        });
+
+        waiters.fetch_sub(1, std::memory_order_relaxed);
+        return notified;
+    }
+
+    /// Wakes up all waiters if there are any. Costs a single fence and load otherwise.
+    auto notify() -> void {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        if (waiters.load(std::memory_order_relaxed) == 0) {
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            epoch.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        cv.notify_all();
+    }
 };
 
+class executor_t;
+
 class asynchronous_t : public sink_t {
-    struct value_type {
-        recordbuf_t record;
-        std::string message;
+public:
+    /// Represents the queue mode.
+    enum class mode_t {
+        /// Records are converted into owned objects stored in a fixed-size lock-free queue. Costs
+        /// several memory allocations per record.
+        queue,
+        /// Records are serialized into a preallocated byte ring with no memory allocations in a
+        /// steady state. Records larger than the ring are dropped.
+        ring
+    };
+
+    /// Represents how producer threads are distributed over lanes.
+    enum class sharding_t {
+        /// Each thread always enqueues into the same lane, which keeps per-thread ordering.
+        thread,
+        /// Each thread enqueues into the lane of the CPU it is currently running on, which reduces
+        /// contention further, but allows records of a migrating thread to be reordered.
+        cpu
+    };
+
+    /// Represents a priority lane, which is a separate queue for records with severity above some
+    /// threshold, so they neither compete for the room with less important records nor wait
+    /// behind them.
+    struct priority_t {
+        /// Minimum severity of records enqueued into the lane.
+        std::int64_t threshold;
+        /// Lane capacity factor, i.e. the lane holds up to 2^factor records.
+        std::size_t factor;
+        /// Policy of the lane overflow, the one of the sink is used if null.
+        std::unique_ptr<overflow_policy_t> overflow_policy;
+    };
+
+    /// Represents fair sharing of the queue between record sources, like tenants or components,
+    /// told apart by the value of some attribute, so a burst of one source can only exhaust its
+    /// own share.
+    ///
+    /// Each listed value gets its own lane of the sink capacity, while other values are spread by
+    /// their hashes over a number of bucket lanes. The consumer drains these lanes using deficit
+    /// round-robin: each round every non-empty lane is credited with its weight times the quantum
+    /// of message bytes and gives records until the credit is spent.
+    struct fairness_t {
+        struct share_t {
+            /// Attribute value, compared with the formatted value of non-string attributes.
+            std::string value;
+            std::size_t weight;
+        };
+
+        /// Name of the attribute keying records, fair sharing is disabled if empty.
+        std::string attribute;
+        std::vector<share_t> shares;
+        /// Number of lanes shared by values that are not listed, including missing attributes.
+        std::size_t buckets;
+        /// Weight of each bucket lane.
+        std::size_t weight;
+        /// Message bytes a lane is credited with per round for each unit of its weight.
+        std::size_t quantum;
+
+        fairness_t() :
+            buckets(1),
+            weight(1),
+            quantum(1024)
+        {}
+    };
+
+    /// Represents the maximum age of queued records, which allows the consumer to catch up quickly
+    /// after overload spikes instead of grinding through a stale backlog.
+    ///
+    /// Records older than the maximum age by the time they're dequeued are dropped instead of
+    /// being emitted, optionally collapsing each batch of them into a single summary record with
+    /// the highest severity among them.
+    struct expiry_t {
+        /// Maximum record age, zero disables expiration.
+        std::chrono::milliseconds max_age;
+        /// Whether to emit a summary record for each batch with expired records.
+        bool summary;
+
+        expiry_t() :
+            max_age(0),
+            summary(false)
+        {}
+    };
+
+    /// Represents the flush-through threshold, which makes rare high severity records, like ones
+    /// logged right before aborting, durable by the time logging returns.
+    ///
+    /// The logging thread enqueues such a record and waits until the consumer has emitted the batch
+    /// with it and flushed the wrapped sink, but no longer than the timeout. Records of its lane
+    /// queued before are emitted first, which covers all earlier records of the same thread unless
+    /// they go to other lanes, like priority ones. Flush-through records are serialized, so each
+    /// waits for its own flush only.
+    struct flush_through_t {
+        /// Minimum severity of flush-through records, disabled by default.
+        std::int64_t threshold;
+        /// Maximum time the logging thread waits.
+        std::chrono::milliseconds timeout;
+
+        flush_through_t() :
+            threshold(std::numeric_limits<std::int64_t>::max()),
+            timeout(1000)
+        {}
+
+        auto enabled() const noexcept -> bool {
+            return threshold != std::numeric_limits<std::int64_t>::max();
+        }
+    };
+
+    /// Represents elastic lanes, which start with their configured capacity and grow by chaining
+    /// segments of the same capacity under bursts, releasing them once idle, so that many mostly
+    /// idle sinks don't hold memory for the worst case.
+    ///
+    /// Lanes overflow only at their maximum capacity, so overflow policies apply to it. Producers
+    /// growing a lane allocate its segments, which are therefore not bound to the NUMA node of
+    /// the consumer. The consumer thread wakes up to release spare segments, while sinks drained
+    /// by an executor or pumped release them when drained next time. Elastic lanes are supported
+    /// in queue mode only.
+    struct elastic_t {
+        /// Maximum number of segments of each lane, in [1; 256] range, where one disables growth.
+        std::size_t segments;
+        /// Period a lane must not grow for before its spare segments are released.
+        std::chrono::milliseconds idle;
+
+        elastic_t() :
+            segments(1),
+            idle(1000)
+        {}
+    };
+
+    /// Represents the consumer thread properties, which allow to isolate logging work from latency
+    /// critical threads, for example on housekeeping cores.
+    ///
+    /// The thread applies them on start, the sink construction fails with `std::system_error` if
+    /// any of them can't be applied. Options other than the name are supported on linux only.
+    ///
+    /// Sinks drained by an executor only use the NUMA node, since they have no thread of their own.
+    struct consumer_t {
+        enum class policy_t {
+            /// Leaves the scheduling policy inherited.
+            other,
+            /// Treats the thread as CPU-intensive, i.e. `SCHED_BATCH`.
+            batch,
+            /// Runs the thread only when CPUs would be idle otherwise, i.e. `SCHED_IDLE`.
+            idle
+        };
+
+        /// Thread name, truncated to 15 characters on linux, left unchanged if empty.
+        std::string name;
+        /// CPUs the thread is pinned to, no pinning if empty.
+        std::vector<int> cpus;
+        policy_t policy;
+        /// Nice value, zero leaves the inherited one.
+        int nice;
+        /// NUMA node the queue memory is bound to, negative means no binding.
+        int node;
+
+        consumer_t() :
+            policy(policy_t::other),
+            nice(0),
+            node(-1)
+        {}
     };
 
-    typedef cds::container::VyukovMPSCCycleQueue<value_type> queue_type;
+private:
+    /// Records are shared with other asynchronous sinks they are emitted into by the same handler.
+    typedef shared_record_t value_type;
+
+    typedef elastic_queue_t<value_type> queue_type;
+
+    /// Either queue or ring lanes are used depending on the mode. Each lane is an independent
+    /// multiple producers single consumer structure, which the consumer thread drains in a
+    /// round-robin manner.
+    ///
+    /// Priority lanes come first in descending priority order, followed by sharded ones.
+    std::vector<std::unique_ptr<queue_type>> queues;
+    std::vector<std::unique_ptr<ring_t>> rings;
+
+    /// Minimum severities of priority lanes in descending order.
+    std::vector<std::int64_t> thresholds;
+    /// Overflow policies of priority lanes, which are null where the sink one is used.
+    std::vector<std::unique_ptr<overflow_policy_t>> policies;
+
+    sharding_t sharding;
+    bool ordered;
+
+    /// Values of fair shares in ascending order along with their lane indices.
+    std::string attribute;
+    std::vector<std::pair<std::string, std::size_t>> shares;
+    std::size_t buckets;
+
+    /// Maximum number of records taken from each lane per batch.
+    std::vector<std::size_t> limits;
+    /// Deficit round-robin quanta and deficits of lanes in message bytes, where zero quanta mean
+    /// that the lane is drained up to its limit regardless of message sizes.
+    std::vector<std::int64_t> quanta;
+    std::vector<std::int64_t> deficits;
 
-    queue_type queue;
     std::atomic<bool> stopped;
+    /// Whether the consumer thread should exit without draining the remaining records.
+    std::atomic<bool> abandoned;
     std::unique_ptr<sink_t> wrapped;
 
+    /// Declared after the wrapped sink, since the policy may use it until destroyed.
+    std::unique_ptr<exception_policy_t> exception_policy;
+
     std::unique_ptr<overflow_policy_t> overflow_policy;
+    std::unique_ptr<underflow_policy_t> underflow_policy;
+
+    std::size_t batch;
+
+    expiry_t expiry;
+    flush_through_t flush_through;
+    elastic_t elastic;
+
+    /// Serializes flush-through records, so the only one in flight is told apart by a count.
+    std::mutex barrier;
+    /// Sequence numbers of the last flush-through record enqueued and of the last one flushed by
+    /// the consumer.
+    std::uint64_t issued;
+    std::atomic<std::uint64_t> flushed;
+
+    /// Message of the summary record of expired records along with its empty attributes, which
+    /// stay valid until the next batch.
+    std::string summary;
+    string_view summary_view;
+    attribute_pack summary_pack;
+
+    /// Maximum number of records taken from a single lane per batch, unless it's a fair lane.
+    std::size_t quota;
+
+    /// Consumer-side buffers of the currently emitting batch.
+    std::vector<value_type> pending;
+    std::vector<std::size_t> runs;
+    std::unique_ptr<ring::decoded_t[]> decoded;
+    std::vector<record_t> records;
+    std::vector<string_view> messages;
+    std::vector<sink_t::event_t> events;
+
+    /// Records submitted for emitting, enqueued, dropped on overflow, as never fitting or after the
+    /// shutdown and emitted by the consumer, either successfully or not. Each submitted record is
+    /// eventually either dropped, expired or emitted, which flushing relies on.
+    metrics::counter_t submitted;
+    metrics::counter_t enqueued;
+    metrics::counter_t dropped;
+    metrics::counter_t emitted;
+    /// Records the wrapped sink has failed to emit, which are handed over to the exception policy.
+    metrics::counter_t failed;
+    /// Records dropped by the consumer as being older than the maximum age.
+    metrics::counter_t expired;
+    /// Time spent emitting batches into the wrapped sink.
+    metrics::histogram_t emitting;
+    /// CPU time in nanoseconds spent draining the sink while CPU time accounting is enabled.
+    metrics::counter_t consumed;
+
+    /// Notified on records completion, i.e. either emitting or dropping.
+    eventcount_t completed;
+
+    /// Shared executor draining the sink instead of the dedicated consumer thread, if any.
+    std::shared_ptr<executor_t> executor;
+    /// Whether the sink is either queued or being drained by the executor, or signalled to be
+    /// pumped.
+    std::atomic<bool> scheduled;
+
+    /// Eventfd signalled when records are enqueued into a pumped sink that isn't signalled yet,
+    /// -1 unless the sink is pumped.
+    int event;
+    /// Held while the sink is pumped, so it's never drained by more than one thread at a time.
+    std::mutex pumping;
 
     std::thread thread;
 
+    /// Source of ring records dumped on fatal signals, declared last to be unregistered first.
+    std::unique_ptr<detail::crash::registration_t> registration;
+
+public:
+    /// Default maximum number of records the consumer thread processes per wakeup.
+    static constexpr std::size_t default_batch = 256;
+
 public:
     asynchronous_t(std::unique_ptr<sink_t> wrapped, std::size_t factor = 10);
 
+    asynchronous_t(std::unique_ptr<sink_t> sink,
+                   std::size_t factor,
+                   std::unique_ptr<overflow_policy_t> overflow_policy);
+
     // TODO: Full customization.
     asynchronous_t(std::unique_ptr<sink_t> sink,
                    std::size_t factor,
                 //    std::unique_ptr<filter_t> filter,
-                //    std::unique_ptr<underflow_policy_t> underflow_policy,
-                //    std::unique_ptr<exception_policy_t> exception_policy,
-                   std::unique_ptr<overflow_policy_t> overflow_policy);
+                   std::unique_ptr<overflow_policy_t> overflow_policy,
+                   std::unique_ptr<underflow_policy_t> underflow_policy,
+                   std::size_t batch = default_batch,
+                   mode_t mode = mode_t::queue,
+                   std::size_t lanes = 1,
+                   sharding_t sharding = sharding_t::thread,
+                   bool ordered = false,
+                   std::vector<priority_t> priorities = std::vector<priority_t>(),
+                   consumer_t consumer = consumer_t(),
+                   std::shared_ptr<executor_t> executor = nullptr,
+                   std::unique_ptr<exception_policy_t> exception_policy = nullptr,
+                   detail::paging_t paging = detail::paging_t(),
+                   fairness_t fairness = fairness_t(),
+                   expiry_t expiry = expiry_t(),
+                   bool pumped = false,
+                   flush_through_t flush_through = flush_through_t(),
+                   elastic_t elastic = elastic_t());
 
     ~asynchronous_t();
 
     auto emit(const record_t& record, const string_view& message) -> void;
 
+    /// Copies slices right into the message room of the record captured for the queue, which is
+    /// possible in queue mode only, so that large messages are copied exactly once.
+    auto emit_gathered(const record_t& record, const string_view* slices, std::size_t count) ->
+        void override;
+
+    /// Lends the message room of the record captured for the queue in advance, so that the record
+    /// is formatted right into its queue item, which is possible in queue mode only.
+    ///
+    /// Sinks are not locked by lending, since each thread has its own room.
+    auto lend(const record_t& record, std::size_t size) -> region_t override;
+    auto commit(const record_t& record, std::size_t size) -> void override;
+    auto cancel() noexcept -> void override;
+
+    /// Waits until all records emitted before the call are passed to the wrapped sink and it has
+    /// flushed them, but no longer than until the given deadline.
+    ///
+    /// Waiting is driven by the consumer thread notifications, so it returns as soon as the last
+    /// record is emitted. Note that records keep being emitted concurrently, the call waits until
+    /// there are no records in flight at all.
+    ///
+    /// Failed records are waited for until the exception policy has processed them.
+    auto flush(std::chrono::steady_clock::time_point deadline) -> bool override;
+
+    /// Stops the consumer thread after flushing, abandoning records still queued once the deadline
+    /// passes, and returns whether all records were emitted.
+    ///
+    /// Records emitted after the shutdown are dropped. Without the shutdown the destructor drains
+    /// the queue completely, however long it takes.
+    ///
+    /// \note the consumer thread can't be interrupted while inside the wrapped sink, so it may
+    /// take longer if the wrapped sink blocks.
+    auto shutdown(std::chrono::steady_clock::time_point deadline) -> bool;
+
+    /// Returns the eventfd of a pumped sink, which becomes readable once records are enqueued and
+    /// stays so until the sink is pumped, or -1 if the sink has a consumer.
+    ///
+    /// Sinks constructed with the pumped flag have neither a consumer thread nor an executor, they
+    /// are drained by the event loop of the application instead, which polls the descriptor and
+    /// calls `pump` whenever it's readable. The descriptor is owned by the sink.
+    auto descriptor() const noexcept -> int;
+
+    /// Drains a pumped sink on the calling thread, emitting batches until at least `limit` records
+    /// are processed, the queue is empty or the deadline passes, and returns the number of records
+    /// processed.
+    ///
+    /// At least a single batch is drained per call, and the batch size rounds the limit up, so it
+    /// is usually set to no more than the limit. The descriptor is signalled again if records are
+    /// left, so no wakeup is lost. Calls made while another thread pumps the sink return 0 at once.
+    ///
+    /// Flushing and destroying a pumped sink drain it on the calling thread as well.
+    ///
+    /// \throw std::logic_error if the sink is not pumped.
+    auto pump(std::size_t limit, std::chrono::steady_clock::time_point deadline) -> std::size_t;
+
+    /// Collects queue metrics, where the queue depth is the number of records enqueued, but not
+    /// emitted yet, and the capacity is the one allocated for elastic lanes, followed by metrics
+    /// of the wrapped sink.
+    auto collect(metrics::collector_t& collector) const -> void override;
+
+    /// Returns the pressure of all lanes taken together, where rings are measured in average
+    /// records, merged with the pressure of the wrapped sink.
+    auto pressure() const -> pressure_t override;
+
 private:
+    /// Enqueues the record, accounting it as dropped if it can't be.
+    auto submit(const record_t& record, const string_view& message, const value_type* captured) ->
+        void;
+
+    /// Enqueues the flush-through record and waits until it's flushed or the timeout expires.
+    auto submit_through(const record_t& record, const string_view& message,
+                        const value_type* captured) -> void;
+
+    /// Enqueues the record resolving overflows, returns `false` if it must be dropped.
+    ///
+    /// \param captured the record with its message captured in advance if any.
+    auto push(const record_t& record, const string_view& message,
+              const value_type* captured = nullptr) -> bool;
+
     auto run() -> void;
+
+    /// Drains several batches on an executor thread, returning whether the sink must be queued
+    /// again, since there are records left.
+    auto step() -> bool;
+
+    /// Notifies the consumer that new records were enqueued, scheduling the sink on the executor
+    /// or signalling the descriptor unless it's already scheduled.
+    auto schedule() -> void;
+
+    /// Makes the descriptor of the pumped sink readable.
+    auto signal() noexcept -> void;
+
+    /// Notifies producers and flushing threads that a batch was emitted.
+    auto complete() -> void;
+
+    /// Dequeues and emits up to `quota` records from each lane, returning the number of records
+    /// processed.
+    auto drain() -> std::size_t;
+    auto drain_queues() -> void;
+    auto drain_rings() -> void;
+
+    /// Removes records older than the maximum age from the dequeued batch, keeping lane runs, and
+    /// appends their summary if requested, returning the number of records removed.
+    auto expire() -> std::size_t;
+
+    /// Returns the lane index the given record should be enqueued into by the calling thread.
+    auto lane(const record_t& record) const -> std::size_t;
+
+    /// Returns the index of the fair lane keyed by the attribute of the given record, counting
+    /// from the first non-priority lane.
+    auto share(const record_t& record) const -> std::size_t;
+
+    /// Credits the lane with its quantum before draining, returning whether it may give records.
+    auto credit(std::size_t lane, bool empty) -> bool;
+
+    /// Settles the lane deficit after draining, so empty lanes don't save their credit up and
+    /// others keep no more than a single quantum.
+    auto settle(std::size_t lane, bool empty) -> void;
+
+    auto enqueue(std::size_t lane, const record_t& record, const string_view& message,
+                 const string_view& encoded, const value_type* captured) -> bool;
+    auto empty() const -> bool;
+
+    /// Returns whether any lane holds spare segments it may release once idle.
+    auto spare() const -> bool;
+
+    /// Returns whether every submitted record is either emitted, expired or dropped.
+    auto idle() const -> bool;
+
+    /// Returns the number of records enqueued, but neither emitted nor expired yet.
+    auto depth() const -> std::uint64_t;
+
+    auto stop() -> void;
+
+    friend class executor_t;
+};
+
+/// Pool of threads draining many asynchronous sinks, which allows to avoid a dedicated consumer
+/// thread for each of them.
+///
+/// Sinks are scheduled on the executor when records are enqueued into them and are never drained
+/// by more than one thread at a time, so their ordering guarantees are the same. Idle sinks are not
+/// polled at all, and idle threads sleep until some sink is scheduled.
+///
+/// The executor must outlive sinks it drains, which is guaranteed by sinks sharing its ownership.
+class executor_t {
+    std::mutex mutex;
+    /// Notified when a sink is scheduled.
+    std::condition_variable ready;
+    /// Notified when a sink is drained.
+    std::condition_variable done;
+
+    /// Sinks scheduled, but not drained yet, and currently drained ones.
+    std::deque<asynchronous_t*> tasks;
+    std::vector<asynchronous_t*> running;
+
+    bool stopped;
+    std::vector<std::thread> threads;
+
+public:
+    /// Starts the given number of threads, each with the given properties.
+    ///
+    /// \throw std::invalid_argument if no threads are requested or properties are invalid.
+    /// \throw std::system_error if properties can't be applied.
+    explicit executor_t(std::size_t threads,
+                        asynchronous_t::consumer_t consumer = asynchronous_t::consumer_t());
+
+    executor_t(const executor_t& other) = delete;
+    auto operator=(const executor_t& other) -> executor_t& = delete;
+
+    ~executor_t();
+
+private:
+    auto run() -> void;
+
+    auto submit(asynchronous_t* sink) -> void;
+
+    /// Waits until the given sink is neither queued nor drained. Producers must not schedule it
+    /// anymore.
+    auto detach(asynchronous_t* sink) -> void;
+
+    auto stop() -> void;
+
+    friend class asynchronous_t;
 };
 
 }  // namespace sink
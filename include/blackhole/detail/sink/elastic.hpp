@@ -0,0 +1,269 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+
+#include <cds/container/vyukov_mpmc_cycle_queue.h>
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+
+/// Multiple producers single consumer queue of a capacity growing under bursts and shrinking when
+/// idle, built of a chain of fixed-size lock-free segments.
+///
+/// Producers enqueue into the tail segment and chain a new one once it's full, up to the maximum
+/// number of segments, so the queue is full only at its maximum capacity. The consumer dequeues
+/// from the head segment, moving on to the next one once it's drained. Segments left behind are
+/// kept for subsequent bursts and are released by `trim` once the queue hasn't grown for the idle
+/// period.
+///
+/// Each segment occupies one of the slots in a ring and is entered by producers pinning its slot,
+/// so the consumer leaves it only after in-flight enqueues complete, which keeps records of each
+/// producer in order. Queues of a single segment are plain lock-free queues, which pay nothing.
+template<typename T>
+class elastic_queue_t {
+    typedef cds::container::VyukovMPSCCycleQueue<T> queue_type;
+
+    struct slot_t {
+        /// Null for slots with released segments, only changed under the mutex for slots out of the
+        /// chain.
+        std::unique_ptr<queue_type> queue;
+        /// Number of threads that have pinned the slot.
+        std::atomic<std::uint32_t> pins;
+
+        slot_t() noexcept :
+            pins(0)
+        {}
+    };
+
+    std::size_t segment;
+    std::chrono::nanoseconds idle;
+
+    std::unique_ptr<slot_t[]> slots;
+    std::size_t count;
+
+    /// Sequence numbers of the head and the tail segments of the chain, where the head is advanced
+    /// by the consumer.
+    std::atomic<std::uint64_t> head;
+    std::atomic<std::uint64_t> tail;
+
+    /// Serializes growing and trimming.
+    std::mutex mutex;
+    std::atomic<std::size_t> allocated;
+    /// Time of the last growth in nanoseconds since the steady clock epoch.
+    std::atomic<std::int64_t> grown;
+
+public:
+    /// Constructs a queue of the given segment capacity, which grows up to the given number of
+    /// segments, releasing ones not needed after being idle for the given period.
+    ///
+    /// \throw std::invalid_argument if there are no segments or more than 256 of them.
+    elastic_queue_t(std::size_t capacity,
+                    std::size_t segments = 1,
+                    std::chrono::milliseconds idle = std::chrono::milliseconds(1000)) :
+        segment(capacity),
+        idle(idle),
+        slots(new slot_t[range(segments)]),
+        count(segments),
+        head(0),
+        tail(0),
+        allocated(1),
+        grown(0)
+    {
+        slots[0].queue.reset(new queue_type(capacity));
+    }
+
+    elastic_queue_t(const elastic_queue_t& other) = delete;
+    auto operator=(const elastic_queue_t& other) -> elastic_queue_t& = delete;
+
+    /// Returns the maximum capacity.
+    auto capacity() const noexcept -> std::size_t {
+        return segment * count;
+    }
+
+    /// Returns the capacity of segments allocated at the moment, including spare ones.
+    auto reserved() const noexcept -> std::size_t {
+        return segment * allocated.load(std::memory_order_relaxed);
+    }
+
+    /// Returns whether there are segments allocated besides the head one.
+    auto spare() const noexcept -> bool {
+        return allocated.load(std::memory_order_relaxed) > 1;
+    }
+
+    template<typename F>
+    auto enqueue_with(F fn) -> bool {
+        if (count == 1) {
+            return slots[0].queue->enqueue_with(fn);
+        }
+
+        while (true) {
+            const auto id = tail.load();
+            auto& slot = slots[id % count];
+
+            if (!pin(slot, id, tail)) {
+                continue;
+            }
+
+            const auto enqueued = slot.queue->enqueue_with(fn);
+            slot.pins.fetch_sub(1);
+
+            if (enqueued) {
+                return true;
+            }
+
+            if (!grow(id)) {
+                return false;
+            }
+        }
+    }
+
+    /// Dequeues from the head segment, moving on to the next one once it's drained. Consumer only.
+    ///
+    /// Returns `false` while the head segment is being entered, even if the next segment has
+    /// records, so that they are never reordered.
+    template<typename F>
+    auto dequeue_with(F fn) -> bool {
+        while (true) {
+            const auto id = head.load(std::memory_order_relaxed);
+            auto& slot = slots[id % count];
+
+            if (slot.queue->dequeue_with(fn)) {
+                return true;
+            }
+
+            if (tail.load() == id || slot.pins.load() != 0) {
+                return false;
+            }
+
+            // Producers can't pin the segment anymore, since the tail has moved on, so there are
+            // no records left in flight.
+            if (slot.queue->dequeue_with(fn)) {
+                return true;
+            }
+
+            head.store(id + 1);
+        }
+    }
+
+    auto empty() const -> bool {
+        if (count == 1) {
+            return slots[0].queue->empty();
+        }
+
+        const auto id = head.load();
+        if (tail.load() != id) {
+            return false;
+        }
+
+        auto& slot = slots[id % count];
+        if (!pin(slot, id, head)) {
+            return false;
+        }
+
+        const auto result = slot.queue->empty();
+        slot.pins.fetch_sub(1);
+        return result;
+    }
+
+    /// Releases spare segments once the queue is back to a single segment and hasn't grown for the
+    /// idle period. Consumer only, costs a single load unless there are spare segments.
+    auto trim() -> void {
+        if (!spare()) {
+            return;
+        }
+
+        const auto id = head.load(std::memory_order_relaxed);
+        if (tail.load() != id || now() - grown.load(std::memory_order_relaxed) < idle.count()) {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+
+        // The queue may have grown meanwhile, while it can't grow until unlocked.
+        if (tail.load() != id) {
+            return;
+        }
+
+        // Released slots are out of the chain, so threads pinning them only find out they're
+        // stale without touching the segment.
+        for (std::size_t pos = 0; pos < count; ++pos) {
+            auto& slot = slots[pos];
+
+            if (pos != id % count && slot.queue && slot.pins.load() == 0) {
+                slot.queue.reset();
+                allocated.fetch_sub(1, std::memory_order_relaxed);
+            }
+        }
+    }
+
+private:
+    static auto range(std::size_t segments) -> std::size_t {
+        if (segments == 0 || segments > 256) {
+            throw std::invalid_argument("number of queue segments should fit in [1; 256] range");
+        }
+
+        return segments;
+    }
+
+    static auto now() noexcept -> std::int64_t {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    /// Pins the slot of the given segment, returning `false` if the position has moved on since
+    /// then, which means that the slot may hold another segment by now.
+    static auto pin(slot_t& slot, std::uint64_t id, const std::atomic<std::uint64_t>& position) ->
+        bool
+    {
+        slot.pins.fetch_add(1);
+
+        if (position.load() != id) {
+            slot.pins.fetch_sub(1);
+            return false;
+        }
+
+        return true;
+    }
+
+    /// Chains a new segment after the full tail one, returning `false` if the queue is at its
+    /// maximum capacity or the segment can't be allocated.
+    auto grow(std::uint64_t id) -> bool {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        if (tail.load() != id) {
+            return true;
+        }
+
+        if (id + 1 - head.load() >= count) {
+            return false;
+        }
+
+        // Segments left behind by the consumer are drained, so they are reused as is.
+        auto& slot = slots[(id + 1) % count];
+        if (!slot.queue) {
+            try {
+                slot.queue.reset(new queue_type(segment));
+            } catch (const std::bad_alloc&) {
+                return false;
+            }
+
+            allocated.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        grown.store(now(), std::memory_order_relaxed);
+        tail.store(id + 1);
+
+        return true;
+    }
+};
+
+}  // namespace sink
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "blackhole/sink.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+namespace http {
+
+class client_t;
+
+}  // namespace http
+
+namespace elasticsearch {
+
+/// Extracts per-item statuses from the bulk API response body in the order of request items.
+///
+/// Only the structure required to locate item statuses is validated, the rest of the response is
+/// skipped without building any document.
+///
+/// \returns false if the body is not a well-formed bulk response.
+auto statuses(const string_view& body, std::vector<int>& result) -> bool;
+
+}  // namespace elasticsearch
+
+class elasticsearch_t : public sink_t {
+public:
+    struct options_t {
+        std::string host;
+        std::uint16_t port;
+
+        /// Index the documents are written into.
+        std::string index;
+
+        /// Maximum number of documents in a single bulk request.
+        std::size_t count;
+
+        /// Maximum size of a single bulk request body in bytes. A document exceeding it is sent
+        /// alone.
+        std::size_t bytes;
+
+        /// Time to wait for more documents before sending an incomplete bulk request.
+        std::chrono::milliseconds linger;
+
+        /// Number of keep-alive connections, which limits the number of requests in flight.
+        std::size_t connections;
+
+        /// Number of times a rejected document is sent again before it is counted as failed.
+        std::size_t retries;
+
+        /// Maximum size of documents waiting to be sent in bytes, newer documents are dropped
+        /// when exceeded.
+        std::size_t capacity;
+
+        options_t() :
+            host("localhost"),
+            port(9200),
+            index("logs"),
+            count(1000),
+            bytes(5 * 1024 * 1024),
+            linger(100),
+            connections(2),
+            retries(3),
+            capacity(64 * 1024 * 1024)
+        {}
+    };
+
+private:
+    const options_t options_;
+    std::unique_ptr<http::client_t> client;
+
+public:
+    /// Starts the I/O thread, which connects in background, so neither unresolvable nor
+    /// unreachable hosts are reported here.
+    ///
+    /// \throw std::invalid_argument if any of count, bytes, linger or connections limits is zero.
+    explicit elasticsearch_t(options_t options);
+    elasticsearch_t(const elasticsearch_t& other) = delete;
+
+    /// Waits up to 5 seconds for pending documents to be sent.
+    ~elasticsearch_t();
+
+    auto operator=(const elasticsearch_t& other) -> elasticsearch_t& = delete;
+
+    auto options() const noexcept -> const options_t&;
+
+    /// Returns the number of documents acknowledged by the cluster.
+    auto sent() const noexcept -> std::uint64_t;
+
+    /// Returns the number of documents rejected by the cluster either permanently or after all
+    /// retries.
+    auto failed() const noexcept -> std::uint64_t;
+
+    /// Returns the number of documents dropped because the pending buffer was full.
+    auto dropped() const noexcept -> std::uint64_t;
+
+    /// Enqueues the formatted document, never blocking on network I/O.
+    auto emit(const record_t& record, const string_view& formatted) -> void override;
+    auto emit_batch(const event_t* events, std::size_t size) -> void override;
+};
+
+}  // namespace sink
+}  // namespace v1
+}  // namespace blackhole
@@ -1,19 +1,34 @@
 #pragma once
 
+#include <cstdint>
 #include <fstream>
+#include <functional>
 #include <limits>
 #include <map>
+#include <memory>
 #include <mutex>
+#include <vector>
 
 #include <boost/assert.hpp>
+#include <boost/container/small_vector.hpp>
 
+#include "blackhole/extensions/writer.hpp"
+#include "blackhole/formatter.hpp"
 #include "blackhole/stdext/string_view.hpp"
 #include "blackhole/sink.hpp"
 #include "blackhole/sink/file.hpp"
 
 #include "blackhole/detail/memory.hpp"
+#include "blackhole/detail/mutex.hpp"
+#include "blackhole/detail/probe.hpp"
 
+#include "file/committer.hpp"
 #include "file/flusher.hpp"
+#include "file/flusher/timer.hpp"
+#include "file/index.hpp"
+#include "file/local.hpp"
+#include "file/lru.hpp"
+#include "file/rotation.hpp"
 #include "file/stream.hpp"
 
 namespace blackhole {
@@ -21,23 +36,336 @@ inline namespace v1 {
 namespace sink {
 namespace file {
 
+/// Tag for constructing durable file sinks.
+struct durable_t {};
+
 class backend_t {
     std::unique_ptr<std::ostream> stream;
     std::unique_ptr<flusher_t> flusher;
+    std::unique_ptr<rotator_t> rotator;
+
+    /// Optional time index, which is updated with each line written.
+    std::unique_ptr<index_t> index;
+
+    /// Raw descriptor buffer of the stream if any, allowing gathered writes.
+    fdbuf_t* fdbuf;
+
+    /// Number of bytes written since the last flush, reported by probes.
+    std::size_t unflushed;
+
+    bool expired_;
+
+    /// Marks the expired file being rotated by a writer, which does it without holding the lock.
+    bool rotating;
 
 public:
-    backend_t(std::unique_ptr<std::ostream> stream, std::unique_ptr<flusher_t> flusher) :
+    backend_t(std::unique_ptr<std::ostream> stream,
+              std::unique_ptr<flusher_t> flusher,
+              std::unique_ptr<rotator_t> rotator = nullptr,
+              std::unique_ptr<index_t> index = nullptr) :
         stream(std::move(stream)),
-        flusher(std::move(flusher))
+        flusher(std::move(flusher)),
+        rotator(std::move(rotator)),
+        index(std::move(index)),
+        fdbuf(dynamic_cast<fdbuf_t*>(this->stream->rdbuf())),
+        unflushed(0),
+        expired_(false),
+        rotating(false)
     {}
 
+    /// Checks whether the underlying file should be rotated according to the rotation policy.
+    auto expired() const noexcept -> bool {
+        return expired_;
+    }
+
+    /// Claims rotation of the expired file, returning `false` if it's not expired or if another
+    /// writer has already claimed it.
+    auto claim() noexcept -> bool {
+        if (!expired_ || rotating) {
+            return false;
+        }
+
+        rotating = true;
+        return true;
+    }
+
+    /// Gives up the claimed rotation after a failure, so the next write retries it.
+    auto release() noexcept -> void {
+        rotating = false;
+    }
+
+    /// Indexes the line written next with the given record timestamp if the time index is enabled.
+    auto mark(record_t::time_point timestamp) -> void {
+        if (index) {
+            index->update(timestamp);
+        }
+    }
+
     auto write(const string_view& message) -> void {
-        stream->write(message.data(), static_cast<std::streamsize>(message.size()));
-        stream->put('\n');
+        put(message);
+        account(message.size() + 1);
+
         if (flusher->update(message.size() + 1) == flusher_t::flush) {
-            stream->flush();
+            flush();
         }
     }
+
+    /// Writes the given events, updating the flush policy once for the whole batch.
+    ///
+    /// Messages interleaved with newlines are passed to file descriptor buffers as a single gather
+    /// list, which results in at most one `writev` per `IOV_MAX` slices.
+    auto write(const sink_t::event_t* events, std::size_t size) -> void {
+        std::size_t nwritten = 0;
+
+        if (fdbuf) {
+            static const char newline = '\n';
+
+            boost::container::small_vector<::iovec, 64> iov;
+            iov.reserve(2 * size);
+
+            for (std::size_t id = 0; id < size; ++id) {
+                const auto& message = *events[id].message;
+
+                iov.push_back({const_cast<char*>(message.data()), message.size()});
+                iov.push_back({const_cast<char*>(&newline), 1});
+                nwritten += message.size() + 1;
+
+                if (index) {
+                    index->update(events[id].record->timestamp());
+                    index->advance(message.size() + 1);
+                }
+            }
+
+            if (!fdbuf->gather(iov.data(), iov.size())) {
+                stream->setstate(std::ios_base::badbit);
+            }
+        } else {
+            for (std::size_t id = 0; id < size; ++id) {
+                put(*events[id].message);
+                nwritten += events[id].message->size() + 1;
+
+                if (index) {
+                    index->update(events[id].record->timestamp());
+                    index->advance(events[id].message->size() + 1);
+                }
+            }
+        }
+
+        unflushed += nwritten;
+        rotate(nwritten);
+
+        if (flusher->batch(size, nwritten) == flusher_t::flush) {
+            flush();
+        }
+    }
+
+    /// Writes the message split into the given slices followed by a newline, passing them to file
+    /// descriptor buffers as a single gather list, so large slices are written without copying.
+    auto write(const string_view* slices, std::size_t count) -> void {
+        std::size_t size = 0;
+
+        if (fdbuf) {
+            static const char newline = '\n';
+
+            boost::container::small_vector<::iovec, 16> iov;
+            iov.reserve(count + 1);
+
+            for (std::size_t id = 0; id < count; ++id) {
+                iov.push_back({const_cast<char*>(slices[id].data()), slices[id].size()});
+                size += slices[id].size();
+            }
+
+            iov.push_back({const_cast<char*>(&newline), 1});
+
+            if (!fdbuf->gather(iov.data(), iov.size())) {
+                stream->setstate(std::ios_base::badbit);
+            }
+        } else {
+            auto& buf = *stream->rdbuf();
+
+            for (std::size_t id = 0; id < count; ++id) {
+                const auto nsize = static_cast<std::streamsize>(slices[id].size());
+
+                if (buf.sputn(slices[id].data(), nsize) != nsize) {
+                    stream->setstate(std::ios_base::badbit);
+                }
+
+                size += slices[id].size();
+            }
+
+            if (std::char_traits<char>::eq_int_type(buf.sputc('\n'), std::char_traits<char>::eof()))
+            {
+                stream->setstate(std::ios_base::badbit);
+            }
+        }
+
+        account(size + 1);
+
+        if (flusher->update(size + 1) == flusher_t::flush) {
+            flush();
+        }
+    }
+
+    /// Lends the free space of the file descriptor buffer if there is at least the given size of
+    /// it, keeping a byte for the trailing newline, or an empty region otherwise.
+    auto lend(std::size_t size) -> sink_t::region_t {
+        ::iovec region{nullptr, 0};
+
+        if (fdbuf && !fdbuf->reserve(size + 1, region)) {
+            stream->setstate(std::ios_base::badbit);
+        }
+
+        if (region.iov_base == nullptr) {
+            return sink_t::region_t{nullptr, 0};
+        }
+
+        return sink_t::region_t{static_cast<char*>(region.iov_base), region.iov_len - 1};
+    }
+
+    /// Completes writing the message of the given size into the lent region.
+    auto commit(std::size_t size) -> void {
+        fdbuf->advance(size);
+        fdbuf->sputc('\n');
+        account(size + 1);
+
+        if (flusher->update(size + 1) == flusher_t::flush) {
+            flush();
+        }
+    }
+
+    /// Flushes the stream followed by pending time index entries, so they never refer to data not
+    /// reaching the file.
+    auto flush() -> void {
+        BLACKHOLE_PROBE(flush_start, unflushed);
+
+        stream->flush();
+
+        if (index) {
+            index->flush();
+        }
+
+        BLACKHOLE_PROBE(flush_end, unflushed);
+        unflushed = 0;
+    }
+
+    /// Flushes the stream if the flush policy tells so without any data written, which is the case
+    /// of time-based policies.
+    auto poll() -> void {
+        if (flusher->poll() == flusher_t::flush) {
+            flush();
+        }
+    }
+
+    /// Replaces the stream after rotation, restarting the rotation policy and the time index, so
+    /// archived files are left without one.
+    auto reopen(std::unique_ptr<std::ostream> stream) -> void {
+        this->stream = std::move(stream);
+        fdbuf = dynamic_cast<fdbuf_t*>(this->stream->rdbuf());
+        expired_ = false;
+        rotating = false;
+
+        if (rotator) {
+            rotator->reset();
+        }
+
+        if (index) {
+            index->reset();
+        }
+    }
+
+private:
+    /// Writes the message followed by a newline directly into the stream buffer, bypassing sentry
+    /// construction for each call.
+    auto put(const string_view& message) -> void {
+        auto& buf = *stream->rdbuf();
+        const auto size = static_cast<std::streamsize>(message.size());
+
+        if (buf.sputn(message.data(), size) != size ||
+            std::char_traits<char>::eq_int_type(buf.sputc('\n'), std::char_traits<char>::eof()))
+        {
+            stream->setstate(std::ios_base::badbit);
+        }
+    }
+
+    /// Updates both the time index and the rotation policy with the number of bytes written.
+    auto account(std::size_t nwritten) -> void {
+        unflushed += nwritten;
+
+        if (index) {
+            index->advance(nwritten);
+        }
+
+        rotate(nwritten);
+    }
+
+    /// Updates the rotation policy with the number of bytes written.
+    auto rotate(std::size_t nwritten) -> void {
+        if (rotator && rotator->update(nwritten)) {
+            expired_ = true;
+        }
+    }
+};
+
+/// Tag for constructing file sinks, in which each logging thread writes into files of its own.
+struct isolated_t {};
+
+/// Appends the name of the file the thread with the given id writes into instead of the given one,
+/// which has the id inserted before the extension, like `app.<tid>.log`, or appended to the name
+/// without one.
+///
+/// \returns a view of the appended name, which is valid until the writer is modified.
+auto isolate(const string_view& filename, std::uint64_t tid, writer_t& writer) -> string_view;
+
+/// Stream backends of a single logging thread keyed by their per-thread file names.
+///
+/// The lock is shared with the timer polling flush policies and with the sink destruction only, so
+/// it is almost always uncontended.
+struct slot_t {
+    std::mutex mutex;
+
+    /// Backends of open files, which is null once the slot is closed.
+    std::unique_ptr<lru_t<backend_t>> backends;
+
+    /// Backend with the region lent, which is kept locked until the region is given back.
+    backend_t* loan;
+
+    explicit slot_t(std::size_t files) :
+        backends(new lru_t<backend_t>(files)),
+        loan(nullptr)
+    {}
+};
+
+/// Set of per-thread slots, which share no state except for the registration performed on the
+/// first access of each thread.
+class slots_t {
+    /// Unique identifier, which is never reused unlike addresses.
+    const std::uint64_t id;
+
+    std::size_t files;
+
+    std::mutex mutex;
+    std::vector<std::shared_ptr<slot_t>> slots;
+
+public:
+    /// \param files the maximum number of simultaneously open files of each thread.
+    explicit slots_t(std::size_t files);
+    slots_t(const slots_t& other) = delete;
+
+    /// Closes all slots, flushing their files.
+    ~slots_t();
+
+    auto operator=(const slots_t& other) -> slots_t& = delete;
+
+    /// Returns the calling thread slot, registering it on first access.
+    auto local() -> slot_t&;
+
+    /// Calls the given function with backends of each slot not locked at the moment, closing slots
+    /// of exited threads.
+    auto poll(const std::function<void(lru_t<backend_t>& backends)>& fn) -> void;
+
+private:
+    /// Removes slots of exited threads from the registry, returning them.
+    auto prune() -> std::vector<std::shared_ptr<slot_t>>;
 };
 
 }  // namespace file
@@ -48,33 +376,153 @@ class file_t : public sink_t {
 
     struct {
         std::string path;
-        std::map<std::string, file::backend_t> backends;
     } data;
 
-    mutable std::mutex mutex;
+    /// Optional archiver, which must outlive all destinations.
+    std::unique_ptr<file::archiver_t> archiver;
+
+    /// Compiled path pattern, which is null for paths without placeholders.
+    std::unique_ptr<formatter_t> pattern;
+
+    /// Time index policy of stream backends.
+    file::indexing_t indexing;
+
+    file::lru_t<file::backend_t> backends;
+
+    /// Per-thread buffers, replacing streams when set.
+    std::unique_ptr<file::locals_t> locals;
+
+    /// Per-thread backends, replacing shared ones in isolated mode.
+    std::unique_ptr<file::slots_t> slots;
+
+    /// Group committers, replacing streams in durable mode.
+    std::unique_ptr<file::lru_t<std::shared_ptr<file::committer_t>>> committers;
+
+    /// Shared timer polling backends for time-based flush policies, which is null otherwise.
+    std::shared_ptr<file::flusher::timer_t> timer;
+    std::uint64_t subscription;
+
+    mutable detail::mutex_t mutex;
+
+    /// Backend with the region lent, which is kept locked until the region is given back.
+    file::backend_t* loan;
 
 public:
-    /// \param path a path with final destination file to open. All files are opened with append
-    ///     mode by default.
+    /// \param path a path pattern with final destination file to open, which can contain string
+    ///     formatter placeholders. All files are opened with append mode by default.
+    /// \param files the maximum number of simultaneously open files, the least recently used ones
+    ///     are closed when exceeded.
+    /// \param indexing time index policy, which makes each file maintain its sidecar index when
+    ///     enabled. Offsets are counted in bytes written, so streams must not transform data.
+    /// \throw std::invalid_argument if the path pattern is malformed.
+    file_t(const std::string& path,
+           std::unique_ptr<file::stream_factory_t> stream_factory,
+           std::unique_ptr<file::flusher_factory_t> flusher_factory,
+           std::size_t files = 1024,
+           const file::rotation_t& rotation = file::rotation_t(),
+           const file::indexing_t& indexing = file::indexing_t());
+
+    /// Constructs a file sink, in which each logging thread writes into files of its own.
+    ///
+    /// Destination names have the kernel thread id inserted before the extension, like
+    /// `app.<tid>.log`, and each thread keeps its own set of stream backends, so threads share
+    /// neither locks nor buffers. Files of exited threads are flushed and closed on the next thread
+    /// registration or timer poll.
     file_t(const std::string& path,
+           file::isolated_t,
            std::unique_ptr<file::stream_factory_t> stream_factory,
-           std::unique_ptr<file::flusher_factory_t> flusher_factory);
+           std::unique_ptr<file::flusher_factory_t> flusher_factory,
+           std::size_t files = 1024,
+           const file::rotation_t& rotation = file::rotation_t(),
+           const file::indexing_t& indexing = file::indexing_t());
+
+    /// Constructs a file sink, which writes through per-thread buffers instead of streams.
+    ///
+    /// Each logging thread collects records into its own buffer of the given capacity, which is
+    /// written out using a single system call to the file opened in append mode, so lines from
+    /// different threads never interleave. Flush policies created by the given factory are applied
+    /// per thread.
+    file_t(const std::string& path,
+           std::size_t capacity,
+           std::unique_ptr<file::flusher_factory_t> flusher_factory,
+           std::size_t files = 1024,
+           const file::rotation_t& rotation = file::rotation_t());
+
+    /// Constructs a file sink, which returns from emitting only after the data reaches the storage
+    /// device.
+    ///
+    /// Concurrent emits into the same file are committed in groups, each with a single write
+    /// followed by `fdatasync`.
+    file_t(const std::string& path,
+           file::durable_t,
+           std::size_t files = 1024,
+           const file::rotation_t& rotation = file::rotation_t());
+
+    ~file_t();
 
     /// Returns a const lvalue reference to destination path pattern.
     ///
     /// The path can contain attribute placeholders, meaning that the real destination name will be
-    /// deduced at runtime using provided log record. No real file will be opened at construction
-    /// time.
+    /// deduced at runtime using provided log record, like `/var/log/{tenant}/{severity}.log`. No
+    /// real file will be opened at construction time.
     auto path() const -> const std::string&;
 
+    /// Returns the destination file name for the given record.
+    ///
+    /// \throw std::logic_error if an attribute required by the path pattern is missing.
     auto filename(const record_t& record) const -> std::string;
 
-    auto backend(const std::string& filename) -> file::backend_t&;
+    /// Renders the destination file name for the given record, appending it to the writer if the
+    /// path contains placeholders.
+    ///
+    /// \returns a view of the file name, which is valid until either the writer or this sink is
+    ///     modified.
+    auto filename(const record_t& record, writer_t& writer) const -> string_view;
+
+    auto backend(const string_view& filename) -> file::backend_t&;
+
+    auto committer(const string_view& filename) -> std::shared_ptr<file::committer_t>;
+
+    /// Archives the file if the rotation policy tells so and reopens the backend.
+    auto rotate(const string_view& filename, file::backend_t& backend) -> void;
+
+    /// Archives the file if the rotation policy tells so and reopens the backend, releasing the
+    /// given lock of the sink while renaming the file and opening the new one.
+    ///
+    /// Concurrent writers keep appending to the renamed file meanwhile, then the lock is taken back
+    /// only to flush the backend and swap the new stream into it.
+    ///
+    /// \warning the backend must not be used after this call, since it can be evicted while the
+    ///     lock is released.
+    auto rotate(std::unique_lock<detail::mutex_t>& lock, const string_view& filename,
+        file::backend_t& backend) -> void;
 
     /// Outputs the formatted message with its associated record to the file.
     ///
     /// Depending on the filename pattern it is possible to write into multiple destinations.
     auto emit(const record_t& record, const string_view& formatted) -> void override;
+
+    /// Outputs the batch of messages, acquiring the lock once.
+    auto emit_batch(const event_t* events, std::size_t size) -> void override;
+
+    /// Outputs the message split into slices with a single gathered write, which is possible only
+    /// for streams over raw file descriptors. Per-thread buffers and durable mode concatenate
+    /// slices instead.
+    auto emit_gathered(const record_t& record, const string_view* slices, std::size_t count) ->
+        void override;
+
+    /// Lends the free space of the destination file buffer, which is possible only for streams
+    /// over raw file descriptors.
+    auto lend(const record_t& record, std::size_t size) -> region_t override;
+    auto commit(const record_t& record, std::size_t size) -> void override;
+    auto cancel() noexcept -> void override;
+
+private:
+    /// Opens the stream backend for the given file name.
+    auto open(const string_view& filename) -> file::backend_t;
+
+    /// Subscribes to the shared timer if flush policies are time-based.
+    auto subscribe() -> void;
 };
 
 }  // namespace sink
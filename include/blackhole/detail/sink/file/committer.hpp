@@ -0,0 +1,65 @@
+#pragma once
+
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "blackhole/stdext/string_view.hpp"
+#include "blackhole/sink.hpp"
+
+#include "local.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+namespace file {
+
+/// Durable writer, which returns only after written data reaches the storage device.
+///
+/// Concurrent writers append their lines to the currently collected group. One of them becomes the
+/// leader, which writes the whole group using a single system call followed by `fdatasync`, while
+/// the others are waiting to be released together. Writers arriving meanwhile collect the next
+/// group, so the throughput grows with the number of concurrent writers instead of being limited
+/// by the synchronization rate.
+class committer_t {
+    struct group_t {
+        std::vector<char> data;
+        bool done;
+        std::exception_ptr error;
+
+        group_t() : done(false) {}
+    };
+
+    descriptor_t descriptor;
+
+    std::shared_ptr<group_t> current;
+    bool active;
+
+    std::mutex mutex;
+    std::condition_variable cv;
+
+public:
+    /// \param archiver optional archiver, which enables rotation using its policy.
+    /// \throw std::system_error if unable to open the file.
+    explicit committer_t(const std::string& filename, archiver_t* archiver = nullptr);
+
+    /// Durably writes the given message followed by a newline.
+    ///
+    /// \throw std::system_error if the group this message belongs to has failed to be committed.
+    auto write(const string_view& message) -> void;
+
+    /// Durably writes the given events as lines, which are committed within a single group.
+    auto write(const sink_t::event_t* events, std::size_t size) -> void;
+
+private:
+    template<typename F>
+    auto commit(F&& append) -> void;
+};
+
+}  // namespace file
+}  // namespace sink
+}  // namespace v1
+}  // namespace blackhole
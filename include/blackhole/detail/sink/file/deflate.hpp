@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+#include "stream.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+namespace file {
+
+/// Stream buffer, which compresses data into a gzip stream written to the underlying stream.
+///
+/// Synchronization completes the current deflate block with `Z_SYNC_FLUSH`, so everything written
+/// before the flush can be decompressed by reading the file up to its current end, which allows to
+/// tail compressed files. Appending to an existing file starts a new gzip member, concatenated
+/// members form a valid gzip file.
+class deflatebuf_t : public std::streambuf {
+    struct state_t;
+
+    std::unique_ptr<std::ostream> inner;
+    std::unique_ptr<state_t> state;
+    std::vector<char> input;
+
+    /// Whether there is data compressed since the last synchronization.
+    bool dirty;
+
+public:
+    /// \param inner the stream receiving compressed data.
+    /// \param level compression level from 1 to 9.
+    /// \param capacity the size of the uncompressed data buffer.
+    /// \throw std::invalid_argument if the compression level is out of range.
+    deflatebuf_t(std::unique_ptr<std::ostream> inner, int level, std::size_t capacity = 64 * 1024);
+    deflatebuf_t(const deflatebuf_t& other) = delete;
+
+    /// Finishes the gzip member and flushes the underlying stream.
+    ~deflatebuf_t();
+
+    auto operator=(const deflatebuf_t& other) -> deflatebuf_t& = delete;
+
+protected:
+    auto overflow(int_type ch) -> int_type override;
+    auto xsputn(const char_type* data, std::streamsize size) -> std::streamsize override;
+    auto sync() -> int override;
+
+private:
+    /// Compresses pending data followed by the given extra data.
+    ///
+    /// \returns false on either compression or underlying stream failure.
+    auto commit(const char* data, std::size_t size, int flush) -> bool;
+    auto compress(const char* data, std::size_t size, int flush) -> bool;
+};
+
+/// Output stream owning a compressing stream buffer.
+class deflatestream_t : public std::ostream {
+    deflatebuf_t buf;
+
+public:
+    deflatestream_t(std::unique_ptr<std::ostream> inner, int level);
+};
+
+/// Produces compressing streams on top of the ones created by the given factory.
+class deflate_factory_t : public stream_factory_t {
+    std::unique_ptr<stream_factory_t> inner;
+    int level;
+
+public:
+    deflate_factory_t(std::unique_ptr<stream_factory_t> inner, int level);
+
+    virtual auto create(const std::string& filename, std::ios_base::openmode mode) const ->
+        std::unique_ptr<std::ostream> override;
+};
+
+}  // namespace file
+}  // namespace sink
+}  // namespace v1
+}  // namespace blackhole
@@ -28,12 +28,35 @@ public:
     ///
     /// \param nwritten bytes consumed during previous write operation.
     virtual auto update(std::size_t nwritten) -> result_t = 0;
+
+    /// Updates the flusher once for the whole batch of events written.
+    ///
+    /// The default implementation accounts the batch as a single write, which suits policies that
+    /// do not count events.
+    ///
+    /// \param nevents number of events in the batch.
+    /// \param nwritten total bytes consumed by the batch.
+    virtual auto batch(std::size_t nevents, std::size_t nwritten) -> result_t {
+        (void)nevents;
+        return update(nwritten);
+    }
+
+    /// Checks whether pending data should be flushed without writing anything, which is performed
+    /// periodically for time-based policies.
+    virtual auto poll() -> result_t {
+        return idle;
+    }
 };
 
 class flusher_factory_t {
 public:
     virtual ~flusher_factory_t() = default;
     virtual auto create() const -> std::unique_ptr<flusher_t> = 0;
+
+    /// Checks whether created flushers depend on time and should be polled periodically.
+    virtual auto timed() const noexcept -> bool {
+        return false;
+    }
 };
 
 }  // namespace file
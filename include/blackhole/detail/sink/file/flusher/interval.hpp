@@ -0,0 +1,159 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <string>
+
+#include "../flusher.hpp"
+#include "bytecount.hpp"
+#include "timer.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+namespace file {
+namespace flusher {
+
+/// Flushes the data written at least the given number of milliseconds ago.
+///
+/// Beside of checking elapsed time on each write, it also tells to flush pending data on polling,
+/// which is performed periodically by the timer thread, so lines are never stuck in buffers of idle
+/// files.
+class interval_t : public flusher_t {
+public:
+    typedef std::uint64_t threshold_type;
+    typedef std::function<std::uint64_t()> clock_type;
+
+private:
+    clock_type now;
+    threshold_type threshold_;
+
+    std::uint64_t last;
+    std::uint64_t counter;
+
+public:
+    /// \param threshold flush interval in milliseconds, zero means never.
+    /// \param now clock function returning the current time in milliseconds.
+    interval_t(threshold_type threshold, clock_type now) :
+        now(std::move(now)),
+        threshold_(threshold > 0 ? threshold : std::numeric_limits<threshold_type>::max()),
+        last(this->now()),
+        counter(0)
+    {}
+
+    auto threshold() const noexcept -> threshold_type {
+        return threshold_;
+    }
+
+    /// Returns the number of bytes written since the last flush.
+    auto count() const noexcept -> std::uint64_t {
+        return counter;
+    }
+
+    auto reset() -> void override {
+        counter = 0;
+        last = now();
+    }
+
+    auto update(std::size_t nwritten) -> flusher_t::result_t override {
+        counter += nwritten;
+        return expire();
+    }
+
+    auto poll() -> flusher_t::result_t override {
+        return expire();
+    }
+
+private:
+    auto expire() -> flusher_t::result_t {
+        if (counter == 0) {
+            return flusher_t::idle;
+        }
+
+        const auto current = now();
+        if (current - last < threshold_) {
+            return flusher_t::idle;
+        }
+
+        counter = 0;
+        last = current;
+        return flusher_t::flush;
+    }
+};
+
+/// Flushes after either the given number of bytes written or the given time elapsed, whichever
+/// comes first.
+class combined_t : public flusher_t {
+    bytecount_t bytes;
+    interval_t interval;
+
+public:
+    combined_t(bytecount_t bytes, interval_t interval) :
+        bytes(std::move(bytes)),
+        interval(std::move(interval))
+    {}
+
+    auto reset() -> void override {
+        bytes.reset();
+        interval.reset();
+    }
+
+    auto update(std::size_t nwritten) -> flusher_t::result_t override {
+        const auto by_bytes = bytes.update(nwritten);
+        const auto by_time = interval.update(nwritten);
+
+        if (by_bytes == flusher_t::flush || by_time == flusher_t::flush) {
+            reset();
+            return flusher_t::flush;
+        }
+
+        return flusher_t::idle;
+    }
+
+    auto poll() -> flusher_t::result_t override {
+        if (interval.poll() == flusher_t::flush) {
+            bytes.reset();
+            return flusher_t::flush;
+        }
+
+        return flusher_t::idle;
+    }
+};
+
+class interval_factory_t : public flusher_factory_t {
+    std::chrono::milliseconds value;
+    std::shared_ptr<timer_t> timer;
+
+public:
+    explicit interval_factory_t(std::chrono::milliseconds interval);
+
+    auto interval() const noexcept -> std::chrono::milliseconds;
+    auto create() const -> std::unique_ptr<flusher_t> override;
+    auto timed() const noexcept -> bool override;
+};
+
+class combined_factory_t : public flusher_factory_t {
+    bytecount_t::threshold_type bytes;
+    std::chrono::milliseconds interval;
+    std::shared_ptr<timer_t> timer;
+
+public:
+    combined_factory_t(bytecount_t::threshold_type bytes, std::chrono::milliseconds interval);
+
+    auto create() const -> std::unique_ptr<flusher_t> override;
+    auto timed() const noexcept -> bool override;
+};
+
+/// Parses time interval with units, like "100ms", "5s" or "1min", into milliseconds.
+///
+/// \throw std::invalid_argument if unit is unknown.
+auto parse_tunit(const std::string& encoded) -> std::chrono::milliseconds;
+
+}  // namespace flusher
+}  // namespace file
+}  // namespace sink
+}  // namespace v1
+}  // namespace blackhole
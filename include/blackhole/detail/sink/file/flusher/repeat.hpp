@@ -45,6 +45,21 @@ public:
 
         return flusher_t::idle;
     }
+
+    auto batch(std::size_t nevents, std::size_t nwritten) -> flusher_t::result_t override {
+        if (nwritten == 0 || nevents == 0) {
+            return flusher_t::idle;
+        }
+
+        const auto left = threshold() - counter;
+        if (nevents < left) {
+            counter += nevents;
+            return flusher_t::idle;
+        }
+
+        counter = (nevents - left) % threshold();
+        return flusher_t::flush;
+    }
 };
 
 class repeat_factory_t : public flusher_factory_t {
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+namespace file {
+namespace flusher {
+
+/// Low resolution timer thread shared between all time-based flushers.
+///
+/// Maintains a coarse monotonic clock, which is cheap to read, and periodically invokes subscribed
+/// callbacks on its own thread. The thread lives while there is at least one timer instance
+/// reference.
+class timer_t {
+public:
+    typedef std::function<void()> callback_type;
+
+    /// Clock and callback invocation resolution.
+    static constexpr std::chrono::milliseconds::rep resolution = 10;
+
+private:
+    const std::chrono::steady_clock::time_point birth;
+    std::atomic<std::uint64_t> now_;
+
+    /// Guards callbacks, being held while they are invoked to allow safe unsubscription.
+    std::mutex mutex;
+    std::map<std::uint64_t, callback_type> callbacks;
+    std::uint64_t counter;
+
+    bool stopped;
+    std::mutex stop_mutex;
+    std::condition_variable cv;
+    std::thread thread;
+
+public:
+    timer_t();
+    timer_t(const timer_t& other) = delete;
+
+    ~timer_t();
+
+    auto operator=(const timer_t& other) -> timer_t& = delete;
+
+    /// Returns the shared timer instance, starting it if required.
+    static auto instance() -> std::shared_ptr<timer_t>;
+
+    /// Returns the number of milliseconds elapsed since the timer start, updated every tick.
+    auto now() const noexcept -> std::uint64_t;
+
+    /// Subscribes the given callback to be invoked every tick, returning the subscription id.
+    ///
+    /// Callback errors are reported to the standard output.
+    auto subscribe(callback_type callback) -> std::uint64_t;
+
+    /// Unsubscribes the callback, waiting for its invocation to complete if it is in progress.
+    ///
+    /// \warning must not be called from a callback.
+    auto unsubscribe(std::uint64_t id) -> void;
+
+private:
+    auto run() -> void;
+};
+
+}  // namespace flusher
+}  // namespace file
+}  // namespace sink
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "blackhole/record.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+namespace file {
+
+/// Time index policy.
+struct indexing_t {
+    /// Index records at least this often in terms of their timestamps, zero means no time limit.
+    std::chrono::milliseconds interval;
+
+    /// Index records at least after this number of bytes written, zero means no size limit.
+    std::uint64_t size;
+
+    indexing_t() noexcept :
+        interval(0),
+        size(0)
+    {}
+
+    auto enabled() const noexcept -> bool {
+        return interval.count() != 0 || size != 0;
+    }
+};
+
+/// Sidecar index of a single file, mapping record timestamps to byte offsets of the lines they
+/// start at, which allows readers to seek directly to the lines of the given time window.
+///
+/// The index is stored next to the file with the ".idx" suffix appended. It begins with the
+/// `magic` header followed by entries of two little-endian 64-bit integers: the timestamp in
+/// nanoseconds since the epoch and the offset. An entry is added for the first record after
+/// either the interval elapsed since the previous entry timestamp or the size limit written,
+/// while entry timestamps never decrease even if record ones do.
+///
+/// Entries are buffered and appended when flushed, which is expected to happen right after the
+/// file itself is flushed, so they refer to the data already written. When the file is never
+/// flushed explicitly they are appended every `batch` entries instead, which may refer a little
+/// past the end of the file until its buffer is written. A truncated trailing entry left after a
+/// crash is dropped when the index is reopened.
+class index_t {
+public:
+    typedef record_t::time_point time_point;
+
+    struct entry_t {
+        std::int64_t timestamp;
+        std::uint64_t offset;
+    };
+
+    /// Index file header.
+    static constexpr const char* magic = "BHINDEX1";
+    static constexpr std::size_t header = 8;
+
+    /// Maximum number of pending entries.
+    static constexpr std::size_t batch = 64;
+
+private:
+    indexing_t policy;
+
+    int fd;
+    std::uint64_t offset;
+
+    bool marked;
+    entry_t last;
+    std::vector<entry_t> pending;
+
+public:
+    /// Opens or creates the index of the given file, which must already exist, continuing after
+    /// its current size.
+    ///
+    /// \throw std::system_error if unable to open the index.
+    index_t(const std::string& filename, const indexing_t& policy);
+
+    /// Appends pending entries, silently ignoring errors.
+    ~index_t();
+
+    index_t(const index_t& other) = delete;
+    auto operator=(const index_t& other) -> index_t& = delete;
+
+    /// Returns the index path of the given file.
+    static auto path(const std::string& filename) -> std::string;
+
+    /// Returns the current offset in the file, where the next line starts.
+    auto position() const noexcept -> std::uint64_t;
+
+    /// Indexes the line written next with the given record timestamp if the policy tells so.
+    auto update(time_point timestamp) -> void;
+
+    /// Accounts the given number of bytes written.
+    auto advance(std::size_t nwritten) noexcept -> void;
+
+    /// Appends pending entries to the index.
+    ///
+    /// \throw std::system_error on write errors.
+    auto flush() -> void;
+
+    /// Truncates the index after the file is replaced by an empty one, like after rotation.
+    ///
+    /// \throw std::system_error if unable to truncate the index.
+    auto reset() -> void;
+
+    /// Reads all complete entries from the index of the given file.
+    ///
+    /// \throw std::system_error if unable to open the index.
+    /// \throw std::runtime_error if the index header is malformed.
+    static auto read(const std::string& filename) -> std::vector<entry_t>;
+
+    /// Returns the offset to start reading at to find all lines with timestamps not less than the
+    /// given one, which is the offset of the last entry earlier than it or zero if there is none.
+    static auto begin(const std::vector<entry_t>& entries, time_point timestamp) -> std::uint64_t;
+
+    /// Returns the offset to stop reading at after all lines with timestamps not greater than the
+    /// given one, which is the offset of the first entry later than it or the maximum value if
+    /// there is none.
+    static auto end(const std::vector<entry_t>& entries, time_point timestamp) -> std::uint64_t;
+};
+
+}  // namespace file
+}  // namespace sink
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,157 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "blackhole/stdext/string_view.hpp"
+
+#include "blackhole/detail/crash.hpp"
+
+#include "flusher.hpp"
+#include "lru.hpp"
+#include "rotation.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+namespace file {
+
+/// File descriptor opened in append mode.
+///
+/// Each write operation is performed using a single system call whenever possible, relying on the
+/// `O_APPEND` semantics to keep data written by concurrent callers from interleaving.
+///
+/// Rotation replaces the underlying file by duplicating the new descriptor over the current one,
+/// which is atomic, so concurrent writers are never blocked or left with a closed descriptor.
+class descriptor_t {
+    int fd;
+    std::string filename;
+
+    archiver_t* archiver;
+    std::unique_ptr<rotator_t> rotator;
+
+public:
+    /// \param archiver optional archiver, which enables rotation using its policy.
+    /// \throw std::system_error if unable to open the file.
+    explicit descriptor_t(const std::string& filename, archiver_t* archiver = nullptr);
+    descriptor_t(const descriptor_t& other) = delete;
+
+    ~descriptor_t();
+
+    auto operator=(const descriptor_t& other) -> descriptor_t& = delete;
+
+    /// Writes both given chunks one after another, rotating the file afterwards if required.
+    ///
+    /// \throw std::system_error on write or rotation failure.
+    auto write(const string_view& head, const string_view& tail) -> void;
+
+    /// Waits until all written data reaches the storage device.
+    ///
+    /// \throw std::system_error on failure.
+    auto sync() -> void;
+
+private:
+    auto rotate() -> void;
+};
+
+class locals_t;
+
+/// Thread-local buffer collecting whole lines, which are committed to their destination at once.
+///
+/// The buffer is mostly accessed by its owning thread only, the lock is shared with the background
+/// flusher, so it is almost always uncontended.
+class local_t {
+    std::mutex mutex;
+
+    std::string filename;
+    std::shared_ptr<descriptor_t> descriptor;
+
+    std::vector<char> buffer;
+    std::size_t capacity;
+    std::unique_ptr<flusher_t> flusher;
+
+    bool closed;
+
+    /// Source of pending lines dumped on fatal signals, declared last to be unregistered first.
+    detail::crash::registration_t registration;
+
+public:
+    local_t(std::size_t capacity, std::unique_ptr<flusher_t> flusher);
+
+    /// Appends the given message followed by a newline.
+    ///
+    /// Messages that do not fit in the buffer are written directly, after committing the pending
+    /// data.
+    auto write(locals_t& locals, const string_view& filename, const string_view& message) -> void;
+
+    /// Writes out the pending data.
+    auto commit() -> void;
+
+    /// Commits the pending data and releases the buffer along with the destination.
+    auto close() -> void;
+
+    auto is_closed() -> bool;
+
+private:
+    auto commit_unlocked() -> void;
+};
+
+/// Set of thread-local buffers, which all write into shared append-only descriptors.
+///
+/// Logging threads do not contend with each other unless switching destination files. Pending data
+/// of each buffer is committed by its owning thread when the buffer fills up or the flush policy
+/// fires, and periodically by the background thread otherwise.
+class locals_t {
+    /// Unique identifier, which is never reused unlike addresses.
+    const std::uint64_t id;
+
+    std::size_t capacity;
+    std::unique_ptr<flusher_factory_t> flusher_factory;
+    archiver_t* archiver;
+
+    /// Descriptors of the recently used files, threads keep their current ones open regardless of
+    /// eviction.
+    lru_t<std::shared_ptr<descriptor_t>> descriptors;
+    std::vector<std::shared_ptr<local_t>> buffers;
+
+    bool stopped;
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::thread thread;
+
+public:
+    /// \param capacity size of each thread buffer.
+    /// \param files the maximum number of open descriptors not used by any thread buffer.
+    /// \param archiver optional archiver for rotating files, which must outlive this object.
+    locals_t(std::size_t capacity, std::unique_ptr<flusher_factory_t> flusher_factory,
+             std::size_t files = 1024, archiver_t* archiver = nullptr);
+    locals_t(const locals_t& other) = delete;
+
+    /// Stops the background thread and commits all buffers.
+    ~locals_t();
+
+    auto operator=(const locals_t& other) -> locals_t& = delete;
+
+    /// Returns the calling thread buffer, registering it on first access.
+    auto local() -> local_t&;
+
+    /// Returns the descriptor for the given file name, opening it on first access.
+    auto descriptor(const string_view& filename) -> std::shared_ptr<descriptor_t>;
+
+    /// Commits all buffers, dropping ones that belong to exited threads.
+    auto commit() -> void;
+
+private:
+    auto run() -> void;
+};
+
+}  // namespace file
+}  // namespace sink
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include "blackhole/stdext/string_view.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+namespace file {
+
+/// Bounded map from file names to associated values, which evicts the least recently used entry
+/// when full.
+///
+/// Entries are looked up by string views using hashing, requiring no temporary string construction
+/// unless a new entry is inserted.
+template<typename T>
+class lru_t {
+public:
+    typedef T value_type;
+
+private:
+    typedef std::pair<std::string, value_type> entry_type;
+    typedef std::list<entry_type> list_type;
+
+    std::size_t capacity_;
+
+    /// Entries ordered from the most recently used one. Index keys refer to names stored here,
+    /// which are stable because list nodes never move.
+    list_type entries;
+    std::unordered_map<string_view, typename list_type::iterator> index;
+
+public:
+    /// \param capacity the maximum number of entries, which is at least one.
+    explicit lru_t(std::size_t capacity) :
+        capacity_(std::max<std::size_t>(capacity, 1))
+    {}
+
+    lru_t(const lru_t& other) = delete;
+    auto operator=(const lru_t& other) -> lru_t& = delete;
+
+    auto capacity() const noexcept -> std::size_t {
+        return capacity_;
+    }
+
+    auto size() const noexcept -> std::size_t {
+        return entries.size();
+    }
+
+    /// Checks whether an entry with the given name exists without touching it.
+    auto contains(const string_view& name) const -> bool {
+        return index.find(name) != index.end();
+    }
+
+    /// Calls the given function for each entry's value without changing the usage order.
+    template<typename F>
+    auto each(F&& fn) -> void {
+        for (auto& entry : entries) {
+            fn(entry.second);
+        }
+    }
+
+    /// Returns the value associated with the given name, marking it as the most recently used.
+    ///
+    /// If there is no such entry, the value is created by calling the given factory with the name.
+    /// The factory is called before eviction, so failing to create a value leaves the map intact.
+    template<typename F>
+    auto get(const string_view& name, F&& factory) -> value_type& {
+        const auto it = index.find(name);
+
+        if (it != index.end()) {
+            entries.splice(entries.begin(), entries, it->second);
+            return it->second->second;
+        }
+
+        auto value = factory(name);
+
+        if (entries.size() == capacity_) {
+            index.erase(string_view(entries.back().first));
+            entries.pop_back();
+        }
+
+        entries.emplace_front(name.to_string(), std::move(value));
+        index.emplace(string_view(entries.front().first), entries.begin());
+
+        return entries.front().second;
+    }
+};
+
+}  // namespace file
+}  // namespace sink
+}  // namespace v1
+}  // namespace blackhole
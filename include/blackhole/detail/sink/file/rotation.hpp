@@ -0,0 +1,126 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+namespace file {
+
+/// File rotation policy.
+struct rotation_t {
+    /// Rotate files after at least this number of bytes written, zero means no size limit.
+    std::uint64_t size;
+
+    /// Rotate files at least this often, zero means no time limit.
+    std::chrono::seconds interval;
+
+    /// The number of rotated files to keep, zero means keeping all of them.
+    std::size_t backups;
+
+    /// Whether to compress rotated files with gzip.
+    bool compress;
+
+    rotation_t() noexcept :
+        size(0),
+        interval(0),
+        backups(0),
+        compress(false)
+    {}
+
+    auto enabled() const noexcept -> bool {
+        return size != 0 || interval.count() != 0;
+    }
+};
+
+/// Tracks a single file, telling when it should be rotated.
+///
+/// Safe to be updated concurrently, in which case it is guaranteed that exactly one of the callers
+/// is told to rotate until the rotator is reset.
+class rotator_t {
+    typedef std::chrono::steady_clock clock_type;
+
+    rotation_t policy;
+
+    std::atomic<std::uint64_t> written;
+    std::atomic<clock_type::rep> deadline;
+    std::atomic<bool> rotating;
+
+public:
+    explicit rotator_t(const rotation_t& policy);
+
+    /// Accounts the given number of bytes written.
+    ///
+    /// \returns true if the caller is responsible for rotation, which must be followed by reset.
+    auto update(std::size_t nwritten) -> bool;
+
+    /// Restarts both size and time counting.
+    auto reset() -> void;
+};
+
+/// Moves rotated files away, compressing them and pruning old ones on the background thread.
+class archiver_t {
+    rotation_t policy_;
+
+    struct job_t {
+        std::string filename;
+        std::string archive;
+        std::chrono::steady_clock::time_point time;
+    };
+
+    std::deque<job_t> jobs;
+
+    bool stopped;
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::thread thread;
+
+public:
+    explicit archiver_t(const rotation_t& policy);
+    archiver_t(const archiver_t& other) = delete;
+
+    /// Stops the background thread after processing all scheduled jobs.
+    ~archiver_t();
+
+    auto operator=(const archiver_t& other) -> archiver_t& = delete;
+
+    auto policy() const noexcept -> const rotation_t&;
+
+    /// Renames the given file to the timestamped archive name, scheduling its compression and
+    /// pruning of old archives.
+    ///
+    /// Callers are expected to reopen the file after this call, the rename itself is the only
+    /// blocking operation performed.
+    ///
+    /// \throw std::system_error if unable to rename the existing file.
+    auto archive(const std::string& filename) -> void;
+
+private:
+    auto run() -> void;
+    auto process(const job_t& job) -> void;
+};
+
+/// Returns the archive name for the given file rotated at the specified time, like
+/// `app.log.20160718-153000.000042`, which sorts chronologically.
+auto archive_name(const std::string& filename, std::chrono::system_clock::time_point time) ->
+    std::string;
+
+/// Compresses the given file with gzip into a file with ".gz" suffix, removing the original.
+///
+/// \throw std::system_error on failure.
+auto compress(const std::string& filename) -> void;
+
+/// Removes the oldest archives of the given file, keeping the specified number of them.
+auto prune(const std::string& filename, std::size_t backups) -> void;
+
+}  // namespace file
+}  // namespace sink
+}  // namespace v1
+}  // namespace blackhole
@@ -1,7 +1,16 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <iosfwd>
 #include <memory>
+#include <ostream>
+#include <streambuf>
+#include <string>
+
+#include <sys/uio.h>
+
+#include "blackhole/detail/pages.hpp"
 
 namespace blackhole {
 inline namespace v1 {
@@ -21,6 +30,224 @@ public:
         std::unique_ptr<std::ostream> override;
 };
 
+/// Stream buffer over a raw file descriptor with a page-aligned userspace buffer.
+///
+/// Data is passed to the kernel only when the buffer overflows or on explicit synchronization. Large
+/// writes that do not fit in the free space are gathered with the pending buffer into a single
+/// `writev` call without copying.
+///
+/// With a write-behind window set, writing back each window of written data is started as soon as
+/// it's complete, and pages of the previous window are dropped from the page cache, so the file
+/// keeps at most two windows of its pages cached instead of evicting hot pages of other files and
+/// accumulating dirty pages until the kernel flushes them in a single burst.
+///
+/// With a preallocation chunk set, file extents are allocated in chunks ahead of the write offset
+/// without changing the file size, so appends neither allocate blocks nor fragment the file one
+/// small write at a time. Extents left beyond the end are trimmed on closing.
+class fdbuf_t : public std::streambuf {
+    int fd;
+    char* buffer;
+    std::size_t capacity_;
+    /// Explicitly mapped buffer memory if any paging property is set.
+    std::unique_ptr<detail::pages_t> pages;
+
+    /// Write-behind window in bytes, zero if disabled.
+    std::size_t window;
+    /// File offset past the data written so far.
+    std::uint64_t offset;
+    /// File offset writing back is started up to.
+    std::uint64_t started;
+    /// File offset pages are dropped from the page cache up to.
+    std::uint64_t dropped_;
+
+    /// Preallocation chunk in bytes, zero if disabled.
+    std::size_t chunk;
+    /// File offset extents are preallocated up to.
+    std::uint64_t allocated_;
+
+public:
+    /// Opens the given file for writing, creating it if required.
+    ///
+    /// The file is opened in `O_APPEND` mode unless truncation is requested.
+    ///
+    /// \param capacity the buffer size, which is rounded up to the multiple of the page size.
+    /// \param paging paging properties of the buffer memory.
+    /// \param writeback write-behind window in bytes, zero disables write-behind.
+    /// \param preallocate preallocation chunk in bytes, zero disables preallocation.
+    /// \throw std::system_error if unable to either allocate the buffer or open the file.
+    fdbuf_t(const std::string& filename, std::ios_base::openmode mode, std::size_t capacity,
+            const detail::paging_t& paging = detail::paging_t(), std::size_t writeback = 0,
+            std::size_t preallocate = 0);
+    fdbuf_t(const fdbuf_t& other) = delete;
+
+    /// Flushes pending data, trims preallocated extents and closes the file descriptor.
+    ~fdbuf_t();
+
+    auto operator=(const fdbuf_t& other) -> fdbuf_t& = delete;
+
+    auto capacity() const noexcept -> std::size_t;
+
+    /// Returns the file offset pages written by this buffer before are dropped from the page cache
+    /// up to, which is the offset the file is opened at if write-behind is disabled.
+    auto dropped() const noexcept -> std::uint64_t;
+
+    /// Returns the file offset extents are preallocated up to, which is zero if preallocation is
+    /// either disabled or not supported by the file system.
+    auto allocated() const noexcept -> std::uint64_t;
+
+    /// Writes the given data slices as a whole.
+    ///
+    /// Slices are copied into the buffer if they fit in the free space, otherwise they are written
+    /// out together with pending data using as few `writev` calls as `IOV_MAX` allows.
+    ///
+    /// \returns false on system error.
+    auto gather(const ::iovec* iov, std::size_t count) -> bool;
+
+    /// Returns the free space of the buffer, writing pending data out first if there is less than
+    /// the given size of it.
+    ///
+    /// The region is left empty if the buffer is smaller than the given size.
+    ///
+    /// \returns false on system error.
+    auto reserve(std::size_t size, ::iovec& region) -> bool;
+
+    /// Marks the given number of bytes written into the reserved region as pending.
+    auto advance(std::size_t size) noexcept -> void;
+
+protected:
+    auto overflow(int_type ch) -> int_type override;
+    auto xsputn(const char_type* data, std::streamsize size) -> std::streamsize override;
+    auto sync() -> int override;
+
+private:
+    /// Writes out all pending data followed by the given extra data.
+    ///
+    /// \returns false on system error.
+    auto commit(const char* data, std::size_t size) -> bool;
+    auto commitv(const ::iovec* iov, std::size_t count) -> bool;
+
+    /// Starts writing back the data written since the last call, waiting for the previous window
+    /// to be written back and dropping its pages.
+    auto writeback() noexcept -> void;
+
+    /// Preallocates extents in chunks up to at least the given file offset, disabling preallocation
+    /// if the file system doesn't support it.
+    auto preallocate(std::uint64_t end) noexcept -> void;
+
+    /// Releases extents preallocated beyond the end of the file.
+    auto trim() noexcept -> void;
+};
+
+/// Output stream owning a file descriptor buffer.
+class fdstream_t : public std::ostream {
+    fdbuf_t buf;
+
+public:
+    fdstream_t(const std::string& filename, std::ios_base::openmode mode, std::size_t capacity,
+               const detail::paging_t& paging = detail::paging_t(), std::size_t writeback = 0,
+               std::size_t preallocate = 0);
+};
+
+/// Produces streams over raw file descriptors, bypassing `std::filebuf` and its locale conversion
+/// machinery.
+class fdstream_factory_t : public stream_factory_t {
+    std::size_t capacity;
+    detail::paging_t paging;
+    std::size_t writeback;
+    std::size_t preallocate;
+
+public:
+    /// \param capacity userspace buffer size for each stream created.
+    /// \param paging paging properties of the buffer memory of each stream created.
+    /// \param writeback write-behind window of each stream created, zero disables write-behind.
+    /// \param preallocate preallocation chunk of each stream created, zero disables it.
+    explicit fdstream_factory_t(std::size_t capacity,
+                                const detail::paging_t& paging = detail::paging_t(),
+                                std::size_t writeback = 0,
+                                std::size_t preallocate = 0) noexcept;
+
+    virtual auto create(const std::string& filename, std::ios_base::openmode mode) const ->
+        std::unique_ptr<std::ostream> override;
+};
+
+/// Stream buffer, which submits writes through io_uring without waiting for their completion.
+///
+/// Data is collected into one of a few rotating buffers registered with the ring. A full buffer is
+/// submitted as a fixed-buffer write and writing continues into the next one, so the caller blocks
+/// only when all buffers are in flight. Completions are reaped lazily on buffer switches, errors
+/// are reported by the next synchronization.
+///
+/// Each write is submitted at an explicit offset tracked by this buffer, so completions may come
+/// in any order without reordering data. This also means that appending is not atomic in respect
+/// to other writers of the same file.
+///
+/// When io_uring is unavailable, like on old kernels or when forbidden by seccomp, buffers are
+/// written with plain `pwrite` instead.
+class uringbuf_t : public std::streambuf {
+    struct state_t;
+
+    int fd;
+    std::unique_ptr<state_t> state;
+
+public:
+    /// Opens the given file for writing, creating it if required.
+    ///
+    /// \param capacity the size of each buffer, which is rounded up to the multiple of the page
+    ///     size.
+    /// \param buffers the number of rotating buffers.
+    /// \throw std::system_error if unable to open the file.
+    uringbuf_t(const std::string& filename,
+               std::ios_base::openmode mode,
+               std::size_t capacity,
+               std::size_t buffers = 4);
+    uringbuf_t(const uringbuf_t& other) = delete;
+
+    /// Submits pending data, waits for all writes in flight and closes the file descriptor.
+    ~uringbuf_t();
+
+    auto operator=(const uringbuf_t& other) -> uringbuf_t& = delete;
+
+    auto capacity() const noexcept -> std::size_t;
+
+    /// Checks whether writes are submitted through io_uring instead of the fallback.
+    auto uring() const noexcept -> bool;
+
+    /// Blocks until all submitted writes complete.
+    ///
+    /// \returns false if any of the writes failed since the last check.
+    auto drain() -> bool;
+
+protected:
+    auto overflow(int_type ch) -> int_type override;
+    auto xsputn(const char_type* data, std::streamsize size) -> std::streamsize override;
+    auto sync() -> int override;
+
+private:
+    /// Submits the current buffer if not empty and switches to the next free one.
+    auto rotate() -> void;
+};
+
+/// Output stream owning an io_uring stream buffer.
+class uringstream_t : public std::ostream {
+    uringbuf_t buf;
+
+public:
+    uringstream_t(const std::string& filename, std::ios_base::openmode mode, std::size_t capacity);
+};
+
+/// Produces streams writing files through io_uring, falling back to plain writes if it is not
+/// available.
+class uringstream_factory_t : public stream_factory_t {
+    std::size_t capacity;
+
+public:
+    /// \param capacity the size of each of rotating buffers for each stream created.
+    explicit uringstream_factory_t(std::size_t capacity) noexcept;
+
+    virtual auto create(const std::string& filename, std::ios_base::openmode mode) const ->
+        std::unique_ptr<std::ostream> override;
+};
+
 }  // namespace file
 }  // namespace sink
 }  // namespace v1
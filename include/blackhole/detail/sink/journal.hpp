@@ -0,0 +1,49 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "blackhole/sink.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+
+/// Sends records directly to systemd-journald using its native protocol, keeping attributes as
+/// separate journal fields.
+///
+/// Each record is sent as a single datagram, which consists of "MESSAGE", "PRIORITY" and
+/// "SYSLOG_IDENTIFIER" fields followed by the record attributes. Attribute names are converted to
+/// valid field names by uppercasing them and replacing invalid characters with underscores, those
+/// that become empty are skipped.
+///
+/// Records exceeding the maximum datagram size are written into a sealed memory file, whose
+/// descriptor is passed to the journal instead.
+class journal_t : public sink_t {
+    std::string path_;
+    std::string identifier;
+    std::vector<int> priorities_;
+
+    int fd;
+
+public:
+    /// \throw std::system_error if unable to connect to the journal socket.
+    explicit journal_t(std::string path = "/run/systemd/journal/socket");
+    journal_t(const journal_t& other) = delete;
+    ~journal_t();
+
+    auto operator=(const journal_t& other) -> journal_t& = delete;
+
+    auto path() const noexcept -> const std::string&;
+    auto priorities() const -> std::vector<int>;
+    auto priorities(std::vector<int> priorities) -> void;
+
+    auto emit(const record_t& record, const string_view& formatted) -> void override;
+
+private:
+    auto send(const struct iovec* iov, std::size_t size) -> void;
+};
+
+}  // namespace sink
+}  // namespace v1
+}  // namespace blackhole
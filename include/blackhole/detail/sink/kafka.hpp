@@ -0,0 +1,85 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "blackhole/sink.hpp"
+
+struct rd_kafka_s;
+struct rd_kafka_topic_s;
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+
+class kafka_t : public sink_t {
+public:
+    struct options_t {
+        /// Comma-separated list of bootstrap brokers.
+        std::string brokers;
+        std::string topic;
+
+        /// Name of the attribute, whose value is used as the message key, which selects the
+        /// partition. Empty means random partitioning.
+        std::string key;
+
+        /// Time to wait for more messages before sending a batch.
+        std::chrono::milliseconds linger;
+
+        /// Maximum number of messages in a batch, zero leaves the librdkafka default.
+        std::size_t batch;
+
+        /// Additional librdkafka configuration properties.
+        std::map<std::string, std::string> properties;
+
+        options_t() :
+            linger(5),
+            batch(0)
+        {}
+    };
+
+private:
+    options_t options;
+
+    std::unique_ptr<rd_kafka_s, void(*)(rd_kafka_s*)> producer;
+    std::unique_ptr<rd_kafka_topic_s, void(*)(rd_kafka_topic_s*)> topic;
+
+    std::atomic<std::uint64_t> dropped_;
+    std::atomic<std::uint64_t> failed_;
+
+    std::atomic<bool> stopped;
+    std::thread thread;
+
+public:
+    /// \throw std::invalid_argument if librdkafka rejects the configuration.
+    explicit kafka_t(options_t options);
+    kafka_t(const kafka_t& other) = delete;
+
+    /// Waits up to 5 seconds for enqueued messages to be delivered.
+    ~kafka_t();
+
+    auto operator=(const kafka_t& other) -> kafka_t& = delete;
+
+    /// Returns the number of messages dropped because the producer queue was full.
+    auto dropped() const noexcept -> std::uint64_t;
+
+    /// Returns the number of messages that were enqueued, but failed to be delivered.
+    auto failed() const noexcept -> std::uint64_t;
+
+    /// Enqueues the message, never throwing on enqueueing or delivery failures, which are counted
+    /// instead.
+    auto emit(const record_t& record, const string_view& formatted) -> void override;
+
+private:
+    /// Serves delivery reports on its own thread, so callbacks never run on logging threads.
+    auto run() -> void;
+};
+
+}  // namespace sink
+}  // namespace v1
+}  // namespace blackhole
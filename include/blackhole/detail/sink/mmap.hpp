@@ -0,0 +1,83 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "blackhole/sink.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+
+class mmap_t : public sink_t {
+public:
+    /// Layout of the file header page.
+    struct header_t {
+        char magic[8];
+        std::uint64_t capacity;
+        /// Total number of bytes ever written, the ring position is obtained modulo capacity.
+        std::atomic<std::uint64_t> tail;
+    };
+
+private:
+    std::string path_;
+
+    int fd;
+    char* map;
+    std::size_t size;
+
+    header_t* header;
+    char* data;
+    std::uint64_t capacity_;
+
+    std::chrono::milliseconds interval;
+
+    bool stopped;
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::thread thread;
+
+public:
+    /// Creates or reopens the ring file at the given path.
+    ///
+    /// Existing files having the same capacity are continued from their tail position, others are
+    /// reinitialized.
+    ///
+    /// \param capacity the data ring capacity, which is rounded up to the multiple of the page
+    ///     size.
+    /// \param interval asynchronous synchronization interval, zero disables it.
+    /// \throw std::system_error if unable to create, allocate or map the file.
+    mmap_t(const std::string& path, std::size_t capacity, std::chrono::milliseconds interval);
+    mmap_t(const mmap_t& other) = delete;
+
+    /// Stops the synchronization thread, synchronously flushing the mapping.
+    ~mmap_t();
+
+    auto operator=(const mmap_t& other) -> mmap_t& = delete;
+
+    auto path() const noexcept -> const std::string&;
+    auto capacity() const noexcept -> std::uint64_t;
+
+    /// Returns the total number of bytes written.
+    auto tail() const noexcept -> std::uint64_t;
+
+    /// Copies the formatted message followed by a newline into the ring.
+    ///
+    /// Messages exceeding the ring capacity are truncated.
+    auto emit(const record_t& record, const string_view& formatted) -> void override;
+
+private:
+    /// Copies the given data into the ring at the given position, splitting it at the ring end.
+    auto copy(const char* data, std::size_t size, std::uint64_t position) noexcept -> void;
+
+    auto run() -> void;
+};
+
+}  // namespace sink
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "blackhole/sink.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+
+/// Sink fanning records out to per NUMA node sinks, each one typically an asynchronous sink with
+/// its queue memory and consumer thread placed on that node, so records never cross the
+/// interconnect on their way from producers to consumers.
+///
+/// Producers emit into the sink of the node the CPU they are currently running on belongs to.
+/// Records of a thread migrating between nodes may be reordered.
+class numa_t : public sink_t {
+public:
+    /// Represents a NUMA node.
+    struct node_t {
+        /// Node id, negative if the topology is unknown.
+        int id;
+        /// CPUs of the node.
+        std::vector<int> cpus;
+    };
+
+    /// Creates the sink of the given node.
+    typedef std::function<auto(const node_t& node) -> std::unique_ptr<sink_t>> factory_type;
+
+private:
+    std::vector<node_t> nodes;
+    std::vector<std::unique_ptr<sink_t>> sinks;
+
+    /// Node index of each CPU, routing to the first node unknown CPUs.
+    std::vector<std::size_t> routes;
+
+    /// Destination shared by node sinks if any, which is collected once.
+    std::shared_ptr<sink_t> shared;
+
+public:
+    /// Constructs node sinks using the given factory.
+    ///
+    /// \param shared destination shared by node sinks, which is only used for collecting its
+    ///     metrics once instead of once per node.
+    /// \throw std::invalid_argument if there are no nodes.
+    numa_t(std::vector<node_t> nodes, const factory_type& factory,
+           std::shared_ptr<sink_t> shared = nullptr);
+
+    /// Returns NUMA nodes of the host, discovered through sysfs on linux, or a single node with
+    /// negative id and no CPUs if there is no such information.
+    static auto topology() -> std::vector<node_t>;
+
+    /// Returns a sink forwarding all calls except collecting metrics to the given one, which
+    /// allows node sinks to share it.
+    static auto share(std::shared_ptr<sink_t> sink) -> std::unique_ptr<sink_t>;
+
+    auto emit(const record_t& record, const string_view& message) -> void override;
+    auto emit_batch(const event_t* events, std::size_t size) -> void override;
+    auto flush(std::chrono::steady_clock::time_point deadline) -> bool override;
+
+    /// Collects metrics of each node sink, labeled with the node id, followed by metrics of the
+    /// shared destination if any.
+    auto collect(metrics::collector_t& collector) const -> void override;
+
+    /// Returns the pressure of node sinks merged together with the one of the shared destination.
+    auto pressure() const -> pressure_t override;
+
+private:
+    /// Returns the sink of the node the calling thread is running on.
+    auto local() const noexcept -> sink_t&;
+};
+
+}  // namespace sink
+}  // namespace v1
+}  // namespace blackhole
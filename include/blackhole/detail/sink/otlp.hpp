@@ -0,0 +1,118 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "blackhole/sink.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+namespace http {
+
+class client_t;
+
+}  // namespace http
+
+namespace otlp {
+
+/// Returns the prefix of an `ExportLogsServiceRequest` body carrying a single `ResourceLogs`
+/// message with the given encoded resource and scope, which contains a single `ScopeLogs` message
+/// with log records of the given total size including their framing.
+auto envelope(const std::string& resource, const std::string& scope, std::size_t size) ->
+    std::string;
+
+}  // namespace otlp
+
+class otlp_t : public sink_t {
+public:
+    struct options_t {
+        std::string host;
+        std::uint16_t port;
+
+        /// Request path of the logs export endpoint.
+        std::string path;
+
+        /// Resource attributes describing the source of records, `service.name` is set to the
+        /// process name unless specified.
+        std::vector<std::pair<std::string, std::string>> resource;
+
+        /// Name of the instrumentation scope records are attributed to.
+        std::string scope;
+
+        /// Maximum number of records in a single export request.
+        std::size_t count;
+
+        /// Maximum size of records in a single export request in bytes. A record exceeding it is
+        /// sent alone.
+        std::size_t bytes;
+
+        /// Time to wait for more records before sending an incomplete request.
+        std::chrono::milliseconds linger;
+
+        /// Number of keep-alive connections, which limits the number of requests in flight.
+        std::size_t connections;
+
+        /// Number of times a rejected request is sent again before its records are counted as
+        /// failed.
+        std::size_t retries;
+
+        /// Maximum size of records waiting to be sent in bytes, newer records are dropped when
+        /// exceeded.
+        std::size_t capacity;
+
+        options_t() :
+            host("localhost"),
+            port(4318),
+            path("/v1/logs"),
+            scope("blackhole"),
+            count(512),
+            bytes(4 * 1024 * 1024),
+            linger(200),
+            connections(1),
+            retries(3),
+            capacity(64 * 1024 * 1024)
+        {}
+    };
+
+private:
+    const options_t options_;
+    std::unique_ptr<http::client_t> client;
+
+public:
+    /// Starts the I/O thread, which connects in background, so neither unresolvable nor
+    /// unreachable collectors are reported here.
+    ///
+    /// \throw std::invalid_argument if any of count, bytes, linger or connections limits is zero.
+    explicit otlp_t(options_t options);
+    otlp_t(const otlp_t& other) = delete;
+
+    /// Waits up to 5 seconds for pending records to be sent.
+    ~otlp_t();
+
+    auto operator=(const otlp_t& other) -> otlp_t& = delete;
+
+    auto options() const noexcept -> const options_t&;
+
+    /// Returns the number of records accepted by the collector.
+    auto sent() const noexcept -> std::uint64_t;
+
+    /// Returns the number of records rejected by the collector either permanently or after all
+    /// retries.
+    auto failed() const noexcept -> std::uint64_t;
+
+    /// Returns the number of records dropped because the pending buffer was full.
+    auto dropped() const noexcept -> std::uint64_t;
+
+    /// Enqueues the formatted `LogRecord` message, never blocking on network I/O.
+    auto emit(const record_t& record, const string_view& formatted) -> void override;
+    auto emit_batch(const event_t* events, std::size_t size) -> void override;
+};
+
+}  // namespace sink
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+#include "blackhole/sink.hpp"
+
+#include "blackhole/detail/mutex.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+
+class pipe_t : public sink_t {
+    std::string path_;
+    std::size_t capacity;
+    std::size_t pipe_size;
+
+    int fd;
+    /// Whether buffers are handed over with `vmsplice`, which is decided once the pipe is opened.
+    bool splicing_;
+
+    /// Page-aligned buffer being filled, which is mapped lazily, since gifted ones are dropped.
+    char* buffer;
+    std::size_t used;
+
+    mutable detail::mutex_t mutex;
+
+public:
+    /// Constructs a sink writing into the named pipe at the given path, which is opened lazily.
+    ///
+    /// \param capacity the size of buffers batches are gathered into, which is rounded up to the
+    ///     multiple of the page size.
+    /// \param pipe_size the pipe capacity to request once opened, zero keeps it intact.
+    pipe_t(std::string path, std::size_t capacity, std::size_t pipe_size);
+    pipe_t(const pipe_t& other) = delete;
+
+    ~pipe_t();
+
+    auto operator=(const pipe_t& other) -> pipe_t& = delete;
+
+    auto path() const noexcept -> const std::string&;
+
+    /// Returns the size of buffers batches are gathered into.
+    auto buffer_size() const noexcept -> std::size_t;
+
+    /// Returns whether buffers are handed over with `vmsplice`, which is known only after the pipe
+    /// has been opened.
+    auto splicing() const -> bool;
+
+    /// Writes the formatted message followed by a newline into the pipe.
+    ///
+    /// \throw std::system_error if unable to open the pipe or to write into it.
+    auto emit(const record_t& record, const string_view& formatted) -> void override;
+
+    /// Gathers formatted messages into page-aligned buffers, handing each one over to the pipe
+    /// when it's full and the last one at the end of the batch.
+    auto emit_batch(const event_t* events, std::size_t size) -> void override;
+
+private:
+    /// Opens the pipe unless it is already open, creating it when missing.
+    auto open() -> void;
+
+    /// Closes the pipe after a write error, so that the next event reopens it, and throws.
+    [[noreturn]] auto fail(int ec) -> void;
+
+    /// Copies the given data into the current buffer, which must have enough free space.
+    auto append(const char* data, std::size_t size) -> void;
+
+    /// Hands the current buffer over to the pipe, unless it's empty.
+    auto handoff() -> void;
+
+    /// Writes the given message followed by a newline directly into the pipe.
+    auto write(const char* data, std::size_t size) -> void;
+};
+
+}  // namespace sink
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,172 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "blackhole/attribute.hpp"
+#include "blackhole/attributes.hpp"
+#include "blackhole/record.hpp"
+#include "blackhole/stdext/string_view.hpp"
+
+#include "blackhole/detail/pages.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+
+/// Multiple producers single consumer ring of variable-length byte slots over a preallocated
+/// cache-line-aligned buffer.
+///
+/// Producers reserve contiguous slots by advancing the shared head position, fill them and commit
+/// by publishing the slot header. The consumer reads committed slots in order and releases them
+/// all at once, zeroing the consumed memory, which is required for uncommitted headers to be
+/// recognized.
+///
+/// Slots never wrap around the buffer end, the unused tail is filled with a padding slot instead.
+class ring_t {
+public:
+    /// Committed slot view.
+    struct slot_t {
+        const char* data;
+        std::size_t size;
+    };
+
+    /// Reserved, but not yet committed slot, data points to the payload.
+    struct reservation_t {
+        char* data;
+        std::uint32_t length;
+    };
+
+private:
+    std::size_t capacity_;
+    std::unique_ptr<detail::pages_t> pages;
+    char* buffer;
+
+    /// Consumer-local position of the next slot to read.
+    std::uint64_t cursor;
+
+    // Producers and the consumer positions live on separate cache lines to avoid false sharing.
+    // Explicit padding is used instead of `alignas`, because over-aligned dynamic allocation is
+    // not available until C++17.
+    char pad0[64];
+    std::atomic<std::uint64_t> head;
+    char pad1[64 - sizeof(std::atomic<std::uint64_t>)];
+    std::atomic<std::uint64_t> tail;
+    char pad2[64 - sizeof(std::atomic<std::uint64_t>)];
+
+public:
+    /// Constructs a ring with the given capacity in bytes, allocating its memory with the given
+    /// paging properties.
+    ///
+    /// \throw std::invalid_argument if the capacity is not a power of two or less than a cache
+    ///     line.
+    /// \throw std::system_error if unable to allocate pages with the given properties.
+    explicit ring_t(std::size_t capacity, const detail::paging_t& paging = detail::paging_t());
+
+    ring_t(const ring_t& other) = delete;
+    auto operator=(const ring_t& other) -> ring_t& = delete;
+
+    auto capacity() const noexcept -> std::size_t;
+
+    /// Returns the number of bytes reserved and not released yet, including padding and headers.
+    ///
+    /// The value may be stale by the time it is returned. Thread-safe.
+    auto used() const noexcept -> std::size_t;
+
+    /// Checks whether a slot of the given size can ever be reserved.
+    auto fits(std::size_t size) const noexcept -> bool;
+
+    /// Checks whether there are no reserved slots starting from the consumer cursor.
+    ///
+    /// Can be called from the consumer thread only.
+    auto empty() const noexcept -> bool;
+
+    /// Reserves a slot of the given size.
+    ///
+    /// Returns a reservation with null data on overflow. Thread-safe.
+    auto reserve(std::size_t size) noexcept -> reservation_t;
+
+    /// Publishes the previously reserved slot making it visible to the consumer. Thread-safe.
+    auto commit(const reservation_t& reservation) noexcept -> void;
+
+    /// Reads the next committed slot, advancing the consumer cursor.
+    ///
+    /// Returns false if the next slot is either not reserved or not committed yet. Slots read stay
+    /// valid until the next `release` call. Can be called from the consumer thread only.
+    auto read(slot_t& slot) noexcept -> bool;
+
+    /// Releases all slots read so far, making their space available to producers.
+    ///
+    /// Can be called from the consumer thread only.
+    auto release() noexcept -> void;
+
+    /// Passes all committed slots not released yet to the given function in order, stopping at
+    /// the first uncommitted one.
+    ///
+    /// Neither synchronizes with the consumer nor modifies the ring, so it's async-signal-safe and
+    /// can be called from any thread, but slots may be overwritten while being visited - this is
+    /// intended for crash dumps only.
+    auto visit(void(*fn)(const slot_t& slot, void* context), void* context) const noexcept
+        -> void;
+
+private:
+    auto header(std::uint64_t position) const noexcept -> std::atomic<std::uint32_t>&;
+};
+
+/// Serializes records into ring slots and deserializes them back into record views.
+///
+/// All strings are stored inline, function attribute values are formatted during serialization.
+namespace ring {
+
+/// Encodes the given record and its formatted message into the thread-local scratch buffer.
+///
+/// The returned view stays valid until the next call from the same thread. The scratch buffer only
+/// grows, so there is no memory allocation in a steady state.
+auto encode(const record_t& record, const string_view& message) -> string_view;
+
+/// Checks whether the given bytes hold exactly one well-formed encoded record, which must be done
+/// before decoding records received from untrusted sources.
+auto valid(const ring_t::slot_t& slot) noexcept -> bool;
+
+/// Writes the formatted message of the encoded record in the given slot followed by a newline
+/// into the file descriptor.
+///
+/// Async-signal-safe.
+auto dump(const ring_t::slot_t& slot, int fd) noexcept -> void;
+
+/// Storage for a decoded record.
+///
+/// Objects of this class are neither copyable nor movable, because the record refers to their
+/// members.
+class decoded_t {
+    string_view message_;
+    string_view formatted_;
+    string_view output_;
+
+    attribute_list attributes;
+    attribute_pack pack;
+
+    typedef std::aligned_storage<sizeof(record_t), alignof(record_t)>::type storage_type;
+    storage_type storage;
+
+public:
+    decoded_t() = default;
+    decoded_t(const decoded_t& other) = delete;
+    auto operator=(const decoded_t& other) -> decoded_t& = delete;
+
+    /// Decodes the record from the given slot, reusing the attributes storage.
+    auto decode(const ring_t::slot_t& slot) -> void;
+
+    /// Returns the record view over the slot memory, valid until the slot is released.
+    auto record() const noexcept -> const record_t&;
+
+    /// Returns the message formatted for the sink.
+    auto output() const noexcept -> const string_view&;
+};
+
+}  // namespace ring
+}  // namespace sink
+}  // namespace v1
+}  // namespace blackhole
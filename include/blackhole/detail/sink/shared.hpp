@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "blackhole/record.hpp"
+#include "blackhole/sink.hpp"
+#include "blackhole/stdext/string_view.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+
+/// Immutable owned record together with its formatted message, shared by atomic reference
+/// counting between asynchronous sinks the record is emitted into.
+///
+/// Both the record and the message are placed into a single chunk of a size class fitting them,
+/// taken from the pool of the capturing thread. When the last reference is released, possibly by
+/// another thread, the chunk returns to that pool, so memory is reused by the same thread and
+/// capturing requires no allocations in a steady state. Chunks larger than 64 KB are allocated
+/// on demand.
+class shared_record_t {
+public:
+    class block_t;
+
+private:
+    block_t* block;
+
+public:
+    /// Constructs an empty object, which must not be accessed.
+    shared_record_t() noexcept :
+        block(nullptr)
+    {}
+
+    shared_record_t(const shared_record_t& other) noexcept;
+    shared_record_t(shared_record_t&& other) noexcept;
+
+    ~shared_record_t();
+
+    auto operator=(const shared_record_t& other) noexcept -> shared_record_t&;
+    auto operator=(shared_record_t&& other) noexcept -> shared_record_t&;
+
+    /// Returns the record with the given message shared in the current sharing scope, capturing
+    /// a new one if there is no such record.
+    ///
+    /// Records are matched by their addresses and messages by their contents, so sinks receiving
+    /// differently formatted messages of the same record get their own copies.
+    ///
+    /// \throw std::bad_alloc on memory allocation failure.
+    static auto capture(const record_t& record, const string_view& message) -> shared_record_t;
+
+    /// Captures the given record with room for its message of at least the given size, which is
+    /// formatted right into the room and completed afterwards instead of being copied.
+    ///
+    /// Reserved records are not shared in the current sharing scope.
+    ///
+    /// \throw std::bad_alloc on memory allocation failure.
+    static auto reserve(const record_t& record, std::size_t size) -> shared_record_t;
+
+    /// Returns the room for the message, which spans the rest of the chunk.
+    auto room() const noexcept -> sink_t::region_t;
+
+    /// Sets the message to the given number of bytes written into the room.
+    ///
+    /// \warning must be called before the record is shared.
+    auto complete(std::size_t size) noexcept -> void;
+
+    /// Returns the record view, valid while this object refers to it.
+    auto record() const noexcept -> record_t;
+
+    /// Returns the formatted message, valid while this object refers to it.
+    auto message() const noexcept -> string_view;
+
+    /// Returns the counter reading the record was captured at if it's sampled, zero otherwise.
+    ///
+    /// \sa blackhole::stage::sample.
+    auto sampled() const noexcept -> std::uint64_t;
+
+    /// Returns the number of references, which is mostly useful for testing.
+    auto use_count() const noexcept -> std::size_t;
+};
+
+/// Marks the scope of emitting a single record into sinks on the current thread.
+///
+/// Asynchronous sinks capture each record once per scope and share it with the others instead of
+/// copying it again. Scopes can be nested, i.e. when logging from inside of a sink.
+class sharing_t {
+    sharing_t* previous;
+
+    const record_t* record;
+    shared_record_t value;
+
+public:
+    sharing_t() noexcept;
+    ~sharing_t();
+
+    sharing_t(const sharing_t& other) = delete;
+    auto operator=(const sharing_t& other) -> sharing_t& = delete;
+
+    friend class shared_record_t;
+};
+
+}  // namespace sink
+}  // namespace v1
+}  // namespace blackhole
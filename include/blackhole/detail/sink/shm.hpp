@@ -0,0 +1,144 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+#include "blackhole/sink.hpp"
+#include "blackhole/stdext/string_view.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+namespace shm {
+
+/// Layout of the shared memory object.
+///
+/// The object consists of this control page followed by the data ring of `capacity` bytes, which
+/// is a power of two. Each field group lives on its own cache line.
+///
+/// The data ring contains variable-length slots, which never wrap around the ring end and are
+/// aligned to 8 bytes. A slot starts with a header of two 32-bit words: the slot length, including
+/// the header and alignment, with the lowest bit set for padding slots filling the ring end, and
+/// the payload size. A zero length means that the slot is not committed yet.
+///
+/// Producers reserve slots by advancing `head`, copy the payload and publish the length with
+/// release semantics. The reader starts at `tail`, reads slots until it meets a zero length, then
+/// zeroes the consumed memory and publishes the new `tail`. Positions only grow, offsets are
+/// obtained modulo capacity.
+///
+/// An idle reader sets `waiting` to non-zero, checks the ring once again and waits on the
+/// `doorbell` futex word. Producers increment the doorbell and wake the reader after committing
+/// when `waiting` is set. Events not fitting into the free space are dropped and counted in
+/// `dropped`.
+struct header_t {
+    /// Identifies the layout version.
+    char magic[8];
+    /// Payload format of slots, see `format_t`.
+    std::uint32_t format;
+    std::uint32_t reserved;
+    std::uint64_t capacity;
+    char pad0[40];
+
+    std::atomic<std::uint64_t> head;
+    char pad1[56];
+
+    std::atomic<std::uint64_t> tail;
+    char pad2[56];
+
+    std::atomic<std::uint32_t> doorbell;
+    std::atomic<std::uint32_t> waiting;
+    std::atomic<std::uint64_t> dropped;
+};
+
+/// Slot payload format.
+enum class format_t : std::uint32_t {
+    /// The formatted message as is.
+    text,
+    /// Record encoded by `ring::encode`, which is decodable with `ring::decoded_t`.
+    binary
+};
+
+/// Maps an existing ring shared memory object.
+class mapping_t {
+protected:
+    int fd;
+    char* map;
+    std::size_t size;
+
+    header_t* header;
+    char* data;
+
+public:
+    mapping_t(const mapping_t& other) = delete;
+    ~mapping_t();
+
+    auto operator=(const mapping_t& other) -> mapping_t& = delete;
+
+    auto capacity() const noexcept -> std::uint64_t;
+    auto format() const noexcept -> format_t;
+
+    /// Returns the number of events dropped because the reader fell behind.
+    auto dropped() const noexcept -> std::uint64_t;
+
+protected:
+    mapping_t() noexcept;
+
+    /// \throw std::system_error if unable to map the file descriptor.
+    auto attach(int fd, std::size_t size) -> void;
+};
+
+/// Reference reader, which consumes the ring in the same way as external readers should.
+class reader_t : public mapping_t {
+    std::uint64_t cursor;
+
+public:
+    typedef string_view slot_type;
+
+    /// \throw std::system_error if unable to open or to map the shared memory object.
+    /// \throw std::invalid_argument if the object has an unknown layout.
+    explicit reader_t(const std::string& name);
+
+    /// Reads the next committed slot payload, returns false if there is none.
+    ///
+    /// Slots read remain valid until the next `release` call.
+    auto read(slot_type& slot) noexcept -> bool;
+
+    /// Releases all slots read so far, making their space available to producers.
+    auto release() noexcept -> void;
+
+    /// Waits for new slots using the doorbell, returns false on timeout.
+    auto wait(std::chrono::milliseconds timeout) -> bool;
+};
+
+}  // namespace shm
+
+class shm_t : public sink_t, public shm::mapping_t {
+    std::string name_;
+    shm::format_t format_;
+
+public:
+    /// Creates the shared memory object with the given name or attaches to an existing one having
+    /// the same capacity and format, continuing from its positions.
+    ///
+    /// \param name the shared memory object name, like "/blackhole".
+    /// \param capacity the data ring capacity, must be a power of two multiple of the page size.
+    /// \throw std::invalid_argument if the capacity is not a power of two or less than a page.
+    /// \throw std::system_error if unable to create or to map the object.
+    shm_t(std::string name, std::size_t capacity, shm::format_t format = shm::format_t::text);
+
+    auto name() const noexcept -> const std::string&;
+
+    /// Copies the formatted message or the encoded record into a ring slot, never blocking.
+    ///
+    /// Events are dropped if the ring has not enough free space.
+    auto emit(const record_t& record, const string_view& formatted) -> void override;
+
+private:
+    auto push(const string_view& payload) noexcept -> bool;
+};
+
+}  // namespace sink
+}  // namespace v1
+}  // namespace blackhole
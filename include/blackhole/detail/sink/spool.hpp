@@ -0,0 +1,91 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "blackhole/sink.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+
+/// Sink queueing records in memory for its own thread emitting them into the wrapped sink, which
+/// spills records to disk instead of blocking or dropping them once the queue passes a watermark.
+///
+/// Records are encoded by `ring::encode` into a byte ring. When the ring fill exceeds the
+/// watermark, for example because the wrapped sink is slow or down, producers append records to
+/// segment files in the spool directory sequentially. The thread emits records of the ring first,
+/// then replays segments in order, removing each one replayed completely, and producers switch
+/// back to the ring once no records are left on disk, which keeps them ordered.
+///
+/// Failed batches are retried after the backoff, so records are emitted at least once, but may be
+/// emitted more than once. Records left in memory on destruction are emitted once more and
+/// spilled if that fails, while segments found in the directory on construction are replayed
+/// first, so spooled records survive restarts. Segments are not synced, which makes them survive
+/// process crashes, but not power loss.
+///
+/// Records not fitting into the disk limit are dropped and counted.
+class spool_t : public sink_t {
+public:
+    struct options_t {
+        /// Directory for segment files, which is created if missing.
+        std::string path;
+        /// In-memory ring capacity in bytes, which must be a power of two.
+        std::size_t capacity;
+        /// Ring fill ratio in (0; 1] range, after which records are spilled to disk.
+        double watermark;
+        /// Segment file size, after which the next segment is started.
+        std::size_t segment;
+        /// The maximum total size of segment files.
+        std::uint64_t limit;
+        /// The maximum number of records emitted into the wrapped sink at once.
+        std::size_t batch;
+        /// Interval between attempts to emit a failed batch.
+        std::chrono::milliseconds backoff;
+
+        options_t();
+    };
+
+private:
+    class inner_t;
+    std::unique_ptr<inner_t> d;
+
+public:
+    /// \throw std::invalid_argument if the path is empty, the capacity is not a power of two, the
+    ///     watermark is out of range, or either the segment size or the batch size is zero.
+    /// \throw std::system_error if unable to create or to scan the spool directory.
+    spool_t(std::unique_ptr<sink_t> wrapped, options_t options);
+
+    /// Stops the thread, spilling records it fails to emit.
+    ~spool_t();
+
+    /// Returns the number of records spilled to disk.
+    auto spilled() const noexcept -> std::uint64_t;
+
+    /// Returns the number of records replayed from disk into the wrapped sink.
+    auto replayed() const noexcept -> std::uint64_t;
+
+    /// Returns the number of records dropped because of the disk limit.
+    auto dropped() const noexcept -> std::uint64_t;
+
+    /// Enqueues the record, spilling it into the current segment if the ring is above the
+    /// watermark or there are spilled records not replayed yet.
+    ///
+    /// \throw std::system_error if unable to write the segment.
+    auto emit(const record_t& record, const string_view& message) -> void override;
+
+    /// Waits until both the ring and the spool directory are drained, then flushes the wrapped
+    /// sink.
+    auto flush(std::chrono::steady_clock::time_point deadline) -> bool override;
+
+    auto collect(metrics::collector_t& collector) const -> void override;
+
+    /// Returns the ring pressure merged with the one of the wrapped sink.
+    auto pressure() const -> pressure_t override;
+};
+
+}  // namespace sink
+}  // namespace v1
+}  // namespace blackhole
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -10,6 +11,16 @@ inline namespace v1 {
 namespace sink {
 
 class syslog_t : public sink_t {
+public:
+    /// Frame format of the native transport.
+    enum class format_t {
+        /// BSD syslog protocol with local time stamps.
+        rfc3164,
+        /// IETF syslog protocol with UTC time stamps of microsecond precision.
+        rfc5424
+    };
+
+private:
     struct {
         int option;
         int facility;
@@ -17,14 +28,39 @@ class syslog_t : public sink_t {
         std::vector<int> priorities;
     } data;
 
+    std::string address_;
+    format_t format_;
+
+    /// Precomputed frame parts, which are the same for all records, except the time stamp: header
+    /// per priority and the trailer following the time stamp.
+    std::vector<std::string> headers;
+    std::string trailer;
+
+    /// Connected socket of the native transport, defined in the translation unit.
+    class transport_t;
+    std::unique_ptr<transport_t> transport;
+
 public:
+    /// Constructs a sink, which uses libc `syslog` function.
     syslog_t();
+
+    /// Constructs a sink, which writes syslog frames directly into the socket, bypassing libc
+    /// `syslog` function with its global lock.
+    ///
+    /// \param address either a path to the local datagram socket, like "/dev/log", or a remote
+    ///     collector address in "udp://host:port" or "tcp://host:port" form. Frames sent over TCP
+    ///     use octet counting framing of RFC 6587.
+    ///
+    /// \throw std::invalid_argument if the address is malformed.
+    /// \throw std::system_error if unable to resolve or to connect the address.
+    explicit syslog_t(std::string address, format_t format = format_t::rfc3164);
+
     syslog_t(const syslog_t& other) = delete;
-    syslog_t(syslog_t&& other) = default;
+    syslog_t(syslog_t&& other);
     ~syslog_t();
 
     auto operator=(const syslog_t& other) -> syslog_t& = delete;
-    auto operator=(syslog_t&& other) -> syslog_t& = default;
+    auto operator=(syslog_t&& other) -> syslog_t&;
 
     auto option() const noexcept -> int;
     auto facility() const noexcept -> int;
@@ -32,7 +68,19 @@ public:
     auto priorities() const -> std::vector<int>;
     auto priorities(std::vector<int> priorities) -> void;
 
+    /// Returns the native transport address, empty if libc `syslog` is used.
+    auto address() const noexcept -> const std::string&;
+    auto format() const noexcept -> format_t;
+
     auto emit(const record_t& record, const string_view& formatted) -> void override;
+
+    /// Emits the batch using a `sendmmsg` call per up to 64 datagrams or a single `writev` for TCP
+    /// with the native transport.
+    auto emit_batch(const event_t* events, std::size_t size) -> void override;
+
+private:
+    auto priority(const record_t& record) const noexcept -> std::size_t;
+    auto precompute() -> void;
 };
 
 }  // namespace sink
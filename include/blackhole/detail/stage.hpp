@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+
+#include "blackhole/stage.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace detail {
+namespace stage {
+
+using blackhole::stage::id_t;
+
+/// Returns whether the calling thread is logging a sampled record.
+auto active() noexcept -> bool;
+
+/// Restarts the current stage of the sampled record of the calling thread, if any.
+auto mark() noexcept -> void;
+
+/// Records the time elapsed since the current stage start as the given stage of the sampled record
+/// of the calling thread, if any, starting the next stage.
+auto stamp(id_t stage) noexcept -> void;
+
+/// Marks the sampled record of the calling thread as passed to an asynchronous consumer, which is
+/// therefore responsible for stamping its write.
+auto defer() noexcept -> void;
+
+/// Records the time elapsed since the current stage start as the write of the sampled record of
+/// the calling thread, unless it was deferred.
+auto written() noexcept -> void;
+
+/// Records the given number of TSC ticks as the given stage of a sampled record.
+auto record(id_t stage, std::uint64_t ticks) noexcept -> void;
+
+/// Decides whether the record logged by the calling thread is sampled, which lasts until the
+/// scope is destroyed.
+class scope_t {
+    bool sampled;
+
+public:
+    scope_t() noexcept;
+    ~scope_t();
+
+    scope_t(const scope_t& other) = delete;
+    auto operator=(const scope_t& other) -> scope_t& = delete;
+};
+
+}  // namespace stage
+}  // namespace detail
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "blackhole/stdext/string_view.hpp"
+#include "blackhole/trace.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace detail {
+namespace trace {
+
+/// Renders the trace id as 32 lowercase hex digits into the given buffer.
+auto trace_id(const trace_t& trace, char (&buffer)[32]) noexcept -> string_view;
+
+/// Renders the span id as 16 lowercase hex digits into the given buffer.
+auto span_id(const trace_t& trace, char (&buffer)[16]) noexcept -> string_view;
+
+}  // namespace trace
+}  // namespace detail
+}  // namespace v1
+}  // namespace blackhole
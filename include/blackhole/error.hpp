@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+#include "blackhole/stdext/string_view.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace error {
+
+/// Kinds of internal errors, each one rate limited and counted separately.
+enum class kind_t {
+    /// Exceptions thrown by handlers, interceptors and components of static loggers while handling
+    /// records, including asynchronous handlers handling them in background.
+    handler,
+    /// Failures of sinks occurred outside of logging calls, for example while flushing, rotating
+    /// or closing files and reconnecting sockets in background threads.
+    sink,
+    /// Exceptions thrown while replaying deferred records, either by deferred loggers or buffered
+    /// scopes.
+    deferred,
+};
+
+/// Number of error kinds.
+constexpr std::size_t kinds = 3;
+
+/// Returns the name of the given error kind, which metrics are labeled with.
+auto name(kind_t kind) noexcept -> const char*;
+
+/// Receives internal errors passed the rate limit together with the number of errors of the same
+/// kind suppressed since the previous report.
+typedef std::function<auto(kind_t kind, const string_view& message, std::uint64_t suppressed) ->
+    void> reporter_type;
+
+/// Sets the process-wide internal error reporter, returning the previous one.
+///
+/// The default reporter prints `logging core error occurred: <message>` lines to the standard
+/// output, noting the number of suppressed errors if any. An empty function restores it.
+///
+/// \note the reporter is called outside of any lock of the library, but it must not throw, since
+///     exceptions thrown by it are swallowed.
+auto reporter(reporter_type reporter) -> reporter_type;
+
+/// Sets the maximum number of errors of each kind reported per second, zero meaning no limit.
+/// Errors exceeding the limit are only counted, which makes a broken sink cost a counter increment
+/// per record instead of a synchronous write to the standard output.
+///
+/// Defaults to 10. Changing the limit restarts rate limiting, so errors suppressed before are no
+/// longer noted by the next report, while still being counted.
+auto limit(std::size_t rate) noexcept -> void;
+
+/// Returns the maximum number of errors of each kind reported per second.
+auto limit() noexcept -> std::size_t;
+
+/// Returns the number of errors of the given kind occurred so far, either reported or not.
+auto occurred(kind_t kind) noexcept -> std::uint64_t;
+
+/// Returns the number of errors of the given kind suppressed by the rate limit so far.
+auto suppressed(kind_t kind) noexcept -> std::uint64_t;
+
+}  // namespace error
+}  // namespace v1
+}  // namespace blackhole
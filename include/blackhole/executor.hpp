@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+
+namespace blackhole {
+inline namespace v1 {
+
+/// Bounded pool of threads running tasks posted by loggers, which offload handlers from logging
+/// threads.
+///
+/// Tasks are started in the order they are posted, but may complete in any order if there are
+/// several threads. The executor can be shared among many loggers.
+class executor_t {
+    class inner_t;
+    std::unique_ptr<inner_t> d;
+
+public:
+    /// Default maximum number of queued tasks.
+    static constexpr std::size_t default_capacity = 1024;
+
+    /// Starts the given number of threads, which run tasks from the queue of the given capacity.
+    ///
+    /// \throw std::invalid_argument if either no threads are requested or the capacity is zero.
+    explicit executor_t(std::size_t threads, std::size_t capacity = default_capacity);
+
+    executor_t(const executor_t& other) = delete;
+    auto operator=(const executor_t& other) -> executor_t& = delete;
+
+    /// Runs all queued tasks and stops threads.
+    ///
+    /// \warning must not be called by a task, i.e. from one of executor threads.
+    ~executor_t();
+
+    /// Queues the given task, returning `false` without queueing if the queue is full.
+    ///
+    /// \note exceptions thrown by tasks are ignored.
+    auto post(std::function<void()> task) -> bool;
+};
+
+}  // namespace v1
+}  // namespace blackhole
@@ -43,6 +43,13 @@ public:
         return wrapped.get();
     }
 
+    /// Checks whether the underlying logger accepts events with the given severity level.
+    ///
+    /// Every logging method checks this before formatting, making disabled events cheap if the
+    /// underlying logger provides `enabled(severity) -> bool` method. Otherwise all events are
+    /// considered enabled.
+    auto enabled(int severity) const -> bool;
+
     /// Log a message with the given severity level.
     auto log(int severity, const string_view& pattern) -> void;
 
@@ -57,6 +64,9 @@ public:
     /// \overload
     /// \tparam T and Args... must meet the requirements of `StreamFormatted`.
     /// \note the last parameter of variadic `Args...` pack can be an `attribute_list`.
+    /// \note alternatively the pack can end with any number of typed attributes, constructed
+    ///     using `attr` function, which are converted into attribute views only if the event passes
+    ///     the severity check.
     template<typename T, typename... Args>
     auto log(int severity, const string_view& pattern, const T& arg, const Args&... args) -> void;
 
@@ -71,6 +81,18 @@ public:
     /// \tparam T and Args... must meet the requirements of `StreamFormatted`.
     template<std::size_t N, typename T, typename... Args>
     auto log(int severity, const detail::formatter<N>& pattern, const T& arg, const Args&... args) -> void;
+
+    /// Log a message with the given severity level, formatting using the pattern split into
+    /// literals at compile time by `BH_PATTERN` macro and the given arguments, optionally followed
+    /// by either an attributes list or typed attributes.
+    ///
+    /// Fails to compile if the number of formatting arguments doesn't match the number of
+    /// placeholders in the pattern.
+    ///
+    /// \overload
+    /// \tparam Args... must meet the requirements of `StreamFormatted`.
+    template<std::size_t N, std::size_t A, typename... Args>
+    auto log(int severity, const detail::pattern_t<N, A>& pattern, const Args&... args) -> void;
 #endif
 
 private:
@@ -80,7 +102,16 @@ private:
     template<typename... Args>
     inline
     auto select(int severity, const string_view& pattern, const Args&... args) ->
-        typename std::enable_if<!detail::with_attributes<Args...>::value>::type;
+        typename std::enable_if<!detail::with_attributes<Args...>::value &&
+            !detail::with_typed_attributes<Args...>::value>::type;
+
+    /// Selects the proper method overload when using variadic pack interface.
+    ///
+    /// \overload for variadic pack with typed attributes as the last arguments.
+    template<typename... Args>
+    inline
+    auto select(int severity, const string_view& pattern, const Args&... args) ->
+        typename std::enable_if<detail::with_typed_attributes<Args...>::value>::type;
 
     /// Selects the proper method overload when using variadic pack interface.
     ///
@@ -89,12 +120,47 @@ private:
     inline
     auto select(int severity, const string_view& pattern, const Args&... args) ->
         typename std::enable_if<detail::with_attributes<Args...>::value>::type;
+
+#if defined(__cpp_constexpr) && __cpp_constexpr >= 201304
+    /// Selects the proper method overload for patterns split at compile time.
+    ///
+    /// \overload for variadic pack without attributes.
+    template<typename Pattern, typename... Args>
+    auto compiled(int severity, const Pattern& pattern, const Args&... args) ->
+        typename std::enable_if<detail::attributes_count<Args...>::value == 0>::type;
+
+    /// Selects the proper method overload for patterns split at compile time.
+    ///
+    /// \overload for variadic pack with attribute list as the last argument.
+    template<typename Pattern, typename... Args>
+    auto compiled(int severity, const Pattern& pattern, const Args&... args) ->
+        typename std::enable_if<detail::attributes_count<Args...>::value != 0 &&
+            !detail::with_typed_attributes<Args...>::value>::type;
+
+    /// Selects the proper method overload for patterns split at compile time.
+    ///
+    /// \overload for variadic pack with typed attributes as the last arguments.
+    template<typename Pattern, typename... Args>
+    auto compiled(int severity, const Pattern& pattern, const Args&... args) ->
+        typename std::enable_if<detail::with_typed_attributes<Args...>::value>::type;
+#endif
 };
 
+template<typename Logger>
+inline
+auto
+logger_facade<Logger>::enabled(int severity) const -> bool {
+    return detail::enabled(inner(), severity, 0);
+}
+
 template<typename Logger>
 inline
 auto
 logger_facade<Logger>::log(int severity, const string_view& pattern) -> void {
+    if (!enabled(severity)) {
+        return;
+    }
+
     inner().log(severity, pattern);
 }
 
@@ -103,6 +169,10 @@ template<typename T, typename... Args>
 inline
 auto
 logger_facade<Logger>::log(int severity, const string_view& pattern, const T& arg, const Args&... args) -> void {
+    if (!enabled(severity)) {
+        return;
+    }
+
     select(severity, pattern, arg, args...);
 }
 
@@ -110,6 +180,10 @@ template<typename Logger>
 inline
 auto
 logger_facade<Logger>::log(int severity, const string_view& pattern, const attribute_list& attributes) -> void {
+    if (!enabled(severity)) {
+        return;
+    }
+
     attribute_pack pack{attributes};
     inner().log(severity, pattern, pack);
 }
@@ -121,6 +195,10 @@ template<std::size_t N, typename T, typename... Args>
 inline
 auto
 logger_facade<Logger>::log(int severity, const detail::formatter<N>& pattern, const T& arg, const Args&... args) -> void {
+    if (!enabled(severity)) {
+        return;
+    }
+
     fmt::MemoryWriter wr;
     const auto fn = [&]() -> string_view {
         pattern.format(wr, arg, args...);
@@ -128,8 +206,67 @@ logger_facade<Logger>::log(int severity, const detail::formatter<N>& pattern, co
     };
 
     attribute_pack pack;
-    // TODO: Pass non-empty pattern.
-    inner().log(severity, {"", std::cref(fn)}, pack);
+    inner().log(severity, {pattern.pattern(), fn}, pack);
+}
+
+template<typename Logger>
+template<std::size_t N, std::size_t A, typename... Args>
+inline
+auto
+logger_facade<Logger>::log(int severity, const detail::pattern_t<N, A>& pattern, const Args&... args) -> void {
+    static_assert(sizeof...(Args) - detail::attributes_count<Args...>::value == A,
+        "the number of formatting arguments must match the number of placeholders in the pattern");
+
+    if (!enabled(severity)) {
+        return;
+    }
+
+    compiled(severity, pattern, args...);
+}
+
+template<typename Logger>
+template<typename Pattern, typename... Args>
+inline
+auto
+logger_facade<Logger>::compiled(int severity, const Pattern& pattern, const Args&... args) ->
+    typename std::enable_if<detail::attributes_count<Args...>::value == 0>::type
+{
+    attribute_pack pack;
+    detail::log_compiled(inner(), severity, pattern, std::forward_as_tuple(args...),
+        typename detail::make_indices<0, sizeof...(Args)>::type(), pack);
+}
+
+template<typename Logger>
+template<typename Pattern, typename... Args>
+inline
+auto
+logger_facade<Logger>::compiled(int severity, const Pattern& pattern, const Args&... args) ->
+    typename std::enable_if<detail::attributes_count<Args...>::value != 0 &&
+        !detail::with_typed_attributes<Args...>::value>::type
+{
+    const auto tuple = std::forward_as_tuple(args...);
+
+    attribute_pack pack{std::get<sizeof...(Args) - 1>(tuple)};
+    detail::log_compiled(inner(), severity, pattern, tuple,
+        typename detail::make_indices<0, sizeof...(Args) - 1>::type(), pack);
+}
+
+template<typename Logger>
+template<typename Pattern, typename... Args>
+inline
+auto
+logger_facade<Logger>::compiled(int severity, const Pattern& pattern, const Args&... args) ->
+    typename std::enable_if<detail::with_typed_attributes<Args...>::value>::type
+{
+    constexpr auto count = sizeof...(Args) - detail::typed_count<Args...>::value;
+
+    const auto tuple = std::forward_as_tuple(args...);
+    const auto attributes = detail::typed_list(tuple,
+        typename detail::make_indices<count, sizeof...(Args)>::type());
+
+    attribute_pack pack{attributes};
+    detail::log_compiled(inner(), severity, pattern, tuple,
+        typename detail::make_indices<0, count>::type(), pack);
 }
 
 #endif
@@ -139,13 +276,14 @@ template<typename... Args>
 inline
 auto
 logger_facade<Logger>::select(int severity, const string_view& pattern, const Args&... args) ->
-    typename std::enable_if<!detail::with_attributes<Args...>::value>::type
+    typename std::enable_if<!detail::with_attributes<Args...>::value &&
+        !detail::with_typed_attributes<Args...>::value>::type
 {
     fmt::MemoryWriter wr;
-    const auto fn = std::bind(&detail::gcc::write_all<Args...>, std::ref(wr), pattern.data(), std::cref(args)...);
+    const detail::formatted_t<Args...> fn(wr, pattern.data(), args...);
 
     attribute_pack pack;
-    inner().log(severity, {pattern, std::cref(fn)}, pack);
+    inner().log(severity, {pattern, fn}, pack);
 }
 
 template<typename Logger>
@@ -158,5 +296,19 @@ logger_facade<Logger>::select(int severity, const string_view& pattern, const Ar
     detail::without_tail<detail::select_t, Args...>::type::apply(inner(), severity, pattern, args...);
 }
 
+template<typename Logger>
+template<typename... Args>
+inline
+auto
+logger_facade<Logger>::select(int severity, const string_view& pattern, const Args&... args) ->
+    typename std::enable_if<detail::with_typed_attributes<Args...>::value>::type
+{
+    constexpr auto count = sizeof...(Args) - detail::typed_count<Args...>::value;
+
+    detail::log_typed(inner(), severity, pattern, std::forward_as_tuple(args...),
+        typename detail::make_indices<0, count>::type(),
+        typename detail::make_indices<count, sizeof...(Args)>::type());
+}
+
 }  // namespace blackhole
 }  // namespace blackhole
@@ -1,7 +1,11 @@
 #pragma once
 
+#include <cstddef>
 #include <functional>
+#include <tuple>
+#include <type_traits>
 
+#include "blackhole/attribute.hpp"
 #include "blackhole/attributes.hpp"
 #include "blackhole/stdext/string_view.hpp"
 #include "blackhole/extensions/writer.hpp"
@@ -11,6 +15,27 @@ inline namespace v1 {
 
 namespace ph = std::placeholders;
 
+/// Typed attribute, which keeps the static type of its value until the logging event is accepted
+/// by the severity check.
+///
+/// Holds a reference to the value, so it is meant to be constructed using `attr` function right in
+/// the logging call arguments.
+template<typename T>
+struct attr_t {
+    string_view name;
+    const T& value;
+};
+
+/// Constructs a typed attribute, which can be passed to logging facade methods in any number as
+/// trailing arguments. For example:
+///     logger.log(0, "{} {}", method, path, attr("status", 200), attr("uri", uri));
+///
+/// \tparam T must be convertible to `attribute::view_t`.
+template<typename T>
+constexpr auto attr(const string_view& name, const T& value) noexcept -> attr_t<T> {
+    return attr_t<T>{name, value};
+}
+
 /// Internal details. Please move along, nothing to see here.
 namespace detail {
 namespace gcc {
@@ -58,6 +83,179 @@ struct last_of<T, U, Tail...> {
 template<typename... Args>
 struct with_attributes : public std::is_same<typename last_of<Args...>::type, attribute_list> {};
 
+/// Checks whether the given logger accepts events with the specified severity before doing any
+/// message formatting.
+///
+/// Loggers providing `enabled(severity) -> bool` method, like the root logger, are asked directly,
+/// all others are assumed to accept every event.
+template<typename Logger>
+inline auto enabled(const Logger& log, int severity, int) -> decltype(log.enabled(severity)) {
+    return log.enabled(severity);
+}
+
+template<typename Logger>
+inline auto enabled(const Logger&, int, long) -> bool {
+    return true;
+}
+
+template<typename T>
+struct is_attr : public std::false_type {};
+
+template<typename T>
+struct is_attr<attr_t<T>> : public std::true_type {};
+
+/// Helper metafunction that counts typed attributes at the end of the given variadic pack.
+///
+/// For example:
+///     typed_count<int, attr_t<int>, attr_t<double>>::value -> 2.
+///     typed_count<attr_t<int>, int>::value                 -> 0.
+template<typename... Args>
+struct typed_count : public std::integral_constant<std::size_t, 0> {};
+
+template<typename T, typename... Tail>
+struct typed_count<T, Tail...> : public std::integral_constant<std::size_t,
+    is_attr<T>::value && typed_count<Tail...>::value == sizeof...(Tail) ?
+        1 + sizeof...(Tail) :
+        typed_count<Tail...>::value>
+{};
+
+/// Helper metafunction that determines whether the last parameter from given variadic pack is a
+/// typed attribute.
+template<typename... Args>
+struct with_typed_attributes : public std::integral_constant<bool, typed_count<Args...>::value != 0> {};
+
+/// Compile-time sequence of indices, required until C++14.
+template<std::size_t... I>
+struct indices_t {};
+
+/// Makes indices from `From` up to `To` exclusively.
+template<std::size_t From, std::size_t To, std::size_t... I>
+struct make_indices : public make_indices<From, To - 1, To - 1, I...> {};
+
+template<std::size_t From, std::size_t... I>
+struct make_indices<From, From, I...> {
+    typedef indices_t<I...> type;
+};
+
+/// Message supplier formatting the pattern with the given arguments into the writer on demand.
+///
+/// Holds everything by reference, so it can be referenced by `lazy_message_t` without any
+/// allocation.
+template<typename... Args>
+class formatted_t {
+    fmt::MemoryWriter& wr;
+    const char* pattern;
+    std::tuple<const Args&...> args;
+
+public:
+    formatted_t(fmt::MemoryWriter& wr, const char* pattern, const Args&... args) noexcept :
+        wr(wr),
+        pattern(pattern),
+        args(args...)
+    {}
+
+    auto operator()() const -> string_view {
+        return apply(typename make_indices<0, sizeof...(Args)>::type());
+    }
+
+private:
+    template<std::size_t... I>
+    auto apply(indices_t<I...>) const -> string_view {
+        return gcc::write_all(wr, pattern, std::get<I>(args)...);
+    }
+};
+
+/// Materializes typed attributes into views only after the event has been accepted by the
+/// severity check, formatting the message lazily using the leading arguments if any.
+///
+/// \overload for no formatting arguments.
+template<typename Logger, typename Tuple, std::size_t... A>
+inline auto log_typed(Logger& log, int severity, const string_view& pattern, const Tuple& args,
+    indices_t<>, indices_t<A...>) -> void
+{
+    const attribute_list attributes{{std::get<A>(args).name, attribute::view_t(std::get<A>(args).value)}...};
+
+    attribute_pack pack{attributes};
+    log.log(severity, pattern, pack);
+}
+
+template<typename Logger, typename Tuple, std::size_t... F, std::size_t... A>
+inline auto log_typed(Logger& log, int severity, const string_view& pattern, const Tuple& args,
+    indices_t<F...>, indices_t<A...>) -> void
+{
+    const attribute_list attributes{{std::get<A>(args).name, attribute::view_t(std::get<A>(args).value)}...};
+
+    // Arguments are stored by references, so they must not decay, otherwise arrays would bind to
+    // temporary pointers.
+    fmt::MemoryWriter wr;
+    const formatted_t<
+        typename std::remove_reference<typename std::tuple_element<F, Tuple>::type>::type...
+    > fn(wr, pattern.data(), std::get<F>(args)...);
+
+    attribute_pack pack{attributes};
+    log.log(severity, {pattern, fn}, pack);
+}
+
+/// Number of trailing arguments carrying attributes, which is either one for an attribute list
+/// or the number of typed attributes.
+template<typename... Args>
+struct attributes_count : public std::integral_constant<std::size_t,
+    with_attributes<Args...>::value ? 1 : typed_count<Args...>::value>
+{};
+
+template<>
+struct attributes_count<> : public std::integral_constant<std::size_t, 0> {};
+
+/// Message supplier formatting the given arguments using the pattern split at compile time.
+template<typename Pattern, typename Tuple, typename Indices>
+class precompiled_t;
+
+template<typename Pattern, typename Tuple, std::size_t... I>
+class precompiled_t<Pattern, Tuple, indices_t<I...>> {
+    fmt::MemoryWriter& wr;
+    const Pattern& pattern;
+    const Tuple& args;
+
+public:
+    precompiled_t(fmt::MemoryWriter& wr, const Pattern& pattern, const Tuple& args) noexcept :
+        wr(wr),
+        pattern(pattern),
+        args(args)
+    {}
+
+    auto operator()() const -> string_view {
+        pattern.format(wr, std::get<I>(args)...);
+        return {wr.data(), wr.size()};
+    }
+};
+
+/// Logs using the pattern split at compile time, formatting the message using the arguments at the
+/// given indices lazily.
+///
+/// \overload for no formatting arguments, which logs the pattern as is.
+template<typename Logger, typename Pattern, typename Tuple>
+inline auto log_compiled(Logger& log, int severity, const Pattern& pattern, const Tuple&,
+    indices_t<>, attribute_pack& pack) -> void
+{
+    log.log(severity, pattern.pattern(), pack);
+}
+
+template<typename Logger, typename Pattern, typename Tuple, std::size_t... F>
+inline auto log_compiled(Logger& log, int severity, const Pattern& pattern, const Tuple& args,
+    indices_t<F...>, attribute_pack& pack) -> void
+{
+    fmt::MemoryWriter wr;
+    const precompiled_t<Pattern, Tuple, indices_t<F...>> fn(wr, pattern, args);
+
+    log.log(severity, {pattern.pattern(), fn}, pack);
+}
+
+/// Materializes typed attributes at the given indices into views.
+template<typename Tuple, std::size_t... A>
+inline auto typed_list(const Tuple& args, indices_t<A...>) -> attribute_list {
+    return {{std::get<A>(args).name, attribute::view_t(std::get<A>(args).value)}...};
+}
+
 template<typename... Args>
 struct dummy_t {};
 
@@ -87,10 +285,10 @@ struct select_t {
         const attribute_list& attributes) -> void
     {
         fmt::MemoryWriter wr;
-        const auto fn = std::bind(&gcc::write_all<Args...>, std::ref(wr), pattern.data(), std::cref(args)...);
+        const formatted_t<Args...> fn(wr, pattern.data(), args...);
 
         attribute_pack pack{attributes};
-        log.log(severity, {pattern, std::cref(fn)}, pack);
+        log.log(severity, {pattern, fn}, pack);
     }
 };
 
@@ -90,6 +90,33 @@ literal_count(const string_view& format) {
     return result;
 }
 
+/// Returns the number of placeholders in the given format, which is the number of arguments it
+/// requires.
+constexpr
+std::size_t
+placeholder_count(const string_view& format) {
+    std::size_t result = 0;
+
+    for (std::size_t id = 0; id < format.size(); ++id) {
+        if (format[id] == '{') {
+            if (++id >= format.size()) {
+                throw std::out_of_range("unmatched '{' in format");
+            }
+
+            if (format[id] != '{') {
+                id += ::parse_argument(format, id) - 2;
+                ++result;
+            }
+        } else if (format[id] == '}') {
+            if (++id >= format.size() || format[id] != '}') {
+                throw std::out_of_range("single '}' encountered in format string");
+            }
+        }
+    }
+
+    return result;
+}
+
 }  // namespace detail
 }  // namespace v1
 }  // namespace blackhole
@@ -196,6 +223,19 @@ public:
         }
     }
 
+    /// Returns the whole format string this formatter was constructed from.
+    constexpr
+    string_view
+    pattern() const {
+        return {literal.data.data(), static_cast<std::size_t>(next.end() - literal.data.data())};
+    }
+
+    constexpr
+    const char*
+    end() const {
+        return next.end();
+    }
+
     template<class Stream>
     Stream&
     repr(Stream& stream) const {
@@ -228,6 +268,18 @@ public:
         writer << fmt::StringRef(literal.data.data(), literal.data.size());
     }
 
+    constexpr
+    string_view
+    pattern() const {
+        return literal.data;
+    }
+
+    constexpr
+    const char*
+    end() const {
+        return literal.data.data() + literal.data.size();
+    }
+
     template<class Stream>
     Stream&
     repr(Stream& stream) const {
@@ -236,6 +288,40 @@ public:
     }
 };
 
+/// Format string split into literals at compile time, which also carries the number of its
+/// placeholders, allowing to check the number of logging arguments at compile time.
+///
+/// Meant to be constructed using `BH_PATTERN` macro.
+template<std::size_t N, std::size_t Arity>
+class pattern_t {
+    const formatter<N> inner;
+
+public:
+    static constexpr std::size_t arity = Arity;
+
+    constexpr
+    pattern_t(const string_view& format) :
+        inner(format)
+    {}
+
+    /// Returns the original format string.
+    constexpr
+    string_view
+    pattern() const {
+        return inner.pattern();
+    }
+
+    template<typename... Args>
+    void
+    format(fmt::MemoryWriter& writer, const Args&... args) const {
+        static_assert(sizeof...(Args) == Arity, "argument count mismatch");
+        inner.format(writer, args...);
+    }
+};
+
+template<std::size_t N, std::size_t Arity>
+constexpr std::size_t pattern_t<N, Arity>::arity;
+
 }  // namespace detail
 
 // NOTE: We are ready for C++17, but our compilers aren't!
@@ -262,4 +348,21 @@ public:
 }  // namespace v1
 }  // namespace blackhole
 
+/// Splits the given string literal pattern into literals at compile time, for example:
+///     logger.log(0, BH_PATTERN("{} - {} 'GET {}'"), host, user, path, attr("status", 200));
+///
+/// Logging facade accepts such patterns in all its `log` overloads, rejecting calls with the number
+/// of formatting arguments not matching the number of placeholders at compile time, while filters
+/// still see the original pattern.
+///
+/// \note only `{}` placeholders are supported, malformed patterns fail to compile.
+#define BH_PATTERN(pattern)                                                                        \
+    ([]() -> const auto& {                                                                         \
+        static constexpr ::blackhole::detail::pattern_t<                                           \
+            ::blackhole::detail::literal_count(pattern),                                           \
+            ::blackhole::detail::placeholder_count(pattern)                                        \
+        > result(pattern);                                                                         \
+        return result;                                                                             \
+    }())
+
 #endif
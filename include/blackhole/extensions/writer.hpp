@@ -1,5 +1,11 @@
 #pragma once
 
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <utility>
+#include <vector>
+
 #include "blackhole/stdext/string_view.hpp"
 #include "blackhole/extensions/format.hpp"
 
@@ -8,10 +14,88 @@ inline namespace v1 {
 
 using stdext::string_view;
 
+namespace detail {
+
+/// Memory buffer, which stores data either in its small inline array, in the heap or in a region
+/// lent by its owner, moving data to the heap once the current storage is exhausted.
+class membuf_t : public fmt::Buffer<char> {
+    char storage[fmt::internal::INLINE_BUFFER_SIZE];
+
+    std::unique_ptr<char[]> heap;
+    std::size_t reserved;
+
+    /// Region lent by its owner, which is used until either outgrown or released.
+    char* region;
+
+public:
+    membuf_t() noexcept :
+        fmt::Buffer<char>(storage, sizeof(storage)),
+        reserved(0),
+        region(nullptr)
+    {}
+
+    /// Discards data, continuing in the given region.
+    auto lend(char* data, std::size_t size) noexcept -> void {
+        region = data;
+        ptr_ = data;
+        size_ = 0;
+        capacity_ = size;
+    }
+
+    /// Checks whether the data is still in the lent region.
+    auto lent() const noexcept -> bool {
+        return region != nullptr && ptr_ == region;
+    }
+
+    /// Discards data if it is in the lent region, returning to the own storage.
+    auto release() noexcept -> void {
+        if (lent()) {
+            ptr_ = heap ? heap.get() : storage;
+            size_ = 0;
+            capacity_ = heap ? reserved : sizeof(storage);
+        }
+
+        region = nullptr;
+    }
+
+protected:
+    void grow(std::size_t size) override {
+        const auto capacity = std::max(capacity_ + capacity_ / 2, size);
+
+        std::unique_ptr<char[]> memory(new char[capacity]);
+        std::memcpy(memory.get(), ptr_, size_);
+
+        heap = std::move(memory);
+        reserved = capacity;
+        ptr_ = heap.get();
+        capacity_ = capacity;
+    }
+};
+
+/// Memory writer over the buffer above, providing the same interface as `fmt::MemoryWriter`.
+class memory_writer_t : public fmt::BasicWriter<char> {
+    membuf_t buf;
+
+public:
+    memory_writer_t() :
+        fmt::BasicWriter<char>(buf)
+    {}
+
+    auto buffer() noexcept -> membuf_t& {
+        return buf;
+    }
+
+    auto buffer() const noexcept -> const membuf_t& {
+        return buf;
+    }
+};
+
+}  // namespace detail
+
 /// Represents stream writer backed up by cppformat.
 class writer_t {
 public:
-    fmt::MemoryWriter inner;
+    detail::memory_writer_t inner;
 
     /// Formats the given arguments using the underlying formatter.
     template<typename... Args>
@@ -19,9 +103,114 @@ public:
         inner.write(args...);
     }
 
+    /// Returns the data written into the buffer.
+    ///
+    /// \warning the referenced data is not included, use `slices` if there is any.
     auto result() const noexcept -> string_view {
         return string_view(inner.data(), inner.size());
     }
+
+    /// Enables referencing strings of at least the given size instead of copying them, which is
+    /// disabled by the zero value.
+    ///
+    /// Referenced strings must outlive emitting the formatted record, so handlers enable this only
+    /// if they emit records synchronously while the records are alive.
+    auto gather(std::size_t threshold) noexcept -> void {
+        this->threshold = threshold;
+    }
+
+    /// Writes the given string as is, referencing it instead of copying if it's at least the
+    /// gathering threshold long.
+    ///
+    /// Strings are always copied into lent regions, since they must hold the whole record.
+    auto reference(const string_view& data) -> void {
+        if (threshold == 0 || data.size() < threshold || lent()) {
+            inner << fmt::StringRef(data.data(), data.size());
+        } else {
+            references.emplace_back(inner.size(), data);
+        }
+    }
+
+    /// Checks whether any string is referenced.
+    auto referenced() const noexcept -> bool {
+        return !references.empty();
+    }
+
+    /// Returns the total size of the formatted record including the referenced data.
+    auto length() const noexcept -> std::size_t {
+        auto size = inner.size();
+        for (const auto& reference : references) {
+            size += reference.second.size();
+        }
+
+        return size;
+    }
+
+    /// Appends non-empty slices of the formatted record into the given vector, interleaving the
+    /// data written into the buffer with the referenced one.
+    auto slices(std::vector<string_view>& result) const -> void {
+        std::size_t position = 0;
+
+        for (const auto& reference : references) {
+            if (reference.first > position) {
+                result.emplace_back(inner.data() + position, reference.first - position);
+            }
+
+            result.push_back(reference.second);
+            position = reference.first;
+        }
+
+        if (inner.size() > position) {
+            result.emplace_back(inner.data() + position, inner.size() - position);
+        }
+    }
+
+    /// Marks the record being formatted as the one that must not be emitted, which handlers check
+    /// after formatting, so formatters can reject records without throwing.
+    auto skip(bool value = true) noexcept -> void {
+        skipping = value;
+    }
+
+    /// Returns whether the formatted record must not be emitted.
+    auto skipped() const noexcept -> bool {
+        return skipping;
+    }
+
+    /// Discards the written data, continuing to write into the given region lent by a sink, so
+    /// that the formatted record requires no copying to be emitted.
+    ///
+    /// Writing more than the region holds moves the data into the writer own memory.
+    auto lend(char* data, std::size_t size) noexcept -> void {
+        inner.buffer().lend(data, size);
+    }
+
+    /// Checks whether the whole written data is in the lent region.
+    auto lent() const noexcept -> bool {
+        return inner.buffer().lent();
+    }
+
+    /// Gives the lent region back, discarding the data written into it.
+    auto release() noexcept -> void {
+        inner.buffer().release();
+    }
+
+    /// Discards the written data together with references, making the writer ready for the next
+    /// record with gathering disabled.
+    auto reset() noexcept -> void {
+        inner.clear();
+        references.clear();
+        skipping = false;
+        threshold = 0;
+    }
+
+private:
+    bool skipping = false;
+
+    /// Gathering threshold, zero if disabled.
+    std::size_t threshold = 0;
+
+    /// Referenced strings together with their positions in the buffer.
+    std::vector<std::pair<std::size_t, string_view>> references;
 };
 
 }  // namespace v1
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "blackhole/factory.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace filter {
+
+class callsite_t;
+
+}  // namespace filter
+
+/// Creates call site filters with the "default" decision, which is true if omitted, and "rules"
+/// array of objects with "match" substring of patterns and "enabled" flag, where later rules take
+/// precedence. For example:
+///     {"type": "callsite", "default": false, "rules": [{"match": "cache miss", "enabled": true}]}
+///
+/// \throw std::invalid_argument if a rule has no "match" field.
+template<>
+class factory<filter::callsite_t> : public factory<filter_t> {
+public:
+    auto type() const noexcept -> const char* override;
+    auto from(const config::node_t& config) const -> std::unique_ptr<filter_t> override;
+};
+
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "blackhole/factory.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace filter {
+
+class dedup_t;
+
+}  // namespace filter
+
+/// Creates deduplicating filters, which suppress records with the same formatted message, pattern
+/// and values of the attributes listed in the "attributes" array, repeated within "window"
+/// milliseconds, which is 1000 by default.
+///
+/// Blocking handlers emit "last message repeated N times" summaries into the sink of this filter.
+///
+/// \throw std::invalid_argument if the window is zero.
+template<>
+class factory<filter::dedup_t> : public factory<filter_t> {
+public:
+    auto type() const noexcept -> const char* override;
+    auto from(const config::node_t& config) const -> std::unique_ptr<filter_t> override;
+};
+
+}  // namespace v1
+}  // namespace blackhole
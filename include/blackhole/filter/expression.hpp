@@ -0,0 +1,39 @@
+#pragma once
+
+#include "blackhole/factory.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace filter {
+
+class expression_t;
+
+}  // namespace filter
+
+/// Creates filters from boolean expressions over record fields and attributes, given as the
+/// "expression" field.
+///
+/// Expressions consist of comparisons combined by `&&`, `||` and `!` operators with parentheses,
+/// for example:
+///     severity >= 3 || (component == "db" && latency_ms > 100)
+///
+/// Operands are integer, floating point, string and boolean literals, the `severity` and `message`
+/// record fields and attributes referred to by name. A bare attribute name checks its presence.
+/// Comparisons with missing attributes or values of incompatible types are false.
+///
+/// Severity is compared as a number, since its names are defined by the application. Comparing it
+/// with a bare name, like `severity >= warn`, is rejected rather than treated as a comparison with
+/// the `warn` attribute, which is almost certainly a mistake. An attribute holding a severity can
+/// still be compared with it when its name is backquoted, for example:
+///     severity >= `level`
+///
+/// \throw std::invalid_argument if the expression is missing or malformed.
+template<>
+class factory<filter::expression_t> : public factory<filter_t> {
+public:
+    auto type() const noexcept -> const char* override;
+    auto from(const config::node_t& config) const -> std::unique_ptr<filter_t> override;
+};
+
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "blackhole/factory.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace filter {
+
+class limit_t;
+
+}  // namespace filter
+
+/// Creates rate limiting filters, which pass at most "rate" records per second for each call site
+/// or each value of the "attribute" field if specified, allowing bursts of up to "burst" records,
+/// which is 1 by default.
+///
+/// Blocking handlers emit summaries of records suppressed by this filter into its sink at most
+/// once per "interval" milliseconds, which is 1000 by default.
+///
+/// \throw std::invalid_argument if the rate is missing or either the rate or burst is not
+///     positive.
+template<>
+class factory<filter::limit_t> : public factory<filter_t> {
+public:
+    auto type() const noexcept -> const char* override;
+    auto from(const config::node_t& config) const -> std::unique_ptr<filter_t> override;
+};
+
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "blackhole/factory.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace filter {
+
+class sample_t;
+
+}  // namespace filter
+
+/// Creates sampling filters, which pass every "every"-th record for each call site or each value
+/// of the "attribute" field if specified, keeping sampled records with the given "probability".
+///
+/// Blocking handlers emit summaries of records suppressed by this filter into its sink at most
+/// once per "interval" milliseconds, which is 1000 by default.
+///
+/// \throw std::invalid_argument if neither the period nor probability is specified or they are
+///     out of range.
+template<>
+class factory<filter::sample_t> : public factory<filter_t> {
+public:
+    auto type() const noexcept -> const char* override;
+    auto from(const config::node_t& config) const -> std::unique_ptr<filter_t> override;
+};
+
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "blackhole/factory.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace filter {
+
+class traced_t;
+
+}  // namespace filter
+
+/// Creates trace sampling filters keeping the given "rate" fraction of traces, identified by the
+/// inline trace context or by the value of the "attribute" field if specified. Records without a
+/// trace id are kept unless the "untraced" flag is false. The "severities" array overrides the rate
+/// for records of at least the given severity, for example:
+///     {"type": "traced", "rate": 0.01, "severities": [{"threshold": 3, "rate": 1.0}]}
+///
+/// \throw std::invalid_argument if the rate is missing or any rate is out of [0; 1] range.
+template<>
+class factory<filter::traced_t> : public factory<filter_t> {
+public:
+    auto type() const noexcept -> const char* override;
+    auto from(const config::node_t& config) const -> std::unique_ptr<filter_t> override;
+};
+
+}  // namespace v1
+}  // namespace blackhole
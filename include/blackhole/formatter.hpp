@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstddef>
+
 namespace blackhole {
 inline namespace v1 {
 
@@ -21,6 +23,27 @@ public:
     /// Formats the specified logging event record by invoking formatter renderers and writing the
     /// result into the given writer.
     virtual auto format(const record_t& record, writer_t& writer) -> void = 0;
+
+    /// Formats the given contiguous batch of records one after another into the given writer.
+    ///
+    /// On return the i-th formatted record occupies the writer result between `offsets[i]` and
+    /// `offsets[i + 1]`, so there must be room for `size + 1` offsets. Records rejected by the
+    /// formatter are marked in `skipped` and left empty.
+    ///
+    /// Formatters able to hoist per-record work out of the loop, like picking the compiled program
+    /// or thread-local caches lookup, should override this method. The default implementation just
+    /// calls `format` for each record.
+    ///
+    /// Offsets must be stored in order before formatting each record, so that callers can tell the
+    /// failed record by the last stored one when an exception interrupts the batch.
+    virtual auto format_batch(const record_t* records, std::size_t size, writer_t& writer,
+        std::size_t* offsets, bool* skipped) -> void;
+
+    /// Returns the expected size of the given record formatted, which handlers use for reserving
+    /// output memory, like regions lent by sinks.
+    ///
+    /// The default implementation expects the formatted message followed by a hundred bytes.
+    virtual auto estimate(const record_t& record) const -> std::size_t;
 };
 
 }  // namespace v1
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <memory>
+
+#include "../factory.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace formatter {
+
+/// The binary formatter encodes records with all their attributes in the native binary form, which
+/// keeps the formatting work off the logging path and defers it until the records are read.
+///
+/// Each record is encoded by `sink::ring::encode`, like the shared memory sink "binary" format
+/// does, and is prefixed with a frame header carrying both its size and CRC32 checksum, see
+/// `detail::formatter::binary::frame_t`. Frames are self-delimiting, so they can be written by any
+/// sink, including line-oriented ones appending newlines, and turned back into text or JSON using
+/// any formatter with `decoder_t` or the `blackhole-decode` tool.
+///
+/// Function attribute values are formatted during encoding. The encoding uses the native byte
+/// order and layout, so files must be decoded on the same architecture.
+class binary_t;
+
+}  // namespace formatter
+
+template<>
+class builder<formatter::binary_t> {
+public:
+    auto build() && -> std::unique_ptr<formatter_t>;
+};
+
+template<>
+class factory<formatter::binary_t> : public factory<formatter_t> {
+public:
+    auto type() const noexcept -> const char* override;
+    auto from(const config::node_t& config) const -> std::unique_ptr<formatter_t> override;
+};
+
+}  // namespace v1
+}  // namespace blackhole
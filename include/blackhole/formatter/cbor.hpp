@@ -0,0 +1,77 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../factory.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace formatter {
+
+/// The CBOR formatter encodes records as CBOR maps, which are both smaller and faster to produce
+/// than JSON trees, see https://tools.ietf.org/html/rfc7049.
+///
+/// Attributes routing, renaming, filtering and mutations are configured the same way as for the
+/// JSON formatter and produce the same tree as its streaming mode does. Records are written
+/// directly into the writer without building any intermediate document.
+///
+/// Integers are written using the shortest argument form, doubles are always written as 64-bit
+/// floats and text strings are always valid UTF-8, i.e. each byte of invalid sequences is
+/// replaced with U+FFFD replacement character.
+///
+/// For example:
+///     auto formatter = builder<cbor_t>()
+///         .route("/fields", {"message", "severity", "timestamp"})
+///         .rename("message", "@message")
+///         .unique()
+///         .build();
+class cbor_t;
+
+}  // namespace formatter
+
+template<>
+class builder<formatter::cbor_t> {
+    class inner_t;
+    std::unique_ptr<inner_t, deleter_t> d;
+
+public:
+    builder();
+
+    /// Configures attribute routing for all not mentioned attributes.
+    auto route(std::string route) & -> builder&;
+    auto route(std::string route) && -> builder&&;
+
+    /// Configures attribute routing for the given set of attributes, see
+    /// `builder<json_t>::route` for details.
+    auto route(std::string route, std::vector<std::string> attributes) & -> builder&;
+    auto route(std::string route, std::vector<std::string> attributes) && -> builder&&;
+
+    auto rename(std::string from, std::string to) & -> builder&;
+    auto rename(std::string from, std::string to) && -> builder&&;
+
+    auto unique() & -> builder&;
+    auto unique() && -> builder&&;
+
+    /// Sets severity mapping array.
+    auto severity(std::vector<std::string> sevmap) & -> builder&;
+    auto severity(std::vector<std::string> sevmap) && -> builder&&;
+
+    /// Replaces integral timestamps in microseconds with strings formatted using the given pattern.
+    auto timestamp(const std::string& pattern) & -> builder&;
+    auto timestamp(const std::string& pattern) && -> builder&&;
+
+    /// \throw std::invalid_argument if any of routes is not a valid JSON pointer.
+    auto build() && -> std::unique_ptr<formatter_t>;
+};
+
+template<>
+class factory<formatter::cbor_t> : public factory<formatter_t> {
+public:
+    auto type() const noexcept -> const char* override;
+    auto from(const config::node_t& config) const -> std::unique_ptr<formatter_t> override;
+};
+
+}  // namespace v1
+}  // namespace blackhole
@@ -31,6 +31,9 @@ namespace formatter {
 ///     "ip": "[::]"
 /// }
 ///
+/// Records carrying a trace context additionally contain "trace_id" and "span_id" hex strings,
+/// which can be routed and renamed like other builtin attributes.
+///
 /// Using configuration parameters for this formatter you can:
 /// - Rename parameters.
 /// - Construct hierarchical tree using a standardized JSON pointer API. For more information please
@@ -68,6 +71,14 @@ namespace formatter {
 /// Also formatter allows to automatically append a newline character at the end of the tree, which
 /// is strangely required by some consumers, like logstash.
 ///
+/// By default the formatter produces the output of an intermediate JSON document for each record.
+/// Output skeletons of each severity are precomputed at build time, so records are written by
+/// filling their slots unless some of attributes are routed to objects holding no builtin fields,
+/// which requires the document to be built. This can be avoided by enabling streaming mode, in
+/// which the output layout is precomputed at build time and records are written directly into the
+/// output buffer. The only difference is the order of nested objects, see
+/// `builder<json_t>::streaming` for details.
+///
 /// Note, that JSON formatter formats the tree using compact style without excess spaces, tabs etc.
 ///
 /// For convenient formatter construction a special builder class is implemented allowing to create
@@ -120,6 +131,20 @@ public:
 
     auto newline() & -> builder&;
     auto newline() && -> builder&&;
+
+    /// Enables streaming mode.
+    ///
+    /// In this mode the output object layout is precomputed from the routing configuration at
+    /// build time and records are written directly into the writer without building a JSON
+    /// document, which is significantly faster.
+    ///
+    /// Members of each object are written first followed by its nested objects in the order of
+    /// their routes, regardless of the order attributes are met, while the document-based mode
+    /// places nested objects at the position of their first insertion.
+    ///
+    /// \throw std::invalid_argument on build if any of routes is not a valid JSON pointer.
+    auto streaming() & -> builder&;
+    auto streaming() && -> builder&&;
     // TODO: auto mutate(...) -> builder&;
 
     /// Sets severity mapping array.
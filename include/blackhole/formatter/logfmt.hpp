@@ -0,0 +1,75 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "../factory.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace formatter {
+
+/// The logfmt formatter writes records as space separated `key=value` pairs, which is the format
+/// understood by Loki, Heroku and many other log processing tools.
+///
+/// Reserved fields go first in the following order: timestamp, severity, message, process and
+/// thread, followed by all attributes of a record in the order they were provided. For example:
+///     timestamp=2014-02-23T12:20:30.000042Z severity=2 message="GET /porn.png" process=42
+///     thread=0x7f4e9b4bb700 status=200 path=/porn.png
+///
+/// Keys of reserved fields can be renamed, i.e. to "ts", "level" and "msg" commonly used by Loki.
+/// Key characters that are not allowed by logfmt, i.e. spaces, control characters, equal signs and
+/// quotes, are replaced by underscores.
+///
+/// String values are written as is unless they contain any of whitespace, control, equal sign,
+/// quote, backslash or non-ASCII characters, in which case they are quoted and escaped using the
+/// same rules as JSON strings do. Empty values are written as nothing after the equal sign.
+///
+/// # Performance
+///
+/// Keys of reserved fields and severity mappings are escaped during construction. All fields are
+/// written directly into the writer without intermediate buffers, while whether a value requires
+/// quoting is determined by a single vectorized scan.
+class logfmt_t;
+
+}  // namespace formatter
+
+template<>
+class builder<formatter::logfmt_t> {
+    class inner_t;
+    std::unique_ptr<inner_t, deleter_t> d;
+
+public:
+    builder();
+
+    /// Renames the given reserved field, which is one of "timestamp", "severity", "message",
+    /// "process" and "thread".
+    ///
+    /// \throw std::invalid_argument on build if the field is not a reserved one.
+    auto rename(std::string from, std::string to) & -> builder&;
+    auto rename(std::string from, std::string to) && -> builder&&;
+
+    /// Sets severity mapping array, severities out of its range are written as integers.
+    auto severity(std::vector<std::string> sevmap) & -> builder&;
+    auto severity(std::vector<std::string> sevmap) && -> builder&&;
+
+    /// Sets the timestamp pattern using UTC time, `%Y-%m-%dT%H:%M:%S.%fZ` by default.
+    auto timestamp(std::string pattern) & -> builder&;
+    auto timestamp(std::string pattern) && -> builder&&;
+
+    /// Enables filtering of attributes with duplicate names, keeping the most recent ones.
+    auto unique() & -> builder&;
+    auto unique() && -> builder&&;
+
+    auto build() && -> std::unique_ptr<formatter_t>;
+};
+
+template<>
+class factory<formatter::logfmt_t> : public factory<formatter_t> {
+public:
+    auto type() const noexcept -> const char* override;
+    auto from(const config::node_t& config) const -> std::unique_ptr<formatter_t> override;
+};
+
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../factory.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace formatter {
+
+/// The OTLP formatter encodes records as OpenTelemetry `LogRecord` protobuf messages, see
+/// https://github.com/open-telemetry/opentelemetry-proto/blob/main/opentelemetry/proto/logs/v1.
+///
+/// Each formatted record is the serialized message itself without any framing, so records can be
+/// batched into `ResourceLogs` envelopes just by prefixing them with their field key and length,
+/// which is what the OTLP sink does.
+///
+/// The record timestamp is written as `time_unix_nano`, the message as a string `body`, while the
+/// process id, the thread id and all attributes are written as `attributes` with `process.pid`
+/// and `thread.id` keys for the former ones. Unsigned integers exceeding the signed range are
+/// written as strings, and all strings are replaced with valid UTF-8, as protobuf requires.
+///
+/// The record trace context, if any, is written as `trace_id` and `span_id` bytes.
+///
+/// Severities are mapped to both `severity_text` and `severity_number` using the severity mapping
+/// array, which is `{"DEBUG", "INFO", "WARN", "ERROR"}` by default. Numbers are deduced from
+/// OpenTelemetry short names, i.e. "TRACE", "DEBUG", "INFO", "WARN", "ERROR" and "FATAL",
+/// optionally followed by a digit from 2 to 4. Severities out of the mapping range are written as
+/// the decimal text with unspecified number.
+///
+/// The message is encoded directly into the writer without building any protobuf object, so no
+/// allocation occurs for attributes of the common types.
+class otlp_t;
+
+}  // namespace formatter
+
+template<>
+class builder<formatter::otlp_t> {
+    class inner_t;
+    std::unique_ptr<inner_t, deleter_t> d;
+
+public:
+    builder();
+
+    /// Sets severity mapping array, see `otlp_t` for details.
+    auto severity(std::vector<std::string> sevmap) & -> builder&;
+    auto severity(std::vector<std::string> sevmap) && -> builder&&;
+
+    /// Enables filtering of attributes with duplicate names, keeping the most recent ones.
+    auto unique() & -> builder&;
+    auto unique() && -> builder&&;
+
+    auto build() && -> std::unique_ptr<formatter_t>;
+};
+
+template<>
+class factory<formatter::otlp_t> : public factory<formatter_t> {
+public:
+    auto type() const noexcept -> const char* override;
+    auto from(const config::node_t& config) const -> std::unique_ptr<formatter_t> override;
+};
+
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <utility>
+
+#include "blackhole/formatter.hpp"
+#include "blackhole/formatter/string.hpp"
+
+#include "blackhole/detail/formatter/string/pattern.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace formatter {
+
+/// String formatter with the pattern parsed at compile time.
+///
+/// The pattern follows the same syntax as the one of `string_t` and is passed using the
+/// `BLACKHOLE_PATTERN` macro, for example:
+///
+///     formatter::pattern_t<BLACKHOLE_PATTERN("{timestamp} {severity}: {message}")> formatter;
+///
+/// Formatting is unrolled into a sequence of statically dispatched placeholders, with literals
+/// written as compile-time constants, which leaves no tokens to interpret at runtime. Malformed
+/// patterns fail to compile.
+///
+/// \note the leftover placeholder is not supported, use `string_t` for such patterns.
+template<typename Pattern>
+class pattern_t final : public formatter_t {
+    typedef typename detail::formatter::string::pattern::parse<
+        detail::formatter::string::pattern::tokens<>,
+        detail::formatter::string::pattern::chars<>,
+        Pattern
+    >::type tokens_type;
+
+    severity_map sevmap;
+
+public:
+    pattern_t() = default;
+
+    /// Constructs the formatter, which uses the given severity mapping for severity placeholders
+    /// without `:d` type.
+    explicit pattern_t(severity_map sevmap) :
+        sevmap(std::move(sevmap))
+    {}
+
+    auto format(const record_t& record, writer_t& writer) -> void override {
+        tokens_type::format(record, writer, sevmap);
+    }
+};
+
+}  // namespace formatter
+}  // namespace v1
+}  // namespace blackhole
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <functional>
+#include <string>
+#include <vector>
 
 #include "../factory.hpp"
 
@@ -17,6 +19,16 @@ namespace formatter {
 /// \param writer result writer.
 typedef std::function<void(int severity, const std::string& spec, writer_t& writer)> severity_map;
 
+/// Policy of rendering required placeholders of attributes missing in the record.
+enum class missing_t {
+    /// Throws `std::logic_error`, which drops the record with an error report, the default.
+    throws,
+    /// Renders the fallback literal as is instead of the attribute.
+    fallback,
+    /// Stops formatting and marks the record as skipped, so handlers drop it silently.
+    skip
+};
+
 /// The string formatter is responsible for effective converting the given record to a string using
 /// precompiled pattern and options.
 ///
@@ -49,8 +61,9 @@ typedef std::function<void(int severity, const std::string& spec, writer_t& writ
 /// For more information see \ref http://cppformat.github.io/latest/syntax.html resource.
 ///
 /// With a few predefined exceptions the formatter supports all userspace attributes. The exceptions
-/// are: message, severity, timestamp, process and thread. For these attributes there are special
-/// rules and it's impossible to override then even with the same name attribute.
+/// are: message, severity, timestamp, process, host, thread, trace_id and span_id. For these
+/// attributes there are special rules and it's impossible to override then even with the same name
+/// attribute.
 ///
 /// For message attribute there are no special rules. It's still allowed to extend the specification
 /// using fill, align and other specifiers.
@@ -68,13 +81,25 @@ typedef std::function<void(int severity, const std::string& spec, writer_t& writ
 /// Process attribute can be represented as either an PID or process name using `:d` and `:s` types
 /// respectively: `{process:s}` and `{process:d}`.
 ///
+/// Host attribute is represented as the host name, or as the fully qualified domain name using the
+/// `fqdn` type, which may be followed by a regular specification: `{host}` and `{host:fqdn}`.
+///
+/// Process names, host names and process ids are rendered once when the formatter is constructed,
+/// merged into adjacent literals, so that a constant prefix of the pattern is written at once.
+/// Processes forked afterwards render their process id on each call.
+///
 /// At last the thread attribute can be formatted as either thread id in platform-independent hex
 /// representation by default or explicitly with `:s` type, thread id in platform-dependent way
 /// using `:d` type or as a thread name if specified, nil otherwise.
 ///
+/// Trace and span ids of the record trace context are rendered as 32 and 16 lowercase hex digits
+/// respectively, which are all zeros if there is no context: `{trace_id}` and `{span_id}`.
+///
 /// The formatter will throw an exception if an attribute name specified in pattern won't be found
 /// in the log record. Of course Blackhole catches this, but it results in dropping the entire
-/// message.
+/// message, paying for the exception and the error report.
+/// The missing attribute policy allows either to render a fallback literal instead or to skip such
+/// records silently, both of which cost nothing more than the attribute lookup.
 /// To avoid this the formatter supports optional generic attributes, which can be specified using
 /// the `optional_t` option with an optional prefix and suffix literals printed if an attribute
 /// exists.
@@ -110,6 +135,18 @@ public:
     auto mapping(formatter::severity_map sevmap) & -> builder&;
     auto mapping(formatter::severity_map sevmap) && -> builder&&;
 
+    /// Maps severities to the given names, which are rendered with specifications of severity
+    /// placeholders once while building, so that writing them is a copy. Severities without names
+    /// are formatted as numbers.
+    auto mapping(std::vector<std::string> names) & -> builder&;
+    auto mapping(std::vector<std::string> names) && -> builder&&;
+
+    /// Sets the policy of rendering required placeholders of missing attributes, with the literal
+    /// rendered by the fallback one.
+    auto missing(formatter::missing_t policy, std::string fallback = std::string()) & -> builder&;
+    auto missing(formatter::missing_t policy, std::string fallback = std::string()) && ->
+        builder&&;
+
     auto build() && -> std::unique_ptr<formatter_t>;
 };
 
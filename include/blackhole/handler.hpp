@@ -1,11 +1,18 @@
 #pragma once
 
+#include <chrono>
+#include <cstddef>
 #include <memory>
 
 namespace blackhole {
 inline namespace v1 {
 
 class record_t;
+struct pressure_t;
+
+namespace metrics {
+class collector_t;
+}  // namespace metrics
 
 /// Represents logging handler interface.
 class handler_t {
@@ -19,6 +26,38 @@ public:
     ///
     /// \warning must be thread-safe.
     virtual auto handle(const record_t& record) -> void = 0;
+
+    /// Handles the given records in order as a single batch.
+    ///
+    /// Handlers emitting to sinks should pass accepted records to each sink as a single batch, so
+    /// that sinks are able to write them at once. The default implementation handles records one
+    /// by one.
+    ///
+    /// \note an exception thrown while handling a record interrupts the whole batch.
+    /// \warning must be thread-safe.
+    virtual auto handle_batch(const record_t* records, std::size_t size) -> void;
+
+    /// Waits until all records handled before the call are emitted and flushed by sinks, but no
+    /// longer than until the given deadline, returning `false` on timeout.
+    ///
+    /// The default implementation does nothing and returns `true`.
+    ///
+    /// \warning must be thread-safe.
+    virtual auto flush(std::chrono::steady_clock::time_point deadline) -> bool;
+
+    /// Collects self-metrics of this handler and its sinks into the given collector.
+    ///
+    /// The default implementation collects nothing.
+    ///
+    /// \warning must be thread-safe.
+    virtual auto collect(metrics::collector_t& collector) const -> void;
+
+    /// Returns the congestion state of this handler and its sinks.
+    ///
+    /// The default implementation returns no pressure.
+    ///
+    /// \warning must be thread-safe.
+    virtual auto pressure() const -> pressure_t;
 };
 
 }  // namespace v1
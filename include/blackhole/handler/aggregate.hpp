@@ -0,0 +1,144 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../factory.hpp"
+#include "../handler.hpp"
+#include "../severity.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace handler {
+
+/// The aggregate handler derives metrics from records instead of passing them further, emitting
+/// aggregated values through the wrapped handler periodically.
+///
+/// Counters count records grouped by label values, histograms additionally distribute values of
+/// a numeric attribute between buckets. Labels are attribute values formatted as strings, where
+/// the "severity" label stands for the record severity, missing attributes give empty values.
+///
+/// Each emission produces one record per metric and label values combination seen since the
+/// previous one, with the metric name as its message. Its attributes are the labels followed by
+/// "count", and for histograms "sum" of observed values and cumulative bucket counts named like
+/// `le_10` after their upper bounds. Values are deltas over the interval, combinations without
+/// new records are not emitted.
+///
+/// # Performance
+///
+/// Each thread aggregates into its own table, which is protected by a lock taken by other threads
+/// only while emitting, so aggregating does not contend. Label values are formatted into the
+/// thread-local key, so only new combinations allocate memory. Tables of finished threads are
+/// reused by new ones.
+///
+/// Collected metrics are the number of records aggregated and emitted, followed by metrics of the
+/// wrapped handler.
+class aggregate_t : public handler_t {
+    class inner_t;
+    std::unique_ptr<inner_t> d;
+
+public:
+    /// Aggregated metric.
+    struct metric_t {
+        enum class type_t {
+            counter,
+            histogram
+        };
+
+        std::string name;
+        type_t type;
+        /// Label names.
+        std::vector<std::string> labels;
+        /// Numeric attribute observed by histograms.
+        std::string attribute;
+        /// Upper bucket bounds of histograms in increasing order, while values above the last one
+        /// are only counted.
+        std::vector<double> buckets;
+        /// Records with lower severity are ignored.
+        severity_t threshold;
+
+        /// Returns a counter with the given labels, counting all records.
+        static auto counter(std::string name, std::vector<std::string> labels = {}) -> metric_t;
+
+        /// Returns a histogram of the given attribute values with the given labels.
+        static auto histogram(std::string name, std::string attribute, std::vector<double> buckets,
+                              std::vector<std::string> labels = {}) -> metric_t;
+    };
+
+    /// Default interval between emissions.
+    static constexpr std::chrono::milliseconds default_interval = std::chrono::milliseconds(10000);
+
+public:
+    /// Starts the thread emitting aggregates every interval, unless it's zero, in which case they
+    /// are emitted on flushes only.
+    ///
+    /// \param severity of emitted records.
+    /// \throw std::invalid_argument if there are no metrics, a metric has no name, or histogram
+    ///     buckets are not increasing.
+    aggregate_t(std::unique_ptr<handler_t> handler,
+                std::vector<metric_t> metrics,
+                std::chrono::milliseconds interval = default_interval,
+                severity_t severity = 0);
+
+    /// Stops the emitting thread, emitting aggregates collected so far.
+    ~aggregate_t();
+
+    auto handle(const record_t& record) -> void override;
+
+    /// Emits aggregates collected so far, then flushes the wrapped handler.
+    auto flush(std::chrono::steady_clock::time_point deadline) -> bool override;
+
+    auto collect(metrics::collector_t& collector) const -> void override;
+    auto pressure() const -> pressure_t override;
+
+    /// Emits aggregates of all threads collected since the previous emission through the wrapped
+    /// handler.
+    auto emit() -> void;
+};
+
+}  // namespace handler
+
+template<>
+class builder<handler::aggregate_t> {
+    class inner_t;
+    std::unique_ptr<inner_t, deleter_t> d;
+
+public:
+    /// Constructs a builder of the aggregate handler emitting through the given handler.
+    explicit builder(std::unique_ptr<handler_t> handler);
+
+    /// Adds the given metric.
+    auto add(handler::aggregate_t::metric_t metric) & -> builder&;
+    auto add(handler::aggregate_t::metric_t metric) && -> builder&&;
+
+    /// Sets the interval between emissions, zero for emitting on flushes only.
+    auto interval(std::chrono::milliseconds value) & -> builder&;
+    auto interval(std::chrono::milliseconds value) && -> builder&&;
+
+    /// Sets the severity of emitted records.
+    auto severity(severity_t value) & -> builder&;
+    auto severity(severity_t value) && -> builder&&;
+
+    /// Returns the handler itself, so that aggregates can be emitted explicitly after being moved
+    /// into the root logger.
+    auto build() && -> std::unique_ptr<handler::aggregate_t>;
+};
+
+template<>
+class factory<handler::aggregate_t> : public factory<handler_t> {
+    const registry_t& registry;
+
+public:
+    constexpr explicit factory(const registry_t& registry) noexcept :
+        registry(registry)
+    {}
+
+    virtual auto type() const noexcept -> const char* override;
+    virtual auto from(const config::node_t& config) const -> std::unique_ptr<handler_t> override;
+};
+
+}  // namespace v1
+}  // namespace blackhole
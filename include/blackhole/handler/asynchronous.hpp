@@ -0,0 +1,111 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+
+#include "../factory.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace handler {
+
+/// The asynchronous handler captures an owned copy of each record and offloads both formatting
+/// and emitting to sinks to a pool of worker threads.
+///
+/// Unlike the asynchronous sink, which only offloads sink I/O, this handler makes the caller thread
+/// pay for the record capture only, which matters when formatting is the expensive part, like with
+/// JSON output.
+///
+/// # Parameters
+///
+/// The factor value maps directly into the queue capacity and equals exp2(factor), 10 by default.
+/// The value must fit in [0; 20] range (1048576 items).
+///
+/// The workers value sets the number of worker threads, 1 by default. Records are formatted and
+/// emitted in order when there is a single worker only, otherwise sinks may observe them reordered.
+///
+/// Overflow policy decides what action is taken when the queue is overflowed, either "wait", which
+/// is the default one, or "drop".
+///
+/// The batch value enables batching when greater than 1, which is the default. Each producer thread
+/// then appends records to its own pending batch, which is enqueued as a single item once full,
+/// amortizing the queue contention over the whole batch. Batches of idle producers are enqueued
+/// by workers after lingering for the given time, 10 milliseconds by default, and remaining ones
+/// are enqueued on producer thread exit and by flushing. Records keep their per thread order, but
+/// the overflow policy applies to whole batches, i.e. the "drop" one drops the whole batch.
+///
+/// The parallel value sets the number of threads formatting a single dequeued batch, 1 by default,
+/// which raises the formatting throughput of a single worker. The batch is split into contiguous
+/// slices of at least 64 records, which are formatted by the worker and helper threads into their
+/// own buffers, and then emitted to sinks at once in the original order. Smaller batches and
+/// single records are formatted by the worker alone.
+///
+/// \warning the formatter and all sinks must be thread-safe if there are several workers, and the
+///     formatter must be thread-safe if batches are formatted in parallel.
+/// \note exceptions while formatting or emitting are printed to the standard output and otherwise
+///     hidden from the application.
+/// \throw std::invalid_argument on construction if the factor is greater than 20.
+/// \throw std::invalid_argument on construction if the workers value is zero.
+/// \throw std::invalid_argument on construction if the overflow policy value differs from "drop" or
+///     "wait".
+/// \throw std::invalid_argument on construction if the batch size or the linger time is zero.
+/// \throw std::invalid_argument on construction if the parallel value is zero.
+class asynchronous_t;
+
+}  // namespace handler
+
+template<>
+class builder<handler::asynchronous_t> {
+    class inner_t;
+    std::unique_ptr<inner_t, deleter_t> d;
+
+public:
+    builder();
+
+    auto set(std::unique_ptr<formatter_t> formatter) & -> builder&;
+    auto set(std::unique_ptr<formatter_t> formatter) && -> builder&&;
+    auto add(std::unique_ptr<sink_t> sink) & -> builder&;
+    auto add(std::unique_ptr<sink_t> sink) && -> builder&&;
+
+    /// Sets the queue capacity factor, i.e. its binary logarithm.
+    auto factor(std::size_t value) & -> builder&;
+    auto factor(std::size_t value) && -> builder&&;
+
+    /// Sets the number of worker threads.
+    auto workers(std::size_t value) & -> builder&;
+    auto workers(std::size_t value) && -> builder&&;
+
+    /// Sets the overflow policy by its name.
+    auto overflow(std::string policy) & -> builder&;
+    auto overflow(std::string policy) && -> builder&&;
+
+    /// Sets the number of records each producer thread accumulates before enqueueing them at once.
+    auto batch(std::size_t size) & -> builder&;
+    auto batch(std::size_t size) && -> builder&&;
+
+    /// Sets the maximum time records are kept in a pending batch of an idle producer.
+    auto linger(std::chrono::microseconds duration) & -> builder&;
+    auto linger(std::chrono::microseconds duration) && -> builder&&;
+
+    /// Sets the number of threads formatting slices of a single batch.
+    auto parallel(std::size_t threads) & -> builder&;
+    auto parallel(std::size_t threads) && -> builder&&;
+
+    auto build() && -> std::unique_ptr<handler_t>;
+};
+
+template<>
+class factory<handler::asynchronous_t> : public factory<handler_t> {
+    const registry_t& registry;
+
+public:
+    constexpr explicit factory(const registry_t& registry) noexcept :
+        registry(registry)
+    {}
+
+    virtual auto type() const noexcept -> const char* override;
+    virtual auto from(const config::node_t& config) const -> std::unique_ptr<handler_t> override;
+};
+
+}  // namespace v1
+}  // namespace blackhole
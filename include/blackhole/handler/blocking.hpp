@@ -23,6 +23,27 @@ public:
     auto add(std::unique_ptr<sink_t> sink) & -> builder&;
     auto add(std::unique_ptr<sink_t> sink) && -> builder&&;
 
+    /// Adds the given sink accompanied with the filter, which is checked before formatting.
+    ///
+    /// Records denied by filters of all sinks are not formatted.
+    auto add(std::unique_ptr<sink_t> sink, std::unique_ptr<filter_t> filter) & -> builder&;
+    auto add(std::unique_ptr<sink_t> sink, std::unique_ptr<filter_t> filter) && -> builder&&;
+
+    /// Sets the maximum formatting buffer capacity kept by each thread between records, in bytes.
+    ///
+    /// Buffers grown over this value by outlier records are released. Zero, which is the default,
+    /// means that the largest buffer is always kept.
+    auto capacity(std::size_t value) & -> builder&;
+    auto capacity(std::size_t value) && -> builder&&;
+
+    /// Sets the minimum size of strings, like messages and attribute values, which are referenced
+    /// instead of being copied while formatting, in bytes.
+    ///
+    /// Records referencing strings are emitted as slices into sinks, which write them with a single
+    /// gathered system call where possible. Zero, which is the default, disables gathering.
+    auto gather(std::size_t threshold) & -> builder&;
+    auto gather(std::size_t threshold) && -> builder&&;
+
     auto build() && -> std::unique_ptr<handler_t>;
 };
 
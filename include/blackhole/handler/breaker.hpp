@@ -0,0 +1,96 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <memory>
+
+#include "../factory.hpp"
+#include "../handler.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace handler {
+
+/// The circuit breaker handler temporarily bypasses the wrapped handler once it keeps throwing.
+///
+/// Exceptions thrown by the wrapped handler are propagated to the root logger, which counts and
+/// reports them, until the given number of consecutive records fail. The breaker then opens and
+/// drops records without passing them further for the cooldown period, after which a single
+/// record probes the wrapped handler. The breaker closes if it succeeds and opens for another
+/// cooldown period otherwise.
+///
+/// This makes a broken sink, like a full disk or an unreachable collector, cost an atomic load and
+/// a counter increment per record instead of an exception thrown through the whole pipeline.
+///
+/// Flushing, collecting metrics and the pressure are always delegated to the wrapped handler.
+///
+/// Collected metrics are the number of records bypassed and the number of times the breaker
+/// opened, followed by metrics of the wrapped handler.
+class breaker_t : public handler_t {
+    class inner_t;
+    std::unique_ptr<inner_t> d;
+
+public:
+    /// Default number of consecutive failures opening the breaker.
+    static constexpr std::size_t default_threshold = 5;
+
+public:
+    /// \throw std::invalid_argument if the threshold is zero.
+    breaker_t(std::unique_ptr<handler_t> handler,
+              std::size_t threshold = default_threshold,
+              std::chrono::milliseconds cooldown = std::chrono::seconds(1));
+
+    ~breaker_t();
+
+    /// Passes the given record to the wrapped handler unless the breaker is open.
+    auto handle(const record_t& record) -> void override;
+
+    /// Passes the given records to the wrapped handler as a single batch unless the breaker is
+    /// open, accounting a failed batch as a single failure.
+    auto handle_batch(const record_t* records, std::size_t size) -> void override;
+
+    auto flush(std::chrono::steady_clock::time_point deadline) -> bool override;
+    auto collect(metrics::collector_t& collector) const -> void override;
+    auto pressure() const -> pressure_t override;
+
+    /// Returns whether records are currently bypassed.
+    auto open() const noexcept -> bool;
+};
+
+}  // namespace handler
+
+template<>
+class builder<handler::breaker_t> {
+    class inner_t;
+    std::unique_ptr<inner_t, deleter_t> d;
+
+public:
+    /// Constructs a builder of the circuit breaker wrapping the given handler.
+    explicit builder(std::unique_ptr<handler_t> handler);
+
+    /// Sets the number of consecutive failures opening the breaker.
+    auto threshold(std::size_t value) & -> builder&;
+    auto threshold(std::size_t value) && -> builder&&;
+
+    /// Sets the time records are bypassed for once the breaker opens.
+    auto cooldown(std::chrono::milliseconds value) & -> builder&;
+    auto cooldown(std::chrono::milliseconds value) && -> builder&&;
+
+    auto build() && -> std::unique_ptr<handler_t>;
+};
+
+template<>
+class factory<handler::breaker_t> : public factory<handler_t> {
+    const registry_t& registry;
+
+public:
+    constexpr explicit factory(const registry_t& registry) noexcept :
+        registry(registry)
+    {}
+
+    virtual auto type() const noexcept -> const char* override;
+    virtual auto from(const config::node_t& config) const -> std::unique_ptr<handler_t> override;
+};
+
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+
+#include "../factory.hpp"
+#include "../handler.hpp"
+#include "../severity.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace handler {
+
+/// The flight recorder handler keeps the most recent records below the threshold severity of each
+/// thread in a ring instead of passing them further, dumping the ring through the wrapped handler
+/// once the thread handles a record with the trigger severity or higher.
+///
+/// This gives full debug context of failures, while paying for capturing records into memory only,
+/// without formatting and emitting them unless something goes wrong. Note that the root logger
+/// must not reject records of low severities for them to be recorded.
+///
+/// Records with the threshold severity or higher are passed directly to the wrapped handler,
+/// records with the trigger severity or higher are passed right after the ring of the calling
+/// thread is dumped, so that the context precedes them. The threshold equals the trigger by default.
+///
+/// # Performance
+///
+/// Each thread has its own ring, which is protected by a lock taken by other threads only while
+/// dumping all rings, so recording does not contend. Slots of the ring are preallocated and records
+/// are captured directly into them, so recording a record that fits in a slot is roughly a copy of
+/// its content without allocations. Larger records are allocated on the heap. Rings of finished
+/// threads are reused by new ones.
+///
+/// Collected metrics are the number of records recorded, dumped and overwritten before being
+/// dumped, the number of dumps, followed by metrics of the wrapped handler.
+class recorder_t : public handler_t {
+    class inner_t;
+    std::unique_ptr<inner_t> d;
+
+public:
+    /// Default number of records kept for each thread.
+    static constexpr std::size_t default_capacity = 128;
+
+    /// Default size of each ring slot in bytes.
+    static constexpr std::size_t default_slot = 2048;
+
+public:
+    /// \throw std::invalid_argument if either the capacity or the slot size is zero.
+    recorder_t(std::unique_ptr<handler_t> handler,
+               severity_t threshold,
+               severity_t trigger,
+               std::size_t capacity = default_capacity,
+               std::size_t slot = default_slot);
+
+    ~recorder_t();
+
+    /// Records the given record or passes it to the wrapped handler depending on its severity.
+    auto handle(const record_t& record) -> void override;
+
+    /// Flushes the wrapped handler, leaving recorded records in their rings.
+    auto flush(std::chrono::steady_clock::time_point deadline) -> bool override;
+
+    auto collect(metrics::collector_t& collector) const -> void override;
+    auto pressure() const -> pressure_t override;
+
+    /// Passes records recorded by the calling thread to the wrapped handler in order, emptying its
+    /// ring.
+    auto dump() -> void;
+
+    /// Passes records recorded by all threads to the wrapped handler, ring by ring.
+    auto dump_all() -> void;
+};
+
+}  // namespace handler
+
+template<>
+class builder<handler::recorder_t> {
+    class inner_t;
+    std::unique_ptr<inner_t, deleter_t> d;
+
+public:
+    /// Constructs a builder of the recorder wrapping the given handler and dumping records once a
+    /// record with the given severity or higher is handled.
+    builder(std::unique_ptr<handler_t> handler, severity_t trigger);
+
+    /// Sets the minimum severity of records passed directly to the wrapped handler, which must not
+    /// exceed the trigger one to make sense.
+    auto threshold(severity_t severity) & -> builder&;
+    auto threshold(severity_t severity) && -> builder&&;
+
+    /// Sets the number of records kept for each thread.
+    auto capacity(std::size_t value) & -> builder&;
+    auto capacity(std::size_t value) && -> builder&&;
+
+    /// Sets the size of each ring slot in bytes, records not fitting are allocated on the heap.
+    auto slot(std::size_t bytes) & -> builder&;
+    auto slot(std::size_t bytes) && -> builder&&;
+
+    /// Returns the recorder itself, so that it can be dumped explicitly after being moved into the
+    /// root logger.
+    auto build() && -> std::unique_ptr<handler::recorder_t>;
+};
+
+template<>
+class factory<handler::recorder_t> : public factory<handler_t> {
+    const registry_t& registry;
+
+public:
+    constexpr explicit factory(const registry_t& registry) noexcept :
+        registry(registry)
+    {}
+
+    virtual auto type() const noexcept -> const char* override;
+    virtual auto from(const config::node_t& config) const -> std::unique_ptr<handler_t> override;
+};
+
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+
+#include "blackhole/stdext/string_view.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace immortal {
+
+/// Declares the given memory immortal, i.e. never freed nor modified while the process lives, like
+/// interned string tables, so that captured records refer to strings within it instead of copying
+/// them.
+///
+/// Read-only segments of the executable, which hold string literals, are immortal without being
+/// declared. Segments of shared libraries are not, since they may be unloaded.
+///
+/// \returns false if too many ranges are declared already, which are limited to 32.
+auto declare(const void* data, std::size_t size) noexcept -> bool;
+
+/// Checks whether the given string lies within immortal memory entirely.
+///
+/// Records captured by asynchronous sinks and handlers or kept by recorders refer to such
+/// messages, message patterns, attribute names and string values as is, which usually leaves only
+/// formatted messages and dynamic values to be copied.
+auto contains(const string_view& value) noexcept -> bool;
+
+}  // namespace immortal
+}  // namespace v1
+}  // namespace blackhole
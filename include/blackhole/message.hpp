@@ -1,6 +1,7 @@
 #pragma once
 
 #include <functional>
+#include <type_traits>
 
 #include "blackhole/stdext/string_view.hpp"
 
@@ -10,6 +11,63 @@ inline namespace v1 {
 /// Represents a message that can be logged.
 typedef string_view message_t;
 
+/// Non-owning reference to a callable object producing the formatted message.
+///
+/// Unlike `std::function` it never allocates and invokes the callable through a single function
+/// pointer, which makes it suitable for passing stack-bound formatting closures down the logging
+/// pipeline.
+///
+/// \warning the referenced callable object must outlive the supplier, except captureless lambdas
+///     and plain functions, which are stored as function pointers.
+class supplier_t {
+    typedef auto (*function_type)() -> string_view;
+
+    union {
+        const void* object;
+        function_type function;
+    };
+
+    auto (*invoke)(const supplier_t& self) -> string_view;
+
+public:
+    /// Constructs a supplier from the given function pointer or captureless lambda.
+    template<typename F, typename = typename std::enable_if<
+        std::is_convertible<F, function_type>::value>::type>
+    supplier_t(const F& fn) noexcept :
+        function(fn),
+        invoke(&supplier_t::call_function)
+    {}
+
+    /// Constructs a supplier referencing the given callable object.
+    template<typename F, typename = typename std::enable_if<
+        !std::is_convertible<F, function_type>::value &&
+        !std::is_same<typename std::decay<F>::type, supplier_t>::value>::type, typename = void>
+    supplier_t(const F& fn) noexcept :
+        object(&fn),
+        invoke(&supplier_t::call_object<F>)
+    {}
+
+    /// Constructs a supplier referencing the callable object wrapped, for example, by `std::cref`.
+    template<typename F>
+    supplier_t(const std::reference_wrapper<F>& fn) noexcept :
+        supplier_t(fn.get())
+    {}
+
+    auto operator()() const -> string_view {
+        return invoke(*this);
+    }
+
+private:
+    static auto call_function(const supplier_t& self) -> string_view {
+        return self.function();
+    }
+
+    template<typename F>
+    static auto call_object(const supplier_t& self) -> string_view {
+        return (*static_cast<const F*>(self.object))();
+    }
+};
+
 /// Represents a message that can be logged and can be instantiated lazily on demand.
 struct lazy_message_t {
     /// Initial unformatted message pattern.
@@ -25,7 +83,7 @@ struct lazy_message_t {
     /// Note, that string view semantics requires the real message storage that is pointed by view
     /// to outlive the function call. Default implementation in the facade just allocates large
     /// buffer on stack and fills it on function invocation.
-    std::function<auto() -> string_view> supplier;
+    supplier_t supplier;
 };
 
 }  // namespace v1
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace blackhole {
+inline namespace v1 {
+namespace metrics {
+
+/// Number of shards each metric is split into to keep concurrent updates off shared cache lines.
+constexpr std::size_t shards = 16;
+
+/// Monotonic counter sharded by the updating thread, the value is aggregated on read.
+///
+/// \remark All methods of this class are thread safe.
+class counter_t {
+    struct shard_t {
+        std::atomic<std::uint64_t> value;
+        char pad[64 - sizeof(std::atomic<std::uint64_t>)];
+    };
+
+    std::array<shard_t, shards> values;
+
+public:
+    counter_t() noexcept;
+
+    counter_t(const counter_t& other) = delete;
+    auto operator=(const counter_t& other) -> counter_t& = delete;
+
+    auto add(std::uint64_t value = 1) noexcept -> void;
+
+    /// Returns the sum of all shards, which is not an atomic snapshot with respect to concurrent
+    /// updates.
+    auto get() const noexcept -> std::uint64_t;
+};
+
+/// Histogram of durations in nanoseconds with power of two buckets, sharded by the updating
+/// thread.
+///
+/// The first bucket counts values below 2, each next i-th one counts values in [2^i; 2^(i + 1))
+/// range and the last one counts everything above.
+///
+/// \remark All methods of this class are thread safe.
+class histogram_t {
+public:
+    static constexpr std::size_t buckets = 40;
+
+private:
+    struct shard_t {
+        std::array<std::atomic<std::uint64_t>, buckets> counts;
+        std::atomic<std::uint64_t> sum;
+        char pad[64 - sizeof(std::atomic<std::uint64_t>)];
+    };
+
+    std::array<shard_t, shards> values;
+
+public:
+    histogram_t() noexcept;
+
+    histogram_t(const histogram_t& other) = delete;
+    auto operator=(const histogram_t& other) -> histogram_t& = delete;
+
+    auto record(std::uint64_t value) noexcept -> void;
+
+    /// Returns per bucket counts aggregated over all shards.
+    auto counts() const -> std::vector<std::uint64_t>;
+
+    /// Returns the sum of all recorded values.
+    auto sum() const noexcept -> std::uint64_t;
+};
+
+/// Records the time elapsed from its construction until destruction into the given histogram.
+class timer_t {
+    histogram_t& histogram;
+    std::chrono::steady_clock::time_point start;
+
+public:
+    explicit timer_t(histogram_t& histogram) noexcept :
+        histogram(histogram),
+        start(std::chrono::steady_clock::now())
+    {}
+
+    timer_t(const timer_t& other) = delete;
+    auto operator=(const timer_t& other) -> timer_t& = delete;
+
+    ~timer_t() {
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        histogram.record(static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+    }
+};
+
+/// Single metric value, labeled with the component it belongs to.
+struct sample_t {
+    enum class kind_t {
+        counter,
+        gauge,
+        histogram
+    };
+
+    /// Metric name, for example "blackhole_sink_bytes_total".
+    std::string name;
+    /// Labels identifying the component, for example {{"handler", "0"}, {"sink", "1"}}.
+    std::vector<std::pair<std::string, std::string>> labels;
+    kind_t kind;
+    /// Value of a counter or a gauge, the total number of observations for histograms.
+    std::uint64_t value;
+    /// Histogram bucket counts in nanoseconds, see `histogram_t`, empty for other kinds.
+    std::vector<std::uint64_t> buckets;
+    /// Sum of observed values in nanoseconds for histograms.
+    std::uint64_t sum;
+};
+
+typedef std::vector<sample_t> snapshot_t;
+
+/// Collects metrics of a component into the snapshot, labeling them with the component labels.
+///
+/// Handlers and sinks receive collectors already labeled with their identifiers.
+class collector_t {
+    snapshot_t& snapshot;
+    std::vector<std::pair<std::string, std::string>> labels;
+
+public:
+    explicit collector_t(snapshot_t& snapshot);
+
+    /// Returns a collector adding the given label to all samples collected.
+    auto with(std::string key, std::string value) const -> collector_t;
+
+    auto counter(std::string name, std::uint64_t value) -> void;
+    auto gauge(std::string name, std::uint64_t value) -> void;
+
+    /// Adds a histogram, which is conventionally named with "_seconds" suffix, since it's exposed
+    /// in seconds.
+    auto histogram(std::string name, const histogram_t& histogram) -> void;
+};
+
+/// Formats the given snapshot using Prometheus text exposition format, converting histograms
+/// into seconds.
+auto prometheus(const snapshot_t& snapshot) -> std::string;
+
+}  // namespace metrics
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,181 @@
+#pragma once
+
+#include <exception>
+#include <memory>
+#include <utility>
+
+#include "blackhole/attribute.hpp"
+#include "blackhole/attributes.hpp"
+#include "blackhole/filter.hpp"
+#include "blackhole/logger.hpp"
+#include "blackhole/record.hpp"
+#include "blackhole/extensions/writer.hpp"
+#include "blackhole/scope/watcher.hpp"
+#include "blackhole/stdext/string_view.hpp"
+
+#include "blackhole/detail/error.hpp"
+#include "blackhole/detail/scope/manager.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace detail {
+namespace pipeline {
+
+/// Returns the component itself, when it is stored by value.
+template<typename T>
+auto deref(T& value) noexcept -> T& {
+    return value;
+}
+
+/// Returns the component pointed to, when it is owned by a smart pointer, for example the ones
+/// created by builders and factories.
+template<typename T, typename D>
+auto deref(std::unique_ptr<T, D>& value) noexcept -> T& {
+    return *value;
+}
+
+template<typename T>
+auto deref(std::shared_ptr<T>& value) noexcept -> T& {
+    return *value;
+}
+
+}  // namespace pipeline
+}  // namespace detail
+
+namespace pipeline {
+
+/// Filter accepting all records.
+struct accept {
+    auto filter(const record_t&) const noexcept -> filter_t::action_t {
+        return filter_t::action_t::neutral;
+    }
+};
+
+/// Filter denying records below the given severity, which is known at compile time.
+template<int Threshold>
+struct severity {
+    auto filter(const record_t& record) const noexcept -> filter_t::action_t {
+        return record.severity() >= Threshold ? filter_t::action_t::neutral
+                                              : filter_t::action_t::deny;
+    }
+};
+
+/// Formatter writing the formatted message only.
+struct message {
+    auto format(const record_t& record, writer_t& writer) const -> void {
+        const auto& formatted = record.formatted();
+        writer.inner << fmt::StringRef(formatted.data(), formatted.size());
+    }
+};
+
+/// Sink dropping all records.
+struct null {
+    auto emit(const record_t&, const string_view&) const noexcept -> void {}
+};
+
+}  // namespace pipeline
+
+/// Logger composing its filter, formatter and sink statically, without a handler between them.
+///
+/// Unlike the root logger the whole path from the logging call to the sink is known at compile
+/// time, which allows the compiler to inline it when the logger is used by its own type, for
+/// example through `logger_facade<static_logger_t<...>>`. Used through the `logger_t` interface,
+/// like with wrappers, it costs a single virtual call.
+///
+/// Components are duck-typed: filters must have `filter(const record_t&) -> filter_t::action_t`
+/// method, denying records by returning `deny`, formatters `format(const record_t&, writer_t&)`
+/// and sinks `emit(const record_t&, const string_view&)` ones. Any of them can also be a smart
+/// pointer to a library component, for example a sink created by its builder, which keeps
+/// dispatching that component dynamically.
+///
+/// Exceptions thrown by components are caught and reported, the same way the root logger does.
+///
+/// \warning the logger has no configuration to replace at runtime and no synchronization of its
+///     own, so components must be thread safe if it is used by multiple threads.
+template<typename Filter, typename Formatter, typename Sink>
+class static_logger_t : public logger_t {
+public:
+    typedef Filter filter_type;
+    typedef Formatter formatter_type;
+    typedef Sink sink_type;
+
+private:
+    filter_type filter;
+    formatter_type formatter;
+    sink_type sink;
+
+    scope::thread_manager_t scoped;
+
+public:
+    explicit static_logger_t(filter_type filter = filter_type(),
+                             formatter_type formatter = formatter_type(),
+                             sink_type sink = sink_type()) :
+        filter(std::move(filter)),
+        formatter(std::move(formatter)),
+        sink(std::move(sink))
+    {}
+
+    auto log(severity_t severity, const message_t& message) -> void override final {
+        attribute_pack pack;
+        log(severity, message, pack);
+    }
+
+    auto log(severity_t severity, const message_t& message, attribute_pack& pack) ->
+        void override final
+    {
+        consume(severity, message, pack, [] {
+            return string_view();
+        });
+    }
+
+    auto log(severity_t severity, const lazy_message_t& message, attribute_pack& pack) ->
+        void override final
+    {
+        consume(severity, message.pattern, pack, message.supplier);
+    }
+
+    auto manager() -> scope::manager_t& override final {
+        return scoped;
+    }
+
+private:
+    template<typename F>
+    auto consume(severity_t severity, const string_view& pattern, attribute_pack& pack,
+                 const F& supplier) -> void
+    {
+        const auto watcher = scoped.get();
+        if (watcher) {
+            watcher->collect(pack);
+        }
+
+        try {
+            record_t record(severity, pattern, pack);
+
+            const unique_attributes_t unique(pack);
+            record.attach(unique);
+
+            if (detail::pipeline::deref(filter).filter(record) == filter_t::action_t::deny) {
+                return;
+            }
+
+            const auto formatted = supplier();
+            record.activate(formatted);
+
+            if (const auto interceptor = watcher ? watcher->capturing() : nullptr) {
+                return interceptor->capture(record);
+            }
+
+            writer_t writer;
+            detail::pipeline::deref(formatter).format(record, writer);
+
+            if (!writer.skipped()) {
+                detail::pipeline::deref(sink).emit(record, writer.result());
+            }
+        } catch (...) {
+            detail::error::report(error::kind_t::handler);
+        }
+    }
+};
+
+}  // namespace v1
+}  // namespace blackhole
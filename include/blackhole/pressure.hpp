@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+
+namespace blackhole {
+inline namespace v1 {
+
+/// Congestion state of logging queues, which allows applications to shed optional logging before
+/// records start being dropped.
+struct pressure_t {
+    enum class level_t {
+        /// Queues are less than half full.
+        normal,
+        /// Queues are at least half full.
+        elevated,
+        /// Queues are at least 80% full.
+        high,
+        /// Queues are at least 95% full or records have been dropped recently.
+        critical
+    };
+
+    /// Fill ratio of the fullest queue in [0; 1] range.
+    double fill;
+    /// Number of records dropped so far.
+    std::uint64_t dropped;
+    /// Number of records dropped per second recently, which is estimated by the root logger only.
+    double rate;
+    level_t level;
+
+    pressure_t() noexcept :
+        fill(0.0),
+        dropped(0),
+        rate(0.0),
+        level(level_t::normal)
+    {}
+
+    /// Constructs the pressure of a queue with the given fill ratio and the number of drops,
+    /// classifying its level.
+    pressure_t(double fill, std::uint64_t dropped) noexcept;
+
+    /// Combines the given pressure of another queue into this one, keeping the fullest queue fill
+    /// and the highest level, summing drops and rates.
+    auto merge(const pressure_t& other) noexcept -> void;
+
+    /// Classifies the level by the given fill ratio and drop rate.
+    static auto classify(double fill, double rate) noexcept -> level_t;
+};
+
+}  // namespace v1
+}  // namespace blackhole
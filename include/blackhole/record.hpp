@@ -7,10 +7,17 @@
 #include "blackhole/attributes.hpp"
 #include "blackhole/stdext/string_view.hpp"
 #include "blackhole/severity.hpp"
+#include "blackhole/trace.hpp"
 
 namespace blackhole {
 inline namespace v1 {
 
+namespace attribute {
+
+class table_t;
+
+}  // namespace attribute
+
 using stdext::string_view;
 
 class record_t {
@@ -21,7 +28,7 @@ public:
     typedef clock_type::time_point time_point;
 
 private:
-    typedef std::aligned_storage<64>::type storage_type;
+    typedef std::aligned_storage<96>::type storage_type;
     storage_type storage;
 
 public:
@@ -42,15 +49,62 @@ public:
     record_t(inner_t inner) noexcept;
 
     auto message() const noexcept -> const string_view&;
+
+    /// Returns the identity of the message pattern, which is its address.
+    ///
+    /// Patterns passed as string literals, which is the case for the logging facade, have the same
+    /// address for all records of the same call site, so filters can maintain per call site tables
+    /// checked before the message is formatted and without looking at the pattern content.
+    auto pattern_id() const noexcept -> std::uintptr_t;
+
+    /// Returns the hash of the pattern identity, which both high and low bits are well mixed.
+    ///
+    /// The hash is computed in constant time regardless of the pattern length.
+    auto pattern_hash() const noexcept -> std::uint64_t;
     auto severity() const noexcept -> severity_t;
     auto timestamp() const noexcept -> time_point;
 
     auto pid() const noexcept -> std::uint64_t;
     auto tid() const noexcept -> std::thread::native_handle_type;
 
+    /// Returns the kernel thread id of the thread the record was created in.
+    auto lwp() const noexcept -> std::uint64_t;
+
+    /// Returns the trace context of the thread the record was created in, which is stored inline.
+    ///
+    /// \sa scope::span_t.
+    auto trace() const noexcept -> const trace_t&;
+
     auto formatted() const noexcept -> const string_view&;
     auto attributes() const noexcept -> const attribute_pack&;
 
+    /// Returns flattened record attributes with duplicate keys removed.
+    ///
+    /// The view attached using `attach` is computed once and shared by all callers. Otherwise the
+    /// result is computed on each call into the thread-local storage, which stays valid until the
+    /// next call from the same thread.
+    auto unique_attributes() const -> const unique_attributes_t&;
+
+    /// Attaches the deduplicated view over record attributes, which is computed at most once and
+    /// reused by all handlers and formatters.
+    ///
+    /// \warning the view must be built over the record attributes and must outlive the record.
+    auto attach(const unique_attributes_t& unique) noexcept -> void;
+
+    /// Returns the flattened table of unique record attributes.
+    ///
+    /// The table attached using `attach` is computed once and shared by all callers. Otherwise the
+    /// result is computed on each call into the thread-local storage, which stays valid until the
+    /// next call from the same thread.
+    auto table() const -> const attribute::table_t&;
+
+    /// Attaches the flattened attributes table, which is computed at most once and reused by all
+    /// handlers, filters and formatters.
+    ///
+    /// \warning the table must be built over the unique attributes of the record and must outlive
+    ///     the record.
+    auto attach(const attribute::table_t& table) noexcept -> void;
+
     /// Check whether the record is active.
     ///
     /// Active record is considered as passed filtering stage and should be accepted by any logger
@@ -59,9 +113,15 @@ public:
     auto is_active() const noexcept -> bool;
 
     /// Activate the record by setting the given formatted message accompanied by obtaining and
-    /// setting the current time point.
+    /// setting the current time point, or the time point cached by the calling thread if any.
     auto activate(const string_view& formatted = string_view()) noexcept -> void;
 
+    /// Activate the record by setting the given formatted message and the given time point, which
+    /// allows to timestamp records using another clock source.
+    ///
+    /// \overload
+    auto activate(const string_view& formatted, time_point timestamp) noexcept -> void;
+
 private:
     auto inner() noexcept -> inner_t&;
     auto inner() const noexcept -> const inner_t&;
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+
+#include "blackhole/attribute.hpp"
+#include "blackhole/attributes.hpp"
+#include "blackhole/record.hpp"
+#include "blackhole/stdext/string_view.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+
+/// Compact binary serialization of records, which allows to move structured records between
+/// processes or store them on disk, deferring text formatting to the consumer.
+///
+/// Records are encoded into a stream of frames, each prefixed with its body size as a varint. A
+/// frame body consists of:
+///     - definitions of attribute keys met in the stream for the first time, i.e. their number
+///       followed by their names, which are assigned consecutive ids starting from zero;
+///     - severity as a zigzag varint;
+///     - timestamp as a zigzag varint delta of nanoseconds relative to the previous record;
+///     - thread id and kernel thread id as varints;
+///     - message as a length-prefixed string;
+///     - formatted message as a length-prefixed string with the length incremented by one, where
+///       zero marks it being the same as the message;
+///     - number of attributes followed by each attribute key id and value.
+///
+/// Values are tagged with the position of their type in `attribute::view_t::types` sequence, which
+/// matches `attribute::value_t::types` one. Booleans are followed by a byte, signed integers are
+/// zigzag varints, unsigned integers are varints, floating point values are eight bytes in little
+/// endian order and strings are length-prefixed. Function values are formatted during encoding and
+/// stored as strings.
+///
+/// Since both the key table and timestamps are relative, frames must be decoded in order by a
+/// decoder, whose state matches the encoder one, i.e. both are either fresh or reset.
+namespace binary {
+
+/// Encodes records into a binary stream.
+class encoder_t {
+    std::int64_t timestamp;
+
+    std::deque<std::string> names;
+    std::unordered_map<string_view, std::uint32_t> keys;
+
+    /// Scratch buffer for frame bodies, which only grows.
+    std::string body;
+
+public:
+    encoder_t();
+
+    encoder_t(const encoder_t& other) = delete;
+    auto operator=(const encoder_t& other) -> encoder_t& = delete;
+
+    /// Appends the frame with the given encoded record to the buffer.
+    ///
+    /// \throw std::bad_alloc on memory allocation failure.
+    auto encode(const record_t& record, std::string& buffer) -> void;
+
+    /// Forgets the key table and the previous timestamp, starting a new stream.
+    auto reset() -> void;
+};
+
+/// Decodes records from a binary stream.
+///
+/// Decoding is zero-copy, all strings of the decoded record, except attribute keys, point into the
+/// frame memory. Objects of this class are neither copyable nor movable, because the record refers
+/// to their members.
+class decoder_t {
+    std::int64_t timestamp;
+    std::deque<std::string> names;
+
+    string_view message;
+    string_view formatted;
+
+    attribute_list attributes;
+    attribute_pack pack;
+
+    typedef std::aligned_storage<sizeof(record_t), alignof(record_t)>::type storage_type;
+    storage_type storage;
+
+public:
+    decoder_t();
+
+    decoder_t(const decoder_t& other) = delete;
+    auto operator=(const decoder_t& other) -> decoder_t& = delete;
+
+    /// Decodes the next record from the given data, reusing the attribute storage.
+    ///
+    /// Returns the number of bytes consumed, which is zero if the data doesn't contain the whole
+    /// frame yet. The decoded record is valid until the next call, provided the frame memory is
+    /// alive.
+    ///
+    /// \throw std::invalid_argument if the frame is malformed.
+    auto decode(const char* data, std::size_t size) -> std::size_t;
+
+    /// Returns the last decoded record.
+    ///
+    /// \warning the behavior is undefined if no record has been decoded yet.
+    auto record() const noexcept -> const record_t&;
+
+    /// Forgets the key table and the previous timestamp, starting a new stream.
+    auto reset() -> void;
+};
+
+}  // namespace binary
+}  // namespace v1
+}  // namespace blackhole
@@ -1,8 +1,11 @@
 #pragma once
 
 #include <functional>
+#include <future>
 #include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "forward.hpp"
 
@@ -10,17 +13,58 @@ namespace blackhole {
 inline namespace v1 {
 
 class builder_t {
+    struct cache_t;
+
     const registry_t& registry;
     std::unique_ptr<config::factory_t, deleter_t> factory;
 
+    /// Sinks of loggers built last, keyed by logger names.
+    std::shared_ptr<cache_t> cache;
+
 public:
     builder_t(const registry_t& registry, std::unique_ptr<config::factory_t> factory);
 
     auto configurator() noexcept -> config::factory_t&;
 
+    /// Builds a logger with the given name from the current configuration.
+    ///
+    /// Sinks configured identically to ones of the logger with the same name built by this builder
+    /// last are shared with it if it's still alive, instead of being constructed again.
     auto build(const std::string& name) -> root_logger_t;
 
+    /// Builds a logger like `build` does, but constructs its sinks concurrently on background
+    /// threads, so it returns without waiting for them to resolve hosts or to connect.
+    ///
+    /// Logging events reaching a sink before it's constructed wait for it, and fail with the
+    /// construction error if it has failed. The returned future becomes ready once all sinks are
+    /// constructed, holding the first error if any.
+    ///
+    /// \warning the registry must outlive the construction.
+    auto build_async(const std::string& name) ->
+        std::pair<root_logger_t, std::shared_future<void>>;
+
+    /// Replaces the current configuration with the given one and rebuilds the given logger from
+    /// it, which must have been built by this builder using the same name.
+    ///
+    /// Sinks, which configuration is unchanged, are reused with their files, sockets and queues,
+    /// while handlers and formatters are constructed again. The new configuration is published
+    /// atomically like the assignment does, so concurrent logging is never blocked, while removed
+    /// sinks are destroyed after all logging events observing them complete. The severity
+    /// threshold of the logger is kept.
+    ///
+    /// Both the logger and the configuration are left unchanged if building fails.
+    ///
+    /// \warning must not be called from inside of a handler, i.e. while logging.
+    auto reload(root_logger_t& logger, const std::string& name,
+                std::unique_ptr<config::factory_t> factory) -> void;
+
 private:
+    typedef std::vector<std::shared_future<std::shared_ptr<sink_t>>> pending_type;
+
+    /// Builds a logger constructing sinks in background if the given pending list is not null,
+    /// which is filled with results of their construction.
+    auto build(const config::factory_t& factory, const std::string& name, pending_type* pending) ->
+        root_logger_t;
     auto handler(const config::node_t& config) const -> std::unique_ptr<handler_t>;
 };
 
@@ -1,14 +1,21 @@
 #pragma once
 
+#include <chrono>
+#include <cstddef>
 #include <functional>
 #include <memory>
 #include <vector>
 
+#include "blackhole/category.hpp"
+#include "blackhole/clock.hpp"
 #include "blackhole/logger.hpp"
+#include "blackhole/metrics.hpp"
+#include "blackhole/pressure.hpp"
 
 namespace blackhole {
 inline namespace v1 {
 
+class executor_t;
 class handler_t;
 class record_t;
 
@@ -22,6 +29,19 @@ class root_logger_t : public logger_t {
 public:
     typedef std::function<auto(const record_t&) -> bool> filter_t;
 
+    /// Ways of calling handlers when logging.
+    enum class mode_t {
+        /// Called by the logging thread, which is the default.
+        blocking,
+        /// Called by the executor concurrently with other handlers, while the logging thread waits
+        /// for completion, so the logging latency is bounded by the slowest handler instead of the
+        /// sum of all of them.
+        parallel,
+        /// Called by the executor with an owned record snapshot, which is taken once per record and
+        /// shared by all detached handlers, while the logging thread doesn't wait at all.
+        detached
+    };
+
 private:
     struct sync_t;
     std::unique_ptr<sync_t> sync;
@@ -49,22 +69,195 @@ public:
     ~root_logger_t();
 
     auto operator=(const root_logger_t& other) -> root_logger_t& = delete;
+
+    /// Replaces the current logger configuration by consuming another existing logger.
+    ///
+    /// Blocks until all concurrent logging events that still observe the previous configuration
+    /// complete.
+    ///
+    /// \warning must not be called from inside of a handler, i.e. while logging.
     auto operator=(root_logger_t&& other) noexcept -> root_logger_t&;
 
     /// Replaces the current logger filter function with the given one.
     ///
     /// Any logging event for which the filter function returns `false` is rejected.
     ///
+    /// The new filter is published as a part of an immutable configuration snapshot, which means
+    /// that the function is never copied while logging. Like assignment this method blocks until
+    /// concurrent logging events using the previous filter complete.
+    ///
     /// \warning the function must be thread-safe.
+    /// \warning must not be called from inside of a handler, i.e. while logging.
     auto filter(filter_t fn) -> void;
 
+    /// Sets the minimum severity level for logging events to be accepted.
+    ///
+    /// Unlike filtering, the threshold check is performed before any other work, i.e. before
+    /// scoped attributes collection and record construction, which makes disabled logging events
+    /// to cost nearly as much as a single relaxed atomic load.
+    ///
+    /// By default the threshold equals the minimum integer value, which means that all events pass
+    /// this check.
+    ///
+    /// \remark this method is thread-safe and can be called while logging.
+    auto threshold(severity_t severity) noexcept -> void;
+
+    /// Returns the current minimum severity threshold.
+    auto threshold() const noexcept -> severity_t;
+
+    /// Checks whether logging events with the given severity pass the severity threshold.
+    ///
+    /// The logging facade uses this method to avoid message formatting of disabled events.
+    auto enabled(severity_t severity) const noexcept -> bool;
+
+    /// Sets the clock source used to timestamp records passed filtering.
+    ///
+    /// Precise clock is used by default. Coarser clocks are significantly cheaper, but provide
+    /// timestamps with millisecond-level resolution.
+    ///
+    /// \note the first selection of TSC clock blocks for its calibration.
+    /// \remark this method is thread-safe and can be called while logging.
+    auto clock(clock_source_t source) -> void;
+
+    /// Returns the current clock source.
+    auto clock() const noexcept -> clock_source_t;
+
+    /// Sets the modes of calling handlers, one for each handler in order, and the executor that
+    /// runs non-blocking ones.
+    ///
+    /// All handlers are blocking by default. Handlers keep being called in their order, i.e.
+    /// non-blocking ones are scheduled before blocking ones are called. When the executor queue is
+    /// full, handlers are called by the logging thread regardless of their mode. Records committed
+    /// by buffered scopes are always handled by the committing thread.
+    ///
+    /// Like the filter replacement this method blocks until concurrent logging events using the
+    /// previous modes complete, while detached handlers may still be running, which `flush` waits
+    /// for.
+    ///
+    /// \warning handlers called concurrently, i.e. non-blocking ones, must be thread-safe, and
+    ///     records of detached ones may be reordered if the executor has several threads.
+    /// \warning must not be called from inside of a handler, i.e. while logging.
+    /// \throw std::invalid_argument if the number of modes differs from the number of handlers.
+    /// \throw std::invalid_argument if there are non-blocking modes, but no executor.
+    auto offload(std::shared_ptr<executor_t> executor, std::vector<mode_t> modes) -> void;
+
     auto log(severity_t severity, const message_t& message) -> void;
     auto log(severity_t severity, const message_t& message, attribute_pack& pack) -> void;
     auto log(severity_t severity, const lazy_message_t& message, attribute_pack& pack) -> void;
 
+    /// Passes the given records to all handlers as a single batch, bypassing both the threshold and
+    /// the filter.
+    ///
+    /// Intended for committing records captured by buffered scopes, which have already passed both
+    /// checks, so they are neither checked nor captured again.
+    ///
+    /// \remark this method is thread-safe and can be called while logging.
+    auto dispatch(const record_t* records, std::size_t size) -> void;
+
+    /// Waits until all records logged before the call are emitted and flushed by all handlers, but
+    /// no longer than until the given deadline, returning `false` on timeout.
+    ///
+    /// Intended for graceful shutdown, which otherwise relies on asynchronous handlers and sinks
+    /// draining their queues on destruction.
+    ///
+    /// \remark this method is thread-safe and can be called while logging.
+    /// \warning must not be called from inside of a handler, i.e. while logging.
+    auto flush(std::chrono::steady_clock::time_point deadline) const -> bool;
+
+    /// Waits with the given timeout.
+    ///
+    /// \overload
+    auto flush(std::chrono::milliseconds timeout) const -> bool;
+
+    /// Returns a snapshot of self-metrics of this logger, its handlers and their sinks.
+    ///
+    /// Logger metrics are unlabeled, while metrics of handlers and sinks are labeled with their
+    /// positions, i.e. "handler" and "sink" labels. Counters are sharded by the updating thread
+    /// and aggregated here, so the snapshot is not atomic with respect to concurrent logging.
+    ///
+    /// \remark this method is thread-safe and can be called while logging.
+    auto metrics() const -> metrics::snapshot_t;
+
+    /// Returns the congestion state of all handlers taken together, i.e. the fill of the fullest
+    /// queue, the total number of drops and their recent rate, which is estimated over intervals
+    /// of at least 100 milliseconds between calls.
+    ///
+    /// Intended for applications shedding their optional logging before records start being
+    /// dropped.
+    ///
+    /// \remark this method is thread-safe and can be called while logging.
+    auto pressure() const -> pressure_t;
+
+    /// Returns the congestion state of the handler at the given position, without the drop rate.
+    ///
+    /// \throw std::out_of_range if there is no such handler.
+    auto pressure(std::size_t handler) const -> pressure_t;
+
+    /// Calls the given function once the pressure falls below the given level, which allows
+    /// coroutines and other tasks to suspend instead of blocking their thread or losing records
+    /// while queues are full.
+    ///
+    /// Returns `true` without calling the function if the pressure is already below the level, so
+    /// the caller may log right away. Otherwise the function is called once from the shared timer
+    /// thread, which polls the pressure every 10 milliseconds while there are waiters, or from the
+    /// destructor if the logger is destroyed first. Tasks bound to event loops should post their
+    /// resumption to them instead of resuming inline.
+    ///
+    /// \remark this method is thread-safe and can be called while logging.
+    /// \warning the function must not block.
+    auto async_wait(pressure_t::level_t level, std::function<void()> fn) -> bool;
+
+    /// Enables the adaptive threshold, which raises the severity threshold to the given one while
+    /// the pressure is at the engaging level or higher, restoring it once the pressure falls to the
+    /// releasing level or lower.
+    ///
+    /// The pressure is evaluated by logging threads once per 64 logging events each, so the
+    /// threshold follows the load without any background activity. Passing the minimum severity
+    /// value disables adaptation.
+    ///
+    /// \remark this method is thread-safe and can be called while logging.
+    auto adapt(severity_t severity, pressure_t::level_t engage = pressure_t::level_t::high,
+               pressure_t::level_t release = pressure_t::level_t::normal) noexcept -> void;
+
+    /// Returns a handle of the given category, creating the category together with its missing
+    /// ancestors, like "db" of "db.pool".
+    ///
+    /// Categories live as long as the logger, including its assignments, which keep categories and
+    /// their handles, applying thresholds of the categories assigned in the consumed logger.
+    ///
+    /// \throw std::invalid_argument if the name is empty or has empty dot separated components.
+    /// \remark this method is thread-safe and can be called while logging.
+    auto category(const string_view& name) -> category_t;
+
+    /// Sets the minimum severity level for logging events of the given category and its
+    /// descendants having no threshold of their own, replacing the logger threshold for them.
+    ///
+    /// \throw std::invalid_argument if the name is empty or has empty dot separated components.
+    /// \remark this method is thread-safe and can be called while logging.
+    auto threshold(const string_view& category, severity_t severity) -> void;
+
+    /// Drops the threshold of the given category, which inherits the one of its parent instead, or
+    /// the logger threshold if no ancestor has a threshold.
+    ///
+    /// \throw std::invalid_argument if the name is empty or has empty dot separated components.
+    /// \remark this method is thread-safe and can be called while logging.
+    auto inherit(const string_view& category) -> void;
+
     auto manager() -> scope::manager_t&;
 
 private:
+    friend class category_t;
+
+    /// Checks the given severity against the given threshold and the adaptive one.
+    auto admit(severity_t severity, int threshold) const noexcept -> bool;
+
+    /// Logs bypassing the threshold check, which categories perform by themselves.
+    auto forward(severity_t severity, const message_t& message, attribute_pack& pack) -> void;
+    auto forward(severity_t severity, const lazy_message_t& message, attribute_pack& pack) -> void;
+
+    /// Calls waiters whose levels the pressure has fallen below.
+    auto wake() -> void;
+
     template<typename F>
     auto consume(severity_t severity, const string_view& pattern, attribute_pack& pack, const F& fn) -> void;
 };
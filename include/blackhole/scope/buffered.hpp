@@ -0,0 +1,114 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <initializer_list>
+#include <memory>
+#include <vector>
+
+#include "blackhole/scope/holder.hpp"
+#include "blackhole/severity.hpp"
+
+#include "blackhole/detail/recordbuf.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+
+class root_logger_t;
+
+}  // namespace v1
+}  // namespace blackhole
+
+namespace blackhole {
+inline namespace v1 {
+namespace scope {
+
+/// Scoped attributes guard, which additionally captures all records logged by the root logger
+/// inside its scope, including nested ones, instead of passing them to handlers.
+///
+/// When the scope closes the captured records are either discarded or committed as a single
+/// batch depending on the outcome: they are committed if any of them has the given severity or
+/// higher, or if the scope has lived for the given latency or longer. Committed records are passed
+/// to the enclosing buffered scope if there is one, otherwise to handlers of the logger, which are
+/// able to pass them to each sink as a single batch, allowing it to write all lines of a request
+/// at once.
+///
+/// For example, keeping the debug context of failed or slow requests only:
+///     scope::buffered_holder_t holder(logger, {3, std::chrono::milliseconds(100)}, {
+///         {"request_id", 42}
+///     });
+///
+/// Records are captured into an arena of the scope, which is allocated in chunks on demand, so
+/// capturing typically requires no allocations besides the chunks themselves.
+///
+/// \warning the scope must be closed by the thread it was opened by, as any other scoped guard.
+class buffered_holder_t : public holder_t {
+public:
+    /// Outcome conditions, which make captured records to be committed.
+    struct policy_t {
+        /// Minimum severity of any captured record.
+        severity_t severity;
+        /// Minimum scope lifetime.
+        std::chrono::microseconds latency;
+    };
+
+    /// Default size of arena chunks in bytes.
+    static constexpr std::size_t chunk = 16 * 1024;
+
+private:
+    typedef std::max_align_t block_type;
+
+    enum class decision_t {
+        none,
+        commit,
+        discard
+    };
+
+    root_logger_t& logger;
+    const policy_t policy;
+    const std::chrono::steady_clock::time_point birth;
+    decision_t decision;
+    bool failed;
+
+    std::vector<detail::recordbuf_t> records;
+    std::vector<std::unique_ptr<block_type[]>> chunks;
+    /// Number of used bytes in the last chunk.
+    std::size_t offset;
+
+public:
+    /// Constructs a buffered scope attaching the given attributes.
+    buffered_holder_t(root_logger_t& logger, policy_t policy, attributes_t attributes);
+
+    /// Constructs a buffered scope from the braced list of attributes.
+    ///
+    /// \overload
+    buffered_holder_t(root_logger_t& logger, policy_t policy,
+                      std::initializer_list<compact_attribute_t> attributes);
+
+    /// Either commits or discards captured records, unless the decision has already been made
+    /// explicitly.
+    ~buffered_holder_t();
+
+    /// Makes captured records to be committed when the scope closes regardless of the outcome.
+    auto commit() noexcept -> void;
+
+    /// Makes captured records to be discarded when the scope closes regardless of the outcome.
+    auto discard() noexcept -> void;
+
+    /// Returns the number of records captured so far.
+    auto size() const noexcept -> std::size_t;
+
+    auto capture(const record_t& record) -> void override;
+
+private:
+    /// Places the given record into the arena, falling back to the heap for records larger than
+    /// a chunk.
+    auto place(const record_t& record) -> detail::recordbuf_t;
+
+    /// Passes all captured records further as a batch.
+    auto flush() -> void;
+};
+
+}  // namespace scope
+}  // namespace v1
+}  // namespace blackhole
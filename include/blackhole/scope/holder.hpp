@@ -1,8 +1,12 @@
 #pragma once
 
+#include <initializer_list>
+#include <memory>
+
 #include "blackhole/scope/watcher.hpp"
 
 #include "blackhole/attribute.hpp"
+#include "blackhole/attribute/compact.hpp"
 #include "blackhole/attributes.hpp"
 
 namespace blackhole {
@@ -12,7 +16,8 @@ namespace scope {
 /// Implementation of scoped attributes guard that keeps attributes provided on construction and
 /// provides them each time on demand.
 class holder_t : public watcher_t {
-    attributes_t storage;
+    std::unique_ptr<const attributes_t> functions;
+    compact_attributes_t storage;
     attribute_list list;
 
 public:
@@ -22,6 +27,12 @@ public:
     /// \note creating multiple scoped watch objects results in attributes stacking.
     holder_t(logger_t& logger, attributes_t attributes);
 
+    /// Constructs a scoped guard from the braced list of attributes, which are kept in the compact
+    /// form, so typical short keys and values require no allocation.
+    ///
+    /// \note this overload is preferred for braced lists, including empty ones.
+    holder_t(logger_t& logger, std::initializer_list<compact_attribute_t> attributes);
+
     /// Returns an immutable reference to the internal attribute list.
     auto attributes() const -> const attribute_list&;
 };
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+
+#include "blackhole/trace.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace scope {
+
+/// Scoped guard, which sets the trace context of the calling thread on construction, making every
+/// further record created in this thread carry it inline, and restores the previous one on
+/// destruction.
+///
+/// Unlike scoped attributes the context is not bound to any logger, and setting it requires no
+/// allocation.
+///
+/// \warning guards **must** be destroyed in reversed order they were created on the same thread,
+///     otherwise the behavior is undefined.
+class span_t {
+    trace_t prev;
+
+public:
+    /// Enters the span of the given trace context.
+    explicit span_t(const trace_t& trace) noexcept;
+
+    /// Enters the span with the given id within the current trace.
+    explicit span_t(std::uint64_t span) noexcept;
+
+    ~span_t();
+
+    span_t(const span_t& other) = delete;
+    auto operator=(const span_t& other) -> span_t& = delete;
+
+    /// Returns the trace context that was current before entering this span.
+    auto parent() const noexcept -> const trace_t&;
+};
+
+}  // namespace scope
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+
+#include "blackhole/scope/watcher.hpp"
+
+#include "blackhole/attribute.hpp"
+#include "blackhole/attributes.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace scope {
+
+/// Scoped attributes guard for a fixed number of attributes, which owns neither keys nor values,
+/// but keeps views over them in place.
+///
+/// Unlike `holder_t` it copies no strings and has no separate storage besides the list published
+/// to loggers, so it requires no allocation as long as the number of attributes fits the inline
+/// capacity of `attribute_list`. This makes it suitable for guards created per request, like:
+///     const scope::static_holder_t<2> holder(logger, {{"method", "GET"}, {"id", 42}});
+///
+/// \warning keys and string values must outlive the guard, i.e. be literals or be owned by the
+///     caller for the whole scope.
+template<std::size_t N>
+class static_holder_t : public watcher_t {
+public:
+    typedef view_of<attribute_t>::type value_type;
+
+private:
+    attribute_list list;
+
+public:
+    /// Constructs a scoped guard which will attach views over the given attributes to the
+    /// specified logger making every further log event to contain them until keeped alive.
+    ///
+    /// The number of attributes is checked at compile time to be exactly `N`.
+    template<std::size_t M>
+    static_holder_t(logger_t& logger, const value_type (&attributes)[M]) :
+        watcher_t(logger),
+        list(attributes, attributes + M)
+    {
+        static_assert(M == N, "the number of attributes must match the holder size");
+    }
+
+    auto attributes() const -> const attribute_list& override {
+        return list;
+    }
+};
+
+}  // namespace scope
+}  // namespace v1
+}  // namespace blackhole
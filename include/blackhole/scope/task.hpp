@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+
+#include "blackhole/attributes.hpp"
+#include "blackhole/trace.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace scope {
+
+class watcher_t;
+
+/// Scoped attributes stacks and the trace context of a task, like a coroutine or a chain of strand
+/// handlers, which interleaves with other tasks on the same thread.
+///
+/// While a task is resumed on a thread using `resume_t`, scoped attributes guards created and
+/// looked up by loggers are kept in the task instead of the thread, so they follow the task across
+/// suspensions and threads without leaking into other tasks. Switching tasks is just a pair of
+/// pointer swaps plus copying the trace context, and a task allocates nothing unless it is used
+/// with more than a few loggers.
+///
+/// \warning scoped guards created while a task is resumed must be destroyed while it is resumed
+///     again, in reversed order they were created, as usual.
+/// \note the task must outlive all its resumptions.
+class task_t {
+public:
+    /// Current watcher of some manager, tagged with the manager generation.
+    struct slot_t {
+        std::uint64_t generation;
+        watcher_t* watcher;
+    };
+
+private:
+#ifdef BLACKHOLE_HAVE_SMALL_VECTOR
+    boost::container::small_vector<slot_t, 4> slots;
+#else
+    std::vector<slot_t> slots;
+#endif
+
+    trace_t trace;
+
+    friend class resume_t;
+
+public:
+    task_t() noexcept;
+
+    task_t(const task_t& other) = delete;
+    auto operator=(const task_t& other) -> task_t& = delete;
+
+    /// Returns the slot of the manager with the given id, adding empty slots on demand.
+    auto slot(std::uint32_t id) -> slot_t&;
+
+    /// Returns the task resumed on the calling thread, nullptr if there is none.
+    static auto current() noexcept -> task_t*;
+};
+
+/// Resumes the given task on the calling thread until destroyed, making its scoped attributes and
+/// trace context current, and then switches back to the previous task or the thread itself.
+///
+/// For example, being created in each handler of an asio strand or in `await_resume` of a C++20
+/// coroutine awaiter.
+class resume_t {
+    task_t& task;
+    task_t* prev;
+    trace_t saved;
+
+public:
+    explicit resume_t(task_t& task) noexcept;
+    ~resume_t();
+
+    resume_t(const resume_t& other) = delete;
+    auto operator=(const resume_t& other) -> resume_t& = delete;
+};
+
+}  // namespace scope
+}  // namespace v1
+}  // namespace blackhole
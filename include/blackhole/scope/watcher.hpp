@@ -1,11 +1,13 @@
 #pragma once
 
+#include "blackhole/attribute.hpp"
 #include "blackhole/attributes.hpp"
 
 namespace blackhole {
 inline namespace v1 {
 
 class logger_t;
+class record_t;
 
 }  // namespace v1
 }  // namespace blackhole
@@ -25,12 +27,26 @@ class manager_t;
 /// living to most ones. This means, that the least attached attributes have more priority, but
 /// they don't override each other, i.e duplicates are allowed.
 ///
+/// Attributes of nested scopes are collected as a single flattened list, which is built on the
+/// first collection and cached until the scope is destroyed, so deep nesting costs nothing on
+/// further logging events. Outer scopes are never modified while inner ones are alive, hence the
+/// cache remains valid after inner scopes are popped.
+///
 /// \warning explicit moving instances of this class will probably invoke an undefined behavior,
 ///     because it can violate construction/destruction order, which is strict.
 class watcher_t {
     std::reference_wrapper<manager_t> manager;
     watcher_t* prev;
 
+    /// Innermost watcher capturing records logged inside this scope, which is either this one or
+    /// the one inherited from outer scopes, null if there is no such watcher.
+    watcher_t* interceptor;
+
+    /// Attributes of this scope followed by the ones of all outer scopes, built lazily, because
+    /// derived classes' attributes are not available during construction.
+    mutable attribute_list chain;
+    mutable bool ready;
+
 public:
     /// Constructs a scoped attributes watch which will be associated with the specified logger.
     explicit watcher_t(logger_t& logger);
@@ -50,16 +66,47 @@ public:
     auto operator=(const watcher_t& other) -> watcher_t& = delete;
     auto operator=(watcher_t&& other) -> watcher_t& = delete;
 
-    /// Recursively collects all scoped attributes into the given attributes pack.
+    /// Collects all scoped attributes into the given attributes pack as a single list.
     auto collect(attribute_pack& pack) const -> void;
 
+    /// Returns the innermost watcher capturing records logged inside this scope, if any.
+    ///
+    /// Records logged by the root logger inside of such scope, which have passed its filter, are
+    /// passed to the `capture` method of the returned watcher instead of handlers.
+    auto capturing() const noexcept -> watcher_t* {
+        return interceptor;
+    }
+
+    /// Captures the given record logged inside this scope or nested ones.
+    ///
+    /// The default implementation does nothing, since only watchers that called `intercept` ever
+    /// receive records.
+    virtual auto capture(const record_t& record) -> void;
+
     /// Recursively rebind all scoped attributes with the new logger manager.
     ///
     /// Usually called in the middle of the logger's move operation.
     auto rebind(manager_t& manager) -> void;
 
     /// Returns an immutable reference to the internal attribute list.
+    ///
+    /// \note the list must not be changed during the watcher lifetime.
     virtual auto attributes() const -> const attribute_list& = 0;
+
+protected:
+    /// Makes this watcher capture all records logged inside its scope, including nested ones.
+    auto intercept() noexcept -> void {
+        interceptor = this;
+    }
+
+    /// Returns the innermost watcher capturing records among outer scopes, if any.
+    auto enclosing() const noexcept -> watcher_t* {
+        return prev ? prev->interceptor : nullptr;
+    }
+
+private:
+    /// Returns attributes of this and all outer scopes.
+    auto flattened() const -> const attribute_list&;
 };
 
 }  // namespace scope
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <chrono>
+#include <cstddef>
 #include <string>
 
 namespace blackhole {
@@ -16,8 +18,26 @@ typedef basic_string_view<char, std::char_traits<char>> string_view;
 using stdext::string_view;
 
 class record_t;
+struct pressure_t;
+
+namespace metrics {
+class collector_t;
+}  // namespace metrics
 
 class sink_t {
+public:
+    /// Represents a single sink event, i.e. a record accompanied with its formatted message.
+    struct event_t {
+        const record_t* record;
+        const string_view* message;
+    };
+
+    /// Represents a writable region of the sink own output buffer.
+    struct region_t {
+        char* data;
+        std::size_t size;
+    };
+
 public:
     sink_t() = default;
     sink_t(const sink_t& other) = default;
@@ -29,6 +49,67 @@ public:
     auto operator=(sink_t&& other) -> sink_t& = default;
 
     virtual auto emit(const record_t& record, const string_view& message) -> void = 0;
+
+    /// Emits the given contiguous batch of events at once.
+    ///
+    /// Sinks that are able to amortize locking or system calls over multiple events, like file or
+    /// socket ones, should override this method. The default implementation just calls `emit` for
+    /// each event.
+    ///
+    /// \note an exception thrown while emitting an event interrupts the whole batch.
+    virtual auto emit_batch(const event_t* events, std::size_t size) -> void;
+
+    /// Emits the formatted message of the given record split into the given slices, which large
+    /// strings the message contains are referenced by instead of being copied.
+    ///
+    /// Sinks writing through system calls accepting gather lists, like file ones, and sinks owning
+    /// records, like asynchronous ones, should override this method to save copying. The default
+    /// implementation concatenates slices and calls `emit`.
+    virtual auto emit_gathered(const record_t& record, const string_view* slices,
+                               std::size_t count) -> void;
+
+    /// Lends a writable region of at least the given size from the sink output buffer, so that
+    /// handlers can format the given record right there instead of having it copied by `emit`.
+    ///
+    /// Every lent region must be given back by either `commit` or `cancel` from the same thread.
+    /// The sink stays locked until then, which is why handlers lend regions only when the sink is
+    /// the single consumer of the formatted record. Sinks writing records through a buffer shared
+    /// between them, like file ones, may override this method. The default implementation lends
+    /// nothing, returning an empty region, meaning the record must be emitted the usual way.
+    virtual auto lend(const record_t& record, std::size_t size) -> region_t;
+
+    /// Emits the first given bytes of the lent region as the formatted message of the given record,
+    /// giving the region back.
+    virtual auto commit(const record_t& record, std::size_t size) -> void;
+
+    /// Gives the lent region back without emitting anything.
+    virtual auto cancel() noexcept -> void;
+
+    /// Waits until all events emitted before the call are written to the sink destination, but no
+    /// longer than until the given deadline, returning `false` on timeout.
+    ///
+    /// Sinks that defer writing, like asynchronous one, should override this method. The default
+    /// implementation does nothing and returns `true`.
+    ///
+    /// \warning must be thread-safe.
+    virtual auto flush(std::chrono::steady_clock::time_point deadline) -> bool;
+
+    /// Collects self-metrics of this sink into the given collector.
+    ///
+    /// Emitted records and bytes are accounted by handlers, so only sinks with an internal state
+    /// worth observing, like queues, should override this method. The default implementation
+    /// collects nothing.
+    ///
+    /// \warning must be thread-safe.
+    virtual auto collect(metrics::collector_t& collector) const -> void;
+
+    /// Returns the congestion state of this sink.
+    ///
+    /// Sinks queueing records, like asynchronous one, should override this method. The default
+    /// implementation returns no pressure.
+    ///
+    /// \warning must be thread-safe.
+    virtual auto pressure() const -> pressure_t;
 };
 
 }  // namespace v1
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "blackhole/factory.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+
+/// Represents a columnar sink, which accumulates records into batches written to the file as an
+/// Apache Arrow IPC stream, readable by analytics tools without parsing text.
+///
+/// Each batch has columns of well-known record fields followed by columns of configured
+/// attributes, typed according to attribute value types.
+class arrow_t;
+
+}  // namespace sink
+
+template<>
+class factory<sink::arrow_t> : public factory<sink_t> {
+    const registry_t& registry;
+
+public:
+    constexpr explicit factory(const registry_t& registry) noexcept :
+        registry(registry)
+    {}
+
+    auto type() const noexcept -> const char* override;
+
+    /// \throw std::invalid_argument if the path is missing, a column is malformed or any of the
+    ///     limits is zero.
+    auto from(const config::node_t& config) const -> std::unique_ptr<sink_t> override;
+};
+
+}  // namespace v1
+}  // namespace blackhole
@@ -24,9 +24,82 @@ namespace sink {
 /// events that weren't enqueued. The second one will block the caller thread until the queue is
 /// full.
 ///
+/// Underflow policy decides what the consumer thread does when the queue is empty. The "wait"
+/// policy, which is the default one, spins for a while and then parks the thread until producers
+/// enqueue something, while "sleep" just polls the queue every millisecond.
+///
+/// The batch value limits the number of records the consumer thread processes per wakeup, 256 by
+/// default.
+///
+/// Queue mode decides how records are stored while waiting for the consumer thread. The "queue"
+/// mode, which is the default one, keeps owned record copies in a lock-free queue of exp2(factor)
+/// items. The "ring" mode serializes records into a preallocated byte ring of exp2(factor) * 256
+/// bytes, avoiding memory allocations at the cost of dropping records that are larger than the
+/// whole ring.
+///
+/// The memory object configures paging of rings, which are allocated by the thread constructing
+/// the sink and thus placed on its NUMA node: "huge" backs them with huge pages, either reserved
+/// or transparent ones, "populate" prefaults all pages, so they are never faulted while logging,
+/// and "lock" locks them in memory. All properties are disabled by default.
+///
+/// The lanes value splits the storage into several independent queues (or rings) of the same
+/// capacity, 1 by default, which reduces contention between producer threads. The consumer thread
+/// drains lanes in a round-robin manner, taking up to batch / lanes records from each one. The
+/// sharding value decides how producers pick their lane: "thread", which is the default one, maps
+/// every thread to a fixed lane and keeps per-thread ordering, while "cpu" picks the lane of the
+/// CPU the thread is running on, which may reorder records of migrating threads. When the ordered
+/// flag is set, records of each batch are additionally merged by their timestamps.
+///
+/// The fairness object shares the capacity between record sources, like tenants or components,
+/// told apart by the value of the given attribute, so a burst of one source can only exhaust its
+/// own share. Listed values get their own lanes of exp2(factor) records and weights, while others
+/// are spread by hashes over the given number of bucket lanes, 1 by default. The consumer drains
+/// them using deficit round-robin, crediting each lane with its weight times the quantum of
+/// message bytes per round, 1024 by default. For example, `{"attribute": "tenant", "shares":
+/// [{"value": "billing", "weight": 4}], "buckets": 4}`.
+///
+/// The expiry object sets the maximum age of queued records in milliseconds, like `{"max_age":
+/// 5000}`. Records older than that by the time the consumer dequeues them are dropped and counted
+/// as expired instead of being emitted, so the sink catches up quickly after overload spikes. With
+/// the summary flag set each batch of expired records is collapsed into a single summary record
+/// with the highest severity among them. Expiration is disabled by default.
+///
+/// The flush-through object makes records of at least the given severity synchronous, like `{
+/// "threshold": 4, "timeout": 1000}`. The logging thread enqueues such a record and waits until
+/// the consumer has emitted it along with records of its lane queued before and flushed the
+/// wrapped sink, but no longer than the timeout in milliseconds, 1000 by default. Flush-through
+/// records are serialized with each other. It's disabled by default.
+///
+/// The elastic object lets lanes grow under bursts, like `{"segments": 16, "idle": 1000}`. Each
+/// lane starts with its exp2(factor) capacity and chains segments of the same capacity up to the
+/// given number of them once full, so overflow policies apply at the maximum capacity only.
+/// Segments are released once the lane hasn't grown for the idle period in milliseconds, 1000 by
+/// default. Lanes have a single segment by default.
+///
+/// When the numa flag is set, the sink is replicated for each NUMA node of the host: every node
+/// gets its own queue bound to the node memory and its own consumer thread pinned to the node
+/// CPUs, unless the thread properties say otherwise, and producers enqueue into the queue of the
+/// node they are running on. Node consumers either share the single wrapped sink or, if the
+/// "sinks" list is given instead, write into their own sinks taken from it in the order of node
+/// ids, for example into per-node files.
+///
 /// \throw std::invalid_argument on construction if the factor is greater than 20.
 /// \throw std::invalid_argument on construction if the overflow policy value differs from "drop" or
 ///     "wait".
+/// \throw std::invalid_argument on construction if the underflow policy value differs from "sleep"
+///     or "wait".
+/// \throw std::invalid_argument on construction if the mode value differs from "queue" or "ring".
+/// \throw std::invalid_argument on construction if any memory property is set in "queue" mode.
+/// \throw std::invalid_argument on construction if the number of elastic segments is not in
+///     [1; 256] range or exceeds one in "ring" mode.
+/// \throw std::system_error on construction if unable to either map or lock ring pages.
+/// \throw std::invalid_argument on construction if the lanes value is zero.
+/// \throw std::invalid_argument on construction if the "sinks" list has fewer sinks than there are
+///     NUMA nodes.
+/// \throw std::invalid_argument on construction if the sharding value differs from "thread" or
+///     "cpu".
+/// \throw std::invalid_argument on construction if fair sharing is combined with multiple lanes,
+///     has no buckets, repeated values or zero weights.
 class asynchronous_t;
 
 }  // namespace sink
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <chrono>
 #include <functional>
 
 #include "blackhole/factory.hpp"
@@ -54,6 +55,14 @@ public:
     auto colorize(std::function<termcolor_t(const record_t& record)> fn) & -> builder&;
     auto colorize(std::function<termcolor_t(const record_t& record)> fn) && -> builder&&;
 
+    /// Enables buffered mode, which writes messages directly into the file descriptor of the
+    /// destination stream with a single `write` call once either the given number of bytes is
+    /// pending or the oldest pending message is older than the given interval.
+    ///
+    /// Zero interval disables time-based writes.
+    auto buffered(std::size_t capacity, std::chrono::milliseconds interval) & -> builder&;
+    auto buffered(std::size_t capacity, std::chrono::milliseconds interval) && -> builder&&;
+
     /// Consumes this builder yielding a newly created console sink with the options configured.
     auto build() && -> std::unique_ptr<sink_t>;
 };
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <chrono>
 #include <memory>
 #include <ratio>
 
@@ -7,13 +8,19 @@
 
 namespace blackhole {
 inline namespace v1 {
+namespace detail {
+
+struct paging_t;
+
+}  // namespace detail
+
 namespace sink {
 
 /// Represents a sink that writes formatted log events to the file or files located at the specified
 /// path.
 ///
-/// The path can contain attribute placeholders, meaning that the real destination name will be
-/// deduced at runtime using provided log record. No real file will be opened at construction
+/// The path can contain string formatter placeholders, meaning that the real destination name will
+/// be deduced at runtime using provided log record. No real file will be opened at construction
 /// time.
 /// All files are opened by default in append mode meaning seek to the end of stream immediately
 /// after open.
@@ -115,6 +122,188 @@ public:
     auto flush_every(std::size_t events) & -> builder&;
     auto flush_every(std::size_t events) && -> builder&&;
 
+    /// Specifies flush threshold in terms of time elapsed since the first unflushed write.
+    ///
+    /// Besides checking on each write, idle files are polled by a shared timer thread, so pending
+    /// data reaches the file after at most about the given interval even without further writes.
+    ///
+    /// \note the timer has a 10 ms resolution.
+    ///
+    /// \param interval flush interval.
+    auto flush_every(std::chrono::milliseconds interval) & -> builder&;
+    auto flush_every(std::chrono::milliseconds interval) && -> builder&&;
+
+    /// Specifies combined flush threshold, which fires after either the given number of bytes
+    /// written or the given interval elapsed, whichever comes first.
+    ///
+    /// \param bytes flush threshold in bytes.
+    /// \param interval flush interval.
+    auto flush_every(bytes_t bytes, std::chrono::milliseconds interval) & -> builder&;
+    auto flush_every(bytes_t bytes, std::chrono::milliseconds interval) && -> builder&&;
+
+    /// Specifies the userspace buffer size for writing files through raw file descriptors instead
+    /// of standard file streams.
+    ///
+    /// Buffered data is written when the buffer is full or when the flush policy fires, so the
+    /// buffer size effectively limits flush thresholds.
+    ///
+    /// \note setting zero value resets to standard file streams, which is the default.
+    ///
+    /// \param bytes buffer size, which is rounded up to the multiple of the page size.
+    auto buffer(bytes_t bytes) & -> builder&;
+    auto buffer(bytes_t bytes) && -> builder&&;
+
+    /// Specifies paging properties of the userspace buffer memory, allowing to back it with huge
+    /// pages, to prefault and to lock it in memory.
+    ///
+    /// \note applies to raw file descriptor buffers only, building a sink with any property set
+    ///     without the buffer size or in any other mode throws `std::invalid_argument`.
+    auto memory(const detail::paging_t& paging) & -> builder&;
+    auto memory(const detail::paging_t& paging) && -> builder&&;
+
+    /// Specifies the write-behind window, keeping the page cache footprint of written files flat.
+    ///
+    /// Each time the given number of bytes is written out of the userspace buffer, writing them
+    /// back is started with `sync_file_range`, and pages of the previous window are dropped from
+    /// the page cache with `posix_fadvise`, so logging neither evicts hot pages of other files nor
+    /// accumulates dirty pages to be flushed in a single burst stalling unrelated I/O.
+    ///
+    /// \note applies to raw file descriptor buffers only, building a sink with the window set
+    ///     without the buffer size or in any other mode throws `std::invalid_argument`. Ignored on
+    ///     systems other than Linux.
+    ///
+    /// \param bytes write-behind window, zero disables write-behind, which is the default.
+    auto writeback(bytes_t bytes) & -> builder&;
+    auto writeback(bytes_t bytes) && -> builder&&;
+
+    /// Specifies the size of chunks file extents are preallocated in ahead of the write offset.
+    ///
+    /// Extents are allocated with `fallocate(FALLOC_FL_KEEP_SIZE)`, so the file size grows with the
+    /// data written only, while appends neither update block allocation metadata nor fragment the
+    /// file each time. Extents left beyond the end are trimmed when the file is closed, either on
+    /// rotation or on destruction, unless other writers have grown the file since.
+    ///
+    /// \note applies to raw file descriptor buffers only, building a sink with the chunk set
+    ///     without the buffer size or in any other mode throws `std::invalid_argument`. Ignored on
+    ///     systems or file systems not supporting preallocation.
+    ///
+    /// \param bytes preallocation chunk, zero disables preallocation, which is the default.
+    auto preallocate(bytes_t bytes) & -> builder&;
+    auto preallocate(bytes_t bytes) && -> builder&&;
+
+    /// Enables per-thread buffering, which allows logging threads to write into the same file
+    /// without serializing on a single lock.
+    ///
+    /// Each thread collects whole lines into its own buffer, sized by `buffer` or 64 KiB by
+    /// default, which is written out by the thread itself when full or when the flush policy
+    /// fires, and by the background thread every 100 milliseconds otherwise.
+    ///
+    /// \note lines are written in the order of buffer commits, not the order of logging events.
+    auto threaded() & -> builder&;
+    auto threaded() && -> builder&&;
+
+    /// Makes the sink submit writes through io_uring instead of writing them synchronously.
+    ///
+    /// Lines are collected into a set of rotating buffers sized by `buffer` or 64 KiB by default.
+    /// Full buffers are submitted without waiting for completion, so logging threads block only
+    /// when all buffers are in flight. Plain writes are used if io_uring is not available.
+    ///
+    /// \note supported only in the default stream mode, neither threaded nor durable one.
+    auto uring() & -> builder&;
+    auto uring() && -> builder&&;
+
+    /// Enables durable mode, in which emitting returns only after the data reaches the storage
+    /// device.
+    ///
+    /// Concurrent emits are committed in groups: one of the writers performs a single write
+    /// followed by `fdatasync` for the whole group, releasing all the others at once. Flush
+    /// policies and buffering options are ignored in this mode.
+    ///
+    /// \note durable and threaded modes are mutually exclusive, building such sink throws
+    ///     `std::invalid_argument`.
+    auto durable() & -> builder&;
+    auto durable() && -> builder&&;
+
+    /// Enables isolated mode, in which each logging thread writes into files of its own, sharing no
+    /// locks or buffers with other threads.
+    ///
+    /// Destination names get the kernel thread id inserted before the extension, like
+    /// `app.<tid>.log` for `app.log`. All stream options apply to each per-thread file, and the
+    /// open files limit is counted per thread. Lines of all threads can be merged back into a
+    /// single ordered stream using `sink::file::merge`.
+    ///
+    /// \note isolated mode is supported only in the default stream mode, neither threaded nor
+    ///     durable one.
+    auto isolated() & -> builder&;
+    auto isolated() && -> builder&&;
+
+    /// Specifies the maximum number of simultaneously open files, which is 1024 by default.
+    ///
+    /// When the path pattern produces more destinations, the least recently used files are closed,
+    /// flushing their buffers, and reopened on demand.
+    ///
+    /// \param count open files limit, zero value is treated as one.
+    auto max_files(std::size_t count) & -> builder&;
+    auto max_files(std::size_t count) && -> builder&&;
+
+    /// Specifies rotation threshold in terms of bytes written into a single file.
+    ///
+    /// When exceeded, the file is renamed to the timestamped archive name, like
+    /// `app.log.20160718-153000.000042`, and a new file is opened in its place. Writers are never
+    /// blocked by archived files processing, which is performed on the background thread.
+    ///
+    /// \note setting zero value disables size-based rotation, which is the default.
+    auto rotate_every(bytes_t bytes) & -> builder&;
+    auto rotate_every(bytes_t bytes) && -> builder&&;
+
+    /// Specifies rotation interval, which is counted from the moment the file is opened.
+    ///
+    /// \note setting zero value disables time-based rotation, which is the default.
+    auto rotate_every(std::chrono::seconds interval) & -> builder&;
+    auto rotate_every(std::chrono::seconds interval) && -> builder&&;
+
+    /// Specifies the number of archived files to keep for each destination, removing older ones.
+    ///
+    /// \note setting zero value keeps all archives, which is the default.
+    auto backups(std::size_t count) & -> builder&;
+    auto backups(std::size_t count) && -> builder&&;
+
+    /// Enables gzip compression of archived files.
+    auto compress() & -> builder&;
+    auto compress() && -> builder&&;
+
+    /// Enables inline gzip compression of written files.
+    ///
+    /// Each time the flush policy fires the current compressed block is completed, so the data
+    /// written so far can be decompressed while the file is still being written. Compression is
+    /// performed by emitting threads, i.e. by the consumer thread when wrapped into an asynchronous
+    /// sink.
+    ///
+    /// \note supported only in the default stream mode, neither threaded nor durable one.
+    ///
+    /// \param level compression level from 1 to 9.
+    /// \throw std::invalid_argument if the compression level is out of range.
+    auto gzip(int level = 6) & -> builder&;
+    auto gzip(int level = 6) && -> builder&&;
+
+    /// Makes each file maintain a sidecar time index, which maps record timestamps to byte offsets
+    /// allowing to seek directly to the lines of the given time window.
+    ///
+    /// The index is stored next to the file with the ".idx" suffix and gets an entry after either
+    /// the interval elapsed in terms of record timestamps or the given number of bytes written,
+    /// whichever comes first. Entries are appended each time the flush policy fires. Rotation
+    /// restarts the index, so archived files are left without one.
+    ///
+    /// \note supported only in the default stream mode without compression, neither threaded nor
+    ///     durable one.
+    ///
+    /// \param interval indexing interval, zero disables time-based entries.
+    /// \param bytes indexing threshold in bytes, zero disables size-based entries.
+    auto index(std::chrono::milliseconds interval = std::chrono::seconds(1),
+               bytes_t bytes = bytes_t(1024 * 1024)) & -> builder&;
+    auto index(std::chrono::milliseconds interval = std::chrono::seconds(1),
+               bytes_t bytes = bytes_t(1024 * 1024)) && -> builder&&;
+
     /// Consumes this builder, returning a newly created file sink with the options configured.
     auto build() && -> std::unique_ptr<sink_t>;
 };
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+#include "blackhole/stdext/string_view.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+namespace file {
+
+/// Returns names of per-thread files written by isolated file sinks instead of the given one,
+/// like `app.<tid>.log` for `app.log`, sorted by name. Archived files are not included.
+///
+/// \throw std::system_error if unable to list the directory.
+auto isolated(const std::string& path) -> std::vector<std::string>;
+
+/// Merges lines of the given files into the stream, performing the k-way merge by line keys.
+///
+/// Lines of each file are expected to be already ordered, like the ones written by a single
+/// thread, and are never reordered relative to each other. Lines with equal keys are taken from
+/// files in the given order.
+///
+/// Keys are the whole lines by default, which orders lines by their timestamps as long as lines
+/// start with fixed-width ones, like ISO 8601, or the given function extracting them otherwise.
+/// Returned keys must refer to the line passed.
+///
+/// \returns the number of lines written.
+/// \throw std::system_error if unable to open one of the files.
+auto merge(const std::vector<std::string>& paths,
+           std::ostream& stream,
+           std::function<string_view(const string_view& line)> key = nullptr) -> std::size_t;
+
+}  // namespace file
+}  // namespace sink
+}  // namespace v1
+}  // namespace blackhole
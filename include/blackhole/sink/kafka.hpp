@@ -0,0 +1,34 @@
+#pragma once
+
+#include "blackhole/factory.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+
+/// Represents a Kafka producer sink, which enqueues formatted records into librdkafka internal
+/// queue, never blocking on network I/O.
+///
+/// Available only if the library has been built with `ENABLE_KAFKA` option.
+class kafka_t;
+
+}  // namespace sink
+
+template<>
+class factory<sink::kafka_t> : public factory<sink_t> {
+    const registry_t& registry;
+
+public:
+    constexpr explicit factory(const registry_t& registry) noexcept :
+        registry(registry)
+    {}
+
+    auto type() const noexcept -> const char* override;
+
+    /// \throw std::invalid_argument if either "brokers" or "topic" option is missing or librdkafka
+    ///     rejects the configuration.
+    auto from(const config::node_t& config) const -> std::unique_ptr<sink_t> override;
+};
+
+}  // namespace v1
+}  // namespace blackhole
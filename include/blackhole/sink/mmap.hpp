@@ -0,0 +1,72 @@
+#pragma once
+
+#include <chrono>
+#include <memory>
+
+#include "blackhole/factory.hpp"
+#include "blackhole/sink/file.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+
+/// Represents a sink that appends formatted log events into a memory-mapped ring file.
+///
+/// The file is preallocated and mapped at construction, after which logging never enters the
+/// kernel: each event reserves its place by atomically advancing the tail and is copied directly
+/// into the mapping. Since written data immediately lands in the page cache, it survives process
+/// crashes. When the ring is full, the oldest events are overwritten.
+///
+/// The file starts with a single page header, containing the ring capacity and the tail position,
+/// followed by the data ring itself. The oldest event can be found by seeking to the tail modulo
+/// capacity.
+///
+/// \remark All methods of this class are thread safe.
+class mmap_t;
+
+}  // namespace sink
+
+/// Represents a memory-mapped sink builder to ease its configuration.
+template<>
+class builder<sink::mmap_t> {
+    class inner_t;
+    std::unique_ptr<inner_t, deleter_t> p;
+
+public:
+    /// Constructs a memory-mapped sink builder with the given destination file path.
+    ///
+    /// By default the ring capacity is 64 MiB and dirty pages are scheduled for writing back every
+    /// second.
+    explicit builder(const std::string& path);
+
+    /// Specifies the data ring capacity, which is rounded up to the multiple of the page size.
+    auto capacity(bytes_t bytes) & -> builder&;
+    auto capacity(bytes_t bytes) && -> builder&&;
+
+    /// Specifies how often to schedule dirty pages for writing back using asynchronous `msync`.
+    ///
+    /// \note setting zero value disables periodic synchronization, leaving it to the kernel.
+    auto sync_every(std::chrono::milliseconds interval) & -> builder&;
+    auto sync_every(std::chrono::milliseconds interval) && -> builder&&;
+
+    /// Consumes this builder, returning a newly created memory-mapped sink.
+    ///
+    /// \throw std::system_error if unable to create, allocate or map the file.
+    auto build() && -> std::unique_ptr<sink_t>;
+};
+
+template<>
+class factory<sink::mmap_t> : public factory<sink_t> {
+    const registry_t& registry;
+
+public:
+    constexpr explicit factory(const registry_t& registry) noexcept :
+        registry(registry)
+    {}
+
+    auto type() const noexcept -> const char* override;
+    auto from(const config::node_t& config) const -> std::unique_ptr<sink_t> override;
+};
+
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "blackhole/factory.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+
+/// Represents an OpenTelemetry sink, which batches formatted records into OTLP/HTTP export
+/// requests sent over a pool of HTTP/1.1 keep-alive connections.
+///
+/// Records are expected to be formatted as OTLP `LogRecord` messages, i.e. using OTLP formatter.
+class otlp_t;
+
+}  // namespace sink
+
+template<>
+class factory<sink::otlp_t> : public factory<sink_t> {
+    const registry_t& registry;
+
+public:
+    constexpr explicit factory(const registry_t& registry) noexcept :
+        registry(registry)
+    {}
+
+    auto type() const noexcept -> const char* override;
+
+    /// \throw std::invalid_argument if any of the limits is zero.
+    auto from(const config::node_t& config) const -> std::unique_ptr<sink_t> override;
+};
+
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <memory>
+
+#include "blackhole/factory.hpp"
+#include "blackhole/sink/file.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+
+/// Represents a sink that writes formatted log events into a named pipe, read by a co-located
+/// consumer, like a log shipper.
+///
+/// Batches of events are gathered into page-aligned buffers, which are handed over to the pipe
+/// with `vmsplice(SPLICE_F_GIFT)`, so the kernel may take the pages instead of copying them. Gifted
+/// buffers are never reused, a fresh one is mapped for the next batch. Single events and events
+/// larger than the buffer are written with `writev` directly. Destinations other than pipes, or
+/// kernels without `vmsplice`, fall back to `writev` using a single reusable buffer.
+///
+/// The pipe is created if it doesn't exist and is opened lazily in non-blocking mode, so emitting
+/// fails until a reader is attached and the sink retries opening it with the next event. Once open,
+/// writes block while the pipe is full, which is how the reader applies backpressure. When the
+/// reader goes away, writing fails with `EPIPE` without raising `SIGPIPE` and the pipe is reopened
+/// by the next event.
+///
+/// \remark All methods of this class are thread safe.
+class pipe_t;
+
+}  // namespace sink
+
+/// Represents a pipe sink builder to ease its configuration.
+template<>
+class builder<sink::pipe_t> {
+    class inner_t;
+    std::unique_ptr<inner_t, deleter_t> p;
+
+public:
+    /// Constructs a pipe sink builder with the given named pipe path.
+    ///
+    /// By default batches are gathered into 64 KiB buffers and the pipe capacity is raised to 1 MiB.
+    explicit builder(const std::string& path);
+
+    /// Specifies the size of buffers batches are gathered into, which is rounded up to the multiple
+    /// of the page size.
+    auto buffer(bytes_t bytes) & -> builder&;
+    auto buffer(bytes_t bytes) && -> builder&&;
+
+    /// Specifies the pipe capacity to request with `F_SETPIPE_SZ` once the pipe is opened.
+    ///
+    /// Unprivileged processes may not exceed `/proc/sys/fs/pipe-max-size`, failed requests keep the
+    /// current capacity.
+    ///
+    /// \note setting zero value keeps the pipe capacity intact.
+    auto pipe_size(bytes_t bytes) & -> builder&;
+    auto pipe_size(bytes_t bytes) && -> builder&&;
+
+    /// Consumes this builder, returning a newly created pipe sink.
+    auto build() && -> std::unique_ptr<sink_t>;
+};
+
+template<>
+class factory<sink::pipe_t> : public factory<sink_t> {
+    const registry_t& registry;
+
+public:
+    constexpr explicit factory(const registry_t& registry) noexcept :
+        registry(registry)
+    {}
+
+    auto type() const noexcept -> const char* override;
+    auto from(const config::node_t& config) const -> std::unique_ptr<sink_t> override;
+};
+
+}  // namespace v1
+}  // namespace blackhole
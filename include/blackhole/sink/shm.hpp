@@ -0,0 +1,30 @@
+#pragma once
+
+#include "blackhole/factory.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+
+/// Represents a sink that writes log events into a POSIX shared memory ring, which is consumed by
+/// a co-located reader process, like a log shipper, with neither system calls nor copies on the
+/// logging path.
+class shm_t;
+
+}  // namespace sink
+
+template<>
+class factory<sink::shm_t> : public factory<sink_t> {
+    const registry_t& registry;
+
+public:
+    constexpr explicit factory(const registry_t& registry) noexcept :
+        registry(registry)
+    {}
+
+    auto type() const noexcept -> const char* override;
+    auto from(const config::node_t& config) const -> std::unique_ptr<sink_t> override;
+};
+
+}  // namespace v1
+}  // namespace blackhole
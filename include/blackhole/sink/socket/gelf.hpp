@@ -0,0 +1,31 @@
+#pragma once
+
+#include "../../factory.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+namespace socket {
+
+/// The GELF sink is a sink that sends records to Graylog over UDP as GELF messages, optionally
+/// compressed and split into chunks.
+class gelf_t;
+
+}  // namespace socket
+}  // namespace sink
+
+template<>
+class factory<sink::socket::gelf_t> : public factory<sink_t> {
+    const registry_t& registry;
+
+public:
+    constexpr explicit factory(const registry_t& registry) noexcept :
+        registry(registry)
+    {}
+
+    auto type() const noexcept -> const char* override;
+    auto from(const config::node_t& config) const -> std::unique_ptr<sink_t> override;
+};
+
+}  // namespace v1
+}  // namespace blackhole
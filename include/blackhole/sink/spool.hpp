@@ -0,0 +1,31 @@
+#pragma once
+
+#include "blackhole/factory.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+
+/// Represents a sink that spills records to local segment files while the wrapped sink, usually a
+/// remote one, is slow or unavailable, replaying them once it recovers.
+///
+/// \throw std::invalid_argument on construction if either "path" or "sink" parameter is missing.
+class spool_t;
+
+}  // namespace sink
+
+template<>
+class factory<sink::spool_t> : public factory<sink_t> {
+    const registry_t& registry;
+
+public:
+    constexpr explicit factory(const registry_t& registry) noexcept :
+        registry(registry)
+    {}
+
+    auto type() const noexcept -> const char* override;
+    auto from(const config::node_t& config) const -> std::unique_ptr<sink_t> override;
+};
+
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace blackhole {
+inline namespace v1 {
+namespace metrics {
+
+class collector_t;
+class histogram_t;
+
+}  // namespace metrics
+}  // namespace v1
+}  // namespace blackhole
+
+namespace blackhole {
+inline namespace v1 {
+namespace stage {
+
+/// Stages of the pipeline a record passes through, which sampled records are stamped at.
+enum class id_t : std::uint8_t {
+    /// Constructing the record and collecting scoped attributes.
+    capture,
+    /// Filtering the record by the root logger.
+    filter,
+    /// Formatting the record by a handler.
+    format,
+    /// Enqueueing the record into an asynchronous sink.
+    enqueue,
+    /// Waiting in an asynchronous queue until the consumer dequeues the record.
+    queue,
+    /// Writing the record by a sink, either synchronously or as a part of a drained batch.
+    write
+};
+
+/// Number of stages.
+constexpr std::size_t count = 6;
+
+/// Enables sampling of one in every given number of records logged by each thread, disabling it
+/// if zero, which is the default.
+///
+/// Sampled records are stamped with TSC readings at each stage they pass, and durations of the
+/// stages are recorded into per-stage histograms, which are exposed in metrics snapshots of root
+/// loggers as `blackhole_stage_seconds{stage="..."}`. Other records cost a single thread-local
+/// countdown.
+///
+/// Queue residence and writes are sampled only for asynchronous sinks in the queue mode.
+///
+/// \note the first call enabling sampling blocks for about 10 milliseconds to calibrate the TSC.
+auto sample(std::size_t every) -> void;
+
+/// Returns the sampling period, zero if sampling is disabled.
+auto sampling() noexcept -> std::size_t;
+
+/// Returns the name of the given stage, like "queue".
+auto name(id_t stage) noexcept -> const char*;
+
+/// Returns the histogram of durations of the given stage in nanoseconds, which is shared by all
+/// loggers.
+auto histogram(id_t stage) noexcept -> const metrics::histogram_t&;
+
+/// Collects per-stage histograms into the given collector.
+auto collect(metrics::collector_t& collector) -> void;
+
+}  // namespace stage
+}  // namespace v1
+}  // namespace blackhole
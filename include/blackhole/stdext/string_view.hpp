@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <iosfwd>
 #include <limits>
 #include <stdexcept>
@@ -139,8 +140,8 @@ constexpr auto
 operator==(basic_string_view<Char, Traits> this_,
            basic_string_view<Char, Traits> other) noexcept -> bool
 {
-    return this_.size() == other.size() &&
-        Traits::compare(this_.data(), other.data(), this_.size()) == 0;
+    return this_.size() == other.size() && (this_.data() == other.data() ||
+        Traits::compare(this_.data(), other.data(), this_.size()) == 0);
 }
 
 template<typename Char, typename Traits>
@@ -148,8 +149,8 @@ constexpr auto
 operator==(basic_string_view<Char, Traits> this_,
            typename std::common_type<basic_string_view<Char, Traits>>::type other) noexcept -> bool
 {
-    return this_.size() == other.size() &&
-        Traits::compare(this_.data(), other.data(), this_.size()) == 0;
+    return this_.size() == other.size() && (this_.data() == other.data() ||
+        Traits::compare(this_.data(), other.data(), this_.size()) == 0);
 }
 
 template<typename Char, typename Traits>
@@ -157,8 +158,8 @@ constexpr auto
 operator==(typename std::common_type<basic_string_view<Char, Traits>>::type this_,
            basic_string_view<Char, Traits> other) noexcept -> bool
 {
-    return this_.size() == other.size() &&
-        Traits::compare(this_.data(), other.data(), this_.size()) == 0;
+    return this_.size() == other.size() && (this_.data() == other.data() ||
+        Traits::compare(this_.data(), other.data(), this_.size()) == 0);
 }
 
 template<typename Char, typename Traits >
@@ -188,7 +189,7 @@ using stdext::string_view;
 
 namespace std {
 
-/// Shamelessly stolen from <string>
+/// FNV-1a hash over the underlying bytes, which doesn't depend on standard library internals.
 template<typename Char, typename Traits>
 struct hash<blackhole::stdext::basic_string_view<Char, Traits>> {
     auto operator()(const blackhole::stdext::basic_string_view<Char, Traits>& val) const noexcept ->
@@ -199,7 +200,16 @@ template<typename Char, typename Traits>
 auto hash<blackhole::stdext::basic_string_view<Char, Traits>>::operator()(
     const blackhole::stdext::basic_string_view<Char, Traits>& val) const noexcept -> std::size_t
 {
-    return __do_string_hash(val.data(), val.data() + val.size());
+    const auto data = reinterpret_cast<const unsigned char*>(val.data());
+    const auto size = val.size() * sizeof(Char);
+
+    std::uint64_t result = 14695981039346656037ULL;
+    for (std::size_t id = 0; id < size; ++id) {
+        result ^= data[id];
+        result *= 1099511628211ULL;
+    }
+
+    return static_cast<std::size_t>(result);
 }
 
 }  // namespace std
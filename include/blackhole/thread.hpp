@@ -0,0 +1,18 @@
+#pragma once
+
+namespace blackhole {
+inline namespace v1 {
+namespace thread {
+
+/// Invalidates thread names cached for `{thread:name}` placeholders.
+///
+/// Thread names are obtained once and then cached by each formatting thread, so this function must
+/// be called after renaming a thread, e.g. with `pthread_setname_np`, for the new name to appear in
+/// the output.
+///
+/// \remark this function is thread-safe.
+auto invalidate_names() noexcept -> void;
+
+}  // namespace thread
+}  // namespace v1
+}  // namespace blackhole
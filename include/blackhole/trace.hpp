@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+
+namespace blackhole {
+inline namespace v1 {
+
+/// Distributed tracing context, which identifies the trace and the span of a logging event.
+///
+/// The context is stored inline in records instead of attributes, so attaching it costs neither
+/// allocations nor formatting unless rendered with dedicated `{trace_id}` and `{span_id}`
+/// placeholders. A zero trace id means there is no context.
+struct trace_t {
+    /// High and low halves of the 128-bit trace id.
+    std::uint64_t hi;
+    std::uint64_t lo;
+
+    /// The 64-bit span id.
+    std::uint64_t span;
+
+    auto empty() const noexcept -> bool {
+        return hi == 0 && lo == 0;
+    }
+};
+
+namespace trace {
+
+/// Returns the trace context of the calling thread, which is attached to each record created in
+/// it, empty by default.
+auto current() noexcept -> const trace_t&;
+
+/// Replaces the trace context of the calling thread.
+///
+/// \note prefer `scope::span_t`, which restores the previous context on destruction.
+auto reset(const trace_t& value) noexcept -> void;
+
+}  // namespace trace
+}  // namespace v1
+}  // namespace blackhole
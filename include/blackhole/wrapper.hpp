@@ -1,20 +1,38 @@
 #pragma once
 
+#include <initializer_list>
+#include <memory>
+
 #include "blackhole/logger.hpp"
 
 #include "blackhole/attribute.hpp"
+#include "blackhole/attribute/block.hpp"
+#include "blackhole/attribute/compact.hpp"
 
 namespace blackhole {
 inline namespace v1 {
 
+/// Logger adaptor, which attaches the given attributes to every logging event.
+///
+/// Wrappers are immutable, so wrapping another wrapper composes the attributes of both ones at
+/// construction and bypasses the wrapped one, forwarding events directly to the innermost logger
+/// with a single precomposed attribute list.
 class wrapper_t : public logger_t {
     logger_t& inner;
-    attributes_t storage;
+    std::unique_ptr<const attributes_t> functions;
+    compact_attributes_t storage;
     view_of<attributes_t>::type attributes_view;
 
 public:
     wrapper_t(logger_t& log, attributes_t attributes);
 
+    /// Constructs a wrapper from the braced list of attributes, which are kept in the compact form,
+    /// so wrapping with typical short keys and values requires no allocation.
+    ///
+    /// \note this overload is preferred for braced lists, including empty ones.
+    wrapper_t(logger_t& log, std::initializer_list<compact_attribute_t> attributes);
+
+    /// Returns own attributes followed by the ones of all wrapped wrappers.
     auto attributes() const noexcept -> const view_of<attributes_t>::type& {
         return attributes_view;
     }
@@ -24,6 +42,57 @@ public:
     auto log(severity_t severity, const lazy_message_t& message, attribute_pack& pack) -> void;
 
     auto manager() -> scope::manager_t&;
+
+private:
+    /// Returns the innermost logger, skipping wrappers.
+    static auto unwrap(logger_t& log) -> logger_t&;
+
+    /// Builds attribute views, appending the composed attributes of the wrapped wrapper if any.
+    auto compose(const logger_t& log) -> void;
+};
+
+/// Logger adaptor, which attaches the given attributes to every logging event, designed for a large
+/// number of long-lived instances, like a wrapper per connection.
+///
+/// Unlike `wrapper_t`, which embeds inline space for 16 attributes twice, attributes are kept in an
+/// exact-size immutable block, so the wrapper itself costs a few pointers. Wrapping another compact
+/// wrapper shares its block instead of copying it, hence wrappers derived from the same parent
+/// cost only their own attributes.
+///
+/// The price is that attribute views are collected from the block chain on every logging event.
+///
+/// \warning function values of wrapped compact wrappers are referred to, so such wrappers must
+///     outlive the ones derived from them.
+class compact_wrapper_t : public logger_t {
+    logger_t& inner;
+    std::unique_ptr<const attributes_t> functions;
+    attribute::block_t block;
+
+public:
+    compact_wrapper_t(logger_t& log, attributes_t attributes);
+
+    /// Constructs a wrapper from the braced list of attributes.
+    ///
+    /// \note this overload is preferred for braced lists, including empty ones.
+    compact_wrapper_t(logger_t& log, std::initializer_list<compact_attribute_t> attributes);
+
+    /// Returns the block of own attributes followed by the ones of all wrapped compact wrappers.
+    auto attributes() const noexcept -> const attribute::block_t& {
+        return block;
+    }
+
+    auto log(severity_t severity, const message_t& message) -> void;
+    auto log(severity_t severity, const message_t& message, attribute_pack& pack) -> void;
+    auto log(severity_t severity, const lazy_message_t& message, attribute_pack& pack) -> void;
+
+    auto manager() -> scope::manager_t&;
+
+private:
+    /// Returns the innermost logger, skipping compact wrappers.
+    static auto unwrap(logger_t& log) -> logger_t&;
+
+    /// Returns the block of the wrapped compact wrapper if any.
+    static auto parent(const logger_t& log) -> attribute::block_t;
 };
 
 }  // namespace v1
@@ -0,0 +1,176 @@
+#include "decoder.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace blackhole {
+inline namespace v1 {
+namespace relay {
+namespace {
+
+constexpr std::size_t prefix = 4;
+
+auto length(const char* data) noexcept -> std::size_t {
+    const auto bytes = reinterpret_cast<const unsigned char*>(data);
+    return std::uint32_t(bytes[0]) << 24 | std::uint32_t(bytes[1]) << 16 |
+        std::uint32_t(bytes[2]) << 8 | std::uint32_t(bytes[3]);
+}
+
+/// Returns the line without the trailing carriage return, which some senders append.
+auto line(const char* data, std::size_t size) noexcept -> string_view {
+    if (size != 0 && data[size - 1] == '\r') {
+        --size;
+    }
+
+    return string_view(data, size);
+}
+
+}  // namespace
+
+batch_t::batch_t() :
+    used(0)
+{}
+
+auto batch_t::text(const string_view& message, severity_t severity) -> void {
+    auto& entry = next();
+    entry.message = message;
+
+    record_t record(severity, std::cref(entry.message), std::cref(empty));
+    record.activate(entry.message);
+
+    records.push_back(record);
+}
+
+auto batch_t::binary(const string_view& data) -> bool {
+    const sink::ring_t::slot_t slot{data.data(), data.size()};
+    if (!sink::ring::valid(slot)) {
+        return false;
+    }
+
+    auto& entry = next();
+    entry.decoded.decode(slot);
+
+    records.push_back(entry.decoded.record());
+    return true;
+}
+
+auto batch_t::data() const noexcept -> const record_t* {
+    return records.data();
+}
+
+auto batch_t::size() const noexcept -> std::size_t {
+    return records.size();
+}
+
+auto batch_t::clear() noexcept -> void {
+    used = 0;
+    records.clear();
+}
+
+auto batch_t::next() -> entry_t& {
+    // Entries are counted separately, because records dropped by `retain` leave them in use.
+    if (used == entries.size()) {
+        entries.emplace_back(new entry_t);
+    }
+
+    return *entries[used++];
+}
+
+decoder_t::decoder_t(encoding_t encoding, severity_t severity, std::size_t limit) noexcept :
+    encoding(encoding),
+    severity(severity),
+    limit(limit)
+{}
+
+auto decoder_t::max_size() const noexcept -> std::size_t {
+    return encoding == encoding_t::text ? limit : limit + prefix;
+}
+
+auto decoder_t::stream(const char* data, std::size_t size, batch_t& batch) const -> std::size_t {
+    std::size_t offset = 0;
+
+    if (encoding == encoding_t::text) {
+        while (offset < size) {
+            const auto end = static_cast<const char*>(std::memchr(data + offset, '\n',
+                size - offset));
+
+            if (end == nullptr) {
+                if (size - offset > limit) {
+                    throw std::runtime_error("line is larger than " + std::to_string(limit) +
+                        " bytes");
+                }
+
+                break;
+            }
+
+            const auto length = static_cast<std::size_t>(end - data) - offset;
+            if (length > limit) {
+                throw std::runtime_error("line is larger than " + std::to_string(limit) +
+                    " bytes");
+            }
+
+            if (length != 0) {
+                batch.text(line(data + offset, length), severity);
+            }
+
+            offset += length + 1;
+        }
+
+        return offset;
+    }
+
+    while (size - offset >= prefix) {
+        const auto length = relay::length(data + offset);
+        if (length > limit) {
+            throw std::runtime_error("frame is larger than " + std::to_string(limit) + " bytes");
+        }
+
+        if (size - offset - prefix < length) {
+            break;
+        }
+
+        const string_view message(data + offset + prefix, length);
+
+        if (encoding == encoding_t::framed) {
+            batch.text(message, severity);
+        } else if (!batch.binary(message)) {
+            throw std::runtime_error("malformed binary record");
+        }
+
+        offset += prefix + length;
+    }
+
+    return offset;
+}
+
+auto decoder_t::datagram(const char* data, std::size_t size, batch_t& batch) const -> void {
+    const auto consumed = stream(data, size, batch);
+
+    if (consumed == size) {
+        return;
+    }
+
+    if (encoding != encoding_t::text) {
+        throw std::runtime_error("datagram ends with an incomplete frame");
+    }
+
+    batch.text(line(data + consumed, size - consumed), severity);
+}
+
+auto encoding(const std::string& name) -> encoding_t {
+    if (name == "text") {
+        return encoding_t::text;
+    } else if (name == "framed") {
+        return encoding_t::framed;
+    } else if (name == "binary") {
+        return encoding_t::binary;
+    }
+
+    throw std::invalid_argument("unknown relay encoding: " + name);
+}
+
+}  // namespace relay
+}  // namespace v1
+}  // namespace blackhole
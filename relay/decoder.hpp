@@ -0,0 +1,116 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include <blackhole/attributes.hpp>
+#include <blackhole/record.hpp>
+#include <blackhole/severity.hpp>
+#include <blackhole/detail/sink/ring.hpp>
+
+namespace blackhole {
+inline namespace v1 {
+namespace relay {
+
+/// Encoding of received messages.
+enum class encoding_t {
+    /// Each message is a line of text, which becomes the record message.
+    text,
+    /// Each message is text prefixed with its size as 32-bit big-endian integer, like the "length"
+    /// framing of socket sinks produces.
+    framed,
+    /// Each message is a record encoded with `sink::ring::encode` prefixed with its size as 32-bit
+    /// big-endian integer, which keeps the severity, timestamp, thread and all attributes of the
+    /// original record.
+    binary
+};
+
+/// Records decoded from received messages.
+///
+/// Records are views over the received bytes, which must outlive them. Storage of decoded records
+/// is reused after clearing, so there is no memory allocation in a steady state.
+class batch_t {
+    struct entry_t {
+        string_view message;
+        sink::ring::decoded_t decoded;
+    };
+
+    /// Storage of decoded records, only growing.
+    std::vector<std::unique_ptr<entry_t>> entries;
+    std::size_t used;
+
+    std::vector<record_t> records;
+
+    const attribute_pack empty;
+
+public:
+    batch_t();
+
+    /// Appends the record with the given text message and severity, timestamped on arrival.
+    auto text(const string_view& message, severity_t severity) -> void;
+
+    /// Appends the record encoded in the given bytes, returning false if they are malformed.
+    auto binary(const string_view& data) -> bool;
+
+    auto data() const noexcept -> const record_t*;
+    auto size() const noexcept -> std::size_t;
+
+    /// Drops records, keeping only the ones the given predicate accepts.
+    template<typename F>
+    auto retain(const F& fn) -> void;
+
+    auto clear() noexcept -> void;
+
+private:
+    auto next() -> entry_t&;
+};
+
+template<typename F>
+auto batch_t::retain(const F& fn) -> void {
+    std::size_t size = 0;
+    for (const auto& record : records) {
+        if (fn(record)) {
+            records[size++] = record;
+        }
+    }
+
+    records.erase(records.begin() + static_cast<std::ptrdiff_t>(size), records.end());
+}
+
+/// Splits received bytes into messages and decodes them into records.
+class decoder_t {
+    encoding_t encoding;
+    severity_t severity;
+    std::size_t limit;
+
+public:
+    /// \param severity of records decoded from text messages.
+    /// \param limit the maximum message size in bytes.
+    decoder_t(encoding_t encoding, severity_t severity, std::size_t limit) noexcept;
+
+    auto max_size() const noexcept -> std::size_t;
+
+    /// Decodes all complete messages at the beginning of the given stream data into the batch.
+    ///
+    /// \returns the number of bytes consumed, the rest is an incomplete message.
+    /// \throw std::runtime_error if a message is larger than the limit or malformed, after which
+    ///     the stream can't be split into messages anymore.
+    auto stream(const char* data, std::size_t size, batch_t& batch) const -> std::size_t;
+
+    /// Decodes messages of the given datagram into the batch, where the last text line may have no
+    /// trailing newline.
+    ///
+    /// \throw std::runtime_error if the datagram ends with an incomplete frame or a message is
+    ///     malformed, keeping messages decoded before.
+    auto datagram(const char* data, std::size_t size, batch_t& batch) const -> void;
+};
+
+/// Parses the encoding name, either "text", "framed" or "binary".
+///
+/// \throw std::invalid_argument if the encoding is unknown.
+auto encoding(const std::string& name) -> encoding_t;
+
+}  // namespace relay
+}  // namespace v1
+}  // namespace blackhole
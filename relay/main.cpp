@@ -0,0 +1,115 @@
+/// Relay daemon receiving records from remote hosts and passing them to handlers and sinks
+/// configured the same way as ones of any other logger.
+///
+/// The JSON config contains both the relay options under the "relay" key and the logger records
+/// are dispatched to, which is "root" unless the "logger" relay option names another one.
+///
+/// The daemon runs until SIGINT or SIGTERM, flushing handlers before exiting. SIGHUP reloads the
+/// logger from the config, reusing unchanged sinks, while listeners are kept.
+#include <chrono>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include <pthread.h>
+#include <signal.h>
+
+#include <boost/optional/optional.hpp>
+
+#include <blackhole/builder.hpp>
+#include <blackhole/config/json.hpp>
+#include <blackhole/config/node.hpp>
+#include <blackhole/config/option.hpp>
+#include <blackhole/registry.hpp>
+#include <blackhole/root.hpp>
+#include <blackhole/detail/memory.hpp>
+
+#include "server.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace relay {
+namespace {
+
+auto factory(const std::string& path) -> std::unique_ptr<config::factory_t> {
+    std::ifstream stream(path);
+    if (!stream) {
+        throw std::invalid_argument("failed to open config " + path);
+    }
+
+    return config::factory_traits<config::json_t>::construct(stream);
+}
+
+auto run(const std::string& path) -> int {
+    // Signals are blocked before any thread is started, so all of them inherit the mask and the
+    // main thread is the only one receiving them.
+    sigset_t signals;
+    ::sigemptyset(&signals);
+    ::sigaddset(&signals, SIGINT);
+    ::sigaddset(&signals, SIGTERM);
+    ::sigaddset(&signals, SIGHUP);
+    ::pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+    const auto registry = registry::configured();
+    auto builder = registry->builder<config::json_t>(std::ifstream(path));
+
+    const auto& config = builder.configurator().config();
+    if (!config["relay"]) {
+        throw std::invalid_argument("config must have relay options");
+    }
+
+    const auto name = config["relay"]["logger"].to_string().get_value_or("root");
+
+    auto logger = builder.build(name);
+    auto server = blackhole::make_unique<server_t>(options(*config["relay"].unwrap()), logger);
+
+    while (true) {
+        int signo = 0;
+        ::sigwait(&signals, &signo);
+
+        if (signo != SIGHUP) {
+            break;
+        }
+
+        try {
+            builder.reload(logger, name, factory(path));
+        } catch (const std::exception& err) {
+            std::cerr << "relay: failed to reload " << path << ": " << err.what() << std::endl;
+        }
+    }
+
+    const auto received = server->received();
+    const auto rejected = server->rejected();
+    server.reset();
+
+    if (!logger.flush(std::chrono::seconds(5))) {
+        std::cerr << "relay: timed out flushing handlers" << std::endl;
+    }
+
+    std::cerr << "relay: received " << received << " records, rejected " << rejected
+        << " malformed messages" << std::endl;
+
+    return 0;
+}
+
+}  // namespace
+}  // namespace relay
+}  // namespace v1
+}  // namespace blackhole
+
+auto main(int argc, char** argv) -> int {
+    if (argc != 2) {
+        std::cerr << "Usage: blackhole-relay CONFIG" << std::endl;
+        return 1;
+    }
+
+    try {
+        return blackhole::relay::run(argv[1]);
+    } catch (const std::exception& err) {
+        std::cerr << "relay: " << err.what() << std::endl;
+        return 1;
+    }
+}
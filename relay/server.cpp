@@ -0,0 +1,455 @@
+#include "server.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <boost/asio/buffer.hpp>
+#include <boost/asio/io_service.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/ip/udp.hpp>
+#include <boost/asio/local/stream_protocol.hpp>
+#include <boost/optional/optional.hpp>
+
+#include <blackhole/config/node.hpp>
+#include <blackhole/config/option.hpp>
+#include <blackhole/metrics.hpp>
+#include <blackhole/record.hpp>
+#include <blackhole/root.hpp>
+
+namespace blackhole {
+inline namespace v1 {
+namespace relay {
+namespace {
+
+typedef boost::asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT> reuse_port;
+
+/// Receive buffers hold at least this many bytes, so small messages are read in batches.
+constexpr std::size_t min_buffer = 64 * 1024;
+
+/// The maximum UDP payload size.
+constexpr std::size_t max_datagram = 65507;
+
+auto rethrow(const boost::system::error_code& ec, const std::string& what) -> void {
+    if (ec) {
+        throw std::system_error(ec.value(), std::system_category(), what);
+    }
+}
+
+}  // namespace
+
+class server_t::inner_t {
+public:
+    /// Event loop of a single thread with its own sockets.
+    struct worker_t {
+        boost::asio::io_service io_service;
+        std::unique_ptr<boost::asio::io_service::work> work;
+        std::thread thread;
+
+        worker_t() :
+            work(new boost::asio::io_service::work(io_service))
+        {}
+    };
+
+    /// Connection of either a TCP or a Unix listener.
+    template<typename Socket>
+    class session_t : public std::enable_shared_from_this<session_t<Socket>> {
+        inner_t& inner;
+        Socket socket;
+        const decoder_t& decoder;
+
+        std::vector<char> buffer;
+        std::size_t size;
+        batch_t batch;
+
+    public:
+        session_t(inner_t& inner, boost::asio::io_service& io_service, const decoder_t& decoder) :
+            inner(inner),
+            socket(io_service),
+            decoder(decoder),
+            buffer(std::max(min_buffer, decoder.max_size() + 1)),
+            size(0)
+        {}
+
+        auto get() noexcept -> Socket& {
+            return socket;
+        }
+
+        auto read() -> void {
+            auto self = this->shared_from_this();
+            socket.async_read_some(boost::asio::buffer(&buffer[size], buffer.size() - size),
+                [self](const boost::system::error_code& ec, std::size_t bytes) {
+                    if (!ec) {
+                        self->consume(bytes);
+                    }
+                }
+            );
+        }
+
+    private:
+        auto consume(std::size_t bytes) -> void {
+            size += bytes;
+
+            std::size_t consumed;
+            try {
+                consumed = decoder.stream(buffer.data(), size, batch);
+            } catch (const std::runtime_error&) {
+                // Records decoded before the malformed message are still delivered.
+                inner.dispatch(batch);
+                inner.rejected.add();
+                return;
+            }
+
+            inner.dispatch(batch);
+
+            // Records no longer refer to the buffer, so the incomplete message can be moved.
+            std::memmove(buffer.data(), buffer.data() + consumed, size - consumed);
+            size -= consumed;
+
+            read();
+        }
+    };
+
+    template<typename Protocol>
+    struct acceptor_t {
+        typedef typename Protocol::acceptor acceptor_type;
+        typedef session_t<typename Protocol::socket> session_type;
+
+        inner_t& inner;
+        acceptor_type acceptor;
+        const decoder_t& decoder;
+
+        /// Workers accepted connections are distributed between, only the own one if the
+        /// listener is sharded by the kernel.
+        std::vector<worker_t*> workers;
+        std::size_t next;
+
+        acceptor_t(inner_t& inner, boost::asio::io_service& io_service, const decoder_t& decoder,
+                   std::vector<worker_t*> workers) :
+            inner(inner),
+            acceptor(io_service),
+            decoder(decoder),
+            workers(std::move(workers)),
+            next(0)
+        {}
+
+        auto accept() -> void {
+            auto& io_service = workers[next++ % workers.size()]->io_service;
+            auto session = std::make_shared<session_type>(inner, io_service, decoder);
+
+            acceptor.async_accept(session->get(),
+                [this, session, &io_service](const boost::system::error_code& ec) {
+                    if (ec == boost::asio::error::operation_aborted) {
+                        return;
+                    }
+
+                    if (!ec) {
+                        // The session is run by the worker its socket belongs to.
+                        io_service.post([session] {
+                            session->read();
+                        });
+                    }
+
+                    accept();
+                }
+            );
+        }
+    };
+
+    /// UDP socket of a single worker.
+    struct receiver_t {
+        inner_t& inner;
+        boost::asio::ip::udp::socket socket;
+        const decoder_t& decoder;
+
+        std::vector<char> buffer;
+        batch_t batch;
+
+        receiver_t(inner_t& inner, boost::asio::io_service& io_service, const decoder_t& decoder) :
+            inner(inner),
+            socket(io_service),
+            decoder(decoder),
+            buffer(max_datagram)
+        {}
+
+        auto receive() -> void {
+            socket.async_receive(boost::asio::buffer(buffer),
+                [this](const boost::system::error_code& ec, std::size_t bytes) {
+                    if (ec == boost::asio::error::operation_aborted) {
+                        return;
+                    }
+
+                    if (!ec) {
+                        try {
+                            decoder.datagram(buffer.data(), bytes, batch);
+                        } catch (const std::runtime_error&) {
+                            inner.rejected.add();
+                        }
+
+                        inner.dispatch(batch);
+                    }
+
+                    receive();
+                }
+            );
+        }
+    };
+
+    const options_t options;
+    root_logger_t& logger;
+
+    metrics::counter_t received;
+    metrics::counter_t rejected;
+
+    std::vector<decoder_t> decoders;
+    std::vector<std::uint16_t> ports;
+
+    /// Workers are destroyed last, after sockets referring to their event loops.
+    std::vector<std::unique_ptr<worker_t>> workers;
+    std::vector<std::unique_ptr<acceptor_t<boost::asio::ip::tcp>>> tcp;
+    std::vector<std::unique_ptr<acceptor_t<boost::asio::local::stream_protocol>>> local;
+    std::vector<std::unique_ptr<receiver_t>> udp;
+
+    inner_t(options_t options, root_logger_t& logger) :
+        options(std::move(options)),
+        logger(logger)
+    {
+        for (std::size_t id = 0; id < this->options.threads; ++id) {
+            workers.emplace_back(new worker_t);
+        }
+
+        for (const auto& listener : this->options.listeners) {
+            decoders.emplace_back(listener.encoding, listener.severity, this->options.limit);
+        }
+
+        for (std::size_t id = 0; id < this->options.listeners.size(); ++id) {
+            const auto& listener = this->options.listeners[id];
+
+            switch (listener.protocol) {
+            case protocol_t::tcp:
+                ports.push_back(bind_tcp(listener, decoders[id]));
+                break;
+            case protocol_t::udp:
+                ports.push_back(bind_udp(listener, decoders[id]));
+                break;
+            case protocol_t::local:
+                ports.push_back(0);
+                bind_local(listener, decoders[id]);
+                break;
+            }
+        }
+    }
+
+    auto dispatch(batch_t& batch) -> void {
+        received.add(batch.size());
+
+        // Records are dispatched bypassing the threshold, which is checked here instead.
+        batch.retain([&](const record_t& record) {
+            return logger.enabled(record.severity());
+        });
+
+        if (batch.size() != 0) {
+            logger.dispatch(batch.data(), batch.size());
+        }
+
+        batch.clear();
+    }
+
+    auto start() -> void {
+        for (auto& worker : workers) {
+            auto& io_service = worker->io_service;
+            worker->thread = std::thread([&io_service] {
+                io_service.run();
+            });
+        }
+    }
+
+    auto stop() -> void {
+        for (auto& worker : workers) {
+            worker->work.reset();
+            worker->io_service.stop();
+        }
+
+        for (auto& worker : workers) {
+            if (worker->thread.joinable()) {
+                worker->thread.join();
+            }
+        }
+    }
+
+private:
+    auto bind_tcp(const listener_t& listener, const decoder_t& decoder) -> std::uint16_t {
+        boost::system::error_code ec;
+        const auto address = boost::asio::ip::address::from_string(listener.host, ec);
+        rethrow(ec, "invalid relay address " + listener.host);
+
+        boost::asio::ip::tcp::endpoint endpoint(address, listener.port);
+
+        for (auto& worker : workers) {
+            std::unique_ptr<acceptor_t<boost::asio::ip::tcp>> acceptor(
+                new acceptor_t<boost::asio::ip::tcp>(*this, worker->io_service, decoder,
+                    {worker.get()}));
+
+            auto& socket = acceptor->acceptor;
+            socket.open(endpoint.protocol(), ec);
+            rethrow(ec, "failed to open TCP relay socket");
+            socket.set_option(boost::asio::ip::tcp::acceptor::reuse_address(true));
+            socket.set_option(reuse_port(true));
+            socket.bind(endpoint, ec);
+            rethrow(ec, "failed to bind TCP relay socket");
+            socket.listen(boost::asio::socket_base::max_connections, ec);
+            rethrow(ec, "failed to listen on TCP relay socket");
+
+            // Other workers bind the port chosen for the first one, when any port is requested.
+            endpoint = socket.local_endpoint();
+
+            acceptor->accept();
+            tcp.push_back(std::move(acceptor));
+        }
+
+        return endpoint.port();
+    }
+
+    auto bind_udp(const listener_t& listener, const decoder_t& decoder) -> std::uint16_t {
+        boost::system::error_code ec;
+        const auto address = boost::asio::ip::address::from_string(listener.host, ec);
+        rethrow(ec, "invalid relay address " + listener.host);
+
+        boost::asio::ip::udp::endpoint endpoint(address, listener.port);
+
+        for (auto& worker : workers) {
+            std::unique_ptr<receiver_t> receiver(new receiver_t(*this, worker->io_service,
+                decoder));
+
+            auto& socket = receiver->socket;
+            socket.open(endpoint.protocol(), ec);
+            rethrow(ec, "failed to open UDP relay socket");
+            socket.set_option(reuse_port(true));
+            socket.bind(endpoint, ec);
+            rethrow(ec, "failed to bind UDP relay socket");
+
+            endpoint = socket.local_endpoint();
+
+            receiver->receive();
+            udp.push_back(std::move(receiver));
+        }
+
+        return endpoint.port();
+    }
+
+    auto bind_local(const listener_t& listener, const decoder_t& decoder) -> void {
+        std::vector<worker_t*> targets;
+        for (auto& worker : workers) {
+            targets.push_back(worker.get());
+        }
+
+        std::unique_ptr<acceptor_t<boost::asio::local::stream_protocol>> acceptor(
+            new acceptor_t<boost::asio::local::stream_protocol>(*this,
+                workers.front()->io_service, decoder, std::move(targets)));
+
+        // The socket file left by the previous run would fail binding.
+        ::unlink(listener.path.c_str());
+
+        boost::system::error_code ec;
+        const boost::asio::local::stream_protocol::endpoint endpoint(listener.path);
+
+        auto& socket = acceptor->acceptor;
+        socket.open(endpoint.protocol(), ec);
+        rethrow(ec, "failed to open Unix relay socket");
+        socket.bind(endpoint, ec);
+        rethrow(ec, "failed to bind Unix relay socket " + listener.path);
+        socket.listen(boost::asio::socket_base::max_connections, ec);
+        rethrow(ec, "failed to listen on Unix relay socket " + listener.path);
+
+        acceptor->accept();
+        local.push_back(std::move(acceptor));
+    }
+};
+
+server_t::server_t(options_t options, root_logger_t& logger) {
+    if (options.listeners.empty()) {
+        throw std::invalid_argument("relay must have at least one listener");
+    }
+
+    if (options.threads == 0) {
+        throw std::invalid_argument("relay must have at least one thread");
+    }
+
+    if (options.limit == 0) {
+        throw std::invalid_argument("relay message size limit must be positive");
+    }
+
+    d.reset(new inner_t(std::move(options), logger));
+    d->start();
+}
+
+server_t::~server_t() {
+    d->stop();
+}
+
+auto server_t::port(std::size_t listener) const -> std::uint16_t {
+    return d->ports.at(listener);
+}
+
+auto server_t::received() const noexcept -> std::uint64_t {
+    return d->received.get();
+}
+
+auto server_t::rejected() const noexcept -> std::uint64_t {
+    return d->rejected.get();
+}
+
+auto options(const config::node_t& config) -> options_t {
+    options_t result;
+    result.threads = std::max(1u, std::thread::hardware_concurrency());
+    result.limit = 64 * 1024;
+
+    if (auto threads = config["threads"].to_uint64()) {
+        result.threads = static_cast<std::size_t>(threads.get());
+    }
+
+    if (auto limit = config["limit"].to_uint64()) {
+        result.limit = static_cast<std::size_t>(limit.get());
+    }
+
+    config["listen"].each([&](const config::node_t& config) {
+        const auto type = config["type"].to_string().get_value_or("tcp");
+        const auto path = config["path"].to_string().get_value_or("");
+
+        auto protocol = protocol_t::tcp;
+        if (type == "udp") {
+            protocol = protocol_t::udp;
+        } else if (type == "unix") {
+            protocol = protocol_t::local;
+            if (path.empty()) {
+                throw std::invalid_argument("unix relay listener must have a path");
+            }
+        } else if (type != "tcp") {
+            throw std::invalid_argument("unknown relay listener type: " + type);
+        }
+
+        listener_t listener{
+            protocol,
+            config["host"].to_string().get_value_or("0.0.0.0"),
+            static_cast<std::uint16_t>(config["port"].to_uint64().get_value_or(0)),
+            path,
+            encoding(config["encoding"].to_string().get_value_or("text")),
+            static_cast<int>(config["severity"].to_sint64().get_value_or(0))
+        };
+
+        result.listeners.push_back(std::move(listener));
+    });
+
+    return result;
+}
+
+}  // namespace relay
+}  // namespace v1
+}  // namespace blackhole
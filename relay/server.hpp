@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <blackhole/forward.hpp>
+#include <blackhole/severity.hpp>
+
+#include "decoder.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace relay {
+
+/// Transport of a listener.
+enum class protocol_t {
+    tcp,
+    udp,
+    /// Unix domain stream socket.
+    local
+};
+
+struct listener_t {
+    protocol_t protocol;
+    /// Address TCP and UDP listeners are bound to.
+    std::string host;
+    /// Port TCP and UDP listeners are bound to, zero for choosing any free one.
+    std::uint16_t port;
+    /// Socket path of Unix listeners, which is removed before binding.
+    std::string path;
+    encoding_t encoding;
+    /// Severity of records decoded from text messages.
+    severity_t severity;
+};
+
+struct options_t {
+    std::vector<listener_t> listeners;
+    /// Number of worker threads.
+    std::size_t threads;
+    /// The maximum message size in bytes.
+    std::size_t limit;
+};
+
+/// Receives records from remote hosts and dispatches them to the logger.
+///
+/// Each worker thread runs its own event loop with its own TCP and UDP sockets bound to the same
+/// addresses with `SO_REUSEPORT`, so the kernel shards connections and datagrams between workers
+/// and they never contend on a shared socket. Unix sockets can't be shared this way, so a single
+/// worker accepts their connections, distributing them between all workers in a round-robin
+/// manner.
+///
+/// Records are decoded as views over the receive buffer of the connection or datagram and passed
+/// to the logger with as few batches as reads are done, bypassing its filter, while records below
+/// its severity threshold are dropped. Connections sending malformed messages are closed.
+class server_t {
+    class inner_t;
+    std::unique_ptr<inner_t> d;
+
+public:
+    /// Binds all listeners and starts workers.
+    ///
+    /// \warning the logger must outlive the server.
+    /// \throw std::invalid_argument if there are no listeners, no threads or the limit is zero.
+    /// \throw std::system_error if unable to bind a listener.
+    server_t(options_t options, root_logger_t& logger);
+
+    /// Stops workers, closing all sockets. Records being dispatched are completed.
+    ~server_t();
+
+    /// Returns the port the given TCP or UDP listener is bound to.
+    auto port(std::size_t listener) const -> std::uint16_t;
+
+    /// Returns the number of records received.
+    auto received() const noexcept -> std::uint64_t;
+
+    /// Returns the number of connections and datagrams rejected because of malformed messages.
+    auto rejected() const noexcept -> std::uint64_t;
+};
+
+/// Reads relay options from the given config, like `{"threads": 4, "listen": [{"type": "tcp",
+/// "port": 5140}]}`. The number of threads is the number of cores by default.
+///
+/// \throw std::invalid_argument if the config is malformed.
+auto options(const config::node_t& config) -> options_t;
+
+}  // namespace relay
+}  // namespace v1
+}  // namespace blackhole
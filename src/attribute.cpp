@@ -13,8 +13,9 @@ inline namespace v1 {
 namespace attribute {
 namespace {
 
+/// Invokes owned functions by reference, since copying them may allocate.
 auto call(const void* value, writer_t& wr) -> void {
-    auto fn = *static_cast<const std::function<auto(writer_t&) -> void>*>(value);
+    const auto& fn = *static_cast<const value_t::function_type*>(value);
     fn(wr);
 }
 
@@ -245,6 +246,10 @@ view_t::view_t(const std::string& value) {
     construct(value);
 }
 
+view_t::view_t(const function_type& value) {
+    construct(function_type(value));
+}
+
 view_t::view_t(const value_t& value) {
     construct(boost::apply_visitor(into_view(), value.inner().value));
 }
@@ -0,0 +1,142 @@
+#include "blackhole/attribute/backtrace.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <execinfo.h>
+
+#include "blackhole/extensions/writer.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace attribute {
+namespace {
+
+/// Symbolized frames by return addresses, which are never evicted, since the set of code addresses
+/// logged with traces is expected to be small.
+class symbols_t {
+    std::mutex mutex;
+    std::unordered_map<const void*, std::string> frames;
+
+public:
+    auto get(const void* address) -> std::string {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            const auto it = frames.find(address);
+            if (it != frames.end()) {
+                return it->second;
+            }
+        }
+
+        // Resolving happens without locking, concurrent ones for the same address are harmless.
+        auto frame = resolve(address);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        return frames.emplace(address, std::move(frame)).first->second;
+    }
+
+private:
+    static auto resolve(const void* address) -> std::string {
+        // Return addresses point past the call instruction, which may belong to the next function
+        // when the call is the last one in a function.
+        const auto pc = static_cast<const char*>(address) - 1;
+
+        Dl_info info;
+        if (::dladdr(pc, &info) == 0) {
+            return hex(reinterpret_cast<std::uintptr_t>(address));
+        }
+
+        if (info.dli_sname && info.dli_saddr) {
+            int status = 0;
+            std::unique_ptr<char, decltype(&std::free)> demangled(
+                abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status), &std::free);
+
+            const std::string name = status == 0 && demangled ? demangled.get() : info.dli_sname;
+            return name + "+" + hex(offset(address, info.dli_saddr));
+        }
+
+        if (info.dli_fname && info.dli_fbase) {
+            const auto slash = std::strrchr(info.dli_fname, '/');
+            const std::string module = slash ? slash + 1 : info.dli_fname;
+            return module + "+" + hex(offset(address, info.dli_fbase));
+        }
+
+        return hex(reinterpret_cast<std::uintptr_t>(address));
+    }
+
+    static auto offset(const void* address, const void* base) noexcept -> std::uintptr_t {
+        return reinterpret_cast<std::uintptr_t>(address) - reinterpret_cast<std::uintptr_t>(base);
+    }
+
+    static auto hex(std::uintptr_t value) -> std::string {
+        fmt::MemoryWriter writer;
+        writer << "0x" << fmt::hex(value);
+        return writer.str();
+    }
+};
+
+/// Symbolized frames are referenced by formatters running on threads that may outlive static
+/// objects destruction, so the cache is never destroyed.
+auto symbols() -> symbols_t& {
+    static auto instance = new symbols_t;
+    return *instance;
+}
+
+}  // namespace
+
+constexpr std::size_t backtrace_t::capacity;
+
+backtrace_t::backtrace_t() noexcept :
+    size_(0),
+    frames()
+{}
+
+__attribute__((noinline))
+auto backtrace_t::capture(std::size_t skip) noexcept -> backtrace_t {
+    // Frames of this function and the skipped ones are captured too, to be dropped afterwards.
+    void* buffer[capacity + 8];
+    skip = std::min<std::size_t>(skip + 1, 8);
+
+    const auto size = ::backtrace(buffer, static_cast<int>(capacity + skip));
+
+    backtrace_t result;
+    if (size > 0 && static_cast<std::size_t>(size) > skip) {
+        result.size_ = static_cast<std::size_t>(size) - skip;
+        std::memcpy(result.frames, buffer + skip, result.size_ * sizeof(void*));
+    }
+
+    return result;
+}
+
+auto backtrace_t::size() const noexcept -> std::size_t {
+    return size_;
+}
+
+auto backtrace_t::operator[](std::size_t id) const noexcept -> void* {
+    return frames[id];
+}
+
+auto backtrace_t::format(writer_t& writer) const -> void {
+    for (std::size_t id = 0; id < size_; ++id) {
+        if (id > 0) {
+            writer.inner << " <- ";
+        }
+
+        const auto frame = symbols().get(frames[id]);
+        writer.inner << fmt::StringRef(frame.data(), frame.size());
+    }
+}
+
+auto symbolize(const void* address) -> std::string {
+    return symbols().get(address);
+}
+
+}  // namespace attribute
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,188 @@
+#include "blackhole/attribute/block.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <utility>
+
+// Must be included strictly before <boost/variant/get.hpp>.
+#include "hack/addressof.hpp"
+#include <boost/variant/get.hpp>
+
+#include "blackhole/detail/attribute.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace attribute {
+
+namespace {
+
+auto aligned(std::size_t size) noexcept -> std::size_t {
+    const auto align = alignof(view_of<attribute_t>::type);
+    return (size + align - 1) / align * align;
+}
+
+}  // namespace
+
+/// Block layout is the header followed by own attributes and then by bytes of keys and strings.
+struct block_t::header_t {
+    std::atomic<std::size_t> refs;
+    /// Number of own attributes.
+    std::size_t size;
+    /// Number of all attributes, including the ones of the parent.
+    std::size_t total;
+    /// Number of allocated bytes.
+    std::size_t capacity;
+    block_t parent;
+
+    auto data() noexcept -> value_type* {
+        return reinterpret_cast<value_type*>(reinterpret_cast<char*>(this) +
+            aligned(sizeof(header_t)));
+    }
+};
+
+static_assert(sizeof(block_t) == sizeof(void*), "block must be a single pointer");
+static_assert(alignof(block_t::value_type) <= alignof(std::max_align_t), "alignment violation");
+
+block_t::block_t() noexcept :
+    inner(nullptr)
+{}
+
+block_t::block_t(const view_of<attributes_t>::type& attributes, block_t parent) :
+    inner(nullptr)
+{
+    if (attributes.empty()) {
+        inner = parent.inner;
+        parent.inner = nullptr;
+        return;
+    }
+
+    std::size_t bytes = 0;
+    for (const auto& attribute : attributes) {
+        bytes += attribute.first.size();
+
+        const auto& value = attribute.second.inner().value;
+        if (const auto string = boost::get<view_t::string_type>(&value)) {
+            bytes += string->size();
+        }
+    }
+
+    const auto offset = aligned(sizeof(header_t)) + attributes.size() * sizeof(value_type);
+    const auto capacity = offset + bytes;
+
+    auto memory = static_cast<char*>(::operator new(capacity));
+    auto header = new(memory) header_t{{1}, attributes.size(),
+        attributes.size() + parent.size(), capacity, std::move(parent)};
+
+    auto data = header->data();
+    auto chars = memory + offset;
+
+    const auto copy = [&](const char* source, std::size_t size) -> string_view {
+        if (size > 0) {
+            std::memcpy(chars, source, size);
+        }
+
+        const string_view result(chars, size);
+        chars += size;
+        return result;
+    };
+
+    // Views are trivially destructible, so keeping no count of constructed ones is fine.
+    for (const auto& attribute : attributes) {
+        const auto key = copy(attribute.first.data(), attribute.first.size());
+
+        const auto& value = attribute.second.inner().value;
+        if (const auto string = boost::get<view_t::string_type>(&value)) {
+            new(data++) value_type(key, view_t(copy(string->data(), string->size())));
+        } else {
+            new(data++) value_type(key, attribute.second);
+        }
+    }
+
+    inner = header;
+}
+
+block_t::block_t(const block_t& other) noexcept :
+    inner(other.inner)
+{
+    if (inner) {
+        inner->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+block_t::block_t(block_t&& other) noexcept :
+    inner(other.inner)
+{
+    other.inner = nullptr;
+}
+
+block_t::~block_t() {
+    reset();
+}
+
+auto block_t::operator=(const block_t& other) noexcept -> block_t& {
+    if (this != &other) {
+        block_t copy(other);
+        reset();
+        std::swap(inner, copy.inner);
+    }
+
+    return *this;
+}
+
+auto block_t::operator=(block_t&& other) noexcept -> block_t& {
+    if (this != &other) {
+        reset();
+        std::swap(inner, other.inner);
+    }
+
+    return *this;
+}
+
+auto block_t::size() const noexcept -> std::size_t {
+    return inner ? inner->total : 0;
+}
+
+auto block_t::capacity() const noexcept -> std::size_t {
+    return inner ? inner->capacity : 0;
+}
+
+auto block_t::parent() const noexcept -> block_t {
+    return inner ? inner->parent : block_t();
+}
+
+auto block_t::append(view_of<attributes_t>::type& attributes) const -> void {
+    attributes.reserve(attributes.size() + size());
+
+    for (auto block = inner; block; block = block->parent.inner) {
+        attributes.insert(attributes.end(), block->data(), block->data() + block->size);
+    }
+}
+
+auto block_t::attributes() const -> view_of<attributes_t>::type {
+    view_of<attributes_t>::type result;
+    append(result);
+    return result;
+}
+
+auto block_t::reset() noexcept -> void {
+    // Parents are released iteratively to avoid deep recursion on long chains.
+    while (inner) {
+        if (inner->refs.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+            inner = nullptr;
+            return;
+        }
+
+        const auto header = inner;
+        inner = header->parent.inner;
+        header->parent.inner = nullptr;
+
+        header->~header_t();
+        ::operator delete(header);
+    }
+}
+
+}  // namespace attribute
+}  // namespace v1
+}  // namespace blackhole
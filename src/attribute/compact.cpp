@@ -0,0 +1,253 @@
+#include "blackhole/attribute/compact.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include <boost/variant/apply_visitor.hpp>
+// Must be included strictly before <boost/variant/get.hpp>.
+#include "hack/addressof.hpp"
+#include <boost/variant/get.hpp>
+
+#include "blackhole/detail/attribute.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace attribute {
+namespace {
+
+struct from_view {
+    typedef compact_t result_type;
+
+    template<typename T>
+    auto operator()(const T& value) const -> result_type {
+        return compact_t(value);
+    }
+};
+
+}  // namespace
+
+static_assert(sizeof(compact_t) <= 24, "padding or alignment violation");
+
+compact_t::compact_t() noexcept :
+    compact_t(nullptr)
+{}
+
+compact_t::compact_t(std::nullptr_t) noexcept :
+    size(0),
+    tag(tag_t::null)
+{}
+
+compact_t::compact_t(bool value) noexcept :
+    size(0),
+    tag(tag_t::boolean)
+{
+    payload.boolean = value;
+}
+
+compact_t::compact_t(char value) noexcept :
+    compact_t(static_cast<long long>(value))
+{}
+
+compact_t::compact_t(short value) noexcept :
+    compact_t(static_cast<long long>(value))
+{}
+
+compact_t::compact_t(int value) noexcept :
+    compact_t(static_cast<long long>(value))
+{}
+
+compact_t::compact_t(long value) noexcept :
+    compact_t(static_cast<long long>(value))
+{}
+
+compact_t::compact_t(long long value) noexcept :
+    size(0),
+    tag(tag_t::sint64)
+{
+    payload.sint64 = static_cast<std::int64_t>(value);
+}
+
+compact_t::compact_t(unsigned char value) noexcept :
+    compact_t(static_cast<unsigned long long>(value))
+{}
+
+compact_t::compact_t(unsigned short value) noexcept :
+    compact_t(static_cast<unsigned long long>(value))
+{}
+
+compact_t::compact_t(unsigned int value) noexcept :
+    compact_t(static_cast<unsigned long long>(value))
+{}
+
+compact_t::compact_t(unsigned long value) noexcept :
+    compact_t(static_cast<unsigned long long>(value))
+{}
+
+compact_t::compact_t(unsigned long long value) noexcept :
+    size(0),
+    tag(tag_t::uint64)
+{
+    payload.uint64 = static_cast<std::uint64_t>(value);
+}
+
+compact_t::compact_t(double value) noexcept :
+    size(0),
+    tag(tag_t::real)
+{
+    payload.real = value;
+}
+
+compact_t::compact_t(const string_view& value) :
+    size(0),
+    tag(tag_t::null)
+{
+    assign(value);
+}
+
+compact_t::compact_t(const std::string& value) :
+    compact_t(string_view(value))
+{}
+
+compact_t::compact_t(const view_t::function_type& value) noexcept :
+    size(0),
+    tag(tag_t::function)
+{
+    payload.function = function_t{value.value, &value.fn.get()};
+}
+
+compact_t::compact_t(const view_t& value) :
+    compact_t(boost::apply_visitor(from_view(), value.inner().value))
+{}
+
+compact_t::compact_t(const value_t& value) :
+    compact_t(view_t(value))
+{}
+
+compact_t::compact_t(const compact_t& other) :
+    payload(other.payload),
+    size(other.size),
+    tag(other.tag)
+{
+    if (tag == tag_t::large) {
+        tag = tag_t::null;
+        assign(string_view(other.payload.large.data, other.payload.large.size));
+    }
+}
+
+compact_t::compact_t(compact_t&& other) noexcept :
+    payload(other.payload),
+    size(other.size),
+    tag(other.tag)
+{
+    other.tag = tag_t::null;
+}
+
+compact_t::~compact_t() {
+    reset();
+}
+
+auto compact_t::operator=(const compact_t& other) -> compact_t& {
+    if (this != &other) {
+        compact_t copy(other);
+        *this = std::move(copy);
+    }
+
+    return *this;
+}
+
+auto compact_t::operator=(compact_t&& other) noexcept -> compact_t& {
+    if (this != &other) {
+        reset();
+        payload = other.payload;
+        size = other.size;
+        tag = other.tag;
+        other.tag = tag_t::null;
+    }
+
+    return *this;
+}
+
+auto compact_t::view() const noexcept -> view_t {
+    switch (tag) {
+    case tag_t::null:
+        return view_t(nullptr);
+    case tag_t::boolean:
+        return view_t(payload.boolean);
+    case tag_t::sint64:
+        return view_t(payload.sint64);
+    case tag_t::uint64:
+        return view_t(payload.uint64);
+    case tag_t::real:
+        return view_t(payload.real);
+    case tag_t::small:
+        return view_t(string_view(payload.small, size));
+    case tag_t::large:
+        return view_t(string_view(payload.large.data, payload.large.size));
+    case tag_t::function:
+        return view_t(view_t::function_type{payload.function.value, std::ref(*payload.function.fn)});
+    }
+
+    return view_t();
+}
+
+auto compact_t::operator==(const compact_t& other) const -> bool {
+    return view() == other.view();
+}
+
+auto compact_t::operator!=(const compact_t& other) const -> bool {
+    return !(*this == other);
+}
+
+auto compact_t::assign(const string_view& value) -> void {
+    if (value.size() <= capacity) {
+        if (value.size() > 0) {
+            std::memcpy(payload.small, value.data(), value.size());
+        }
+
+        size = static_cast<std::uint8_t>(value.size());
+        tag = tag_t::small;
+    } else {
+        const auto data = new char[value.size()];
+        std::memcpy(data, value.data(), value.size());
+
+        payload.large = large_t{data, value.size()};
+        tag = tag_t::large;
+    }
+}
+
+auto compact_t::reset() noexcept -> void {
+    if (tag == tag_t::large) {
+        delete[] payload.large.data;
+    }
+
+    tag = tag_t::null;
+}
+
+}  // namespace attribute
+
+auto into_compact(attributes_t source, std::unique_ptr<const attributes_t>& holder) ->
+    compact_attributes_t
+{
+    const auto function = std::any_of(source.begin(), source.end(), [](const attribute_t& attribute) {
+        return boost::get<attribute::value_t::function_type>(&attribute.second.inner().value) != nullptr;
+    });
+
+    const attributes_t* attributes = &source;
+
+    if (function) {
+        holder.reset(new attributes_t(std::move(source)));
+        attributes = holder.get();
+    }
+
+    compact_attributes_t result;
+    result.reserve(attributes->size());
+
+    for (const auto& attribute : *attributes) {
+        result.emplace_back(attribute.first, attribute.second);
+    }
+
+    return result;
+}
+
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,71 @@
+#include "blackhole/attribute/key.hpp"
+
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace blackhole {
+inline namespace v1 {
+namespace attribute {
+namespace {
+
+struct entry_t {
+    std::string name;
+    std::uint64_t hash;
+    std::uint32_t id;
+};
+
+/// Process-wide storage of interned names.
+///
+/// Entries are kept in a deque, which never relocates its elements on growth, so interned names
+/// are stable.
+class registry_t {
+    std::mutex mutex;
+    std::deque<entry_t> entries;
+    std::unordered_map<string_view, const entry_t*> index;
+
+public:
+    /// Returns the registry, which is never destroyed, allowing to intern keys during both static
+    /// initialization and destruction.
+    static auto instance() -> registry_t& {
+        static auto registry = new registry_t;
+        return *registry;
+    }
+
+    auto intern(const string_view& name) -> const entry_t& {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        const auto it = index.find(name);
+        if (it != index.end()) {
+            return *it->second;
+        }
+
+        const auto id = static_cast<std::uint32_t>(entries.size());
+        entries.push_back({name.to_string(), std::hash<string_view>()(name), id});
+
+        try {
+            const auto& entry = entries.back();
+            index.insert({string_view(entry.name), &entry});
+            return entry;
+        } catch (...) {
+            entries.pop_back();
+            throw;
+        }
+    }
+};
+
+}  // namespace
+
+key_t::key_t(const string_view& name) {
+    const auto& entry = registry_t::instance().intern(name);
+
+    name_ = string_view(entry.name);
+    hash_ = entry.hash;
+    id_ = entry.id;
+}
+
+}  // namespace attribute
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,253 @@
+#include "blackhole/attribute/table.hpp"
+
+#include <vector>
+
+#include "blackhole/attribute/key.hpp"
+
+#include "blackhole/detail/attribute.hpp"
+#include "blackhole/detail/simd.hpp"
+
+#if defined(BLACKHOLE_SIMD_X86)
+#include <immintrin.h>
+#elif defined(BLACKHOLE_SIMD_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace blackhole {
+inline namespace v1 {
+namespace attribute {
+
+namespace {
+
+auto hash_of(const string_view& key) noexcept -> std::uint32_t {
+    return static_cast<std::uint32_t>(std::hash<string_view>()(key));
+}
+
+auto tail(const std::uint32_t* hashes, std::size_t size, std::size_t pos, std::uint32_t hash)
+    noexcept -> std::size_t
+{
+    for (; pos < size; ++pos) {
+        if (hashes[pos] == hash) {
+            return pos;
+        }
+    }
+
+    return size;
+}
+
+#if defined(BLACKHOLE_SIMD_X86)
+BLACKHOLE_TARGET_SSE2
+auto scan_sse2(const std::uint32_t* hashes, std::size_t size, std::size_t pos, std::uint32_t hash)
+    noexcept -> std::size_t
+{
+    const auto needle = _mm_set1_epi32(static_cast<int>(hash));
+
+    for (; pos + 4 <= size; pos += 4) {
+        const auto chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(hashes + pos));
+        const auto mask = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(chunk, needle)));
+
+        if (mask != 0) {
+            return pos + static_cast<std::size_t>(__builtin_ctz(static_cast<unsigned int>(mask)));
+        }
+    }
+
+    return tail(hashes, size, pos, hash);
+}
+
+BLACKHOLE_TARGET_AVX2
+auto scan_avx2(const std::uint32_t* hashes, std::size_t size, std::size_t pos, std::uint32_t hash)
+    noexcept -> std::size_t
+{
+    const auto needle = _mm256_set1_epi32(static_cast<int>(hash));
+
+    for (; pos + 8 <= size; pos += 8) {
+        const auto chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(hashes + pos));
+        const auto equal = _mm256_cmpeq_epi32(chunk, needle);
+        const auto mask = _mm256_movemask_ps(_mm256_castsi256_ps(equal));
+
+        if (mask != 0) {
+            return pos + static_cast<std::size_t>(__builtin_ctz(static_cast<unsigned int>(mask)));
+        }
+    }
+
+    return tail(hashes, size, pos, hash);
+}
+
+BLACKHOLE_TARGET_AVX512
+auto scan_avx512(const std::uint32_t* hashes, std::size_t size, std::size_t pos,
+                 std::uint32_t hash) noexcept -> std::size_t
+{
+    const auto needle = _mm512_set1_epi32(static_cast<int>(hash));
+
+    for (; pos + 16 <= size; pos += 16) {
+        const auto mask = _mm512_cmpeq_epi32_mask(_mm512_loadu_si512(hashes + pos), needle);
+
+        if (mask != 0) {
+            return pos + static_cast<std::size_t>(__builtin_ctz(static_cast<unsigned int>(mask)));
+        }
+    }
+
+    return tail(hashes, size, pos, hash);
+}
+#endif
+
+#if defined(BLACKHOLE_SIMD_NEON)
+auto scan_neon(const std::uint32_t* hashes, std::size_t size, std::size_t pos, std::uint32_t hash)
+    noexcept -> std::size_t
+{
+    const auto needle = vdupq_n_u32(hash);
+
+    for (; pos + 4 <= size; pos += 4) {
+        const auto equal = vceqq_u32(vld1q_u32(hashes + pos), needle);
+
+        if (vmaxvq_u32(equal) != 0) {
+            break;
+        }
+    }
+
+    return tail(hashes, size, pos, hash);
+}
+#endif
+
+/// Returns the position of the first hash equal to the given one starting from the given position
+/// or the size if there is none.
+detail::simd::kernel_t<std::size_t(const std::uint32_t*, std::size_t, std::size_t, std::uint32_t)>
+    scan(&tail,
+         BLACKHOLE_SIMD_X86_VARIANT(scan_sse2),
+         BLACKHOLE_SIMD_X86_VARIANT(scan_avx2),
+         BLACKHOLE_SIMD_X86_VARIANT(scan_avx512),
+         BLACKHOLE_SIMD_NEON_VARIANT(scan_neon));
+
+}  // namespace
+
+/// Heap columns of tables with more than `capacity` attributes.
+struct table_t::overflow_t {
+    std::vector<std::uint32_t> hashes;
+    std::vector<string_view> keys;
+    std::vector<tag_t> tags;
+    std::vector<const view_t*> values;
+};
+
+constexpr std::size_t table_t::capacity;
+
+table_t::table_t() noexcept :
+    unique(nullptr),
+    ready(false),
+    size_(0),
+    hashes_(nullptr),
+    keys_(nullptr),
+    tags_(nullptr),
+    values_(nullptr)
+{}
+
+table_t::table_t(std::reference_wrapper<const unique_attributes_t> unique) noexcept :
+    table_t()
+{
+    this->unique = &unique.get();
+}
+
+table_t::~table_t() = default;
+
+auto table_t::reset(std::reference_wrapper<const unique_attributes_t> unique) noexcept -> void {
+    this->unique = &unique.get();
+    ready = false;
+}
+
+auto table_t::size() const -> std::size_t {
+    compute();
+    return size_;
+}
+
+auto table_t::empty() const -> bool {
+    return size() == 0;
+}
+
+auto table_t::hashes() const -> const std::uint32_t* {
+    compute();
+    return hashes_;
+}
+
+auto table_t::keys() const -> const string_view* {
+    compute();
+    return keys_;
+}
+
+auto table_t::tags() const -> const tag_t* {
+    compute();
+    return tags_;
+}
+
+auto table_t::values() const -> const view_t* const* {
+    compute();
+    return values_;
+}
+
+auto table_t::find(const string_view& key) const -> const view_t* {
+    return find(key, hash_of(key));
+}
+
+auto table_t::find(const key_t& key) const -> const view_t* {
+    return find(key.name(), static_cast<std::uint32_t>(key.hash()));
+}
+
+auto table_t::find(const string_view& key, std::uint32_t hash) const -> const view_t* {
+    compute();
+
+    for (auto pos = scan(hashes_, size_, 0, hash); pos < size_;
+        pos = scan(hashes_, size_, pos + 1, hash))
+    {
+        if (keys_[pos] == key) {
+            return values_[pos];
+        }
+    }
+
+    return nullptr;
+}
+
+auto table_t::compute() const -> void {
+    if (ready) {
+        return;
+    }
+
+    ready = true;
+    size_ = unique ? unique->size() : 0;
+
+    if (size_ <= capacity) {
+        hashes_ = reinterpret_cast<std::uint32_t*>(&inline_hashes);
+        keys_ = reinterpret_cast<string_view*>(&inline_keys);
+        tags_ = reinterpret_cast<tag_t*>(&inline_tags);
+        values_ = reinterpret_cast<const view_t**>(&inline_values);
+    } else {
+        if (!overflow) {
+            overflow.reset(new overflow_t);
+        }
+
+        overflow->hashes.resize(size_);
+        overflow->keys.resize(size_);
+        overflow->tags.resize(size_);
+        overflow->values.resize(size_);
+
+        hashes_ = overflow->hashes.data();
+        keys_ = overflow->keys.data();
+        tags_ = overflow->tags.data();
+        values_ = overflow->values.data();
+    }
+
+    if (size_ == 0) {
+        return;
+    }
+
+    std::size_t id = 0;
+    for (const auto& attribute : *unique) {
+        // Columns are trivially destructible, so inline ones are constructed in place.
+        hashes_[id] = hash_of(attribute.first);
+        new(keys_ + id) string_view(attribute.first);
+        tags_[id] = static_cast<tag_t>(attribute.second.inner().value.which());
+        values_[id] = &attribute.second;
+        ++id;
+    }
+}
+
+}  // namespace attribute
+}  // namespace v1
+}  // namespace blackhole
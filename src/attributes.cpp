@@ -0,0 +1,119 @@
+#include "blackhole/attributes.hpp"
+
+#include <algorithm>
+#include <vector>
+
+#include "blackhole/attribute.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace {
+
+/// Packs with no more than this number of attributes are deduplicated using linear search, which
+/// beats sorting on such sizes.
+constexpr std::size_t linear_limit = 32;
+
+typedef std::pair<const unique_attributes_t::value_type*, std::size_t> entry_type;
+
+}  // namespace
+
+unique_attributes_t::unique_attributes_t() noexcept :
+    pack(nullptr),
+    ready(false)
+{}
+
+unique_attributes_t::unique_attributes_t(std::reference_wrapper<const attribute_pack> pack) noexcept :
+    pack(&pack.get()),
+    ready(false)
+{}
+
+auto unique_attributes_t::reset(std::reference_wrapper<const attribute_pack> pack) noexcept -> void {
+    this->pack = &pack.get();
+    ready = false;
+}
+
+auto unique_attributes_t::begin() const -> const_iterator {
+    return const_iterator(compute().begin());
+}
+
+auto unique_attributes_t::end() const -> const_iterator {
+    return const_iterator(compute().end());
+}
+
+auto unique_attributes_t::size() const -> std::size_t {
+    return compute().size();
+}
+
+auto unique_attributes_t::empty() const -> bool {
+    return compute().empty();
+}
+
+auto unique_attributes_t::compute() const -> const container_type& {
+    if (ready) {
+        return items;
+    }
+
+    items.clear();
+    ready = true;
+
+    if (pack == nullptr) {
+        return items;
+    }
+
+    std::size_t total = 0;
+    for (const auto& list : *pack) {
+        total += list.get().size();
+    }
+
+    if (total <= linear_limit) {
+        for (const auto& list : *pack) {
+            for (const auto& attribute : list.get()) {
+                const auto duplicate = std::any_of(items.begin(), items.end(),
+                    [&](const value_type* item) {
+                        return item->first == attribute.first;
+                    });
+
+                if (!duplicate) {
+                    items.push_back(&attribute);
+                }
+            }
+        }
+
+        return items;
+    }
+
+    // Attributes are indexed by their pack position to be able to restore the original order after
+    // sorting, because addresses of attributes from different lists are not comparable.
+    std::vector<entry_type> sorted;
+    sorted.reserve(total);
+
+    for (const auto& list : *pack) {
+        for (const auto& attribute : list.get()) {
+            sorted.emplace_back(&attribute, sorted.size());
+        }
+    }
+
+    // Stable sorting keeps the first attribute of each key group in front.
+    std::stable_sort(sorted.begin(), sorted.end(), [](const entry_type& lhs, const entry_type& rhs) {
+        return lhs.first->first < rhs.first->first;
+    });
+
+    const auto last = std::unique(sorted.begin(), sorted.end(),
+        [](const entry_type& lhs, const entry_type& rhs) {
+            return lhs.first->first == rhs.first->first;
+        });
+
+    std::sort(sorted.begin(), last, [](const entry_type& lhs, const entry_type& rhs) {
+        return lhs.second < rhs.second;
+    });
+
+    items.reserve(static_cast<std::size_t>(last - sorted.begin()));
+    for (auto it = sorted.begin(); it != last; ++it) {
+        items.push_back(it->first);
+    }
+
+    return items;
+}
+
+}  // namespace v1
+}  // namespace blackhole
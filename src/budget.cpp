@@ -0,0 +1,68 @@
+#include "blackhole/budget.hpp"
+
+#include <atomic>
+
+#include "blackhole/detail/budget.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace {
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wglobal-constructors"
+
+/// Statically initialized, so allocations made during static initialization are accounted.
+std::atomic<std::size_t> total(0);
+std::atomic<std::size_t> usage(0);
+std::atomic<std::uint64_t> rejections(0);
+
+#pragma clang diagnostic pop
+
+}  // namespace
+
+namespace detail {
+namespace budget {
+
+auto admit() noexcept -> bool {
+    const auto limit = total.load(std::memory_order_relaxed);
+
+    if (limit == 0 || usage.load(std::memory_order_relaxed) < limit) {
+        return true;
+    }
+
+    rejections.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+auto charge(std::size_t bytes) noexcept -> void {
+    usage.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+auto release(std::size_t bytes) noexcept -> void {
+    usage.fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+}  // namespace budget
+}  // namespace detail
+
+namespace budget {
+
+auto limit(std::size_t bytes) noexcept -> void {
+    total.store(bytes, std::memory_order_relaxed);
+}
+
+auto limit() noexcept -> std::size_t {
+    return total.load(std::memory_order_relaxed);
+}
+
+auto used() noexcept -> std::size_t {
+    return usage.load(std::memory_order_relaxed);
+}
+
+auto rejected() noexcept -> std::uint64_t {
+    return rejections.load(std::memory_order_relaxed);
+}
+
+}  // namespace budget
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,353 @@
+#include "blackhole/callsite.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "blackhole/extensions/format.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace callsite {
+namespace {
+
+auto matches(const query_t& query, const site_t& site) -> bool {
+    if (!query.file.empty() && std::strstr(site.file(), query.file.c_str()) == nullptr) {
+        return false;
+    }
+
+    if (!query.function.empty() && query.function != site.function()) {
+        return false;
+    }
+
+    if (!query.pattern.empty() && std::strstr(site.pattern(), query.pattern.c_str()) == nullptr) {
+        return false;
+    }
+
+    return query.line == 0 || query.line == site.line();
+}
+
+/// Process-wide table of registered sites and rules applied to them.
+class registry_t {
+    struct rule_t {
+        query_t query;
+        bool enabled;
+    };
+
+    std::mutex mutex;
+    std::vector<site_t*> sites;
+    std::vector<rule_t> rules;
+
+public:
+    /// Returns the registry, which is never destroyed, since sites may be checked during static
+    /// destruction.
+    static auto instance() -> registry_t& {
+        static auto registry = new registry_t;
+        return *registry;
+    }
+
+    auto enroll(site_t& site) -> bool {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        // Another thread may have registered the site while this one was waiting for the lock, in
+        // which case its state is already set.
+        if (std::find(sites.begin(), sites.end(), &site) != sites.end()) {
+            return site.is_enabled();
+        }
+
+        sites.push_back(&site);
+
+        auto enabled = false;
+        for (auto it = rules.rbegin(); it != rules.rend(); ++it) {
+            if (matches(it->query, site)) {
+                enabled = it->enabled;
+                break;
+            }
+        }
+
+        site.set(enabled);
+        return enabled;
+    }
+
+    auto set(const query_t& query, bool enabled) -> std::size_t {
+        std::lock_guard<std::mutex> lock(mutex);
+        rules.push_back({query, enabled});
+
+        std::size_t result = 0;
+        for (auto site : sites) {
+            if (matches(query, *site)) {
+                site->set(enabled);
+                ++result;
+            }
+        }
+
+        return result;
+    }
+
+    auto reset() -> void {
+        std::lock_guard<std::mutex> lock(mutex);
+        rules.clear();
+
+        for (auto site : sites) {
+            site->set(false);
+        }
+    }
+
+    auto each(const std::function<auto(const site_t& site) -> void>& fn) -> void {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        for (auto site : sites) {
+            fn(*site);
+        }
+    }
+};
+
+/// Splits the command into terms, allowing double quoted values with spaces.
+auto tokenize(const std::string& command) -> std::vector<std::string> {
+    std::vector<std::string> result;
+
+    for (std::size_t pos = 0; pos < command.size();) {
+        if (std::isspace(command[pos])) {
+            ++pos;
+            continue;
+        }
+
+        std::string token;
+        auto quoted = false;
+
+        for (; pos < command.size() && (quoted || !std::isspace(command[pos])); ++pos) {
+            if (command[pos] == '"') {
+                quoted = !quoted;
+            } else {
+                token.push_back(command[pos]);
+            }
+        }
+
+        if (quoted) {
+            throw std::invalid_argument("unterminated quoted value");
+        }
+
+        result.push_back(std::move(token));
+    }
+
+    return result;
+}
+
+}  // namespace
+
+auto site_t::enroll() noexcept -> bool {
+    try {
+        return registry_t::instance().enroll(*this);
+    } catch (...) {
+        // Failing to register leaves the site disabled until the next check.
+        return false;
+    }
+}
+
+auto set(const query_t& query, bool enabled) -> std::size_t {
+    return registry_t::instance().set(query, enabled);
+}
+
+auto apply(const std::string& command) -> std::size_t {
+    const auto tokens = tokenize(command);
+
+    if (tokens.empty() || (tokens.back() != "+" && tokens.back() != "-")) {
+        throw std::invalid_argument("command must end with either '+' or '-'");
+    }
+
+    query_t query;
+    for (std::size_t id = 0; id + 1 < tokens.size(); ++id) {
+        const auto& token = tokens[id];
+        const auto eq = token.find('=');
+
+        if (eq == std::string::npos) {
+            throw std::invalid_argument(fmt::format("expected 'field=value', got '{}'", token));
+        }
+
+        const auto field = token.substr(0, eq);
+        const auto value = token.substr(eq + 1);
+
+        if (field == "file") {
+            query.file = value;
+        } else if (field == "func") {
+            query.function = value;
+        } else if (field == "format") {
+            query.pattern = value;
+        } else if (field == "line") {
+            char* end = nullptr;
+            query.line = static_cast<int>(std::strtol(value.c_str(), &end, 10));
+
+            if (value.empty() || *end != '\0' || query.line <= 0) {
+                throw std::invalid_argument(fmt::format("invalid line number '{}'", value));
+            }
+        } else {
+            throw std::invalid_argument(fmt::format("unknown field '{}'", field));
+        }
+    }
+
+    return set(query, tokens.back() == "+");
+}
+
+auto reset() -> void {
+    registry_t::instance().reset();
+}
+
+auto each(const std::function<auto(const site_t& site) -> void>& fn) -> void {
+    registry_t::instance().each(fn);
+}
+
+class control_t::inner_t {
+public:
+    std::string path;
+    int fd;
+    /// Self-pipe waking the serving thread up on shutdown.
+    int wakeup[2];
+    std::thread thread;
+
+    explicit inner_t(std::string path) :
+        path(std::move(path)),
+        fd(-1),
+        wakeup{-1, -1}
+    {}
+
+    ~inner_t() {
+        for (auto fd : {this->fd, wakeup[0], wakeup[1]}) {
+            if (fd >= 0) {
+                ::close(fd);
+            }
+        }
+    }
+
+    auto run() -> void {
+        while (true) {
+            pollfd fds[] = {{fd, POLLIN, 0}, {wakeup[0], POLLIN, 0}};
+
+            if (::poll(fds, 2, -1) < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+
+                return;
+            }
+
+            if (fds[1].revents != 0) {
+                return;
+            }
+
+            const auto client = ::accept(fd, nullptr, nullptr);
+            if (client >= 0) {
+                const auto stopped = serve(client);
+                ::close(client);
+
+                if (stopped) {
+                    return;
+                }
+            }
+        }
+    }
+
+private:
+    /// Serves the client until it disconnects, returns true if stopped meanwhile.
+    auto serve(int client) -> bool {
+        std::string buffer;
+        char data[512];
+
+        while (true) {
+            pollfd fds[] = {{client, POLLIN, 0}, {wakeup[0], POLLIN, 0}};
+
+            if (::poll(fds, 2, -1) < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+
+                return false;
+            }
+
+            if (fds[1].revents != 0) {
+                return true;
+            }
+
+            const auto size = ::read(client, data, sizeof(data));
+            if (size <= 0) {
+                return false;
+            }
+
+            buffer.append(data, static_cast<std::size_t>(size));
+
+            for (auto pos = buffer.find('\n'); pos != std::string::npos; pos = buffer.find('\n')) {
+                const auto command = buffer.substr(0, pos);
+                buffer.erase(0, pos + 1);
+
+                std::string reply;
+                try {
+                    reply = fmt::format("{}\n", apply(command));
+                } catch (const std::exception& err) {
+                    reply = fmt::format("error: {}\n", err.what());
+                }
+
+                if (::send(client, reply.data(), reply.size(), MSG_NOSIGNAL) < 0) {
+                    return false;
+                }
+            }
+        }
+    }
+};
+
+control_t::control_t(const std::string& path) :
+    d(new inner_t(path))
+{
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+
+    if (path.empty() || path.size() >= sizeof(address.sun_path)) {
+        throw std::invalid_argument("control socket path must be non-empty and fit sockaddr_un");
+    }
+
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, path.data(), path.size());
+
+    if (::pipe2(d->wakeup, O_CLOEXEC) != 0) {
+        throw std::system_error(errno, std::system_category(), "failed to create pipe");
+    }
+
+    d->fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (d->fd < 0) {
+        throw std::system_error(errno, std::system_category(), "failed to create socket");
+    }
+
+    ::unlink(path.c_str());
+
+    if (::bind(d->fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 ||
+        ::listen(d->fd, 16) != 0)
+    {
+        throw std::system_error(errno, std::system_category(),
+            fmt::format("failed to bind control socket '{}'", path));
+    }
+
+    d->thread = std::thread(&inner_t::run, d.get());
+}
+
+control_t::~control_t() {
+    const char byte = 0;
+    while (::write(d->wakeup[1], &byte, 1) < 0 && errno == EINTR) {
+    }
+
+    d->thread.join();
+    ::unlink(d->path.c_str());
+}
+
+}  // namespace callsite
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,222 @@
+#include "blackhole/capture.hpp"
+
+#include <atomic>
+
+#include <boost/variant/get.hpp>
+
+#include "blackhole/attribute.hpp"
+
+#include "blackhole/detail/attribute.hpp"
+#include "blackhole/detail/capture.hpp"
+#include "blackhole/detail/record.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace {
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wglobal-constructors"
+
+std::atomic<std::size_t> message_limit(0);
+std::atomic<std::size_t> value_limit(0);
+std::atomic<std::size_t> attributes_limit(0);
+std::atomic<std::uint64_t> truncations(0);
+
+#pragma clang diagnostic pop
+
+/// Inline capacity of attribute lists, which bounded records fill one after another.
+constexpr std::size_t chunk = 16;
+
+/// Returns the string attribute value if any.
+auto string_of(const attribute::view_t& value) noexcept -> const string_view* {
+    return boost::get<attribute::view_t::string_type>(&value.inner().value);
+}
+
+}  // namespace
+
+namespace capture {
+
+auto limit(const limits_t& limits) noexcept -> void {
+    message_limit.store(limits.message, std::memory_order_relaxed);
+    value_limit.store(limits.value, std::memory_order_relaxed);
+    attributes_limit.store(limits.attributes, std::memory_order_relaxed);
+}
+
+auto limits() noexcept -> limits_t {
+    limits_t result;
+    result.message = message_limit.load(std::memory_order_relaxed);
+    result.value = value_limit.load(std::memory_order_relaxed);
+    result.attributes = attributes_limit.load(std::memory_order_relaxed);
+    return result;
+}
+
+auto truncated() noexcept -> std::uint64_t {
+    return truncations.load(std::memory_order_relaxed);
+}
+
+}  // namespace capture
+
+namespace detail {
+namespace capture {
+
+const string_view marker("...");
+
+auto cut(const string_view& value, std::size_t size) noexcept -> std::size_t {
+    if (size >= value.size()) {
+        return value.size();
+    }
+
+    // Continuation bytes are 10xxxxxx, the character starts before them.
+    while (size > 0 && (static_cast<unsigned char>(value[size]) & 0xc0) == 0x80) {
+        --size;
+    }
+
+    return size;
+}
+
+auto account() noexcept -> void {
+    truncations.fetch_add(1, std::memory_order_relaxed);
+}
+
+bounded_t::bounded_t(const record_t& record) :
+    source(&record)
+{
+    const auto message = message_limit.load(std::memory_order_relaxed);
+    const auto value = value_limit.load(std::memory_order_relaxed);
+    const auto attributes = attributes_limit.load(std::memory_order_relaxed);
+
+    if (message == 0 && value == 0 && attributes == 0) {
+        return;
+    }
+
+    auto exceeded = message != 0 &&
+        (record.formatted().size() > message || record.message().size() > message);
+
+    std::size_t count = 0;
+    for (const auto& list : record.attributes()) {
+        for (const auto& kv : list.get()) {
+            ++count;
+
+            if (value != 0) {
+                const auto string = string_of(kv.second);
+                exceeded = exceeded || (string != nullptr && string->size() > value);
+            }
+        }
+    }
+
+    exceeded = exceeded || (attributes != 0 && count > attributes);
+
+    if (exceeded) {
+        bound(record, message, value, attributes);
+        account();
+    }
+}
+
+auto bounded_t::get() const noexcept -> const record_t& {
+    return result ? result.get() : *source;
+}
+
+auto bounded_t::bound(const record_t& record, std::size_t message, std::size_t value,
+                      std::size_t attributes) -> void
+{
+    const auto kept = [&](const string_view& string, std::size_t limit) -> std::size_t {
+        return limit == 0 || string.size() <= limit ? string.size() : cut(string, limit);
+    };
+
+    // Cut values are copied one after another, so the storage is reserved up front to keep views
+    // valid.
+    std::size_t size = 0;
+    std::size_t count = 0;
+
+    if (kept(record.formatted(), message) < record.formatted().size()) {
+        size += kept(record.formatted(), message) + marker.size();
+    }
+
+    for (const auto& list : record.attributes()) {
+        for (const auto& kv : list.get()) {
+            if (attributes != 0 && count == attributes) {
+                break;
+            }
+
+            ++count;
+
+            const auto string = string_of(kv.second);
+            if (string != nullptr && kept(*string, value) < string->size()) {
+                size += kept(*string, value) + marker.size();
+            }
+        }
+    }
+
+    storage.reserve(size);
+
+    const auto copy = [&](const string_view& string, std::size_t size) -> string_view {
+        const auto offset = storage.size();
+        storage.append(string.data(), size);
+        storage.append(marker.data(), marker.size());
+        return string_view(storage.data() + offset, size + marker.size());
+    };
+
+    // Patterns are cut in place, since filters tell call sites apart by their address.
+    this->message = record.message().substr(0, kept(record.message(), message));
+
+    const auto formatted = kept(record.formatted(), message);
+    this->formatted = formatted < record.formatted().size() ?
+        copy(record.formatted(), formatted) :
+        record.formatted();
+
+    std::size_t total = 0;
+    for (const auto& list : record.attributes()) {
+        total += list.get().size();
+    }
+
+    const auto elided = attributes != 0 && total > attributes ? total - attributes : 0;
+    const auto entries = total - elided + (elided > 0 ? 1 : 0);
+
+    // Lists are referred to by the pack, so they must not be reallocated.
+    lists.resize(entries == 0 ? 1 : (entries - 1) / chunk + 1);
+
+    std::size_t id = 0;
+    for (const auto& list : record.attributes()) {
+        for (const auto& kv : list.get()) {
+            if (id == total - elided) {
+                break;
+            }
+
+            const auto string = string_of(kv.second);
+            if (string != nullptr && kept(*string, value) < string->size()) {
+                lists[id / chunk].emplace_back(kv.first,
+                    attribute::view_t(copy(*string, kept(*string, value))));
+            } else {
+                lists[id / chunk].emplace_back(kv);
+            }
+
+            ++id;
+        }
+    }
+
+    if (elided > 0) {
+        lists[id / chunk].emplace_back("elided", static_cast<std::uint64_t>(elided));
+    }
+
+    for (const auto& list : lists) {
+        pack.emplace_back(list);
+    }
+
+    result = record_t(record_t::inner_t{
+        std::cref(this->message),
+        std::cref(this->formatted),
+        record.severity(),
+        record.timestamp(),
+        record.tid(),
+        record.lwp(),
+        nullptr,
+        nullptr,
+        std::cref(pack),
+        record.trace()
+    });
+}
+
+}  // namespace capture
+}  // namespace detail
+}  // namespace v1
+}  // namespace blackhole
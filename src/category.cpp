@@ -0,0 +1,149 @@
+#include "blackhole/category.hpp"
+
+#include <stdexcept>
+#include <utility>
+
+#include "blackhole/root.hpp"
+
+#include "blackhole/detail/category.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace detail {
+namespace category {
+namespace {
+
+/// Stores the given effective threshold into the node and its descendants that inherit it.
+auto propagate(node_t& node, int threshold) -> void {
+    node.threshold.store(threshold, std::memory_order_relaxed);
+
+    for (auto child : node.children) {
+        if (!child->assigned) {
+            propagate(*child, threshold);
+        }
+    }
+}
+
+}  // namespace
+
+auto registry_t::get(const string_view& name) -> const node_t& {
+    std::lock_guard<std::mutex> lock(mutex);
+    return emplace(name.to_string());
+}
+
+auto registry_t::assign(const string_view& name, int threshold) -> void {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto& node = emplace(name.to_string());
+    node.assigned = true;
+    node.own = threshold;
+    propagate(node, threshold);
+}
+
+auto registry_t::inherit(const string_view& name) -> void {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto& node = emplace(name.to_string());
+    node.assigned = false;
+    node.own = unset;
+    propagate(node, node.parent ? node.parent->threshold.load(std::memory_order_relaxed) : unset);
+}
+
+auto registry_t::merge(const registry_t& other) -> void {
+    std::vector<std::pair<std::string, int>> assigned;
+
+    {
+        std::lock_guard<std::mutex> lock(other.mutex);
+        for (const auto& pair : other.nodes) {
+            if (pair.second->assigned) {
+                assigned.emplace_back(pair.first, pair.second->own);
+            }
+        }
+    }
+
+    // Nodes are ordered by name, so ancestors are assigned before their descendants.
+    for (const auto& pair : assigned) {
+        assign(pair.first, pair.second);
+    }
+}
+
+auto registry_t::emplace(const std::string& name) -> node_t& {
+    const auto it = nodes.find(name);
+    if (it != nodes.end()) {
+        return *it->second;
+    }
+
+    if (name.empty() || name.front() == '.' || name.back() == '.' ||
+        name.find("..") != std::string::npos)
+    {
+        throw std::invalid_argument("category name must consist of non-empty components");
+    }
+
+    const auto dot = name.rfind('.');
+    const auto parent = dot == std::string::npos ? nullptr : &emplace(name.substr(0, dot));
+
+    std::unique_ptr<node_t> node(new node_t(name, parent));
+    const auto result = node.get();
+    nodes.emplace(result->name, std::move(node));
+
+    if (parent) {
+        parent->children.push_back(result);
+    }
+
+    return *result;
+}
+
+}  // namespace category
+}  // namespace detail
+
+category_t::category_t(root_logger_t& root, const detail::category::node_t& node) :
+    root(&root),
+    node(&node),
+    attributes{{"category", attribute::view_t(string_view(node.name))}}
+{}
+
+auto category_t::name() const noexcept -> string_view {
+    return node->name;
+}
+
+auto category_t::threshold() const noexcept -> severity_t {
+    return node->threshold.load(std::memory_order_relaxed);
+}
+
+auto category_t::enabled(severity_t severity) const noexcept -> bool {
+    const auto threshold = node->threshold.load(std::memory_order_relaxed);
+
+    if (threshold == detail::category::unset) {
+        return root->enabled(severity);
+    }
+
+    return root->admit(severity, threshold);
+}
+
+auto category_t::log(severity_t severity, const message_t& message) -> void {
+    attribute_pack pack;
+    log(severity, message, pack);
+}
+
+auto category_t::log(severity_t severity, const message_t& message, attribute_pack& pack) -> void {
+    if (enabled(severity)) {
+        pack.push_back(attributes);
+        root->forward(severity, message, pack);
+    }
+}
+
+auto category_t::log(severity_t severity, const lazy_message_t& message, attribute_pack& pack) ->
+    void
+{
+    if (enabled(severity)) {
+        pack.push_back(attributes);
+        root->forward(severity, message, pack);
+    }
+}
+
+auto category_t::manager() -> scope::manager_t& {
+    return root->manager();
+}
+
+}  // namespace v1
+}  // namespace blackhole
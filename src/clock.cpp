@@ -0,0 +1,174 @@
+#include "blackhole/clock.hpp"
+
+#include <ctime>
+#include <stdexcept>
+#include <thread>
+
+#if defined(__x86_64__) || defined(__i386__)
+#   include <x86intrin.h>
+#   define BLACKHOLE_HAS_TSC
+#endif
+
+namespace blackhole {
+inline namespace v1 {
+namespace clock {
+namespace {
+
+typedef std::chrono::system_clock::time_point time_point;
+
+auto precise() noexcept -> time_point {
+    return std::chrono::system_clock::now();
+}
+
+auto coarse() noexcept -> time_point {
+#ifdef __linux__
+    struct timespec ts;
+    ::clock_gettime(CLOCK_REALTIME_COARSE, &ts);
+
+    const auto duration = std::chrono::seconds(ts.tv_sec) + std::chrono::nanoseconds(ts.tv_nsec);
+    return time_point(std::chrono::duration_cast<time_point::duration>(duration));
+#else
+    return precise();
+#endif
+}
+
+#ifdef BLACKHOLE_HAS_TSC
+/// Maps TSC readings into the realtime clock domain using the rate measured once.
+class tsc_t {
+    std::uint64_t origin;
+    time_point epoch;
+    double ns_per_tick;
+
+public:
+    tsc_t() {
+        const auto tsc0 = __rdtsc();
+        const auto time0 = std::chrono::steady_clock::now();
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+        origin = __rdtsc();
+        epoch = precise();
+
+        const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - time0);
+
+        ns_per_tick = static_cast<double>(elapsed.count()) / static_cast<double>(origin - tsc0);
+    }
+
+    static auto instance() -> const tsc_t& {
+        static const tsc_t clock;
+        return clock;
+    }
+
+    auto rate() const noexcept -> double {
+        return ns_per_tick;
+    }
+
+    auto now() const noexcept -> time_point {
+        const auto ticks = static_cast<double>(__rdtsc() - origin);
+        const std::chrono::nanoseconds elapsed(static_cast<std::int64_t>(ticks * ns_per_tick));
+
+        return epoch + std::chrono::duration_cast<time_point::duration>(elapsed);
+    }
+};
+#endif
+
+/// Time point cached by the thread, trivial to keep thread-local access free of initialization
+/// checks.
+struct slot_t {
+    time_point::rep value;
+    bool cached;
+};
+
+thread_local slot_t slot = {0, false};
+
+}  // namespace
+
+auto cache(time_point timestamp) noexcept -> void {
+    slot.value = timestamp.time_since_epoch().count();
+    slot.cached = true;
+}
+
+auto clear() noexcept -> void {
+    slot.cached = false;
+}
+
+auto timestamp(clock_source_t source) noexcept -> time_point {
+    if (slot.cached) {
+        return time_point(time_point::duration(slot.value));
+    }
+
+    return now(source);
+}
+
+cached_t::cached_t(time_point timestamp) noexcept :
+    previous(time_point::duration(slot.value)),
+    cached(slot.cached)
+{
+    cache(timestamp);
+}
+
+cached_t::~cached_t() {
+    slot.value = previous.time_since_epoch().count();
+    slot.cached = cached;
+}
+
+auto now(clock_source_t source) noexcept -> time_point {
+    switch (source) {
+    case clock_source_t::coarse:
+        return coarse();
+    case clock_source_t::tsc:
+#ifdef BLACKHOLE_HAS_TSC
+        return tsc_t::instance().now();
+#else
+        return coarse();
+#endif
+    case clock_source_t::precise:
+    default:
+        return precise();
+    }
+}
+
+auto prepare(clock_source_t source) -> void {
+#ifdef BLACKHOLE_HAS_TSC
+    if (source == clock_source_t::tsc) {
+        tsc_t::instance();
+    }
+#else
+    (void)source;
+#endif
+}
+
+auto ticks() noexcept -> std::uint64_t {
+#ifdef BLACKHOLE_HAS_TSC
+    return __rdtsc();
+#else
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+auto nanoseconds(std::uint64_t ticks) noexcept -> std::uint64_t {
+#ifdef BLACKHOLE_HAS_TSC
+    return static_cast<std::uint64_t>(static_cast<double>(ticks) * tsc_t::instance().rate());
+#else
+    return ticks;
+#endif
+}
+
+}  // namespace clock
+
+auto clock_source(const std::string& name) -> clock_source_t {
+    if (name == "precise") {
+        return clock_source_t::precise;
+    } else if (name == "coarse") {
+        return clock_source_t::coarse;
+    } else if (name == "tsc") {
+        return clock_source_t::tsc;
+    }
+
+    throw std::invalid_argument("unknown clock source: \"" + name + "\"");
+}
+
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,187 @@
+#include "copy.hpp"
+
+#include <exception>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "blackhole/config/option.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace config {
+namespace {
+
+/// Either a converted value or the exception thrown while converting it.
+template<typename T>
+struct result_t {
+    T value;
+    std::exception_ptr error;
+
+    auto get() const -> T {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+
+        return value;
+    }
+};
+
+template<typename T, typename F>
+auto capture(F fn) -> result_t<T> {
+    try {
+        return {fn(), nullptr};
+    } catch (...) {
+        return {T(), std::current_exception()};
+    }
+}
+
+struct value_t {
+    bool is_bool;
+    bool is_sint64;
+    bool is_uint64;
+    bool is_double;
+    bool is_string;
+    bool is_vector;
+    bool is_object;
+
+    result_t<bool> to_bool;
+    result_t<std::int64_t> to_sint64;
+    result_t<std::uint64_t> to_uint64;
+    result_t<double> to_double;
+    result_t<std::string> to_string;
+
+    std::vector<std::shared_ptr<const value_t>> items;
+    std::vector<std::pair<std::string, std::shared_ptr<const value_t>>> members;
+};
+
+auto make(const node_t& node) -> std::shared_ptr<const value_t> {
+    std::shared_ptr<value_t> value(new value_t{
+        node.is_bool(),
+        node.is_sint64(),
+        node.is_uint64(),
+        node.is_double(),
+        node.is_string(),
+        node.is_vector(),
+        node.is_object(),
+        capture<bool>([&] { return node.to_bool(); }),
+        capture<std::int64_t>([&] { return node.to_sint64(); }),
+        capture<std::uint64_t>([&] { return node.to_uint64(); }),
+        capture<double>([&] { return node.to_double(); }),
+        capture<std::string>([&] { return node.to_string(); }),
+        {},
+        {}
+    });
+
+    if (value->is_vector) {
+        node.each([&](const node_t& item) {
+            value->items.push_back(make(item));
+        });
+    }
+
+    if (value->is_object) {
+        node.each_map([&](const std::string& key, const node_t& member) {
+            value->members.emplace_back(key, make(member));
+        });
+    }
+
+    return value;
+}
+
+/// Node viewing a part of an owned tree, keeping the whole tree alive.
+class copy_t : public node_t {
+    std::shared_ptr<const value_t> value;
+
+public:
+    explicit copy_t(std::shared_ptr<const value_t> value) noexcept :
+        value(std::move(value))
+    {}
+
+    auto is_bool() const noexcept -> bool override {
+        return value->is_bool;
+    }
+
+    auto is_sint64() const noexcept -> bool override {
+        return value->is_sint64;
+    }
+
+    auto is_uint64() const noexcept -> bool override {
+        return value->is_uint64;
+    }
+
+    auto is_double() const noexcept -> bool override {
+        return value->is_double;
+    }
+
+    auto is_string() const noexcept -> bool override {
+        return value->is_string;
+    }
+
+    auto is_vector() const noexcept -> bool override {
+        return value->is_vector;
+    }
+
+    auto is_object() const noexcept -> bool override {
+        return value->is_object;
+    }
+
+    auto to_bool() const -> bool override {
+        return value->to_bool.get();
+    }
+
+    auto to_sint64() const -> std::int64_t override {
+        return value->to_sint64.get();
+    }
+
+    auto to_uint64() const -> std::uint64_t override {
+        return value->to_uint64.get();
+    }
+
+    auto to_double() const -> double override {
+        return value->to_double.get();
+    }
+
+    auto to_string() const -> std::string override {
+        return value->to_string.get();
+    }
+
+    auto each(const each_function& fn) const -> void override {
+        for (const auto& item : value->items) {
+            fn(copy_t(item));
+        }
+    }
+
+    auto each_map(const member_function& fn) const -> void override {
+        for (const auto& member : value->members) {
+            fn(member.first, copy_t(member.second));
+        }
+    }
+
+    auto operator[](const std::size_t& idx) const -> option<node_t> override {
+        if (idx < value->items.size()) {
+            return make_option<copy_t>(value->items[idx]);
+        }
+
+        return {};
+    }
+
+    auto operator[](const std::string& key) const -> option<node_t> override {
+        for (const auto& member : value->members) {
+            if (member.first == key) {
+                return make_option<copy_t>(member.second);
+            }
+        }
+
+        return {};
+    }
+};
+
+}  // namespace
+
+auto copy(const node_t& node) -> std::unique_ptr<node_t> {
+    return std::unique_ptr<node_t>(new copy_t(make(node)));
+}
+
+}  // namespace config
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <memory>
+
+#include "blackhole/config/node.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace config {
+
+/// Returns a deep copy of the given configuration node, which owns its content and so outlives
+/// the configuration it was copied from.
+///
+/// Conversions of the copy behave exactly like the ones of the original node, including throwing
+/// the same exceptions on type mismatches.
+auto copy(const node_t& node) -> std::unique_ptr<node_t>;
+
+}  // namespace config
+}  // namespace v1
+}  // namespace blackhole
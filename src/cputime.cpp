@@ -0,0 +1,247 @@
+#include "blackhole/cputime.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <pthread.h>
+#include <time.h>
+
+#include "blackhole/metrics.hpp"
+
+#include "blackhole/detail/cputime.hpp"
+#include "blackhole/detail/process.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace {
+
+/// Accounting state of the calling thread.
+struct state_t {
+    /// Records left until the next accounted one.
+    std::size_t countdown;
+    /// Whether the record being logged is accounted.
+    bool active;
+};
+
+/// Estimated logging CPU time of a single thread, which is registered with its first accounted
+/// record and unregistered on the thread exit.
+struct account_t {
+    std::thread::native_handle_type handle;
+    std::uint64_t lwp;
+    std::atomic<std::uint64_t> nanoseconds;
+};
+
+class accounts_t {
+    std::mutex mutex;
+    std::vector<account_t*> active;
+    std::atomic<std::uint64_t> exited;
+
+public:
+    accounts_t() noexcept :
+        exited(0)
+    {}
+
+    auto add(account_t* account) -> void {
+        std::lock_guard<std::mutex> lock(mutex);
+        active.push_back(account);
+    }
+
+    auto remove(account_t* account) noexcept -> void {
+        std::lock_guard<std::mutex> lock(mutex);
+        active.erase(std::remove(active.begin(), active.end(), account), active.end());
+        exited.fetch_add(account->nanoseconds.load(std::memory_order_relaxed),
+            std::memory_order_relaxed);
+    }
+
+    auto collect(metrics::collector_t& collector) -> void;
+};
+
+/// Accounts are unregistered by thread-local destructors, which may run after static ones, so the
+/// registry is never destroyed.
+auto accounts() -> accounts_t& {
+    static auto instance = new accounts_t;
+    return *instance;
+}
+
+/// Registers the account of the calling thread on construction, folding its value into the exited
+/// threads sum on destruction.
+class registration_t {
+    account_t account;
+    bool registered;
+
+public:
+    registration_t() noexcept :
+        account{detail::this_thread::native_handle(), detail::this_thread::lwp(), {0}},
+        registered(false)
+    {}
+
+    ~registration_t() {
+        if (registered) {
+            accounts().remove(&account);
+        }
+    }
+
+    registration_t(const registration_t& other) = delete;
+    auto operator=(const registration_t& other) -> registration_t& = delete;
+
+    auto get() -> account_t& {
+        if (!registered) {
+            accounts().add(&account);
+            registered = true;
+        }
+
+        return account;
+    }
+
+    auto spent() const noexcept -> std::uint64_t {
+        return account.nanoseconds.load(std::memory_order_relaxed);
+    }
+};
+
+/// Returns the CPU time consumed by the thread with the given handle, zero if it can't be read.
+auto consumed(std::thread::native_handle_type handle) noexcept -> std::uint64_t {
+#if defined(__linux__)
+    clockid_t id;
+    struct timespec ts;
+
+    if (::pthread_getcpuclockid(handle, &id) == 0 && ::clock_gettime(id, &ts) == 0) {
+        return static_cast<std::uint64_t>(ts.tv_sec) * 1000000000 +
+            static_cast<std::uint64_t>(ts.tv_nsec);
+    }
+#else
+    (void)handle;
+#endif
+
+    return 0;
+}
+
+auto accounts_t::collect(metrics::collector_t& collector) -> void {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    // Registered accounts belong to threads that haven't exited yet, so their handles are valid.
+    for (const auto account : active) {
+        auto labeled = collector
+            .with("thread", detail::this_thread::name(account->handle).to_string())
+            .with("tid", std::to_string(account->lwp));
+
+        labeled.counter("blackhole_log_cpu_nanoseconds_total",
+            account->nanoseconds.load(std::memory_order_relaxed));
+        labeled.counter("blackhole_thread_cpu_nanoseconds_total", consumed(account->handle));
+    }
+
+    collector.counter("blackhole_log_cpu_exited_nanoseconds_total",
+        exited.load(std::memory_order_relaxed));
+}
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wglobal-constructors"
+#pragma clang diagnostic ignored "-Wexit-time-destructors"
+
+std::atomic<std::size_t> period(0);
+
+thread_local registration_t registration;
+
+#pragma clang diagnostic pop
+
+thread_local state_t state{0, false};
+
+}  // namespace
+
+namespace cputime {
+
+auto sample(std::size_t every) -> void {
+    period.store(every, std::memory_order_relaxed);
+}
+
+auto sampling() noexcept -> std::size_t {
+    return period.load(std::memory_order_relaxed);
+}
+
+auto spent() noexcept -> std::uint64_t {
+    return registration.spent();
+}
+
+auto collect(metrics::collector_t& collector) -> void {
+    if (sampling() == 0) {
+        return;
+    }
+
+    accounts().collect(collector);
+}
+
+}  // namespace cputime
+
+namespace detail {
+namespace cputime {
+
+auto now() noexcept -> std::uint64_t {
+    struct timespec ts;
+    if (::clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0) {
+        return 0;
+    }
+
+    return static_cast<std::uint64_t>(ts.tv_sec) * 1000000000 +
+        static_cast<std::uint64_t>(ts.tv_nsec);
+}
+
+scope_t::scope_t() noexcept :
+    every(0),
+    start(0)
+{
+    // Nested records, logged by handlers while handling the outer one, are accounted as a part
+    // of it.
+    if (state.active) {
+        return;
+    }
+
+    const auto sampling = blackhole::cputime::sampling();
+    if (sampling == 0) {
+        return;
+    }
+
+    if (state.countdown == 0 || state.countdown > sampling) {
+        state.countdown = sampling;
+    }
+
+    if (--state.countdown == 0) {
+        every = sampling;
+        state.active = true;
+        start = now();
+    }
+}
+
+scope_t::~scope_t() {
+    if (every == 0) {
+        return;
+    }
+
+    const auto elapsed = now() - start;
+    state.active = false;
+
+    try {
+        registration.get().nanoseconds.fetch_add(elapsed * every, std::memory_order_relaxed);
+    } catch (...) {
+        // Failing to register the thread only loses the accounted time.
+    }
+}
+
+meter_t::meter_t(metrics::counter_t& counter) noexcept :
+    counter(counter),
+    enabled(blackhole::cputime::sampling() != 0),
+    start(enabled ? now() : 0)
+{}
+
+meter_t::~meter_t() {
+    if (enabled) {
+        counter.add(now() - start);
+    }
+}
+
+}  // namespace cputime
+}  // namespace detail
+}  // namespace v1
+}  // namespace blackhole
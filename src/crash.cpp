@@ -0,0 +1,196 @@
+#include "blackhole/crash.hpp"
+
+#include <signal.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <mutex>
+#include <system_error>
+
+#include "blackhole/detail/crash.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace detail {
+namespace crash {
+namespace {
+
+constexpr int capacity = 256;
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wglobal-constructors"
+
+/// Statically initialized, so sources registered during static initialization are not lost.
+std::atomic<const registration_t*> slots[capacity];
+
+#pragma clang diagnostic pop
+
+}  // namespace
+
+registration_t::registration_t(function_type fn, const void* context) noexcept :
+    fn(fn),
+    context(context),
+    slot(-1)
+{
+    for (int id = 0; id < capacity; ++id) {
+        const registration_t* expected = nullptr;
+        if (slots[id].compare_exchange_strong(expected, this, std::memory_order_release)) {
+            slot = id;
+            break;
+        }
+    }
+}
+
+registration_t::~registration_t() {
+    if (slot >= 0) {
+        slots[slot].store(nullptr, std::memory_order_release);
+    }
+}
+
+auto registration_t::dump(int fd) noexcept -> void {
+    for (int id = 0; id < capacity; ++id) {
+        if (const auto registration = slots[id].load(std::memory_order_acquire)) {
+            registration->fn(registration->context, fd);
+        }
+    }
+}
+
+auto write(int fd, const string_view& data) noexcept -> void {
+    std::size_t written = 0;
+
+    while (written < data.size()) {
+        const auto rc = ::write(fd, data.data() + written, data.size() - written);
+
+        if (rc < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            return;
+        }
+
+        written += static_cast<std::size_t>(rc);
+    }
+}
+
+auto write(int fd, std::int64_t value) noexcept -> void {
+    char buffer[24];
+    auto end = buffer + sizeof(buffer);
+    auto pos = end;
+
+    // Negating the minimum value overflows, so digits are extracted from the negative value.
+    const auto negative = value < 0;
+    do {
+        const auto digit = value % 10;
+        *--pos = static_cast<char>('0' + (negative ? -digit : digit));
+        value /= 10;
+    } while (value != 0);
+
+    if (negative) {
+        *--pos = '-';
+    }
+
+    write(fd, string_view(pos, static_cast<std::size_t>(end - pos)));
+}
+
+}  // namespace crash
+}  // namespace detail
+
+namespace crash {
+namespace {
+
+constexpr int signals[] = {SIGSEGV, SIGBUS, SIGILL, SIGFPE, SIGABRT};
+constexpr std::size_t nsignals = sizeof(signals) / sizeof(signals[0]);
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wglobal-constructors"
+#pragma clang diagnostic ignored "-Wexit-time-destructors"
+
+std::mutex mutex;
+bool installed = false;
+struct sigaction previous[nsignals];
+
+/// Descriptor the handler writes into, accessed from signal handlers.
+std::atomic<int> target(-1);
+
+/// Set by the first crashing thread, so that concurrent crashes are dumped once.
+std::atomic<bool> crashed(false);
+
+#pragma clang diagnostic pop
+
+auto handler(int signo) -> void {
+    if (!crashed.exchange(true)) {
+        const auto fd = target.load();
+
+        detail::crash::write(fd, string_view("blackhole: fatal signal "));
+        detail::crash::write(fd, static_cast<std::int64_t>(signo));
+        detail::crash::write(fd, string_view(", dumping pending records\n"));
+
+        dump(fd);
+    }
+
+    // Signals raised by faulting instructions are delivered again once the handler returns, others
+    // are raised explicitly. Both are handled by the previous handlers.
+    for (std::size_t id = 0; id < nsignals; ++id) {
+        if (signals[id] == signo) {
+            ::sigaction(signo, &previous[id], nullptr);
+        }
+    }
+
+    ::raise(signo);
+}
+
+}  // namespace
+
+auto install(int fd) -> void {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    target.store(fd);
+
+    if (installed) {
+        return;
+    }
+
+    struct sigaction action;
+    action.sa_handler = &handler;
+    action.sa_flags = SA_ONSTACK;
+    ::sigemptyset(&action.sa_mask);
+
+    for (std::size_t id = 0; id < nsignals; ++id) {
+        if (::sigaction(signals[id], &action, &previous[id]) != 0) {
+            const auto ec = errno;
+
+            for (std::size_t rollback = 0; rollback < id; ++rollback) {
+                ::sigaction(signals[rollback], &previous[rollback], nullptr);
+            }
+
+            throw std::system_error(ec, std::system_category(),
+                "failed to install fatal signal handler");
+        }
+    }
+
+    installed = true;
+}
+
+auto uninstall() -> void {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (!installed) {
+        return;
+    }
+
+    for (std::size_t id = 0; id < nsignals; ++id) {
+        ::sigaction(signals[id], &previous[id], nullptr);
+    }
+
+    installed = false;
+}
+
+auto dump(int fd) noexcept -> void {
+    detail::crash::registration_t::dump(fd);
+}
+
+}  // namespace crash
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,101 @@
+#include "blackhole/detail/datetime/cache.hpp"
+
+#include "blackhole/extensions/format.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace detail {
+namespace datetime {
+
+cache_t::cache_t() : next(0) {
+    for (auto& entry : entries) {
+        entry.valid = false;
+    }
+}
+
+auto cache_t::format(const std::string& pattern, const generator_t& generator, bool gmtime,
+                     std::time_t time, std::uint64_t usec) -> const std::string&
+{
+    auto& entry = lookup(pattern, gmtime);
+
+    if (!entry.valid || entry.time != time) {
+        generate(entry, generator, time, usec);
+    }
+
+    // Each "%f" is rendered as exactly six zero-padded digits.
+    char usecs[6];
+    for (int id = 5; id >= 0; --id) {
+        usecs[id] = static_cast<char>('0' + usec % 10);
+        usec /= 10;
+    }
+
+    for (std::size_t id = 0; id < entry.digits.size(); ++id) {
+        entry.value[entry.digits[id]] = usecs[id % 6];
+    }
+
+    return entry.value;
+}
+
+auto cache_t::lookup(const std::string& pattern, bool gmtime) -> entry_t& {
+    for (auto& entry : entries) {
+        if (entry.valid && entry.gmtime == gmtime && entry.pattern == pattern) {
+            return entry;
+        }
+    }
+
+    auto& entry = entries[next];
+    next = (next + 1) % entries.size();
+
+    entry.pattern = pattern;
+    entry.gmtime = gmtime;
+    entry.valid = false;
+
+    return entry;
+}
+
+auto cache_t::generate(entry_t& entry, const generator_t& generator, std::time_t time,
+                       std::uint64_t usec) -> void
+{
+    std::tm tm;
+    if (entry.gmtime) {
+        datetime::gmtime(time, tm);
+    } else {
+        zone.localtime(time, tm);
+    }
+
+    // Render the same time twice with different microseconds, the only positions that differ are
+    // the microsecond digits.
+    fmt::MemoryWriter lower;
+    fmt::MemoryWriter upper;
+    generator(lower, tm, 0);
+    generator(upper, tm, 999999);
+
+    entry.value.assign(lower.data(), lower.size());
+    entry.digits.clear();
+    entry.time = time;
+    entry.valid = lower.size() == upper.size();
+
+    if (entry.valid) {
+        for (std::size_t id = 0; id < lower.size(); ++id) {
+            if (lower.data()[id] != upper.data()[id]) {
+                entry.digits.push_back(id);
+            }
+        }
+
+        entry.valid = entry.digits.size() % 6 == 0;
+    }
+
+    if (!entry.valid) {
+        // Unable to locate microseconds, format as is without caching.
+        fmt::MemoryWriter buffer;
+        generator(buffer, tm, usec);
+
+        entry.value.assign(buffer.data(), buffer.size());
+        entry.digits.clear();
+    }
+}
+
+}  // namespace datetime
+}  // namespace detail
+}  // namespace v1
+}  // namespace blackhole
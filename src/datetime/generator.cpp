@@ -0,0 +1,226 @@
+#include "blackhole/detail/datetime/generator.hpp"
+
+#include <cstring>
+
+#include "blackhole/extensions/format.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace detail {
+namespace datetime {
+
+namespace {
+
+typedef fmt::MemoryWriter writer_type;
+typedef generator_t::kind_t kind_t;
+typedef generator_t::token_t token_t;
+
+/// Writes the given non-negative value zero-padded to the given number of digits.
+template<std::size_t Length, char Filler = '0', typename Stream>
+inline auto fill(Stream& stream, std::uint64_t value) -> void {
+    char buffer[Length];
+
+    std::size_t digits = 0;
+    do {
+        buffer[Length - 1 - digits] = static_cast<char>('0' + value % 10);
+        value /= 10;
+        ++digits;
+    } while (value != 0 && digits < Length);
+
+    for (std::size_t id = 0; id < Length - digits; ++id) {
+        buffer[id] = Filler;
+    }
+
+    stream << fmt::StringRef(buffer, Length);
+}
+
+template<typename Stream>
+inline auto strftime(Stream& stream, const char* format, const std::tm& tm) -> void {
+    char buffer[1024];
+    const auto size = std::strftime(buffer, sizeof(buffer), format, &tm);
+    stream << fmt::StringRef(buffer, size);
+}
+
+auto push(std::vector<token_t>& tokens, kind_t kind, std::string value = std::string()) -> void {
+    if (kind == kind_t::literal && !tokens.empty() && tokens.back().kind == kind_t::literal) {
+        tokens.back().value += value;
+    } else {
+        tokens.push_back({kind, std::move(value)});
+    }
+}
+
+/// Appends tokens of the given conversion specifier, returning false if it has no digit writer.
+auto compile(std::vector<token_t>& tokens, char specifier) -> bool {
+    switch (specifier) {
+    case 'Y': push(tokens, kind_t::year); break;
+    case 'y': push(tokens, kind_t::year_short); break;
+    case 'C': push(tokens, kind_t::century); break;
+    case 'm': push(tokens, kind_t::month); break;
+    case 'd': push(tokens, kind_t::mday); break;
+    case 'e': push(tokens, kind_t::mday_spaced); break;
+    case 'j': push(tokens, kind_t::yday); break;
+    case 'H': push(tokens, kind_t::hour); break;
+    case 'I': push(tokens, kind_t::hour_half); break;
+    case 'M': push(tokens, kind_t::minute); break;
+    case 'S': push(tokens, kind_t::second); break;
+    case 'f': push(tokens, kind_t::usecond); break;
+    case 'z': push(tokens, kind_t::offset); break;
+    case 'n': push(tokens, kind_t::literal, "\n"); break;
+    case 't': push(tokens, kind_t::literal, "\t"); break;
+    case '%': push(tokens, kind_t::literal, "%"); break;
+    case 'D':
+        compile(tokens, 'm');
+        push(tokens, kind_t::literal, "/");
+        compile(tokens, 'd');
+        push(tokens, kind_t::literal, "/");
+        compile(tokens, 'y');
+        break;
+    case 'F':
+        compile(tokens, 'Y');
+        push(tokens, kind_t::literal, "-");
+        compile(tokens, 'm');
+        push(tokens, kind_t::literal, "-");
+        compile(tokens, 'd');
+        break;
+    case 'R':
+        compile(tokens, 'H');
+        push(tokens, kind_t::literal, ":");
+        compile(tokens, 'M');
+        break;
+    case 'T':
+        compile(tokens, 'R');
+        push(tokens, kind_t::literal, ":");
+        compile(tokens, 'S');
+        break;
+    default:
+        return false;
+    }
+
+    return true;
+}
+
+}  // namespace
+
+generator_t::generator_t(const std::string& pattern) {
+    std::size_t pos = 0;
+
+    while (pos < pattern.size()) {
+        const auto percent = pattern.find('%', pos);
+        if (percent != pos) {
+            push(tokens, kind_t::literal, pattern.substr(pos, percent - pos));
+
+            if (percent == std::string::npos) {
+                break;
+            }
+        }
+
+        // Flags, field width and modifiers are left to strftime together with the conversion.
+        auto end = percent + 1;
+        while (end < pattern.size() && pattern[end] != '\0' &&
+               std::strchr("_-0^#+EO0123456789", pattern[end])) {
+            ++end;
+        }
+
+        if (end == pattern.size()) {
+            push(tokens, kind_t::strftime, pattern.substr(percent));
+            break;
+        }
+
+        if (end != percent + 1 || !compile(tokens, pattern[end])) {
+            push(tokens, kind_t::strftime, pattern.substr(percent, end + 1 - percent));
+        }
+
+        pos = end + 1;
+    }
+}
+
+template<typename Stream>
+auto generator_t::operator()(Stream& stream, const std::tm& tm, std::uint64_t usec) const -> void {
+    // Years out of the four digit range are neither padded nor truncated by strftime.
+    const auto year = static_cast<long>(tm.tm_year) + 1900;
+    const auto regular = year >= 1000 && year <= 9999;
+
+    for (const auto& token : tokens) {
+        switch (token.kind) {
+        case kind_t::literal:
+            stream << fmt::StringRef(token.value.data(), token.value.size());
+            break;
+        case kind_t::strftime:
+            strftime(stream, token.value.c_str(), tm);
+            break;
+        case kind_t::year:
+            if (regular) {
+                fill<4>(stream, static_cast<std::uint64_t>(year));
+            } else {
+                strftime(stream, "%Y", tm);
+            }
+            break;
+        case kind_t::year_short:
+            if (regular) {
+                fill<2>(stream, static_cast<std::uint64_t>(year % 100));
+            } else {
+                strftime(stream, "%y", tm);
+            }
+            break;
+        case kind_t::century:
+            if (regular) {
+                fill<2>(stream, static_cast<std::uint64_t>(year / 100));
+            } else {
+                strftime(stream, "%C", tm);
+            }
+            break;
+        case kind_t::month:
+            fill<2>(stream, static_cast<std::uint64_t>(tm.tm_mon + 1));
+            break;
+        case kind_t::mday:
+            fill<2>(stream, static_cast<std::uint64_t>(tm.tm_mday));
+            break;
+        case kind_t::mday_spaced:
+            fill<2, ' '>(stream, static_cast<std::uint64_t>(tm.tm_mday));
+            break;
+        case kind_t::yday:
+            fill<3>(stream, static_cast<std::uint64_t>(tm.tm_yday + 1));
+            break;
+        case kind_t::hour:
+            fill<2>(stream, static_cast<std::uint64_t>(tm.tm_hour));
+            break;
+        case kind_t::hour_half:
+            fill<2>(stream, static_cast<std::uint64_t>(tm.tm_hour % 12 == 0 ? 12 : tm.tm_hour % 12));
+            break;
+        case kind_t::minute:
+            fill<2>(stream, static_cast<std::uint64_t>(tm.tm_min));
+            break;
+        case kind_t::second:
+            fill<2>(stream, static_cast<std::uint64_t>(tm.tm_sec));
+            break;
+        case kind_t::usecond:
+            fill<6>(stream, usec);
+            break;
+        case kind_t::offset:
+#if defined(__linux__) || defined(__APPLE__)
+            // Unknown daylight saving time state means unknown offset, strftime prints nothing.
+            if (tm.tm_isdst >= 0) {
+                auto offset = static_cast<long>(tm.tm_gmtoff);
+                stream << (offset < 0 ? "-" : "+");
+                offset = (offset < 0 ? -offset : offset) / 60;
+                fill<4>(stream, static_cast<std::uint64_t>(offset / 60 * 100 + offset % 60));
+            }
+#else
+            strftime(stream, "%z", tm);
+#endif
+            break;
+        }
+    }
+}
+
+auto make_generator(const std::string& pattern) -> generator_t {
+    return generator_t(pattern);
+}
+
+template
+auto generator_t::operator()<writer_type>(writer_type&, const std::tm&, std::uint64_t) const -> void;
+
+}  // namespace datetime
+}  // namespace detail
+}  // namespace v1
+}  // namespace blackhole
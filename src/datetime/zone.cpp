@@ -0,0 +1,132 @@
+#include "blackhole/detail/datetime/zone.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace detail {
+namespace datetime {
+
+namespace {
+
+constexpr std::time_t day = 86400;
+
+/// Number of days probed ahead while looking for the next transition.
+constexpr int lookahead = 32;
+
+/// Returns the number of days since the epoch of January 1 of the given year.
+inline auto days_from_year(long year) noexcept -> long {
+    // Count from 0000-03-01, so that leap days come last in each 400 years era.
+    --year;
+    const auto era = (year >= 0 ? year : year - 399) / 400;
+    const auto yoe = year - era * 400;
+    return era * 146097 + yoe * 365 + yoe / 4 - yoe / 100 + 306 - 719468;
+}
+
+}  // namespace
+
+auto gmtime(std::time_t time, std::tm& tm) noexcept -> void {
+    auto days = static_cast<long>(time / day);
+    auto seconds = static_cast<long>(time % day);
+    if (seconds < 0) {
+        seconds += day;
+        --days;
+    }
+
+    tm.tm_hour = static_cast<int>(seconds / 3600);
+    tm.tm_min = static_cast<int>(seconds / 60 % 60);
+    tm.tm_sec = static_cast<int>(seconds % 60);
+
+    // The epoch is Thursday.
+    tm.tm_wday = static_cast<int>((days % 7 + 11) % 7);
+
+    // Count from 0000-03-01, so that leap days come last in each 400 years era.
+    const auto shifted = days + 719468;
+    const auto era = (shifted >= 0 ? shifted : shifted - 146096) / 146097;
+    const auto doe = shifted - era * 146097;
+    const auto yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const auto doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const auto mp = (5 * doy + 2) / 153;
+    const auto month = mp < 10 ? mp + 3 : mp - 9;
+    const auto year = yoe + era * 400 + (month <= 2);
+
+    tm.tm_year = static_cast<int>(year - 1900);
+    tm.tm_mon = static_cast<int>(month - 1);
+    tm.tm_mday = static_cast<int>(doy - (153 * mp + 2) / 5 + 1);
+    tm.tm_yday = static_cast<int>(days - days_from_year(year));
+    tm.tm_isdst = 0;
+#if defined(__linux__) || defined(__APPLE__)
+    tm.tm_gmtoff = 0;
+    tm.tm_zone = "GMT";
+#endif
+}
+
+zone_t::zone_t() noexcept :
+    begin(0),
+    end(0),
+    offset(0),
+    isdst(0),
+    name(nullptr)
+{}
+
+auto zone_t::localtime(std::time_t time, std::tm& tm) -> void {
+#if defined(__linux__) || defined(__APPLE__)
+    if (time < begin || time >= end) {
+        update(time);
+    }
+
+    datetime::gmtime(time + offset, tm);
+    tm.tm_isdst = isdst;
+    tm.tm_gmtoff = offset;
+    tm.tm_zone = name;
+#else
+    ::localtime_r(&time, &tm);
+#endif
+}
+
+auto zone_t::update(std::time_t time) -> void {
+#if defined(__linux__) || defined(__APPLE__)
+    std::tm tm;
+    ::localtime_r(&time, &tm);
+
+    offset = tm.tm_gmtoff;
+    isdst = tm.tm_isdst;
+    name = tm.tm_zone;
+
+    const auto same = [&](std::time_t time) -> bool {
+        std::tm tm;
+        ::localtime_r(&time, &tm);
+        return tm.tm_gmtoff == offset && tm.tm_isdst == isdst;
+    };
+
+    // Step ahead day by day until the offset changes, then bisect to the exact second.
+    auto lower = time;
+    for (int id = 0; id < lookahead; ++id) {
+        const auto upper = lower + day;
+
+        if (!same(upper)) {
+            auto bound = upper;
+            while (bound - lower > 1) {
+                const auto middle = lower + (bound - lower) / 2;
+                if (same(middle)) {
+                    lower = middle;
+                } else {
+                    bound = middle;
+                }
+            }
+
+            break;
+        }
+
+        lower = upper;
+    }
+
+    begin = time;
+    end = lower + 1;
+#else
+    (void)time;
+#endif
+}
+
+}  // namespace datetime
+}  // namespace detail
+}  // namespace v1
+}  // namespace blackhole
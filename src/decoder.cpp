@@ -0,0 +1,312 @@
+#include "blackhole/decoder.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "blackhole/extensions/writer.hpp"
+#include "blackhole/formatter.hpp"
+
+#include "blackhole/detail/formatter/binary/frame.hpp"
+#include "blackhole/detail/sink/file/index.hpp"
+#include "blackhole/detail/sink/ring.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace {
+
+namespace binary = detail::formatter::binary;
+
+/// Decoding state of a single thread.
+struct context_t {
+    std::unique_ptr<formatter_t> formatter;
+    sink::ring::decoded_t decoded;
+    writer_t writer;
+};
+
+struct chunk_t {
+    std::size_t begin;
+    std::size_t end;
+
+    /// Offset of the first frame decoded, which is the chunk end if there is none.
+    std::size_t first;
+    /// Offset right after the last frame decoded, which the next chunk is expected to start at.
+    std::size_t next;
+
+    std::string output;
+    decoder_t::stats_t stats;
+
+    bool ready;
+    std::exception_ptr error;
+};
+
+/// Decodes frames, which start in the chunk from the given offset, resynchronizing on malformed
+/// bytes.
+///
+/// Bytes preceding the first frame are counted as skipped only if the offset is known to be a
+/// frame boundary, because otherwise they may belong to the last frame of the previous chunk.
+auto run(const char* data, std::size_t size, std::size_t from, bool exact, chunk_t& chunk,
+    context_t& context) -> void
+{
+    chunk.output.clear();
+    chunk.stats = {0, 0};
+    chunk.first = chunk.end;
+
+    auto synced = false;
+    auto position = from;
+
+    sink::ring_t::slot_t slot;
+    while (position < chunk.end) {
+        if (!binary::parse(data, size, position, slot)) {
+            if (synced || exact) {
+                ++chunk.stats.skipped;
+            }
+
+            ++position;
+            continue;
+        }
+
+        if (!synced) {
+            chunk.first = position;
+            synced = true;
+        }
+
+        context.decoded.decode(slot);
+        context.writer.inner.clear();
+        context.formatter->format(context.decoded.record(), context.writer);
+
+        const auto result = context.writer.result();
+        chunk.output.append(result.data(), result.size());
+        chunk.output.push_back('\n');
+
+        ++chunk.stats.records;
+        position = binary::next(data, size, slot);
+    }
+
+    chunk.next = position;
+}
+
+}  // namespace
+
+decoder_t::decoder_t(std::string path) :
+    path_(std::move(path)),
+    data(nullptr),
+    size_(0)
+{
+    const auto fd = ::open(path_.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw std::system_error(errno, std::system_category(), "failed to open " + path_);
+    }
+
+    struct stat info;
+    if (::fstat(fd, &info) != 0) {
+        const auto err = errno;
+        ::close(fd);
+        throw std::system_error(err, std::system_category(), "failed to stat " + path_);
+    }
+
+    size_ = static_cast<std::size_t>(info.st_size);
+
+    if (size_ > 0) {
+        const auto memory = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (memory == MAP_FAILED) {
+            const auto err = errno;
+            ::close(fd);
+            throw std::system_error(err, std::system_category(), "failed to map " + path_);
+        }
+
+        data = static_cast<const char*>(memory);
+    }
+
+    ::close(fd);
+
+    try {
+        for (const auto& entry : sink::file::index_t::read(path_)) {
+            boundaries.push_back(entry.offset);
+        }
+    } catch (const std::exception&) {
+        // Either a missing or a malformed index only makes chunks resynchronize.
+    }
+
+    std::sort(boundaries.begin(), boundaries.end());
+}
+
+decoder_t::~decoder_t() {
+    if (data) {
+        ::munmap(const_cast<char*>(data), size_);
+    }
+}
+
+auto decoder_t::path() const noexcept -> const std::string& {
+    return path_;
+}
+
+auto decoder_t::size() const noexcept -> std::size_t {
+    return size_;
+}
+
+auto decoder_t::decode(const factory_type& factory, const callback_type& fn,
+    const options_t& options) const -> stats_t
+{
+    if (options.chunk == 0) {
+        throw std::invalid_argument("chunk size must be positive");
+    }
+
+    std::vector<std::size_t> starts{0};
+    for (std::size_t position = options.chunk; position < size_; position += options.chunk) {
+        auto start = position;
+
+        const auto it = std::lower_bound(boundaries.begin(), boundaries.end(), position);
+        if (it != boundaries.end()) {
+            start = static_cast<std::size_t>(std::min<std::uint64_t>(*it, size_));
+        }
+
+        if (start > starts.back() && start < size_) {
+            starts.push_back(start);
+        }
+    }
+
+    std::vector<chunk_t> chunks(starts.size());
+    for (std::size_t id = 0; id < chunks.size(); ++id) {
+        chunks[id].begin = starts[id];
+        chunks[id].end = id + 1 < starts.size() ? starts[id + 1] : size_;
+        chunks[id].ready = false;
+    }
+
+    auto threads = options.threads;
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    threads = std::min(threads, chunks.size());
+
+    // The last context belongs to the calling thread, which decodes misaligned chunks again.
+    std::vector<std::unique_ptr<context_t>> contexts;
+    for (std::size_t id = 0; id <= threads; ++id) {
+        contexts.emplace_back(new context_t);
+        contexts.back()->formatter = factory();
+    }
+
+    // Limits the number of chunks decoded ahead, which bounds the memory used for their output.
+    const auto window = 2 * threads;
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::size_t claimed = 0;
+    std::size_t emitted = 0;
+    bool stopped = false;
+
+    const auto worker = [&](context_t& context) {
+        for (;;) {
+            std::size_t id;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                cv.wait(lock, [&] {
+                    return stopped || claimed == chunks.size() || claimed < emitted + window;
+                });
+
+                if (stopped || claimed == chunks.size()) {
+                    return;
+                }
+
+                id = claimed++;
+            }
+
+            auto& chunk = chunks[id];
+            try {
+                run(data, size_, chunk.begin, id == 0, chunk, context);
+            } catch (...) {
+                chunk.error = std::current_exception();
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                chunk.ready = true;
+            }
+
+            cv.notify_all();
+        }
+    };
+
+    std::vector<std::thread> pool;
+
+    /// Stops and joins workers on scope exit, including errors.
+    struct joiner_t {
+        std::vector<std::thread>& pool;
+        std::mutex& mutex;
+        std::condition_variable& cv;
+        bool& stopped;
+
+        ~joiner_t() {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopped = true;
+            }
+
+            cv.notify_all();
+
+            for (auto& thread : pool) {
+                thread.join();
+            }
+        }
+    } joiner{pool, mutex, cv, stopped};
+
+    for (std::size_t id = 0; id < threads; ++id) {
+        pool.emplace_back(worker, std::ref(*contexts[id]));
+    }
+
+    stats_t stats{0, 0};
+    std::size_t expected = 0;
+
+    for (std::size_t id = 0; id < chunks.size(); ++id) {
+        auto& chunk = chunks[id];
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [&] { return chunk.ready; });
+        }
+
+        if (chunk.error) {
+            std::rethrow_exception(chunk.error);
+        }
+
+        // Chunks covered by a frame of the previous one entirely contain nothing to decode.
+        if (expected < chunk.end) {
+            // The first chunk is decoded from the file beginning, which is a frame boundary.
+            if (id > 0 && chunk.first != expected) {
+                run(data, size_, expected, true, chunk, *contexts.back());
+            }
+
+            if (!chunk.output.empty()) {
+                fn(chunk.output);
+            }
+
+            stats.records += chunk.stats.records;
+            stats.skipped += chunk.stats.skipped;
+            expected = chunk.next;
+        }
+
+        std::string().swap(chunk.output);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            emitted = id + 1;
+        }
+
+        cv.notify_all();
+    }
+
+    return stats;
+}
+
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,242 @@
+#include "blackhole/deferred.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "blackhole/attribute.hpp"
+#include "blackhole/attributes.hpp"
+#include "blackhole/message.hpp"
+#include "blackhole/root.hpp"
+
+#include "blackhole/detail/error.hpp"
+#include "blackhole/detail/mutex.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace deferred {
+namespace {
+
+/// Process-wide table of registered call site patterns.
+class registry_t {
+    std::mutex mutex;
+    std::deque<const char*> patterns;
+
+public:
+    /// Returns the registry, which is never destroyed, allowing to register call sites during both
+    /// static initialization and destruction.
+    static auto instance() -> registry_t& {
+        static auto registry = new registry_t;
+        return *registry;
+    }
+
+    auto enroll(const char* pattern) -> std::uint32_t {
+        std::lock_guard<std::mutex> lock(mutex);
+        patterns.push_back(pattern);
+        return static_cast<std::uint32_t>(patterns.size() - 1);
+    }
+
+    auto pattern(std::uint32_t id) -> const char* {
+        std::lock_guard<std::mutex> lock(mutex);
+        return patterns.at(id);
+    }
+};
+
+}  // namespace
+
+auto callsite_t::enroll(const char* pattern) -> std::uint32_t {
+    return registry_t::instance().enroll(pattern);
+}
+
+auto pattern(std::uint32_t id) -> const char* {
+    return registry_t::instance().pattern(id);
+}
+
+}  // namespace deferred
+
+namespace {
+
+/// Per-thread buffer of encoded events, which is swapped out by the consumer.
+struct buffer_t {
+    detail::adaptive_mutex_t mutex;
+    std::vector<char> data;
+};
+
+/// Size of a thread buffer at which the background thread is woken up before the interval ends,
+/// smoothing out bursts.
+constexpr std::size_t watermark = 1024 * 1024;
+
+/// Unique ids of deferred loggers, which are never reused, unlike addresses.
+std::atomic<std::uint64_t> generation(1);
+
+/// Buffer last used by the current thread, avoiding the lookup while a thread sticks to the same
+/// logger.
+struct cache_t {
+    std::uint64_t owner;
+    buffer_t* buffer;
+};
+
+thread_local cache_t cache{0, nullptr};
+
+}  // namespace
+
+class deferred_t::inner_t {
+public:
+    root_logger_t& logger;
+    const std::chrono::milliseconds interval;
+    const std::uint64_t id;
+
+    /// Buffers of all threads ever logged through this logger, which are owned here and hence are
+    /// alive until the logger is destroyed regardless of their threads lifetime.
+    std::mutex mutex;
+    std::unordered_map<std::thread::id, std::unique_ptr<buffer_t>> buffers;
+
+    /// Serializes draining, because events from the same buffer must be delivered in order.
+    std::mutex drain;
+
+    std::condition_variable cv;
+    bool stopped;
+    std::thread thread;
+
+    inner_t(root_logger_t& logger, std::chrono::milliseconds interval) :
+        logger(logger),
+        interval(interval),
+        id(generation.fetch_add(1)),
+        stopped(false)
+    {}
+
+    auto buffer() -> buffer_t& {
+        if (cache.owner == id) {
+            return *cache.buffer;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+
+        auto& buffer = buffers[std::this_thread::get_id()];
+        if (buffer == nullptr) {
+            buffer.reset(new buffer_t);
+        }
+
+        cache = {id, buffer.get()};
+        return *buffer;
+    }
+
+    auto run() -> void {
+        std::unique_lock<std::mutex> lock(mutex);
+
+        while (!stopped) {
+            cv.wait_for(lock, interval);
+
+            lock.unlock();
+            flush();
+            lock.lock();
+        }
+    }
+
+    auto flush() -> void {
+        std::lock_guard<std::mutex> guard(drain);
+
+        std::vector<buffer_t*> snapshot;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            snapshot.reserve(buffers.size());
+            for (const auto& buffer : buffers) {
+                snapshot.push_back(buffer.second.get());
+            }
+        }
+
+        // The pending storage is swapped with buffers, so their capacity is reused.
+        for (auto buffer : snapshot) {
+            {
+                std::lock_guard<detail::adaptive_mutex_t> lock(buffer->mutex);
+                pending.swap(buffer->data);
+            }
+
+            deliver();
+            pending.clear();
+        }
+    }
+
+private:
+    std::vector<char> pending;
+    writer_t writer;
+
+    auto deliver() -> void {
+        typedef deferred::detail::header_t header_t;
+
+        const auto end = pending.data() + pending.size();
+        for (auto it = pending.data(); it < end;) {
+            header_t header;
+            std::memcpy(&header, it, sizeof(header));
+
+            const auto data = it + sizeof(header);
+            it += header.size;
+
+            try {
+                const auto format = deferred::pattern(header.callsite);
+                const string_view pattern(format, std::strlen(format));
+
+                const auto supplier = [&]() -> string_view {
+                    writer.inner.clear();
+                    header.format(format, data, writer);
+                    return writer.result();
+                };
+
+                attribute_pack pack;
+                logger.log(header.severity, lazy_message_t{pattern, std::cref(supplier)}, pack);
+            } catch (...) {
+                detail::error::report(error::kind_t::deferred);
+            }
+        }
+    }
+};
+
+deferred_t::deferred_t(root_logger_t& inner, std::chrono::milliseconds interval) :
+    d(new inner_t(inner, interval))
+{
+    d->thread = std::thread(&inner_t::run, d.get());
+}
+
+deferred_t::~deferred_t() {
+    {
+        std::lock_guard<std::mutex> lock(d->mutex);
+        d->stopped = true;
+    }
+
+    d->cv.notify_one();
+    d->thread.join();
+
+    d->flush();
+}
+
+auto deferred_t::enabled(severity_t severity) const noexcept -> bool {
+    return d->logger.enabled(severity);
+}
+
+auto deferred_t::flush() -> void {
+    d->flush();
+}
+
+auto deferred_t::push(const char* data, std::size_t size) -> void {
+    auto& buffer = d->buffer();
+
+    std::size_t before;
+    {
+        std::lock_guard<detail::adaptive_mutex_t> lock(buffer.mutex);
+        before = buffer.data.size();
+        buffer.data.insert(buffer.data.end(), data, data + size);
+    }
+
+    if (before < watermark && before + size >= watermark) {
+        d->cv.notify_one();
+    }
+}
+
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,168 @@
+#include "blackhole/error.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "blackhole/detail/error.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace {
+
+/// Fixed window rate limiter and counters of a single error kind.
+struct limiter_t {
+    /// Second of the steady clock errors are currently reported within.
+    std::atomic<std::int64_t> window;
+    /// Errors reported within the current window, including ones exceeding the limit.
+    std::atomic<std::uint64_t> reported;
+    /// Errors suppressed since the last report.
+    std::atomic<std::uint64_t> pending;
+
+    std::atomic<std::uint64_t> occurred;
+    std::atomic<std::uint64_t> suppressed;
+};
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wglobal-constructors"
+#pragma clang diagnostic ignored "-Wexit-time-destructors"
+
+/// Zero initialized statically, so errors occurred during static initialization are counted.
+limiter_t limiters[error::kinds];
+
+std::atomic<std::size_t> rate(10);
+
+/// Custom reporter if any, which is copied out under the lock to be called without holding it.
+std::mutex mutex;
+std::shared_ptr<const error::reporter_type> custom;
+
+#pragma clang diagnostic pop
+
+auto print(error::kind_t, const string_view& message, std::uint64_t suppressed) -> void {
+    std::string line("logging core error occurred: ");
+    line.append(message.data(), message.size());
+
+    if (suppressed != 0) {
+        line.append(" (").append(std::to_string(suppressed)).append(" similar suppressed)");
+    }
+
+    std::cout << line << std::endl;
+}
+
+}  // namespace
+
+namespace detail {
+namespace error {
+
+auto report(kind_t kind, const char* message) noexcept -> void {
+    auto& limiter = limiters[static_cast<std::size_t>(kind)];
+    limiter.occurred.fetch_add(1, std::memory_order_relaxed);
+
+    if (const auto limit = rate.load(std::memory_order_relaxed)) {
+        const std::int64_t now = std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+
+        auto window = limiter.window.load(std::memory_order_relaxed);
+        if (window != now &&
+            limiter.window.compare_exchange_strong(window, now, std::memory_order_relaxed))
+        {
+            limiter.reported.store(0, std::memory_order_relaxed);
+        }
+
+        if (limiter.reported.fetch_add(1, std::memory_order_relaxed) >= limit) {
+            limiter.pending.fetch_add(1, std::memory_order_relaxed);
+            limiter.suppressed.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+    }
+
+    const auto suppressed = limiter.pending.exchange(0, std::memory_order_relaxed);
+
+    try {
+        std::shared_ptr<const blackhole::error::reporter_type> reporter;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            reporter = custom;
+        }
+
+        const string_view view(message, std::strlen(message));
+
+        if (reporter) {
+            (*reporter)(kind, view, suppressed);
+        } else {
+            print(kind, view, suppressed);
+        }
+    } catch (...) {
+        // Reporting errors has nowhere to be reported.
+    }
+}
+
+auto report(kind_t kind) noexcept -> void {
+    try {
+        throw;
+    } catch (const std::exception& err) {
+        report(kind, err.what());
+    } catch (...) {
+        report(kind, "unknown");
+    }
+}
+
+}  // namespace error
+}  // namespace detail
+
+namespace error {
+
+auto name(kind_t kind) noexcept -> const char* {
+    switch (kind) {
+    case kind_t::handler:
+        return "handler";
+    case kind_t::sink:
+        return "sink";
+    case kind_t::deferred:
+        return "deferred";
+    }
+
+    return "unknown";
+}
+
+auto reporter(reporter_type reporter) -> reporter_type {
+    std::shared_ptr<const reporter_type> value;
+    if (reporter) {
+        value = std::make_shared<const reporter_type>(std::move(reporter));
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    custom.swap(value);
+
+    return value ? *value : reporter_type();
+}
+
+auto limit(std::size_t value) noexcept -> void {
+    rate.store(value, std::memory_order_relaxed);
+
+    for (auto& limiter : limiters) {
+        limiter.window.store(-1, std::memory_order_relaxed);
+        limiter.reported.store(0, std::memory_order_relaxed);
+        limiter.pending.store(0, std::memory_order_relaxed);
+    }
+}
+
+auto limit() noexcept -> std::size_t {
+    return rate.load(std::memory_order_relaxed);
+}
+
+auto occurred(kind_t kind) noexcept -> std::uint64_t {
+    return limiters[static_cast<std::size_t>(kind)].occurred.load(std::memory_order_relaxed);
+}
+
+auto suppressed(kind_t kind) noexcept -> std::uint64_t {
+    return limiters[static_cast<std::size_t>(kind)].suppressed.load(std::memory_order_relaxed);
+}
+
+}  // namespace error
+}  // namespace v1
+}  // namespace blackhole
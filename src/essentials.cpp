@@ -1,34 +1,88 @@
 #include "essentials.hpp"
 
+#include "blackhole/filter/callsite.hpp"
+#include "blackhole/filter/dedup.hpp"
+#include "blackhole/filter/expression.hpp"
+#include "blackhole/filter/limit.hpp"
+#include "blackhole/filter/sample.hpp"
 #include "blackhole/filter/severity.hpp"
+#include "blackhole/filter/traced.hpp"
+#include "blackhole/formatter/binary.hpp"
+#include "blackhole/formatter/cbor.hpp"
+#include "blackhole/formatter/logfmt.hpp"
+#include "blackhole/formatter/msgpack.hpp"
+#include "blackhole/formatter/otlp.hpp"
 #include "blackhole/formatter/string.hpp"
+#include "blackhole/handler/aggregate.hpp"
+#include "blackhole/handler/asynchronous.hpp"
 #include "blackhole/handler/blocking.hpp"
+#include "blackhole/handler/breaker.hpp"
+#include "blackhole/handler/recorder.hpp"
 #include "blackhole/registry.hpp"
+#include "blackhole/sink/arrow.hpp"
 #include "blackhole/sink/asynchronous.hpp"
 #include "blackhole/sink/console.hpp"
+#include "blackhole/sink/elasticsearch.hpp"
 #include "blackhole/sink/file.hpp"
+#include "blackhole/sink/journal.hpp"
+#include "blackhole/sink/kafka.hpp"
+#include "blackhole/sink/mmap.hpp"
 #include "blackhole/sink/null.hpp"
+#include "blackhole/sink/otlp.hpp"
+#include "blackhole/sink/pipe.hpp"
+#include "blackhole/sink/shm.hpp"
+#include "blackhole/sink/spool.hpp"
+#include "blackhole/sink/socket/gelf.hpp"
 #include "blackhole/sink/socket/tcp.hpp"
 #include "blackhole/sink/socket/udp.hpp"
+#include "blackhole/sink/socket/unix.hpp"
 #include "blackhole/sink/syslog.hpp"
 
 namespace blackhole {
 inline namespace v1 {
 
 auto essentials(registry_t& registry) -> void {
+    registry.add<filter::callsite_t>();
+    registry.add<filter::dedup_t>();
+    registry.add<filter::expression_t>();
+    registry.add<filter::limit_t>();
+    registry.add<filter::sample_t>();
     registry.add<filter::severity_t>();
+    registry.add<filter::traced_t>();
 
+    registry.add<formatter::binary_t>();
+    registry.add<formatter::cbor_t>();
+    registry.add<formatter::logfmt_t>();
+    registry.add<formatter::msgpack_t>();
+    registry.add<formatter::otlp_t>();
     registry.add<formatter::string_t>();
 
+    registry.add<sink::arrow_t>(registry);
     registry.add<sink::asynchronous_t>(registry);
     registry.add<sink::console_t>(registry);
+    registry.add<sink::elasticsearch_t>(registry);
     registry.add<sink::file_t>(registry);
+    registry.add<sink::journal_t>(registry);
+#ifdef BLACKHOLE_HAS_KAFKA
+    registry.add<sink::kafka_t>(registry);
+#endif
+    registry.add<sink::mmap_t>(registry);
     registry.add<sink::null_t>();
+    registry.add<sink::otlp_t>(registry);
+    registry.add<sink::pipe_t>(registry);
+    registry.add<sink::shm_t>(registry);
+    registry.add<sink::spool_t>(registry);
+    registry.add<sink::socket::gelf_t>(registry);
     registry.add<sink::socket::tcp_t>(registry);
     registry.add<sink::socket::udp_t>(registry);
+    registry.add<sink::socket::unix_t>(registry);
     registry.add<sink::syslog_t>(registry);
 
+    registry.add<handler::aggregate_t>(registry);
+    registry.add<handler::asynchronous_t>(registry);
     registry.add<handler::blocking_t>(registry);
+    registry.add<handler::breaker_t>(registry);
+    registry.add<handler::recorder_t>(registry);
 }
 
 }  // namespace v1
@@ -0,0 +1,118 @@
+#include "blackhole/executor.hpp"
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace blackhole {
+inline namespace v1 {
+
+class executor_t::inner_t {
+public:
+    const std::size_t capacity;
+
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::deque<std::function<void()>> tasks;
+    bool stopped;
+
+    std::vector<std::thread> threads;
+
+    explicit inner_t(std::size_t capacity) :
+        capacity(capacity),
+        stopped(false)
+    {}
+
+    auto run() -> void {
+        std::unique_lock<std::mutex> lock(mutex);
+
+        while (true) {
+            ready.wait(lock, [&] {
+                return stopped || !tasks.empty();
+            });
+
+            // Queued tasks are run even after stopping, because loggers don't wait for them.
+            if (tasks.empty()) {
+                return;
+            }
+
+            const auto task = std::move(tasks.front());
+            tasks.pop_front();
+
+            lock.unlock();
+
+            try {
+                task();
+            } catch (...) {
+                // Tasks are responsible for reporting their errors.
+            }
+
+            lock.lock();
+        }
+    }
+};
+
+constexpr std::size_t executor_t::default_capacity;
+
+executor_t::executor_t(std::size_t threads, std::size_t capacity) {
+    if (threads == 0) {
+        throw std::invalid_argument("executor must have at least one thread");
+    }
+
+    if (capacity == 0) {
+        throw std::invalid_argument("executor capacity must be positive");
+    }
+
+    d.reset(new inner_t(capacity));
+
+    try {
+        for (std::size_t id = 0; id < threads; ++id) {
+            d->threads.emplace_back([this] { d->run(); });
+        }
+    } catch (...) {
+        {
+            std::lock_guard<std::mutex> lock(d->mutex);
+            d->stopped = true;
+        }
+
+        d->ready.notify_all();
+        for (auto& thread : d->threads) {
+            thread.join();
+        }
+
+        throw;
+    }
+}
+
+executor_t::~executor_t() {
+    {
+        std::lock_guard<std::mutex> lock(d->mutex);
+        d->stopped = true;
+    }
+
+    d->ready.notify_all();
+    for (auto& thread : d->threads) {
+        thread.join();
+    }
+}
+
+auto executor_t::post(std::function<void()> task) -> bool {
+    {
+        std::lock_guard<std::mutex> lock(d->mutex);
+
+        if (d->tasks.size() >= d->capacity) {
+            return false;
+        }
+
+        d->tasks.push_back(std::move(task));
+    }
+
+    d->ready.notify_one();
+    return true;
+}
+
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,138 @@
+#include "blackhole/filter/callsite.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include <boost/optional/optional.hpp>
+
+#include "blackhole/config/node.hpp"
+#include "blackhole/config/option.hpp"
+#include "blackhole/record.hpp"
+
+#include "blackhole/detail/memory.hpp"
+
+#include "callsite.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace filter {
+namespace {
+
+/// Returns 31 bits identifying the pattern of the given record besides its address.
+auto fingerprint(const record_t& record) noexcept -> std::uint64_t {
+    const auto size = static_cast<std::uint64_t>(record.message().size());
+    return (record.pattern_hash() ^ (size * 0x9e3779b97f4a7c15ull)) & 0x7fffffff;
+}
+
+}  // namespace
+
+constexpr std::size_t callsite_t::size;
+
+callsite_t::callsite_t(bool enabled) :
+    slots(new slot_t[size]),
+    fallback(enabled),
+    generation(1)
+{
+    for (std::size_t id = 0; id < size; ++id) {
+        slots[id].key.store(0, std::memory_order_relaxed);
+        slots[id].value.store(0, std::memory_order_relaxed);
+    }
+}
+
+auto callsite_t::set(std::string match, bool enabled) -> void {
+    std::lock_guard<std::mutex> lock(mutex);
+    rules.emplace_back(std::move(match), enabled);
+
+    // Zero generation marks empty slots.
+    if (generation.fetch_add(1) + 1 == 0) {
+        generation.fetch_add(1);
+    }
+}
+
+auto callsite_t::clear() -> void {
+    std::lock_guard<std::mutex> lock(mutex);
+    rules.clear();
+
+    if (generation.fetch_add(1) + 1 == 0) {
+        generation.fetch_add(1);
+    }
+}
+
+auto callsite_t::enabled(const record_t& record) -> bool {
+    const auto key = record.pattern_id();
+    const auto tag = fingerprint(record);
+    auto& slot = slots[record.pattern_hash() >> 54];
+
+    // Concurrent misses may interleave their stores, so the value must agree with both the key
+    // loaded before and after it and the pattern tag.
+    if (slot.key.load(std::memory_order_acquire) == key) {
+        const auto value = slot.value.load(std::memory_order_acquire);
+
+        if (slot.key.load(std::memory_order_acquire) == key &&
+            (value >> 32) == generation.load(std::memory_order_acquire) &&
+            ((value >> 1) & 0x7fffffff) == tag)
+        {
+            return value & 1;
+        }
+    }
+
+    std::uint32_t current;
+    const auto result = resolve(record, current);
+
+    slot.value.store(0);
+    slot.key.store(key);
+    slot.value.store(static_cast<std::uint64_t>(current) << 32 | tag << 1 | (result ? 1 : 0));
+
+    return result;
+}
+
+auto callsite_t::filter(const record_t& record) -> filter_t::action_t {
+    return enabled(record) ? filter_t::action_t::neutral : filter_t::action_t::deny;
+}
+
+auto callsite_t::resolve(const record_t& record, std::uint32_t& generation) const -> bool {
+    const auto& pattern = record.message();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    generation = this->generation.load();
+
+    for (auto it = rules.rbegin(); it != rules.rend(); ++it) {
+        const auto& match = it->first;
+        const auto end = pattern.data() + pattern.size();
+
+        if (std::search(pattern.data(), end, match.data(), match.data() + match.size()) != end ||
+            match.empty())
+        {
+            return it->second;
+        }
+    }
+
+    return fallback;
+}
+
+}  // namespace filter
+
+auto factory<filter::callsite_t>::type() const noexcept -> const char* {
+    return "callsite";
+}
+
+auto factory<filter::callsite_t>::from(const config::node_t& config) const ->
+    std::unique_ptr<filter_t>
+{
+    auto filter = blackhole::make_unique<filter::callsite_t>(
+        config["default"].to_bool().get_value_or(true));
+
+    config["rules"].each([&](const config::node_t& rule) {
+        const auto match = rule["match"].to_string();
+        if (!match) {
+            throw std::invalid_argument("each call site rule must have a 'match' field");
+        }
+
+        filter->set(*match, rule["enabled"].to_bool().get_value_or(true));
+    });
+
+    return filter;
+}
+
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "blackhole/filter.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace filter {
+
+/// Filter enabling or disabling records per call site, i.e. message pattern, which can be changed
+/// at runtime, much like the dynamic debug facility of the linux kernel.
+///
+/// Rules match patterns containing the given substring and are checked in reverse order, so later
+/// rules take precedence, falling back to the default decision if none matches.
+///
+/// Matching is performed once per pattern address, after which the decision is cached in a fixed
+/// lock-free table indexed by the pattern hash and tagged with the rules generation, so checking a
+/// cached call site takes a few atomic loads and neither formats the message nor reads the pattern.
+/// Changing rules invalidates all cached decisions.
+///
+/// \note cached decisions are additionally verified by the pattern size, but patterns are expected
+///     to be string literals, since other strings may reuse the same address with other content.
+class callsite_t : public filter_t {
+    struct alignas(16) slot_t {
+        std::atomic<std::uintptr_t> key;
+        /// Generation in high 32 bits, pattern size in the next 31 bits and the decision in the
+        /// lowest bit, zero if the slot is empty.
+        std::atomic<std::uint64_t> value;
+    };
+
+    static constexpr std::size_t size = 1024;
+
+    std::unique_ptr<slot_t[]> slots;
+
+    /// Protects rules, which are accessed only on cache misses.
+    mutable std::mutex mutex;
+    std::vector<std::pair<std::string, bool>> rules;
+    bool fallback;
+    std::atomic<std::uint32_t> generation;
+
+public:
+    /// Constructs a filter with no rules passing records by default if the given flag is true.
+    explicit callsite_t(bool enabled = true);
+
+    callsite_t(const callsite_t& other) = delete;
+    auto operator=(const callsite_t& other) -> callsite_t& = delete;
+
+    /// Adds the rule enabling or disabling call sites, which pattern contains the given string.
+    auto set(std::string match, bool enabled) -> void;
+
+    /// Removes all rules.
+    auto clear() -> void;
+
+    /// Checks whether records of the call site with the given pattern are enabled.
+    auto enabled(const record_t& record) -> bool;
+
+    auto filter(const record_t& record) -> filter_t::action_t override;
+
+private:
+    auto resolve(const record_t& record, std::uint32_t& generation) const -> bool;
+};
+
+}  // namespace filter
+}  // namespace v1
+}  // namespace blackhole
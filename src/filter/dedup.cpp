@@ -0,0 +1,88 @@
+#include "blackhole/filter/dedup.hpp"
+
+#include <stdexcept>
+
+#include <boost/optional/optional.hpp>
+
+#include "blackhole/config/node.hpp"
+#include "blackhole/config/option.hpp"
+#include "blackhole/record.hpp"
+
+#include "blackhole/detail/memory.hpp"
+
+#include "dedup.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace filter {
+namespace {
+
+auto combine(std::uint64_t seed, std::uint64_t value) noexcept -> std::uint64_t {
+    return seed ^ (value + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2));
+}
+
+}  // namespace
+
+dedup_t::dedup_t(std::chrono::nanoseconds window, std::vector<std::string> attributes) :
+    // Summaries are reported as soon as a window closes, hence the zero interval.
+    throttle_t({}, std::chrono::nanoseconds(0)),
+    window(window.count()),
+    attributes(std::move(attributes))
+{
+    if (this->window <= 0) {
+        throw std::invalid_argument("deduplication window must be positive");
+    }
+}
+
+auto dedup_t::summary() const noexcept -> const char* {
+    return "last message repeated {} times";
+}
+
+auto dedup_t::key(const record_t& record) const -> std::uint64_t {
+    auto result = std::hash<string_view>()(record.formatted());
+    result = combine(result, record.pattern_hash());
+
+    for (const auto& attribute : attributes) {
+        result = combine(result, hash(record, string_view(attribute.data(), attribute.size())));
+    }
+
+    return result;
+}
+
+auto dedup_t::admit(slot_t& slot, std::uint64_t key, std::int64_t now) -> bool {
+    const auto current = static_cast<std::int64_t>(key);
+
+    if (slot.state.load(std::memory_order_relaxed) != current) {
+        slot.state.store(current, std::memory_order_relaxed);
+        slot.timestamp.store(now + window, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Only a single thread reopens the window of a repeated record, others are suppressed.
+    auto deadline = slot.timestamp.load(std::memory_order_relaxed);
+    return now >= deadline &&
+        slot.timestamp.compare_exchange_strong(deadline, now + window, std::memory_order_relaxed);
+}
+
+}  // namespace filter
+
+auto factory<filter::dedup_t>::type() const noexcept -> const char* {
+    return "dedup";
+}
+
+auto factory<filter::dedup_t>::from(const config::node_t& config) const ->
+    std::unique_ptr<filter_t>
+{
+    const auto window = config["window"].to_uint64().get_value_or(1000);
+
+    std::vector<std::string> attributes;
+    config["attributes"].each([&](const config::node_t& node) {
+        attributes.push_back(node.to_string());
+    });
+
+    return blackhole::make_unique<filter::dedup_t>(std::chrono::milliseconds(window),
+        std::move(attributes));
+}
+
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <vector>
+
+#include "throttle.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace filter {
+
+/// Deduplicating filter, which collapses records repeated within the given time window.
+///
+/// Records are keyed by the hash of their formatted message, message pattern and values of the
+/// given attributes. The first record of each key passes, opening a window, and repeats are
+/// suppressed until the window closes, after which the next repeat passes and reopens it. A
+/// summary with the repeat count is reported together with the first record passed after the
+/// window closes, or with a record of another key taking over the slot.
+///
+/// \note the slot keeps only the key hash, so a summary reported when another key takes over the
+///     slot is attributed to the record of the new key.
+class dedup_t : public throttle_t {
+    std::int64_t window;
+    std::vector<std::string> attributes;
+
+public:
+    /// \throw std::invalid_argument if the window is not positive.
+    explicit dedup_t(std::chrono::nanoseconds window, std::vector<std::string> attributes = {});
+
+    auto summary() const noexcept -> const char* override;
+
+protected:
+    auto key(const record_t& record) const -> std::uint64_t override;
+    auto admit(slot_t& slot, std::uint64_t key, std::int64_t now) -> bool override;
+};
+
+}  // namespace filter
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,525 @@
+#include "blackhole/filter/expression.hpp"
+
+#include <cctype>
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <stdexcept>
+
+#include <boost/optional/optional.hpp>
+#include <boost/variant/apply_visitor.hpp>
+#include <boost/variant/get.hpp>
+
+#include "blackhole/attribute.hpp"
+#include "blackhole/attribute/table.hpp"
+#include "blackhole/attributes.hpp"
+#include "blackhole/config/node.hpp"
+#include "blackhole/config/option.hpp"
+#include "blackhole/extensions/format.hpp"
+#include "blackhole/record.hpp"
+
+#include "blackhole/detail/attribute.hpp"
+#include "blackhole/detail/memory.hpp"
+
+#include "expression.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace filter {
+namespace {
+
+using attribute::view_t;
+
+/// Result of ordering values, which can't be compared.
+constexpr int unordered = 2;
+
+template<typename T>
+auto sign(const T& lhs, const T& rhs) noexcept -> int {
+    return lhs < rhs ? -1 : (rhs < lhs ? 1 : 0);
+}
+
+auto order(std::int64_t lhs, std::int64_t rhs) noexcept -> int {
+    return sign(lhs, rhs);
+}
+
+auto order(std::uint64_t lhs, std::uint64_t rhs) noexcept -> int {
+    return sign(lhs, rhs);
+}
+
+auto order(double lhs, double rhs) noexcept -> int {
+    if (std::isnan(lhs) || std::isnan(rhs)) {
+        return unordered;
+    }
+
+    return sign(lhs, rhs);
+}
+
+auto order(std::int64_t lhs, std::uint64_t rhs) noexcept -> int {
+    return lhs < 0 ? -1 : sign(static_cast<std::uint64_t>(lhs), rhs);
+}
+
+auto order(std::uint64_t lhs, std::int64_t rhs) noexcept -> int {
+    return -order(rhs, lhs);
+}
+
+auto order(std::int64_t lhs, double rhs) noexcept -> int {
+    return order(static_cast<double>(lhs), rhs);
+}
+
+auto order(double lhs, std::int64_t rhs) noexcept -> int {
+    return order(lhs, static_cast<double>(rhs));
+}
+
+auto order(std::uint64_t lhs, double rhs) noexcept -> int {
+    return order(static_cast<double>(lhs), rhs);
+}
+
+auto order(double lhs, std::uint64_t rhs) noexcept -> int {
+    return order(lhs, static_cast<double>(rhs));
+}
+
+auto order(bool lhs, bool rhs) noexcept -> int {
+    return sign(lhs, rhs);
+}
+
+auto order(const string_view& lhs, const string_view& rhs) noexcept -> int {
+    if (lhs == rhs) {
+        return 0;
+    }
+
+    return lhs < rhs ? -1 : 1;
+}
+
+template<typename T, typename U>
+auto order(const T&, const U&) noexcept -> int {
+    return unordered;
+}
+
+class order_t : public boost::static_visitor<int> {
+public:
+    template<typename T, typename U>
+    auto operator()(const T& lhs, const U& rhs) const noexcept -> int {
+        return order(lhs, rhs);
+    }
+};
+
+auto lookup(const record_t& record, const attribute::key_t& key) -> const view_t* {
+    return record.table().find(key);
+}
+
+}  // namespace
+
+class expression_t::compiler_t {
+    expression_t& result;
+    const std::string& expression;
+    std::size_t pos;
+
+public:
+    compiler_t(expression_t& result, const std::string& expression) noexcept :
+        result(result),
+        expression(expression),
+        pos(0)
+    {}
+
+    auto compile() -> void {
+        disjunction();
+
+        skip();
+        if (pos != expression.size()) {
+            fail("unexpected character");
+        }
+    }
+
+private:
+    auto disjunction() -> void {
+        conjunction();
+        chain("||", opcode_t::jump_true, &compiler_t::conjunction);
+    }
+
+    auto conjunction() -> void {
+        unary();
+        chain("&&", opcode_t::jump_false, &compiler_t::unary);
+    }
+
+    /// Compiles a left-associative chain of the given operator, where each next operand is
+    /// evaluated only if the register doesn't determine the result yet.
+    auto chain(const char* token, opcode_t opcode, void(compiler_t::*next)()) -> void {
+        std::vector<std::size_t> jumps;
+
+        while (consume(token)) {
+            jumps.push_back(emit({opcode, relation_t::eq, {}, {}, 0}));
+            (this->*next)();
+        }
+
+        for (auto jump : jumps) {
+            result.program[jump].target = result.program.size();
+        }
+    }
+
+    auto unary() -> void {
+        if (consume("!")) {
+            unary();
+            emit({opcode_t::negate, relation_t::eq, {}, {}, 0});
+        } else {
+            primary();
+        }
+    }
+
+    auto primary() -> void {
+        if (consume("(")) {
+            disjunction();
+
+            if (!consume(")")) {
+                fail("expected ')'");
+            }
+
+            return;
+        }
+
+        skip();
+        const auto lstart = pos;
+        const auto lhs = operand();
+
+        relation_t relation;
+        if (consume("==")) {
+            relation = relation_t::eq;
+        } else if (consume("!=")) {
+            relation = relation_t::ne;
+        } else if (consume("<=")) {
+            relation = relation_t::le;
+        } else if (consume(">=")) {
+            relation = relation_t::ge;
+        } else if (consume("<")) {
+            relation = relation_t::lt;
+        } else if (consume(">")) {
+            relation = relation_t::gt;
+        } else {
+            if (lhs.kind == operand_t::kind_t::attribute) {
+                emit({opcode_t::exists, relation_t::eq, lhs, {}, 0});
+            } else if (lhs.kind == operand_t::kind_t::constant &&
+                boost::get<view_t::bool_type>(&lhs.value.inner().value))
+            {
+                emit({opcode_t::compare, relation_t::eq, lhs, constant(view_t(true)), 0});
+            } else {
+                fail("expected comparison");
+            }
+
+            return;
+        }
+
+        skip();
+        const auto rstart = pos;
+        const auto rhs = operand();
+
+        // Severity names like `warn` would otherwise silently refer to missing attributes, making
+        // the comparison always false.
+        if (lhs.kind == operand_t::kind_t::severity && bare(rhs, rstart)) {
+            pos = rstart;
+            fail("severity can't be compared with a bare name, use its number instead");
+        } else if (rhs.kind == operand_t::kind_t::severity && bare(lhs, lstart)) {
+            pos = lstart;
+            fail("severity can't be compared with a bare name, use its number instead");
+        }
+
+        emit({opcode_t::compare, relation, lhs, rhs, 0});
+    }
+
+    /// Checks whether the given operand starting at the given position is an attribute referred to
+    /// by a bare, i.e. not backquoted, name.
+    auto bare(const operand_t& operand, std::size_t start) const noexcept -> bool {
+        return operand.kind == operand_t::kind_t::attribute && expression[start] != '`';
+    }
+
+    auto operand() -> operand_t {
+        skip();
+
+        if (pos == expression.size()) {
+            fail("expected operand");
+        }
+
+        const auto ch = expression[pos];
+
+        if (ch == '"') {
+            return literal();
+        }
+
+        if (std::isdigit(ch) ||
+            (ch == '-' && pos + 1 < expression.size() && std::isdigit(expression[pos + 1]))) {
+            return number();
+        }
+
+        if (ch == '`') {
+            const auto end = expression.find('`', pos + 1);
+            if (end == std::string::npos) {
+                fail("unterminated attribute name");
+            }
+
+            const auto name = expression.substr(pos + 1, end - pos - 1);
+            pos = end + 1;
+            return attribute(name);
+        }
+
+        if (std::isalpha(ch) || ch == '_') {
+            const auto start = pos;
+            while (pos < expression.size() &&
+                (std::isalnum(expression[pos]) || expression[pos] == '_' || expression[pos] == '.'))
+            {
+                ++pos;
+            }
+
+            const auto name = expression.substr(start, pos - start);
+
+            if (name == "true") {
+                return constant(view_t(true));
+            } else if (name == "false") {
+                return constant(view_t(false));
+            } else if (name == "severity") {
+                return {operand_t::kind_t::severity, 0, {}};
+            } else if (name == "message") {
+                return {operand_t::kind_t::message, 0, {}};
+            }
+
+            return attribute(name);
+        }
+
+        fail("expected operand");
+    }
+
+    auto literal() -> operand_t {
+        std::string value;
+
+        for (++pos; pos < expression.size(); ++pos) {
+            auto ch = expression[pos];
+
+            if (ch == '"') {
+                ++pos;
+                result.strings.push_back(std::move(value));
+                return constant(view_t(string_view(result.strings.back())));
+            }
+
+            if (ch == '\\') {
+                if (++pos == expression.size()) {
+                    break;
+                }
+
+                switch (expression[pos]) {
+                case 'n':
+                    ch = '\n';
+                    break;
+                case 't':
+                    ch = '\t';
+                    break;
+                default:
+                    ch = expression[pos];
+                }
+            }
+
+            value.push_back(ch);
+        }
+
+        fail("unterminated string literal");
+    }
+
+    auto number() -> operand_t {
+        const auto start = expression.c_str() + pos;
+        char* end = nullptr;
+
+        auto floating = false;
+        for (auto it = start + (*start == '-' ? 1 : 0); *it; ++it) {
+            if (*it == '.' || *it == 'e' || *it == 'E') {
+                floating = true;
+            } else if (!std::isdigit(*it)) {
+                break;
+            }
+        }
+
+        errno = 0;
+
+        view_t value;
+        if (floating) {
+            value = view_t(std::strtod(start, &end));
+        } else if (*start == '-') {
+            value = view_t(static_cast<std::int64_t>(std::strtoll(start, &end, 10)));
+        } else {
+            const auto number = std::strtoull(start, &end, 10);
+            const auto max = std::numeric_limits<std::int64_t>::max();
+            if (number > static_cast<unsigned long long>(max)) {
+                value = view_t(static_cast<std::uint64_t>(number));
+            } else {
+                value = view_t(static_cast<std::int64_t>(number));
+            }
+        }
+
+        if (errno == ERANGE || end == start) {
+            fail("invalid number");
+        }
+
+        pos += static_cast<std::size_t>(end - start);
+        return constant(value);
+    }
+
+    auto constant(const view_t& value) -> operand_t {
+        return {operand_t::kind_t::constant, 0, value};
+    }
+
+    auto attribute(const std::string& name) -> operand_t {
+        if (name.empty()) {
+            fail("empty attribute name");
+        }
+
+        const attribute::key_t key{string_view(name)};
+
+        for (std::size_t id = 0; id < result.keys.size(); ++id) {
+            if (result.keys[id] == key) {
+                return {operand_t::kind_t::attribute, id, {}};
+            }
+        }
+
+        result.keys.push_back(key);
+        return {operand_t::kind_t::attribute, result.keys.size() - 1, {}};
+    }
+
+    auto emit(instruction_t instruction) -> std::size_t {
+        result.program.push_back(instruction);
+        return result.program.size() - 1;
+    }
+
+    auto skip() noexcept -> void {
+        while (pos < expression.size() && std::isspace(expression[pos])) {
+            ++pos;
+        }
+    }
+
+    auto consume(const char* token) -> bool {
+        skip();
+
+        const auto size = std::char_traits<char>::length(token);
+        if (expression.compare(pos, size, token) != 0) {
+            return false;
+        }
+
+        // Prevent matching the prefix of a longer operator, i.e. "<" of "<=" or "!" of "!=".
+        if (size == 1 && pos + 1 < expression.size() && expression[pos + 1] == '=' &&
+            (*token == '<' || *token == '>' || *token == '!'))
+        {
+            return false;
+        }
+
+        pos += size;
+        return true;
+    }
+
+    [[noreturn]] auto fail(const char* reason) const -> void {
+        throw std::invalid_argument(fmt::format("invalid filter expression at position {}: {}",
+            pos, reason));
+    }
+};
+
+expression_t::expression_t(const std::string& expression) {
+    compiler_t(*this, expression).compile();
+}
+
+auto expression_t::evaluate(const record_t& record) const -> bool {
+    const auto value = [&](const operand_t& operand) -> boost::optional<view_t> {
+        switch (operand.kind) {
+        case operand_t::kind_t::constant:
+            return operand.value;
+        case operand_t::kind_t::severity:
+            return view_t(static_cast<std::int64_t>(record.severity()));
+        case operand_t::kind_t::message:
+            return view_t(record.message());
+        case operand_t::kind_t::attribute:
+            if (const auto attribute = lookup(record, keys[operand.key])) {
+                return *attribute;
+            }
+
+            return boost::none;
+        }
+
+        return boost::none;
+    };
+
+    auto reg = false;
+
+    for (std::size_t id = 0; id < program.size();) {
+        const auto& instruction = program[id];
+
+        switch (instruction.opcode) {
+        case opcode_t::compare: {
+            const auto lhs = value(instruction.lhs);
+            const auto rhs = value(instruction.rhs);
+
+            if (lhs && rhs) {
+                const auto order = boost::apply_visitor(order_t(),
+                    lhs->inner().value, rhs->inner().value);
+
+                switch (instruction.relation) {
+                case relation_t::eq:
+                    reg = order == 0;
+                    break;
+                case relation_t::ne:
+                    reg = order == -1 || order == 1;
+                    break;
+                case relation_t::lt:
+                    reg = order == -1;
+                    break;
+                case relation_t::le:
+                    reg = order == -1 || order == 0;
+                    break;
+                case relation_t::gt:
+                    reg = order == 1;
+                    break;
+                case relation_t::ge:
+                    reg = order == 1 || order == 0;
+                    break;
+                }
+            } else {
+                reg = false;
+            }
+
+            ++id;
+            break;
+        }
+        case opcode_t::exists:
+            reg = lookup(record, keys[instruction.lhs.key]) != nullptr;
+            ++id;
+            break;
+        case opcode_t::negate:
+            reg = !reg;
+            ++id;
+            break;
+        case opcode_t::jump_false:
+            id = reg ? id + 1 : instruction.target;
+            break;
+        case opcode_t::jump_true:
+            id = reg ? instruction.target : id + 1;
+            break;
+        }
+    }
+
+    return reg;
+}
+
+auto expression_t::filter(const record_t& record) -> filter_t::action_t {
+    return evaluate(record) ? filter_t::action_t::neutral : filter_t::action_t::deny;
+}
+
+}  // namespace filter
+
+auto factory<filter::expression_t>::type() const noexcept -> const char* {
+    return "expression";
+}
+
+auto factory<filter::expression_t>::from(const config::node_t& config) const ->
+    std::unique_ptr<filter_t>
+{
+    if (auto expression = config["expression"].to_string()) {
+        return blackhole::make_unique<filter::expression_t>(*expression);
+    }
+
+    throw std::invalid_argument("field 'expression' is required");
+}
+
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "blackhole/attribute.hpp"
+#include "blackhole/attribute/key.hpp"
+#include "blackhole/filter.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace filter {
+
+/// Filter evaluating a boolean expression compiled into a flat program.
+///
+/// The program is a sequence of instructions operating on a single boolean register, where logical
+/// operators are compiled into conditional jumps, making evaluation short-circuiting. Attribute
+/// names are interned while compiling, so attributes with interned keys are matched by pointer.
+/// Evaluation never allocates.
+///
+/// Records for which the expression is true are passed further, others are denied.
+class expression_t : public filter_t {
+public:
+    enum class opcode_t : std::uint8_t {
+        /// Sets the register to the result of comparing both operands.
+        compare,
+        /// Sets the register to whether the attribute exists.
+        exists,
+        /// Negates the register.
+        negate,
+        /// Jumps to the target if the register is false.
+        jump_false,
+        /// Jumps to the target if the register is true.
+        jump_true
+    };
+
+    enum class relation_t : std::uint8_t {
+        eq,
+        ne,
+        lt,
+        le,
+        gt,
+        ge
+    };
+
+    struct operand_t {
+        enum class kind_t : std::uint8_t {
+            constant,
+            severity,
+            message,
+            attribute
+        };
+
+        kind_t kind;
+        std::size_t key;
+        attribute::view_t value;
+    };
+
+    struct instruction_t {
+        opcode_t opcode;
+        relation_t relation;
+        operand_t lhs;
+        operand_t rhs;
+        std::size_t target;
+    };
+
+private:
+    std::vector<instruction_t> program;
+    std::vector<attribute::key_t> keys;
+
+    /// Storage for string literals, which are referred to by constant operands.
+    std::deque<std::string> strings;
+
+public:
+    /// Compiles the given expression.
+    ///
+    /// \throw std::invalid_argument if the expression is malformed.
+    explicit expression_t(const std::string& expression);
+
+    expression_t(const expression_t& other) = delete;
+    auto operator=(const expression_t& other) -> expression_t& = delete;
+
+    /// Returns the compiled program.
+    auto instructions() const noexcept -> const std::vector<instruction_t>& {
+        return program;
+    }
+
+    /// Evaluates the expression over the given record.
+    auto evaluate(const record_t& record) const -> bool;
+
+    auto filter(const record_t& record) -> filter_t::action_t override;
+
+private:
+    class compiler_t;
+};
+
+}  // namespace filter
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,74 @@
+#include "blackhole/filter/limit.hpp"
+
+#include <cmath>
+#include <stdexcept>
+
+#include <boost/optional/optional.hpp>
+
+#include "blackhole/config/node.hpp"
+#include "blackhole/config/option.hpp"
+
+#include "blackhole/detail/memory.hpp"
+
+#include "limit.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace filter {
+
+limit_t::limit_t(double rate,
+                 std::uint64_t burst,
+                 std::string attribute,
+                 std::chrono::nanoseconds interval) :
+    throttle_t(std::move(attribute), interval)
+{
+    if (!(rate > 0.0) || burst == 0) {
+        throw std::invalid_argument("rate and burst must be positive");
+    }
+
+    emission = std::max<std::int64_t>(1, static_cast<std::int64_t>(std::llround(1e9 / rate)));
+    tolerance = emission * static_cast<std::int64_t>(burst - 1);
+}
+
+auto limit_t::admit(slot_t& slot, std::uint64_t, std::int64_t now) -> bool {
+    // Generic cell rate algorithm: a record conforms unless the next arrival time is further than
+    // the burst tolerance from now.
+    auto tat = slot.state.load(std::memory_order_relaxed);
+
+    while (true) {
+        const auto base = std::max(tat, now);
+
+        if (base - now > tolerance) {
+            return false;
+        }
+
+        if (slot.state.compare_exchange_weak(tat, base + emission, std::memory_order_relaxed)) {
+            return true;
+        }
+    }
+}
+
+}  // namespace filter
+
+auto factory<filter::limit_t>::type() const noexcept -> const char* {
+    return "limit";
+}
+
+auto factory<filter::limit_t>::from(const config::node_t& config) const ->
+    std::unique_ptr<filter_t>
+{
+    const auto rate = config["rate"].to_double();
+    if (!rate) {
+        throw std::invalid_argument("field 'rate' is required");
+    }
+
+    const auto burst = config["burst"].to_uint64().get_value_or(1);
+    const auto attribute = config["attribute"].to_string().get_value_or(std::string());
+    const auto interval = config["interval"].to_uint64().get_value_or(1000);
+
+    return blackhole::make_unique<filter::limit_t>(*rate, burst, attribute,
+        std::chrono::milliseconds(interval));
+}
+
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "throttle.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace filter {
+
+/// Rate limiting filter, which passes at most the given number of records per second for each key
+/// allowing short bursts of up to the given size.
+///
+/// Each slot keeps a token bucket encoded as the theoretical arrival time of the next record, which
+/// is advanced by a single compare-and-swap when a record passes.
+class limit_t : public throttle_t {
+    std::int64_t emission;
+    std::int64_t tolerance;
+
+public:
+    /// \throw std::invalid_argument if either the rate or burst is not positive.
+    limit_t(double rate,
+            std::uint64_t burst,
+            std::string attribute = {},
+            std::chrono::nanoseconds interval = std::chrono::seconds(1));
+
+protected:
+    auto admit(slot_t& slot, std::uint64_t key, std::int64_t now) -> bool override;
+};
+
+}  // namespace filter
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,92 @@
+#include "blackhole/filter/sample.hpp"
+
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+
+#include <boost/optional/optional.hpp>
+
+#include "blackhole/config/node.hpp"
+#include "blackhole/config/option.hpp"
+
+#include "blackhole/detail/memory.hpp"
+
+#include "sample.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace filter {
+namespace {
+
+/// Returns the next number of the thread-local xorshift64* sequence.
+auto random() noexcept -> std::uint64_t {
+    thread_local std::uint64_t state =
+        std::hash<std::thread::id>()(std::this_thread::get_id()) | 1;
+
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    return state * 0x2545f4914f6cdd1dull;
+}
+
+}  // namespace
+
+sample_t::sample_t(std::uint64_t every,
+                   double probability,
+                   std::string attribute,
+                   std::chrono::nanoseconds interval) :
+    throttle_t(std::move(attribute), interval),
+    every(every)
+{
+    if (every == 0) {
+        throw std::invalid_argument("sampling period must be positive");
+    }
+
+    if (!(probability > 0.0 && probability <= 1.0)) {
+        throw std::invalid_argument("sampling probability must be in (0; 1] range");
+    }
+
+    if (probability == 1.0) {
+        threshold = std::numeric_limits<std::uint64_t>::max();
+    } else {
+        threshold = static_cast<std::uint64_t>(std::ldexp(probability, 64));
+    }
+}
+
+auto sample_t::admit(slot_t& slot, std::uint64_t, std::int64_t) -> bool {
+    if (every > 1) {
+        const auto id = slot.state.fetch_add(1, std::memory_order_relaxed);
+        if (static_cast<std::uint64_t>(id) % every != 0) {
+            return false;
+        }
+    }
+
+    return threshold == std::numeric_limits<std::uint64_t>::max() || random() < threshold;
+}
+
+}  // namespace filter
+
+auto factory<filter::sample_t>::type() const noexcept -> const char* {
+    return "sample";
+}
+
+auto factory<filter::sample_t>::from(const config::node_t& config) const ->
+    std::unique_ptr<filter_t>
+{
+    const auto every = config["every"].to_uint64();
+    const auto probability = config["probability"].to_double();
+
+    if (!every && !probability) {
+        throw std::invalid_argument("either field 'every' or 'probability' is required");
+    }
+
+    const auto attribute = config["attribute"].to_string().get_value_or(std::string());
+    const auto interval = config["interval"].to_uint64().get_value_or(1000);
+
+    return blackhole::make_unique<filter::sample_t>(every.get_value_or(1),
+        probability.get_value_or(1.0), attribute, std::chrono::milliseconds(interval));
+}
+
+}  // namespace v1
+}  // namespace blackhole
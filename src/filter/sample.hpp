@@ -0,0 +1,31 @@
+#pragma once
+
+#include "throttle.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace filter {
+
+/// Sampling filter, which passes every N-th record of each key, starting from the first one, and
+/// then passes it with the given probability.
+///
+/// Random numbers are generated by a thread-local xorshift generator, so probabilistic sampling
+/// doesn't share any state between threads.
+class sample_t : public throttle_t {
+    std::uint64_t every;
+    std::uint64_t threshold;
+
+public:
+    /// \throw std::invalid_argument if the period is zero or the probability is not in (0; 1].
+    sample_t(std::uint64_t every,
+             double probability = 1.0,
+             std::string attribute = {},
+             std::chrono::nanoseconds interval = std::chrono::seconds(1));
+
+protected:
+    auto admit(slot_t& slot, std::uint64_t key, std::int64_t now) -> bool override;
+};
+
+}  // namespace filter
+}  // namespace v1
+}  // namespace blackhole
@@ -4,31 +4,13 @@
 
 #include "blackhole/config/node.hpp"
 #include "blackhole/config/option.hpp"
-#include "blackhole/filter.hpp"
-#include "blackhole/record.hpp"
 
 #include "blackhole/detail/memory.hpp"
 
+#include "severity.hpp"
+
 namespace blackhole {
 inline namespace v1 {
-namespace filter {
-
-class severity_t : public filter_t {
-    std::int64_t threshold;
-
-public:
-    severity_t(std::int64_t threshold) noexcept : threshold(threshold) {}
-
-    auto filter(const record_t& record) -> filter_t::action_t override {
-        if (record.severity() >= threshold) {
-            return filter_t::action_t::neutral;
-        } else {
-            return filter_t::action_t::deny;
-        }
-    }
-};
-
-}  // namespace filter
 
 auto factory<filter::severity_t>::type() const noexcept -> const char* {
     return "severity";
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+
+#include "blackhole/filter.hpp"
+#include "blackhole/record.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace filter {
+
+/// Denies records with severity less than the threshold.
+///
+/// Handlers may recognize this filter and check the threshold directly without calling it.
+class severity_t : public filter_t {
+    std::int64_t threshold_;
+
+public:
+    severity_t(std::int64_t threshold) noexcept : threshold_(threshold) {}
+
+    auto threshold() const noexcept -> std::int64_t {
+        return threshold_;
+    }
+
+    auto filter(const record_t& record) -> filter_t::action_t override {
+        if (record.severity() >= threshold_) {
+            return filter_t::action_t::neutral;
+        } else {
+            return filter_t::action_t::deny;
+        }
+    }
+};
+
+}  // namespace filter
+}  // namespace v1
+}  // namespace blackhole
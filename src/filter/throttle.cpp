@@ -0,0 +1,149 @@
+#include "throttle.hpp"
+
+#include <new>
+
+#include <boost/align/aligned_alloc.hpp>
+#include <boost/variant/apply_visitor.hpp>
+
+#include "blackhole/attribute.hpp"
+#include "blackhole/attributes.hpp"
+#include "blackhole/extensions/writer.hpp"
+#include "blackhole/record.hpp"
+
+#include "blackhole/detail/attribute.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace filter {
+namespace {
+
+using attribute::view_t;
+
+class hash_t : public boost::static_visitor<std::uint64_t> {
+public:
+    auto operator()(const view_t::null_type&) const noexcept -> std::uint64_t {
+        return 0;
+    }
+
+    template<typename T>
+    auto operator()(const T& value) const -> std::uint64_t {
+        return std::hash<T>()(value);
+    }
+
+    auto operator()(const view_t::function_type& value) const -> std::uint64_t {
+        writer_t writer;
+        value(writer);
+        return std::hash<string_view>()(writer.result());
+    }
+};
+
+auto now() noexcept -> std::int64_t {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/// Allocates the given number of objects aligned as their type requires.
+template<typename T>
+auto allocate(std::size_t size) -> T* {
+    const auto memory = boost::alignment::aligned_alloc(alignof(T), sizeof(T) * size);
+    if (memory == nullptr) {
+        throw std::bad_alloc();
+    }
+
+    const auto result = static_cast<T*>(memory);
+    for (std::size_t id = 0; id < size; ++id) {
+        new (result + id) T;
+    }
+
+    return result;
+}
+
+}  // namespace
+
+constexpr std::size_t throttle_t::size;
+
+auto throttle_t::release_t::operator()(slot_t* slots) const noexcept -> void {
+    // Slots consist of atomics only, which are trivially destructible.
+    boost::alignment::aligned_free(slots);
+}
+
+throttle_t::throttle_t(std::string attribute, std::chrono::nanoseconds interval) :
+    attribute(std::move(attribute)),
+    interval(interval),
+    slots(allocate<slot_t>(size)),
+    total(0)
+{
+    for (std::size_t id = 0; id < size; ++id) {
+        slots[id].state.store(0, std::memory_order_relaxed);
+        slots[id].timestamp.store(0, std::memory_order_relaxed);
+        slots[id].suppressed.store(0, std::memory_order_relaxed);
+        slots[id].deadline.store(0, std::memory_order_relaxed);
+    }
+}
+
+auto throttle_t::report(reporter_type reporter) -> void {
+    this->reporter = std::move(reporter);
+}
+
+auto throttle_t::suppressed() const noexcept -> std::uint64_t {
+    return total.load(std::memory_order_relaxed);
+}
+
+auto throttle_t::summary() const noexcept -> const char* {
+    return "suppressed {} messages";
+}
+
+auto throttle_t::filter(const record_t& record) -> filter_t::action_t {
+    // Fibonacci hashing takes the high bits, which are well mixed even for aligned pointers.
+    const auto key = this->key(record);
+    const auto id = (key * 0x9e3779b97f4a7c15ull) >> 54;
+    static_assert(size == 1 << (64 - 54), "slot index must cover the table exactly");
+
+    auto& slot = slots[id];
+    const auto timestamp = now();
+
+    if (!admit(slot, key, timestamp)) {
+        slot.suppressed.fetch_add(1, std::memory_order_relaxed);
+        total.fetch_add(1, std::memory_order_relaxed);
+        return filter_t::action_t::deny;
+    }
+
+    if (reporter && slot.suppressed.load(std::memory_order_relaxed) != 0) {
+        // Only the thread advancing the deadline reports, others keep accumulating.
+        auto deadline = slot.deadline.load(std::memory_order_relaxed);
+        if (timestamp >= deadline &&
+            slot.deadline.compare_exchange_strong(deadline, timestamp + interval.count(),
+                std::memory_order_relaxed))
+        {
+            if (const auto suppressed = slot.suppressed.exchange(0, std::memory_order_relaxed)) {
+                reporter(record, suppressed);
+            }
+        }
+    }
+
+    return filter_t::action_t::neutral;
+}
+
+auto throttle_t::key(const record_t& record) const -> std::uint64_t {
+    if (attribute.empty()) {
+        return record.pattern_hash();
+    }
+
+    return hash(record, string_view(attribute.data(), attribute.size()));
+}
+
+auto throttle_t::hash(const record_t& record, const string_view& name) -> std::uint64_t {
+    for (const auto& list : record.attributes()) {
+        for (const auto& it : list.get()) {
+            if (it.first == name) {
+                return boost::apply_visitor(hash_t(), it.second.inner().value);
+            }
+        }
+    }
+
+    return 0;
+}
+
+}  // namespace filter
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "blackhole/filter.hpp"
+#include "blackhole/stdext/string_view.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace filter {
+
+/// Base for filters suppressing records with the same key, which is either the call site, i.e. the
+/// message pattern pointer, or the value of the given attribute.
+///
+/// Per-key state lives in a fixed table of cache line sized slots updated using atomics only, so
+/// filtering never locks. Keys are hashed into the table, so distinct keys sharing a slot share
+/// its state as well. Records without the key attribute share a single slot.
+///
+/// Suppressed records are counted per slot. When a record is passed while its slot has suppressed
+/// records and at least the summary interval has passed since the last summary, the reporter is
+/// called with this record and the number of records suppressed since then, allowing handlers to
+/// emit a summary record. Summaries are lazy, i.e. suppressed records of a key are reported only
+/// after another one of the same key passes.
+class throttle_t : public filter_t {
+public:
+    typedef std::function<auto(const record_t& record, std::uint64_t suppressed) -> void>
+        reporter_type;
+
+    /// Number of slots in the table.
+    static constexpr std::size_t size = 1024;
+
+protected:
+    struct alignas(64) slot_t {
+        /// Filter specific state.
+        std::atomic<std::int64_t> state;
+        /// Filter specific monotonic time point in nanoseconds.
+        std::atomic<std::int64_t> timestamp;
+        /// Number of records suppressed since the last summary.
+        std::atomic<std::uint64_t> suppressed;
+        /// Monotonic time in nanoseconds before which no summary is reported.
+        std::atomic<std::int64_t> deadline;
+    };
+
+private:
+    /// Frees the table allocated with the alignment of slots, which C++14 `new` doesn't honor.
+    struct release_t {
+        auto operator()(slot_t* slots) const noexcept -> void;
+    };
+
+    std::string attribute;
+    std::chrono::nanoseconds interval;
+    std::unique_ptr<slot_t[], release_t> slots;
+    reporter_type reporter;
+    std::atomic<std::uint64_t> total;
+
+public:
+    /// Constructs a filter accounting records by the given attribute, or by the call site if the
+    /// name is empty, reporting suppressed records at most once per given interval for each slot.
+    throttle_t(std::string attribute, std::chrono::nanoseconds interval);
+
+    throttle_t(const throttle_t& other) = delete;
+    auto operator=(const throttle_t& other) -> throttle_t& = delete;
+
+    /// Sets the reporter called with summaries of suppressed records.
+    ///
+    /// \warning must not be called concurrently with filtering.
+    auto report(reporter_type reporter) -> void;
+
+    /// Returns the total number of records suppressed.
+    auto suppressed() const noexcept -> std::uint64_t;
+
+    /// Returns the message pattern of summary records, which is formatted with the number of
+    /// suppressed records.
+    virtual auto summary() const noexcept -> const char*;
+
+    auto filter(const record_t& record) -> filter_t::action_t override final;
+
+protected:
+    /// Returns the key of the given record, which is the hash of either the configured attribute
+    /// value or the call site.
+    virtual auto key(const record_t& record) const -> std::uint64_t;
+
+    /// Checks whether the record with the given key should be passed, updating the state of its
+    /// slot.
+    virtual auto admit(slot_t& slot, std::uint64_t key, std::int64_t now) -> bool = 0;
+
+    /// Returns the hash of the value of the attribute with the given name, zero if there is no
+    /// such attribute.
+    static auto hash(const record_t& record, const string_view& name) -> std::uint64_t;
+};
+
+}  // namespace filter
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,231 @@
+#include "blackhole/filter/traced.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+#include <boost/optional/optional.hpp>
+#include <boost/variant/apply_visitor.hpp>
+
+#include "blackhole/attribute.hpp"
+#include "blackhole/attributes.hpp"
+#include "blackhole/config/node.hpp"
+#include "blackhole/config/option.hpp"
+#include "blackhole/extensions/writer.hpp"
+#include "blackhole/record.hpp"
+
+#include "blackhole/detail/attribute.hpp"
+#include "blackhole/detail/memory.hpp"
+
+#include "traced.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace filter {
+namespace {
+
+using attribute::view_t;
+
+/// Trace id bits carrying randomness.
+constexpr std::uint64_t mask = (std::uint64_t(1) << 56) - 1;
+
+auto threshold_of(double rate) -> std::uint64_t {
+    if (!(rate >= 0.0 && rate <= 1.0)) {
+        throw std::invalid_argument("sampling rate must be in [0; 1] range");
+    }
+
+    return static_cast<std::uint64_t>(std::ldexp(1.0 - rate, 56));
+}
+
+/// Finalizer of SplitMix64, which spreads sequential values over all bits.
+auto mix(std::uint64_t value) noexcept -> std::uint64_t {
+    value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ull;
+    value = (value ^ (value >> 27)) * 0x94d049bb133111ebull;
+    return value ^ (value >> 31);
+}
+
+auto digit(char ch) noexcept -> int {
+    if (ch >= '0' && ch <= '9') {
+        return ch - '0';
+    }
+
+    if (ch >= 'a' && ch <= 'f') {
+        return ch - 'a' + 10;
+    }
+
+    if (ch >= 'A' && ch <= 'F') {
+        return ch - 'A' + 10;
+    }
+
+    return -1;
+}
+
+/// Takes the lowest 56 bits of hexadecimal trace ids as is, so that the decision matches other
+/// implementations of consistent sampling, and hashes other strings.
+auto randomness_of(const string_view& value) noexcept -> std::uint64_t {
+    if (value.size() >= 14) {
+        std::uint64_t result = 0;
+        bool hex = true;
+
+        for (std::size_t id = 0; id < value.size() && hex; ++id) {
+            const auto current = digit(value[id]);
+            hex = current >= 0;
+            result = (result << 4) | static_cast<std::uint64_t>(current & 0xf);
+        }
+
+        if (hex) {
+            return result & mask;
+        }
+    }
+
+    // FNV-1a.
+    std::uint64_t hash = 0xcbf29ce484222325ull;
+    for (std::size_t id = 0; id < value.size(); ++id) {
+        hash ^= static_cast<unsigned char>(value[id]);
+        hash *= 0x100000001b3ull;
+    }
+
+    return mix(hash) & mask;
+}
+
+class randomness_t : public boost::static_visitor<std::uint64_t> {
+public:
+    auto operator()(const view_t::null_type&) const noexcept -> std::uint64_t {
+        return 0;
+    }
+
+    auto operator()(bool value) const noexcept -> std::uint64_t {
+        return mix(value ? 1 : 0) & mask;
+    }
+
+    auto operator()(std::int64_t value) const noexcept -> std::uint64_t {
+        return mix(static_cast<std::uint64_t>(value)) & mask;
+    }
+
+    auto operator()(std::uint64_t value) const noexcept -> std::uint64_t {
+        return mix(value) & mask;
+    }
+
+    auto operator()(double value) const noexcept -> std::uint64_t {
+        std::uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return mix(bits) & mask;
+    }
+
+    auto operator()(const view_t::string_type& value) const noexcept -> std::uint64_t {
+        return randomness_of(value);
+    }
+
+    auto operator()(const view_t::function_type& value) const -> std::uint64_t {
+        writer_t writer;
+        value(writer);
+        return randomness_of(writer.result());
+    }
+};
+
+}  // namespace
+
+traced_t::traced_t(double rate,
+                   std::string attribute,
+                   bool untraced,
+                   std::vector<severity_t> severities) :
+    attribute(std::move(attribute)),
+    untraced(untraced),
+    threshold(threshold_of(rate))
+{
+    std::stable_sort(severities.begin(), severities.end(),
+        [](const severity_t& lhs, const severity_t& rhs) -> bool {
+            return lhs.threshold > rhs.threshold;
+        });
+
+    for (const auto& severity : severities) {
+        overrides.emplace_back(severity.threshold, threshold_of(severity.rate));
+    }
+}
+
+auto traced_t::rate() const noexcept -> double {
+    return 1.0 - std::ldexp(static_cast<double>(threshold.load(std::memory_order_relaxed)), -56);
+}
+
+auto traced_t::rate(double value) -> void {
+    threshold.store(threshold_of(value), std::memory_order_relaxed);
+}
+
+auto traced_t::filter(const record_t& record) -> filter_t::action_t {
+    auto threshold = this->threshold.load(std::memory_order_relaxed);
+
+    for (const auto& it : overrides) {
+        if (record.severity() >= it.first) {
+            threshold = it.second;
+            break;
+        }
+    }
+
+    // Records kept always need no trace id at all.
+    if (threshold == 0) {
+        return filter_t::action_t::neutral;
+    }
+
+    bool traced = false;
+    const auto randomness = this->randomness(record, traced);
+
+    if (!traced) {
+        return untraced ? filter_t::action_t::neutral : filter_t::action_t::deny;
+    }
+
+    return randomness >= threshold ? filter_t::action_t::neutral : filter_t::action_t::deny;
+}
+
+auto traced_t::randomness(const record_t& record, bool& traced) const -> std::uint64_t {
+    if (attribute.empty()) {
+        const auto& trace = record.trace();
+        traced = !trace.empty();
+        return trace.lo & mask;
+    }
+
+    for (const auto& list : record.attributes()) {
+        for (const auto& it : list.get()) {
+            if (it.first == attribute) {
+                traced = it.second.inner().value.which() != 0;
+                return boost::apply_visitor(randomness_t(), it.second.inner().value);
+            }
+        }
+    }
+
+    return 0;
+}
+
+}  // namespace filter
+
+auto factory<filter::traced_t>::type() const noexcept -> const char* {
+    return "traced";
+}
+
+auto factory<filter::traced_t>::from(const config::node_t& config) const ->
+    std::unique_ptr<filter_t>
+{
+    const auto rate = config["rate"].to_double();
+    if (!rate) {
+        throw std::invalid_argument("field 'rate' is required");
+    }
+
+    std::vector<filter::traced_t::severity_t> severities;
+    config["severities"].each([&](const config::node_t& severity) {
+        const auto threshold = severity["threshold"].to_sint64();
+        const auto rate = severity["rate"].to_double();
+
+        if (!threshold || !rate) {
+            throw std::invalid_argument("each severity override must have 'threshold' and 'rate'");
+        }
+
+        severities.push_back({threshold.get(), rate.get()});
+    });
+
+    return blackhole::make_unique<filter::traced_t>(rate.get(),
+        config["attribute"].to_string().get_value_or(std::string()),
+        config["untraced"].to_bool().get_value_or(true), std::move(severities));
+}
+
+}  // namespace v1
+}  // namespace blackhole
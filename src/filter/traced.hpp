@@ -0,0 +1,70 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "blackhole/filter.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace filter {
+
+/// Consistent sampling filter, which keeps or drops whole traces, so that every service using the
+/// same rate keeps the same traces complete.
+///
+/// The decision follows the consistent probability sampling of W3C trace context and OpenTelemetry:
+/// the lowest 56 bits of the trace id are its randomness, and a trace is kept with the rate `p` if
+/// the randomness is not less than `(1 - p) * 2^56`. Thus lowering the rate keeps a subset of
+/// traces kept before. Trace ids of attributes are taken from hexadecimal strings of at least 14
+/// digits as is, while other values, like integer request ids, are hashed with FNV-1a followed by
+/// the SplitMix64 finalizer, which is stable across builds and platforms.
+///
+/// Severity overrides apply their own rates to records of at least the given severity, which
+/// allows to keep all errors regardless of their trace.
+class traced_t : public filter_t {
+public:
+    /// Represents the rate of records of at least the given severity.
+    struct severity_t {
+        std::int64_t threshold;
+        double rate;
+    };
+
+private:
+    std::string attribute;
+    bool untraced;
+
+    /// Randomness thresholds of the base rate and of overrides ordered by descending severity.
+    std::atomic<std::uint64_t> threshold;
+    std::vector<std::pair<std::int64_t, std::uint64_t>> overrides;
+
+public:
+    /// \param attribute the name of the trace id attribute, the inline trace context if empty.
+    /// \param untraced whether records without a trace id are kept.
+    ///
+    /// \throw std::invalid_argument if any rate is out of [0; 1] range.
+    explicit traced_t(double rate,
+                      std::string attribute = {},
+                      bool untraced = true,
+                      std::vector<severity_t> severities = {});
+
+    /// Returns the base rate.
+    auto rate() const noexcept -> double;
+
+    /// Changes the base rate at runtime, which takes effect for records filtered afterwards.
+    ///
+    /// \throw std::invalid_argument if the rate is out of [0; 1] range.
+    auto rate(double value) -> void;
+
+    auto filter(const record_t& record) -> filter_t::action_t override;
+
+private:
+    /// Returns the 56 bits of trace id randomness, setting the flag if the record has any.
+    auto randomness(const record_t& record, bool& traced) const -> std::uint64_t;
+};
+
+}  // namespace filter
+}  // namespace v1
+}  // namespace blackhole
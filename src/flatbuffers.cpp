@@ -0,0 +1,153 @@
+#include "blackhole/detail/flatbuffers.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "blackhole/stdext/string_view.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace detail {
+namespace flatbuffers {
+
+builder_t::builder_t() :
+    buffer(1024),
+    head(buffer.size()),
+    minalign(1),
+    start(0)
+{}
+
+auto builder_t::size() const noexcept -> offset_t {
+    return static_cast<offset_t>(buffer.size() - head);
+}
+
+auto builder_t::string(const string_view& value) -> offset_t {
+    prepare(sizeof(offset_t), value.size() + 1);
+
+    static const char zero = '\0';
+    put(&zero, 1);
+    put(value.data(), value.size());
+
+    const auto length = static_cast<std::uint32_t>(value.size());
+    push(reinterpret_cast<const char*>(&length), sizeof(length));
+
+    return size();
+}
+
+auto builder_t::offsets(const std::vector<offset_t>& values) -> offset_t {
+    prepare(sizeof(offset_t), values.size() * sizeof(offset_t));
+
+    for (auto it = values.rbegin(); it != values.rend(); ++it) {
+        put_offset(*it);
+    }
+
+    const auto length = static_cast<std::uint32_t>(values.size());
+    push(reinterpret_cast<const char*>(&length), sizeof(length));
+
+    return size();
+}
+
+auto builder_t::structs(const char* data, std::size_t count, std::size_t size,
+    std::size_t alignment) -> offset_t
+{
+    // Both the length prefix and the elements following it must be aligned.
+    prepare(sizeof(offset_t), count * size);
+    prepare(alignment, count * size);
+    put(data, count * size);
+
+    const auto length = static_cast<std::uint32_t>(count);
+    push(reinterpret_cast<const char*>(&length), sizeof(length));
+
+    return this->size();
+}
+
+auto builder_t::begin() -> void {
+    fields.clear();
+    start = size();
+}
+
+auto builder_t::reference(std::uint16_t field, offset_t value) -> void {
+    put_offset(value);
+    fields.emplace_back(field, size());
+}
+
+auto builder_t::end() -> offset_t {
+    // The table begins with the offset to its vtable, which is patched once the vtable is written.
+    const std::int32_t placeholder = 0;
+    push(reinterpret_cast<const char*>(&placeholder), sizeof(placeholder));
+    const auto table = size();
+
+    std::uint16_t count = 0;
+    for (const auto& field : fields) {
+        count = std::max<std::uint16_t>(count, static_cast<std::uint16_t>(field.first + 1));
+    }
+
+    std::vector<std::uint16_t> vtable(2 + count, 0);
+    vtable[0] = static_cast<std::uint16_t>(vtable.size() * sizeof(std::uint16_t));
+    vtable[1] = static_cast<std::uint16_t>(table - start);
+
+    for (const auto& field : fields) {
+        vtable[2 + field.first] = static_cast<std::uint16_t>(table - field.second);
+    }
+
+    for (auto it = vtable.rbegin(); it != vtable.rend(); ++it) {
+        push(reinterpret_cast<const char*>(&*it), sizeof(*it));
+    }
+
+    const auto offset = static_cast<std::int32_t>(size() - table);
+    std::memcpy(&buffer[buffer.size() - table], &offset, sizeof(offset));
+
+    fields.clear();
+    return table;
+}
+
+auto builder_t::finish(offset_t root) -> std::string {
+    prepare(minalign, sizeof(offset_t));
+    put_offset(root);
+
+    return std::string(buffer.data() + head, buffer.size() - head);
+}
+
+auto builder_t::prepare(std::size_t alignment, std::size_t additional) -> void {
+    minalign = std::max(minalign, alignment);
+
+    const auto padding = (~(size() + additional) + 1) & (alignment - 1);
+
+    static const char zeros[16] = {};
+    put(zeros, padding);
+}
+
+auto builder_t::push(const char* data, std::size_t size) -> void {
+    prepare(size, 0);
+    put(data, size);
+}
+
+auto builder_t::put(const char* data, std::size_t size) -> void {
+    if (head < size) {
+        const auto used = buffer.size() - head;
+        std::vector<char> grown(std::max(2 * buffer.size(), used + size));
+
+        std::copy(buffer.begin() + static_cast<std::ptrdiff_t>(head), buffer.end(),
+            grown.end() - static_cast<std::ptrdiff_t>(used));
+
+        head = grown.size() - used;
+        buffer.swap(grown);
+    }
+
+    head -= size;
+    std::memcpy(&buffer[head], data, size);
+}
+
+auto builder_t::put_offset(offset_t value) -> void {
+    prepare(sizeof(offset_t), 0);
+
+    // Referenced objects are written earlier, i.e. located further, so the offset is relative to
+    // the position of the offset itself.
+    const auto offset = static_cast<std::uint32_t>(size() - value + sizeof(offset_t));
+    put(reinterpret_cast<const char*>(&offset), sizeof(offset));
+}
+
+}  // namespace flatbuffers
+}  // namespace detail
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,48 @@
+#include "blackhole/formatter/binary.hpp"
+
+#include "blackhole/extensions/writer.hpp"
+#include "blackhole/formatter.hpp"
+#include "blackhole/record.hpp"
+#include "blackhole/stdext/string_view.hpp"
+
+#include "blackhole/detail/formatter/binary/frame.hpp"
+#include "blackhole/detail/memory.hpp"
+#include "blackhole/detail/sink/ring.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace formatter {
+
+class binary_t : public formatter_t {
+public:
+    auto format(const record_t& record, writer_t& writer) -> void override {
+        // Decoders format records themselves, so there is no output to keep.
+        const auto encoded = sink::ring::encode(record, string_view());
+
+        detail::formatter::binary::frame_t frame;
+        frame.size = static_cast<std::uint32_t>(encoded.size());
+        frame.checksum = detail::formatter::binary::checksum(encoded.data(), encoded.size());
+
+        writer.inner << fmt::StringRef(reinterpret_cast<const char*>(&frame), sizeof(frame));
+        writer.inner << fmt::StringRef(encoded.data(), encoded.size());
+    }
+};
+
+}  // namespace formatter
+
+using formatter::binary_t;
+
+auto builder<binary_t>::build() && -> std::unique_ptr<formatter_t> {
+    return blackhole::make_unique<binary_t>();
+}
+
+auto factory<binary_t>::type() const noexcept -> const char* {
+    return "binary";
+}
+
+auto factory<binary_t>::from(const config::node_t&) const -> std::unique_ptr<formatter_t> {
+    return builder<binary_t>().build();
+}
+
+}  // namespace v1
+}  // namespace blackhole
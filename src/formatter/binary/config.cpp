@@ -0,0 +1,33 @@
+#include "config.hpp"
+
+#include <chrono>
+
+#include "blackhole/detail/datetime.hpp"
+#include "blackhole/detail/datetime/cache.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace formatter {
+namespace binary {
+
+auto timestamp(const std::string& pattern) -> detail::formatter::binary::serializer_t::timestamp_type {
+    auto generator = detail::datetime::make_generator(pattern);
+
+    return [=](const record_t::time_point& timestamp, writer_t& wr) {
+        const auto time = record_t::clock_type::to_time_t(timestamp);
+        const auto usec = std::chrono::duration_cast<
+            std::chrono::microseconds
+        >(timestamp.time_since_epoch()).count() % 1000000;
+
+        thread_local detail::datetime::cache_t cache;
+
+        const auto& value = cache.format(pattern, generator, true, time,
+            static_cast<std::uint64_t>(usec));
+        wr.inner << fmt::StringRef(value.data(), value.size());
+    };
+}
+
+}  // namespace binary
+}  // namespace formatter
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <boost/optional/optional.hpp>
+
+#include "blackhole/config/node.hpp"
+#include "blackhole/config/option.hpp"
+
+#include "blackhole/detail/formatter/binary/serializer.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace formatter {
+namespace binary {
+
+/// Returns a function writing timestamps formatted using the given pattern in UTC.
+auto timestamp(const std::string& pattern) -> detail::formatter::binary::serializer_t::timestamp_type;
+
+/// Configures the given builder of a binary formatter using the same options as the JSON formatter
+/// factory does, except both newline and streaming ones.
+template<typename Builder>
+auto configure(const config::node_t& config, Builder& builder) -> void {
+    if (auto unique = config["unique"].to_bool()) {
+        if (unique.get()) {
+            builder.unique();
+        }
+    }
+
+    if (auto mapping = config["mapping"]) {
+        mapping.each_map([&](const std::string& key, const config::node_t& value) {
+            builder.rename(key, value.to_string());
+        });
+    }
+
+    if (auto routing = config["routing"]) {
+        routing.each_map([&](const std::string& key, const config::node_t& value) {
+            try {
+                value.to_string();
+                builder.route(key);
+                return;
+            } catch (const std::logic_error&) {
+                // Eat.
+            }
+
+            std::vector<std::string> attributes;
+            value.each([&](const config::node_t& config) {
+                attributes.emplace_back(config.to_string());
+            });
+            builder.route(key, std::move(attributes));
+        });
+    }
+
+    if (auto mutate = config["mutate"]) {
+        mutate.each_map([&](const std::string& key, const config::node_t& config) {
+            if (key == "timestamp") {
+                builder.timestamp(config.to_string());
+            } else if (key == "severity") {
+                std::vector<std::string> mapping;
+                config.each([&](const config::node_t& severity) {
+                    mapping.emplace_back(severity.to_string());
+                });
+                builder.severity(std::move(mapping));
+            } else {
+                throw std::invalid_argument("only \"timestamp\" and \"severity\" mutations are allowed now");
+            }
+        });
+    }
+}
+
+}  // namespace binary
+}  // namespace formatter
+}  // namespace v1
+}  // namespace blackhole
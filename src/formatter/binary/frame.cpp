@@ -0,0 +1,61 @@
+#include "blackhole/detail/formatter/binary/frame.hpp"
+
+#include <cstring>
+
+#include <zlib.h>
+
+namespace blackhole {
+inline namespace v1 {
+namespace detail {
+namespace formatter {
+namespace binary {
+
+auto checksum(const char* data, std::size_t size) noexcept -> std::uint32_t {
+    return static_cast<std::uint32_t>(::crc32(0, reinterpret_cast<const Bytef*>(data),
+        static_cast<uInt>(size)));
+}
+
+auto parse(const char* data, std::size_t size, std::size_t offset, sink::ring_t::slot_t& slot)
+    noexcept -> bool
+{
+    frame_t frame;
+    if (offset > size || size - offset < sizeof(frame)) {
+        return false;
+    }
+
+    std::memcpy(&frame, data + offset, sizeof(frame));
+
+    const auto payload = data + offset + sizeof(frame);
+    if (frame.size > size - offset - sizeof(frame) ||
+        checksum(payload, frame.size) != frame.checksum)
+    {
+        return false;
+    }
+
+    const sink::ring_t::slot_t result{payload, frame.size};
+    if (!sink::ring::valid(result)) {
+        return false;
+    }
+
+    slot = result;
+    return true;
+}
+
+auto next(const char* data, std::size_t size, const sink::ring_t::slot_t& slot) noexcept ->
+    std::size_t
+{
+    const auto offset = static_cast<std::size_t>(slot.data - data) + slot.size;
+
+    sink::ring_t::slot_t ignored;
+    if (offset < size && data[offset] == '\n' && !parse(data, size, offset, ignored)) {
+        return offset + 1;
+    }
+
+    return offset;
+}
+
+}  // namespace binary
+}  // namespace formatter
+}  // namespace detail
+}  // namespace v1
+}  // namespace blackhole
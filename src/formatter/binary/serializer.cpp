@@ -0,0 +1,336 @@
+#include "blackhole/detail/formatter/binary/serializer.hpp"
+
+#include <cstring>
+
+#include <boost/container/small_vector.hpp>
+#include <boost/variant/apply_visitor.hpp>
+
+#include "blackhole/attribute.hpp"
+
+#include "blackhole/detail/attribute.hpp"
+#include "blackhole/detail/formatter/json/escape.hpp"
+#include "blackhole/detail/process.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace detail {
+namespace formatter {
+namespace binary {
+namespace {
+
+typedef fmt::StringRef string_ref;
+
+/// Writes the given prefix byte followed by the value in network byte order.
+template<typename T>
+auto put(std::uint64_t prefix, T value, writer_t& writer) -> void {
+    char buffer[1 + sizeof(T)];
+    buffer[0] = static_cast<char>(prefix);
+
+    for (std::size_t id = 0; id < sizeof(T); ++id) {
+        buffer[sizeof(T) - id] = static_cast<char>(static_cast<std::uint64_t>(value) >> (8 * id));
+    }
+
+    writer.inner << string_ref(buffer, sizeof(buffer));
+}
+
+/// Writes CBOR data item head of the given major type, choosing the shortest argument form.
+auto head(std::uint64_t major, std::uint64_t value, writer_t& writer) -> void {
+    const auto type = major << 5;
+
+    if (value < 24) {
+        writer.inner << static_cast<char>(type | value);
+    } else if (value <= 0xff) {
+        put(type | 24, static_cast<std::uint8_t>(value), writer);
+    } else if (value <= 0xffff) {
+        put(type | 25, static_cast<std::uint16_t>(value), writer);
+    } else if (value <= 0xffffffff) {
+        put(type | 26, static_cast<std::uint32_t>(value), writer);
+    } else {
+        put(type | 27, value, writer);
+    }
+}
+
+auto write_map(encoding_t encoding, std::size_t size, writer_t& writer) -> void {
+    if (encoding == encoding_t::cbor) {
+        head(5, size, writer);
+    } else if (size < 16) {
+        writer.inner << static_cast<char>(0x80 | size);
+    } else if (size <= 0xffff) {
+        put(0xde, static_cast<std::uint16_t>(size), writer);
+    } else {
+        put(0xdf, static_cast<std::uint32_t>(size), writer);
+    }
+}
+
+auto write_raw_string(encoding_t encoding, const string_view& value, writer_t& writer) -> void {
+    const auto size = value.size();
+
+    if (encoding == encoding_t::cbor) {
+        head(3, size, writer);
+    } else if (size < 32) {
+        writer.inner << static_cast<char>(0xa0 | size);
+    } else if (size <= 0xff) {
+        put(0xd9, static_cast<std::uint8_t>(size), writer);
+    } else if (size <= 0xffff) {
+        put(0xda, static_cast<std::uint16_t>(size), writer);
+    } else {
+        put(0xdb, static_cast<std::uint32_t>(size), writer);
+    }
+
+    writer.inner << string_ref(value.data(), size);
+}
+
+/// Writes a string, replacing invalid UTF-8 sequences, because both formats require strings to be
+/// valid UTF-8 and the length must be known before the content is written.
+auto write_string(encoding_t encoding, const string_view& value, writer_t& writer) -> void {
+    if (json::validate(value) == value.size()) {
+        write_raw_string(encoding, value, writer);
+    } else {
+        const auto sanitized = json::sanitize(value);
+        write_raw_string(encoding, sanitized, writer);
+    }
+}
+
+/// Returns the given name encoded as a map key.
+auto key_of(encoding_t encoding, const string_view& name) -> std::string {
+    writer_t writer;
+    write_string(encoding, name, writer);
+    return writer.result().to_string();
+}
+
+class value_visitor_t : public boost::static_visitor<> {
+    encoding_t encoding;
+    writer_t& writer;
+
+public:
+    value_visitor_t(encoding_t encoding, writer_t& writer) noexcept :
+        encoding(encoding),
+        writer(writer)
+    {}
+
+    auto operator()(std::nullptr_t) const -> void {
+        writer.inner << static_cast<char>(encoding == encoding_t::cbor ? 0xf6 : 0xc0);
+    }
+
+    auto operator()(bool value) const -> void {
+        if (encoding == encoding_t::cbor) {
+            writer.inner << static_cast<char>(value ? 0xf5 : 0xf4);
+        } else {
+            writer.inner << static_cast<char>(value ? 0xc3 : 0xc2);
+        }
+    }
+
+    auto operator()(std::int64_t value) const -> void {
+        if (value >= 0) {
+            (*this)(static_cast<std::uint64_t>(value));
+        } else if (encoding == encoding_t::cbor) {
+            // Negative integers are encoded as -1 minus the argument.
+            head(1, ~static_cast<std::uint64_t>(value), writer);
+        } else if (value >= -32) {
+            writer.inner << static_cast<char>(value);
+        } else if (value >= INT8_MIN) {
+            put(0xd0, static_cast<std::uint8_t>(value), writer);
+        } else if (value >= INT16_MIN) {
+            put(0xd1, static_cast<std::uint16_t>(value), writer);
+        } else if (value >= INT32_MIN) {
+            put(0xd2, static_cast<std::uint32_t>(value), writer);
+        } else {
+            put(0xd3, static_cast<std::uint64_t>(value), writer);
+        }
+    }
+
+    auto operator()(std::uint64_t value) const -> void {
+        if (encoding == encoding_t::cbor) {
+            head(0, value, writer);
+        } else if (value < 0x80) {
+            writer.inner << static_cast<char>(value);
+        } else if (value <= 0xff) {
+            put(0xcc, static_cast<std::uint8_t>(value), writer);
+        } else if (value <= 0xffff) {
+            put(0xcd, static_cast<std::uint16_t>(value), writer);
+        } else if (value <= 0xffffffff) {
+            put(0xce, static_cast<std::uint32_t>(value), writer);
+        } else {
+            put(0xcf, value, writer);
+        }
+    }
+
+    auto operator()(double value) const -> void {
+        std::uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        put(encoding == encoding_t::cbor ? 0xfb : 0xcb, bits, writer);
+    }
+
+    auto operator()(const string_view& value) const -> void {
+        write_string(encoding, value, writer);
+    }
+
+    auto operator()(const attribute::view_t::function_type& value) const -> void {
+        writer_t wr;
+        value(wr);
+        write_string(encoding, wr.result(), writer);
+    }
+};
+
+}  // namespace
+
+class serializer_t::frame_t {
+public:
+    enum class kind_t : std::uint8_t {
+        /// The text is an attribute name, which requires encoding.
+        attribute,
+        /// The text is a precomputed key.
+        field,
+        /// The text is a precomputed key-value pair, the value is not used.
+        member
+    };
+
+    struct entry_t {
+        std::uint32_t node;
+        kind_t kind;
+        string_view text;
+        attribute::view_t value;
+    };
+
+    boost::container::small_vector<entry_t, 32> entries;
+
+    /// Marks objects having at least one member in their subtree.
+    boost::container::small_vector<bool, 16> used;
+
+    /// Number of members of each object including nested objects, required for map headers.
+    boost::container::small_vector<std::uint32_t, 16> count;
+};
+
+serializer_t::serializer_t(encoding_t encoding, properties_t properties) :
+    encoding(encoding),
+    layout(properties.routing, properties.rest, properties.mapping),
+    unique(properties.unique),
+    timestamp_(std::move(properties.timestamp))
+{
+    const char* names[builtins] = {"message", "thread", "process", "severity", "timestamp"};
+    for (std::uint32_t id = 0; id < builtins; ++id) {
+        const string_view name(names[id], std::strlen(names[id]));
+
+        fields[id].node = layout.node_of(name);
+        fields[id].key = key_of(encoding, layout.renamed(name));
+    }
+
+    for (const auto& severity : properties.severity) {
+        writer_t writer;
+        writer.inner << string_ref(fields[builtin_t::severity].key);
+        write_string(encoding, severity, writer);
+        severities.emplace_back(writer.result().to_string());
+    }
+}
+
+auto serializer_t::format(const record_t& record, writer_t& writer) const -> void {
+    frame_t frame;
+
+    typedef frame_t::kind_t kind_t;
+
+    const auto add = [&](const route_t& route, attribute::view_t value) {
+        frame.entries.push_back({route.node, kind_t::field, route.key, value});
+    };
+
+    add(fields[message], record.formatted());
+    add(fields[thread], this_thread::hex(record.tid()));
+    add(fields[process], record.pid());
+
+    const auto sev = static_cast<std::size_t>(record.severity());
+    if (sev < severities.size()) {
+        frame.entries.push_back({fields[severity].node, kind_t::member, severities[sev], {}});
+    } else {
+        add(fields[severity], static_cast<std::int64_t>(record.severity()));
+    }
+
+    // Uses an inline buffer, which is large enough to require no allocation.
+    writer_t time;
+    if (timestamp_) {
+        timestamp_(record.timestamp(), time);
+        add(fields[timestamp], time.result());
+    } else {
+        add(fields[timestamp], static_cast<std::int64_t>(std::chrono::duration_cast<
+            std::chrono::microseconds
+        >(record.timestamp().time_since_epoch()).count()));
+    }
+
+    const auto push = [&](const view_of<attribute_t>::type& attribute) {
+        frame.entries.push_back({
+            layout.node_of(attribute.first),
+            kind_t::attribute,
+            layout.renamed(attribute.first),
+            attribute.second
+        });
+    };
+
+    if (unique) {
+        for (const auto& item : record.unique_attributes()) {
+            push(item);
+        }
+    } else {
+        for (const auto& list : record.attributes()) {
+            for (const auto& item : list.get()) {
+                push(item);
+            }
+        }
+    }
+
+    const auto& nodes = layout.nodes();
+
+    frame.used.assign(nodes.size(), false);
+    frame.count.assign(nodes.size(), 0);
+    for (const auto& entry : frame.entries) {
+        ++frame.count[entry.node];
+
+        for (auto id = entry.node; !frame.used[id]; id = nodes[id].parent) {
+            frame.used[id] = true;
+
+            if (id != 0) {
+                ++frame.count[nodes[id].parent];
+            }
+        }
+    }
+
+    write(frame, 0, writer);
+}
+
+auto serializer_t::write(const frame_t& frame, std::uint32_t id, writer_t& writer) const -> void {
+    write_map(encoding, frame.count[id], writer);
+
+    const value_visitor_t visitor(encoding, writer);
+
+    for (const auto& entry : frame.entries) {
+        if (entry.node != id) {
+            continue;
+        }
+
+        switch (entry.kind) {
+        case frame_t::kind_t::attribute:
+            write_string(encoding, entry.text, writer);
+            break;
+        case frame_t::kind_t::field:
+        case frame_t::kind_t::member:
+            writer.inner << string_ref(entry.text.data(), entry.text.size());
+            break;
+        }
+
+        if (entry.kind != frame_t::kind_t::member) {
+            boost::apply_visitor(visitor, entry.value.inner().value);
+        }
+    }
+
+    const auto& nodes = layout.nodes();
+
+    for (auto child : nodes[id].children) {
+        if (frame.used[child]) {
+            write_string(encoding, nodes[child].name, writer);
+            write(frame, child, writer);
+        }
+    }
+}
+
+}  // namespace binary
+}  // namespace formatter
+}  // namespace detail
+}  // namespace v1
+}  // namespace blackhole
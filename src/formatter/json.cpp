@@ -1,7 +1,6 @@
 #include "blackhole/formatter/json.hpp"
 
 #include <array>
-#include <set>
 #include <unordered_map>
 
 #include <boost/optional/optional.hpp>
@@ -11,6 +10,7 @@
 #define RAPIDJSON_HAS_STDSTRING 1
 #endif
 #include <rapidjson/document.h>
+#include <rapidjson/internal/dtoa.h>
 #include <rapidjson/stringbuffer.h>
 #include <rapidjson/writer.h>
 #include <rapidjson/pointer.h>
@@ -23,7 +23,13 @@
 
 #include "blackhole/detail/attribute.hpp"
 #include "blackhole/detail/datetime.hpp"
+#include "blackhole/detail/datetime/cache.hpp"
+#include "blackhole/detail/formatter/json/escape.hpp"
+#include "blackhole/detail/formatter/json/serializer.hpp"
+#include "blackhole/detail/formatter/json/skeleton.hpp"
 #include "blackhole/detail/memory.hpp"
+#include "blackhole/detail/process.hpp"
+#include "blackhole/detail/trace.hpp"
 #include "blackhole/detail/util/deleter.hpp"
 
 #include "json.hpp"
@@ -57,48 +63,94 @@ struct visitor_t {
     }
 
     auto operator()(const string_view& value) -> void {
+        if (detail::formatter::json::validate(value) != value.size()) {
+            return copy(value);
+        }
+
         node.AddMember(rapidjson::StringRef(name.data(), name.size()),
             rapidjson::StringRef(value.data(), value.size()), allocator);
     }
 
     // For non-owning buffers.
     auto operator()(const char* data, std::size_t size) -> void {
-        node.AddMember(rapidjson::StringRef(name.data(), name.size()),
-            rapidjson::Value(data, static_cast<unsigned int>(size), allocator), allocator);
+        copy(string_view(data, size));
     }
 
     auto operator()(const attribute::view_t::function_type& value) -> void {
         writer_t wr;
         value(wr);
 
-        node.AddMember(rapidjson::StringRef(name.data(), name.size()),
-            wr.result().to_string(), allocator);
+        copy(wr.result());
+    }
+
+private:
+    /// Copies the given string into the document, replacing invalid UTF-8 sequences.
+    auto copy(const string_view& value) -> void {
+        if (detail::formatter::json::validate(value) == value.size()) {
+            node.AddMember(rapidjson::StringRef(name.data(), name.size()),
+                rapidjson::Value(value.data(), static_cast<unsigned int>(value.size()), allocator),
+                allocator);
+        } else {
+            const auto sanitized = detail::formatter::json::sanitize(value);
+            node.AddMember(rapidjson::StringRef(name.data(), name.size()),
+                rapidjson::Value(sanitized.data(), static_cast<unsigned int>(sanitized.size()),
+                    allocator),
+                allocator);
+        }
     }
 };
 
+/// Writes the given finite double exactly like RapidJSON writer does.
+auto real(double value, writer_t& wr) -> void {
+    char buffer[25];
+    const auto end = rapidjson::internal::dtoa(value, buffer);
+    wr.inner << fmt::StringRef(buffer, static_cast<std::size_t>(end - buffer));
+}
+
 /// A RapidJSON Stream concept implementation required to avoid intermediate buffer allocation.
-struct stream_t {
+///
+/// Characters are collected into a small on-stack chunk, which is appended to the underlying
+/// buffer in bulk when filled, instead of writing them one-by-one.
+class stream_t {
+public:
     typedef char Ch;
 
+private:
     writer_t& wr;
 
-    /// Writes a character directly into the underlying buffer.
-    // TODO: Seems like writing string one-by-one affects the performance. See similar benchmarks
-    // that differs only with input string length.
+    std::array<Ch, 512> chunk;
+    std::size_t size;
+
+public:
+    explicit stream_t(writer_t& wr) noexcept :
+        wr(wr),
+        size(0)
+    {}
+
+    stream_t(const stream_t& other) = delete;
+    auto operator=(const stream_t& other) -> stream_t& = delete;
+
     auto Put(Ch c) -> void {
-        wr.inner << c;
+        if (size == chunk.size()) {
+            Flush();
+        }
+
+        chunk[size++] = c;
     }
 
-    /// Does nothing, because there is no intermediate buffer.
-    auto Flush() -> void {}
+    /// Writes the chunk into the underlying buffer.
+    auto Flush() -> void {
+        wr.inner << fmt::StringRef(chunk.data(), size);
+        size = 0;
+    }
 };
-
 }  // namespace
 
 class json_t::properties_t {
 public:
     bool unique;
     bool newline;
+    bool streaming;
 
     std::function<void(const record_t::time_point& time, writer_t& wr)> timestamp;
     std::vector<std::string> severity;
@@ -112,7 +164,8 @@ public:
 
     properties_t() :
         unique(false),
-        newline(false)
+        newline(false),
+        streaming(false)
     {}
 };
 
@@ -127,12 +180,23 @@ public:
 
     std::unordered_map<std::string, std::string> mapping;
 
+    // Indexes over both routing and renaming maps keyed by views of their keys, which allows to
+    // look attribute names up without temporary strings construction.
+    std::unordered_map<string_view, rapidjson::Pointer*> routes;
+    std::unordered_map<string_view, string_view> renames;
+
     bool unique;
     bool newline;
 
     std::function<void(const record_t::time_point& time, writer_t& wr)> timestamp;
     std::vector<std::string> severity;
 
+    // Streaming serializer, which is used instead of building documents if enabled.
+    std::unique_ptr<detail::formatter::json::serializer_t> serializer;
+
+    // Output skeletons, which produce the document output of most records without building it.
+    std::unique_ptr<detail::formatter::json::skeleton_t> skeleton;
+
     inner_t(json_t::properties_t properties) :
         rest(properties.routing.unspecified),
         mapping(std::move(properties.mapping)),
@@ -146,18 +210,49 @@ public:
                 routing.insert({name, rapidjson::Pointer(route.first)});
             }
         }
+
+        for (auto& route : routing) {
+            routes.insert({string_view(route.first), &route.second});
+        }
+
+        for (const auto& rename : mapping) {
+            renames.insert({string_view(rename.first), string_view(rename.second)});
+        }
+
+        if (properties.streaming) {
+            serializer.reset(new detail::formatter::json::serializer_t({
+                std::move(properties.routing.specified),
+                std::move(properties.routing.unspecified),
+                mapping,
+                unique,
+                severity,
+                timestamp
+            }));
+        } else {
+            try {
+                skeleton.reset(new detail::formatter::json::skeleton_t({
+                    properties.routing.specified,
+                    properties.routing.unspecified,
+                    mapping,
+                    unique,
+                    severity,
+                    timestamp,
+                    &real
+                }));
+            } catch (const std::invalid_argument&) {
+                // Documents are built for all records then.
+            }
+        }
     }
 
     template<typename Document>
     auto get(const string_view& name, Document& root) -> rapidjson::Value& {
-        // TODO: Here we can avoid a temporary string construction by using multi indexed
-        // containers.
-        const auto it = routing.find(name.to_string());
+        const auto it = routes.find(name);
 
-        if (it == routing.end()) {
+        if (it == routes.end()) {
             return rest.GetWithDefault(root, rapidjson::kObjectType);
         } else {
-            return it->second.GetWithDefault(root, rapidjson::kObjectType);
+            return it->second->GetWithDefault(root, rapidjson::kObjectType);
         }
     }
 
@@ -165,9 +260,9 @@ public:
     auto create(Document& root, const record_t& record) -> builder<Document>;
 
     auto renamed(const string_view& name) const -> string_view {
-        const auto it = mapping.find(name.to_string());
+        const auto it = renames.find(name);
 
-        if (it == mapping.end()) {
+        if (it == renames.end()) {
             return name;
         } else {
             return it->second;
@@ -197,14 +292,23 @@ public:
     }
 
     auto thread() -> void {
-        writer_t wr;
-        // TODO: Encapsulate.
-#ifdef __linux__
-            wr.write("{:#x}", record.tid());
-#elif __APPLE__
-            wr.write("{:#x}", reinterpret_cast<unsigned long>(record.tid()));
-#endif
-        apply("thread", wr.inner.data(), wr.inner.size());
+        // The cached value stays valid until the document is serialized, because there are no
+        // other calls on this thread in between.
+        apply("thread", detail::this_thread::hex(record.tid()));
+    }
+
+    auto trace() -> void {
+        const auto& trace = record.trace();
+        if (trace.empty()) {
+            return;
+        }
+
+        char trace_id[32];
+        char span_id[16];
+        const auto trace_hex = detail::trace::trace_id(trace, trace_id);
+        const auto span_hex = detail::trace::span_id(trace, span_id);
+        apply("trace_id", trace_hex.data(), trace_hex.size());
+        apply("span_id", span_hex.data(), span_hex.size());
     }
 
     auto severity() -> void {
@@ -230,28 +334,24 @@ public:
     }
 
     auto build(writer_t& writer) -> void {
-        stream_t stream{writer};
+        stream_t stream(writer);
         rapidjson::Writer<stream_t> wr(stream);
         root.Accept(wr);
+
+        // Flushing is idempotent, which guarantees the last chunk to be written regardless of
+        // whether RapidJSON flushes on completion.
+        stream.Flush();
     }
 
     auto attributes() -> void {
         if (inner.unique) {
-            // TODO: Small buffer optimization is possible here (see stack allocator with arena).
-            std::set<string_view> set;
-
-            for (const auto& attributes : record.attributes()) {
-                for (const auto& attribute : attributes.get()) {
-                    if (set.insert(attribute.first).second) {
-                        apply(attribute.first, attribute.second);
-                    }
-                }
+            for (const auto& attribute : record.unique_attributes()) {
+                apply(attribute.first, attribute.second);
             }
+
             return;
         }
 
-        // TODO: Make flattened range
-        // TODO: Make uniqued range.
         for (const auto& attributes : record.attributes()) {
             for (const auto& attribute : attributes.get()) {
                 apply(attribute.first, attribute.second);
@@ -303,7 +403,29 @@ auto json_t::unique() const noexcept -> bool {
     return inner->unique;
 }
 
+auto json_t::streaming() const noexcept -> bool {
+    return inner->serializer != nullptr;
+}
+
 auto json_t::format(const record_t& record, writer_t& writer) -> void {
+    if (inner->serializer) {
+        inner->serializer->format(record, writer);
+
+        if (inner->newline) {
+            writer.inner << '\n';
+        }
+
+        return;
+    }
+
+    if (inner->skeleton && inner->skeleton->format(record, writer)) {
+        if (inner->newline) {
+            writer.inner << '\n';
+        }
+
+        return;
+    }
+
     typedef rapidjson::GenericDocument<
         rapidjson::UTF8<>,
         rapidjson::MemoryPoolAllocator<>,
@@ -318,12 +440,11 @@ auto json_t::format(const record_t& record, writer_t& writer) -> void {
     document_type root(&value_allocator, parse_buffer.size(), &parse_allocator);
     root.SetObject();
 
-    // TODO: Try to use `AutoUTF<>` or `AutoUTFOutputStream` for UTF-8 validation.
-
     auto builder = inner->create(root, record);
     builder.message();
     builder.thread();
     builder.process();
+    builder.trace();
     builder.severity();
     builder.timestamp();
     builder.attributes();
@@ -394,6 +515,15 @@ auto builder<json_t>::newline() && -> builder&& {
     return std::move(*this);
 }
 
+auto builder<json_t>::streaming() & -> builder& {
+    d->streaming = true;
+    return *this;
+}
+
+auto builder<json_t>::streaming() && -> builder&& {
+    return std::move(streaming());
+}
+
 auto builder<json_t>::severity(std::vector<std::string> sevmap) & -> builder& {
     d->severity = std::move(sevmap);
     return *this;
@@ -413,10 +543,11 @@ auto builder<json_t>::timestamp(const std::string& pattern) & -> builder& {
             std::chrono::microseconds
         >(timestamp.time_since_epoch()).count() % 1000000;
 
-        std::tm tm;
-        ::gmtime_r(&time, &tm);
+        thread_local detail::datetime::cache_t cache;
 
-        generator(wr.inner, tm, static_cast<std::uint64_t>(usec));
+        const auto& value = cache.format(pattern, generator, true, time,
+            static_cast<std::uint64_t>(usec));
+        wr.inner << fmt::StringRef(value.data(), value.size());
     };
 
     return *this;
@@ -451,6 +582,12 @@ auto factory<json_t>::from(const config::node_t& config) const ->
         }
     }
 
+    if (auto streaming = config["streaming"].to_bool()) {
+        if (streaming.get()) {
+            builder.streaming();
+        }
+    }
+
     if (auto mapping = config["mapping"]) {
         mapping.each_map([&](const std::string& key, const config::node_t& value) {
             builder.rename(key, value.to_string());
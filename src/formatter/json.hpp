@@ -27,6 +27,10 @@ public:
     /// Returns true if the filtering policy is enabled.
     auto unique() const noexcept -> bool;
 
+    /// Returns true if records are serialized directly into the writer without building an
+    /// intermediate JSON document.
+    auto streaming() const noexcept -> bool;
+
     /// Formats the given record by constructing a JSON tree with further serializing into the
     /// specified writer.
     ///
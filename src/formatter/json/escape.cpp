@@ -0,0 +1,326 @@
+#include "blackhole/detail/formatter/json/escape.hpp"
+
+#include <cstdint>
+#include <cstring>
+
+#include "blackhole/detail/simd.hpp"
+
+#if defined(BLACKHOLE_SIMD_X86)
+#include <immintrin.h>
+#elif defined(BLACKHOLE_SIMD_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace blackhole {
+inline namespace v1 {
+namespace detail {
+namespace formatter {
+namespace json {
+namespace {
+
+constexpr std::uint64_t ones = ~std::uint64_t(0) / 255;
+constexpr std::uint64_t highs = ones * 128;
+
+/// UTF-8 encoded U+FFFD replacement character.
+constexpr char replacement_character[] = "\xef\xbf\xbd";
+
+/// Checks whether any byte of the given word is less than the given value, which must not
+/// exceed 128.
+constexpr auto has_less(std::uint64_t word, std::uint64_t value) noexcept -> bool {
+    return ((word - ones * value) & ~word & highs) != 0;
+}
+
+/// Checks whether any byte of the given word equals to the given value.
+constexpr auto has_byte(std::uint64_t word, std::uint64_t value) noexcept -> bool {
+    return has_less(word ^ (ones * value), 1);
+}
+
+/// Checks whether none of the word bytes require either escaping or UTF-8 validation.
+constexpr auto is_clean(std::uint64_t word) noexcept -> bool {
+    return (word & highs) == 0 && !has_less(word, 0x20) && !has_byte(word, '"') &&
+        !has_byte(word, '\\');
+}
+
+constexpr auto is_clean(unsigned char ch) noexcept -> bool {
+    return ch >= 0x20 && ch < 0x80 && ch != '"' && ch != '\\';
+}
+
+/// Continues scanning for bytes that require either escaping or UTF-8 validation from the given
+/// position, a word at a time.
+auto tail(const char* data, std::size_t size, std::size_t pos) noexcept -> std::size_t {
+    for (; pos + sizeof(std::uint64_t) <= size; pos += sizeof(std::uint64_t)) {
+        std::uint64_t word;
+        std::memcpy(&word, data + pos, sizeof(word));
+
+        if (!is_clean(word)) {
+            break;
+        }
+    }
+
+    while (pos < size && is_clean(static_cast<unsigned char>(data[pos]))) {
+        ++pos;
+    }
+
+    return pos;
+}
+
+auto scan_scalar(const char* data, std::size_t size) noexcept -> std::size_t {
+    return tail(data, size, 0);
+}
+
+// Bytes are compared as signed ones, so that both control and non-ASCII ones are less than the
+// space.
+#if defined(BLACKHOLE_SIMD_X86)
+BLACKHOLE_TARGET_SSE2
+auto scan_sse2(const char* data, std::size_t size) noexcept -> std::size_t {
+    const auto space = _mm_set1_epi8(0x20);
+    const auto quote = _mm_set1_epi8('"');
+    const auto backslash = _mm_set1_epi8('\\');
+
+    std::size_t pos = 0;
+    for (; pos + 16 <= size; pos += 16) {
+        const auto chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+        const auto special = _mm_or_si128(_mm_cmplt_epi8(chunk, space),
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash)));
+
+        if (const auto mask = static_cast<unsigned int>(_mm_movemask_epi8(special))) {
+            return pos + static_cast<std::size_t>(__builtin_ctz(mask));
+        }
+    }
+
+    return tail(data, size, pos);
+}
+
+BLACKHOLE_TARGET_AVX2
+auto scan_avx2(const char* data, std::size_t size) noexcept -> std::size_t {
+    const auto space = _mm256_set1_epi8(0x20);
+    const auto quote = _mm256_set1_epi8('"');
+    const auto backslash = _mm256_set1_epi8('\\');
+
+    std::size_t pos = 0;
+    for (; pos + 32 <= size; pos += 32) {
+        const auto chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos));
+        const auto special = _mm256_or_si256(_mm256_cmpgt_epi8(space, chunk),
+            _mm256_or_si256(_mm256_cmpeq_epi8(chunk, quote), _mm256_cmpeq_epi8(chunk, backslash)));
+
+        if (const auto mask = static_cast<unsigned int>(_mm256_movemask_epi8(special))) {
+            return pos + static_cast<std::size_t>(__builtin_ctz(mask));
+        }
+    }
+
+    return tail(data, size, pos);
+}
+
+BLACKHOLE_TARGET_AVX512
+auto scan_avx512(const char* data, std::size_t size) noexcept -> std::size_t {
+    const auto space = _mm512_set1_epi8(0x20);
+    const auto quote = _mm512_set1_epi8('"');
+    const auto backslash = _mm512_set1_epi8('\\');
+
+    std::size_t pos = 0;
+    for (; pos + 64 <= size; pos += 64) {
+        const auto chunk = _mm512_loadu_si512(data + pos);
+        const auto mask = _mm512_cmpgt_epi8_mask(space, chunk) |
+            _mm512_cmpeq_epi8_mask(chunk, quote) | _mm512_cmpeq_epi8_mask(chunk, backslash);
+
+        if (mask != 0) {
+            return pos + static_cast<std::size_t>(__builtin_ctzll(mask));
+        }
+    }
+
+    return tail(data, size, pos);
+}
+#endif
+
+#if defined(BLACKHOLE_SIMD_NEON)
+auto scan_neon(const char* data, std::size_t size) noexcept -> std::size_t {
+    const auto space = vdupq_n_s8(0x20);
+    const auto quote = vdupq_n_u8('"');
+    const auto backslash = vdupq_n_u8('\\');
+
+    std::size_t pos = 0;
+    for (; pos + 16 <= size; pos += 16) {
+        const auto chunk = vld1q_u8(reinterpret_cast<const std::uint8_t*>(data + pos));
+        const auto special = vorrq_u8(vcltq_s8(vreinterpretq_s8_u8(chunk), space),
+            vorrq_u8(vceqq_u8(chunk, quote), vceqq_u8(chunk, backslash)));
+
+        if (vmaxvq_u8(special) != 0) {
+            break;
+        }
+    }
+
+    return tail(data, size, pos);
+}
+#endif
+
+/// Returns the number of leading bytes that require neither escaping nor UTF-8 validation.
+simd::kernel_t<std::size_t(const char*, std::size_t)> scan(
+    &scan_scalar,
+    BLACKHOLE_SIMD_X86_VARIANT(scan_sse2),
+    BLACKHOLE_SIMD_X86_VARIANT(scan_avx2),
+    BLACKHOLE_SIMD_X86_VARIANT(scan_avx512),
+    BLACKHOLE_SIMD_NEON_VARIANT(scan_neon));
+
+/// Returns the length of a valid UTF-8 encoded non-ASCII character at the beginning of the given
+/// data or zero if there is none, rejecting overlong forms, surrogates and code points beyond
+/// U+10FFFF.
+auto sequence(const char* data, std::size_t size) noexcept -> std::size_t {
+    const auto at = [&](std::size_t id) -> unsigned int {
+        return static_cast<unsigned char>(data[id]);
+    };
+
+    const auto continuation = [&](std::size_t id) -> bool {
+        return (at(id) & 0xc0) == 0x80;
+    };
+
+    const auto lead = at(0);
+
+    if (lead >= 0xc2 && lead <= 0xdf) {
+        return size >= 2 && continuation(1) ? 2 : 0;
+    }
+
+    if (lead >= 0xe0 && lead <= 0xef) {
+        if (size < 3 || !continuation(1) || !continuation(2)) {
+            return 0;
+        }
+
+        if ((lead == 0xe0 && at(1) < 0xa0) || (lead == 0xed && at(1) > 0x9f)) {
+            return 0;
+        }
+
+        return 3;
+    }
+
+    if (lead >= 0xf0 && lead <= 0xf4) {
+        if (size < 4 || !continuation(1) || !continuation(2) || !continuation(3)) {
+            return 0;
+        }
+
+        if ((lead == 0xf0 && at(1) < 0x90) || (lead == 0xf4 && at(1) > 0x8f)) {
+            return 0;
+        }
+
+        return 4;
+    }
+
+    return 0;
+}
+
+auto replacement(unsigned char ch) noexcept -> char {
+    switch (ch) {
+    case '"':
+        return '"';
+    case '\\':
+        return '\\';
+    case '\b':
+        return 'b';
+    case '\f':
+        return 'f';
+    case '\n':
+        return 'n';
+    case '\r':
+        return 'r';
+    case '\t':
+        return 't';
+    default:
+        return 'u';
+    }
+}
+
+}  // namespace
+
+auto escape(const string_view& value, writer_t& writer) -> void {
+    static const char hex[] = "0123456789ABCDEF";
+
+    const auto data = value.data();
+    const auto size = value.size();
+
+    std::size_t run = 0;
+    std::size_t pos = 0;
+
+    while (true) {
+        pos += scan(data + pos, size - pos);
+
+        if (pos == size) {
+            break;
+        }
+
+        const auto ch = static_cast<unsigned char>(data[pos]);
+
+        if (ch >= 0x80) {
+            if (const auto length = sequence(data + pos, size - pos)) {
+                pos += length;
+                continue;
+            }
+
+            writer.inner << fmt::StringRef(data + run, pos - run);
+            writer.inner << fmt::StringRef(replacement_character, sizeof(replacement_character) - 1);
+            run = ++pos;
+            continue;
+        }
+
+        writer.inner << fmt::StringRef(data + run, pos - run);
+
+        const auto esc = replacement(ch);
+        if (esc == 'u') {
+            const char seq[] = {'\\', 'u', '0', '0', hex[ch >> 4], hex[ch & 0xf]};
+            writer.inner << fmt::StringRef(seq, sizeof(seq));
+        } else {
+            const char seq[] = {'\\', esc};
+            writer.inner << fmt::StringRef(seq, sizeof(seq));
+        }
+
+        run = ++pos;
+    }
+
+    writer.inner << fmt::StringRef(data + run, size - run);
+}
+
+auto validate(const string_view& value) noexcept -> std::size_t {
+    const auto data = value.data();
+    const auto size = value.size();
+
+    std::size_t pos = 0;
+
+    while (true) {
+        pos += scan(data + pos, size - pos);
+
+        if (pos == size) {
+            return pos;
+        }
+
+        if (static_cast<unsigned char>(data[pos]) < 0x80) {
+            // Characters requiring escaping are valid UTF-8 anyway.
+            ++pos;
+        } else if (const auto length = sequence(data + pos, size - pos)) {
+            pos += length;
+        } else {
+            return pos;
+        }
+    }
+}
+
+auto sanitize(const string_view& value) -> std::string {
+    std::string result;
+    result.reserve(value.size());
+
+    string_view rest = value;
+
+    while (true) {
+        const auto pos = validate(rest);
+        result.append(rest.data(), pos);
+
+        if (pos == rest.size()) {
+            return result;
+        }
+
+        result.append(replacement_character, sizeof(replacement_character) - 1);
+        rest = string_view(rest.data() + pos + 1, rest.size() - pos - 1);
+    }
+}
+
+}  // namespace json
+}  // namespace formatter
+}  // namespace detail
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,302 @@
+#include "blackhole/detail/formatter/json/serializer.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <boost/container/small_vector.hpp>
+#include <boost/variant/apply_visitor.hpp>
+
+#include "blackhole/attribute.hpp"
+
+#include "blackhole/detail/attribute.hpp"
+#include "blackhole/detail/formatter/json/value.hpp"
+#include "blackhole/detail/process.hpp"
+#include "blackhole/detail/trace.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace detail {
+namespace formatter {
+namespace json {
+namespace {
+
+typedef fmt::StringRef string_ref;
+
+/// Writes the given finite double if it's exactly the nearest one to a decimal with up to 15
+/// significant digits in fixed notation, returning false otherwise.
+///
+/// The output is the same as "%.15g" produces, because at most one such decimal rounds to each
+/// double, but requires neither formatting nor parsing it back.
+auto write_short(double value, writer_t& writer) -> bool {
+    static const double powers[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15
+    };
+
+    const auto magnitude = std::fabs(value);
+
+    // The "%g" conversion switches to exponent notation below 1e-4.
+    if ((magnitude != 0.0 && magnitude < 1e-4) || magnitude >= 1e15) {
+        return false;
+    }
+
+    for (std::size_t id = 0; id < sizeof(powers) / sizeof(powers[0]); ++id) {
+        const auto scaled = magnitude * powers[id];
+
+        if (scaled >= 1e15) {
+            return false;
+        }
+
+        // Both operands of the division are exact, so it's correctly rounded the same way parsing
+        // the decimal is.
+        if (scaled != std::floor(scaled) || scaled / powers[id] != magnitude) {
+            continue;
+        }
+
+        auto digits = static_cast<std::uint64_t>(scaled);
+        auto scale = id;
+        while (scale > 0 && digits % 10 == 0) {
+            digits /= 10;
+            --scale;
+        }
+
+        const fmt::FormatInt formatted(digits);
+        const auto size = formatted.size();
+
+        if (std::signbit(value)) {
+            writer.inner << '-';
+        }
+
+        if (scale == 0) {
+            writer.inner << string_ref(formatted.data(), size) << string_ref(".0", 2);
+        } else if (size > scale) {
+            writer.inner << string_ref(formatted.data(), size - scale) << '.'
+                << string_ref(formatted.data() + size - scale, scale);
+        } else {
+            writer.inner << string_ref("0.000", 2 + scale - size)
+                << string_ref(formatted.data(), size);
+        }
+
+        return true;
+    }
+
+    return false;
+}
+
+/// Writes a double using the shortest representation that survives the round trip, always keeping
+/// it distinguishable from integers like RapidJSON does.
+auto write(double value, writer_t& writer) -> void {
+    // Neither NaN nor infinities are representable in JSON.
+    if (!std::isfinite(value)) {
+        writer.inner << string_ref("null", 4);
+        return;
+    }
+
+    if (write_short(value, writer)) {
+        return;
+    }
+
+    char buffer[32];
+    int size = 0;
+
+    for (int precision = 15; precision <= 17; ++precision) {
+        size = std::snprintf(buffer, sizeof(buffer), "%.*g", precision, value);
+
+        if (std::strtod(buffer, nullptr) == value) {
+            break;
+        }
+    }
+
+    writer.inner << string_ref(buffer, static_cast<std::size_t>(size));
+
+    if (std::strpbrk(buffer, ".e") == nullptr) {
+        writer.inner << string_ref(".0", 2);
+    }
+}
+
+/// Writes doubles of attribute values.
+struct real_t {
+    auto operator()(double value, writer_t& writer) const -> void {
+        write(value, writer);
+    }
+};
+
+}  // namespace
+
+class serializer_t::frame_t {
+public:
+    enum class kind_t : std::uint8_t {
+        /// The text is an attribute name, which requires escaping.
+        attribute,
+        /// The text is a precomputed key.
+        field,
+        /// The text is a precomputed member, the value is not used.
+        member
+    };
+
+    struct entry_t {
+        std::uint32_t node;
+        kind_t kind;
+        string_view text;
+        attribute::view_t value;
+    };
+
+    boost::container::small_vector<entry_t, 32> entries;
+
+    /// Marks objects having at least one member in their subtree.
+    boost::container::small_vector<bool, 16> used;
+};
+
+serializer_t::serializer_t(properties_t properties) :
+    layout(properties.routing, properties.rest, properties.mapping),
+    unique(properties.unique),
+    timestamp_(std::move(properties.timestamp))
+{
+    const char* names[builtins] = {
+        "message", "thread", "process", "severity", "timestamp", "trace_id", "span_id"
+    };
+    for (std::uint32_t id = 0; id < builtins; ++id) {
+        const string_view name(names[id], std::strlen(names[id]));
+
+        fields[id].node = layout.node_of(name);
+        fields[id].key = key_of(layout.renamed(name));
+    }
+
+    for (const auto& severity : properties.severity) {
+        writer_t writer;
+        writer.inner << fmt::StringRef(fields[builtin_t::severity].key);
+        write_string(severity, writer);
+        severities.emplace_back(writer.result().to_string());
+    }
+}
+
+auto serializer_t::format(const record_t& record, writer_t& writer) const -> void {
+    frame_t frame;
+
+    typedef frame_t::kind_t kind_t;
+
+    const auto add = [&](const route_t& route, attribute::view_t value) {
+        frame.entries.push_back({route.node, kind_t::field, route.key, value});
+    };
+
+    add(fields[message], record.formatted());
+    add(fields[thread], this_thread::hex(record.tid()));
+    add(fields[process], record.pid());
+
+    const auto sev = static_cast<std::size_t>(record.severity());
+    if (sev < severities.size()) {
+        frame.entries.push_back({fields[severity].node, kind_t::member, severities[sev], {}});
+    } else {
+        add(fields[severity], static_cast<std::int64_t>(record.severity()));
+    }
+
+    // Uses an inline buffer, which is large enough to require no allocation.
+    writer_t time;
+    if (timestamp_) {
+        timestamp_(record.timestamp(), time);
+        add(fields[timestamp], time.result());
+    } else {
+        add(fields[timestamp], static_cast<std::int64_t>(std::chrono::duration_cast<
+            std::chrono::microseconds
+        >(record.timestamp().time_since_epoch()).count()));
+    }
+
+    // Hex digits of the trace context, which is present only if the trace id is set.
+    char trace_hex[32];
+    char span_hex[16];
+    if (!record.trace().empty()) {
+        add(fields[trace_id], detail::trace::trace_id(record.trace(), trace_hex));
+        add(fields[span_id], detail::trace::span_id(record.trace(), span_hex));
+    }
+
+    const auto push = [&](const view_of<attribute_t>::type& attribute) {
+        frame.entries.push_back({
+            layout.node_of(attribute.first),
+            kind_t::attribute,
+            layout.renamed(attribute.first),
+            attribute.second
+        });
+    };
+
+    if (unique) {
+        for (const auto& item : record.unique_attributes()) {
+            push(item);
+        }
+    } else {
+        for (const auto& list : record.attributes()) {
+            for (const auto& item : list.get()) {
+                push(item);
+            }
+        }
+    }
+
+    const auto& nodes = layout.nodes();
+
+    frame.used.assign(nodes.size(), false);
+    for (const auto& entry : frame.entries) {
+        for (auto id = entry.node; !frame.used[id]; id = nodes[id].parent) {
+            frame.used[id] = true;
+        }
+    }
+
+    write(frame, 0, writer);
+}
+
+auto serializer_t::write(const frame_t& frame, std::uint32_t id, writer_t& writer) const -> void {
+    writer.inner << '{';
+
+    bool first = true;
+    const auto separate = [&] {
+        if (first) {
+            first = false;
+        } else {
+            writer.inner << ',';
+        }
+    };
+
+    const real_t real{};
+    const value_visitor_t<real_t> visitor(writer, real);
+
+    for (const auto& entry : frame.entries) {
+        if (entry.node != id) {
+            continue;
+        }
+
+        separate();
+
+        switch (entry.kind) {
+        case frame_t::kind_t::attribute:
+            write_string(entry.text, writer);
+            writer.inner << ':';
+            break;
+        case frame_t::kind_t::field:
+        case frame_t::kind_t::member:
+            writer.inner << string_ref(entry.text.data(), entry.text.size());
+            break;
+        }
+
+        if (entry.kind != frame_t::kind_t::member) {
+            boost::apply_visitor(visitor, entry.value.inner().value);
+        }
+    }
+
+    const auto& nodes = layout.nodes();
+
+    for (auto child : nodes[id].children) {
+        if (frame.used[child]) {
+            separate();
+            write_string(nodes[child].name, writer);
+            writer.inner << ':';
+            write(frame, child, writer);
+        }
+    }
+
+    writer.inner << '}';
+}
+
+}  // namespace json
+}  // namespace formatter
+}  // namespace detail
+}  // namespace v1
+}  // namespace blackhole
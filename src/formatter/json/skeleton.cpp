@@ -0,0 +1,322 @@
+#include "blackhole/detail/formatter/json/skeleton.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+#include <boost/container/small_vector.hpp>
+#include <boost/variant/apply_visitor.hpp>
+#include <boost/variant/get.hpp>
+
+#include "blackhole/attribute.hpp"
+
+#include "blackhole/detail/attribute.hpp"
+#include "blackhole/detail/formatter/json/escape.hpp"
+#include "blackhole/detail/formatter/json/value.hpp"
+#include "blackhole/detail/process.hpp"
+#include "blackhole/detail/trace.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace detail {
+namespace formatter {
+namespace json {
+namespace {
+
+typedef fmt::StringRef string_ref;
+
+/// Returns the given name if it's valid UTF-8.
+///
+/// \throw std::invalid_argument if the name is not valid UTF-8, which the document writes as is.
+auto validated(const string_view& name) -> string_view {
+    if (validate(name) != name.size()) {
+        throw std::invalid_argument("JSON key is not valid UTF-8: \"" + name.to_string() + "\"");
+    }
+
+    return name;
+}
+
+}  // namespace
+
+class skeleton_t::frame_t {
+public:
+    struct entry_t {
+        std::uint32_t node;
+        string_view name;
+        attribute::view_t value;
+    };
+
+    const record_t& record;
+
+    boost::container::small_vector<entry_t, 32> entries;
+
+    /// Formatted timestamp and hex digits of the trace context, if any.
+    string_view time;
+    string_view trace;
+    string_view span;
+
+    explicit frame_t(const record_t& record) noexcept :
+        record(record)
+    {}
+};
+
+skeleton_t::skeleton_t(properties_t properties) :
+    layout(properties.routing, properties.rest, properties.mapping),
+    unique(properties.unique),
+    timestamp_(std::move(properties.timestamp)),
+    real(std::move(properties.real))
+{
+    // The document treats such tokens as array indices.
+    for (const auto& node : layout.nodes()) {
+        const auto& name = node.name;
+
+        if (!name.empty() && std::all_of(name.begin(), name.end(), [](char ch) {
+            return ch >= '0' && ch <= '9';
+        })) {
+            throw std::invalid_argument("JSON pointer has an array index token: \"" + name + "\"");
+        }
+    }
+
+    for (std::size_t id = 0; id <= properties.severity.size(); ++id) {
+        outlines.push_back(outline(properties.severity, id, false));
+        outlines.push_back(outline(properties.severity, id, true));
+    }
+}
+
+auto skeleton_t::outline(const std::vector<std::string>& sevmap, std::size_t id, bool traced)
+    const -> outline_t
+{
+    const char* names[builtins] = {
+        "message", "thread", "process", "trace_id", "span_id", "severity", "timestamp"
+    };
+
+    const auto& nodes = layout.nodes();
+
+    struct item_t {
+        bool child;
+        std::uint32_t id;
+    };
+
+    // Simulates insertion of builtin fields, where the document creates objects on their first use
+    // appending them to their parents.
+    std::vector<std::vector<item_t>> items(nodes.size());
+
+    outline_t result;
+    result.created.assign(nodes.size(), false);
+    result.created[0] = true;
+
+    const std::function<void(std::uint32_t)> create = [&](std::uint32_t node) {
+        if (result.created[node]) {
+            return;
+        }
+
+        create(nodes[node].parent);
+        items[nodes[node].parent].push_back({true, node});
+        result.created[node] = true;
+    };
+
+    for (std::uint32_t field = 0; field < builtins; ++field) {
+        if (!traced && (field == trace_id || field == span_id)) {
+            continue;
+        }
+
+        const auto node = layout.node_of(string_view(names[field], std::strlen(names[field])));
+        create(node);
+        items[node].push_back({false, field});
+    }
+
+    // The document would replace a builtin member with an object of the same name.
+    for (std::uint32_t node = 0; node < nodes.size(); ++node) {
+        for (const auto& item : items[node]) {
+            if (item.child) {
+                continue;
+            }
+
+            const auto name = layout.renamed(string_view(names[item.id],
+                std::strlen(names[item.id])));
+
+            for (const auto& other : items[node]) {
+                if (other.child && string_view(nodes[other.id].name) == name) {
+                    throw std::invalid_argument("JSON object clashes with a builtin field: \"" +
+                        nodes[other.id].name + "\"");
+                }
+            }
+        }
+    }
+
+    std::string text;
+
+    const std::function<void(std::uint32_t)> render = [&](std::uint32_t node) {
+        text.push_back('{');
+
+        bool first = true;
+        for (const auto& item : items[node]) {
+            if (!first) {
+                text.push_back(',');
+            }
+            first = false;
+
+            if (item.child) {
+                text += key_of(validated(nodes[item.id].name));
+                render(item.id);
+                continue;
+            }
+
+            const auto name = layout.renamed(string_view(names[item.id],
+                std::strlen(names[item.id])));
+            text += key_of(validated(name));
+
+            if (item.id == severity && id > 0) {
+                writer_t writer;
+                write_string(sevmap[id - 1], writer);
+                text += writer.result().to_string();
+                continue;
+            }
+
+            result.ops.push_back({std::move(text), op_t::slot_t::field, item.id});
+            text.clear();
+        }
+
+        // Each created object holds at least one builtin field, so attributes always follow a
+        // member.
+        result.ops.push_back({std::move(text), op_t::slot_t::attributes, node});
+        text.clear();
+        text.push_back('}');
+    };
+
+    render(0);
+    result.ops.push_back({std::move(text), op_t::slot_t::none, 0});
+
+    return result;
+}
+
+auto skeleton_t::format(const record_t& record, writer_t& writer) const -> bool {
+    frame_t frame(record);
+
+    const auto sev = static_cast<std::size_t>(record.severity());
+    const auto traced = !record.trace().empty();
+    const auto mapped = sev < outlines.size() / 2 - 1 ? sev + 1 : 0;
+    const auto& outline = outlines[mapped * 2 + (traced ? 1 : 0)];
+
+    const auto push = [&](const view_of<attribute_t>::type& attribute) -> bool {
+        const auto node = layout.node_of(attribute.first);
+        if (!outline.created[node]) {
+            return false;
+        }
+
+        const auto name = layout.renamed(attribute.first);
+        if (validate(name) != name.size()) {
+            return false;
+        }
+
+        // The document serializer stops writing on non-finite doubles.
+        if (auto value = boost::get<double>(&attribute.second.inner().value)) {
+            if (!std::isfinite(*value)) {
+                return false;
+            }
+        }
+
+        frame.entries.push_back({node, name, attribute.second});
+        return true;
+    };
+
+    if (unique) {
+        for (const auto& item : record.unique_attributes()) {
+            if (!push(item)) {
+                return false;
+            }
+        }
+    } else {
+        for (const auto& list : record.attributes()) {
+            for (const auto& item : list.get()) {
+                if (!push(item)) {
+                    return false;
+                }
+            }
+        }
+    }
+
+    // Uses an inline buffer, which is large enough to require no allocation.
+    writer_t time;
+    if (timestamp_) {
+        timestamp_(record.timestamp(), time);
+        frame.time = time.result();
+    }
+
+    char trace_hex[32];
+    char span_hex[16];
+    if (traced) {
+        frame.trace = detail::trace::trace_id(record.trace(), trace_hex);
+        frame.span = detail::trace::span_id(record.trace(), span_hex);
+    }
+
+    for (const auto& op : outline.ops) {
+        write(frame, op, writer);
+    }
+
+    return true;
+}
+
+auto skeleton_t::write(const frame_t& frame, const op_t& op, writer_t& writer) const -> void {
+    writer.inner << string_ref(op.text.data(), op.text.size());
+
+    const value_visitor_t<real_type> visitor(writer, real);
+    const auto& record = frame.record;
+
+    switch (op.slot) {
+    case op_t::slot_t::field:
+        switch (op.id) {
+        case message:
+            write_string(record.formatted(), writer);
+            break;
+        case thread:
+            write_string(this_thread::hex(record.tid()), writer);
+            break;
+        case process:
+            visitor(record.pid());
+            break;
+        case trace_id:
+            write_string(frame.trace, writer);
+            break;
+        case span_id:
+            write_string(frame.span, writer);
+            break;
+        case severity:
+            visitor(static_cast<std::int64_t>(record.severity()));
+            break;
+        case timestamp:
+            if (timestamp_) {
+                write_string(frame.time, writer);
+            } else {
+                visitor(static_cast<std::int64_t>(std::chrono::duration_cast<
+                    std::chrono::microseconds
+                >(record.timestamp().time_since_epoch()).count()));
+            }
+            break;
+        default:
+            break;
+        }
+        break;
+    case op_t::slot_t::attributes:
+        for (const auto& entry : frame.entries) {
+            if (entry.node != op.id) {
+                continue;
+            }
+
+            writer.inner << ',';
+            write_string(entry.name, writer);
+            writer.inner << ':';
+            boost::apply_visitor(visitor, entry.value.inner().value);
+        }
+        break;
+    case op_t::slot_t::none:
+        break;
+    }
+}
+
+}  // namespace json
+}  // namespace formatter
+}  // namespace detail
+}  // namespace v1
+}  // namespace blackhole
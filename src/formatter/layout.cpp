@@ -0,0 +1,127 @@
+#include "blackhole/detail/formatter/layout.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace blackhole {
+inline namespace v1 {
+namespace detail {
+namespace formatter {
+
+layout_t::layout_t(const std::map<std::string, std::vector<std::string>>& routing,
+    const std::string& rest,
+    const std::unordered_map<std::string, std::string>& mapping) :
+    nodes_{{std::string(), 0, {}}},
+    mapping(mapping.begin(), mapping.end())
+{
+    for (const auto& route : routing) {
+        const auto id = node(route.first);
+
+        for (const auto& name : route.second) {
+            routes.emplace_back(name, id);
+        }
+    }
+
+    this->rest = node(rest);
+
+    // Stable sorting preserves the first-wins semantics of the document-based formatter on
+    // conflicting routes.
+    std::stable_sort(routes.begin(), routes.end(), [](
+        const std::pair<std::string, std::uint32_t>& lhs,
+        const std::pair<std::string, std::uint32_t>& rhs)
+    {
+        return lhs.first < rhs.first;
+    });
+
+    std::sort(this->mapping.begin(), this->mapping.end());
+}
+
+auto layout_t::nodes() const noexcept -> const std::vector<node_t>& {
+    return nodes_;
+}
+
+auto layout_t::node(const std::string& pointer) -> std::uint32_t {
+    if (pointer.empty()) {
+        return 0;
+    }
+
+    if (pointer.front() != '/') {
+        throw std::invalid_argument("JSON pointer must start with '/': \"" + pointer + "\"");
+    }
+
+    std::uint32_t current = 0;
+
+    auto pos = pointer.begin() + 1;
+    while (true) {
+        std::string token;
+
+        for (; pos != pointer.end() && *pos != '/'; ++pos) {
+            if (*pos != '~') {
+                token.push_back(*pos);
+                continue;
+            }
+
+            ++pos;
+            if (pos != pointer.end() && *pos == '0') {
+                token.push_back('~');
+            } else if (pos != pointer.end() && *pos == '1') {
+                token.push_back('/');
+            } else {
+                throw std::invalid_argument("invalid escape sequence in JSON pointer: \"" + pointer + "\"");
+            }
+        }
+
+        const auto& children = nodes_[current].children;
+        const auto it = std::find_if(children.begin(), children.end(), [&](std::uint32_t id) {
+            return nodes_[id].name == token;
+        });
+
+        if (it == children.end()) {
+            const auto id = static_cast<std::uint32_t>(nodes_.size());
+            nodes_.push_back({std::move(token), current, {}});
+            nodes_[current].children.push_back(id);
+            current = id;
+        } else {
+            current = *it;
+        }
+
+        if (pos == pointer.end()) {
+            return current;
+        }
+
+        ++pos;
+    }
+}
+
+auto layout_t::node_of(const string_view& name) const noexcept -> std::uint32_t {
+    const auto it = std::lower_bound(routes.begin(), routes.end(), name, [](
+        const std::pair<std::string, std::uint32_t>& route, const string_view& name)
+    {
+        return string_view(route.first) < name;
+    });
+
+    if (it != routes.end() && string_view(it->first) == name) {
+        return it->second;
+    }
+
+    return rest;
+}
+
+auto layout_t::renamed(const string_view& name) const noexcept -> string_view {
+    const auto it = std::lower_bound(mapping.begin(), mapping.end(), name, [](
+        const std::pair<std::string, std::string>& kv, const string_view& name)
+    {
+        return string_view(kv.first) < name;
+    });
+
+    if (it != mapping.end() && string_view(it->first) == name) {
+        return it->second;
+    }
+
+    return name;
+}
+
+}  // namespace formatter
+}  // namespace detail
+}  // namespace v1
+}  // namespace blackhole
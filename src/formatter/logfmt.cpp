@@ -0,0 +1,462 @@
+#include "blackhole/formatter/logfmt.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+
+#include <boost/optional/optional.hpp>
+#include <boost/variant/apply_visitor.hpp>
+
+#include "blackhole/attribute.hpp"
+#include "blackhole/config/node.hpp"
+#include "blackhole/config/option.hpp"
+#include "blackhole/extensions/writer.hpp"
+#include "blackhole/formatter.hpp"
+#include "blackhole/record.hpp"
+
+#include "blackhole/detail/attribute.hpp"
+#include "blackhole/detail/datetime.hpp"
+#include "blackhole/detail/datetime/cache.hpp"
+#include "blackhole/detail/formatter/json/escape.hpp"
+#include "blackhole/detail/memory.hpp"
+#include "blackhole/detail/process.hpp"
+#include "blackhole/detail/simd.hpp"
+#include "blackhole/detail/util/deleter.hpp"
+
+#if defined(BLACKHOLE_SIMD_X86)
+#include <immintrin.h>
+#elif defined(BLACKHOLE_SIMD_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace blackhole {
+inline namespace v1 {
+namespace formatter {
+namespace {
+
+typedef fmt::StringRef string_ref;
+
+constexpr auto is_plain(unsigned char ch) noexcept -> bool {
+    return ch > 0x20 && ch < 0x80 && ch != '=' && ch != '"' && ch != '\\';
+}
+
+/// Continues scanning for bytes that require either quoting or replacing from the given position.
+auto tail(const char* data, std::size_t size, std::size_t pos) noexcept -> std::size_t {
+    while (pos < size && is_plain(static_cast<unsigned char>(data[pos]))) {
+        ++pos;
+    }
+
+    return pos;
+}
+
+auto scan_scalar(const char* data, std::size_t size) noexcept -> std::size_t {
+    return tail(data, size, 0);
+}
+
+// Bytes are compared as signed ones, so that control, space and non-ASCII ones are all less than
+// the exclamation mark.
+#if defined(BLACKHOLE_SIMD_X86)
+BLACKHOLE_TARGET_SSE2
+auto scan_sse2(const char* data, std::size_t size) noexcept -> std::size_t {
+    const auto bang = _mm_set1_epi8(0x21);
+    const auto equal = _mm_set1_epi8('=');
+    const auto quote = _mm_set1_epi8('"');
+    const auto backslash = _mm_set1_epi8('\\');
+
+    std::size_t pos = 0;
+    for (; pos + 16 <= size; pos += 16) {
+        const auto chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+        const auto special = _mm_or_si128(
+            _mm_or_si128(_mm_cmplt_epi8(chunk, bang), _mm_cmpeq_epi8(chunk, equal)),
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash)));
+
+        if (const auto mask = static_cast<unsigned int>(_mm_movemask_epi8(special))) {
+            return pos + static_cast<std::size_t>(__builtin_ctz(mask));
+        }
+    }
+
+    return tail(data, size, pos);
+}
+
+BLACKHOLE_TARGET_AVX2
+auto scan_avx2(const char* data, std::size_t size) noexcept -> std::size_t {
+    const auto bang = _mm256_set1_epi8(0x21);
+    const auto equal = _mm256_set1_epi8('=');
+    const auto quote = _mm256_set1_epi8('"');
+    const auto backslash = _mm256_set1_epi8('\\');
+
+    std::size_t pos = 0;
+    for (; pos + 32 <= size; pos += 32) {
+        const auto chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos));
+        const auto special = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpgt_epi8(bang, chunk), _mm256_cmpeq_epi8(chunk, equal)),
+            _mm256_or_si256(_mm256_cmpeq_epi8(chunk, quote), _mm256_cmpeq_epi8(chunk, backslash)));
+
+        if (const auto mask = static_cast<unsigned int>(_mm256_movemask_epi8(special))) {
+            return pos + static_cast<std::size_t>(__builtin_ctz(mask));
+        }
+    }
+
+    return tail(data, size, pos);
+}
+
+BLACKHOLE_TARGET_AVX512
+auto scan_avx512(const char* data, std::size_t size) noexcept -> std::size_t {
+    const auto bang = _mm512_set1_epi8(0x21);
+    const auto equal = _mm512_set1_epi8('=');
+    const auto quote = _mm512_set1_epi8('"');
+    const auto backslash = _mm512_set1_epi8('\\');
+
+    std::size_t pos = 0;
+    for (; pos + 64 <= size; pos += 64) {
+        const auto chunk = _mm512_loadu_si512(data + pos);
+        const auto mask = _mm512_cmpgt_epi8_mask(bang, chunk) |
+            _mm512_cmpeq_epi8_mask(chunk, equal) | _mm512_cmpeq_epi8_mask(chunk, quote) |
+            _mm512_cmpeq_epi8_mask(chunk, backslash);
+
+        if (mask != 0) {
+            return pos + static_cast<std::size_t>(__builtin_ctzll(mask));
+        }
+    }
+
+    return tail(data, size, pos);
+}
+#endif
+
+#if defined(BLACKHOLE_SIMD_NEON)
+auto scan_neon(const char* data, std::size_t size) noexcept -> std::size_t {
+    const auto bang = vdupq_n_s8(0x21);
+    const auto equal = vdupq_n_u8('=');
+    const auto quote = vdupq_n_u8('"');
+    const auto backslash = vdupq_n_u8('\\');
+
+    std::size_t pos = 0;
+    for (; pos + 16 <= size; pos += 16) {
+        const auto chunk = vld1q_u8(reinterpret_cast<const std::uint8_t*>(data + pos));
+        const auto special = vorrq_u8(
+            vorrq_u8(vcltq_s8(vreinterpretq_s8_u8(chunk), bang), vceqq_u8(chunk, equal)),
+            vorrq_u8(vceqq_u8(chunk, quote), vceqq_u8(chunk, backslash)));
+
+        if (vmaxvq_u8(special) != 0) {
+            break;
+        }
+    }
+
+    return tail(data, size, pos);
+}
+#endif
+
+/// Returns the number of leading bytes that require neither quoting nor replacing in keys.
+detail::simd::kernel_t<std::size_t(const char*, std::size_t)> scan(
+    &scan_scalar,
+    BLACKHOLE_SIMD_X86_VARIANT(scan_sse2),
+    BLACKHOLE_SIMD_X86_VARIANT(scan_avx2),
+    BLACKHOLE_SIMD_X86_VARIANT(scan_avx512),
+    BLACKHOLE_SIMD_NEON_VARIANT(scan_neon));
+
+/// Writes the given key replacing characters not allowed by logfmt with underscores.
+auto write_key(const string_view& key, writer_t& writer) -> void {
+    const auto data = key.data();
+    const auto size = key.size();
+
+    if (size == 0) {
+        writer.inner << '_';
+        return;
+    }
+
+    std::size_t pos = 0;
+    while (true) {
+        const auto run = scan(data + pos, size - pos);
+        writer.inner << string_ref(data + pos, run);
+        pos += run;
+
+        if (pos == size) {
+            break;
+        }
+
+        // Both backslashes and non-ASCII characters are fine in keys.
+        const auto ch = static_cast<unsigned char>(data[pos]);
+        writer.inner << (ch <= 0x20 || ch == '=' || ch == '"' ? '_' : data[pos]);
+        ++pos;
+    }
+}
+
+auto write_string(const string_view& value, writer_t& writer) -> void {
+    if (scan(value.data(), value.size()) == value.size()) {
+        writer.inner << string_ref(value.data(), value.size());
+    } else {
+        writer.inner << '"';
+        detail::formatter::json::escape(value, writer);
+        writer.inner << '"';
+    }
+}
+
+class value_visitor_t : public boost::static_visitor<> {
+    writer_t& writer;
+
+public:
+    explicit value_visitor_t(writer_t& writer) noexcept :
+        writer(writer)
+    {}
+
+    auto operator()(std::nullptr_t) const -> void {
+        writer.inner << string_ref("null", 4);
+    }
+
+    auto operator()(bool value) const -> void {
+        if (value) {
+            writer.inner << string_ref("true", 4);
+        } else {
+            writer.inner << string_ref("false", 5);
+        }
+    }
+
+    auto operator()(std::int64_t value) const -> void {
+        const fmt::FormatInt formatted(value);
+        writer.inner << string_ref(formatted.data(), formatted.size());
+    }
+
+    auto operator()(std::uint64_t value) const -> void {
+        const fmt::FormatInt formatted(value);
+        writer.inner << string_ref(formatted.data(), formatted.size());
+    }
+
+    auto operator()(double value) const -> void {
+        writer.inner << value;
+    }
+
+    auto operator()(const string_view& value) const -> void {
+        write_string(value, writer);
+    }
+
+    auto operator()(const attribute::view_t::function_type& value) const -> void {
+        writer_t wr;
+        value(wr);
+        write_string(wr.result(), writer);
+    }
+};
+
+}  // namespace
+
+class logfmt_t : public formatter_t {
+public:
+    enum builtin_t : std::size_t {
+        timestamp,
+        severity,
+        message,
+        process,
+        thread,
+        builtins
+    };
+
+    struct properties_t {
+        std::array<std::string, builtins> names;
+        std::vector<std::string> severity;
+        std::string pattern;
+        bool unique;
+    };
+
+private:
+    /// Escaped keys of reserved fields followed by an equal sign, all except the first one are
+    /// preceded by a space.
+    std::array<std::string, builtins> keys;
+
+    /// Severity key-value pairs preceded by a space.
+    std::vector<std::string> severities;
+
+    std::string pattern;
+    detail::datetime::generator_t generator;
+    bool unique;
+
+public:
+    explicit logfmt_t(properties_t properties) :
+        pattern(std::move(properties.pattern)),
+        generator(detail::datetime::make_generator(pattern)),
+        unique(properties.unique)
+    {
+        for (std::size_t id = 0; id < builtins; ++id) {
+            writer_t writer;
+            if (id != 0) {
+                writer.inner << ' ';
+            }
+
+            const auto& name = properties.names[id];
+            write_key(string_view(name.data(), name.size()), writer);
+            writer.inner << '=';
+            keys[id] = writer.result().to_string();
+        }
+
+        for (const auto& value : properties.severity) {
+            writer_t writer;
+            writer.inner << keys[builtin_t::severity];
+            write_string(string_view(value.data(), value.size()), writer);
+            severities.emplace_back(writer.result().to_string());
+        }
+    }
+
+    auto format(const record_t& record, writer_t& writer) -> void override {
+        const auto key = [&](builtin_t id) {
+            writer.inner << string_ref(keys[id].data(), keys[id].size());
+        };
+
+        const auto time = record_t::clock_type::to_time_t(record.timestamp());
+        const auto usec = std::chrono::duration_cast<
+            std::chrono::microseconds
+        >(record.timestamp().time_since_epoch()).count() % 1000000;
+
+        thread_local detail::datetime::cache_t cache;
+
+        const auto& timestamp = cache.format(pattern, generator, true, time,
+            static_cast<std::uint64_t>(usec));
+
+        key(builtin_t::timestamp);
+        write_string(string_view(timestamp.data(), timestamp.size()), writer);
+
+        const auto sev = static_cast<std::size_t>(record.severity());
+        if (sev < severities.size()) {
+            writer.inner << string_ref(severities[sev].data(), severities[sev].size());
+        } else {
+            key(builtin_t::severity);
+            writer.inner << record.severity();
+        }
+
+        key(builtin_t::message);
+        write_string(record.formatted(), writer);
+
+        key(builtin_t::process);
+        writer.inner << record.pid();
+
+        key(builtin_t::thread);
+        const auto hex = detail::this_thread::hex(record.tid());
+        writer.inner << string_ref(hex.data(), hex.size());
+
+        const auto write = [&](const view_of<attribute_t>::type& attribute) {
+            writer.inner << ' ';
+            write_key(attribute.first, writer);
+            writer.inner << '=';
+            boost::apply_visitor(value_visitor_t(writer), attribute.second.inner().value);
+        };
+
+        if (unique) {
+            for (const auto& attribute : record.unique_attributes()) {
+                write(attribute);
+            }
+        } else {
+            for (const auto& attributes : record.attributes()) {
+                for (const auto& attribute : attributes.get()) {
+                    write(attribute);
+                }
+            }
+        }
+    }
+};
+
+}  // namespace formatter
+
+using formatter::logfmt_t;
+
+class builder<logfmt_t>::inner_t {
+public:
+    std::vector<std::pair<std::string, std::string>> renames;
+    logfmt_t::properties_t properties;
+};
+
+builder<logfmt_t>::builder() :
+    d(new inner_t{{}, {{{"timestamp", "severity", "message", "process", "thread"}}, {},
+        "%Y-%m-%dT%H:%M:%S.%fZ", false}}, deleter_t())
+{}
+
+auto builder<logfmt_t>::rename(std::string from, std::string to) & -> builder& {
+    d->renames.emplace_back(std::move(from), std::move(to));
+    return *this;
+}
+
+auto builder<logfmt_t>::rename(std::string from, std::string to) && -> builder&& {
+    return std::move(rename(std::move(from), std::move(to)));
+}
+
+auto builder<logfmt_t>::severity(std::vector<std::string> sevmap) & -> builder& {
+    d->properties.severity = std::move(sevmap);
+    return *this;
+}
+
+auto builder<logfmt_t>::severity(std::vector<std::string> sevmap) && -> builder&& {
+    return std::move(severity(std::move(sevmap)));
+}
+
+auto builder<logfmt_t>::timestamp(std::string pattern) & -> builder& {
+    d->properties.pattern = std::move(pattern);
+    return *this;
+}
+
+auto builder<logfmt_t>::timestamp(std::string pattern) && -> builder&& {
+    return std::move(timestamp(std::move(pattern)));
+}
+
+auto builder<logfmt_t>::unique() & -> builder& {
+    d->properties.unique = true;
+    return *this;
+}
+
+auto builder<logfmt_t>::unique() && -> builder&& {
+    return std::move(unique());
+}
+
+auto builder<logfmt_t>::build() && -> std::unique_ptr<formatter_t> {
+    auto properties = std::move(d->properties);
+    const auto defaults = properties.names;
+
+    for (const auto& rename : d->renames) {
+        const auto it = std::find(defaults.begin(), defaults.end(), rename.first);
+        if (it == defaults.end()) {
+            throw std::invalid_argument("unable to rename \"" + rename.first + "\": "
+                "logfmt formatter renames only reserved fields");
+        }
+
+        properties.names[static_cast<std::size_t>(it - defaults.begin())] = rename.second;
+    }
+
+    return blackhole::make_unique<logfmt_t>(std::move(properties));
+}
+
+auto factory<logfmt_t>::type() const noexcept -> const char* {
+    return "logfmt";
+}
+
+auto factory<logfmt_t>::from(const config::node_t& config) const -> std::unique_ptr<formatter_t> {
+    builder<logfmt_t> builder;
+
+    if (auto mapping = config["mapping"]) {
+        mapping.each_map([&](const std::string& key, const config::node_t& value) {
+            builder.rename(key, value.to_string());
+        });
+    }
+
+    if (auto sevmap = config["sevmap"]) {
+        std::vector<std::string> severities;
+        sevmap.each([&](const config::node_t& config) {
+            severities.emplace_back(config.to_string());
+        });
+
+        builder.severity(std::move(severities));
+    }
+
+    if (auto pattern = config["timestamp"].to_string()) {
+        builder.timestamp(pattern.get());
+    }
+
+    if (auto unique = config["unique"].to_bool()) {
+        if (unique.get()) {
+            builder.unique();
+        }
+    }
+
+    return std::move(builder).build();
+}
+
+template auto deleter_t::operator()(builder<formatter::logfmt_t>::inner_t* value) -> void;
+
+}  // namespace v1
+}  // namespace blackhole
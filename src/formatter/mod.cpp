@@ -1,9 +1,37 @@
 #include "blackhole/formatter.hpp"
 
+#include "blackhole/extensions/writer.hpp"
+#include "blackhole/record.hpp"
+#include "blackhole/stdext/string_view.hpp"
+
 namespace blackhole {
 inline namespace v1 {
 
 formatter_t::~formatter_t() = default;
 
+auto formatter_t::format_batch(const record_t* records, std::size_t size, writer_t& writer,
+    std::size_t* offsets, bool* skipped) -> void
+{
+    for (std::size_t id = 0; id < size; ++id) {
+        offsets[id] = writer.inner.size();
+
+        writer.skip(false);
+        format(records[id], writer);
+
+        // Rejected records may have been partially written.
+        skipped[id] = writer.skipped();
+        if (skipped[id]) {
+            writer.inner.buffer().resize(offsets[id]);
+        }
+    }
+
+    offsets[size] = writer.inner.size();
+    writer.skip(false);
+}
+
+auto formatter_t::estimate(const record_t& record) const -> std::size_t {
+    return record.formatted().size() + 100;
+}
+
 }  // namespace v1
 }  // namespace blackhole
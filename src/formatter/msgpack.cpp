@@ -0,0 +1,112 @@
+#include "blackhole/formatter/msgpack.hpp"
+
+#include "blackhole/formatter.hpp"
+
+#include "blackhole/detail/formatter/binary/serializer.hpp"
+#include "blackhole/detail/memory.hpp"
+#include "blackhole/detail/util/deleter.hpp"
+
+#include "binary/config.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace formatter {
+
+class msgpack_t : public formatter_t {
+    typedef detail::formatter::binary::serializer_t serializer_type;
+
+    serializer_type serializer;
+
+public:
+    explicit msgpack_t(serializer_type::properties_t properties) :
+        serializer(detail::formatter::binary::encoding_t::msgpack, std::move(properties))
+    {}
+
+    auto format(const record_t& record, writer_t& writer) -> void override {
+        serializer.format(record, writer);
+    }
+};
+
+}  // namespace formatter
+
+using formatter::msgpack_t;
+
+class builder<msgpack_t>::inner_t : public detail::formatter::binary::serializer_t::properties_t {};
+
+builder<msgpack_t>::builder() :
+    d(new inner_t(), deleter_t())
+{}
+
+auto builder<msgpack_t>::route(std::string route) & -> builder& {
+    d->rest = std::move(route);
+    return *this;
+}
+
+auto builder<msgpack_t>::route(std::string route) && -> builder&& {
+    return std::move(this->route(std::move(route)));
+}
+
+auto builder<msgpack_t>::route(std::string route, std::vector<std::string> attributes) & -> builder& {
+    d->routing[std::move(route)] = std::move(attributes);
+    return *this;
+}
+
+auto builder<msgpack_t>::route(std::string route, std::vector<std::string> attributes) && -> builder&& {
+    return std::move(this->route(std::move(route), std::move(attributes)));
+}
+
+auto builder<msgpack_t>::rename(std::string from, std::string to) & -> builder& {
+    d->mapping[std::move(from)] = std::move(to);
+    return *this;
+}
+
+auto builder<msgpack_t>::rename(std::string from, std::string to) && -> builder&& {
+    return std::move(rename(std::move(from), std::move(to)));
+}
+
+auto builder<msgpack_t>::unique() & -> builder& {
+    d->unique = true;
+    return *this;
+}
+
+auto builder<msgpack_t>::unique() && -> builder&& {
+    return std::move(unique());
+}
+
+auto builder<msgpack_t>::severity(std::vector<std::string> sevmap) & -> builder& {
+    d->severity = std::move(sevmap);
+    return *this;
+}
+
+auto builder<msgpack_t>::severity(std::vector<std::string> sevmap) && -> builder&& {
+    return std::move(severity(std::move(sevmap)));
+}
+
+auto builder<msgpack_t>::timestamp(const std::string& pattern) & -> builder& {
+    d->timestamp = formatter::binary::timestamp(pattern);
+    return *this;
+}
+
+auto builder<msgpack_t>::timestamp(const std::string& pattern) && -> builder&& {
+    return std::move(timestamp(pattern));
+}
+
+auto builder<msgpack_t>::build() && -> std::unique_ptr<formatter_t> {
+    return blackhole::make_unique<msgpack_t>(std::move(*d));
+}
+
+auto factory<msgpack_t>::type() const noexcept -> const char* {
+    return "msgpack";
+}
+
+auto factory<msgpack_t>::from(const config::node_t& config) const -> std::unique_ptr<formatter_t> {
+    builder<msgpack_t> builder;
+    formatter::binary::configure(config, builder);
+
+    return std::move(builder).build();
+}
+
+template auto deleter_t::operator()(builder<formatter::msgpack_t>::inner_t* value) -> void;
+
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,393 @@
+#include "blackhole/formatter/otlp.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstring>
+#include <limits>
+
+#include <boost/optional/optional.hpp>
+#include <boost/variant/apply_visitor.hpp>
+
+#include "blackhole/attribute.hpp"
+#include "blackhole/config/node.hpp"
+#include "blackhole/config/option.hpp"
+#include "blackhole/extensions/writer.hpp"
+#include "blackhole/formatter.hpp"
+#include "blackhole/record.hpp"
+
+#include "blackhole/detail/attribute.hpp"
+#include "blackhole/detail/formatter/json/escape.hpp"
+#include "blackhole/detail/memory.hpp"
+#include "blackhole/detail/protobuf.hpp"
+#include "blackhole/detail/util/deleter.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace formatter {
+namespace {
+
+namespace protobuf = detail::protobuf;
+
+typedef fmt::StringRef string_ref;
+
+/// Field numbers of `LogRecord`, `KeyValue` and `AnyValue` messages.
+namespace field {
+
+constexpr std::uint32_t time_unix_nano = 1;
+constexpr std::uint32_t severity_number = 2;
+constexpr std::uint32_t severity_text = 3;
+constexpr std::uint32_t body = 5;
+constexpr std::uint32_t attributes = 6;
+constexpr std::uint32_t trace_id = 9;
+constexpr std::uint32_t span_id = 10;
+
+constexpr std::uint32_t key = 1;
+constexpr std::uint32_t value = 2;
+
+constexpr std::uint32_t string_value = 1;
+constexpr std::uint32_t bool_value = 2;
+constexpr std::uint32_t int_value = 3;
+constexpr std::uint32_t double_value = 4;
+
+}  // namespace field
+
+auto put(std::uint64_t value, writer_t& writer) -> void {
+    char buffer[protobuf::max_varint];
+    writer.inner << string_ref(buffer, protobuf::encode(value, buffer));
+}
+
+auto put_fixed64(std::uint64_t value, writer_t& writer) -> void {
+    char buffer[8];
+    protobuf::encode_fixed64(value, buffer);
+    writer.inner << string_ref(buffer, sizeof(buffer));
+}
+
+auto put_string(std::uint32_t number, const string_view& value, writer_t& writer) -> void {
+    put(protobuf::key(number, protobuf::delimited), writer);
+    put(value.size(), writer);
+    writer.inner << string_ref(value.data(), value.size());
+}
+
+/// Encodes the given id part in big-endian byte order, which OTLP trace and span ids use.
+auto encode_id(std::uint64_t value, char* buffer) noexcept -> void {
+    for (int id = 7; id >= 0; --id) {
+        buffer[id] = static_cast<char>(value & 0xff);
+        value >>= 8;
+    }
+}
+
+/// Refers to the given string if it's valid UTF-8 or holds its sanitized copy otherwise, because
+/// protobuf strings are required to be valid UTF-8.
+class text_t {
+    std::string storage;
+    string_view view;
+
+public:
+    explicit text_t(const string_view& value) :
+        view(value)
+    {
+        if (detail::formatter::json::validate(value) != value.size()) {
+            storage = detail::formatter::json::sanitize(value);
+            view = storage;
+        }
+    }
+
+    text_t(const text_t& other) = delete;
+    auto operator=(const text_t& other) -> text_t& = delete;
+
+    auto get() const noexcept -> const string_view& {
+        return view;
+    }
+};
+
+/// Resolved `AnyValue` message content, which size must be known before it is written.
+struct any_t {
+    /// Field number of the value set, zero for an empty message representing null.
+    std::uint32_t number;
+    protobuf::wire_t wire;
+    std::uint64_t bits;
+    string_view text;
+
+    auto size() const noexcept -> std::size_t {
+        if (number == 0) {
+            return 0;
+        }
+
+        const auto prefix = protobuf::varint_size(protobuf::key(number, wire));
+
+        switch (wire) {
+        case protobuf::varint:
+            return prefix + protobuf::varint_size(bits);
+        case protobuf::fixed64:
+            return prefix + 8;
+        default:
+            return protobuf::delimited_size(number, text.size());
+        }
+    }
+
+    auto write(writer_t& writer) const -> void {
+        if (number == 0) {
+            return;
+        }
+
+        switch (wire) {
+        case protobuf::varint:
+            put(protobuf::key(number, wire), writer);
+            put(bits, writer);
+            break;
+        case protobuf::fixed64:
+            put(protobuf::key(number, wire), writer);
+            put_fixed64(bits, writer);
+            break;
+        default:
+            put_string(number, text, writer);
+        }
+    }
+};
+
+auto bits_of(double value) noexcept -> std::uint64_t {
+    std::uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+/// Resolves attribute values using the given writer to render values that are not stored as is.
+class value_visitor_t : public boost::static_visitor<any_t> {
+    writer_t& scratch;
+
+public:
+    explicit value_visitor_t(writer_t& scratch) noexcept :
+        scratch(scratch)
+    {}
+
+    auto operator()(std::nullptr_t) const -> any_t {
+        return {0, protobuf::varint, 0, {}};
+    }
+
+    auto operator()(bool value) const -> any_t {
+        return {field::bool_value, protobuf::varint, value ? 1u : 0u, {}};
+    }
+
+    auto operator()(std::int64_t value) const -> any_t {
+        // Negative values are encoded as ten bytes long two's complement varints.
+        return {field::int_value, protobuf::varint, static_cast<std::uint64_t>(value), {}};
+    }
+
+    auto operator()(std::uint64_t value) const -> any_t {
+        if (value <= static_cast<std::uint64_t>(std::numeric_limits<std::int64_t>::max())) {
+            return {field::int_value, protobuf::varint, value, {}};
+        }
+
+        scratch.inner << value;
+        return {field::string_value, protobuf::delimited, 0, scratch.result()};
+    }
+
+    auto operator()(double value) const -> any_t {
+        return {field::double_value, protobuf::fixed64, bits_of(value), {}};
+    }
+
+    auto operator()(const string_view& value) const -> any_t {
+        return {field::string_value, protobuf::delimited, 0, value};
+    }
+
+    auto operator()(const attribute::view_t::function_type& value) const -> any_t {
+        value(scratch);
+        return {field::string_value, protobuf::delimited, 0, scratch.result()};
+    }
+};
+
+/// Writes the given attribute as a `KeyValue` message of the `attributes` field.
+auto write_attribute(const string_view& name, const any_t& value, writer_t& writer) -> void {
+    const text_t key(name);
+    const text_t text(value.text);
+
+    any_t any = value;
+    any.text = text.get();
+
+    const auto size = any.size();
+    const auto length = protobuf::delimited_size(field::key, key.get().size()) +
+        protobuf::delimited_size(field::value, size);
+
+    put(protobuf::key(field::attributes, protobuf::delimited), writer);
+    put(length, writer);
+    put_string(field::key, key.get(), writer);
+    put(protobuf::key(field::value, protobuf::delimited), writer);
+    put(size, writer);
+    any.write(writer);
+}
+
+/// Returns OpenTelemetry severity number of the given short name, zero if it's unknown.
+auto severity_number(const std::string& name) -> std::uint32_t {
+    static const char* names[] = {"trace", "debug", "info", "warn", "error", "fatal"};
+
+    std::string lower(name);
+    std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char ch) {
+        return static_cast<char>(std::tolower(ch));
+    });
+
+    std::uint32_t offset = 0;
+    if (lower.size() > 1 && lower.back() >= '2' && lower.back() <= '4') {
+        offset = static_cast<std::uint32_t>(lower.back() - '1');
+        lower.pop_back();
+    }
+
+    for (std::uint32_t id = 0; id < sizeof(names) / sizeof(names[0]); ++id) {
+        if (lower == names[id]) {
+            return id * 4 + 1 + offset;
+        }
+    }
+
+    return 0;
+}
+
+}  // namespace
+
+class otlp_t : public formatter_t {
+    /// Precomputed `severity_number` and `severity_text` fields.
+    std::vector<std::string> severities;
+    bool unique;
+
+public:
+    otlp_t(const std::vector<std::string>& sevmap, bool unique) :
+        unique(unique)
+    {
+        for (const auto& name : sevmap) {
+            writer_t writer;
+
+            if (const auto number = severity_number(name)) {
+                put(protobuf::key(field::severity_number, protobuf::varint), writer);
+                put(number, writer);
+            }
+
+            const text_t text(name);
+            put_string(field::severity_text, text.get(), writer);
+            severities.emplace_back(writer.result().to_string());
+        }
+    }
+
+    auto format(const record_t& record, writer_t& writer) -> void override {
+        const auto nanoseconds = std::chrono::duration_cast<
+            std::chrono::nanoseconds
+        >(record.timestamp().time_since_epoch()).count();
+
+        put(protobuf::key(field::time_unix_nano, protobuf::fixed64), writer);
+        put_fixed64(static_cast<std::uint64_t>(nanoseconds), writer);
+
+        const auto sev = static_cast<std::size_t>(record.severity());
+        if (sev < severities.size()) {
+            writer.inner << string_ref(severities[sev].data(), severities[sev].size());
+        } else {
+            const fmt::FormatInt formatted(record.severity());
+            put_string(field::severity_text, string_view(formatted.data(), formatted.size()),
+                writer);
+        }
+
+        const text_t message(record.formatted());
+        put(protobuf::key(field::body, protobuf::delimited), writer);
+        put(protobuf::delimited_size(field::string_value, message.get().size()), writer);
+        put_string(field::string_value, message.get(), writer);
+
+        write_attribute(string_view("process.pid", 11),
+            {field::int_value, protobuf::varint, record.pid(), {}}, writer);
+        write_attribute(string_view("thread.id", 9),
+            {field::int_value, protobuf::varint, record.lwp(), {}}, writer);
+
+        const auto write = [&](const view_of<attribute_t>::type& attribute) {
+            writer_t scratch;
+            const auto value = boost::apply_visitor(value_visitor_t(scratch),
+                attribute.second.inner().value);
+            write_attribute(attribute.first, value, writer);
+        };
+
+        if (unique) {
+            for (const auto& attribute : record.unique_attributes()) {
+                write(attribute);
+            }
+        } else {
+            for (const auto& attributes : record.attributes()) {
+                for (const auto& attribute : attributes.get()) {
+                    write(attribute);
+                }
+            }
+        }
+
+        const auto& trace = record.trace();
+        if (!trace.empty()) {
+            char trace_id[16];
+            encode_id(trace.hi, trace_id);
+            encode_id(trace.lo, trace_id + 8);
+            put_string(field::trace_id, string_view(trace_id, sizeof(trace_id)), writer);
+
+            char span_id[8];
+            encode_id(trace.span, span_id);
+            put_string(field::span_id, string_view(span_id, sizeof(span_id)), writer);
+        }
+    }
+};
+
+}  // namespace formatter
+
+using formatter::otlp_t;
+
+class builder<otlp_t>::inner_t {
+public:
+    std::vector<std::string> severity;
+    bool unique;
+};
+
+builder<otlp_t>::builder() :
+    d(new inner_t{{"DEBUG", "INFO", "WARN", "ERROR"}, false}, deleter_t())
+{}
+
+auto builder<otlp_t>::severity(std::vector<std::string> sevmap) & -> builder& {
+    d->severity = std::move(sevmap);
+    return *this;
+}
+
+auto builder<otlp_t>::severity(std::vector<std::string> sevmap) && -> builder&& {
+    return std::move(severity(std::move(sevmap)));
+}
+
+auto builder<otlp_t>::unique() & -> builder& {
+    d->unique = true;
+    return *this;
+}
+
+auto builder<otlp_t>::unique() && -> builder&& {
+    return std::move(unique());
+}
+
+auto builder<otlp_t>::build() && -> std::unique_ptr<formatter_t> {
+    return blackhole::make_unique<otlp_t>(d->severity, d->unique);
+}
+
+auto factory<otlp_t>::type() const noexcept -> const char* {
+    return "otlp";
+}
+
+auto factory<otlp_t>::from(const config::node_t& config) const -> std::unique_ptr<formatter_t> {
+    builder<otlp_t> builder;
+
+    if (auto sevmap = config["sevmap"]) {
+        std::vector<std::string> severities;
+        sevmap.each([&](const config::node_t& config) {
+            severities.emplace_back(config.to_string());
+        });
+
+        builder.severity(std::move(severities));
+    }
+
+    if (auto unique = config["unique"].to_bool()) {
+        if (unique.get()) {
+            builder.unique();
+        }
+    }
+
+    return std::move(builder).build();
+}
+
+template auto deleter_t::operator()(builder<formatter::otlp_t>::inner_t* value) -> void;
+
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,125 @@
+#include "shared.hpp"
+
+#include <string>
+#include <vector>
+
+#include "blackhole/extensions/writer.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace formatter {
+namespace {
+
+/// Serial number of the current dispatch on this thread, zero if there is no one.
+thread_local std::uint64_t current = 0;
+
+/// Last assigned dispatch serial number on this thread.
+thread_local std::uint64_t counter = 0;
+
+/// Result of formatting the dispatched record by a shared formatter.
+struct entry_t {
+    const shared_t::state_t* owner;
+    std::uint64_t dispatch;
+    const record_t* record;
+    std::string data;
+    bool skipped;
+};
+
+}  // namespace
+
+class shared_t::state_t {
+public:
+    std::unique_ptr<formatter_t> formatter;
+
+    /// Number of proxies created using `share`, which is changed only while building.
+    std::size_t users;
+
+    explicit state_t(std::unique_ptr<formatter_t> formatter) :
+        formatter(std::move(formatter)),
+        users(0)
+    {}
+};
+
+dispatch_t::dispatch_t() noexcept :
+    previous(current)
+{
+    current = ++counter;
+}
+
+dispatch_t::~dispatch_t() {
+    current = previous;
+}
+
+shared_t::shared_t(std::unique_ptr<formatter_t> formatter) :
+    state(std::make_shared<state_t>(std::move(formatter)))
+{}
+
+auto shared_t::share() const -> std::unique_ptr<formatter_t> {
+    std::unique_ptr<shared_t> result(new shared_t(*this));
+    ++state->users;
+    return result;
+}
+
+auto shared_t::format(const record_t& record, writer_t& writer) -> void {
+    if (state->users < 2 || current == 0) {
+        state->formatter->format(record, writer);
+        return;
+    }
+
+    // Entries are kept for the thread lifetime, so their buffers are reused. Entries not touched
+    // during the current dispatch are free to be taken by other formatters, which bounds their
+    // number by the number of shared formatters involved in a single dispatch.
+    thread_local std::vector<entry_t> entries;
+
+    entry_t* entry = nullptr;
+    entry_t* free = nullptr;
+    for (auto& it : entries) {
+        if (it.owner == state.get()) {
+            entry = &it;
+            break;
+        }
+
+        if (free == nullptr && it.dispatch != current) {
+            free = &it;
+        }
+    }
+
+    if (entry && entry->dispatch == current && entry->record == &record) {
+        writer.inner << fmt::StringRef(entry->data.data(), entry->data.size());
+        writer.skip(entry->skipped);
+        return;
+    }
+
+    const auto offset = writer.inner.size();
+    state->formatter->format(record, writer);
+
+    if (entry == nullptr) {
+        if (free == nullptr) {
+            entries.push_back({nullptr, 0, nullptr, {}, false});
+            free = &entries.back();
+        }
+
+        entry = free;
+        entry->owner = state.get();
+    }
+
+    entry->dispatch = current;
+    entry->record = &record;
+    entry->data.assign(writer.inner.data() + offset, writer.inner.size() - offset);
+    entry->skipped = writer.skipped();
+}
+
+auto shared_t::format_batch(const record_t* records, std::size_t size, writer_t& writer,
+    std::size_t* offsets, bool* skipped) -> void
+{
+    if (state->users < 2 || current == 0) {
+        state->formatter->format_batch(records, size, writer, offsets, skipped);
+        return;
+    }
+
+    formatter_t::format_batch(records, size, writer, offsets, skipped);
+}
+
+}  // namespace formatter
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+#include "blackhole/formatter.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace formatter {
+
+/// Marks the scope of dispatching a single record to handlers on the current thread.
+///
+/// Shared formatters format each record once per dispatch and replay the result for all other
+/// handlers. Scopes can be nested, i.e. when logging from inside of a handler.
+class dispatch_t {
+    std::uint64_t previous;
+
+public:
+    dispatch_t() noexcept;
+    ~dispatch_t();
+
+    dispatch_t(const dispatch_t& other) = delete;
+    auto operator=(const dispatch_t& other) -> dispatch_t& = delete;
+};
+
+/// Formatter proxy that shares the underlying formatter between several handlers.
+///
+/// While the underlying formatter is shared with a single proxy, records are formatted directly. Otherwise the result of formatting a record is cached by the thread during its
+/// dispatch, so other handlers only copy it instead of formatting again.
+class shared_t : public formatter_t {
+public:
+    class state_t;
+
+private:
+    std::shared_ptr<state_t> state;
+
+public:
+    /// Creates a proxy owning the given formatter, which is meant to be used only for sharing it.
+    explicit shared_t(std::unique_ptr<formatter_t> formatter);
+
+    /// Creates another proxy sharing the formatter with the given one.
+    auto share() const -> std::unique_ptr<formatter_t>;
+
+    auto format(const record_t& record, writer_t& writer) -> void override;
+
+    /// Formats batches with the underlying formatter directly outside of dispatches, replaying
+    /// cached results record by record otherwise.
+    auto format_batch(const record_t* records, std::size_t size, writer_t& writer,
+        std::size_t* offsets, bool* skipped) -> void override;
+};
+
+}  // namespace formatter
+}  // namespace v1
+}  // namespace blackhole
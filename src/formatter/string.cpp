@@ -1,7 +1,11 @@
 #include "blackhole/formatter/string.hpp"
 
+#include <algorithm>
 #include <array>
+#include <cstring>
+#include <type_traits>
 
+#include <boost/container/small_vector.hpp>
 #include <boost/type_traits/remove_cv.hpp>
 #include <boost/variant/apply_visitor.hpp>
 #include <boost/variant/get.hpp>
@@ -16,10 +20,16 @@
 #include "blackhole/record.hpp"
 
 #include "blackhole/detail/attribute.hpp"
+#include "blackhole/detail/datetime/cache.hpp"
 #include "blackhole/detail/formatter/string/parser.hpp"
+#include "blackhole/detail/formatter/string/path.hpp"
+#include "blackhole/detail/formatter/string/pattern.hpp"
+#include "blackhole/detail/formatter/string/program.hpp"
 #include "blackhole/detail/formatter/string/token.hpp"
 #include "blackhole/detail/memory.hpp"
+#include "blackhole/detail/process.hpp"
 #include "blackhole/detail/procname.hpp"
+#include "blackhole/detail/trace.hpp"
 #include "blackhole/detail/util/deleter.hpp"
 
 // TODO: Optional attributes.
@@ -51,6 +61,12 @@ using string::literal_t;
 using string::token_t;
 using string::parser_t;
 
+using string::spec_t;
+using string::opcode_t;
+using string::instruction_t;
+using string::interned_t;
+using string::program_t;
+
 typedef fmt::StringRef string_ref;
 
 }  // namespace
@@ -83,6 +99,24 @@ public:
         writer.write(spec, value);
     }
 
+    // Default specifications are the most common ones, so numbers are written directly without
+    // parsing the specification on each call. Everything else is rare enough.
+    auto operator()(std::int64_t value) const -> void {
+        write_integer(value);
+    }
+
+    auto operator()(std::uint64_t value) const -> void {
+        write_integer(value);
+    }
+
+    auto operator()(double value) const -> void {
+        if (spec == "{}") {
+            writer.inner << value;
+        } else {
+            writer.write(spec, value);
+        }
+    }
+
     auto operator()(const string_view& value) const -> void {
         writer.write(spec, value.data());
     }
@@ -90,6 +124,17 @@ public:
     auto operator()(const attribute::view_t::function_type& value) const -> void {
         value(writer);
     }
+
+private:
+    template<typename T>
+    auto write_integer(T value) const -> void {
+        if (spec == "{}") {
+            const fmt::FormatInt formatted(value);
+            writer.inner << string_ref(formatted.data(), formatted.size());
+        } else {
+            writer.write(spec, value);
+        }
+    }
 };
 
 class pattern_visitor_t : public boost::static_visitor<> {
@@ -125,159 +170,451 @@ public:
         placeholder(placeholder)
     {}
 
-    auto eval(writer_t& wr, const attribute_pack& pack) -> void {
+    auto eval(writer_t& wr, const unique_attributes_t& attributes) -> void {
         bool first = true;
-        for (const auto& attributes : pack) {
-            for (const auto& attribute : attributes.get()) {
-                if (first) {
-                    first = false;
-                    wr.inner << placeholder.prefix;
-                } else {
-                    wr.inner << placeholder.separator;
-                }
+        for (const auto& attribute : attributes) {
+            if (first) {
+                first = false;
+                wr.inner << placeholder.prefix;
+            } else {
+                wr.inner << placeholder.separator;
+            }
 
-                pattern_visitor_t visitor(wr, attribute);
-                for (const auto& token : placeholder.tokens) {
-                    boost::apply_visitor(visitor, token);
-                }
+            pattern_visitor_t visitor(wr, attribute);
+            for (const auto& token : placeholder.tokens) {
+                boost::apply_visitor(visitor, token);
             }
         }
 
-        // TODO: Resize instead? Measure.
         if (!first) {
             wr.inner << placeholder.suffix;
         }
     }
 };
 
-class visitor_t : public boost::static_visitor<> {
+/// Attribute values resolved for each interned name, null if there is no such attribute.
+typedef boost::container::small_vector<const attribute::view_t*, 16> resolved_type;
+
+/// Resolves all interned names in a single pass over the attribute pack.
+///
+/// The first attribute with a matching name wins, which preserves the lookup order of attribute
+/// lists in the pack.
+auto resolve(const std::vector<interned_t>& names, const attribute_pack& pack, resolved_type& result)
+    -> void
+{
+    result.assign(names.size(), nullptr);
+
+    auto remaining = names.size();
+
+    for (const auto& attributes : pack) {
+        for (const auto& attribute : attributes.get()) {
+            const auto& key = attribute.first;
+
+            bool hashed = false;
+            std::uint64_t hash = 0;
+
+            for (std::size_t id = 0; id < names.size(); ++id) {
+                const auto& name = names[id];
+
+                if (result[id] != nullptr || name.name.size() != key.size()) {
+                    continue;
+                }
+
+                // Attributes with interned keys share the storage of the interned name.
+                const auto same = name.key.name().data() == key.data();
+
+                if (!same && !hashed) {
+                    hash = interned_t::hash_of(key.data(), key.size());
+                    hashed = true;
+                }
+
+                if (same || (name.hash == hash &&
+                    std::memcmp(name.name.data(), key.data(), key.size()) == 0))
+                {
+                    result[id] = &attribute.second;
+
+                    if (--remaining == 0) {
+                        return;
+                    }
+
+                    // Interned names are unique, so no other slot can match this attribute.
+                    break;
+                }
+            }
+        }
+    }
+}
+
+/// Writes the given value padded according to the pre-parsed specification.
+auto pad(writer_t& writer, const spec_t& spec, const char* data, std::size_t size, char align)
+    -> void
+{
+    if (spec.width <= size) {
+        writer.inner << string_ref(data, size);
+        return;
+    }
+
+    const auto fill = spec.width - size;
+    std::size_t left = 0;
+
+    switch (spec.align == 0 ? align : spec.align) {
+    case '>':
+        left = fill;
+        break;
+    case '^':
+        left = fill / 2;
+        break;
+    default:
+        break;
+    }
+
+    for (std::size_t id = 0; id < left; ++id) {
+        writer.inner << spec.fill;
+    }
+
+    writer.inner << string_ref(data, size);
+
+    for (std::size_t id = left; id < fill; ++id) {
+        writer.inner << spec.fill;
+    }
+}
+
+/// Writes the given string, left-aligned by default.
+auto emit(writer_t& writer, const spec_t& spec, const string_view& value) -> void {
+    if (spec.kind == spec_t::kind_t::custom || spec.type == 'd') {
+        writer.write(spec.pattern, string_ref(value.data(), value.size()));
+    } else if (spec.kind == spec_t::kind_t::plain) {
+        writer.inner << string_ref(value.data(), value.size());
+    } else {
+        pad(writer, spec, value.data(), value.size(), '<');
+    }
+}
+
+/// Writes the given string like the function above, but lets the writer reference it instead of
+/// copying if it's written as is.
+///
+/// \warning the string must outlive the formatted record.
+auto emit_view(writer_t& writer, const spec_t& spec, const string_view& value) -> void {
+    if (spec.kind == spec_t::kind_t::plain && spec.type != 'd') {
+        writer.reference(value);
+    } else {
+        emit(writer, spec, value);
+    }
+}
+
+/// Writes the given integer, right-aligned by default.
+template<typename T>
+auto emit(writer_t& writer, const spec_t& spec, T value) ->
+    typename std::enable_if<std::is_integral<T>::value>::type
+{
+    if (spec.kind == spec_t::kind_t::custom || spec.type == 's') {
+        writer.write(spec.pattern, value);
+    } else if (spec.kind == spec_t::kind_t::plain) {
+        writer.inner << value;
+    } else {
+        const fmt::FormatInt formatted(value);
+        pad(writer, spec, formatted.data(), formatted.size(), '>');
+    }
+}
+
+/// Writes attribute values using the pre-parsed specification.
+class spec_visitor_t : public boost::static_visitor<> {
     writer_t& writer;
-    const record_t& record;
-    const severity_map& sevmap;
+    const spec_t& spec;
 
 public:
-    visitor_t(writer_t& writer, const record_t& record, const severity_map& sevmap) noexcept :
+    spec_visitor_t(writer_t& writer, const spec_t& spec) noexcept :
         writer(writer),
-        record(record),
-        sevmap(sevmap)
+        spec(spec)
     {}
 
-    auto operator()(const literal_t& token) const -> void {
-        writer.inner << token.value;
+    auto operator()(std::nullptr_t) const -> void {
+        emit(writer, spec, string_view("none"));
     }
 
-    auto operator()(const ph::message_t& token) const -> void {
-        const auto& value = record.formatted();
-        writer.write(token.spec, string_ref(value.data(), value.size()));
+    auto operator()(bool value) const -> void {
+        writer.write(spec.pattern, value);
     }
 
-    auto operator()(const ph::process<id>& token) const -> void {
-        writer.write(token.spec, record.pid());
+    auto operator()(std::int64_t value) const -> void {
+        emit(writer, spec, value);
     }
 
-    auto operator()(const ph::process<name>& token) const -> void {
-        writer.write(token.spec, detail::procname().data());
+    auto operator()(std::uint64_t value) const -> void {
+        emit(writer, spec, value);
     }
 
-    __attribute__((noreturn))
-    auto operator()(const ph::thread<id>&) const -> void {
-        throw std::runtime_error("{thread:d} placeholder is not implemented yet");
+    auto operator()(double value) const -> void {
+        if (spec.kind == spec_t::kind_t::plain && spec.type == 0) {
+            writer.inner << value;
+        } else {
+            writer.write(spec.pattern, value);
+        }
     }
 
-    auto operator()(const ph::thread<hex>& token) const -> void {
+    auto operator()(const string_view& value) const -> void {
+        emit_view(writer, spec, value);
+    }
+
+    auto operator()(const attribute::view_t::function_type& value) const -> void {
+        value(writer);
+    }
+};
+
+auto thread_name(writer_t& writer, const spec_t& spec, const record_t& record) -> void {
+    const auto name = detail::this_thread::name(record.tid());
+
+    if (name.size() == 0) {
+        emit(writer, spec, string_view("<unnamed>"));
+    } else {
+        emit(writer, spec, name);
+    }
+}
+
+auto trace_id(writer_t& writer, const spec_t& spec, const record_t& record) -> void {
+    char buffer[32];
+    emit(writer, spec, detail::trace::trace_id(record.trace(), buffer));
+}
+
+auto span_id(writer_t& writer, const spec_t& spec, const record_t& record) -> void {
+    char buffer[16];
+    emit(writer, spec, detail::trace::span_id(record.trace(), buffer));
+}
+
+/// Returns the timestamp cache of the calling thread.
+auto timestamps() -> detail::datetime::cache_t& {
+    thread_local detail::datetime::cache_t cache;
+    return cache;
+}
+
+auto timestamp_user(writer_t& writer, const spec_t& spec, const ph::timestamp<user>& token,
+                    const record_t& record, detail::datetime::cache_t& cache) -> void
+{
+    const auto timestamp = record.timestamp();
+    const auto time = record_t::clock_type::to_time_t(timestamp);
+    const auto usec = std::chrono::duration_cast<
+        std::chrono::microseconds
+    >(timestamp.time_since_epoch()).count() % 1000000;
+
+    const auto& value = cache.format(token.pattern, token.generator, token.gmtime, time,
+        static_cast<std::uint64_t>(usec));
+    emit(writer, spec, string_view(value.data(), value.size()));
+}
+
+/// Executes compiled pattern programs.
+class executor_t {
+    writer_t& writer;
+    const record_t& record;
+    const severity_map& sevmap;
+    const program_t& program;
+    const missing_t missing;
+    const std::string& fallback;
+    detail::datetime::cache_t& cache;
+
+public:
+    executor_t(writer_t& writer,
+               const record_t& record,
+               const severity_map& sevmap,
+               const program_t& program,
+               missing_t missing,
+               const std::string& fallback,
+               detail::datetime::cache_t& cache) noexcept :
+        writer(writer),
+        record(record),
+        sevmap(sevmap),
+        program(program),
+        missing(missing),
+        fallback(fallback),
+        cache(cache)
+    {}
+
+    auto run() -> void {
+        resolved_type resolved;
+
+        if (!program.names.empty()) {
+            resolve(program.names, record.attributes(), resolved);
+        }
+
+        for (const auto& instruction : program.code) {
+            const auto& spec = program.specs[instruction.spec];
+
+            switch (instruction.opcode) {
+            case opcode_t::literal:
+                writer.inner << string_ref(program.arena.data() + instruction.offset, instruction.size);
+                break;
+            case opcode_t::message:
+                emit_view(writer, spec, record.formatted());
+                break;
+            case opcode_t::process_id:
+                emit(writer, spec, record.pid());
+                break;
+            case opcode_t::process_name:
+                emit(writer, spec, detail::procname());
+                break;
+            case opcode_t::host_name:
+                emit(writer, spec, detail::this_process::host());
+                break;
+            case opcode_t::host_fqdn:
+                emit(writer, spec, detail::this_process::fqdn());
+                break;
+            case opcode_t::thread_id:
+                emit(writer, spec, record.lwp());
+                break;
+            case opcode_t::thread_hex:
 #ifdef __linux__
-        writer.write(token.spec, record.tid());
+                writer.write(spec.pattern, record.tid());
 #elif __APPLE__
-        writer.write(token.spec, reinterpret_cast<unsigned long>(record.tid()));
+                writer.write(spec.pattern, reinterpret_cast<unsigned long>(record.tid()));
 #endif
+                break;
+            case opcode_t::thread_name:
+                thread_name(writer, spec, record);
+                break;
+            case opcode_t::trace_id:
+                trace_id(writer, spec, record);
+                break;
+            case opcode_t::span_id:
+                span_id(writer, spec, record);
+                break;
+            case opcode_t::severity_num:
+                emit(writer, spec, static_cast<int>(record.severity()));
+                break;
+            case opcode_t::severity_user:
+                severity_user(spec, instruction);
+                break;
+            case opcode_t::timestamp_num:
+                timestamp_num(spec);
+                break;
+            case opcode_t::timestamp_user:
+                timestamp_user(writer, spec,
+                    boost::get<ph::timestamp<user>>(program.tokens[instruction.operand]), record,
+                    cache);
+                break;
+            case opcode_t::required:
+                if (!required_attribute(spec, instruction, resolved)) {
+                    return writer.skip();
+                }
+                break;
+            case opcode_t::optional:
+                optional_attribute(spec, instruction, resolved);
+                break;
+            case opcode_t::leftover:
+                leftover(spec, instruction);
+                break;
+            }
+        }
     }
 
-    auto operator()(const ph::thread<name>& token) const -> void {
-        std::array<char, 16> buffer;
-        const auto rc = ::pthread_getname_np(record.tid(), buffer.data(), buffer.size());
+private:
+    /// Writes the rendered severity name if there is such one, formatting it otherwise.
+    auto severity_user(const spec_t& spec, const instruction_t& instruction) -> void {
+        const auto severity = static_cast<int>(record.severity());
 
-        if (rc == 0) {
-            writer.write(token.spec, buffer.data());
+        if (severity >= 0 && static_cast<std::uint32_t>(severity) < instruction.size) {
+            const auto bound = program.bounds.data() + instruction.offset + severity;
+            writer.inner << string_ref(program.arena.data() + bound[0], bound[1] - bound[0]);
         } else {
-            writer.write(token.spec, "<unnamed>");
+            sevmap(severity, spec.pattern, writer);
         }
     }
 
-    auto operator()(const ph::severity<num>& token) const -> void {
-        writer.write(token.spec, record.severity());
-    }
-
-    auto operator()(const ph::severity<user>& token) const -> void {
-        sevmap(record.severity(), token.spec, writer);
-    }
-
-    auto operator()(const ph::timestamp<num>& token) const -> void {
+    auto timestamp_num(const spec_t& spec) -> void {
         const auto timestamp = record.timestamp();
         const auto usec = std::chrono::duration_cast<
             std::chrono::microseconds
         >(timestamp.time_since_epoch()).count();
 
-        writer.write(token.spec, usec);
+        emit(writer, spec, static_cast<std::int64_t>(usec));
     }
 
-    auto operator()(const ph::timestamp<user>& token) const -> void {
-        const auto timestamp = record.timestamp();
-        const auto time = record_t::clock_type::to_time_t(timestamp);
-        const auto usec = std::chrono::duration_cast<
-            std::chrono::microseconds
-        >(timestamp.time_since_epoch()).count() % 1000000;
 
-        std::tm tm;
-        if (token.gmtime) {
-            ::gmtime_r(&time, &tm);
-        } else {
-            ::localtime_r(&time, &tm);
+    /// Renders the required attribute, returning `false` if the record must be skipped.
+    auto required_attribute(const spec_t& spec, const instruction_t& instruction,
+                            const resolved_type& resolved) -> bool
+    {
+        if (auto value = resolved[instruction.operand]) {
+            boost::apply_visitor(spec_visitor_t(writer, spec), value->inner().value);
+            return true;
         }
 
-        fmt::MemoryWriter buffer;
-        token.generator(buffer, tm, static_cast<std::uint64_t>(usec));
-        writer.write(token.spec, string_ref(buffer.data(), buffer.size()));
-    }
-
-    auto operator()(const ph::generic<required>& token) const -> void {
-        if (auto value = find(token.name)) {
-            return boost::apply_visitor(view_visitor<spec>(writer, token.spec), value->inner().value);
+        switch (missing) {
+        case missing_t::fallback:
+            writer.inner << string_ref(fallback.data(), fallback.size());
+            return true;
+        case missing_t::skip:
+            return false;
+        case missing_t::throws:
+            break;
         }
 
-        throw std::logic_error("required attribute '" + token.name + "' not found");
+        throw std::logic_error("required attribute '" + program.names[instruction.operand].name +
+            "' not found");
     }
 
-    auto operator()(const ph::generic<optional>& token) const -> void {
-        if (auto value = find(token.name)) {
-            writer.write(token.prefix);
-            boost::apply_visitor(view_visitor<spec>(writer, token.spec), value->inner().value);
-            writer.write(token.suffix);
+    auto optional_attribute(const spec_t& spec, const instruction_t& instruction,
+                            const resolved_type& resolved) -> void
+    {
+        if (auto value = resolved[instruction.operand]) {
+            const auto data = program.arena.data() + instruction.offset;
+
+            writer.inner << string_ref(data, instruction.size);
+            boost::apply_visitor(spec_visitor_t(writer, spec), value->inner().value);
+            writer.inner << string_ref(data + instruction.size, instruction.suffix);
         }
     }
 
-    auto operator()(const ph::leftover_t& token) const -> void {
-        writer_t wr;
+    auto leftover(const spec_t& spec, const instruction_t& instruction) -> void {
+        const auto& token = boost::get<ph::leftover_t>(program.tokens[instruction.operand]);
+
+        if (spec.kind == spec_t::kind_t::custom || spec.type == 'd') {
+            writer_t wr;
+            evaluator_t(token)
+                .eval(wr, record.unique_attributes());
+
+            // Seems like cppformat doesn't initializes the data pointer until required which leads
+            // to conditional jump or move which depends on uninitialised value.
+            if (wr.inner.size() > 0) {
+                emit(writer, spec, string_view(wr.inner.data(), wr.inner.size()));
+            }
+
+            return;
+        }
+
+        // Render directly into the destination, fixing up alignment afterwards if required.
+        const auto position = writer.inner.size();
+
         evaluator_t(token)
-            .eval(wr, record.attributes());
+            .eval(writer, record.unique_attributes());
+
+        const auto size = writer.inner.size() - position;
 
-        // Seems like cppformat doesn't initializes the data pointer until required which leads to
-        // conditional jump or move which depends on uninitialised value.
-        if (wr.inner.size() > 0) {
-            writer.write(token.spec, string_ref(wr.inner.data(), wr.inner.size()));
+        if (size == 0 || spec.width <= size) {
+            return;
         }
-    }
 
-private:
-    auto find(const std::string& name) const -> boost::optional<attribute::view_t> {
-        for (const auto& attributes : record.attributes()) {
-            for (const auto& attribute : attributes.get()) {
-                if (attribute.first == name) {
-                    return attribute.second;
-                }
-            }
+        const auto fill = spec.width - size;
+        std::size_t left = 0;
+
+        switch (spec.align) {
+        case '>':
+            left = fill;
+            break;
+        case '^':
+            left = fill / 2;
+            break;
+        default:
+            break;
         }
 
-        return boost::none;
+        for (std::size_t id = 0; id < fill; ++id) {
+            writer.inner << spec.fill;
+        }
+
+        if (left > 0) {
+            // The buffer is owned by the writer, it's just not exposed for modification.
+            const auto data = const_cast<char*>(writer.inner.data()) + position;
+            std::rotate(data, data + size, data + size + left);
+        }
     }
 };
 
@@ -298,33 +635,174 @@ auto tokenize(const std::string& pattern) -> std::vector<token_t> {
 
 class string_t : public formatter_t {
     severity_map sevmap;
-    std::vector<token_t> tokens;
+    string::program_t program;
+    /// Program rendering the process id on each call, used in forked processes if the main one has
+    /// the process id rendered into literals.
+    string::program_t forked;
+    missing_t missing;
+    std::string fallback;
+    /// Expected size of the formatted record except the message.
+    std::size_t overhead;
 
 public:
     explicit string_t(const std::string& pattern) :
-        tokens(tokenize(pattern))
+        missing(missing_t::throws)
     {
         sevmap = [](int severity, const std::string& spec, writer_t& writer) {
             writer.write(spec, severity);
         };
+
+        compile(pattern);
     }
 
     string_t(const std::string& pattern, severity_map sevmap) :
         sevmap(std::move(sevmap)),
-        tokens(tokenize(pattern))
-    {}
+        missing(missing_t::throws)
+    {
+        compile(pattern);
+    }
+
+    /// Maps severities to the given names, rendering them with specifications of severity
+    /// placeholders, while others are formatted as numbers.
+    auto names(std::vector<std::string> names) -> void {
+        string::render(program, names);
+        string::render(forked, names);
+
+        sevmap = [names](int severity, const std::string& spec, writer_t& writer) {
+            if (severity >= 0 && static_cast<std::size_t>(severity) < names.size()) {
+                writer.write(spec, names[static_cast<std::size_t>(severity)]);
+            } else {
+                // Numbers are written as strings, since the specification is the one of names.
+                writer.write(spec, fmt::FormatInt(severity).c_str());
+            }
+        };
+    }
+
+    auto policy(missing_t missing, std::string fallback) -> void {
+        this->missing = missing;
+        this->fallback = std::move(fallback);
+    }
 
     auto format(const record_t& record, writer_t& writer) -> void override {
-        const visitor_t visitor(writer, record, sevmap);
+        executor_t(writer, record, sevmap, current(), missing, fallback, timestamps()).run();
+    }
+
+    /// Picks the program and looks the timestamp cache up once per batch, dispatching formatting
+    /// of records statically.
+    auto format_batch(const record_t* records, std::size_t size, writer_t& writer,
+        std::size_t* offsets, bool* skipped) -> void override
+    {
+        const auto& selected = current();
+        auto& cache = timestamps();
+
+        for (std::size_t id = 0; id < size; ++id) {
+            offsets[id] = writer.inner.size();
+
+            writer.skip(false);
+            executor_t(writer, records[id], sevmap, selected, missing, fallback, cache).run();
+
+            skipped[id] = writer.skipped();
+            if (skipped[id]) {
+                writer.inner.buffer().resize(offsets[id]);
+            }
+        }
+
+        offsets[size] = writer.inner.size();
+        writer.skip(false);
+    }
+
+    auto estimate(const record_t& record) const -> std::size_t override {
+        return overhead + record.formatted().size();
+    }
+
+private:
+    auto current() const noexcept -> const string::program_t& {
+        return program.pid == 0 || program.pid == detail::this_process::id() ? program : forked;
+    }
+
+    auto compile(const std::string& pattern) -> void {
+        auto tokens = tokenize(pattern);
+        program = string::compile(tokens);
+
+        if (program.pid != 0) {
+            forked = string::compile(std::move(tokens), false);
+        }
 
-        for (const auto& token : tokens) {
-            boost::apply_visitor(visitor, token);
+        // Literals are known exactly, while other placeholders are expected to be short.
+        overhead = 0;
+        for (const auto& instruction : program.code) {
+            switch (instruction.opcode) {
+            case string::opcode_t::literal:
+                overhead += instruction.size;
+                break;
+            case string::opcode_t::message:
+                break;
+            default:
+                overhead += 32;
+            }
         }
     }
 };
 
 }  // namespace formatter
 
+namespace detail {
+namespace formatter {
+namespace string {
+namespace pattern {
+
+auto emit(writer_t& writer, const spec_t& spec, const string_view& value) -> void {
+    blackhole::formatter::emit(writer, spec, value);
+}
+
+auto emit(writer_t& writer, const spec_t& spec, std::int64_t value) -> void {
+    blackhole::formatter::emit(writer, spec, value);
+}
+
+auto emit(writer_t& writer, const spec_t& spec, std::uint64_t value) -> void {
+    blackhole::formatter::emit(writer, spec, value);
+}
+
+auto thread_name(writer_t& writer, const spec_t& spec, const record_t& record) -> void {
+    blackhole::formatter::thread_name(writer, spec, record);
+}
+
+auto timestamp(writer_t& writer, const spec_t& spec, const ph::timestamp<user>& token,
+               const record_t& record) -> void
+{
+    blackhole::formatter::timestamp_user(writer, spec, token, record,
+        blackhole::formatter::timestamps());
+}
+
+auto required(writer_t& writer, const spec_t& spec, const interned_t& name, const record_t& record)
+    -> void
+{
+    for (const auto& attributes : record.attributes()) {
+        for (const auto& attribute : attributes.get()) {
+            const auto& key = attribute.first;
+
+            if (key.size() != name.name.size()) {
+                continue;
+            }
+
+            // Attributes with interned keys share the storage of the interned name.
+            if (key.data() == name.key.name().data() ||
+                std::memcmp(key.data(), name.name.data(), key.size()) == 0)
+            {
+                const blackhole::formatter::spec_visitor_t visitor(writer, spec);
+                return boost::apply_visitor(visitor, attribute.second.inner().value);
+            }
+        }
+    }
+
+    throw std::logic_error("required attribute '" + name.name + "' not found");
+}
+
+}  // namespace pattern
+}  // namespace string
+}  // namespace formatter
+}  // namespace detail
+
 using formatter::severity_map;
 using formatter::string_t;
 
@@ -332,29 +810,65 @@ class builder<string_t>::inner_t {
 public:
     std::string pattern;
     severity_map sevmap;
+    std::vector<std::string> names;
+    formatter::missing_t missing;
+    std::string fallback;
 };
 
 builder<string_t>::builder(std::string pattern) :
-    p(new inner_t{std::move(pattern), {}}, deleter_t())
+    p(new inner_t{std::move(pattern), {}, {}, formatter::missing_t::throws, {}}, deleter_t())
 {}
 
 // TODO: TEST!
 auto builder<string_t>::mapping(formatter::severity_map sevmap) & -> builder& {
     p->sevmap = std::move(sevmap);
+    p->names.clear();
     return *this;
 }
 
 auto builder<string_t>::mapping(formatter::severity_map sevmap) && -> builder&& {
-    p->sevmap = std::move(sevmap);
-    return std::move(*this);
+    return std::move(mapping(std::move(sevmap)));
+}
+
+auto builder<string_t>::mapping(std::vector<std::string> names) & -> builder& {
+    p->sevmap = nullptr;
+    p->names = std::move(names);
+    return *this;
+}
+
+auto builder<string_t>::mapping(std::vector<std::string> names) && -> builder&& {
+    return std::move(mapping(std::move(names)));
+}
+
+auto builder<string_t>::missing(formatter::missing_t policy, std::string fallback) & ->
+    builder&
+{
+    p->missing = policy;
+    p->fallback = std::move(fallback);
+    return *this;
+}
+
+auto builder<string_t>::missing(formatter::missing_t policy, std::string fallback) && ->
+    builder&&
+{
+    return std::move(missing(policy, std::move(fallback)));
 }
 
 auto builder<string_t>::build() && -> std::unique_ptr<formatter_t> {
+    std::unique_ptr<string_t> result;
+
     if (p->sevmap) {
-        return blackhole::make_unique<string_t>(std::move(p->pattern), std::move(p->sevmap));
+        result = blackhole::make_unique<string_t>(std::move(p->pattern), std::move(p->sevmap));
     } else {
-        return blackhole::make_unique<string_t>(std::move(p->pattern));
+        result = blackhole::make_unique<string_t>(std::move(p->pattern));
+    }
+
+    if (!p->names.empty()) {
+        result->names(std::move(p->names));
     }
+
+    result->policy(p->missing, std::move(p->fallback));
+    return result;
 }
 
 auto factory<string_t>::type() const noexcept -> const char* {
@@ -364,26 +878,51 @@ auto factory<string_t>::type() const noexcept -> const char* {
 auto factory<string_t>::from(const config::node_t& config) const -> std::unique_ptr<formatter_t> {
     auto pattern = config["pattern"].to_string().get();
 
+    auto missing = formatter::missing_t::throws;
+    if (auto policy = config["missing"].to_string()) {
+        if (policy.get() == "fallback") {
+            missing = formatter::missing_t::fallback;
+        } else if (policy.get() == "skip") {
+            missing = formatter::missing_t::skip;
+        } else if (policy.get() != "throw") {
+            throw std::invalid_argument("missing attribute policy must be either \"throw\", "
+                "\"fallback\" or \"skip\"");
+        }
+    }
+
+    auto fallback = config["fallback"].to_string().get_value_or("");
+
+    builder<string_t> builder(std::move(pattern));
+
     if (auto mapping = config["sevmap"]) {
-        std::vector<std::string> sevmap;
+        std::vector<std::string> names;
         mapping.each([&](const config::node_t& config) {
-            sevmap.emplace_back(config.to_string());
+            names.emplace_back(config.to_string());
         });
 
-        auto fn = [=](std::size_t severity, const std::string& spec, writer_t& writer) {
-            if (severity < sevmap.size()) {
-                writer.write(spec, sevmap[severity]);
-            } else {
-                writer.write(spec, severity);
-            }
-        };
+        builder.mapping(std::move(names));
+    }
 
-        return blackhole::make_unique<string_t>(std::move(pattern), std::move(fn));
+    builder.missing(missing, std::move(fallback));
+    return std::move(builder).build();
+}
+
+namespace detail {
+namespace formatter {
+namespace string {
+
+auto path(const std::string& pattern) -> std::unique_ptr<formatter_t> {
+    if (pattern.find('{') == std::string::npos) {
+        return nullptr;
     }
 
-    return blackhole::make_unique<string_t>(std::move(pattern));
+    return builder<blackhole::formatter::string_t>(pattern).build();
 }
 
+}  // namespace string
+}  // namespace formatter
+}  // namespace detail
+
 template auto deleter_t::operator()(builder<formatter::string_t>::inner_t* value) -> void;
 
 }  // namespace v1
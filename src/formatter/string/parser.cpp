@@ -54,6 +54,19 @@ public:
     }
 };
 
+template<>
+class spec_factory<ph::host<name>> : public factory<ph::host<name>> {
+public:
+    auto match(std::string spec) const -> token_t {
+        // The "fqdn" type may be followed by a regular specification, like "{host:fqdn:>20}".
+        if (spec.compare(0, 6, "{:fqdn") == 0 && (spec[6] == '}' || spec[6] == ':')) {
+            return ph::host<fqdn>(spec[6] == '}' ? std::string("{}") : "{" + spec.substr(6));
+        }
+
+        return ph::host<name>(std::move(spec));
+    }
+};
+
 template<>
 class spec_factory<ph::thread<hex>> : public factory<ph::thread<hex>> {
 public:
@@ -140,6 +153,14 @@ public:
     }
 };
 
+template<typename T>
+class spec_factory<ph::trace<T>> : public factory<ph::trace<T>> {
+public:
+    auto match(std::string spec) const -> token_t {
+        return ph::trace<T>(std::move(spec));
+    }
+};
+
 template<>
 class spec_factory<ph::leftover_t> : public factory<ph::leftover_t> {
 public:
@@ -155,9 +176,12 @@ parser_t::parser_t(std::string pattern) :
 {
     factories["message"]   = std::make_shared<spec_factory<ph::message_t>>();
     factories["process"]   = std::make_shared<spec_factory<ph::process<id>>>();
+    factories["host"]      = std::make_shared<spec_factory<ph::host<name>>>();
     factories["thread"]    = std::make_shared<spec_factory<ph::thread<hex>>>();
     factories["severity"]  = std::make_shared<spec_factory<ph::severity<user>>>();
     factories["timestamp"] = std::make_shared<spec_factory<ph::timestamp<user>>>();
+    factories["trace_id"]  = std::make_shared<spec_factory<ph::trace<id>>>();
+    factories["span_id"]   = std::make_shared<spec_factory<ph::trace<span>>>();
     factories["..."]       = std::make_shared<spec_factory<ph::leftover_t>>();
 }
 
@@ -0,0 +1,322 @@
+#include "blackhole/detail/formatter/string/program.hpp"
+
+#include <cctype>
+#include <limits>
+#include <stdexcept>
+
+#include <boost/variant/apply_visitor.hpp>
+
+#include "blackhole/extensions/writer.hpp"
+
+#include "blackhole/detail/process.hpp"
+#include "blackhole/detail/procname.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace detail {
+namespace formatter {
+namespace string {
+namespace {
+
+auto is_align(char ch) noexcept -> bool {
+    return ch == '<' || ch == '>' || ch == '^';
+}
+
+class compiler_t : public boost::static_visitor<> {
+    program_t& program;
+    const bool fold;
+
+public:
+    compiler_t(program_t& program, bool fold) noexcept :
+        program(program),
+        fold(fold)
+    {}
+
+    auto operator()(const literal_t& token) -> void {
+        if (token.value.empty()) {
+            return;
+        }
+
+        auto& code = program.code;
+
+        // Adjacent literals are merged, because they are placed contiguously in the arena.
+        if (code.empty() || code.back().opcode != opcode_t::literal) {
+            code.push_back({opcode_t::literal, size(program.arena.size()), 0, 0, 0, 0});
+        }
+
+        program.arena.append(token.value);
+        code.back().size += size(token.value.size());
+    }
+
+    auto operator()(const ph::message_t& token) -> void {
+        emit(opcode_t::message, token.spec);
+    }
+
+    auto operator()(const ph::process<id>& token) -> void {
+        const auto pid = this_process::id();
+
+        if (fold && constant(token.spec, pid)) {
+            program.pid = pid;
+        } else {
+            emit(opcode_t::process_id, token.spec);
+        }
+    }
+
+    auto operator()(const ph::process<name>& token) -> void {
+        if (!constant(token.spec, ref(procname()))) {
+            emit(opcode_t::process_name, token.spec);
+        }
+    }
+
+    auto operator()(const ph::host<name>& token) -> void {
+        if (!constant(token.spec, ref(this_process::host()))) {
+            emit(opcode_t::host_name, token.spec);
+        }
+    }
+
+    auto operator()(const ph::host<fqdn>& token) -> void {
+        if (!constant(token.spec, ref(this_process::fqdn()))) {
+            emit(opcode_t::host_fqdn, token.spec);
+        }
+    }
+
+    auto operator()(const ph::thread<id>& token) -> void {
+        emit(opcode_t::thread_id, token.spec);
+    }
+
+    auto operator()(const ph::thread<hex>& token) -> void {
+        emit(opcode_t::thread_hex, token.spec);
+    }
+
+    auto operator()(const ph::thread<name>& token) -> void {
+        emit(opcode_t::thread_name, token.spec);
+    }
+
+    auto operator()(const ph::trace<id>& token) -> void {
+        emit(opcode_t::trace_id, token.spec);
+    }
+
+    auto operator()(const ph::trace<span>& token) -> void {
+        emit(opcode_t::span_id, token.spec);
+    }
+
+    auto operator()(const ph::severity<num>& token) -> void {
+        emit(opcode_t::severity_num, token.spec);
+    }
+
+    auto operator()(const ph::severity<user>& token) -> void {
+        emit(opcode_t::severity_user, token.spec);
+    }
+
+    auto operator()(const ph::timestamp<num>& token) -> void {
+        emit(opcode_t::timestamp_num, token.spec);
+    }
+
+    auto operator()(const ph::timestamp<user>& token) -> void {
+        emit(opcode_t::timestamp_user, token.spec, keep(token));
+    }
+
+    auto operator()(const ph::generic<required>& token) -> void {
+        emit(opcode_t::required, token.spec, intern(token.name));
+    }
+
+    auto operator()(const ph::generic<optional>& token) -> void {
+        emit(opcode_t::optional, token.spec, intern(token.name));
+
+        // Optional placeholders additionally require their prefix and suffix, which are placed
+        // into the arena right after each other.
+        auto& instruction = program.code.back();
+        instruction.offset = size(program.arena.size());
+        instruction.size = size(token.prefix.size());
+        instruction.suffix = size(token.suffix.size());
+        program.arena.append(token.prefix);
+        program.arena.append(token.suffix);
+    }
+
+    auto operator()(const ph::leftover_t& token) -> void {
+        emit(opcode_t::leftover, token.spec, keep(token));
+    }
+
+private:
+    static auto size(std::size_t value) -> std::uint32_t {
+        if (value > std::numeric_limits<std::uint32_t>::max()) {
+            throw std::length_error("pattern is too long");
+        }
+
+        return static_cast<std::uint32_t>(value);
+    }
+
+    /// Renders the given value into a literal, returning `false` if the specification is not
+    /// applicable to it.
+    template<typename T>
+    auto constant(const std::string& spec, const T& value) -> bool {
+        writer_t writer;
+
+        try {
+            writer.write(spec, value);
+        } catch (const std::exception&) {
+            return false;
+        }
+
+        (*this)(literal_t(writer.result().to_string()));
+        return true;
+    }
+
+    static auto ref(const string_view& value) noexcept -> fmt::StringRef {
+        return fmt::StringRef(value.data(), value.size());
+    }
+
+    auto emit(opcode_t opcode, const std::string& spec, std::uint32_t operand = 0) -> void {
+        program.specs.push_back(parse(spec));
+        program.code.push_back({opcode, 0, 0, 0, size(program.specs.size() - 1), operand});
+    }
+
+    template<typename T>
+    auto keep(const T& token) -> std::uint32_t {
+        program.tokens.emplace_back(token);
+        return size(program.tokens.size() - 1);
+    }
+
+    auto intern(const std::string& name) -> std::uint32_t {
+        auto& names = program.names;
+
+        for (std::size_t id = 0; id < names.size(); ++id) {
+            if (names[id].name == name) {
+                return size(id);
+            }
+        }
+
+        names.push_back({name, interned_t::hash_of(name.data(), name.size()), attribute::key_t(name)});
+        return size(names.size() - 1);
+    }
+};
+
+}  // namespace
+
+auto parse(const std::string& spec) -> spec_t {
+    spec_t result{spec_t::kind_t::custom, ' ', 0, 0, 0, spec};
+
+    if (spec.size() < 2 || spec.front() != '{' || spec.back() != '}') {
+        return result;
+    }
+
+    // Strip braces and an optional colon.
+    auto pos = spec.begin() + 1;
+    const auto end = spec.end() - 1;
+
+    if (pos != end && *pos == ':') {
+        ++pos;
+    }
+
+    if (pos == end) {
+        result.kind = spec_t::kind_t::plain;
+        return result;
+    }
+
+    if (end - pos >= 2 && is_align(*(pos + 1)) && *pos != '{' && *pos != '}') {
+        result.fill = *pos;
+        result.align = *(pos + 1);
+        pos += 2;
+    } else if (is_align(*pos)) {
+        result.align = *pos;
+        ++pos;
+    }
+
+    // Leading zero means zero-padding in cppformat, which is sign-aware.
+    if (pos != end && *pos == '0') {
+        return result;
+    }
+
+    unsigned int width = 0;
+    for (; pos != end && std::isdigit(static_cast<unsigned char>(*pos)); ++pos) {
+        width = width * 10 + static_cast<unsigned int>(*pos - '0');
+
+        if (width > 1024 * 1024) {
+            return result;
+        }
+    }
+
+    if (pos != end && (*pos == 's' || *pos == 'd')) {
+        result.type = *pos;
+        ++pos;
+    }
+
+    if (pos != end) {
+        return result;
+    }
+
+    result.width = width;
+    result.kind = result.align == 0 && width == 0 ? spec_t::kind_t::plain : spec_t::kind_t::align;
+
+    return result;
+}
+
+auto interned_t::hash_of(const char* data, std::size_t size) noexcept -> std::uint64_t {
+    std::uint64_t result = 14695981039346656037ULL;
+
+    for (std::size_t id = 0; id < size; ++id) {
+        result ^= static_cast<unsigned char>(data[id]);
+        result *= 1099511628211ULL;
+    }
+
+    return result;
+}
+
+auto compile(std::vector<token_t> tokens, bool fold) -> program_t {
+    program_t program;
+
+    compiler_t compiler(program, fold);
+    for (const auto& token : tokens) {
+        boost::apply_visitor(compiler, token);
+    }
+
+    return program;
+}
+
+auto render(program_t& program, const std::vector<std::string>& names) -> void {
+    if (names.empty() || names.size() >= std::numeric_limits<std::uint32_t>::max()) {
+        return;
+    }
+
+    for (auto& instruction : program.code) {
+        if (instruction.opcode != opcode_t::severity_user) {
+            continue;
+        }
+
+        const auto& spec = program.specs[instruction.spec];
+
+        writer_t writer;
+        std::vector<std::uint32_t> bounds;
+
+        try {
+            for (const auto& name : names) {
+                bounds.push_back(static_cast<std::uint32_t>(writer.inner.size()));
+                writer.write(spec.pattern, fmt::StringRef(name.data(), name.size()));
+            }
+        } catch (const std::exception&) {
+            continue;
+        }
+
+        bounds.push_back(static_cast<std::uint32_t>(writer.inner.size()));
+
+        const auto base = program.arena.size();
+        if (base + writer.inner.size() > std::numeric_limits<std::uint32_t>::max()) {
+            throw std::length_error("pattern is too long");
+        }
+
+        program.arena.append(writer.inner.data(), writer.inner.size());
+
+        instruction.offset = static_cast<std::uint32_t>(program.bounds.size());
+        instruction.size = static_cast<std::uint32_t>(names.size());
+
+        for (auto bound : bounds) {
+            program.bounds.push_back(static_cast<std::uint32_t>(base + bound));
+        }
+    }
+}
+
+}  // namespace string
+}  // namespace formatter
+}  // namespace detail
+}  // namespace v1
+}  // namespace blackhole
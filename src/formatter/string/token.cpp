@@ -63,6 +63,18 @@ process<T>::process() : spec("{}") {}
 template<typename T>
 process<T>::process(std::string spec) : spec(std::move(spec)) {}
 
+template<typename T>
+host<T>::host() : spec("{}") {}
+
+template<typename T>
+host<T>::host(std::string spec) : spec(std::move(spec)) {}
+
+template<typename T>
+trace<T>::trace() : spec("{}") {}
+
+template<typename T>
+trace<T>::trace(std::string spec) : spec(std::move(spec)) {}
+
 template<typename T>
 thread<T>::thread() : spec("{}") {}
 
@@ -96,9 +108,15 @@ template struct severity<user>;
 template struct process<id>;
 template struct process<name>;
 
+template struct host<name>;
+template struct host<fqdn>;
+
 template struct thread<id>;
 template struct thread<name>;
 
+template struct trace<id>;
+template struct trace<span>;
+
 template struct attribute<name>;
 template struct attribute<value>;
 
@@ -1,9 +1,28 @@
 #include "blackhole/handler.hpp"
 
+#include "blackhole/pressure.hpp"
+#include "blackhole/record.hpp"
+
 namespace blackhole {
 inline namespace v1 {
 
 handler_t::~handler_t() = default;
 
+auto handler_t::handle_batch(const record_t* records, std::size_t size) -> void {
+    for (std::size_t id = 0; id < size; ++id) {
+        handle(records[id]);
+    }
+}
+
+auto handler_t::flush(std::chrono::steady_clock::time_point) -> bool {
+    return true;
+}
+
+auto handler_t::collect(metrics::collector_t&) const -> void {}
+
+auto handler_t::pressure() const -> pressure_t {
+    return pressure_t();
+}
+
 }  // namespace v1
 }  // namespace blackhole
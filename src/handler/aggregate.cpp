@@ -0,0 +1,615 @@
+#include "blackhole/handler/aggregate.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+
+#include <boost/optional/optional.hpp>
+#include <boost/variant/apply_visitor.hpp>
+
+#include "blackhole/attribute.hpp"
+#include "blackhole/attributes.hpp"
+#include "blackhole/config/node.hpp"
+#include "blackhole/config/option.hpp"
+#include "blackhole/extensions/format.hpp"
+#include "blackhole/extensions/writer.hpp"
+#include "blackhole/metrics.hpp"
+#include "blackhole/pressure.hpp"
+#include "blackhole/record.hpp"
+#include "blackhole/registry.hpp"
+
+#include "blackhole/detail/attribute.hpp"
+#include "blackhole/detail/memory.hpp"
+#include "blackhole/detail/util/deleter.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace handler {
+namespace {
+
+using attribute::view_t;
+
+/// Separates label values in table keys.
+constexpr char separator = '\x1f';
+
+/// Appends attribute values formatted as label values to the key.
+class label_t : public boost::static_visitor<> {
+    std::string& key;
+
+public:
+    explicit label_t(std::string& key) noexcept :
+        key(key)
+    {}
+
+    auto operator()(const view_t::null_type&) const -> void {}
+
+    auto operator()(const view_t::bool_type& value) const -> void {
+        key += value ? "true" : "false";
+    }
+
+    template<typename T>
+    auto operator()(const T& value) const -> void {
+        const fmt::FormatInt formatted(value);
+        key.append(formatted.data(), formatted.size());
+    }
+
+    auto operator()(const view_t::double_type& value) const -> void {
+        key += fmt::format("{}", value);
+    }
+
+    auto operator()(const view_t::string_type& value) const -> void {
+        key.append(value.data(), value.size());
+    }
+
+    auto operator()(const view_t::function_type& value) const -> void {
+        writer_t writer;
+        value(writer);
+        const auto result = writer.result();
+        key.append(result.data(), result.size());
+    }
+};
+
+/// Converts numeric attribute values, yielding none for other ones.
+class number_t : public boost::static_visitor<boost::optional<double>> {
+public:
+    auto operator()(const view_t::sint64_type& value) const -> boost::optional<double> {
+        return static_cast<double>(value);
+    }
+
+    auto operator()(const view_t::uint64_type& value) const -> boost::optional<double> {
+        return static_cast<double>(value);
+    }
+
+    auto operator()(const view_t::double_type& value) const -> boost::optional<double> {
+        return value;
+    }
+
+    template<typename T>
+    auto operator()(const T&) const -> boost::optional<double> {
+        return boost::none;
+    }
+};
+
+auto find(const record_t& record, const std::string& name) -> const view_t* {
+    for (const auto& list : record.attributes()) {
+        for (const auto& it : list.get()) {
+            if (it.first.size() == name.size() &&
+                std::equal(name.begin(), name.end(), it.first.data()))
+            {
+                return &it.second;
+            }
+        }
+    }
+
+    return nullptr;
+}
+
+/// Aggregated values of a single label values combination.
+struct cell_t {
+    std::uint64_t count;
+    double sum;
+    /// Non-cumulative bucket counts.
+    std::vector<std::uint64_t> buckets;
+
+    explicit cell_t(std::size_t buckets = 0) :
+        count(0),
+        sum(0.0),
+        buckets(buckets, 0)
+    {}
+
+    auto merge(const cell_t& other) -> void {
+        count += other.count;
+        sum += other.sum;
+        for (std::size_t id = 0; id < buckets.size(); ++id) {
+            buckets[id] += other.buckets[id];
+        }
+    }
+};
+
+typedef std::unordered_map<std::string, cell_t> table_type;
+
+/// Tables of a single thread, one per metric.
+struct shard_t {
+    std::mutex mutex;
+    /// Whether the shard is bound to a running thread.
+    std::atomic<bool> owned;
+    std::vector<table_type> tables;
+
+    explicit shard_t(std::size_t metrics) :
+        owned(true),
+        tables(metrics)
+    {}
+};
+
+/// Shards of the current thread for each aggregate handler it has handled records with.
+///
+/// Handlers are identified by unique numbers instead of addresses, which can be reused.
+struct bindings_t {
+    std::vector<std::pair<std::uint64_t, std::shared_ptr<shard_t>>> items;
+
+    ~bindings_t() {
+        for (const auto& item : items) {
+            item.second->owned.store(false, std::memory_order_release);
+        }
+    }
+
+    auto find(std::uint64_t id) const noexcept -> shard_t* {
+        for (const auto& item : items) {
+            if (item.first == id) {
+                return item.second.get();
+            }
+        }
+
+        return nullptr;
+    }
+};
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wglobal-constructors"
+#pragma clang diagnostic ignored "-Wexit-time-destructors"
+
+std::atomic<std::uint64_t> counter(0);
+
+thread_local bindings_t bindings;
+thread_local std::string scratch;
+
+#pragma clang diagnostic pop
+
+}  // namespace
+
+auto aggregate_t::metric_t::counter(std::string name, std::vector<std::string> labels) ->
+    metric_t
+{
+    return {std::move(name), type_t::counter, std::move(labels), std::string(), {},
+        std::numeric_limits<int>::min()};
+}
+
+auto aggregate_t::metric_t::histogram(std::string name, std::string attribute,
+    std::vector<double> buckets, std::vector<std::string> labels) -> metric_t
+{
+    return {std::move(name), type_t::histogram, std::move(labels), std::move(attribute),
+        std::move(buckets), std::numeric_limits<int>::min()};
+}
+
+class aggregate_t::inner_t {
+public:
+    const std::uint64_t id;
+
+    std::unique_ptr<handler_t> handler;
+    const std::vector<metric_t> metrics;
+    /// Attribute names of histogram buckets of each metric.
+    std::vector<std::vector<std::string>> bounds;
+    const std::chrono::milliseconds interval;
+    const severity_t severity;
+
+    /// Shards of all threads, either running or finished ones waiting for reuse.
+    std::mutex mutex;
+    std::vector<std::shared_ptr<shard_t>> shards;
+
+    /// Serializes emissions, which is required for flushing while the timer thread emits.
+    std::mutex emitting;
+
+    blackhole::metrics::counter_t aggregated;
+    blackhole::metrics::counter_t emitted;
+
+    bool stopped;
+    std::mutex stop_mutex;
+    std::condition_variable stop_cv;
+    std::thread thread;
+
+    inner_t(std::unique_ptr<handler_t> handler, std::vector<metric_t> metrics,
+            std::chrono::milliseconds interval, severity_t severity) :
+        id(++counter),
+        handler(std::move(handler)),
+        metrics(std::move(metrics)),
+        interval(interval),
+        severity(severity),
+        stopped(false)
+    {
+        for (const auto& metric : this->metrics) {
+            std::vector<std::string> names;
+            for (auto bound : metric.buckets) {
+                names.push_back(fmt::format("le_{}", bound));
+            }
+
+            bounds.push_back(std::move(names));
+        }
+    }
+
+    /// Returns the shard of the calling thread, binding one if there is no such shard yet.
+    auto local() -> shard_t& {
+        if (auto shard = bindings.find(id)) {
+            return *shard;
+        }
+
+        std::shared_ptr<shard_t> shard;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (const auto& item : shards) {
+                bool owned = false;
+                if (!item->owned.load(std::memory_order_relaxed) &&
+                    item->owned.compare_exchange_strong(owned, true, std::memory_order_acquire))
+                {
+                    // Aggregates of the finished thread are kept until the next emission.
+                    shard = item;
+                    break;
+                }
+            }
+
+            if (shard == nullptr) {
+                shard = std::make_shared<shard_t>(metrics.size());
+                shards.push_back(shard);
+            }
+        }
+
+        // Bindings of destroyed handlers are pruned here, since it's the only place they grow.
+        auto& items = bindings.items;
+        for (auto it = items.begin(); it != items.end();) {
+            if (it->second.use_count() == 1) {
+                it = items.erase(it);
+            } else {
+                ++it;
+            }
+        }
+
+        items.emplace_back(id, shard);
+        return *shard;
+    }
+
+    /// Formats label values of the given record into the key.
+    auto key(const metric_t& metric, const record_t& record, std::string& key) const -> void {
+        key.clear();
+
+        const label_t visitor(key);
+
+        for (const auto& label : metric.labels) {
+            if (label == "severity") {
+                visitor(static_cast<std::int64_t>(record.severity()));
+            } else if (const auto value = find(record, label)) {
+                boost::apply_visitor(visitor, value->inner().value);
+            }
+
+            key.push_back(separator);
+        }
+    }
+
+    auto run() -> void {
+        std::unique_lock<std::mutex> lock(stop_mutex);
+
+        while (!stopped) {
+            stop_cv.wait_for(lock, interval);
+
+            if (!stopped) {
+                lock.unlock();
+                emit();
+                lock.lock();
+            }
+        }
+    }
+
+    auto emit() -> void {
+        std::lock_guard<std::mutex> lock(emitting);
+
+        std::vector<std::shared_ptr<shard_t>> snapshot;
+
+        {
+            std::lock_guard<std::mutex> guard(mutex);
+            snapshot = shards;
+        }
+
+        // Combinations are ordered by their keys, so the output is stable between emissions.
+        std::vector<std::map<std::string, cell_t>> result(metrics.size());
+
+        for (const auto& shard : snapshot) {
+            std::vector<table_type> tables(metrics.size());
+
+            {
+                std::lock_guard<std::mutex> guard(shard->mutex);
+                tables.swap(shard->tables);
+            }
+
+            for (std::size_t id = 0; id < tables.size(); ++id) {
+                for (const auto& item : tables[id]) {
+                    auto it = result[id].find(item.first);
+                    if (it == result[id].end()) {
+                        result[id].insert(item);
+                    } else {
+                        it->second.merge(item.second);
+                    }
+                }
+            }
+        }
+
+        for (std::size_t id = 0; id < metrics.size(); ++id) {
+            for (const auto& item : result[id]) {
+                emit(id, item.first, item.second);
+            }
+        }
+    }
+
+private:
+    auto emit(std::size_t id, const std::string& key, const cell_t& cell) -> void {
+        const auto& metric = metrics[id];
+
+        attribute_list attributes;
+
+        std::size_t position = 0;
+        for (const auto& label : metric.labels) {
+            const auto end = key.find(separator, position);
+            attributes.emplace_back(label, string_view(key.data() + position, end - position));
+            position = end + 1;
+        }
+
+        attributes.emplace_back("count", cell.count);
+
+        if (metric.type == metric_t::type_t::histogram) {
+            attributes.emplace_back("sum", cell.sum);
+
+            std::uint64_t cumulative = 0;
+            for (std::size_t bucket = 0; bucket < cell.buckets.size(); ++bucket) {
+                cumulative += cell.buckets[bucket];
+                attributes.emplace_back(bounds[id][bucket], cumulative);
+            }
+        }
+
+        const attribute_pack pack{attributes};
+        const string_view message(metric.name.data(), metric.name.size());
+
+        record_t record(severity, message, pack);
+        record.activate(message);
+
+        handler->handle(record);
+        emitted.add();
+    }
+};
+
+constexpr std::chrono::milliseconds aggregate_t::default_interval;
+
+aggregate_t::aggregate_t(std::unique_ptr<handler_t> handler, std::vector<metric_t> metrics,
+                         std::chrono::milliseconds interval, severity_t severity)
+{
+    if (metrics.empty()) {
+        throw std::invalid_argument("aggregate handler must have at least one metric");
+    }
+
+    for (const auto& metric : metrics) {
+        if (metric.name.empty()) {
+            throw std::invalid_argument("aggregated metric must have a name");
+        }
+
+        if (metric.type == metric_t::type_t::histogram && metric.attribute.empty()) {
+            throw std::invalid_argument("histogram " + metric.name + " must have an attribute");
+        }
+
+        for (std::size_t id = 1; id < metric.buckets.size(); ++id) {
+            if (metric.buckets[id - 1] >= metric.buckets[id]) {
+                throw std::invalid_argument("buckets of histogram " + metric.name +
+                    " must be increasing");
+            }
+        }
+    }
+
+    d.reset(new inner_t(std::move(handler), std::move(metrics), interval, severity));
+
+    if (interval.count() > 0) {
+        d->thread = std::thread(&inner_t::run, d.get());
+    }
+}
+
+aggregate_t::~aggregate_t() {
+    if (d->thread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(d->stop_mutex);
+            d->stopped = true;
+        }
+
+        d->stop_cv.notify_one();
+        d->thread.join();
+    }
+
+    try {
+        d->emit();
+    } catch (...) {
+        // Nothing can be done with aggregates failing to be emitted on destruction.
+    }
+}
+
+auto aggregate_t::handle(const record_t& record) -> void {
+    auto& shard = d->local();
+    auto& key = scratch;
+
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    for (std::size_t id = 0; id < d->metrics.size(); ++id) {
+        const auto& metric = d->metrics[id];
+        if (record.severity() < metric.threshold) {
+            continue;
+        }
+
+        boost::optional<double> value;
+        if (metric.type == metric_t::type_t::histogram) {
+            if (const auto attribute = find(record, metric.attribute)) {
+                value = boost::apply_visitor(number_t(), attribute->inner().value);
+            }
+
+            if (!value) {
+                continue;
+            }
+        }
+
+        d->key(metric, record, key);
+
+        auto& table = shard.tables[id];
+        auto it = table.find(key);
+        if (it == table.end()) {
+            it = table.emplace(key, cell_t(metric.buckets.size())).first;
+        }
+
+        auto& cell = it->second;
+        ++cell.count;
+
+        if (value) {
+            cell.sum += *value;
+
+            const auto bucket = std::lower_bound(metric.buckets.begin(), metric.buckets.end(),
+                *value) - metric.buckets.begin();
+            if (static_cast<std::size_t>(bucket) < cell.buckets.size()) {
+                ++cell.buckets[static_cast<std::size_t>(bucket)];
+            }
+        }
+    }
+
+    d->aggregated.add();
+}
+
+auto aggregate_t::flush(std::chrono::steady_clock::time_point deadline) -> bool {
+    d->emit();
+    return d->handler->flush(deadline);
+}
+
+auto aggregate_t::collect(metrics::collector_t& collector) const -> void {
+    collector.counter("blackhole_aggregate_records_total", d->aggregated.get());
+    collector.counter("blackhole_aggregate_emitted_total", d->emitted.get());
+
+    d->handler->collect(collector);
+}
+
+auto aggregate_t::pressure() const -> pressure_t {
+    return d->handler->pressure();
+}
+
+auto aggregate_t::emit() -> void {
+    d->emit();
+}
+
+}  // namespace handler
+
+using handler::aggregate_t;
+
+class builder<aggregate_t>::inner_t {
+public:
+    std::unique_ptr<handler_t> handler;
+    std::vector<aggregate_t::metric_t> metrics;
+    std::chrono::milliseconds interval;
+    severity_t severity;
+};
+
+builder<aggregate_t>::builder(std::unique_ptr<handler_t> handler) :
+    d(new inner_t{std::move(handler), {}, aggregate_t::default_interval, 0})
+{}
+
+auto builder<aggregate_t>::add(aggregate_t::metric_t metric) & -> builder& {
+    d->metrics.push_back(std::move(metric));
+    return *this;
+}
+
+auto builder<aggregate_t>::add(aggregate_t::metric_t metric) && -> builder&& {
+    return std::move(add(std::move(metric)));
+}
+
+auto builder<aggregate_t>::interval(std::chrono::milliseconds value) & -> builder& {
+    d->interval = value;
+    return *this;
+}
+
+auto builder<aggregate_t>::interval(std::chrono::milliseconds value) && -> builder&& {
+    return std::move(interval(value));
+}
+
+auto builder<aggregate_t>::severity(severity_t value) & -> builder& {
+    d->severity = value;
+    return *this;
+}
+
+auto builder<aggregate_t>::severity(severity_t value) && -> builder&& {
+    return std::move(severity(value));
+}
+
+auto builder<aggregate_t>::build() && -> std::unique_ptr<aggregate_t> {
+    return blackhole::make_unique<aggregate_t>(std::move(d->handler), std::move(d->metrics),
+        d->interval, d->severity);
+}
+
+auto factory<aggregate_t>::type() const noexcept -> const char* {
+    return "aggregate";
+}
+
+auto factory<aggregate_t>::from(const config::node_t& config) const -> std::unique_ptr<handler_t> {
+    auto inner = config["handler"];
+    if (!inner) {
+        throw std::invalid_argument("aggregate handler must have a wrapped handler");
+    }
+
+    const auto type = inner["type"].to_string().get_value_or("blocking");
+    builder<aggregate_t> builder(registry.handler(type)(*inner.unwrap()));
+
+    config["metrics"].each([&](const config::node_t& config) {
+        const auto name = config["name"].to_string().get_value_or("");
+
+        std::vector<std::string> labels;
+        config["labels"].each([&](const config::node_t& label) {
+            labels.push_back(label.to_string());
+        });
+
+        const auto kind = config["type"].to_string().get_value_or("counter");
+
+        auto metric = aggregate_t::metric_t::counter(name, std::move(labels));
+        if (kind == "histogram") {
+            metric.type = aggregate_t::metric_t::type_t::histogram;
+            metric.attribute = config["attribute"].to_string().get_value_or("");
+            config["buckets"].each([&](const config::node_t& bound) {
+                metric.buckets.push_back(bound.to_double());
+            });
+        } else if (kind != "counter") {
+            throw std::invalid_argument("unknown aggregated metric type: " + kind);
+        }
+
+        if (auto threshold = config["threshold"].to_sint64()) {
+            metric.threshold = static_cast<int>(threshold.get());
+        }
+
+        builder.add(std::move(metric));
+    });
+
+    if (auto interval = config["interval"].to_uint64()) {
+        builder.interval(std::chrono::milliseconds(interval.get()));
+    }
+
+    if (auto severity = config["severity"].to_sint64()) {
+        builder.severity(static_cast<int>(severity.get()));
+    }
+
+    return std::move(builder).build();
+}
+
+template auto deleter_t::operator()(builder<handler::aggregate_t>::inner_t*) -> void;
+
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,877 @@
+#include "blackhole/handler/asynchronous.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <limits>
+
+#include <boost/container/vector.hpp>
+#include <boost/optional/optional.hpp>
+
+#include "blackhole/config/node.hpp"
+#include "blackhole/config/option.hpp"
+#include "blackhole/executor.hpp"
+#include "blackhole/extensions/writer.hpp"
+#include "blackhole/formatter.hpp"
+#include "blackhole/metrics.hpp"
+#include "blackhole/pressure.hpp"
+#include "blackhole/registry.hpp"
+#include "blackhole/sink.hpp"
+
+#include "blackhole/detail/budget.hpp"
+#include "blackhole/detail/error.hpp"
+#include "blackhole/detail/memory.hpp"
+#include "blackhole/detail/util/deleter.hpp"
+
+#include "asynchronous.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace handler {
+namespace {
+
+auto exp2(std::size_t factor) -> std::size_t {
+    if (factor > 20) {
+        throw std::invalid_argument("factor should fit in [0; 20] range");
+    }
+
+    return static_cast<std::size_t>(std::exp2(factor));
+}
+
+/// Starts helper threads formatting slices of batches besides workers, if any.
+auto helpers(std::size_t parallel) -> std::unique_ptr<executor_t> {
+    if (parallel == 0) {
+        throw std::invalid_argument("formatting parallelism should be positive");
+    }
+
+    if (parallel == 1) {
+        return nullptr;
+    }
+
+    return blackhole::make_unique<executor_t>(parallel - 1);
+}
+
+/// Counts down slices formatted by helpers, which the worker waits for.
+class latch_t {
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::size_t count;
+
+public:
+    latch_t() :
+        count(0)
+    {}
+
+    auto add() -> void {
+        std::lock_guard<std::mutex> lock(mutex);
+        ++count;
+    }
+
+    auto done() -> void {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--count == 0) {
+            cv.notify_one();
+        }
+    }
+
+    auto wait() -> void {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [&] {
+            return count == 0;
+        });
+    }
+};
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wglobal-constructors"
+
+std::atomic<std::uint64_t> counter(0);
+
+#pragma clang diagnostic pop
+
+}  // namespace
+
+struct asynchronous_t::pending_t {
+    std::mutex mutex;
+
+    /// Handler the batch is enqueued to, reset when it is destroyed.
+    asynchronous_t* owner;
+    /// Whether the batch is bound to a running thread.
+    std::atomic<bool> owned;
+
+    std::vector<value_type> records;
+    /// Time the first record has been appended at.
+    std::chrono::steady_clock::time_point since;
+
+    explicit pending_t(asynchronous_t* owner) :
+        owner(owner),
+        owned(true)
+    {}
+
+    /// Enqueues remaining records on thread exit.
+    auto release() -> void {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        if (owner) {
+            try {
+                owner->handoff(*this, true);
+            } catch (...) {
+                // Nowhere to report, the thread is exiting.
+            }
+        }
+
+        owned.store(false, std::memory_order_release);
+    }
+};
+
+/// Pending batches of the current thread for each handler it has handled records with.
+///
+/// Handlers are identified by unique numbers instead of addresses, which can be reused.
+struct asynchronous_t::bindings_t {
+    std::vector<std::pair<std::uint64_t, std::shared_ptr<pending_t>>> items;
+
+    ~bindings_t() {
+        for (const auto& item : items) {
+            item.second->release();
+        }
+    }
+};
+
+struct asynchronous_t::slice_t {
+    const value_type* begin;
+    const value_type* end;
+
+    std::vector<record_t> records;
+
+    /// Formatted messages one after another.
+    writer_t writer;
+    /// Offsets of messages in the writer followed by the written size.
+    std::vector<std::size_t> offsets;
+    /// Whether records are skipped either by the formatter or due to formatting errors, which is
+    /// not a bit vector to be filled by formatters directly.
+    boost::container::vector<bool> skipped;
+};
+
+constexpr std::size_t asynchronous_t::default_factor;
+constexpr std::chrono::microseconds asynchronous_t::default_linger;
+constexpr std::size_t asynchronous_t::min_slice;
+
+asynchronous_t::asynchronous_t(std::unique_ptr<formatter_t> formatter,
+                               std::vector<std::unique_ptr<sink_t>> sinks,
+                               std::size_t factor,
+                               std::size_t workers,
+                               std::unique_ptr<sink::overflow_policy_t> overflow_policy,
+                               std::size_t batch,
+                               std::chrono::microseconds linger,
+                               std::size_t parallel) :
+    formatter(std::move(formatter)),
+    sinks(std::move(sinks)),
+    queue(exp2(factor)),
+    stopped(false),
+    overflow_policy(overflow_policy ?
+        std::move(overflow_policy) : sink::overflow_policy_factory_t().create("wait")),
+    underflow_policy(sink::underflow_policy_factory_t().create("wait")),
+    id(++counter),
+    batch(batch),
+    linger(linger),
+    parallel(parallel),
+    pool(helpers(parallel))
+{
+    if (workers == 0) {
+        throw std::invalid_argument("workers count should be positive");
+    }
+
+    if (batch == 0) {
+        throw std::invalid_argument("batch size should be positive");
+    }
+
+    if (linger.count() <= 0) {
+        throw std::invalid_argument("batch linger should be positive");
+    }
+
+    for (std::size_t id = 0; id < this->sinks.size(); ++id) {
+        statistics.push_back(blackhole::make_unique<statistics_t>());
+    }
+
+    threads.reserve(workers);
+
+    try {
+        for (std::size_t id = 0; id < workers; ++id) {
+            threads.emplace_back(std::bind(&asynchronous_t::run, this));
+        }
+    } catch (...) {
+        stopped.store(true);
+        underflow_policy->wakeup();
+        ready.notify();
+
+        for (auto& thread : threads) {
+            thread.join();
+        }
+
+        throw;
+    }
+}
+
+asynchronous_t::~asynchronous_t() {
+    {
+        // Bound threads may outlive the handler, so their batches are detached from it as well.
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const auto& pending : pendings) {
+            std::lock_guard<std::mutex> guard(pending->mutex);
+
+            try {
+                handoff(*pending, true);
+            } catch (...) {
+                pending->records.clear();
+            }
+
+            pending->owner = nullptr;
+        }
+    }
+
+    stopped.store(true);
+    underflow_policy->wakeup();
+    ready.notify();
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+auto asynchronous_t::handle(const record_t& record) -> void {
+    if (batch > 1) {
+        return accumulate(record);
+    }
+
+    const auto enqueue = [&]() -> bool {
+        if (!detail::budget::admit()) {
+            return false;
+        }
+
+        return queue.enqueue_with([&](item_t& item) {
+            item.record = value_type::capture(record, string_view());
+        });
+    };
+
+    submitted.add();
+
+    try {
+        if (enqueue() || overflow_policy->resolve(record, enqueue)) {
+            enqueued.add();
+            underflow_policy->wakeup();
+            return;
+        }
+    } catch (...) {
+        dropped.add();
+        completed.notify();
+        throw;
+    }
+
+    dropped.add();
+    completed.notify();
+}
+
+auto asynchronous_t::accumulate(const record_t& record) -> void {
+    auto& pending = local();
+
+    std::lock_guard<std::mutex> lock(pending.mutex);
+
+    const auto capture = [&]() -> bool {
+        if (!detail::budget::admit()) {
+            return false;
+        }
+
+        if (pending.records.empty()) {
+            pending.records.reserve(batch);
+            pending.since = std::chrono::steady_clock::now();
+        }
+
+        pending.records.push_back(value_type::capture(record, string_view()));
+        return true;
+    };
+
+    submitted.add();
+
+    try {
+        if (!capture() && !overflow_policy->resolve(record, capture)) {
+            dropped.add();
+            completed.notify();
+            return;
+        }
+    } catch (...) {
+        dropped.add();
+        completed.notify();
+        throw;
+    }
+
+    if (pending.records.size() >= batch) {
+        handoff(pending, true);
+    }
+}
+
+auto asynchronous_t::local() -> pending_t& {
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wexit-time-destructors"
+    thread_local bindings_t bindings;
+#pragma clang diagnostic pop
+
+    for (const auto& item : bindings.items) {
+        if (item.first == id) {
+            return *item.second;
+        }
+    }
+
+    const auto pending = std::make_shared<pending_t>(this);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        // Batches of finished threads have been enqueued on their exit.
+        pendings.erase(std::remove_if(pendings.begin(), pendings.end(),
+            [](const std::shared_ptr<pending_t>& pending) {
+                return !pending->owned.load(std::memory_order_acquire);
+            }), pendings.end());
+
+        pendings.push_back(pending);
+    }
+
+    // Bindings of destroyed handlers are pruned here, since it's the only place they grow.
+    auto& items = bindings.items;
+    items.erase(std::remove_if(items.begin(), items.end(),
+        [](const std::pair<std::uint64_t, std::shared_ptr<pending_t>>& item) {
+            return item.second.use_count() == 1;
+        }), items.end());
+
+    items.emplace_back(id, pending);
+    return *pending;
+}
+
+auto asynchronous_t::handoff(pending_t& pending, bool blocking) -> bool {
+    const auto size = pending.records.size();
+    if (size == 0) {
+        return false;
+    }
+
+    const auto enqueue = [&]() -> bool {
+        return queue.enqueue_with([&](item_t& item) {
+            item.batch = std::move(pending.records);
+        });
+    };
+
+    // The lock of the batch is held while enqueueing, so batches of a thread are enqueued in order
+    // even if they race with a sweeping worker.
+    const auto enqueued = enqueue() ||
+        (blocking && overflow_policy->resolve(pending.records.back().record(), enqueue));
+
+    if (enqueued) {
+        pending.records.clear();
+        this->enqueued.add(size);
+        underflow_policy->wakeup();
+        ready.notify();
+        return true;
+    }
+
+    if (blocking) {
+        pending.records.clear();
+        dropped.add(size);
+        completed.notify();
+    }
+
+    return false;
+}
+
+auto asynchronous_t::sweep(std::chrono::steady_clock::time_point before, bool blocking) -> bool {
+    std::vector<std::shared_ptr<pending_t>> pendings;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pendings = this->pendings;
+    }
+
+    auto result = false;
+
+    for (const auto& pending : pendings) {
+        std::unique_lock<std::mutex> lock(pending->mutex, std::defer_lock);
+
+        // The owning thread keeps appending to a locked batch, so it's not stale anyway.
+        if (blocking) {
+            lock.lock();
+        } else if (!lock.try_lock()) {
+            continue;
+        }
+
+        if (pending->owner && !pending->records.empty() && pending->since <= before) {
+            result = handoff(*pending, blocking) || result;
+        }
+    }
+
+    return result;
+}
+
+auto asynchronous_t::flush(std::chrono::steady_clock::time_point deadline) -> bool {
+    if (batch > 1) {
+        sweep(std::chrono::steady_clock::time_point::max(), true);
+    }
+
+    while (true) {
+        const auto key = completed.prepare();
+
+        if (idle()) {
+            completed.cancel();
+            break;
+        }
+
+        if (!completed.wait_until(key, deadline)) {
+            return false;
+        }
+    }
+
+    bool result = true;
+    for (const auto& sink : sinks) {
+        result = sink->flush(deadline) && result;
+    }
+
+    return result;
+}
+
+auto asynchronous_t::idle() const -> bool {
+    // Completions are loaded first, so if they catch up with submissions loaded after, there was a
+    // moment with no records in flight, since both counters only grow.
+    const auto completed = processed.get() + dropped.get();
+    return completed >= submitted.get();
+}
+
+auto asynchronous_t::run() -> void {
+    while (true) {
+        item_t result;
+        const auto dequeued = queue.dequeue_with([&](item_t& item) {
+            result = std::move(item);
+        });
+
+        if (dequeued) {
+            overflow_policy->wakeup();
+            process(result);
+            continue;
+        }
+
+        if (stopped) {
+            return;
+        }
+
+        if (batch == 1) {
+            underflow_policy->underflow([&]() -> bool {
+                return !queue.empty() || stopped;
+            });
+
+            continue;
+        }
+
+        // Batches of idle producers are enqueued by workers once they linger for too long.
+        const auto now = std::chrono::steady_clock::now();
+        if (sweep(now - linger, false)) {
+            continue;
+        }
+
+        const auto key = ready.prepare();
+        if (!queue.empty() || stopped) {
+            ready.cancel();
+            continue;
+        }
+
+        ready.wait_until(key, now + linger);
+    }
+}
+
+auto asynchronous_t::process(const item_t& item) -> void {
+    if (item.batch.empty()) {
+        return process(item.record);
+    }
+
+    process(item.batch);
+}
+
+auto asynchronous_t::process(const value_type& value) -> void {
+    const auto record = value.record();
+
+    try {
+        writer_t writer;
+
+        {
+            const metrics::timer_t timer(formatting);
+            formatter->format(record, writer);
+        }
+
+        const auto message = writer.result();
+
+        for (std::size_t id = 0; id < sinks.size() && !writer.skipped(); ++id) {
+            auto& current = *statistics[id];
+
+            {
+                const metrics::timer_t timer(current.emit);
+                sinks[id]->emit(record, message);
+            }
+
+            current.records.add();
+            current.bytes.add(message.size());
+        }
+    } catch (...) {
+        errors.add();
+        detail::error::report(error::kind_t::handler);
+    }
+
+    processed.add();
+    completed.notify();
+}
+
+auto asynchronous_t::process(const std::vector<value_type>& batch) -> void {
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wexit-time-destructors"
+    // Buffers of the worker are reused between batches.
+    thread_local std::vector<std::unique_ptr<slice_t>> slices;
+    thread_local std::vector<record_t> records;
+    thread_local std::vector<string_view> messages;
+    thread_local std::vector<sink_t::event_t> events;
+#pragma clang diagnostic pop
+
+    const auto count = std::max<std::size_t>(1, std::min(parallel, batch.size() / min_slice));
+    while (slices.size() < count) {
+        slices.emplace_back(new slice_t);
+    }
+
+    // Slices are contiguous and as even as possible, the first ones being larger by one record.
+    auto begin = batch.data();
+    for (std::size_t id = 0; id < count; ++id) {
+        const auto size = batch.size() / count + (id < batch.size() % count ? 1 : 0);
+        slices[id]->begin = begin;
+        slices[id]->end = begin + size;
+        begin += size;
+    }
+
+    // The worker formats the first slice itself, as well as ones the helpers queue rejects.
+    latch_t latch;
+    for (std::size_t id = 1; id < count; ++id) {
+        auto& slice = *slices[id];
+
+        latch.add();
+        const auto posted = pool->post([&] {
+            try {
+                format(slice);
+            } catch (...) {
+                // Formatting errors are reported per record, so there is nothing to add here.
+            }
+
+            latch.done();
+        });
+
+        if (!posted) {
+            format(slice);
+            latch.done();
+        }
+    }
+
+    format(*slices[0]);
+    latch.wait();
+
+    records.clear();
+    messages.clear();
+    events.clear();
+
+    records.reserve(batch.size());
+    messages.reserve(batch.size());
+
+    std::size_t bytes = 0;
+    for (std::size_t id = 0; id < count; ++id) {
+        const auto& slice = *slices[id];
+
+        for (std::size_t k = 0; k < slice.skipped.size(); ++k) {
+            if (slice.skipped[k]) {
+                continue;
+            }
+
+            const auto offset = slice.offsets[k];
+            const auto size = slice.offsets[k + 1] - offset;
+
+            records.emplace_back(slice.records[k]);
+            messages.emplace_back(slice.writer.inner.data() + offset, size);
+            bytes += size;
+        }
+    }
+
+    for (std::size_t id = 0; id < records.size(); ++id) {
+        events.push_back({&records[id], &messages[id]});
+    }
+
+    for (std::size_t id = 0; id < sinks.size() && !events.empty(); ++id) {
+        auto& current = *statistics[id];
+
+        try {
+            {
+                const metrics::timer_t timer(current.emit);
+                sinks[id]->emit_batch(events.data(), events.size());
+            }
+
+            current.records.add(events.size());
+            current.bytes.add(bytes);
+        } catch (...) {
+            errors.add();
+            detail::error::report(error::kind_t::handler);
+        }
+    }
+
+    records.clear();
+    processed.add(batch.size());
+    completed.notify();
+}
+
+auto asynchronous_t::format(slice_t& slice) -> void {
+    const auto size = static_cast<std::size_t>(slice.end - slice.begin);
+    const auto npos = std::numeric_limits<std::size_t>::max();
+
+    slice.records.clear();
+    for (auto it = slice.begin; it != slice.end; ++it) {
+        slice.records.push_back(it->record());
+    }
+
+    slice.offsets.assign(size + 1, npos);
+    slice.skipped.assign(size, false);
+
+    auto& writer = slice.writer;
+    writer.inner.clear();
+    writer.skip(false);
+
+    const auto start = std::chrono::steady_clock::now();
+
+    // Failed records are skipped, resuming the batch from the next one.
+    for (std::size_t done = 0; done < size;) {
+        const auto base = writer.inner.size();
+
+        try {
+            formatter->format_batch(slice.records.data() + done, size - done, writer,
+                slice.offsets.data() + done, slice.skipped.data() + done);
+            done = size;
+        } catch (...) {
+            errors.add();
+            detail::error::report(error::kind_t::handler);
+
+            // Offsets are stored in order before formatting each record, so the last stored one
+            // belongs to the failed record.
+            auto failed = done;
+            while (failed + 1 < size && slice.offsets[failed + 1] != npos) {
+                ++failed;
+            }
+
+            if (slice.offsets[failed] == npos) {
+                slice.offsets[failed] = base;
+            }
+
+            writer.inner.buffer().resize(slice.offsets[failed]);
+            writer.skip(false);
+            slice.skipped[failed] = true;
+
+            done = failed + 1;
+        }
+    }
+
+    slice.offsets[size] = writer.inner.size();
+
+    // Formatting time is accounted per record, evenly spread over the batch.
+    const auto elapsed = static_cast<std::uint64_t>(std::chrono::duration_cast<
+        std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+
+    for (std::size_t id = 0; id < size; ++id) {
+        formatting.record(elapsed / size);
+    }
+}
+
+auto asynchronous_t::collect(metrics::collector_t& collector) const -> void {
+    // Producers account records after enqueueing them, so workers may be seen ahead.
+    const auto processed = this->processed.get();
+    const auto enqueued = this->enqueued.get();
+
+    collector.counter("blackhole_queue_enqueued_total", enqueued);
+    collector.counter("blackhole_queue_dropped_total", dropped.get());
+    collector.gauge("blackhole_queue_depth", enqueued > processed ? enqueued - processed : 0);
+    collector.counter("blackhole_handler_records_total", processed);
+    collector.counter("blackhole_handler_errors_total", errors.get());
+    collector.histogram("blackhole_handler_format_seconds", formatting);
+
+    for (std::size_t id = 0; id < sinks.size(); ++id) {
+        const auto& current = *statistics[id];
+
+        auto labeled = collector.with("sink", std::to_string(id));
+        labeled.counter("blackhole_sink_records_total", current.records.get());
+        labeled.counter("blackhole_sink_bytes_total", current.bytes.get());
+        labeled.histogram("blackhole_sink_emit_seconds", current.emit);
+
+        sinks[id]->collect(labeled);
+    }
+}
+
+auto asynchronous_t::pressure() const -> pressure_t {
+    const auto processed = this->processed.get();
+    const auto enqueued = this->enqueued.get();
+    const auto depth = enqueued > processed ? enqueued - processed : 0;
+
+    pressure_t result(std::min(1.0,
+        static_cast<double>(depth) / static_cast<double>(queue.capacity())), dropped.get());
+
+    for (const auto& sink : sinks) {
+        result.merge(sink->pressure());
+    }
+
+    return result;
+}
+
+}  // namespace handler
+
+using handler::asynchronous_t;
+
+class builder<asynchronous_t>::inner_t {
+public:
+    std::unique_ptr<formatter_t> formatter;
+    std::vector<std::unique_ptr<sink_t>> sinks;
+    std::size_t factor;
+    std::size_t workers;
+    std::string overflow;
+    std::size_t batch;
+    std::chrono::microseconds linger;
+    std::size_t parallel;
+};
+
+builder<asynchronous_t>::builder() :
+    d(new inner_t{nullptr, {}, asynchronous_t::default_factor, 1, "wait", 1,
+        asynchronous_t::default_linger, 1})
+{}
+
+auto builder<asynchronous_t>::set(std::unique_ptr<formatter_t> formatter) & -> builder& {
+    d->formatter = std::move(formatter);
+    return *this;
+}
+
+auto builder<asynchronous_t>::set(std::unique_ptr<formatter_t> formatter) && -> builder&& {
+    return std::move(set(std::move(formatter)));
+}
+
+auto builder<asynchronous_t>::add(std::unique_ptr<sink_t> sink) & -> builder& {
+    d->sinks.emplace_back(std::move(sink));
+    return *this;
+}
+
+auto builder<asynchronous_t>::add(std::unique_ptr<sink_t> sink) && -> builder&& {
+    return std::move(add(std::move(sink)));
+}
+
+auto builder<asynchronous_t>::factor(std::size_t value) & -> builder& {
+    d->factor = value;
+    return *this;
+}
+
+auto builder<asynchronous_t>::factor(std::size_t value) && -> builder&& {
+    return std::move(factor(value));
+}
+
+auto builder<asynchronous_t>::workers(std::size_t value) & -> builder& {
+    d->workers = value;
+    return *this;
+}
+
+auto builder<asynchronous_t>::workers(std::size_t value) && -> builder&& {
+    return std::move(workers(value));
+}
+
+auto builder<asynchronous_t>::overflow(std::string policy) & -> builder& {
+    d->overflow = std::move(policy);
+    return *this;
+}
+
+auto builder<asynchronous_t>::overflow(std::string policy) && -> builder&& {
+    return std::move(overflow(std::move(policy)));
+}
+
+auto builder<asynchronous_t>::batch(std::size_t size) & -> builder& {
+    d->batch = size;
+    return *this;
+}
+
+auto builder<asynchronous_t>::batch(std::size_t size) && -> builder&& {
+    return std::move(batch(size));
+}
+
+auto builder<asynchronous_t>::linger(std::chrono::microseconds duration) & -> builder& {
+    d->linger = duration;
+    return *this;
+}
+
+auto builder<asynchronous_t>::linger(std::chrono::microseconds duration) && -> builder&& {
+    return std::move(linger(duration));
+}
+
+auto builder<asynchronous_t>::parallel(std::size_t threads) & -> builder& {
+    d->parallel = threads;
+    return *this;
+}
+
+auto builder<asynchronous_t>::parallel(std::size_t threads) && -> builder&& {
+    return std::move(parallel(threads));
+}
+
+auto builder<asynchronous_t>::build() && -> std::unique_ptr<handler_t> {
+    return blackhole::make_unique<asynchronous_t>(std::move(d->formatter), std::move(d->sinks),
+        d->factor, d->workers, sink::overflow_policy_factory_t().create(d->overflow), d->batch,
+        d->linger, d->parallel);
+}
+
+auto factory<asynchronous_t>::type() const noexcept -> const char* {
+    return "asynchronous";
+}
+
+auto factory<asynchronous_t>::from(const config::node_t& config) const -> std::unique_ptr<handler_t> {
+    builder<asynchronous_t> builder;
+
+    if (auto type = config["formatter"]["type"].to_string()) {
+        builder.set(registry.formatter(type.get())(*config["formatter"].unwrap()));
+    } else {
+        throw std::invalid_argument("each handler must have a formatter with type");
+    }
+
+    config["sinks"].each([&](const config::node_t& config) {
+        if (auto type = config["type"].to_string()) {
+            builder.add(registry.sink(type.get())(config));
+        } else {
+            throw std::invalid_argument("each sink must have a type");
+        }
+    });
+
+    if (auto factor = config["factor"].to_uint64()) {
+        builder.factor(factor.get());
+    }
+
+    if (auto workers = config["workers"].to_uint64()) {
+        builder.workers(workers.get());
+    }
+
+    if (auto overflow = config["overflow"].to_string()) {
+        builder.overflow(overflow.get());
+    }
+
+    if (auto batch = config["batch"].to_uint64()) {
+        builder.batch(static_cast<std::size_t>(batch.get()));
+    }
+
+    if (auto linger = config["linger"].to_uint64()) {
+        builder.linger(std::chrono::milliseconds(linger.get()));
+    }
+
+    if (auto parallel = config["parallel"].to_uint64()) {
+        builder.parallel(static_cast<std::size_t>(parallel.get()));
+    }
+
+    return std::move(builder).build();
+}
+
+template auto deleter_t::operator()(builder<handler::asynchronous_t>::inner_t*) -> void;
+
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,165 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <cds/container/vyukov_mpmc_cycle_queue.h>
+
+#include "blackhole/handler.hpp"
+#include "blackhole/forward.hpp"
+#include "blackhole/metrics.hpp"
+
+#include "blackhole/detail/sink/asynchronous.hpp"
+#include "blackhole/detail/sink/shared.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+
+class executor_t;
+
+namespace handler {
+
+class asynchronous_t : public handler_t {
+    /// Records are captured into memory pooled by producer threads.
+    typedef sink::shared_record_t value_type;
+
+    /// Queue item, either a single record or a whole batch of records of a single producer.
+    struct item_t {
+        value_type record;
+        std::vector<value_type> batch;
+    };
+
+    typedef cds::container::VyukovMPMCCycleQueue<item_t> queue_type;
+
+    /// Records accumulated by a single producer thread, which are enqueued at once.
+    struct pending_t;
+    struct bindings_t;
+
+    /// Contiguous slice of a batch formatted into a single buffer.
+    struct slice_t;
+
+    struct statistics_t {
+        metrics::counter_t records;
+        metrics::counter_t bytes;
+        metrics::histogram_t emit;
+    };
+
+    std::unique_ptr<formatter_t> formatter;
+    std::vector<std::unique_ptr<sink_t>> sinks;
+    std::vector<std::unique_ptr<statistics_t>> statistics;
+
+    queue_type queue;
+    std::atomic<bool> stopped;
+
+    std::unique_ptr<sink::overflow_policy_t> overflow_policy;
+    std::unique_ptr<sink::underflow_policy_t> underflow_policy;
+
+    /// Each submitted record is eventually either dropped or processed, which flushing relies on.
+    metrics::counter_t submitted;
+    metrics::counter_t enqueued;
+    metrics::counter_t dropped;
+    metrics::counter_t processed;
+    metrics::counter_t errors;
+    metrics::histogram_t formatting;
+
+    /// Notified on records completion, i.e. either processing or dropping.
+    sink::eventcount_t completed;
+
+    /// Batching settings, disabled if the batch size is 1.
+    const std::uint64_t id;
+    const std::size_t batch;
+    const std::chrono::microseconds linger;
+
+    /// Pending batches of all bound threads.
+    std::mutex mutex;
+    std::vector<std::shared_ptr<pending_t>> pendings;
+
+    /// Notified on batches enqueued, which workers wait for with the linger timeout.
+    sink::eventcount_t ready;
+
+    /// Number of threads formatting a batch, including the worker, and helper ones besides it.
+    const std::size_t parallel;
+    std::unique_ptr<executor_t> pool;
+
+    std::vector<std::thread> threads;
+
+public:
+    /// Default queue capacity factor.
+    static constexpr std::size_t default_factor = 10;
+
+    /// Default maximum time records are kept in a pending batch.
+    static constexpr std::chrono::microseconds default_linger = std::chrono::milliseconds(10);
+
+    /// Minimum number of records formatted by a single thread, which smaller batches are not split
+    /// below to keep the cost of handing slices over negligible.
+    static constexpr std::size_t min_slice = 64;
+
+public:
+    asynchronous_t(std::unique_ptr<formatter_t> formatter,
+                   std::vector<std::unique_ptr<sink_t>> sinks,
+                   std::size_t factor = default_factor,
+                   std::size_t workers = 1,
+                   std::unique_ptr<sink::overflow_policy_t> overflow_policy = nullptr,
+                   std::size_t batch = 1,
+                   std::chrono::microseconds linger = default_linger,
+                   std::size_t parallel = 1);
+
+    /// Enqueues pending batches and waits for workers to process all records.
+    ~asynchronous_t();
+
+    /// Captures the given record and enqueues it for formatting and emitting on a worker thread.
+    ///
+    /// With batching enabled the record is appended to the pending batch of the calling thread
+    /// instead, which is enqueued once full.
+    virtual auto handle(const record_t& record) -> void override;
+
+    /// Waits until all records handled before the call, including pending batches of all threads,
+    /// are processed and flushed by sinks, but no longer than until the given deadline.
+    virtual auto flush(std::chrono::steady_clock::time_point deadline) -> bool override;
+
+    /// Collects queue metrics, the number of errors swallowed by workers, formatting time and, for
+    /// each sink, the number of records and bytes emitted and emitting time.
+    virtual auto collect(metrics::collector_t& collector) const -> void override;
+
+    /// Returns the queue pressure merged with pressures of sinks.
+    virtual auto pressure() const -> pressure_t override;
+
+private:
+    auto run() -> void;
+    auto process(const item_t& item) -> void;
+    auto process(const value_type& value) -> void;
+
+    /// Formats slices of the batch in parallel and emits them to sinks in the batch order.
+    auto process(const std::vector<value_type>& batch) -> void;
+
+    /// Formats the slice with `format_batch`, skipping records it fails to format.
+    auto format(slice_t& slice) -> void;
+
+    /// Captures the given record into the pending batch of the calling thread.
+    auto accumulate(const record_t& record) -> void;
+
+    /// Returns the pending batch of the calling thread, binding one if there is no such batch yet.
+    auto local() -> pending_t&;
+
+    /// Enqueues the given pending batch, resolving the overflow if blocking, which either enqueues
+    /// or drops it, and returning whether it has been enqueued.
+    ///
+    /// \warning must be called under the lock of the batch.
+    auto handoff(pending_t& pending, bool blocking) -> bool;
+
+    /// Enqueues pending batches started before the given time point, skipping locked ones unless
+    /// blocking, and returning whether any of them has been enqueued.
+    auto sweep(std::chrono::steady_clock::time_point before, bool blocking) -> bool;
+
+    /// Returns whether every submitted record is either processed or dropped.
+    auto idle() const -> bool;
+};
+
+}  // namespace handler
+}  // namespace v1
+}  // namespace blackhole
@@ -1,37 +1,459 @@
 #include "blackhole/handler/blocking.hpp"
 
+#include <algorithm>
+#include <limits>
+#include <utility>
+#include <vector>
+
 #include <boost/optional/optional.hpp>
 
+#include "blackhole/attribute.hpp"
+#include "blackhole/attributes.hpp"
 #include "blackhole/config/node.hpp"
 #include "blackhole/config/option.hpp"
 #include "blackhole/extensions/writer.hpp"
 #include "blackhole/formatter.hpp"
+#include "blackhole/metrics.hpp"
+#include "blackhole/pressure.hpp"
+#include "blackhole/record.hpp"
 #include "blackhole/registry.hpp"
+#include "blackhole/filter.hpp"
 #include "blackhole/sink.hpp"
 
+#include "blackhole/detail/capture.hpp"
 #include "blackhole/detail/memory.hpp"
+#include "blackhole/detail/probe.hpp"
+#include "blackhole/detail/sink/shared.hpp"
+#include "blackhole/detail/stage.hpp"
 #include "blackhole/detail/util/deleter.hpp"
 
+#include "../filter/severity.hpp"
+#include "../filter/throttle.hpp"
+
 #include "blocking.hpp"
 
 namespace blackhole {
 inline namespace v1 {
 namespace handler {
+namespace {
+
+/// Writer reused by all blocking handlers of the current thread, since they never run concurrently
+/// within it, except being reentered from a sink, which is served by a temporary writer instead.
+struct slot_t {
+    std::unique_ptr<writer_t> writer;
+    bool busy;
+};
+
+/// Acquires the thread-local writer for a single record, clearing it on release and releasing its
+/// buffer if it has grown over the given capacity.
+class lease_t {
+    slot_t* slot;
+    std::size_t capacity;
+    std::unique_ptr<writer_t> temporary;
+
+public:
+    explicit lease_t(std::size_t capacity) :
+        capacity(capacity)
+    {
+        thread_local slot_t current{nullptr, false};
+        slot = &current;
+
+        if (slot->busy) {
+            temporary.reset(new writer_t);
+            return;
+        }
+
+        if (slot->writer == nullptr) {
+            slot->writer.reset(new writer_t);
+        }
+
+        slot->busy = true;
+    }
+
+    ~lease_t() {
+        if (temporary) {
+            return;
+        }
+
+        slot->writer->release();
+
+        if (capacity != 0 && slot->writer->inner.size() > capacity) {
+            slot->writer.reset();
+        } else {
+            slot->writer->reset();
+        }
+
+        slot->busy = false;
+    }
+
+    auto writer() noexcept -> writer_t& {
+        return temporary ? *temporary : *slot->writer;
+    }
+
+    /// Checks whether the writer is a temporary one, meaning that a sink is being reentered.
+    auto reentered() const noexcept -> bool {
+        return temporary != nullptr;
+    }
+};
+
+}  // namespace
 
 blocking_t::blocking_t(std::unique_ptr<formatter_t> formatter,
-                       std::vector<std::unique_ptr<sink_t>> sinks) :
-    formatter(std::move(formatter)),
-    sinks(std::move(sinks))
+                       std::vector<std::unique_ptr<sink_t>> sinks,
+                       std::size_t capacity,
+                       std::size_t gather) :
+    blocking_t(std::move(formatter), std::move(sinks), std::vector<std::unique_ptr<filter_t>>(),
+        capacity, gather)
 {}
 
-auto blocking_t::handle(const record_t& record) -> void {
-    writer_t writer;
+blocking_t::blocking_t(std::unique_ptr<formatter_t> formatter,
+                       std::vector<std::unique_ptr<sink_t>> sinks,
+                       std::vector<std::unique_ptr<filter_t>> filters,
+                       std::size_t capacity,
+                       std::size_t gather) :
+    formatter(std::move(formatter)),
+    capacity(capacity),
+    gather(gather),
+    mask(0),
+    threshold(std::numeric_limits<std::int64_t>::max()),
+    dynamic(false)
+{
+    if (!filters.empty() && filters.size() != sinks.size()) {
+        throw std::invalid_argument("each sink must be accompanied with a filter");
+    }
+
+    filters.resize(sinks.size());
+
+    for (std::size_t id = 0; id < sinks.size(); ++id) {
+        route_t route{std::move(sinks[id]), std::move(filters[id]),
+            std::numeric_limits<std::int64_t>::min(), blackhole::make_unique<statistics_t>()};
+
+        if (route.filter) {
+            if (auto severity = dynamic_cast<const filter::severity_t*>(route.filter.get())) {
+                route.threshold = severity->threshold();
+                route.filter.reset();
+            } else {
+                if (auto throttle = dynamic_cast<filter::throttle_t*>(route.filter.get())) {
+                    const auto sink = route.sink.get();
+                    const auto pattern = throttle->summary();
+                    throttle->report([=](const record_t& record, std::uint64_t count) {
+                        summarize(*sink, pattern, record, count);
+                    });
+                }
+
+                dynamic = true;
+            }
+        }
+
+        threshold = std::min(threshold, route.threshold);
+
+        const auto min = std::max<std::int64_t>(route.threshold, 0);
+        for (auto severity = min; severity < 64; ++severity) {
+            mask |= std::uint64_t(1) << severity;
+        }
+
+        routes.push_back(std::move(route));
+    }
+}
+
+auto blocking_t::handle(const record_t& original) -> void {
+    const std::int64_t severity = original.severity();
+
+    if (!dynamic) {
+        const auto accepted = severity >= 0 && severity < 64 ?
+            (mask >> severity) & 1 :
+            severity >= threshold;
+
+        if (!accepted) {
+            filtered.add();
+            return;
+        }
+    }
+
+    BLACKHOLE_PROBE(handle_start, severity);
+
+    // Filters and formatters see the record bounded by capture limits, like sinks capturing it do.
+    const detail::capture::bounded_t bounded(original);
+    const auto& record = bounded.get();
+
+    boost::optional<lease_t> lease;
+
+    // Slices of the formatted record if it references large strings instead of copying them.
+    std::vector<string_view> slices;
+
+    // Allows asynchronous sinks to share a single owned copy of the record.
+    const sink::sharing_t sharing;
+
+    for (const auto& route : routes) {
+        if (severity < route.threshold) {
+            continue;
+        }
+
+        if (route.filter && route.filter->filter(record) == filter_t::action_t::deny) {
+            continue;
+        }
+
+        // Formatting is postponed until the first sink accepting the record.
+        if (!lease) {
+            lease.emplace(capacity);
+            lease->writer().gather(gather);
+
+            // Sinks lending regions stay locked while formatting, which would deadlock reentering.
+            if (routes.size() == 1 && !lease->reentered() && lend(route, record, lease->writer())) {
+                // Formatting right into the sink is stamped as a write as a whole.
+                detail::stage::written();
+                break;
+            }
+
+            BLACKHOLE_PROBE(format_start, severity);
+            {
+                const metrics::timer_t timer(formatting);
+                formatter->format(record, lease->writer());
+            }
+            BLACKHOLE_PROBE(format_end, severity, lease->writer().inner.size());
+            detail::stage::stamp(detail::stage::id_t::format);
+        }
+
+        auto& writer = lease->writer();
+
+        if (writer.skipped()) {
+            break;
+        }
+
+        if (writer.referenced() && slices.empty()) {
+            writer.slices(slices);
+        }
+
+        const auto size = writer.length();
+
+        BLACKHOLE_PROBE(emit_start, severity, size);
+        {
+            const metrics::timer_t timer(route.statistics->emit);
+
+            if (slices.empty()) {
+                route.sink->emit(record, writer.result());
+            } else {
+                route.sink->emit_gathered(record, slices.data(), slices.size());
+            }
+        }
+        BLACKHOLE_PROBE(emit_end, severity, size);
+        detail::stage::written();
+
+        route.statistics->records.add();
+        route.statistics->bytes.add(size);
+    }
+
+    if (lease && !lease->writer().skipped()) {
+        records.add();
+        BLACKHOLE_PROBE(handle_end, severity, lease->writer().inner.size());
+    } else {
+        filtered.add();
+        BLACKHOLE_PROBE(handle_end, severity, 0);
+    }
+}
+
+auto blocking_t::handle_batch(const record_t* batch, std::size_t size) -> void {
+    lease_t lease(capacity);
+    auto& writer = lease.writer();
+
+    // Records are formatted into the same writer on the first sink accepting them. The buffer may
+    // grow while formatting, so messages are kept as offsets until the batch for a sink is ready.
+    const auto none = std::numeric_limits<std::size_t>::max();
+    // Records skipped by the formatter keep their partial output in the buffer, but no span.
+    const auto skipped = none - 1;
+    std::vector<std::pair<std::size_t, std::size_t>> spans(size, {none, 0});
+
+    std::vector<std::size_t> accepted;
+    std::vector<string_view> messages;
+    std::vector<sink_t::event_t> events;
+
+    for (const auto& route : routes) {
+        accepted.clear();
+
+        for (std::size_t id = 0; id < size; ++id) {
+            const auto& record = batch[id];
+
+            if (record.severity() < route.threshold) {
+                continue;
+            }
+
+            if (route.filter && route.filter->filter(record) == filter_t::action_t::deny) {
+                continue;
+            }
+
+            if (spans[id].first == none) {
+                const auto offset = writer.inner.size();
 
-    formatter->format(record, writer);
+                {
+                    const metrics::timer_t timer(formatting);
+                    formatter->format(record, writer);
+                }
 
-    for (const auto& sink : sinks) {
-        // TODO: Check for filter.
-        sink->emit(record, writer.result());
+                if (writer.skipped()) {
+                    writer.skip(false);
+                    spans[id] = {skipped, 0};
+                } else {
+                    spans[id] = {offset, writer.inner.size()};
+                }
+            }
+
+            if (spans[id].first != skipped) {
+                accepted.push_back(id);
+            }
+        }
+
+        if (accepted.empty()) {
+            continue;
+        }
+
+        messages.clear();
+        events.clear();
+
+        // Events refer to messages, which therefore must not be reallocated.
+        messages.reserve(accepted.size());
+
+        std::size_t bytes = 0;
+        for (auto id : accepted) {
+            messages.emplace_back(writer.inner.data() + spans[id].first,
+                spans[id].second - spans[id].first);
+            events.push_back({&batch[id], &messages.back()});
+            bytes += messages.back().size();
+        }
+
+        {
+            const metrics::timer_t timer(route.statistics->emit);
+            route.sink->emit_batch(events.data(), events.size());
+        }
+
+        route.statistics->records.add(events.size());
+        route.statistics->bytes.add(bytes);
+    }
+
+    for (const auto& span : spans) {
+        if (span.first == none || span.first == skipped) {
+            filtered.add();
+        } else {
+            records.add();
+        }
+    }
+}
+
+auto blocking_t::flush(std::chrono::steady_clock::time_point deadline) -> bool {
+    bool result = true;
+    for (const auto& route : routes) {
+        result = route.sink->flush(deadline) && result;
+    }
+
+    return result;
+}
+
+auto blocking_t::collect(metrics::collector_t& collector) const -> void {
+    collector.counter("blackhole_handler_records_total", records.get());
+    collector.counter("blackhole_handler_filtered_total", filtered.get());
+    collector.histogram("blackhole_handler_format_seconds", formatting);
+
+    for (std::size_t id = 0; id < routes.size(); ++id) {
+        const auto& route = routes[id];
+
+        auto labeled = collector.with("sink", std::to_string(id));
+        labeled.counter("blackhole_sink_records_total", route.statistics->records.get());
+        labeled.counter("blackhole_sink_bytes_total", route.statistics->bytes.get());
+        labeled.histogram("blackhole_sink_emit_seconds", route.statistics->emit);
+
+        route.sink->collect(labeled);
+    }
+}
+
+auto blocking_t::pressure() const -> pressure_t {
+    pressure_t result;
+
+    for (const auto& route : routes) {
+        result.merge(route.sink->pressure());
+    }
+
+    return result;
+}
+
+auto blocking_t::lend(const route_t& route, const record_t& record, writer_t& writer) -> bool {
+    const auto estimate = formatter->estimate(record);
+
+    // Records that large would outgrow the region anyway, while referencing them saves a copy.
+    if (gather != 0 && estimate >= gather) {
+        return false;
+    }
+
+    const auto region = route.sink->lend(record, estimate);
+    if (region.data == nullptr) {
+        return false;
+    }
+
+    writer.lend(region.data, region.size);
+
+    try {
+        const metrics::timer_t timer(formatting);
+        formatter->format(record, writer);
+    } catch (...) {
+        writer.release();
+        route.sink->cancel();
+        throw;
+    }
+
+    if (writer.skipped()) {
+        writer.release();
+        route.sink->cancel();
+        return true;
+    }
+
+    const auto size = writer.length();
+
+    {
+        const metrics::timer_t timer(route.statistics->emit);
+
+        if (writer.lent()) {
+            writer.release();
+            route.sink->commit(record, size);
+        } else if (writer.referenced()) {
+            // The formatter has outgrown the region and referenced large strings afterwards.
+            writer.release();
+            route.sink->cancel();
+
+            std::vector<string_view> slices;
+            writer.slices(slices);
+            route.sink->emit_gathered(record, slices.data(), slices.size());
+        } else {
+            // The formatter has outgrown the region, so the record is copied from the writer.
+            writer.release();
+            route.sink->cancel();
+            route.sink->emit(record, writer.result());
+        }
+    }
+
+    route.statistics->records.add();
+    route.statistics->bytes.add(size);
+
+    return true;
+}
+
+auto blocking_t::summarize(sink_t& sink, const char* pattern, const record_t& record,
+                           std::uint64_t suppressed) -> void
+{
+    writer_t message;
+    message.write(pattern, suppressed);
+    const auto result = message.result();
+
+    const attribute_list attributes{{"suppressed", suppressed}, {"pattern", record.message()}};
+    attribute_pack pack(record.attributes());
+    pack.emplace_back(attributes);
+
+    record_t summary(record.severity(), result, pack);
+    summary.activate(result, record.timestamp());
+
+    // Summaries are rare, so they don't compete for the thread-local writer.
+    writer_t writer;
+    formatter->format(summary, writer);
+
+    if (!writer.skipped()) {
+        sink.emit(summary, writer.result());
     }
 }
 
@@ -43,11 +465,14 @@ class builder<blocking_t>::inner_t {
 public:
     std::unique_ptr<formatter_t> formatter;
     std::vector<std::unique_ptr<sink_t>> sinks;
+    std::vector<std::unique_ptr<filter_t>> filters;
+    std::size_t capacity;
+    std::size_t gather;
 };
 
 // TODO: TEST!
 builder<blocking_t>::builder() :
-    d(new inner_t)
+    d(new inner_t{nullptr, {}, {}, 0, 0})
 {}
 
 auto builder<blocking_t>::set(std::unique_ptr<formatter_t> formatter) & -> builder& {
@@ -60,16 +485,48 @@ auto builder<blocking_t>::set(std::unique_ptr<formatter_t> formatter) && -> buil
 }
 
 auto builder<blocking_t>::add(std::unique_ptr<sink_t> sink) & -> builder& {
-    d->sinks.emplace_back(std::move(sink));
-    return *this;
+    return add(std::move(sink), nullptr);
 }
 
 auto builder<blocking_t>::add(std::unique_ptr<sink_t> sink) && -> builder&& {
     return std::move(add(std::move(sink)));
 }
 
+auto builder<blocking_t>::add(std::unique_ptr<sink_t> sink, std::unique_ptr<filter_t> filter) & ->
+    builder&
+{
+    d->sinks.emplace_back(std::move(sink));
+    d->filters.emplace_back(std::move(filter));
+    return *this;
+}
+
+auto builder<blocking_t>::add(std::unique_ptr<sink_t> sink, std::unique_ptr<filter_t> filter) && ->
+    builder&&
+{
+    return std::move(add(std::move(sink), std::move(filter)));
+}
+
+auto builder<blocking_t>::capacity(std::size_t value) & -> builder& {
+    d->capacity = value;
+    return *this;
+}
+
+auto builder<blocking_t>::capacity(std::size_t value) && -> builder&& {
+    return std::move(capacity(value));
+}
+
+auto builder<blocking_t>::gather(std::size_t threshold) & -> builder& {
+    d->gather = threshold;
+    return *this;
+}
+
+auto builder<blocking_t>::gather(std::size_t threshold) && -> builder&& {
+    return std::move(gather(threshold));
+}
+
 auto builder<blocking_t>::build() && -> std::unique_ptr<handler_t> {
-    return blackhole::make_unique<blocking_t>(std::move(d->formatter), std::move(d->sinks));
+    return blackhole::make_unique<blocking_t>(std::move(d->formatter), std::move(d->sinks),
+        std::move(d->filters), d->capacity, d->gather);
 }
 
 auto factory<blocking_t>::type() const noexcept -> const char* {
@@ -87,13 +544,27 @@ auto factory<blocking_t>::from(const config::node_t& config) const -> std::uniqu
     }
 
     config["sinks"].each([&](const config::node_t& config) {
-        if (auto type = config["type"].to_string()) {
-            builder.add(registry.sink(type.get())(config));
-        } else {
+        auto type = config["type"].to_string();
+        if (!type) {
             throw std::invalid_argument("each sink must have a type");
         }
+
+        std::unique_ptr<filter_t> filter;
+        if (auto filter_type = config["filter"]["type"].to_string()) {
+            filter = registry.filter(filter_type.get())(*config["filter"].unwrap());
+        }
+
+        builder.add(registry.sink(type.get())(config), std::move(filter));
     });
 
+    if (auto capacity = config["capacity"].to_uint64()) {
+        builder.capacity(capacity.get());
+    }
+
+    if (auto threshold = config["gather"].to_uint64()) {
+        builder.gather(threshold.get());
+    }
+
     return std::move(builder).build();
 }
 
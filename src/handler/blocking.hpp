@@ -1,23 +1,110 @@
 #pragma once
 
+#include <cstdint>
 #include <memory>
 #include <vector>
 
 #include "blackhole/handler.hpp"
 #include "blackhole/forward.hpp"
+#include "blackhole/metrics.hpp"
 
 namespace blackhole {
 inline namespace v1 {
 namespace handler {
 
+/// Formats records and emits them to sinks synchronously in the calling thread.
+///
+/// Each sink can be accompanied with a filter, which is checked before formatting, so records
+/// denied by all sinks are not formatted at all. Severity filters are recognized and compiled into
+/// a bitmask of accepted severities in [0; 64) range together with a threshold for others, which
+/// allows to reject records without calling any filter.
+///
+/// Rate limiting, sampling and deduplicating filters are given a reporter, which formats summary
+/// records of suppressed records with "suppressed" and "pattern" attributes and emits them into the
+/// sink of the filter.
+///
+/// Records are formatted into a thread-local writer, which is reused across records, so its buffer
+/// keeps the largest capacity reached and long records stop requiring heap allocations. If the
+/// capacity value is positive, the buffer is released after records exceeding it, bounding the
+/// memory kept by each thread after outliers. Zero value, which is the default, means no limit.
+///
+/// Records handled by a single sink are formatted right into the output buffer region lent by it
+/// if the sink is able to, which saves copying the formatted record. Records outgrowing the region,
+/// as well as ones handled by multiple sinks, are emitted the usual way.
+///
+/// If the gathering threshold is positive, strings at least that long, like huge messages and
+/// attribute values, are referenced by formatters supporting it instead of being copied into the
+/// writer, and records are emitted as slices by `sink_t::emit_gathered`. Zero value, which is the
+/// default, disables gathering.
+///
+/// Collected metrics are the number of records handled and rejected by all sinks, formatting time
+/// and, for each sink, the number of records and bytes emitted and emitting time.
 class blocking_t : public handler_t {
+    struct statistics_t {
+        metrics::counter_t records;
+        metrics::counter_t bytes;
+        metrics::histogram_t emit;
+    };
+
+    struct route_t {
+        std::unique_ptr<sink_t> sink;
+        /// Custom filter, null if there is no filter or it's a severity one.
+        std::unique_ptr<filter_t> filter;
+        /// Minimum accepted severity.
+        std::int64_t threshold;
+        std::unique_ptr<statistics_t> statistics;
+    };
+
     std::unique_ptr<formatter_t> formatter;
-    std::vector<std::unique_ptr<sink_t>> sinks;
+    std::vector<route_t> routes;
+    std::size_t capacity;
+    /// Minimum size of strings referenced instead of copied, zero if disabled.
+    std::size_t gather;
+
+    /// Severities in [0; 64) range accepted by at least one sink, unless there are custom filters.
+    std::uint64_t mask;
+    /// Minimum severity accepted by at least one sink.
+    std::int64_t threshold;
+    /// Whether any sink has a custom filter, making the fast path inapplicable.
+    bool dynamic;
+
+    metrics::counter_t records;
+    metrics::counter_t filtered;
+    metrics::histogram_t formatting;
 
 public:
-    blocking_t(std::unique_ptr<formatter_t> formatter, std::vector<std::unique_ptr<sink_t>> sinks);
+    blocking_t(std::unique_ptr<formatter_t> formatter,
+               std::vector<std::unique_ptr<sink_t>> sinks,
+               std::size_t capacity = 0,
+               std::size_t gather = 0);
+
+    /// Constructs a handler with the given sinks, each of which is accompanied with the filter
+    /// from the same position, where null filters accept everything.
+    ///
+    /// \throw std::invalid_argument if the number of filters differs from the number of sinks.
+    blocking_t(std::unique_ptr<formatter_t> formatter,
+               std::vector<std::unique_ptr<sink_t>> sinks,
+               std::vector<std::unique_ptr<filter_t>> filters,
+               std::size_t capacity = 0,
+               std::size_t gather = 0);
 
     virtual auto handle(const record_t& record) -> void override;
+
+    /// Formats records accepted by each sink and emits them to it as a single batch, formatting
+    /// each record at most once.
+    virtual auto handle_batch(const record_t* records, std::size_t size) -> void override;
+
+    virtual auto flush(std::chrono::steady_clock::time_point deadline) -> bool override;
+    virtual auto collect(metrics::collector_t& collector) const -> void override;
+    virtual auto pressure() const -> pressure_t override;
+
+private:
+    /// Formats the record into the region lent by the sink of the given route and emits it,
+    /// returning false without formatting if the sink lends nothing.
+    auto lend(const route_t& route, const record_t& record, writer_t& writer) -> bool;
+
+    auto summarize(sink_t& sink, const char* pattern, const record_t& record,
+                   std::uint64_t suppressed) -> void;
 };
 
 }  // namespace handler
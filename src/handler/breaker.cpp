@@ -0,0 +1,207 @@
+#include "blackhole/handler/breaker.hpp"
+
+#include <atomic>
+#include <stdexcept>
+
+#include <boost/optional/optional.hpp>
+
+#include "blackhole/config/node.hpp"
+#include "blackhole/config/option.hpp"
+#include "blackhole/metrics.hpp"
+#include "blackhole/pressure.hpp"
+#include "blackhole/registry.hpp"
+
+#include "blackhole/detail/memory.hpp"
+#include "blackhole/detail/util/deleter.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace handler {
+namespace {
+
+typedef std::chrono::steady_clock::rep ticks_type;
+
+auto ticks() noexcept -> ticks_type {
+    return std::chrono::steady_clock::now().time_since_epoch().count();
+}
+
+}  // namespace
+
+class breaker_t::inner_t {
+public:
+    std::unique_ptr<handler_t> handler;
+    const std::size_t threshold;
+    const ticks_type cooldown;
+
+    /// Consecutive failures since the last success or opening.
+    std::atomic<std::size_t> failures;
+    /// Steady clock time the breaker is open until, zero while closed.
+    std::atomic<ticks_type> until;
+
+    metrics::counter_t bypassed;
+    metrics::counter_t opened;
+
+    inner_t(std::unique_ptr<handler_t> handler, std::size_t threshold,
+            std::chrono::milliseconds cooldown) :
+        handler(std::move(handler)),
+        threshold(threshold),
+        cooldown(std::chrono::duration_cast<std::chrono::steady_clock::duration>(cooldown).count()),
+        failures(0),
+        until(0)
+    {}
+
+    /// Calls the given function unless the breaker is open, bypassing the given number of records
+    /// otherwise.
+    template<typename F>
+    auto call(std::size_t size, const F& fn) -> void {
+        auto deadline = until.load(std::memory_order_acquire);
+        auto probing = false;
+
+        if (deadline != 0) {
+            const auto now = ticks();
+
+            // A single thread probes once the cooldown expires, while others keep bypassing
+            // records for another cooldown period, unless the probe succeeds earlier.
+            if (now < deadline ||
+                !until.compare_exchange_strong(deadline, now + cooldown, std::memory_order_acq_rel))
+            {
+                bypassed.add(size);
+                return;
+            }
+
+            probing = true;
+        }
+
+        try {
+            fn();
+        } catch (...) {
+            if (probing || failures.fetch_add(1, std::memory_order_relaxed) + 1 >= threshold) {
+                failures.store(0, std::memory_order_relaxed);
+                until.store(ticks() + cooldown, std::memory_order_release);
+                opened.add();
+            }
+
+            throw;
+        }
+
+        if (failures.load(std::memory_order_relaxed) != 0) {
+            failures.store(0, std::memory_order_relaxed);
+        }
+
+        if (probing) {
+            until.store(0, std::memory_order_release);
+        }
+    }
+};
+
+constexpr std::size_t breaker_t::default_threshold;
+
+breaker_t::breaker_t(std::unique_ptr<handler_t> handler, std::size_t threshold,
+                     std::chrono::milliseconds cooldown)
+{
+    if (threshold == 0) {
+        throw std::invalid_argument("circuit breaker threshold must be positive");
+    }
+
+    d.reset(new inner_t(std::move(handler), threshold, cooldown));
+}
+
+breaker_t::~breaker_t() = default;
+
+auto breaker_t::handle(const record_t& record) -> void {
+    d->call(1, [&] {
+        d->handler->handle(record);
+    });
+}
+
+auto breaker_t::handle_batch(const record_t* records, std::size_t size) -> void {
+    d->call(size, [&] {
+        d->handler->handle_batch(records, size);
+    });
+}
+
+auto breaker_t::flush(std::chrono::steady_clock::time_point deadline) -> bool {
+    return d->handler->flush(deadline);
+}
+
+auto breaker_t::collect(metrics::collector_t& collector) const -> void {
+    collector.counter("blackhole_breaker_bypassed_total", d->bypassed.get());
+    collector.counter("blackhole_breaker_opened_total", d->opened.get());
+
+    d->handler->collect(collector);
+}
+
+auto breaker_t::pressure() const -> pressure_t {
+    return d->handler->pressure();
+}
+
+auto breaker_t::open() const noexcept -> bool {
+    const auto deadline = d->until.load(std::memory_order_acquire);
+    return deadline != 0 && ticks() < deadline;
+}
+
+}  // namespace handler
+
+using handler::breaker_t;
+
+class builder<breaker_t>::inner_t {
+public:
+    std::unique_ptr<handler_t> handler;
+    std::size_t threshold;
+    std::chrono::milliseconds cooldown;
+};
+
+builder<breaker_t>::builder(std::unique_ptr<handler_t> handler) :
+    d(new inner_t{std::move(handler), breaker_t::default_threshold, std::chrono::seconds(1)})
+{}
+
+auto builder<breaker_t>::threshold(std::size_t value) & -> builder& {
+    d->threshold = value;
+    return *this;
+}
+
+auto builder<breaker_t>::threshold(std::size_t value) && -> builder&& {
+    return std::move(threshold(value));
+}
+
+auto builder<breaker_t>::cooldown(std::chrono::milliseconds value) & -> builder& {
+    d->cooldown = value;
+    return *this;
+}
+
+auto builder<breaker_t>::cooldown(std::chrono::milliseconds value) && -> builder&& {
+    return std::move(cooldown(value));
+}
+
+auto builder<breaker_t>::build() && -> std::unique_ptr<handler_t> {
+    return blackhole::make_unique<breaker_t>(std::move(d->handler), d->threshold, d->cooldown);
+}
+
+auto factory<breaker_t>::type() const noexcept -> const char* {
+    return "breaker";
+}
+
+auto factory<breaker_t>::from(const config::node_t& config) const -> std::unique_ptr<handler_t> {
+    auto inner = config["handler"];
+    if (!inner) {
+        throw std::invalid_argument("circuit breaker handler must have a wrapped handler");
+    }
+
+    const auto type = inner["type"].to_string().get_value_or("blocking");
+    builder<breaker_t> builder(registry.handler(type)(*inner.unwrap()));
+
+    if (auto threshold = config["threshold"].to_uint64()) {
+        builder.threshold(static_cast<std::size_t>(threshold.get()));
+    }
+
+    if (auto cooldown = config["cooldown"].to_uint64()) {
+        builder.cooldown(std::chrono::milliseconds(cooldown.get()));
+    }
+
+    return std::move(builder).build();
+}
+
+template auto deleter_t::operator()(builder<handler::breaker_t>::inner_t*) -> void;
+
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,442 @@
+#include "blackhole/handler/recorder.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+#include <boost/optional/optional.hpp>
+
+#include "blackhole/config/node.hpp"
+#include "blackhole/config/option.hpp"
+#include "blackhole/metrics.hpp"
+#include "blackhole/pressure.hpp"
+#include "blackhole/record.hpp"
+#include "blackhole/registry.hpp"
+
+#include "blackhole/detail/crash.hpp"
+#include "blackhole/detail/memory.hpp"
+#include "blackhole/detail/recordbuf.hpp"
+#include "blackhole/detail/util/deleter.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace handler {
+namespace {
+
+/// Ring of the most recent records of a single thread.
+///
+/// Only the owning thread appends records, while the lock is required for dumping from another
+/// thread and for releasing the ring when the recorder is destroyed.
+struct ring_t {
+    typedef std::max_align_t block_type;
+
+    std::mutex mutex;
+    /// Whether the ring is bound to a running thread.
+    std::atomic<bool> owned;
+
+    /// Size of each slot in blocks.
+    const std::size_t slot;
+    std::vector<block_type> memory;
+    std::vector<detail::recordbuf_t> records;
+
+    /// Position of the oldest record.
+    std::size_t head;
+    std::size_t size;
+
+    ring_t(std::size_t capacity, std::size_t slot) :
+        owned(true),
+        slot((slot + sizeof(block_type) - 1) / sizeof(block_type)),
+        memory(capacity * this->slot),
+        records(capacity),
+        head(0),
+        size(0)
+    {}
+
+    /// Captures the given record, returning whether the oldest one has been overwritten.
+    ///
+    /// \warning must be called under the lock.
+    auto push(const record_t& record) -> bool {
+        const auto position = (head + size) % records.size();
+        auto& value = records[position];
+
+        // The previous record must be destroyed before its memory is reused.
+        value = detail::recordbuf_t();
+        value = detail::recordbuf_t(record, &memory[position * slot], slot * sizeof(block_type));
+
+        if (size == records.size()) {
+            head = (head + 1) % records.size();
+            return true;
+        }
+
+        ++size;
+        return false;
+    }
+
+    /// Passes all records to the given handler in order, returning their number.
+    ///
+    /// \warning must be called under the lock.
+    auto dump(handler_t& handler) -> std::size_t {
+        std::size_t dumped = 0;
+
+        while (size != 0) {
+            // Taking the record out before handling keeps the ring consistent if handling throws.
+            const auto value = std::move(records[head]);
+            head = (head + 1) % records.size();
+            --size;
+
+            handler.handle(value.into_view());
+            ++dumped;
+        }
+
+        return dumped;
+    }
+
+    /// Drops all records together with their memory, leaving an empty shell, which is kept only by
+    /// bindings of the running thread.
+    ///
+    /// \warning must be called under the lock.
+    auto release() -> void {
+        clear();
+        std::vector<detail::recordbuf_t>().swap(records);
+        std::vector<block_type>().swap(memory);
+    }
+
+    /// Drops all records, returning their number.
+    ///
+    /// \warning must be called under the lock.
+    auto clear() -> std::size_t {
+        const auto dropped = size;
+
+        for (auto& value : records) {
+            value = detail::recordbuf_t();
+        }
+
+        head = 0;
+        size = 0;
+
+        return dropped;
+    }
+};
+
+/// Rings of the current thread for each recorder it has handled records with.
+///
+/// Recorders are identified by unique numbers instead of addresses, which can be reused.
+struct bindings_t {
+    std::vector<std::pair<std::uint64_t, std::shared_ptr<ring_t>>> items;
+
+    ~bindings_t() {
+        for (const auto& item : items) {
+            item.second->owned.store(false, std::memory_order_release);
+        }
+    }
+
+    auto find(std::uint64_t id) const noexcept -> ring_t* {
+        for (const auto& item : items) {
+            if (item.first == id) {
+                return item.second.get();
+            }
+        }
+
+        return nullptr;
+    }
+};
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wglobal-constructors"
+#pragma clang diagnostic ignored "-Wexit-time-destructors"
+
+std::atomic<std::uint64_t> counter(0);
+
+thread_local bindings_t bindings;
+
+#pragma clang diagnostic pop
+
+}  // namespace
+
+class recorder_t::inner_t {
+public:
+    const std::uint64_t id;
+
+    std::unique_ptr<handler_t> handler;
+    const severity_t threshold;
+    const severity_t trigger;
+    const std::size_t capacity;
+    const std::size_t slot;
+
+    /// Rings of all threads, either running or finished ones waiting for reuse.
+    mutable std::mutex mutex;
+    std::vector<std::shared_ptr<ring_t>> rings;
+
+    metrics::counter_t recorded;
+    metrics::counter_t dumped;
+    metrics::counter_t overwritten;
+    metrics::counter_t dumps;
+
+    /// Source of recorded records dumped on fatal signals, declared last to be unregistered first.
+    detail::crash::registration_t registration;
+
+    inner_t(std::unique_ptr<handler_t> handler, severity_t threshold, severity_t trigger,
+            std::size_t capacity, std::size_t slot) :
+        id(++counter),
+        handler(std::move(handler)),
+        threshold(threshold),
+        trigger(trigger),
+        capacity(capacity),
+        slot(slot),
+        registration(&crash, this)
+    {}
+
+    /// Writes records of all rings as `[severity] message` lines without locking.
+    static auto crash(const void* context, int fd) -> void {
+        for (const auto& ring : static_cast<const inner_t*>(context)->rings) {
+            const auto capacity = ring->records.size();
+
+            for (std::size_t id = 0; id < ring->size && capacity != 0; ++id) {
+                const auto& value = ring->records[(ring->head + id) % capacity];
+                if (value.size() == 0) {
+                    continue;
+                }
+
+                const auto record = value.into_view();
+                detail::crash::write(fd, string_view("["));
+                detail::crash::write(fd, static_cast<std::int64_t>(record.severity()));
+                detail::crash::write(fd, string_view("] "));
+                detail::crash::write(fd, record.formatted());
+                detail::crash::write(fd, string_view("\n"));
+            }
+        }
+    }
+
+    /// Returns the ring of the calling thread, binding one if there is no such ring yet.
+    auto local() -> ring_t& {
+        if (auto ring = bindings.find(id)) {
+            return *ring;
+        }
+
+        std::shared_ptr<ring_t> ring;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (const auto& item : rings) {
+                bool owned = false;
+                if (!item->owned.load(std::memory_order_relaxed) &&
+                    item->owned.compare_exchange_strong(owned, true, std::memory_order_acquire))
+                {
+                    ring = item;
+                    break;
+                }
+            }
+
+            if (ring == nullptr) {
+                ring = std::make_shared<ring_t>(capacity, slot);
+                rings.push_back(ring);
+            }
+        }
+
+        {
+            // Records of the finished thread are no context for this one.
+            std::lock_guard<std::mutex> lock(ring->mutex);
+            overwritten.add(ring->clear());
+        }
+
+        // Bindings of destroyed recorders are pruned here, since it's the only place they grow.
+        auto& items = bindings.items;
+        for (auto it = items.begin(); it != items.end();) {
+            if (it->second.use_count() == 1) {
+                it = items.erase(it);
+            } else {
+                ++it;
+            }
+        }
+
+        items.emplace_back(id, ring);
+        return *ring;
+    }
+
+    auto dump(ring_t& ring) -> void {
+        std::lock_guard<std::mutex> lock(ring.mutex);
+
+        if (ring.size != 0) {
+            dumps.add();
+            dumped.add(ring.dump(*handler));
+        }
+    }
+};
+
+constexpr std::size_t recorder_t::default_capacity;
+constexpr std::size_t recorder_t::default_slot;
+
+recorder_t::recorder_t(std::unique_ptr<handler_t> handler, severity_t threshold, severity_t trigger,
+                       std::size_t capacity, std::size_t slot)
+{
+    if (capacity == 0) {
+        throw std::invalid_argument("recorder capacity must be positive");
+    }
+
+    if (slot == 0) {
+        throw std::invalid_argument("recorder slot size must be positive");
+    }
+
+    d.reset(new inner_t(std::move(handler), threshold, trigger, capacity, slot));
+}
+
+recorder_t::~recorder_t() {
+    // Rings may outlive the recorder while being bound to running threads, but not its records.
+    std::lock_guard<std::mutex> lock(d->mutex);
+    for (const auto& ring : d->rings) {
+        std::lock_guard<std::mutex> guard(ring->mutex);
+        ring->release();
+    }
+}
+
+auto recorder_t::handle(const record_t& record) -> void {
+    const auto severity = record.severity();
+
+    if (severity >= d->trigger) {
+        if (auto ring = bindings.find(d->id)) {
+            d->dump(*ring);
+        }
+
+        return d->handler->handle(record);
+    }
+
+    if (severity >= d->threshold) {
+        return d->handler->handle(record);
+    }
+
+    auto& ring = d->local();
+
+    std::lock_guard<std::mutex> lock(ring.mutex);
+    if (ring.push(record)) {
+        d->overwritten.add();
+    }
+
+    d->recorded.add();
+}
+
+auto recorder_t::flush(std::chrono::steady_clock::time_point deadline) -> bool {
+    return d->handler->flush(deadline);
+}
+
+auto recorder_t::collect(metrics::collector_t& collector) const -> void {
+    collector.counter("blackhole_recorder_records_total", d->recorded.get());
+    collector.counter("blackhole_recorder_dumped_total", d->dumped.get());
+    collector.counter("blackhole_recorder_overwritten_total", d->overwritten.get());
+    collector.counter("blackhole_recorder_dumps_total", d->dumps.get());
+
+    d->handler->collect(collector);
+}
+
+auto recorder_t::pressure() const -> pressure_t {
+    return d->handler->pressure();
+}
+
+auto recorder_t::dump() -> void {
+    if (auto ring = bindings.find(d->id)) {
+        d->dump(*ring);
+    }
+}
+
+auto recorder_t::dump_all() -> void {
+    std::vector<std::shared_ptr<ring_t>> rings;
+
+    {
+        std::lock_guard<std::mutex> lock(d->mutex);
+        rings = d->rings;
+    }
+
+    for (const auto& ring : rings) {
+        d->dump(*ring);
+    }
+}
+
+}  // namespace handler
+
+using handler::recorder_t;
+
+class builder<recorder_t>::inner_t {
+public:
+    std::unique_ptr<handler_t> handler;
+    severity_t threshold;
+    severity_t trigger;
+    std::size_t capacity;
+    std::size_t slot;
+};
+
+builder<recorder_t>::builder(std::unique_ptr<handler_t> handler, severity_t trigger) :
+    d(new inner_t{std::move(handler), trigger, trigger, recorder_t::default_capacity,
+        recorder_t::default_slot})
+{}
+
+auto builder<recorder_t>::threshold(severity_t severity) & -> builder& {
+    d->threshold = severity;
+    return *this;
+}
+
+auto builder<recorder_t>::threshold(severity_t severity) && -> builder&& {
+    return std::move(threshold(severity));
+}
+
+auto builder<recorder_t>::capacity(std::size_t value) & -> builder& {
+    d->capacity = value;
+    return *this;
+}
+
+auto builder<recorder_t>::capacity(std::size_t value) && -> builder&& {
+    return std::move(capacity(value));
+}
+
+auto builder<recorder_t>::slot(std::size_t bytes) & -> builder& {
+    d->slot = bytes;
+    return *this;
+}
+
+auto builder<recorder_t>::slot(std::size_t bytes) && -> builder&& {
+    return std::move(slot(bytes));
+}
+
+auto builder<recorder_t>::build() && -> std::unique_ptr<recorder_t> {
+    return blackhole::make_unique<recorder_t>(std::move(d->handler), d->threshold, d->trigger,
+        d->capacity, d->slot);
+}
+
+auto factory<recorder_t>::type() const noexcept -> const char* {
+    return "recorder";
+}
+
+auto factory<recorder_t>::from(const config::node_t& config) const -> std::unique_ptr<handler_t> {
+    const auto trigger = config["trigger"].to_sint64();
+    if (!trigger) {
+        throw std::invalid_argument("recorder handler must have a trigger severity");
+    }
+
+    auto inner = config["handler"];
+    if (!inner) {
+        throw std::invalid_argument("recorder handler must have a wrapped handler");
+    }
+
+    const auto type = inner["type"].to_string().get_value_or("blocking");
+    builder<recorder_t> builder(registry.handler(type)(*inner.unwrap()),
+        static_cast<int>(trigger.get()));
+
+    if (auto threshold = config["threshold"].to_sint64()) {
+        builder.threshold(static_cast<int>(threshold.get()));
+    }
+
+    if (auto capacity = config["capacity"].to_uint64()) {
+        builder.capacity(static_cast<std::size_t>(capacity.get()));
+    }
+
+    if (auto slot = config["slot"].to_uint64()) {
+        builder.slot(static_cast<std::size_t>(slot.get()));
+    }
+
+    return std::move(builder).build();
+}
+
+template auto deleter_t::operator()(builder<handler::recorder_t>::inner_t*) -> void;
+
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,95 @@
+#include "blackhole/immortal.hpp"
+
+#include <atomic>
+#include <cstdint>
+
+#ifdef __linux__
+#include <link.h>
+#endif
+
+namespace blackhole {
+inline namespace v1 {
+namespace immortal {
+namespace {
+
+constexpr std::size_t capacity = 32;
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wglobal-constructors"
+
+/// Ranges are published by the count, so readers never lock.
+std::atomic<std::uintptr_t> begins[capacity];
+std::atomic<std::uintptr_t> ends[capacity];
+std::atomic<std::size_t> count(0);
+
+/// Serializes declarations, trivially destructible unlike mutexes.
+std::atomic_flag declaring = ATOMIC_FLAG_INIT;
+
+#pragma clang diagnostic pop
+
+/// Declares read-only segments of the executable, which is the first object visited.
+auto scan() noexcept -> bool {
+#ifdef __linux__
+    ::dl_iterate_phdr([](struct dl_phdr_info* info, std::size_t, void*) -> int {
+        for (ElfW(Half) id = 0; id < info->dlpi_phnum; ++id) {
+            const auto& header = info->dlpi_phdr[id];
+
+            if (header.p_type == PT_LOAD && (header.p_flags & PF_W) == 0) {
+                declare(reinterpret_cast<const void*>(info->dlpi_addr + header.p_vaddr),
+                    static_cast<std::size_t>(header.p_memsz));
+            }
+        }
+
+        return 1;
+    }, nullptr);
+#endif
+
+    return true;
+}
+
+}  // namespace
+
+auto declare(const void* data, std::size_t size) noexcept -> bool {
+    while (declaring.test_and_set(std::memory_order_acquire)) {}
+
+    const auto id = count.load(std::memory_order_relaxed);
+    const auto available = id < capacity;
+
+    if (available) {
+        const auto begin = reinterpret_cast<std::uintptr_t>(data);
+        begins[id].store(begin, std::memory_order_relaxed);
+        ends[id].store(begin + size, std::memory_order_relaxed);
+        count.store(id + 1, std::memory_order_release);
+    }
+
+    declaring.clear(std::memory_order_release);
+
+    return available;
+}
+
+auto contains(const string_view& value) noexcept -> bool {
+    static const bool scanned = scan();
+    static_cast<void>(scanned);
+
+    if (value.size() == 0) {
+        return false;
+    }
+
+    const auto begin = reinterpret_cast<std::uintptr_t>(value.data());
+    const auto end = begin + value.size();
+    const auto size = count.load(std::memory_order_acquire);
+
+    for (std::size_t id = 0; id < size; ++id) {
+        if (begin >= begins[id].load(std::memory_order_relaxed) &&
+            end <= ends[id].load(std::memory_order_relaxed))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+}  // namespace immortal
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,212 @@
+#include "blackhole/metrics.hpp"
+
+#include <algorithm>
+
+#include "blackhole/extensions/format.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace metrics {
+namespace {
+
+/// Returns the shard of the calling thread, assigned round-robin on the first call.
+auto shard() noexcept -> std::size_t {
+    static std::atomic<std::size_t> counter(0);
+    thread_local const std::size_t id = counter.fetch_add(1, std::memory_order_relaxed) % shards;
+    return id;
+}
+
+auto escape(const std::string& value) -> std::string {
+    std::string result;
+    result.reserve(value.size());
+
+    for (auto c : value) {
+        switch (c) {
+        case '\\':
+            result += "\\\\";
+            break;
+        case '"':
+            result += "\\\"";
+            break;
+        case '\n':
+            result += "\\n";
+            break;
+        default:
+            result += c;
+        }
+    }
+
+    return result;
+}
+
+/// Formats labels with an optional extra one, returning an empty string if there are no labels.
+auto format(const std::vector<std::pair<std::string, std::string>>& labels,
+    const std::string& extra = std::string()) -> std::string
+{
+    fmt::MemoryWriter wr;
+
+    for (const auto& label : labels) {
+        wr << (wr.size() == 0 ? "{" : ",") << label.first << "=\"" << escape(label.second) << "\"";
+    }
+
+    if (!extra.empty()) {
+        wr << (wr.size() == 0 ? "{" : ",") << extra;
+    }
+
+    if (wr.size() != 0) {
+        wr << "}";
+    }
+
+    return wr.str();
+}
+
+auto seconds(std::uint64_t nanoseconds) -> std::string {
+    return fmt::format("{:.12g}", static_cast<double>(nanoseconds) / 1e9);
+}
+
+}  // namespace
+
+counter_t::counter_t() noexcept {
+    for (auto& shard : values) {
+        shard.value.store(0, std::memory_order_relaxed);
+    }
+}
+
+auto counter_t::add(std::uint64_t value) noexcept -> void {
+    values[shard()].value.fetch_add(value, std::memory_order_relaxed);
+}
+
+auto counter_t::get() const noexcept -> std::uint64_t {
+    std::uint64_t result = 0;
+    for (const auto& shard : values) {
+        result += shard.value.load(std::memory_order_relaxed);
+    }
+
+    return result;
+}
+
+constexpr std::size_t histogram_t::buckets;
+
+histogram_t::histogram_t() noexcept {
+    for (auto& shard : values) {
+        for (auto& count : shard.counts) {
+            count.store(0, std::memory_order_relaxed);
+        }
+
+        shard.sum.store(0, std::memory_order_relaxed);
+    }
+}
+
+auto histogram_t::record(std::uint64_t value) noexcept -> void {
+    const auto bucket = value < 2 ?
+        0 :
+        std::min<std::size_t>(63 - static_cast<std::size_t>(__builtin_clzll(value)), buckets - 1);
+
+    auto& current = values[shard()];
+    current.counts[bucket].fetch_add(1, std::memory_order_relaxed);
+    current.sum.fetch_add(value, std::memory_order_relaxed);
+}
+
+auto histogram_t::counts() const -> std::vector<std::uint64_t> {
+    std::vector<std::uint64_t> result(buckets);
+
+    for (const auto& shard : values) {
+        for (std::size_t id = 0; id < buckets; ++id) {
+            result[id] += shard.counts[id].load(std::memory_order_relaxed);
+        }
+    }
+
+    return result;
+}
+
+auto histogram_t::sum() const noexcept -> std::uint64_t {
+    std::uint64_t result = 0;
+    for (const auto& shard : values) {
+        result += shard.sum.load(std::memory_order_relaxed);
+    }
+
+    return result;
+}
+
+collector_t::collector_t(snapshot_t& snapshot) :
+    snapshot(snapshot)
+{}
+
+auto collector_t::with(std::string key, std::string value) const -> collector_t {
+    collector_t result(*this);
+    result.labels.emplace_back(std::move(key), std::move(value));
+    return result;
+}
+
+auto collector_t::counter(std::string name, std::uint64_t value) -> void {
+    snapshot.push_back({std::move(name), labels, sample_t::kind_t::counter, value, {}, 0});
+}
+
+auto collector_t::gauge(std::string name, std::uint64_t value) -> void {
+    snapshot.push_back({std::move(name), labels, sample_t::kind_t::gauge, value, {}, 0});
+}
+
+auto collector_t::histogram(std::string name, const histogram_t& histogram) -> void {
+    auto counts = histogram.counts();
+
+    std::uint64_t total = 0;
+    for (auto count : counts) {
+        total += count;
+    }
+
+    snapshot.push_back({std::move(name), labels, sample_t::kind_t::histogram, total,
+        std::move(counts), histogram.sum()});
+}
+
+auto prometheus(const snapshot_t& snapshot) -> std::string {
+    fmt::MemoryWriter wr;
+
+    // Samples of the same metric must be grouped under a single type line.
+    std::vector<std::string> names;
+    for (const auto& sample : snapshot) {
+        if (std::find(names.begin(), names.end(), sample.name) == names.end()) {
+            names.push_back(sample.name);
+        }
+    }
+
+    for (const auto& name : names) {
+        bool typed = false;
+
+        for (const auto& sample : snapshot) {
+            if (sample.name != name) {
+                continue;
+            }
+
+            if (!typed) {
+                static const char* types[] = {"counter", "gauge", "histogram"};
+                wr << "# TYPE " << name << " " << types[static_cast<int>(sample.kind)] << "\n";
+                typed = true;
+            }
+
+            if (sample.kind != sample_t::kind_t::histogram) {
+                wr << name << format(sample.labels) << " " << sample.value << "\n";
+                continue;
+            }
+
+            // The last bucket is unbounded, so it's reported as "+Inf" only.
+            std::uint64_t accumulated = 0;
+            for (std::size_t id = 0; id + 1 < sample.buckets.size(); ++id) {
+                accumulated += sample.buckets[id];
+
+                const auto le = fmt::format("le=\"{}\"", seconds(std::uint64_t(1) << (id + 1)));
+                wr << name << "_bucket" << format(sample.labels, le) << " " << accumulated << "\n";
+            }
+
+            wr << name << "_bucket" << format(sample.labels, "le=\"+Inf\"") << " " << sample.value
+               << "\n";
+            wr << name << "_sum" << format(sample.labels) << " " << seconds(sample.sum) << "\n";
+            wr << name << "_count" << format(sample.labels) << " " << sample.value << "\n";
+        }
+    }
+
+    return wr.str();
+}
+
+}  // namespace metrics
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,89 @@
+#include "blackhole/detail/mutex.hpp"
+
+#ifdef __linux__
+#   include <linux/futex.h>
+#   include <sys/syscall.h>
+#   include <unistd.h>
+#endif
+
+#include <thread>
+
+namespace blackhole {
+inline namespace v1 {
+namespace detail {
+namespace {
+
+/// Spinning rounds, each one doubling the number of pauses up to the limit, which sums up to about
+/// a microsecond on modern hardware.
+constexpr int rounds = 8;
+constexpr int max_pauses = 64;
+
+inline auto pause() noexcept -> void {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield" ::: "memory");
+#else
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+#endif
+}
+
+auto park(std::atomic<std::uint32_t>& word, std::uint32_t value) noexcept -> void {
+#ifdef __linux__
+    ::syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word), FUTEX_WAIT_PRIVATE, value,
+        nullptr, nullptr, 0);
+#else
+    (void)word;
+    (void)value;
+    std::this_thread::yield();
+#endif
+}
+
+auto unpark(std::atomic<std::uint32_t>& word) noexcept -> void {
+#ifdef __linux__
+    ::syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word), FUTEX_WAKE_PRIVATE, 1, nullptr,
+        nullptr, 0);
+#else
+    (void)word;
+#endif
+}
+
+}  // namespace
+
+auto adaptive_mutex_t::contend() noexcept -> void {
+    auto pauses = 1;
+
+    for (int round = 0; round < rounds; ++round) {
+        for (int id = 0; id < pauses; ++id) {
+            pause();
+        }
+
+        pauses = pauses < max_pauses ? pauses * 2 : max_pauses;
+
+        // Spinning on a load keeps the cache line shared until the holder releases it.
+        if (state.load(std::memory_order_relaxed) != 0) {
+            continue;
+        }
+
+        std::uint32_t expected = 0;
+        if (state.compare_exchange_weak(expected, 1, std::memory_order_acquire,
+            std::memory_order_relaxed))
+        {
+            return;
+        }
+    }
+
+    // Marking the mutex as having waiters makes the holder wake one of them up on unlock, while a
+    // thread acquiring it this way keeps the mark, since other waiters may still be parked.
+    while (state.exchange(2, std::memory_order_acquire) != 0) {
+        park(state, 2);
+    }
+}
+
+auto adaptive_mutex_t::wake() noexcept -> void {
+    unpark(state);
+}
+
+}  // namespace detail
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,115 @@
+#include "blackhole/detail/pages.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <system_error>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <boost/align/aligned_alloc.hpp>
+
+#include "blackhole/detail/budget.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace detail {
+namespace {
+
+/// Size of huge pages taken from the reserved pool, which is the default one on x86-64.
+constexpr std::size_t huge_page = 2 * 1024 * 1024;
+
+auto round(std::size_t size, std::size_t page) noexcept -> std::size_t {
+    return (size + page - 1) / page * page;
+}
+
+auto map(std::size_t size, int flags) noexcept -> void* {
+    const auto memory = ::mmap(nullptr, size, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS | flags, -1, 0);
+    return memory == MAP_FAILED ? nullptr : memory;
+}
+
+}  // namespace
+
+pages_t::pages_t(std::size_t size, std::size_t alignment, const paging_t& paging) :
+    data_(nullptr),
+    size_(size),
+    mapped(paging.enabled())
+{
+    if (!mapped) {
+        data_ = static_cast<char*>(boost::alignment::aligned_alloc(alignment, size));
+        if (data_ == nullptr) {
+            throw std::bad_alloc();
+        }
+
+        std::memset(data_, 0, size);
+        budget::charge(size_);
+        return;
+    }
+
+    int flags = 0;
+#ifdef MAP_POPULATE
+    if (paging.populate) {
+        flags |= MAP_POPULATE;
+    }
+#endif
+
+    void* memory = nullptr;
+
+#ifdef MAP_HUGETLB
+    // The reserved pool is often empty, so the mapping silently falls back to regular pages.
+    if (paging.huge) {
+        size_ = round(size, huge_page);
+        memory = map(size_, flags | MAP_HUGETLB);
+    }
+#endif
+
+    if (memory == nullptr) {
+        size_ = round(size, static_cast<std::size_t>(::sysconf(_SC_PAGESIZE)));
+        memory = map(size_, flags);
+
+        if (memory == nullptr) {
+            throw std::system_error(errno, std::system_category(), "failed to map pages");
+        }
+
+#ifdef MADV_HUGEPAGE
+        if (paging.huge) {
+            // Transparent huge pages are an optimization hint only, so errors are ignored.
+            ::madvise(memory, size_, MADV_HUGEPAGE);
+        }
+#endif
+    }
+
+    data_ = static_cast<char*>(memory);
+
+    if (paging.lock && ::mlock(data_, size_) != 0) {
+        const auto ec = errno;
+        ::munmap(data_, size_);
+        throw std::system_error(ec, std::system_category(), "failed to lock pages");
+    }
+
+    budget::charge(size_);
+}
+
+pages_t::~pages_t() {
+    budget::release(size_);
+
+    if (mapped) {
+        ::munmap(data_, size_);
+    } else {
+        boost::alignment::aligned_free(data_);
+    }
+}
+
+auto pages_t::data() const noexcept -> char* {
+    return data_;
+}
+
+auto pages_t::size() const noexcept -> std::size_t {
+    return size_;
+}
+
+}  // namespace detail
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,35 @@
+#include "blackhole/pressure.hpp"
+
+#include <algorithm>
+
+namespace blackhole {
+inline namespace v1 {
+
+pressure_t::pressure_t(double fill, std::uint64_t dropped) noexcept :
+    fill(fill),
+    dropped(dropped),
+    rate(0.0),
+    level(classify(fill, 0.0))
+{}
+
+auto pressure_t::merge(const pressure_t& other) noexcept -> void {
+    fill = std::max(fill, other.fill);
+    dropped += other.dropped;
+    rate += other.rate;
+    level = std::max(level, other.level);
+}
+
+auto pressure_t::classify(double fill, double rate) noexcept -> level_t {
+    if (fill >= 0.95 || rate > 0.0) {
+        return level_t::critical;
+    } else if (fill >= 0.8) {
+        return level_t::high;
+    } else if (fill >= 0.5) {
+        return level_t::elevated;
+    }
+
+    return level_t::normal;
+}
+
+}  // namespace v1
+}  // namespace blackhole
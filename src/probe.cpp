@@ -0,0 +1,14 @@
+#include "blackhole/detail/probe.hpp"
+
+#if defined(BLACKHOLE_HAS_USDT)
+
+// Tracers increment semaphores of probes they attach to, which lives in the dedicated section.
+#define BLACKHOLE_PROBE_SEMAPHORE_DEFINE(name)                                                     \
+    __extension__ unsigned short BLACKHOLE_PROBE_SEMAPHORE(name)                                 \
+        __attribute__((unused)) __attribute__((section(".probes"))) = 0;
+
+extern "C" {
+BLACKHOLE_PROBES(BLACKHOLE_PROBE_SEMAPHORE_DEFINE)
+}
+
+#endif
@@ -0,0 +1,254 @@
+#include "blackhole/detail/process.hpp"
+
+#include <netdb.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#   include <sys/syscall.h>
+#endif
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <string>
+
+namespace blackhole {
+inline namespace v1 {
+namespace detail {
+namespace {
+
+/// Thread-local cache, zero-initialized for each thread, which allows to avoid dynamic TLS
+/// initialization wrappers.
+thread_local std::uint64_t lwp_cache = 0;
+
+auto gettid() noexcept -> std::uint64_t {
+#ifdef __linux__
+    return static_cast<std::uint64_t>(::syscall(SYS_gettid));
+#elif __APPLE__
+    std::uint64_t tid = 0;
+    ::pthread_threadid_np(nullptr, &tid);
+    return tid;
+#endif
+}
+
+/// Registers the fork handler resetting caches once, on the first use of any of them.
+auto watch_forks() noexcept -> void;
+
+class pid_cache_t {
+    std::atomic<std::uint64_t> value;
+
+public:
+    pid_cache_t() noexcept :
+        value(static_cast<std::uint64_t>(::getpid()))
+    {
+        watch_forks();
+    }
+
+    static auto instance() noexcept -> pid_cache_t&;
+
+    auto get() const noexcept -> std::uint64_t {
+        return value.load(std::memory_order_relaxed);
+    }
+
+    auto reset() noexcept -> void {
+        value.store(static_cast<std::uint64_t>(::getpid()), std::memory_order_relaxed);
+    }
+};
+
+auto pid_cache_t::instance() noexcept -> pid_cache_t& {
+    static pid_cache_t cache;
+    return cache;
+}
+
+/// Called in the child process after fork. Only the forking thread survives, so it's enough to
+/// reset its own kernel thread id cache.
+auto on_fork() -> void {
+    pid_cache_t::instance().reset();
+    lwp_cache = 0;
+}
+
+auto watch_forks() noexcept -> void {
+    static const bool watched = ::pthread_atfork(nullptr, nullptr, &on_fork) == 0;
+    static_cast<void>(watched);
+}
+
+/// Thread names cache generation, bumped on each invalidation.
+std::atomic<std::uint64_t> names_generation(0);
+
+/// Small fixed-size cache of thread names with round-robin eviction.
+///
+/// Note that native handles may be reused after a thread exits, in that case the cache returns the
+/// name of the exited thread until the entry is evicted or invalidated.
+class names_cache_t {
+    struct entry_t {
+        std::thread::native_handle_type tid;
+        std::array<char, 16> name;
+        std::size_t size;
+    };
+
+    std::array<entry_t, 16> entries;
+    std::size_t count;
+    std::size_t next;
+    std::uint64_t generation;
+
+public:
+    names_cache_t() noexcept :
+        count(0),
+        next(0),
+        generation(0)
+    {}
+
+    auto get(std::thread::native_handle_type tid) -> string_view {
+        const auto current = names_generation.load(std::memory_order_acquire);
+
+        if (generation != current) {
+            count = 0;
+            next = 0;
+            generation = current;
+        }
+
+        for (std::size_t id = 0; id < count; ++id) {
+            if (entries[id].tid == tid) {
+                return {entries[id].name.data(), entries[id].size};
+            }
+        }
+
+        auto& entry = entries[next];
+        next = (next + 1) % entries.size();
+        count = std::min(count + 1, entries.size());
+
+        entry.tid = tid;
+        entry.size = 0;
+
+        if (::pthread_getname_np(tid, entry.name.data(), entry.name.size()) == 0) {
+            entry.size = std::strlen(entry.name.data());
+        }
+
+        return {entry.name.data(), entry.size};
+    }
+};
+
+}  // namespace
+
+namespace this_process {
+
+auto id() noexcept -> std::uint64_t {
+    return pid_cache_t::instance().get();
+}
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wexit-time-destructors"
+
+auto host() -> string_view {
+    static const std::string value = [] {
+        char buffer[256] = {};
+
+        if (::gethostname(buffer, sizeof(buffer) - 1) != 0) {
+            return std::string();
+        }
+
+        return std::string(buffer);
+    }();
+
+    return value;
+}
+
+auto fqdn() -> string_view {
+    static const std::string value = [] {
+        const auto name = host().to_string();
+
+        addrinfo hints{};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_flags = AI_CANONNAME;
+
+        addrinfo* result = nullptr;
+        if (name.empty() || ::getaddrinfo(name.c_str(), nullptr, &hints, &result) != 0) {
+            return name;
+        }
+
+        const std::unique_ptr<addrinfo, void(*)(addrinfo*)> guard(result, &::freeaddrinfo);
+
+        if (result->ai_canonname == nullptr || result->ai_canonname[0] == '\0') {
+            return name;
+        }
+
+        return std::string(result->ai_canonname);
+    }();
+
+    return value;
+}
+
+#pragma clang diagnostic pop
+
+}  // namespace this_process
+
+namespace this_thread {
+
+auto native_handle() noexcept -> std::thread::native_handle_type {
+    return ::pthread_self();
+}
+
+auto lwp() noexcept -> std::uint64_t {
+    if (lwp_cache == 0) {
+        watch_forks();
+        lwp_cache = gettid();
+    }
+
+    return lwp_cache;
+}
+
+auto hex(std::thread::native_handle_type tid) noexcept -> string_view {
+    struct entry_t {
+        std::thread::native_handle_type tid;
+        bool valid;
+        std::array<char, 2 + 2 * sizeof(std::uint64_t)> data;
+        std::size_t size;
+    };
+
+    thread_local entry_t entry{};
+
+    if (entry.valid && entry.tid == tid) {
+        return {entry.data.data(), entry.size};
+    }
+
+#ifdef __linux__
+    auto value = static_cast<std::uint64_t>(tid);
+#elif __APPLE__
+    auto value = static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(tid));
+#endif
+
+    // Digits are written backwards and then moved right after the prefix.
+    auto end = entry.data.end();
+    auto pos = end;
+    do {
+        *--pos = "0123456789abcdef"[value & 0xf];
+        value >>= 4;
+    } while (value != 0);
+
+    entry.data[0] = '0';
+    entry.data[1] = 'x';
+    const auto last = std::copy(pos, end, entry.data.begin() + 2);
+
+    entry.tid = tid;
+    entry.valid = true;
+    entry.size = static_cast<std::size_t>(last - entry.data.begin());
+
+    return {entry.data.data(), entry.size};
+}
+
+auto name(std::thread::native_handle_type tid) -> string_view {
+    thread_local names_cache_t cache;
+    return cache.get(tid);
+}
+
+auto invalidate_names() noexcept -> void {
+    names_generation.fetch_add(1, std::memory_order_release);
+}
+
+}  // namespace this_thread
+}  // namespace detail
+}  // namespace v1
+}  // namespace blackhole
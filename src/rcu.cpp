@@ -0,0 +1,111 @@
+#include "blackhole/detail/rcu.hpp"
+
+#include <mutex>
+#include <thread>
+
+#include <boost/assert.hpp>
+
+namespace blackhole {
+inline namespace v1 {
+namespace detail {
+namespace rcu {
+namespace {
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wglobal-constructors"
+#pragma clang diagnostic ignored "-Wexit-time-destructors"
+
+/// Protects the list of registered readers. Held only while scanning the list, never while waiting
+/// for readers, so threads registering on their first use are not blocked by slow ones.
+std::mutex mutex;
+
+/// Serializes writers doing grace period detection.
+std::mutex writers;
+
+/// Head of the intrusive list of registered readers.
+reader_t* head = nullptr;
+
+/// Global epoch, incremented on each grace period. Zero is reserved for quiescent readers.
+std::atomic<std::uint64_t> global(1);
+
+#pragma clang diagnostic pop
+
+/// Checks whether any registered reader is inside a critical section entered before the given
+/// epoch.
+auto lagging(std::uint64_t target) -> bool {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    for (auto it = head; it != nullptr; it = it->next) {
+        const auto epoch = it->epoch.load(std::memory_order_acquire);
+
+        if (epoch != 0 && epoch < target) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+}  // namespace
+
+reader_t::reader_t() noexcept :
+    epoch(0),
+    nesting(0),
+    prev(nullptr),
+    next(nullptr)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    next = head;
+    if (head) {
+        head->prev = this;
+    }
+    head = this;
+}
+
+reader_t::~reader_t() {
+    BOOST_ASSERT(nesting == 0);
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (prev) {
+        prev->next = next;
+    } else {
+        head = next;
+    }
+
+    if (next) {
+        next->prev = prev;
+    }
+}
+
+auto reader() noexcept -> reader_t& {
+    thread_local reader_t state;
+    return state;
+}
+
+auto epoch() noexcept -> const std::atomic<std::uint64_t>& {
+    return global;
+}
+
+auto synchronize() noexcept -> void {
+    BOOST_ASSERT(reader().nesting == 0 && "synchronize from inside of a read-side critical section");
+
+    std::lock_guard<std::mutex> lock(writers);
+
+    // Readers that observed the new epoch have also observed every pointer published before this
+    // increment, so it's only required to wait for ones that entered their sections earlier.
+    const auto target = global.fetch_add(1, std::memory_order_seq_cst) + 1;
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    // Readers can't be pinned outside of the list lock, since they are destroyed on thread exit,
+    // so the list is rescanned until no reader lags behind.
+    while (lagging(target)) {
+        std::this_thread::yield();
+    }
+}
+
+}  // namespace rcu
+}  // namespace detail
+}  // namespace v1
+}  // namespace blackhole
@@ -3,7 +3,10 @@
 #include <thread>
 
 #include "blackhole/attribute.hpp"
+#include "blackhole/attribute/table.hpp"
+#include "blackhole/clock.hpp"
 
+#include "blackhole/detail/process.hpp"
 #include "blackhole/detail/record.hpp"
 
 namespace blackhole {
@@ -22,9 +25,14 @@ record_t::record_t(severity_t severity,
     inner.severity = severity;
     inner.timestamp = time_point();
 
-    inner.tid = ::pthread_self();
+    inner.tid = detail::this_thread::native_handle();
+    inner.lwp = detail::this_thread::lwp();
 
     inner.attributes = attributes;
+    inner.unique = nullptr;
+    inner.table = nullptr;
+
+    inner.trace = trace::current();
 }
 
 record_t::record_t(inner_t inner) noexcept {
@@ -35,6 +43,16 @@ auto record_t::message() const noexcept -> const string_view& {
     return inner().message.get();
 }
 
+auto record_t::pattern_id() const noexcept -> std::uintptr_t {
+    return reinterpret_cast<std::uintptr_t>(inner().message.get().data());
+}
+
+auto record_t::pattern_hash() const noexcept -> std::uint64_t {
+    // Fibonacci hashing folded in half, since addresses have both low and high bits fixed.
+    const auto hash = static_cast<std::uint64_t>(pattern_id()) * 0x9e3779b97f4a7c15ull;
+    return hash ^ (hash >> 32);
+}
+
 auto record_t::severity() const noexcept -> severity_t {
     return inner().severity;
 }
@@ -44,13 +62,21 @@ auto record_t::timestamp() const noexcept -> time_point {
 }
 
 auto record_t::pid() const noexcept -> std::uint64_t {
-    return static_cast<std::uint64_t>(::getpid());
+    return detail::this_process::id();
 }
 
 auto record_t::tid() const noexcept -> std::thread::native_handle_type {
     return inner().tid;
 }
 
+auto record_t::lwp() const noexcept -> std::uint64_t {
+    return inner().lwp;
+}
+
+auto record_t::trace() const noexcept -> const trace_t& {
+    return inner().trace;
+}
+
 auto record_t::formatted() const noexcept -> const string_view& {
     return inner().formatted;
 }
@@ -59,17 +85,48 @@ auto record_t::attributes() const noexcept -> const attribute_pack& {
     return inner().attributes.get();
 }
 
+auto record_t::unique_attributes() const -> const unique_attributes_t& {
+    if (const auto unique = inner().unique) {
+        return *unique;
+    }
+
+    thread_local unique_attributes_t unique;
+    unique.reset(attributes());
+    return unique;
+}
+
+auto record_t::attach(const unique_attributes_t& unique) noexcept -> void {
+    inner().unique = &unique;
+}
+
+auto record_t::table() const -> const attribute::table_t& {
+    if (const auto table = inner().table) {
+        return *table;
+    }
+
+    thread_local attribute::table_t table;
+    table.reset(unique_attributes());
+    return table;
+}
+
+auto record_t::attach(const attribute::table_t& table) noexcept -> void {
+    inner().table = &table;
+}
+
 auto record_t::is_active() const noexcept -> bool {
     return inner().timestamp != time_point();
 }
 
 auto record_t::activate(const string_view& formatted) noexcept -> void {
+    activate(formatted, clock::timestamp(clock_source_t::precise));
+}
+
+auto record_t::activate(const string_view& formatted, time_point timestamp) noexcept -> void {
     if (formatted.data() != nullptr) {
         inner().formatted = formatted;
     }
 
-    // TODO: I can use coarse clock in linux.
-    inner().timestamp = clock_type::now();
+    inner().timestamp = timestamp;
 }
 
 auto record_t::inner() noexcept -> inner_t& {
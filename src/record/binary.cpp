@@ -0,0 +1,370 @@
+#include "blackhole/record/binary.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+
+#include <boost/mpl/begin.hpp>
+#include <boost/mpl/distance.hpp>
+#include <boost/mpl/find.hpp>
+#include <boost/variant/apply_visitor.hpp>
+
+#include "blackhole/extensions/writer.hpp"
+
+#include "blackhole/detail/attribute.hpp"
+#include "blackhole/detail/record.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace binary {
+namespace {
+
+using attribute::view_t;
+
+/// Returns the position of the given type in the attribute value types sequence.
+template<typename T>
+constexpr auto tag_of() -> std::uint8_t {
+    return static_cast<std::uint8_t>(boost::mpl::distance<
+        boost::mpl::begin<view_t::types>::type,
+        typename boost::mpl::find<view_t::types, T>::type
+    >::value);
+}
+
+constexpr auto zigzag(std::int64_t value) noexcept -> std::uint64_t {
+    return (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63);
+}
+
+constexpr auto unzigzag(std::uint64_t value) noexcept -> std::int64_t {
+    return static_cast<std::int64_t>(value >> 1) ^ -static_cast<std::int64_t>(value & 1);
+}
+
+auto nanoseconds(const record_t::time_point& timestamp) -> std::int64_t {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(timestamp.time_since_epoch()).count();
+}
+
+auto varint(std::string& buffer, std::uint64_t value) -> void {
+    while (value >= 0x80) {
+        buffer.push_back(static_cast<char>(value | 0x80));
+        value >>= 7;
+    }
+
+    buffer.push_back(static_cast<char>(value));
+}
+
+auto string(std::string& buffer, const string_view& value) -> void {
+    varint(buffer, value.size());
+    buffer.append(value.data(), value.size());
+}
+
+class value_encoder_t : public boost::static_visitor<> {
+    std::string& buffer;
+
+public:
+    explicit value_encoder_t(std::string& buffer) noexcept :
+        buffer(buffer)
+    {}
+
+    auto operator()(const view_t::null_type&) const -> void {
+        buffer.push_back(static_cast<char>(tag_of<view_t::null_type>()));
+    }
+
+    auto operator()(const view_t::bool_type& value) const -> void {
+        buffer.push_back(static_cast<char>(tag_of<view_t::bool_type>()));
+        buffer.push_back(value ? 1 : 0);
+    }
+
+    auto operator()(const view_t::sint64_type& value) const -> void {
+        buffer.push_back(static_cast<char>(tag_of<view_t::sint64_type>()));
+        varint(buffer, zigzag(value));
+    }
+
+    auto operator()(const view_t::uint64_type& value) const -> void {
+        buffer.push_back(static_cast<char>(tag_of<view_t::uint64_type>()));
+        varint(buffer, value);
+    }
+
+    auto operator()(const view_t::double_type& value) const -> void {
+        buffer.push_back(static_cast<char>(tag_of<view_t::double_type>()));
+
+        std::uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+
+        for (int id = 0; id < 8; ++id) {
+            buffer.push_back(static_cast<char>(bits >> (8 * id)));
+        }
+    }
+
+    auto operator()(const view_t::string_type& value) const -> void {
+        buffer.push_back(static_cast<char>(tag_of<view_t::string_type>()));
+        string(buffer, value);
+    }
+
+    auto operator()(const view_t::function_type& value) const -> void {
+        writer_t wr;
+        value(wr);
+
+        (*this)(wr.result());
+    }
+};
+
+/// Reads values from a frame body, checking its bounds.
+class reader_t {
+    const char* data;
+    const char* end;
+
+public:
+    reader_t(const char* data, const char* end) noexcept :
+        data(data),
+        end(end)
+    {}
+
+    auto exhausted() const noexcept -> bool {
+        return data == end;
+    }
+
+    auto byte() -> std::uint8_t {
+        if (data == end) {
+            throw std::invalid_argument("malformed binary record: unexpected end of frame");
+        }
+
+        return static_cast<std::uint8_t>(*data++);
+    }
+
+    auto varint() -> std::uint64_t {
+        std::uint64_t result = 0;
+
+        for (int shift = 0; shift < 64; shift += 7) {
+            const auto value = byte();
+            result |= static_cast<std::uint64_t>(value & 0x7f) << shift;
+
+            if ((value & 0x80) == 0) {
+                return result;
+            }
+        }
+
+        throw std::invalid_argument("malformed binary record: varint is too long");
+    }
+
+    auto read(std::uint64_t size) -> string_view {
+        if (size > static_cast<std::uint64_t>(end - data)) {
+            throw std::invalid_argument("malformed binary record: unexpected end of frame");
+        }
+
+        const string_view result(data, size);
+        data += size;
+        return result;
+    }
+
+    auto string() -> string_view {
+        return read(varint());
+    }
+
+    auto value() -> view_t {
+        const auto tag = byte();
+
+        switch (tag) {
+        case tag_of<view_t::null_type>():
+            return view_t();
+        case tag_of<view_t::bool_type>():
+            return view_t(byte() != 0);
+        case tag_of<view_t::sint64_type>():
+            return view_t(unzigzag(varint()));
+        case tag_of<view_t::uint64_type>():
+            return view_t(varint());
+        case tag_of<view_t::double_type>(): {
+            std::uint64_t bits = 0;
+            for (int id = 0; id < 8; ++id) {
+                bits |= static_cast<std::uint64_t>(byte()) << (8 * id);
+            }
+
+            double value;
+            std::memcpy(&value, &bits, sizeof(value));
+            return view_t(value);
+        }
+        case tag_of<view_t::string_type>():
+            return view_t(string());
+        default:
+            throw std::invalid_argument("malformed binary record: unknown value tag");
+        }
+    }
+};
+
+}  // namespace
+
+encoder_t::encoder_t() :
+    timestamp(0)
+{}
+
+auto encoder_t::encode(const record_t& record, std::string& buffer) -> void {
+    body.clear();
+
+    // Keys met for the first time are defined in front of the record, which refers to them by ids.
+    const auto defined = names.size();
+    std::uint64_t nattributes = 0;
+
+    for (const auto& list : record.attributes()) {
+        for (const auto& attribute : list.get()) {
+            ++nattributes;
+
+            if (keys.find(attribute.first) == keys.end()) {
+                names.emplace_back(attribute.first.data(), attribute.first.size());
+                keys.insert({string_view(names.back()), static_cast<std::uint32_t>(names.size() - 1)});
+            }
+        }
+    }
+
+    varint(body, names.size() - defined);
+    for (auto id = defined; id < names.size(); ++id) {
+        string(body, names[id]);
+    }
+
+    const auto now = nanoseconds(record.timestamp());
+
+    std::uint64_t tid = 0;
+    const auto handle = record.tid();
+    std::memcpy(&tid, &handle, std::min(sizeof(tid), sizeof(handle)));
+
+    varint(body, zigzag(record.severity()));
+    varint(body, zigzag(now - timestamp));
+    varint(body, tid);
+    varint(body, record.lwp());
+
+    timestamp = now;
+
+    const auto& message = record.message();
+    const auto& formatted = record.formatted();
+
+    string(body, message);
+
+    if (formatted == message) {
+        varint(body, 0);
+    } else {
+        varint(body, formatted.size() + 1);
+        body.append(formatted.data(), formatted.size());
+    }
+
+    varint(body, nattributes);
+
+    const value_encoder_t encoder(body);
+    for (const auto& list : record.attributes()) {
+        for (const auto& attribute : list.get()) {
+            varint(body, keys.find(attribute.first)->second);
+            boost::apply_visitor(encoder, attribute.second.inner().value);
+        }
+    }
+
+    varint(buffer, body.size());
+    buffer.append(body);
+}
+
+auto encoder_t::reset() -> void {
+    timestamp = 0;
+    keys.clear();
+    names.clear();
+}
+
+decoder_t::decoder_t() :
+    timestamp(0)
+{}
+
+auto decoder_t::decode(const char* data, std::size_t size) -> std::size_t {
+    // The frame size prefix may be incomplete as well as the frame itself.
+    std::uint64_t length = 0;
+    std::size_t header = 0;
+
+    for (int shift = 0; ; shift += 7) {
+        if (header == size) {
+            return 0;
+        }
+
+        if (shift >= 64) {
+            throw std::invalid_argument("malformed binary record: varint is too long");
+        }
+
+        const auto value = static_cast<std::uint8_t>(data[header++]);
+        length |= static_cast<std::uint64_t>(value & 0x7f) << shift;
+
+        if ((value & 0x80) == 0) {
+            break;
+        }
+    }
+
+    if (length > size - header) {
+        return 0;
+    }
+
+    reader_t reader(data + header, data + header + length);
+
+    const auto ndefinitions = reader.varint();
+    for (std::uint64_t id = 0; id < ndefinitions; ++id) {
+        names.emplace_back(reader.string().to_string());
+    }
+
+    const auto severity = unzigzag(reader.varint());
+    timestamp += unzigzag(reader.varint());
+
+    const auto tid = reader.varint();
+    std::thread::native_handle_type handle;
+    std::memset(&handle, 0, sizeof(handle));
+    std::memcpy(&handle, &tid, std::min(sizeof(tid), sizeof(handle)));
+
+    const auto lwp = reader.varint();
+
+    message = reader.string();
+
+    const auto nformatted = reader.varint();
+    formatted = nformatted == 0 ? message : reader.read(nformatted - 1);
+
+    const auto nattributes = reader.varint();
+
+    attributes.clear();
+    for (std::uint64_t id = 0; id < nattributes; ++id) {
+        const auto key = reader.varint();
+
+        if (key >= names.size()) {
+            throw std::invalid_argument("malformed binary record: undefined attribute key");
+        }
+
+        attributes.emplace_back(string_view(names[key]), reader.value());
+    }
+
+    if (!reader.exhausted()) {
+        throw std::invalid_argument("malformed binary record: trailing bytes in frame");
+    }
+
+    pack.clear();
+    pack.emplace_back(attributes);
+
+    const record_t::inner_t inner{
+        std::cref(message),
+        std::cref(formatted),
+        static_cast<int>(severity),
+        record_t::time_point(std::chrono::duration_cast<record_t::time_point::duration>(
+            std::chrono::nanoseconds(timestamp))),
+        handle,
+        lwp,
+        nullptr,
+        nullptr,
+        std::cref(pack),
+        {0, 0, 0}
+    };
+
+    new (&storage) record_t(inner);
+
+    return header + static_cast<std::size_t>(length);
+}
+
+auto decoder_t::record() const noexcept -> const record_t& {
+    return reinterpret_cast<const record_t&>(storage);
+}
+
+auto decoder_t::reset() -> void {
+    timestamp = 0;
+    names.clear();
+}
+
+}  // namespace binary
+}  // namespace v1
+}  // namespace blackhole
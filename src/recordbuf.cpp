@@ -0,0 +1,419 @@
+#include "blackhole/detail/recordbuf.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <new>
+
+#include <boost/container/small_vector.hpp>
+#include <boost/variant/apply_visitor.hpp>
+
+#include "blackhole/attribute.hpp"
+#include "blackhole/attributes.hpp"
+#include "blackhole/capture.hpp"
+#include "blackhole/extensions/writer.hpp"
+#include "blackhole/immortal.hpp"
+
+#include "blackhole/detail/attribute.hpp"
+#include "blackhole/detail/capture.hpp"
+#include "blackhole/detail/record.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace detail {
+namespace {
+
+#ifdef BLACKHOLE_HAVE_SMALL_VECTOR
+/// Inline capacity of attribute lists, so filling a chunk requires no allocation.
+constexpr std::size_t chunk = 16;
+#else
+constexpr std::size_t chunk = std::numeric_limits<std::size_t>::max();
+#endif
+
+/// Returns the number of bytes the string takes in the block, which is zero for immortal ones
+/// referred to as is.
+auto owned(const string_view& value) noexcept -> std::size_t {
+    return immortal::contains(value) ? 0 : value.size();
+}
+
+/// Function attribute value, either formatted into the scratch writer or deferred.
+struct function_t {
+    /// Size of the formatted value.
+    std::size_t size;
+    /// Size of its part kept by the value limit, which is followed by the marker if less.
+    std::size_t kept;
+
+    /// Deferred value and its copy, which is placed into the block at the given offset.
+    const void* value;
+    void(*copy)(void* destination, const void* value);
+    std::size_t offset;
+};
+
+typedef boost::container::small_vector<function_t, 8> functions_type;
+
+constexpr auto align(std::size_t size, std::size_t alignment) noexcept -> std::size_t {
+    return (size + alignment - 1) / alignment * alignment;
+}
+
+}  // namespace
+
+class capture_t {
+public:
+    writer_t& writer;
+    functions_type functions;
+
+    /// Offset of the next deferred value copy relative to the objects area.
+    std::size_t offset;
+
+    explicit capture_t(writer_t& writer) noexcept :
+        writer(writer),
+        offset(0)
+    {}
+};
+
+namespace {
+
+thread_local capture_t* current = nullptr;
+
+/// Makes the given capture current on this thread for the scope lifetime.
+class scope_t {
+    capture_t* previous;
+
+public:
+    explicit scope_t(capture_t& capture) noexcept :
+        previous(current)
+    {
+        current = &capture;
+    }
+
+    ~scope_t() {
+        current = previous;
+    }
+};
+
+/// Returns the number of string bytes an attribute value requires, formatting function values
+/// into the scratch writer one after another, unless they are deferred.
+class measure_t : public boost::static_visitor<std::size_t> {
+    capture_t& capture;
+    std::size_t limit;
+
+public:
+    measure_t(capture_t& capture, std::size_t limit) noexcept :
+        capture(capture),
+        limit(limit)
+    {}
+
+    template<typename T>
+    auto operator()(const T&) const noexcept -> std::size_t {
+        return 0;
+    }
+
+    auto operator()(const attribute::view_t::string_type& value) const noexcept -> std::size_t {
+        return owned(value);
+    }
+
+    auto operator()(const attribute::view_t::function_type& value) const -> std::size_t {
+        const auto size = capture.writer.inner.size();
+        const auto count = capture.functions.size();
+
+        value(capture.writer);
+
+        // Deferred values register themselves instead of writing anything.
+        if (capture.functions.size() > count) {
+            return 0;
+        }
+
+        const auto formatted = capture.writer.inner.size() - size;
+        auto kept = formatted;
+
+        if (limit != 0 && formatted > limit) {
+            const string_view value(capture.writer.inner.data() + size, formatted);
+            kept = detail::capture::cut(value, limit);
+        }
+
+        capture.functions.push_back({formatted, kept, nullptr, nullptr, 0});
+        return kept < formatted ? kept + detail::capture::marker.size() : formatted;
+    }
+};
+
+/// Copies string bytes into the block, advancing the cursor.
+struct cursor_t {
+    char* data;
+
+    auto copy(const string_view& value) noexcept -> string_view {
+        if (value.size() > 0) {
+            std::memcpy(data, value.data(), value.size());
+        }
+
+        const string_view result(data, value.size());
+        data += value.size();
+        return result;
+    }
+
+    /// Refers to immortal strings as is, copying others.
+    auto keep(const string_view& value) noexcept -> string_view {
+        return immortal::contains(value) ? value : copy(value);
+    }
+};
+
+/// Maps an attribute value into the view over the block, taking formatted function values from
+/// the scratch writer in the same order they were measured.
+class copy_t : public boost::static_visitor<attribute::view_t> {
+    cursor_t& cursor;
+    char* objects;
+    const char* scratch;
+    const function_t* function;
+
+public:
+    copy_t(cursor_t& cursor, char* objects, const capture_t& capture) noexcept :
+        cursor(cursor),
+        objects(objects),
+        scratch(capture.writer.inner.data()),
+        function(capture.functions.data())
+    {}
+
+    template<typename T>
+    auto operator()(T value) noexcept -> attribute::view_t {
+        return attribute::view_t(value);
+    }
+
+    auto operator()(const attribute::view_t::string_type& value) noexcept -> attribute::view_t {
+        return attribute::view_t(cursor.keep(value));
+    }
+
+    auto operator()(const attribute::view_t::function_type& value) -> attribute::view_t {
+        const auto& entry = *function++;
+
+        if (entry.copy) {
+            const auto destination = objects + entry.offset;
+            entry.copy(destination, entry.value);
+            return attribute::view_t(attribute::view_t::function_type{destination, value.fn});
+        }
+
+        const string_view result(scratch, entry.kept);
+        scratch += entry.size;
+
+        if (entry.kept == entry.size) {
+            return attribute::view_t(cursor.copy(result));
+        }
+
+        const auto kept = cursor.copy(result);
+        const auto marker = cursor.copy(detail::capture::marker);
+        return attribute::view_t(string_view(kept.data(), kept.size() + marker.size()));
+    }
+};
+
+}  // namespace
+
+auto capture_of(writer_t& writer) noexcept -> capture_t* {
+    return current != nullptr && &current->writer == &writer ? current : nullptr;
+}
+
+auto defer(capture_t& capture, const void* value, std::size_t size, std::size_t align,
+    void(*copy)(void* destination, const void* value)) -> void
+{
+    capture.offset = detail::align(capture.offset, align);
+    capture.functions.push_back({0, 0, value, copy, capture.offset});
+    capture.offset += size;
+}
+
+/// Block layout: the header, followed by attribute lists aligned to their alignment, copies of
+/// deferred attribute values and then all string bytes.
+struct recordbuf_t::header_t {
+    string_view message;
+    string_view formatted;
+
+    attribute_pack pack;
+    record_t::inner_t inner;
+
+    attribute_list* lists;
+    std::size_t nlists;
+    bool heap;
+    /// Size of the whole block.
+    std::size_t size;
+
+    header_t(string_view message, string_view formatted, const record_t& record,
+             attribute_list* lists, std::size_t nlists, bool heap) noexcept :
+        message(message),
+        formatted(formatted),
+        inner{
+            std::cref(this->message),
+            std::cref(this->formatted),
+            record.severity(),
+            record.timestamp(),
+            record.tid(),
+            record.lwp(),
+            nullptr,
+            nullptr,
+            std::cref(pack),
+            record.trace()
+        },
+        lists(lists),
+        nlists(nlists),
+        heap(heap),
+        size(0)
+    {}
+};
+
+recordbuf_t::recordbuf_t(const record_t& record) :
+    header(nullptr)
+{
+    init(record, nullptr, nullptr);
+}
+
+namespace {
+
+struct placement_t {
+    void* memory;
+    std::size_t size;
+};
+
+auto place(std::size_t size, void* context) -> void* {
+    const auto& placement = *static_cast<const placement_t*>(context);
+    const auto misaligned =
+        reinterpret_cast<std::uintptr_t>(placement.memory) % alignof(std::max_align_t) != 0;
+
+    return placement.size < size || misaligned ? nullptr : placement.memory;
+}
+
+}  // namespace
+
+recordbuf_t::recordbuf_t(const record_t& record, void* memory, std::size_t size) :
+    header(nullptr)
+{
+    placement_t placement{memory, size};
+    init(record, &place, &placement);
+}
+
+recordbuf_t::recordbuf_t(const record_t& record, allocate_type allocate, void* context) :
+    header(nullptr)
+{
+    init(record, allocate, context);
+}
+
+auto recordbuf_t::init(const record_t& original, allocate_type allocate, void* context) -> void {
+    // Oversized records are bounded before being measured, while function values are bounded
+    // once formatted.
+    const detail::capture::bounded_t bounded(original);
+    const auto& record = bounded.get();
+
+    // Uses an inline buffer, which is large enough for typical function values to require no
+    // allocation.
+    writer_t scratch;
+    capture_t capture(scratch);
+    const measure_t measure(capture, blackhole::capture::limits().value);
+
+    std::size_t count = 0;
+    std::size_t nbytes = owned(record.message()) + owned(record.formatted());
+
+    {
+        const scope_t scope(capture);
+
+        for (const auto& list : record.attributes()) {
+            for (const auto& kv : list.get()) {
+                ++count;
+                nbytes += owned(kv.first) + boost::apply_visitor(measure, kv.second.inner().value);
+            }
+        }
+    }
+
+    // Records already bounded have been accounted.
+    const auto cut = std::any_of(capture.functions.begin(), capture.functions.end(),
+        [](const function_t& function) { return function.kept < function.size; });
+
+    if (cut && &record == &original) {
+        detail::capture::account();
+    }
+
+    // There is always at least one list to keep the attribute pack shape of a flattened record.
+    // Each takes the size of the whole list object regardless of the number of its entries, since
+    // the pack refers to lists of the fixed type.
+    const auto nlists = count == 0 ? std::size_t(1) : (count - 1) / chunk + 1;
+    const auto offset = align(sizeof(header_t), alignof(attribute_list));
+    const auto objects = align(offset + nlists * sizeof(attribute_list), alignof(std::max_align_t));
+    const auto total = objects + capture.offset + nbytes;
+
+    auto memory = allocate == nullptr ? nullptr : allocate(total, context);
+    const auto heap = memory == nullptr;
+
+    if (heap) {
+        memory = ::operator new(total);
+    }
+
+    const auto base = static_cast<char*>(memory);
+    const auto lists = reinterpret_cast<attribute_list*>(base + offset);
+
+    cursor_t cursor{base + objects + capture.offset};
+
+    const auto message = cursor.keep(record.message());
+    const auto formatted = cursor.keep(record.formatted());
+
+    header = new (memory) header_t(message, formatted, record, lists, nlists, heap);
+    header->size = total;
+
+    for (std::size_t id = 0; id < nlists; ++id) {
+        new (lists + id) attribute_list();
+    }
+
+    try {
+        header->pack.reserve(nlists);
+
+        for (std::size_t id = 0; id < nlists; ++id) {
+            header->pack.emplace_back(lists[id]);
+        }
+
+        copy_t copy(cursor, base + objects, capture);
+        std::size_t id = 0;
+
+        for (const auto& list : record.attributes()) {
+            for (const auto& kv : list.get()) {
+                const auto key = cursor.keep(kv.first);
+                lists[id / chunk].emplace_back(key, boost::apply_visitor(copy, kv.second.inner().value));
+                ++id;
+            }
+        }
+    } catch (...) {
+        reset();
+        throw;
+    }
+}
+
+recordbuf_t::~recordbuf_t() {
+    reset();
+}
+
+auto recordbuf_t::into_view() const noexcept -> record_t {
+    return {header->inner};
+}
+
+auto recordbuf_t::allocated() const noexcept -> bool {
+    return header != nullptr && header->heap;
+}
+
+auto recordbuf_t::size() const noexcept -> std::size_t {
+    return header == nullptr ? 0 : header->size;
+}
+
+auto recordbuf_t::reset() noexcept -> void {
+    if (header == nullptr) {
+        return;
+    }
+
+    for (std::size_t id = 0; id < header->nlists; ++id) {
+        header->lists[id].~attribute_list();
+    }
+
+    const auto heap = header->heap;
+    header->~header_t();
+
+    if (heap) {
+        ::operator delete(header);
+    }
+
+    header = nullptr;
+}
+
+}  // namespace detail
+}  // namespace v1
+}  // namespace blackhole
@@ -1,21 +1,35 @@
 #include "blackhole/registry.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <map>
+#include <vector>
+
 #include <boost/optional/optional.hpp>
 
+#include "blackhole/budget.hpp"
+#include "blackhole/capture.hpp"
+#include "blackhole/clock.hpp"
 #include "blackhole/config/factory.hpp"
 #include "blackhole/config/node.hpp"
 #include "blackhole/config/option.hpp"
+#include "blackhole/executor.hpp"
 #include "blackhole/extensions/format.hpp"
 #include "blackhole/factory.hpp"
 #include "blackhole/filter.hpp"
 #include "blackhole/formatter.hpp"
 #include "blackhole/handler.hpp"
+#include "blackhole/metrics.hpp"
 #include "blackhole/root.hpp"
 #include "blackhole/sink.hpp"
 
 #include "blackhole/detail/memory.hpp"
 
+#include "config/copy.hpp"
 #include "essentials.hpp"
+#include "formatter/shared.hpp"
 
 namespace blackhole {
 inline namespace v1 {
@@ -50,11 +64,267 @@ auto get(const std::map<std::string, V>* map, const std::string& key) -> result<
     }
 }
 
+/// Writes the canonical representation of the given config node, which is equal for equal nodes.
+auto canonical(const config::node_t& node, fmt::MemoryWriter& wr) -> void {
+    if (node.is_bool()) {
+        wr << (node.to_bool() ? "t" : "f");
+    } else if (node.is_sint64()) {
+        wr << "i" << node.to_sint64() << ";";
+    } else if (node.is_uint64()) {
+        wr << "u" << node.to_uint64() << ";";
+    } else if (node.is_double()) {
+        wr << "d" << fmt::format("{:.17g}", node.to_double()) << ";";
+    } else if (node.is_string()) {
+        const auto value = node.to_string();
+        wr << "s" << value.size() << ":" << value;
+    } else if (node.is_vector()) {
+        wr << "[";
+        node.each([&](const config::node_t& node) {
+            canonical(node, wr);
+        });
+        wr << "]";
+    } else if (node.is_object()) {
+        wr << "{";
+        node.each_map([&](const std::string& key, const config::node_t& node) {
+            wr << key.size() << ":" << key;
+            canonical(node, wr);
+        });
+        wr << "}";
+    } else {
+        wr << "n";
+    }
+}
+
+/// Keys components by their type and canonical configuration.
+auto key(const std::string& type, const config::node_t& config) -> std::string {
+    fmt::MemoryWriter wr;
+    wr << type.size() << ":" << type;
+    canonical(config, wr);
+
+    return wr.str();
+}
+
+/// Sink proxy sharing the underlying sink between loggers.
+class shared_sink_t : public sink_t {
+    std::shared_ptr<sink_t> sink;
+
+public:
+    explicit shared_sink_t(std::shared_ptr<sink_t> sink) noexcept :
+        sink(std::move(sink))
+    {}
+
+    auto emit(const record_t& record, const string_view& message) -> void override {
+        sink->emit(record, message);
+    }
+
+    auto emit_batch(const event_t* events, std::size_t size) -> void override {
+        sink->emit_batch(events, size);
+    }
+
+    auto flush(std::chrono::steady_clock::time_point deadline) -> bool override {
+        return sink->flush(deadline);
+    }
+
+    auto collect(metrics::collector_t& collector) const -> void override {
+        sink->collect(collector);
+    }
+};
+
+/// Sink proxy constructing the underlying sink on a background thread.
+class deferred_sink_t : public sink_t {
+    std::shared_future<std::shared_ptr<sink_t>> future;
+    /// Cached once constructed, saving the future synchronization.
+    mutable std::atomic<sink_t*> sink;
+
+public:
+    explicit deferred_sink_t(std::shared_future<std::shared_ptr<sink_t>> future) noexcept :
+        future(std::move(future)),
+        sink(nullptr)
+    {}
+
+    auto emit(const record_t& record, const string_view& message) -> void override {
+        get().emit(record, message);
+    }
+
+    auto emit_batch(const event_t* events, std::size_t size) -> void override {
+        get().emit_batch(events, size);
+    }
+
+    auto flush(std::chrono::steady_clock::time_point deadline) -> bool override {
+        if (future.wait_until(deadline) != std::future_status::ready) {
+            return false;
+        }
+
+        try {
+            return get().flush(deadline);
+        } catch (...) {
+            // Sinks failed to construct have nothing to flush, but are not flushed either.
+            return false;
+        }
+    }
+
+    auto collect(metrics::collector_t& collector) const -> void override {
+        if (future.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            return;
+        }
+
+        try {
+            get().collect(collector);
+        } catch (...) {
+        }
+    }
+
+private:
+    /// Returns the constructed sink, waiting for it or rethrowing the construction error.
+    auto get() const -> sink_t& {
+        if (auto result = sink.load(std::memory_order_acquire)) {
+            return *result;
+        }
+
+        auto& result = *future.get();
+        sink.store(&result, std::memory_order_release);
+
+        return result;
+    }
+};
+
+/// Sinks keyed by their type and canonical configuration, with an entry per each identically
+/// configured sink of a logger in the order of construction.
+typedef std::map<std::string, std::vector<std::weak_ptr<sink_t>>> sinks_type;
+
+/// Components created while building a logger.
+///
+/// Formatters are keyed by their type and canonical configuration, allowing handlers with
+/// identical formatter configurations to share a single formatter. Sinks are reused from the
+/// previous logger built with the same name, if any, matching the n-th identically configured sink
+/// with the n-th one, so the number of sinks never changes.
+class sharing_t {
+    sharing_t* previous;
+    std::map<std::string, std::unique_ptr<formatter::shared_t>> formatters;
+
+    /// Sinks of the previous logger.
+    const sinks_type* reusable;
+    /// Sinks of the logger being built.
+    sinks_type sinks;
+
+    /// Construction results of sinks constructed in background, null if they are constructed
+    /// immediately.
+    std::vector<std::shared_future<std::shared_ptr<sink_t>>>* pending;
+
+public:
+    static thread_local sharing_t* current;
+
+    sharing_t(const sinks_type* reusable,
+              std::vector<std::shared_future<std::shared_ptr<sink_t>>>* pending) noexcept :
+        previous(current),
+        reusable(reusable),
+        pending(pending)
+    {
+        current = this;
+    }
+
+    ~sharing_t() {
+        current = previous;
+    }
+
+    auto formatter(const std::string& type,
+                   const config::node_t& config,
+                   const registry_t::formatter_factory& factory) -> std::unique_ptr<formatter_t>
+    {
+        auto& shared = formatters[key(type, config)];
+        if (shared == nullptr) {
+            shared.reset(new formatter::shared_t(factory(config)));
+        }
+
+        return shared->share();
+    }
+
+    auto sink(const std::string& type,
+              const config::node_t& config,
+              const registry_t::sink_factory& factory) -> std::unique_ptr<sink_t>
+    {
+        const auto id = key(type, config);
+        auto& built = sinks[id];
+
+        std::shared_ptr<sink_t> result;
+
+        if (reusable) {
+            const auto it = reusable->find(id);
+            if (it != reusable->end() && built.size() < it->second.size()) {
+                result = it->second[built.size()].lock();
+            }
+        }
+
+        if (result == nullptr && pending) {
+            // Nodes passed to factories are transient, so the background thread gets a copy.
+            const std::shared_ptr<config::node_t> copy(config::copy(config));
+
+            auto future = std::async(std::launch::async, [=]() -> std::shared_ptr<sink_t> {
+                return factory(*copy);
+            }).share();
+
+            pending->push_back(future);
+            result = std::make_shared<deferred_sink_t>(std::move(future));
+        }
+
+        if (result == nullptr) {
+            result = factory(config);
+        }
+
+        built.push_back(result);
+
+        return std::unique_ptr<sink_t>(new shared_sink_t(std::move(result)));
+    }
+
+    /// Returns sinks of the built logger, followed by ones of the previous one that are still
+    /// alive, i.e. nested into reused sinks, so they can be reused next time too.
+    auto merge() -> sinks_type {
+        if (reusable) {
+            for (const auto& pair : *reusable) {
+                auto& built = sinks[pair.first];
+
+                for (const auto& sink : pair.second) {
+                    const auto alive = sink.lock();
+                    const auto found = std::find_if(built.begin(), built.end(),
+                        [&](const std::weak_ptr<sink_t>& other) {
+                            return other.lock() == alive;
+                        });
+
+                    if (alive && found == built.end()) {
+                        built.push_back(alive);
+                    }
+                }
+            }
+        }
+
+        return std::move(sinks);
+    }
+};
+
+thread_local sharing_t* sharing_t::current = nullptr;
+
+auto handler_mode(const std::string& name) -> root_logger_t::mode_t {
+    if (name == "blocking") {
+        return root_logger_t::mode_t::blocking;
+    } else if (name == "parallel") {
+        return root_logger_t::mode_t::parallel;
+    } else if (name == "detached") {
+        return root_logger_t::mode_t::detached;
+    }
+
+    throw std::invalid_argument("unknown handler dispatch mode: \"" + name + "\"");
+}
+
 }  // namespace
 
+struct builder_t::cache_t {
+    std::map<std::string, sinks_type> loggers;
+};
+
 builder_t::builder_t(const registry_t& registry, std::unique_ptr<config::factory_t> factory) :
     registry(registry),
-    factory(factory.release())
+    factory(factory.release()),
+    cache(std::make_shared<cache_t>())
 {}
 
 auto builder_t::configurator() noexcept -> config::factory_t& {
@@ -62,16 +332,128 @@ auto builder_t::configurator() noexcept -> config::factory_t& {
 }
 
 auto builder_t::build(const std::string& name) -> root_logger_t {
-    const auto& config = factory->config();
+    return build(*factory, name, nullptr);
+}
+
+auto builder_t::build_async(const std::string& name) ->
+    std::pair<root_logger_t, std::shared_future<void>>
+{
+    pending_type pending;
+    auto logger = build(*factory, name, &pending);
+
+    auto ready = std::async(std::launch::async, [pending] {
+        for (const auto& future : pending) {
+            future.wait();
+        }
+
+        for (const auto& future : pending) {
+            future.get();
+        }
+    }).share();
+
+    return std::make_pair(std::move(logger), std::move(ready));
+}
+
+auto builder_t::reload(root_logger_t& logger, const std::string& name,
+    std::unique_ptr<config::factory_t> factory) -> void
+{
+    auto next = build(*factory, name, nullptr);
+    next.threshold(logger.threshold());
+
+    // Sinks that are not reused are destroyed here, after concurrent logging events complete.
+    logger = std::move(next);
+
+    this->factory.reset(factory.release());
+
+    for (auto& pair : cache->loggers[name]) {
+        auto& sinks = pair.second;
+        sinks.erase(std::remove_if(sinks.begin(), sinks.end(),
+            [](const std::weak_ptr<sink_t>& sink) {
+                return sink.expired();
+            }), sinks.end());
+    }
+}
+
+auto builder_t::build(const config::factory_t& factory, const std::string& name,
+    pending_type* pending) -> root_logger_t
+{
+    const auto& config = factory.config();
+
+    auto& sinks = cache->loggers[name];
 
     std::vector<std::unique_ptr<handler_t>> handlers;
+    std::vector<root_logger_t::mode_t> modes;
+
+    // Formatters configured identically in several handlers are created once and format each
+    // record once.
+    sharing_t sharing(&sinks, pending);
 
     // TODO: Check `config.contains(name)`.
-    config[name].each([&](const config::node_t& config) {
+    const auto root = config[name];
+
+    // The logger can be configured either by a plain array of handlers or by an object with
+    // "handlers" array and optional logger-wide settings, like "clock".
+    const auto node = root.unwrap();
+    const auto verbose = node && node->is_object();
+
+    const auto fn = [&](const config::node_t& config) {
         handlers.emplace_back(handler(config));
+        modes.push_back(handler_mode(config["dispatch"].to_string().get_value_or("blocking")));
+    };
+
+    if (verbose) {
+        root["handlers"].each(fn);
+    } else {
+        root.each(fn);
+    }
+
+    root_logger_t logger(std::move(handlers));
+
+    if (verbose) {
+        if (auto clock = root["clock"].to_string()) {
+            logger.clock(clock_source(clock.get()));
+        }
+
+        // The budget is process-wide, so the most recently built logger configuring it wins.
+        if (auto bytes = root["budget"].to_uint64()) {
+            budget::limit(static_cast<std::size_t>(bytes.get()));
+        }
+
+        // Capture limits are process-wide as well.
+        if (auto node = root["capture"]) {
+            const auto limit = [&](const char* name) -> std::size_t {
+                return static_cast<std::size_t>(node[name].to_uint64().get_value_or(0));
+            };
+
+            capture::limits_t limits;
+            limits.message = limit("message");
+            limits.value = limit("value");
+            limits.attributes = limit("attributes");
+            capture::limit(limits);
+        }
+
+        root["categories"].each_map([&](const std::string& category, const config::node_t& node) {
+            logger.threshold(category, static_cast<int>(node.to_sint64()));
+        });
+    }
+
+    const auto blocking = std::all_of(modes.begin(), modes.end(), [](root_logger_t::mode_t mode) {
+        return mode == root_logger_t::mode_t::blocking;
     });
 
-    return root_logger_t(std::move(handlers));
+    if (!blocking) {
+        const auto executor = verbose ? root["executor"] : config::option<config::node_t>();
+        const auto threads = executor["threads"].to_uint64().get_value_or(1);
+        const auto capacity = executor["capacity"].to_uint64()
+            .get_value_or(executor_t::default_capacity);
+
+        logger.offload(std::make_shared<executor_t>(static_cast<std::size_t>(threads),
+            static_cast<std::size_t>(capacity)), std::move(modes));
+    }
+
+    sinks = sharing.merge();
+
+    return logger;
 }
 
 auto builder_t::handler(const config::node_t& config) const -> std::unique_ptr<handler_t> {
@@ -131,8 +513,20 @@ auto default_registry_t::add(std::shared_ptr<factory<formatter_t>> factory) -> v
 }
 
 auto default_registry_t::sink(const std::string& type) const -> sink_factory {
-    return get(&sinks, type)
+    auto factory = get(&sinks, type)
         .expect<std::out_of_range>(R"(sink with type "{}" is not registered)", type);
+
+    if (sharing_t::current == nullptr) {
+        return factory;
+    }
+
+    return [=](const config::node_t& config) -> std::unique_ptr<sink_t> {
+        if (auto sharing = sharing_t::current) {
+            return sharing->sink(type, config, factory);
+        }
+
+        return factory(config);
+    };
 }
 
 auto default_registry_t::filter(const std::string& type) const -> filter_factory {
@@ -146,8 +540,20 @@ auto default_registry_t::handler(const std::string& type) const -> handler_facto
 }
 
 auto default_registry_t::formatter(const std::string& type) const -> formatter_factory {
-    return get(&formatters, type)
+    auto factory = get(&formatters, type)
         .expect<std::out_of_range>(R"(formatter with type "{}" is not registered)", type);
+
+    if (sharing_t::current == nullptr) {
+        return factory;
+    }
+
+    return [=](const config::node_t& config) -> std::unique_ptr<formatter_t> {
+        if (auto sharing = sharing_t::current) {
+            return sharing->formatter(type, config, factory);
+        }
+
+        return factory(config);
+    };
 }
 
 auto registry::configured() -> std::unique_ptr<registry_t> {
@@ -1,116 +1,331 @@
 #include "blackhole/root.hpp"
 
+#include <algorithm>
 #include <atomic>
-#include <iostream>
+#include <condition_variable>
+#include <cstdint>
+#include <iterator>
+#include <limits>
 #include <mutex>
-
-#include <boost/thread/tss.hpp>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include "blackhole/attribute.hpp"
+#include "blackhole/attribute/table.hpp"
+#include "blackhole/budget.hpp"
+#include "blackhole/capture.hpp"
+#include "blackhole/cputime.hpp"
+#include "blackhole/error.hpp"
+#include "blackhole/executor.hpp"
 #include "blackhole/handler.hpp"
 #include "blackhole/record.hpp"
 #include "blackhole/scope/manager.hpp"
 #include "blackhole/scope/watcher.hpp"
+#include "blackhole/stage.hpp"
+
+#include "blackhole/detail/category.hpp"
+#include "blackhole/detail/cputime.hpp"
+#include "blackhole/detail/error.hpp"
+#include "blackhole/detail/probe.hpp"
+#include "blackhole/detail/rcu.hpp"
+#include "blackhole/detail/scope/manager.hpp"
+#include "blackhole/detail/stage.hpp"
+#include "blackhole/detail/recordbuf.hpp"
+#include "blackhole/detail/sink/file/flusher/timer.hpp"
 
-#include "blackhole/detail/spinlock.hpp"
+#include "formatter/shared.hpp"
 
 namespace blackhole {
 inline namespace v1 {
 
-using detail::spinlock_t;
+namespace rcu = detail::rcu;
 
 namespace {
 
-using scope::watcher_t;
+/// Counter of handler calls in flight, which can be waited to drop to zero.
+class pending_t {
+    std::mutex mutex;
+    std::condition_variable done;
+    std::size_t size;
+
+public:
+    pending_t() noexcept :
+        size(0)
+    {}
+
+    auto acquire() -> void {
+        std::lock_guard<std::mutex> lock(mutex);
+        ++size;
+    }
+
+    auto release() -> void {
+        // Notifying under the lock, because waiters may destroy the counter once it drops to zero.
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--size == 0) {
+            done.notify_all();
+        }
+    }
+
+    auto wait() -> void {
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [&] {
+            return size == 0;
+        });
+    }
+
+    auto wait_until(std::chrono::steady_clock::time_point deadline) -> bool {
+        std::unique_lock<std::mutex> lock(mutex);
+        return done.wait_until(lock, deadline, [&] {
+            return size == 0;
+        });
+    }
+};
 
-class thread_manager_t : public scope::manager_t {
-    boost::thread_specific_ptr<watcher_t> inner;
+/// Calls the given function, counting and reporting exceptions instead of propagating them into
+/// the logging call site.
+template<typename F>
+auto guarded(metrics::counter_t& errors, const F& fn) -> void {
+    try {
+        fn();
+    } catch (...) {
+        errors.add();
+        detail::error::report(error::kind_t::handler);
+    }
+}
+
+/// State shared with detached handler calls, which may outlive the logger.
+struct detached_t {
+    pending_t pending;
+    /// Exceptions thrown by detached handlers.
+    metrics::counter_t errors;
+};
+
+/// Per-thread attribute pack reused by logging events logged without attributes, which retains
+/// the capacity grown by previous events.
+struct spare_t {
+    attribute_pack pack;
+    bool busy;
+};
+
+thread_local spare_t spare = {attribute_pack(), false};
+
+/// Leases the per-thread pack, falling back to an own one for events logged reentrantly, like the
+/// ones logged while formatting attributes.
+class lease_t {
+    attribute_pack local;
+    attribute_pack* pack;
 
 public:
-    thread_manager_t() : inner([](watcher_t*) {}) {}
+    lease_t() noexcept :
+        pack(spare.busy ? &local : &spare.pack)
+    {
+        spare.busy = true;
+    }
 
-    auto get() const -> watcher_t* {
-        return inner.get();
+    ~lease_t() {
+        if (pack == &spare.pack) {
+            pack->clear();
+            spare.busy = false;
+        }
     }
 
-    auto reset(watcher_t* value) -> void {
-        inner.reset(value);
+    lease_t(const lease_t& other) = delete;
+    auto operator=(const lease_t& other) -> lease_t& = delete;
+
+    auto get() noexcept -> attribute_pack& {
+        return *pack;
     }
 };
 
 }  // namespace
 
 struct root_logger_t::sync_t {
-    // NOTE: Actually we need to check for `std::atomic_*_explicit` overloads for `std::shared_ptr`,
-    // but it seems there is no simple way to do this.
-    // The given solution works both on OS X with clang compiler and on linux with GCC and clang.
-    // Feel free to hack and send a PR with better solution.
-#ifndef __APPLE__
-    typedef spinlock_t mutex_type;
-    mutable mutex_type mutex;
-#endif
-
-    thread_manager_t manager;
-
-    auto load(const std::shared_ptr<inner_t>& source) const noexcept -> std::shared_ptr<inner_t> {
-#ifdef __APPLE__
-        return std::atomic_load_explicit(&source, std::memory_order_acquire);
-#else
-        std::lock_guard<mutex_type> lock(mutex);
+    /// Serializes configuration updates, i.e. filter replacement and assignment.
+    mutable std::mutex mutex;
+
+    /// Currently published configuration snapshot.
+    ///
+    /// Readers load it inside an RCU read-side critical section without touching its reference
+    /// counter, while the owning `std::shared_ptr` is kept by the logger and modified by writers
+    /// only.
+    std::atomic<inner_t*> snapshot;
+
+    /// Minimum severity value allowed to pass.
+    std::atomic<int> threshold;
+
+    /// Clock source used to activate records.
+    std::atomic<clock_source_t> clock;
+
+    /// Adaptive threshold and pressure levels engaging and releasing it, disabled if minimal.
+    std::atomic<int> adapted;
+    std::atomic<pressure_t::level_t> engage;
+    std::atomic<pressure_t::level_t> release;
+    /// Currently effective adaptive threshold, minimal while released.
+    std::atomic<int> raised;
+
+    /// Drops observed by the last pressure sample, which the drop rate is estimated against.
+    mutable std::mutex sampler;
+    std::chrono::steady_clock::time_point sampled;
+    std::uint64_t drops;
+    double rate;
+
+    scope::thread_manager_t manager;
+
+    /// Categories, which are kept on assignment, so their handles remain valid.
+    detail::category::registry_t categories;
+
+    /// Records passed the root filter.
+    metrics::counter_t records;
+    /// Records rejected by the root filter.
+    metrics::counter_t filtered;
+    /// Exceptions thrown by handlers.
+    metrics::counter_t errors;
+
+    const std::shared_ptr<detached_t> detached;
+
+    /// Function waiting for the pressure to fall below its level.
+    struct waiter_t {
+        pressure_t::level_t level;
+        std::function<void()> fn;
+    };
+
+    /// Waiters, which are polled by the shared timer subscribed on the first wait.
+    std::mutex waiting;
+    std::vector<waiter_t> waiters;
+    std::shared_ptr<sink::file::flusher::timer_t> timer;
+    std::uint64_t subscription;
+
+    sync_t() :
+        snapshot(nullptr),
+        threshold(std::numeric_limits<int>::min()),
+        clock(clock_source_t::precise),
+        adapted(std::numeric_limits<int>::min()),
+        engage(pressure_t::level_t::high),
+        release(pressure_t::level_t::normal),
+        raised(std::numeric_limits<int>::min()),
+        sampled(std::chrono::steady_clock::now()),
+        drops(0),
+        rate(0.0),
+        detached(std::make_shared<detached_t>()),
+        subscription(0)
+    {}
+
+    /// Estimates the recent drop rate for the given pressure, classifying its level.
+    auto sample(pressure_t& pressure) -> void {
+        std::lock_guard<std::mutex> lock(sampler);
+
+        const auto now = std::chrono::steady_clock::now();
+        const auto elapsed = std::chrono::duration<double>(now - sampled).count();
+
+        if (elapsed >= 0.1) {
+            rate = pressure.dropped > drops ? (pressure.dropped - drops) / elapsed : 0.0;
+            drops = pressure.dropped;
+            sampled = now;
+        }
+
+        pressure.rate = rate;
+        pressure.level = std::max(pressure.level, pressure_t::classify(pressure.fill, rate));
+    }
+
+    /// Returns an owning copy of the current configuration.
+    auto load(const std::shared_ptr<inner_t>& source) const -> std::shared_ptr<inner_t> {
+        std::lock_guard<std::mutex> lock(mutex);
         return source;
-#endif
     }
 
-    auto store(std::shared_ptr<inner_t>& source, std::shared_ptr<inner_t> value) noexcept -> void {
-#ifdef __APPLE__
-        std::atomic_store_explicit(&source, std::move(value), std::memory_order_release);
-#else
-        std::lock_guard<mutex_type> lock(mutex);
-        source = std::move(value);
-#endif
+    /// Publishes the given configuration, waiting for all readers of the previous one to complete
+    /// before releasing it.
+    auto store(std::shared_ptr<inner_t>& source, std::shared_ptr<inner_t> value) -> void {
+        update(source, [&](const std::shared_ptr<inner_t>&) -> std::shared_ptr<inner_t> {
+            return std::move(value);
+        });
+    }
+
+    /// Publishes a configuration produced by the given function from the current one atomically
+    /// with respect to other updates.
+    template<typename F>
+    auto update(std::shared_ptr<inner_t>& source, F&& fn) -> void {
+        std::unique_lock<std::mutex> lock(mutex);
+
+        auto value = fn(source);
+        snapshot.store(value.get(), std::memory_order_release);
+        std::swap(source, value);
+
+        lock.unlock();
+
+        // The previous configuration may be still used by concurrent log events. Note that we
+        // can't destroy it under the lock, because its handlers may log something on destruction.
+        rcu::synchronize();
     }
 };
 
+/// Immutable logger configuration snapshot.
+///
+/// Replacing the filter publishes a new snapshot sharing the same handlers, so log events only
+/// reference the filter of a snapshot they have observed instead of copying it.
 struct root_logger_t::inner_t {
-    typedef spinlock_t mutex_type;
+    typedef std::vector<std::unique_ptr<handler_t>> handlers_type;
 
-    filter_t filter;
-    const std::vector<std::unique_ptr<handler_t>> handlers;
+    /// Modes of calling handlers together with the executor running non-blocking ones.
+    struct plan_t {
+        std::shared_ptr<executor_t> executor;
+        std::vector<mode_t> modes;
+    };
 
-    inner_t(std::vector<std::unique_ptr<handler_t>> handlers):
+    const filter_t filter;
+    const std::shared_ptr<const handlers_type> handlers;
+    /// Absent if all handlers are blocking.
+    const std::shared_ptr<const plan_t> plan;
+
+    inner_t(handlers_type handlers):
         filter([](const record_t&) -> bool { return true; }),
-        handlers(std::move(handlers))
+        handlers(std::make_shared<handlers_type>(std::move(handlers)))
     {}
 
-    inner_t(filter_t filter, std::vector<std::unique_ptr<handler_t>> handlers):
+    inner_t(filter_t filter, handlers_type handlers):
         filter(std::move(filter)),
-        handlers(std::move(handlers))
+        handlers(std::make_shared<handlers_type>(std::move(handlers)))
     {}
 
-    template<typename F>
-    auto apply(F&& fn) -> decltype(fn(std::declval<inner_t&>())) {
-        std::lock_guard<mutex_type> lock(mutex);
-        return fn(*this);
-    }
+    inner_t(filter_t filter, std::shared_ptr<const handlers_type> handlers,
+            std::shared_ptr<const plan_t> plan):
+        filter(std::move(filter)),
+        handlers(std::move(handlers)),
+        plan(std::move(plan))
+    {}
 
-private:
-    mutable mutex_type mutex;
+    /// Passes the given record to all handlers according to their modes.
+    auto handle(sync_t& sync, const record_t& record) const -> void;
 };
 
 root_logger_t::root_logger_t(std::vector<std::unique_ptr<handler_t>> handlers):
     sync(new sync_t),
     inner(std::make_shared<inner_t>(std::move(handlers)))
-{}
+{
+    sync->snapshot.store(inner.get(), std::memory_order_release);
+}
 
 root_logger_t::root_logger_t(filter_t filter, std::vector<std::unique_ptr<handler_t>> handlers):
     sync(new sync_t),
     inner(std::make_shared<inner_t>(std::move(filter), std::move(handlers)))
-{}
+{
+    sync->snapshot.store(inner.get(), std::memory_order_release);
+}
 
 root_logger_t::root_logger_t(root_logger_t&& other) noexcept :
     sync(new sync_t),
     inner(other.sync->load(other.inner))
 {
+    sync->snapshot.store(inner.get(), std::memory_order_release);
+    sync->threshold.store(other.sync->threshold.load());
+    sync->clock.store(other.sync->clock.load());
+    sync->adapted.store(other.sync->adapted.load());
+    sync->engage.store(other.sync->engage.load());
+    sync->release.store(other.sync->release.load());
+    sync->categories.merge(other.sync->categories);
+
     sync->manager.reset(other.sync->manager.get());
 
     if (sync->manager.get()) {
@@ -118,7 +333,19 @@ root_logger_t::root_logger_t(root_logger_t&& other) noexcept :
     }
 }
 
-root_logger_t::~root_logger_t() {}
+root_logger_t::~root_logger_t() {
+    if (sync->timer) {
+        sync->timer->unsubscribe(sync->subscription);
+    }
+
+    // Pending waiters are called anyway, so suspended coroutines are not leaked.
+    std::vector<sync_t::waiter_t> waiters;
+    std::swap(waiters, sync->waiters);
+
+    for (auto& waiter : waiters) {
+        guarded(sync->errors, waiter.fn);
+    }
+}
 
 auto
 root_logger_t::operator=(root_logger_t&& other) noexcept -> root_logger_t& {
@@ -128,6 +355,12 @@ root_logger_t::operator=(root_logger_t&& other) noexcept -> root_logger_t& {
 
     const auto inner = other.sync->load(other.inner);
     sync->store(this->inner, std::move(inner));
+    sync->threshold.store(other.sync->threshold.load());
+    sync->clock.store(other.sync->clock.load());
+    sync->adapted.store(other.sync->adapted.load());
+    sync->engage.store(other.sync->engage.load());
+    sync->release.store(other.sync->release.load());
+    sync->categories.merge(other.sync->categories);
 
     sync->manager.reset(other.sync->manager.get());
 
@@ -140,13 +373,115 @@ root_logger_t::operator=(root_logger_t&& other) noexcept -> root_logger_t& {
 
 auto
 root_logger_t::filter(filter_t fn) -> void {
-    auto inner = sync->load(this->inner);
+    sync->update(this->inner, [&](const std::shared_ptr<inner_t>& inner) {
+        return std::make_shared<inner_t>(std::move(fn), inner->handlers, inner->plan);
+    });
+}
+
+auto root_logger_t::threshold(severity_t severity) noexcept -> void {
+    sync->threshold.store(severity, std::memory_order_relaxed);
+}
+
+auto root_logger_t::threshold() const noexcept -> severity_t {
+    return sync->threshold.load(std::memory_order_relaxed);
+}
+
+auto root_logger_t::enabled(severity_t severity) const noexcept -> bool {
+    return admit(severity, sync->threshold.load(std::memory_order_relaxed));
+}
+
+auto root_logger_t::category(const string_view& name) -> category_t {
+    return category_t(*this, sync->categories.get(name));
+}
+
+auto root_logger_t::threshold(const string_view& category, severity_t severity) -> void {
+    sync->categories.assign(category, severity);
+}
+
+auto root_logger_t::inherit(const string_view& category) -> void {
+    sync->categories.inherit(category);
+}
+
+auto root_logger_t::admit(severity_t severity, int threshold) const noexcept -> bool {
+    if (severity < threshold) {
+        return false;
+    }
+
+    const auto adapted = sync->adapted.load(std::memory_order_relaxed);
+    if (adapted == std::numeric_limits<int>::min()) {
+        return true;
+    }
+
+    // Shared by all loggers, which is fine, since it only spreads evaluations over events.
+    thread_local std::uint32_t countdown = 0;
 
-    inner->apply([&](inner_t& inner) {
-        inner.filter = std::move(fn);
+    if (countdown-- == 0) {
+        countdown = 63;
+
+        try {
+            const auto level = pressure().level;
+
+            if (level >= sync->engage.load(std::memory_order_relaxed)) {
+                sync->raised.store(adapted, std::memory_order_relaxed);
+            } else if (level <= sync->release.load(std::memory_order_relaxed)) {
+                sync->raised.store(std::numeric_limits<int>::min(), std::memory_order_relaxed);
+            }
+        } catch (...) {
+            // Keeps the current state, evaluating the pressure again later.
+        }
+    }
+
+    return severity >= sync->raised.load(std::memory_order_relaxed);
+}
+
+auto root_logger_t::adapt(severity_t severity, pressure_t::level_t engage,
+                          pressure_t::level_t release) noexcept -> void
+{
+    sync->engage.store(engage, std::memory_order_relaxed);
+    sync->release.store(release, std::memory_order_relaxed);
+    sync->adapted.store(severity, std::memory_order_relaxed);
+
+    if (severity == std::numeric_limits<int>::min()) {
+        sync->raised.store(severity, std::memory_order_relaxed);
+    }
+}
+
+auto root_logger_t::clock(clock_source_t source) -> void {
+    blackhole::clock::prepare(source);
+    sync->clock.store(source, std::memory_order_relaxed);
+}
+
+auto root_logger_t::clock() const noexcept -> clock_source_t {
+    return sync->clock.load(std::memory_order_relaxed);
+}
+
+auto root_logger_t::offload(std::shared_ptr<executor_t> executor, std::vector<mode_t> modes) ->
+    void
+{
+    const auto blocking = std::all_of(modes.begin(), modes.end(), [](mode_t mode) {
+        return mode == mode_t::blocking;
     });
 
-    sync->store(this->inner, std::move(inner));
+    if (!blocking && executor == nullptr) {
+        throw std::invalid_argument("non-blocking handlers require an executor");
+    }
+
+    const auto size = modes.size();
+
+    std::shared_ptr<const inner_t::plan_t> plan;
+    if (!blocking) {
+        plan = std::make_shared<const inner_t::plan_t>(
+            inner_t::plan_t{std::move(executor), std::move(modes)});
+    }
+
+    sync->update(this->inner, [&](const std::shared_ptr<inner_t>& inner) {
+        if (size != inner->handlers->size()) {
+            throw std::invalid_argument("the number of handler modes must match the number of "
+                "handlers");
+        }
+
+        return std::make_shared<inner_t>(inner->filter, inner->handlers, plan);
+    });
 }
 
 namespace {
@@ -161,44 +496,312 @@ struct null_message_t {
 
 }  // namespace
 
+auto root_logger_t::inner_t::handle(sync_t& sync, const record_t& record) const -> void {
+    if (plan == nullptr) {
+        for (auto& handler : *handlers) {
+            guarded(sync.errors, [&] {
+                handler->handle(record);
+            });
+        }
+
+        return;
+    }
+
+    auto& executor = *plan->executor;
+
+    pending_t parallel;
+    bool shared = false;
+    // Taken lazily on the first detached handler and shared by all of them.
+    std::shared_ptr<const detail::recordbuf_t> snapshot;
+
+    for (std::size_t id = 0; id < handlers->size(); ++id) {
+        const auto handler = (*handlers)[id].get();
+
+        switch (plan->modes[id]) {
+        case mode_t::blocking:
+            break;
+        case mode_t::parallel:
+            // Unique attributes and the attribute table are computed lazily and are not
+            // thread-safe, so they are computed before the record is shared with other threads.
+            if (!shared) {
+                record.unique_attributes().size();
+                record.table().size();
+                shared = true;
+            }
+
+            parallel.acquire();
+
+            if (!executor.post([&sync, &parallel, &record, handler] {
+                guarded(sync.errors, [&] {
+                    handler->handle(record);
+                });
+                parallel.release();
+            })) {
+                parallel.release();
+                guarded(sync.errors, [&] {
+                    handler->handle(record);
+                });
+            }
+            break;
+        case mode_t::detached: {
+            if (snapshot == nullptr) {
+                snapshot = std::make_shared<const detail::recordbuf_t>(record);
+            }
+
+            // Handlers are kept alive by the task, since the configuration may be replaced or the
+            // logger destroyed before it runs.
+            const auto owner = handlers;
+            const auto detached = sync.detached;
+            detached->pending.acquire();
+
+            if (!executor.post([owner, detached, snapshot, handler] {
+                guarded(detached->errors, [&] {
+                    handler->handle(snapshot->into_view());
+                });
+                detached->pending.release();
+            })) {
+                detached->pending.release();
+                guarded(sync.errors, [&] {
+                    handler->handle(record);
+                });
+            }
+            break;
+        }
+        }
+    }
+
+    for (std::size_t id = 0; id < handlers->size(); ++id) {
+        if (plan->modes[id] == mode_t::blocking) {
+            guarded(sync.errors, [&] {
+                (*handlers)[id]->handle(record);
+            });
+        }
+    }
+
+    // The record is borrowed by parallel handlers.
+    parallel.wait();
+}
+
 auto root_logger_t::log(severity_t severity, const message_t& message) -> void {
-    attribute_pack pack;
-    log(severity, message, pack);
+    lease_t lease;
+    log(severity, message, lease.get());
 }
 
 auto root_logger_t::log(severity_t severity, const message_t& message, attribute_pack& pack) -> void {
-    consume(severity, message, pack, null_message_t());
+    if (enabled(severity)) {
+        consume(severity, message, pack, null_message_t());
+    }
 }
 
 auto root_logger_t::log(severity_t severity, const lazy_message_t& message, attribute_pack& pack) -> void {
+    if (enabled(severity)) {
+        consume(severity, message.pattern, pack, message);
+    }
+}
+
+auto root_logger_t::forward(severity_t severity, const message_t& message, attribute_pack& pack) ->
+    void
+{
+    consume(severity, message, pack, null_message_t());
+}
+
+auto root_logger_t::forward(severity_t severity, const lazy_message_t& message,
+                            attribute_pack& pack) -> void
+{
     consume(severity, message.pattern, pack, message);
 }
 
 template<typename F>
 auto root_logger_t::consume(severity_t severity, const string_view& pattern, attribute_pack& pack, const F& supplier) -> void {
-    const auto inner = sync->load(this->inner);
-    const auto filter = inner->apply([&](inner_t& inner) -> filter_t {
-        return inner.filter;
-    });
+    BLACKHOLE_PROBE(consume, static_cast<int>(severity), pattern.size());
 
-    if (sync->manager.get()) {
-        sync->manager.get()->collect(pack);
+    const detail::cputime::scope_t accounting;
+    const detail::stage::scope_t sampling;
+    const rcu::read_lock_t lock;
+
+    const auto inner = sync->snapshot.load(std::memory_order_acquire);
+
+    const auto watcher = sync->manager.get();
+    if (watcher) {
+        watcher->collect(pack);
     }
 
     record_t record(severity, pattern, pack);
-    if (filter(record)) {
+
+    const unique_attributes_t unique(pack);
+    record.attach(unique);
+
+    // Computed only if some filter or formatter looks attributes up, costing nothing otherwise.
+    const attribute::table_t table(unique);
+    record.attach(table);
+    detail::stage::stamp(detail::stage::id_t::capture);
+
+    const auto passed = inner->filter(record);
+    BLACKHOLE_PROBE(filter, static_cast<int>(severity), passed ? 1 : 0);
+    detail::stage::stamp(detail::stage::id_t::filter);
+
+    if (passed) {
+        sync->records.add();
+
         const auto formatted = supplier.supplier();
 
-        record.activate(formatted);
-        for (auto& handler : inner->handlers) {
-            try {
-                handler->handle(record);
-            } catch (const std::exception& err) {
-                std::cout << "logging core error occurred: " << err.what() << std::endl;
-            } catch (...) {
-                std::cout << "logging core error occurred: unknown" << std::endl;
-            }
+        record.activate(formatted,
+            blackhole::clock::timestamp(sync->clock.load(std::memory_order_relaxed)));
+
+        if (const auto interceptor = watcher ? watcher->capturing() : nullptr) {
+            return guarded(sync->errors, [&] {
+                interceptor->capture(record);
+            });
         }
+
+        // Allows shared formatters to format the record once for all handlers.
+        const formatter::dispatch_t dispatch;
+
+        inner->handle(*sync, record);
+    } else {
+        sync->filtered.add();
+    }
+}
+
+auto root_logger_t::dispatch(const record_t* records, std::size_t size) -> void {
+    const rcu::read_lock_t lock;
+
+    const auto inner = sync->snapshot.load(std::memory_order_acquire);
+
+    for (auto& handler : *inner->handlers) {
+        guarded(sync->errors, [&] {
+            handler->handle_batch(records, size);
+        });
+    }
+}
+
+auto root_logger_t::flush(std::chrono::steady_clock::time_point deadline) const -> bool {
+    // Handlers are owned by the configuration snapshot, which must outlive waiting, while the RCU
+    // read lock must not be held that long, since it would block configuration updates.
+    const auto inner = sync->load(this->inner);
+
+    // Records logged before are being handled by detached handlers until they complete.
+    bool result = sync->detached->pending.wait_until(deadline);
+    for (const auto& handler : *inner->handlers) {
+        result = handler->flush(deadline) && result;
+    }
+
+    return result;
+}
+
+auto root_logger_t::flush(std::chrono::milliseconds timeout) const -> bool {
+    return flush(std::chrono::steady_clock::now() + timeout);
+}
+
+auto root_logger_t::metrics() const -> metrics::snapshot_t {
+    metrics::snapshot_t snapshot;
+    metrics::collector_t collector(snapshot);
+
+    collector.counter("blackhole_records_total", sync->records.get());
+    collector.counter("blackhole_records_filtered_total", sync->filtered.get());
+    collector.counter("blackhole_handler_errors_total",
+        sync->errors.get() + sync->detached->errors.get());
+    collector.gauge("blackhole_budget_used_bytes", budget::used());
+    collector.gauge("blackhole_budget_limit_bytes", budget::limit());
+    collector.counter("blackhole_budget_rejected_total", budget::rejected());
+    collector.counter("blackhole_capture_truncated_total", capture::truncated());
+
+    for (std::size_t id = 0; id < error::kinds; ++id) {
+        const auto kind = static_cast<error::kind_t>(id);
+        auto labeled = collector.with("kind", error::name(kind));
+        labeled.counter("blackhole_internal_errors_total", error::occurred(kind));
+        labeled.counter("blackhole_internal_errors_suppressed_total", error::suppressed(kind));
+    }
+
+    stage::collect(collector);
+    cputime::collect(collector);
+
+    const rcu::read_lock_t lock;
+    const auto inner = sync->snapshot.load(std::memory_order_acquire);
+
+    std::size_t id = 0;
+    for (const auto& handler : *inner->handlers) {
+        auto labeled = collector.with("handler", std::to_string(id++));
+        handler->collect(labeled);
+    }
+
+    return snapshot;
+}
+
+auto root_logger_t::pressure() const -> pressure_t {
+    pressure_t result;
+
+    {
+        const rcu::read_lock_t lock;
+        const auto inner = sync->snapshot.load(std::memory_order_acquire);
+
+        for (const auto& handler : *inner->handlers) {
+            result.merge(handler->pressure());
+        }
+    }
+
+    sync->sample(result);
+
+    return result;
+}
+
+auto root_logger_t::pressure(std::size_t handler) const -> pressure_t {
+    const rcu::read_lock_t lock;
+    const auto inner = sync->snapshot.load(std::memory_order_acquire);
+
+    if (handler >= inner->handlers->size()) {
+        throw std::out_of_range("no handler at position " + std::to_string(handler));
+    }
+
+    return (*inner->handlers)[handler]->pressure();
+}
+
+auto root_logger_t::async_wait(pressure_t::level_t level, std::function<void()> fn) -> bool {
+    if (pressure().level < level) {
+        return true;
+    }
+
+    std::lock_guard<std::mutex> lock(sync->waiting);
+
+    if (sync->timer == nullptr) {
+        sync->timer = sink::file::flusher::timer_t::instance();
+        sync->subscription = sync->timer->subscribe([this] {
+            wake();
+        });
+    }
+
+    sync->waiters.push_back({level, std::move(fn)});
+
+    return false;
+}
+
+auto root_logger_t::wake() -> void {
+    {
+        std::lock_guard<std::mutex> lock(sync->waiting);
+        if (sync->waiters.empty()) {
+            return;
+        }
+    }
+
+    const auto level = pressure().level;
+
+    std::vector<sync_t::waiter_t> ready;
+    {
+        std::lock_guard<std::mutex> lock(sync->waiting);
+
+        auto& waiters = sync->waiters;
+        const auto it = std::stable_partition(waiters.begin(), waiters.end(),
+            [&](const sync_t::waiter_t& waiter) {
+                return waiter.level <= level;
+            });
+
+        std::move(it, waiters.end(), std::back_inserter(ready));
+        waiters.erase(it, waiters.end());
+    }
+
+    // Called without the lock, so functions are allowed to wait again.
+    for (auto& waiter : ready) {
+        guarded(sync->errors, waiter.fn);
     }
 }
 
@@ -0,0 +1,129 @@
+#include "blackhole/scope/buffered.hpp"
+
+#include <stdexcept>
+
+#include "blackhole/record.hpp"
+#include "blackhole/root.hpp"
+
+#include "blackhole/detail/error.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace scope {
+
+constexpr std::size_t buffered_holder_t::chunk;
+
+buffered_holder_t::buffered_holder_t(root_logger_t& logger, policy_t policy,
+                                     attributes_t attributes) :
+    holder_t(logger, std::move(attributes)),
+    logger(logger),
+    policy(policy),
+    birth(std::chrono::steady_clock::now()),
+    decision(decision_t::none),
+    failed(false),
+    offset(0)
+{
+    intercept();
+}
+
+buffered_holder_t::buffered_holder_t(root_logger_t& logger, policy_t policy,
+                                     std::initializer_list<compact_attribute_t> attributes) :
+    holder_t(logger, attributes),
+    logger(logger),
+    policy(policy),
+    birth(std::chrono::steady_clock::now()),
+    decision(decision_t::none),
+    failed(false),
+    offset(0)
+{
+    intercept();
+}
+
+buffered_holder_t::~buffered_holder_t() {
+    if (decision == decision_t::none) {
+        const auto elapsed = std::chrono::steady_clock::now() - birth;
+        decision = failed || elapsed >= policy.latency ? decision_t::commit : decision_t::discard;
+    }
+
+    if (decision == decision_t::discard || records.empty()) {
+        return;
+    }
+
+    try {
+        flush();
+    } catch (const std::exception& err) {
+        detail::error::report(error::kind_t::deferred, err.what());
+    }
+}
+
+auto buffered_holder_t::commit() noexcept -> void {
+    decision = decision_t::commit;
+}
+
+auto buffered_holder_t::discard() noexcept -> void {
+    decision = decision_t::discard;
+}
+
+auto buffered_holder_t::size() const noexcept -> std::size_t {
+    return records.size();
+}
+
+auto buffered_holder_t::capture(const record_t& record) -> void {
+    records.push_back(place(record));
+
+    if (record.severity() >= policy.severity) {
+        failed = true;
+    }
+}
+
+auto buffered_holder_t::place(const record_t& record) -> detail::recordbuf_t {
+    const auto align = [](std::size_t size) -> std::size_t {
+        return (size + sizeof(block_type) - 1) / sizeof(block_type) * sizeof(block_type);
+    };
+
+    if (!chunks.empty()) {
+        const auto memory = reinterpret_cast<char*>(chunks.back().get()) + offset;
+        detail::recordbuf_t result(record, memory, chunk - offset);
+
+        if (!result.allocated()) {
+            offset += align(result.size());
+            return result;
+        }
+
+        // Records larger than a chunk stay on the heap, while others start a new chunk.
+        if (result.size() > chunk) {
+            return result;
+        }
+    }
+
+    chunks.emplace_back(new block_type[chunk / sizeof(block_type)]);
+    offset = 0;
+
+    detail::recordbuf_t result(record, chunks.back().get(), chunk);
+    if (!result.allocated()) {
+        offset = align(result.size());
+    }
+
+    return result;
+}
+
+auto buffered_holder_t::flush() -> void {
+    std::vector<record_t> views;
+    views.reserve(records.size());
+
+    for (const auto& record : records) {
+        views.push_back(record.into_view());
+    }
+
+    if (auto outer = enclosing()) {
+        for (const auto& view : views) {
+            outer->capture(view);
+        }
+    } else {
+        logger.dispatch(views.data(), views.size());
+    }
+}
+
+}  // namespace scope
+}  // namespace v1
+}  // namespace blackhole
@@ -7,10 +7,10 @@ namespace scope {
 namespace {
 
 // TODO: Move somewhere near `view_of`.
-auto transform(const attributes_t& source) -> attribute_list {
+auto transform(const compact_attributes_t& source) -> attribute_list {
     attribute_list result;
     for (const auto& attribute : source) {
-        result.emplace_back(attribute);
+        result.emplace_back(attribute.first, attribute.second.view());
     }
 
     return result;
@@ -20,7 +20,13 @@ auto transform(const attributes_t& source) -> attribute_list {
 
 holder_t::holder_t(logger_t& logger, attributes_t attributes):
     watcher_t(logger),
-    storage(std::move(attributes)),
+    storage(into_compact(std::move(attributes), functions)),
+    list(transform(storage))
+{}
+
+holder_t::holder_t(logger_t& logger, std::initializer_list<compact_attribute_t> attributes):
+    watcher_t(logger),
+    storage(attributes.begin(), attributes.end()),
     list(transform(storage))
 {}
 
@@ -1,11 +1,117 @@
 #include "blackhole/scope/manager.hpp"
 
+#include <mutex>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "blackhole/scope/task.hpp"
+
+#include "blackhole/detail/scope/manager.hpp"
+
 namespace blackhole {
 inline namespace v1 {
 namespace scope {
+namespace {
+
+/// Thread-local slot, which holds the current watcher of some manager.
+///
+/// Slots are tagged with the generation of the manager that has written them, because ids are
+/// reused after managers are destroyed, while their slots on other threads are left as is.
+typedef task_t::slot_t slot_t;
+
+/// Number of slots kept inline, covering typical number of loggers with static thread-local
+/// storage, which requires neither lazy initialization nor function calls to access.
+constexpr std::size_t inline_slots = 16;
+
+thread_local slot_t slots[inline_slots];
+thread_local std::vector<slot_t> overflow;
+
+/// Allocates dense manager ids, reusing released ones, and unique generations starting from one,
+/// so zero-initialized slots match no manager.
+class ids_t {
+    std::mutex mutex;
+    std::vector<std::uint32_t> released;
+    std::uint32_t next;
+    std::uint64_t generation;
+
+public:
+    ids_t() noexcept :
+        next(0),
+        generation(0)
+    {}
+
+    /// Returns the allocator, which is never destroyed, allowing loggers with static storage
+    /// duration to be destroyed in any order.
+    static auto instance() -> ids_t& {
+        static auto ids = new ids_t;
+        return *ids;
+    }
+
+    auto acquire() -> std::pair<std::uint32_t, std::uint64_t> {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        std::uint32_t id;
+        if (released.empty()) {
+            id = next++;
+            // Reserves space for releasing all ids, so releasing never throws.
+            released.reserve(next);
+        } else {
+            id = released.back();
+            released.pop_back();
+        }
+
+        return {id, ++generation};
+    }
+
+    auto release(std::uint32_t id) noexcept -> void {
+        std::lock_guard<std::mutex> lock(mutex);
+        released.push_back(id);
+    }
+};
+
+auto slot(std::uint32_t id) -> slot_t& {
+    // Resumed tasks keep their watchers themselves, so scopes follow them across threads.
+    if (const auto task = task_t::current()) {
+        return task->slot(id);
+    }
+
+    if (id < inline_slots) {
+        return slots[id];
+    }
+
+    const auto index = id - inline_slots;
+
+    if (overflow.size() <= index) {
+        overflow.resize(index + 1, slot_t{0, nullptr});
+    }
+
+    return overflow[index];
+}
+
+}  // namespace
 
 manager_t::~manager_t() = default;
 
+thread_manager_t::thread_manager_t() {
+    std::tie(id, generation) = ids_t::instance().acquire();
+}
+
+thread_manager_t::~thread_manager_t() {
+    ids_t::instance().release(id);
+}
+
+auto thread_manager_t::get() const -> watcher_t* {
+    const auto& slot = scope::slot(id);
+    return slot.generation == generation ? slot.watcher : nullptr;
+}
+
+auto thread_manager_t::reset(watcher_t* value) -> void {
+    auto& slot = scope::slot(id);
+    slot.generation = generation;
+    slot.watcher = value;
+}
+
 }  // namespace scope
 }  // namespace v1
 }  // namespace blackhole
@@ -0,0 +1,29 @@
+#include "blackhole/scope/span.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace scope {
+
+span_t::span_t(const trace_t& trace) noexcept :
+    prev(trace::current())
+{
+    trace::reset(trace);
+}
+
+span_t::span_t(std::uint64_t span) noexcept :
+    prev(trace::current())
+{
+    trace::reset({prev.hi, prev.lo, span});
+}
+
+span_t::~span_t() {
+    trace::reset(prev);
+}
+
+auto span_t::parent() const noexcept -> const trace_t& {
+    return prev;
+}
+
+}  // namespace scope
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,45 @@
+#include "blackhole/scope/task.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace scope {
+namespace {
+
+thread_local task_t* resumed = nullptr;
+
+}  // namespace
+
+task_t::task_t() noexcept :
+    trace{0, 0, 0}
+{}
+
+auto task_t::slot(std::uint32_t id) -> slot_t& {
+    if (slots.size() <= id) {
+        slots.resize(id + 1, slot_t{0, nullptr});
+    }
+
+    return slots[id];
+}
+
+auto task_t::current() noexcept -> task_t* {
+    return resumed;
+}
+
+resume_t::resume_t(task_t& task) noexcept :
+    task(task),
+    prev(resumed),
+    saved(trace::current())
+{
+    resumed = &task;
+    trace::reset(task.trace);
+}
+
+resume_t::~resume_t() {
+    task.trace = trace::current();
+    trace::reset(saved);
+    resumed = prev;
+}
+
+}  // namespace scope
+}  // namespace v1
+}  // namespace blackhole
@@ -12,7 +12,9 @@ namespace scope {
 
 watcher_t::watcher_t(logger_t& logger) :
     manager(logger.manager()),
-    prev(manager.get().get())
+    prev(manager.get().get()),
+    interceptor(prev ? prev->interceptor : nullptr),
+    ready(false)
 {
     manager.get().reset(this);
 }
@@ -23,13 +25,11 @@ watcher_t::~watcher_t() {
 }
 
 auto watcher_t::collect(attribute_pack& pack) const -> void {
-    pack.emplace_back(attributes());
-
-    if (prev) {
-        prev->collect(pack);
-    }
+    pack.emplace_back(flattened());
 }
 
+auto watcher_t::capture(const record_t&) -> void {}
+
 auto watcher_t::rebind(manager_t& manager) -> void {
     this->manager = manager;
 
@@ -38,6 +38,24 @@ auto watcher_t::rebind(manager_t& manager) -> void {
     }
 }
 
+auto watcher_t::flattened() const -> const attribute_list& {
+    if (prev == nullptr) {
+        return attributes();
+    }
+
+    if (!ready) {
+        const auto& own = attributes();
+        const auto& rest = prev->flattened();
+
+        chain.reserve(own.size() + rest.size());
+        chain.insert(chain.end(), own.begin(), own.end());
+        chain.insert(chain.end(), rest.begin(), rest.end());
+        ready = true;
+    }
+
+    return chain;
+}
+
 }  // namespace scope
 }  // namespace v1
 }  // namespace blackhole
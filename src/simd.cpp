@@ -0,0 +1,123 @@
+#include "blackhole/detail/simd.hpp"
+
+#include <mutex>
+
+namespace blackhole {
+inline namespace v1 {
+namespace detail {
+namespace simd {
+namespace {
+
+/// Guards the list of attached kernels, both are constant-initialized, so kernels can attach
+/// during static initialization.
+std::mutex mutex;
+binding_t* head = nullptr;
+
+/// Selected instruction set or a negative value until detected.
+std::atomic<int> current(-1);
+
+struct features_t {
+    bool supported[isa_count];
+
+    features_t() noexcept :
+        supported{true, false, false, false, false}
+    {
+#if defined(BLACKHOLE_SIMD_X86)
+        // Required when called before constructors of the runtime library, which may be the case
+        // of kernels called during static initialization.
+        __builtin_cpu_init();
+
+        supported[static_cast<std::size_t>(isa_t::sse2)] = __builtin_cpu_supports("sse2");
+        supported[static_cast<std::size_t>(isa_t::avx2)] = __builtin_cpu_supports("avx2");
+        supported[static_cast<std::size_t>(isa_t::avx512)] =
+            __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw");
+#endif
+
+#if defined(BLACKHOLE_SIMD_NEON)
+        supported[static_cast<std::size_t>(isa_t::neon)] = true;
+#endif
+    }
+
+    auto best() const noexcept -> isa_t {
+        for (auto id = isa_count - 1; id > 0; --id) {
+            if (supported[id]) {
+                return static_cast<isa_t>(id);
+            }
+        }
+
+        return isa_t::scalar;
+    }
+};
+
+auto features() noexcept -> const features_t& {
+    static const features_t features;
+    return features;
+}
+
+}  // namespace
+
+auto name(isa_t isa) noexcept -> const char* {
+    switch (isa) {
+    case isa_t::scalar:
+        return "scalar";
+    case isa_t::sse2:
+        return "sse2";
+    case isa_t::avx2:
+        return "avx2";
+    case isa_t::avx512:
+        return "avx512";
+    case isa_t::neon:
+        return "neon";
+    }
+
+    return "unknown";
+}
+
+auto supported(isa_t isa) noexcept -> bool {
+    const auto id = static_cast<std::size_t>(isa);
+    return id < isa_count && features().supported[id];
+}
+
+auto selected() noexcept -> isa_t {
+    auto value = current.load(std::memory_order_acquire);
+
+    if (value < 0) {
+        const auto best = static_cast<int>(features().best());
+        current.compare_exchange_strong(value, best, std::memory_order_acq_rel);
+        value = current.load(std::memory_order_acquire);
+    }
+
+    return static_cast<isa_t>(value);
+}
+
+auto select(isa_t isa) noexcept -> bool {
+    if (!supported(isa)) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    current.store(static_cast<int>(isa), std::memory_order_release);
+
+    for (auto binding = head; binding != nullptr; binding = binding->next) {
+        binding->bind(isa);
+    }
+
+    return true;
+}
+
+auto binding_t::attach() noexcept -> void {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (!attached) {
+        attached = true;
+        next = head;
+        head = this;
+    }
+
+    bind(selected());
+}
+
+}  // namespace simd
+}  // namespace detail
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,52 @@
+#include "blackhole/sink.hpp"
+
+#include "blackhole/pressure.hpp"
+#include "blackhole/stdext/string_view.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+
+auto sink_t::emit_batch(const event_t* events, std::size_t size) -> void {
+    for (std::size_t id = 0; id < size; ++id) {
+        emit(*events[id].record, *events[id].message);
+    }
+}
+
+auto sink_t::emit_gathered(const record_t& record, const string_view* slices, std::size_t count) ->
+    void
+{
+    std::size_t size = 0;
+    for (std::size_t id = 0; id < count; ++id) {
+        size += slices[id].size();
+    }
+
+    std::string message;
+    message.reserve(size);
+
+    for (std::size_t id = 0; id < count; ++id) {
+        message.append(slices[id].data(), slices[id].size());
+    }
+
+    emit(record, message);
+}
+
+auto sink_t::lend(const record_t&, std::size_t) -> region_t {
+    return region_t{nullptr, 0};
+}
+
+auto sink_t::commit(const record_t&, std::size_t) -> void {}
+
+auto sink_t::cancel() noexcept -> void {}
+
+auto sink_t::flush(std::chrono::steady_clock::time_point) -> bool {
+    return true;
+}
+
+auto sink_t::collect(metrics::collector_t&) const -> void {}
+
+auto sink_t::pressure() const -> pressure_t {
+    return pressure_t();
+}
+
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,856 @@
+#include "blackhole/sink/arrow.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <system_error>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <boost/optional/optional.hpp>
+#include <boost/variant/apply_visitor.hpp>
+
+#include "blackhole/attribute.hpp"
+#include "blackhole/attributes.hpp"
+#include "blackhole/config/node.hpp"
+#include "blackhole/config/option.hpp"
+#include "blackhole/extensions/format.hpp"
+#include "blackhole/extensions/writer.hpp"
+#include "blackhole/record.hpp"
+#include "blackhole/stdext/string_view.hpp"
+
+#include "blackhole/detail/attribute.hpp"
+#include "blackhole/detail/error.hpp"
+#include "blackhole/detail/flatbuffers.hpp"
+#include "blackhole/detail/memory.hpp"
+#include "blackhole/detail/sink/arrow.hpp"
+#include "blackhole/detail/sink/file/flusher/timer.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+namespace arrow {
+namespace {
+
+namespace fb = detail::flatbuffers;
+
+using attribute::view_t;
+
+/// Arrow schema constants, see https://github.com/apache/arrow/tree/main/format.
+constexpr std::int16_t metadata_v5 = 4;
+
+enum header_t : std::uint8_t {
+    schema_header = 1,
+    dictionary_header = 2,
+    batch_header = 3
+};
+
+enum type_id_t : std::uint8_t {
+    int_id = 2,
+    floating_id = 3,
+    utf8_id = 5,
+    bool_id = 6,
+    timestamp_id = 10
+};
+
+constexpr std::int16_t double_precision = 2;
+constexpr std::int16_t nanosecond_unit = 3;
+
+constexpr std::uint32_t continuation = 0xffffffff;
+
+/// Physical layouts of columns.
+enum class layout_t {
+    boolean,
+    sint32,
+    sint64,
+    uint64,
+    float64,
+    timestamp,
+    string,
+    dictionary
+};
+
+auto layout(const column_t& column) -> layout_t {
+    switch (column.type) {
+    case type_t::boolean:
+        return layout_t::boolean;
+    case type_t::sint64:
+        return layout_t::sint64;
+    case type_t::uint64:
+        return layout_t::uint64;
+    case type_t::float64:
+        return layout_t::float64;
+    case type_t::string:
+        return column.dictionary ? layout_t::dictionary : layout_t::string;
+    }
+
+    return layout_t::string;
+}
+
+/// Well-known columns preceding attribute ones.
+const char* const fields[] = {"timestamp", "severity", "message", "pid", "lwp"};
+const layout_t layouts[] = {
+    layout_t::timestamp, layout_t::sint32, layout_t::string, layout_t::uint64, layout_t::uint64
+};
+
+constexpr std::size_t known = sizeof(fields) / sizeof(fields[0]);
+
+auto put(std::string& result, const void* data, std::size_t size) -> void {
+    if (size != 0) {
+        result.append(static_cast<const char*>(data), size);
+    }
+}
+
+auto pad(std::string& result) -> void {
+    result.append((8 - result.size() % 8) % 8, '\0');
+}
+
+/// Body of a record batch with the layout of its buffers.
+struct body_t {
+    std::string data;
+    std::vector<std::int64_t> nodes;
+    std::vector<std::int64_t> buffers;
+
+    auto node(std::size_t length, std::size_t nulls) -> void {
+        nodes.push_back(static_cast<std::int64_t>(length));
+        nodes.push_back(static_cast<std::int64_t>(nulls));
+    }
+
+    /// Appends the buffer aligned to 8 bytes.
+    auto buffer(const void* value, std::size_t size) -> void {
+        buffers.push_back(static_cast<std::int64_t>(data.size()));
+        buffers.push_back(static_cast<std::int64_t>(size));
+        put(data, value, size);
+        pad(data);
+    }
+};
+
+/// Encapsulates the given flatbuffer metadata and body into an IPC message.
+auto message(const std::string& metadata, const std::string& body) -> std::string {
+    std::string result;
+    put(result, &continuation, sizeof(continuation));
+
+    // The metadata is padded so that the body starts at an 8-byte boundary.
+    const auto size = static_cast<std::int32_t>((metadata.size() + 7) / 8 * 8);
+    put(result, &size, sizeof(size));
+    result.append(metadata);
+    pad(result);
+    result.append(body);
+
+    return result;
+}
+
+auto finish(fb::builder_t& builder, header_t type, fb::offset_t header, std::size_t body) ->
+    std::string
+{
+    builder.begin();
+    builder.add<std::int16_t>(0, metadata_v5);
+    builder.add<std::uint8_t>(1, type);
+    builder.reference(2, header);
+    builder.add<std::int64_t>(3, static_cast<std::int64_t>(body));
+    return builder.finish(builder.end());
+}
+
+auto int_type(fb::builder_t& builder, std::int32_t width, bool sign) -> fb::offset_t {
+    builder.begin();
+    builder.add<std::int32_t>(0, width);
+    builder.add<std::uint8_t>(1, sign);
+    return builder.end();
+}
+
+/// Writes the `Field` table of the given column, whose dictionary id is ignored unless the column
+/// is dictionary encoded.
+auto field(fb::builder_t& builder, const std::string& name, layout_t layout, std::int64_t id) ->
+    fb::offset_t
+{
+    std::uint8_t type_id = utf8_id;
+    fb::offset_t type = 0;
+
+    switch (layout) {
+    case layout_t::boolean:
+        type_id = bool_id;
+        builder.begin();
+        type = builder.end();
+        break;
+    case layout_t::sint32:
+        type_id = int_id;
+        type = int_type(builder, 32, true);
+        break;
+    case layout_t::sint64:
+        type_id = int_id;
+        type = int_type(builder, 64, true);
+        break;
+    case layout_t::uint64:
+        type_id = int_id;
+        type = int_type(builder, 64, false);
+        break;
+    case layout_t::float64:
+        type_id = floating_id;
+        builder.begin();
+        builder.add<std::int16_t>(0, double_precision);
+        type = builder.end();
+        break;
+    case layout_t::timestamp: {
+        type_id = timestamp_id;
+        const auto timezone = builder.string("UTC");
+        builder.begin();
+        builder.add<std::int16_t>(0, nanosecond_unit);
+        builder.reference(1, timezone);
+        type = builder.end();
+        break;
+    }
+    case layout_t::string:
+    case layout_t::dictionary:
+        builder.begin();
+        type = builder.end();
+        break;
+    }
+
+    fb::offset_t dictionary = 0;
+    if (layout == layout_t::dictionary) {
+        const auto index = int_type(builder, 32, true);
+        builder.begin();
+        builder.add<std::int64_t>(0, id);
+        builder.reference(1, index);
+        builder.add<std::uint8_t>(2, false);
+        dictionary = builder.end();
+    }
+
+    const auto label = builder.string(name);
+    const auto children = builder.offsets({});
+
+    builder.begin();
+    builder.reference(0, label);
+    builder.add<std::uint8_t>(1, true);
+    builder.add<std::uint8_t>(2, type_id);
+    builder.reference(3, type);
+    if (dictionary != 0) {
+        builder.reference(4, dictionary);
+    }
+    builder.reference(5, children);
+    return builder.end();
+}
+
+/// Writes the `RecordBatch` table describing the given body.
+auto record_batch(fb::builder_t& builder, std::size_t length, const body_t& body) -> fb::offset_t {
+    const auto nodes = builder.structs(reinterpret_cast<const char*>(body.nodes.data()),
+        body.nodes.size() / 2, 16, 8);
+    const auto buffers = builder.structs(reinterpret_cast<const char*>(body.buffers.data()),
+        body.buffers.size() / 2, 16, 8);
+
+    builder.begin();
+    builder.add<std::int64_t>(0, static_cast<std::int64_t>(length));
+    builder.reference(1, nodes);
+    builder.reference(2, buffers);
+    return builder.end();
+}
+
+}  // namespace
+
+auto type(const std::string& name) -> type_t {
+    if (name == "bool") {
+        return type_t::boolean;
+    } else if (name == "int64") {
+        return type_t::sint64;
+    } else if (name == "uint64") {
+        return type_t::uint64;
+    } else if (name == "double") {
+        return type_t::float64;
+    } else if (name == "string") {
+        return type_t::string;
+    }
+
+    throw std::invalid_argument("unknown column type: " + name);
+}
+
+/// Values of a single column.
+class batch_t::data_t {
+public:
+    const layout_t layout;
+
+    std::vector<std::uint8_t> validity;
+    std::size_t size;
+    std::size_t nulls;
+
+    /// Fixed-width values, boolean bitmap or dictionary codes.
+    std::string values;
+
+    /// Either plain strings or dictionary values.
+    std::vector<std::int32_t> offsets;
+    std::string strings;
+
+    std::unordered_map<std::string, std::int32_t> codes;
+    std::string key;
+
+    explicit data_t(layout_t layout) :
+        layout(layout),
+        size(0),
+        nulls(0)
+    {
+        offsets.push_back(0);
+    }
+
+    auto bytes() const noexcept -> std::size_t {
+        return validity.size() + values.size() + offsets.size() * sizeof(std::int32_t) +
+            strings.size();
+    }
+
+    auto null() -> void {
+        switch (layout) {
+        case layout_t::boolean:
+            bit(values, false);
+            break;
+        case layout_t::sint32:
+            values.append(sizeof(std::int32_t), '\0');
+            break;
+        case layout_t::sint64:
+        case layout_t::uint64:
+        case layout_t::float64:
+        case layout_t::timestamp:
+            values.append(sizeof(std::int64_t), '\0');
+            break;
+        case layout_t::string:
+            offsets.push_back(offsets.back());
+            break;
+        case layout_t::dictionary:
+            values.append(sizeof(std::int32_t), '\0');
+            break;
+        }
+
+        ++nulls;
+        valid(false);
+    }
+
+    auto boolean(bool value) -> void {
+        bit(values, value);
+        valid(true);
+    }
+
+    template<typename T>
+    auto number(T value) -> void {
+        put(values, &value, sizeof(value));
+        valid(true);
+    }
+
+    auto string(const char* data, std::size_t size) -> void {
+        if (layout == layout_t::dictionary) {
+            key.assign(data, size);
+
+            auto it = codes.find(key);
+            if (it == codes.end()) {
+                it = codes.emplace(key, static_cast<std::int32_t>(codes.size())).first;
+                append(data, size);
+            }
+
+            number(it->second);
+            return;
+        }
+
+        append(data, size);
+        valid(true);
+    }
+
+    /// Appends buffers of the column values to the body.
+    auto encode(body_t& body) const -> void {
+        body.node(size, nulls);
+        body.buffer(validity.data(), nulls == 0 ? 0 : validity.size());
+
+        switch (layout) {
+        case layout_t::string:
+            body.buffer(offsets.data(), offsets.size() * sizeof(std::int32_t));
+            body.buffer(strings.data(), strings.size());
+            break;
+        default:
+            body.buffer(values.data(), values.size());
+            break;
+        }
+    }
+
+    /// Appends buffers of dictionary values to the body.
+    auto encode_dictionary(body_t& body) const -> void {
+        body.node(codes.size(), 0);
+        body.buffer(nullptr, 0);
+        body.buffer(offsets.data(), offsets.size() * sizeof(std::int32_t));
+        body.buffer(strings.data(), strings.size());
+    }
+
+    auto clear() -> void {
+        validity.clear();
+        size = 0;
+        nulls = 0;
+        values.clear();
+        offsets.assign(1, 0);
+        strings.clear();
+        codes.clear();
+    }
+
+private:
+    auto append(const char* data, std::size_t size) -> void {
+        strings.append(data, size);
+        offsets.push_back(static_cast<std::int32_t>(strings.size()));
+    }
+
+    auto valid(bool value) -> void {
+        if (size % 8 == 0) {
+            validity.push_back(0);
+        }
+
+        if (value) {
+            validity.back() |= static_cast<std::uint8_t>(1 << (size % 8));
+        }
+
+        ++size;
+    }
+
+    /// Appends a bit to the bitmap, whose length is tracked by the validity one.
+    auto bit(std::string& bitmap, bool value) -> void {
+        if (size % 8 == 0) {
+            bitmap.push_back('\0');
+        }
+
+        if (value) {
+            bitmap.back() = static_cast<char>(bitmap.back() | (1 << (size % 8)));
+        }
+    }
+};
+
+namespace {
+
+/// Appends attribute values converted to the column type, yielding nulls for inconvertible ones.
+class append_t : public boost::static_visitor<> {
+    batch_t::data_t& data;
+
+public:
+    explicit append_t(batch_t::data_t& data) noexcept :
+        data(data)
+    {}
+
+    auto operator()(const view_t::null_type&) const -> void {
+        data.null();
+    }
+
+    auto operator()(const view_t::bool_type& value) const -> void {
+        switch (data.layout) {
+        case layout_t::boolean:
+            data.boolean(value);
+            break;
+        case layout_t::string:
+        case layout_t::dictionary:
+            value ? data.string("true", 4) : data.string("false", 5);
+            break;
+        default:
+            data.null();
+        }
+    }
+
+    auto operator()(const view_t::sint64_type& value) const -> void {
+        switch (data.layout) {
+        case layout_t::sint64:
+            data.number(value);
+            break;
+        case layout_t::uint64:
+            value < 0 ? data.null() : data.number(static_cast<std::uint64_t>(value));
+            break;
+        case layout_t::float64:
+            data.number(static_cast<double>(value));
+            break;
+        case layout_t::string:
+        case layout_t::dictionary: {
+            const fmt::FormatInt formatted(value);
+            data.string(formatted.data(), formatted.size());
+            break;
+        }
+        default:
+            data.null();
+        }
+    }
+
+    auto operator()(const view_t::uint64_type& value) const -> void {
+        switch (data.layout) {
+        case layout_t::sint64:
+            if (value > static_cast<std::uint64_t>(std::numeric_limits<std::int64_t>::max())) {
+                data.null();
+            } else {
+                data.number(static_cast<std::int64_t>(value));
+            }
+            break;
+        case layout_t::uint64:
+            data.number(value);
+            break;
+        case layout_t::float64:
+            data.number(static_cast<double>(value));
+            break;
+        case layout_t::string:
+        case layout_t::dictionary: {
+            const fmt::FormatInt formatted(value);
+            data.string(formatted.data(), formatted.size());
+            break;
+        }
+        default:
+            data.null();
+        }
+    }
+
+    auto operator()(const view_t::double_type& value) const -> void {
+        switch (data.layout) {
+        case layout_t::float64:
+            data.number(value);
+            break;
+        case layout_t::string:
+        case layout_t::dictionary: {
+            const auto formatted = fmt::format("{}", value);
+            data.string(formatted.data(), formatted.size());
+            break;
+        }
+        default:
+            data.null();
+        }
+    }
+
+    auto operator()(const view_t::string_type& value) const -> void {
+        if (data.layout == layout_t::string || data.layout == layout_t::dictionary) {
+            data.string(value.data(), value.size());
+        } else {
+            data.null();
+        }
+    }
+
+    auto operator()(const view_t::function_type& value) const -> void {
+        if (data.layout == layout_t::string || data.layout == layout_t::dictionary) {
+            writer_t writer;
+            value(writer);
+            const auto result = writer.result();
+            data.string(result.data(), result.size());
+        } else {
+            data.null();
+        }
+    }
+};
+
+}  // namespace
+
+batch_t::batch_t(std::vector<column_t> columns) :
+    columns(std::move(columns)),
+    rows_(0)
+{
+    std::unordered_set<std::string> names(fields, fields + known);
+
+    for (std::size_t id = 0; id < known; ++id) {
+        data.emplace_back(new data_t(layouts[id]));
+    }
+
+    for (const auto& column : this->columns) {
+        if (column.name.empty() || !names.insert(column.name).second) {
+            throw std::invalid_argument("column names must be non-empty and unique: " +
+                column.name);
+        }
+
+        data.emplace_back(new data_t(layout(column)));
+    }
+}
+
+batch_t::~batch_t() = default;
+
+auto batch_t::rows() const noexcept -> std::size_t {
+    return rows_;
+}
+
+auto batch_t::bytes() const noexcept -> std::size_t {
+    std::size_t result = 0;
+    for (const auto& column : data) {
+        result += column->bytes();
+    }
+
+    return result;
+}
+
+auto batch_t::schema() const -> std::string {
+    fb::builder_t builder;
+
+    std::vector<fb::offset_t> offsets;
+    for (std::size_t id = 0; id < data.size(); ++id) {
+        const auto& name = id < known ? std::string(fields[id]) : columns[id - known].name;
+        offsets.push_back(field(builder, name, data[id]->layout, static_cast<std::int64_t>(id)));
+    }
+
+    const auto list = builder.offsets(offsets);
+
+    builder.begin();
+    // Little endian.
+    builder.add<std::int16_t>(0, 0);
+    builder.reference(1, list);
+    const auto schema = builder.end();
+
+    return message(finish(builder, schema_header, schema, 0), std::string());
+}
+
+auto batch_t::append(const record_t& record, const string_view& message) -> void {
+    data[0]->number(static_cast<std::int64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        record.timestamp().time_since_epoch()).count()));
+    data[1]->number(static_cast<std::int32_t>(record.severity()));
+    data[2]->string(message.data(), message.size());
+    data[3]->number(static_cast<std::uint64_t>(record.pid()));
+    data[4]->number(record.lwp());
+
+    for (std::size_t id = 0; id < columns.size(); ++id) {
+        const auto& name = columns[id].name;
+        auto& column = *data[known + id];
+
+        const view_t* value = nullptr;
+        for (const auto& list : record.attributes()) {
+            for (const auto& it : list.get()) {
+                if (it.first.size() == name.size() &&
+                    std::memcmp(it.first.data(), name.data(), name.size()) == 0)
+                {
+                    value = &it.second;
+                    break;
+                }
+            }
+
+            if (value) {
+                break;
+            }
+        }
+
+        if (value) {
+            boost::apply_visitor(append_t(column), value->inner().value);
+        } else {
+            column.null();
+        }
+    }
+
+    ++rows_;
+}
+
+auto batch_t::encode() -> std::string {
+    if (rows_ == 0) {
+        return std::string();
+    }
+
+    std::string result;
+
+    for (std::size_t id = 0; id < data.size(); ++id) {
+        if (data[id]->layout != layout_t::dictionary) {
+            continue;
+        }
+
+        body_t body;
+        data[id]->encode_dictionary(body);
+
+        fb::builder_t builder;
+        const auto batch = record_batch(builder, data[id]->codes.size(), body);
+
+        builder.begin();
+        builder.add<std::int64_t>(0, static_cast<std::int64_t>(id));
+        builder.reference(1, batch);
+        builder.add<std::uint8_t>(2, false);
+        const auto dictionary = builder.end();
+
+        result += message(finish(builder, dictionary_header, dictionary, body.data.size()),
+            body.data);
+    }
+
+    body_t body;
+    for (const auto& column : data) {
+        column->encode(body);
+    }
+
+    fb::builder_t builder;
+    const auto batch = record_batch(builder, rows_, body);
+    result += message(finish(builder, batch_header, batch, body.data.size()), body.data);
+
+    for (auto& column : data) {
+        column->clear();
+    }
+
+    rows_ = 0;
+    return result;
+}
+
+auto batch_t::eos() -> std::string {
+    std::string result;
+    put(result, &continuation, sizeof(continuation));
+    result.append(4, '\0');
+    return result;
+}
+
+}  // namespace arrow
+
+namespace {
+
+auto write(int fd, const std::string& data) -> void {
+    const char* it = data.data();
+    auto size = data.size();
+
+    while (size > 0) {
+        const auto nwritten = ::write(fd, it, size);
+
+        if (nwritten < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            throw std::system_error(errno, std::system_category());
+        }
+
+        it += nwritten;
+        size -= static_cast<std::size_t>(nwritten);
+    }
+}
+
+}  // namespace
+
+arrow_t::arrow_t(options_t options) :
+    options_(std::move(options)),
+    batch(options_.columns),
+    fd(-1),
+    since(0),
+    subscription(0)
+{
+    if (options_.rows == 0 || options_.bytes == 0) {
+        throw std::invalid_argument("rows and bytes limits must be positive");
+    }
+
+    fd = ::open(options_.path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        throw std::system_error(errno, std::system_category(),
+            "failed to create " + options_.path);
+    }
+
+    try {
+        sink::write(fd, batch.schema());
+    } catch (...) {
+        ::close(fd);
+        throw;
+    }
+
+    if (options_.interval.count() > 0) {
+        timer = file::flusher::timer_t::instance();
+        since = timer->now();
+
+        subscription = timer->subscribe([this] {
+            // Skips the round while the sink is busy, since emitting checks the time either way.
+            std::unique_lock<detail::mutex_t> lock(mutex, std::try_to_lock);
+            if (lock.owns_lock() && batch.rows() > 0 &&
+                timer->now() - since >= static_cast<std::uint64_t>(options_.interval.count()))
+            {
+                write();
+            }
+        });
+    }
+}
+
+arrow_t::~arrow_t() {
+    if (timer) {
+        timer->unsubscribe(subscription);
+    }
+
+    try {
+        write();
+        sink::write(fd, arrow::batch_t::eos());
+    } catch (const std::exception& err) {
+        detail::error::report(error::kind_t::sink, err.what());
+    }
+
+    ::close(fd);
+}
+
+auto arrow_t::options() const noexcept -> const options_t& {
+    return options_;
+}
+
+auto arrow_t::emit(const record_t& record, const string_view& formatted) -> void {
+    const event_t event{&record, &formatted};
+    emit_batch(&event, 1);
+}
+
+auto arrow_t::emit_batch(const event_t* events, std::size_t size) -> void {
+    std::lock_guard<detail::mutex_t> lock(mutex);
+
+    for (std::size_t id = 0; id < size; ++id) {
+        if (timer && batch.rows() == 0) {
+            since = timer->now();
+        }
+
+        batch.append(*events[id].record, *events[id].message);
+
+        const auto expired = timer &&
+            timer->now() - since >= static_cast<std::uint64_t>(options_.interval.count());
+
+        if (batch.rows() >= options_.rows || batch.bytes() >= options_.bytes || expired) {
+            write();
+        }
+    }
+}
+
+auto arrow_t::flush(std::chrono::steady_clock::time_point) -> bool {
+    std::lock_guard<detail::mutex_t> lock(mutex);
+    write();
+    return true;
+}
+
+auto arrow_t::write() -> void {
+    if (batch.rows() > 0) {
+        sink::write(fd, batch.encode());
+    }
+}
+
+}  // namespace sink
+
+auto factory<sink::arrow_t>::type() const noexcept -> const char* {
+    return "arrow";
+}
+
+auto factory<sink::arrow_t>::from(const config::node_t& config) const -> std::unique_ptr<sink_t> {
+    (void)registry;
+
+    sink::arrow_t::options_t options;
+
+    const auto path = config["path"].to_string();
+    if (!path) {
+        throw std::invalid_argument("field 'path' is required");
+    }
+
+    options.path = path.get();
+
+    // Either attribute names, which give dictionary encoded string columns, or objects, like
+    // `{"name": "elapsed", "type": "double"}`.
+    config["columns"].each([&](const config::node_t& column) {
+        if (column.is_string()) {
+            options.columns.push_back({column.to_string(), sink::arrow::type_t::string, true});
+            return;
+        }
+
+        const auto name = column["name"].to_string();
+        if (!name) {
+            throw std::invalid_argument("column requires 'name' field");
+        }
+
+        const auto type = sink::arrow::type(column["type"].to_string().get_value_or("string"));
+        const auto dictionary = column["dictionary"].to_bool().get_value_or(true);
+
+        options.columns.push_back({name.get(), type, type == sink::arrow::type_t::string &&
+            dictionary});
+    });
+
+    if (auto rows = config["rows"].to_uint64()) {
+        options.rows = static_cast<std::size_t>(rows.get());
+    }
+
+    if (auto bytes = config["bytes"].to_uint64()) {
+        options.bytes = static_cast<std::size_t>(bytes.get());
+    }
+
+    if (auto interval = config["interval"].to_uint64()) {
+        options.interval = std::chrono::milliseconds(interval.get());
+    }
+
+    return blackhole::make_unique<sink::arrow_t>(std::move(options));
+}
+
+}  // namespace v1
+}  // namespace blackhole
@@ -1,5 +1,9 @@
 #include "blackhole/sink/asynchronous.hpp"
 
+#include <chrono>
+#include <map>
+#include <mutex>
+
 #include <boost/optional/optional.hpp>
 
 #include "blackhole/config/node.hpp"
@@ -7,9 +11,279 @@
 #include "blackhole/registry.hpp"
 
 #include "blackhole/detail/sink/asynchronous.hpp"
+#include "blackhole/detail/sink/numa.hpp"
 
 namespace blackhole {
 inline namespace v1 {
+namespace {
+
+auto mode_from(const std::string& name) -> sink::asynchronous_t::mode_t {
+    if (name == "queue") {
+        return sink::asynchronous_t::mode_t::queue;
+    } else if (name == "ring") {
+        return sink::asynchronous_t::mode_t::ring;
+    }
+
+    throw std::invalid_argument("no queue mode with name \"" + name + "\" found");
+}
+
+auto sharding_from(const std::string& name) -> sink::asynchronous_t::sharding_t {
+    if (name == "thread") {
+        return sink::asynchronous_t::sharding_t::thread;
+    } else if (name == "cpu") {
+        return sink::asynchronous_t::sharding_t::cpu;
+    }
+
+    throw std::invalid_argument("no sharding with name \"" + name + "\" found");
+}
+
+auto policy_from(const std::string& name) -> sink::asynchronous_t::consumer_t::policy_t {
+    if (name == "other") {
+        return sink::asynchronous_t::consumer_t::policy_t::other;
+    } else if (name == "batch") {
+        return sink::asynchronous_t::consumer_t::policy_t::batch;
+    } else if (name == "idle") {
+        return sink::asynchronous_t::consumer_t::policy_t::idle;
+    }
+
+    throw std::invalid_argument("no scheduling policy with name \"" + name + "\" found");
+}
+
+/// Reads consumer thread properties from an object like `{"name": "blackhole", "cpus": [0, 1],
+/// "policy": "idle", "nice": 10, "numa": 0}`, where all fields are optional.
+auto consumer_from(const config::option<config::node_t>& config) ->
+    sink::asynchronous_t::consumer_t
+{
+    sink::asynchronous_t::consumer_t consumer;
+
+    if (auto name = config["name"].to_string()) {
+        consumer.name = name.get();
+    }
+
+    config["cpus"].each([&](const config::node_t& cpu) {
+        consumer.cpus.push_back(static_cast<int>(cpu.to_sint64()));
+    });
+
+    if (auto policy = config["policy"].to_string()) {
+        consumer.policy = policy_from(policy.get());
+    }
+
+    if (auto nice = config["nice"].to_sint64()) {
+        consumer.nice = static_cast<int>(nice.get());
+    }
+
+    if (auto node = config["numa"].to_sint64()) {
+        consumer.node = static_cast<int>(node.get());
+    }
+
+    return consumer;
+}
+
+/// Creates an overflow policy either from its name or from an object like `{"type": "severity",
+/// "threshold": 2, "timeout": 10}` for policies with parameters, where the timeout is in
+/// milliseconds.
+auto overflow_from(const config::option<config::node_t>& config) ->
+    std::unique_ptr<sink::overflow_policy_t>
+{
+    const sink::overflow_policy_factory_t factory;
+
+    const auto node = config.unwrap();
+    if (!node || !node->is_object()) {
+        return factory.create(config.to_string().get());
+    }
+
+    const auto type = config["type"].to_string();
+    if (!type) {
+        throw std::invalid_argument("overflow policy must have a type");
+    }
+
+    if (type.get() != "timeout" && type.get() != "severity") {
+        return factory.create(type.get());
+    }
+
+    const auto timeout = config["timeout"].to_uint64();
+    if (!timeout) {
+        throw std::invalid_argument("\"" + type.get() + "\" overflow policy requires \"timeout\"");
+    }
+
+    const auto duration = std::chrono::milliseconds(timeout.get());
+
+    if (type.get() == "timeout") {
+        return factory.timeout(duration);
+    }
+
+    const auto threshold = config["threshold"].to_sint64();
+    if (!threshold) {
+        throw std::invalid_argument("\"severity\" overflow policy requires \"threshold\"");
+    }
+
+    return factory.severity(threshold.get(), duration);
+}
+
+/// Creates an exception policy either from its name or from an object like `{"type": "retry",
+/// "attempts": 3, "backoff": 100}` with the backoff in milliseconds, or `{"type": "fallback",
+/// "sink": {...}}`.
+auto exception_from(const config::option<config::node_t>& config, const registry_t& registry) ->
+    std::unique_ptr<sink::exception_policy_t>
+{
+    const sink::exception_policy_factory_t factory;
+
+    const auto node = config.unwrap();
+    if (!node) {
+        return nullptr;
+    }
+
+    if (!node->is_object()) {
+        return factory.create(config.to_string().get());
+    }
+
+    const auto type = config["type"].to_string();
+    if (!type) {
+        throw std::invalid_argument("exception policy must have a type");
+    }
+
+    if (type.get() == "retry") {
+        return factory.retry(config["attempts"].to_uint64().get_value_or(3),
+            std::chrono::milliseconds(config["backoff"].to_uint64().get_value_or(100)),
+            config["capacity"].to_uint64().get_value_or(65536));
+    }
+
+    if (type.get() == "fallback") {
+        const auto sink = config["sink"]["type"].to_string();
+        if (!sink) {
+            throw std::invalid_argument("\"fallback\" exception policy requires \"sink\" with "
+                "\"type\"");
+        }
+
+        return factory.fallback(registry.sink(sink.get())(*config["sink"].unwrap()));
+    }
+
+    return factory.create(type.get());
+}
+
+/// Returns the executor shared by all sinks configured with the same name, creating it on the first
+/// use and destroying with the last sink. Configured either by the name only or by an object like
+/// `{"name": "shared", "threads": 2, "thread": {...}}` with thread properties like the sink has.
+///
+/// Properties are taken from the sink creating the executor, others just share it.
+auto executor_from(const config::option<config::node_t>& config) ->
+    std::shared_ptr<sink::executor_t>
+{
+    const auto node = config.unwrap();
+    if (!node) {
+        return nullptr;
+    }
+
+    const auto name = node->is_object() ? config["name"].to_string() : config.to_string();
+    if (!name) {
+        throw std::invalid_argument("executor must have a name");
+    }
+
+    static std::mutex mutex;
+    static std::map<std::string, std::weak_ptr<sink::executor_t>> executors;
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto& executor = executors[name.get()];
+    if (auto result = executor.lock()) {
+        return result;
+    }
+
+    std::shared_ptr<sink::executor_t> result;
+    if (node->is_object()) {
+        result = std::make_shared<sink::executor_t>(config["threads"].to_uint64().get_value_or(1),
+            consumer_from(config["thread"]));
+    } else {
+        result = std::make_shared<sink::executor_t>(1);
+    }
+
+    executor = result;
+    return result;
+}
+
+/// Reads memory paging properties from an object like `{"huge": true, "populate": true,
+/// "lock": false}`, where all fields are optional.
+auto paging_from(const config::option<config::node_t>& config) -> detail::paging_t {
+    detail::paging_t paging;
+    paging.huge = config["huge"].to_bool().get_value_or(false);
+    paging.populate = config["populate"].to_bool().get_value_or(false);
+    paging.lock = config["lock"].to_bool().get_value_or(false);
+
+    return paging;
+}
+
+/// Reads fair sharing properties from an object like `{"attribute": "tenant", "shares":
+/// [{"value": "billing", "weight": 4}], "buckets": 4, "weight": 1, "quantum": 1024}`, where all
+/// fields except the attribute are optional.
+auto fairness_from(const config::option<config::node_t>& config) ->
+    sink::asynchronous_t::fairness_t
+{
+    sink::asynchronous_t::fairness_t fairness;
+
+    if (!config.unwrap()) {
+        return fairness;
+    }
+
+    const auto attribute = config["attribute"].to_string();
+    if (!attribute) {
+        throw std::invalid_argument("fair sharing requires \"attribute\"");
+    }
+
+    fairness.attribute = attribute.get();
+
+    config["shares"].each([&](const config::node_t& share) {
+        const auto value = share["value"].to_string();
+        if (!value) {
+            throw std::invalid_argument("each fair share must have a \"value\"");
+        }
+
+        fairness.shares.push_back({value.get(), static_cast<std::size_t>(
+            share["weight"].to_uint64().get_value_or(1))});
+    });
+
+    fairness.buckets = config["buckets"].to_uint64().get_value_or(fairness.buckets);
+    fairness.weight = config["weight"].to_uint64().get_value_or(fairness.weight);
+    fairness.quantum = config["quantum"].to_uint64().get_value_or(fairness.quantum);
+
+    return fairness;
+}
+
+/// Reads the record expiration from an object like `{"max_age": 5000, "summary": true}` with the
+/// maximum age in milliseconds.
+auto expiry_from(const config::option<config::node_t>& config) -> sink::asynchronous_t::expiry_t {
+    sink::asynchronous_t::expiry_t expiry;
+    expiry.max_age = std::chrono::milliseconds(config["max_age"].to_uint64().get_value_or(0));
+    expiry.summary = config["summary"].to_bool().get_value_or(false);
+
+    return expiry;
+}
+
+/// Reads the flush-through threshold from an object like `{"threshold": 4, "timeout": 1000}` with
+/// the timeout in milliseconds.
+auto flush_through_from(const config::option<config::node_t>& config) ->
+    sink::asynchronous_t::flush_through_t
+{
+    sink::asynchronous_t::flush_through_t flush_through;
+    flush_through.threshold = config["threshold"].to_sint64()
+        .get_value_or(flush_through.threshold);
+    flush_through.timeout = std::chrono::milliseconds(config["timeout"].to_uint64()
+        .get_value_or(static_cast<std::uint64_t>(flush_through.timeout.count())));
+
+    return flush_through;
+}
+
+/// Reads elastic lanes from an object like `{"segments": 16, "idle": 1000}` with the idle period
+/// in milliseconds.
+auto elastic_from(const config::option<config::node_t>& config) -> sink::asynchronous_t::elastic_t {
+    sink::asynchronous_t::elastic_t elastic;
+    elastic.segments = config["segments"].to_uint64().get_value_or(elastic.segments);
+    elastic.idle = std::chrono::milliseconds(config["idle"].to_uint64()
+        .get_value_or(static_cast<std::uint64_t>(elastic.idle.count())));
+
+    return elastic;
+}
+
+}  // namespace
 
 auto factory<sink::asynchronous_t>::type() const noexcept -> const char* {
     return "asynchronous";
@@ -18,22 +292,111 @@ auto factory<sink::asynchronous_t>::type() const noexcept -> const char* {
 auto factory<sink::asynchronous_t>::from(const config::node_t& config) const ->
     std::unique_ptr<sink_t>
 {
-    auto type = config["sink"]["type"].to_string();
+    const auto numa = config["numa"].to_bool().get_value_or(false);
 
-    if (!type) {
+    if (!config["sink"]["type"].to_string() && !(numa && config["sinks"].unwrap())) {
         throw std::invalid_argument("\"sink\" field with \"type\" is required");
     }
 
-    auto factory = registry.sink(type.get());
-
     auto factor = config["factor"].to_uint64().get();
-    auto overflow = sink::overflow_policy_factory_t().create(config["overflow"].to_string().get());
+    auto batch = config["batch"].to_uint64()
+        .get_value_or(sink::asynchronous_t::default_batch);
+    auto mode = mode_from(config["mode"].to_string().get_value_or("queue"));
+    auto lanes = config["lanes"].to_uint64().get_value_or(1);
+    auto sharding = sharding_from(config["sharding"].to_string().get_value_or("thread"));
+    auto ordered = config["ordered"].to_bool().get_value_or(false);
+
+    const auto consumer = consumer_from(config["thread"]);
+    auto executor = executor_from(config["executor"]);
+    const auto paging = paging_from(config["memory"]);
+    const auto fairness = fairness_from(config["fairness"]);
+    const auto expiry = expiry_from(config["expiry"]);
+    const auto flush_through = flush_through_from(config["flush_through"]);
+    const auto elastic = elastic_from(config["elastic"]);
+
+    // Policies are owned by the sink, so each node sink in NUMA mode creates its own ones.
+    const auto build = [&](std::unique_ptr<sink_t> sink, const sink::asynchronous_t::consumer_t&
+        consumer) -> std::unique_ptr<sink_t>
+    {
+        auto overflow = overflow_from(config["overflow"]);
+        auto underflow = sink::underflow_policy_factory_t().create(config["underflow"].to_string()
+            .get_value_or("wait"));
+
+        std::vector<sink::asynchronous_t::priority_t> priorities;
+        config["priorities"].each([&](const config::node_t& priority) {
+            const auto threshold = priority["threshold"].to_sint64();
+            if (!threshold) {
+                throw std::invalid_argument("each priority lane must have a \"threshold\"");
+            }
+
+            std::unique_ptr<sink::overflow_policy_t> policy;
+            if (priority["overflow"].unwrap()) {
+                policy = overflow_from(priority["overflow"]);
+            }
+
+            priorities.push_back({threshold.get(),
+                priority["factor"].to_uint64().get_value_or(factor), std::move(policy)});
+        });
+
+        auto exception = exception_from(config["exception"], registry);
+
+        return std::unique_ptr<sink_t>(new sink::asynchronous_t(std::move(sink), factor,
+            std::move(overflow), std::move(underflow), batch, mode, lanes, sharding, ordered,
+            std::move(priorities), consumer, executor, std::move(exception), paging, fairness,
+            expiry, false, flush_through, elastic));
+    };
+
+    const auto make = [&](const config::node_t& config) -> std::unique_ptr<sink_t> {
+        const auto type = config["type"].to_string();
+        if (!type) {
+            throw std::invalid_argument("each sink must have a \"type\"");
+        }
+
+        return registry.sink(type.get())(config);
+    };
+
+    if (!numa) {
+        // It's safe to unwrap here, because we've already checked that there is "sink" child and
+        // it's an object.
+        return build(make(*config["sink"].unwrap()), consumer);
+    }
+
+    // Node sinks are either built from the "sinks" list in the order of node ids or share the
+    // single destination.
+    std::size_t sinks = 0;
+    config["sinks"].each([&](const config::node_t&) {
+        ++sinks;
+    });
+
+    std::shared_ptr<sink_t> shared;
+    if (sinks == 0) {
+        shared = make(*config["sink"].unwrap());
+    }
+
+    auto nodes = sink::numa_t::topology();
+    if (sinks != 0 && sinks < nodes.size()) {
+        throw std::invalid_argument("\"sinks\" must have a sink for each of " +
+            std::to_string(nodes.size()) + " NUMA nodes");
+    }
+
+    std::size_t id = 0;
+    return std::unique_ptr<sink_t>(new sink::numa_t(std::move(nodes),
+        [&](const sink::numa_t::node_t& node) -> std::unique_ptr<sink_t> {
+            auto local = consumer;
+            if (local.cpus.empty()) {
+                local.cpus = node.cpus;
+            }
+
+            if (local.node < 0) {
+                local.node = node.id;
+            }
 
-    // It's safe to unwrap here, because we've already checked that there is "sink" child and it's
-    // an object.
-    auto sink = factory(*config["sink"].unwrap());
+            auto sink = shared ? sink::numa_t::share(shared) :
+                make(*config["sinks"][id].unwrap());
+            ++id;
 
-    return std::unique_ptr<sink_t>(new sink::asynchronous_t(std::move(sink), factor, std::move(overflow)));
+            return build(std::move(sink), local);
+        }, shared));
 }
 
 }  // namespace v1
@@ -1,14 +1,54 @@
 #include "blackhole/detail/sink/asynchronous.hpp"
 
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <climits>
 #include <cmath>
+#include <cstring>
 #include <condition_variable>
+#include <deque>
+#include <future>
+#include <limits>
 #include <mutex>
+#include <system_error>
+
+#include <pthread.h>
+
+#ifdef __linux__
+#include <sched.h>
+#include <sys/eventfd.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <boost/variant/apply_visitor.hpp>
+
+#include "blackhole/attribute.hpp"
+#include "blackhole/attributes.hpp"
+#include "blackhole/clock.hpp"
+#include "blackhole/cputime.hpp"
+#include "blackhole/extensions/writer.hpp"
+#include "blackhole/pressure.hpp"
+#include "blackhole/record.hpp"
+#include "blackhole/stage.hpp"
+
+#include "blackhole/detail/attribute.hpp"
+#include "blackhole/detail/budget.hpp"
+#include "blackhole/detail/cputime.hpp"
+#include "blackhole/detail/probe.hpp"
+#include "blackhole/detail/process.hpp"
+#include "blackhole/detail/stage.hpp"
 
 namespace blackhole {
 inline namespace v1 {
 namespace sink {
 namespace {
 
+/// Ring bytes reserved per queue item, which is enough for an average record to fit.
+constexpr std::size_t ring_slot = 256;
+
 auto exp2(std::size_t factor) -> std::size_t {
     if (factor > 20) {
         throw std::invalid_argument("factor should fit in [0; 20] range");
@@ -17,8 +57,418 @@ auto exp2(std::size_t factor) -> std::size_t {
     return static_cast<std::size_t>(std::exp2(factor));
 }
 
+auto positive(std::size_t lanes) -> std::size_t {
+    if (lanes == 0) {
+        throw std::invalid_argument("lanes count should be positive");
+    }
+
+    return lanes;
+}
+
+/// Returns the number of non-priority lanes, which are either sharded or fair ones.
+auto sharded(std::size_t lanes, const asynchronous_t::fairness_t& fairness) -> std::size_t {
+    if (fairness.attribute.empty()) {
+        return positive(lanes);
+    }
+
+    if (lanes != 1) {
+        throw std::invalid_argument("fair sharing can't be combined with multiple lanes");
+    }
+
+    if (fairness.buckets == 0) {
+        throw std::invalid_argument("fair sharing requires at least one bucket");
+    }
+
+    if (fairness.quantum == 0) {
+        throw std::invalid_argument("fair sharing quantum should be positive");
+    }
+
+    for (const auto& share : fairness.shares) {
+        if (share.weight == 0) {
+            throw std::invalid_argument("fair share weights should be positive");
+        }
+    }
+
+    if (fairness.weight == 0) {
+        throw std::invalid_argument("fair share weights should be positive");
+    }
+
+    return fairness.shares.size() + fairness.buckets;
+}
+
+/// Returns values of fair shares in ascending order, paired with lane indices.
+auto shares(const asynchronous_t::fairness_t& fairness, std::size_t offset) ->
+    std::vector<std::pair<std::string, std::size_t>>
+{
+    std::vector<std::pair<std::string, std::size_t>> result;
+    for (std::size_t id = 0; id < fairness.shares.size(); ++id) {
+        result.emplace_back(fairness.shares[id].value, offset + id);
+    }
+
+    std::sort(result.begin(), result.end());
+
+    for (std::size_t id = 1; id < result.size(); ++id) {
+        if (result[id].first == result[id - 1].first) {
+            throw std::invalid_argument("fair share \"" + result[id].first + "\" is duplicated");
+        }
+    }
+
+    return result;
+}
+
+/// Returns weights of fair lanes, which are shares followed by buckets.
+auto weights(const asynchronous_t::fairness_t& fairness) -> std::vector<std::size_t> {
+    std::vector<std::size_t> result;
+    for (const auto& share : fairness.shares) {
+        result.push_back(share.weight);
+    }
+
+    result.insert(result.end(), fairness.buckets, fairness.weight);
+
+    return result;
+}
+
+/// Returns the maximum number of records taken from each lane per batch. The batch is split
+/// between fair lanes by their weights, while other lanes get the same quota.
+auto limits(std::size_t lanes, std::size_t quota, std::size_t batch,
+    const asynchronous_t::fairness_t& fairness) -> std::vector<std::size_t>
+{
+    if (fairness.attribute.empty()) {
+        return std::vector<std::size_t>(lanes, quota);
+    }
+
+    const auto weights = sink::weights(fairness);
+
+    std::size_t total = 0;
+    for (auto weight : weights) {
+        total += weight;
+    }
+
+    std::vector<std::size_t> result(lanes - weights.size(), quota);
+    for (auto weight : weights) {
+        result.push_back(std::max<std::size_t>(batch * weight / total, 1));
+    }
+
+    return result;
+}
+
+auto quanta(std::size_t lanes, const asynchronous_t::fairness_t& fairness) ->
+    std::vector<std::int64_t>
+{
+    if (fairness.attribute.empty()) {
+        return std::vector<std::int64_t>(lanes, 0);
+    }
+
+    const auto weights = sink::weights(fairness);
+
+    std::vector<std::int64_t> result(lanes - weights.size(), 0);
+    for (auto weight : weights) {
+        result.push_back(static_cast<std::int64_t>(weight * fairness.quantum));
+    }
+
+    return result;
+}
+
+auto total(const std::vector<std::size_t>& values) -> std::size_t {
+    std::size_t result = 0;
+    for (auto value : values) {
+        result += value;
+    }
+
+    return result;
+}
+
+/// Returns the value of an attribute keying fair shares, formatting non-string values into the
+/// given writer.
+class share_visitor_t : public boost::static_visitor<string_view> {
+    writer_t& writer;
+
+public:
+    explicit share_visitor_t(writer_t& writer) noexcept :
+        writer(writer)
+    {}
+
+    auto operator()(std::nullptr_t) const -> string_view {
+        return string_view("null", 4);
+    }
+
+    auto operator()(bool value) const -> string_view {
+        return value ? string_view("true", 4) : string_view("false", 5);
+    }
+
+    template<typename T>
+    auto operator()(T value) const -> string_view {
+        writer.inner << value;
+        return writer.result();
+    }
+
+    auto operator()(const string_view& value) const -> string_view {
+        return value;
+    }
+
+    auto operator()(const attribute::view_t::function_type& value) const -> string_view {
+        value(writer);
+        return writer.result();
+    }
+};
+
+/// Returns capacities of priority lanes followed by the given number of sharded lanes.
+auto capacities(std::size_t factor, std::size_t lanes,
+    const std::vector<asynchronous_t::priority_t>& priorities) -> std::vector<std::size_t>
+{
+    std::vector<std::size_t> result;
+
+    for (std::size_t id = 0; id < priorities.size(); ++id) {
+        if (id > 0 && priorities[id].threshold >= priorities[id - 1].threshold) {
+            throw std::invalid_argument("priority lanes thresholds should be strictly descending");
+        }
+
+        result.push_back(exp2(priorities[id].factor));
+    }
+
+    result.insert(result.end(), positive(lanes), exp2(factor));
+
+    return result;
+}
+
+auto check(int rc, const char* what) -> void {
+    if (rc != 0) {
+        throw std::system_error(rc, std::system_category(), what);
+    }
+}
+
+/// Binds memory allocated by the calling thread to the given NUMA node while alive, restoring the
+/// previous memory policy after. Does nothing for negative nodes.
+///
+/// Pages are bound on the first touch, so the memory must be initialized within the scope.
+class mempolicy_t {
+#ifdef __linux__
+    // See <linux/mempolicy.h>.
+    static constexpr int bind = 2;
+
+    typedef std::array<unsigned long, 16> mask_type;
+    static constexpr unsigned long bits = sizeof(mask_type) * CHAR_BIT;
+
+    int mode;
+    mask_type mask;
+#endif
+    bool active;
+
+public:
+    explicit mempolicy_t(int node) :
+        active(node >= 0)
+    {
+        if (!active) {
+            return;
+        }
+
+#ifdef __linux__
+        if (static_cast<unsigned long>(node) >= bits) {
+            throw std::invalid_argument("NUMA node is out of range");
+        }
+
+        // The kernel expects the number of mask bits plus one.
+        if (::syscall(SYS_get_mempolicy, &mode, mask.data(), bits + 1, nullptr, 0) != 0) {
+            throw std::system_error(errno, std::system_category(), "failed to get memory policy");
+        }
+
+        mask_type nodes{};
+        nodes[node / (sizeof(unsigned long) * CHAR_BIT)] |=
+            1ul << (node % (sizeof(unsigned long) * CHAR_BIT));
+
+        if (::syscall(SYS_set_mempolicy, bind, nodes.data(), bits + 1) != 0) {
+            throw std::system_error(errno, std::system_category(), "failed to bind memory policy");
+        }
+#else
+        throw std::invalid_argument("NUMA node binding is supported on linux only");
+#endif
+    }
+
+    mempolicy_t(const mempolicy_t& other) = delete;
+    auto operator=(const mempolicy_t& other) -> mempolicy_t& = delete;
+
+    ~mempolicy_t() {
+#ifdef __linux__
+        if (active) {
+            ::syscall(SYS_set_mempolicy, mode, mask.data(), bits + 1);
+        }
+#endif
+    }
+};
+
+/// Applies the given properties to the calling thread.
+auto configure(const asynchronous_t::consumer_t& consumer) -> void {
+    typedef asynchronous_t::consumer_t::policy_t policy_t;
+
+    if (!consumer.name.empty()) {
+#ifdef __linux__
+        // Longer names are rejected instead of being truncated.
+        const auto name = consumer.name.substr(0, 15);
+        check(::pthread_setname_np(::pthread_self(), name.c_str()), "failed to set thread name");
+#elif __APPLE__
+        check(::pthread_setname_np(consumer.name.c_str()), "failed to set thread name");
+#endif
+        detail::this_thread::invalidate_names();
+    }
+
+#ifdef __linux__
+    if (!consumer.cpus.empty()) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+
+        for (auto cpu : consumer.cpus) {
+            if (cpu < 0 || cpu >= CPU_SETSIZE) {
+                throw std::invalid_argument("CPU ids should fit in [0; CPU_SETSIZE) range");
+            }
+
+            CPU_SET(cpu, &set);
+        }
+
+        check(::pthread_setaffinity_np(::pthread_self(), sizeof(set), &set),
+            "failed to set thread affinity");
+    }
+
+    if (consumer.policy != policy_t::other) {
+        sched_param param{};
+        param.sched_priority = 0;
+
+        check(::pthread_setschedparam(::pthread_self(),
+            consumer.policy == policy_t::batch ? SCHED_BATCH : SCHED_IDLE, &param),
+            "failed to set thread scheduling policy");
+    }
+
+    // Nice values are per thread on linux, unlike POSIX says.
+    if (consumer.nice != 0) {
+        const auto tid = static_cast<id_t>(detail::this_thread::lwp());
+        if (::setpriority(PRIO_PROCESS, tid, consumer.nice) != 0) {
+            throw std::system_error(errno, std::system_category(),
+                "failed to set thread nice value");
+        }
+    }
+#else
+    if (!consumer.cpus.empty() || consumer.policy != policy_t::other || consumer.nice != 0) {
+        throw std::invalid_argument("thread affinity and scheduling are supported on linux only");
+    }
+#endif
+}
+
+/// Starts a thread with the given properties running the given function, waiting until it has
+/// applied them.
+///
+/// \throw std::system_error or std::invalid_argument rethrown from the thread if properties can't
+/// be applied, in which case the thread is already joined.
+auto spawn(const asynchronous_t::consumer_t& consumer, std::function<auto() -> void> fn) ->
+    std::thread
+{
+    std::promise<void> started;
+    auto future = started.get_future();
+
+    // The thread configures itself, which reports the failure back to the caller.
+    std::thread thread([consumer](std::promise<void> started, std::function<auto() -> void> fn) {
+        try {
+            configure(consumer);
+        } catch (...) {
+            started.set_exception(std::current_exception());
+            return;
+        }
+
+        started.set_value();
+        fn();
+    }, std::move(started), std::move(fn));
+
+    try {
+        future.get();
+    } catch (...) {
+        thread.join();
+        throw;
+    }
+
+    return thread;
+}
+
+template<typename T, typename... Args>
+auto make_lanes(bool enabled, const std::vector<std::size_t>& capacities, std::size_t scale,
+    int node, const Args&... args) -> std::vector<std::unique_ptr<T>>
+{
+    std::vector<std::unique_ptr<T>> lanes;
+
+    if (!enabled) {
+        return lanes;
+    }
+
+    const mempolicy_t policy(node);
+
+    lanes.reserve(capacities.size());
+
+    for (auto capacity : capacities) {
+        lanes.emplace_back(new T(capacity * scale, args...));
+    }
+
+    return lanes;
+}
+
+auto thresholds(const std::vector<asynchronous_t::priority_t>& priorities) ->
+    std::vector<std::int64_t>
+{
+    std::vector<std::int64_t> result;
+    for (const auto& priority : priorities) {
+        result.push_back(priority.threshold);
+    }
+
+    return result;
+}
+
+auto policies(std::vector<asynchronous_t::priority_t> priorities) ->
+    std::vector<std::unique_ptr<overflow_policy_t>>
+{
+    std::vector<std::unique_ptr<overflow_policy_t>> result;
+    for (auto& priority : priorities) {
+        result.push_back(std::move(priority.overflow_policy));
+    }
+
+    return result;
+}
+
+/// Maximum number of batches an executor thread drains from a single sink in a row, which keeps
+/// busy sinks from starving others.
+constexpr std::size_t rounds = 16;
+
+/// Record reserved for the region lent by an asynchronous sink on the current thread, which is
+/// formatted into it until committed or cancelled.
+struct loan_t {
+    const asynchronous_t* sink;
+    shared_record_t value;
+};
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wglobal-constructors"
+#pragma clang diagnostic ignored "-Wexit-time-destructors"
+
+thread_local loan_t loan;
+
+#pragma clang diagnostic pop
+
 }  // namespace
 
+auto overflow_policy_t::overflow() -> action_t {
+    return action_t::drop;
+}
+
+auto overflow_policy_t::resolve(const record_t&, const enqueue_type& enqueue) -> bool {
+    while (true) {
+        switch (overflow()) {
+        case action_t::retry:
+            if (enqueue()) {
+                return true;
+            }
+
+            continue;
+        case action_t::drop:
+            return false;
+        }
+    }
+}
+
 class drop_overflow_policy_t : public overflow_policy_t {
     typedef overflow_policy_t::action_t action_t;
 
@@ -52,6 +502,62 @@ public:
     }
 };
 
+/// Blocks producers on an event count until the consumer dequeues a batch, dropping records that
+/// didn't fit during the timeout.
+///
+/// Enqueueing is retried after preparing to wait, so the wakeup can't be missed, and producers
+/// only pay for it when the queue is actually full.
+class timeout_overflow_policy_t : public overflow_policy_t {
+    std::chrono::milliseconds timeout;
+    eventcount_t event;
+
+public:
+    explicit timeout_overflow_policy_t(std::chrono::milliseconds timeout) :
+        timeout(timeout)
+    {}
+
+    virtual auto resolve(const record_t&, const enqueue_type& enqueue) -> bool {
+        const auto deadline = std::chrono::steady_clock::now() + timeout;
+
+        while (true) {
+            const auto key = event.prepare();
+
+            if (enqueue()) {
+                event.cancel();
+                return true;
+            }
+
+            if (!event.wait_until(key, deadline)) {
+                return false;
+            }
+        }
+    }
+
+    virtual auto wakeup() -> void {
+        event.notify();
+    }
+};
+
+/// Drops records with severity below the threshold as soon as the queue is full, letting more
+/// important ones to wait for the room.
+class severity_overflow_policy_t : public timeout_overflow_policy_t {
+    std::int64_t threshold;
+
+public:
+    severity_overflow_policy_t(std::int64_t threshold, std::chrono::milliseconds timeout) :
+        timeout_overflow_policy_t(timeout),
+        threshold(threshold)
+    {}
+
+    virtual auto resolve(const record_t& record, const enqueue_type& enqueue) -> bool {
+        if (record.severity() < threshold) {
+            return false;
+        }
+
+        return timeout_overflow_policy_t::resolve(record, enqueue);
+    }
+};
+
 auto overflow_policy_factory_t::create(const std::string& name) const ->
     std::unique_ptr<overflow_policy_t>
 {
@@ -64,82 +570,1301 @@ auto overflow_policy_factory_t::create(const std::string& name) const ->
     throw std::invalid_argument("no overflow policy with name \"" + name + "\" found");
 }
 
-asynchronous_t::asynchronous_t(std::unique_ptr<sink_t> wrapped, std::size_t factor) :
-    queue(exp2(factor)),
-    stopped(false),
-    wrapped(std::move(wrapped)),
-    overflow_policy(new wait_overflow_policy_t),
-    thread(std::bind(&asynchronous_t::run, this))
-{}
-
-asynchronous_t::asynchronous_t(std::unique_ptr<sink_t> sink,
-                               std::size_t factor,
-                               std::unique_ptr<overflow_policy_t> overflow_policy) :
-    queue(exp2(factor)),
-    stopped(false),
-    wrapped(std::move(sink)),
-    overflow_policy(std::move(overflow_policy)),
-    thread(std::bind(&asynchronous_t::run, this))
-{}
+auto overflow_policy_factory_t::timeout(std::chrono::milliseconds timeout) const ->
+    std::unique_ptr<overflow_policy_t>
+{
+    return std::unique_ptr<overflow_policy_t>(new timeout_overflow_policy_t(timeout));
+}
 
-asynchronous_t::~asynchronous_t() {
-    stopped.store(true);
-    thread.join();
+auto overflow_policy_factory_t::severity(std::int64_t threshold,
+    std::chrono::milliseconds timeout) const -> std::unique_ptr<overflow_policy_t>
+{
+    return std::unique_ptr<overflow_policy_t>(new severity_overflow_policy_t(threshold, timeout));
 }
 
-auto asynchronous_t::emit(const record_t& record, const string_view& message) -> void {
-    while (true) {
-        // TODO: Uncomment.
-        // switch (filter->filter(record, message)) {
-        // case filter_t::accept:
-        // case filter_t::neutral:
-        //     break;
-        // case filter_t::reject:
-        //     return;
-        // }
-
-        const auto enqueued = queue.enqueue_with([&](value_type& value) {
-            value = {recordbuf_t(record), message.to_string()};
-        });
+/// Legacy underflow policy, which just sleeps for a millisecond when there is nothing to consume.
+class sleep_underflow_policy_t : public underflow_policy_t {
+public:
+    virtual auto underflow(const predicate_type&) -> void {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
 
-        if (enqueued) {
-            // TODO: underflow_policy->wakeup();
-            return;
-        } else {
-            switch (overflow_policy->overflow()) {
-            case overflow_policy_t::action_t::retry:
-                continue;
-            case overflow_policy_t::action_t::drop:
+    /// Does nothing on wakeup.
+    virtual auto wakeup() -> void {}
+};
+
+/// Spins for a while waiting for new records to come and parks the consumer thread on an event
+/// count after that.
+///
+/// Producers only pay for the wakeup when the consumer is actually parked, i.e. on the queue
+/// empty to non-empty transition.
+class wait_underflow_policy_t : public underflow_policy_t {
+    /// Number of yielding spins before parking.
+    static constexpr int spins = 64;
+
+    eventcount_t event;
+
+public:
+    virtual auto underflow(const predicate_type& ready) -> void {
+        for (int i = 0; i < spins; ++i) {
+            if (ready()) {
                 return;
             }
+
+            std::this_thread::yield();
         }
-    }
-}
 
-auto asynchronous_t::run() -> void {
-    while (true) {
-        value_type result;
-        const auto dequeued = queue.dequeue_with([&](value_type& value) {
-            result = std::move(value);
-        });
+        const auto key = event.prepare();
 
-        if (stopped && !dequeued) {
-            return;
+        if (ready()) {
+            event.cancel();
+        } else {
+            event.wait(key);
         }
+    }
 
-        if (dequeued) {
-            try {
-                wrapped->emit(result.record.into_view(), result.message);
-                overflow_policy->wakeup();
-            } catch (...) {
-                throw;
-                // TODO: exception_policy->process();
-            }
+    virtual auto underflow_until(const predicate_type& ready,
+                                 std::chrono::steady_clock::time_point deadline) -> void
+    {
+        const auto key = event.prepare();
+
+        if (ready()) {
+            event.cancel();
         } else {
-            std::this_thread::sleep_for(std::chrono::milliseconds(1));
-            // TODO: underflow_policy->underflow(); [wait for enqueue, sleep].
+            event.wait_until(key, deadline);
         }
     }
+
+    virtual auto wakeup() -> void {
+        event.notify();
+    }
+};
+
+auto underflow_policy_t::underflow_until(const predicate_type& ready,
+                                         std::chrono::steady_clock::time_point) -> void
+{
+    underflow(ready);
+}
+
+auto underflow_policy_factory_t::create(const std::string& name) const ->
+    std::unique_ptr<underflow_policy_t>
+{
+    if (name == "sleep") {
+        return std::unique_ptr<underflow_policy_t>(new sleep_underflow_policy_t);
+    } else if (name == "wait") {
+        return std::unique_ptr<underflow_policy_t>(new wait_underflow_policy_t);
+    }
+
+    throw std::invalid_argument("no underflow policy with name \"" + name + "\" found");
+}
+
+auto exception_policy_t::flush(std::chrono::steady_clock::time_point) -> bool {
+    return true;
+}
+
+class drop_exception_policy_t : public exception_policy_t {
+public:
+    virtual auto handle(sink_t&, const sink_t::event_t*, std::size_t) -> void {}
+};
+
+/// Retries failed batches from a dedicated thread, so they never block the consumer.
+class retry_exception_policy_t : public exception_policy_t {
+    struct batch_t {
+        sink_t* sink;
+        std::vector<recordbuf_t> records;
+        std::vector<std::string> messages;
+    };
+
+    std::size_t attempts;
+    std::chrono::milliseconds backoff;
+    std::size_t capacity;
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<batch_t> batches;
+    /// Number of records in queued batches.
+    std::size_t size;
+    /// Whether a batch is being retried right now.
+    bool busy;
+    bool stopped;
+
+    std::thread thread;
+
+public:
+    retry_exception_policy_t(std::size_t attempts, std::chrono::milliseconds backoff,
+                             std::size_t capacity) :
+        attempts(attempts),
+        backoff(backoff),
+        capacity(capacity),
+        size(0),
+        busy(false),
+        stopped(false),
+        thread(&retry_exception_policy_t::run, this)
+    {}
+
+    ~retry_exception_policy_t() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopped = true;
+        }
+
+        cv.notify_all();
+        thread.join();
+    }
+
+    virtual auto handle(sink_t& sink, const sink_t::event_t* events, std::size_t size) -> void {
+        batch_t batch{&sink, {}, {}};
+        batch.records.reserve(size);
+        batch.messages.reserve(size);
+
+        for (std::size_t id = 0; id < size; ++id) {
+            batch.records.emplace_back(*events[id].record);
+            batch.messages.emplace_back(events[id].message->to_string());
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+
+        if (this->size + size > capacity) {
+            return;
+        }
+
+        this->size += size;
+        batches.emplace_back(std::move(batch));
+        cv.notify_all();
+    }
+
+    virtual auto flush(std::chrono::steady_clock::time_point deadline) -> bool {
+        std::unique_lock<std::mutex> lock(mutex);
+        return cv.wait_until(lock, deadline, [&] {
+            return batches.empty() && !busy;
+        });
+    }
+
+private:
+    auto run() -> void {
+        std::unique_lock<std::mutex> lock(mutex);
+
+        while (true) {
+            cv.wait(lock, [&] {
+                return stopped || !batches.empty();
+            });
+
+            if (stopped) {
+                return;
+            }
+
+            auto batch = std::move(batches.front());
+            batches.pop_front();
+            size -= batch.records.size();
+            busy = true;
+
+            lock.unlock();
+            retry(batch, lock);
+            lock.lock();
+
+            busy = false;
+            cv.notify_all();
+        }
+    }
+
+    /// Retries the given batch, sleeping on the given unlocked lock between attempts, so the
+    /// destruction interrupts the backoff.
+    auto retry(const batch_t& batch, std::unique_lock<std::mutex>& lock) -> void {
+        std::vector<record_t> records;
+        std::vector<string_view> messages;
+        std::vector<sink_t::event_t> events;
+
+        for (std::size_t id = 0; id < batch.records.size(); ++id) {
+            records.emplace_back(batch.records[id].into_view());
+            messages.emplace_back(batch.messages[id]);
+        }
+
+        for (std::size_t id = 0; id < records.size(); ++id) {
+            events.push_back({&records[id], &messages[id]});
+        }
+
+        auto delay = backoff;
+
+        for (std::size_t attempt = 0; attempt < attempts; ++attempt) {
+            lock.lock();
+            const auto interrupted = cv.wait_for(lock, delay, [&] {
+                return stopped;
+            });
+            lock.unlock();
+
+            if (interrupted) {
+                return;
+            }
+
+            try {
+                batch.sink->emit_batch(events.data(), events.size());
+                return;
+            } catch (...) {
+                delay *= 2;
+            }
+        }
+    }
+};
+
+class fallback_exception_policy_t : public exception_policy_t {
+    std::unique_ptr<sink_t> sink;
+
+public:
+    explicit fallback_exception_policy_t(std::unique_ptr<sink_t> sink) :
+        sink(std::move(sink))
+    {}
+
+    virtual auto handle(sink_t&, const sink_t::event_t* events, std::size_t size) -> void {
+        sink->emit_batch(events, size);
+    }
+
+    virtual auto flush(std::chrono::steady_clock::time_point deadline) -> bool {
+        return sink->flush(deadline);
+    }
+};
+
+auto exception_policy_factory_t::create(const std::string& name) const ->
+    std::unique_ptr<exception_policy_t>
+{
+    if (name == "drop") {
+        return std::unique_ptr<exception_policy_t>(new drop_exception_policy_t);
+    }
+
+    throw std::invalid_argument("no exception policy with name \"" + name + "\" found");
+}
+
+auto exception_policy_factory_t::retry(std::size_t attempts, std::chrono::milliseconds backoff,
+    std::size_t capacity) const -> std::unique_ptr<exception_policy_t>
+{
+    return std::unique_ptr<exception_policy_t>(
+        new retry_exception_policy_t(attempts, backoff, capacity));
+}
+
+auto exception_policy_factory_t::fallback(std::unique_ptr<sink_t> sink) const ->
+    std::unique_ptr<exception_policy_t>
+{
+    if (!sink) {
+        throw std::invalid_argument("fallback sink must not be null");
+    }
+
+    return std::unique_ptr<exception_policy_t>(new fallback_exception_policy_t(std::move(sink)));
+}
+
+constexpr std::size_t asynchronous_t::default_batch;
+
+asynchronous_t::asynchronous_t(std::unique_ptr<sink_t> wrapped, std::size_t factor) :
+    asynchronous_t(std::move(wrapped), factor, std::unique_ptr<overflow_policy_t>(new wait_overflow_policy_t))
+{}
+
+asynchronous_t::asynchronous_t(std::unique_ptr<sink_t> sink,
+                               std::size_t factor,
+                               std::unique_ptr<overflow_policy_t> overflow_policy) :
+    asynchronous_t(std::move(sink),
+                   factor,
+                   std::move(overflow_policy),
+                   std::unique_ptr<underflow_policy_t>(new wait_underflow_policy_t))
+{}
+
+asynchronous_t::asynchronous_t(std::unique_ptr<sink_t> sink,
+                               std::size_t factor,
+                               std::unique_ptr<overflow_policy_t> overflow_policy,
+                               std::unique_ptr<underflow_policy_t> underflow_policy,
+                               std::size_t batch,
+                               mode_t mode,
+                               std::size_t lanes,
+                               sharding_t sharding,
+                               bool ordered,
+                               std::vector<priority_t> priorities,
+                               consumer_t consumer,
+                               std::shared_ptr<executor_t> executor,
+                               std::unique_ptr<exception_policy_t> exception_policy,
+                               detail::paging_t paging,
+                               fairness_t fairness,
+                               expiry_t expiry,
+                               bool pumped,
+                               flush_through_t flush_through,
+                               elastic_t elastic) :
+    queues(make_lanes<queue_type>(mode == mode_t::queue,
+        capacities(factor, sharded(lanes, fairness), priorities), 1, consumer.node,
+        elastic.segments, elastic.idle)),
+    rings(make_lanes<ring_t>(mode == mode_t::ring,
+        capacities(factor, sharded(lanes, fairness), priorities), ring_slot, consumer.node,
+        paging)),
+    thresholds(sink::thresholds(priorities)),
+    policies(sink::policies(std::move(priorities))),
+    sharding(sharding),
+    ordered(ordered),
+    attribute(fairness.attribute),
+    shares(sink::shares(fairness, thresholds.size())),
+    buckets(fairness.buckets),
+    quanta(sink::quanta(queues.size() + rings.size(), fairness)),
+    deficits(quanta.size(), 0),
+    stopped(false),
+    abandoned(false),
+    wrapped(std::move(sink)),
+    exception_policy(exception_policy ?
+        std::move(exception_policy) :
+        exception_policy_factory_t().create("drop")),
+    overflow_policy(std::move(overflow_policy)),
+    underflow_policy(std::move(underflow_policy)),
+    batch(std::max<std::size_t>(batch, 1)),
+    expiry(expiry),
+    flush_through(flush_through),
+    elastic(elastic),
+    issued(0),
+    flushed(0),
+    quota(std::max<std::size_t>(this->batch / (queues.size() + rings.size()), 1)),
+    executor(std::move(executor)),
+    scheduled(false),
+    event(-1)
+{
+    limits = sink::limits(queues.size() + rings.size(), quota, this->batch, fairness);
+
+    if (mode == mode_t::ring) {
+        decoded.reset(new ring::decoded_t[total(limits)]);
+    }
+
+    // Queue cells are allocated by the queue itself, initializing them on construction.
+    if (mode != mode_t::ring && paging.enabled()) {
+        throw std::invalid_argument("memory paging properties are supported in ring mode only");
+    }
+
+    // Rings are preallocated buffers of variable-length slots, which can't be chained.
+    if (mode == mode_t::ring && elastic.segments != 1) {
+        throw std::invalid_argument("elastic lanes are supported in queue mode only");
+    }
+
+    if (!rings.empty()) {
+        registration.reset(new detail::crash::registration_t([](const void* context, int fd) {
+            for (const auto& ring : static_cast<const asynchronous_t*>(context)->rings) {
+                ring->visit([](const ring_t::slot_t& slot, void* fd) {
+                    ring::dump(slot, *static_cast<int*>(fd));
+                }, &fd);
+            }
+        }, this));
+    }
+
+    if (pumped && this->executor) {
+        throw std::invalid_argument("pumped sinks can't be drained by an executor");
+    }
+
+    if (!this->executor && !pumped) {
+        thread = spawn(consumer, [this] { run(); });
+        return;
+    }
+
+    if (!consumer.name.empty() || !consumer.cpus.empty() ||
+        consumer.policy != consumer_t::policy_t::other || consumer.nice != 0)
+    {
+        throw std::invalid_argument(pumped ?
+            "pumped sinks have no consumer thread to set properties of" :
+            "consumer thread properties of sinks drained by an executor must be set on the "
+            "executor");
+    }
+
+    if (pumped) {
+#ifdef __linux__
+        event = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+#else
+        errno = ENOSYS;
+#endif
+        if (event < 0) {
+            throw std::system_error(errno, std::system_category(), "failed to create eventfd");
+        }
+    }
+}
+
+asynchronous_t::~asynchronous_t() {
+    stop();
+
+    if (event >= 0) {
+        ::close(event);
+    }
+}
+
+auto asynchronous_t::flush(std::chrono::steady_clock::time_point deadline) -> bool {
+    while (true) {
+        if (event >= 0) {
+            // Unless the event loop is pumping the sink right now, nobody else drains it.
+            pump(std::numeric_limits<std::size_t>::max(), deadline);
+        }
+
+        const auto key = completed.prepare();
+
+        if (idle()) {
+            completed.cancel();
+            break;
+        }
+
+        if (!completed.wait_until(key, deadline)) {
+            return false;
+        }
+    }
+
+    return exception_policy->flush(deadline) && wrapped->flush(deadline);
+}
+
+auto asynchronous_t::shutdown(std::chrono::steady_clock::time_point deadline) -> bool {
+    const auto flushed = flush(deadline);
+
+    if (!flushed) {
+        abandoned.store(true);
+    }
+
+    stop();
+
+    return flushed;
+}
+
+auto asynchronous_t::stop() -> void {
+    stopped.store(true);
+
+    if (thread.joinable()) {
+        underflow_policy->wakeup();
+        thread.join();
+    }
+
+    if (executor) {
+        // Once detached the sink is owned by the calling thread exclusively, which drains it.
+        executor->detach(this);
+        executor.reset();
+
+        while (!abandoned && drain() > 0) {
+            complete();
+        }
+    }
+
+    if (event >= 0) {
+        // Waits for the event loop to finish pumping, the rest is drained by the calling thread.
+        std::lock_guard<std::mutex> lock(pumping);
+
+        while (!abandoned && drain() > 0) {
+            complete();
+        }
+    }
+}
+
+auto asynchronous_t::descriptor() const noexcept -> int {
+    return event;
+}
+
+auto asynchronous_t::pump(std::size_t limit, std::chrono::steady_clock::time_point deadline) ->
+    std::size_t
+{
+    if (event < 0) {
+        throw std::logic_error("sink is not pumped");
+    }
+
+    std::unique_lock<std::mutex> lock(pumping, std::try_to_lock);
+    if (!lock.owns_lock()) {
+        return 0;
+    }
+
+    // Producers don't signal the descriptor until the sink is unscheduled below, so it's reset
+    // once here. It may be not signalled at all when pumped by flushing.
+    std::uint64_t value;
+    const auto rc = ::read(event, &value, sizeof(value));
+    (void)rc;
+
+    std::size_t processed = 0;
+    while (processed < limit && !abandoned) {
+        const auto count = drain();
+
+        if (count == 0) {
+            break;
+        }
+
+        processed += count;
+        complete();
+
+        if (std::chrono::steady_clock::now() >= deadline) {
+            break;
+        }
+    }
+
+    // Pairs with the fence in `schedule` the same way as with executors.
+    scheduled.store(false);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    if (!abandoned && !empty() && !scheduled.exchange(true)) {
+        signal();
+    }
+
+    return processed;
+}
+
+auto asynchronous_t::idle() const -> bool {
+    // Completions are loaded first, so if they catch up with submissions loaded after, there was a
+    // moment with no records in flight, since both counters only grow.
+    const auto completed = emitted.get() + expired.get() + dropped.get();
+    return completed >= submitted.get();
+}
+
+auto asynchronous_t::depth() const -> std::uint64_t {
+    const auto emitted = this->emitted.get() + expired.get();
+    const auto enqueued = this->enqueued.get();
+    return enqueued > emitted ? enqueued - emitted : 0;
+}
+
+auto asynchronous_t::emit(const record_t& record, const string_view& message) -> void {
+    submit(record, message, nullptr);
+}
+
+auto asynchronous_t::emit_gathered(const record_t& record, const string_view* slices,
+                                   std::size_t count) -> void
+{
+    // Ring mode serializes the message together with the record, so it's concatenated anyway.
+    if (queues.empty()) {
+        sink_t::emit_gathered(record, slices, count);
+        return;
+    }
+
+    std::size_t size = 0;
+    for (std::size_t id = 0; id < count; ++id) {
+        size += slices[id].size();
+    }
+
+    // Slices are copied right into the room of the captured record, which is the only copy.
+    auto value = shared_record_t::reserve(record, size);
+    auto data = value.room().data;
+
+    for (std::size_t id = 0; id < count; ++id) {
+        std::memcpy(data, slices[id].data(), slices[id].size());
+        data += slices[id].size();
+    }
+
+    value.complete(size);
+    submit(record, value.message(), &value);
+}
+
+auto asynchronous_t::lend(const record_t& record, std::size_t size) -> region_t {
+    // Ring mode serializes the message together with the record, so there is nothing to lend.
+    if (queues.empty() || stopped.load(std::memory_order_relaxed) || loan.sink != nullptr) {
+        return region_t{nullptr, 0};
+    }
+
+    loan.value = shared_record_t::reserve(record, size);
+    loan.sink = this;
+
+    return loan.value.room();
+}
+
+auto asynchronous_t::commit(const record_t& record, std::size_t size) -> void {
+    auto value = std::move(loan.value);
+    loan.sink = nullptr;
+
+    value.complete(size);
+    submit(record, value.message(), &value);
+}
+
+auto asynchronous_t::cancel() noexcept -> void {
+    loan.value = shared_record_t();
+    loan.sink = nullptr;
+}
+
+auto asynchronous_t::submit(const record_t& record, const string_view& message,
+                            const value_type* captured) -> void
+{
+    if (flush_through.enabled() && record.severity() >= flush_through.threshold) {
+        submit_through(record, message, captured);
+        return;
+    }
+
+    submitted.add();
+
+    try {
+        if (stopped.load(std::memory_order_relaxed) || !push(record, message, captured)) {
+            BLACKHOLE_PROBE(drop, static_cast<int>(record.severity()), message.size());
+            dropped.add();
+            completed.notify();
+        }
+    } catch (...) {
+        dropped.add();
+        completed.notify();
+        throw;
+    }
+}
+
+auto asynchronous_t::submit_through(const record_t& record, const string_view& message,
+                                    const value_type* captured) -> void
+{
+    const auto deadline = std::chrono::steady_clock::now() + flush_through.timeout;
+
+    std::lock_guard<std::mutex> lock(barrier);
+
+    submitted.add();
+
+    auto enqueued = false;
+
+    try {
+        enqueued = !stopped.load(std::memory_order_relaxed) && push(record, message, captured);
+    } catch (...) {
+        dropped.add();
+        completed.notify();
+        throw;
+    }
+
+    // Dropped records never reach the consumer, so there is nothing to wait for.
+    if (!enqueued) {
+        BLACKHOLE_PROBE(drop, static_cast<int>(record.severity()), message.size());
+        dropped.add();
+        completed.notify();
+        return;
+    }
+
+    const auto ticket = ++issued;
+
+    while (flushed.load() < ticket) {
+        if (event >= 0) {
+            pump(std::numeric_limits<std::size_t>::max(), deadline);
+        }
+
+        const auto key = completed.prepare();
+
+        if (flushed.load() >= ticket) {
+            completed.cancel();
+            break;
+        }
+
+        if (!completed.wait_until(key, deadline)) {
+            return;
+        }
+    }
+}
+
+auto asynchronous_t::push(const record_t& record, const string_view& message,
+                          const value_type* captured) -> bool
+{
+    // In ring mode the record is serialized once, retrying only the slot reservation.
+    const auto encoded = rings.empty() ? string_view() : ring::encode(record, message);
+
+    const auto id = lane(record);
+
+    if (!rings.empty() && !rings[id]->fits(encoded.size())) {
+        // Never fits, waiting for space makes no sense.
+        return false;
+    }
+
+    auto& policy = id < policies.size() && policies[id] ? *policies[id] : *overflow_policy;
+
+    // Producers blocked on overflow are released on shutdown, since there is no consumer anymore.
+    auto enqueued = enqueue(id, record, message, encoded, captured);
+
+    if (!enqueued) {
+        BLACKHOLE_PROBE(overflow, static_cast<int>(record.severity()), message.size(),
+            BLACKHOLE_PROBE_ENABLED(overflow) ? depth() : 0);
+
+        enqueued = policy.resolve(record, [&]() -> bool {
+            return stopped.load(std::memory_order_relaxed) ||
+                enqueue(id, record, message, encoded, captured);
+        });
+    }
+
+    if (!enqueued || stopped.load(std::memory_order_relaxed)) {
+        return false;
+    }
+
+    this->enqueued.add();
+
+    if (rings.empty()) {
+        // The consumer stamps the queue residence and the write of sampled records.
+        detail::stage::stamp(detail::stage::id_t::enqueue);
+        detail::stage::defer();
+    }
+
+    BLACKHOLE_PROBE(enqueue, static_cast<int>(record.severity()), message.size(),
+        BLACKHOLE_PROBE_ENABLED(enqueue) ? depth() : 0);
+    schedule();
+
+    return true;
+}
+
+auto asynchronous_t::run() -> void {
+    while (!abandoned) {
+        if (drain() > 0) {
+            complete();
+            continue;
+        }
+
+        if (stopped) {
+            return;
+        }
+
+        const auto ready = [&]() -> bool {
+            return !empty() || stopped;
+        };
+
+        // Draining releases spare segments of lanes idle for long enough, so the consumer thread
+        // wakes up for that even without records.
+        if (spare()) {
+            underflow_policy->underflow_until(ready,
+                std::chrono::steady_clock::now() + elastic.idle);
+        } else {
+            underflow_policy->underflow(ready);
+        }
+    }
+}
+
+auto asynchronous_t::step() -> bool {
+    for (std::size_t round = 0; round < rounds && !abandoned; ++round) {
+        if (drain() == 0) {
+            break;
+        }
+
+        complete();
+    }
+
+    // Pairs with the fence in `schedule`, so either the producer sees the sink unscheduled or the
+    // records it has just enqueued are seen here.
+    scheduled.store(false);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    return !abandoned && !empty() && !scheduled.exchange(true);
+}
+
+auto asynchronous_t::schedule() -> void {
+    if (!executor && event < 0) {
+        underflow_policy->wakeup();
+        return;
+    }
+
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    // Producers only pay for the exchange on the idle to busy transition.
+    if (!scheduled.load(std::memory_order_relaxed) && !scheduled.exchange(true)) {
+        if (executor) {
+            executor->submit(this);
+        } else {
+            signal();
+        }
+    }
+}
+
+auto asynchronous_t::signal() noexcept -> void {
+    // The counter can't overflow, since it's reset before the sink is signalled again.
+    const std::uint64_t value = 1;
+    const auto rc = ::write(event, &value, sizeof(value));
+    (void)rc;
+}
+
+auto asynchronous_t::complete() -> void {
+    // Wake up producers blocked on overflow once per batch instead of once per record.
+    overflow_policy->wakeup();
+
+    for (const auto& policy : policies) {
+        if (policy) {
+            policy->wakeup();
+        }
+    }
+
+    completed.notify();
+}
+
+auto asynchronous_t::lane(const record_t& record) const -> std::size_t {
+    const std::int64_t severity = record.severity();
+
+    for (std::size_t id = 0; id < thresholds.size(); ++id) {
+        if (severity >= thresholds[id]) {
+            return id;
+        }
+    }
+
+    const auto offset = thresholds.size();
+
+    if (!attribute.empty()) {
+        return offset + share(record);
+    }
+
+    const auto count = queues.size() + rings.size() - offset;
+
+    if (count == 1) {
+        return offset;
+    }
+
+#ifdef __linux__
+    if (sharding == sharding_t::cpu) {
+        const auto cpu = ::sched_getcpu();
+
+        if (cpu >= 0) {
+            return offset + static_cast<std::size_t>(cpu) % count;
+        }
+    }
+#endif
+
+    return offset + static_cast<std::size_t>(detail::this_thread::lwp() % count);
+}
+
+auto asynchronous_t::share(const record_t& record) const -> std::size_t {
+    writer_t writer;
+    string_view value;
+
+    const string_view name(attribute.data(), attribute.size());
+
+    // Records without the attribute are treated as ones with an empty value.
+    for (const auto& list : record.attributes()) {
+        const auto& attributes = list.get();
+
+        const auto it = std::find_if(attributes.begin(), attributes.end(),
+            [&](const attribute_list::value_type& attribute) -> bool {
+                return attribute.first == name;
+            });
+
+        if (it != attributes.end()) {
+            value = boost::apply_visitor(share_visitor_t(writer), it->second.inner().value);
+            break;
+        }
+    }
+
+    const auto it = std::lower_bound(shares.begin(), shares.end(), value,
+        [](const std::pair<std::string, std::size_t>& share, const string_view& value) -> bool {
+            return string_view(share.first.data(), share.first.size()) < value;
+        });
+
+    if (it != shares.end() && string_view(it->first.data(), it->first.size()) == value) {
+        return it->second - thresholds.size();
+    }
+
+    return shares.size() + std::hash<string_view>()(value) % buckets;
+}
+
+auto asynchronous_t::credit(std::size_t lane, bool empty) -> bool {
+    if (quanta[lane] == 0) {
+        return true;
+    }
+
+    if (empty) {
+        deficits[lane] = 0;
+        return false;
+    }
+
+    deficits[lane] += quanta[lane];
+    return deficits[lane] > 0;
+}
+
+auto asynchronous_t::settle(std::size_t lane, bool empty) -> void {
+    if (quanta[lane] != 0) {
+        deficits[lane] = empty ? 0 : std::min(deficits[lane], quanta[lane]);
+    }
+}
+
+auto asynchronous_t::enqueue(std::size_t lane,
+                             const record_t& record,
+                             const string_view& message,
+                             const string_view& encoded,
+                             const value_type* captured) -> bool
+{
+    if (!queues.empty()) {
+        if (!detail::budget::admit()) {
+            return false;
+        }
+
+        return queues[lane]->enqueue_with([&](value_type& value) {
+            value = captured ? *captured : shared_record_t::capture(record, message);
+        });
+    }
+
+    auto& ring = *rings[lane];
+    const auto reservation = ring.reserve(encoded.size());
+
+    if (reservation.data == nullptr) {
+        return false;
+    }
+
+    std::memcpy(reservation.data, encoded.data(), encoded.size());
+    ring.commit(reservation);
+
+    return true;
+}
+
+auto asynchronous_t::spare() const -> bool {
+    for (const auto& queue : queues) {
+        if (queue->spare()) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+auto asynchronous_t::empty() const -> bool {
+    for (const auto& queue : queues) {
+        if (!queue->empty()) {
+            return false;
+        }
+    }
+
+    for (const auto& ring : rings) {
+        if (!ring->empty()) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+auto asynchronous_t::drain() -> std::size_t {
+    const detail::cputime::meter_t meter(consumed);
+
+    records.clear();
+    messages.clear();
+    events.clear();
+    runs.clear();
+
+    if (rings.empty()) {
+        drain_queues();
+    } else {
+        drain_rings();
+    }
+
+    const auto processed = records.size();
+
+    if (processed == 0) {
+        return 0;
+    }
+
+    BLACKHOLE_PROBE(dequeue, processed, BLACKHOLE_PROBE_ENABLED(dequeue) ? depth() : 0);
+
+    // Flush-through records are counted before expiration, since expired ones are done with too.
+    std::uint64_t barriers = 0;
+    if (flush_through.enabled()) {
+        for (const auto& record : records) {
+            if (record.severity() >= flush_through.threshold) {
+                ++barriers;
+            }
+        }
+    }
+
+    const auto expired = expiry.max_age.count() > 0 ? expire() : 0;
+    const auto size = records.size();
+
+    for (std::size_t id = 0; id < size; ++id) {
+        events.push_back({&records[id], &messages[id]});
+    }
+
+    if (ordered) {
+        // Merge lane runs by timestamp. The merge is stable and never reorders records within a
+        // single run, so per-lane ordering is kept even if the clock goes backwards.
+        const auto first = events.data();
+
+        for (std::size_t id = 1; id < runs.size(); ++id) {
+            std::inplace_merge(first, first + runs[id - 1], first + runs[id],
+                [](const sink_t::event_t& lhs, const sink_t::event_t& rhs) -> bool {
+                    return lhs.record->timestamp() < rhs.record->timestamp();
+                });
+        }
+    }
+
+    // Sampling is checked once per batch, so unsampled batches cost a single atomic load.
+    const auto sampling = rings.empty() && stage::sampling() != 0;
+    const auto start = sampling ? clock::ticks() : 0;
+
+    if (sampling) {
+        for (const auto& value : pending) {
+            if (const auto sampled = value.sampled()) {
+                detail::stage::record(detail::stage::id_t::queue, start - sampled);
+            }
+        }
+    }
+
+    try {
+        if (size > 0) {
+            const metrics::timer_t timer(emitting);
+            wrapped->emit_batch(events.data(), events.size());
+        }
+    } catch (...) {
+        failed.add(size);
+
+        try {
+            exception_policy->handle(*wrapped, events.data(), events.size());
+        } catch (...) {
+            // There is nobody to report to from the consumer thread, the batch is dropped.
+        }
+    }
+
+    if (barriers > 0) {
+        try {
+            wrapped->flush(std::chrono::steady_clock::now() + flush_through.timeout);
+        } catch (...) {
+            // Waiting threads are released anyway, the record has been emitted.
+        }
+    }
+
+    // The summary record is not a submitted one, so it's not accounted.
+    this->expired.add(expired);
+    emitted.add(processed - expired);
+    flushed.fetch_add(barriers);
+
+    if (sampling) {
+        const auto elapsed = clock::ticks() - start;
+
+        for (const auto& value : pending) {
+            if (value.sampled()) {
+                detail::stage::record(detail::stage::id_t::write, elapsed);
+            }
+        }
+    }
+
+    for (auto& ring : rings) {
+        ring->release();
+    }
+
+    return processed;
+}
+
+auto asynchronous_t::expire() -> std::size_t {
+    const auto cutoff = record_t::clock_type::now() - expiry.max_age;
+
+    std::size_t kept = 0;
+    std::size_t run = 0;
+    std::size_t expired = 0;
+    int severity = 0;
+
+    for (std::size_t id = 0; id < records.size(); ++id) {
+        // Runs are ends of lanes, which are shifted by the number of records expired before them.
+        for (; run < runs.size() && runs[run] == id; ++run) {
+            runs[run] = kept;
+        }
+
+        const auto timestamp = records[id].timestamp();
+
+        // Records are stamped after filtering, so unstamped ones have no age.
+        if (timestamp != record_t::time_point() && timestamp < cutoff) {
+            const int current = records[id].severity();
+            severity = expired == 0 ? current : std::max(severity, current);
+            ++expired;
+            continue;
+        }
+
+        if (kept != id) {
+            records[kept] = records[id];
+            messages[kept] = messages[id];
+        }
+
+        ++kept;
+    }
+
+    for (; run < runs.size(); ++run) {
+        runs[run] = kept;
+    }
+
+    records.erase(records.begin() + static_cast<std::ptrdiff_t>(kept), records.end());
+    messages.erase(messages.begin() + static_cast<std::ptrdiff_t>(kept), messages.end());
+
+    if (expired > 0 && expiry.summary) {
+        summary = std::to_string(expired) + " records expired in queue, older than " +
+            std::to_string(expiry.max_age.count()) + " ms";
+        summary_view = string_view(summary);
+
+        records.emplace_back(severity, std::cref(summary_view), std::cref(summary_pack));
+        records.back().activate(summary_view);
+        messages.emplace_back(summary_view);
+    }
+
+    return expired;
+}
+
+auto asynchronous_t::collect(metrics::collector_t& collector) const -> void {
+    // Producers account records after enqueueing them, so the consumer may be seen ahead.
+    const auto emitted = this->emitted.get() + expired.get();
+    const auto enqueued = this->enqueued.get();
+
+    collector.counter("blackhole_queue_enqueued_total", enqueued);
+    collector.counter("blackhole_queue_dropped_total", dropped.get());
+    collector.counter("blackhole_queue_failed_total", failed.get());
+    collector.counter("blackhole_queue_expired_total", expired.get());
+    collector.gauge("blackhole_queue_depth", enqueued > emitted ? enqueued - emitted : 0);
+
+    if (!queues.empty()) {
+        std::size_t capacity = 0;
+        for (const auto& queue : queues) {
+            capacity += queue->reserved();
+        }
+
+        collector.gauge("blackhole_queue_capacity", capacity);
+    }
+
+    collector.histogram("blackhole_queue_emit_seconds", emitting);
+
+    if (cputime::sampling() != 0) {
+        collector.counter("blackhole_consumer_cpu_nanoseconds_total", consumed.get());
+    }
+
+    wrapped->collect(collector);
+}
+
+auto asynchronous_t::pressure() const -> pressure_t {
+    std::size_t capacity = 0;
+    for (const auto& queue : queues) {
+        capacity += queue->capacity();
+    }
+
+    for (const auto& ring : rings) {
+        capacity += ring->capacity() / ring_slot;
+    }
+
+    pressure_t result(std::min(1.0, static_cast<double>(depth()) / static_cast<double>(capacity)),
+        dropped.get() + expired.get());
+    result.merge(wrapped->pressure());
+
+    return result;
+}
+
+auto asynchronous_t::drain_queues() -> void {
+    // Batch buffers are accessed from the consumer thread only and never shrink, so there are no
+    // allocations for them in a steady state. Note that records view their owned buffers by
+    // pointers, so the storage must not be reallocated until the batch is emitted.
+    pending.clear();
+    pending.reserve(total(limits));
+
+    for (std::size_t id = 0; id < queues.size(); ++id) {
+        auto& queue = *queues[id];
+        const auto limit = pending.size() + limits[id];
+
+        // Fair lanes are charged with message sizes, which is the consumer work they cost.
+        auto ready = credit(id, queue.empty());
+
+        while (ready && pending.size() < limit) {
+            value_type result;
+            const auto dequeued = queue.dequeue_with([&](value_type& value) {
+                result = std::move(value);
+            });
+
+            if (!dequeued) {
+                break;
+            }
+
+            if (quanta[id] != 0) {
+                deficits[id] -= static_cast<std::int64_t>(result.message().size());
+                ready = deficits[id] > 0;
+            }
+
+            pending.emplace_back(std::move(result));
+        }
+
+        settle(id, queue.empty());
+        runs.push_back(pending.size());
+
+        queue.trim();
+    }
+
+    for (const auto& value : pending) {
+        records.emplace_back(value.record());
+        messages.emplace_back(value.message());
+    }
+}
+
+auto asynchronous_t::drain_rings() -> void {
+    ring_t::slot_t slot;
+
+    for (std::size_t id = 0; id < rings.size(); ++id) {
+        auto& ring = *rings[id];
+        const auto limit = records.size() + limits[id];
+
+        auto ready = credit(id, ring.empty());
+
+        while (ready && records.size() < limit && ring.read(slot)) {
+            auto& value = decoded[records.size()];
+            value.decode(slot);
+
+            records.emplace_back(value.record());
+            messages.emplace_back(value.output());
+
+            if (quanta[id] != 0) {
+                deficits[id] -= static_cast<std::int64_t>(messages.back().size());
+                ready = deficits[id] > 0;
+            }
+        }
+
+        settle(id, ring.empty());
+        runs.push_back(records.size());
+    }
+}
+
+executor_t::executor_t(std::size_t threads, asynchronous_t::consumer_t consumer) :
+    stopped(false)
+{
+    if (threads == 0) {
+        throw std::invalid_argument("executor must have at least one thread");
+    }
+
+    try {
+        for (std::size_t id = 0; id < threads; ++id) {
+            this->threads.push_back(spawn(consumer, [this] { run(); }));
+        }
+    } catch (...) {
+        stop();
+        throw;
+    }
+}
+
+executor_t::~executor_t() {
+    stop();
+}
+
+auto executor_t::stop() -> void {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopped = true;
+    }
+
+    ready.notify_all();
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    threads.clear();
+}
+
+auto executor_t::run() -> void {
+    std::unique_lock<std::mutex> lock(mutex);
+
+    while (true) {
+        ready.wait(lock, [&] {
+            return stopped || !tasks.empty();
+        });
+
+        if (tasks.empty()) {
+            return;
+        }
+
+        const auto sink = tasks.front();
+        tasks.pop_front();
+        running.push_back(sink);
+
+        lock.unlock();
+        const auto again = sink->step();
+        lock.lock();
+
+        running.erase(std::find(running.begin(), running.end(), sink));
+
+        // Busy sinks go to the back of the queue, so others are drained meanwhile.
+        if (again) {
+            tasks.push_back(sink);
+        }
+
+        done.notify_all();
+    }
+}
+
+auto executor_t::submit(asynchronous_t* sink) -> void {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        tasks.push_back(sink);
+    }
+
+    ready.notify_one();
+}
+
+auto executor_t::detach(asynchronous_t* sink) -> void {
+    std::unique_lock<std::mutex> lock(mutex);
+
+    done.wait(lock, [&] {
+        return std::find(running.begin(), running.end(), sink) == running.end();
+    });
+
+    // The sink may have been queued again by the thread that has just drained it.
+    tasks.erase(std::remove(tasks.begin(), tasks.end(), sink), tasks.end());
 }
 
 }  // namespace sink
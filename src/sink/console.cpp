@@ -2,9 +2,16 @@
 
 #include <unistd.h>
 
+#include <cerrno>
 #include <iostream>
 #include <map>
 #include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
 
 #include <boost/optional/optional.hpp>
 
@@ -16,7 +23,10 @@
 #include "blackhole/stdext/string_view.hpp"
 #include "blackhole/termcolor.hpp"
 
+#include "blackhole/detail/error.hpp"
 #include "blackhole/detail/memory.hpp"
+#include "blackhole/detail/mutex.hpp"
+#include "blackhole/detail/sink/file/flusher/timer.hpp"
 #include "blackhole/detail/util/deleter.hpp"
 
 #include "console.hpp"
@@ -32,7 +42,7 @@ namespace sink {
 
 // Both standard output and error access mutex. Messages written with Blackhole will be
 // synchronized, otherwise an intermixing can occur.
-static std::mutex mutex;
+static detail::mutex_t mutex;
 
 #pragma clang diagnostic pop
 
@@ -60,65 +70,300 @@ auto isatty(const std::ostream& stream) -> bool {
     }
 }
 
+auto render(const termcolor_t& color) -> std::string {
+    std::ostringstream stream;
+    stream << color;
+    return stream.str();
+}
+
+auto reset() -> const std::string& {
+    static const std::string escape = render(termcolor_t::reset());
+    return escape;
+}
+
 }  // namespace
 
+/// Pending output of the buffered mode.
+///
+/// Messages are appended to the buffer under its own lock and written into the file descriptor
+/// with a single `write` call when either the capacity is reached or the shared timer notices that
+/// the oldest pending message is older than the interval.
+class console_t::buffer_t {
+    typedef file::flusher::timer_t timer_t;
+
+    const int fd;
+    const bool tty;
+    const console_t::buffered_t options;
+
+    std::mutex mutex;
+    std::string pending;
+    /// Timer reading at the moment the first pending message has been appended.
+    std::uint64_t since;
+
+    std::shared_ptr<timer_t> timer;
+    std::uint64_t subscription;
+
+public:
+    buffer_t(int fd, console_t::buffered_t options) :
+        fd(fd),
+        tty(::isatty(fd)),
+        options(options),
+        since(0),
+        subscription(0)
+    {
+        if (options.capacity == 0) {
+            throw std::invalid_argument("buffered console sink capacity must be positive");
+        }
+
+        pending.reserve(options.capacity);
+
+        if (options.interval.count() > 0) {
+            timer = timer_t::instance();
+            subscription = timer->subscribe([this] {
+                // Skipping the round while the buffer is busy is fine, stalling the timer shared
+                // between sinks is not.
+                std::unique_lock<std::mutex> lock(mutex, std::try_to_lock);
+                if (lock.owns_lock() && !pending.empty() &&
+                    timer->now() - since >= static_cast<std::uint64_t>(this->options.interval.count()))
+                {
+                    flush();
+                }
+            });
+        }
+    }
+
+    ~buffer_t() {
+        if (timer) {
+            timer->unsubscribe(subscription);
+        }
+
+        try {
+            flush();
+        } catch (const std::exception& err) {
+            detail::error::report(error::kind_t::sink, err.what());
+        }
+    }
+
+    template<typename F>
+    auto append(const F& fn) -> void {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        if (pending.empty() && timer) {
+            since = timer->now();
+        }
+
+        fn();
+
+        if (pending.size() >= options.capacity) {
+            flush();
+        }
+    }
+
+    /// Appends the message followed by a newline, preceding it with the given escape sequence and
+    /// following with the reset one when writing into a terminal.
+    ///
+    /// \warning must be called within `append`.
+    auto push(const std::string& escape, const string_view& message) -> void {
+        if (tty && !escape.empty()) {
+            pending.append(escape);
+            pending.append(message.data(), message.size());
+            pending.append(reset());
+        } else {
+            pending.append(message.data(), message.size());
+        }
+
+        pending.push_back('\n');
+    }
+
+private:
+    auto flush() -> void {
+        std::size_t written = 0;
+
+        while (written < pending.size()) {
+            const auto rc = ::write(fd, pending.data() + written, pending.size() - written);
+
+            if (rc < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+
+                pending.clear();
+                throw std::system_error(errno, std::system_category(), "failed to write");
+            }
+
+            written += static_cast<std::size_t>(rc);
+        }
+
+        pending.clear();
+    }
+};
+
 console_t::console_t() :
     stream_(std::cout),
-    filter(new filter::zen_t),
-    mapping_([](const record_t&) -> termcolor_t { return {}; })
+    filter(new filter::zen_t)
 {}
 
 console_t::console_t(std::unique_ptr<filter_t> filter) :
     stream_(std::cout),
-    filter(std::move(filter)),
-    mapping_([](const record_t&) -> termcolor_t { return {}; })
+    filter(std::move(filter))
 {}
 
-console_t::console_t(std::ostream& stream, std::function<termcolor_t(const record_t& record)> mapping) :
+console_t::console_t(std::ostream& stream, mapping_type mapping) :
+    console_t(stream, colors_type(), std::move(mapping))
+{}
+
+console_t::console_t(std::ostream& stream, const colors_type& colors, mapping_type mapping) :
     stream_(stream),
     filter(new filter::zen_t),
     mapping_(std::move(mapping))
+{
+    for (const auto& item : colors) {
+        const auto severity = static_cast<int>(item.first);
+        if (severity < 0 || severity >= palette_size) {
+            throw std::invalid_argument("console sink palette severity is out of range");
+        }
+
+        const auto id = static_cast<std::size_t>(severity);
+        if (id >= palette.size()) {
+            palette.resize(id + 1, color_t{false, {}, {}});
+        }
+
+        const auto& color = item.second;
+        palette[id] = color_t{true, color, color.colored() ? render(color) : std::string()};
+    }
+}
+
+console_t::console_t(std::ostream& stream, mapping_type mapping, buffered_t buffered) :
+    console_t(stream, colors_type(), std::move(mapping), buffered)
 {}
 
+console_t::console_t(std::ostream& stream, const colors_type& colors, mapping_type mapping,
+                     buffered_t buffered) :
+    console_t(stream, colors, std::move(mapping))
+{
+    const auto file = streamfd(stream);
+    if (file == nullptr) {
+        throw std::invalid_argument("buffered console sink requires either standard output or error");
+    }
+
+    // Messages written through the stream before must precede ours.
+    stream.flush();
+    buffer.reset(new buffer_t(::fileno(file), buffered));
+}
+
+console_t::console_t(std::unique_ptr<filter_t> filter, buffered_t buffered) :
+    console_t(std::cout, mapping_type(), buffered)
+{
+    this->filter = std::move(filter);
+}
+
+console_t::~console_t() = default;
+
 auto console_t::stream() noexcept -> std::ostream& {
     return stream_;
 }
 
 auto console_t::mapping(const record_t& record) const -> termcolor_t {
-    return mapping_(record);
+    const auto id = static_cast<std::size_t>(record.severity());
+    if (id < palette.size() && palette[id].mapped) {
+        return palette[id].color;
+    }
+
+    return mapping_ ? mapping_(record) : termcolor_t();
+}
+
+auto console_t::buffered() const noexcept -> bool {
+    return buffer != nullptr;
 }
 
 auto console_t::emit(const record_t& record, const string_view& formatted) -> void {
-    switch (filter->filter(record)) {
-    case filter_t::action_t::neutral:
-    case filter_t::action_t::accept:
-        break;
-    case filter_t::action_t::deny:
+    if (!accepted(record)) {
         return;
     }
 
+    if (buffer) {
+        std::string storage;
+        const auto& prefix = escape(record, storage);
+
+        return buffer->append([&] {
+            buffer->push(prefix, formatted);
+        });
+    }
+
     if (isatty(stream())) {
-        std::lock_guard<std::mutex> lock(mutex);
-        mapping(record)
-            .write(stream(), formatted.data(), formatted.size());
+        std::string storage;
+        const auto& prefix = escape(record, storage);
+
+        std::lock_guard<detail::mutex_t> lock(mutex);
+        if (prefix.empty()) {
+            stream().write(formatted.data(), static_cast<std::streamsize>(formatted.size()));
+        } else {
+            stream().write(prefix.data(), static_cast<std::streamsize>(prefix.size()));
+            stream().write(formatted.data(), static_cast<std::streamsize>(formatted.size()));
+            stream().write(reset().data(), static_cast<std::streamsize>(reset().size()));
+        }
         stream() << std::endl;
     } else {
-        std::lock_guard<std::mutex> lock(mutex);
+        std::lock_guard<detail::mutex_t> lock(mutex);
         stream().write(formatted.data(), static_cast<std::streamsize>(formatted.size()));
         stream() << std::endl;
     }
 }
 
+auto console_t::emit_batch(const event_t* events, std::size_t size) -> void {
+    if (!buffer) {
+        return sink_t::emit_batch(events, size);
+    }
+
+    std::string storage;
+
+    buffer->append([&] {
+        for (std::size_t id = 0; id < size; ++id) {
+            if (accepted(*events[id].record)) {
+                buffer->push(escape(*events[id].record, storage), *events[id].message);
+            }
+        }
+    });
+}
+
+auto console_t::escape(const record_t& record, std::string& storage) const -> const std::string& {
+    const auto id = static_cast<std::size_t>(record.severity());
+    if (id < palette.size() && palette[id].mapped) {
+        return palette[id].escape;
+    }
+
+    const auto color = mapping_ ? mapping_(record) : termcolor_t();
+    storage = color.colored() ? render(color) : std::string();
+
+    return storage;
+}
+
+auto console_t::accepted(const record_t& record) -> bool {
+    switch (filter->filter(record)) {
+    case filter_t::action_t::neutral:
+    case filter_t::action_t::accept:
+        return true;
+    case filter_t::action_t::deny:
+        return false;
+    }
+
+    return false;
+}
+
 }  // namespace sink
 
 class builder<sink::console_t>::inner_t {
 public:
     std::ostream* stream;
-    std::function<termcolor_t(const record_t& record)> mapping;
+    /// Colors of severities within the palette range, which are compiled into escape sequences.
+    sink::console_t::colors_type colors;
+    /// Mapping of all other severities, empty means no coloring.
+    sink::console_t::mapping_type mapping;
+    boost::optional<sink::console_t::buffered_t> buffered;
 };
 
 builder<sink::console_t>::builder() :
-    d(new inner_t{&std::cout, [](const record_t&) -> termcolor_t { return {}; }})
+    d(new inner_t{&std::cout, {}, {}, boost::none})
 {}
 
 auto builder<sink::console_t>::stdout() & -> builder& {
@@ -140,15 +385,22 @@ auto builder<sink::console_t>::stderr() && -> builder&& {
 }
 
 auto builder<sink::console_t>::colorize(severity_t severity, termcolor_t color) & -> builder& {
+    if (severity >= 0 && severity < sink::console_t::palette_size) {
+        d->colors.emplace_back(severity, color);
+        return *this;
+    }
+
     const auto fallback = std::move(d->mapping);
 
-    return colorize([=](const record_t& record) -> termcolor_t {
+    d->mapping = [=](const record_t& record) -> termcolor_t {
         if (severity == record.severity()) {
             return color;
         } else {
-            return fallback(record);
+            return fallback ? fallback(record) : termcolor_t();
         }
-    });
+    };
+
+    return *this;
 }
 
 auto builder<sink::console_t>::colorize(severity_t severity, termcolor_t color) && -> builder&& {
@@ -156,6 +408,7 @@ auto builder<sink::console_t>::colorize(severity_t severity, termcolor_t color)
 }
 
 auto builder<sink::console_t>::colorize(std::function<termcolor_t(const record_t& record)> fn) & -> builder& {
+    d->colors.clear();
     d->mapping = std::move(fn);
     return *this;
 }
@@ -164,8 +417,26 @@ auto builder<sink::console_t>::colorize(std::function<termcolor_t(const record_t
     return std::move(colorize(std::move(fn)));
 }
 
+auto builder<sink::console_t>::buffered(std::size_t capacity, std::chrono::milliseconds interval) & ->
+    builder&
+{
+    d->buffered = sink::console_t::buffered_t{capacity, interval};
+    return *this;
+}
+
+auto builder<sink::console_t>::buffered(std::size_t capacity, std::chrono::milliseconds interval) && ->
+    builder&&
+{
+    return std::move(buffered(capacity, interval));
+}
+
 auto builder<sink::console_t>::build() && -> std::unique_ptr<sink_t> {
-    return blackhole::make_unique<sink::console_t>(*d->stream, std::move(d->mapping));
+    if (d->buffered) {
+        return blackhole::make_unique<sink::console_t>(*d->stream, d->colors,
+            std::move(d->mapping), d->buffered.get());
+    }
+
+    return blackhole::make_unique<sink::console_t>(*d->stream, d->colors, std::move(d->mapping));
 }
 
 auto factory<sink::console_t>::type() const noexcept -> const char* {
@@ -173,10 +444,31 @@ auto factory<sink::console_t>::type() const noexcept -> const char* {
 }
 
 auto factory<sink::console_t>::from(const config::node_t& config) const -> std::unique_ptr<sink_t> {
+    std::unique_ptr<filter_t> filter;
     if (auto type = config["filter"]["type"].to_string()) {
         auto factory = registry.filter(*type);
-        auto filter = factory(*config["filter"].unwrap());
+        filter = factory(*config["filter"].unwrap());
+    }
+
+    if (auto buffered = config["buffered"]) {
+        sink::console_t::buffered_t options{64 * 1024, std::chrono::milliseconds(100)};
+
+        if (auto capacity = buffered["capacity"].to_uint64()) {
+            options.capacity = static_cast<std::size_t>(capacity.get());
+        }
+
+        if (auto interval = buffered["interval"].to_uint64()) {
+            options.interval = std::chrono::milliseconds(interval.get());
+        }
+
+        if (!filter) {
+            filter.reset(new blackhole::filter::zen_t);
+        }
+
+        return blackhole::make_unique<sink::console_t>(std::move(filter), options);
+    }
 
+    if (filter) {
         return blackhole::make_unique<sink::console_t>(std::move(filter));
     }
 
@@ -1,29 +1,110 @@
 #pragma once
 
+#include <chrono>
 #include <functional>
 #include <iosfwd>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
 
+#include "blackhole/severity.hpp"
 #include "blackhole/sink.hpp"
 #include "blackhole/sink/console.hpp"
+#include "blackhole/termcolor.hpp"
 
 namespace blackhole {
 inline namespace v1 {
 namespace sink {
 
 class console_t : public sink_t {
+public:
+    /// Options of the buffered mode.
+    struct buffered_t {
+        /// Size of the pending output in bytes that triggers the write.
+        std::size_t capacity;
+
+        /// Maximum time messages can stay buffered, zero means until the capacity is reached or
+        /// the sink is destroyed.
+        std::chrono::milliseconds interval;
+    };
+
+    typedef std::function<termcolor_t(const record_t& record)> mapping_type;
+
+    /// Explicit severity colors, later ones override earlier ones of the same severity.
+    ///
+    /// Severities are used as palette indices, so they must be in `[0, palette_size)` range.
+    static constexpr int palette_size = 256;
+    typedef std::vector<std::pair<severity_t, termcolor_t>> colors_type;
+
+private:
+    /// Color of a severity with its escape sequence rendered, which is empty for the default color.
+    struct color_t {
+        bool mapped;
+        termcolor_t color;
+        std::string escape;
+    };
+
     std::ostream& stream_;
     std::unique_ptr<filter_t> filter;
-    std::function<termcolor_t(const record_t& record)> mapping_;
+
+    /// Colors of explicitly mapped severities indexed by their values.
+    std::vector<color_t> palette;
+
+    /// Mapping of all other severities, empty function means no coloring.
+    mapping_type mapping_;
+
+    /// Pending output with its flushing timer in buffered mode, defined in the translation unit.
+    class buffer_t;
+    std::unique_ptr<buffer_t> buffer;
 
 public:
     console_t();
     console_t(std::unique_ptr<filter_t> filter);
-    console_t(std::ostream& stream, std::function<termcolor_t(const record_t& record)> mapping);
+    console_t(std::ostream& stream, mapping_type mapping);
+
+    /// Constructs a console sink with the given severity colors, which escape sequences are
+    /// rendered once, falling back to the mapping function for other severities.
+    ///
+    /// \throw std::invalid_argument if any of severities is out of the palette range.
+    console_t(std::ostream& stream, const colors_type& colors, mapping_type mapping);
+
+    /// Constructs a buffered console sink, which accumulates messages and writes them directly
+    /// into the file descriptor of the given standard stream, bypassing both `std::ostream` and the
+    /// global mutex.
+    ///
+    /// \note the output is no longer ordered with other writes into the same standard stream made
+    ///     outside of the logger.
+    ///
+    /// \throw std::invalid_argument if the stream is neither standard output nor error or the
+    ///     capacity is zero.
+    console_t(std::ostream& stream, mapping_type mapping, buffered_t buffered);
+    console_t(std::ostream& stream, const colors_type& colors, mapping_type mapping,
+              buffered_t buffered);
+
+    /// Constructs a buffered console sink writing into the standard output.
+    console_t(std::unique_ptr<filter_t> filter, buffered_t buffered);
+
+    /// Writes pending messages in buffered mode.
+    ~console_t();
 
     auto stream() noexcept -> std::ostream&;
     auto mapping(const record_t& record) const -> termcolor_t;
 
+    /// Checks whether the sink is in buffered mode.
+    auto buffered() const noexcept -> bool;
+
     auto emit(const record_t& record, const string_view& formatted) -> void override;
+
+    /// Emits the batch appending all messages under a single lock in buffered mode.
+    auto emit_batch(const event_t* events, std::size_t size) -> void override;
+
+private:
+    auto accepted(const record_t& record) -> bool;
+
+    /// Returns the escape sequence preceding the message of the given record, which is empty if
+    /// it's not colored, using the given storage for colors out of the palette.
+    auto escape(const record_t& record, std::string& storage) const -> const std::string&;
 };
 
 }  // namespace sink
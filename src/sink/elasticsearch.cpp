@@ -0,0 +1,265 @@
+#include "blackhole/sink/elasticsearch.hpp"
+
+#include <cctype>
+#include <cstdlib>
+#include <stdexcept>
+
+#include <boost/asio/buffer.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/optional/optional.hpp>
+
+#include "blackhole/config/node.hpp"
+#include "blackhole/config/option.hpp"
+#include "blackhole/stdext/string_view.hpp"
+
+#include "blackhole/detail/memory.hpp"
+#include "blackhole/detail/sink/elasticsearch.hpp"
+
+#include "http/client.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+
+namespace {
+
+/// Action line preceding each document, the index is specified by the request path instead.
+const string_view action("{\"index\":{}}\n", 13);
+
+/// Size of the action line and the trailing newline added to each document.
+constexpr std::size_t framing = 14;
+
+}  // namespace
+
+namespace elasticsearch {
+
+auto statuses(const string_view& body, std::vector<int>& result) -> bool {
+    const auto data = body.data();
+    const auto size = body.size();
+
+    // The response is like `{"errors":true,"items":[{"index":{"status":201,...}},...]}`, so item
+    // objects are at the third level of nesting and their statuses are at the fourth one.
+    std::size_t depth = 0;
+    std::size_t level = 0;
+    string_view key;
+    bool items = false;
+    bool found = false;
+
+    std::size_t pos = 0;
+    while (pos < size) {
+        const auto ch = data[pos];
+
+        switch (ch) {
+        case '"': {
+            const auto start = ++pos;
+            for (; pos < size && data[pos] != '"'; ++pos) {
+                if (data[pos] == '\\') {
+                    ++pos;
+                }
+            }
+
+            if (pos >= size) {
+                return false;
+            }
+
+            const string_view value(data + start, pos - start);
+            ++pos;
+
+            while (pos < size && std::isspace(static_cast<unsigned char>(data[pos]))) {
+                ++pos;
+            }
+
+            if (pos < size && data[pos] == ':') {
+                key = value;
+                level = depth;
+                ++pos;
+            }
+            break;
+        }
+        case '{':
+        case '[':
+            ++depth;
+
+            if (ch == '[' && depth == 2 && level == 1 && key == string_view("items", 5)) {
+                items = true;
+                found = true;
+            } else if (ch == '{' && items && depth == 3) {
+                result.push_back(0);
+            }
+
+            key = string_view();
+            ++pos;
+            break;
+        case '}':
+        case ']':
+            if (depth == 0) {
+                return false;
+            }
+
+            if (ch == ']' && items && depth == 2) {
+                items = false;
+            }
+
+            --depth;
+            ++pos;
+            break;
+        default:
+            if (items && depth == 4 && level == 4 && key == string_view("status", 6) &&
+                std::isdigit(static_cast<unsigned char>(ch)))
+            {
+                result.back() = std::atoi(data + pos);
+                key = string_view();
+            }
+
+            ++pos;
+        }
+    }
+
+    return found && depth == 0;
+}
+
+}  // namespace elasticsearch
+
+namespace {
+
+class protocol_t : public http::protocol_t {
+    const elasticsearch_t::options_t& options;
+
+public:
+    explicit protocol_t(const elasticsearch_t::options_t& options) noexcept :
+        options(options)
+    {}
+
+    auto head() const -> std::string override {
+        return "POST /" + options.index + "/_bulk HTTP/1.1\r\n"
+            "Host: " + options.host + ":" + boost::lexical_cast<std::string>(options.port) + "\r\n"
+            "Content-Type: application/x-ndjson\r\n"
+            "Content-Length: ";
+    }
+
+    auto overhead(std::size_t size) const noexcept -> std::size_t override {
+        return size + framing;
+    }
+
+    auto frame(const std::vector<http::item_t>& batch, std::string&,
+        std::vector<boost::asio::const_buffer>& buffers) const -> void override
+    {
+        for (const auto& item : batch) {
+            buffers.emplace_back(action.data(), action.size());
+            buffers.emplace_back(item.document.data(), item.document.size());
+            buffers.emplace_back("\n", 1);
+        }
+    }
+
+    auto statuses(const string_view& body, std::size_t, std::vector<int>& result) const ->
+        bool override
+    {
+        return elasticsearch::statuses(body, result);
+    }
+};
+
+}  // namespace
+
+elasticsearch_t::elasticsearch_t(options_t options) :
+    options_(std::move(options))
+{
+    if (options_.count == 0 || options_.bytes == 0 || options_.connections == 0 ||
+        options_.linger.count() <= 0)
+    {
+        throw std::invalid_argument("count, bytes, linger and connections must be positive");
+    }
+
+    client.reset(new http::client_t({
+        options_.host,
+        options_.port,
+        options_.count,
+        options_.bytes,
+        options_.linger,
+        options_.connections,
+        options_.retries,
+        options_.capacity
+    }, blackhole::make_unique<protocol_t>(options_)));
+}
+
+elasticsearch_t::~elasticsearch_t() = default;
+
+auto elasticsearch_t::options() const noexcept -> const options_t& {
+    return options_;
+}
+
+auto elasticsearch_t::sent() const noexcept -> std::uint64_t {
+    return client->sent();
+}
+
+auto elasticsearch_t::failed() const noexcept -> std::uint64_t {
+    return client->failed();
+}
+
+auto elasticsearch_t::dropped() const noexcept -> std::uint64_t {
+    return client->dropped();
+}
+
+auto elasticsearch_t::emit(const record_t&, const string_view& formatted) -> void {
+    client->push(1, [&](std::size_t) -> const string_view& {
+        return formatted;
+    });
+}
+
+auto elasticsearch_t::emit_batch(const event_t* events, std::size_t size) -> void {
+    client->push(size, [&](std::size_t id) -> const string_view& {
+        return *events[id].message;
+    });
+}
+
+}  // namespace sink
+
+auto factory<sink::elasticsearch_t>::type() const noexcept -> const char* {
+    return "elasticsearch";
+}
+
+auto factory<sink::elasticsearch_t>::from(const config::node_t& config) const -> std::unique_ptr<sink_t> {
+    (void)registry;
+
+    sink::elasticsearch_t::options_t options;
+
+    if (auto host = config["host"].to_string()) {
+        options.host = host.get();
+    }
+
+    if (auto port = config["port"].to_uint64()) {
+        options.port = static_cast<std::uint16_t>(port.get());
+    }
+
+    if (auto index = config["index"].to_string()) {
+        options.index = index.get();
+    }
+
+    if (auto count = config["count"].to_uint64()) {
+        options.count = static_cast<std::size_t>(count.get());
+    }
+
+    if (auto bytes = config["bytes"].to_uint64()) {
+        options.bytes = static_cast<std::size_t>(bytes.get());
+    }
+
+    if (auto linger = config["linger"].to_uint64()) {
+        options.linger = std::chrono::milliseconds(linger.get());
+    }
+
+    if (auto connections = config["connections"].to_uint64()) {
+        options.connections = static_cast<std::size_t>(connections.get());
+    }
+
+    if (auto retries = config["retries"].to_uint64()) {
+        options.retries = static_cast<std::size_t>(retries.get());
+    }
+
+    if (auto capacity = config["capacity"].to_uint64()) {
+        options.capacity = static_cast<std::size_t>(capacity.get());
+    }
+
+    return blackhole::make_unique<sink::elasticsearch_t>(std::move(options));
+}
+
+}  // namespace v1
+}  // namespace blackhole
@@ -1,17 +1,38 @@
 #include "blackhole/sink/file.hpp"
 
+#include <algorithm>
+#include <atomic>
 #include <cctype>
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <system_error>
+#include <unordered_map>
 
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <boost/container/small_vector.hpp>
 #include <boost/lexical_cast.hpp>
 #include <boost/optional/optional.hpp>
 
 #include "blackhole/config/node.hpp"
 #include "blackhole/config/option.hpp"
+#include "blackhole/extensions/writer.hpp"
+#include "blackhole/formatter.hpp"
 #include "blackhole/stdext/string_view.hpp"
 #include "blackhole/record.hpp"
 
+#include "blackhole/detail/budget.hpp"
+#include "blackhole/detail/formatter/string/path.hpp"
+#include "blackhole/detail/process.hpp"
 #include "blackhole/detail/sink/file.hpp"
+#include "blackhole/detail/sink/file/deflate.hpp"
 #include "blackhole/detail/sink/file/flusher/bytecount.hpp"
+#include "blackhole/detail/sink/file/flusher/interval.hpp"
 #include "blackhole/detail/sink/file/flusher/repeat.hpp"
 #include "blackhole/detail/sink/file/stream.hpp"
 #include "blackhole/detail/util/deleter.hpp"
@@ -77,6 +98,73 @@ auto parse_dunit(const std::string& encoded) -> std::uint64_t {
     return base * it->second;
 }
 
+interval_factory_t::interval_factory_t(std::chrono::milliseconds interval) :
+    value(interval),
+    timer(timer_t::instance())
+{}
+
+auto interval_factory_t::interval() const noexcept -> std::chrono::milliseconds {
+    return value;
+}
+
+auto interval_factory_t::create() const -> std::unique_ptr<flusher_t> {
+    const auto timer = this->timer;
+
+    return blackhole::make_unique<interval_t>(static_cast<interval_t::threshold_type>(value.count()),
+        [timer] { return timer->now(); });
+}
+
+auto interval_factory_t::timed() const noexcept -> bool {
+    return true;
+}
+
+combined_factory_t::combined_factory_t(bytecount_t::threshold_type bytes,
+                                       std::chrono::milliseconds interval) :
+    bytes(bytes),
+    interval(interval),
+    timer(timer_t::instance())
+{}
+
+auto combined_factory_t::create() const -> std::unique_ptr<flusher_t> {
+    const auto timer = this->timer;
+
+    return blackhole::make_unique<combined_t>(bytecount_t(bytes),
+        interval_t(static_cast<interval_t::threshold_type>(interval.count()), [timer] {
+            return timer->now();
+        }));
+}
+
+auto combined_factory_t::timed() const noexcept -> bool {
+    return true;
+}
+
+auto parse_tunit(const std::string& encoded) -> std::chrono::milliseconds {
+    const auto ipos = std::find_if(std::begin(encoded), std::end(encoded), [&](char c) -> bool {
+        return !std::isdigit(c);
+    });
+
+    if (ipos == std::end(encoded)) {
+        return std::chrono::milliseconds(boost::lexical_cast<std::uint64_t>(encoded));
+    }
+
+    const auto pos = static_cast<std::size_t>(std::distance(std::begin(encoded), ipos));
+    const auto base = boost::lexical_cast<std::uint64_t>(encoded.substr(0, pos));
+    const auto unit = encoded.substr(pos);
+
+    const std::map<std::string, std::uint64_t> mapping {
+        {"ms",  1},
+        {"s",   1000},
+        {"min", 60 * 1000},
+    };
+
+    const auto it = mapping.find(unit);
+    if (it == std::end(mapping)) {
+        throw std::invalid_argument("unknown time unit - " + unit);
+    }
+
+    return std::chrono::milliseconds(base * it->second);
+}
+
 }  // namespace flusher
 
 auto ofstream_factory_t::create(const std::string& filename, std::ios_base::openmode mode) const ->
@@ -100,108 +188,1407 @@ auto ofstream_factory_t::create(const std::string& filename, std::ios_base::open
     return std::unique_ptr<std::ostream>(stream.release());
 }
 
-}  // namespace file
+namespace {
 
-file_t::file_t(const std::string& path,
-               std::unique_ptr<file::stream_factory_t> stream_factory,
-               std::unique_ptr<file::flusher_factory_t> flusher_factory) :
-    stream_factory(std::move(stream_factory)),
-    flusher_factory(std::move(flusher_factory))
+auto page_size() noexcept -> std::size_t {
+    const auto size = ::sysconf(_SC_PAGESIZE);
+    return size > 0 ? static_cast<std::size_t>(size) : 4096;
+}
+
+}  // namespace
+
+fdbuf_t::fdbuf_t(const std::string& filename, std::ios_base::openmode mode, std::size_t capacity,
+                 const detail::paging_t& paging, std::size_t writeback,
+                 std::size_t preallocate) :
+    fd(-1),
+    buffer(nullptr),
+    capacity_(0),
+    window(writeback),
+    offset(0),
+    started(0),
+    dropped_(0),
+    chunk(preallocate),
+    allocated_(0)
 {
-    data.path = path;
+    const auto page = page_size();
+    capacity_ = std::max(page, (capacity + page - 1) / page * page);
+
+    if (paging.enabled()) {
+        pages.reset(new detail::pages_t(capacity_, page, paging));
+        buffer = pages->data();
+    } else {
+        void* memory = nullptr;
+        if (const auto rc = ::posix_memalign(&memory, page, capacity_)) {
+            throw std::system_error(rc, std::system_category());
+        }
+
+        buffer = static_cast<char*>(memory);
+        detail::budget::charge(capacity_);
+    }
+
+    // Mimic std::ofstream behavior, which truncates files unless opened in append mode.
+    auto flags = O_WRONLY | O_CREAT | O_CLOEXEC;
+    flags |= (mode & std::ios_base::app) ? O_APPEND : O_TRUNC;
+
+    fd = ::open(filename.c_str(), flags, 0644);
+
+    if (fd == -1) {
+        const auto ec = errno;
+        if (pages == nullptr) {
+            std::free(buffer);
+            detail::budget::release(capacity_);
+        }
+        throw std::system_error(ec, std::system_category());
+    }
+
+    // Appended data starts at the end of the file, which is tracked from there on, since writes of
+    // other processes appending to the same file only shift ranges given as advice to the kernel.
+    if (mode & std::ios_base::app) {
+        const auto end = ::lseek(fd, 0, SEEK_END);
+        offset = end > 0 ? static_cast<std::uint64_t>(end) : 0;
+    }
+
+    started = offset;
+    dropped_ = offset;
+
+    setp(buffer, buffer + capacity_);
 }
 
-auto file_t::path() const -> const std::string& {
-    return data.path;
+fdbuf_t::~fdbuf_t() {
+    commit(nullptr, 0);
+    trim();
+    ::close(fd);
+
+    if (pages == nullptr) {
+        std::free(buffer);
+        detail::budget::release(capacity_);
+    }
+}
+
+auto fdbuf_t::capacity() const noexcept -> std::size_t {
+    return capacity_;
 }
 
-auto file_t::filename(const record_t&) const -> std::string {
-    // TODO: Generate path from tokens, for now just return static path.
-    return {data.path};
+auto fdbuf_t::dropped() const noexcept -> std::uint64_t {
+    return dropped_;
 }
 
-auto file_t::backend(const std::string& filename) -> file::backend_t& {
-    const auto it = data.backends.find(filename);
+auto fdbuf_t::allocated() const noexcept -> std::uint64_t {
+    return allocated_;
+}
 
-    if (it == data.backends.end()) {
-        auto stream = stream_factory->create(filename, std::ios_base::app);
-        auto flusher = flusher_factory->create();
+auto fdbuf_t::overflow(int_type ch) -> int_type {
+    if (!commit(nullptr, 0)) {
+        return traits_type::eof();
+    }
 
-        return data.backends.insert(it,
-            std::make_pair(filename, file::backend_t(std::move(stream), std::move(flusher))))->second;
+    if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(ch);
+        pbump(1);
     }
 
-    return it->second;
+    return traits_type::not_eof(ch);
 }
 
-auto file_t::emit(const record_t& record, const string_view& formatted) -> void {
-    const auto filename = this->filename(record);
+auto fdbuf_t::xsputn(const char_type* data, std::streamsize size) -> std::streamsize {
+    const auto nsize = static_cast<std::size_t>(size);
 
-    std::lock_guard<std::mutex> lock(mutex);
-    backend(filename).write(formatted);
+    if (nsize <= static_cast<std::size_t>(epptr() - pptr())) {
+        std::memcpy(pptr(), data, nsize);
+        pbump(static_cast<int>(nsize));
+        return size;
+    }
+
+    return commit(data, nsize) ? size : 0;
 }
 
-}  // namespace sink
+auto fdbuf_t::sync() -> int {
+    return commit(nullptr, 0) ? 0 : -1;
+}
 
-class builder<sink::file_t>::inner_t {
-public:
-    std::string filename;
-    std::unique_ptr<sink::file::flusher_factory_t> ffactory;
-};
+auto fdbuf_t::gather(const ::iovec* iov, std::size_t count) -> bool {
+    std::size_t size = 0;
+    for (std::size_t id = 0; id < count; ++id) {
+        size += iov[id].iov_len;
+    }
 
-builder<sink::file_t>::builder(const std::string& path) :
-    p(new inner_t{path, nullptr}, deleter_t())
+    if (size > static_cast<std::size_t>(epptr() - pptr())) {
+        return commitv(iov, count);
+    }
+
+    for (std::size_t id = 0; id < count; ++id) {
+        std::memcpy(pptr(), iov[id].iov_base, iov[id].iov_len);
+        pbump(static_cast<int>(iov[id].iov_len));
+    }
+
+    return true;
+}
+
+auto fdbuf_t::reserve(std::size_t size, ::iovec& region) -> bool {
+    region = {nullptr, 0};
+
+    if (size > capacity_) {
+        return true;
+    }
+
+    if (size > static_cast<std::size_t>(epptr() - pptr()) && !commit(nullptr, 0)) {
+        return false;
+    }
+
+    region = {pptr(), static_cast<std::size_t>(epptr() - pptr())};
+    return true;
+}
+
+auto fdbuf_t::advance(std::size_t size) noexcept -> void {
+    pbump(static_cast<int>(size));
+}
+
+auto fdbuf_t::commit(const char* data, std::size_t size) -> bool {
+    const ::iovec iov = {const_cast<char*>(data), size};
+    return commitv(&iov, size == 0 ? 0 : 1);
+}
+
+auto fdbuf_t::commitv(const ::iovec* extra, std::size_t count) -> bool {
+    boost::container::small_vector<::iovec, 64> iov;
+    iov.reserve(count + 1);
+
+    if (pptr() != buffer) {
+        iov.push_back({buffer, static_cast<std::size_t>(pptr() - buffer)});
+    }
+
+    for (std::size_t id = 0; id < count; ++id) {
+        if (extra[id].iov_len != 0) {
+            iov.push_back(extra[id]);
+        }
+    }
+
+    // The put area is reset regardless of the result, because partially written data can not be
+    // reliably retried without duplicating it in the file.
+    setp(buffer, buffer + capacity_);
+
+    if (chunk != 0) {
+        std::uint64_t size = 0;
+        for (const auto& slice : iov) {
+            size += slice.iov_len;
+        }
+
+        preallocate(offset + size);
+    }
+
+    auto it = iov.data();
+    auto remaining = iov.size();
+
+    while (remaining > 0) {
+        const auto nvecs = static_cast<int>(std::min<std::size_t>(remaining, IOV_MAX));
+        const auto rc = ::writev(fd, it, nvecs);
+
+        if (rc == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            return false;
+        }
+
+        auto written = static_cast<std::size_t>(rc);
+        offset += written;
+
+        while (remaining > 0 && written >= it->iov_len) {
+            written -= it->iov_len;
+            ++it;
+            --remaining;
+        }
+
+        if (remaining > 0) {
+            it->iov_base = static_cast<char*>(it->iov_base) + written;
+            it->iov_len -= written;
+        }
+    }
+
+    if (window != 0 && offset - started >= window) {
+        writeback();
+    }
+
+    return true;
+}
+
+auto fdbuf_t::writeback() noexcept -> void {
+#if defined(__linux__)
+    // The previous window is most likely written back already, so waiting for it rarely blocks,
+    // while dropping pages still under writeback would have no effect.
+    if (started > dropped_) {
+        const auto size = static_cast<::off_t>(started - dropped_);
+        ::sync_file_range(fd, static_cast<::off_t>(dropped_), size, SYNC_FILE_RANGE_WAIT_BEFORE |
+            SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER);
+        ::posix_fadvise(fd, static_cast<::off_t>(dropped_), size, POSIX_FADV_DONTNEED);
+        dropped_ = started;
+    }
+
+    // Errors are ignored, since both calls are merely hints, which never lose data.
+    ::sync_file_range(fd, static_cast<::off_t>(started), static_cast<::off_t>(offset - started),
+        SYNC_FILE_RANGE_WRITE);
+#endif
+
+    started = offset;
+}
+
+auto fdbuf_t::preallocate(std::uint64_t end) noexcept -> void {
+    if (end <= allocated_) {
+        return;
+    }
+
+#if defined(__linux__)
+    const auto from = std::max(allocated_, offset);
+    const auto to = (end + chunk - 1) / chunk * chunk;
+
+    if (::fallocate(fd, FALLOC_FL_KEEP_SIZE, static_cast<::off_t>(from),
+        static_cast<::off_t>(to - from)) == 0)
+    {
+        allocated_ = to;
+        return;
+    }
+#endif
+
+    // Appends just allocate blocks as usual, either without support or when the disk is full.
+    chunk = 0;
+    trim();
+}
+
+auto fdbuf_t::trim() noexcept -> void {
+    if (allocated_ == 0) {
+        return;
+    }
+
+    // Truncating to the current size releases blocks beyond it. Files grown by other writers since
+    // are left as they are, since their data could be lost otherwise.
+    struct ::stat stat;
+    if (::fstat(fd, &stat) == 0 && static_cast<std::uint64_t>(stat.st_size) == offset) {
+        while (::ftruncate(fd, stat.st_size) == -1 && errno == EINTR) {}
+    }
+
+    allocated_ = 0;
+}
+
+fdstream_t::fdstream_t(const std::string& filename, std::ios_base::openmode mode, std::size_t capacity,
+                       const detail::paging_t& paging, std::size_t writeback,
+                       std::size_t preallocate) :
+    std::ostream(nullptr),
+    buf(filename, mode, capacity, paging, writeback, preallocate)
 {
-    p->ffactory = blackhole::make_unique<sink::file::flusher::repeat_factory_t>(std::size_t(0));
+    rdbuf(&buf);
 }
 
-auto builder<sink::file_t>::flush_every(bytes_t bytes) & -> builder& {
-    p->ffactory = blackhole::make_unique<sink::file::flusher::bytecount_factory_t>(bytes.count());
-    return *this;
+fdstream_factory_t::fdstream_factory_t(std::size_t capacity,
+                                       const detail::paging_t& paging,
+                                       std::size_t writeback,
+                                       std::size_t preallocate) noexcept :
+    capacity(capacity),
+    paging(paging),
+    writeback(writeback),
+    preallocate(preallocate)
+{}
+
+auto fdstream_factory_t::create(const std::string& filename, std::ios_base::openmode mode) const ->
+    std::unique_ptr<std::ostream>
+{
+    auto stream = blackhole::make_unique<fdstream_t>(filename, mode, capacity, paging, writeback,
+        preallocate);
+    stream->exceptions(std::ios_base::failbit | std::ios_base::badbit);
+
+    return std::unique_ptr<std::ostream>(stream.release());
 }
 
-auto builder<sink::file_t>::flush_every(bytes_t bytes) && -> builder&& {
-    return std::move(flush_every(bytes));
+auto isolate(const string_view& filename, std::uint64_t tid, writer_t& writer) -> string_view {
+    const auto offset = writer.inner.size();
+
+    auto base = filename.size();
+    while (base > 0 && filename[base - 1] != '/') {
+        --base;
+    }
+
+    // A dot leading the last path component denotes a hidden file rather than an extension.
+    auto dot = filename.size();
+    for (auto pos = filename.size(); pos > base + 1; --pos) {
+        if (filename[pos - 1] == '.') {
+            dot = pos - 1;
+            break;
+        }
+    }
+
+    writer.inner << fmt::StringRef(filename.data(), dot) << '.' << tid
+        << fmt::StringRef(filename.data() + dot, filename.size() - dot);
+
+    return string_view(writer.inner.data() + offset, writer.inner.size() - offset);
 }
 
-auto builder<sink::file_t>::flush_every(std::size_t events) & -> builder& {
-    p->ffactory = blackhole::make_unique<sink::file::flusher::repeat_factory_t>(events);
-    return *this;
+namespace {
+
+std::atomic<std::uint64_t> counter(0);
+
+/// Closes the slot, flushing and releasing all its backends.
+auto close(slot_t& slot) -> void {
+    std::lock_guard<std::mutex> lock(slot.mutex);
+    slot.backends.reset();
 }
 
-auto builder<sink::file_t>::flush_every(std::size_t events) && -> builder&& {
-    return std::move(flush_every(events));
+}  // namespace
+
+slots_t::slots_t(std::size_t files) :
+    id(++counter),
+    files(files)
+{}
+
+slots_t::~slots_t() {
+    for (const auto& slot : slots) {
+        close(*slot);
+    }
 }
 
-auto builder<sink::file_t>::build() && -> std::unique_ptr<sink_t> {
-    return blackhole::make_unique<sink::file_t>(
-        std::move(p->filename),
-        blackhole::make_unique<sink::file::ofstream_factory_t>(),
-        std::move(p->ffactory));
+auto slots_t::local() -> slot_t& {
+    // Slots are keyed by sink identifiers, because sink addresses can be reused after destruction,
+    // while slots of destroyed sinks stay here until the thread exits.
+    thread_local std::unordered_map<std::uint64_t, std::shared_ptr<slot_t>> cache;
+
+    const auto it = cache.find(id);
+    if (it != cache.end()) {
+        return *it->second;
+    }
+
+    for (auto it = cache.begin(); it != cache.end();) {
+        std::unique_lock<std::mutex> lock(it->second->mutex);
+
+        if (it->second->backends == nullptr) {
+            lock.unlock();
+            it = cache.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    auto slot = std::make_shared<slot_t>(files);
+
+    // The slot must be owned by the thread before registering, otherwise it may be treated as
+    // orphaned.
+    cache.emplace(id, slot);
+
+    std::vector<std::shared_ptr<slot_t>> orphans;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        orphans = prune();
+        slots.push_back(slot);
+    }
+
+    for (const auto& orphan : orphans) {
+        close(*orphan);
+    }
+
+    return *slot;
 }
 
-auto factory<sink::file_t>::type() const noexcept -> const char* {
-    return "file";
+auto slots_t::poll(const std::function<void(lru_t<backend_t>& backends)>& fn) -> void {
+    std::vector<std::shared_ptr<slot_t>> active;
+    std::vector<std::shared_ptr<slot_t>> orphans;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        orphans = prune();
+        active = slots;
+    }
+
+    for (const auto& slot : active) {
+        std::unique_lock<std::mutex> lock(slot->mutex, std::try_to_lock);
+        if (lock.owns_lock() && slot->backends) {
+            fn(*slot->backends);
+        }
+    }
+
+    for (const auto& orphan : orphans) {
+        close(*orphan);
+    }
 }
 
-auto factory<sink::file_t>::from(const config::node_t& config) const -> std::unique_ptr<sink_t> {
-    (void)registry;
-    const auto filename = config["path"].to_string();
+auto slots_t::prune() -> std::vector<std::shared_ptr<slot_t>> {
+    // Slots referenced only from here belong to exited threads.
+    const auto it = std::stable_partition(slots.begin(), slots.end(),
+        [](const std::shared_ptr<slot_t>& slot) {
+            return slot.use_count() > 1;
+        });
 
-    if (!filename) {
-        throw std::invalid_argument("field 'path' is required");
+    std::vector<std::shared_ptr<slot_t>> orphans(std::make_move_iterator(it),
+        std::make_move_iterator(slots.end()));
+    slots.erase(it, slots.end());
+
+    return orphans;
+}
+
+}  // namespace file
+
+file_t::file_t(const std::string& path,
+               std::unique_ptr<file::stream_factory_t> stream_factory,
+               std::unique_ptr<file::flusher_factory_t> flusher_factory,
+               std::size_t files,
+               const file::rotation_t& rotation,
+               const file::indexing_t& indexing) :
+    stream_factory(std::move(stream_factory)),
+    flusher_factory(std::move(flusher_factory)),
+    archiver(rotation.enabled() ? new file::archiver_t(rotation) : nullptr),
+    pattern(detail::formatter::string::path(path)),
+    indexing(indexing),
+    backends(files),
+    subscription(0),
+    loan(nullptr)
+{
+    data.path = path;
+    subscribe();
+}
+
+file_t::file_t(const std::string& path,
+               file::isolated_t,
+               std::unique_ptr<file::stream_factory_t> stream_factory,
+               std::unique_ptr<file::flusher_factory_t> flusher_factory,
+               std::size_t files,
+               const file::rotation_t& rotation,
+               const file::indexing_t& indexing) :
+    stream_factory(std::move(stream_factory)),
+    flusher_factory(std::move(flusher_factory)),
+    archiver(rotation.enabled() ? new file::archiver_t(rotation) : nullptr),
+    pattern(detail::formatter::string::path(path)),
+    indexing(indexing),
+    backends(files),
+    slots(new file::slots_t(files)),
+    subscription(0),
+    loan(nullptr)
+{
+    data.path = path;
+    subscribe();
+}
+
+file_t::file_t(const std::string& path,
+               std::size_t capacity,
+               std::unique_ptr<file::flusher_factory_t> flusher_factory,
+               std::size_t files,
+               const file::rotation_t& rotation) :
+    archiver(rotation.enabled() ? new file::archiver_t(rotation) : nullptr),
+    pattern(detail::formatter::string::path(path)),
+    backends(files),
+    locals(new file::locals_t(capacity, std::move(flusher_factory), files, archiver.get())),
+    subscription(0),
+    loan(nullptr)
+{
+    data.path = path;
+}
+
+file_t::file_t(const std::string& path,
+               file::durable_t,
+               std::size_t files,
+               const file::rotation_t& rotation) :
+    archiver(rotation.enabled() ? new file::archiver_t(rotation) : nullptr),
+    pattern(detail::formatter::string::path(path)),
+    backends(files),
+    committers(new file::lru_t<std::shared_ptr<file::committer_t>>(files)),
+    subscription(0),
+    loan(nullptr)
+{
+    data.path = path;
+}
+
+file_t::~file_t() {
+    if (timer) {
+        timer->unsubscribe(subscription);
     }
+}
 
-    builder<sink::file_t> builder(filename.get());
+auto file_t::path() const -> const std::string& {
+    return data.path;
+}
 
-    if (auto flush = config["flush"]) {
-        if (flush.unwrap()->is_uint64()) {
-            builder.flush_every(flush.unwrap()->to_uint64());
+auto file_t::filename(const record_t& record) const -> std::string {
+    writer_t writer;
+    return filename(record, writer).to_string();
+}
+
+auto file_t::filename(const record_t& record, writer_t& writer) const -> string_view {
+    if (pattern == nullptr) {
+        return data.path;
+    }
+
+    const auto offset = writer.inner.size();
+    pattern->format(record, writer);
+
+    return string_view(writer.inner.data() + offset, writer.inner.size() - offset);
+}
+
+auto file_t::backend(const string_view& filename) -> file::backend_t& {
+    return backends.get(filename, [&](const string_view& filename) {
+        return open(filename);
+    });
+}
+
+auto file_t::open(const string_view& filename) -> file::backend_t {
+    auto stream = stream_factory->create(filename.to_string(), std::ios_base::app);
+    auto flusher = flusher_factory->create();
+
+    std::unique_ptr<file::rotator_t> rotator;
+    if (archiver) {
+        rotator.reset(new file::rotator_t(archiver->policy()));
+    }
+
+    // The index is opened after the stream, which creates the file it continues.
+    std::unique_ptr<file::index_t> index;
+    if (indexing.enabled()) {
+        index.reset(new file::index_t(filename.to_string(), indexing));
+    }
+
+    return file::backend_t(std::move(stream), std::move(flusher), std::move(rotator),
+        std::move(index));
+}
+
+auto file_t::subscribe() -> void {
+    if (flusher_factory == nullptr || !flusher_factory->timed()) {
+        return;
+    }
+
+    timer = file::flusher::timer_t::instance();
+    subscription = timer->subscribe([this] {
+        const auto poll = [](file::lru_t<file::backend_t>& backends) {
+            backends.each([](file::backend_t& backend) {
+                backend.poll();
+            });
+        };
+
+        if (slots) {
+            slots->poll(poll);
+            return;
         }
 
-        if (flush.unwrap()->is_string()) {
-            const auto bytes = sink::file::flusher::parse_dunit(flush.unwrap()->to_string());
-            builder.flush_every(bytes_t(bytes));
+        // Skipping the round while the sink is busy is fine, because writes check the elapsed
+        // time by themselves, but stalling the timer shared between sinks is not.
+        std::unique_lock<detail::mutex_t> lock(mutex, std::try_to_lock);
+        if (lock.owns_lock()) {
+            poll(backends);
+        }
+    });
+}
+
+auto file_t::committer(const string_view& filename) -> std::shared_ptr<file::committer_t> {
+    std::lock_guard<detail::mutex_t> lock(mutex);
+
+    // Committers are shared, so evicted ones are kept alive by writers still waiting on them.
+    return committers->get(filename, [&](const string_view& filename) {
+        return std::make_shared<file::committer_t>(filename.to_string(), archiver.get());
+    });
+}
+
+auto file_t::rotate(const string_view& filename, file::backend_t& backend) -> void {
+    if (!backend.expired()) {
+        return;
+    }
+
+    const auto name = filename.to_string();
+
+    // The file is renamed while still open, so no data is lost, then the backend switches to the
+    // freshly created file. Compression is left for the archiver thread.
+    backend.flush();
+    archiver->archive(name);
+    backend.reopen(stream_factory->create(name, std::ios_base::app));
+}
+
+auto file_t::rotate(std::unique_lock<detail::mutex_t>& lock, const string_view& filename,
+    file::backend_t& backend) -> void
+{
+    if (!backend.claim()) {
+        return;
+    }
+
+    const auto name = filename.to_string();
+    lock.unlock();
+
+    // The file is renamed while still open, so concurrent writers keep appending to the archived
+    // one until the new stream is swapped in. Compression is left for the archiver thread.
+    std::unique_ptr<std::ostream> stream;
+    try {
+        archiver->archive(name);
+        stream = stream_factory->create(name, std::ios_base::app);
+    } catch (...) {
+        lock.lock();
+        if (backends.contains(name)) {
+            this->backend(name).release();
+        }
+
+        throw;
+    }
+
+    lock.lock();
+
+    // The backend could have been evicted meanwhile, in which case the reopened one already writes
+    // into the new file.
+    if (backends.contains(name)) {
+        auto& current = this->backend(name);
+        current.flush();
+        current.reopen(std::move(stream));
+    }
+}
+
+auto file_t::emit(const record_t& record, const string_view& formatted) -> void {
+    // Uses an inline buffer, which is large enough to require no allocation for common paths.
+    writer_t writer;
+    const auto filename = this->filename(record, writer);
+
+    if (locals) {
+        locals->local().write(*locals, filename, formatted);
+        return;
+    }
+
+    if (committers) {
+        committer(filename)->write(formatted);
+        return;
+    }
+
+    if (slots) {
+        writer_t isolated;
+        const auto name = file::isolate(filename, detail::this_thread::lwp(), isolated);
+
+        auto& slot = slots->local();
+        std::lock_guard<std::mutex> lock(slot.mutex);
+
+        auto& backend = slot.backends->get(name, [&](const string_view& name) {
+            return open(name);
+        });
+        backend.mark(record.timestamp());
+        backend.write(formatted);
+        rotate(name, backend);
+        return;
+    }
+
+    std::unique_lock<detail::mutex_t> lock(mutex);
+
+    auto& backend = this->backend(filename);
+    backend.mark(record.timestamp());
+    backend.write(formatted);
+    rotate(lock, filename, backend);
+}
+
+auto file_t::emit_gathered(const record_t& record, const string_view* slices, std::size_t count) ->
+    void
+{
+    if (locals || committers) {
+        sink_t::emit_gathered(record, slices, count);
+        return;
+    }
+
+    writer_t writer;
+    const auto filename = this->filename(record, writer);
+
+    if (slots) {
+        writer_t isolated;
+        const auto name = file::isolate(filename, detail::this_thread::lwp(), isolated);
+
+        auto& slot = slots->local();
+        std::lock_guard<std::mutex> lock(slot.mutex);
+
+        auto& backend = slot.backends->get(name, [&](const string_view& name) {
+            return open(name);
+        });
+        backend.mark(record.timestamp());
+        backend.write(slices, count);
+        rotate(name, backend);
+        return;
+    }
+
+    std::unique_lock<detail::mutex_t> lock(mutex);
+
+    auto& backend = this->backend(filename);
+    backend.mark(record.timestamp());
+    backend.write(slices, count);
+    rotate(lock, filename, backend);
+}
+
+auto file_t::emit_batch(const event_t* events, std::size_t size) -> void {
+    // All file names are rendered one after another into the single buffer, because views can
+    // only be taken after it stops growing.
+    writer_t writer;
+    boost::container::small_vector<std::size_t, 64> bounds;
+
+    if (pattern != nullptr) {
+        bounds.reserve(size + 1);
+        bounds.push_back(0);
+
+        for (std::size_t id = 0; id < size; ++id) {
+            this->filename(*events[id].record, writer);
+            bounds.push_back(writer.inner.size());
+        }
+    }
+
+    const auto filename = [&](std::size_t id) -> string_view {
+        if (pattern == nullptr) {
+            return data.path;
+        }
+
+        return string_view(writer.inner.data() + bounds[id], bounds[id + 1] - bounds[id]);
+    };
+
+    if (locals) {
+        auto& local = locals->local();
+
+        for (std::size_t id = 0; id < size; ++id) {
+            local.write(*locals, filename(id), *events[id].message);
+        }
+
+        return;
+    }
+
+    if (committers) {
+        for (std::size_t id = 0; id < size;) {
+            std::size_t end = id + 1;
+            while (end < size && filename(end) == filename(id)) {
+                ++end;
+            }
+
+            committer(filename(id))->write(events + id, end - id);
+            id = end;
+        }
+
+        return;
+    }
+
+    if (slots) {
+        const auto tid = detail::this_thread::lwp();
+
+        auto& slot = slots->local();
+        std::lock_guard<std::mutex> lock(slot.mutex);
+
+        for (std::size_t id = 0; id < size;) {
+            writer_t isolated;
+            const auto name = file::isolate(filename(id), tid, isolated);
+
+            auto& backend = slot.backends->get(name, [&](const string_view& name) {
+                return open(name);
+            });
+
+            std::size_t end = id + 1;
+            while (end < size && filename(end) == filename(id)) {
+                ++end;
+            }
+
+            backend.write(events + id, end - id);
+            rotate(name, backend);
+            id = end;
+        }
+
+        return;
+    }
+
+    std::unique_lock<detail::mutex_t> lock(mutex);
+
+    // Consecutive events usually share the same destination, so the backend is looked up once for
+    // each such run.
+    for (std::size_t id = 0; id < size;) {
+        auto& backend = this->backend(filename(id));
+
+        std::size_t end = id + 1;
+        while (end < size && filename(end) == filename(id)) {
+            ++end;
+        }
+
+        backend.write(events + id, end - id);
+        rotate(lock, filename(id), backend);
+        id = end;
+    }
+}
+
+auto file_t::lend(const record_t& record, std::size_t size) -> region_t {
+    if (locals || committers) {
+        return region_t{nullptr, 0};
+    }
+
+    writer_t writer;
+    const auto filename = this->filename(record, writer);
+
+    if (slots) {
+        writer_t isolated;
+        const auto name = file::isolate(filename, detail::this_thread::lwp(), isolated);
+
+        auto& slot = slots->local();
+        std::unique_lock<std::mutex> lock(slot.mutex);
+
+        auto& backend = slot.backends->get(name, [&](const string_view& name) {
+            return open(name);
+        });
+        const auto region = backend.lend(size);
+
+        if (region.data != nullptr) {
+            slot.loan = &backend;
+            lock.release();
+        }
+
+        return region;
+    }
+
+    std::unique_lock<detail::mutex_t> lock(mutex);
+
+    auto& backend = this->backend(filename);
+    const auto region = backend.lend(size);
+
+    if (region.data != nullptr) {
+        // The lock is released by either committing or cancelling.
+        loan = &backend;
+        lock.release();
+    }
+
+    return region;
+}
+
+auto file_t::commit(const record_t& record, std::size_t size) -> void {
+    if (slots) {
+        // The slot is the one of the calling thread, since regions are never passed between them.
+        auto& slot = slots->local();
+        std::unique_lock<std::mutex> lock(slot.mutex, std::adopt_lock);
+
+        auto& backend = *slot.loan;
+        slot.loan = nullptr;
+
+        backend.mark(record.timestamp());
+        backend.commit(size);
+
+        if (backend.expired()) {
+            writer_t writer;
+            const auto filename = this->filename(record, writer);
+
+            writer_t isolated;
+            rotate(file::isolate(filename, detail::this_thread::lwp(), isolated), backend);
+        }
+
+        return;
+    }
+
+    std::unique_lock<detail::mutex_t> lock(mutex, std::adopt_lock);
+
+    auto& backend = *loan;
+    loan = nullptr;
+
+    backend.mark(record.timestamp());
+    backend.commit(size);
+
+    // The file name is rendered again, because it is required only for rotating.
+    if (backend.expired()) {
+        writer_t writer;
+        rotate(lock, this->filename(record, writer), backend);
+    }
+}
+
+auto file_t::cancel() noexcept -> void {
+    if (slots) {
+        auto& slot = slots->local();
+        slot.loan = nullptr;
+        slot.mutex.unlock();
+        return;
+    }
+
+    loan = nullptr;
+    mutex.unlock();
+}
+
+}  // namespace sink
+
+class builder<sink::file_t>::inner_t {
+public:
+    std::string filename;
+    std::unique_ptr<sink::file::flusher_factory_t> ffactory;
+    std::size_t buffer;
+    bool threaded;
+    bool durable;
+    bool isolated;
+    std::size_t files;
+    sink::file::rotation_t rotation;
+    int gzip;
+    bool uring;
+    detail::paging_t paging;
+    std::size_t writeback;
+    std::size_t preallocate;
+    sink::file::indexing_t indexing;
+};
+
+builder<sink::file_t>::builder(const std::string& path) :
+    p(new inner_t{path, nullptr, 0, false, false, false, 1024, sink::file::rotation_t(), 0, false,
+        detail::paging_t(), 0, 0, sink::file::indexing_t()}, deleter_t())
+{
+    p->ffactory = blackhole::make_unique<sink::file::flusher::repeat_factory_t>(std::size_t(0));
+}
+
+auto builder<sink::file_t>::flush_every(bytes_t bytes) & -> builder& {
+    p->ffactory = blackhole::make_unique<sink::file::flusher::bytecount_factory_t>(bytes.count());
+    return *this;
+}
+
+auto builder<sink::file_t>::flush_every(bytes_t bytes) && -> builder&& {
+    return std::move(flush_every(bytes));
+}
+
+auto builder<sink::file_t>::flush_every(std::size_t events) & -> builder& {
+    p->ffactory = blackhole::make_unique<sink::file::flusher::repeat_factory_t>(events);
+    return *this;
+}
+
+auto builder<sink::file_t>::flush_every(std::size_t events) && -> builder&& {
+    return std::move(flush_every(events));
+}
+
+auto builder<sink::file_t>::flush_every(std::chrono::milliseconds interval) & -> builder& {
+    p->ffactory = blackhole::make_unique<sink::file::flusher::interval_factory_t>(interval);
+    return *this;
+}
+
+auto builder<sink::file_t>::flush_every(std::chrono::milliseconds interval) && -> builder&& {
+    return std::move(flush_every(interval));
+}
+
+auto builder<sink::file_t>::flush_every(bytes_t bytes, std::chrono::milliseconds interval) & ->
+    builder&
+{
+    p->ffactory = blackhole::make_unique<sink::file::flusher::combined_factory_t>(bytes.count(),
+        interval);
+    return *this;
+}
+
+auto builder<sink::file_t>::flush_every(bytes_t bytes, std::chrono::milliseconds interval) && ->
+    builder&&
+{
+    return std::move(flush_every(bytes, interval));
+}
+
+auto builder<sink::file_t>::buffer(bytes_t bytes) & -> builder& {
+    p->buffer = static_cast<std::size_t>(bytes.count());
+    return *this;
+}
+
+auto builder<sink::file_t>::buffer(bytes_t bytes) && -> builder&& {
+    return std::move(buffer(bytes));
+}
+
+auto builder<sink::file_t>::memory(const detail::paging_t& paging) & -> builder& {
+    p->paging = paging;
+    return *this;
+}
+
+auto builder<sink::file_t>::memory(const detail::paging_t& paging) && -> builder&& {
+    return std::move(memory(paging));
+}
+
+auto builder<sink::file_t>::writeback(bytes_t bytes) & -> builder& {
+    p->writeback = bytes.count();
+    return *this;
+}
+
+auto builder<sink::file_t>::writeback(bytes_t bytes) && -> builder&& {
+    return std::move(writeback(bytes));
+}
+
+auto builder<sink::file_t>::preallocate(bytes_t bytes) & -> builder& {
+    p->preallocate = bytes.count();
+    return *this;
+}
+
+auto builder<sink::file_t>::preallocate(bytes_t bytes) && -> builder&& {
+    return std::move(preallocate(bytes));
+}
+
+auto builder<sink::file_t>::threaded() & -> builder& {
+    p->threaded = true;
+    return *this;
+}
+
+auto builder<sink::file_t>::threaded() && -> builder&& {
+    return std::move(threaded());
+}
+
+auto builder<sink::file_t>::uring() & -> builder& {
+    p->uring = true;
+    return *this;
+}
+
+auto builder<sink::file_t>::uring() && -> builder&& {
+    return std::move(uring());
+}
+
+auto builder<sink::file_t>::durable() & -> builder& {
+    p->durable = true;
+    return *this;
+}
+
+auto builder<sink::file_t>::durable() && -> builder&& {
+    return std::move(durable());
+}
+
+auto builder<sink::file_t>::isolated() & -> builder& {
+    p->isolated = true;
+    return *this;
+}
+
+auto builder<sink::file_t>::isolated() && -> builder&& {
+    return std::move(isolated());
+}
+
+auto builder<sink::file_t>::max_files(std::size_t count) & -> builder& {
+    p->files = count;
+    return *this;
+}
+
+auto builder<sink::file_t>::max_files(std::size_t count) && -> builder&& {
+    return std::move(max_files(count));
+}
+
+auto builder<sink::file_t>::rotate_every(bytes_t bytes) & -> builder& {
+    p->rotation.size = bytes.count();
+    return *this;
+}
+
+auto builder<sink::file_t>::rotate_every(bytes_t bytes) && -> builder&& {
+    return std::move(rotate_every(bytes));
+}
+
+auto builder<sink::file_t>::rotate_every(std::chrono::seconds interval) & -> builder& {
+    p->rotation.interval = interval;
+    return *this;
+}
+
+auto builder<sink::file_t>::rotate_every(std::chrono::seconds interval) && -> builder&& {
+    return std::move(rotate_every(interval));
+}
+
+auto builder<sink::file_t>::backups(std::size_t count) & -> builder& {
+    p->rotation.backups = count;
+    return *this;
+}
+
+auto builder<sink::file_t>::backups(std::size_t count) && -> builder&& {
+    return std::move(backups(count));
+}
+
+auto builder<sink::file_t>::compress() & -> builder& {
+    p->rotation.compress = true;
+    return *this;
+}
+
+auto builder<sink::file_t>::compress() && -> builder&& {
+    return std::move(compress());
+}
+
+auto builder<sink::file_t>::gzip(int level) & -> builder& {
+    if (level < 1 || level > 9) {
+        throw std::invalid_argument("compression level must be in [1; 9] range");
+    }
+
+    p->gzip = level;
+    return *this;
+}
+
+auto builder<sink::file_t>::gzip(int level) && -> builder&& {
+    return std::move(gzip(level));
+}
+
+auto builder<sink::file_t>::index(std::chrono::milliseconds interval, bytes_t bytes) & ->
+    builder&
+{
+    p->indexing.interval = interval;
+    p->indexing.size = bytes.count();
+    return *this;
+}
+
+auto builder<sink::file_t>::index(std::chrono::milliseconds interval, bytes_t bytes) && ->
+    builder&&
+{
+    return std::move(index(interval, bytes));
+}
+
+auto builder<sink::file_t>::build() && -> std::unique_ptr<sink_t> {
+    if (p->gzip != 0 && (p->durable || p->threaded)) {
+        throw std::invalid_argument("compression is supported only in the default stream mode");
+    }
+
+    if (p->uring && (p->durable || p->threaded)) {
+        throw std::invalid_argument("io_uring is supported only in the default stream mode");
+    }
+
+    if (p->indexing.enabled() && (p->gzip != 0 || p->durable || p->threaded)) {
+        throw std::invalid_argument(
+            "time index is supported only in the default stream mode without compression");
+    }
+
+    if (p->paging.enabled() && (p->buffer == 0 || p->uring || p->durable || p->threaded)) {
+        throw std::invalid_argument(
+            "memory paging properties are supported for buffered streams only");
+    }
+
+    if (p->writeback != 0 && (p->buffer == 0 || p->uring || p->durable || p->threaded)) {
+        throw std::invalid_argument("write-behind is supported for buffered streams only");
+    }
+
+    if (p->preallocate != 0 && (p->buffer == 0 || p->uring || p->durable || p->threaded)) {
+        throw std::invalid_argument("preallocation is supported for buffered streams only");
+    }
+
+    if (p->isolated && (p->durable || p->threaded)) {
+        throw std::invalid_argument("isolated mode is supported only in the default stream mode");
+    }
+
+    if (p->durable) {
+        if (p->threaded) {
+            throw std::invalid_argument("durable and threaded modes are mutually exclusive");
+        }
+
+        return blackhole::make_unique<sink::file_t>(
+            std::move(p->filename),
+            sink::file::durable_t(),
+            p->files,
+            p->rotation);
+    }
+
+    if (p->threaded) {
+        const auto capacity = p->buffer == 0 ? std::size_t(64 * 1024) : p->buffer;
+
+        return blackhole::make_unique<sink::file_t>(
+            std::move(p->filename),
+            capacity,
+            std::move(p->ffactory),
+            p->files,
+            p->rotation);
+    }
+
+    std::unique_ptr<sink::file::stream_factory_t> sfactory;
+
+    if (p->uring) {
+        const auto capacity = p->buffer == 0 ? std::size_t(64 * 1024) : p->buffer;
+        sfactory = blackhole::make_unique<sink::file::uringstream_factory_t>(capacity);
+    } else if (p->buffer == 0) {
+        sfactory = blackhole::make_unique<sink::file::ofstream_factory_t>();
+    } else {
+        sfactory = blackhole::make_unique<sink::file::fdstream_factory_t>(p->buffer,
+            p->paging, p->writeback, p->preallocate);
+    }
+
+    if (p->gzip != 0) {
+        sfactory = blackhole::make_unique<sink::file::deflate_factory_t>(std::move(sfactory),
+            p->gzip);
+    }
+
+    if (p->isolated) {
+        return blackhole::make_unique<sink::file_t>(
+            std::move(p->filename),
+            sink::file::isolated_t(),
+            std::move(sfactory),
+            std::move(p->ffactory),
+            p->files,
+            p->rotation,
+            p->indexing);
+    }
+
+    return blackhole::make_unique<sink::file_t>(
+        std::move(p->filename),
+        std::move(sfactory),
+        std::move(p->ffactory),
+        p->files,
+        p->rotation,
+        p->indexing);
+}
+
+namespace {
+
+/// Checks whether the given encoded value has time units, like "100ms".
+auto is_tunit(const std::string& encoded) -> bool {
+    return (encoded.size() > 1 && encoded.back() == 's') ||
+        (encoded.size() > 3 && encoded.compare(encoded.size() - 3, 3, "min") == 0);
+}
+
+}  // namespace
+
+auto factory<sink::file_t>::type() const noexcept -> const char* {
+    return "file";
+}
+
+auto factory<sink::file_t>::from(const config::node_t& config) const -> std::unique_ptr<sink_t> {
+    (void)registry;
+    const auto filename = config["path"].to_string();
+
+    if (!filename) {
+        throw std::invalid_argument("field 'path' is required");
+    }
+
+    builder<sink::file_t> builder(filename.get());
+
+    if (auto flush = config["flush"]) {
+        const auto is_uint64 = flush.unwrap()->is_uint64();
+        if (is_uint64) {
+            builder.flush_every(flush.unwrap()->to_uint64());
+        }
+
+        const auto is_string = flush.unwrap()->is_string();
+        if (is_string) {
+            const auto value = flush.unwrap()->to_string();
+
+            if (is_tunit(value)) {
+                builder.flush_every(sink::file::flusher::parse_tunit(value));
+            } else {
+                builder.flush_every(bytes_t(sink::file::flusher::parse_dunit(value)));
+            }
+        }
+
+        // Combined policy, like `{"bytes": "1MB", "interval": "100ms"}`.
+        if (!is_uint64 && !is_string) {
+            const auto bytes = flush["bytes"].to_string();
+            const auto interval = flush["interval"].to_string();
+
+            if (!bytes || !interval) {
+                throw std::invalid_argument("combined flush policy requires both 'bytes' and 'interval' fields");
+            }
+
+            builder.flush_every(bytes_t(sink::file::flusher::parse_dunit(bytes.get())),
+                sink::file::flusher::parse_tunit(interval.get()));
+        }
+    }
+
+    if (auto buffer = config["buffer"]) {
+        if (buffer.unwrap()->is_uint64()) {
+            builder.buffer(bytes_t(buffer.unwrap()->to_uint64()));
+        }
+
+        if (buffer.unwrap()->is_string()) {
+            const auto bytes = sink::file::flusher::parse_dunit(buffer.unwrap()->to_string());
+            builder.buffer(bytes_t(bytes));
+        }
+    }
+
+    if (auto memory = config["memory"]) {
+        detail::paging_t paging;
+        paging.huge = memory["huge"].to_bool().get_value_or(false);
+        paging.populate = memory["populate"].to_bool().get_value_or(false);
+        paging.lock = memory["lock"].to_bool().get_value_or(false);
+        builder.memory(paging);
+    }
+
+    if (auto writeback = config["writeback"]) {
+        if (writeback.unwrap()->is_uint64()) {
+            builder.writeback(bytes_t(writeback.unwrap()->to_uint64()));
+        }
+
+        if (writeback.unwrap()->is_string()) {
+            const auto bytes = sink::file::flusher::parse_dunit(writeback.unwrap()->to_string());
+            builder.writeback(bytes_t(bytes));
+        }
+    }
+
+    if (auto preallocate = config["preallocate"]) {
+        if (preallocate.unwrap()->is_uint64()) {
+            builder.preallocate(bytes_t(preallocate.unwrap()->to_uint64()));
+        }
+
+        if (preallocate.unwrap()->is_string()) {
+            const auto bytes = sink::file::flusher::parse_dunit(preallocate.unwrap()->to_string());
+            builder.preallocate(bytes_t(bytes));
+        }
+    }
+
+    if (auto threaded = config["threaded"].to_bool()) {
+        if (threaded.get()) {
+            builder.threaded();
+        }
+    }
+
+    if (auto uring = config["uring"].to_bool()) {
+        if (uring.get()) {
+            builder.uring();
+        }
+    }
+
+    if (auto durable = config["durable"].to_bool()) {
+        if (durable.get()) {
+            builder.durable();
+        }
+    }
+
+    if (auto isolated = config["isolated"].to_bool()) {
+        if (isolated.get()) {
+            builder.isolated();
+        }
+    }
+
+    if (auto files = config["files"].to_uint64()) {
+        builder.max_files(static_cast<std::size_t>(files.get()));
+    }
+
+    if (auto rotation = config["rotation"]) {
+        if (auto size = rotation["size"]) {
+            if (size.unwrap()->is_uint64()) {
+                builder.rotate_every(bytes_t(size.unwrap()->to_uint64()));
+            }
+
+            if (size.unwrap()->is_string()) {
+                const auto bytes = sink::file::flusher::parse_dunit(size.unwrap()->to_string());
+                builder.rotate_every(bytes_t(bytes));
+            }
+        }
+
+        if (auto interval = rotation["interval"].to_uint64()) {
+            builder.rotate_every(std::chrono::seconds(interval.get()));
+        }
+
+        if (auto backups = rotation["backups"].to_uint64()) {
+            builder.backups(static_cast<std::size_t>(backups.get()));
+        }
+
+        if (auto compress = rotation["compress"].to_bool()) {
+            if (compress.get()) {
+                builder.compress();
+            }
+        }
+    }
+
+    // Either a type name, like "gzip", or an object, like `{"type": "gzip", "level": 6}`.
+    if (auto compression = config["compression"]) {
+        const auto is_string = compression.unwrap()->is_string();
+        const auto type = is_string ? compression.to_string() : compression["type"].to_string();
+
+        if (!type || type.get() != "gzip") {
+            throw std::invalid_argument("unknown compression type, only \"gzip\" is supported");
+        }
+
+        int level = 6;
+        if (!is_string) {
+            if (auto value = compression["level"].to_uint64()) {
+                level = static_cast<int>(value.get());
+            }
+        }
+
+        builder.gzip(level);
+    }
+
+    // Either a flag enabling the default policy or an object, like
+    // `{"interval": "1s", "bytes": "1MB"}`, with omitted fields disabling the corresponding limit.
+    if (auto index = config["index"]) {
+        if (index.unwrap()->is_bool()) {
+            if (index.unwrap()->to_bool()) {
+                builder.index();
+            }
+        } else {
+            std::chrono::milliseconds interval(0);
+            if (auto value = index["interval"].to_string()) {
+                interval = sink::file::flusher::parse_tunit(value.get());
+            }
+
+            std::uint64_t bytes = 0;
+            if (auto value = index["bytes"]) {
+                if (value.unwrap()->is_uint64()) {
+                    bytes = value.unwrap()->to_uint64();
+                } else {
+                    bytes = sink::file::flusher::parse_dunit(value.unwrap()->to_string());
+                }
+            }
+
+            if (interval.count() == 0 && bytes == 0) {
+                throw std::invalid_argument(
+                    "time index requires either 'interval' or 'bytes' field");
+            }
+
+            builder.index(interval, bytes_t(bytes));
         }
     }
 
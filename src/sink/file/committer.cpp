@@ -0,0 +1,80 @@
+#include "blackhole/detail/sink/file/committer.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+namespace file {
+namespace {
+
+auto append(std::vector<char>& data, const string_view& message) -> void {
+    data.insert(data.end(), message.data(), message.data() + message.size());
+    data.push_back('\n');
+}
+
+}  // namespace
+
+committer_t::committer_t(const std::string& filename, archiver_t* archiver) :
+    descriptor(filename, archiver),
+    current(std::make_shared<group_t>()),
+    active(false)
+{}
+
+auto committer_t::write(const string_view& message) -> void {
+    commit([&](std::vector<char>& data) {
+        append(data, message);
+    });
+}
+
+auto committer_t::write(const sink_t::event_t* events, std::size_t size) -> void {
+    commit([&](std::vector<char>& data) {
+        for (std::size_t id = 0; id < size; ++id) {
+            append(data, *events[id].message);
+        }
+    });
+}
+
+template<typename F>
+auto committer_t::commit(F&& append) -> void {
+    std::unique_lock<std::mutex> lock(mutex);
+
+    append(current->data);
+    const auto group = current;
+
+    while (!group->done) {
+        if (active) {
+            cv.wait(lock);
+            continue;
+        }
+
+        // Becoming a leader is possible only while the own group is still being collected, because
+        // taken groups are either done or being committed by the active leader.
+        active = true;
+
+        const auto batch = std::move(current);
+        current = std::make_shared<group_t>();
+
+        lock.unlock();
+
+        try {
+            descriptor.write(string_view(batch->data.data(), batch->data.size()), string_view());
+            descriptor.sync();
+        } catch (...) {
+            batch->error = std::current_exception();
+        }
+
+        lock.lock();
+
+        batch->done = true;
+        active = false;
+        cv.notify_all();
+    }
+
+    if (group->error) {
+        std::rethrow_exception(group->error);
+    }
+}
+
+}  // namespace file
+}  // namespace sink
+}  // namespace v1
+}  // namespace blackhole
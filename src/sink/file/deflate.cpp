@@ -0,0 +1,153 @@
+#include "blackhole/detail/sink/file/deflate.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include <zlib.h>
+
+#include "blackhole/detail/memory.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+namespace file {
+
+struct deflatebuf_t::state_t {
+    z_stream stream;
+};
+
+deflatebuf_t::deflatebuf_t(std::unique_ptr<std::ostream> inner, int level, std::size_t capacity) :
+    inner(std::move(inner)),
+    state(new state_t),
+    input(std::max<std::size_t>(capacity, 1)),
+    dirty(false)
+{
+    if (level < 1 || level > 9) {
+        throw std::invalid_argument("compression level must be in [1; 9] range");
+    }
+
+    std::memset(&state->stream, 0, sizeof(state->stream));
+
+    // Window bits increased by 16 tell zlib to write gzip header and trailer.
+    if (::deflateInit2(&state->stream, level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        throw std::bad_alloc();
+    }
+
+    setp(input.data(), input.data() + input.size());
+}
+
+deflatebuf_t::~deflatebuf_t() {
+    commit(nullptr, 0, Z_FINISH);
+    inner->rdbuf()->pubsync();
+
+    ::deflateEnd(&state->stream);
+}
+
+auto deflatebuf_t::overflow(int_type ch) -> int_type {
+    if (!commit(nullptr, 0, Z_NO_FLUSH)) {
+        return traits_type::eof();
+    }
+
+    if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(ch);
+        pbump(1);
+    }
+
+    return traits_type::not_eof(ch);
+}
+
+auto deflatebuf_t::xsputn(const char_type* data, std::streamsize size) -> std::streamsize {
+    if (size <= epptr() - pptr()) {
+        std::memcpy(pptr(), data, static_cast<std::size_t>(size));
+        pbump(static_cast<int>(size));
+        return size;
+    }
+
+    if (!commit(data, static_cast<std::size_t>(size), Z_NO_FLUSH)) {
+        return 0;
+    }
+
+    return size;
+}
+
+auto deflatebuf_t::sync() -> int {
+    if (pptr() == pbase() && !dirty) {
+        return inner->rdbuf()->pubsync();
+    }
+
+    if (!commit(nullptr, 0, Z_SYNC_FLUSH)) {
+        return -1;
+    }
+
+    dirty = false;
+    return inner->rdbuf()->pubsync();
+}
+
+auto deflatebuf_t::commit(const char* data, std::size_t size, int flush) -> bool {
+    const auto pending = static_cast<std::size_t>(pptr() - pbase());
+    setp(input.data(), input.data() + input.size());
+
+    if (pending > 0 || size > 0) {
+        dirty = true;
+    }
+
+    if (size == 0) {
+        return compress(input.data(), pending, flush);
+    }
+
+    return compress(input.data(), pending, Z_NO_FLUSH) && compress(data, size, flush);
+}
+
+auto deflatebuf_t::compress(const char* data, std::size_t size, int flush) -> bool {
+    auto& stream = state->stream;
+    auto& buf = *inner->rdbuf();
+
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+    stream.avail_in = static_cast<uInt>(size);
+
+    char output[16 * 1024];
+
+    do {
+        stream.next_out = reinterpret_cast<Bytef*>(output);
+        stream.avail_out = sizeof(output);
+
+        if (::deflate(&stream, flush) == Z_STREAM_ERROR) {
+            return false;
+        }
+
+        const auto nwritten = static_cast<std::streamsize>(sizeof(output) - stream.avail_out);
+        if (nwritten > 0 && buf.sputn(output, nwritten) != nwritten) {
+            return false;
+        }
+    } while (stream.avail_out == 0);
+
+    return true;
+}
+
+deflatestream_t::deflatestream_t(std::unique_ptr<std::ostream> inner, int level) :
+    std::ostream(nullptr),
+    buf(std::move(inner), level)
+{
+    rdbuf(&buf);
+}
+
+deflate_factory_t::deflate_factory_t(std::unique_ptr<stream_factory_t> inner, int level) :
+    inner(std::move(inner)),
+    level(level)
+{}
+
+auto deflate_factory_t::create(const std::string& filename, std::ios_base::openmode mode) const ->
+    std::unique_ptr<std::ostream>
+{
+    auto stream = blackhole::make_unique<deflatestream_t>(
+        inner->create(filename, mode | std::ios_base::binary), level);
+    stream->exceptions(std::ios_base::failbit | std::ios_base::badbit);
+
+    return std::unique_ptr<std::ostream>(stream.release());
+}
+
+}  // namespace file
+}  // namespace sink
+}  // namespace v1
+}  // namespace blackhole
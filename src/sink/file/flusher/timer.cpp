@@ -0,0 +1,104 @@
+#include "blackhole/detail/sink/file/flusher/timer.hpp"
+
+#include "blackhole/detail/error.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+namespace file {
+namespace flusher {
+
+constexpr std::chrono::milliseconds::rep timer_t::resolution;
+
+timer_t::timer_t() :
+    birth(std::chrono::steady_clock::now()),
+    now_(0),
+    counter(0),
+    stopped(false)
+{
+    thread = std::thread(&timer_t::run, this);
+}
+
+timer_t::~timer_t() {
+    {
+        std::lock_guard<std::mutex> lock(stop_mutex);
+        stopped = true;
+    }
+
+    cv.notify_one();
+    thread.join();
+}
+
+auto timer_t::instance() -> std::shared_ptr<timer_t> {
+    static std::mutex mutex;
+    static std::weak_ptr<timer_t> instance;
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto timer = instance.lock();
+    if (timer == nullptr) {
+        timer = std::make_shared<timer_t>();
+        instance = timer;
+    }
+
+    return timer;
+}
+
+auto timer_t::now() const noexcept -> std::uint64_t {
+    return now_.load(std::memory_order_relaxed);
+}
+
+auto timer_t::subscribe(callback_type callback) -> std::uint64_t {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    const auto id = ++counter;
+    callbacks.emplace(id, std::move(callback));
+
+    return id;
+}
+
+auto timer_t::unsubscribe(std::uint64_t id) -> void {
+    std::lock_guard<std::mutex> lock(mutex);
+    callbacks.erase(id);
+}
+
+auto timer_t::run() -> void {
+    std::unique_lock<std::mutex> lock(stop_mutex);
+
+    while (true) {
+        cv.wait_for(lock, std::chrono::milliseconds(resolution), [&] {
+            return stopped;
+        });
+
+        if (stopped) {
+            return;
+        }
+
+        const auto elapsed = std::chrono::steady_clock::now() - birth;
+        now_.store(static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count()),
+            std::memory_order_relaxed);
+
+        lock.unlock();
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+
+            for (const auto& callback : callbacks) {
+                try {
+                    callback.second();
+                } catch (const std::exception& err) {
+                    detail::error::report(error::kind_t::sink, err.what());
+                }
+            }
+        }
+
+        lock.lock();
+    }
+}
+
+}  // namespace flusher
+}  // namespace file
+}  // namespace sink
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,285 @@
+#include "blackhole/detail/sink/file/index.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "blackhole/detail/error.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+namespace file {
+namespace {
+
+constexpr std::size_t entry_size = 16;
+
+auto error() -> std::system_error {
+    return std::system_error(errno != 0 ? errno : EIO, std::system_category());
+}
+
+auto encode(std::uint64_t value, char* data) noexcept -> void {
+    for (std::size_t id = 0; id < 8; ++id) {
+        data[id] = static_cast<char>((value >> (8 * id)) & 0xff);
+    }
+}
+
+auto decode(const char* data) noexcept -> std::uint64_t {
+    std::uint64_t value = 0;
+    for (std::size_t id = 0; id < 8; ++id) {
+        value |= static_cast<std::uint64_t>(static_cast<unsigned char>(data[id])) << (8 * id);
+    }
+
+    return value;
+}
+
+auto decode(const char* data, index_t::entry_t& entry) noexcept -> void {
+    entry.timestamp = static_cast<std::int64_t>(decode(data));
+    entry.offset = decode(data + 8);
+}
+
+auto nanoseconds(index_t::time_point timestamp) -> std::int64_t {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(timestamp.time_since_epoch())
+        .count();
+}
+
+auto write(int fd, const char* data, std::size_t size) -> void {
+    while (size > 0) {
+        const auto nwritten = ::write(fd, data, size);
+
+        if (nwritten < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            throw error();
+        }
+
+        data += nwritten;
+        size -= static_cast<std::size_t>(nwritten);
+    }
+}
+
+}  // namespace
+
+constexpr const char* index_t::magic;
+constexpr std::size_t index_t::header;
+constexpr std::size_t index_t::batch;
+
+index_t::index_t(const std::string& filename, const indexing_t& policy) :
+    policy(policy),
+    fd(::open(path(filename).c_str(), O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644)),
+    offset(0),
+    marked(false),
+    last{0, 0}
+{
+    if (fd < 0) {
+        throw error();
+    }
+
+    struct ::stat stat;
+
+    if (::stat(filename.c_str(), &stat) == 0) {
+        offset = static_cast<std::uint64_t>(stat.st_size);
+    }
+
+    if (::fstat(fd, &stat) != 0) {
+        const auto err = error();
+        ::close(fd);
+        throw err;
+    }
+
+    const auto size = static_cast<std::uint64_t>(stat.st_size);
+    const auto complete = size < header ? 0 : header + (size - header) / entry_size * entry_size;
+
+    // The last entry is continued from, unless it refers past the end of the file, which means
+    // that the file has been replaced meanwhile.
+    char data[entry_size];
+    if (complete > header &&
+        ::pread(fd, data, entry_size, static_cast<off_t>(complete - entry_size)) ==
+            static_cast<ssize_t>(entry_size))
+    {
+        decode(data, last);
+        marked = last.offset <= offset;
+    }
+
+    try {
+        if (complete > header && !marked) {
+            reset();
+        } else if (size != complete || size == 0) {
+            if (::ftruncate(fd, static_cast<off_t>(complete)) != 0) {
+                throw error();
+            }
+
+            if (complete == 0) {
+                write(fd, magic, header);
+            }
+        }
+    } catch (...) {
+        ::close(fd);
+        throw;
+    }
+}
+
+index_t::~index_t() {
+    try {
+        flush();
+    } catch (const std::exception& err) {
+        detail::error::report(error::kind_t::sink, err.what());
+    }
+
+    ::close(fd);
+}
+
+auto index_t::path(const std::string& filename) -> std::string {
+    return filename + ".idx";
+}
+
+auto index_t::position() const noexcept -> std::uint64_t {
+    return offset;
+}
+
+auto index_t::update(time_point timestamp) -> void {
+    const auto now = nanoseconds(timestamp);
+
+    if (marked) {
+        if (offset == last.offset) {
+            return;
+        }
+
+        const auto interval =
+            std::chrono::duration_cast<std::chrono::nanoseconds>(policy.interval).count();
+
+        const auto elapsed = interval != 0 && now - last.timestamp >= interval;
+        const auto grown = policy.size != 0 && offset - last.offset >= policy.size;
+
+        if (!elapsed && !grown) {
+            return;
+        }
+    }
+
+    last = entry_t{marked ? std::max(now, last.timestamp) : now, offset};
+    marked = true;
+    pending.push_back(last);
+
+    if (pending.size() >= batch) {
+        flush();
+    }
+}
+
+auto index_t::advance(std::size_t nwritten) noexcept -> void {
+    offset += nwritten;
+}
+
+auto index_t::flush() -> void {
+    if (pending.empty()) {
+        return;
+    }
+
+    std::vector<char> data(pending.size() * entry_size);
+    for (std::size_t id = 0; id < pending.size(); ++id) {
+        encode(static_cast<std::uint64_t>(pending[id].timestamp), &data[id * entry_size]);
+        encode(pending[id].offset, &data[id * entry_size + 8]);
+    }
+
+    // Entries are dropped even on failure, because retrying would duplicate partially written
+    // ones.
+    pending.clear();
+    write(fd, data.data(), data.size());
+}
+
+auto index_t::reset() -> void {
+    pending.clear();
+    offset = 0;
+    marked = false;
+
+    if (::ftruncate(fd, static_cast<off_t>(header)) != 0) {
+        throw error();
+    }
+}
+
+auto index_t::read(const std::string& filename) -> std::vector<entry_t> {
+    const auto fd = ::open(path(filename).c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw error();
+    }
+
+    std::vector<char> data;
+    char buffer[64 * 1024];
+
+    for (;;) {
+        const auto nread = ::read(fd, buffer, sizeof(buffer));
+
+        if (nread < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            const auto err = error();
+            ::close(fd);
+            throw err;
+        }
+
+        if (nread == 0) {
+            break;
+        }
+
+        data.insert(data.end(), buffer, buffer + nread);
+    }
+
+    ::close(fd);
+
+    if (data.size() < header || std::memcmp(data.data(), magic, header) != 0) {
+        throw std::runtime_error("malformed time index header");
+    }
+
+    std::vector<entry_t> entries((data.size() - header) / entry_size);
+    for (std::size_t id = 0; id < entries.size(); ++id) {
+        decode(&data[header + id * entry_size], entries[id]);
+    }
+
+    return entries;
+}
+
+auto index_t::begin(const std::vector<entry_t>& entries, time_point timestamp) -> std::uint64_t {
+    const auto value = nanoseconds(timestamp);
+
+    const auto it = std::lower_bound(entries.begin(), entries.end(), value,
+        [](const entry_t& entry, std::int64_t value) {
+            return entry.timestamp < value;
+        });
+
+    if (it == entries.begin()) {
+        return 0;
+    }
+
+    return std::prev(it)->offset;
+}
+
+auto index_t::end(const std::vector<entry_t>& entries, time_point timestamp) -> std::uint64_t {
+    const auto value = nanoseconds(timestamp);
+
+    const auto it = std::upper_bound(entries.begin(), entries.end(), value,
+        [](std::int64_t value, const entry_t& entry) {
+            return value < entry.timestamp;
+        });
+
+    if (it == entries.end()) {
+        return std::numeric_limits<std::uint64_t>::max();
+    }
+
+    return it->offset;
+}
+
+}  // namespace file
+}  // namespace sink
+}  // namespace v1
+}  // namespace blackhole
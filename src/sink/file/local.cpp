@@ -0,0 +1,335 @@
+#include "blackhole/detail/sink/file/local.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <iterator>
+#include <system_error>
+#include <unordered_map>
+
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "blackhole/detail/error.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+namespace file {
+namespace {
+
+/// Maximum time the pending data of idle threads stays in their buffers.
+constexpr auto interval = std::chrono::milliseconds(100);
+
+std::atomic<std::uint64_t> counter(0);
+
+auto open(const std::string& filename) -> int {
+    const auto fd = ::open(filename.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+
+    if (fd == -1) {
+        throw std::system_error(errno, std::system_category());
+    }
+
+    return fd;
+}
+
+}  // namespace
+
+descriptor_t::descriptor_t(const std::string& filename, archiver_t* archiver) :
+    fd(open(filename)),
+    filename(filename),
+    archiver(archiver)
+{
+    if (archiver && archiver->policy().enabled()) {
+        rotator.reset(new rotator_t(archiver->policy()));
+    }
+}
+
+descriptor_t::~descriptor_t() {
+    ::close(fd);
+}
+
+auto descriptor_t::write(const string_view& head, const string_view& tail) -> void {
+    ::iovec iov[2] = {
+        {const_cast<char*>(head.data()), head.size()},
+        {const_cast<char*>(tail.data()), tail.size()}
+    };
+
+    auto it = iov;
+    auto count = tail.size() == 0 ? 1 : 2;
+
+    while (count > 0) {
+        const auto rc = ::writev(fd, it, count);
+
+        if (rc == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            throw std::system_error(errno, std::system_category());
+        }
+
+        auto written = static_cast<std::size_t>(rc);
+        while (count > 0 && written >= it->iov_len) {
+            written -= it->iov_len;
+            ++it;
+            --count;
+        }
+
+        if (count > 0) {
+            it->iov_base = static_cast<char*>(it->iov_base) + written;
+            it->iov_len -= written;
+        }
+    }
+
+    if (rotator && rotator->update(head.size() + tail.size())) {
+        rotate();
+    }
+}
+
+auto descriptor_t::sync() -> void {
+    if (::fdatasync(fd) != 0) {
+        throw std::system_error(errno, std::system_category());
+    }
+}
+
+auto descriptor_t::rotate() -> void {
+    try {
+        archiver->archive(filename);
+
+        const auto next = open(filename);
+        const auto rc = ::dup2(next, fd);
+        const auto err = errno;
+        ::close(next);
+
+        if (rc == -1) {
+            throw std::system_error(err, std::system_category());
+        }
+    } catch (...) {
+        rotator->reset();
+        throw;
+    }
+
+    rotator->reset();
+}
+
+local_t::local_t(std::size_t capacity, std::unique_ptr<flusher_t> flusher) :
+    capacity(capacity),
+    flusher(std::move(flusher)),
+    closed(false),
+    registration([](const void* context, int fd) {
+        // The buffer is never reallocated while open, since it's reserved up to its capacity.
+        const auto& buffer = static_cast<const local_t*>(context)->buffer;
+        detail::crash::write(fd, string_view(buffer.data(), buffer.size()));
+    }, this)
+{
+    buffer.reserve(capacity);
+}
+
+auto local_t::write(locals_t& locals, const string_view& filename, const string_view& message) ->
+    void
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (descriptor == nullptr || !(string_view(this->filename) == filename)) {
+        commit_unlocked();
+        descriptor = locals.descriptor(filename);
+        this->filename.assign(filename.data(), filename.size());
+    }
+
+    const auto size = message.size() + 1;
+
+    if (buffer.size() + size > capacity) {
+        commit_unlocked();
+    }
+
+    if (size > capacity) {
+        descriptor->write(message, string_view("\n", 1));
+    } else {
+        buffer.insert(buffer.end(), message.data(), message.data() + message.size());
+        buffer.push_back('\n');
+    }
+
+    if (flusher->update(size) == flusher_t::flush) {
+        commit_unlocked();
+    }
+}
+
+auto local_t::commit() -> void {
+    std::lock_guard<std::mutex> lock(mutex);
+    commit_unlocked();
+}
+
+auto local_t::close() -> void {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    const auto release = [&] {
+        closed = true;
+        descriptor.reset();
+        std::vector<char>().swap(buffer);
+    };
+
+    try {
+        commit_unlocked();
+    } catch (...) {
+        release();
+        throw;
+    }
+
+    release();
+}
+
+auto local_t::is_closed() -> bool {
+    std::lock_guard<std::mutex> lock(mutex);
+    return closed;
+}
+
+auto local_t::commit_unlocked() -> void {
+    if (buffer.empty()) {
+        return;
+    }
+
+    // The buffer is cleared even on failure, because partially written data can not be retried
+    // without duplicating lines.
+    try {
+        descriptor->write(string_view(buffer.data(), buffer.size()), string_view());
+    } catch (...) {
+        buffer.clear();
+        throw;
+    }
+
+    buffer.clear();
+}
+
+locals_t::locals_t(std::size_t capacity, std::unique_ptr<flusher_factory_t> flusher_factory,
+                   std::size_t files, archiver_t* archiver) :
+    id(++counter),
+    capacity(capacity),
+    flusher_factory(std::move(flusher_factory)),
+    archiver(archiver),
+    descriptors(files),
+    stopped(false)
+{
+    thread = std::thread(&locals_t::run, this);
+}
+
+locals_t::~locals_t() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopped = true;
+    }
+
+    cv.notify_one();
+    thread.join();
+
+    std::vector<std::shared_ptr<local_t>> buffers;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        buffers.swap(this->buffers);
+    }
+
+    for (const auto& buffer : buffers) {
+        try {
+            buffer->close();
+        } catch (const std::exception& err) {
+            detail::error::report(error::kind_t::sink, err.what());
+        }
+    }
+}
+
+auto locals_t::local() -> local_t& {
+    // Buffers are keyed by sink identifiers, because sink addresses can be reused after
+    // destruction, while buffers of destroyed sinks stay here until the thread exits.
+    thread_local std::unordered_map<std::uint64_t, std::shared_ptr<local_t>> cache;
+
+    const auto it = cache.find(id);
+    if (it != cache.end()) {
+        return *it->second;
+    }
+
+    for (auto it = cache.begin(); it != cache.end();) {
+        if (it->second->is_closed()) {
+            it = cache.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    auto buffer = std::make_shared<local_t>(capacity, flusher_factory->create());
+
+    // The buffer must be owned by the thread before registering, otherwise the background thread
+    // may treat it as orphaned.
+    cache.emplace(id, buffer);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    buffers.push_back(buffer);
+
+    return *buffer;
+}
+
+auto locals_t::descriptor(const string_view& filename) -> std::shared_ptr<descriptor_t> {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    return descriptors.get(filename, [&](const string_view& filename) {
+        return std::make_shared<descriptor_t>(filename.to_string(), archiver);
+    });
+}
+
+auto locals_t::commit() -> void {
+    std::vector<std::shared_ptr<local_t>> active;
+    std::vector<std::shared_ptr<local_t>> orphans;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        // Buffers referenced only from here belong to exited threads.
+        const auto it = std::stable_partition(buffers.begin(), buffers.end(),
+            [](const std::shared_ptr<local_t>& buffer) {
+                return buffer.use_count() > 1;
+            });
+
+        orphans.assign(std::make_move_iterator(it), std::make_move_iterator(buffers.end()));
+        buffers.erase(it, buffers.end());
+        active = buffers;
+    }
+
+    for (const auto& buffer : active) {
+        try {
+            buffer->commit();
+        } catch (const std::exception& err) {
+            detail::error::report(error::kind_t::sink, err.what());
+        }
+    }
+
+    for (const auto& buffer : orphans) {
+        try {
+            buffer->close();
+        } catch (const std::exception& err) {
+            detail::error::report(error::kind_t::sink, err.what());
+        }
+    }
+}
+
+auto locals_t::run() -> void {
+    std::unique_lock<std::mutex> lock(mutex);
+
+    while (!stopped) {
+        cv.wait_for(lock, interval, [&] {
+            return stopped;
+        });
+
+        if (stopped) {
+            return;
+        }
+
+        lock.unlock();
+        commit();
+        lock.lock();
+    }
+}
+
+}  // namespace file
+}  // namespace sink
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,137 @@
+#include "blackhole/sink/file/merge.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <fstream>
+#include <memory>
+#include <ostream>
+#include <queue>
+#include <system_error>
+
+#include <dirent.h>
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+namespace file {
+namespace {
+
+/// Input file with its current line.
+struct cursor_t {
+    std::ifstream stream;
+    std::string line;
+    string_view key;
+};
+
+}  // namespace
+
+auto isolated(const std::string& path) -> std::vector<std::string> {
+    const auto slash = path.rfind('/');
+    const auto base = slash == std::string::npos ? 0 : slash + 1;
+    const auto directory = slash == std::string::npos ? std::string(".") : path.substr(0, base);
+
+    auto dot = path.rfind('.');
+    if (dot == std::string::npos || dot <= base) {
+        dot = path.size();
+    }
+
+    const auto stem = path.substr(base, dot - base) + ".";
+    const auto extension = path.substr(dot);
+
+    std::unique_ptr<DIR, int(*)(DIR*)> dir(::opendir(directory.c_str()), &::closedir);
+    if (dir == nullptr) {
+        throw std::system_error(errno, std::system_category());
+    }
+
+    std::vector<std::string> result;
+
+    while (const auto entry = ::readdir(dir.get())) {
+        const std::string name(entry->d_name);
+
+        if (name.size() <= stem.size() + extension.size() ||
+            name.compare(0, stem.size(), stem) != 0 ||
+            name.compare(name.size() - extension.size(), extension.size(), extension) != 0)
+        {
+            continue;
+        }
+
+        const auto first = name.begin() + static_cast<std::ptrdiff_t>(stem.size());
+        const auto last = name.end() - static_cast<std::ptrdiff_t>(extension.size());
+
+        if (std::all_of(first, last, [](char c) { return std::isdigit(c) != 0; })) {
+            result.push_back(path.substr(0, base) + name);
+        }
+    }
+
+    std::sort(result.begin(), result.end());
+
+    return result;
+}
+
+auto merge(const std::vector<std::string>& paths,
+           std::ostream& stream,
+           std::function<string_view(const string_view& line)> key) -> std::size_t
+{
+    std::vector<std::unique_ptr<cursor_t>> cursors;
+    cursors.reserve(paths.size());
+
+    for (const auto& path : paths) {
+        std::unique_ptr<cursor_t> cursor(new cursor_t);
+        cursor->stream.open(path);
+
+        if (!cursor->stream) {
+            throw std::system_error(errno, std::system_category());
+        }
+
+        cursors.push_back(std::move(cursor));
+    }
+
+    const auto next = [&](cursor_t& cursor) -> bool {
+        if (!std::getline(cursor.stream, cursor.line)) {
+            return false;
+        }
+
+        cursor.key = key ? key(cursor.line) : string_view(cursor.line);
+        return true;
+    };
+
+    // The queue is a max-heap, so cursors compare by the key reversed, falling back to their
+    // positions to keep the merge stable.
+    const auto compare = [&](std::size_t lhs, std::size_t rhs) -> bool {
+        const auto& a = cursors[lhs]->key;
+        const auto& b = cursors[rhs]->key;
+        return b < a || (a == b && lhs > rhs);
+    };
+
+    std::priority_queue<std::size_t, std::vector<std::size_t>, decltype(compare)> queue(compare);
+
+    for (std::size_t id = 0; id < cursors.size(); ++id) {
+        if (next(*cursors[id])) {
+            queue.push(id);
+        }
+    }
+
+    std::size_t count = 0;
+
+    while (!queue.empty()) {
+        const auto id = queue.top();
+        queue.pop();
+
+        auto& cursor = *cursors[id];
+        stream.write(cursor.line.data(), static_cast<std::streamsize>(cursor.line.size()));
+        stream.put('\n');
+        ++count;
+
+        if (next(cursor)) {
+            queue.push(id);
+        }
+    }
+
+    return count;
+}
+
+}  // namespace file
+}  // namespace sink
+}  // namespace v1
+}  // namespace blackhole
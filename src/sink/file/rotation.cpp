@@ -0,0 +1,262 @@
+#include "blackhole/detail/sink/file/rotation.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <ctime>
+#include <memory>
+#include <system_error>
+#include <vector>
+
+#include <dirent.h>
+#include <unistd.h>
+
+#include <zlib.h>
+
+#include "blackhole/detail/error.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+namespace file {
+namespace {
+
+/// Time given to writers, which obtained the file descriptor before rotation, to finish writing
+/// into the archived file before it is compressed.
+constexpr auto grace = std::chrono::milliseconds(100);
+
+auto error() -> std::system_error {
+    return std::system_error(errno != 0 ? errno : EIO, std::system_category());
+}
+
+}  // namespace
+
+rotator_t::rotator_t(const rotation_t& policy) :
+    policy(policy),
+    written(0),
+    deadline(0),
+    rotating(false)
+{
+    reset();
+}
+
+auto rotator_t::update(std::size_t nwritten) -> bool {
+    const auto total = written.fetch_add(nwritten, std::memory_order_relaxed) + nwritten;
+
+    auto due = policy.size != 0 && total >= policy.size;
+
+    if (!due && policy.interval.count() != 0) {
+        const auto now = clock_type::now().time_since_epoch().count();
+        due = now >= deadline.load(std::memory_order_relaxed);
+    }
+
+    if (!due) {
+        return false;
+    }
+
+    auto expected = false;
+    return rotating.compare_exchange_strong(expected, true, std::memory_order_acq_rel);
+}
+
+auto rotator_t::reset() -> void {
+    const auto now = clock_type::now();
+
+    written.store(0, std::memory_order_relaxed);
+    deadline.store((now + policy.interval).time_since_epoch().count(), std::memory_order_relaxed);
+    rotating.store(false, std::memory_order_release);
+}
+
+archiver_t::archiver_t(const rotation_t& policy) :
+    policy_(policy),
+    stopped(false)
+{
+    thread = std::thread(&archiver_t::run, this);
+}
+
+archiver_t::~archiver_t() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopped = true;
+    }
+
+    cv.notify_one();
+    thread.join();
+}
+
+auto archiver_t::policy() const noexcept -> const rotation_t& {
+    return policy_;
+}
+
+auto archiver_t::archive(const std::string& filename) -> void {
+    auto archive = archive_name(filename, std::chrono::system_clock::now());
+
+    if (::rename(filename.c_str(), archive.c_str()) != 0) {
+        // Nothing to archive if the file has been removed externally.
+        if (errno == ENOENT) {
+            return;
+        }
+
+        throw error();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobs.push_back({filename, std::move(archive), std::chrono::steady_clock::now()});
+    }
+
+    cv.notify_one();
+}
+
+auto archiver_t::run() -> void {
+    std::unique_lock<std::mutex> lock(mutex);
+
+    while (true) {
+        cv.wait(lock, [&] {
+            return stopped || !jobs.empty();
+        });
+
+        if (jobs.empty()) {
+            return;
+        }
+
+        const auto job = std::move(jobs.front());
+        jobs.pop_front();
+
+        cv.wait_until(lock, job.time + grace, [&] {
+            return stopped;
+        });
+
+        lock.unlock();
+        process(job);
+        lock.lock();
+    }
+}
+
+auto archiver_t::process(const job_t& job) -> void {
+    try {
+        if (policy_.compress) {
+            compress(job.archive);
+        }
+
+        if (policy_.backups != 0) {
+            prune(job.filename, policy_.backups);
+        }
+    } catch (const std::exception& err) {
+        detail::error::report(error::kind_t::sink, err.what());
+    }
+}
+
+auto archive_name(const std::string& filename, std::chrono::system_clock::time_point time) ->
+    std::string
+{
+    const auto since = time.time_since_epoch();
+    const auto seconds = std::chrono::duration_cast<std::chrono::seconds>(since);
+    const auto usec = std::chrono::duration_cast<std::chrono::microseconds>(since - seconds);
+
+    const auto value = static_cast<std::time_t>(seconds.count());
+
+    std::tm tm;
+    ::localtime_r(&value, &tm);
+
+    char buffer[64];
+    const auto size = std::strftime(buffer, sizeof(buffer), "%Y%m%d-%H%M%S", &tm);
+    std::snprintf(buffer + size, sizeof(buffer) - size, ".%06d", static_cast<int>(usec.count()));
+
+    return filename + "." + buffer;
+}
+
+auto compress(const std::string& filename) -> void {
+    std::unique_ptr<std::FILE, int(*)(std::FILE*)> input(std::fopen(filename.c_str(), "rb"),
+        &std::fclose);
+
+    if (input == nullptr) {
+        throw error();
+    }
+
+    const auto target = filename + ".gz";
+
+    errno = 0;
+    const auto output = ::gzopen(target.c_str(), "wb");
+
+    if (output == nullptr) {
+        throw error();
+    }
+
+    const auto fail = [&] {
+        const auto err = error();
+        ::gzclose(output);
+        ::unlink(target.c_str());
+        return err;
+    };
+
+    std::vector<char> buffer(64 * 1024);
+
+    while (true) {
+        const auto size = std::fread(buffer.data(), 1, buffer.size(), input.get());
+
+        if (size == 0) {
+            break;
+        }
+
+        if (::gzwrite(output, buffer.data(), static_cast<unsigned int>(size)) != static_cast<int>(size)) {
+            throw fail();
+        }
+    }
+
+    if (std::ferror(input.get())) {
+        throw fail();
+    }
+
+    if (::gzclose(output) != Z_OK) {
+        ::unlink(target.c_str());
+        throw std::system_error(EIO, std::system_category());
+    }
+
+    ::unlink(filename.c_str());
+}
+
+auto prune(const std::string& filename, std::size_t backups) -> void {
+    const auto pos = filename.rfind('/');
+
+    std::string directory(".");
+    if (pos != std::string::npos) {
+        directory = pos == 0 ? "/" : filename.substr(0, pos);
+    }
+
+    const auto prefix = filename.substr(pos == std::string::npos ? 0 : pos + 1) + ".";
+
+    std::unique_ptr<DIR, int(*)(DIR*)> dir(::opendir(directory.c_str()), &::closedir);
+
+    if (dir == nullptr) {
+        throw error();
+    }
+
+    std::vector<std::string> archives;
+
+    while (const auto entry = ::readdir(dir.get())) {
+        const std::string name(entry->d_name);
+
+        if (name.size() > prefix.size() && name.compare(0, prefix.size(), prefix) == 0 &&
+            std::isdigit(static_cast<unsigned char>(name[prefix.size()])))
+        {
+            archives.push_back(name);
+        }
+    }
+
+    if (archives.size() <= backups) {
+        return;
+    }
+
+    // Archive names sort chronologically.
+    std::sort(archives.begin(), archives.end());
+
+    for (std::size_t id = 0; id < archives.size() - backups; ++id) {
+        ::unlink((directory + "/" + archives[id]).c_str());
+    }
+}
+
+}  // namespace file
+}  // namespace sink
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,535 @@
+#include "blackhole/detail/sink/file/stream.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <system_error>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "blackhole/detail/memory.hpp"
+
+#if defined(__linux__) && defined(__NR_io_uring_setup) && defined(__has_include)
+#   if __has_include(<linux/io_uring.h>)
+#       include <linux/io_uring.h>
+#       define BLACKHOLE_HAS_IO_URING
+#   endif
+#endif
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+namespace file {
+namespace {
+
+auto error() -> std::system_error {
+    return std::system_error(errno, std::system_category());
+}
+
+auto page_size() noexcept -> std::size_t {
+    const auto size = ::sysconf(_SC_PAGESIZE);
+    return size > 0 ? static_cast<std::size_t>(size) : 4096;
+}
+
+/// Writes the whole data at the given offset.
+///
+/// \returns zero on success, error number otherwise.
+auto pwrite_all(int fd, const char* data, std::size_t size, std::uint64_t offset) noexcept -> int {
+    while (size > 0) {
+        const auto rc = ::pwrite(fd, data, size, static_cast<::off_t>(offset));
+
+        if (rc == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            return errno;
+        }
+
+        data += rc;
+        size -= static_cast<std::size_t>(rc);
+        offset += static_cast<std::uint64_t>(rc);
+    }
+
+    return 0;
+}
+
+#ifdef BLACKHOLE_HAS_IO_URING
+
+/// Minimal single-producer io_uring wrapper over the raw system calls.
+class ring_t {
+    int fd;
+
+    void* sq;
+    std::size_t sq_size;
+    void* cq;
+    std::size_t cq_size;
+    ::io_uring_sqe* sqes;
+    std::size_t sqes_size;
+
+    unsigned* sq_tail;
+    unsigned* sq_mask;
+    unsigned* sq_array;
+
+    unsigned* cq_head;
+    unsigned* cq_tail;
+    unsigned* cq_mask;
+    ::io_uring_cqe* cqes;
+
+public:
+    /// \throw std::system_error if io_uring is not supported or not permitted.
+    explicit ring_t(unsigned entries) :
+        sq(MAP_FAILED),
+        cq(MAP_FAILED),
+        sqes(static_cast<::io_uring_sqe*>(MAP_FAILED))
+    {
+        ::io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+
+        fd = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+        if (fd == -1) {
+            throw error();
+        }
+
+        sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cq_size = params.cq_off.cqes + params.cq_entries * sizeof(::io_uring_cqe);
+        sqes_size = params.sq_entries * sizeof(::io_uring_sqe);
+
+        sq = ::mmap(nullptr, sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd,
+            IORING_OFF_SQ_RING);
+        cq = ::mmap(nullptr, cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd,
+            IORING_OFF_CQ_RING);
+        sqes = static_cast<::io_uring_sqe*>(::mmap(nullptr, sqes_size, PROT_READ | PROT_WRITE,
+            MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES));
+
+        if (sq == MAP_FAILED || cq == MAP_FAILED || sqes == MAP_FAILED) {
+            const auto err = error();
+            unmap();
+            ::close(fd);
+            throw err;
+        }
+
+        const auto sq_base = static_cast<char*>(sq);
+        sq_tail = reinterpret_cast<unsigned*>(sq_base + params.sq_off.tail);
+        sq_mask = reinterpret_cast<unsigned*>(sq_base + params.sq_off.ring_mask);
+        sq_array = reinterpret_cast<unsigned*>(sq_base + params.sq_off.array);
+
+        const auto cq_base = static_cast<char*>(cq);
+        cq_head = reinterpret_cast<unsigned*>(cq_base + params.cq_off.head);
+        cq_tail = reinterpret_cast<unsigned*>(cq_base + params.cq_off.tail);
+        cq_mask = reinterpret_cast<unsigned*>(cq_base + params.cq_off.ring_mask);
+        cqes = reinterpret_cast<::io_uring_cqe*>(cq_base + params.cq_off.cqes);
+    }
+
+    ring_t(const ring_t& other) = delete;
+    auto operator=(const ring_t& other) -> ring_t& = delete;
+
+    ~ring_t() {
+        unmap();
+        ::close(fd);
+    }
+
+    auto register_buffers(const ::iovec* iov, unsigned count) -> bool {
+        return ::syscall(__NR_io_uring_register, fd, IORING_REGISTER_BUFFERS, iov, count) == 0;
+    }
+
+    /// Pushes the given entry into the submission queue and submits it.
+    ///
+    /// \returns false if the kernel refused the submission, in which case the entry is withdrawn.
+    auto submit(const ::io_uring_sqe& sqe) -> bool {
+        const auto tail = *sq_tail;
+        const auto id = tail & *sq_mask;
+
+        sqes[id] = sqe;
+        sq_array[id] = id;
+        __atomic_store_n(sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+        while (true) {
+            const auto rc = ::syscall(__NR_io_uring_enter, fd, 1, 0, 0, nullptr, 0);
+
+            if (rc == 1) {
+                return true;
+            }
+
+            if (rc == -1 && errno == EINTR) {
+                continue;
+            }
+
+            // Nothing was consumed, so the tail can be safely moved back, because this is the only
+            // producer.
+            __atomic_store_n(sq_tail, tail, __ATOMIC_RELEASE);
+            return false;
+        }
+    }
+
+    /// Blocks until at least one completion is available.
+    auto wait() -> void {
+        while (::syscall(__NR_io_uring_enter, fd, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0) == -1) {
+            if (errno != EINTR) {
+                return;
+            }
+        }
+    }
+
+    /// Calls the given function with user data and result of each available completion.
+    template<typename F>
+    auto reap(F&& fn) -> void {
+        auto head = *cq_head;
+        const auto tail = __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE);
+
+        while (head != tail) {
+            const auto& cqe = cqes[head & *cq_mask];
+            fn(cqe.user_data, cqe.res);
+            ++head;
+        }
+
+        __atomic_store_n(cq_head, head, __ATOMIC_RELEASE);
+    }
+
+private:
+    auto unmap() -> void {
+        if (sq != MAP_FAILED) {
+            ::munmap(sq, sq_size);
+        }
+
+        if (cq != MAP_FAILED) {
+            ::munmap(cq, cq_size);
+        }
+
+        if (sqes != MAP_FAILED) {
+            ::munmap(sqes, sqes_size);
+        }
+    }
+};
+
+#endif
+
+}  // namespace
+
+struct uringbuf_t::state_t {
+    struct slot_t {
+        char* data;
+        /// Number of bytes to be written and written so far.
+        std::size_t size;
+        std::size_t done;
+        std::uint64_t offset;
+        bool busy;
+    };
+
+    int fd;
+    std::size_t capacity;
+    std::vector<slot_t> slots;
+    std::size_t current;
+
+    /// File offset for the next submitted buffer.
+    std::uint64_t offset;
+
+    /// The first error occurred since the last check.
+    int error;
+
+#ifdef BLACKHOLE_HAS_IO_URING
+    std::unique_ptr<ring_t> ring;
+    std::size_t inflight;
+#endif
+
+    state_t(int fd, std::size_t capacity) :
+        fd(fd),
+        capacity(capacity),
+        current(0),
+        offset(0),
+        error(0)
+#ifdef BLACKHOLE_HAS_IO_URING
+        , inflight(0)
+#endif
+    {}
+
+    ~state_t() {
+#ifdef BLACKHOLE_HAS_IO_URING
+        // Buffers must outlive their registration.
+        ring.reset();
+#endif
+
+        for (auto& slot : slots) {
+            std::free(slot.data);
+        }
+    }
+
+    auto uring() const noexcept -> bool {
+#ifdef BLACKHOLE_HAS_IO_URING
+        return ring != nullptr;
+#else
+        return false;
+#endif
+    }
+
+    auto fail(int err) noexcept -> void {
+        if (error == 0) {
+            error = err;
+        }
+    }
+
+    /// Writes the remaining part of the given slot.
+    auto submit(std::size_t id) -> void {
+        auto& slot = slots[id];
+
+#ifdef BLACKHOLE_HAS_IO_URING
+        if (ring) {
+            ::io_uring_sqe sqe;
+            std::memset(&sqe, 0, sizeof(sqe));
+
+            sqe.opcode = IORING_OP_WRITE_FIXED;
+            sqe.fd = fd;
+            sqe.addr = reinterpret_cast<std::uint64_t>(slot.data + slot.done);
+            sqe.len = static_cast<std::uint32_t>(slot.size - slot.done);
+            sqe.off = slot.offset + slot.done;
+            sqe.buf_index = static_cast<std::uint16_t>(id);
+            sqe.user_data = id;
+
+            if (ring->submit(sqe)) {
+                slot.busy = true;
+                ++inflight;
+                return;
+            }
+        }
+#endif
+
+        const auto rc = pwrite_all(fd, slot.data + slot.done, slot.size - slot.done,
+            slot.offset + slot.done);
+
+        if (rc != 0) {
+            fail(rc);
+        }
+
+        slot.busy = false;
+    }
+
+    /// Reaps available completions, resubmitting short writes.
+    auto reap() -> void {
+#ifdef BLACKHOLE_HAS_IO_URING
+        if (ring == nullptr) {
+            return;
+        }
+
+        ring->reap([&](std::uint64_t id, int res) {
+            auto& slot = slots[id];
+            --inflight;
+
+            if (res == -EINTR || res == -EAGAIN) {
+                submit(id);
+            } else if (res < 0) {
+                fail(-res);
+                slot.busy = false;
+            } else if (res == 0) {
+                fail(EIO);
+                slot.busy = false;
+            } else {
+                slot.done += static_cast<std::size_t>(res);
+
+                if (slot.done < slot.size) {
+                    submit(id);
+                } else {
+                    slot.busy = false;
+                }
+            }
+        });
+#endif
+    }
+
+    /// Blocks until at least one of writes in flight completes.
+    auto wait() -> void {
+#ifdef BLACKHOLE_HAS_IO_URING
+        if (ring && inflight > 0) {
+            ring->wait();
+            reap();
+        }
+#endif
+    }
+
+    auto pending() const noexcept -> bool {
+#ifdef BLACKHOLE_HAS_IO_URING
+        return inflight > 0;
+#else
+        return false;
+#endif
+    }
+};
+
+uringbuf_t::uringbuf_t(const std::string& filename,
+                       std::ios_base::openmode mode,
+                       std::size_t capacity,
+                       std::size_t buffers)
+{
+    const auto append = (mode & std::ios_base::app) != 0;
+    const auto flags = O_WRONLY | O_CREAT | O_CLOEXEC | (append ? 0 : O_TRUNC);
+
+    fd = ::open(filename.c_str(), flags, 0644);
+    if (fd == -1) {
+        throw error();
+    }
+
+    const auto page = page_size();
+    state.reset(new state_t(fd, std::max<std::size_t>((capacity + page - 1) / page, 1) * page));
+
+    if (append) {
+        const auto end = ::lseek(fd, 0, SEEK_END);
+        if (end == -1) {
+            const auto err = error();
+            ::close(fd);
+            throw err;
+        }
+
+        state->offset = static_cast<std::uint64_t>(end);
+    }
+
+    std::vector<::iovec> iov;
+
+    for (std::size_t id = 0; id < std::max<std::size_t>(buffers, 1); ++id) {
+        void* data = nullptr;
+        if (::posix_memalign(&data, page, state->capacity) != 0) {
+            ::close(fd);
+            throw std::bad_alloc();
+        }
+
+        state->slots.push_back({static_cast<char*>(data), 0, 0, 0, false});
+        iov.push_back({data, state->capacity});
+    }
+
+#ifdef BLACKHOLE_HAS_IO_URING
+    try {
+        auto ring = blackhole::make_unique<ring_t>(static_cast<unsigned>(iov.size()));
+
+        if (ring->register_buffers(iov.data(), static_cast<unsigned>(iov.size()))) {
+            state->ring = std::move(ring);
+        }
+    } catch (const std::system_error&) {
+        // Fallback to plain writes.
+    }
+#endif
+
+    setp(state->slots[0].data, state->slots[0].data + state->capacity);
+}
+
+uringbuf_t::~uringbuf_t() {
+    drain();
+    state.reset();
+    ::close(fd);
+}
+
+auto uringbuf_t::capacity() const noexcept -> std::size_t {
+    return state->capacity;
+}
+
+auto uringbuf_t::uring() const noexcept -> bool {
+    return state->uring();
+}
+
+auto uringbuf_t::drain() -> bool {
+    rotate();
+
+    while (state->pending()) {
+        state->wait();
+    }
+
+    const auto failed = state->error != 0;
+    state->error = 0;
+
+    return !failed;
+}
+
+auto uringbuf_t::overflow(int_type ch) -> int_type {
+    rotate();
+
+    if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(ch);
+        pbump(1);
+    }
+
+    return traits_type::not_eof(ch);
+}
+
+auto uringbuf_t::xsputn(const char_type* data, std::streamsize size) -> std::streamsize {
+    auto remaining = static_cast<std::size_t>(size);
+
+    while (remaining > 0) {
+        const auto nsize = std::min(remaining, static_cast<std::size_t>(epptr() - pptr()));
+
+        std::memcpy(pptr(), data, nsize);
+        pbump(static_cast<int>(nsize));
+
+        data += nsize;
+        remaining -= nsize;
+
+        if (pptr() == epptr()) {
+            rotate();
+        }
+    }
+
+    return size;
+}
+
+auto uringbuf_t::sync() -> int {
+    rotate();
+    state->reap();
+
+    const auto failed = state->error != 0;
+    state->error = 0;
+
+    return failed ? -1 : 0;
+}
+
+auto uringbuf_t::rotate() -> void {
+    auto& slot = state->slots[state->current];
+
+    slot.size = static_cast<std::size_t>(pptr() - pbase());
+    if (slot.size == 0) {
+        return;
+    }
+
+    slot.done = 0;
+    slot.offset = state->offset;
+    state->offset += slot.size;
+    state->submit(state->current);
+
+    state->current = (state->current + 1) % state->slots.size();
+    state->reap();
+
+    while (state->slots[state->current].busy) {
+        state->wait();
+    }
+
+    const auto& next = state->slots[state->current];
+    setp(next.data, next.data + state->capacity);
+}
+
+uringstream_t::uringstream_t(const std::string& filename,
+                             std::ios_base::openmode mode,
+                             std::size_t capacity) :
+    std::ostream(nullptr),
+    buf(filename, mode, capacity)
+{
+    rdbuf(&buf);
+}
+
+uringstream_factory_t::uringstream_factory_t(std::size_t capacity) noexcept :
+    capacity(capacity)
+{}
+
+auto uringstream_factory_t::create(const std::string& filename, std::ios_base::openmode mode) const ->
+    std::unique_ptr<std::ostream>
+{
+    auto stream = blackhole::make_unique<uringstream_t>(filename, mode, capacity);
+    stream->exceptions(std::ios_base::failbit | std::ios_base::badbit);
+
+    return std::unique_ptr<std::ostream>(stream.release());
+}
+
+}  // namespace file
+}  // namespace sink
+}  // namespace v1
+}  // namespace blackhole
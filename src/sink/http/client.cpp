@@ -0,0 +1,446 @@
+#include "client.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+
+#include <boost/asio/buffers_iterator.hpp>
+#include <boost/asio/connect.hpp>
+#include <boost/asio/read.hpp>
+#include <boost/asio/read_until.hpp>
+#include <boost/asio/write.hpp>
+#include <boost/lexical_cast.hpp>
+
+#include "blackhole/detail/error.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+namespace http {
+namespace {
+
+/// Checks whether the request or the document rejected with the given status may succeed later,
+/// like on queue overflow or node failure.
+auto retriable(int status) noexcept -> bool {
+    return status == 429 || status >= 500;
+}
+
+}  // namespace
+
+client_t::connection_t::connection_t(boost::asio::io_service& io_service) :
+    socket(io_service),
+    timer(io_service),
+    connected(false),
+    busy(false),
+    backoff(min_backoff)
+{}
+
+client_t::client_t(options_t options, std::unique_ptr<protocol_t> protocol) :
+    options(std::move(options)),
+    protocol(std::move(protocol)),
+    request(this->protocol->head()),
+    resolver(io.io_service()),
+    ticker(io.io_service()),
+    deadline(io.io_service()),
+    closed(false),
+    nbytes(0),
+    scheduled(false),
+    stopped(false),
+    sent_(0),
+    failed_(0),
+    dropped_(0)
+{
+    for (std::size_t id = 0; id < this->options.connections; ++id) {
+        connections.emplace_back(new connection_t(io.io_service()));
+    }
+
+    io.post([this] {
+        for (auto& connection : connections) {
+            connect(*connection);
+        }
+
+        tick();
+    });
+}
+
+client_t::~client_t() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopped = true;
+    }
+
+    io.post([this] {
+        shutdown();
+    });
+
+    io.join();
+}
+
+auto client_t::sent() const noexcept -> std::uint64_t {
+    return sent_.load();
+}
+
+auto client_t::failed() const noexcept -> std::uint64_t {
+    return failed_.load();
+}
+
+auto client_t::dropped() const noexcept -> std::uint64_t {
+    return dropped_.load();
+}
+
+auto client_t::parse(const std::string& head) -> boost::optional<head_t> {
+    if (head.size() < 12 || head.compare(0, 7, "HTTP/1.") != 0) {
+        return boost::none;
+    }
+
+    std::string lower(head);
+    std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char ch) {
+        return static_cast<char>(std::tolower(ch));
+    });
+
+    head_t result{std::atoi(head.c_str() + 9), boost::none, false};
+
+    const auto pos = lower.find("\r\ncontent-length:");
+    if (pos != std::string::npos) {
+        result.length = static_cast<std::size_t>(std::strtoull(head.c_str() + pos + 17, nullptr, 10));
+    }
+
+    result.close = lower.find("\r\nconnection: close") != std::string::npos;
+
+    return result;
+}
+
+auto client_t::full() const -> bool {
+    return pending.size() >= options.count || nbytes >= options.bytes;
+}
+
+auto client_t::dispatch(bool force) -> void {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        scheduled = false;
+    }
+
+    for (auto& connection : connections) {
+        if (!connection->connected || connection->busy) {
+            continue;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+
+            if (pending.empty() || !(force || stopped || full())) {
+                break;
+            }
+
+            take(*connection);
+        }
+
+        send(*connection);
+    }
+}
+
+auto client_t::take(connection_t& connection) -> void {
+    std::size_t size = 0;
+
+    while (!pending.empty() && connection.batch.size() < options.count) {
+        const auto length = protocol->overhead(pending.front().document.size());
+
+        if (!connection.batch.empty() && size + length > options.bytes) {
+            break;
+        }
+
+        size += length;
+        nbytes -= length;
+        connection.batch.push_back(std::move(pending.front()));
+        pending.pop_front();
+    }
+}
+
+auto client_t::requeue(std::vector<item_t>& items, bool attempted) -> void {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    for (auto it = items.rbegin(); it != items.rend(); ++it) {
+        if (attempted && ++it->attempts > options.retries) {
+            ++failed_;
+            continue;
+        }
+
+        nbytes += protocol->overhead(it->document.size());
+        pending.push_front(std::move(*it));
+    }
+
+    items.clear();
+}
+
+auto client_t::connect(connection_t& connection) -> void {
+    // Handlers of already expired timers are still invoked after closing.
+    if (closed) {
+        return;
+    }
+
+    const protocol_type::resolver::query query(options.host,
+        boost::lexical_cast<std::string>(options.port),
+        protocol_type::resolver::query::flags::numeric_service);
+
+    resolver.async_resolve(query, io.wrap([this, &connection](const boost::system::error_code& ec,
+                                                              protocol_type::resolver::iterator it)
+    {
+        if (ec) {
+            reconnect(connection);
+            return;
+        }
+
+        boost::asio::async_connect(connection.socket, it, io.wrap([this, &connection](
+            const boost::system::error_code& ec, protocol_type::resolver::iterator)
+        {
+            if (ec) {
+                reconnect(connection);
+                return;
+            }
+
+            connection.connected = true;
+            connection.backoff = min_backoff;
+            connection.response.consume(connection.response.size());
+
+            dispatch(false);
+        }));
+    }));
+}
+
+auto client_t::reconnect(connection_t& connection) -> void {
+    boost::system::error_code ec;
+    connection.socket.close(ec);
+    connection.connected = false;
+
+    if (closed) {
+        return;
+    }
+
+    connection.timer.expires_from_now(boost::posix_time::milliseconds(connection.backoff));
+    connection.backoff = std::min(connection.backoff * 2, max_backoff);
+
+    connection.timer.async_wait(io.wrap([this, &connection](const boost::system::error_code& ec) {
+        if (!ec) {
+            connect(connection);
+        }
+    }));
+}
+
+auto client_t::send(connection_t& connection) -> void {
+    connection.busy = true;
+
+    std::vector<boost::asio::const_buffer> buffers;
+    buffers.reserve(1 + 3 * connection.batch.size());
+    buffers.emplace_back();
+
+    connection.scratch.clear();
+    protocol->frame(connection.batch, connection.scratch, buffers);
+
+    const auto length = boost::asio::buffer_size(buffers);
+    connection.head = request + boost::lexical_cast<std::string>(length) + "\r\n\r\n";
+    buffers.front() = boost::asio::const_buffer(connection.head.data(), connection.head.size());
+
+    boost::asio::async_write(connection.socket, buffers, io.wrap([this, &connection](
+        const boost::system::error_code& ec, std::size_t)
+    {
+        if (ec) {
+            reset(connection);
+            return;
+        }
+
+        receive(connection);
+    }));
+}
+
+auto client_t::receive(connection_t& connection) -> void {
+    boost::asio::async_read_until(connection.socket, connection.response, "\r\n\r\n",
+        io.wrap([this, &connection](const boost::system::error_code& ec, std::size_t size)
+    {
+        if (ec) {
+            reset(connection);
+            return;
+        }
+
+        const auto begin = boost::asio::buffers_begin(connection.response.data());
+        const auto head = parse(std::string(begin, begin + static_cast<std::ptrdiff_t>(size)));
+        connection.response.consume(size);
+
+        // Responses are expected to be framed by their length, since the request does not allow
+        // any content encoding.
+        if (!head || !head->length) {
+            failed_ += connection.batch.size();
+            connection.batch.clear();
+            reset(connection);
+            return;
+        }
+
+        const auto length = head->length.get();
+        const auto available = connection.response.size();
+
+        if (available >= length) {
+            complete(connection, head.get());
+            return;
+        }
+
+        boost::asio::async_read(connection.socket, connection.response,
+            boost::asio::transfer_exactly(length - available),
+            io.wrap([this, &connection, head](const boost::system::error_code& ec, std::size_t)
+        {
+            if (ec) {
+                reset(connection);
+                return;
+            }
+
+            complete(connection, head.get());
+        }));
+    }));
+}
+
+auto client_t::complete(connection_t& connection, const head_t& head) -> void {
+    const auto length = head.length.get();
+    const auto begin = boost::asio::buffers_begin(connection.response.data());
+    const std::string body(begin, begin + static_cast<std::ptrdiff_t>(length));
+    connection.response.consume(length);
+
+    auto& batch = connection.batch;
+    std::vector<item_t> rejected;
+
+    if (head.status / 100 == 2) {
+        std::vector<int> items;
+        items.reserve(batch.size());
+
+        if (protocol->statuses(body, batch.size(), items) && items.size() == batch.size()) {
+            for (std::size_t id = 0; id < batch.size(); ++id) {
+                if (items[id] / 100 == 2) {
+                    ++sent_;
+                } else if (retriable(items[id])) {
+                    rejected.push_back(std::move(batch[id]));
+                } else {
+                    ++failed_;
+                }
+            }
+        } else {
+            failed_ += batch.size();
+        }
+
+        batch.clear();
+    } else if (retriable(head.status)) {
+        rejected.swap(batch);
+    } else {
+        failed_ += batch.size();
+        batch.clear();
+    }
+
+    const bool retry = !rejected.empty();
+    requeue(rejected, true);
+
+    if (head.close) {
+        connection.busy = false;
+        boost::system::error_code ec;
+        connection.socket.close(ec);
+        connection.connected = false;
+
+        connect(connection);
+    } else if (retry) {
+        // Gives the server some time to recover from the overload before sending more.
+        connection.timer.expires_from_now(boost::posix_time::milliseconds(connection.backoff));
+        connection.backoff = std::min(connection.backoff * 2, max_backoff);
+
+        connection.timer.async_wait(io.wrap([this, &connection](
+            const boost::system::error_code& ec)
+        {
+            if (!ec) {
+                connection.busy = false;
+                dispatch(false);
+                drained();
+            }
+        }));
+
+        return;
+    } else {
+        connection.backoff = min_backoff;
+        connection.busy = false;
+        dispatch(false);
+    }
+
+    drained();
+}
+
+auto client_t::reset(connection_t& connection) -> void {
+    requeue(connection.batch, false);
+    connection.busy = false;
+
+    reconnect(connection);
+    drained();
+}
+
+auto client_t::tick() -> void {
+    if (closed) {
+        return;
+    }
+
+    ticker.expires_from_now(boost::posix_time::milliseconds(options.linger.count()));
+    ticker.async_wait(io.wrap([this](const boost::system::error_code& ec) {
+        if (!ec) {
+            dispatch(true);
+            tick();
+        }
+    }));
+}
+
+auto client_t::shutdown() -> void {
+    dispatch(true);
+
+    deadline.expires_from_now(boost::posix_time::seconds(5));
+    deadline.async_wait(io.wrap([this](const boost::system::error_code& ec) {
+        if (!ec) {
+            close();
+        }
+    }));
+
+    drained();
+}
+
+auto client_t::drained() -> void {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!stopped || !pending.empty()) {
+            return;
+        }
+    }
+
+    for (const auto& connection : connections) {
+        if (connection->busy) {
+            return;
+        }
+    }
+
+    close();
+}
+
+auto client_t::close() -> void {
+    if (closed) {
+        return;
+    }
+
+    closed = true;
+
+    boost::system::error_code ec;
+    ticker.cancel(ec);
+    deadline.cancel(ec);
+    resolver.cancel();
+
+    for (auto& connection : connections) {
+        connection->timer.cancel(ec);
+        connection->socket.close(ec);
+        connection->connected = false;
+    }
+}
+
+constexpr long client_t::min_backoff;
+constexpr long client_t::max_backoff;
+
+}  // namespace http
+}  // namespace sink
+}  // namespace v1
+}  // namespace blackhole
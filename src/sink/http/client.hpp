@@ -0,0 +1,239 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <boost/asio/buffer.hpp>
+#include <boost/asio/deadline_timer.hpp>
+#include <boost/asio/io_service.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/streambuf.hpp>
+#include <boost/optional/optional.hpp>
+
+#include "blackhole/stdext/string_view.hpp"
+
+#include "../reactor.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+namespace http {
+
+/// Document waiting to be sent together with the number of attempts made.
+struct item_t {
+    std::string document;
+    std::size_t attempts;
+};
+
+/// Describes how documents are framed into bulk request bodies and how responses acknowledge
+/// them, which is the only difference between bulk HTTP APIs the client talks to.
+class protocol_t {
+public:
+    virtual ~protocol_t() {}
+
+    /// Returns the request head up to the content length value, i.e. the request line and all
+    /// headers followed by "Content-Length: ".
+    virtual auto head() const -> std::string = 0;
+
+    /// Returns the number of bytes the given document occupies in a request body along with its
+    /// framing.
+    virtual auto overhead(std::size_t size) const noexcept -> std::size_t = 0;
+
+    /// Appends buffers of the request body carrying the given batch.
+    ///
+    /// The scratch string may be used to store framing, it is kept untouched until the request
+    /// completes.
+    virtual auto frame(const std::vector<item_t>& batch, std::string& scratch,
+        std::vector<boost::asio::const_buffer>& buffers) const -> void = 0;
+
+    /// Fills statuses of each document in the batch of the given size from the body of a
+    /// successful response.
+    ///
+    /// \returns false if the body is malformed, which fails the whole batch.
+    virtual auto statuses(const string_view& body, std::size_t size,
+        std::vector<int>& result) const -> bool = 0;
+};
+
+struct options_t {
+    std::string host;
+    std::uint16_t port;
+
+    /// Maximum number of documents in a single request.
+    std::size_t count;
+
+    /// Maximum size of a single request body in bytes. A document exceeding it is sent alone.
+    std::size_t bytes;
+
+    /// Time to wait for more documents before sending an incomplete request.
+    std::chrono::milliseconds linger;
+
+    /// Number of keep-alive connections, which limits the number of requests in flight.
+    std::size_t connections;
+
+    /// Number of times a rejected document is sent again before it is counted as failed.
+    std::size_t retries;
+
+    /// Maximum size of documents waiting to be sent in bytes, newer documents are dropped when
+    /// exceeded.
+    std::size_t capacity;
+};
+
+/// Bulk HTTP/1.1 client, which accumulates documents into requests sent over a pool of keep-alive
+/// connections from the I/O thread of the reactor shared by network sinks.
+///
+/// Documents rejected with retriable statuses, like on queue overflow or node failure, are sent
+/// again with exponential backoff, while documents of requests failed due to I/O errors are
+/// delivered at least once.
+class client_t {
+    typedef boost::asio::ip::tcp protocol_type;
+
+    struct head_t {
+        int status;
+        boost::optional<std::size_t> length;
+        bool close;
+    };
+
+    struct connection_t {
+        protocol_type::socket socket;
+        boost::asio::deadline_timer timer;
+        boost::asio::streambuf response;
+
+        std::string head;
+        std::string scratch;
+        std::vector<item_t> batch;
+
+        bool connected;
+        /// Set while the request is in flight or the connection pauses after rejections.
+        bool busy;
+        long backoff;
+
+        explicit connection_t(boost::asio::io_service& io_service);
+    };
+
+    const options_t options;
+    const std::unique_ptr<protocol_t> protocol;
+
+    /// Request head up to the content length value.
+    const std::string request;
+
+    /// Runs handlers on the shared reactor, declared before I/O objects constructed with it.
+    binding_t io;
+    protocol_type::resolver resolver;
+    boost::asio::deadline_timer ticker;
+    boost::asio::deadline_timer deadline;
+
+    // Accessed by the I/O thread only.
+    std::vector<std::unique_ptr<connection_t>> connections;
+    bool closed;
+
+    std::mutex mutex;
+    std::deque<item_t> pending;
+    /// Total size of pending documents including their framing.
+    std::size_t nbytes;
+    bool scheduled;
+    bool stopped;
+
+    std::atomic<std::uint64_t> sent_;
+    std::atomic<std::uint64_t> failed_;
+    std::atomic<std::uint64_t> dropped_;
+
+public:
+    /// Registers with the shared reactor, connecting in background.
+    client_t(options_t options, std::unique_ptr<protocol_t> protocol);
+
+    /// Waits up to 5 seconds for pending documents to be sent.
+    ~client_t();
+
+    /// Returns the number of documents acknowledged by the server.
+    auto sent() const noexcept -> std::uint64_t;
+
+    /// Returns the number of documents rejected either permanently or after all retries.
+    auto failed() const noexcept -> std::uint64_t;
+
+    /// Returns the number of documents dropped because the pending buffer was full.
+    auto dropped() const noexcept -> std::uint64_t;
+
+    /// Copies documents returned by the given function for each index into the pending queue,
+    /// waking up the I/O thread if enough of them are collected for a full request.
+    template<typename F>
+    auto push(std::size_t size, F&& document) -> void {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        for (std::size_t id = 0; id < size; ++id) {
+            const string_view& data = document(id);
+            const auto length = protocol->overhead(data.size());
+
+            if (!pending.empty() && nbytes + length > options.capacity) {
+                ++dropped_;
+                continue;
+            }
+
+            pending.push_back({std::string(data.data(), data.size()), 0});
+            nbytes += length;
+        }
+
+        if (!scheduled && full()) {
+            scheduled = true;
+            io.post([this] {
+                dispatch(false);
+            });
+        }
+    }
+
+private:
+    static constexpr long min_backoff = 100;
+    static constexpr long max_backoff = 10000;
+
+    static auto parse(const std::string& head) -> boost::optional<head_t>;
+
+    /// Must be called with the mutex held.
+    auto full() const -> bool;
+
+    /// Sends pending documents over idle connections, either unconditionally or only while there
+    /// are enough of them to fill a request.
+    auto dispatch(bool force) -> void;
+
+    /// Moves pending documents into the connection batch up to the request limits. Must be called
+    /// with the mutex held.
+    auto take(connection_t& connection) -> void;
+
+    /// Returns the given documents into the head of the pending queue keeping their order,
+    /// optionally counting them as attempted.
+    auto requeue(std::vector<item_t>& items, bool attempted) -> void;
+
+    auto connect(connection_t& connection) -> void;
+
+    /// Schedules reconnection with exponential backoff.
+    auto reconnect(connection_t& connection) -> void;
+
+    auto send(connection_t& connection) -> void;
+    auto receive(connection_t& connection) -> void;
+
+    /// Handles the received response, retrying only documents rejected with retriable statuses.
+    auto complete(connection_t& connection, const head_t& head) -> void;
+
+    /// Drops the connection after an I/O error, returning its batch into the pending queue.
+    ///
+    /// \note the batch may have been partially or even completely accepted, so documents are
+    ///     delivered at least once.
+    auto reset(connection_t& connection) -> void;
+
+    auto tick() -> void;
+    auto shutdown() -> void;
+
+    /// Closes all connections when stopped and there is nothing left to send.
+    auto drained() -> void;
+
+    auto close() -> void;
+};
+
+}  // namespace http
+}  // namespace sink
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,404 @@
+#include "blackhole/sink/journal.hpp"
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <syslog.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#   include <sys/mman.h>
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+
+#include <boost/container/small_vector.hpp>
+#include <boost/optional/optional.hpp>
+#include <boost/variant/apply_visitor.hpp>
+
+#include "blackhole/attribute.hpp"
+#include "blackhole/attributes.hpp"
+#include "blackhole/config/node.hpp"
+#include "blackhole/config/option.hpp"
+#include "blackhole/extensions/writer.hpp"
+#include "blackhole/record.hpp"
+#include "blackhole/stdext/string_view.hpp"
+
+#include "blackhole/detail/attribute.hpp"
+#include "blackhole/detail/procname.hpp"
+#include "blackhole/detail/sink/journal.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+namespace {
+
+/// Maximum length of a journal field name.
+constexpr std::size_t max_name = 64;
+
+/// Closes the file descriptor on scope exit.
+class closer_t {
+    int fd;
+
+public:
+    explicit closer_t(int fd) noexcept :
+        fd(fd)
+    {}
+
+    ~closer_t() {
+        ::close(fd);
+    }
+};
+
+/// Collects datagram slices, which either point to external memory, like messages and string
+/// attributes, or into the arena holding field names and formatted non-string values.
+///
+/// Slices into the arena are stored as offsets, because the arena may grow while the record is
+/// being encoded.
+class fields_t {
+    struct slice_t {
+        const char* data;
+        std::size_t offset;
+        std::size_t size;
+    };
+
+    boost::container::small_vector<char, 2048> arena;
+    boost::container::small_vector<slice_t, 48> slices;
+
+public:
+    /// Returns the arena offset, where the next written byte will be.
+    auto mark() const noexcept -> std::size_t {
+        return arena.size();
+    }
+
+    auto write(const char* data, std::size_t size) -> void {
+        arena.insert(arena.end(), data, data + size);
+    }
+
+    /// Adds a field with the value pointing to external memory.
+    ///
+    /// \param convert whether the name must be converted into a valid field name.
+    auto add(const string_view& name, bool convert, const string_view& value) -> void {
+        add(name, convert, {value.data(), 0, value.size()}, value);
+    }
+
+    /// Adds a field with the value written into the arena starting at the given offset.
+    auto add(const string_view& name, bool convert, std::size_t offset) -> void {
+        const auto size = arena.size() - offset;
+        add(name, convert, {nullptr, offset, size}, string_view(arena.data() + offset, size));
+    }
+
+    /// Converts the collected slices into the given vector of I/O slices.
+    template<typename T>
+    auto materialize(T& iov) const -> void {
+        iov.resize(slices.size());
+
+        for (std::size_t id = 0; id < slices.size(); ++id) {
+            const auto& slice = slices[id];
+
+            iov[id].iov_base = const_cast<char*>(slice.data ? slice.data : arena.data() + slice.offset);
+            iov[id].iov_len = slice.size;
+        }
+    }
+
+private:
+    auto add(const string_view& name, bool convert, slice_t value, const string_view& content) ->
+        void
+    {
+        // Must be checked before the arena grows, the content may point into it.
+        const auto binary = std::memchr(content.data(), '\n', content.size()) != nullptr;
+        const auto offset = arena.size();
+
+        if (convert) {
+            if (this->convert(name) == 0) {
+                return;
+            }
+        } else {
+            write(name.data(), name.size());
+        }
+
+        // Values containing newlines require the binary form: the name followed by a newline and
+        // 64-bit little-endian length.
+        if (binary) {
+            arena.push_back('\n');
+
+            auto length = static_cast<std::uint64_t>(value.size);
+            for (int id = 0; id < 8; ++id) {
+                arena.push_back(static_cast<char>(length & 0xff));
+                length >>= 8;
+            }
+        } else {
+            arena.push_back('=');
+        }
+
+        static const char newline = '\n';
+
+        slices.push_back({nullptr, offset, arena.size() - offset});
+        slices.push_back(value);
+        slices.push_back({&newline, 0, 1});
+    }
+
+    /// Appends the field name converted from the attribute name to the arena, returning its length,
+    /// which is zero if the name is unusable.
+    auto convert(const string_view& name) -> std::size_t {
+        std::size_t size = 0;
+
+        for (std::size_t id = 0; id < name.size(); ++id) {
+            auto ch = name[id];
+
+            if (size == max_name) {
+                break;
+            }
+
+            if (ch >= 'a' && ch <= 'z') {
+                ch = static_cast<char>(ch - 'a' + 'A');
+            } else if (!((ch >= 'A' && ch <= 'Z') || (ch >= '0' && ch <= '9'))) {
+                ch = '_';
+            }
+
+            // Names must start with a letter, underscored ones are reserved for trusted fields.
+            if (size == 0 && !(ch >= 'A' && ch <= 'Z')) {
+                continue;
+            }
+
+            arena.push_back(ch);
+            ++size;
+        }
+
+        return size;
+    }
+};
+
+/// Adds attribute fields, formatting non-string values into the arena.
+class visitor_t : public boost::static_visitor<> {
+    fields_t& fields;
+    const string_view& name;
+
+public:
+    visitor_t(fields_t& fields, const string_view& name) noexcept :
+        fields(fields),
+        name(name)
+    {}
+
+    auto operator()(std::nullptr_t) const -> void {
+        fields.add(name, true, string_view("null", 4));
+    }
+
+    auto operator()(bool value) const -> void {
+        fields.add(name, true, value ? string_view("true", 4) : string_view("false", 5));
+    }
+
+    auto operator()(std::int64_t value) const -> void {
+        const fmt::FormatInt formatted(value);
+        write(formatted.data(), formatted.size());
+    }
+
+    auto operator()(std::uint64_t value) const -> void {
+        const fmt::FormatInt formatted(value);
+        write(formatted.data(), formatted.size());
+    }
+
+    auto operator()(double value) const -> void {
+        writer_t writer;
+        writer.inner << value;
+        write(writer.inner.data(), writer.inner.size());
+    }
+
+    auto operator()(const string_view& value) const -> void {
+        fields.add(name, true, value);
+    }
+
+    auto operator()(const attribute::view_t::function_type& value) const -> void {
+        writer_t writer;
+        value(writer);
+        write(writer.inner.data(), writer.inner.size());
+    }
+
+private:
+    auto write(const char* data, std::size_t size) const -> void {
+        const auto offset = fields.mark();
+        fields.write(data, size);
+        fields.add(name, true, offset);
+    }
+};
+
+}  // namespace
+
+journal_t::journal_t(std::string path) :
+    path_(std::move(path)),
+    identifier(detail::procname().to_string()),
+    fd(-1)
+{
+    struct sockaddr_un address;
+    if (path_.empty() || path_.size() >= sizeof(address.sun_path)) {
+        throw std::invalid_argument("invalid journal socket path: \"" + path_ + "\"");
+    }
+
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, path_.data(), path_.size());
+
+    fd = ::socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (fd == -1) {
+        throw std::system_error(errno, std::system_category(), "failed to create socket");
+    }
+
+    if (::connect(fd, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) != 0) {
+        const auto ec = errno;
+        ::close(fd);
+        throw std::system_error(ec, std::system_category(), "failed to connect to '" + path_ + "'");
+    }
+}
+
+journal_t::~journal_t() {
+    ::close(fd);
+}
+
+auto journal_t::path() const noexcept -> const std::string& {
+    return path_;
+}
+
+auto journal_t::priorities() const -> std::vector<int> {
+    return priorities_;
+}
+
+auto journal_t::priorities(std::vector<int> priorities) -> void {
+    priorities_ = std::move(priorities);
+}
+
+auto journal_t::emit(const record_t& record, const string_view& formatted) -> void {
+    const auto severity = static_cast<std::size_t>(record.severity());
+    const auto priority = severity < priorities_.size() ? priorities_[severity] : LOG_ERR;
+
+    const char digit = static_cast<char>('0' + (priority & LOG_PRIMASK));
+
+    fields_t fields;
+    fields.add(string_view("MESSAGE", 7), false, formatted);
+    fields.add(string_view("PRIORITY", 8), false, string_view(&digit, 1));
+    fields.add(string_view("SYSLOG_IDENTIFIER", 17), false, identifier);
+
+    for (const auto& list : record.attributes()) {
+        for (const auto& attribute : list.get()) {
+            boost::apply_visitor(visitor_t(fields, attribute.first), attribute.second.inner().value);
+        }
+    }
+
+    boost::container::small_vector<struct iovec, 48> iov;
+    fields.materialize(iov);
+
+    send(iov.data(), iov.size());
+}
+
+auto journal_t::send(const struct iovec* iov, std::size_t size) -> void {
+    struct msghdr header;
+    std::memset(&header, 0, sizeof(header));
+    header.msg_iov = const_cast<struct iovec*>(iov);
+    header.msg_iovlen = size;
+
+    while (true) {
+        if (::sendmsg(fd, &header, MSG_NOSIGNAL) >= 0) {
+            return;
+        }
+
+        if (errno == EINTR) {
+            continue;
+        }
+
+        if (errno != EMSGSIZE && errno != ENOBUFS) {
+            throw std::system_error(errno, std::system_category(), "failed to send to the journal");
+        }
+
+        break;
+    }
+
+#ifdef __linux__
+    // The record is too large for a datagram, pass it using a sealed memory file.
+    const auto file = ::memfd_create("blackhole-journal", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (file == -1) {
+        throw std::system_error(errno, std::system_category(), "failed to create memory file");
+    }
+
+    const closer_t closer(file);
+
+    for (std::size_t offset = 0; offset < size; offset += IOV_MAX) {
+        const auto chunk = std::min<std::size_t>(size - offset, IOV_MAX);
+
+        std::size_t expected = 0;
+        for (std::size_t id = offset; id < offset + chunk; ++id) {
+            expected += iov[id].iov_len;
+        }
+
+        const auto rc = ::writev(file, iov + offset, static_cast<int>(chunk));
+        if (rc < 0 || static_cast<std::size_t>(rc) != expected) {
+            throw std::system_error(rc < 0 ? errno : EIO, std::system_category(),
+                "failed to write memory file");
+        }
+    }
+
+    if (::fcntl(file, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL) != 0) {
+        throw std::system_error(errno, std::system_category(), "failed to seal memory file");
+    }
+
+    union {
+        struct cmsghdr header;
+        char control[CMSG_SPACE(sizeof(int))];
+    } control;
+    std::memset(&control, 0, sizeof(control));
+
+    std::memset(&header, 0, sizeof(header));
+    header.msg_control = &control;
+    header.msg_controllen = sizeof(control);
+
+    auto cmsg = CMSG_FIRSTHDR(&header);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+    std::memcpy(CMSG_DATA(cmsg), &file, sizeof(int));
+
+    while (::sendmsg(fd, &header, MSG_NOSIGNAL) < 0) {
+        if (errno != EINTR) {
+            throw std::system_error(errno, std::system_category(), "failed to send to the journal");
+        }
+    }
+#else
+    throw std::system_error(EMSGSIZE, std::system_category(), "failed to send to the journal");
+#endif
+}
+
+}  // namespace sink
+
+auto factory<sink::journal_t>::type() const noexcept -> const char* {
+    return "journal";
+}
+
+auto factory<sink::journal_t>::from(const config::node_t& config) const -> std::unique_ptr<sink_t> {
+    (void)registry;
+
+    std::unique_ptr<sink::journal_t> journal;
+    if (auto path = config["path"].to_string()) {
+        journal.reset(new sink::journal_t(path.get()));
+    } else {
+        journal.reset(new sink::journal_t);
+    }
+
+    if (auto mapping = config["priorities"]) {
+        std::vector<int> priorities;
+        mapping.each([&](const config::node_t& config) {
+            priorities.emplace_back(config.to_sint64());
+        });
+
+        journal->priorities(std::move(priorities));
+    }
+
+    return journal;
+}
+
+}  // namespace v1
+}  // namespace blackhole
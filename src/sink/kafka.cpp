@@ -0,0 +1,217 @@
+#include "blackhole/sink/kafka.hpp"
+
+#include <librdkafka/rdkafka.h>
+
+#include <stdexcept>
+
+#include <boost/lexical_cast.hpp>
+#include <boost/optional/optional.hpp>
+#include <boost/variant/apply_visitor.hpp>
+
+#include "blackhole/attribute.hpp"
+#include "blackhole/attributes.hpp"
+#include "blackhole/config/node.hpp"
+#include "blackhole/config/option.hpp"
+#include "blackhole/extensions/writer.hpp"
+#include "blackhole/record.hpp"
+#include "blackhole/stdext/string_view.hpp"
+
+#include "blackhole/detail/attribute.hpp"
+#include "blackhole/detail/memory.hpp"
+#include "blackhole/detail/sink/kafka.hpp"
+#include "blackhole/detail/util/optional.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+namespace {
+
+auto set(rd_kafka_conf_t* conf, const std::string& name, const std::string& value) -> void {
+    char error[512];
+
+    if (rd_kafka_conf_set(conf, name.c_str(), value.c_str(), error, sizeof(error)) != RD_KAFKA_CONF_OK) {
+        throw std::invalid_argument("invalid Kafka property \"" + name + "\": " + error);
+    }
+}
+
+/// Writes non-string attribute values used as message keys.
+class key_visitor_t : public boost::static_visitor<string_view> {
+    writer_t& writer;
+
+public:
+    explicit key_visitor_t(writer_t& writer) noexcept :
+        writer(writer)
+    {}
+
+    auto operator()(std::nullptr_t) const -> string_view {
+        return string_view("null", 4);
+    }
+
+    auto operator()(bool value) const -> string_view {
+        return value ? string_view("true", 4) : string_view("false", 5);
+    }
+
+    template<typename T>
+    auto operator()(T value) const -> string_view {
+        writer.inner << value;
+        return writer.result();
+    }
+
+    auto operator()(const string_view& value) const -> string_view {
+        return value;
+    }
+
+    auto operator()(const attribute::view_t::function_type& value) const -> string_view {
+        value(writer);
+        return writer.result();
+    }
+};
+
+/// Returns the value of the attribute with the given name, formatting it into the writer when it is
+/// not a string, or empty string view if there is no such attribute.
+auto key_of(const record_t& record, const string_view& name, writer_t& writer) -> string_view {
+    for (const auto& list : record.attributes()) {
+        for (const auto& attribute : list.get()) {
+            if (attribute.first == name) {
+                return boost::apply_visitor(key_visitor_t(writer), attribute.second.inner().value);
+            }
+        }
+    }
+
+    return string_view();
+}
+
+}  // namespace
+
+kafka_t::kafka_t(options_t options) :
+    options(std::move(options)),
+    producer(nullptr, &rd_kafka_destroy),
+    topic(nullptr, &rd_kafka_topic_destroy),
+    dropped_(0),
+    failed_(0),
+    stopped(false)
+{
+    if (this->options.brokers.empty() || this->options.topic.empty()) {
+        throw std::invalid_argument("both Kafka brokers and topic must be specified");
+    }
+
+    std::unique_ptr<rd_kafka_conf_t, void(*)(rd_kafka_conf_t*)> conf(rd_kafka_conf_new(),
+        &rd_kafka_conf_destroy);
+
+    set(conf.get(), "bootstrap.servers", this->options.brokers);
+    set(conf.get(), "queue.buffering.max.ms",
+        boost::lexical_cast<std::string>(this->options.linger.count()));
+
+    if (this->options.batch > 0) {
+        set(conf.get(), "batch.num.messages", boost::lexical_cast<std::string>(this->options.batch));
+    }
+
+    for (const auto& property : this->options.properties) {
+        set(conf.get(), property.first, property.second);
+    }
+
+    rd_kafka_conf_set_opaque(conf.get(), this);
+    rd_kafka_conf_set_dr_msg_cb(conf.get(), [](rd_kafka_t*, const rd_kafka_message_t* message, void* opaque) {
+        if (message->err != RD_KAFKA_RESP_ERR_NO_ERROR) {
+            static_cast<kafka_t*>(opaque)->failed_.fetch_add(1, std::memory_order_relaxed);
+        }
+    });
+
+    char error[512];
+    producer.reset(rd_kafka_new(RD_KAFKA_PRODUCER, conf.get(), error, sizeof(error)));
+
+    if (producer == nullptr) {
+        throw std::invalid_argument(std::string("failed to create Kafka producer: ") + error);
+    }
+
+    // The producer owns the configuration from now on.
+    conf.release();
+
+    topic.reset(rd_kafka_topic_new(producer.get(), this->options.topic.c_str(), nullptr));
+
+    if (topic == nullptr) {
+        throw std::invalid_argument(std::string("failed to create Kafka topic: ") +
+            rd_kafka_err2str(rd_kafka_last_error()));
+    }
+
+    thread = std::thread(&kafka_t::run, this);
+}
+
+kafka_t::~kafka_t() {
+    stopped.store(true);
+    thread.join();
+
+    rd_kafka_flush(producer.get(), 5000);
+}
+
+auto kafka_t::dropped() const noexcept -> std::uint64_t {
+    return dropped_.load(std::memory_order_relaxed);
+}
+
+auto kafka_t::failed() const noexcept -> std::uint64_t {
+    return failed_.load(std::memory_order_relaxed);
+}
+
+auto kafka_t::emit(const record_t& record, const string_view& formatted) -> void {
+    writer_t writer;
+    const auto key = options.key.empty() ? string_view() : key_of(record, options.key, writer);
+
+    // Copying the payload lets librdkafka batch it in background, while failing instead of
+    // blocking when its queue is full.
+    const auto rc = rd_kafka_produce(topic.get(), RD_KAFKA_PARTITION_UA, RD_KAFKA_MSG_F_COPY,
+        const_cast<char*>(formatted.data()), formatted.size(),
+        key.size() > 0 ? key.data() : nullptr, key.size(), nullptr);
+
+    if (rc != 0) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+auto kafka_t::run() -> void {
+    while (!stopped.load()) {
+        rd_kafka_poll(producer.get(), 100);
+    }
+}
+
+}  // namespace sink
+
+using detail::util::value_or;
+
+auto factory<sink::kafka_t>::type() const noexcept -> const char* {
+    return "kafka";
+}
+
+auto factory<sink::kafka_t>::from(const config::node_t& config) const -> std::unique_ptr<sink_t> {
+    (void)registry;
+
+    sink::kafka_t::options_t options;
+
+    options.brokers = value_or(config["brokers"].to_string(), []() -> std::string {
+        throw std::invalid_argument(R"(parameter "brokers" is required)");
+    });
+
+    options.topic = value_or(config["topic"].to_string(), []() -> std::string {
+        throw std::invalid_argument(R"(parameter "topic" is required)");
+    });
+
+    if (auto key = config["key"].to_string()) {
+        options.key = key.get();
+    }
+
+    if (auto linger = config["linger"].to_uint64()) {
+        options.linger = std::chrono::milliseconds(linger.get());
+    }
+
+    if (auto batch = config["batch"].to_uint64()) {
+        options.batch = static_cast<std::size_t>(batch.get());
+    }
+
+    config["properties"].each_map([&](const std::string& name, const config::node_t& value) {
+        options.properties[name] = value.to_string();
+    });
+
+    return blackhole::make_unique<sink::kafka_t>(std::move(options));
+}
+
+}  // namespace v1
+}  // namespace blackhole
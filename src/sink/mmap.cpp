@@ -0,0 +1,244 @@
+#include "blackhole/sink/mmap.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <system_error>
+
+#include <boost/optional/optional.hpp>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "blackhole/config/node.hpp"
+#include "blackhole/config/option.hpp"
+#include "blackhole/stdext/string_view.hpp"
+#include "blackhole/record.hpp"
+
+#include "blackhole/detail/memory.hpp"
+#include "blackhole/detail/sink/file/flusher/bytecount.hpp"
+#include "blackhole/detail/sink/mmap.hpp"
+#include "blackhole/detail/util/deleter.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+namespace {
+
+/// Identifies the file format version.
+const char magic[8] = "BHMMAP1";
+
+auto page_size() noexcept -> std::size_t {
+    const auto size = ::sysconf(_SC_PAGESIZE);
+    return size > 0 ? static_cast<std::size_t>(size) : 4096;
+}
+
+}  // namespace
+
+mmap_t::mmap_t(const std::string& path, std::size_t capacity, std::chrono::milliseconds interval) :
+    path_(path),
+    fd(-1),
+    map(nullptr),
+    size(0),
+    header(nullptr),
+    data(nullptr),
+    capacity_(0),
+    interval(interval),
+    stopped(false)
+{
+    const auto page = page_size();
+
+    capacity_ = std::max(page, (capacity + page - 1) / page * page);
+    size = page + static_cast<std::size_t>(capacity_);
+
+    fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+
+    if (fd == -1) {
+        throw std::system_error(errno, std::system_category());
+    }
+
+    try {
+        struct stat stat;
+        if (::fstat(fd, &stat) != 0) {
+            throw std::system_error(errno, std::system_category());
+        }
+
+        const auto fresh = static_cast<std::size_t>(stat.st_size) != size;
+
+        if (fresh && ::ftruncate(fd, 0) != 0) {
+            throw std::system_error(errno, std::system_category());
+        }
+
+        // Allocating all blocks in advance prevents from receiving SIGBUS when the file system
+        // runs out of space while writing into the mapping.
+        if (const auto rc = ::posix_fallocate(fd, 0, static_cast<off_t>(size))) {
+            throw std::system_error(rc, std::system_category());
+        }
+
+        const auto memory = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+        if (memory == MAP_FAILED) {
+            throw std::system_error(errno, std::system_category());
+        }
+
+        map = static_cast<char*>(memory);
+        header = reinterpret_cast<header_t*>(map);
+        data = map + page;
+
+        const auto valid = std::memcmp(header->magic, magic, sizeof(magic)) == 0 &&
+            header->capacity == capacity_;
+
+        if (fresh || !valid) {
+            std::memset(map, 0, page);
+            std::memcpy(header->magic, magic, sizeof(magic));
+            header->capacity = capacity_;
+            new (&header->tail) std::atomic<std::uint64_t>(0);
+        }
+
+        if (interval.count() > 0) {
+            thread = std::thread(&mmap_t::run, this);
+        }
+    } catch (...) {
+        if (map) {
+            ::munmap(map, size);
+        }
+
+        ::close(fd);
+        throw;
+    }
+}
+
+mmap_t::~mmap_t() {
+    if (thread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopped = true;
+        }
+
+        cv.notify_one();
+        thread.join();
+    }
+
+    ::msync(map, size, MS_SYNC);
+    ::munmap(map, size);
+    ::close(fd);
+}
+
+auto mmap_t::path() const noexcept -> const std::string& {
+    return path_;
+}
+
+auto mmap_t::capacity() const noexcept -> std::uint64_t {
+    return capacity_;
+}
+
+auto mmap_t::tail() const noexcept -> std::uint64_t {
+    return header->tail.load(std::memory_order_acquire);
+}
+
+auto mmap_t::emit(const record_t&, const string_view& formatted) -> void {
+    const auto length = std::min<std::uint64_t>(formatted.size(), capacity_ - 1);
+    const auto position = header->tail.fetch_add(length + 1, std::memory_order_acq_rel);
+
+    copy(formatted.data(), static_cast<std::size_t>(length), position);
+    copy("\n", 1, position + length);
+}
+
+auto mmap_t::copy(const char* data, std::size_t size, std::uint64_t position) noexcept -> void {
+    const auto offset = static_cast<std::size_t>(position % capacity_);
+    const auto first = std::min(size, static_cast<std::size_t>(capacity_) - offset);
+
+    std::memcpy(this->data + offset, data, first);
+    std::memcpy(this->data, data + first, size - first);
+}
+
+auto mmap_t::run() -> void {
+    std::unique_lock<std::mutex> lock(mutex);
+
+    while (true) {
+        cv.wait_for(lock, interval, [&] {
+            return stopped;
+        });
+
+        if (stopped) {
+            return;
+        }
+
+        ::msync(map, size, MS_ASYNC);
+    }
+}
+
+}  // namespace sink
+
+class builder<sink::mmap_t>::inner_t {
+public:
+    std::string path;
+    std::size_t capacity;
+    std::chrono::milliseconds interval;
+};
+
+builder<sink::mmap_t>::builder(const std::string& path) :
+    p(new inner_t{path, 64 * 1024 * 1024, std::chrono::milliseconds(1000)}, deleter_t())
+{}
+
+auto builder<sink::mmap_t>::capacity(bytes_t bytes) & -> builder& {
+    p->capacity = static_cast<std::size_t>(bytes.count());
+    return *this;
+}
+
+auto builder<sink::mmap_t>::capacity(bytes_t bytes) && -> builder&& {
+    return std::move(capacity(bytes));
+}
+
+auto builder<sink::mmap_t>::sync_every(std::chrono::milliseconds interval) & -> builder& {
+    p->interval = interval;
+    return *this;
+}
+
+auto builder<sink::mmap_t>::sync_every(std::chrono::milliseconds interval) && -> builder&& {
+    return std::move(sync_every(interval));
+}
+
+auto builder<sink::mmap_t>::build() && -> std::unique_ptr<sink_t> {
+    return blackhole::make_unique<sink::mmap_t>(std::move(p->path), p->capacity, p->interval);
+}
+
+auto factory<sink::mmap_t>::type() const noexcept -> const char* {
+    return "mmap";
+}
+
+auto factory<sink::mmap_t>::from(const config::node_t& config) const -> std::unique_ptr<sink_t> {
+    (void)registry;
+    const auto path = config["path"].to_string();
+
+    if (!path) {
+        throw std::invalid_argument("field 'path' is required");
+    }
+
+    builder<sink::mmap_t> builder(path.get());
+
+    if (auto capacity = config["capacity"]) {
+        if (capacity.unwrap()->is_uint64()) {
+            builder.capacity(bytes_t(capacity.unwrap()->to_uint64()));
+        }
+
+        if (capacity.unwrap()->is_string()) {
+            const auto bytes = sink::file::flusher::parse_dunit(capacity.unwrap()->to_string());
+            builder.capacity(bytes_t(bytes));
+        }
+    }
+
+    if (auto interval = config["sync"].to_uint64()) {
+        builder.sync_every(std::chrono::milliseconds(interval.get()));
+    }
+
+    return std::move(builder).build();
+}
+
+template auto deleter_t::operator()(builder<sink::mmap_t>::inner_t* value) -> void;
+
+}  // namespace v1
+}  // namespace blackhole
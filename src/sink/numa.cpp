@@ -0,0 +1,209 @@
+#include "blackhole/detail/sink/numa.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+#ifdef __linux__
+#include <dirent.h>
+#include <sched.h>
+#endif
+
+#include "blackhole/metrics.hpp"
+#include "blackhole/pressure.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+namespace {
+
+/// Parses CPU lists like `0-3,8,10-11`, as the kernel formats them.
+auto parse(const std::string& list) -> std::vector<int> {
+    std::vector<int> result;
+
+    std::size_t pos = 0;
+    while (pos < list.size()) {
+        auto end = list.find(',', pos);
+        if (end == std::string::npos) {
+            end = list.size();
+        }
+
+        const auto range = list.substr(pos, end - pos);
+        pos = end + 1;
+
+        if (range.empty() || !std::isdigit(static_cast<unsigned char>(range[0]))) {
+            continue;
+        }
+
+        const auto dash = range.find('-');
+        const auto first = std::atoi(range.c_str());
+        const auto last = dash == std::string::npos ? first : std::atoi(range.c_str() + dash + 1);
+
+        for (auto cpu = first; cpu <= last; ++cpu) {
+            result.push_back(cpu);
+        }
+    }
+
+    return result;
+}
+
+class shared_t : public sink_t {
+    std::shared_ptr<sink_t> sink;
+
+public:
+    explicit shared_t(std::shared_ptr<sink_t> sink) :
+        sink(std::move(sink))
+    {}
+
+    auto emit(const record_t& record, const string_view& message) -> void override {
+        sink->emit(record, message);
+    }
+
+    auto emit_batch(const event_t* events, std::size_t size) -> void override {
+        sink->emit_batch(events, size);
+    }
+
+    auto flush(std::chrono::steady_clock::time_point deadline) -> bool override {
+        return sink->flush(deadline);
+    }
+
+    auto collect(metrics::collector_t&) const -> void override {}
+};
+
+}  // namespace
+
+numa_t::numa_t(std::vector<node_t> nodes, const factory_type& factory,
+               std::shared_ptr<sink_t> shared) :
+    nodes(std::move(nodes)),
+    shared(std::move(shared))
+{
+    if (this->nodes.empty()) {
+        throw std::invalid_argument("at least one NUMA node is required");
+    }
+
+    sinks.reserve(this->nodes.size());
+
+    for (std::size_t id = 0; id < this->nodes.size(); ++id) {
+        sinks.push_back(factory(this->nodes[id]));
+
+        for (auto cpu : this->nodes[id].cpus) {
+            if (cpu < 0) {
+                continue;
+            }
+
+            if (static_cast<std::size_t>(cpu) >= routes.size()) {
+                routes.resize(static_cast<std::size_t>(cpu) + 1, 0);
+            }
+
+            routes[static_cast<std::size_t>(cpu)] = id;
+        }
+    }
+}
+
+auto numa_t::topology() -> std::vector<node_t> {
+    std::vector<node_t> result;
+
+#ifdef __linux__
+    const std::string root("/sys/devices/system/node");
+    std::unique_ptr<DIR, int(*)(DIR*)> dir(::opendir(root.c_str()), &::closedir);
+
+    if (dir != nullptr) {
+        while (const auto entry = ::readdir(dir.get())) {
+            const std::string name(entry->d_name);
+
+            if (name.size() <= 4 || name.compare(0, 4, "node") != 0 ||
+                !std::isdigit(static_cast<unsigned char>(name[4])))
+            {
+                continue;
+            }
+
+            std::ifstream stream(root + "/" + name + "/cpulist");
+            std::string list;
+            std::getline(stream, list);
+
+            const auto cpus = parse(list);
+
+            // Memory-only nodes have no CPUs to run their consumers on.
+            if (!cpus.empty()) {
+                result.push_back({std::atoi(name.c_str() + 4), cpus});
+            }
+        }
+    }
+#endif
+
+    if (result.empty()) {
+        result.push_back({-1, {}});
+    }
+
+    std::sort(result.begin(), result.end(), [](const node_t& lhs, const node_t& rhs) {
+        return lhs.id < rhs.id;
+    });
+
+    return result;
+}
+
+auto numa_t::share(std::shared_ptr<sink_t> sink) -> std::unique_ptr<sink_t> {
+    return std::unique_ptr<sink_t>(new shared_t(std::move(sink)));
+}
+
+auto numa_t::emit(const record_t& record, const string_view& message) -> void {
+    local().emit(record, message);
+}
+
+auto numa_t::emit_batch(const event_t* events, std::size_t size) -> void {
+    local().emit_batch(events, size);
+}
+
+auto numa_t::flush(std::chrono::steady_clock::time_point deadline) -> bool {
+    auto result = true;
+
+    for (auto& sink : sinks) {
+        result = sink->flush(deadline) && result;
+    }
+
+    return result;
+}
+
+auto numa_t::collect(metrics::collector_t& collector) const -> void {
+    for (std::size_t id = 0; id < sinks.size(); ++id) {
+        auto labeled = collector.with("node", std::to_string(nodes[id].id));
+        sinks[id]->collect(labeled);
+    }
+
+    if (shared) {
+        shared->collect(collector);
+    }
+}
+
+auto numa_t::pressure() const -> pressure_t {
+    pressure_t result;
+
+    for (const auto& sink : sinks) {
+        result.merge(sink->pressure());
+    }
+
+    if (shared) {
+        result.merge(shared->pressure());
+    }
+
+    return result;
+}
+
+auto numa_t::local() const noexcept -> sink_t& {
+#ifdef __linux__
+    const auto cpu = ::sched_getcpu();
+
+    if (cpu >= 0 && static_cast<std::size_t>(cpu) < routes.size()) {
+        return *sinks[routes[static_cast<std::size_t>(cpu)]];
+    }
+#endif
+
+    return *sinks.front();
+}
+
+}  // namespace sink
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,275 @@
+#include "blackhole/sink/otlp.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include <boost/asio/buffer.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/optional/optional.hpp>
+
+#include "blackhole/config/node.hpp"
+#include "blackhole/config/option.hpp"
+#include "blackhole/stdext/string_view.hpp"
+
+#include "blackhole/detail/memory.hpp"
+#include "blackhole/detail/procname.hpp"
+#include "blackhole/detail/protobuf.hpp"
+#include "blackhole/detail/sink/otlp.hpp"
+
+#include "http/client.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+namespace {
+
+namespace protobuf = detail::protobuf;
+
+auto put(std::uint64_t value, std::string& result) -> void {
+    char buffer[protobuf::max_varint];
+    result.append(buffer, protobuf::encode(value, buffer));
+}
+
+/// Appends the key and the length prefix of a length-delimited field of the given size.
+auto put_delimited(std::uint32_t field, std::size_t size, std::string& result) -> void {
+    put(protobuf::key(field, protobuf::delimited), result);
+    put(size, result);
+}
+
+auto put_string(std::uint32_t field, const std::string& value, std::string& result) -> void {
+    put_delimited(field, value.size(), result);
+    result.append(value);
+}
+
+/// Returns the encoded `Resource` message with the given string attributes.
+auto resource_of(std::vector<std::pair<std::string, std::string>> attributes) -> std::string {
+    const auto named = std::any_of(attributes.begin(), attributes.end(), [](
+        const std::pair<std::string, std::string>& attribute)
+    {
+        return attribute.first == "service.name";
+    });
+
+    if (!named) {
+        const auto name = detail::procname();
+        attributes.emplace_back("service.name", std::string(name.data(), name.size()));
+    }
+
+    std::string result;
+
+    for (const auto& attribute : attributes) {
+        // The `AnyValue` message holding the `string_value` field only.
+        std::string value;
+        put_string(1, attribute.second, value);
+
+        std::string kv;
+        put_string(1, attribute.first, kv);
+        put_string(2, value, kv);
+
+        put_string(1, kv, result);
+    }
+
+    return result;
+}
+
+class protocol_t : public http::protocol_t {
+    const otlp_t::options_t& options;
+
+    /// Encoded `Resource` and `InstrumentationScope` messages.
+    const std::string resource;
+    const std::string scope;
+
+public:
+    explicit protocol_t(const otlp_t::options_t& options) :
+        options(options),
+        resource(resource_of(options.resource)),
+        scope([&] {
+            std::string result;
+            put_string(1, options.scope, result);
+            return result;
+        }())
+    {}
+
+    auto head() const -> std::string override {
+        return "POST " + options.path + " HTTP/1.1\r\n"
+            "Host: " + options.host + ":" + boost::lexical_cast<std::string>(options.port) + "\r\n"
+            "Content-Type: application/x-protobuf\r\n"
+            "Content-Length: ";
+    }
+
+    /// Each record is the `log_records` field of the `ScopeLogs` message.
+    auto overhead(std::size_t size) const noexcept -> std::size_t override {
+        return protobuf::delimited_size(2, size);
+    }
+
+    auto frame(const std::vector<http::item_t>& batch, std::string& scratch,
+        std::vector<boost::asio::const_buffer>& buffers) const -> void override
+    {
+        std::size_t size = 0;
+        for (const auto& item : batch) {
+            size += overhead(item.document.size());
+        }
+
+        scratch = otlp::envelope(resource, scope, size);
+        const auto prefix = scratch.size();
+
+        for (const auto& item : batch) {
+            put_delimited(2, item.document.size(), scratch);
+        }
+
+        // Buffers are made after the scratch is complete, since appending may reallocate it.
+        buffers.emplace_back(scratch.data(), prefix);
+
+        auto offset = prefix;
+        for (const auto& item : batch) {
+            const auto length = overhead(item.document.size()) - item.document.size();
+            buffers.emplace_back(scratch.data() + offset, length);
+            buffers.emplace_back(item.document.data(), item.document.size());
+            offset += length;
+        }
+    }
+
+    /// Partial success responses are not inspected, so all records of an accepted request are
+    /// counted as sent.
+    auto statuses(const string_view&, std::size_t size, std::vector<int>& result) const ->
+        bool override
+    {
+        result.assign(size, 200);
+        return true;
+    }
+};
+
+}  // namespace
+
+namespace otlp {
+
+auto envelope(const std::string& resource, const std::string& scope, std::size_t size) ->
+    std::string
+{
+    const auto scope_logs = protobuf::delimited_size(1, scope.size()) + size;
+    const auto resource_logs = protobuf::delimited_size(1, resource.size()) +
+        protobuf::delimited_size(2, scope_logs);
+
+    std::string result;
+    put_delimited(1, resource_logs, result);
+    put_string(1, resource, result);
+    put_delimited(2, scope_logs, result);
+    put_string(1, scope, result);
+
+    return result;
+}
+
+}  // namespace otlp
+
+otlp_t::otlp_t(options_t options) :
+    options_(std::move(options))
+{
+    if (options_.count == 0 || options_.bytes == 0 || options_.connections == 0 ||
+        options_.linger.count() <= 0)
+    {
+        throw std::invalid_argument("count, bytes, linger and connections must be positive");
+    }
+
+    client.reset(new http::client_t({
+        options_.host,
+        options_.port,
+        options_.count,
+        options_.bytes,
+        options_.linger,
+        options_.connections,
+        options_.retries,
+        options_.capacity
+    }, blackhole::make_unique<protocol_t>(options_)));
+}
+
+otlp_t::~otlp_t() = default;
+
+auto otlp_t::options() const noexcept -> const options_t& {
+    return options_;
+}
+
+auto otlp_t::sent() const noexcept -> std::uint64_t {
+    return client->sent();
+}
+
+auto otlp_t::failed() const noexcept -> std::uint64_t {
+    return client->failed();
+}
+
+auto otlp_t::dropped() const noexcept -> std::uint64_t {
+    return client->dropped();
+}
+
+auto otlp_t::emit(const record_t&, const string_view& formatted) -> void {
+    client->push(1, [&](std::size_t) -> const string_view& {
+        return formatted;
+    });
+}
+
+auto otlp_t::emit_batch(const event_t* events, std::size_t size) -> void {
+    client->push(size, [&](std::size_t id) -> const string_view& {
+        return *events[id].message;
+    });
+}
+
+}  // namespace sink
+
+auto factory<sink::otlp_t>::type() const noexcept -> const char* {
+    return "otlp";
+}
+
+auto factory<sink::otlp_t>::from(const config::node_t& config) const -> std::unique_ptr<sink_t> {
+    (void)registry;
+
+    sink::otlp_t::options_t options;
+
+    if (auto host = config["host"].to_string()) {
+        options.host = host.get();
+    }
+
+    if (auto port = config["port"].to_uint64()) {
+        options.port = static_cast<std::uint16_t>(port.get());
+    }
+
+    if (auto path = config["path"].to_string()) {
+        options.path = path.get();
+    }
+
+    if (auto resource = config["resource"]) {
+        resource.each_map([&](const std::string& key, const config::node_t& value) {
+            options.resource.emplace_back(key, value.to_string());
+        });
+    }
+
+    if (auto scope = config["scope"].to_string()) {
+        options.scope = scope.get();
+    }
+
+    if (auto count = config["count"].to_uint64()) {
+        options.count = static_cast<std::size_t>(count.get());
+    }
+
+    if (auto bytes = config["bytes"].to_uint64()) {
+        options.bytes = static_cast<std::size_t>(bytes.get());
+    }
+
+    if (auto linger = config["linger"].to_uint64()) {
+        options.linger = std::chrono::milliseconds(linger.get());
+    }
+
+    if (auto connections = config["connections"].to_uint64()) {
+        options.connections = static_cast<std::size_t>(connections.get());
+    }
+
+    if (auto retries = config["retries"].to_uint64()) {
+        options.retries = static_cast<std::size_t>(retries.get());
+    }
+
+    if (auto capacity = config["capacity"].to_uint64()) {
+        options.capacity = static_cast<std::size_t>(capacity.get());
+    }
+
+    return blackhole::make_unique<sink::otlp_t>(std::move(options));
+}
+
+}  // namespace v1
+}  // namespace blackhole
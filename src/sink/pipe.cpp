@@ -0,0 +1,414 @@
+#include "blackhole/sink/pipe.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <mutex>
+#include <system_error>
+#include <utility>
+
+#include <boost/optional/optional.hpp>
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "blackhole/config/node.hpp"
+#include "blackhole/config/option.hpp"
+#include "blackhole/stdext/string_view.hpp"
+#include "blackhole/record.hpp"
+
+#include "blackhole/detail/memory.hpp"
+#include "blackhole/detail/sink/file/flusher/bytecount.hpp"
+#include "blackhole/detail/sink/pipe.hpp"
+#include "blackhole/detail/util/deleter.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+namespace {
+
+auto page_size() noexcept -> std::size_t {
+    const auto size = ::sysconf(_SC_PAGESIZE);
+    return size > 0 ? static_cast<std::size_t>(size) : 4096;
+}
+
+/// Blocks `SIGPIPE` for the calling thread while alive, so that writing into a pipe without readers
+/// fails with `EPIPE` instead of terminating the process.
+///
+/// The signal raised meanwhile is consumed on destruction, unless it had been pending before.
+/// Elsewhere `F_SETNOSIGPIPE` is set on the pipe instead.
+class sigpipe_t {
+#if defined(__linux__)
+    sigset_t set;
+    sigset_t previous;
+    bool pending;
+#endif
+    bool raised_;
+
+public:
+    sigpipe_t() noexcept :
+        raised_(false)
+    {
+#if defined(__linux__)
+        ::sigemptyset(&set);
+        ::sigaddset(&set, SIGPIPE);
+
+        sigset_t waiting;
+        ::sigemptyset(&waiting);
+        ::sigpending(&waiting);
+        pending = ::sigismember(&waiting, SIGPIPE) == 1;
+
+        ::pthread_sigmask(SIG_BLOCK, &set, &previous);
+#endif
+    }
+
+    ~sigpipe_t() {
+#if defined(__linux__)
+        const auto saved = errno;
+
+        if (raised_ && !pending) {
+            const struct timespec zero{0, 0};
+            while (::sigtimedwait(&set, nullptr, &zero) == -1 && errno == EINTR) {}
+        }
+
+        ::pthread_sigmask(SIG_SETMASK, &previous, nullptr);
+        errno = saved;
+#endif
+    }
+
+    /// Marks that a write has failed with `EPIPE`, so the signal must be consumed.
+    auto raised() noexcept -> void {
+        raised_ = true;
+    }
+};
+
+/// Writes the given vector entirely, returning zero or the error code.
+auto writev(int fd, struct iovec* iov, int count) noexcept -> int {
+    while (count > 0) {
+        const auto rc = ::writev(fd, iov, count);
+
+        if (rc < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            return errno;
+        }
+
+        auto written = static_cast<std::size_t>(rc);
+        while (count > 0 && written >= iov->iov_len) {
+            written -= iov->iov_len;
+            ++iov;
+            --count;
+        }
+
+        if (count > 0) {
+            iov->iov_base = static_cast<char*>(iov->iov_base) + written;
+            iov->iov_len -= written;
+        }
+    }
+
+    return 0;
+}
+
+#if defined(__linux__)
+/// Gifts pages of the given entry to the pipe entirely, advancing it, returning zero or the error
+/// code.
+auto gift(int fd, struct iovec& iov) noexcept -> int {
+    while (iov.iov_len > 0) {
+        const auto rc = ::vmsplice(fd, &iov, 1, SPLICE_F_GIFT);
+
+        if (rc < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            return errno;
+        }
+
+        iov.iov_base = static_cast<char*>(iov.iov_base) + rc;
+        iov.iov_len -= static_cast<std::size_t>(rc);
+    }
+
+    return 0;
+}
+#endif
+
+}  // namespace
+
+pipe_t::pipe_t(std::string path, std::size_t capacity, std::size_t pipe_size) :
+    path_(std::move(path)),
+    capacity(0),
+    pipe_size(pipe_size),
+    fd(-1),
+    splicing_(false),
+    buffer(nullptr),
+    used(0)
+{
+    const auto page = page_size();
+    this->capacity = std::max(page, (capacity + page - 1) / page * page);
+}
+
+pipe_t::~pipe_t() {
+    if (buffer) {
+        ::munmap(buffer, capacity);
+    }
+
+    if (fd != -1) {
+        ::close(fd);
+    }
+}
+
+auto pipe_t::path() const noexcept -> const std::string& {
+    return path_;
+}
+
+auto pipe_t::buffer_size() const noexcept -> std::size_t {
+    return capacity;
+}
+
+auto pipe_t::splicing() const -> bool {
+    std::lock_guard<detail::mutex_t> lock(mutex);
+    return splicing_;
+}
+
+auto pipe_t::emit(const record_t&, const string_view& formatted) -> void {
+    std::lock_guard<detail::mutex_t> lock(mutex);
+
+    open();
+    write(formatted.data(), formatted.size());
+}
+
+auto pipe_t::emit_batch(const event_t* events, std::size_t size) -> void {
+    std::lock_guard<detail::mutex_t> lock(mutex);
+
+    open();
+
+    for (std::size_t id = 0; id < size; ++id) {
+        const auto& message = *events[id].message;
+        const auto length = message.size() + 1;
+
+        if (used + length > capacity) {
+            handoff();
+        }
+
+        if (length > capacity) {
+            write(message.data(), message.size());
+            continue;
+        }
+
+        append(message.data(), message.size());
+        append("\n", 1);
+    }
+
+    handoff();
+}
+
+auto pipe_t::open() -> void {
+    if (fd != -1) {
+        return;
+    }
+
+    if (::mkfifo(path_.c_str(), 0644) != 0 && errno != EEXIST) {
+        throw std::system_error(errno, std::system_category());
+    }
+
+    // Opening in non-blocking mode fails with `ENXIO` instead of waiting for a reader.
+    const auto result = ::open(path_.c_str(), O_WRONLY | O_APPEND | O_NONBLOCK | O_CLOEXEC);
+
+    if (result == -1) {
+        throw std::system_error(errno, std::system_category());
+    }
+
+    // Writes must block while the pipe is full.
+    const auto flags = ::fcntl(result, F_GETFL);
+    struct stat stat;
+
+    if (flags == -1 || ::fcntl(result, F_SETFL, flags & ~O_NONBLOCK) == -1 ||
+        ::fstat(result, &stat) != 0)
+    {
+        const auto ec = errno;
+        ::close(result);
+        throw std::system_error(ec, std::system_category());
+    }
+
+    fd = result;
+
+#if defined(__linux__)
+    splicing_ = S_ISFIFO(stat.st_mode);
+
+    if (splicing_ && pipe_size > 0) {
+        // Failed requests, like ones exceeding the system limit, keep the current capacity.
+        ::fcntl(fd, F_SETPIPE_SZ, static_cast<int>(std::min<std::size_t>(pipe_size, 1 << 30)));
+    }
+#endif
+
+#if defined(F_SETNOSIGPIPE)
+    ::fcntl(fd, F_SETNOSIGPIPE, 1);
+#endif
+}
+
+auto pipe_t::fail(int ec) -> void {
+    ::close(fd);
+    fd = -1;
+
+    throw std::system_error(ec, std::system_category());
+}
+
+auto pipe_t::append(const char* data, std::size_t size) -> void {
+    if (buffer == nullptr) {
+        const auto memory = ::mmap(nullptr, capacity, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+        if (memory == MAP_FAILED) {
+            throw std::system_error(errno, std::system_category());
+        }
+
+        buffer = static_cast<char*>(memory);
+    }
+
+    std::memcpy(buffer + used, data, size);
+    used += size;
+}
+
+auto pipe_t::handoff() -> void {
+    if (used == 0) {
+        return;
+    }
+
+    struct iovec iov{buffer, used};
+    used = 0;
+
+    int ec = 0;
+    {
+        sigpipe_t guard;
+
+#if defined(__linux__)
+        if (splicing_) {
+            ec = gift(fd, iov);
+
+            // Destinations turned out not to support splicing fail before transferring anything.
+            if (ec == EINVAL || ec == EBADF || ec == ENOSYS) {
+                splicing_ = false;
+            }
+        }
+#endif
+
+        if (!splicing_ && iov.iov_len > 0) {
+            ec = sink::writev(fd, &iov, 1);
+        }
+
+        if (ec == EPIPE) {
+            guard.raised();
+        }
+    }
+
+    // The pipe may still reference gifted pages, so they must never be written again.
+    if (splicing_) {
+        ::munmap(buffer, capacity);
+        buffer = nullptr;
+    }
+
+    if (ec != 0) {
+        fail(ec);
+    }
+}
+
+auto pipe_t::write(const char* data, std::size_t size) -> void {
+    struct iovec iov[2] = {
+        {const_cast<char*>(data), size},
+        {const_cast<char*>("\n"), 1}
+    };
+
+    int ec = 0;
+    {
+        sigpipe_t guard;
+        ec = sink::writev(fd, iov, 2);
+
+        if (ec == EPIPE) {
+            guard.raised();
+        }
+    }
+
+    if (ec != 0) {
+        fail(ec);
+    }
+}
+
+}  // namespace sink
+
+class builder<sink::pipe_t>::inner_t {
+public:
+    std::string path;
+    std::size_t capacity;
+    std::size_t pipe_size;
+};
+
+builder<sink::pipe_t>::builder(const std::string& path) :
+    p(new inner_t{path, 64 * 1024, 1024 * 1024}, deleter_t())
+{}
+
+auto builder<sink::pipe_t>::buffer(bytes_t bytes) & -> builder& {
+    p->capacity = static_cast<std::size_t>(bytes.count());
+    return *this;
+}
+
+auto builder<sink::pipe_t>::buffer(bytes_t bytes) && -> builder&& {
+    return std::move(buffer(bytes));
+}
+
+auto builder<sink::pipe_t>::pipe_size(bytes_t bytes) & -> builder& {
+    p->pipe_size = static_cast<std::size_t>(bytes.count());
+    return *this;
+}
+
+auto builder<sink::pipe_t>::pipe_size(bytes_t bytes) && -> builder&& {
+    return std::move(pipe_size(bytes));
+}
+
+auto builder<sink::pipe_t>::build() && -> std::unique_ptr<sink_t> {
+    return blackhole::make_unique<sink::pipe_t>(std::move(p->path), p->capacity, p->pipe_size);
+}
+
+auto factory<sink::pipe_t>::type() const noexcept -> const char* {
+    return "pipe";
+}
+
+auto factory<sink::pipe_t>::from(const config::node_t& config) const -> std::unique_ptr<sink_t> {
+    (void)registry;
+    const auto path = config["path"].to_string();
+
+    if (!path) {
+        throw std::invalid_argument("field 'path' is required");
+    }
+
+    const auto bytes = [](const config::node_t& node) -> bytes_t {
+        if (node.is_string()) {
+            return bytes_t(sink::file::flusher::parse_dunit(node.to_string()));
+        }
+
+        return bytes_t(node.to_uint64());
+    };
+
+    builder<sink::pipe_t> builder(path.get());
+
+    if (auto buffer = config["buffer"]) {
+        builder.buffer(bytes(*buffer.unwrap()));
+    }
+
+    if (auto pipe_size = config["pipe_size"]) {
+        builder.pipe_size(bytes(*pipe_size.unwrap()));
+    }
+
+    return std::move(builder).build();
+}
+
+template auto deleter_t::operator()(builder<sink::pipe_t>::inner_t* value) -> void;
+
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,96 @@
+#include "reactor.hpp"
+
+#include <stdexcept>
+
+#include "blackhole/detail/error.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+
+reactor_t::reactor_t(std::size_t threads) :
+    work(new boost::asio::io_service::work(io_service_))
+{
+    if (threads == 0) {
+        throw std::invalid_argument("reactor must have at least one thread");
+    }
+
+    try {
+        for (std::size_t id = 0; id < threads; ++id) {
+            this->threads.emplace_back(&reactor_t::run, this);
+        }
+    } catch (...) {
+        work.reset();
+        for (auto& thread : this->threads) {
+            thread.join();
+        }
+
+        throw;
+    }
+}
+
+reactor_t::~reactor_t() {
+    work.reset();
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+auto reactor_t::io_service() noexcept -> boost::asio::io_service& {
+    return io_service_;
+}
+
+auto reactor_t::size() const noexcept -> std::size_t {
+    return threads.size();
+}
+
+auto reactor_t::shared() -> std::shared_ptr<reactor_t> {
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wexit-time-destructors"
+    static std::mutex mutex;
+    static std::weak_ptr<reactor_t> instance;
+#pragma clang diagnostic pop
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto reactor = instance.lock();
+    if (reactor == nullptr) {
+        reactor = std::make_shared<reactor_t>(1);
+        instance = reactor;
+    }
+
+    return reactor;
+}
+
+auto reactor_t::run() -> void {
+    while (true) {
+        try {
+            io_service_.run();
+            return;
+        } catch (const std::exception& err) {
+            detail::error::report(error::kind_t::sink, err.what());
+        }
+    }
+}
+
+binding_t::binding_t(std::shared_ptr<reactor_t> reactor) :
+    reactor(std::move(reactor)),
+    strand(this->reactor->io_service())
+{}
+
+binding_t::~binding_t() {
+    join();
+}
+
+auto binding_t::io_service() noexcept -> boost::asio::io_service& {
+    return reactor->io_service();
+}
+
+auto binding_t::join() -> void {
+    state.wait();
+}
+
+}  // namespace sink
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,166 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <boost/asio/io_service.hpp>
+#include <boost/asio/strand.hpp>
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+
+/// I/O threads running an io_service shared by network sinks, which saves a thread per remote
+/// sink for background connecting, writing and timers.
+class reactor_t {
+    boost::asio::io_service io_service_;
+    std::unique_ptr<boost::asio::io_service::work> work;
+    std::vector<std::thread> threads;
+
+public:
+    /// \throw std::invalid_argument if the number of threads is zero.
+    explicit reactor_t(std::size_t threads = 1);
+
+    /// Stops threads once all handlers are completed.
+    ///
+    /// \warning must not be destroyed from its own thread.
+    ~reactor_t();
+
+    reactor_t(const reactor_t& other) = delete;
+    auto operator=(const reactor_t& other) -> reactor_t& = delete;
+
+    auto io_service() noexcept -> boost::asio::io_service&;
+
+    /// Returns the number of threads.
+    auto size() const noexcept -> std::size_t;
+
+    /// Returns the process-wide reactor with a single thread, which is started on the first call
+    /// and stopped once the last sink using it is destroyed.
+    static auto shared() -> std::shared_ptr<reactor_t>;
+
+private:
+    auto run() -> void;
+};
+
+/// Registration of a single component in the reactor.
+///
+/// Handlers wrapped or posted through the binding are run one at a time through its strand, so
+/// they need no synchronization between themselves even if the reactor has several threads. The
+/// binding also counts handlers not destroyed yet, which allows the component to wait for all of
+/// them to complete before its state is destroyed.
+class binding_t {
+    typedef boost::asio::io_service::strand strand_type;
+
+    class state_t {
+        std::atomic<std::size_t> pending;
+        std::mutex mutex;
+        std::condition_variable cv;
+
+    public:
+        state_t() :
+            pending(0)
+        {}
+
+        auto acquire() noexcept -> void {
+            ++pending;
+        }
+
+        auto release() -> void {
+            if (--pending == 0) {
+                std::lock_guard<std::mutex> lock(mutex);
+                cv.notify_all();
+            }
+        }
+
+        auto wait() -> void {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [&] {
+                return pending.load() == 0;
+            });
+        }
+    };
+
+    /// Handler holding the registration count while it exists.
+    template<typename F>
+    class guarded_t {
+        F fn;
+        state_t* state;
+
+    public:
+        guarded_t(F fn, state_t* state) :
+            fn(std::move(fn)),
+            state(state)
+        {
+            state->acquire();
+        }
+
+        guarded_t(const guarded_t& other) :
+            fn(other.fn),
+            state(other.state)
+        {
+            state->acquire();
+        }
+
+        guarded_t(guarded_t&& other) :
+            fn(std::move(other.fn)),
+            state(other.state)
+        {
+            state->acquire();
+        }
+
+        ~guarded_t() {
+            state->release();
+        }
+
+        auto operator=(const guarded_t& other) -> guarded_t& = delete;
+
+        template<typename... Args>
+        auto operator()(Args&&... args) -> void {
+            fn(std::forward<Args>(args)...);
+        }
+    };
+
+    std::shared_ptr<reactor_t> reactor;
+    strand_type strand;
+    state_t state;
+
+public:
+    explicit binding_t(std::shared_ptr<reactor_t> reactor = reactor_t::shared());
+
+    /// Waits for handlers to complete.
+    ~binding_t();
+
+    binding_t(const binding_t& other) = delete;
+    auto operator=(const binding_t& other) -> binding_t& = delete;
+
+    /// Returns the io_service I/O objects of the component must be constructed with.
+    auto io_service() noexcept -> boost::asio::io_service&;
+
+    /// Wraps the completion handler of an asynchronous operation.
+    template<typename F>
+    auto wrap(F fn) -> decltype(std::declval<strand_type&>().wrap(std::declval<guarded_t<F>>())) {
+        return strand.wrap(guarded_t<F>(std::move(fn), &state));
+    }
+
+    /// Schedules the given function to be called from the reactor thread.
+    template<typename F>
+    auto post(F fn) -> void {
+        strand.post(guarded_t<F>(std::move(fn), &state));
+    }
+
+    /// Blocks until all handlers are both completed and destroyed, which requires all pending
+    /// operations of the component to be either finished or cancelled.
+    ///
+    /// \warning must not be called from the reactor thread.
+    auto join() -> void;
+};
+
+}  // namespace sink
+}  // namespace v1
+}  // namespace blackhole
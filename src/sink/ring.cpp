@@ -0,0 +1,502 @@
+#include "blackhole/detail/sink/ring.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+
+#include <boost/assert.hpp>
+#include <boost/variant/apply_visitor.hpp>
+
+#include "blackhole/attribute.hpp"
+#include "blackhole/extensions/writer.hpp"
+
+#include "blackhole/detail/attribute.hpp"
+#include "blackhole/detail/crash.hpp"
+#include "blackhole/detail/record.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+namespace {
+
+/// Slot header size. The first word contains the slot length with the padding flag in its lowest
+/// bit, the second one contains the payload size.
+constexpr std::size_t header_size = 8;
+constexpr std::uint32_t padding = 1;
+
+constexpr auto align(std::size_t size) noexcept -> std::size_t {
+    return (size + 7) & ~std::size_t(7);
+}
+
+}  // namespace
+
+ring_t::ring_t(std::size_t capacity, const detail::paging_t& paging) :
+    capacity_(capacity),
+    buffer(nullptr),
+    cursor(0),
+    head(0),
+    tail(0)
+{
+    if (capacity < 64 || (capacity & (capacity - 1)) != 0) {
+        throw std::invalid_argument("ring capacity must be a power of two not less than 64");
+    }
+
+    pages.reset(new detail::pages_t(capacity, 64, paging));
+    buffer = pages->data();
+}
+
+auto ring_t::capacity() const noexcept -> std::size_t {
+    return capacity_;
+}
+
+auto ring_t::used() const noexcept -> std::size_t {
+    const auto tail = this->tail.load(std::memory_order_acquire);
+    const auto head = this->head.load(std::memory_order_acquire);
+    return static_cast<std::size_t>(head > tail ? head - tail : 0);
+}
+
+auto ring_t::fits(std::size_t size) const noexcept -> bool {
+    return align(header_size + size) <= capacity_;
+}
+
+auto ring_t::empty() const noexcept -> bool {
+    return head.load(std::memory_order_acquire) == cursor;
+}
+
+auto ring_t::reserve(std::size_t size) noexcept -> reservation_t {
+    if (!fits(size)) {
+        return {nullptr, 0};
+    }
+
+    const auto length = align(header_size + size);
+
+    auto position = head.load(std::memory_order_relaxed);
+    std::size_t skip;
+
+    while (true) {
+        const auto offset = position & (capacity_ - 1);
+        skip = offset + length > capacity_ ? capacity_ - offset : 0;
+
+        if (position + skip + length - tail.load(std::memory_order_acquire) > capacity_) {
+            return {nullptr, 0};
+        }
+
+        if (head.compare_exchange_weak(position, position + skip + length, std::memory_order_relaxed)) {
+            break;
+        }
+    }
+
+    if (skip > 0) {
+        header(position).store(static_cast<std::uint32_t>(skip) | padding, std::memory_order_release);
+        position += skip;
+    }
+
+    auto data = buffer + (position & (capacity_ - 1));
+
+    const auto nsize = static_cast<std::uint32_t>(size);
+    std::memcpy(data + sizeof(std::uint32_t), &nsize, sizeof(nsize));
+
+    return {data + header_size, static_cast<std::uint32_t>(length)};
+}
+
+auto ring_t::commit(const reservation_t& reservation) noexcept -> void {
+    BOOST_ASSERT(reservation.data != nullptr);
+
+    const auto data = reservation.data - header_size;
+    reinterpret_cast<std::atomic<std::uint32_t>*>(data)->store(reservation.length,
+        std::memory_order_release);
+}
+
+auto ring_t::read(slot_t& slot) noexcept -> bool {
+    while (true) {
+        // The whole ring is read, but not released yet - the memory at the cursor is stale.
+        if (cursor - tail.load(std::memory_order_relaxed) >= capacity_) {
+            return false;
+        }
+
+        const auto state = header(cursor).load(std::memory_order_acquire);
+
+        if (state == 0) {
+            return false;
+        }
+
+        if (state & padding) {
+            cursor += state & ~padding;
+            continue;
+        }
+
+        const auto data = buffer + (cursor & (capacity_ - 1));
+
+        std::uint32_t size;
+        std::memcpy(&size, data + sizeof(std::uint32_t), sizeof(size));
+
+        slot = {data + header_size, size};
+        cursor += state;
+        return true;
+    }
+}
+
+auto ring_t::release() noexcept -> void {
+    const auto position = tail.load(std::memory_order_relaxed);
+    const auto length = static_cast<std::size_t>(cursor - position);
+
+    if (length == 0) {
+        return;
+    }
+
+    // Zero the consumed memory, because any offset can become a slot header later.
+    const auto offset = position & (capacity_ - 1);
+    const auto first = std::min(length, capacity_ - offset);
+
+    std::memset(buffer + offset, 0, first);
+    std::memset(buffer, 0, length - first);
+
+    tail.store(cursor, std::memory_order_release);
+}
+
+auto ring_t::visit(void(*fn)(const slot_t& slot, void* context), void* context) const noexcept
+    -> void
+{
+    const auto position = tail.load(std::memory_order_acquire);
+    const auto end = head.load(std::memory_order_acquire);
+
+    for (auto current = position; current < end && current - position < capacity_;) {
+        const auto state = header(current).load(std::memory_order_acquire);
+
+        // Headers are garbage if the ring is being modified concurrently, so they are validated.
+        if (state == 0 || (state & ~padding) > capacity_) {
+            return;
+        }
+
+        if (state & padding) {
+            current += state & ~padding;
+            continue;
+        }
+
+        const auto data = buffer + (current & (capacity_ - 1));
+
+        std::uint32_t size;
+        std::memcpy(&size, data + sizeof(std::uint32_t), sizeof(size));
+
+        if (size + header_size > state) {
+            return;
+        }
+
+        fn({data + header_size, size}, context);
+        current += state;
+    }
+}
+
+auto ring_t::header(std::uint64_t position) const noexcept -> std::atomic<std::uint32_t>& {
+    return *reinterpret_cast<std::atomic<std::uint32_t>*>(buffer + (position & (capacity_ - 1)));
+}
+
+namespace ring {
+namespace {
+
+enum class tag_t : std::uint8_t {
+    null,
+    bool_,
+    sint64,
+    uint64,
+    double_,
+    string
+};
+
+struct fixed_t {
+    std::int32_t severity;
+    std::uint32_t nattributes;
+    std::int64_t timestamp;
+    std::uint64_t lwp;
+    std::uint32_t message;
+    std::uint32_t formatted;
+    std::uint32_t output;
+    std::uint32_t reserved;
+    std::thread::native_handle_type tid;
+    trace_t trace;
+};
+
+class encoder_t {
+    std::vector<char>& buffer;
+
+public:
+    typedef void result_type;
+
+    explicit encoder_t(std::vector<char>& buffer) noexcept :
+        buffer(buffer)
+    {}
+
+    template<typename T>
+    auto write(const T& value) -> void {
+        const auto data = reinterpret_cast<const char*>(&value);
+        buffer.insert(buffer.end(), data, data + sizeof(value));
+    }
+
+    auto write(const string_view& value) -> void {
+        buffer.insert(buffer.end(), value.data(), value.data() + value.size());
+    }
+
+    auto string(const string_view& value) -> void {
+        write(static_cast<std::uint32_t>(value.size()));
+        write(value);
+    }
+
+    auto operator()(const attribute::view_t::null_type&) -> void {
+        write(tag_t::null);
+    }
+
+    auto operator()(const attribute::view_t::bool_type& value) -> void {
+        write(tag_t::bool_);
+        write(static_cast<std::uint8_t>(value));
+    }
+
+    auto operator()(const attribute::view_t::sint64_type& value) -> void {
+        write(tag_t::sint64);
+        write(value);
+    }
+
+    auto operator()(const attribute::view_t::uint64_type& value) -> void {
+        write(tag_t::uint64);
+        write(value);
+    }
+
+    auto operator()(const attribute::view_t::double_type& value) -> void {
+        write(tag_t::double_);
+        write(value);
+    }
+
+    auto operator()(const attribute::view_t::string_type& value) -> void {
+        write(tag_t::string);
+        string(value);
+    }
+
+    auto operator()(const attribute::view_t::function_type& value) -> void {
+        writer_t wr;
+        value(wr);
+
+        write(tag_t::string);
+        string(wr.result());
+    }
+};
+
+class decoder_t {
+    const char* data;
+    const char* end;
+
+public:
+    decoder_t(const char* data, std::size_t size) noexcept :
+        data(data),
+        end(data + size)
+    {}
+
+    template<typename T>
+    auto read() noexcept -> T {
+        BOOST_ASSERT(data + sizeof(T) <= end);
+
+        T value;
+        std::memcpy(&value, data, sizeof(value));
+        data += sizeof(value);
+        return value;
+    }
+
+    auto read(std::size_t size) noexcept -> string_view {
+        BOOST_ASSERT(data + size <= end);
+
+        const string_view result(data, size);
+        data += size;
+        return result;
+    }
+
+    auto string() noexcept -> string_view {
+        return read(read<std::uint32_t>());
+    }
+
+    auto value() noexcept -> attribute::view_t {
+        switch (read<tag_t>()) {
+        case tag_t::bool_:
+            return attribute::view_t(read<std::uint8_t>() != 0);
+        case tag_t::sint64:
+            return attribute::view_t(read<attribute::view_t::sint64_type>());
+        case tag_t::uint64:
+            return attribute::view_t(read<attribute::view_t::uint64_type>());
+        case tag_t::double_:
+            return attribute::view_t(read<attribute::view_t::double_type>());
+        case tag_t::string:
+            return attribute::view_t(string());
+        case tag_t::null:
+        default:
+            return attribute::view_t();
+        }
+    }
+};
+
+}  // namespace
+
+auto encode(const record_t& record, const string_view& message) -> string_view {
+    thread_local std::vector<char> buffer;
+    buffer.clear();
+
+    std::uint32_t nattributes = 0;
+    for (const auto& list : record.attributes()) {
+        nattributes += static_cast<std::uint32_t>(list.get().size());
+    }
+
+    fixed_t fixed;
+    fixed.severity = record.severity();
+    fixed.nattributes = nattributes;
+    fixed.timestamp = record.timestamp().time_since_epoch().count();
+    fixed.lwp = record.lwp();
+    fixed.message = static_cast<std::uint32_t>(record.message().size());
+    fixed.formatted = static_cast<std::uint32_t>(record.formatted().size());
+    fixed.output = static_cast<std::uint32_t>(message.size());
+    fixed.reserved = 0;
+    fixed.tid = record.tid();
+    fixed.trace = record.trace();
+
+    encoder_t encoder(buffer);
+    encoder.write(fixed);
+    encoder.write(record.message());
+    encoder.write(record.formatted());
+    encoder.write(message);
+
+    for (const auto& list : record.attributes()) {
+        for (const auto& kv : list.get()) {
+            encoder.string(kv.first);
+            boost::apply_visitor(encoder, kv.second.inner().value);
+        }
+    }
+
+    return string_view(buffer.data(), buffer.size());
+}
+
+auto valid(const ring_t::slot_t& slot) noexcept -> bool {
+    fixed_t fixed;
+    if (slot.size < sizeof(fixed)) {
+        return false;
+    }
+
+    std::memcpy(&fixed, slot.data, sizeof(fixed));
+
+    std::size_t offset = sizeof(fixed);
+    const auto skip = [&](std::size_t size) -> bool {
+        if (size > slot.size - offset) {
+            return false;
+        }
+
+        offset += size;
+        return true;
+    };
+
+    const auto string = [&]() -> bool {
+        std::uint32_t size;
+        if (!skip(sizeof(size))) {
+            return false;
+        }
+
+        std::memcpy(&size, slot.data + offset - sizeof(size), sizeof(size));
+        return skip(size);
+    };
+
+    if (!skip(fixed.message) || !skip(fixed.formatted) || !skip(fixed.output)) {
+        return false;
+    }
+
+    for (std::uint32_t id = 0; id < fixed.nattributes; ++id) {
+        tag_t tag;
+        if (!string() || !skip(sizeof(tag))) {
+            return false;
+        }
+
+        std::memcpy(&tag, slot.data + offset - sizeof(tag), sizeof(tag));
+
+        auto result = true;
+        switch (tag) {
+        case tag_t::null:
+            break;
+        case tag_t::bool_:
+            result = skip(sizeof(std::uint8_t));
+            break;
+        case tag_t::sint64:
+        case tag_t::uint64:
+        case tag_t::double_:
+            result = skip(sizeof(std::uint64_t));
+            break;
+        case tag_t::string:
+            result = string();
+            break;
+        default:
+            result = false;
+        }
+
+        if (!result) {
+            return false;
+        }
+    }
+
+    return offset == slot.size;
+}
+
+auto dump(const ring_t::slot_t& slot, int fd) noexcept -> void {
+    fixed_t fixed;
+    if (slot.size < sizeof(fixed)) {
+        return;
+    }
+
+    std::memcpy(&fixed, slot.data, sizeof(fixed));
+
+    const std::size_t offset = sizeof(fixed) + std::size_t(fixed.message) + fixed.formatted;
+    if (offset + fixed.output > slot.size) {
+        return;
+    }
+
+    detail::crash::write(fd, string_view(slot.data + offset, fixed.output));
+    detail::crash::write(fd, string_view("\n", 1));
+}
+
+auto decoded_t::decode(const ring_t::slot_t& slot) -> void {
+    decoder_t decoder(slot.data, slot.size);
+
+    const auto fixed = decoder.read<fixed_t>();
+
+    message_ = decoder.read(fixed.message);
+    formatted_ = decoder.read(fixed.formatted);
+    output_ = decoder.read(fixed.output);
+
+    attributes.clear();
+    for (std::uint32_t id = 0; id < fixed.nattributes; ++id) {
+        const auto key = decoder.string();
+        attributes.emplace_back(key, decoder.value());
+    }
+
+    pack.clear();
+    pack.emplace_back(attributes);
+
+    record_t::inner_t inner{
+        std::cref(message_),
+        std::cref(formatted_),
+        fixed.severity,
+        record_t::time_point(record_t::time_point::duration(fixed.timestamp)),
+        fixed.tid,
+        fixed.lwp,
+        nullptr,
+        nullptr,
+        std::cref(pack),
+        fixed.trace
+    };
+
+    new (&storage) record_t(inner);
+}
+
+auto decoded_t::record() const noexcept -> const record_t& {
+    return reinterpret_cast<const record_t&>(storage);
+}
+
+auto decoded_t::output() const noexcept -> const string_view& {
+    return output_;
+}
+
+}  // namespace ring
+}  // namespace sink
+}  // namespace v1
+}  // namespace blackhole
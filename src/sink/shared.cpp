@@ -0,0 +1,372 @@
+#include "blackhole/detail/sink/shared.hpp"
+
+#include <atomic>
+#include <cstring>
+#include <new>
+
+#include "blackhole/clock.hpp"
+#include "blackhole/immortal.hpp"
+
+#include "blackhole/detail/budget.hpp"
+#include "blackhole/detail/recordbuf.hpp"
+#include "blackhole/detail/stage.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+namespace {
+
+typedef std::max_align_t block_type;
+
+constexpr auto align(std::size_t size) noexcept -> std::size_t {
+    return (size + sizeof(block_type) - 1) / sizeof(block_type) * sizeof(block_type);
+}
+
+/// Chunk size classes are powers of two starting from 1 KB, since the smallest records with their
+/// attribute lists take about a kilobyte. Larger chunks are allocated on demand.
+constexpr std::size_t min_class = 1024;
+constexpr std::size_t nclasses = 7;
+
+auto size_class(std::size_t size) noexcept -> std::size_t {
+    std::size_t id = 0;
+    while (id < nclasses && (min_class << id) < size) {
+        ++id;
+    }
+
+    return id;
+}
+
+class pool_t;
+
+}  // namespace
+
+/// Chunk header, followed by the record memory and the message bytes.
+class shared_record_t::block_t {
+public:
+    std::atomic<std::size_t> refs;
+
+    /// Pool of the thread the chunk is taken from, null for chunks beyond size classes.
+    pool_t* owner;
+    std::size_t size_class;
+    /// Chunk size accounted against the memory budget.
+    std::size_t size;
+    block_t* next;
+    /// Counter reading the record was captured at if it's sampled, zero otherwise.
+    std::uint64_t sampled;
+
+    detail::recordbuf_t record;
+    string_view message;
+
+    block_t(pool_t* owner, std::size_t size_class) noexcept :
+        refs(1),
+        owner(owner),
+        size_class(size_class),
+        size(0),
+        next(nullptr),
+        sampled(0)
+    {}
+
+    auto data() noexcept -> char* {
+        return reinterpret_cast<char*>(this) + align(sizeof(block_t));
+    }
+};
+
+namespace {
+
+typedef shared_record_t::block_t block_t;
+
+/// Free lists of chunks taken by a single producer thread.
+///
+/// Chunks released by the owning thread are pushed into its local lists without synchronization,
+/// while other threads, i.e. consumers, push them into lock-free remote lists, which the owner
+/// takes whole when its local list runs out, so there is no ABA problem. Lists grow up to the peak
+/// number of chunks in flight and keep them until the pool is destroyed.
+///
+/// The pool is reference counted by its thread and all chunks in flight, so it's destroyed by
+/// whoever drops the last reference after the thread exits.
+class pool_t {
+    struct free_list_t {
+        block_t* local;
+        std::atomic<block_t*> remote;
+        char pad[64 - sizeof(block_t*) - sizeof(std::atomic<block_t*>)];
+    };
+
+    std::atomic<std::size_t> refs;
+    free_list_t lists[nclasses];
+
+public:
+    pool_t() noexcept :
+        refs(1)
+    {
+        for (auto& list : lists) {
+            list.local = nullptr;
+            list.remote.store(nullptr, std::memory_order_relaxed);
+        }
+    }
+
+    ~pool_t() {
+        for (auto& list : lists) {
+            destroy(list.local);
+            destroy(list.remote.load(std::memory_order_acquire));
+        }
+    }
+
+    /// Returns memory of a chunk of the given size class with the block header constructed.
+    ///
+    /// \warning must be called by the owning thread only.
+    auto acquire(std::size_t size_class) -> block_t* {
+        auto& list = lists[size_class];
+
+        if (list.local == nullptr) {
+            list.local = list.remote.exchange(nullptr, std::memory_order_acquire);
+        }
+
+        void* memory = list.local;
+        if (memory != nullptr) {
+            list.local = list.local->next;
+            static_cast<block_t*>(memory)->~block_t();
+        } else {
+            memory = ::operator new(min_class << size_class);
+        }
+
+        refs.fetch_add(1, std::memory_order_relaxed);
+        return new (memory) block_t(this, size_class);
+    }
+
+    /// Returns the chunk into the pool, either local or remote list depending on the thread.
+    auto release(block_t* block, bool local) noexcept -> void {
+        auto& list = lists[block->size_class];
+
+        if (local) {
+            block->next = list.local;
+            list.local = block;
+        } else {
+            auto head = list.remote.load(std::memory_order_relaxed);
+            do {
+                block->next = head;
+            } while (!list.remote.compare_exchange_weak(head, block, std::memory_order_release,
+                std::memory_order_relaxed));
+        }
+
+        unref();
+    }
+
+    auto unref() noexcept -> void {
+        if (refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            delete this;
+        }
+    }
+
+private:
+    static auto destroy(block_t* block) noexcept -> void {
+        while (block != nullptr) {
+            const auto next = block->next;
+            block->~block_t();
+            ::operator delete(block);
+            block = next;
+        }
+    }
+};
+
+/// Pool of the current thread, which is released when the thread exits.
+struct local_t {
+    pool_t* pool;
+
+    ~local_t() {
+        if (pool != nullptr) {
+            pool->unref();
+            pool = nullptr;
+        }
+    }
+
+    auto get() -> pool_t& {
+        if (pool == nullptr) {
+            pool = new pool_t;
+        }
+
+        return *pool;
+    }
+};
+
+thread_local local_t local = {nullptr};
+
+auto deallocate(block_t* block) noexcept -> void {
+    block->record = detail::recordbuf_t();
+    block->message = string_view();
+
+    detail::budget::release(block->size);
+
+    if (const auto owner = block->owner) {
+        owner->release(block, owner == local.pool);
+    } else {
+        block->~block_t();
+        ::operator delete(block);
+    }
+}
+
+/// Allocation context, which learns the message size up front and the record size from the
+/// record buffer once it's measured.
+struct allocation_t {
+    std::size_t message;
+    block_t* block;
+
+    static auto allocate(std::size_t size, void* context) -> void* {
+        auto& self = *static_cast<allocation_t*>(context);
+
+        const auto total = align(sizeof(block_t)) + align(size) + self.message;
+        const auto id = size_class(total);
+
+        if (id < nclasses) {
+            self.block = local.get().acquire(id);
+            self.block->size = min_class << id;
+        } else {
+            self.block = new (::operator new(total)) block_t(nullptr, nclasses);
+            self.block->size = total;
+        }
+
+        detail::budget::charge(self.block->size);
+
+        self.block->sampled = detail::stage::active() ? clock::ticks() : 0;
+
+        return self.block->data();
+    }
+};
+
+thread_local sharing_t* current = nullptr;
+
+}  // namespace
+
+shared_record_t::shared_record_t(const shared_record_t& other) noexcept :
+    block(other.block)
+{
+    if (block != nullptr) {
+        block->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+shared_record_t::shared_record_t(shared_record_t&& other) noexcept :
+    block(other.block)
+{
+    other.block = nullptr;
+}
+
+shared_record_t::~shared_record_t() {
+    if (block != nullptr && block->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        deallocate(block);
+    }
+}
+
+auto shared_record_t::operator=(const shared_record_t& other) noexcept -> shared_record_t& {
+    shared_record_t copy(other);
+    std::swap(block, copy.block);
+    return *this;
+}
+
+auto shared_record_t::operator=(shared_record_t&& other) noexcept -> shared_record_t& {
+    shared_record_t copy(std::move(other));
+    std::swap(block, copy.block);
+    return *this;
+}
+
+auto shared_record_t::capture(const record_t& record, const string_view& message) ->
+    shared_record_t
+{
+    const auto scope = current;
+
+    if (scope != nullptr && scope->record == &record && scope->value.message() == message) {
+        return scope->value;
+    }
+
+    // Immortal messages, like unformatted literals, are referred to as is.
+    const auto keep = immortal::contains(message);
+    allocation_t allocation{keep ? 0 : message.size(), nullptr};
+
+    try {
+        detail::recordbuf_t buffer(record, &allocation_t::allocate, &allocation);
+
+        if (keep) {
+            allocation.block->message = message;
+        } else {
+            const auto data = allocation.block->data() + align(buffer.size());
+            std::memcpy(data, message.data(), message.size());
+            allocation.block->message = string_view(data, message.size());
+        }
+
+        allocation.block->record = std::move(buffer);
+    } catch (...) {
+        if (allocation.block != nullptr) {
+            deallocate(allocation.block);
+        }
+
+        throw;
+    }
+
+    shared_record_t result;
+    result.block = allocation.block;
+
+    if (scope != nullptr) {
+        scope->record = &record;
+        scope->value = result;
+    }
+
+    return result;
+}
+
+auto shared_record_t::reserve(const record_t& record, std::size_t size) -> shared_record_t {
+    allocation_t allocation{size, nullptr};
+
+    try {
+        detail::recordbuf_t buffer(record, &allocation_t::allocate, &allocation);
+        allocation.block->record = std::move(buffer);
+    } catch (...) {
+        if (allocation.block != nullptr) {
+            deallocate(allocation.block);
+        }
+
+        throw;
+    }
+
+    shared_record_t result;
+    result.block = allocation.block;
+    return result;
+}
+
+auto shared_record_t::room() const noexcept -> sink_t::region_t {
+    const auto offset = align(sizeof(block_t)) + align(block->record.size());
+    return sink_t::region_t{reinterpret_cast<char*>(block) + offset, block->size - offset};
+}
+
+auto shared_record_t::complete(std::size_t size) noexcept -> void {
+    block->message = string_view(room().data, size);
+}
+
+auto shared_record_t::record() const noexcept -> record_t {
+    return block->record.into_view();
+}
+
+auto shared_record_t::message() const noexcept -> string_view {
+    return block->message;
+}
+
+auto shared_record_t::sampled() const noexcept -> std::uint64_t {
+    return block->sampled;
+}
+
+auto shared_record_t::use_count() const noexcept -> std::size_t {
+    return block == nullptr ? 0 : block->refs.load(std::memory_order_relaxed);
+}
+
+sharing_t::sharing_t() noexcept :
+    previous(current),
+    record(nullptr)
+{
+    current = this;
+}
+
+sharing_t::~sharing_t() {
+    current = previous;
+}
+
+}  // namespace sink
+}  // namespace v1
+}  // namespace blackhole
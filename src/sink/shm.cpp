@@ -0,0 +1,385 @@
+#include "blackhole/sink/shm.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#   include <linux/futex.h>
+#   include <sys/syscall.h>
+#   include <time.h>
+#endif
+
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+
+#include <boost/optional/optional.hpp>
+
+#include "blackhole/config/node.hpp"
+#include "blackhole/config/option.hpp"
+#include "blackhole/record.hpp"
+
+#include "blackhole/detail/memory.hpp"
+#include "blackhole/detail/sink/ring.hpp"
+#include "blackhole/detail/sink/shm.hpp"
+#include "blackhole/detail/util/optional.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+namespace shm {
+namespace {
+
+/// Identifies the layout version.
+const char magic[8] = "BHSHMR1";
+
+/// Slot header size and the padding flag, the same as in the in-process ring.
+constexpr std::size_t header_size = 8;
+constexpr std::uint32_t padding = 1;
+
+static_assert(offsetof(header_t, head) == 64, "producers position must start the second line");
+static_assert(offsetof(header_t, tail) == 128, "consumer position must start the third line");
+static_assert(offsetof(header_t, doorbell) == 192, "doorbell must start the fourth line");
+
+constexpr auto align(std::size_t size) noexcept -> std::size_t {
+    return (size + 7) & ~std::size_t(7);
+}
+
+auto page_size() noexcept -> std::size_t {
+    const auto size = ::sysconf(_SC_PAGESIZE);
+    return size > 0 ? static_cast<std::size_t>(size) : 4096;
+}
+
+auto slot(char* data, std::uint64_t capacity, std::uint64_t position) noexcept ->
+    std::atomic<std::uint32_t>&
+{
+    return *reinterpret_cast<std::atomic<std::uint32_t>*>(data + (position & (capacity - 1)));
+}
+
+auto wake(std::atomic<std::uint32_t>& word) noexcept -> void {
+#ifdef __linux__
+    ::syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word), FUTEX_WAKE, 1, nullptr, nullptr, 0);
+#else
+    (void)word;
+#endif
+}
+
+}  // namespace
+
+mapping_t::mapping_t() noexcept :
+    fd(-1),
+    map(nullptr),
+    size(0),
+    header(nullptr),
+    data(nullptr)
+{}
+
+mapping_t::~mapping_t() {
+    if (map) {
+        ::munmap(map, size);
+    }
+
+    if (fd != -1) {
+        ::close(fd);
+    }
+}
+
+auto mapping_t::capacity() const noexcept -> std::uint64_t {
+    return header->capacity;
+}
+
+auto mapping_t::format() const noexcept -> format_t {
+    return static_cast<format_t>(header->format);
+}
+
+auto mapping_t::dropped() const noexcept -> std::uint64_t {
+    return header->dropped.load(std::memory_order_relaxed);
+}
+
+auto mapping_t::attach(int fd, std::size_t size) -> void {
+    this->fd = fd;
+
+    const auto memory = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+    if (memory == MAP_FAILED) {
+        throw std::system_error(errno, std::system_category());
+    }
+
+    this->map = static_cast<char*>(memory);
+    this->size = size;
+    this->header = reinterpret_cast<header_t*>(map);
+    this->data = map + page_size();
+}
+
+reader_t::reader_t(const std::string& name) :
+    cursor(0)
+{
+    const auto fd = ::shm_open(name.c_str(), O_RDWR | O_CLOEXEC, 0);
+
+    if (fd == -1) {
+        throw std::system_error(errno, std::system_category());
+    }
+
+    struct stat stat;
+    if (::fstat(fd, &stat) != 0) {
+        const auto ec = errno;
+        ::close(fd);
+        throw std::system_error(ec, std::system_category());
+    }
+
+    const auto page = page_size();
+    const auto total = static_cast<std::size_t>(stat.st_size);
+
+    if (total <= page) {
+        ::close(fd);
+        throw std::invalid_argument("shared memory object is too small to be a ring");
+    }
+
+    attach(fd, total);
+
+    if (std::memcmp(header->magic, magic, sizeof(magic)) != 0 || header->capacity != total - page) {
+        throw std::invalid_argument("shared memory object has unknown layout");
+    }
+
+    cursor = header->tail.load(std::memory_order_acquire);
+}
+
+auto reader_t::read(slot_type& slot) noexcept -> bool {
+    const auto capacity = header->capacity;
+
+    while (true) {
+        // The whole ring is read, but not released yet - the memory at the cursor is stale.
+        if (cursor - header->tail.load(std::memory_order_relaxed) >= capacity) {
+            return false;
+        }
+
+        const auto state = shm::slot(data, capacity, cursor).load(std::memory_order_acquire);
+
+        if (state == 0) {
+            return false;
+        }
+
+        if (state & padding) {
+            cursor += state & ~padding;
+            continue;
+        }
+
+        const auto offset = data + (cursor & (capacity - 1));
+
+        std::uint32_t size;
+        std::memcpy(&size, offset + sizeof(std::uint32_t), sizeof(size));
+
+        slot = slot_type(offset + header_size, size);
+        cursor += state;
+        return true;
+    }
+}
+
+auto reader_t::release() noexcept -> void {
+    const auto capacity = static_cast<std::size_t>(header->capacity);
+    const auto position = header->tail.load(std::memory_order_relaxed);
+    const auto length = static_cast<std::size_t>(cursor - position);
+
+    if (length == 0) {
+        return;
+    }
+
+    // Zero the consumed memory, because any offset can become a slot header later.
+    const auto offset = static_cast<std::size_t>(position & (capacity - 1));
+    const auto first = std::min(length, capacity - offset);
+
+    std::memset(data + offset, 0, first);
+    std::memset(data, 0, length - first);
+
+    header->tail.store(cursor, std::memory_order_release);
+}
+
+auto reader_t::wait(std::chrono::milliseconds timeout) -> bool {
+    const auto bell = header->doorbell.load(std::memory_order_acquire);
+
+    header->waiting.store(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    // Producers might have committed after the last read, but before noticing the flag.
+    if (shm::slot(data, header->capacity, cursor).load(std::memory_order_acquire) != 0) {
+        header->waiting.store(0, std::memory_order_relaxed);
+        return true;
+    }
+
+#ifdef __linux__
+    struct timespec ts;
+    ts.tv_sec = static_cast<time_t>(timeout.count() / 1000);
+    ts.tv_nsec = static_cast<long>(timeout.count() % 1000 * 1000000);
+
+    ::syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&header->doorbell), FUTEX_WAIT, bell,
+        &ts, nullptr, 0);
+#else
+    std::this_thread::sleep_for(timeout);
+#endif
+
+    header->waiting.store(0, std::memory_order_relaxed);
+    return header->doorbell.load(std::memory_order_acquire) != bell;
+}
+
+}  // namespace shm
+
+shm_t::shm_t(std::string name, std::size_t capacity, shm::format_t format) :
+    name_(std::move(name)),
+    format_(format)
+{
+    const auto page = shm::page_size();
+
+    if (capacity < page || (capacity & (capacity - 1)) != 0) {
+        throw std::invalid_argument("ring capacity must be a power of two not less than a page");
+    }
+
+    const auto total = page + capacity;
+    const auto fd = ::shm_open(name_.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+
+    if (fd == -1) {
+        throw std::system_error(errno, std::system_category());
+    }
+
+    struct stat stat;
+    if (::fstat(fd, &stat) != 0) {
+        const auto ec = errno;
+        ::close(fd);
+        throw std::system_error(ec, std::system_category());
+    }
+
+    const auto fresh = static_cast<std::size_t>(stat.st_size) != total;
+
+    // Truncating to zero first guarantees zeroed memory, which is required for slot headers.
+    if (fresh && (::ftruncate(fd, 0) != 0 || ::ftruncate(fd, static_cast<off_t>(total)) != 0)) {
+        const auto ec = errno;
+        ::close(fd);
+        throw std::system_error(ec, std::system_category());
+    }
+
+    attach(fd, total);
+
+    const auto valid = std::memcmp(header->magic, shm::magic, sizeof(shm::magic)) == 0 &&
+        header->capacity == capacity && header->format == static_cast<std::uint32_t>(format);
+
+    if (!valid) {
+        std::memset(map, 0, total);
+
+        header->format = static_cast<std::uint32_t>(format);
+        header->capacity = capacity;
+        new (&header->head) std::atomic<std::uint64_t>(0);
+        new (&header->tail) std::atomic<std::uint64_t>(0);
+        new (&header->doorbell) std::atomic<std::uint32_t>(0);
+        new (&header->waiting) std::atomic<std::uint32_t>(0);
+        new (&header->dropped) std::atomic<std::uint64_t>(0);
+
+        // Readers recognize the object only when the magic is published.
+        std::atomic_thread_fence(std::memory_order_release);
+        std::memcpy(header->magic, shm::magic, sizeof(shm::magic));
+    }
+}
+
+auto shm_t::name() const noexcept -> const std::string& {
+    return name_;
+}
+
+auto shm_t::emit(const record_t& record, const string_view& formatted) -> void {
+    const auto payload = format_ == shm::format_t::binary ? ring::encode(record, formatted) : formatted;
+
+    if (!push(payload)) {
+        header->dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+auto shm_t::push(const string_view& payload) noexcept -> bool {
+    const auto capacity = header->capacity;
+    const auto length = shm::align(shm::header_size + payload.size());
+
+    if (length > capacity) {
+        return false;
+    }
+
+    auto position = header->head.load(std::memory_order_relaxed);
+    std::uint64_t skip;
+
+    while (true) {
+        const auto offset = position & (capacity - 1);
+        skip = offset + length > capacity ? capacity - offset : 0;
+
+        if (position + skip + length - header->tail.load(std::memory_order_acquire) > capacity) {
+            return false;
+        }
+
+        if (header->head.compare_exchange_weak(position, position + skip + length,
+            std::memory_order_relaxed))
+        {
+            break;
+        }
+    }
+
+    if (skip > 0) {
+        shm::slot(data, capacity, position).store(static_cast<std::uint32_t>(skip) | shm::padding,
+            std::memory_order_release);
+        position += skip;
+    }
+
+    const auto slot = data + (position & (capacity - 1));
+
+    const auto size = static_cast<std::uint32_t>(payload.size());
+    std::memcpy(slot + sizeof(std::uint32_t), &size, sizeof(size));
+    std::memcpy(slot + shm::header_size, payload.data(), payload.size());
+
+    shm::slot(data, capacity, position).store(static_cast<std::uint32_t>(length),
+        std::memory_order_release);
+
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    if (header->waiting.load(std::memory_order_relaxed) != 0 &&
+        header->waiting.exchange(0, std::memory_order_relaxed) != 0)
+    {
+        header->doorbell.fetch_add(1, std::memory_order_release);
+        shm::wake(header->doorbell);
+    }
+
+    return true;
+}
+
+}  // namespace sink
+
+using detail::util::value_or;
+
+auto factory<sink::shm_t>::type() const noexcept -> const char* {
+    return "shm";
+}
+
+auto factory<sink::shm_t>::from(const config::node_t& config) const -> std::unique_ptr<sink_t> {
+    (void)registry;
+
+    const auto name = value_or(config["name"].to_string(), []() -> std::string {
+        throw std::invalid_argument(R"(parameter "name" is required)");
+    });
+
+    std::size_t capacity = 1024 * 1024;
+    if (auto value = config["capacity"].to_uint64()) {
+        capacity = static_cast<std::size_t>(value.get());
+    }
+
+    auto format = sink::shm::format_t::text;
+    if (auto value = config["format"].to_string()) {
+        if (value.get() == "binary") {
+            format = sink::shm::format_t::binary;
+        } else if (value.get() != "text") {
+            throw std::invalid_argument("unknown shared memory ring format: \"" + value.get() + "\"");
+        }
+    }
+
+    return blackhole::make_unique<sink::shm_t>(name, capacity, format);
+}
+
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,277 @@
+#include "balanced.hpp"
+
+#include <algorithm>
+#include <exception>
+#include <stdexcept>
+
+#include <boost/variant/apply_visitor.hpp>
+
+#include "blackhole/attribute.hpp"
+#include "blackhole/attribute/table.hpp"
+#include "blackhole/extensions/writer.hpp"
+#include "blackhole/record.hpp"
+
+#include "blackhole/detail/attribute.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+namespace socket {
+namespace {
+
+using attribute::view_t;
+
+/// Number of points each endpoint takes on the hash ring.
+constexpr std::size_t replicas = 64;
+
+class hash_t : public boost::static_visitor<std::uint64_t> {
+public:
+    auto operator()(const view_t::null_type&) const noexcept -> std::uint64_t {
+        return 0;
+    }
+
+    template<typename T>
+    auto operator()(const T& value) const -> std::uint64_t {
+        return std::hash<T>()(value);
+    }
+
+    auto operator()(const view_t::function_type& value) const -> std::uint64_t {
+        writer_t writer;
+        value(writer);
+        return std::hash<string_view>()(writer.result());
+    }
+};
+
+/// Finalizer of SplitMix64, which spreads keys over the ring, since standard hashes of integers
+/// are usually identities.
+auto mix(std::uint64_t value) noexcept -> std::uint64_t {
+    value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ull;
+    value = (value ^ (value >> 27)) * 0x94d049bb133111ebull;
+    return value ^ (value >> 31);
+}
+
+auto now() noexcept -> std::int64_t {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+}  // namespace
+
+balanced_t::balanced_t(std::vector<endpoint_t> endpoints, balancing_t balancing,
+                       factory_type factory) :
+    balancing(std::move(balancing)),
+    next(0)
+{
+    if (endpoints.empty()) {
+        throw std::invalid_argument("balanced sink requires at least one endpoint");
+    }
+
+    if (this->balancing.connections == 0) {
+        throw std::invalid_argument("balanced sink requires at least one connection per endpoint");
+    }
+
+    if (this->balancing.strategy == balancing_t::strategy_t::hash &&
+        this->balancing.attribute.empty())
+    {
+        throw std::invalid_argument("hash balancing requires an attribute");
+    }
+
+    for (auto& endpoint : endpoints) {
+        std::unique_ptr<node_t> node(new node_t);
+        node->endpoint = std::move(endpoint);
+        node->until.store(0);
+
+        for (std::size_t id = 0; id < this->balancing.connections; ++id) {
+            node->connections.push_back(factory(node->endpoint));
+        }
+
+        const auto name = node->endpoint.host + ":" + std::to_string(node->endpoint.port);
+        for (std::size_t id = 0; id < replicas; ++id) {
+            const auto point = std::hash<std::string>()(name + "#" + std::to_string(id));
+            ring.emplace_back(mix(point), nodes.size());
+        }
+
+        nodes.push_back(std::move(node));
+    }
+
+    std::sort(ring.begin(), ring.end());
+}
+
+auto balanced_t::healthy(std::size_t id) const -> bool {
+    return nodes.at(id)->until.load() == 0;
+}
+
+auto balanced_t::emit(const record_t& record, const string_view& message) -> void {
+    send(route(record), [&](sink_t& sink) {
+        sink.emit(record, message);
+    });
+}
+
+auto balanced_t::emit_batch(const event_t* events, std::size_t size) -> void {
+    if (balancing.strategy == balancing_t::strategy_t::round_robin) {
+        send(route_t{next++, false}, [&](sink_t& sink) {
+            sink.emit_batch(events, size);
+        });
+        return;
+    }
+
+    // Records are grouped by the preferred connection, keeping their relative order, while records
+    // without the attribute share a single round-robin route.
+    const auto fallback = route_t{next++, false};
+    const auto count = nodes.size() * balancing.connections;
+
+    std::vector<route_t> routes(count, fallback);
+    std::vector<std::vector<event_t>> groups(count);
+
+    for (std::size_t id = 0; id < size; ++id) {
+        auto current = route(*events[id].record);
+
+        if (!current.hashed) {
+            current = fallback;
+        }
+
+        const auto group = order(current).front() * balancing.connections + connection(current);
+
+        if (groups[group].empty()) {
+            routes[group] = current;
+        }
+
+        groups[group].push_back(events[id]);
+    }
+
+    for (std::size_t id = 0; id < count; ++id) {
+        if (groups[id].empty()) {
+            continue;
+        }
+
+        const auto& group = groups[id];
+        send(routes[id], [&](sink_t& sink) {
+            sink.emit_batch(group.data(), group.size());
+        });
+    }
+}
+
+auto balanced_t::collect(metrics::collector_t& collector) const -> void {
+    for (const auto& node : nodes) {
+        const auto& endpoint = node->endpoint;
+
+        auto labeled = collector.with("endpoint", endpoint.host + ":" +
+            std::to_string(endpoint.port));
+        labeled.gauge("blackhole_endpoint_healthy", node->until.load() == 0 ? 1 : 0);
+        labeled.counter("blackhole_endpoint_failures_total", node->failures.get());
+
+        for (const auto& connection : node->connections) {
+            connection->collect(labeled);
+        }
+    }
+}
+
+auto balanced_t::route(const record_t& record) -> route_t {
+    if (balancing.strategy == balancing_t::strategy_t::hash) {
+        if (auto value = record.table().find(balancing.attribute)) {
+            return route_t{mix(boost::apply_visitor(hash_t(), value->inner().value)), true};
+        }
+    }
+
+    return route_t{next++, false};
+}
+
+auto balanced_t::order(const route_t& route) const -> order_type {
+    order_type result;
+
+    if (!route.hashed) {
+        for (std::size_t id = 0; id < nodes.size(); ++id) {
+            result.push_back((route.key + id) % nodes.size());
+        }
+
+        return result;
+    }
+
+    // Walks the ring clockwise from the key, collecting each endpoint the first time it's met.
+    auto it = std::lower_bound(ring.begin(), ring.end(), std::make_pair(route.key, std::size_t(0)));
+
+    for (std::size_t step = 0; step < ring.size() && result.size() < nodes.size(); ++step, ++it) {
+        if (it == ring.end()) {
+            it = ring.begin();
+        }
+
+        if (std::find(result.begin(), result.end(), it->second) == result.end()) {
+            result.push_back(it->second);
+        }
+    }
+
+    return result;
+}
+
+auto balanced_t::connection(const route_t& route) const -> std::size_t {
+    if (route.hashed) {
+        return static_cast<std::size_t>((route.key >> 32) % balancing.connections);
+    }
+
+    return static_cast<std::size_t>((route.key / nodes.size()) % balancing.connections);
+}
+
+template<typename F>
+auto balanced_t::send(const route_t& route, const F& fn) -> void {
+    const auto timestamp = now();
+    const auto interval = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        balancing.interval).count();
+    const auto id = connection(route);
+
+    node_t* disconnected = nullptr;
+    std::exception_ptr error;
+
+    for (auto index : order(route)) {
+        auto& node = *nodes[index];
+
+        // Only the thread moving the deadline forward probes the endpoint out of rotation.
+        auto until = node.until.load();
+        if (until != 0 &&
+            (timestamp < until || !node.until.compare_exchange_strong(until, timestamp + interval)))
+        {
+            continue;
+        }
+
+        auto& sink = *node.connections[id];
+
+        if (!sink.available()) {
+            if (disconnected == nullptr) {
+                disconnected = &node;
+            }
+
+            continue;
+        }
+
+        try {
+            fn(sink);
+        } catch (...) {
+            error = std::current_exception();
+            node.failures.add();
+            node.until.store(timestamp + interval);
+            continue;
+        }
+
+        if (until != 0) {
+            node.until.store(0);
+        }
+
+        return;
+    }
+
+    // Non-blocking connections buffer messages until reconnected.
+    if (disconnected != nullptr) {
+        fn(*disconnected->connections[id]);
+        return;
+    }
+
+    if (error) {
+        std::rethrow_exception(error);
+    }
+
+    throw std::runtime_error("all endpoints are out of rotation");
+}
+
+}  // namespace socket
+}  // namespace sink
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/container/small_vector.hpp>
+
+#include "blackhole/metrics.hpp"
+#include "blackhole/sink.hpp"
+
+#include "tcp.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+namespace socket {
+
+/// Represents a collector node of balanced sinks.
+struct endpoint_t {
+    std::string host;
+    std::uint16_t port;
+};
+
+/// Represents the distribution policy of balanced sinks.
+struct balancing_t {
+    enum class strategy_t {
+        /// Records and batches are distributed over all connections one after another.
+        round_robin,
+        /// Records are distributed by the consistent hash of the attribute value, so records with
+        /// the same value go through the same connection, keeping their order.
+        hash
+    };
+
+    strategy_t strategy;
+
+    /// Name of the attribute hashed with the hash strategy. Records without it are distributed
+    /// round-robin.
+    std::string attribute;
+
+    /// Number of connections to each endpoint.
+    std::size_t connections;
+
+    /// Time an endpoint stays out of rotation after a failure before it's probed again.
+    std::chrono::milliseconds interval;
+
+    balancing_t() :
+        strategy(strategy_t::round_robin),
+        connections(1),
+        interval(1000)
+    {}
+};
+
+/// Distributes records over multiple connections to multiple collector endpoints.
+///
+/// Endpoints failing to accept records are taken out of rotation, and the records are written to
+/// the next endpoint instead: the following one for round-robin distribution and the next one on
+/// the hash ring for hashed one. An endpoint out of rotation is probed with the next record routed
+/// to it once the interval passes, which is only done by a single thread at a time, returning the
+/// endpoint into rotation if it succeeds. Endpoints of non-blocking connections, which never throw,
+/// are skipped while disconnected, reconnecting on their own, unless no endpoint is connected.
+///
+/// Batches are written through a single connection each with round-robin distribution, while with
+/// hashed one they are split into runs by the preferred connection, each following the ring of
+/// its first record on failover.
+class balanced_t : public sink_t {
+public:
+    typedef std::function<std::unique_ptr<tcp_t>(const endpoint_t& endpoint)> factory_type;
+
+private:
+    struct node_t {
+        endpoint_t endpoint;
+        std::vector<std::unique_ptr<tcp_t>> connections;
+        /// Steady clock ticks until which the endpoint is out of rotation, zero if it's in it.
+        std::atomic<std::int64_t> until;
+        metrics::counter_t failures;
+    };
+
+    balancing_t balancing;
+    std::vector<std::unique_ptr<node_t>> nodes;
+
+    /// Points of virtual nodes on the hash ring with indices of their endpoints, sorted by point.
+    std::vector<std::pair<std::uint64_t, std::size_t>> ring;
+
+    std::atomic<std::uint64_t> next;
+
+public:
+    /// Constructs a balanced sink, creating the given number of connections to each endpoint using
+    /// the factory.
+    ///
+    /// \throw std::invalid_argument if there are no endpoints, no connections or no attribute for
+    ///     the hash strategy.
+    balanced_t(std::vector<endpoint_t> endpoints, balancing_t balancing, factory_type factory);
+
+    /// Returns whether the endpoint with the given index is in rotation.
+    auto healthy(std::size_t id) const -> bool;
+
+    auto emit(const record_t& record, const string_view& message) -> void override;
+    auto emit_batch(const event_t* events, std::size_t size) -> void override;
+
+    /// Collects for each endpoint whether it's in rotation and the number of failures.
+    auto collect(metrics::collector_t& collector) const -> void override;
+
+private:
+    /// Distribution key of a record, which is either the mixed hash of its attribute or the value
+    /// of the round-robin counter.
+    struct route_t {
+        std::uint64_t key;
+        bool hashed;
+    };
+
+    typedef boost::container::small_vector<std::size_t, 8> order_type;
+
+    auto route(const record_t& record) -> route_t;
+
+    /// Returns indices of endpoints in the order of preference for the given route.
+    auto order(const route_t& route) const -> order_type;
+
+    /// Returns the index of the connection the given route prefers within each endpoint.
+    auto connection(const route_t& route) const -> std::size_t;
+
+    /// Calls the given function with one of connections of endpoints in the order of preference
+    /// for the given route until it succeeds, taking failed endpoints out of rotation.
+    ///
+    /// \throw the last exception thrown by the function if no endpoint succeeds.
+    template<typename F>
+    auto send(const route_t& route, const F& fn) -> void;
+};
+
+}  // namespace socket
+}  // namespace sink
+}  // namespace v1
+}  // namespace blackhole
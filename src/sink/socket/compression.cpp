@@ -0,0 +1,199 @@
+#include "compression.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <zlib.h>
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+namespace socket {
+
+namespace {
+
+/// Length of substrings counted when training dictionaries.
+constexpr std::size_t gram = 8;
+
+/// Length of dictionary segments.
+constexpr std::size_t segment = 64;
+
+auto key(const char* data) noexcept -> std::uint64_t {
+    std::uint64_t result;
+    std::memcpy(&result, data, sizeof(result));
+    return result;
+}
+
+}  // namespace
+
+struct compressor_t::state_t {
+    z_stream stream;
+};
+
+compressor_t::compressor_t(int level, std::string dictionary) :
+    dictionary(std::move(dictionary)),
+    state(new state_t)
+{
+    if (level < 1 || level > 9) {
+        throw std::invalid_argument("compression level must be in [1; 9] range");
+    }
+
+    std::memset(&state->stream, 0, sizeof(state->stream));
+
+    // The zlib format declares in its header whether a dictionary is used and which one.
+    if (::deflateInit2(&state->stream, level, Z_DEFLATED, 15, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        throw std::bad_alloc();
+    }
+
+    reset();
+}
+
+compressor_t::~compressor_t() {
+    ::deflateEnd(&state->stream);
+}
+
+auto compressor_t::reset() -> void {
+    ::deflateReset(&state->stream);
+
+    if (!dictionary.empty()) {
+        ::deflateSetDictionary(&state->stream,
+            reinterpret_cast<const Bytef*>(dictionary.data()), static_cast<uInt>(dictionary.size()));
+    }
+}
+
+auto compressor_t::compress(const char* data, std::size_t size, bool flush, std::string& output) ->
+    void
+{
+    auto& stream = state->stream;
+
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+    stream.avail_in = static_cast<uInt>(size);
+
+    // Output is written directly into the buffer, growing it by the bound of the remaining input.
+    do {
+        const auto offset = output.size();
+        output.resize(offset + ::deflateBound(&stream, stream.avail_in) + 16);
+
+        stream.next_out = reinterpret_cast<Bytef*>(&output[offset]);
+        stream.avail_out = static_cast<uInt>(output.size() - offset);
+
+        ::deflate(&stream, flush ? Z_SYNC_FLUSH : Z_NO_FLUSH);
+
+        output.resize(output.size() - stream.avail_out);
+    } while (stream.avail_out == 0);
+}
+
+auto train(const std::vector<std::string>& samples, std::size_t size) -> std::string {
+    std::size_t total = 0;
+    for (const auto& sample : samples) {
+        total += sample.size();
+    }
+
+    // Small samples fit entirely.
+    if (total <= size) {
+        std::string result;
+        for (const auto& sample : samples) {
+            result += sample;
+        }
+
+        return result;
+    }
+
+    // Number of samples each substring occurs in.
+    std::unordered_map<std::uint64_t, std::size_t> counts;
+
+    for (const auto& sample : samples) {
+        std::unordered_set<std::uint64_t> seen;
+
+        for (std::size_t pos = 0; pos + gram <= sample.size(); ++pos) {
+            if (seen.insert(key(&sample[pos])).second) {
+                ++counts[key(&sample[pos])];
+            }
+        }
+    }
+
+    struct chosen_t {
+        std::size_t score;
+        std::string data;
+    };
+
+    std::vector<chosen_t> chosen;
+
+    const auto epochs = (size + segment - 1) / segment;
+    const auto epoch = std::max<std::size_t>(total / epochs, 1);
+
+    std::size_t id = 0;
+    std::size_t used = 0;
+
+    while (id < samples.size() && used < size) {
+        // Best segment of the current epoch as the sample index, offset and score.
+        std::size_t best = samples.size();
+        std::size_t offset = 0;
+        std::size_t score = 0;
+
+        for (std::size_t consumed = 0; id < samples.size() && consumed < epoch; ++id) {
+            const auto& sample = samples[id];
+            consumed += sample.size();
+
+            if (sample.size() < gram) {
+                continue;
+            }
+
+            const auto grams = sample.size() - gram + 1;
+            const auto window = std::min(segment - gram + 1, grams);
+
+            // Scores windows of substrings starting within the segment using a sliding sum.
+            std::size_t current = 0;
+            for (std::size_t pos = 0; pos < grams; ++pos) {
+                current += counts[key(&sample[pos])];
+
+                if (pos >= window) {
+                    current -= counts[key(&sample[pos - window])];
+                }
+
+                if (pos + 1 >= window && current > score) {
+                    best = id;
+                    offset = pos + 1 - window;
+                    score = current;
+                }
+            }
+        }
+
+        if (best == samples.size()) {
+            continue;
+        }
+
+        const auto& sample = samples[best];
+        const auto length = std::min({segment, sample.size() - offset, size - used});
+
+        // Covered substrings are not rewarded again.
+        for (std::size_t pos = offset; pos + gram <= offset + length; ++pos) {
+            counts[key(&sample[pos])] = 0;
+        }
+
+        chosen.push_back({score, sample.substr(offset, length)});
+        used += length;
+    }
+
+    std::stable_sort(chosen.begin(), chosen.end(), [](const chosen_t& lhs, const chosen_t& rhs) {
+        return lhs.score < rhs.score;
+    });
+
+    std::string result;
+    result.reserve(used);
+
+    for (const auto& item : chosen) {
+        result += item.data;
+    }
+
+    return result;
+}
+
+}  // namespace socket
+}  // namespace sink
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+namespace socket {
+
+/// Options of the stream compression.
+struct compression_t {
+    /// Compression level from 1 to 9.
+    int level;
+    /// Preset dictionary, which allows compressing short messages well from the beginning of the
+    /// stream. Receivers must use the same one, identified by its Adler-32 checksum declared in
+    /// the zlib stream header.
+    std::string dictionary;
+    /// Delay before compressing and writing data that arrives into an idle connection in
+    /// non-blocking mode, which gathers more messages into a single flushed block.
+    std::chrono::milliseconds linger;
+
+    compression_t() :
+        level(6),
+        linger(0)
+    {}
+};
+
+/// Streaming zlib compressor, whose output can be decompressed incrementally, since each
+/// compressed batch ends on a byte boundary using `Z_SYNC_FLUSH`.
+class compressor_t {
+    struct state_t;
+
+    std::string dictionary;
+    std::unique_ptr<state_t> state;
+
+public:
+    /// \throw std::invalid_argument if the compression level is out of range.
+    compressor_t(int level, std::string dictionary);
+    ~compressor_t();
+
+    /// Starts a new stream, which must be done for each new connection.
+    auto reset() -> void;
+
+    /// Compresses the given data, appending the output to the given buffer.
+    ///
+    /// \param flush whether to complete the batch making all data compressed so far decodable.
+    auto compress(const char* data, std::size_t size, bool flush, std::string& output) -> void;
+};
+
+/// Builds a preset dictionary of at most the given size from sample messages.
+///
+/// Messages are split into epochs, from each of which the segment containing the most 8-byte
+/// substrings common among samples and not yet covered by previously chosen segments is picked.
+/// Segments are ordered by their scores, the best ones last, where zlib matches them with the
+/// shortest distances. The result is deterministic, so it can be reproduced by receivers.
+auto train(const std::vector<std::string>& samples, std::size_t size = 32 * 1024) -> std::string;
+
+}  // namespace socket
+}  // namespace sink
+}  // namespace v1
+}  // namespace blackhole
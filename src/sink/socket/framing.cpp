@@ -0,0 +1,94 @@
+#include "framing.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <stdexcept>
+#include <string>
+
+#include "blackhole/config/node.hpp"
+#include "blackhole/config/option.hpp"
+#include "blackhole/extensions/format.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+namespace socket {
+
+auto prefix(framing_t framing, std::size_t size, char* buffer) noexcept -> std::size_t {
+    switch (framing) {
+    case framing_t::length: {
+        const auto value = static_cast<std::uint32_t>(size);
+        buffer[0] = static_cast<char>(value >> 24);
+        buffer[1] = static_cast<char>(value >> 16);
+        buffer[2] = static_cast<char>(value >> 8);
+        buffer[3] = static_cast<char>(value);
+        return 4;
+    }
+    case framing_t::octet: {
+        const fmt::FormatInt formatted(size);
+        std::memcpy(buffer, formatted.data(), formatted.size());
+        buffer[formatted.size()] = ' ';
+        return formatted.size() + 1;
+    }
+    case framing_t::none:
+    case framing_t::newline:
+        break;
+    }
+
+    return 0;
+}
+
+auto suffix(framing_t framing) noexcept -> string_view {
+    return framing == framing_t::newline ? string_view("\n", 1) : string_view();
+}
+
+auto framing(const config::node_t& config) -> framing_t {
+    auto value = config["framing"].to_string();
+    if (!value) {
+        return framing_t::none;
+    }
+
+    const std::map<std::string, framing_t> mapping{
+        {"none", framing_t::none},
+        {"newline", framing_t::newline},
+        {"length", framing_t::length},
+        {"octet-counting", framing_t::octet},
+    };
+
+    const auto it = mapping.find(value.get());
+    if (it == mapping.end()) {
+        throw std::invalid_argument(R"(parameter "framing" must be one of "none", "newline", )"
+            R"("length" or "octet-counting")");
+    }
+
+    return it->second;
+}
+
+auto nonblocking(const config::node_t& config) -> boost::optional<nonblocking_t> {
+    auto nonblocking = config["nonblocking"];
+    if (!nonblocking) {
+        return boost::none;
+    }
+
+    nonblocking_t options{1024 * 1024, nonblocking_t::overflow_t::wait};
+
+    if (auto capacity = nonblocking["capacity"].to_uint64()) {
+        options.capacity = static_cast<std::size_t>(capacity.get());
+    }
+
+    if (auto overflow = nonblocking["overflow"].to_string()) {
+        if (overflow.get() == "drop") {
+            options.overflow = nonblocking_t::overflow_t::drop;
+        } else if (overflow.get() != "wait") {
+            throw std::invalid_argument(R"(parameter "overflow" must be either "drop" or "wait")");
+        }
+    }
+
+    return options;
+}
+
+}  // namespace socket
+}  // namespace sink
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+
+#include <boost/optional/optional.hpp>
+
+#include "blackhole/stdext/string_view.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace config {
+
+class node_t;
+
+}  // namespace config
+
+namespace sink {
+namespace socket {
+
+/// Message framing, allowing receivers to split the stream back into messages.
+enum class framing_t {
+    /// Messages are written as is.
+    none,
+    /// Each message is followed by a newline.
+    newline,
+    /// Each message is prefixed with its size as 32-bit big-endian integer.
+    length,
+    /// Each message is prefixed with its size in decimal followed by a space, as the octet
+    /// counting method of RFC 6587 requires.
+    octet
+};
+
+/// Options of the non-blocking mode.
+struct nonblocking_t {
+    /// What to do with new messages when the send buffer is full.
+    enum class overflow_t {
+        /// Drop new messages, counting them.
+        drop,
+        /// Block the caller until the buffer has enough free space.
+        wait
+    };
+
+    /// Send buffer size in bytes.
+    std::size_t capacity;
+    overflow_t overflow;
+};
+
+/// The maximum size of frame prefixes.
+constexpr std::size_t max_prefix = 24;
+
+/// Writes the frame prefix of a message with the given size into the buffer, which must hold at
+/// least `max_prefix` bytes.
+///
+/// \returns the prefix size.
+auto prefix(framing_t framing, std::size_t size, char* buffer) noexcept -> std::size_t;
+
+/// Returns the frame suffix.
+auto suffix(framing_t framing) noexcept -> string_view;
+
+/// Reads the "framing" option of the given config, which is "none" by default.
+///
+/// \throw std::invalid_argument if the framing is unknown.
+auto framing(const config::node_t& config) -> framing_t;
+
+/// Reads the "nonblocking" option of the given config, like `{"capacity": 1048576, "overflow":
+/// "drop"}`, which is none if the option is missing.
+///
+/// \throw std::invalid_argument if the overflow policy is unknown.
+auto nonblocking(const config::node_t& config) -> boost::optional<nonblocking_t>;
+
+}  // namespace socket
+}  // namespace sink
+}  // namespace v1
+}  // namespace blackhole
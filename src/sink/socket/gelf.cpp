@@ -0,0 +1,376 @@
+#include <zlib.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <boost/optional/optional.hpp>
+#include <boost/variant/apply_visitor.hpp>
+
+#include "blackhole/attribute.hpp"
+#include "blackhole/attributes.hpp"
+#include "blackhole/config/node.hpp"
+#include "blackhole/config/option.hpp"
+#include "blackhole/extensions/writer.hpp"
+#include "blackhole/metrics.hpp"
+#include "blackhole/record.hpp"
+#include "blackhole/sink/socket/gelf.hpp"
+#include "blackhole/stdext/string_view.hpp"
+
+#include "blackhole/detail/attribute.hpp"
+#include "blackhole/detail/formatter/json/escape.hpp"
+#include "blackhole/detail/memory.hpp"
+#include "blackhole/detail/process.hpp"
+#include "blackhole/detail/util/optional.hpp"
+
+#include "gelf.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+namespace socket {
+namespace {
+
+namespace json = detail::formatter::json;
+
+/// Size of the chunk header: magic bytes, message id, sequence number and count.
+constexpr std::size_t header = 12;
+
+/// The maximum number of chunks of a message, Graylog discards messages with more.
+constexpr std::size_t max_chunks = 128;
+
+/// Level of severities without mapping, which is syslog error.
+constexpr int default_level = 3;
+
+auto quote(const string_view& value, writer_t& writer) -> void {
+    writer.inner << '"';
+    json::escape(value, writer);
+    writer.inner << '"';
+}
+
+/// Writes additional field values, numbers as they are and everything else as strings.
+class visitor_t : public boost::static_visitor<> {
+    writer_t& writer;
+
+public:
+    explicit visitor_t(writer_t& writer) noexcept :
+        writer(writer)
+    {}
+
+    auto operator()(std::nullptr_t) const -> void {
+        writer.inner << "\"null\"";
+    }
+
+    auto operator()(bool value) const -> void {
+        writer.inner << (value ? "\"true\"" : "\"false\"");
+    }
+
+    auto operator()(std::int64_t value) const -> void {
+        writer.inner << value;
+    }
+
+    auto operator()(std::uint64_t value) const -> void {
+        writer.inner << value;
+    }
+
+    auto operator()(double value) const -> void {
+        writer.inner << value;
+    }
+
+    auto operator()(const string_view& value) const -> void {
+        quote(value, writer);
+    }
+
+    auto operator()(const attribute::view_t::function_type& value) const -> void {
+        writer_t formatted;
+        value(formatted);
+        quote({formatted.inner.data(), formatted.inner.size()}, writer);
+    }
+};
+
+/// Writes the additional field name converted from the attribute name, returning false if the name
+/// is unusable.
+auto name(const string_view& value, writer_t& writer) -> bool {
+    // The "_id" field is reserved by Graylog.
+    if (value.size() == 0 || value == string_view("id", 2)) {
+        return false;
+    }
+
+    writer.inner << ",\"_";
+
+    for (std::size_t id = 0; id < value.size(); ++id) {
+        const auto ch = value[id];
+        const auto valid = (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') ||
+            (ch >= '0' && ch <= '9') || ch == '_' || ch == '.' || ch == '-';
+        writer.inner << (valid ? ch : '_');
+    }
+
+    writer.inner << "\":";
+    return true;
+}
+
+auto deflate(const char* data, std::size_t size, int level, bool gzip, std::string& output) ->
+    void
+{
+    z_stream stream;
+    std::memset(&stream, 0, sizeof(stream));
+
+    // Window bits above 15 select the gzip wrapper instead of the zlib one.
+    if (::deflateInit2(&stream, level, Z_DEFLATED, gzip ? 15 + 16 : 15, 8, Z_DEFAULT_STRATEGY) !=
+        Z_OK)
+    {
+        throw std::runtime_error("failed to initialize deflate stream");
+    }
+
+    const auto offset = output.size();
+    output.resize(offset + ::deflateBound(&stream, static_cast<uLong>(size)));
+
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+    stream.avail_in = static_cast<uInt>(size);
+    stream.next_out = reinterpret_cast<Bytef*>(&output[offset]);
+    stream.avail_out = static_cast<uInt>(output.size() - offset);
+
+    const auto rc = ::deflate(&stream, Z_FINISH);
+    ::deflateEnd(&stream);
+
+    if (rc != Z_STREAM_END) {
+        throw std::runtime_error("failed to deflate message");
+    }
+
+    output.resize(output.size() - stream.avail_out);
+}
+
+}  // namespace
+
+gelf_t::options_t::options_t() :
+    source(detail::this_process::host().to_string()),
+    encoding(encoding_t::zlib),
+    level(Z_DEFAULT_COMPRESSION),
+    chunk(1420)
+{}
+
+gelf_t::gelf_t(const std::string& host, std::uint16_t port, options_t options) :
+    options([&] {
+        if (options.chunk <= header) {
+            throw std::invalid_argument("GELF chunk size must exceed the chunk header size");
+        }
+
+        if (options.level != Z_DEFAULT_COMPRESSION && (options.level < 1 || options.level > 9)) {
+            throw std::invalid_argument("GELF compression level must be in range [1; 9]");
+        }
+
+        // Packing would concatenate messages into a single invalid datagram.
+        options.udp.mtu = 0;
+        return std::move(options);
+    }()),
+    udp(host, port, this->options.udp),
+    seed(std::random_device()()),
+    counter(0),
+    dropped_(0)
+{
+    seed = (seed << 32) ^ std::random_device()();
+}
+
+auto gelf_t::chunk() const noexcept -> std::size_t {
+    return options.chunk;
+}
+
+auto gelf_t::encoding() const noexcept -> encoding_t {
+    return options.encoding;
+}
+
+auto gelf_t::dropped() const noexcept -> std::uint64_t {
+    return dropped_.load();
+}
+
+auto gelf_t::encode(const record_t& record, const string_view& message, std::string& output) const
+    -> void
+{
+    const auto severity = static_cast<std::size_t>(record.severity());
+    const auto level = severity < options.levels.size() ? options.levels[severity] : default_level;
+
+    const auto timestamp = std::chrono::duration_cast<std::chrono::microseconds>(
+        record.timestamp().time_since_epoch()).count();
+
+    writer_t writer;
+    writer.inner << R"({"version":"1.1","host":)";
+    quote(options.source, writer);
+    writer.inner << R"(,"short_message":)";
+    quote(message, writer);
+    writer.inner.write(R"(,"timestamp":{}.{:06},"level":{})", timestamp / 1000000,
+        timestamp % 1000000, level);
+
+    for (const auto& attribute : record.unique_attributes()) {
+        if (name(attribute.first, writer)) {
+            boost::apply_visitor(visitor_t(writer), attribute.second.inner().value);
+        }
+    }
+
+    writer.inner << '}';
+
+    if (options.encoding == encoding_t::none) {
+        output.append(writer.inner.data(), writer.inner.size());
+    } else {
+        deflate(writer.inner.data(), writer.inner.size(), options.level,
+            options.encoding == encoding_t::gzip, output);
+    }
+}
+
+auto gelf_t::emit(const record_t& record, const string_view& message) -> void {
+    const event_t event{&record, &message};
+    emit_batch(&event, 1);
+}
+
+auto gelf_t::emit_batch(const event_t* events, std::size_t size) -> void {
+    const auto payload = options.chunk - header;
+
+    // Chunked messages are laid out as consecutive datagrams of the chunk size, so each datagram
+    // is a slice of the buffer.
+    std::vector<std::string> buffers;
+    std::vector<const record_t*> records;
+    buffers.reserve(size);
+    records.reserve(size);
+
+    std::string encoded;
+
+    for (std::size_t id = 0; id < size; ++id) {
+        encoded.clear();
+        encode(*events[id].record, *events[id].message, encoded);
+
+        if (encoded.size() <= options.chunk) {
+            buffers.push_back(encoded);
+            records.push_back(events[id].record);
+            continue;
+        }
+
+        const auto count = (encoded.size() + payload - 1) / payload;
+        if (count > max_chunks) {
+            ++dropped_;
+            continue;
+        }
+
+        const auto message = seed + counter++;
+
+        std::string chunked;
+        chunked.reserve(encoded.size() + count * header);
+
+        for (std::size_t seq = 0; seq < count; ++seq) {
+            chunked.push_back('\x1e');
+            chunked.push_back('\x0f');
+            for (int shift = 56; shift >= 0; shift -= 8) {
+                chunked.push_back(static_cast<char>((message >> shift) & 0xff));
+            }
+            chunked.push_back(static_cast<char>(seq));
+            chunked.push_back(static_cast<char>(count));
+            chunked.append(encoded, seq * payload, payload);
+        }
+
+        buffers.push_back(std::move(chunked));
+        records.push_back(events[id].record);
+    }
+
+    // Views are built only now, when buffers no longer move.
+    std::vector<string_view> datagrams;
+    std::vector<event_t> batch;
+
+    for (std::size_t id = 0; id < buffers.size(); ++id) {
+        const auto& buffer = buffers[id];
+
+        for (std::size_t offset = 0; offset < buffer.size(); offset += options.chunk) {
+            datagrams.emplace_back(buffer.data() + offset,
+                std::min(options.chunk, buffer.size() - offset));
+        }
+
+        // The number of chunks is known only after the loop.
+        while (batch.size() < datagrams.size()) {
+            batch.push_back({records[id], nullptr});
+        }
+    }
+
+    for (std::size_t id = 0; id < batch.size(); ++id) {
+        batch[id].message = &datagrams[id];
+    }
+
+    if (!batch.empty()) {
+        udp.emit_batch(batch.data(), batch.size());
+    }
+}
+
+auto gelf_t::collect(metrics::collector_t& collector) const -> void {
+    collector.counter("blackhole_gelf_dropped_total", dropped());
+}
+
+}  // namespace socket
+}  // namespace sink
+
+using sink::socket::gelf_t;
+
+using detail::util::value_or;
+
+auto factory<gelf_t>::type() const noexcept -> const char* {
+    return "gelf";
+}
+
+auto factory<gelf_t>::from(const config::node_t& config) const -> std::unique_ptr<sink_t> {
+    (void)registry;
+    const auto host = value_or(config["host"].to_string(), []() -> std::string {
+        throw std::invalid_argument(R"(parameter "host" is required)");
+    });
+
+    const auto port = value_or(config["port"].to_uint64(), []() -> std::uint64_t {
+        throw std::invalid_argument(R"(parameter "port" is required)");
+    });
+
+    gelf_t::options_t options;
+
+    if (auto source = config["source"].to_string()) {
+        options.source = source.get();
+    }
+
+    if (auto compression = config["compression"].to_string()) {
+        const auto& value = compression.get();
+
+        if (value == "none") {
+            options.encoding = gelf_t::encoding_t::none;
+        } else if (value == "zlib") {
+            options.encoding = gelf_t::encoding_t::zlib;
+        } else if (value == "gzip") {
+            options.encoding = gelf_t::encoding_t::gzip;
+        } else {
+            throw std::invalid_argument(R"(parameter "compression" must be one of "none", )"
+                R"("zlib" or "gzip")");
+        }
+    }
+
+    if (auto level = config["level"].to_sint64()) {
+        options.level = static_cast<int>(level.get());
+    }
+
+    if (auto chunk = config["chunk"].to_uint64()) {
+        options.chunk = static_cast<std::size_t>(chunk.get());
+    }
+
+    if (auto mapping = config["levels"]) {
+        mapping.each([&](const config::node_t& config) {
+            options.levels.emplace_back(config.to_sint64());
+        });
+    }
+
+    if (auto connect = config["connect"].to_bool()) {
+        options.udp.connect = connect.get();
+    }
+
+    if (auto resolve = config["resolve"].to_uint64()) {
+        options.udp.resolve = std::chrono::seconds(resolve.get());
+    }
+
+    return blackhole::make_unique<gelf_t>(host, static_cast<std::uint16_t>(port),
+        std::move(options));
+}
+
+}  // namespace v1
+}  // namespace blackhole
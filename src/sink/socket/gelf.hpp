@@ -0,0 +1,86 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "blackhole/sink.hpp"
+
+#include "udp.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+namespace socket {
+
+/// Sends records as GELF messages over UDP.
+///
+/// Each record is mapped to a GELF 1.1 object with the formatted message as "short_message",
+/// the record timestamp, the level mapped from its severity and unique attributes as additional
+/// fields prefixed with an underscore, non-string attribute values other than numbers being sent
+/// as strings. Invalid field name characters are replaced with underscores, while the reserved
+/// "id" attribute is skipped.
+///
+/// Messages larger than the chunk size are split into GELF chunks sharing a unique message id,
+/// which are sent with the rest of the batch by the wrapped UDP sink, using `sendmmsg` on linux.
+class gelf_t : public sink_t {
+public:
+    enum class encoding_t {
+        none,
+        zlib,
+        gzip
+    };
+
+    struct options_t {
+        /// Value of the "host" field, which is the host name by default.
+        std::string source;
+        encoding_t encoding;
+        /// Compression level from 1 to 9.
+        int level;
+        /// The maximum datagram size, including the chunk header.
+        std::size_t chunk;
+        /// GELF levels, i.e. syslog severities, by record severity. Unmapped severities are sent
+        /// with level 3, which is error.
+        std::vector<int> levels;
+        /// Options of the wrapped UDP sink, whose packing is always disabled.
+        udp_t::options_t udp;
+
+        options_t();
+    };
+
+private:
+    options_t options;
+    udp_t udp;
+
+    std::uint64_t seed;
+    std::atomic<std::uint64_t> counter;
+    std::atomic<std::uint64_t> dropped_;
+
+public:
+    /// \throw std::invalid_argument if the chunk size can not hold the chunk header with at least
+    ///     a byte of data or if the compression level is out of range.
+    gelf_t(const std::string& host, std::uint16_t port, options_t options = options_t());
+
+    auto chunk() const noexcept -> std::size_t;
+    auto encoding() const noexcept -> encoding_t;
+
+    /// Returns the number of messages dropped because they require more than 128 chunks.
+    auto dropped() const noexcept -> std::uint64_t;
+
+    auto emit(const record_t& record, const string_view& message) -> void override;
+
+    /// Encodes and chunks the whole batch, sending all datagrams at once.
+    auto emit_batch(const event_t* events, std::size_t size) -> void override;
+
+    auto collect(metrics::collector_t& collector) const -> void override;
+
+    /// Appends the GELF message of the given record to the output, compressing it if configured.
+    auto encode(const record_t& record, const string_view& message, std::string& output) const ->
+        void;
+};
+
+}  // namespace socket
+}  // namespace sink
+}  // namespace v1
+}  // namespace blackhole
@@ -1,5 +1,16 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <fstream>
+#include <iterator>
 #include <mutex>
+#include <stdexcept>
+#include <vector>
 
+#include <boost/asio/connect.hpp>
+#include <boost/asio/deadline_timer.hpp>
 #include <boost/asio/write.hpp>
 #include <boost/lexical_cast.hpp>
 #include <boost/optional/optional.hpp>
@@ -10,9 +21,14 @@
 #include "blackhole/extensions/format.hpp"
 #include "blackhole/sink/socket/tcp.hpp"
 
+#include "blackhole/detail/error.hpp"
 #include "blackhole/detail/memory.hpp"
+#include "blackhole/detail/mutex.hpp"
 #include "blackhole/detail/util/optional.hpp"
 
+#include "../reactor.hpp"
+#include "balanced.hpp"
+#include "compression.hpp"
 #include "tcp.hpp"
 
 namespace blackhole {
@@ -94,13 +110,475 @@ auto reconnect(boost::asio::io_service& io_service, const std::string& host, std
     return socket;
 }
 
+/// Checks that the TLS call over a blocking socket has completed.
+auto expect(tls::want_t want) -> void {
+    if (want != tls::want_t::none) {
+        throw std::runtime_error("TLS call over a blocking socket has not completed");
+    }
+}
+
 }  // namespace
 
-tcp_t::tcp_t(std::string host, std::uint16_t port) :
+class tcp_t::channel_t {
+    typedef nonblocking_t::overflow_t overflow_t;
+
+    const std::string host;
+    const std::uint16_t port;
+    const nonblocking_t options;
+    const framing_t framing;
+    const std::shared_ptr<tls::context_t> tls;
+    const std::chrono::milliseconds linger;
+
+    /// Runs handlers on the shared reactor, declared before I/O objects constructed with it.
+    binding_t io;
+    protocol_type::resolver resolver;
+    socket_type socket;
+    boost::asio::deadline_timer timer;
+    boost::asio::deadline_timer lingering;
+
+    /// Shared with the I/O thread, so it's kept even in single-threaded builds.
+    detail::adaptive_mutex_t mutex;
+    /// Notifies blocked producers about free space in the buffer.
+    std::condition_variable_any cv;
+    std::string pending;
+    bool connected;
+    bool writing;
+    bool stopped;
+
+    // Accessed by the I/O thread only.
+    std::unique_ptr<tls::session_t> session;
+    std::unique_ptr<compressor_t> compressor;
+    std::string sending;
+    std::string deflated;
+    long backoff;
+
+    std::atomic<std::uint64_t> dropped_;
+
+public:
+    channel_t(std::string host, std::uint16_t port, nonblocking_t options, framing_t framing,
+              std::shared_ptr<tls::context_t> tls, const boost::optional<compression_t>& compression) :
+        host(std::move(host)),
+        port(port),
+        options(options),
+        framing(framing),
+        tls(std::move(tls)),
+        linger(compression ? compression->linger : std::chrono::milliseconds(0)),
+        resolver(io.io_service()),
+        socket(io.io_service()),
+        timer(io.io_service()),
+        lingering(io.io_service()),
+        connected(false),
+        writing(false),
+        stopped(false),
+        backoff(min_backoff),
+        dropped_(0)
+    {
+        if (compression) {
+            compressor.reset(new compressor_t(compression->level, compression->dictionary));
+        }
+
+        io.post([this] {
+            connect();
+        });
+    }
+
+    ~channel_t() {
+        {
+            std::lock_guard<detail::adaptive_mutex_t> lock(mutex);
+            stopped = true;
+        }
+
+        cv.notify_all();
+
+        io.post([this] {
+            shutdown();
+        });
+
+        io.join();
+    }
+
+    auto dropped() const noexcept -> std::uint64_t {
+        return dropped_.load();
+    }
+
+    auto compressed() const noexcept -> bool {
+        return compressor != nullptr;
+    }
+
+    auto online() -> bool {
+        std::lock_guard<detail::adaptive_mutex_t> lock(mutex);
+        return connected;
+    }
+
+    /// Appends framed messages returned by the given function for each index into the send
+    /// buffer, which is written using a single write by the I/O thread.
+    template<typename F>
+    auto push(std::size_t size, F&& message) -> void {
+        const auto tail = suffix(framing);
+        char head[max_prefix];
+
+        std::unique_lock<detail::adaptive_mutex_t> lock(mutex);
+
+        for (std::size_t id = 0; id < size; ++id) {
+            const string_view& data = message(id);
+            const auto nhead = prefix(framing, data.size(), head);
+
+            if (reserve(lock, nhead + data.size() + tail.size())) {
+                pending.append(head, nhead);
+                pending.append(data.data(), data.size());
+                pending.append(tail.data(), tail.size());
+            } else {
+                ++dropped_;
+            }
+        }
+
+        wakeup();
+    }
+
+private:
+    static constexpr long min_backoff = 100;
+    static constexpr long max_backoff = 10000;
+
+    /// Waits for the buffer to have enough free space for the given number of bytes according to
+    /// the overflow policy.
+    ///
+    /// \returns false if the message should be dropped.
+    auto reserve(std::unique_lock<detail::adaptive_mutex_t>& lock, std::size_t size) -> bool {
+        // Messages larger than the whole buffer are accepted into an empty one, otherwise they
+        // would never fit.
+        const auto fits = [&] {
+            return pending.empty() || pending.size() + size <= options.capacity;
+        };
+
+        if (fits()) {
+            return true;
+        }
+
+        if (options.overflow == overflow_t::drop) {
+            return false;
+        }
+
+        wakeup();
+        cv.wait(lock, [&] {
+            return stopped || fits();
+        });
+
+        return !stopped;
+    }
+
+    /// Schedules writing unless already in progress. Must be called with the mutex held.
+    auto wakeup() -> void {
+        if (connected && !writing && !pending.empty()) {
+            writing = true;
+            io.post([this] {
+                linger.count() > 0 ? delay() : flush();
+            });
+        }
+    }
+
+    /// Flushes after the linger delay, gathering messages arriving meanwhile into the same batch.
+    auto delay() -> void {
+        lingering.expires_from_now(boost::posix_time::milliseconds(linger.count()));
+
+        // Cancelling on shutdown flushes immediately.
+        lingering.async_wait(io.wrap([this](const boost::system::error_code&) {
+            flush();
+        }));
+    }
+
+    auto connect() -> void {
+        if (is_stopped()) {
+            return;
+        }
+
+        const protocol_type::resolver::query query(host, boost::lexical_cast<std::string>(port),
+            protocol_type::resolver::query::flags::numeric_service);
+
+        resolver.async_resolve(query, io.wrap([this](const boost::system::error_code& ec,
+                                                     protocol_type::resolver::iterator it)
+        {
+            if (ec) {
+                retry();
+                return;
+            }
+
+            boost::asio::async_connect(socket, it, io.wrap([this](
+                const boost::system::error_code& ec, protocol_type::resolver::iterator)
+            {
+                if (ec) {
+                    retry();
+                    return;
+                }
+
+                if (!tls) {
+                    established();
+                    return;
+                }
+
+                try {
+                    socket.non_blocking(true);
+                    session.reset(new tls::session_t(*tls, socket.native_handle(), host));
+                } catch (const std::exception& err) {
+                    detail::error::report(error::kind_t::sink, err.what());
+                    retry();
+                    return;
+                }
+
+                handshake();
+            }));
+        }));
+    }
+
+    /// Continues the TLS handshake until it completes, waiting for the socket readiness.
+    auto handshake() -> void {
+        tls::want_t want;
+
+        try {
+            want = session->handshake();
+        } catch (const std::exception& err) {
+            detail::error::report(error::kind_t::sink, err.what());
+            retry();
+            return;
+        }
+
+        if (want == tls::want_t::none) {
+            established();
+            return;
+        }
+
+        wait(want, [this] {
+            handshake();
+        });
+    }
+
+    auto established() -> void {
+        backoff = min_backoff;
+
+        if (compressor) {
+            compressor->reset();
+        }
+
+        {
+            std::lock_guard<detail::adaptive_mutex_t> lock(mutex);
+            connected = true;
+            writing = true;
+        }
+
+        flush();
+    }
+
+    /// Calls the given function when the socket becomes ready for the wanted operation, retrying
+    /// connection on failure.
+    template<typename F>
+    auto wait(tls::want_t want, F fn) -> void {
+        const auto callback = [this, fn](const boost::system::error_code& ec, std::size_t) {
+            if (ec) {
+                failed(false);
+                return;
+            }
+
+            fn();
+        };
+
+        if (want == tls::want_t::read) {
+            socket.async_read_some(boost::asio::null_buffers(), io.wrap(callback));
+        } else {
+            socket.async_write_some(boost::asio::null_buffers(), io.wrap(callback));
+        }
+    }
+
+    /// Schedules reconnection with exponential backoff.
+    auto retry() -> void {
+        session.reset();
+
+        boost::system::error_code ec;
+        socket.close(ec);
+
+        if (is_stopped()) {
+            return;
+        }
+
+        timer.expires_from_now(boost::posix_time::milliseconds(backoff));
+        backoff = std::min(backoff * 2, max_backoff);
+
+        timer.async_wait(io.wrap([this](const boost::system::error_code& ec) {
+            if (!ec) {
+                connect();
+            }
+        }));
+    }
+
+    /// Writes buffered data until the buffer is drained. Must be called with the writing flag set.
+    auto flush() -> void {
+        bool fresh = false;
+
+        {
+            std::lock_guard<detail::adaptive_mutex_t> lock(mutex);
+
+            if (!connected) {
+                writing = false;
+                return;
+            }
+
+            if (sending.empty()) {
+                if (pending.empty()) {
+                    writing = false;
+
+                    if (stopped) {
+                        close();
+                    }
+
+                    return;
+                }
+
+                sending.swap(pending);
+                fresh = true;
+            }
+        }
+
+        cv.notify_all();
+
+        // Each batch is compressed into a separately decodable block.
+        if (compressor && fresh) {
+            deflated.clear();
+            compressor->compress(sending.data(), sending.size(), true, deflated);
+            sending.swap(deflated);
+        }
+
+        // The kernel encrypts data written into the socket itself with kTLS.
+        if (session && !session->ktls()) {
+            transfer(0);
+            return;
+        }
+
+        boost::asio::async_write(socket, boost::asio::buffer(sending), io.wrap([this](
+            const boost::system::error_code& ec, std::size_t nwritten)
+        {
+            if (ec) {
+                failed(nwritten > 0);
+                return;
+            }
+
+            sending.clear();
+            flush();
+        }));
+    }
+
+    /// Writes the data being sent through the TLS session starting from the given offset.
+    auto transfer(std::size_t offset) -> void {
+        while (offset < sending.size()) {
+            std::size_t nwritten;
+            tls::want_t want;
+
+            try {
+                want = session->write(sending.data() + offset, sending.size() - offset, nwritten);
+            } catch (const std::exception& err) {
+                detail::error::report(error::kind_t::sink, err.what());
+                failed(offset > 0);
+                return;
+            }
+
+            offset += nwritten;
+
+            if (want != tls::want_t::none) {
+                wait(want, [this, offset] {
+                    transfer(offset);
+                });
+                return;
+            }
+        }
+
+        sending.clear();
+        flush();
+    }
+
+    /// Drops the connection after a write failure and schedules reconnection.
+    auto failed(bool partial) -> void {
+        // Partially sent data can not be resent into the new connection without breaking the
+        // message boundaries, neither can be compressed data, which depends on the stream state.
+        if (partial || compressor) {
+            sending.clear();
+        }
+
+        {
+            std::lock_guard<detail::adaptive_mutex_t> lock(mutex);
+            connected = false;
+            writing = false;
+        }
+
+        retry();
+    }
+
+    auto shutdown() -> void {
+        boost::system::error_code ec;
+        timer.cancel(ec);
+        lingering.cancel(ec);
+        resolver.cancel();
+
+        bool busy;
+        {
+            std::lock_guard<detail::adaptive_mutex_t> lock(mutex);
+            busy = connected && writing;
+        }
+
+        if (!busy) {
+            close();
+            return;
+        }
+
+        // Gives pending writes some time to complete.
+        timer.expires_from_now(boost::posix_time::seconds(1));
+        timer.async_wait(io.wrap([this](const boost::system::error_code& ec) {
+            if (!ec) {
+                close();
+            }
+        }));
+    }
+
+    auto close() -> void {
+        if (session) {
+            session->shutdown();
+            session.reset();
+        }
+
+        boost::system::error_code ec;
+        timer.cancel(ec);
+        lingering.cancel(ec);
+        socket.close(ec);
+    }
+
+    auto is_stopped() -> bool {
+        std::lock_guard<detail::adaptive_mutex_t> lock(mutex);
+        return stopped;
+    }
+};
+
+constexpr long tcp_t::channel_t::min_backoff;
+constexpr long tcp_t::channel_t::max_backoff;
+
+tcp_t::tcp_t(std::string host, std::uint16_t port, framing_t framing,
+             std::shared_ptr<tls::context_t> tls, boost::optional<compression_t> compression) :
+    host_(std::move(host)),
+    port_(port),
+    framing_(framing),
+    tls(std::move(tls))
+{
+    if (compression) {
+        compressor.reset(new compressor_t(compression->level, compression->dictionary));
+    }
+}
+
+tcp_t::tcp_t(std::string host, std::uint16_t port, nonblocking_t options, framing_t framing,
+             std::shared_ptr<tls::context_t> tls, boost::optional<compression_t> compression) :
     host_(std::move(host)),
-    port_(port)
+    port_(port),
+    framing_(framing),
+    tls(std::move(tls)),
+    channel(new channel_t(host_, port_, options, framing, this->tls, compression))
 {}
 
+tcp_t::~tcp_t() = default;
+
 auto tcp_t::host() const noexcept -> const std::string& {
     return host_;
 }
@@ -109,18 +587,138 @@ auto tcp_t::port() const noexcept -> std::uint16_t {
     return port_;
 }
 
+auto tcp_t::framing() const noexcept -> framing_t {
+    return framing_;
+}
+
+auto tcp_t::secure() const noexcept -> bool {
+    return tls != nullptr;
+}
+
+auto tcp_t::compressed() const noexcept -> bool {
+    return compressor != nullptr || (channel && channel->compressed());
+}
+
+auto tcp_t::dropped() const noexcept -> std::uint64_t {
+    return channel ? channel->dropped() : 0;
+}
+
+auto tcp_t::available() const -> bool {
+    return channel == nullptr || channel->online();
+}
+
 auto tcp_t::emit(const record_t&, const string_view& message) -> void {
-    std::lock_guard<std::mutex> lock(mutex);
+    if (channel) {
+        channel->push(1, [&](std::size_t) -> const string_view& {
+            return message;
+        });
+        return;
+    }
+
+    char head[max_prefix];
+    const auto tail = suffix(framing_);
 
-    if (!socket) {
-        socket = reconnect(io_service, host(), port());
+    const std::array<boost::asio::const_buffer, 3> buffers{{
+        {head, prefix(framing_, message.size(), head)},
+        {message.data(), message.size()},
+        {tail.data(), tail.size()}
+    }};
+
+    std::lock_guard<detail::mutex_t> lock(mutex);
+    write(buffers);
+}
+
+auto tcp_t::emit_batch(const event_t* events, std::size_t size) -> void {
+    if (channel) {
+        channel->push(size, [&](std::size_t id) -> const string_view& {
+            return *events[id].message;
+        });
+        return;
+    }
+
+    const auto tail = suffix(framing_);
+
+    std::vector<std::array<char, max_prefix>> heads(framing_ == framing_t::length ||
+        framing_ == framing_t::octet ? size : 0);
+
+    std::vector<boost::asio::const_buffer> buffers;
+    buffers.reserve(3 * size);
+
+    for (std::size_t id = 0; id < size; ++id) {
+        const auto& message = *events[id].message;
+
+        if (!heads.empty()) {
+            buffers.emplace_back(heads[id].data(), prefix(framing_, message.size(), heads[id].data()));
+        }
+
+        buffers.emplace_back(message.data(), message.size());
+
+        if (tail.size() > 0) {
+            buffers.emplace_back(tail.data(), tail.size());
+        }
     }
 
+    std::lock_guard<detail::mutex_t> lock(mutex);
+    write(buffers);
+}
+
+template<typename Buffers>
+auto tcp_t::write(const Buffers& buffers) -> void {
     try {
-        boost::asio::write(*socket, boost::asio::buffer(message.data(), message.size()));
-    } catch (const boost::system::system_error&) {
+        if (!socket) {
+            socket = reconnect(io_service, host(), port());
+
+            if (tls) {
+                session.reset(new tls::session_t(*tls, socket->native_handle(), host()));
+                expect(session->handshake());
+            }
+
+            if (compressor) {
+                compressor->reset();
+            }
+        }
+
+        if (compressor) {
+            // Each call is compressed into a separately decodable block.
+            deflated.clear();
+            for (const auto& buffer : buffers) {
+                compressor->compress(boost::asio::buffer_cast<const char*>(buffer),
+                    boost::asio::buffer_size(buffer), false, deflated);
+            }
+
+            compressor->compress(nullptr, 0, true, deflated);
+            send(std::array<boost::asio::const_buffer, 1>{{
+                boost::asio::buffer(deflated)
+            }});
+        } else {
+            send(buffers);
+        }
+    } catch (...) {
+        session.reset();
         socket.reset();
-        std::rethrow_exception(std::current_exception());
+        throw;
+    }
+}
+
+template<typename Buffers>
+auto tcp_t::send(const Buffers& buffers) -> void {
+    if (session && !session->ktls()) {
+        // Coalescing avoids producing a TLS record for each frame part.
+        scratch.clear();
+        for (const auto& buffer : buffers) {
+            scratch.append(boost::asio::buffer_cast<const char*>(buffer),
+                boost::asio::buffer_size(buffer));
+        }
+
+        for (std::size_t offset = 0; offset < scratch.size();) {
+            std::size_t nwritten;
+            expect(session->write(scratch.data() + offset, scratch.size() - offset, nwritten));
+            offset += nwritten;
+        }
+    } else {
+        // Gathered write results in a single `writev` call unless the kernel accepts the data
+        // partially.
+        boost::asio::write(*socket, buffers);
     }
 }
 
@@ -137,15 +735,141 @@ auto factory<tcp_t>::type() const noexcept -> const char* {
 
 auto factory<tcp_t>::from(const config::node_t& config) const -> std::unique_ptr<sink_t> {
     (void)registry;
-    const auto host = value_or(config["host"].to_string(), []() -> std::string {
-        throw std::invalid_argument(R"(parameter "host" is required)");
-    });
 
-    const auto port = value_or(config["port"].to_uint64(), []() -> std::uint64_t {
-        throw std::invalid_argument(R"(parameter "port" is required)");
+    // Multiple endpoints, like `[{"host": "collector-1", "port": 5000}, ...]`, replace the single
+    // host and port.
+    std::vector<sink::socket::endpoint_t> endpoints;
+
+    config["endpoints"].each([&](const config::node_t& endpoint) {
+        const auto host = value_or(endpoint["host"].to_string(), []() -> std::string {
+            throw std::invalid_argument(R"(each endpoint requires "host" parameter)");
+        });
+
+        const auto port = value_or(endpoint["port"].to_uint64(), []() -> std::uint64_t {
+            throw std::invalid_argument(R"(each endpoint requires "port" parameter)");
+        });
+
+        endpoints.push_back({host, static_cast<std::uint16_t>(port)});
     });
 
-    return blackhole::make_unique<tcp_t>(host, static_cast<std::uint16_t>(port));
+    if (endpoints.empty()) {
+        const auto host = value_or(config["host"].to_string(), []() -> std::string {
+            throw std::invalid_argument(R"(parameter "host" is required)");
+        });
+
+        const auto port = value_or(config["port"].to_uint64(), []() -> std::uint64_t {
+            throw std::invalid_argument(R"(parameter "port" is required)");
+        });
+
+        endpoints.push_back({host, static_cast<std::uint16_t>(port)});
+    }
+
+    const auto framing = sink::socket::framing(config);
+
+    // TLS, like `{"ca": "/etc/ssl/collector.pem", "server_name": "collector"}`.
+    std::shared_ptr<sink::socket::tls::context_t> tls;
+
+    if (auto node = config["tls"]) {
+        sink::socket::tls::options_t options;
+
+        if (auto ca = node["ca"].to_string()) {
+            options.ca = ca.get();
+        }
+
+        if (auto certificate = node["certificate"].to_string()) {
+            options.certificate = certificate.get();
+        }
+
+        if (auto key = node["key"].to_string()) {
+            options.key = key.get();
+        }
+
+        if (auto server_name = node["server_name"].to_string()) {
+            options.server_name = server_name.get();
+        }
+
+        if (auto verify = node["verify"].to_bool()) {
+            options.verify = verify.get();
+        }
+
+        if (auto ktls = node["ktls"].to_bool()) {
+            options.ktls = ktls.get();
+        }
+
+        tls = std::make_shared<sink::socket::tls::context_t>(std::move(options));
+    }
+
+    // Compression, like `{"level": 6, "dictionary": "/etc/blackhole/logs.dict", "linger": 20}`.
+    boost::optional<sink::socket::compression_t> compression;
+
+    if (auto node = config["compression"]) {
+        sink::socket::compression_t options;
+
+        if (auto level = node["level"].to_sint64()) {
+            options.level = static_cast<int>(level.get());
+        }
+
+        if (auto path = node["dictionary"].to_string()) {
+            std::ifstream stream(path.get(), std::ios::binary);
+            if (!stream) {
+                throw std::invalid_argument("failed to read compression dictionary " + path.get());
+            }
+
+            options.dictionary.assign(std::istreambuf_iterator<char>(stream),
+                std::istreambuf_iterator<char>());
+        }
+
+        if (auto linger = node["linger"].to_uint64()) {
+            options.linger = std::chrono::milliseconds(linger.get());
+        }
+
+        compression = options;
+    }
+
+    const auto nonblocking = sink::socket::nonblocking(config);
+
+    const auto make = [&](const std::string& host, std::uint16_t port) -> std::unique_ptr<tcp_t> {
+        if (nonblocking) {
+            return blackhole::make_unique<tcp_t>(host, port, nonblocking.get(), framing, tls,
+                compression);
+        }
+
+        return blackhole::make_unique<tcp_t>(host, port, framing, tls, compression);
+    };
+
+    if (endpoints.size() == 1 && !config["balancing"]) {
+        return make(endpoints.front().host, endpoints.front().port);
+    }
+
+    // Balancing, like `{"strategy": "hash", "attribute": "tenant", "connections": 4}`.
+    sink::socket::balancing_t balancing;
+
+    if (auto strategy = config["balancing"]["strategy"].to_string()) {
+        if (strategy.get() == "round-robin") {
+            balancing.strategy = sink::socket::balancing_t::strategy_t::round_robin;
+        } else if (strategy.get() == "hash") {
+            balancing.strategy = sink::socket::balancing_t::strategy_t::hash;
+        } else {
+            throw std::invalid_argument("unknown balancing strategy " + strategy.get());
+        }
+    }
+
+    if (auto attribute = config["balancing"]["attribute"].to_string()) {
+        balancing.attribute = attribute.get();
+    }
+
+    if (auto connections = config["balancing"]["connections"].to_uint64()) {
+        balancing.connections = static_cast<std::size_t>(connections.get());
+    }
+
+    if (auto interval = config["balancing"]["interval"].to_uint64()) {
+        balancing.interval = std::chrono::milliseconds(interval.get());
+    }
+
+    return blackhole::make_unique<sink::socket::balanced_t>(std::move(endpoints),
+        std::move(balancing), [&](const sink::socket::endpoint_t& endpoint) {
+            return make(endpoint.host, endpoint.port);
+        });
 }
 
 }  // namespace v1
@@ -3,9 +3,16 @@
 #include <mutex>
 
 #include <boost/asio/ip/tcp.hpp>
+#include <boost/optional/optional.hpp>
 
 #include "blackhole/sink.hpp"
 
+#include "blackhole/detail/mutex.hpp"
+
+#include "compression.hpp"
+#include "framing.hpp"
+#include "tls.hpp"
+
 namespace blackhole {
 inline namespace v1 {
 namespace sink {
@@ -14,19 +21,95 @@ namespace socket {
 class tcp_t : public sink_t {
     std::string host_;
     std::uint16_t port_;
+    framing_t framing_;
+
+    /// Shared with the I/O thread in non-blocking mode, null if TLS is disabled.
+    std::shared_ptr<tls::context_t> tls;
 
     boost::asio::io_service io_service;
     std::unique_ptr<boost::asio::ip::tcp::socket> socket;
+    std::unique_ptr<tls::session_t> session;
+    /// Coalesced messages for writing through the TLS session, when the kernel does not encrypt.
+    std::string scratch;
+    std::unique_ptr<compressor_t> compressor;
+    std::string deflated;
+
+    mutable detail::mutex_t mutex;
 
-    mutable std::mutex mutex;
+    /// Send buffer written from the shared reactor in non-blocking mode, defined in the translation
+    /// unit.
+    class channel_t;
+    std::unique_ptr<channel_t> channel;
 
 public:
-    tcp_t(std::string host, std::uint16_t port);
+    /// Constructs a TCP sink, optionally encrypting the connection using the given TLS context.
+    ///
+    /// With TLS the handshake is performed right after connecting. If the kernel supports kTLS,
+    /// negotiated keys are handed over to it, so messages are written with the same gathered
+    /// writes as without TLS, otherwise they are coalesced and encrypted in user space.
+    ///
+    /// With compression the connection carries a zlib stream, each emitted message or batch
+    /// compressed into a block completed by a sync flush, which the receiver can decompress
+    /// incrementally.
+    tcp_t(std::string host,
+          std::uint16_t port,
+          framing_t framing = framing_t::none,
+          std::shared_ptr<tls::context_t> tls = nullptr,
+          boost::optional<compression_t> compression = boost::none);
+
+    /// Constructs a TCP sink, which never performs network I/O on emitting threads.
+    ///
+    /// Messages are appended to a bounded send buffer, which is written using asynchronous writes
+    /// from the I/O thread of the reactor shared by all network sinks. Both resolving and
+    /// connecting happen there too, reconnecting with exponential backoff from 100 ms up to 10 s
+    /// after failures. Data buffered while disconnected is sent after reconnection.
+    ///
+    /// With compression each write is compressed on the I/O thread as a single block, optionally
+    /// after lingering for more messages.
+    tcp_t(std::string host,
+          std::uint16_t port,
+          nonblocking_t options,
+          framing_t framing = framing_t::none,
+          std::shared_ptr<tls::context_t> tls = nullptr,
+          boost::optional<compression_t> compression = boost::none);
+
+    /// Waits for buffered data to be sent if connected, for at most a second, then waits for its
+    /// handlers on the reactor to complete.
+    ~tcp_t();
 
     auto host() const noexcept -> const std::string&;
     auto port() const noexcept -> std::uint16_t;
+    auto framing() const noexcept -> framing_t;
+
+    /// Returns whether the connection is encrypted using TLS.
+    auto secure() const noexcept -> bool;
+
+    /// Returns whether the connection carries a compressed stream.
+    auto compressed() const noexcept -> bool;
+
+    /// Returns the number of messages dropped because of the send buffer overflow.
+    auto dropped() const noexcept -> std::uint64_t;
+
+    /// Returns whether emitted messages are sent right away, which is always the case in blocking
+    /// mode, where failures are reported by throwing, and only while connected in non-blocking
+    /// mode.
+    auto available() const -> bool;
 
     auto emit(const record_t& record, const string_view& message) -> void override;
+
+    /// Writes the whole batch with frames using a single gathered write.
+    auto emit_batch(const event_t* events, std::size_t size) -> void override;
+
+private:
+    /// Connects unless connected, then writes the given buffers and disconnects on failure.
+    ///
+    /// \warning must be called under the lock.
+    template<typename Buffers>
+    auto write(const Buffers& buffers) -> void;
+
+    /// Writes the given buffers either through the TLS session or directly.
+    template<typename Buffers>
+    auto send(const Buffers& buffers) -> void;
 };
 
 }  // namespace socket
@@ -0,0 +1,218 @@
+#include "tls.hpp"
+
+#include <stdexcept>
+
+#ifdef BLACKHOLE_HAS_TLS
+#   include <arpa/inet.h>
+#   include <openssl/err.h>
+#   include <openssl/ssl.h>
+#   include <openssl/x509v3.h>
+#endif
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+namespace socket {
+namespace tls {
+
+#ifdef BLACKHOLE_HAS_TLS
+
+namespace {
+
+/// Returns the description of the oldest error from the thread's queue, clearing it.
+auto describe() -> std::string {
+    const auto code = ::ERR_get_error();
+    ::ERR_clear_error();
+
+    if (code == 0) {
+        return "unknown error";
+    }
+
+    char buffer[256];
+    ::ERR_error_string_n(code, buffer, sizeof(buffer));
+    return buffer;
+}
+
+/// Translates the result of a TLS call on a non-blocking socket.
+auto translate(::SSL* ssl, int rc, const char* operation) -> want_t {
+    switch (::SSL_get_error(ssl, rc)) {
+    case SSL_ERROR_WANT_READ:
+        return want_t::read;
+    case SSL_ERROR_WANT_WRITE:
+        return want_t::write;
+    case SSL_ERROR_SYSCALL:
+        ::ERR_clear_error();
+        throw std::runtime_error(std::string("TLS ") + operation + " failed: connection error");
+    default:
+        throw std::runtime_error(std::string("TLS ") + operation + " failed: " + describe());
+    }
+}
+
+auto is_ip(const std::string& name) -> bool {
+    unsigned char address[16];
+    return ::inet_pton(AF_INET, name.c_str(), address) == 1 ||
+        ::inet_pton(AF_INET6, name.c_str(), address) == 1;
+}
+
+}  // namespace
+
+context_t::context_t(options_t options) :
+    options_(std::move(options)),
+    handle(::SSL_CTX_new(::TLS_client_method()), &::SSL_CTX_free)
+{
+    if (handle == nullptr) {
+        throw std::invalid_argument("failed to create TLS context: " + describe());
+    }
+
+    const auto ctx = handle.get();
+
+    ::SSL_CTX_set_min_proto_version(ctx, TLS1_2_VERSION);
+    // Partial writes allow resuming from the next byte, like with plain non-blocking sockets.
+    ::SSL_CTX_set_mode(ctx, SSL_MODE_ENABLE_PARTIAL_WRITE | SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
+
+#ifdef SSL_OP_ENABLE_KTLS
+    if (options_.ktls) {
+        ::SSL_CTX_set_options(ctx, SSL_OP_ENABLE_KTLS);
+    }
+#endif
+
+    if (options_.verify) {
+        ::SSL_CTX_set_verify(ctx, SSL_VERIFY_PEER, nullptr);
+
+        const auto loaded = options_.ca.empty() ?
+            ::SSL_CTX_set_default_verify_paths(ctx) :
+            ::SSL_CTX_load_verify_locations(ctx, options_.ca.c_str(), nullptr);
+
+        if (loaded != 1) {
+            throw std::invalid_argument("failed to load TLS CA certificates: " + describe());
+        }
+    }
+
+    if (!options_.certificate.empty()) {
+        if (::SSL_CTX_use_certificate_chain_file(ctx, options_.certificate.c_str()) != 1) {
+            throw std::invalid_argument("failed to load TLS certificate " + options_.certificate +
+                ": " + describe());
+        }
+
+        const auto& key = options_.key.empty() ? options_.certificate : options_.key;
+        if (::SSL_CTX_use_PrivateKey_file(ctx, key.c_str(), SSL_FILETYPE_PEM) != 1) {
+            throw std::invalid_argument("failed to load TLS private key " + key + ": " +
+                describe());
+        }
+    }
+}
+
+auto context_t::options() const noexcept -> const options_t& {
+    return options_;
+}
+
+auto context_t::native() const noexcept -> ssl_ctx_st* {
+    return handle.get();
+}
+
+session_t::session_t(const context_t& context, int fd, const std::string& host) :
+    ssl(::SSL_new(context.native()), &::SSL_free)
+{
+    if (ssl == nullptr || ::SSL_set_fd(ssl.get(), fd) != 1) {
+        throw std::runtime_error("failed to create TLS session: " + describe());
+    }
+
+    const auto& name = context.options().server_name.empty() ?
+        host : context.options().server_name;
+
+    // Servers are identified by IP addresses without SNI, which does not allow them.
+    if (is_ip(name)) {
+        if (context.options().verify) {
+            ::X509_VERIFY_PARAM_set1_ip_asc(::SSL_get0_param(ssl.get()), name.c_str());
+        }
+    } else {
+        ::SSL_set_tlsext_host_name(ssl.get(), name.c_str());
+
+        if (context.options().verify) {
+            ::SSL_set1_host(ssl.get(), name.c_str());
+        }
+    }
+
+    ::SSL_set_connect_state(ssl.get());
+}
+
+auto session_t::ktls() const -> bool {
+    return BIO_get_ktls_send(::SSL_get_wbio(ssl.get()));
+}
+
+auto session_t::handshake() -> want_t {
+    const auto rc = ::SSL_do_handshake(ssl.get());
+    if (rc == 1) {
+        return want_t::none;
+    }
+
+    return translate(ssl.get(), rc, "handshake");
+}
+
+auto session_t::write(const char* data, std::size_t size, std::size_t& nwritten) -> want_t {
+    nwritten = 0;
+
+    if (size == 0) {
+        return want_t::none;
+    }
+
+    const auto rc = ::SSL_write_ex(ssl.get(), data, size, &nwritten);
+    if (rc == 1) {
+        return want_t::none;
+    }
+
+    return translate(ssl.get(), rc, "write");
+}
+
+auto session_t::shutdown() noexcept -> void {
+    ::SSL_shutdown(ssl.get());
+    ::ERR_clear_error();
+}
+
+#else
+
+context_t::context_t(options_t options) :
+    options_(std::move(options)),
+    handle(nullptr, [](ssl_ctx_st*) {})
+{
+    throw std::invalid_argument("TLS requires the library to be built with ENABLE_TLS option");
+}
+
+auto context_t::options() const noexcept -> const options_t& {
+    return options_;
+}
+
+auto context_t::native() const noexcept -> ssl_ctx_st* {
+    return nullptr;
+}
+
+// Sessions can not be created without a context, so the rest is unreachable.
+
+session_t::session_t(const context_t&, int, const std::string&) :
+    ssl(nullptr, [](ssl_st*) {})
+{
+    throw std::logic_error("TLS is not supported");
+}
+
+auto session_t::ktls() const -> bool {
+    return false;
+}
+
+auto session_t::handshake() -> want_t {
+    return want_t::none;
+}
+
+auto session_t::write(const char*, std::size_t, std::size_t& nwritten) -> want_t {
+    nwritten = 0;
+    return want_t::none;
+}
+
+auto session_t::shutdown() noexcept -> void {}
+
+#endif
+
+}  // namespace tls
+}  // namespace socket
+}  // namespace sink
+}  // namespace v1
+}  // namespace blackhole
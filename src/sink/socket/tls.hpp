@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+struct ssl_ctx_st;
+struct ssl_st;
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+namespace socket {
+namespace tls {
+
+/// TLS client options.
+struct options_t {
+    /// Path to the PEM file with trusted CA certificates, the system default ones are used if
+    /// empty.
+    std::string ca;
+    /// Paths to the PEM files with the client certificate chain and its private key, used for
+    /// mutual authentication if not empty.
+    std::string certificate;
+    std::string key;
+    /// Name the server certificate is verified against and sent via SNI, the host if empty.
+    std::string server_name;
+    /// Whether to verify the server certificate.
+    bool verify;
+    /// Whether to hand negotiated keys over to the kernel via kTLS where available, which allows
+    /// writing plain data into the socket with encryption performed by the kernel.
+    bool ktls;
+
+    options_t() :
+        verify(true),
+        ktls(true)
+    {}
+};
+
+/// Operation a non-blocking socket must become ready for, before the TLS call can be repeated.
+enum class want_t {
+    none,
+    read,
+    write
+};
+
+/// TLS client context shared by all connections of a sink.
+class context_t {
+    options_t options_;
+    std::unique_ptr<ssl_ctx_st, void(*)(ssl_ctx_st*)> handle;
+
+public:
+    /// \throw std::invalid_argument if the library has been built without TLS support or if
+    ///     certificates or the private key can not be loaded.
+    explicit context_t(options_t options);
+
+    auto options() const noexcept -> const options_t&;
+    auto native() const noexcept -> ssl_ctx_st*;
+};
+
+/// TLS session over a connected socket, which stays owned by the caller.
+class session_t {
+    std::unique_ptr<ssl_st, void(*)(ssl_st*)> ssl;
+
+public:
+    /// \param host the host connected to, used for verification unless a server name is set.
+    session_t(const context_t& context, int fd, const std::string& host);
+
+    /// Returns whether the kernel encrypts data written into the socket after the handshake,
+    /// which allows bypassing the session for writing.
+    auto ktls() const -> bool;
+
+    /// Performs the handshake, which is complete if nothing is wanted.
+    ///
+    /// \throw std::runtime_error on failure.
+    auto handshake() -> want_t;
+
+    /// Writes the given data partially, storing the number of written bytes.
+    ///
+    /// The call must be repeated with the same remaining data if something is wanted.
+    ///
+    /// \throw std::runtime_error on failure.
+    auto write(const char* data, std::size_t size, std::size_t& nwritten) -> want_t;
+
+    /// Sends the closure alert without waiting for the peer one.
+    auto shutdown() noexcept -> void;
+};
+
+}  // namespace tls
+}  // namespace socket
+}  // namespace sink
+}  // namespace v1
+}  // namespace blackhole
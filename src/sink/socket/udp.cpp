@@ -1,3 +1,15 @@
+#ifdef __linux__
+#   include <sys/socket.h>
+#   include <sys/uio.h>
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <system_error>
+#include <vector>
+
+#include <boost/asio/deadline_timer.hpp>
+#include <boost/container/small_vector.hpp>
 #include <boost/lexical_cast.hpp>
 #include <boost/optional/optional.hpp>
 
@@ -6,9 +18,12 @@
 #include "blackhole/stdext/string_view.hpp"
 #include "blackhole/sink/socket/udp.hpp"
 
+#include "blackhole/detail/error.hpp"
 #include "blackhole/detail/memory.hpp"
+#include "blackhole/detail/rcu.hpp"
 #include "blackhole/detail/util/optional.hpp"
 
+#include "../reactor.hpp"
 #include "udp.hpp"
 
 namespace blackhole {
@@ -16,23 +31,267 @@ inline namespace v1 {
 namespace sink {
 namespace socket {
 
-udp_t::udp_t(const std::string& host, std::uint16_t port) :
-    socket(io_service)
+namespace {
+
+namespace rcu = detail::rcu;
+
+/// The maximum number of datagrams passed to a single `sendmmsg` call.
+constexpr std::size_t max_batch = 64;
+
+auto resolve(boost::asio::io_service& io_service, const std::string& host, std::uint16_t port) ->
+    udp_t::endpoint_type
 {
     boost::asio::ip::udp::resolver resolver(io_service);
     boost::asio::ip::udp::resolver::query query(host, boost::lexical_cast<std::string>(port),
         boost::asio::ip::udp::resolver::query::flags::numeric_service);
-    endpoint_ = *resolver.resolve(query);
 
-    socket.open(endpoint_.protocol());
+    return *resolver.resolve(query);
 }
 
-auto udp_t::endpoint() const -> const endpoint_type& {
-    return endpoint_;
+}  // namespace
+
+/// Periodically resolves the host on the shared reactor, publishing changed endpoints.
+class udp_t::resolver_t {
+    udp_t& sink;
+
+    /// Runs handlers on the shared reactor, declared before I/O objects constructed with it.
+    binding_t io;
+    boost::asio::ip::udp::resolver resolver;
+    boost::asio::deadline_timer timer;
+
+    // Accessed by the reactor thread only.
+    bool stopped;
+
+public:
+    explicit resolver_t(udp_t& sink) :
+        sink(sink),
+        resolver(io.io_service()),
+        timer(io.io_service()),
+        stopped(false)
+    {
+        io.post([this] {
+            schedule();
+        });
+    }
+
+    ~resolver_t() {
+        io.post([this] {
+            stopped = true;
+
+            boost::system::error_code ec;
+            timer.cancel(ec);
+            resolver.cancel();
+        });
+
+        io.join();
+    }
+
+private:
+    auto schedule() -> void {
+        if (stopped) {
+            return;
+        }
+
+        timer.expires_from_now(boost::posix_time::seconds(sink.options.resolve.count()));
+        timer.async_wait(io.wrap([this](const boost::system::error_code& ec) {
+            if (!ec) {
+                resolve();
+            }
+        }));
+    }
+
+    auto resolve() -> void {
+        const boost::asio::ip::udp::resolver::query query(sink.host,
+            boost::lexical_cast<std::string>(sink.port),
+            boost::asio::ip::udp::resolver::query::flags::numeric_service);
+
+        resolver.async_resolve(query, io.wrap([this](const boost::system::error_code& ec,
+                                                     boost::asio::ip::udp::resolver::iterator it)
+        {
+            if (ec == boost::asio::error::operation_aborted) {
+                return;
+            }
+
+            try {
+                if (ec) {
+                    throw boost::system::system_error(ec, "failed to resolve");
+                }
+
+                const endpoint_type endpoint = *it;
+
+                if (!(endpoint == sink.endpoint())) {
+                    sink.update(endpoint);
+                }
+            } catch (const std::exception& err) {
+                detail::error::report(error::kind_t::sink, err.what());
+            }
+
+            schedule();
+        }));
+    }
+};
+
+udp_t::udp_t(const std::string& host, std::uint16_t port, std::size_t mtu) :
+    udp_t(host, port, [&] {
+        options_t options;
+        options.mtu = mtu;
+        return options;
+    }())
+{}
+
+udp_t::udp_t(const std::string& host, std::uint16_t port, const options_t& options) :
+    host(host),
+    port(port),
+    options(options),
+    socket(io_service),
+    endpoint_(new endpoint_type(resolve(io_service, host, port)))
+{
+    const auto& endpoint = *endpoint_.load();
+
+    try {
+        socket.open(endpoint.protocol());
+
+        if (options.connect) {
+            socket.connect(endpoint);
+        }
+    } catch (...) {
+        delete endpoint_.load();
+        throw;
+    }
+
+    if (options.resolve.count() > 0) {
+        resolver.reset(new resolver_t(*this));
+    }
+}
+
+udp_t::~udp_t() {
+    resolver.reset();
+    delete endpoint_.load();
+}
+
+auto udp_t::endpoint() const -> endpoint_type {
+    const rcu::read_lock_t lock;
+    return *endpoint_.load(std::memory_order_acquire);
+}
+
+auto udp_t::mtu() const noexcept -> std::size_t {
+    return options.mtu;
+}
+
+auto udp_t::update(const endpoint_type& endpoint) -> void {
+    // The socket is bound to the address family it was opened with.
+    if (endpoint.protocol() != this->endpoint().protocol()) {
+        throw std::system_error(EAFNOSUPPORT, std::system_category(),
+            "failed to switch to an endpoint of another address family");
+    }
+
+    // Connecting an already connected datagram socket atomically changes its peer, using the
+    // native handle avoids racing with sends on the asio socket object.
+    if (options.connect) {
+        if (::connect(socket.native_handle(), endpoint.data(), endpoint.size()) != 0) {
+            throw std::system_error(errno, std::system_category(), "failed to connect");
+        }
+    }
+
+    const auto previous = endpoint_.exchange(new endpoint_type(endpoint), std::memory_order_acq_rel);
+
+    rcu::synchronize();
+    delete previous;
 }
 
 auto udp_t::emit(const record_t&, const string_view& formatted) -> void {
-    socket.send_to(boost::asio::buffer(formatted.data(), formatted.size()), endpoint_);
+    const auto buffer = boost::asio::buffer(formatted.data(), formatted.size());
+
+    if (options.connect) {
+        socket.send(buffer);
+    } else {
+        socket.send_to(buffer, endpoint());
+    }
+}
+
+auto udp_t::emit_batch(const event_t* events, std::size_t size) -> void {
+    static const char newline = '\n';
+
+    // Datagrams are described as ranges of slices, which allows to pack messages without copying.
+    boost::container::small_vector<string_view, 128> slices;
+    boost::container::small_vector<std::pair<std::size_t, std::size_t>, max_batch> datagrams;
+
+    std::size_t current = 0;
+
+    for (std::size_t id = 0; id < size; ++id) {
+        const auto& message = *events[id].message;
+
+        if (options.mtu > 0 && !datagrams.empty() && current + 1 + message.size() <= options.mtu) {
+            slices.emplace_back(&newline, 1);
+            slices.push_back(message);
+            datagrams.back().second += 2;
+            current += 1 + message.size();
+        } else {
+            datagrams.emplace_back(slices.size(), 1);
+            slices.push_back(message);
+            current = message.size();
+        }
+    }
+
+    auto endpoint = this->endpoint();
+
+#ifdef __linux__
+    boost::container::small_vector<struct iovec, 128> iov(slices.size());
+    for (std::size_t id = 0; id < slices.size(); ++id) {
+        iov[id].iov_base = const_cast<char*>(slices[id].data());
+        iov[id].iov_len = slices[id].size();
+    }
+
+    struct mmsghdr headers[max_batch];
+
+    for (std::size_t offset = 0; offset < datagrams.size(); offset += max_batch) {
+        const auto count = std::min(max_batch, datagrams.size() - offset);
+
+        for (std::size_t id = 0; id < count; ++id) {
+            const auto& datagram = datagrams[offset + id];
+
+            auto& header = headers[id].msg_hdr;
+            header = {};
+            if (!options.connect) {
+                header.msg_name = endpoint.data();
+                header.msg_namelen = static_cast<socklen_t>(endpoint.size());
+            }
+            header.msg_iov = &iov[datagram.first];
+            header.msg_iovlen = datagram.second;
+        }
+
+        for (std::size_t sent = 0; sent < count;) {
+            const auto rc = ::sendmmsg(socket.native_handle(), headers + sent,
+                static_cast<unsigned int>(count - sent), 0);
+
+            if (rc < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+
+                throw std::system_error(errno, std::system_category(), "failed to send datagrams");
+            }
+
+            sent += static_cast<std::size_t>(rc);
+        }
+    }
+#else
+    std::vector<boost::asio::const_buffer> buffers;
+
+    for (const auto& datagram : datagrams) {
+        buffers.clear();
+
+        for (std::size_t id = datagram.first; id < datagram.first + datagram.second; ++id) {
+            buffers.emplace_back(slices[id].data(), slices[id].size());
+        }
+
+        if (options.connect) {
+            socket.send(buffers);
+        } else {
+            socket.send_to(buffers, endpoint);
+        }
+    }
+#endif
 }
 
 }  // namespace socket
@@ -56,7 +315,21 @@ auto factory<udp_t>::from(const config::node_t& config) const -> std::unique_ptr
         throw std::invalid_argument(R"(parameter "port" is required)");
     });
 
-    return blackhole::make_unique<udp_t>(host, static_cast<std::uint16_t>(port));
+    udp_t::options_t options;
+
+    if (auto mtu = config["mtu"].to_uint64()) {
+        options.mtu = static_cast<std::size_t>(mtu.get());
+    }
+
+    if (auto connect = config["connect"].to_bool()) {
+        options.connect = connect.get();
+    }
+
+    if (auto resolve = config["resolve"].to_uint64()) {
+        options.resolve = std::chrono::seconds(resolve.get());
+    }
+
+    return blackhole::make_unique<udp_t>(host, static_cast<std::uint16_t>(port), options);
 }
 
 }  // namespace v1
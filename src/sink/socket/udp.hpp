@@ -1,5 +1,9 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <memory>
+
 #include <boost/asio/ip/udp.hpp>
 
 #include "blackhole/sink.hpp"
@@ -14,19 +18,67 @@ public:
     /// The endpoint type.
     typedef boost::asio::ip::basic_endpoint<boost::asio::ip::udp> endpoint_type;
 
+    struct options_t {
+        /// The maximum datagram size for packing multiple messages of a batch into a single
+        /// datagram separated by newlines, zero disables packing.
+        std::size_t mtu;
+
+        /// Whether to connect the socket, which allows the kernel to skip the route lookup for each
+        /// datagram and surfaces ICMP errors, like port unreachable, on subsequent sends.
+        bool connect;
+
+        /// Interval of the host resolution in background, zero means resolving once.
+        std::chrono::seconds resolve;
+
+        options_t() :
+            mtu(0),
+            connect(false),
+            resolve(0)
+        {}
+    };
+
 private:
+    std::string host;
+    std::uint16_t port;
+    options_t options;
+
     boost::asio::io_service io_service;
     boost::asio::ip::udp::socket socket;
-    boost::asio::ip::udp::endpoint endpoint_;
+
+    /// The current destination, published using RCU, so sending never blocks on its update.
+    std::atomic<const endpoint_type*> endpoint_;
+
+    /// Background resolver, defined in the translation unit.
+    class resolver_t;
+    std::unique_ptr<resolver_t> resolver;
 
 public:
-    udp_t(const std::string& host, std::uint16_t port);
+    /// \param mtu the maximum datagram size for packing multiple messages of a batch into a single
+    ///     datagram separated by newlines, zero disables packing.
+    udp_t(const std::string& host, std::uint16_t port, std::size_t mtu = 0);
+
+    /// \throw boost::system::system_error if either unable to resolve the host or to connect the socket.
+    udp_t(const std::string& host, std::uint16_t port, const options_t& options);
+
+    ~udp_t();
+
+    /// Returns a copy of the current destination endpoint.
+    auto endpoint() const -> endpoint_type;
 
-    /// Returns a const lvalue reference to the destination endpoint.
-    auto endpoint() const -> const endpoint_type&;
+    auto mtu() const noexcept -> std::size_t;
 
     /// Emits a datagram to the specified endpoint.
     auto emit(const record_t& record, const string_view& message) -> void override;
+
+    /// Emits datagrams for the batch, using a `sendmmsg` call per up to 64 datagrams on linux.
+    ///
+    /// Messages are packed into datagrams up to the MTU if configured, otherwise each message is
+    /// sent as a separate datagram.
+    auto emit_batch(const event_t* events, std::size_t size) -> void override;
+
+private:
+    /// Publishes the given endpoint, reconnecting the socket in connected mode.
+    auto update(const endpoint_type& endpoint) -> void;
 };
 
 }  // namespace socket
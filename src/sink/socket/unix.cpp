@@ -0,0 +1,605 @@
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include "blackhole/config/node.hpp"
+#include "blackhole/config/option.hpp"
+#include "blackhole/stdext/string_view.hpp"
+#include "blackhole/sink/socket/unix.hpp"
+
+#include "blackhole/detail/error.hpp"
+#include "blackhole/detail/memory.hpp"
+#include "blackhole/detail/util/optional.hpp"
+
+#include "unix.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+namespace socket {
+
+namespace {
+
+/// The maximum number of messages passed to a single `sendmmsg` call.
+constexpr std::size_t max_batch = 64;
+
+/// The maximum number of slices passed to a single `sendmsg` call, which is the lowest `IOV_MAX`
+/// among supported platforms.
+constexpr std::size_t max_slices = 1024;
+
+/// Writing into a socket closed by the peer must fail instead of raising `SIGPIPE`.
+#ifdef MSG_NOSIGNAL
+constexpr int send_flags = MSG_NOSIGNAL;
+#else
+constexpr int send_flags = 0;
+#endif
+
+auto native(unix_t::type_t type) noexcept -> int {
+    switch (type) {
+    case unix_t::type_t::datagram:
+        return SOCK_DGRAM;
+    case unix_t::type_t::seqpacket:
+        return SOCK_SEQPACKET;
+    case unix_t::type_t::stream:
+        break;
+    }
+
+    return SOCK_STREAM;
+}
+
+/// Creates a socket of the given type connected to the given address.
+///
+/// \throw std::system_error on failure.
+auto connect(unix_t::type_t type, const ::sockaddr_un& address, ::socklen_t length) -> int {
+    auto flags = native(type);
+#ifdef SOCK_CLOEXEC
+    flags |= SOCK_CLOEXEC;
+#endif
+
+    const auto fd = ::socket(AF_UNIX, flags, 0);
+    if (fd < 0) {
+        throw std::system_error(errno, std::system_category(), "failed to create unix socket");
+    }
+
+#ifndef SOCK_CLOEXEC
+    ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+#endif
+#ifdef SO_NOSIGPIPE
+    const int enabled = 1;
+    ::setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &enabled, sizeof(enabled));
+#endif
+
+    if (::connect(fd, reinterpret_cast<const ::sockaddr*>(&address), length) != 0) {
+        const auto ec = errno;
+        ::close(fd);
+        throw std::system_error(ec, std::system_category(), "failed to connect to unix socket");
+    }
+
+    return fd;
+}
+
+/// Writes all the given slices into the stream socket, continuing after partial writes.
+///
+/// \warning slices are modified while being written.
+auto write(int fd, ::iovec* iov, std::size_t size) -> void {
+    while (size > 0) {
+        ::msghdr header{};
+        header.msg_iov = iov;
+        header.msg_iovlen = static_cast<decltype(header.msg_iovlen)>(std::min(size, max_slices));
+
+        const auto rc = ::sendmsg(fd, &header, send_flags);
+
+        if (rc < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            throw std::system_error(errno, std::system_category(), "failed to write to socket");
+        }
+
+        auto nwritten = static_cast<std::size_t>(rc);
+
+        while (size > 0 && nwritten >= iov->iov_len) {
+            nwritten -= iov->iov_len;
+            ++iov;
+            --size;
+        }
+
+        if (nwritten > 0) {
+            iov->iov_base = static_cast<char*>(iov->iov_base) + nwritten;
+            iov->iov_len -= nwritten;
+        }
+    }
+}
+
+/// Sends each of the given slices as a separate message.
+auto send(int fd, ::iovec* iov, std::size_t size) -> void {
+#ifdef __linux__
+    ::mmsghdr headers[max_batch];
+
+    for (std::size_t offset = 0; offset < size; offset += max_batch) {
+        const auto count = std::min(max_batch, size - offset);
+
+        for (std::size_t id = 0; id < count; ++id) {
+            headers[id] = {};
+            headers[id].msg_hdr.msg_iov = &iov[offset + id];
+            headers[id].msg_hdr.msg_iovlen = 1;
+        }
+
+        for (std::size_t sent = 0; sent < count;) {
+            const auto rc = ::sendmmsg(fd, headers + sent, static_cast<unsigned int>(count - sent),
+                send_flags);
+
+            if (rc < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+
+                throw std::system_error(errno, std::system_category(), "failed to send messages");
+            }
+
+            sent += static_cast<std::size_t>(rc);
+        }
+    }
+#else
+    for (std::size_t id = 0; id < size;) {
+        if (::send(fd, iov[id].iov_base, iov[id].iov_len, send_flags) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            throw std::system_error(errno, std::system_category(), "failed to send messages");
+        }
+
+        ++id;
+    }
+#endif
+}
+
+/// Writes the given slices as a stream or sends them as separate messages depending on the socket
+/// type.
+auto transmit(int fd, unix_t::type_t type, ::iovec* iov, std::size_t size) -> void {
+    if (type == unix_t::type_t::stream) {
+        write(fd, iov, size);
+    } else {
+        send(fd, iov, size);
+    }
+}
+
+auto slice(const char* data, std::size_t size) noexcept -> ::iovec {
+    return {const_cast<char*>(data), size};
+}
+
+}  // namespace
+
+class unix_t::channel_t {
+    typedef nonblocking_t::overflow_t overflow_t;
+
+    const unix_t& sink;
+    const nonblocking_t options;
+
+    std::mutex mutex;
+    /// Notifies the I/O thread about pending data or stopping.
+    std::condition_variable ready;
+    /// Notifies blocked producers about free space in the buffer and the destructor about the I/O
+    /// thread being finished.
+    std::condition_variable space;
+    std::string pending;
+    /// End offsets of pending messages.
+    std::vector<std::size_t> bounds;
+    /// Connected socket, negative if there is no connection. Closed by the I/O thread under the
+    /// lock only, which allows the destructor to shut it down.
+    int fd;
+    bool stopped;
+    bool finished;
+
+    // Accessed by the I/O thread only.
+    std::string sending;
+    std::vector<std::size_t> ends;
+    std::vector<::iovec> slices;
+
+    std::atomic<std::uint64_t> dropped_;
+
+    std::thread thread;
+
+public:
+    channel_t(const unix_t& sink, nonblocking_t options) :
+        sink(sink),
+        options(options),
+        fd(-1),
+        stopped(false),
+        finished(false),
+        dropped_(0)
+    {
+        thread = std::thread([this] {
+            run();
+        });
+    }
+
+    ~channel_t() {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            stopped = true;
+            ready.notify_all();
+            space.notify_all();
+
+            // Writes blocked by a peer not reading are interrupted after the grace period.
+            if (!space.wait_for(lock, std::chrono::seconds(1), [&] { return finished; })) {
+                if (fd >= 0) {
+                    ::shutdown(fd, SHUT_RDWR);
+                }
+            }
+        }
+
+        thread.join();
+    }
+
+    auto dropped() const noexcept -> std::uint64_t {
+        return dropped_.load();
+    }
+
+    /// Appends framed messages returned by the given function for each index into the send
+    /// buffer.
+    template<typename F>
+    auto push(std::size_t size, F&& message) -> void {
+        const auto tail = suffix(sink.options.framing);
+        char head[max_prefix];
+
+        std::unique_lock<std::mutex> lock(mutex);
+
+        for (std::size_t id = 0; id < size; ++id) {
+            const string_view& data = message(id);
+            const auto nhead = prefix(sink.options.framing, data.size(), head);
+
+            if (reserve(lock, nhead + data.size() + tail.size())) {
+                pending.append(head, nhead);
+                pending.append(data.data(), data.size());
+                pending.append(tail.data(), tail.size());
+                bounds.push_back(pending.size());
+            } else {
+                ++dropped_;
+            }
+        }
+
+        ready.notify_one();
+    }
+
+private:
+    static constexpr long min_backoff = 100;
+    static constexpr long max_backoff = 10000;
+
+    /// Waits for the buffer to have enough free space for the given number of bytes according to
+    /// the overflow policy.
+    ///
+    /// \returns false if the message should be dropped.
+    auto reserve(std::unique_lock<std::mutex>& lock, std::size_t size) -> bool {
+        // Messages larger than the whole buffer are accepted into an empty one, otherwise they
+        // would never fit.
+        const auto fits = [&] {
+            return pending.empty() || pending.size() + size <= options.capacity;
+        };
+
+        if (fits()) {
+            return true;
+        }
+
+        if (options.overflow == overflow_t::drop) {
+            return false;
+        }
+
+        ready.notify_one();
+        space.wait(lock, [&] {
+            return stopped || fits();
+        });
+
+        return !stopped;
+    }
+
+    auto run() -> void {
+        auto backoff = min_backoff;
+
+        std::unique_lock<std::mutex> lock(mutex);
+
+        while (true) {
+            ready.wait(lock, [&] {
+                return stopped || !pending.empty();
+            });
+
+            if (pending.empty()) {
+                break;
+            }
+
+            if (fd < 0) {
+                // Data buffered while disconnected is dropped on stopping.
+                if (stopped) {
+                    break;
+                }
+
+                lock.unlock();
+
+                auto socket = -1;
+                try {
+                    socket = connect(sink.options.type, sink.address, sink.length);
+                } catch (const std::system_error&) {
+                }
+
+                lock.lock();
+
+                if (socket < 0) {
+                    ready.wait_for(lock, std::chrono::milliseconds(backoff), [&] {
+                        return stopped;
+                    });
+
+                    backoff = std::min(backoff * 2, max_backoff);
+                    continue;
+                }
+
+                fd = socket;
+                backoff = min_backoff;
+            }
+
+            sending.swap(pending);
+            ends.swap(bounds);
+            lock.unlock();
+
+            space.notify_all();
+
+            try {
+                flush();
+            } catch (const std::system_error& err) {
+                // Partially sent data can not be resent into the new connection without breaking
+                // the message boundaries.
+                dropped_ += ends.size();
+                detail::error::report(error::kind_t::sink, err.what());
+
+                lock.lock();
+                ::close(fd);
+                fd = -1;
+                lock.unlock();
+            }
+
+            sending.clear();
+            ends.clear();
+
+            lock.lock();
+        }
+
+        if (fd >= 0) {
+            ::close(fd);
+            fd = -1;
+        }
+
+        finished = true;
+        space.notify_all();
+    }
+
+    auto flush() -> void {
+        slices.clear();
+
+        if (sink.options.type == type_t::stream) {
+            slices.push_back(slice(sending.data(), sending.size()));
+        } else {
+            std::size_t offset = 0;
+            for (auto end : ends) {
+                slices.push_back(slice(sending.data() + offset, end - offset));
+                offset = end;
+            }
+        }
+
+        transmit(fd, sink.options.type, slices.data(), slices.size());
+    }
+};
+
+constexpr long unix_t::channel_t::min_backoff;
+constexpr long unix_t::channel_t::max_backoff;
+
+unix_t::unix_t(std::string path, options_t options) :
+    path_(std::move(path)),
+    options(options),
+    address(),
+    length(0),
+    fd(-1)
+{
+    if (options.framing != framing_t::none && options.type != type_t::stream) {
+        throw std::invalid_argument("framing is supported by stream unix sockets only");
+    }
+
+#ifndef __linux__
+    if (options.abstract) {
+        throw std::invalid_argument("abstract unix socket addresses are supported on linux only");
+    }
+#endif
+
+    // Filesystem paths need room for the terminating null, abstract names for the leading one.
+    if (path_.empty() || path_.size() >= sizeof(address.sun_path)) {
+        throw std::invalid_argument("unix socket path must be non-empty and shorter than " +
+            std::to_string(sizeof(address.sun_path)) + " bytes");
+    }
+
+    const std::size_t offset = options.abstract ? 1 : 0;
+
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path + offset, path_.data(), path_.size());
+
+    // Abstract names are not null-terminated, so the length counts either the terminating null of
+    // the path or the leading one of the name.
+    length = static_cast<::socklen_t>(offsetof(::sockaddr_un, sun_path) + path_.size() + 1);
+}
+
+unix_t::unix_t(std::string path, options_t options, nonblocking_t nonblocking) :
+    unix_t(std::move(path), options)
+{
+    channel.reset(new channel_t(*this, nonblocking));
+}
+
+unix_t::~unix_t() {
+    channel.reset();
+
+    if (fd >= 0) {
+        ::close(fd);
+    }
+}
+
+auto unix_t::path() const noexcept -> const std::string& {
+    return path_;
+}
+
+auto unix_t::type() const noexcept -> type_t {
+    return options.type;
+}
+
+auto unix_t::abstract() const noexcept -> bool {
+    return options.abstract;
+}
+
+auto unix_t::framing() const noexcept -> framing_t {
+    return options.framing;
+}
+
+auto unix_t::dropped() const noexcept -> std::uint64_t {
+    return channel ? channel->dropped() : 0;
+}
+
+auto unix_t::emit(const record_t&, const string_view& message) -> void {
+    if (channel) {
+        channel->push(1, [&](std::size_t) -> const string_view& {
+            return message;
+        });
+        return;
+    }
+
+    char head[max_prefix];
+    const auto tail = suffix(options.framing);
+
+    std::array<::iovec, 3> slices{{
+        slice(head, prefix(options.framing, message.size(), head)),
+        slice(message.data(), message.size()),
+        slice(tail.data(), tail.size())
+    }};
+
+    std::lock_guard<detail::mutex_t> lock(mutex);
+
+    if (fd < 0) {
+        fd = connect(options.type, address, length);
+    }
+
+    try {
+        if (options.type == type_t::stream) {
+            write(fd, slices.data(), slices.size());
+        } else {
+            send(fd, &slices[1], 1);
+        }
+    } catch (const std::system_error&) {
+        ::close(fd);
+        fd = -1;
+        throw;
+    }
+}
+
+auto unix_t::emit_batch(const event_t* events, std::size_t size) -> void {
+    if (channel) {
+        channel->push(size, [&](std::size_t id) -> const string_view& {
+            return *events[id].message;
+        });
+        return;
+    }
+
+    const auto tail = suffix(options.framing);
+
+    std::vector<std::array<char, max_prefix>> heads(options.framing == framing_t::length ||
+        options.framing == framing_t::octet ? size : 0);
+
+    std::vector<::iovec> slices;
+    slices.reserve(options.framing == framing_t::none ? size : 2 * size);
+
+    for (std::size_t id = 0; id < size; ++id) {
+        const auto& message = *events[id].message;
+
+        if (!heads.empty()) {
+            slices.push_back(slice(heads[id].data(),
+                prefix(options.framing, message.size(), heads[id].data())));
+        }
+
+        slices.push_back(slice(message.data(), message.size()));
+
+        if (tail.size() > 0) {
+            slices.push_back(slice(tail.data(), tail.size()));
+        }
+    }
+
+    std::lock_guard<detail::mutex_t> lock(mutex);
+
+    if (fd < 0) {
+        fd = connect(options.type, address, length);
+    }
+
+    try {
+        transmit(fd, options.type, slices.data(), slices.size());
+    } catch (const std::system_error&) {
+        ::close(fd);
+        fd = -1;
+        throw;
+    }
+}
+
+}  // namespace socket
+}  // namespace sink
+
+using sink::socket::unix_t;
+
+using detail::util::value_or;
+
+auto factory<unix_t>::type() const noexcept -> const char* {
+    return "unix";
+}
+
+auto factory<unix_t>::from(const config::node_t& config) const -> std::unique_ptr<sink_t> {
+    (void)registry;
+    const auto path = value_or(config["path"].to_string(), []() -> std::string {
+        throw std::invalid_argument(R"(parameter "path" is required)");
+    });
+
+    unix_t::options_t options;
+
+    if (auto type = config["socket"].to_string()) {
+        if (type.get() == "datagram") {
+            options.type = unix_t::type_t::datagram;
+        } else if (type.get() == "seqpacket") {
+            options.type = unix_t::type_t::seqpacket;
+        } else if (type.get() != "stream") {
+            throw std::invalid_argument(R"(parameter "socket" must be one of "stream", )"
+                R"("datagram" or "seqpacket")");
+        }
+    }
+
+    if (auto abstract = config["abstract"].to_bool()) {
+        options.abstract = abstract.get();
+    }
+
+    options.framing = sink::socket::framing(config);
+
+    if (auto nonblocking = sink::socket::nonblocking(config)) {
+        return blackhole::make_unique<unix_t>(path, options, nonblocking.get());
+    }
+
+    return blackhole::make_unique<unix_t>(path, options);
+}
+
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "blackhole/sink.hpp"
+
+#include "blackhole/detail/mutex.hpp"
+
+#include "framing.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+namespace socket {
+
+class unix_t : public sink_t {
+public:
+    /// Socket type.
+    enum class type_t {
+        /// Connected byte stream, where messages can be framed, `SOCK_STREAM`.
+        stream,
+        /// Connected datagrams, each message is sent as a separate one, `SOCK_DGRAM`.
+        datagram,
+        /// Connected datagrams with guaranteed order and delivery, `SOCK_SEQPACKET`.
+        seqpacket
+    };
+
+    struct options_t {
+        type_t type;
+        /// Whether the path is a name in the abstract namespace instead of a filesystem path,
+        /// which is linux specific.
+        bool abstract;
+        /// Message framing, which only stream sockets support.
+        framing_t framing;
+
+        options_t() :
+            type(type_t::stream),
+            abstract(false),
+            framing(framing_t::none)
+        {}
+    };
+
+private:
+    std::string path_;
+    options_t options;
+
+    ::sockaddr_un address;
+    ::socklen_t length;
+
+    /// Connected socket in blocking mode, negative if there is no connection.
+    int fd;
+    mutable detail::mutex_t mutex;
+
+    /// Send buffer with its I/O thread in non-blocking mode, defined in the translation unit.
+    class channel_t;
+    std::unique_ptr<channel_t> channel;
+
+public:
+    /// Constructs a unix socket sink, which connects lazily on the first emitted message and
+    /// reconnects after send failures.
+    ///
+    /// \throw std::invalid_argument if the path is empty or does not fit into the socket address,
+    ///     if the abstract namespace is not supported or if framing is requested for a socket type
+    ///     other than stream.
+    explicit unix_t(std::string path, options_t options = options_t());
+
+    /// Constructs a unix socket sink, which never performs I/O on emitting threads.
+    ///
+    /// Messages are appended to a bounded send buffer, which is written by a dedicated I/O thread,
+    /// connecting on that thread too and reconnecting with exponential backoff from 100 ms up to
+    /// 10 s after failures. Messages buffered while disconnected are sent after reconnection,
+    /// while the ones that failed to be sent are dropped.
+    unix_t(std::string path, options_t options, nonblocking_t nonblocking);
+
+    /// Waits for buffered data to be sent if connected, for at most a second, then stops the I/O
+    /// thread.
+    ~unix_t();
+
+    auto path() const noexcept -> const std::string&;
+    auto type() const noexcept -> type_t;
+    auto abstract() const noexcept -> bool;
+    auto framing() const noexcept -> framing_t;
+
+    /// Returns the number of messages dropped because of the send buffer overflow or send
+    /// failures in non-blocking mode.
+    auto dropped() const noexcept -> std::uint64_t;
+
+    auto emit(const record_t& record, const string_view& message) -> void override;
+
+    /// Writes the whole batch using a single gathered write for stream sockets and `sendmmsg`
+    /// calls of up to 64 messages for others where available.
+    auto emit_batch(const event_t* events, std::size_t size) -> void override;
+};
+
+}  // namespace socket
+}  // namespace sink
+}  // namespace v1
+}  // namespace blackhole
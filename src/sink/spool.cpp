@@ -0,0 +1,656 @@
+#include "blackhole/sink/spool.hpp"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <boost/optional/optional.hpp>
+
+#include "blackhole/config/node.hpp"
+#include "blackhole/config/option.hpp"
+#include "blackhole/metrics.hpp"
+#include "blackhole/pressure.hpp"
+#include "blackhole/record.hpp"
+#include "blackhole/registry.hpp"
+
+#include "blackhole/detail/error.hpp"
+#include "blackhole/detail/memory.hpp"
+#include "blackhole/detail/sink/ring.hpp"
+#include "blackhole/detail/sink/spool.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+namespace {
+
+/// Extension of segment files, whose names are zero-padded ids, so they sort in order.
+constexpr char extension[] = ".spool";
+constexpr std::size_t digits = 20;
+
+/// Segment entry header, followed by the encoded record.
+struct entry_t {
+    std::uint32_t size;
+    /// CRC32 of the encoded record, which detects a torn tail left by a crash.
+    std::uint32_t checksum;
+};
+
+auto checksum(const char* data, std::size_t size) noexcept -> std::uint32_t {
+    return static_cast<std::uint32_t>(::crc32(0, reinterpret_cast<const Bytef*>(data),
+        static_cast<uInt>(size)));
+}
+
+/// Closes the file descriptor on scope exit.
+class closer_t {
+    int fd;
+
+public:
+    explicit closer_t(int fd) noexcept :
+        fd(fd)
+    {}
+
+    ~closer_t() {
+        ::close(fd);
+    }
+};
+
+auto read(const std::string& path, std::vector<char>& buffer) -> void {
+    const auto fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        throw std::system_error(errno, std::system_category(), "failed to open '" + path + "'");
+    }
+
+    const closer_t closer(fd);
+
+    struct stat info;
+    if (::fstat(fd, &info) != 0) {
+        throw std::system_error(errno, std::system_category(), "failed to stat '" + path + "'");
+    }
+
+    buffer.resize(static_cast<std::size_t>(info.st_size));
+
+    std::size_t offset = 0;
+    while (offset < buffer.size()) {
+        const auto rc = ::read(fd, buffer.data() + offset, buffer.size() - offset);
+
+        if (rc < 0 && errno == EINTR) {
+            continue;
+        }
+
+        if (rc < 0) {
+            throw std::system_error(errno, std::system_category(), "failed to read '" + path + "'");
+        }
+
+        if (rc == 0) {
+            break;
+        }
+
+        offset += static_cast<std::size_t>(rc);
+    }
+
+    buffer.resize(offset);
+}
+
+/// Reads the entry at the given offset of the segment, advancing the offset past it, or returns
+/// false if there is either no entry or a torn one.
+auto parse(const std::vector<char>& buffer, std::size_t& offset, ring_t::slot_t& slot) noexcept
+    -> bool
+{
+    entry_t entry;
+    if (offset + sizeof(entry) > buffer.size()) {
+        return false;
+    }
+
+    std::memcpy(&entry, buffer.data() + offset, sizeof(entry));
+
+    const auto data = buffer.data() + offset + sizeof(entry);
+    if (entry.size > buffer.size() - offset - sizeof(entry) ||
+        checksum(data, entry.size) != entry.checksum)
+    {
+        return false;
+    }
+
+    slot = {data, entry.size};
+    offset += sizeof(entry) + entry.size;
+    return true;
+}
+
+}  // namespace
+
+spool_t::options_t::options_t() :
+    capacity(1024 * 1024),
+    watermark(0.5),
+    segment(4 * 1024 * 1024),
+    limit(1024 * 1024 * 1024),
+    batch(256),
+    backoff(1000)
+{}
+
+class spool_t::inner_t {
+public:
+    std::unique_ptr<sink_t> wrapped;
+    const options_t options;
+
+    ring_t ring;
+    /// Ring fill in bytes, after which records are spilled.
+    const std::size_t threshold;
+
+    /// Number of records in the ring, which are not emitted yet.
+    std::atomic<std::uint64_t> queued;
+    /// Whether producers spill records instead of enqueueing them, which lasts until all spilled
+    /// records are replayed.
+    std::atomic<bool> spilling;
+    std::atomic<bool> sleeping;
+    /// Total size of segment files.
+    std::atomic<std::uint64_t> disk;
+
+    metrics::counter_t spilled;
+    metrics::counter_t replayed;
+    metrics::counter_t dropped;
+    metrics::counter_t failed;
+
+    /// Guards the stop flag and segments.
+    mutable std::mutex mutex;
+    std::condition_variable cv;
+    std::condition_variable drained;
+    bool stopped;
+
+    /// Ids of complete segments in order, which are ready for replaying.
+    std::deque<std::uint64_t> segments;
+    /// The segment being written if any, its id and size.
+    int fd;
+    std::uint64_t current;
+    std::size_t written;
+    /// Id of the next segment.
+    std::uint64_t next;
+
+    std::thread thread;
+
+    inner_t(std::unique_ptr<sink_t> wrapped, options_t options) :
+        wrapped(std::move(wrapped)),
+        options(std::move(options)),
+        ring(this->options.capacity),
+        threshold(static_cast<std::size_t>(static_cast<double>(this->options.capacity) *
+            this->options.watermark)),
+        queued(0),
+        spilling(false),
+        sleeping(false),
+        disk(0),
+        stopped(false),
+        fd(-1),
+        current(0),
+        written(0),
+        next(0)
+    {
+        scan();
+
+        // Records spilled by the previous run are older than any new one.
+        spilling = !segments.empty();
+
+        thread = std::thread(&inner_t::run, this);
+    }
+
+    ~inner_t() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopped = true;
+        }
+
+        cv.notify_one();
+        thread.join();
+
+        if (fd != -1) {
+            ::close(fd);
+        }
+    }
+
+    auto filename(std::uint64_t id) const -> std::string {
+        auto name = std::to_string(id);
+        name.insert(0, digits - std::min(digits, name.size()), '0');
+        return options.path + "/" + name + extension;
+    }
+
+    auto scan() -> void {
+        if (::mkdir(options.path.c_str(), 0755) != 0 && errno != EEXIST) {
+            throw std::system_error(errno, std::system_category(),
+                "failed to create spool directory '" + options.path + "'");
+        }
+
+        std::unique_ptr<DIR, int(*)(DIR*)> dir(::opendir(options.path.c_str()), &::closedir);
+        if (dir == nullptr) {
+            throw std::system_error(errno, std::system_category(),
+                "failed to open spool directory '" + options.path + "'");
+        }
+
+        const auto size = sizeof(extension) - 1;
+
+        while (const auto entry = ::readdir(dir.get())) {
+            const std::string name(entry->d_name);
+
+            if (name.size() != digits + size || name.compare(digits, size, extension) != 0 ||
+                name.find_first_not_of("0123456789") != digits)
+            {
+                continue;
+            }
+
+            const auto id = static_cast<std::uint64_t>(std::strtoull(name.c_str(), nullptr, 10));
+
+            struct stat info;
+            if (::stat(filename(id).c_str(), &info) == 0) {
+                segments.push_back(id);
+                disk += static_cast<std::uint64_t>(info.st_size);
+                next = std::max(next, id + 1);
+            }
+        }
+
+        std::sort(segments.begin(), segments.end());
+    }
+
+    auto enqueue(const string_view& encoded) -> void {
+        if (!spilling.load(std::memory_order_acquire) &&
+            ring.used() + encoded.size() <= threshold)
+        {
+            const auto reservation = ring.reserve(encoded.size());
+
+            if (reservation.data != nullptr) {
+                std::memcpy(reservation.data, encoded.data(), encoded.size());
+                ++queued;
+                ring.commit(reservation);
+                wake();
+                return;
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            spilling = true;
+            spill(encoded.data(), encoded.size());
+        }
+
+        wake();
+    }
+
+    /// Appends the encoded record to the current segment, starting a new one if required.
+    ///
+    /// \warning must be called under the lock.
+    auto spill(const char* data, std::size_t size) -> void {
+        if (disk.load() + sizeof(entry_t) + size > options.limit) {
+            dropped.add();
+            return;
+        }
+
+        if (fd != -1 && written >= options.segment) {
+            seal();
+        }
+
+        if (fd == -1) {
+            const auto path = filename(next);
+
+            fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644);
+            if (fd == -1) {
+                dropped.add();
+                throw std::system_error(errno, std::system_category(),
+                    "failed to create spool segment '" + path + "'");
+            }
+
+            current = next++;
+            written = 0;
+        }
+
+        const entry_t entry{static_cast<std::uint32_t>(size), checksum(data, size)};
+
+        struct iovec iov[2];
+        iov[0].iov_base = const_cast<entry_t*>(&entry);
+        iov[0].iov_len = sizeof(entry);
+        iov[1].iov_base = const_cast<char*>(data);
+        iov[1].iov_len = size;
+
+        const auto expected = sizeof(entry) + size;
+        const auto rc = ::writev(fd, iov, 2);
+
+        if (rc < 0 || static_cast<std::size_t>(rc) != expected) {
+            const auto ec = rc < 0 ? errno : EIO;
+
+            // The entry may be torn, so the segment is finished here, replaying it stops there.
+            if (rc > 0) {
+                written += static_cast<std::size_t>(rc);
+                disk += static_cast<std::uint64_t>(rc);
+            }
+
+            seal();
+            dropped.add();
+            throw std::system_error(ec, std::system_category(), "failed to write spool segment");
+        }
+
+        written += expected;
+        disk += expected;
+        spilled.add();
+    }
+
+    /// Finishes the current segment, making it ready for replaying.
+    ///
+    /// \warning must be called under the lock.
+    auto seal() -> void {
+        ::close(fd);
+        fd = -1;
+        segments.push_back(current);
+    }
+
+    auto wake() -> void {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        if (sleeping.load(std::memory_order_relaxed)) {
+            std::lock_guard<std::mutex> lock(mutex);
+            cv.notify_one();
+        }
+    }
+
+    auto idle() const -> bool {
+        return queued.load() == 0 && segments.empty() && fd == -1;
+    }
+
+    /// Emits the batch into the wrapped sink, retrying it after the backoff until either it
+    /// succeeds or the sink is stopped, returning false in the latter case.
+    auto deliver(const event_t* events, std::size_t size) -> bool {
+        while (true) {
+            try {
+                wrapped->emit_batch(events, size);
+                return true;
+            } catch (...) {
+                failed.add();
+                detail::error::report(error::kind_t::sink);
+            }
+
+            std::unique_lock<std::mutex> lock(mutex);
+            if (stopped || cv.wait_for(lock, options.backoff, [&] { return stopped; })) {
+                return false;
+            }
+        }
+    }
+
+    auto run() -> void {
+        std::unique_ptr<ring::decoded_t[]> decoded(new ring::decoded_t[options.batch]);
+        std::vector<ring_t::slot_t> slots(options.batch);
+        std::vector<event_t> events(options.batch);
+        std::vector<char> buffer;
+
+        while (true) {
+            if (drain(decoded.get(), slots, events)) {
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(mutex);
+            if (stopped) {
+                break;
+            }
+
+            if (!segments.empty() || fd != -1) {
+                lock.unlock();
+                replay(decoded.get(), events, buffer);
+                continue;
+            }
+
+            spilling = false;
+            drained.notify_all();
+
+            sleeping = true;
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+
+            if (ring.empty()) {
+                cv.wait_for(lock, std::chrono::milliseconds(100));
+            }
+
+            sleeping = false;
+        }
+    }
+
+    /// Emits up to a batch of records from the ring, returning false if it's empty.
+    auto drain(ring::decoded_t* decoded, std::vector<ring_t::slot_t>& slots,
+               std::vector<event_t>& events) -> bool
+    {
+        std::size_t size = 0;
+        while (size < options.batch && ring.read(slots[size])) {
+            decoded[size].decode(slots[size]);
+            events[size] = {&decoded[size].record(), &decoded[size].output()};
+            ++size;
+        }
+
+        if (size == 0) {
+            return false;
+        }
+
+        auto count = size;
+
+        if (!deliver(events.data(), size)) {
+            std::lock_guard<std::mutex> lock(mutex);
+
+            try {
+                for (std::size_t id = 0; id < size; ++id) {
+                    spill(slots[id].data, slots[id].size);
+                }
+
+                ring_t::slot_t slot;
+                while (ring.read(slot)) {
+                    spill(slot.data, slot.size);
+                    ++count;
+                }
+            } catch (...) {
+                detail::error::report(error::kind_t::sink);
+            }
+
+            // Records not read are lost anyway, the sink is being destroyed.
+            ring_t::slot_t slot;
+            while (ring.read(slot)) {
+                ++count;
+            }
+        }
+
+        ring.release();
+        queued -= count;
+
+        std::lock_guard<std::mutex> lock(mutex);
+        drained.notify_all();
+
+        return true;
+    }
+
+    /// Replays the oldest segment, finishing the current one if it's the only one left.
+    auto replay(ring::decoded_t* decoded, std::vector<event_t>& events, std::vector<char>& buffer)
+        -> void
+    {
+        std::uint64_t id;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (segments.empty()) {
+                seal();
+            }
+
+            id = segments.front();
+        }
+
+        const auto path = filename(id);
+
+        try {
+            read(path, buffer);
+        } catch (...) {
+            detail::error::report(error::kind_t::sink);
+            buffer.clear();
+        }
+
+        std::size_t offset = 0;
+        std::size_t size = 0;
+        ring_t::slot_t slot;
+
+        while (true) {
+            const auto more = parse(buffer, offset, slot);
+            if (more) {
+                decoded[size].decode(slot);
+                events[size] = {&decoded[size].record(), &decoded[size].output()};
+                ++size;
+            }
+
+            if (size == options.batch || (!more && size > 0)) {
+                // The segment stays on disk if stopped, records emitted so far will be replayed
+                // once again.
+                if (!deliver(events.data(), size)) {
+                    return;
+                }
+
+                replayed.add(size);
+                size = 0;
+            }
+
+            if (!more) {
+                break;
+            }
+        }
+
+        if (offset < buffer.size()) {
+            detail::error::report(error::kind_t::sink, "spool segment has a torn tail");
+        }
+
+        ::unlink(path.c_str());
+
+        std::lock_guard<std::mutex> lock(mutex);
+        segments.pop_front();
+        disk -= std::min<std::uint64_t>(disk.load(), buffer.size());
+        drained.notify_all();
+    }
+};
+
+spool_t::spool_t(std::unique_ptr<sink_t> wrapped, options_t options) {
+    if (options.path.empty()) {
+        throw std::invalid_argument("spool path must not be empty");
+    }
+
+    if (!(options.watermark > 0.0 && options.watermark <= 1.0)) {
+        throw std::invalid_argument("spool watermark must be in (0; 1] range");
+    }
+
+    if (options.segment == 0) {
+        throw std::invalid_argument("spool segment size must be positive");
+    }
+
+    if (options.batch == 0) {
+        throw std::invalid_argument("spool batch size must be positive");
+    }
+
+    d.reset(new inner_t(std::move(wrapped), std::move(options)));
+}
+
+spool_t::~spool_t() = default;
+
+auto spool_t::spilled() const noexcept -> std::uint64_t {
+    return d->spilled.get();
+}
+
+auto spool_t::replayed() const noexcept -> std::uint64_t {
+    return d->replayed.get();
+}
+
+auto spool_t::dropped() const noexcept -> std::uint64_t {
+    return d->dropped.get();
+}
+
+auto spool_t::emit(const record_t& record, const string_view& message) -> void {
+    d->enqueue(ring::encode(record, message));
+}
+
+auto spool_t::flush(std::chrono::steady_clock::time_point deadline) -> bool {
+    {
+        std::unique_lock<std::mutex> lock(d->mutex);
+        if (!d->drained.wait_until(lock, deadline, [&] { return d->idle(); })) {
+            return false;
+        }
+    }
+
+    return d->wrapped->flush(deadline);
+}
+
+auto spool_t::collect(metrics::collector_t& collector) const -> void {
+    collector.counter("blackhole_spool_spilled_total", d->spilled.get());
+    collector.counter("blackhole_spool_replayed_total", d->replayed.get());
+    collector.counter("blackhole_spool_dropped_total", d->dropped.get());
+    collector.counter("blackhole_spool_failed_total", d->failed.get());
+    collector.gauge("blackhole_spool_disk_bytes", d->disk.load());
+
+    d->wrapped->collect(collector);
+}
+
+auto spool_t::pressure() const -> pressure_t {
+    const auto fill = static_cast<double>(d->ring.used()) / static_cast<double>(d->ring.capacity());
+
+    pressure_t result(std::min(1.0, fill), d->dropped.get());
+    result.merge(d->wrapped->pressure());
+
+    return result;
+}
+
+}  // namespace sink
+
+auto factory<sink::spool_t>::type() const noexcept -> const char* {
+    return "spool";
+}
+
+auto factory<sink::spool_t>::from(const config::node_t& config) const -> std::unique_ptr<sink_t> {
+    sink::spool_t::options_t options;
+
+    if (auto path = config["path"].to_string()) {
+        options.path = path.get();
+    } else {
+        throw std::invalid_argument(R"(parameter "path" is required)");
+    }
+
+    const auto type = config["sink"]["type"].to_string();
+    if (!type) {
+        throw std::invalid_argument(R"(parameter "sink" with "type" is required)");
+    }
+
+    if (auto capacity = config["capacity"].to_uint64()) {
+        options.capacity = static_cast<std::size_t>(capacity.get());
+    }
+
+    if (auto watermark = config["watermark"].to_double()) {
+        options.watermark = watermark.get();
+    }
+
+    if (auto segment = config["segment"].to_uint64()) {
+        options.segment = static_cast<std::size_t>(segment.get());
+    }
+
+    if (auto limit = config["limit"].to_uint64()) {
+        options.limit = limit.get();
+    }
+
+    if (auto batch = config["batch"].to_uint64()) {
+        options.batch = static_cast<std::size_t>(batch.get());
+    }
+
+    if (auto backoff = config["backoff"].to_uint64()) {
+        options.backoff = std::chrono::milliseconds(backoff.get());
+    }
+
+    auto wrapped = registry.sink(type.get())(*config["sink"].unwrap());
+
+    return blackhole::make_unique<sink::spool_t>(std::move(wrapped), std::move(options));
+}
+
+}  // namespace v1
+}  // namespace blackhole
@@ -1,20 +1,325 @@
 #include "blackhole/sink/syslog.hpp"
 
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
 #include <syslog.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <mutex>
+#include <stdexcept>
+#include <system_error>
+
+#include <boost/container/small_vector.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/optional/optional.hpp>
 
 #include "blackhole/config/node.hpp"
 #include "blackhole/config/option.hpp"
 #include "blackhole/stdext/string_view.hpp"
 #include "blackhole/record.hpp"
 
+#include "blackhole/detail/process.hpp"
 #include "blackhole/detail/procname.hpp"
 #include "blackhole/detail/sink/syslog.hpp"
 
 namespace blackhole {
 inline namespace v1 {
 namespace sink {
+namespace {
+
+/// The maximum number of datagrams passed to a single `sendmmsg` call.
+constexpr std::size_t max_batch = 64;
+
+/// Number of slices per frame: header, time stamp, trailer and the message itself.
+constexpr std::size_t slices = 4;
+
+struct scratch_t {
+    char prefix[24];
+    char time[32];
+};
+
+/// Formats the time stamp part of a frame, caching it per thread until the second changes.
+class timestamp_t {
+    std::time_t time;
+    syslog_t::format_t format;
+    std::size_t size;
+    char buffer[32];
+
+public:
+    timestamp_t() :
+        time(-1),
+        format(syslog_t::format_t::rfc3164),
+        size(0)
+    {}
+
+    auto get(const record_t& record, syslog_t::format_t format) -> string_view {
+        const auto timestamp = record.timestamp();
+        const auto time = record_t::clock_type::to_time_t(timestamp);
+
+        if (time != this->time || format != this->format) {
+            std::tm tm;
+
+            if (format == syslog_t::format_t::rfc3164) {
+                ::localtime_r(&time, &tm);
+                size = std::strftime(buffer, sizeof(buffer), "%b %e %H:%M:%S", &tm);
+            } else {
+                ::gmtime_r(&time, &tm);
+                size = std::strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%S.000000Z", &tm);
+            }
+
+            this->time = time;
+            this->format = format;
+        }
+
+        if (format == syslog_t::format_t::rfc5424) {
+            // Patch microseconds in place, located between the dot and the trailing zone.
+            auto usec = std::chrono::duration_cast<
+                std::chrono::microseconds
+            >(timestamp.time_since_epoch()).count() % 1000000;
+
+            for (std::size_t id = size - 2; id > size - 8; --id) {
+                buffer[id] = static_cast<char>('0' + usec % 10);
+                usec /= 10;
+            }
+        }
+
+        return string_view(buffer, size);
+    }
+};
+
+auto hostname() -> std::string {
+    const auto name = detail::this_process::host();
+    return name.size() == 0 ? "-" : name.to_string();
+}
+
+}  // namespace
+
+/// Connected socket, either local datagram one or remote UDP or TCP.
+class syslog_t::transport_t {
+    std::string path;
+    std::string host;
+    std::string port;
+
+    int type;
+    int fd;
+
+    /// Serializes writes into the stream socket, which is unable to write a frame atomically.
+    std::mutex mutex;
+
+public:
+    explicit transport_t(const std::string& address) :
+        type(SOCK_DGRAM),
+        fd(-1)
+    {
+        const auto udp = address.compare(0, 6, "udp://") == 0;
+        const auto tcp = address.compare(0, 6, "tcp://") == 0;
+
+        if (udp || tcp) {
+            const auto endpoint = address.substr(6);
+            const auto pos = endpoint.rfind(':');
+
+            if (pos == std::string::npos || pos == 0 || pos + 1 == endpoint.size()) {
+                throw std::invalid_argument("syslog address must be in 'proto://host:port' form: \"" +
+                    address + "\"");
+            }
+
+            host = endpoint.substr(0, pos);
+            port = endpoint.substr(pos + 1);
+
+            // Strip brackets of IPv6 addresses.
+            if (host.size() > 2 && host.front() == '[' && host.back() == ']') {
+                host = host.substr(1, host.size() - 2);
+            }
+
+            type = tcp ? SOCK_STREAM : SOCK_DGRAM;
+        } else {
+            if (address.empty() || address.size() >= sizeof(sockaddr_un::sun_path)) {
+                throw std::invalid_argument("invalid syslog socket path: \"" + address + "\"");
+            }
+
+            path = address;
+        }
+
+        connect();
+    }
+
+    ~transport_t() {
+        if (fd != -1) {
+            ::close(fd);
+        }
+    }
+
+    auto stream() const noexcept -> bool {
+        return type == SOCK_STREAM;
+    }
+
+    auto remote() const noexcept -> bool {
+        return path.empty();
+    }
+
+    /// Sends each frame as a separate datagram.
+    auto send(struct iovec* iov, std::size_t frames) -> void {
+#ifdef __linux__
+        struct mmsghdr headers[max_batch];
+
+        while (frames > 0) {
+            const auto chunk = std::min(frames, max_batch);
+
+            for (std::size_t id = 0; id < chunk; ++id) {
+                std::memset(&headers[id], 0, sizeof(headers[id]));
+                headers[id].msg_hdr.msg_iov = iov + id * slices;
+                headers[id].msg_hdr.msg_iovlen = slices;
+            }
+
+            const auto rc = ::sendmmsg(fd, headers, static_cast<unsigned int>(chunk), 0);
+
+            if (rc < 0) {
+                if (!recoverable(errno)) {
+                    throw std::system_error(errno, std::system_category(), "failed to send");
+                }
+
+                continue;
+            }
+
+            iov += static_cast<std::size_t>(rc) * slices;
+            frames -= static_cast<std::size_t>(rc);
+        }
+#else
+        for (std::size_t id = 0; id < frames; ++id) {
+            struct msghdr header;
+            std::memset(&header, 0, sizeof(header));
+            header.msg_iov = iov + id * slices;
+            header.msg_iovlen = slices;
+
+            while (::sendmsg(fd, &header, 0) < 0) {
+                if (!recoverable(errno)) {
+                    throw std::system_error(errno, std::system_category(), "failed to send");
+                }
+            }
+        }
+#endif
+    }
+
+    /// Writes the given slices into the stream, retrying on partial writes.
+    auto write(struct iovec* iov, std::size_t size) -> void {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        while (size > 0) {
+            const auto chunk = std::min<std::size_t>(size, IOV_MAX);
+            const auto rc = ::writev(fd, iov, static_cast<int>(chunk));
+
+            if (rc < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+
+                throw std::system_error(errno, std::system_category(), "failed to write");
+            }
+
+            auto written = static_cast<std::size_t>(rc);
+            while (size > 0 && written >= iov->iov_len) {
+                written -= iov->iov_len;
+                ++iov;
+                --size;
+            }
+
+            if (written > 0) {
+                iov->iov_base = static_cast<char*>(iov->iov_base) + written;
+                iov->iov_len -= written;
+            }
+        }
+    }
+
+private:
+    auto connect() -> void {
+        if (path.empty()) {
+            struct addrinfo hints;
+            std::memset(&hints, 0, sizeof(hints));
+            hints.ai_family = AF_UNSPEC;
+            hints.ai_socktype = type;
+            hints.ai_flags = AI_NUMERICSERV;
+
+            struct addrinfo* result = nullptr;
+            if (const auto rc = ::getaddrinfo(host.c_str(), port.c_str(), &hints, &result)) {
+                throw std::system_error(EHOSTUNREACH, std::system_category(),
+                    "failed to resolve '" + host + "': " + ::gai_strerror(rc));
+            }
+
+            std::unique_ptr<struct addrinfo, decltype(&::freeaddrinfo)> guard(result, &::freeaddrinfo);
+
+            int ec = 0;
+            for (auto it = result; it != nullptr; it = it->ai_next) {
+                const auto fd = ::socket(it->ai_family, it->ai_socktype, it->ai_protocol);
+                if (fd == -1) {
+                    ec = errno;
+                    continue;
+                }
+
+                if (::connect(fd, it->ai_addr, it->ai_addrlen) == 0) {
+                    this->fd = fd;
+                    return;
+                }
+
+                ec = errno;
+                ::close(fd);
+            }
+
+            throw std::system_error(ec, std::system_category(), "failed to connect");
+        }
+
+        struct sockaddr_un address;
+        std::memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        std::memcpy(address.sun_path, path.data(), path.size());
 
-syslog_t::syslog_t() {
+        const auto fd = ::socket(AF_UNIX, SOCK_DGRAM, 0);
+        if (fd == -1) {
+            throw std::system_error(errno, std::system_category(), "failed to create socket");
+        }
+
+        if (::connect(fd, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) != 0) {
+            const auto ec = errno;
+            ::close(fd);
+            throw std::system_error(ec, std::system_category(), "failed to connect to '" + path + "'");
+        }
+
+        this->fd = fd;
+    }
+
+    /// Checks whether the datagram can be sent again, reconnecting the local socket if the daemon
+    /// has been restarted.
+    auto recoverable(int ec) -> bool {
+        if (ec == EINTR) {
+            return true;
+        }
+
+        if (!path.empty() && (ec == ECONNREFUSED || ec == ENOTCONN)) {
+            std::lock_guard<std::mutex> lock(mutex);
+
+            struct sockaddr_un address;
+            std::memset(&address, 0, sizeof(address));
+            address.sun_family = AF_UNIX;
+            std::memcpy(address.sun_path, path.data(), path.size());
+
+            return ::connect(fd, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) == 0;
+        }
+
+        return false;
+    }
+};
+
+syslog_t::syslog_t() :
+    format_(format_t::rfc3164)
+{
    data.option = LOG_PID;
    data.facility = LOG_USER;
    data.identity = detail::procname().to_string();
@@ -22,10 +327,28 @@ syslog_t::syslog_t() {
    ::openlog(identity().c_str(), option(), facility());
 }
 
+syslog_t::syslog_t(std::string address, format_t format) :
+    address_(std::move(address)),
+    format_(format),
+    transport(new transport_t(address_))
+{
+    data.option = LOG_PID;
+    data.facility = LOG_USER;
+    data.identity = detail::procname().to_string();
+
+    precompute();
+}
+
+syslog_t::syslog_t(syslog_t&& other) = default;
+
 syslog_t::~syslog_t() {
-    ::closelog();
+    if (address_.empty()) {
+        ::closelog();
+    }
 }
 
+auto syslog_t::operator=(syslog_t&& other) -> syslog_t& = default;
+
 auto syslog_t::option() const noexcept -> int {
     return data.option;
 }
@@ -44,9 +367,26 @@ auto syslog_t::priorities() const -> std::vector<int> {
 
 auto syslog_t::priorities(std::vector<int> priorities) -> void {
     data.priorities = std::move(priorities);
+
+    if (transport) {
+        precompute();
+    }
+}
+
+auto syslog_t::address() const noexcept -> const std::string& {
+    return address_;
+}
+
+auto syslog_t::format() const noexcept -> format_t {
+    return format_;
 }
 
 auto syslog_t::emit(const record_t& record, const string_view& formatted) -> void {
+    if (transport) {
+        const event_t event{&record, &formatted};
+        return emit_batch(&event, 1);
+    }
+
     const auto severity = static_cast<std::size_t>(record.severity());
 
     int priority;
@@ -59,6 +399,83 @@ auto syslog_t::emit(const record_t& record, const string_view& formatted) -> voi
     ::syslog(priority, "%.*s", static_cast<int>(formatted.size()), formatted.data());
 }
 
+auto syslog_t::emit_batch(const event_t* events, std::size_t size) -> void {
+    if (!transport) {
+        return sink_t::emit_batch(events, size);
+    }
+
+    thread_local timestamp_t timestamp;
+
+    const auto stream = transport->stream();
+    const auto stride = stream ? slices + 1 : slices;
+
+    boost::container::small_vector<struct iovec, 16 * (slices + 1)> iov(size * stride);
+    // Per-frame storage for time stamps and octet counting prefixes, which must outlive the write,
+    // while the formatted time stamp is cached per thread.
+    boost::container::small_vector<scratch_t, 16> scratch(size);
+
+    for (std::size_t id = 0; id < size; ++id) {
+        const auto& header = headers[priority(*events[id].record)];
+        const auto time = timestamp.get(*events[id].record, format_);
+        const auto& message = *events[id].message;
+
+        std::memcpy(scratch[id].time, time.data(), time.size());
+
+        auto slice = &iov[id * stride];
+
+        if (stream) {
+            const auto length = header.size() + time.size() + trailer.size() + message.size();
+            const auto rc = std::snprintf(scratch[id].prefix, sizeof(scratch[id].prefix), "%zu ",
+                length);
+
+            *slice++ = {scratch[id].prefix, static_cast<std::size_t>(rc)};
+        }
+
+        *slice++ = {const_cast<char*>(header.data()), header.size()};
+        *slice++ = {scratch[id].time, time.size()};
+        *slice++ = {const_cast<char*>(trailer.data()), trailer.size()};
+        *slice++ = {const_cast<char*>(message.data()), message.size()};
+    }
+
+    if (stream) {
+        transport->write(iov.data(), iov.size());
+    } else {
+        transport->send(iov.data(), size);
+    }
+}
+
+auto syslog_t::priority(const record_t& record) const noexcept -> std::size_t {
+    const auto severity = static_cast<std::size_t>(record.severity());
+
+    return severity < data.priorities.size() ? severity : data.priorities.size();
+}
+
+auto syslog_t::precompute() -> void {
+    headers.clear();
+
+    const auto header = [&](int priority) -> std::string {
+        const auto pri = "<" + boost::lexical_cast<std::string>(data.facility | priority) + ">";
+        return format_ == format_t::rfc5424 ? pri + "1 " : pri;
+    };
+
+    for (auto priority : data.priorities) {
+        headers.emplace_back(header(priority));
+    }
+
+    headers.emplace_back(header(LOG_ERR));
+
+    const auto pid = boost::lexical_cast<std::string>(::getpid());
+
+    if (format_ == format_t::rfc5424) {
+        trailer = " " + hostname() + " " + data.identity + " " + pid + " - - ";
+    } else if (transport->remote()) {
+        trailer = " " + hostname() + " " + data.identity + "[" + pid + "]: ";
+    } else {
+        // The local daemon fills the host name in itself, like libc does.
+        trailer = " " + data.identity + "[" + pid + "]: ";
+    }
+}
+
 }  // namespace sink
 
 auto factory<sink::syslog_t>::type() const noexcept -> const char* {
@@ -67,15 +484,30 @@ auto factory<sink::syslog_t>::type() const noexcept -> const char* {
 
 auto factory<sink::syslog_t>::from(const config::node_t& config) const -> std::unique_ptr<sink_t> {
     (void)registry;
-    sink::syslog_t syslog;
 
+    boost::optional<std::vector<int>> priorities;
     if (auto mapping = config["priorities"]) {
-        std::vector<int> priorities;
+        priorities = std::vector<int>();
         mapping.each([&](const config::node_t& config) {
-            priorities.emplace_back(config.to_sint64());
+            priorities->emplace_back(config.to_sint64());
         });
+    }
+
+    auto format = sink::syslog_t::format_t::rfc3164;
+    const auto address = config["address"].to_string();
+
+    if (auto value = config["format"].to_string()) {
+        if (value.get() == "rfc5424") {
+            format = sink::syslog_t::format_t::rfc5424;
+        } else if (value.get() != "rfc3164") {
+            throw std::invalid_argument("unknown syslog format: \"" + value.get() + "\"");
+        }
+    }
+
+    auto syslog = address ? sink::syslog_t(address.get(), format) : sink::syslog_t();
 
-        syslog.priorities(std::move(priorities));
+    if (priorities) {
+        syslog.priorities(std::move(priorities.get()));
     }
 
     return std::unique_ptr<sink_t>(new sink::syslog_t(std::move(syslog)));
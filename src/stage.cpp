@@ -0,0 +1,163 @@
+#include "blackhole/stage.hpp"
+
+#include <atomic>
+
+#include "blackhole/clock.hpp"
+#include "blackhole/metrics.hpp"
+
+#include "blackhole/detail/stage.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace {
+
+using stage::id_t;
+
+/// Sampling state of the calling thread.
+struct state_t {
+    /// Records left until the next sampled one.
+    std::size_t countdown;
+    /// Whether the record being logged is sampled.
+    bool active;
+    /// Whether writing the sampled record is stamped by an asynchronous consumer.
+    bool deferred;
+    /// Counter reading the current stage started at.
+    std::uint64_t last;
+};
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wglobal-constructors"
+#pragma clang diagnostic ignored "-Wexit-time-destructors"
+
+std::atomic<std::size_t> period(0);
+
+metrics::histogram_t histograms[stage::count];
+
+#pragma clang diagnostic pop
+
+thread_local state_t state{0, false, false, 0};
+
+}  // namespace
+
+namespace stage {
+
+auto sample(std::size_t every) -> void {
+    if (every != 0) {
+        clock::prepare(clock_source_t::tsc);
+    }
+
+    period.store(every, std::memory_order_relaxed);
+}
+
+auto sampling() noexcept -> std::size_t {
+    return period.load(std::memory_order_relaxed);
+}
+
+auto name(id_t stage) noexcept -> const char* {
+    switch (stage) {
+    case id_t::capture:
+        return "capture";
+    case id_t::filter:
+        return "filter";
+    case id_t::format:
+        return "format";
+    case id_t::enqueue:
+        return "enqueue";
+    case id_t::queue:
+        return "queue";
+    case id_t::write:
+        return "write";
+    }
+
+    return "unknown";
+}
+
+auto histogram(id_t stage) noexcept -> const metrics::histogram_t& {
+    return histograms[static_cast<std::size_t>(stage)];
+}
+
+auto collect(metrics::collector_t& collector) -> void {
+    if (sampling() == 0) {
+        return;
+    }
+
+    for (std::size_t id = 0; id < count; ++id) {
+        const auto stage = static_cast<id_t>(id);
+        collector.with("stage", name(stage)).histogram("blackhole_stage_seconds",
+            histogram(stage));
+    }
+}
+
+}  // namespace stage
+
+namespace detail {
+namespace stage {
+
+auto active() noexcept -> bool {
+    return state.active;
+}
+
+auto mark() noexcept -> void {
+    if (state.active) {
+        state.last = clock::ticks();
+    }
+}
+
+auto stamp(id_t stage) noexcept -> void {
+    if (state.active) {
+        const auto now = clock::ticks();
+        record(stage, now - state.last);
+        state.last = now;
+    }
+}
+
+auto defer() noexcept -> void {
+    state.deferred = state.active;
+}
+
+auto written() noexcept -> void {
+    if (!state.deferred) {
+        stamp(id_t::write);
+    }
+}
+
+auto record(id_t stage, std::uint64_t ticks) noexcept -> void {
+    histograms[static_cast<std::size_t>(stage)].record(clock::nanoseconds(ticks));
+}
+
+scope_t::scope_t() noexcept :
+    sampled(false)
+{
+    // Nested records, logged by handlers while handling the outer one, are never sampled.
+    if (state.active) {
+        return;
+    }
+
+    const auto every = period.load(std::memory_order_relaxed);
+    if (every == 0) {
+        return;
+    }
+
+    if (state.countdown == 0 || state.countdown > every) {
+        state.countdown = every;
+    }
+
+    if (--state.countdown == 0) {
+        sampled = true;
+        state.active = true;
+        state.deferred = false;
+        state.last = clock::ticks();
+    }
+}
+
+scope_t::~scope_t() {
+    if (sampled) {
+        state.active = false;
+        state.deferred = false;
+    }
+}
+
+}  // namespace stage
+}  // namespace detail
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,15 @@
+#include "blackhole/thread.hpp"
+
+#include "blackhole/detail/process.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace thread {
+
+auto invalidate_names() noexcept -> void {
+    detail::this_thread::invalidate_names();
+}
+
+}  // namespace thread
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,53 @@
+#include "blackhole/trace.hpp"
+
+#include "blackhole/detail/trace.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace trace {
+namespace {
+
+thread_local trace_t context = {0, 0, 0};
+
+}  // namespace
+
+auto current() noexcept -> const trace_t& {
+    return context;
+}
+
+auto reset(const trace_t& value) noexcept -> void {
+    context = value;
+}
+
+}  // namespace trace
+
+namespace detail {
+namespace trace {
+namespace {
+
+auto hex(std::uint64_t value, char* buffer) noexcept -> void {
+    constexpr char digits[] = "0123456789abcdef";
+
+    for (int id = 15; id >= 0; --id) {
+        buffer[id] = digits[value & 0xf];
+        value >>= 4;
+    }
+}
+
+}  // namespace
+
+auto trace_id(const trace_t& trace, char (&buffer)[32]) noexcept -> string_view {
+    hex(trace.hi, buffer);
+    hex(trace.lo, buffer + 16);
+    return {buffer, sizeof(buffer)};
+}
+
+auto span_id(const trace_t& trace, char (&buffer)[16]) noexcept -> string_view {
+    hex(trace.span, buffer);
+    return {buffer, sizeof(buffer)};
+}
+
+}  // namespace trace
+}  // namespace detail
+}  // namespace v1
+}  // namespace blackhole
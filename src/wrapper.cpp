@@ -6,13 +6,17 @@ inline namespace v1 {
 using attribute::view_t;
 
 wrapper_t::wrapper_t(logger_t& log, attributes_t attributes):
-    inner(log),
-    storage(std::move(attributes))
+    inner(unwrap(log)),
+    storage(into_compact(std::move(attributes), functions))
 {
-    // TODO: Replace somewhere near `view_of`.
-    for (const auto& attribute : storage) {
-        attributes_view.emplace_back(attribute);
-    }
+    compose(log);
+}
+
+wrapper_t::wrapper_t(logger_t& log, std::initializer_list<compact_attribute_t> attributes):
+    inner(unwrap(log)),
+    storage(attributes.begin(), attributes.end())
+{
+    compose(log);
 }
 
 auto wrapper_t::log(severity_t severity, const message_t& message) -> void {
@@ -34,5 +38,102 @@ auto wrapper_t::manager() -> scope::manager_t& {
     return inner.manager();
 }
 
+auto wrapper_t::unwrap(logger_t& log) -> logger_t& {
+    if (const auto wrapper = dynamic_cast<wrapper_t*>(&log)) {
+        return wrapper->inner;
+    }
+
+    return log;
+}
+
+auto wrapper_t::compose(const logger_t& log) -> void {
+    const auto wrapper = dynamic_cast<const wrapper_t*>(&log);
+
+    attributes_view.reserve(storage.size() + (wrapper ? wrapper->attributes().size() : 0));
+
+    for (const auto& attribute : storage) {
+        attributes_view.emplace_back(attribute.first, attribute.second.view());
+    }
+
+    if (wrapper) {
+        const auto& rest = wrapper->attributes();
+        attributes_view.insert(attributes_view.end(), rest.begin(), rest.end());
+    }
+}
+
+namespace {
+
+auto into_views(const compact_attributes_t& attributes) -> view_of<attributes_t>::type {
+    view_of<attributes_t>::type result;
+    result.reserve(attributes.size());
+
+    for (const auto& attribute : attributes) {
+        result.emplace_back(attribute.first, attribute.second.view());
+    }
+
+    return result;
+}
+
+}  // namespace
+
+compact_wrapper_t::compact_wrapper_t(logger_t& log, attributes_t attributes):
+    inner(unwrap(log)),
+    block(into_views(into_compact(std::move(attributes), functions)), parent(log))
+{}
+
+compact_wrapper_t::compact_wrapper_t(logger_t& log,
+    std::initializer_list<compact_attribute_t> attributes):
+    inner(unwrap(log)),
+    block(into_views(compact_attributes_t(attributes.begin(), attributes.end())), parent(log))
+{}
+
+auto compact_wrapper_t::log(severity_t severity, const message_t& message) -> void {
+    view_of<attributes_t>::type attributes;
+    block.append(attributes);
+
+    attribute_pack pack{attributes};
+    inner.log(severity, message, pack);
+}
+
+auto compact_wrapper_t::log(severity_t severity, const message_t& message, attribute_pack& pack) ->
+    void
+{
+    view_of<attributes_t>::type attributes;
+    block.append(attributes);
+
+    pack.push_back(attributes);
+    inner.log(severity, message, pack);
+}
+
+auto compact_wrapper_t::log(severity_t severity, const lazy_message_t& message,
+    attribute_pack& pack) -> void
+{
+    view_of<attributes_t>::type attributes;
+    block.append(attributes);
+
+    pack.push_back(attributes);
+    inner.log(severity, message, pack);
+}
+
+auto compact_wrapper_t::manager() -> scope::manager_t& {
+    return inner.manager();
+}
+
+auto compact_wrapper_t::unwrap(logger_t& log) -> logger_t& {
+    if (const auto wrapper = dynamic_cast<compact_wrapper_t*>(&log)) {
+        return wrapper->inner;
+    }
+
+    return log;
+}
+
+auto compact_wrapper_t::parent(const logger_t& log) -> attribute::block_t {
+    if (const auto wrapper = dynamic_cast<const compact_wrapper_t*>(&log)) {
+        return wrapper->block;
+    }
+
+    return attribute::block_t();
+}
+
 }  // namespace v1
 }  // namespace blackhole
@@ -1,11 +1,22 @@
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <utility>
+
 #include <gtest/gtest.h>
 
 #include <boost/variant/apply_visitor.hpp>
 
 #include <blackhole/attribute.hpp>
+#include <blackhole/attribute/backtrace.hpp>
+#include <blackhole/attribute/block.hpp>
+#include <blackhole/attribute/compact.hpp>
+#include <blackhole/attribute/key.hpp>
 #include "blackhole/extensions/writer.hpp"
 
+#include <blackhole/record.hpp>
 #include <blackhole/detail/attribute.hpp>
+#include <blackhole/detail/recordbuf.hpp>
 
 namespace {
 
@@ -32,6 +43,10 @@ namespace blackhole {
 namespace testing {
 namespace attribute {
 
+using ::blackhole::attribute::backtrace_t;
+using ::blackhole::attribute::block_t;
+using ::blackhole::attribute::compact_t;
+using ::blackhole::attribute::key_t;
 using ::blackhole::attribute::value_t;
 using ::blackhole::attribute::view_t;
 
@@ -162,6 +177,62 @@ TEST(view_t, FromUserType) {
 
 namespace {
 
+/// Writes the given text, counting its own copies.
+struct counted_t {
+    std::string text;
+    int* copies;
+
+    counted_t(std::string text, int* copies) :
+        text(std::move(text)),
+        copies(copies)
+    {}
+
+    counted_t(const counted_t& other) :
+        text(other.text),
+        copies(other.copies)
+    {
+        ++*copies;
+    }
+
+    auto operator()(writer_t& wr) const -> void {
+        wr.write("{}", text);
+    }
+};
+
+}  // namespace
+
+TEST(view_t, FromCallableReference) {
+    int copies = 0;
+    const counted_t fn("le function", &copies);
+
+    view_t v(view_t::function_type::ref(fn));
+
+    writer_t wr;
+    blackhole::attribute::get<view_t::function_type>(v)(wr);
+    blackhole::attribute::get<view_t::function_type>(v)(wr);
+
+    EXPECT_EQ("le functionle function", wr.result().to_string());
+    EXPECT_EQ(0, copies);
+}
+
+TEST(view_t, InvokesOwnedFunctionsByReference) {
+    int copies = 0;
+    value_t value;
+    value.inner().value = value_t::function_type(counted_t("le function", &copies));
+    const auto constructed = copies;
+
+    view_t v(value);
+
+    writer_t wr;
+    blackhole::attribute::get<view_t::function_type>(v)(wr);
+    blackhole::attribute::get<view_t::function_type>(v)(wr);
+
+    EXPECT_EQ("le functionle function", wr.result().to_string());
+    EXPECT_EQ(constructed, copies);
+}
+
+namespace {
+
 struct visitor_t : public boost::static_visitor<bool> {
     auto operator()(std::nullptr_t) const -> bool {
         return true;
@@ -334,6 +405,227 @@ TEST(value_t, Visitor) {
     EXPECT_EQ(42, visitor.value);
 }
 
+TEST(compact_t, Size) {
+    EXPECT_EQ(24, sizeof(compact_t));
+}
+
+TEST(compact_t, Default) {
+    compact_t v;
+
+    EXPECT_EQ(nullptr, blackhole::attribute::get<std::nullptr_t>(v.view()));
+}
+
+TEST(compact_t, FromPrimitives) {
+    EXPECT_EQ(true, blackhole::attribute::get<bool>(compact_t(true).view()));
+    EXPECT_EQ(-42, blackhole::attribute::get<std::int64_t>(compact_t(-42).view()));
+    EXPECT_EQ(42, blackhole::attribute::get<std::uint64_t>(compact_t(42u).view()));
+    EXPECT_EQ(42.5, blackhole::attribute::get<double>(compact_t(42.5).view()));
+}
+
+TEST(compact_t, FromShortString) {
+    const std::string value("le message");
+    compact_t v(value);
+
+    const auto actual = blackhole::attribute::get<string_view>(v.view());
+
+    EXPECT_EQ("le message", actual.to_string());
+    EXPECT_NE(value.data(), actual.data());
+}
+
+TEST(compact_t, FromLongString) {
+    const std::string value(64, 'x');
+    compact_t v(value);
+
+    EXPECT_EQ(value, blackhole::attribute::get<string_view>(v.view()).to_string());
+}
+
+TEST(compact_t, CopyOwnsStrings) {
+    std::unique_ptr<compact_t> source(new compact_t(std::string(64, 'x')));
+    compact_t small("le message");
+
+    const compact_t copy(*source);
+    small = *source;
+    source.reset();
+
+    EXPECT_EQ(std::string(64, 'x'), blackhole::attribute::get<string_view>(copy.view()).to_string());
+    EXPECT_EQ(copy, small);
+}
+
+TEST(compact_t, MoveTransfersLongString) {
+    compact_t source(std::string(64, 'x'));
+    const auto data = blackhole::attribute::get<string_view>(source.view()).data();
+
+    const compact_t moved(std::move(source));
+
+    EXPECT_EQ(data, blackhole::attribute::get<string_view>(moved.view()).data());
+}
+
+TEST(compact_t, FromFunctionRefersValue) {
+    const user_t user{"Ivan"};
+    const compact_t v(view_t{user});
+
+    writer_t wr;
+    blackhole::attribute::get<view_t::function_type>(v.view())(wr);
+
+    EXPECT_EQ("user_t(name: Ivan)", wr.result().to_string());
+}
+
+TEST(compact_t, FromValue) {
+    EXPECT_EQ(compact_t(42), compact_t(value_t(42)));
+    EXPECT_EQ(compact_t("le message"), compact_t(value_t("le message")));
+    EXPECT_NE(compact_t(42), compact_t(value_t("le message")));
+}
+
+TEST(block_t, Empty) {
+    const block_t block;
+
+    EXPECT_EQ(0, block.size());
+    EXPECT_EQ(0, block.capacity());
+    EXPECT_TRUE(block.attributes().empty());
+}
+
+TEST(block_t, CopiesKeysAndStrings) {
+    std::string key("key#0");
+    std::string value(64, 'x');
+
+    const block_t block({{key, {value}}, {"key#1", {42}}});
+
+    key[0] = 'K';
+    value[0] = 'X';
+
+    const std::string copied(64, 'x');
+    const attribute_list expected{{"key#0", {copied}}, {"key#1", {42}}};
+    EXPECT_EQ(expected, block.attributes());
+    EXPECT_EQ(2, block.size());
+}
+
+TEST(block_t, HasExactCapacity) {
+    const block_t small(attribute_list{{"id", {42}}});
+    const block_t large(attribute_list{{"id", {42}}, {"name", {"value"}}});
+
+    EXPECT_EQ(sizeof(attribute_list::value_type) + 4 + 5,
+        large.capacity() - small.capacity());
+    EXPECT_LT(small.capacity(), sizeof(attribute_list) / 4);
+}
+
+TEST(block_t, SharesParent) {
+    const block_t parent(attribute_list{{"parent", {"value"}}});
+    const block_t block(attribute_list{{"id", {42}}}, parent);
+
+    EXPECT_EQ(parent.capacity(), block.parent().capacity());
+    EXPECT_EQ(parent.attributes()[0].first.data(), block.attributes()[1].first.data());
+
+    const attribute_list expected{{"id", {42}}, {"parent", {"value"}}};
+    EXPECT_EQ(expected, block.attributes());
+}
+
+TEST(block_t, OutlivesParentHandle) {
+    block_t block;
+    {
+        const block_t parent(attribute_list{{"parent", {"value"}}});
+        block = block_t(attribute_list{{"id", {42}}}, parent);
+    }
+
+    const attribute_list expected{{"id", {42}}, {"parent", {"value"}}};
+    EXPECT_EQ(expected, block.attributes());
+}
+
+TEST(key_t, SameNameSharesEntry) {
+    const std::string name("request_id");
+
+    const key_t k1(name);
+    const key_t k2(string_view("request_id"));
+
+    EXPECT_EQ(k1, k2);
+    EXPECT_EQ(k1.id(), k2.id());
+    EXPECT_EQ(k1.name().data(), k2.name().data());
+    EXPECT_NE(name.data(), k1.name().data());
+    EXPECT_EQ("request_id", k1.name().to_string());
+}
+
+TEST(key_t, DifferentNamesDiffer) {
+    const key_t k1(string_view("key#1"));
+    const key_t k2(string_view("key#2"));
+
+    EXPECT_NE(k1, k2);
+    EXPECT_NE(k1.id(), k2.id());
+}
+
+TEST(key_t, HashMatchesStringViewHash) {
+    const key_t key(string_view("request_id"));
+
+    EXPECT_EQ(std::hash<string_view>()(string_view("request_id")), key.hash());
+}
+
+TEST(key_t, Macro) {
+    BH_ATTR_KEY(trace_id);
+
+    EXPECT_EQ(key_t(string_view("trace_id")), trace_id);
+
+    const attribute_list attributes{{trace_id, {42}}};
+    EXPECT_EQ(trace_id.name().data(), attributes[0].first.data());
+}
+
+TEST(backtrace_t, Empty) {
+    const backtrace_t backtrace;
+
+    writer_t writer;
+    backtrace.format(writer);
+
+    EXPECT_EQ(0, backtrace.size());
+    EXPECT_EQ("", writer.result().to_string());
+}
+
+TEST(backtrace_t, Capture) {
+    const auto backtrace = backtrace_t::capture();
+    const auto skipped = backtrace_t::capture(1);
+
+    ASSERT_LT(1, backtrace.size());
+    EXPECT_LE(backtrace.size(), backtrace_t::capacity);
+    EXPECT_EQ(backtrace.size() - 1, skipped.size());
+
+    writer_t writer;
+    backtrace.format(writer);
+
+    EXPECT_NE(std::string::npos, writer.result().to_string().find(" <- "));
+}
+
+TEST(backtrace_t, SymbolizesExportedFunctions) {
+    const auto address = reinterpret_cast<const char*>(&std::abort) + 1;
+
+    EXPECT_EQ(0, ::blackhole::attribute::symbolize(address).find("abort+0x1"));
+    EXPECT_EQ(::blackhole::attribute::symbolize(address),
+        ::blackhole::attribute::symbolize(address));
+}
+
+TEST(backtrace_t, IsCopiedIntoOwnedRecords) {
+    std::unique_ptr<detail::recordbuf_t> result;
+    std::string expected;
+
+    {
+        const auto backtrace = backtrace_t::capture();
+
+        writer_t writer;
+        backtrace.format(writer);
+        expected = writer.result().to_string();
+
+        const string_view message("");
+        const attribute_list attributes{{"backtrace", backtrace}};
+        const attribute_pack pack{attributes};
+        const record_t record(0, message, pack);
+
+        result.reset(new detail::recordbuf_t(record));
+    }
+
+    const auto& attributes = result->into_view().attributes().at(0).get();
+    ASSERT_EQ(1, attributes.size());
+
+    writer_t writer;
+    ::blackhole::attribute::get<view_t::function_type>(attributes[0].second)(writer);
+
+    EXPECT_EQ(expected, writer.result().to_string());
+}
+
 }  // namespace attribute
 }  // namespace testing
 }  // namespace blackhole
@@ -0,0 +1,73 @@
+#include <memory>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <blackhole/attribute.hpp>
+#include <blackhole/attributes.hpp>
+#include <blackhole/budget.hpp>
+#include <blackhole/record.hpp>
+#include <blackhole/detail/budget.hpp>
+#include <blackhole/detail/sink/asynchronous.hpp>
+#include <blackhole/detail/sink/shared.hpp>
+
+#include "mocks/sink.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace budget {
+namespace {
+
+using ::testing::_;
+
+using namespace blackhole::testing;
+
+TEST(budget, Unlimited) {
+    EXPECT_EQ(0, limit());
+    EXPECT_TRUE(detail::budget::admit());
+}
+
+TEST(budget, CapturedRecordsAreAccounted) {
+    const auto before = used();
+
+    {
+        const string_view message("le message");
+        const attribute_pack pack;
+        record_t record(0, message, pack);
+
+        const auto value = sink::shared_record_t::capture(record, message);
+
+        EXPECT_GE(used(), before + 1024);
+    }
+
+    EXPECT_EQ(before, used());
+}
+
+TEST(budget, ExhaustedBudgetDropsRecords) {
+    std::unique_ptr<mock::sink_t> wrapped(new mock::sink_t);
+    EXPECT_CALL(*wrapped, emit(_, _))
+        .Times(0);
+
+    sink::asynchronous_t sink(std::move(wrapped), 4,
+        sink::overflow_policy_factory_t().create("drop"));
+
+    const auto rejected = budget::rejected();
+
+    limit(1);
+    detail::budget::charge(1);
+
+    const string_view message("le message");
+    const attribute_pack pack;
+    record_t record(0, message, pack);
+    sink.emit(record, message);
+
+    detail::budget::release(1);
+    limit(0);
+
+    EXPECT_EQ(rejected + 1, budget::rejected());
+}
+
+}  // namespace
+}  // namespace budget
+}  // namespace v1
+}  // namespace blackhole
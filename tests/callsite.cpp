@@ -0,0 +1,162 @@
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <blackhole/callsite.hpp>
+
+namespace blackhole {
+namespace testing {
+
+namespace {
+
+struct logger_t {
+    std::vector<std::string> patterns;
+
+    template<typename... Args>
+    auto log(int, const char* pattern, const Args&...) -> void {
+        patterns.push_back(pattern);
+    }
+};
+
+auto emit(logger_t& logger, int& evaluated) -> void {
+    BH_DYNAMIC_LOG(logger, 0, "cache miss for {}", ++evaluated);
+}
+
+auto emit_other(logger_t& logger) -> void {
+    BH_DYNAMIC_LOG(logger, 0, "connection refused");
+}
+
+auto emit_later(logger_t& logger) -> void {
+    BH_DYNAMIC_LOG(logger, 0, "registered later");
+}
+
+}  // namespace
+
+TEST(callsite, DisabledByDefault) {
+    callsite::reset();
+
+    logger_t logger;
+    int evaluated = 0;
+
+    emit(logger, evaluated);
+    emit(logger, evaluated);
+
+    EXPECT_TRUE(logger.patterns.empty());
+    EXPECT_EQ(0, evaluated);
+}
+
+TEST(callsite, EnableByPattern) {
+    callsite::reset();
+
+    logger_t logger;
+    int evaluated = 0;
+
+    emit(logger, evaluated);
+    emit_other(logger);
+
+    callsite::query_t query;
+    query.pattern = "cache miss";
+    EXPECT_EQ(1, callsite::set(query, true));
+
+    emit(logger, evaluated);
+    emit_other(logger);
+
+    EXPECT_EQ((std::vector<std::string>{"cache miss for {}"}), logger.patterns);
+    EXPECT_EQ(1, evaluated);
+
+    callsite::set(query, false);
+    emit(logger, evaluated);
+    EXPECT_EQ(1, logger.patterns.size());
+}
+
+TEST(callsite, RulesApplyToSitesRegisteredLater) {
+    callsite::reset();
+
+    callsite::query_t query;
+    query.function = "emit_later";
+    callsite::set(query, true);
+
+    logger_t logger;
+    emit_later(logger);
+
+    EXPECT_EQ((std::vector<std::string>{"registered later"}), logger.patterns);
+}
+
+TEST(callsite, LaterRulesTakePrecedence) {
+    callsite::reset();
+
+    logger_t logger;
+    emit_other(logger);
+
+    EXPECT_LE(1, callsite::apply("file=callsite.cpp +"));
+    EXPECT_EQ(1, callsite::apply("format=\"connection refused\" -"));
+
+    emit_other(logger);
+    EXPECT_TRUE(logger.patterns.empty());
+}
+
+TEST(callsite, Each) {
+    logger_t logger;
+    emit_other(logger);
+
+    std::vector<std::string> functions;
+    callsite::each([&](const callsite::site_t& site) {
+        functions.push_back(site.function());
+    });
+
+    EXPECT_NE(std::find(functions.begin(), functions.end(), "emit_other"), functions.end());
+}
+
+TEST(callsite, ApplyThrowsOnMalformedCommand) {
+    EXPECT_THROW(callsite::apply(""), std::invalid_argument);
+    EXPECT_THROW(callsite::apply("file=a.cpp"), std::invalid_argument);
+    EXPECT_THROW(callsite::apply("file +"), std::invalid_argument);
+    EXPECT_THROW(callsite::apply("module=a +"), std::invalid_argument);
+    EXPECT_THROW(callsite::apply("line=abc +"), std::invalid_argument);
+    EXPECT_THROW(callsite::apply("format=\"unterminated +"), std::invalid_argument);
+}
+
+TEST(callsite, Control) {
+    callsite::reset();
+
+    logger_t logger;
+    emit_other(logger);
+
+    const std::string path = "/tmp/blackhole-callsite-" + std::to_string(::getpid()) + ".sock";
+    callsite::control_t control(path);
+
+    const auto fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    ASSERT_GE(fd, 0);
+
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    path.copy(address.sun_path, path.size());
+    ASSERT_EQ(0, ::connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)));
+
+    const std::string commands = "func=emit_other +\nfile +\n";
+    ASSERT_EQ(static_cast<ssize_t>(commands.size()), ::write(fd, commands.data(), commands.size()));
+
+    std::string reply;
+    char data[256];
+    while (std::count(reply.begin(), reply.end(), '\n') < 2) {
+        const auto size = ::read(fd, data, sizeof(data));
+        ASSERT_GT(size, 0);
+        reply.append(data, static_cast<std::size_t>(size));
+    }
+
+    ::close(fd);
+
+    EXPECT_EQ("1\nerror: expected 'field=value', got 'file'\n", reply);
+
+    emit_other(logger);
+    EXPECT_EQ((std::vector<std::string>{"connection refused"}), logger.patterns);
+}
+
+}  // namespace testing
+}  // namespace blackhole
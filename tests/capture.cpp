@@ -0,0 +1,189 @@
+#include <string>
+
+#include <boost/variant/get.hpp>
+
+#include <gtest/gtest.h>
+
+#include <blackhole/attribute.hpp>
+#include <blackhole/attributes.hpp>
+#include <blackhole/capture.hpp>
+#include <blackhole/extensions/writer.hpp>
+#include <blackhole/record.hpp>
+#include <blackhole/detail/attribute.hpp>
+#include <blackhole/detail/capture.hpp>
+#include <blackhole/detail/recordbuf.hpp>
+
+namespace {
+
+struct text_t {
+    std::string value;
+};
+
+}  // namespace
+
+namespace blackhole {
+inline namespace v1 {
+
+template<>
+struct display_traits<text_t> {
+    static auto apply(const text_t& text, writer_t& wr) -> void {
+        wr.write("{}", text.value);
+    }
+};
+
+namespace capture {
+namespace {
+
+/// Sets capture limits for the lifetime of a test, removing them afterwards.
+class scoped_limits_t {
+public:
+    scoped_limits_t(std::size_t message, std::size_t value, std::size_t attributes) {
+        limits_t limits;
+        limits.message = message;
+        limits.value = value;
+        limits.attributes = attributes;
+        limit(limits);
+    }
+
+    ~scoped_limits_t() {
+        limit(limits_t());
+    }
+};
+
+auto find(const record_t& record, const string_view& key) -> std::string {
+    for (const auto& list : record.attributes()) {
+        for (const auto& kv : list.get()) {
+            if (!(kv.first == key)) {
+                continue;
+            }
+
+            const auto& value = kv.second.inner().value;
+
+            if (auto string = boost::get<attribute::view_t::string_type>(&value)) {
+                return string->to_string();
+            }
+
+            if (auto number = boost::get<std::uint64_t>(&value)) {
+                return std::to_string(*number);
+            }
+
+            return "<other>";
+        }
+    }
+
+    return "<none>";
+}
+
+auto count(const record_t& record) -> std::size_t {
+    std::size_t result = 0;
+    for (const auto& list : record.attributes()) {
+        result += list.get().size();
+    }
+
+    return result;
+}
+
+TEST(capture, Unlimited) {
+    EXPECT_EQ(0, limits().message);
+    EXPECT_EQ(0, limits().value);
+    EXPECT_EQ(0, limits().attributes);
+}
+
+TEST(capture, CutKeepsCharactersWhole) {
+    // "ж" takes two bytes.
+    const string_view value("abж");
+
+    EXPECT_EQ(4, detail::capture::cut(value, 10));
+    EXPECT_EQ(4, detail::capture::cut(value, 4));
+    EXPECT_EQ(2, detail::capture::cut(value, 3));
+    EXPECT_EQ(0, detail::capture::cut(value, 0));
+}
+
+TEST(capture, RecordWithinLimitsIsReferredToAsIs) {
+    const scoped_limits_t limits(64, 64, 4);
+
+    const string_view message("le message");
+    const attribute_list attributes{{"key", "value"}};
+    const attribute_pack pack{attributes};
+    record_t record(0, message, pack);
+
+    const detail::capture::bounded_t bounded(record);
+
+    EXPECT_EQ(&record, &bounded.get());
+}
+
+TEST(capture, CutsMessage) {
+    const scoped_limits_t limits(4, 0, 0);
+    const auto before = truncated();
+
+    const string_view message("le message");
+    const attribute_pack pack;
+    record_t record(0, message, pack);
+    record.activate("le formatted message");
+
+    const detail::capture::bounded_t bounded(record);
+    const auto& result = bounded.get();
+
+    EXPECT_EQ("le m", result.message().to_string());
+    EXPECT_EQ(message.data(), result.message().data());
+    EXPECT_EQ("le f...", result.formatted().to_string());
+    EXPECT_EQ(0, result.severity());
+    EXPECT_EQ(before + 1, truncated());
+}
+
+TEST(capture, CutsStringValues) {
+    const scoped_limits_t limits(0, 3, 0);
+
+    const string_view message("le message");
+    const attribute_list attributes{{"short", "abc"}, {"long", "abcdef"}, {"number", 42}};
+    const attribute_pack pack{attributes};
+    record_t record(0, message, pack);
+
+    const detail::capture::bounded_t bounded(record);
+    const auto& result = bounded.get();
+
+    EXPECT_EQ("le message", result.message().to_string());
+    EXPECT_EQ("abc", find(result, "short"));
+    EXPECT_EQ("abc...", find(result, "long"));
+    EXPECT_EQ(3, count(result));
+}
+
+TEST(capture, ElidesAttributes) {
+    const scoped_limits_t limits(0, 0, 2);
+
+    const string_view message("le message");
+    const attribute_list first{{"a", "1"}, {"b", "2"}};
+    const attribute_list second{{"c", "3"}, {"d", "4"}, {"e", "5"}};
+    const attribute_pack pack{first, second};
+    record_t record(0, message, pack);
+
+    const detail::capture::bounded_t bounded(record);
+    const auto& result = bounded.get();
+
+    EXPECT_EQ(3, count(result));
+    EXPECT_EQ("1", find(result, "a"));
+    EXPECT_EQ("2", find(result, "b"));
+    EXPECT_EQ("<none>", find(result, "c"));
+    EXPECT_EQ("3", find(result, "elided"));
+}
+
+TEST(capture, CapturedRecordIsBounded) {
+    const scoped_limits_t limits(0, 4, 0);
+
+    const string_view message("le message");
+    const text_t text{"a very long value"};
+    const attribute_list attributes{{"string", text.value}, {"function", text}};
+    const attribute_pack pack{attributes};
+    record_t record(0, message, pack);
+
+    const detail::recordbuf_t buffer(record);
+    const auto result = buffer.into_view();
+
+    EXPECT_EQ("a ve...", find(result, "string"));
+    EXPECT_EQ("a ve...", find(result, "function"));
+}
+
+}  // namespace
+}  // namespace capture
+}  // namespace v1
+}  // namespace blackhole
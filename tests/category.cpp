@@ -0,0 +1,163 @@
+#include <limits>
+#include <stdexcept>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <blackhole/attribute.hpp>
+#include <blackhole/category.hpp>
+#include <blackhole/handler.hpp>
+#include <blackhole/record.hpp>
+#include <blackhole/root.hpp>
+
+#include "mocks/handler.hpp"
+
+namespace blackhole {
+namespace testing {
+
+using ::testing::Invoke;
+using ::testing::_;
+
+namespace {
+
+auto make_logger(mock::handler_t*& view) -> root_logger_t {
+    std::unique_ptr<mock::handler_t> handler(new mock::handler_t);
+    view = handler.get();
+
+    std::vector<std::unique_ptr<handler_t>> handlers;
+    handlers.push_back(std::move(handler));
+
+    return root_logger_t(std::move(handlers));
+}
+
+}  // namespace
+
+TEST(Category, FollowsLoggerThresholdByDefault) {
+    root_logger_t logger({});
+    logger.threshold(2);
+
+    const auto category = logger.category("db.pool");
+
+    EXPECT_EQ("db.pool", category.name().to_string());
+    EXPECT_FALSE(category.enabled(1));
+    EXPECT_TRUE(category.enabled(2));
+}
+
+TEST(Category, ThresholdReplacesLoggerOne) {
+    root_logger_t logger({});
+    logger.threshold(2);
+
+    const auto category = logger.category("db");
+    logger.threshold("db", 0);
+
+    EXPECT_EQ(0, category.threshold());
+    EXPECT_TRUE(category.enabled(0));
+    EXPECT_FALSE(logger.enabled(0));
+}
+
+TEST(Category, ThresholdPropagatesDownTheHierarchy) {
+    root_logger_t logger({});
+
+    const auto pool = logger.category("db.pool");
+    const auto conn = logger.category("db.pool.conn");
+    const auto rpc = logger.category("rpc");
+
+    logger.threshold("db", 3);
+
+    EXPECT_EQ(3, pool.threshold());
+    EXPECT_EQ(3, conn.threshold());
+    EXPECT_EQ(std::numeric_limits<int>::min(), rpc.threshold());
+
+    logger.threshold("db.pool", 1);
+    logger.threshold("db", 5);
+
+    EXPECT_EQ(1, pool.threshold());
+    EXPECT_EQ(1, conn.threshold());
+    EXPECT_EQ(5, logger.category("db").threshold());
+}
+
+TEST(Category, InheritsParentThresholdAfterReset) {
+    root_logger_t logger({});
+
+    const auto pool = logger.category("db.pool");
+
+    logger.threshold("db", 3);
+    logger.threshold("db.pool", 1);
+    logger.inherit("db.pool");
+
+    EXPECT_EQ(3, pool.threshold());
+
+    logger.inherit("db");
+
+    EXPECT_EQ(std::numeric_limits<int>::min(), pool.threshold());
+    EXPECT_TRUE(pool.enabled(-1));
+}
+
+TEST(Category, NewCategoriesInheritAssignedAncestors) {
+    root_logger_t logger({});
+    logger.threshold("db", 3);
+
+    EXPECT_EQ(3, logger.category("db.pool.conn").threshold());
+}
+
+TEST(Category, ThrowsOnInvalidName) {
+    root_logger_t logger({});
+
+    EXPECT_THROW(logger.category(""), std::invalid_argument);
+    EXPECT_THROW(logger.category(".db"), std::invalid_argument);
+    EXPECT_THROW(logger.category("db."), std::invalid_argument);
+    EXPECT_THROW(logger.category("db..pool"), std::invalid_argument);
+    EXPECT_THROW(logger.threshold("", 0), std::invalid_argument);
+}
+
+TEST(Category, AttachesItsName) {
+    mock::handler_t* view;
+    auto logger = make_logger(view);
+
+    auto category = logger.category("db.pool");
+
+    EXPECT_CALL(*view, handle(_))
+        .Times(1)
+        .WillOnce(Invoke([](const record_t& record) {
+            EXPECT_EQ(1, record.severity());
+
+            const auto& attributes = record.attributes();
+            ASSERT_EQ(1, attributes.size());
+            ASSERT_EQ(1, attributes[0].get().size());
+            EXPECT_EQ("category", attributes[0].get()[0].first);
+            EXPECT_EQ(attribute::view_t("db.pool"), attributes[0].get()[0].second);
+        }));
+
+    category.log(1, "-");
+}
+
+TEST(Category, BypassesLoggerThresholdWhenAssigned) {
+    mock::handler_t* view;
+    auto logger = make_logger(view);
+    logger.threshold(5);
+
+    auto category = logger.category("db");
+    logger.threshold("db", 1);
+
+    EXPECT_CALL(*view, handle(_))
+        .Times(1);
+
+    category.log(0, "-");
+    category.log(1, "-");
+    logger.log(1, "-");
+}
+
+TEST(Category, SurvivesAssignment) {
+    root_logger_t logger({});
+    const auto pool = logger.category("db.pool");
+
+    root_logger_t next({});
+    next.threshold("db", 4);
+
+    logger = std::move(next);
+
+    EXPECT_EQ(4, pool.threshold());
+}
+
+}  // namespace testing
+}  // namespace blackhole
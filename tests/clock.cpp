@@ -0,0 +1,93 @@
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include <blackhole/clock.hpp>
+
+namespace blackhole {
+namespace testing {
+
+namespace {
+
+auto within(clock_source_t source, std::chrono::milliseconds tolerance) -> bool {
+    const auto min = std::chrono::system_clock::now() - tolerance;
+    const auto timestamp = clock::now(source);
+    const auto max = std::chrono::system_clock::now() + tolerance;
+
+    return min <= timestamp && timestamp <= max;
+}
+
+}  // namespace
+
+TEST(clock, Source) {
+    EXPECT_EQ(clock_source_t::precise, clock_source("precise"));
+    EXPECT_EQ(clock_source_t::coarse, clock_source("coarse"));
+    EXPECT_EQ(clock_source_t::tsc, clock_source("tsc"));
+}
+
+TEST(clock, ThrowsOnUnknownSource) {
+    EXPECT_THROW(clock_source("sundial"), std::invalid_argument);
+}
+
+TEST(clock, Precise) {
+    EXPECT_TRUE(within(clock_source_t::precise, std::chrono::milliseconds(0)));
+}
+
+TEST(clock, Coarse) {
+    EXPECT_TRUE(within(clock_source_t::coarse, std::chrono::milliseconds(50)));
+}
+
+TEST(clock, Tsc) {
+    clock::prepare(clock_source_t::tsc);
+    EXPECT_TRUE(within(clock_source_t::tsc, std::chrono::milliseconds(50)));
+}
+
+TEST(clock, TimestampReadsClockUnlessCached) {
+    const auto min = std::chrono::system_clock::now();
+    EXPECT_LE(min, clock::timestamp(clock_source_t::precise));
+}
+
+TEST(clock, TimestampIsCachedUntilCleared) {
+    const std::chrono::system_clock::time_point timestamp(std::chrono::seconds(42));
+
+    clock::cache(timestamp);
+    EXPECT_EQ(timestamp, clock::timestamp(clock_source_t::precise));
+    EXPECT_EQ(timestamp, clock::timestamp(clock_source_t::coarse));
+
+    clock::clear();
+    EXPECT_NE(timestamp, clock::timestamp(clock_source_t::precise));
+}
+
+TEST(clock, CachedTimestampIsThreadLocal) {
+    const std::chrono::system_clock::time_point timestamp(std::chrono::seconds(42));
+    const clock::cached_t cached(timestamp);
+
+    std::chrono::system_clock::time_point other;
+    std::thread([&] {
+        other = clock::timestamp(clock_source_t::precise);
+    }).join();
+
+    EXPECT_NE(timestamp, other);
+    EXPECT_EQ(timestamp, clock::timestamp(clock_source_t::precise));
+}
+
+TEST(clock, CachedScopeRestoresPrevious) {
+    const std::chrono::system_clock::time_point outer(std::chrono::seconds(42));
+    const std::chrono::system_clock::time_point inner(std::chrono::seconds(43));
+
+    {
+        const clock::cached_t cached(outer);
+
+        {
+            const clock::cached_t cached(inner);
+            EXPECT_EQ(inner, clock::timestamp(clock_source_t::precise));
+        }
+
+        EXPECT_EQ(outer, clock::timestamp(clock_source_t::precise));
+    }
+
+    EXPECT_NE(outer, clock::timestamp(clock_source_t::precise));
+}
+
+}  // namespace testing
+}  // namespace blackhole
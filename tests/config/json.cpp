@@ -5,7 +5,15 @@
 #include <rapidjson/document.h>
 
 #include <blackhole/config/json.hpp>
-
+#include <blackhole/config/node.hpp>
+#include <blackhole/config/option.hpp>
+#include <blackhole/factory.hpp>
+#include <blackhole/record.hpp>
+#include <blackhole/registry.hpp>
+#include <blackhole/root.hpp>
+#include <blackhole/sink.hpp>
+
+#include <src/config/copy.hpp>
 #include <src/config/json.hpp>
 
 namespace blackhole {
@@ -334,5 +342,166 @@ TEST(factory, FromInvalidJson) {
     }
 }
 
+TEST(factory, BuildsLoggerFromObject) {
+    std::stringstream stream;
+    stream << R"({"root": {"clock": "coarse", "handlers": []}})";
+
+    auto log = registry::configured()->builder<json_t>(stream).build("root");
+
+    EXPECT_EQ(clock_source_t::coarse, log.clock());
+}
+
+TEST(factory, BuildsLoggerWithCategories) {
+    std::stringstream stream;
+    stream << R"({"root": {"categories": {"db": 2, "db.pool": 0}, "handlers": []}})";
+
+    auto log = registry::configured()->builder<json_t>(stream).build("root");
+
+    EXPECT_EQ(2, log.category("db").threshold());
+    EXPECT_EQ(0, log.category("db.pool").threshold());
+    EXPECT_EQ(2, log.category("db.query").threshold());
+}
+
+TEST(factory, ThrowsOnUnknownDispatchMode) {
+    std::stringstream stream;
+    stream << R"({"root": [{"type": "blocking", "dispatch": "eventually"}]})";
+
+    EXPECT_THROW(registry::configured()->builder<json_t>(stream).build("root"),
+        std::invalid_argument);
+}
+
+TEST(factory, BuildsLoggerWithPreciseClockByDefault) {
+    std::stringstream stream;
+    stream << R"({"root": []})";
+
+    auto log = registry::configured()->builder<json_t>(stream).build("root");
+
+    EXPECT_EQ(clock_source_t::precise, log.clock());
+}
+
+namespace {
+
+/// Records messages into the log shared by all instances, tagged with the sink id.
+class tagged_sink_t : public sink_t {
+    std::string id;
+    std::vector<std::string>& log;
+
+public:
+    tagged_sink_t(std::string id, std::vector<std::string>& log) :
+        id(std::move(id)),
+        log(log)
+    {
+        log.push_back("+" + this->id);
+    }
+
+    ~tagged_sink_t() {
+        log.push_back("-" + id);
+    }
+
+    auto emit(const record_t&, const string_view& message) -> void override {
+        log.push_back(id + ":" + message.to_string());
+    }
+};
+
+class tagged_factory_t : public factory<sink_t> {
+    std::vector<std::string>& log;
+
+public:
+    explicit tagged_factory_t(std::vector<std::string>& log) :
+        log(log)
+    {}
+
+    auto type() const noexcept -> const char* override {
+        return "tagged";
+    }
+
+    auto from(const config::node_t& config) const -> std::unique_ptr<sink_t> override {
+        return std::unique_ptr<sink_t>(new tagged_sink_t(config["id"].to_string().get(), log));
+    }
+};
+
+auto handler(const std::string& sinks) -> std::string {
+    return R"({"root": [{"type": "blocking", "formatter": {"type": "string", "pattern": )"
+        R"("{message}"}, "sinks": [)" + sinks + "]}]}";
+}
+
+}  // namespace
+
+TEST(factory, ReloadReusesUnchangedSinks) {
+    std::vector<std::string> log;
+
+    auto registry = registry::configured();
+    registry->add(std::make_shared<tagged_factory_t>(log));
+
+    std::stringstream stream;
+    stream << handler(R"({"type": "tagged", "id": "a"}, {"type": "tagged", "id": "b"})");
+
+    auto builder = registry->builder<json_t>(stream);
+
+    auto logger = builder.build("root");
+    logger.threshold(1);
+    logger.log(1, "GET");
+
+    EXPECT_EQ((std::vector<std::string>{"+a", "+b", "a:GET", "b:GET"}), log);
+    log.clear();
+
+    builder.reload(logger, "root", config::factory_traits<json_t>::construct(std::stringstream(
+        handler(R"({"type": "tagged", "id": "c"}, {"type": "tagged", "id": "a"})"))));
+    logger.log(1, "POST");
+
+    EXPECT_EQ((std::vector<std::string>{"+c", "-b", "c:POST", "a:POST"}), log);
+    EXPECT_EQ(1, logger.threshold());
+    log.clear();
+
+    // Failed reloads leave the logger as is.
+    EXPECT_THROW(builder.reload(logger, "root", config::factory_traits<json_t>::construct(
+        std::stringstream(handler(R"({"type": "tagged", "id": "a"}, {"type": "unknown"})")))),
+        std::out_of_range);
+    logger.log(1, "PUT");
+
+    EXPECT_EQ((std::vector<std::string>{"c:PUT", "a:PUT"}), log);
+}
+
+TEST(factory, BuildsLoggerAsync) {
+    std::vector<std::string> log;
+
+    auto registry = registry::configured();
+    registry->add(std::make_shared<tagged_factory_t>(log));
+
+    std::stringstream stream;
+    stream << handler(R"({"type": "tagged", "id": "a"}, {"type": "tagged", "id": 42})");
+
+    auto built = registry->builder<json_t>(stream).build_async("root");
+
+    // Construction errors are reported through the future, events fail for broken sinks only.
+    EXPECT_THROW(built.second.get(), config::type_mismatch);
+
+    built.first.log(0, "GET");
+
+    EXPECT_EQ((std::vector<std::string>{"+a", "a:GET"}), log);
+}
+
+TEST(copy, BehavesLikeOriginal) {
+    std::stringstream stream;
+    stream << R"({"root": {"name": "value", "port": 42, "sinks": [{"type": "null"}]}})";
+
+    config::factory<json_t> factory(stream);
+
+    const auto copy = config::copy(*factory.config()["root"].unwrap());
+
+    EXPECT_TRUE(copy->is_object());
+    EXPECT_EQ("value", (*copy)["name"].to_string().get());
+    EXPECT_EQ(42, (*copy)["port"].to_uint64().get());
+    EXPECT_EQ("null", (*copy)["sinks"][0]["type"].to_string().get());
+    EXPECT_FALSE((*copy)["missing"]);
+
+    try {
+        (*copy)["port"].to_string();
+        FAIL();
+    } catch (const config::type_mismatch& err) {
+        EXPECT_EQ("/root/port", err.cursor());
+    }
+}
+
 }  // namespace testing
 }  // namespace blackhole
@@ -0,0 +1,123 @@
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <limits>
+#include <string>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <blackhole/attribute.hpp>
+#include <blackhole/attributes.hpp>
+#include <blackhole/crash.hpp>
+#include <blackhole/handler/recorder.hpp>
+#include <blackhole/record.hpp>
+#include <blackhole/detail/crash.hpp>
+#include <blackhole/detail/sink/ring.hpp>
+
+#include "mocks/handler.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace crash {
+namespace {
+
+/// Collects everything written into its descriptor.
+class pipe_t {
+    int fds[2];
+
+public:
+    pipe_t() {
+        EXPECT_EQ(0, ::pipe(fds));
+        ::fcntl(fds[0], F_SETFL, O_NONBLOCK);
+    }
+
+    ~pipe_t() {
+        ::close(fds[0]);
+        ::close(fds[1]);
+    }
+
+    auto fd() const noexcept -> int {
+        return fds[1];
+    }
+
+    auto read() -> std::string {
+        std::string result;
+
+        char buffer[512];
+        ssize_t rc;
+        while ((rc = ::read(fds[0], buffer, sizeof(buffer))) > 0) {
+            result.append(buffer, static_cast<std::size_t>(rc));
+        }
+
+        return result;
+    }
+};
+
+TEST(crash, WriteInteger) {
+    pipe_t pipe;
+
+    detail::crash::write(pipe.fd(), std::int64_t(0));
+    detail::crash::write(pipe.fd(), string_view(" "));
+    detail::crash::write(pipe.fd(), std::int64_t(-42));
+    detail::crash::write(pipe.fd(), string_view(" "));
+    detail::crash::write(pipe.fd(), std::numeric_limits<std::int64_t>::min());
+
+    EXPECT_EQ("0 -42 -9223372036854775808", pipe.read());
+}
+
+TEST(crash, DumpsRegisteredSources) {
+    pipe_t pipe;
+
+    const std::string data("pending\n");
+
+    {
+        detail::crash::registration_t registration([](const void* context, int fd) {
+            detail::crash::write(fd, *static_cast<const std::string*>(context));
+        }, &data);
+
+        dump(pipe.fd());
+        EXPECT_EQ("pending\n", pipe.read());
+    }
+
+    dump(pipe.fd());
+    EXPECT_EQ("", pipe.read());
+}
+
+TEST(crash, DumpsRecorderRecords) {
+    using ::testing::_;
+
+    pipe_t pipe;
+
+    std::unique_ptr<testing::mock::handler_t> inner(new testing::mock::handler_t);
+    EXPECT_CALL(*inner, handle(_))
+        .Times(0);
+
+    handler::recorder_t recorder(std::move(inner), 3, 3);
+
+    const string_view message("le message");
+    const attribute_pack pack;
+    record_t record(2, message, pack);
+    recorder.handle(record);
+
+    dump(pipe.fd());
+    EXPECT_EQ("[2] le message\n", pipe.read());
+}
+
+TEST(crash, DumpsEncodedRingRecords) {
+    pipe_t pipe;
+
+    const string_view message("le message");
+    const attribute_pack pack;
+    record_t record(2, message, pack);
+
+    const auto encoded = sink::ring::encode(record, "[2] le message");
+    sink::ring::dump({encoded.data(), encoded.size()}, pipe.fd());
+
+    EXPECT_EQ("[2] le message\n", pipe.read());
+}
+
+}  // namespace
+}  // namespace crash
+}  // namespace v1
+}  // namespace blackhole
@@ -1,12 +1,16 @@
 #include <gtest/gtest.h>
 
+#include <cstdlib>
 #include <string>
+#include <vector>
 
 #include <boost/assert.hpp>
 
 #include <blackhole/extensions/format.hpp>
 
 #include <blackhole/detail/datetime.hpp>
+#include <blackhole/detail/datetime/cache.hpp>
+#include <blackhole/detail/datetime/zone.hpp>
 
 namespace blackhole {
 namespace testing {
@@ -371,5 +375,158 @@ TEST_F(datetime_t, Large) {
     EXPECT_EQ(expected, generate(pattern));
 }
 
+TEST_F(datetime_t, OffsetFromUTCNegative) {
+    tm.tm_gmtoff = -(5 * 3600 + 30 * 60);
+    EXPECT_EQ(using_strftime("%z", tm), generate("%z"));
+}
+
+TEST_F(datetime_t, OffsetFromUTCUnknown) {
+    tm.tm_isdst = -1;
+    EXPECT_EQ("[]", generate("[%z]"));
+}
+
+TEST_F(datetime_t, ModifiedSpecifiersFallBackToStrftime) {
+    tm.tm_year = 114;
+    tm.tm_mday = 6;
+    tm.tm_hour = 7;
+    EXPECT_EQ(using_strftime("%-d %_H %Ey %OS %10Y", tm), generate("%-d %_H %Ey %OS %10Y"));
+}
+
+TEST_F(datetime_t, YearOutOfFourDigitsRange) {
+    tm.tm_year = -1800;
+    EXPECT_EQ(using_strftime("%Y %y %C %F", tm), generate("%Y %y %C %F"));
+
+    tm.tm_year = 9000;
+    EXPECT_EQ(using_strftime("%Y %y %C %F", tm), generate("%Y %y %C %F"));
+}
+
+TEST_F(datetime_t, TrailingPercentSign) {
+    EXPECT_EQ(using_strftime("value %", tm), generate("value %"));
+}
+
+TEST_F(datetime_t, CompiledSpecifiersSameAsStrftime) {
+    const std::time_t time = 1393158030;
+    ::localtime_r(&time, &tm);
+
+    EXPECT_EQ(using_strftime("%Y-%m-%d %H:%M:%S %z|%y %C %e %j %I|%D %F %R %T|%%%n%t", tm),
+        generate("%Y-%m-%d %H:%M:%S %z|%y %C %e %j %I|%D %F %R %T|%%%n%t"));
+}
+
+TEST(datetime_cache_t, PatchesMicrosecondsWithinSameSecond) {
+    const std::string pattern("%Y-%m-%d %H:%M:%S.%f");
+    const auto generator = make_generator(pattern);
+
+    // 2014-02-23 12:20:30 UTC.
+    const std::time_t time = 1393158030;
+
+    detail::datetime::cache_t cache;
+    EXPECT_EQ("2014-02-23 12:20:30.000042", cache.format(pattern, generator, true, time, 42));
+    EXPECT_EQ("2014-02-23 12:20:30.123456", cache.format(pattern, generator, true, time, 123456));
+    EXPECT_EQ("2014-02-23 12:20:31.000001", cache.format(pattern, generator, true, time + 1, 1));
+}
+
+TEST(datetime_cache_t, DistinguishesPatterns) {
+    const std::string p1("%H:%M:%S");
+    const std::string p2("%S.%f");
+    const auto g1 = make_generator(p1);
+    const auto g2 = make_generator(p2);
+
+    const std::time_t time = 1393158030;
+
+    detail::datetime::cache_t cache;
+    EXPECT_EQ("12:20:30", cache.format(p1, g1, true, time, 42));
+    EXPECT_EQ("30.000042", cache.format(p2, g2, true, time, 42));
+    EXPECT_EQ("12:20:30", cache.format(p1, g1, true, time, 43));
+}
+
+namespace {
+
+auto same(const std::tm& lhs, const std::tm& rhs) -> bool {
+    return lhs.tm_year == rhs.tm_year && lhs.tm_mon == rhs.tm_mon && lhs.tm_mday == rhs.tm_mday &&
+        lhs.tm_hour == rhs.tm_hour && lhs.tm_min == rhs.tm_min && lhs.tm_sec == rhs.tm_sec &&
+        lhs.tm_wday == rhs.tm_wday && lhs.tm_yday == rhs.tm_yday && lhs.tm_isdst == rhs.tm_isdst &&
+        lhs.tm_gmtoff == rhs.tm_gmtoff;
+}
+
+/// Sets the timezone for the lifetime of the object, restoring the previous one on destruction.
+class scoped_tz_t {
+    bool had;
+    std::string previous;
+
+public:
+    explicit scoped_tz_t(const char* value) :
+        had(std::getenv("TZ") != nullptr),
+        previous(had ? std::getenv("TZ") : "")
+    {
+        ::setenv("TZ", value, 1);
+        ::tzset();
+    }
+
+    ~scoped_tz_t() {
+        if (had) {
+            ::setenv("TZ", previous.c_str(), 1);
+        } else {
+            ::unsetenv("TZ");
+        }
+
+        ::tzset();
+    }
+};
+
+}  // namespace
+
+TEST(datetime_zone_t, GmtimeSameAsLibc) {
+    // From 1901 to 2100 including leap years, days before the epoch and the 2000 one.
+    for (std::time_t time = -2147483647; time < 4102444800; time += 3600 * 7 + 59) {
+        std::tm expected;
+        ::gmtime_r(&time, &expected);
+
+        std::tm actual;
+        detail::datetime::gmtime(time, actual);
+
+        ASSERT_TRUE(same(expected, actual)) << time;
+    }
+}
+
+TEST(datetime_zone_t, LocaltimeSameAsLibcAcrossTransitions) {
+    scoped_tz_t tz("EST5EDT,M3.2.0,M11.1.0");
+
+    detail::datetime::zone_t zone;
+
+    // Two years in steps of 17 minutes, and each second around the first 2014 transitions.
+    std::vector<std::time_t> times;
+    for (std::time_t time = 1388534400; time < 1451606400; time += 1020) {
+        times.push_back(time);
+    }
+
+    for (std::time_t transition : {1394348400, 1414908000}) {
+        for (std::time_t time = transition - 5; time < transition + 5; ++time) {
+            times.push_back(time);
+        }
+    }
+
+    for (auto time : times) {
+        std::tm expected;
+        ::localtime_r(&time, &expected);
+
+        std::tm actual;
+        zone.localtime(time, actual);
+
+        ASSERT_TRUE(same(expected, actual)) << time;
+        EXPECT_STREQ(expected.tm_zone, actual.tm_zone);
+    }
+}
+
+TEST(datetime_cache_t, FormatsLocalTime) {
+    scoped_tz_t tz("EST5EDT,M3.2.0,M11.1.0");
+
+    const std::string pattern("%Y-%m-%d %H:%M:%S %z");
+    const auto generator = make_generator(pattern);
+
+    detail::datetime::cache_t cache;
+    EXPECT_EQ("2014-02-23 07:20:30 -0500", cache.format(pattern, generator, false, 1393158030, 0));
+    EXPECT_EQ("2014-07-23 08:20:30 -0400", cache.format(pattern, generator, false, 1406118030, 0));
+}
+
 }  // namespace testing
 }  // namespace blackhole
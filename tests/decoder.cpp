@@ -0,0 +1,220 @@
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <utility>
+
+#include <gtest/gtest.h>
+
+#include <blackhole/attribute.hpp>
+#include <blackhole/attributes.hpp>
+#include <blackhole/decoder.hpp>
+#include <blackhole/extensions/writer.hpp>
+#include <blackhole/formatter.hpp>
+#include <blackhole/formatter/binary.hpp>
+#include <blackhole/record.hpp>
+#include <blackhole/detail/memory.hpp>
+#include <blackhole/detail/sink/file/index.hpp>
+
+#include "temporary.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace {
+
+/// Writes the formatted message followed by the number of attributes.
+class message_t : public formatter_t {
+public:
+    auto format(const record_t& record, writer_t& writer) -> void override {
+        writer.write("{}", record.formatted().to_string());
+
+        for (const auto& list : record.attributes()) {
+            writer.write(" {}", list.get().size());
+        }
+    }
+};
+
+auto factory() -> std::unique_ptr<formatter_t> {
+    return blackhole::make_unique<message_t>();
+}
+
+class decoder : public ::testing::Test {
+protected:
+    const blackhole::testing::temporary_file_t temporary{"decoder"};
+    const std::string filename{temporary.path()};
+    std::string expected;
+
+    auto TearDown() -> void override {
+        std::remove(sink::file::index_t::path(filename).c_str());
+    }
+
+    /// Returns the given number of records encoded, each followed by a newline, remembering their
+    /// expected output.
+    auto encode(int count, std::size_t padding = 0) -> std::string {
+        auto formatter = builder<formatter::binary_t>().build();
+
+        std::string result;
+        for (int id = 0; id < count; ++id) {
+            const auto formatted = "#" + std::to_string(id);
+            const std::string pad(padding + static_cast<std::size_t>(id % 7), '\n');
+
+            const attribute_list attributes{{"padding", {pad}}};
+            const attribute_pack pack{attributes};
+
+            const string_view message("#{}");
+            record_t record(0, message, pack);
+            record.activate(formatted);
+
+            writer_t writer;
+            formatter->format(record, writer);
+            result += writer.result().to_string() + "\n";
+
+            expected += formatted + " 1\n";
+        }
+
+        return result;
+    }
+
+    auto write(const std::string& data) -> void {
+        std::ofstream stream(filename, std::ios::binary);
+        stream << data;
+    }
+
+    auto decode(std::size_t threads, std::size_t chunk) ->
+        std::pair<std::string, decoder_t::stats_t>
+    {
+        decoder_t::options_t options;
+        options.threads = threads;
+        options.chunk = chunk;
+
+        std::string output;
+        decoder_t decoder(filename);
+        const auto stats = decoder.decode(&factory, [&](const string_view& data) {
+            output.append(data.data(), data.size());
+        }, options);
+
+        return {output, stats};
+    }
+};
+
+TEST_F(decoder, ThrowsOnMissingFile) {
+    EXPECT_THROW(decoder_t("/tmp/blackhole-decoder-missing"), std::system_error);
+}
+
+TEST_F(decoder, ThrowsOnZeroChunk) {
+    write(encode(1));
+    EXPECT_THROW(decode(1, 0), std::invalid_argument);
+}
+
+TEST_F(decoder, DecodesEmptyFile) {
+    const auto result = decode(2, 64);
+
+    EXPECT_TRUE(result.first.empty());
+    EXPECT_EQ(0, result.second.records);
+    EXPECT_EQ(0, result.second.skipped);
+}
+
+TEST_F(decoder, DecodesSequentially) {
+    write(encode(100));
+
+    const auto result = decode(1, 1024 * 1024);
+    EXPECT_EQ(expected, result.first);
+    EXPECT_EQ(100, result.second.records);
+    EXPECT_EQ(0, result.second.skipped);
+}
+
+TEST_F(decoder, DecodesChunksInParallelInOrder) {
+    write(encode(1000));
+
+    // Chunks much smaller than frames resynchronize inside them, all of them being discarded.
+    for (std::size_t chunk : {1, 17, 64, 100, 4096}) {
+        const auto result = decode(4, chunk);
+        EXPECT_EQ(expected, result.first) << "chunk: " << chunk;
+        EXPECT_EQ(1000, result.second.records);
+        EXPECT_EQ(0, result.second.skipped);
+    }
+}
+
+TEST_F(decoder, DecodesFramesSpanningChunks) {
+    write(encode(20, 1000));
+
+    const auto result = decode(3, 256);
+    EXPECT_EQ(expected, result.first);
+    EXPECT_EQ(20, result.second.records);
+}
+
+TEST_F(decoder, SkipsCorruptedBytes) {
+    auto data = encode(25);
+    data += "garbage";
+    data += encode(25);
+
+    // Torn tail.
+    const auto tail = encode(1);
+    data += tail.substr(0, tail.size() / 2);
+
+    write(data);
+
+    const auto sequential = decode(1, 1024 * 1024);
+    EXPECT_EQ(50, sequential.second.records);
+    EXPECT_EQ(7 + tail.size() / 2, sequential.second.skipped);
+
+    const auto parallel = decode(4, 32);
+    EXPECT_EQ(sequential.first, parallel.first);
+    EXPECT_EQ(sequential.second.records, parallel.second.records);
+    EXPECT_EQ(sequential.second.skipped, parallel.second.skipped);
+}
+
+TEST_F(decoder, UsesIndexBoundaries) {
+    write(std::string());
+
+    sink::file::indexing_t indexing;
+    indexing.size = 1;
+
+    std::string data;
+    {
+        sink::file::index_t index(filename, indexing);
+        for (int id = 0; id < 100; ++id) {
+            const auto line = encode(1, 100);
+
+            index.update(record_t::time_point());
+            index.advance(line.size());
+            data += line;
+        }
+    }
+
+    write(data);
+    ASSERT_EQ(100, sink::file::index_t::read(filename).size());
+
+    const auto result = decode(4, 128);
+    EXPECT_EQ(expected, result.first);
+    EXPECT_EQ(100, result.second.records);
+    EXPECT_EQ(0, result.second.skipped);
+}
+
+TEST_F(decoder, ToleratesMisalignedIndex) {
+    const auto data = encode(100, 100);
+    write(std::string());
+
+    sink::file::indexing_t indexing;
+    indexing.size = 1;
+
+    {
+        sink::file::index_t index(filename, indexing);
+        for (std::size_t offset = 0; offset < data.size(); offset += 97) {
+            index.update(record_t::time_point());
+            index.advance(97);
+        }
+    }
+
+    write(data);
+
+    const auto result = decode(4, 128);
+    EXPECT_EQ(expected, result.first);
+    EXPECT_EQ(100, result.second.records);
+    EXPECT_EQ(0, result.second.skipped);
+}
+
+}  // namespace
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,176 @@
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <blackhole/deferred.hpp>
+#include <blackhole/record.hpp>
+#include <blackhole/root.hpp>
+
+#include "mocks/handler.hpp"
+
+namespace blackhole {
+namespace testing {
+
+using ::testing::Invoke;
+using ::testing::_;
+
+namespace {
+
+struct event_t {
+    int severity;
+    std::string message;
+    std::string formatted;
+};
+
+auto make_logger(std::vector<event_t>& events) -> root_logger_t {
+    std::unique_ptr<mock::handler_t> handler(new mock::handler_t);
+
+    EXPECT_CALL(*handler, handle(_))
+        .WillRepeatedly(Invoke([&](const record_t& record) {
+            events.push_back({
+                record.severity(),
+                record.message().to_string(),
+                record.formatted().to_string()
+            });
+        }));
+
+    std::vector<std::unique_ptr<handler_t>> handlers;
+    handlers.push_back(std::move(handler));
+
+    return root_logger_t(std::move(handlers));
+}
+
+}  // namespace
+
+TEST(callsite_t, RegistersPattern) {
+    static const deferred::callsite_t c1("GET {} HTTP/1.1");
+    static const deferred::callsite_t c2("POST {} HTTP/1.1");
+
+    EXPECT_NE(c1.id(), c2.id());
+    EXPECT_STREQ("GET {} HTTP/1.1", deferred::pattern(c1.id()));
+    EXPECT_STREQ("POST {} HTTP/1.1", deferred::pattern(c2.id()));
+}
+
+TEST(Deferred, FormatsOnFlush) {
+    std::vector<event_t> events;
+    auto inner = make_logger(events);
+    deferred_t logger(inner, std::chrono::milliseconds(60000));
+
+    static const deferred::callsite_t callsite("{} {} -> {}: {} in {:.1f} ms");
+
+    const std::string method("GET");
+    logger.log(callsite, 2, method, "/porn.png", string_view("200"), 42u, 3.14);
+
+    logger.flush();
+
+    ASSERT_EQ(1, events.size());
+    EXPECT_EQ(2, events[0].severity);
+    EXPECT_EQ("{} {} -> {}: {} in {:.1f} ms", events[0].message);
+    EXPECT_EQ("GET /porn.png -> 200: 42 in 3.1 ms", events[0].formatted);
+}
+
+TEST(Deferred, WithoutArguments) {
+    std::vector<event_t> events;
+    auto inner = make_logger(events);
+    deferred_t logger(inner, std::chrono::milliseconds(60000));
+
+    static const deferred::callsite_t callsite("GET /porn.png HTTP/1.1");
+    logger.log(callsite, 0);
+    logger.flush();
+
+    ASSERT_EQ(1, events.size());
+    EXPECT_EQ("GET /porn.png HTTP/1.1", events[0].formatted);
+}
+
+TEST(Deferred, LargeArguments) {
+    std::vector<event_t> events;
+    auto inner = make_logger(events);
+    deferred_t logger(inner, std::chrono::milliseconds(60000));
+
+    static const deferred::callsite_t callsite("[{}]");
+
+    const std::string value(1024, 'x');
+    logger.log(callsite, 0, value);
+    logger.flush();
+
+    ASSERT_EQ(1, events.size());
+    EXPECT_EQ("[" + value + "]", events[0].formatted);
+}
+
+TEST(Deferred, SkipsDisabledSeverity) {
+    std::vector<event_t> events;
+    auto inner = make_logger(events);
+    inner.threshold(1);
+
+    deferred_t logger(inner, std::chrono::milliseconds(60000));
+
+    static const deferred::callsite_t callsite("value: {}");
+    logger.log(callsite, 0, 1);
+    logger.log(callsite, 1, 2);
+    logger.flush();
+
+    EXPECT_FALSE(logger.enabled(0));
+    ASSERT_EQ(1, events.size());
+    EXPECT_EQ("value: 2", events[0].formatted);
+}
+
+TEST(Deferred, DeliversPendingOnDestruction) {
+    std::vector<event_t> events;
+    auto inner = make_logger(events);
+
+    static const deferred::callsite_t callsite("value: {}");
+
+    {
+        deferred_t logger(inner, std::chrono::milliseconds(60000));
+        for (int id = 0; id < 10; ++id) {
+            logger.log(callsite, 0, id);
+        }
+    }
+
+    ASSERT_EQ(10, events.size());
+    for (int id = 0; id < 10; ++id) {
+        EXPECT_EQ("value: " + std::to_string(id), events[id].formatted);
+    }
+}
+
+TEST(Deferred, PreservesOrderWithinThread) {
+    std::vector<event_t> events;
+    auto inner = make_logger(events);
+
+    static const deferred::callsite_t callsite("{}:{}");
+
+    {
+        deferred_t logger(inner, std::chrono::milliseconds(1));
+
+        std::vector<std::thread> threads;
+        for (int thread = 0; thread < 4; ++thread) {
+            threads.emplace_back([&, thread] {
+                for (int id = 0; id < 1000; ++id) {
+                    logger.log(callsite, 0, thread, id);
+                }
+            });
+        }
+
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    }
+
+    ASSERT_EQ(4000, events.size());
+
+    std::vector<int> last(4, -1);
+    for (const auto& event : events) {
+        const auto pos = event.formatted.find(':');
+        const auto thread = std::stoi(event.formatted.substr(0, pos));
+        const auto id = std::stoi(event.formatted.substr(pos + 1));
+
+        EXPECT_EQ(last[thread] + 1, id);
+        last[thread] = id;
+    }
+}
+
+}  // namespace testing
+}  // namespace blackhole
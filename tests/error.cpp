@@ -0,0 +1,123 @@
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <blackhole/error.hpp>
+#include <blackhole/detail/error.hpp>
+
+namespace blackhole {
+inline namespace v1 {
+namespace error {
+namespace {
+
+/// Installs a reporter collecting reports with the given rate limit, restoring defaults on exit.
+class collecting_t {
+    std::vector<std::string>& reports;
+    const std::size_t previous;
+
+public:
+    collecting_t(std::vector<std::string>& reports, std::size_t rate) :
+        reports(reports),
+        previous(limit())
+    {
+        limit(rate);
+        reporter([&](kind_t kind, const string_view& message, std::uint64_t suppressed) {
+            reports.push_back(std::string(name(kind)) + ":" + message.to_string() + ":" +
+                std::to_string(suppressed));
+        });
+    }
+
+    ~collecting_t() {
+        reporter(nullptr);
+        limit(previous);
+    }
+};
+
+TEST(error, DefaultLimit) {
+    EXPECT_EQ(10, limit());
+}
+
+TEST(error, Names) {
+    EXPECT_EQ(std::string("handler"), name(kind_t::handler));
+    EXPECT_EQ(std::string("sink"), name(kind_t::sink));
+    EXPECT_EQ(std::string("deferred"), name(kind_t::deferred));
+}
+
+TEST(error, ReporterReturnsPrevious) {
+    EXPECT_FALSE(reporter([](kind_t, const string_view&, std::uint64_t) {}));
+    EXPECT_TRUE(reporter(nullptr));
+    EXPECT_FALSE(reporter(nullptr));
+}
+
+TEST(error, RateLimitsReportsPerKind) {
+    std::vector<std::string> reports;
+    const collecting_t collecting(reports, 2);
+
+    const auto occurred = error::occurred(kind_t::sink);
+    const auto suppressed = error::suppressed(kind_t::sink);
+
+    for (int i = 0; i < 5; ++i) {
+        detail::error::report(kind_t::sink, "disk full");
+    }
+
+    detail::error::report(kind_t::handler, "emit");
+
+    ASSERT_LE(3, reports.size());
+    EXPECT_EQ("sink:disk full:0", reports[0]);
+    EXPECT_EQ(occurred + 5, error::occurred(kind_t::sink));
+
+    // Unless the window rolls over in between, only the first two errors are reported.
+    const auto reported = reports.size() - 1;
+    EXPECT_GE(4, reported);
+    EXPECT_EQ(5, reported + error::suppressed(kind_t::sink) - suppressed);
+    EXPECT_EQ("handler:emit:0", reports.back());
+}
+
+TEST(error, UnlimitedRate) {
+    std::vector<std::string> reports;
+    const collecting_t collecting(reports, 0);
+
+    const auto suppressed = error::suppressed(kind_t::deferred);
+
+    for (int i = 0; i < 100; ++i) {
+        detail::error::report(kind_t::deferred, "replay");
+    }
+
+    EXPECT_EQ(100, reports.size());
+    EXPECT_EQ(suppressed, error::suppressed(kind_t::deferred));
+}
+
+TEST(error, ReportsCurrentException) {
+    std::vector<std::string> reports;
+    const collecting_t collecting(reports, 0);
+
+    try {
+        throw std::runtime_error("broken pipe");
+    } catch (...) {
+        detail::error::report(kind_t::sink);
+    }
+
+    try {
+        throw 42;
+    } catch (...) {
+        detail::error::report(kind_t::sink);
+    }
+
+    EXPECT_EQ((std::vector<std::string>{"sink:broken pipe:0", "sink:unknown:0"}), reports);
+}
+
+TEST(error, SwallowsReporterExceptions) {
+    const auto previous = reporter([](kind_t, const string_view&, std::uint64_t) {
+        throw std::runtime_error("reporter");
+    });
+
+    EXPECT_NO_THROW(detail::error::report(kind_t::handler, "emit"));
+
+    reporter(previous);
+}
+
+}  // namespace
+}  // namespace error
+}  // namespace v1
+}  // namespace blackhole
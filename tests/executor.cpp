@@ -0,0 +1,79 @@
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <stdexcept>
+
+#include <gtest/gtest.h>
+
+#include <blackhole/executor.hpp>
+
+namespace blackhole {
+inline namespace v1 {
+namespace {
+
+TEST(executor_t, ThrowsOnInvalidArguments) {
+    EXPECT_THROW(executor_t(0), std::invalid_argument);
+    EXPECT_THROW(executor_t(1, 0), std::invalid_argument);
+}
+
+TEST(executor_t, RunsQueuedTasksOnDestruction) {
+    std::atomic<int> counter(0);
+
+    {
+        executor_t executor(2);
+        for (int i = 0; i < 100; ++i) {
+            EXPECT_TRUE(executor.post([&] {
+                ++counter;
+            }));
+        }
+    }
+
+    EXPECT_EQ(100, counter.load());
+}
+
+TEST(executor_t, RejectsTasksWhenFull) {
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool started = false;
+    bool released = false;
+
+    executor_t executor(1, 1);
+
+    // Blocks the only thread, so the next task stays queued.
+    ASSERT_TRUE(executor.post([&] {
+        std::unique_lock<std::mutex> lock(mutex);
+        started = true;
+        cv.notify_all();
+        cv.wait(lock, [&] { return released; });
+    }));
+
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [&] { return started; });
+    }
+
+    EXPECT_TRUE(executor.post([] {}));
+    EXPECT_FALSE(executor.post([] {}));
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        released = true;
+    }
+    cv.notify_all();
+}
+
+TEST(executor_t, IgnoresExceptionsFromTasks) {
+    std::atomic<int> counter(0);
+
+    {
+        executor_t executor(1);
+        executor.post([] { throw std::runtime_error("..."); });
+        executor.post([&] { ++counter; });
+    }
+
+    EXPECT_EQ(1, counter.load());
+}
+
+}  // namespace
+}  // namespace v1
+}  // namespace blackhole
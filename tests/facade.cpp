@@ -32,6 +32,17 @@ using ::testing::_;
 
 typedef mock::logger_t logger_type;
 
+namespace {
+
+class disabled_logger_t : public mock::logger_t {
+public:
+    auto enabled(int) const -> bool {
+        return false;
+    }
+};
+
+}  // namespace
+
 TEST(Facade, Constructor) {
     logger_type inner;
     logger_facade<logger_type> logger(inner);
@@ -119,5 +130,143 @@ TEST(Facade, FormattedAttributeLog) {
     });
 }
 
+TEST(Facade, TypedAttributeLog) {
+    logger_type inner;
+    logger_facade<logger_type> logger(inner);
+
+    const std::string uri("/porn.png");
+    const attribute_list attributes{{"status", {200}}, {"uri", {uri}}};
+    attribute_pack expected{attributes};
+
+    EXPECT_CALL(inner, log(severity_t(0), string_view("GET"), expected))
+        .Times(1);
+
+    logger.log(0, "GET", attr("status", 200), attr("uri", uri));
+}
+
+TEST(Facade, FormattedTypedAttributeLog) {
+    logger_type inner;
+    logger_facade<logger_type> logger(inner);
+
+    const attribute_list attributes{{"status", {200}}, {"elapsed", {0.5}}};
+    attribute_pack expected{attributes};
+
+    EXPECT_CALL(inner, log(severity_t(0), An<const lazy_message_t&>(), expected))
+        .Times(1)
+        .WillOnce(WithArg<1>(Invoke([](const lazy_message_t& message) {
+            EXPECT_EQ("{} {} HTTP/1.0", message.pattern.to_string());
+            EXPECT_EQ("GET /porn.png HTTP/1.0", message.supplier().to_string());
+        })));
+
+    logger.log(0, "{} {} HTTP/1.0", "GET", std::string("/porn.png"),
+        attr("status", 200), attr("elapsed", 0.5));
+}
+
+#if defined(__cpp_constexpr) && __cpp_constexpr >= 201304
+
+TEST(Facade, CompiledPatternCountsPlaceholders) {
+    static_assert(detail::placeholder_count("GET {} HTTP/1.0 - {}") == 2, "");
+    static_assert(detail::placeholder_count("{{}} - {}") == 1, "");
+    static_assert(detail::placeholder_count("GET") == 0, "");
+
+    EXPECT_EQ("GET {} - {{}}", BH_PATTERN("GET {} - {{}}").pattern().to_string());
+}
+
+TEST(Facade, CompiledPatternLog) {
+    logger_type inner;
+    logger_facade<logger_type> logger(inner);
+
+    attribute_pack expected;
+
+    EXPECT_CALL(inner, log(severity_t(0), An<const lazy_message_t&>(), expected))
+        .Times(1)
+        .WillOnce(WithArg<1>(Invoke([](const lazy_message_t& message) {
+            EXPECT_EQ("GET {} HTTP/1.0 - {}", message.pattern.to_string());
+            EXPECT_EQ("GET /porn.png HTTP/1.0 - 42", message.supplier().to_string());
+        })));
+
+    logger.log(0, BH_PATTERN("GET {} HTTP/1.0 - {}"), "/porn.png", 42);
+}
+
+TEST(Facade, CompiledPatternWithoutArguments) {
+    logger_type inner;
+    logger_facade<logger_type> logger(inner);
+
+    const attribute_list attributes{{"key#1", {42}}};
+    attribute_pack expected{attributes};
+
+    EXPECT_CALL(inner, log(severity_t(0), string_view("GET /porn.png HTTP/1.0"), expected))
+        .Times(1);
+
+    logger.log(0, BH_PATTERN("GET /porn.png HTTP/1.0"), attribute_list{{"key#1", {42}}});
+}
+
+TEST(Facade, CompiledPatternAttributeLog) {
+    logger_type inner;
+    logger_facade<logger_type> logger(inner);
+
+    const attribute_list attributes{{"key#1", {42}}};
+    attribute_pack expected{attributes};
+
+    EXPECT_CALL(inner, log(severity_t(0), An<const lazy_message_t&>(), expected))
+        .Times(1)
+        .WillOnce(WithArg<1>(Invoke([](const lazy_message_t& message) {
+            EXPECT_EQ("GET /porn.png HTTP/1.0 - {}", message.pattern.to_string());
+            EXPECT_EQ("GET /porn.png HTTP/1.0 - 2345", message.supplier().to_string());
+        })));
+
+    logger.log(0, BH_PATTERN("GET /porn.png HTTP/1.0 - {}"), 2345, attribute_list{
+        {"key#1", {42}}
+    });
+}
+
+TEST(Facade, CompiledPatternTypedAttributeLog) {
+    logger_type inner;
+    logger_facade<logger_type> logger(inner);
+
+    const attribute_list attributes{{"status", {200}}, {"elapsed", {0.5}}};
+    attribute_pack expected{attributes};
+
+    EXPECT_CALL(inner, log(severity_t(0), An<const lazy_message_t&>(), expected))
+        .Times(1)
+        .WillOnce(WithArg<1>(Invoke([](const lazy_message_t& message) {
+            EXPECT_EQ("{} {} HTTP/1.0", message.pattern.to_string());
+            EXPECT_EQ("GET /porn.png HTTP/1.0", message.supplier().to_string());
+        })));
+
+    logger.log(0, BH_PATTERN("{} {} HTTP/1.0"), "GET", std::string("/porn.png"),
+        attr("status", 200), attr("elapsed", 0.5));
+}
+
+#endif
+
+TEST(Facade, SkipsDisabledSeverity) {
+    disabled_logger_t inner;
+    logger_facade<disabled_logger_t> logger(inner);
+
+    EXPECT_CALL(inner, log(_, _)).Times(0);
+    EXPECT_CALL(inner, log(_, An<const message_t&>(), _)).Times(0);
+    EXPECT_CALL(inner, log(_, An<const lazy_message_t&>(), _)).Times(0);
+
+    EXPECT_FALSE(logger.enabled(0));
+
+    logger.log(0, "GET /porn.png HTTP/1.0");
+    logger.log(0, "GET /porn.png HTTP/1.0 - {}", 42);
+    logger.log(0, "GET /porn.png HTTP/1.0", attribute_list{{"key#1", {42}}});
+    logger.log(0, "GET /porn.png HTTP/1.0 - {}", 42, attribute_list{{"key#1", {42}}});
+    logger.log(0, "GET /porn.png HTTP/1.0", attr("key#1", 42));
+    logger.log(0, "GET /porn.png HTTP/1.0 - {}", 42, attr("key#1", 42));
+#if defined(__cpp_constexpr) && __cpp_constexpr >= 201304
+    logger.log(0, BH_PATTERN("GET /porn.png HTTP/1.0 - {}"), 42, attr("key#1", 42));
+#endif
+}
+
+TEST(Facade, EnabledByDefault) {
+    logger_type inner;
+    logger_facade<logger_type> logger(inner);
+
+    EXPECT_TRUE(logger.enabled(0));
+}
+
 }  // namespace testing
 }  // namespace blackhole
@@ -0,0 +1,42 @@
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include <blackhole/immortal.hpp>
+
+namespace blackhole {
+inline namespace v1 {
+namespace immortal {
+namespace {
+
+TEST(immortal, ContainsLiterals) {
+    EXPECT_TRUE(contains(string_view("le message")));
+}
+
+TEST(immortal, DoesNotContainDynamicStrings) {
+    const std::string value("le message of some length to be allocated");
+    EXPECT_FALSE(contains(string_view(value)));
+    EXPECT_FALSE(contains(string_view()));
+}
+
+TEST(immortal, ContainsDeclaredMemory) {
+    // Writable, so it's not immortal unless declared.
+    static char table[] = "le value";
+    EXPECT_FALSE(contains(string_view(table + 3, 5)));
+
+    EXPECT_TRUE(declare(table, sizeof(table)));
+    EXPECT_TRUE(contains(string_view(table + 3, 5)));
+}
+
+TEST(immortal, DoesNotContainStringsCrossingBounds) {
+    static char table[] = "le other value";
+
+    EXPECT_TRUE(declare(table, 2));
+    EXPECT_TRUE(contains(string_view(table, 2)));
+    EXPECT_FALSE(contains(string_view(table, 3)));
+}
+
+}  // namespace
+}  // namespace immortal
+}  // namespace v1
+}  // namespace blackhole
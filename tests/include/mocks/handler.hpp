@@ -14,6 +14,7 @@ public:
     ~handler_t();
 
     MOCK_METHOD1(handle, void(const record_t&));
+    MOCK_METHOD1(flush, bool(std::chrono::steady_clock::time_point));
 };
 
 }  // namespace mock
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include <dirent.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+namespace blackhole {
+namespace testing {
+
+/// Empty temporary file named after the given tag, which is removed on destruction.
+class temporary_file_t {
+    std::string path_;
+
+public:
+    /// \throw std::system_error if the file can't be created.
+    explicit temporary_file_t(const std::string& tag) {
+        std::string path = "/tmp/blackhole-" + tag + "-XXXXXX";
+
+        const auto fd = ::mkstemp(&path[0]);
+        if (fd == -1) {
+            throw std::system_error(errno, std::system_category(), "failed to create " + path);
+        }
+
+        ::close(fd);
+        path_ = std::move(path);
+    }
+
+    temporary_file_t(const temporary_file_t& other) = delete;
+    auto operator=(const temporary_file_t& other) -> temporary_file_t& = delete;
+
+    ~temporary_file_t() {
+        std::remove(path_.c_str());
+    }
+
+    auto path() const noexcept -> const std::string& {
+        return path_;
+    }
+};
+
+/// Temporary directory named after the given tag, which is removed with the files it contains on
+/// destruction.
+class temporary_directory_t {
+    std::string path_;
+
+public:
+    /// \throw std::system_error if the directory can't be created.
+    explicit temporary_directory_t(const std::string& tag) {
+        std::string path = "/tmp/blackhole-" + tag + "-XXXXXX";
+
+        if (::mkdtemp(&path[0]) == nullptr) {
+            throw std::system_error(errno, std::system_category(), "failed to create " + path);
+        }
+
+        path_ = std::move(path);
+    }
+
+    temporary_directory_t(const temporary_directory_t& other) = delete;
+    auto operator=(const temporary_directory_t& other) -> temporary_directory_t& = delete;
+
+    ~temporary_directory_t() {
+        for (const auto& name : list()) {
+            std::remove((path_ + "/" + name).c_str());
+        }
+
+        ::rmdir(path_.c_str());
+    }
+
+    auto path() const noexcept -> const std::string& {
+        return path_;
+    }
+
+    /// Returns sorted names of files in the directory.
+    auto list() const -> std::vector<std::string> {
+        std::vector<std::string> result;
+
+        if (auto dir = ::opendir(path_.c_str())) {
+            while (const auto entry = ::readdir(dir)) {
+                const std::string name(entry->d_name);
+                if (name != "." && name != "..") {
+                    result.push_back(name);
+                }
+            }
+
+            ::closedir(dir);
+        }
+
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+};
+
+}  // namespace testing
+}  // namespace blackhole
@@ -0,0 +1,59 @@
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include <blackhole/message.hpp>
+
+namespace blackhole {
+namespace testing {
+
+namespace {
+
+auto supply() -> string_view {
+    return {"from function"};
+}
+
+}  // namespace
+
+TEST(supplier_t, FromFunction) {
+    const supplier_t supplier(&supply);
+    EXPECT_EQ("from function", supplier().to_string());
+}
+
+TEST(supplier_t, FromTemporaryCapturelessLambda) {
+    // Captureless lambdas decay to function pointers, so the supplier doesn't dangle.
+    const supplier_t supplier([]() -> string_view {
+        return {"from lambda"};
+    });
+
+    EXPECT_EQ("from lambda", supplier().to_string());
+}
+
+TEST(supplier_t, ReferencesCallable) {
+    std::string message = "initial";
+    const auto fn = [&]() -> string_view {
+        return {message.data(), message.size()};
+    };
+
+    const supplier_t supplier(fn);
+    message = "changed";
+
+    EXPECT_EQ("changed", supplier().to_string());
+}
+
+TEST(supplier_t, FromReferenceWrapper) {
+    int calls = 0;
+    const auto fn = [&]() -> string_view {
+        ++calls;
+        return {"wrapped"};
+    };
+
+    const supplier_t supplier(std::cref(fn));
+    const auto copy = supplier;
+
+    EXPECT_EQ("wrapped", copy().to_string());
+    EXPECT_EQ(1, calls);
+}
+
+}  // namespace testing
+}  // namespace blackhole
@@ -0,0 +1,350 @@
+#include <thread>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <blackhole/attribute.hpp>
+#include <blackhole/cputime.hpp>
+#include <blackhole/formatter.hpp>
+#include <blackhole/formatter/string.hpp>
+#include <blackhole/handler.hpp>
+#include <blackhole/handler/blocking.hpp>
+#include <blackhole/metrics.hpp>
+#include <blackhole/record.hpp>
+#include <blackhole/root.hpp>
+#include <blackhole/sink.hpp>
+#include <blackhole/stage.hpp>
+#include <blackhole/detail/cputime.hpp>
+#include <blackhole/detail/process.hpp>
+#include <blackhole/detail/sink/asynchronous.hpp>
+
+#include "mocks/sink.hpp"
+
+namespace blackhole {
+namespace testing {
+
+using ::testing::HasSubstr;
+using ::testing::InvokeWithoutArgs;
+using ::testing::_;
+
+namespace {
+
+auto find(const metrics::snapshot_t& snapshot, const std::string& name,
+    const std::vector<std::pair<std::string, std::string>>& labels = {}) -> const metrics::sample_t*
+{
+    for (const auto& sample : snapshot) {
+        if (sample.name == name && sample.labels == labels) {
+            return &sample;
+        }
+    }
+
+    return nullptr;
+}
+
+auto count(stage::id_t id) -> std::uint64_t {
+    std::uint64_t result = 0;
+    for (auto value : stage::histogram(id).counts()) {
+        result += value;
+    }
+
+    return result;
+}
+
+auto logger(std::unique_ptr<sink_t> sink) -> root_logger_t {
+    std::vector<std::unique_ptr<handler_t>> handlers;
+    handlers.push_back(builder<handler::blocking_t>()
+        .set(builder<formatter::string_t>("{message}").build())
+        .add(std::move(sink))
+        .build());
+
+    return root_logger_t(std::move(handlers));
+}
+
+}  // namespace
+
+TEST(metrics, CounterAggregatesShards) {
+    metrics::counter_t counter;
+
+    std::vector<std::thread> threads;
+    for (int id = 0; id < 4; ++id) {
+        threads.emplace_back([&] {
+            for (int i = 0; i < 1000; ++i) {
+                counter.add();
+            }
+        });
+    }
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    counter.add(42);
+
+    EXPECT_EQ(4042, counter.get());
+}
+
+TEST(metrics, HistogramBuckets) {
+    metrics::histogram_t histogram;
+    histogram.record(0);
+    histogram.record(1);
+    histogram.record(2);
+    histogram.record(3);
+    histogram.record(1024);
+    histogram.record(~0ull);
+
+    const auto counts = histogram.counts();
+    ASSERT_EQ(metrics::histogram_t::buckets, counts.size());
+    EXPECT_EQ(2, counts[0]);
+    EXPECT_EQ(2, counts[1]);
+    EXPECT_EQ(1, counts[10]);
+    EXPECT_EQ(1, counts.back());
+    EXPECT_EQ(1030 + ~0ull, histogram.sum());
+}
+
+TEST(metrics, PrometheusCounter) {
+    metrics::snapshot_t snapshot;
+    metrics::collector_t collector(snapshot);
+
+    collector.counter("blackhole_records_total", 42);
+    collector.with("handler", "0").with("sink", "\"1\"").gauge("blackhole_queue_depth", 5);
+
+    EXPECT_EQ(
+        "# TYPE blackhole_records_total counter\n"
+        "blackhole_records_total 42\n"
+        "# TYPE blackhole_queue_depth gauge\n"
+        "blackhole_queue_depth{handler=\"0\",sink=\"\\\"1\\\"\"} 5\n",
+        metrics::prometheus(snapshot));
+}
+
+TEST(metrics, PrometheusGroupsSamplesByName) {
+    metrics::snapshot_t snapshot;
+    metrics::collector_t collector(snapshot);
+
+    collector.with("sink", "0").counter("a", 1);
+    collector.with("sink", "0").counter("b", 2);
+    collector.with("sink", "1").counter("a", 3);
+
+    EXPECT_EQ(
+        "# TYPE a counter\n"
+        "a{sink=\"0\"} 1\n"
+        "a{sink=\"1\"} 3\n"
+        "# TYPE b counter\n"
+        "b{sink=\"0\"} 2\n",
+        metrics::prometheus(snapshot));
+}
+
+TEST(metrics, PrometheusHistogram) {
+    metrics::histogram_t histogram;
+    histogram.record(1);
+    histogram.record(3);
+    histogram.record(1000000000);
+
+    metrics::snapshot_t snapshot;
+    metrics::collector_t collector(snapshot);
+    collector.histogram("emit_seconds", histogram);
+
+    const auto result = metrics::prometheus(snapshot);
+
+    EXPECT_THAT(result, HasSubstr("# TYPE emit_seconds histogram\n"));
+    EXPECT_THAT(result, HasSubstr("emit_seconds_bucket{le=\"2e-09\"} 1\n"));
+    EXPECT_THAT(result, HasSubstr("emit_seconds_bucket{le=\"4e-09\"} 2\n"));
+    EXPECT_THAT(result, HasSubstr("emit_seconds_bucket{le=\"1.073741824\"} 3\n"));
+    EXPECT_THAT(result, HasSubstr("emit_seconds_bucket{le=\"+Inf\"} 3\n"));
+    EXPECT_THAT(result, HasSubstr("emit_seconds_sum 1.000000004\n"));
+    EXPECT_THAT(result, HasSubstr("emit_seconds_count 3\n"));
+}
+
+TEST(metrics, RootLoggerSnapshot) {
+    std::unique_ptr<mock::sink_t> sink(new mock::sink_t);
+    EXPECT_CALL(*sink, emit(_, _))
+        .Times(2);
+
+    std::vector<std::unique_ptr<handler_t>> handlers;
+    handlers.push_back(builder<handler::blocking_t>()
+        .set(builder<formatter::string_t>("{message}").build())
+        .add(std::move(sink))
+        .build());
+
+    root_logger_t logger([](const record_t& record) -> bool {
+        return record.severity() != 1;
+    }, std::move(handlers));
+
+    logger.log(0, "GET");
+    logger.log(0, "POST");
+    logger.log(1, "PUT");
+
+    const auto snapshot = logger.metrics();
+
+    const auto records = find(snapshot, "blackhole_records_total");
+    ASSERT_NE(nullptr, records);
+    EXPECT_EQ(2, records->value);
+
+    const auto filtered = find(snapshot, "blackhole_records_filtered_total");
+    ASSERT_NE(nullptr, filtered);
+    EXPECT_EQ(1, filtered->value);
+
+    const auto bytes = find(snapshot, "blackhole_sink_bytes_total", {{"handler", "0"}, {"sink", "0"}});
+    ASSERT_NE(nullptr, bytes);
+    EXPECT_EQ(7, bytes->value);
+
+    const auto emit = find(snapshot, "blackhole_sink_emit_seconds", {{"handler", "0"}, {"sink", "0"}});
+    ASSERT_NE(nullptr, emit);
+    EXPECT_EQ(metrics::sample_t::kind_t::histogram, emit->kind);
+    EXPECT_EQ(2, emit->value);
+}
+
+TEST(metrics, StagesOfSampledRecords) {
+    std::unique_ptr<mock::sink_t> sink(new mock::sink_t);
+    EXPECT_CALL(*sink, emit(_, _))
+        .Times(4);
+
+    auto root = logger(std::move(sink));
+
+    const auto capture = count(stage::id_t::capture);
+    const auto filter = count(stage::id_t::filter);
+    const auto format = count(stage::id_t::format);
+    const auto write = count(stage::id_t::write);
+
+    stage::sample(2);
+    for (int id = 0; id < 4; ++id) {
+        root.log(0, "GET");
+    }
+    stage::sample(0);
+
+    EXPECT_EQ(capture + 2, count(stage::id_t::capture));
+    EXPECT_EQ(filter + 2, count(stage::id_t::filter));
+    EXPECT_EQ(format + 2, count(stage::id_t::format));
+    EXPECT_EQ(write + 2, count(stage::id_t::write));
+}
+
+TEST(metrics, StagesOfSampledRecordsInAsynchronousSinks) {
+    std::unique_ptr<mock::sink_t> wrapped(new mock::sink_t);
+    EXPECT_CALL(*wrapped, emit(_, _))
+        .Times(3);
+
+    const auto enqueue = count(stage::id_t::enqueue);
+    const auto queue = count(stage::id_t::queue);
+    const auto write = count(stage::id_t::write);
+
+    stage::sample(1);
+    {
+        auto root = logger(std::unique_ptr<sink_t>(new sink::asynchronous_t(std::move(wrapped))));
+
+        for (int id = 0; id < 3; ++id) {
+            root.log(0, "GET");
+        }
+
+        EXPECT_EQ(enqueue + 3, count(stage::id_t::enqueue));
+    }
+    stage::sample(0);
+
+    EXPECT_EQ(queue + 3, count(stage::id_t::queue));
+    EXPECT_EQ(write + 3, count(stage::id_t::write));
+}
+
+TEST(metrics, StagesInRootLoggerSnapshot) {
+    auto root = logger(std::unique_ptr<sink_t>(new mock::sink_t));
+
+    EXPECT_EQ(nullptr, find(root.metrics(), "blackhole_stage_seconds", {{"stage", "capture"}}));
+
+    stage::sample(1);
+    const auto snapshot = root.metrics();
+    stage::sample(0);
+
+    for (const auto name : {"capture", "filter", "format", "enqueue", "queue", "write"}) {
+        const auto sample = find(snapshot, "blackhole_stage_seconds", {{"stage", name}});
+        ASSERT_NE(nullptr, sample);
+        EXPECT_EQ(metrics::sample_t::kind_t::histogram, sample->kind);
+    }
+}
+
+namespace {
+
+/// Burns the given CPU time of the calling thread.
+auto spin(std::uint64_t nanoseconds) -> void {
+    const auto start = detail::cputime::now();
+    while (detail::cputime::now() - start < nanoseconds) {}
+}
+
+}  // namespace
+
+TEST(metrics, CpuTimeOfAccountedRecords) {
+    std::unique_ptr<mock::sink_t> sink(new mock::sink_t);
+    EXPECT_CALL(*sink, emit(_, _))
+        .Times(4)
+        .WillRepeatedly(InvokeWithoutArgs([] { spin(1000000); }));
+
+    auto root = logger(std::move(sink));
+
+    const auto spent = cputime::spent();
+
+    cputime::sample(2);
+    for (int id = 0; id < 4; ++id) {
+        root.log(0, "GET");
+    }
+    cputime::sample(0);
+
+    // Two accounted records, each of which stands for two ones.
+    EXPECT_LE(spent + 4000000, cputime::spent());
+}
+
+TEST(metrics, CpuTimeInRootLoggerSnapshot) {
+    auto root = logger(std::unique_ptr<sink_t>(new mock::sink_t));
+
+    EXPECT_EQ(nullptr, find(root.metrics(), "blackhole_log_cpu_exited_nanoseconds_total"));
+
+    cputime::sample(1);
+    root.log(0, "GET");
+    const auto snapshot = root.metrics();
+    cputime::sample(0);
+
+    EXPECT_NE(nullptr, find(snapshot, "blackhole_log_cpu_exited_nanoseconds_total"));
+
+    const auto tid = std::make_pair(std::string("tid"), std::to_string(detail::this_thread::lwp()));
+
+    std::size_t found = 0;
+    for (const auto& sample : snapshot) {
+        if (sample.labels.size() != 2 || sample.labels[1] != tid) {
+            continue;
+        }
+
+        if (sample.name == "blackhole_log_cpu_nanoseconds_total") {
+            EXPECT_LE(cputime::spent(), sample.value);
+            ++found;
+        } else if (sample.name == "blackhole_thread_cpu_nanoseconds_total") {
+            EXPECT_LT(0u, sample.value);
+            ++found;
+        }
+    }
+
+    EXPECT_EQ(2, found);
+}
+
+TEST(metrics, CpuTimeOfAsynchronousConsumers) {
+    std::unique_ptr<mock::sink_t> wrapped(new mock::sink_t);
+    EXPECT_CALL(*wrapped, emit(_, _))
+        .Times(2)
+        .WillRepeatedly(InvokeWithoutArgs([] { spin(1000000); }));
+
+    auto root = logger(std::unique_ptr<sink_t>(new sink::asynchronous_t(std::move(wrapped))));
+
+    EXPECT_EQ(nullptr, find(root.metrics(), "blackhole_consumer_cpu_nanoseconds_total",
+        {{"handler", "0"}, {"sink", "0"}}));
+
+    cputime::sample(1);
+    root.log(0, "GET");
+    root.log(0, "GET");
+    ASSERT_TRUE(root.flush(std::chrono::seconds(10)));
+
+    const auto snapshot = root.metrics();
+    cputime::sample(0);
+
+    const auto sample = find(snapshot, "blackhole_consumer_cpu_nanoseconds_total",
+        {{"handler", "0"}, {"sink", "0"}});
+    ASSERT_NE(nullptr, sample);
+    EXPECT_LE(2000000, sample->value);
+}
+
+}  // namespace testing
+}  // namespace blackhole
@@ -0,0 +1,123 @@
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <blackhole/attribute.hpp>
+#include <blackhole/attributes.hpp>
+#include <blackhole/pipeline.hpp>
+#include <blackhole/record.hpp>
+#include <blackhole/sink.hpp>
+#include <blackhole/wrapper.hpp>
+#include <blackhole/extensions/facade.hpp>
+#include <blackhole/scope/holder.hpp>
+
+#include "mocks/sink.hpp"
+
+namespace blackhole {
+namespace testing {
+namespace {
+
+using ::testing::_;
+using ::testing::Invoke;
+
+/// Sink collecting messages together with the number of attributes of each record.
+struct collecting_t {
+    std::vector<std::string>* messages;
+    std::vector<std::size_t>* attributes;
+
+    auto emit(const record_t& record, const string_view& message) -> void {
+        messages->push_back(message.to_string());
+
+        std::size_t size = 0;
+        for (const auto& list : record.attributes()) {
+            size += list.get().size();
+        }
+        attributes->push_back(size);
+    }
+};
+
+struct throwing_t {
+    auto emit(const record_t&, const string_view&) -> void {
+        throw std::runtime_error("emit");
+    }
+};
+
+typedef static_logger_t<pipeline::severity<2>, pipeline::message, collecting_t> logger_type;
+
+TEST(static_logger_t, LogsFormattedMessage) {
+    std::vector<std::string> messages;
+    std::vector<std::size_t> attributes;
+    logger_type logger({}, {}, {&messages, &attributes});
+
+    logger_facade<logger_type> facade(logger);
+    facade.log(3, "{} - {}", 42, "value");
+
+    EXPECT_EQ((std::vector<std::string>{"42 - value"}), messages);
+}
+
+TEST(static_logger_t, FiltersBySeverity) {
+    std::vector<std::string> messages;
+    std::vector<std::size_t> attributes;
+    logger_type logger({}, {}, {&messages, &attributes});
+
+    logger.log(1, "-");
+    logger.log(2, "+");
+
+    EXPECT_EQ((std::vector<std::string>{"+"}), messages);
+}
+
+TEST(static_logger_t, DoesNotFormatFilteredMessage) {
+    std::vector<std::string> messages;
+    std::vector<std::size_t> attributes;
+    logger_type logger({}, {}, {&messages, &attributes});
+
+    bool called = false;
+    const auto supplier = [&]() -> string_view {
+        called = true;
+        return "+";
+    };
+
+    attribute_pack pack;
+    logger.log(1, lazy_message_t{"-", supplier}, pack);
+
+    EXPECT_FALSE(called);
+    EXPECT_TRUE(messages.empty());
+}
+
+TEST(static_logger_t, AttachesWrapperAndScopedAttributes) {
+    std::vector<std::string> messages;
+    std::vector<std::size_t> attributes;
+    logger_type logger({}, {}, {&messages, &attributes});
+
+    wrapper_t wrapper(logger, {{"key#1", {42}}});
+    const scope::holder_t scoped(wrapper, {{"key#2", {"value"}}});
+
+    wrapper.log(2, "message");
+
+    ASSERT_EQ(1, attributes.size());
+    EXPECT_EQ(2, attributes[0]);
+}
+
+TEST(static_logger_t, EmitsIntoOwnedSink) {
+    std::unique_ptr<mock::sink_t> sink(new mock::sink_t);
+    EXPECT_CALL(*sink, emit(_, string_view("message")))
+        .Times(1);
+
+    static_logger_t<pipeline::accept, pipeline::message, std::unique_ptr<sink_t>> logger({}, {},
+        std::move(sink));
+
+    logger.log(0, "message");
+}
+
+TEST(static_logger_t, CatchesSinkExceptions) {
+    static_logger_t<pipeline::accept, pipeline::message, throwing_t> logger;
+
+    EXPECT_NO_THROW(logger.log(0, "message"));
+}
+
+}  // namespace
+}  // namespace testing
+}  // namespace blackhole
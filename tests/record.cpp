@@ -1,11 +1,44 @@
+#include <algorithm>
+#include <string>
+#include <vector>
+
 #include <gtest/gtest.h>
 
 #include <blackhole/attribute.hpp>
+#include <blackhole/attribute/key.hpp>
+#include <blackhole/attribute/table.hpp>
 #include <blackhole/record.hpp>
+#include <blackhole/record/binary.hpp>
+#include <blackhole/scope/span.hpp>
+#include <blackhole/extensions/writer.hpp>
 
 namespace blackhole {
 namespace testing {
 
+TEST(Record, TraceEmptyByDefault) {
+    const string_view message("GET /porn.png HTTP/1.1");
+    const attribute_pack pack;
+
+    record_t record(0, message, pack);
+
+    EXPECT_TRUE(record.trace().empty());
+    EXPECT_EQ(0, record.trace().span);
+}
+
+TEST(Record, TraceFromThreadContext) {
+    const string_view message("GET /porn.png HTTP/1.1");
+    const attribute_pack pack;
+
+    const trace_t trace{1, 2, 3};
+    scope::span_t span(trace);
+
+    record_t record(0, message, pack);
+
+    EXPECT_EQ(1, record.trace().hi);
+    EXPECT_EQ(2, record.trace().lo);
+    EXPECT_EQ(3, record.trace().span);
+}
+
 TEST(Record, Severity) {
     const string_view message("GET /porn.png HTTP/1.1");
     const attribute_pack pack;
@@ -24,6 +57,31 @@ TEST(Record, Message) {
     EXPECT_EQ("GET /porn.png HTTP/1.1", record.message().to_string());
 }
 
+TEST(Record, PatternIdentity) {
+    const char* pattern = "GET {} HTTP/1.1";
+    const string_view m1(pattern, 15);
+    const string_view m2(pattern, 15);
+    const string_view m3("GET {} HTTP/1.1");
+    const attribute_pack pack;
+
+    record_t r1(42, m1, pack);
+    record_t r2(42, m2, pack);
+    record_t r3(42, m3, pack);
+
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(pattern), r1.pattern_id());
+    EXPECT_EQ(r1.pattern_id(), r2.pattern_id());
+    EXPECT_EQ(r1.pattern_hash(), r2.pattern_hash());
+
+    // Formatting doesn't change the identity.
+    const string_view formatted("GET /porn.png HTTP/1.1");
+    r2.activate(formatted);
+    EXPECT_EQ(r1.pattern_hash(), r2.pattern_hash());
+
+    if (r3.pattern_id() != r1.pattern_id()) {
+        EXPECT_NE(r1.pattern_hash(), r3.pattern_hash());
+    }
+}
+
 TEST(Record, Attributes) {
     const string_view message("GET /porn.png HTTP/1.1");
     const view_of<attributes_t>::type attributes{{"key#1", {42}}};
@@ -52,6 +110,14 @@ TEST(Record, Tid) {
     EXPECT_EQ(::pthread_self(), record.tid());
 }
 
+TEST(Record, Lwp) {
+    const string_view message("GET /porn.png HTTP/1.1");
+    const attribute_pack pack;
+
+    record_t record(42, message, pack);
+    EXPECT_NE(0, record.lwp());
+}
+
 TEST(Record, NullTimestampByDefault) {
     const string_view message("GET /porn.png HTTP/1.1");
     const attribute_pack pack;
@@ -106,5 +172,280 @@ TEST(Record, IsActive) {
     EXPECT_TRUE(record.is_active());
 }
 
+TEST(Record, UniqueAttributes) {
+    const string_view message("GET /porn.png HTTP/1.1");
+    const view_of<attributes_t>::type a1{{"key#1", {42}}, {"key#2", {"v1"}}};
+    const view_of<attributes_t>::type a2{{"key#2", {"v2"}}, {"key#3", {3.1415}}, {"key#1", {0}}};
+    const attribute_pack pack{a1, a2};
+
+    record_t record(42, message, pack);
+
+    const auto& unique = record.unique_attributes();
+    ASSERT_EQ(3, unique.size());
+
+    auto it = unique.begin();
+    EXPECT_EQ(a1[0], *it++);
+    EXPECT_EQ(a1[1], *it++);
+    EXPECT_EQ(a2[1], *it++);
+    EXPECT_TRUE(it == unique.end());
+}
+
+TEST(Record, UniqueAttributesAttached) {
+    const string_view message("GET /porn.png HTTP/1.1");
+    const view_of<attributes_t>::type attributes{{"key#1", {42}}, {"key#1", {0}}};
+    const attribute_pack pack{attributes};
+
+    const unique_attributes_t unique(pack);
+
+    record_t record(42, message, pack);
+    record.attach(unique);
+
+    EXPECT_EQ(&unique, &record.unique_attributes());
+    ASSERT_EQ(1, unique.size());
+    EXPECT_EQ(attributes[0], *unique.begin());
+}
+
+TEST(Record, UniqueAttributesPreservesOrderOnLargePacks) {
+    const string_view message("GET /porn.png HTTP/1.1");
+
+    std::vector<std::string> names;
+    for (int id = 0; id < 40; ++id) {
+        names.push_back("key#" + std::to_string(40 - id));
+    }
+
+    view_of<attributes_t>::type a1;
+    view_of<attributes_t>::type a2;
+    for (int id = 0; id < 40; ++id) {
+        a1.emplace_back(names[id], attribute::view_t(id));
+        a2.emplace_back(names[id], attribute::view_t(id + 100));
+    }
+
+    const attribute_pack pack{a1, a2};
+
+    record_t record(42, message, pack);
+
+    const auto& unique = record.unique_attributes();
+    ASSERT_EQ(40, unique.size());
+
+    int id = 0;
+    for (const auto& attribute : unique) {
+        EXPECT_EQ(a1[id++], attribute);
+    }
+}
+
+TEST(Record, Table) {
+    const string_view message("GET /porn.png HTTP/1.1");
+    const view_of<attributes_t>::type attributes{
+        {"key#1", {42}}, {"key#2", {"value"}}, {"key#1", {0}}
+    };
+    const attribute_pack pack{attributes};
+
+    record_t record(42, message, pack);
+
+    const auto& table = record.table();
+    ASSERT_EQ(2, table.size());
+    EXPECT_EQ("key#1", table.keys()[0].to_string());
+    EXPECT_EQ("key#2", table.keys()[1].to_string());
+    EXPECT_EQ(attribute::table_t::tag_t::sint64, table.tags()[0]);
+    EXPECT_EQ(attribute::table_t::tag_t::string, table.tags()[1]);
+    EXPECT_EQ(&attributes[1].second, table.values()[1]);
+
+    ASSERT_NE(nullptr, table.find("key#1"));
+    EXPECT_EQ(attribute::view_t(42), *table.find("key#1"));
+    EXPECT_EQ(nullptr, table.find("key#3"));
+
+    const attribute::key_t key(string_view("key#2"));
+    EXPECT_EQ(&attributes[1].second, table.find(key));
+}
+
+TEST(Record, TableAttached) {
+    const string_view message("GET /porn.png HTTP/1.1");
+    const view_of<attributes_t>::type attributes{{"key#1", {42}}};
+    const attribute_pack pack{attributes};
+
+    const unique_attributes_t unique(pack);
+    const attribute::table_t table(unique);
+
+    record_t record(42, message, pack);
+    record.attach(unique);
+    record.attach(table);
+
+    EXPECT_EQ(&table, &record.table());
+    EXPECT_EQ(&attributes[0].second, table.find("key#1"));
+}
+
+TEST(Record, TableOverflowsInlineColumns) {
+    const string_view message("GET /porn.png HTTP/1.1");
+
+    std::vector<std::string> names;
+    for (int id = 0; id < 40; ++id) {
+        names.push_back("key#" + std::to_string(id));
+    }
+
+    view_of<attributes_t>::type attributes;
+    for (int id = 0; id < 40; ++id) {
+        attributes.emplace_back(names[id], attribute::view_t(id));
+    }
+
+    const attribute_pack pack{attributes};
+
+    record_t record(42, message, pack);
+
+    const auto& table = record.table();
+    ASSERT_EQ(40, table.size());
+
+    for (int id = 0; id < 40; ++id) {
+        ASSERT_NE(nullptr, table.find(names[id]));
+        EXPECT_EQ(attribute::view_t(id), *table.find(names[id]));
+    }
+}
+
+TEST(Binary, Roundtrip) {
+    const string_view message("GET /porn.png HTTP/1.1: {}");
+    const string_view formatted("GET /porn.png HTTP/1.1: 200");
+    const view_of<attributes_t>::type a1{{"key#1", {42}}, {"key#2", {"value"}}};
+    const view_of<attributes_t>::type a2{
+        {"key#3", {-100}},
+        {"key#4", {std::uint64_t(1) << 60}},
+        {"key#5", {3.1415}},
+        {"key#6", {true}},
+        {"key#7", {nullptr}}
+    };
+    const attribute_pack pack{a1, a2};
+
+    record_t record(-7, message, pack);
+    record.activate(formatted);
+
+    binary::encoder_t encoder;
+    std::string buffer;
+    encoder.encode(record, buffer);
+
+    binary::decoder_t decoder;
+    ASSERT_EQ(buffer.size(), decoder.decode(buffer.data(), buffer.size()));
+
+    const auto& result = decoder.record();
+    EXPECT_EQ(-7, result.severity());
+    EXPECT_EQ(record.timestamp(), result.timestamp());
+    EXPECT_EQ(record.tid(), result.tid());
+    EXPECT_EQ(record.lwp(), result.lwp());
+    EXPECT_EQ(message, result.message());
+    EXPECT_EQ(formatted, result.formatted());
+
+    ASSERT_EQ(1, result.attributes().size());
+
+    view_of<attributes_t>::type expected(a1.begin(), a1.end());
+    expected.insert(expected.end(), a2.begin(), a2.end());
+    EXPECT_EQ(expected, result.attributes().at(0).get());
+}
+
+TEST(Binary, FormattedSameAsMessageIsNotDuplicated) {
+    const string_view message("GET /porn.png HTTP/1.1");
+    const attribute_pack pack;
+
+    record_t record(0, message, pack);
+    record.activate(message);
+
+    binary::encoder_t encoder;
+    std::string buffer;
+    encoder.encode(record, buffer);
+
+    EXPECT_EQ(1, std::count(buffer.begin(), buffer.end(), 'G'));
+
+    binary::decoder_t decoder;
+    ASSERT_EQ(buffer.size(), decoder.decode(buffer.data(), buffer.size()));
+    EXPECT_EQ(message, decoder.record().formatted());
+}
+
+TEST(Binary, KeysAreDefinedOnce) {
+    const string_view message("GET /porn.png HTTP/1.1");
+    const view_of<attributes_t>::type attributes{{"a-very-unique-key", {42}}};
+    const attribute_pack pack{attributes};
+
+    record_t record(0, message, pack);
+    record.activate();
+
+    binary::encoder_t encoder;
+    std::string buffer;
+    encoder.encode(record, buffer);
+    const auto first = buffer.size();
+    encoder.encode(record, buffer);
+
+    EXPECT_EQ(std::string::npos, buffer.find("a-very-unique-key", first));
+
+    binary::decoder_t decoder;
+    std::size_t offset = 0;
+    for (int id = 0; id < 2; ++id) {
+        const auto size = decoder.decode(buffer.data() + offset, buffer.size() - offset);
+        ASSERT_NE(0, size);
+        offset += size;
+
+        EXPECT_EQ(record.timestamp(), decoder.record().timestamp());
+        EXPECT_EQ(attributes, decoder.record().attributes().at(0).get());
+    }
+
+    EXPECT_EQ(buffer.size(), offset);
+}
+
+namespace {
+
+auto milliseconds(const void* value, writer_t& wr) -> void {
+    wr.write("{}ms", *static_cast<const int*>(value));
+}
+
+}  // namespace
+
+TEST(Binary, FunctionValuesAreFormatted) {
+    const string_view message("GET /porn.png HTTP/1.1");
+    const int elapsed = 42;
+    const attribute::view_t::function_type fn{&elapsed, std::ref(milliseconds)};
+    const view_of<attributes_t>::type attributes{{"elapsed", attribute::view_t(fn)}};
+    const attribute_pack pack{attributes};
+
+    record_t record(0, message, pack);
+    record.activate();
+
+    binary::encoder_t encoder;
+    std::string buffer;
+    encoder.encode(record, buffer);
+
+    binary::decoder_t decoder;
+    ASSERT_EQ(buffer.size(), decoder.decode(buffer.data(), buffer.size()));
+
+    const view_of<attributes_t>::type expected{{"elapsed", {"42ms"}}};
+    EXPECT_EQ(expected, decoder.record().attributes().at(0).get());
+}
+
+TEST(Binary, IncompleteFrame) {
+    const string_view message("GET /porn.png HTTP/1.1");
+    const view_of<attributes_t>::type attributes{{"key#1", {42}}};
+    const attribute_pack pack{attributes};
+
+    record_t record(0, message, pack);
+    record.activate();
+
+    binary::encoder_t encoder;
+    std::string buffer;
+    encoder.encode(record, buffer);
+
+    binary::decoder_t decoder;
+    for (std::size_t size = 0; size < buffer.size(); ++size) {
+        EXPECT_EQ(0, decoder.decode(buffer.data(), size));
+    }
+
+    EXPECT_EQ(buffer.size(), decoder.decode(buffer.data(), buffer.size()));
+}
+
+TEST(Binary, ThrowsOnMalformedFrame) {
+    binary::decoder_t decoder;
+
+    // Body claims an undefined attribute key.
+    const char undefined[] = {9, 0, 0, 0, 0, 0, 0, 0, 1, 5};
+    EXPECT_THROW(decoder.decode(undefined, sizeof(undefined)), std::invalid_argument);
+
+    // Body is shorter than its own fields.
+    const char truncated[] = {2, 0, 0};
+    EXPECT_THROW(decoder.decode(truncated, sizeof(truncated)), std::invalid_argument);
+}
+
 }  // namespace testing
 }  // namespace blackhole
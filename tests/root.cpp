@@ -1,12 +1,29 @@
+#include <atomic>
+#include <condition_variable>
+#include <stdexcept>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
 #include <blackhole/attribute.hpp>
+#include <blackhole/attribute/table.hpp>
+#include <blackhole/attributes.hpp>
+#include <blackhole/clock.hpp>
+#include <blackhole/error.hpp>
+#include <blackhole/executor.hpp>
 #include <blackhole/extensions/writer.hpp>
 #include <blackhole/logger.hpp>
+#include <blackhole/metrics.hpp>
+#include <blackhole/pressure.hpp>
 #include <blackhole/record.hpp>
 #include <blackhole/root.hpp>
 #include <blackhole/scope/holder.hpp>
+#include <blackhole/scope/manager.hpp>
 
 #include "mocks/handler.hpp"
 
@@ -14,6 +31,7 @@ namespace blackhole {
 namespace testing {
 
 using ::testing::Invoke;
+using ::testing::Return;
 using ::testing::Throw;
 using ::testing::_;
 using ::testing::internal::CaptureStdout;
@@ -37,6 +55,128 @@ TEST(RootLogger, FilterConstructor) {
     EXPECT_EQ(1, passed);
 }
 
+TEST(RootLogger, FilterReplacementKeepsHandlers) {
+    std::unique_ptr<mock::handler_t> handler(new mock::handler_t);
+    mock::handler_t* view = handler.get();
+
+    std::vector<std::unique_ptr<handler_t>> handlers;
+    handlers.push_back(std::move(handler));
+
+    root_logger_t logger(std::move(handlers));
+
+    EXPECT_CALL(*view, handle(_))
+        .Times(1)
+        .WillOnce(Invoke([](const record_t& record) {
+            EXPECT_EQ(1, record.severity());
+        }));
+
+    logger.filter([](const record_t& record) -> bool {
+        return record.severity() > 0;
+    });
+
+    logger.log(0, "-");
+    logger.log(1, "-");
+}
+
+TEST(RootLogger, DefaultThresholdPassesEverything) {
+    root_logger_t logger({});
+
+    EXPECT_EQ(std::numeric_limits<int>::min(), logger.threshold());
+    EXPECT_TRUE(logger.enabled(std::numeric_limits<int>::min()));
+    EXPECT_TRUE(logger.enabled(0));
+}
+
+TEST(RootLogger, ThresholdRejectsBeforeFilterAndHandlers) {
+    int passed = 0;
+
+    std::unique_ptr<mock::handler_t> handler(new mock::handler_t);
+    mock::handler_t* view = handler.get();
+
+    std::vector<std::unique_ptr<handler_t>> handlers;
+    handlers.push_back(std::move(handler));
+
+    root_logger_t logger([&](const record_t&) -> bool {
+        passed++;
+        return true;
+    }, std::move(handlers));
+
+    logger.threshold(2);
+
+    EXPECT_FALSE(logger.enabled(1));
+    EXPECT_TRUE(logger.enabled(2));
+
+    EXPECT_CALL(*view, handle(_))
+        .Times(1)
+        .WillOnce(Invoke([](const record_t& record) {
+            EXPECT_EQ(2, record.severity());
+        }));
+
+    logger.log(1, "-");
+    logger.log(2, "-");
+
+    EXPECT_EQ(1, passed);
+}
+
+TEST(RootLogger, MoveConstructorMovesThreshold) {
+    root_logger_t original({});
+    original.threshold(42);
+
+    root_logger_t logger(std::move(original));
+
+    EXPECT_EQ(42, logger.threshold());
+}
+
+TEST(RootLogger, ClockIsPreciseByDefault) {
+    root_logger_t logger({});
+
+    EXPECT_EQ(clock_source_t::precise, logger.clock());
+}
+
+TEST(RootLogger, ActivatesRecordsUsingConfiguredClock) {
+    std::unique_ptr<mock::handler_t> handler(new mock::handler_t);
+    mock::handler_t* view = handler.get();
+
+    std::vector<std::unique_ptr<handler_t>> handlers;
+    handlers.push_back(std::move(handler));
+
+    root_logger_t logger(std::move(handlers));
+    logger.clock(clock_source_t::coarse);
+
+    const auto min = std::chrono::system_clock::now() - std::chrono::milliseconds(50);
+
+    EXPECT_CALL(*view, handle(_))
+        .Times(1)
+        .WillOnce(Invoke([&](const record_t& record) {
+            EXPECT_TRUE(record.is_active());
+            EXPECT_TRUE(min <= record.timestamp());
+        }));
+
+    logger.log(0, "-");
+
+    EXPECT_EQ(clock_source_t::coarse, logger.clock());
+}
+
+TEST(RootLogger, ActivatesRecordsUsingCachedTimestamp) {
+    std::unique_ptr<mock::handler_t> handler(new mock::handler_t);
+    mock::handler_t* view = handler.get();
+
+    std::vector<std::unique_ptr<handler_t>> handlers;
+    handlers.push_back(std::move(handler));
+
+    root_logger_t logger(std::move(handlers));
+
+    const std::chrono::system_clock::time_point timestamp(std::chrono::seconds(42));
+    const clock::cached_t cached(timestamp);
+
+    EXPECT_CALL(*view, handle(_))
+        .Times(1)
+        .WillOnce(Invoke([&](const record_t& record) {
+            EXPECT_EQ(timestamp, record.timestamp());
+        }));
+
+    logger.log(0, "-");
+}
+
 TEST(RootLogger, MoveConstructorMovesFilter) {
     int passed = 0;
 
@@ -113,9 +253,9 @@ TEST(RootLogger, MoveConstructorMovesNestedScopedAttributes) {
     EXPECT_CALL(*view, handle(_))
         .Times(2)
         .WillOnce(Invoke([](const record_t& record) {
-            ASSERT_EQ(2, record.attributes().size());
-            EXPECT_EQ((attribute_list{{"key#2", {"value#2"}}}), record.attributes().at(0).get());
-            EXPECT_EQ((attribute_list{{"key#1", {42}}}), record.attributes().at(1).get());
+            ASSERT_EQ(1, record.attributes().size());
+            EXPECT_EQ((attribute_list{{"key#2", {"value#2"}}, {"key#1", {42}}}),
+                record.attributes().at(0).get());
         }))
         .WillOnce(Invoke([](const record_t& record) {
             ASSERT_EQ(1, record.attributes().size());
@@ -290,6 +430,58 @@ TEST(RootLogger, LogWithScopedAttributes) {
     logger.log(0, "GET /porn.png HTTP/1.1");
 }
 
+TEST(RootLogger, ReusesPackForEventsWithoutAttributes) {
+    std::unique_ptr<mock::handler_t> handler(new mock::handler_t);
+    mock::handler_t* view = handler.get();
+
+    std::vector<std::unique_ptr<handler_t>> handlers;
+    handlers.push_back(std::move(handler));
+
+    std::vector<const attribute_pack*> packs;
+
+    EXPECT_CALL(*view, handle(_))
+        .Times(2)
+        .WillRepeatedly(Invoke([&](const record_t& record) {
+            packs.push_back(&record.attributes());
+        }));
+
+    root_logger_t logger(std::move(handlers));
+
+    logger.log(0, "GET /porn.png HTTP/1.1");
+    logger.log(0, "GET /porn.png HTTP/1.1");
+
+    ASSERT_EQ(2, packs.size());
+    EXPECT_EQ(packs[0], packs[1]);
+}
+
+TEST(RootLogger, ReentrantEventsUseOwnPack) {
+    std::unique_ptr<mock::handler_t> handler(new mock::handler_t);
+    mock::handler_t* view = handler.get();
+
+    std::vector<std::unique_ptr<handler_t>> handlers;
+    handlers.push_back(std::move(handler));
+
+    root_logger_t logger(std::move(handlers));
+    const scope::holder_t scoped(logger, {{"key#1", {42}}});
+
+    const attribute_pack* inner = nullptr;
+
+    EXPECT_CALL(*view, handle(_))
+        .Times(2)
+        .WillOnce(Invoke([&](const record_t& record) {
+            logger.log(0, "nested");
+
+            ASSERT_EQ(1, record.attributes().size());
+            EXPECT_NE(inner, &record.attributes());
+        }))
+        .WillOnce(Invoke([&](const record_t& record) {
+            inner = &record.attributes();
+            EXPECT_EQ(1, record.attributes().size());
+        }));
+
+    logger.log(0, "GET /porn.png HTTP/1.1");
+}
+
 TEST(RootLogger, LogWithNestedScopedAttributes) {
     typedef view_of<attributes_t>::type attribute_list;
 
@@ -302,9 +494,9 @@ TEST(RootLogger, LogWithNestedScopedAttributes) {
     EXPECT_CALL(*view, handle(_))
         .Times(2)
         .WillOnce(Invoke([](const record_t& record) {
-            ASSERT_EQ(2, record.attributes().size());
-            EXPECT_EQ((attribute_list{{"key#2", {100}}}), record.attributes().at(0).get());
-            EXPECT_EQ((attribute_list{{"key#1", {42}}}), record.attributes().at(1).get());
+            ASSERT_EQ(1, record.attributes().size());
+            EXPECT_EQ((attribute_list{{"key#2", {100}}, {"key#1", {42}}}),
+                record.attributes().at(0).get());
         }))
         .WillOnce(Invoke([](const record_t& record) {
             ASSERT_EQ(1, record.attributes().size());
@@ -323,6 +515,94 @@ TEST(RootLogger, LogWithNestedScopedAttributes) {
     logger.log(0, "GET /porn.png HTTP/1.1");
 }
 
+TEST(RootLogger, LogWithDeeplyNestedScopedAttributes) {
+    std::unique_ptr<mock::handler_t> handler(new mock::handler_t);
+    mock::handler_t* view = handler.get();
+
+    std::vector<std::unique_ptr<handler_t>> handlers;
+    handlers.push_back(std::move(handler));
+
+    std::vector<std::size_t> sizes;
+    std::vector<std::int64_t> firsts;
+
+    EXPECT_CALL(*view, handle(_))
+        .Times(3)
+        .WillRepeatedly(Invoke([&](const record_t& record) {
+            ASSERT_EQ(1, record.attributes().size());
+
+            const auto& attributes = record.attributes().at(0).get();
+            sizes.push_back(attributes.size());
+            firsts.push_back(attribute::get<std::int64_t>(attributes.front().second));
+        }));
+
+    root_logger_t logger(std::move(handlers));
+
+    std::vector<std::unique_ptr<scope::holder_t>> scopes;
+    for (int id = 0; id < 50; ++id) {
+        scopes.emplace_back(new scope::holder_t(logger, {{"id", {id}}}));
+    }
+
+    logger.log(0, "-");
+    logger.log(0, "-");
+
+    // Scopes must be destroyed in reversed order.
+    while (scopes.size() > 10) {
+        scopes.pop_back();
+    }
+
+    logger.log(0, "-");
+
+    while (!scopes.empty()) {
+        scopes.pop_back();
+    }
+
+    EXPECT_EQ((std::vector<std::size_t>{50, 50, 10}), sizes);
+    EXPECT_EQ((std::vector<std::int64_t>{49, 49, 9}), firsts);
+}
+
+TEST(RootLogger, ScopedAttributesOfManyLoggers) {
+    std::vector<std::unique_ptr<root_logger_t>> loggers;
+    std::vector<std::unique_ptr<scope::holder_t>> scopes;
+
+    for (int id = 0; id < 40; ++id) {
+        loggers.emplace_back(new root_logger_t({}));
+        scopes.emplace_back(new scope::holder_t(*loggers.back(), {{"id", {id}}}));
+    }
+
+    for (int id = 0; id < 40; ++id) {
+        const auto watcher = loggers[id]->manager().get();
+        ASSERT_NE(nullptr, watcher);
+        EXPECT_EQ(scopes[id].get(), watcher);
+    }
+
+    std::thread([&] {
+        for (const auto& logger : loggers) {
+            EXPECT_EQ(nullptr, logger->manager().get());
+        }
+    }).join();
+
+    while (!scopes.empty()) {
+        scopes.pop_back();
+    }
+}
+
+TEST(RootLogger, NewLoggerDoesNotInheritStaleScopedAttributes) {
+    std::unique_ptr<root_logger_t> original(new root_logger_t({}));
+    root_logger_t logger({});
+
+    {
+        const scope::holder_t scoped(*original, {{"key#1", {42}}});
+        // Moving leaves the source manager pointing to the transferred watcher.
+        logger = std::move(*original);
+    }
+
+    original.reset();
+
+    // Possibly reuses the id of the destroyed logger.
+    root_logger_t fresh({});
+    EXPECT_EQ(nullptr, fresh.manager().get());
+}
+
 TEST(RootLogger, AssignmentMovesScopedAttributes) {
     typedef view_of<attributes_t>::type attribute_list;
 
@@ -362,9 +642,9 @@ TEST(RootLogger, AssignmentMovesNestedScopedAttributes) {
     EXPECT_CALL(*view, handle(_))
         .Times(2)
         .WillOnce(Invoke([](const record_t& record) {
-            ASSERT_EQ(2, record.attributes().size());
-            EXPECT_EQ((attribute_list{{"key#2", {"value#2"}}}), record.attributes().at(0).get());
-            EXPECT_EQ((attribute_list{{"key#1", {42}}}), record.attributes().at(1).get());
+            ASSERT_EQ(1, record.attributes().size());
+            EXPECT_EQ((attribute_list{{"key#2", {"value#2"}}, {"key#1", {42}}}),
+                record.attributes().at(0).get());
         }))
         .WillOnce(Invoke([](const record_t& record) {
             ASSERT_EQ(1, record.attributes().size());
@@ -395,15 +675,14 @@ TEST(RootLogger, AssignmentMovesNestedTripleScopedAttributes) {
     EXPECT_CALL(*view, handle(_))
         .Times(3)
         .WillOnce(Invoke([](const record_t& record) {
-            ASSERT_EQ(3, record.attributes().size());
-            EXPECT_EQ((attribute_list{{"key#3", {100}}}), record.attributes().at(0).get());
-            EXPECT_EQ((attribute_list{{"key#2", {"value#2"}}}), record.attributes().at(1).get());
-            EXPECT_EQ((attribute_list{{"key#1", {42}}}), record.attributes().at(2).get());
+            ASSERT_EQ(1, record.attributes().size());
+            EXPECT_EQ((attribute_list{{"key#3", {100}}, {"key#2", {"value#2"}}, {"key#1", {42}}}),
+                record.attributes().at(0).get());
         }))
         .WillOnce(Invoke([](const record_t& record) {
-            ASSERT_EQ(2, record.attributes().size());
-            EXPECT_EQ((attribute_list{{"key#2", {"value#2"}}}), record.attributes().at(0).get());
-            EXPECT_EQ((attribute_list{{"key#1", {42}}}), record.attributes().at(1).get());
+            ASSERT_EQ(1, record.attributes().size());
+            EXPECT_EQ((attribute_list{{"key#2", {"value#2"}}, {"key#1", {42}}}),
+                record.attributes().at(0).get());
         }))
         .WillOnce(Invoke([](const record_t& record) {
             ASSERT_EQ(1, record.attributes().size());
@@ -437,6 +716,9 @@ TEST(RootLogger, IgnoresExceptionsFromHandlers) {
         .Times(1)
         .WillOnce(Throw(std::runtime_error("...")));
 
+    // Restarts rate limiting, so that errors of previous tests do not affect the report.
+    error::limit(error::limit());
+
     CaptureStdout();
     EXPECT_NO_THROW(logger.log(0, "GET /porn.png HTTP/1.1"));
 
@@ -455,6 +737,9 @@ TEST(RootLogger, IgnoresMarginalExceptionsFromHandlers) {
         .Times(1)
         .WillOnce(Throw(42));
 
+    // Restarts rate limiting, so that errors of previous tests do not affect the report.
+    error::limit(error::limit());
+
     CaptureStdout();
     EXPECT_NO_THROW(logger.log(0, "GET /porn.png HTTP/1.1"));
 
@@ -462,5 +747,384 @@ TEST(RootLogger, IgnoresMarginalExceptionsFromHandlers) {
     EXPECT_EQ("logging core error occurred: unknown\n", actual);
 }
 
+TEST(RootLogger, ReportsHandlerErrors) {
+    auto handler = new mock::handler_t;
+    std::vector<std::unique_ptr<handler_t>> handlers;
+    handlers.emplace_back(handler);
+
+    root_logger_t logger(std::move(handlers));
+
+    EXPECT_CALL(*handler, handle(_))
+        .Times(1)
+        .WillOnce(Throw(std::runtime_error("disk full")));
+
+    std::vector<std::string> reports;
+    error::reporter([&](error::kind_t kind, const string_view& message, std::uint64_t) {
+        reports.push_back(std::string(error::name(kind)) + ": " + message.to_string());
+    });
+
+    error::limit(error::limit());
+
+    const auto occurred = error::occurred(error::kind_t::handler);
+    logger.log(0, "GET /porn.png HTTP/1.1");
+    error::reporter(nullptr);
+
+    EXPECT_EQ(occurred + 1, error::occurred(error::kind_t::handler));
+    EXPECT_EQ((std::vector<std::string>{"handler: disk full"}), reports);
+
+    const auto snapshot = logger.metrics();
+    EXPECT_NE(std::string::npos, metrics::prometheus(snapshot).find(
+        "blackhole_internal_errors_total{kind=\"handler\"}"));
+}
+
+TEST(RootLogger, FlushesAllHandlers) {
+    auto h1 = new mock::handler_t;
+    auto h2 = new mock::handler_t;
+    std::vector<std::unique_ptr<handler_t>> handlers;
+    handlers.emplace_back(h1);
+    handlers.emplace_back(h2);
+
+    root_logger_t logger(std::move(handlers));
+
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+
+    EXPECT_CALL(*h1, flush(deadline))
+        .Times(1)
+        .WillOnce(Return(false));
+    EXPECT_CALL(*h2, flush(deadline))
+        .Times(1)
+        .WillOnce(Return(true));
+
+    EXPECT_FALSE(logger.flush(deadline));
+}
+
+TEST(RootLogger, OffloadThrowsOnModesMismatch) {
+    std::vector<std::unique_ptr<handler_t>> handlers;
+    handlers.emplace_back(new mock::handler_t);
+
+    root_logger_t logger(std::move(handlers));
+
+    EXPECT_THROW(logger.offload(std::make_shared<executor_t>(1), {}), std::invalid_argument);
+    EXPECT_THROW(logger.offload(nullptr, {root_logger_t::mode_t::parallel}),
+        std::invalid_argument);
+}
+
+TEST(RootLogger, ParallelHandlersAreAwaited) {
+    std::vector<std::unique_ptr<handler_t>> handlers;
+    std::vector<mock::handler_t*> handlers_view;
+
+    for (int i = 0; i < 3; ++i) {
+        std::unique_ptr<mock::handler_t> handler(new mock::handler_t);
+        handlers_view.push_back(handler.get());
+        handlers.push_back(std::move(handler));
+    }
+
+    const auto caller = std::this_thread::get_id();
+
+    std::mutex mutex;
+    std::vector<std::thread::id> threads;
+
+    for (auto handler : handlers_view) {
+        EXPECT_CALL(*handler, handle(_))
+            .Times(1)
+            .WillOnce(Invoke([&](const record_t& record) {
+                EXPECT_EQ("GET /porn.png HTTP/1.1", record.formatted().to_string());
+
+                std::lock_guard<std::mutex> lock(mutex);
+                threads.push_back(std::this_thread::get_id());
+            }));
+    }
+
+    root_logger_t logger(std::move(handlers));
+    logger.offload(std::make_shared<executor_t>(2), {
+        root_logger_t::mode_t::parallel,
+        root_logger_t::mode_t::blocking,
+        root_logger_t::mode_t::parallel
+    });
+
+    logger.log(0, "GET /porn.png HTTP/1.1");
+
+    ASSERT_EQ(3, threads.size());
+    EXPECT_EQ(1, std::count(threads.begin(), threads.end(), caller));
+}
+
+TEST(RootLogger, ParallelHandlersShareUniqueAttributes) {
+    std::vector<std::unique_ptr<handler_t>> handlers;
+    std::vector<mock::handler_t*> handlers_view;
+
+    for (int i = 0; i < 2; ++i) {
+        std::unique_ptr<mock::handler_t> handler(new mock::handler_t);
+        handlers_view.push_back(handler.get());
+        handlers.push_back(std::move(handler));
+    }
+
+    std::atomic<int> handled(0);
+    for (auto handler : handlers_view) {
+        EXPECT_CALL(*handler, handle(_))
+            .Times(100)
+            .WillRepeatedly(Invoke([&](const record_t& record) {
+                // Both handlers access lazily computed views of the same record concurrently.
+                EXPECT_EQ(40, record.unique_attributes().size());
+                EXPECT_EQ(40, record.table().size());
+                EXPECT_NE(nullptr, record.table().find("key#39"));
+                ++handled;
+            }));
+    }
+
+    root_logger_t logger(std::move(handlers));
+    logger.offload(std::make_shared<executor_t>(2), {
+        root_logger_t::mode_t::parallel,
+        root_logger_t::mode_t::parallel
+    });
+
+    // More attributes than deduplicated linearly and kept inline by the table.
+    std::vector<std::string> keys;
+    for (int i = 0; i < 40; ++i) {
+        keys.push_back("key#" + std::to_string(i));
+    }
+
+    view_of<attributes_t>::type attributes;
+    for (const auto& key : keys) {
+        attributes.emplace_back(key, 42);
+    }
+    attributes.emplace_back(keys.front(), 0);
+
+    for (int i = 0; i < 100; ++i) {
+        attribute_pack pack{attributes};
+        logger.log(0, "GET /porn.png HTTP/1.1", pack);
+    }
+
+    EXPECT_EQ(200, handled.load());
+}
+
+TEST(RootLogger, DetachedHandlersReceiveSnapshot) {
+    std::vector<std::unique_ptr<handler_t>> handlers;
+    std::vector<mock::handler_t*> handlers_view;
+
+    for (int i = 0; i < 2; ++i) {
+        std::unique_ptr<mock::handler_t> handler(new mock::handler_t);
+        handlers_view.push_back(handler.get());
+        handlers.push_back(std::move(handler));
+    }
+
+    std::atomic<int> handled(0);
+    for (auto handler : handlers_view) {
+        EXPECT_CALL(*handler, handle(_))
+            .Times(1)
+            .WillOnce(Invoke([&](const record_t& record) {
+                EXPECT_EQ("GET /porn.png HTTP/1.1 - 200", record.formatted().to_string());
+                EXPECT_EQ(2, record.severity());
+                ASSERT_EQ(1, record.attributes().size());
+                EXPECT_EQ(1, record.attributes().at(0).get().size());
+                ++handled;
+            }));
+
+        EXPECT_CALL(*handler, flush(_))
+            .WillOnce(Return(true));
+    }
+
+    root_logger_t logger(std::move(handlers));
+    logger.offload(std::make_shared<executor_t>(1), {
+        root_logger_t::mode_t::detached,
+        root_logger_t::mode_t::detached
+    });
+
+    // Neither the message nor attributes outlive the logging call.
+    {
+        const std::string formatted("GET /porn.png HTTP/1.1 - 200");
+        view_of<attributes_t>::type attributes{{"key#1", {42}}};
+        attribute_pack pack{attributes};
+
+        lazy_message_t message{{"GET /porn.png HTTP/1.1 - {}"}, [&]() -> string_view {
+            return formatted;
+        }};
+        logger.log(2, message, pack);
+    }
+
+    EXPECT_TRUE(logger.flush(std::chrono::seconds(1)));
+    EXPECT_EQ(2, handled.load());
+}
+
+TEST(RootLogger, FilterReplacementKeepsModes) {
+    auto handler = new mock::handler_t;
+    std::vector<std::unique_ptr<handler_t>> handlers;
+    handlers.emplace_back(handler);
+
+    const auto caller = std::this_thread::get_id();
+
+    EXPECT_CALL(*handler, handle(_))
+        .Times(1)
+        .WillOnce(Invoke([&](const record_t&) {
+            EXPECT_NE(caller, std::this_thread::get_id());
+        }));
+
+    root_logger_t logger(std::move(handlers));
+    logger.offload(std::make_shared<executor_t>(1), {root_logger_t::mode_t::parallel});
+    logger.filter([](const record_t&) -> bool {
+        return true;
+    });
+
+    logger.log(0, "GET /porn.png HTTP/1.1");
+}
+
+/// Handler reporting the pressure it's told to.
+class congested_t : public handler_t {
+public:
+    std::atomic<double> fill;
+    std::atomic<std::uint64_t> dropped;
+    std::atomic<int> handled;
+
+    congested_t() :
+        fill(0.0),
+        dropped(0),
+        handled(0)
+    {}
+
+    auto handle(const record_t&) -> void override {
+        ++handled;
+    }
+
+    auto pressure() const -> pressure_t override {
+        return pressure_t(fill.load(), dropped.load());
+    }
+};
+
+TEST(RootLogger, PressureMergesHandlers) {
+    auto first = new congested_t;
+    auto second = new congested_t;
+    first->fill = 0.6;
+    first->dropped = 1;
+    second->fill = 0.2;
+    second->dropped = 2;
+
+    std::vector<std::unique_ptr<handler_t>> handlers;
+    handlers.emplace_back(first);
+    handlers.emplace_back(second);
+
+    root_logger_t logger(std::move(handlers));
+
+    const auto pressure = logger.pressure();
+    EXPECT_DOUBLE_EQ(0.6, pressure.fill);
+    EXPECT_EQ(3, pressure.dropped);
+    EXPECT_EQ(pressure_t::level_t::elevated, pressure.level);
+
+    EXPECT_DOUBLE_EQ(0.2, logger.pressure(1).fill);
+    EXPECT_THROW(logger.pressure(2), std::out_of_range);
+}
+
+TEST(RootLogger, PressureClassifiesDropsAsCritical) {
+    auto handler = new congested_t;
+    std::vector<std::unique_ptr<handler_t>> handlers;
+    handlers.emplace_back(handler);
+
+    root_logger_t logger(std::move(handlers));
+
+    handler->dropped = 10;
+    std::this_thread::sleep_for(std::chrono::milliseconds(110));
+
+    const auto pressure = logger.pressure();
+    EXPECT_GT(pressure.rate, 0.0);
+    EXPECT_EQ(pressure_t::level_t::critical, pressure.level);
+}
+
+TEST(RootLogger, AdaptiveThresholdFollowsPressureWithHysteresis) {
+    auto handler = new congested_t;
+    std::vector<std::unique_ptr<handler_t>> handlers;
+    handlers.emplace_back(handler);
+
+    root_logger_t logger(std::move(handlers));
+    logger.adapt(2);
+
+    // The pressure is evaluated once per 64 events of each thread.
+    const auto spin = [&] {
+        for (int id = 0; id < 64; ++id) {
+            logger.enabled(0);
+        }
+    };
+
+    EXPECT_TRUE(logger.enabled(0));
+
+    handler->fill = 0.9;
+    spin();
+
+    EXPECT_FALSE(logger.enabled(1));
+    EXPECT_TRUE(logger.enabled(2));
+
+    handler->fill = 0.6;
+    spin();
+
+    EXPECT_FALSE(logger.enabled(1));
+
+    handler->fill = 0.1;
+    spin();
+
+    EXPECT_TRUE(logger.enabled(1));
+
+    handler->fill = 0.9;
+    spin();
+    logger.adapt(std::numeric_limits<int>::min());
+
+    EXPECT_TRUE(logger.enabled(0));
+}
+
+TEST(RootLogger, AsyncWaitPassesWithoutPressure) {
+    root_logger_t logger({});
+
+    auto called = false;
+    EXPECT_TRUE(logger.async_wait(pressure_t::level_t::critical, [&] {
+        called = true;
+    }));
+    EXPECT_FALSE(called);
+}
+
+TEST(RootLogger, AsyncWaitCallsOnceQueuesDrain) {
+    auto handler = new congested_t;
+    handler->fill = 0.99;
+
+    std::vector<std::unique_ptr<handler_t>> handlers;
+    handlers.emplace_back(handler);
+
+    root_logger_t logger(std::move(handlers));
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    auto called = false;
+
+    EXPECT_FALSE(logger.async_wait(pressure_t::level_t::critical, [&] {
+        std::lock_guard<std::mutex> lock(mutex);
+        called = true;
+        cv.notify_all();
+    }));
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        EXPECT_FALSE(called);
+    }
+
+    handler->fill = 0.5;
+
+    std::unique_lock<std::mutex> lock(mutex);
+    EXPECT_TRUE(cv.wait_for(lock, std::chrono::seconds(5), [&] { return called; }));
+}
+
+TEST(RootLogger, AsyncWaitCallsPendingOnDestruction) {
+    auto handler = new congested_t;
+    handler->fill = 0.99;
+
+    std::vector<std::unique_ptr<handler_t>> handlers;
+    handlers.emplace_back(handler);
+
+    std::atomic<int> called(0);
+    {
+        root_logger_t logger(std::move(handlers));
+        EXPECT_FALSE(logger.async_wait(pressure_t::level_t::high, [&] {
+            ++called;
+        }));
+    }
+
+    EXPECT_EQ(1, called.load());
+}
+
 }  // namespace testing
 }  // namespace blackhole
@@ -0,0 +1,168 @@
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <blackhole/attribute.hpp>
+#include <blackhole/formatter.hpp>
+#include <blackhole/formatter/string.hpp>
+#include <blackhole/handler.hpp>
+#include <blackhole/handler/blocking.hpp>
+#include <blackhole/record.hpp>
+#include <blackhole/root.hpp>
+#include <blackhole/scope/buffered.hpp>
+#include <blackhole/sink.hpp>
+
+namespace blackhole {
+namespace testing {
+namespace {
+
+/// Sink remembering emitted messages grouped by batches.
+class batches_t : public sink_t {
+    std::vector<std::vector<std::string>>& batches;
+
+public:
+    explicit batches_t(std::vector<std::vector<std::string>>& batches) :
+        batches(batches)
+    {}
+
+    auto emit(const record_t&, const string_view& message) -> void override {
+        batches.push_back({message.to_string()});
+    }
+
+    auto emit_batch(const event_t* events, std::size_t size) -> void override {
+        batches.emplace_back();
+        for (std::size_t id = 0; id < size; ++id) {
+            batches.back().push_back(events[id].message->to_string());
+        }
+    }
+};
+
+auto make_logger(std::vector<std::vector<std::string>>& batches) -> root_logger_t {
+    std::vector<std::unique_ptr<handler_t>> handlers;
+    handlers.push_back(builder<handler::blocking_t>()
+        .set(builder<formatter::string_t>("{severity}: {message} [{...}]").build())
+        .add(std::unique_ptr<sink_t>(new batches_t(batches)))
+        .build());
+
+    return root_logger_t(std::move(handlers));
+}
+
+const scope::buffered_holder_t::policy_t policy{3, std::chrono::hours(1)};
+
+}  // namespace
+
+TEST(buffered_holder_t, DiscardsSuccessfulScope) {
+    std::vector<std::vector<std::string>> batches;
+    auto logger = make_logger(batches);
+
+    {
+        const scope::buffered_holder_t holder(logger, policy, {{"request", {42}}});
+        logger.log(0, "GET");
+        logger.log(2, "POST");
+
+        EXPECT_EQ(2, holder.size());
+    }
+
+    EXPECT_TRUE(batches.empty());
+
+    logger.log(0, "PUT");
+
+    EXPECT_EQ((std::vector<std::vector<std::string>>{{"0: PUT []"}}), batches);
+}
+
+TEST(buffered_holder_t, CommitsScopeWithError) {
+    std::vector<std::vector<std::string>> batches;
+    auto logger = make_logger(batches);
+
+    {
+        const scope::buffered_holder_t holder(logger, policy, {{"request", {42}}});
+        logger.log(0, "GET");
+        logger.log(3, "failed");
+        logger.log(1, "done");
+
+        EXPECT_TRUE(batches.empty());
+    }
+
+    EXPECT_EQ((std::vector<std::vector<std::string>>{
+        {"0: GET [request: 42]", "3: failed [request: 42]", "1: done [request: 42]"}
+    }), batches);
+}
+
+TEST(buffered_holder_t, CommitsSlowScope) {
+    std::vector<std::vector<std::string>> batches;
+    auto logger = make_logger(batches);
+
+    {
+        const scope::buffered_holder_t holder(logger, {3, std::chrono::microseconds(0)}, {});
+        logger.log(0, "GET");
+    }
+
+    EXPECT_EQ((std::vector<std::vector<std::string>>{{"0: GET []"}}), batches);
+}
+
+TEST(buffered_holder_t, ExplicitDecision) {
+    std::vector<std::vector<std::string>> batches;
+    auto logger = make_logger(batches);
+
+    {
+        scope::buffered_holder_t holder(logger, policy, {});
+        logger.log(0, "GET");
+        holder.commit();
+    }
+
+    {
+        scope::buffered_holder_t holder(logger, policy, {});
+        logger.log(3, "failed");
+        holder.discard();
+    }
+
+    EXPECT_EQ((std::vector<std::vector<std::string>>{{"0: GET []"}}), batches);
+}
+
+TEST(buffered_holder_t, NestedScopeCommitsIntoEnclosingOne) {
+    std::vector<std::vector<std::string>> batches;
+    auto logger = make_logger(batches);
+
+    {
+        scope::buffered_holder_t outer(logger, policy, {});
+        logger.log(0, "GET");
+
+        {
+            const scope::buffered_holder_t inner(logger, policy, {{"request", {42}}});
+            logger.log(3, "failed");
+        }
+
+        EXPECT_TRUE(batches.empty());
+        EXPECT_EQ(2, outer.size());
+
+        outer.discard();
+    }
+
+    EXPECT_TRUE(batches.empty());
+}
+
+TEST(buffered_holder_t, KeepsRecordsLargerThanChunk) {
+    std::vector<std::vector<std::string>> batches;
+    auto logger = make_logger(batches);
+
+    const std::string large(2 * scope::buffered_holder_t::chunk, 'x');
+
+    {
+        scope::buffered_holder_t holder(logger, policy, {});
+        for (int id = 0; id < 64; ++id) {
+            logger.log(0, string_view(large.data(), static_cast<std::size_t>(id + 1) * 512));
+        }
+        holder.commit();
+    }
+
+    ASSERT_EQ(1, batches.size());
+    ASSERT_EQ(64, batches[0].size());
+
+    for (std::size_t id = 0; id < 64; ++id) {
+        EXPECT_EQ("0: " + large.substr(0, (id + 1) * 512) + " []", batches[0][id]);
+    }
+}
+
+}  // namespace testing
+}  // namespace blackhole
@@ -0,0 +1,57 @@
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include <blackhole/scope/span.hpp>
+
+namespace blackhole {
+namespace testing {
+namespace {
+
+TEST(span_t, SetsThreadTraceContext) {
+    EXPECT_TRUE(trace::current().empty());
+
+    {
+        const trace_t trace{1, 2, 3};
+        scope::span_t span(trace);
+
+        EXPECT_EQ(1, trace::current().hi);
+        EXPECT_EQ(2, trace::current().lo);
+        EXPECT_EQ(3, trace::current().span);
+        EXPECT_TRUE(span.parent().empty());
+    }
+
+    EXPECT_TRUE(trace::current().empty());
+}
+
+TEST(span_t, NestedSpanKeepsTraceId) {
+    const trace_t trace{1, 2, 3};
+    scope::span_t outer(trace);
+
+    {
+        scope::span_t inner(42);
+
+        EXPECT_EQ(1, trace::current().hi);
+        EXPECT_EQ(2, trace::current().lo);
+        EXPECT_EQ(42, trace::current().span);
+        EXPECT_EQ(3, inner.parent().span);
+    }
+
+    EXPECT_EQ(3, trace::current().span);
+}
+
+TEST(span_t, ContextIsThreadLocal) {
+    const trace_t trace{1, 2, 3};
+    scope::span_t span(trace);
+
+    bool empty = false;
+    std::thread([&] {
+        empty = trace::current().empty();
+    }).join();
+
+    EXPECT_TRUE(empty);
+}
+
+}  // namespace
+}  // namespace testing
+}  // namespace blackhole
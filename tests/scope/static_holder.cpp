@@ -0,0 +1,72 @@
+#include <string>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <blackhole/attribute.hpp>
+#include <blackhole/handler.hpp>
+#include <blackhole/record.hpp>
+#include <blackhole/root.hpp>
+#include <blackhole/scope/holder.hpp>
+#include <blackhole/scope/static_holder.hpp>
+
+#include "mocks/handler.hpp"
+
+namespace blackhole {
+namespace testing {
+namespace {
+
+using ::testing::Invoke;
+using ::testing::_;
+
+TEST(static_holder_t, AttachesViewsToRecords) {
+    std::unique_ptr<mock::handler_t> handler(new mock::handler_t);
+    mock::handler_t* view = handler.get();
+
+    std::vector<std::unique_ptr<handler_t>> handlers;
+    handlers.push_back(std::move(handler));
+
+    root_logger_t logger(std::move(handlers));
+
+    const std::string method("GET");
+    const scope::static_holder_t<2> holder(logger, {{"method", method}, {"id", 42}});
+
+    EXPECT_EQ(2, holder.attributes().size());
+
+    EXPECT_CALL(*view, handle(_))
+        .Times(1)
+        .WillOnce(Invoke([](const record_t& record) {
+            ASSERT_EQ(1, record.attributes().size());
+            EXPECT_EQ((attribute_list{{"method", {"GET"}}, {"id", {42}}}),
+                record.attributes().at(0).get());
+        }));
+
+    logger.log(0, "-");
+}
+
+TEST(static_holder_t, StacksWithOtherScopes) {
+    std::unique_ptr<mock::handler_t> handler(new mock::handler_t);
+    mock::handler_t* view = handler.get();
+
+    std::vector<std::unique_ptr<handler_t>> handlers;
+    handlers.push_back(std::move(handler));
+
+    root_logger_t logger(std::move(handlers));
+
+    const scope::holder_t outer(logger, {{"key#1", {42}}});
+    const scope::static_holder_t<1> inner(logger, {{"key#2", {"value#2"}}});
+
+    EXPECT_CALL(*view, handle(_))
+        .Times(1)
+        .WillOnce(Invoke([](const record_t& record) {
+            ASSERT_EQ(1, record.attributes().size());
+            EXPECT_EQ((attribute_list{{"key#2", {"value#2"}}, {"key#1", {42}}}),
+                record.attributes().at(0).get());
+        }));
+
+    logger.log(0, "-");
+}
+
+}  // namespace
+}  // namespace testing
+}  // namespace blackhole
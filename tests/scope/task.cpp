@@ -0,0 +1,125 @@
+#include <memory>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include <blackhole/attribute.hpp>
+#include <blackhole/handler.hpp>
+#include <blackhole/root.hpp>
+#include <blackhole/scope/holder.hpp>
+#include <blackhole/scope/manager.hpp>
+#include <blackhole/scope/span.hpp>
+#include <blackhole/scope/task.hpp>
+#include <blackhole/scope/watcher.hpp>
+
+namespace blackhole {
+namespace testing {
+namespace {
+
+auto attributes(root_logger_t& logger) -> attribute_list {
+    attribute_pack pack;
+    if (const auto watcher = logger.manager().get()) {
+        watcher->collect(pack);
+    }
+
+    return pack.empty() ? attribute_list() : pack.at(0).get();
+}
+
+TEST(task_t, KeepsScopesOfInterleavedTasks) {
+    root_logger_t logger({});
+
+    scope::task_t t1;
+    scope::task_t t2;
+
+    std::unique_ptr<scope::holder_t> h1;
+    std::unique_ptr<scope::holder_t> h2;
+
+    {
+        scope::resume_t resume(t1);
+        h1.reset(new scope::holder_t(logger, {{"task", {1}}}));
+    }
+
+    {
+        scope::resume_t resume(t2);
+        EXPECT_TRUE(attributes(logger).empty());
+        h2.reset(new scope::holder_t(logger, {{"task", {2}}}));
+    }
+
+    EXPECT_TRUE(attributes(logger).empty());
+
+    {
+        scope::resume_t resume(t1);
+        EXPECT_EQ((attribute_list{{"task", {1}}}), attributes(logger));
+        h1.reset();
+        EXPECT_TRUE(attributes(logger).empty());
+    }
+
+    {
+        scope::resume_t resume(t2);
+        EXPECT_EQ((attribute_list{{"task", {2}}}), attributes(logger));
+        h2.reset();
+    }
+}
+
+TEST(task_t, HidesThreadScopes) {
+    root_logger_t logger({});
+    const scope::holder_t holder(logger, {{"thread", {42}}});
+
+    scope::task_t task;
+    {
+        scope::resume_t resume(task);
+        EXPECT_TRUE(attributes(logger).empty());
+    }
+
+    EXPECT_EQ((attribute_list{{"thread", {42}}}), attributes(logger));
+}
+
+TEST(task_t, FollowsTaskAcrossThreads) {
+    root_logger_t logger({});
+
+    scope::task_t task;
+    std::unique_ptr<scope::holder_t> holder;
+
+    {
+        scope::resume_t resume(task);
+        holder.reset(new scope::holder_t(logger, {{"task", {1}}}));
+    }
+
+    attribute_list result;
+    std::thread([&] {
+        scope::resume_t resume(task);
+        result = attributes(logger);
+        holder.reset();
+    }).join();
+
+    EXPECT_EQ((attribute_list{{"task", {1}}}), result);
+}
+
+TEST(task_t, SwitchesTraceContext) {
+    scope::task_t task;
+
+    {
+        scope::resume_t resume(task);
+        trace::reset({1, 2, 3});
+    }
+
+    EXPECT_TRUE(trace::current().empty());
+
+    {
+        const trace_t trace{4, 5, 6};
+        scope::span_t span(trace);
+
+        scope::resume_t resume(task);
+        EXPECT_EQ(3, trace::current().span);
+    }
+
+    {
+        scope::resume_t resume(task);
+        EXPECT_EQ(3, trace::current().span);
+        trace::reset({0, 0, 0});
+    }
+}
+
+}  // namespace
+}  // namespace testing
+}  // namespace blackhole
@@ -0,0 +1,109 @@
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include <blackhole/detail/formatter/json/escape.hpp>
+
+namespace blackhole {
+inline namespace v1 {
+namespace detail {
+namespace formatter {
+namespace json {
+namespace {
+
+auto escaped(const std::string& value) -> std::string {
+    writer_t writer;
+    escape(string_view(value), writer);
+    return writer.result().to_string();
+}
+
+TEST(escape, Empty) {
+    EXPECT_EQ("", escaped(""));
+}
+
+TEST(escape, Plain) {
+    EXPECT_EQ("GET /index.html HTTP/1.1", escaped("GET /index.html HTTP/1.1"));
+}
+
+TEST(escape, QuotesAndBackslashes) {
+    EXPECT_EQ("say \\\"hi\\\" to C:\\\\", escaped("say \"hi\" to C:\\"));
+}
+
+TEST(escape, ShortControlCharacters) {
+    EXPECT_EQ("\\b\\f\\n\\r\\t", escaped("\b\f\n\r\t"));
+}
+
+TEST(escape, OtherControlCharacters) {
+    EXPECT_EQ("\\u0000\\u0001\\u001F", escaped(std::string("\x00\x01\x1f", 3)));
+}
+
+TEST(escape, NonAsciiKeptAsIs) {
+    EXPECT_EQ("\xd0\xbf\xd1\x80\xd0\xb8\xd0\xb2\xd0\xb5\xd1\x82\x7f",
+        escaped("\xd0\xbf\xd1\x80\xd0\xb8\xd0\xb2\xd0\xb5\xd1\x82\x7f"));
+}
+
+TEST(escape, AtEveryPositionOfLongString) {
+    const std::string clean(37, 'x');
+
+    for (std::size_t pos = 0; pos < clean.size(); ++pos) {
+        auto value = clean;
+        value[pos] = '"';
+
+        auto expected = clean;
+        expected.replace(pos, 1, "\\\"");
+
+        EXPECT_EQ(expected, escaped(value)) << "at position " << pos;
+    }
+}
+
+TEST(escape, FourBytesSequenceKeptAsIs) {
+    EXPECT_EQ("\xf0\x9f\x98\x80", escaped("\xf0\x9f\x98\x80"));
+}
+
+TEST(escape, InvalidSequencesReplaced) {
+    // Lone continuation, overlong form, surrogate, beyond U+10FFFF and truncated sequence.
+    EXPECT_EQ("a\xef\xbf\xbd", escaped("a\x80"));
+    EXPECT_EQ("\xef\xbf\xbd\xef\xbf\xbd", escaped("\xc0\xaf"));
+    EXPECT_EQ("\xef\xbf\xbd\xef\xbf\xbd\xef\xbf\xbd", escaped("\xed\xa0\x80"));
+    EXPECT_EQ("\xef\xbf\xbd\xef\xbf\xbd\xef\xbf\xbd\xef\xbf\xbd",
+        escaped("\xf4\x90\x80\x80"));
+    EXPECT_EQ("\xef\xbf\xbd\\n", escaped("\xd0\n"));
+}
+
+TEST(escape, ControlAndNonAsciiAtEveryPositionOfLongString) {
+    const std::string clean(71, 'x');
+
+    for (std::size_t pos = 0; pos + 1 < clean.size(); ++pos) {
+        auto value = clean;
+        value.replace(pos, 2, "\xd1\x82");
+        value[clean.size() - 1 - pos] = '\x01';
+
+        auto expected = value;
+        expected.replace(clean.size() - 1 - pos, 1, "\\u0001");
+
+        if (clean.size() - 1 - pos == pos || clean.size() - 1 - pos == pos + 1) {
+            continue;
+        }
+
+        EXPECT_EQ(expected, escaped(value)) << "at position " << pos;
+    }
+}
+
+TEST(validate, ReturnsValidPrefixLength) {
+    EXPECT_EQ(0, validate(""));
+    EXPECT_EQ(10, validate("\"valid\"\n\xd0\xbf"));
+    EXPECT_EQ(40, validate(std::string(40, 'x') + "\xff" + std::string(40, 'x')));
+    EXPECT_EQ(1, validate("x\xe2\x82"));
+}
+
+TEST(sanitize, ReplacesInvalidBytes) {
+    EXPECT_EQ("valid \xd0\xbf", sanitize("valid \xd0\xbf"));
+    EXPECT_EQ("\xef\xbf\xbd\"\xef\xbf\xbd", sanitize("\xff\"\xfe"));
+}
+
+}  // namespace
+}  // namespace json
+}  // namespace formatter
+}  // namespace detail
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,223 @@
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <blackhole/attribute.hpp>
+#include <blackhole/attributes.hpp>
+#include <blackhole/scope/span.hpp>
+#include <blackhole/detail/formatter/json/serializer.hpp>
+
+namespace blackhole {
+inline namespace v1 {
+namespace detail {
+namespace formatter {
+namespace json {
+namespace {
+
+using ::testing::EndsWith;
+using ::testing::HasSubstr;
+using ::testing::Not;
+using ::testing::StartsWith;
+
+auto format(serializer_t::properties_t properties, const attribute_pack& pack) -> std::string {
+    const string_view message("value");
+    record_t record(0, message, pack);
+
+    writer_t writer;
+    serializer_t(std::move(properties)).format(record, writer);
+
+    return writer.result().to_string();
+}
+
+TEST(serializer_t, Plain) {
+    const attribute_list attributes{{"key", {42}}};
+    const attribute_pack pack{attributes};
+
+    const auto result = format({}, pack);
+
+    EXPECT_THAT(result, StartsWith("{\"message\":\"value\",\"thread\":\"0x"));
+    EXPECT_THAT(result, HasSubstr(",\"process\":"));
+    EXPECT_THAT(result, EndsWith(",\"severity\":0,\"timestamp\":0,\"key\":42}"));
+}
+
+TEST(serializer_t, AttributeTypes) {
+    const attribute_list attributes{
+        {"null", {nullptr}},
+        {"bool", {true}},
+        {"sint", {-42}},
+        {"uint", {42u}},
+        {"double", {3.1415}},
+        {"integral", {1.0}},
+        {"string", {"\"quoted\"\n"}}
+    };
+    const attribute_pack pack{attributes};
+
+    EXPECT_THAT(format({}, pack), EndsWith(
+        "\"null\":null,\"bool\":true,\"sint\":-42,\"uint\":42,\"double\":3.1415,\"integral\":1.0,"
+        "\"string\":\"\\\"quoted\\\"\\n\"}"));
+}
+
+TEST(serializer_t, Routing) {
+    serializer_t::properties_t properties{};
+    properties.routing["/fields"] = {"key"};
+
+    const attribute_list attributes{{"key", {42}}, {"other", {1}}};
+    const attribute_pack pack{attributes};
+
+    EXPECT_THAT(format(properties, pack), EndsWith(",\"other\":1,\"fields\":{\"key\":42}}"));
+}
+
+TEST(serializer_t, NestedRoutingOmitsEmptyObjects) {
+    serializer_t::properties_t properties{};
+    properties.routing["/a/b"] = {"key"};
+    properties.routing["/a/c"] = {"missing"};
+    properties.routing["/d"] = {"missing"};
+
+    const attribute_list attributes{{"key", {42}}};
+    const attribute_pack pack{attributes};
+
+    EXPECT_THAT(format(properties, pack), EndsWith(",\"timestamp\":0,\"a\":{\"b\":{\"key\":42}}}"));
+}
+
+TEST(serializer_t, RestRouting) {
+    serializer_t::properties_t properties{};
+    properties.routing[""] = {"key"};
+    properties.rest = "/other";
+
+    const attribute_list attributes{{"key", {42}}};
+    const attribute_pack pack{attributes};
+
+    const auto result = format(properties, pack);
+
+    EXPECT_THAT(result, StartsWith("{\"key\":42,\"other\":{\"message\":\"value\","));
+    EXPECT_THAT(result, EndsWith("\"timestamp\":0}}"));
+}
+
+TEST(serializer_t, EscapedPointer) {
+    serializer_t::properties_t properties{};
+    properties.routing["/a~1b/c~0d"] = {"key"};
+
+    const attribute_list attributes{{"key", {42}}};
+    const attribute_pack pack{attributes};
+
+    EXPECT_THAT(format(properties, pack), EndsWith(",\"a/b\":{\"c~d\":{\"key\":42}}}"));
+}
+
+TEST(serializer_t, ThrowsOnInvalidPointer) {
+    serializer_t::properties_t properties{};
+    properties.routing["fields"] = {"key"};
+
+    EXPECT_THROW(serializer_t{properties}, std::invalid_argument);
+
+    properties.routing.clear();
+    properties.rest = "/a~2";
+
+    EXPECT_THROW(serializer_t{properties}, std::invalid_argument);
+}
+
+TEST(serializer_t, Renaming) {
+    serializer_t::properties_t properties{};
+    properties.mapping["message"] = "@message";
+    properties.mapping["key"] = "@key";
+
+    const attribute_list attributes{{"key", {42}}};
+    const attribute_pack pack{attributes};
+
+    const auto result = format(properties, pack);
+
+    EXPECT_THAT(result, StartsWith("{\"@message\":\"value\","));
+    EXPECT_THAT(result, EndsWith(",\"@key\":42}"));
+}
+
+TEST(serializer_t, DuplicatesByDefault) {
+    const attribute_list a1{{"key", {42}}};
+    const attribute_list a2{{"key", {100}}};
+    const attribute_pack pack{a1, a2};
+
+    EXPECT_THAT(format({}, pack), EndsWith(",\"key\":42,\"key\":100}"));
+}
+
+TEST(serializer_t, Unique) {
+    serializer_t::properties_t properties{};
+    properties.unique = true;
+
+    const attribute_list a1{{"key", {42}}};
+    const attribute_list a2{{"key", {100}}};
+    const attribute_pack pack{a1, a2};
+
+    EXPECT_THAT(format(properties, pack), EndsWith(",\"timestamp\":0,\"key\":42}"));
+}
+
+TEST(serializer_t, MutateSeverityAndTimestamp) {
+    serializer_t::properties_t properties{};
+    properties.severity = {"D", "I"};
+    properties.timestamp = [](const record_t::time_point&, writer_t& wr) {
+        wr.inner << "now";
+    };
+
+    const attribute_pack pack;
+
+    EXPECT_THAT(format(properties, pack), EndsWith(",\"severity\":\"D\",\"timestamp\":\"now\"}"));
+}
+
+TEST(serializer_t, TraceContext) {
+    serializer_t::properties_t properties{};
+    properties.mapping["span_id"] = "span";
+
+    const attribute_pack pack;
+    EXPECT_THAT(format(properties, pack), Not(HasSubstr("trace_id")));
+
+    const trace_t trace{0x0af7651916cd43ddull, 0x8448eb211c80319cull, 0xb7ad6b7169203331ull};
+    blackhole::scope::span_t span(trace);
+
+    EXPECT_THAT(format(properties, pack), EndsWith(",\"timestamp\":0,"
+        "\"trace_id\":\"0af7651916cd43dd8448eb211c80319c\",\"span\":\"b7ad6b7169203331\"}"));
+}
+
+TEST(serializer_t, DoublesSameAsShortestRoundTrip) {
+    const auto expected = [](double value) -> std::string {
+        char buffer[32];
+        int size = 0;
+        for (int precision = 15; precision <= 17; ++precision) {
+            size = std::snprintf(buffer, sizeof(buffer), "%.*g", precision, value);
+            if (std::strtod(buffer, nullptr) == value) {
+                break;
+            }
+        }
+
+        std::string result(buffer, static_cast<std::size_t>(size));
+        return std::strpbrk(buffer, ".e") == nullptr ? result + ".0" : result;
+    };
+
+    const double values[] = {
+        0.0, -0.0, 0.1, 0.3, -0.25, 1.5, 100.0, 1234.5678, 1e-4, 0.00012, 1e-5, 123456789012345.0,
+        12345678901234.5, 1e15, 1e20, 1.0 / 3, 2.0 / 3, M_PI, 5e-324, 9007199254740993.0,
+        std::numeric_limits<double>::max(), std::numeric_limits<double>::min()
+    };
+
+    std::vector<double> all(std::begin(values), std::end(values));
+    for (int id = 0; id < 2000; ++id) {
+        all.push_back(static_cast<double>(std::rand() % 100000) / std::pow(10.0, id % 12) *
+            (id % 2 ? 1 : -1));
+    }
+
+    for (auto value : all) {
+        const attribute_list attributes{{"v", {value}}};
+        const attribute_pack pack{attributes};
+
+        EXPECT_THAT(format({}, pack), EndsWith(",\"v\":" + expected(value) + "}")) << value;
+    }
+}
+
+}  // namespace
+}  // namespace json
+}  // namespace formatter
+}  // namespace detail
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,199 @@
+#include <cmath>
+#include <limits>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <blackhole/attribute.hpp>
+#include <blackhole/attributes.hpp>
+#include <blackhole/scope/span.hpp>
+#include <blackhole/detail/formatter/json/skeleton.hpp>
+
+namespace blackhole {
+inline namespace v1 {
+namespace detail {
+namespace formatter {
+namespace json {
+namespace {
+
+using ::testing::EndsWith;
+using ::testing::HasSubstr;
+using ::testing::StartsWith;
+
+auto properties() -> skeleton_t::properties_t {
+    skeleton_t::properties_t result{};
+    result.real = [](double value, writer_t& wr) {
+        wr.write("{}", value);
+    };
+
+    return result;
+}
+
+auto format(skeleton_t::properties_t properties, const attribute_pack& pack, severity_t sev = 0) ->
+    std::string
+{
+    const string_view message("value");
+    record_t record(sev, message, pack);
+
+    writer_t writer;
+    if (!skeleton_t(std::move(properties)).format(record, writer)) {
+        return "<declined>";
+    }
+
+    return writer.result().to_string();
+}
+
+TEST(skeleton_t, Plain) {
+    const attribute_list attributes{{"key", {42}}, {"flag", {true}}, {"none", {nullptr}}};
+    const attribute_pack pack{attributes};
+
+    const auto result = format(properties(), pack);
+
+    EXPECT_THAT(result, StartsWith("{\"message\":\"value\",\"thread\":\"0x"));
+    EXPECT_THAT(result, HasSubstr(",\"process\":"));
+    EXPECT_THAT(result, EndsWith(
+        ",\"severity\":0,\"timestamp\":0,\"key\":42,\"flag\":true,\"none\":null}"));
+}
+
+TEST(skeleton_t, MappedSeverity) {
+    auto props = properties();
+    props.severity = {"D", "I"};
+
+    const attribute_pack pack;
+
+    EXPECT_THAT(format(props, pack, 1), EndsWith(",\"severity\":\"I\",\"timestamp\":0}"));
+    EXPECT_THAT(format(props, pack, 2), EndsWith(",\"severity\":2,\"timestamp\":0}"));
+    EXPECT_THAT(format(props, pack, -1), EndsWith(",\"severity\":-1,\"timestamp\":0}"));
+}
+
+TEST(skeleton_t, AppendsAttributesToObjectsOfBuiltins) {
+    auto props = properties();
+    props.routing["/fields"] = {"endpoint", "severity"};
+
+    const attribute_list attributes{{"endpoint", {"[::]"}}, {"other", {1}}};
+    const attribute_pack pack{attributes};
+
+    // Objects are placed where the document creates them, i.e. on their first builtin field.
+    EXPECT_THAT(format(props, pack), EndsWith(
+        ",\"fields\":{\"severity\":0,\"endpoint\":\"[::]\"},\"timestamp\":0,\"other\":1}"));
+}
+
+TEST(skeleton_t, NestedRoutingOfBuiltins) {
+    auto props = properties();
+    props.routing["/a/b"] = {"message"};
+    props.rest = "/a";
+
+    const attribute_list attributes{{"key", {"value"}}};
+    const attribute_pack pack{attributes};
+
+    const auto result = format(props, pack);
+
+    EXPECT_THAT(result, StartsWith("{\"a\":{\"b\":{\"message\":\"value\"},\"thread\":\"0x"));
+    EXPECT_THAT(result, EndsWith(",\"severity\":0,\"timestamp\":0,\"key\":\"value\"}}"));
+}
+
+TEST(skeleton_t, Renaming) {
+    auto props = properties();
+    props.mapping["message"] = "#message";
+    props.mapping["key"] = "#key";
+
+    const attribute_list attributes{{"key", {"\"quoted\"\n"}}};
+    const attribute_pack pack{attributes};
+
+    const auto result = format(props, pack);
+
+    EXPECT_THAT(result, StartsWith("{\"#message\":\"value\","));
+    EXPECT_THAT(result, EndsWith(",\"#key\":\"\\\"quoted\\\"\\n\"}"));
+}
+
+TEST(skeleton_t, WritesDoublesUsingGivenFunction) {
+    auto props = properties();
+    props.real = [](double, writer_t& wr) {
+        wr.inner << "real";
+    };
+
+    const attribute_list attributes{{"pi", {3.1415}}};
+    const attribute_pack pack{attributes};
+
+    EXPECT_THAT(format(props, pack), EndsWith(",\"pi\":real}"));
+}
+
+TEST(skeleton_t, MutateTimestamp) {
+    auto props = properties();
+    props.timestamp = [](const record_t::time_point&, writer_t& wr) {
+        wr.inner << "now";
+    };
+
+    const attribute_pack pack;
+
+    EXPECT_THAT(format(props, pack), EndsWith(",\"timestamp\":\"now\"}"));
+}
+
+TEST(skeleton_t, TraceContext) {
+    auto props = properties();
+    props.mapping["span_id"] = "span";
+
+    const attribute_list attributes{{"key", {42}}};
+    const attribute_pack pack{attributes};
+    EXPECT_THAT(format(props, pack), Not(HasSubstr("trace_id")));
+
+    const trace_t trace{0x0af7651916cd43ddull, 0x8448eb211c80319cull, 0xb7ad6b7169203331ull};
+    blackhole::scope::span_t span(trace);
+
+    EXPECT_THAT(format(props, pack), HasSubstr(
+        ",\"trace_id\":\"0af7651916cd43dd8448eb211c80319c\",\"span\":\"b7ad6b7169203331\","
+        "\"severity\":0,\"timestamp\":0,\"key\":42}"));
+}
+
+TEST(skeleton_t, DeclinesAttributesRoutedToNewObjects) {
+    auto props = properties();
+    props.routing["/fields"] = {"key"};
+
+    const attribute_list attributes{{"key", {42}}};
+    const attribute_pack pack{attributes};
+
+    EXPECT_EQ("<declined>", format(props, pack));
+    EXPECT_THAT(format(props, {}), EndsWith(",\"timestamp\":0}"));
+}
+
+TEST(skeleton_t, DeclinesNonFiniteDoubles) {
+    const attribute_list attributes{{"nan", {std::numeric_limits<double>::quiet_NaN()}}};
+    const attribute_pack pack{attributes};
+
+    EXPECT_EQ("<declined>", format(properties(), pack));
+}
+
+TEST(skeleton_t, DeclinesInvalidKeys) {
+    const attribute_list attributes{{"\xff", {42}}};
+    const attribute_pack pack{attributes};
+
+    EXPECT_EQ("<declined>", format(properties(), pack));
+}
+
+TEST(skeleton_t, ThrowsOnArrayIndexTokens) {
+    auto props = properties();
+    props.routing["/fields/0"] = {"message"};
+
+    EXPECT_THROW(skeleton_t{props}, std::invalid_argument);
+}
+
+TEST(skeleton_t, ThrowsOnObjectsClashingWithBuiltins) {
+    auto props = properties();
+    props.routing["/message"] = {"thread"};
+
+    EXPECT_THROW(skeleton_t{props}, std::invalid_argument);
+}
+
+TEST(skeleton_t, ThrowsOnMalformedRoutes) {
+    auto props = properties();
+    props.routing["fields"] = {"message"};
+
+    EXPECT_THROW(skeleton_t{props}, std::invalid_argument);
+}
+
+}  // namespace
+}  // namespace json
+}  // namespace formatter
+}  // namespace detail
+}  // namespace v1
+}  // namespace blackhole
@@ -16,6 +16,7 @@ namespace ph {
 }  // namespace ph
 
 using detail::formatter::string::ph::generic;
+using detail::formatter::string::ph::host;
 using detail::formatter::string::ph::leftover_t;
 using detail::formatter::string::ph::message_t;
 using detail::formatter::string::ph::process;
@@ -314,6 +315,34 @@ TEST(parser_t, ProcessName) {
     EXPECT_FALSE(parser.next());
 }
 
+TEST(parser_t, Host) {
+    parser_t parser("{host}{host:>20}");
+
+    auto token = parser.next();
+    ASSERT_TRUE(!!token);
+    EXPECT_EQ("{}", boost::get<host<name>>(*token).spec);
+
+    token = parser.next();
+    ASSERT_TRUE(!!token);
+    EXPECT_EQ("{:>20}", boost::get<host<name>>(*token).spec);
+
+    EXPECT_FALSE(parser.next());
+}
+
+TEST(parser_t, HostFqdn) {
+    parser_t parser("{host:fqdn}{host:fqdn:>20}");
+
+    auto token = parser.next();
+    ASSERT_TRUE(!!token);
+    EXPECT_EQ("{}", boost::get<host<fqdn>>(*token).spec);
+
+    token = parser.next();
+    ASSERT_TRUE(!!token);
+    EXPECT_EQ("{:>20}", boost::get<host<fqdn>>(*token).spec);
+
+    EXPECT_FALSE(parser.next());
+}
+
 TEST(parser_t, Thread) {
     // NOTE: Hex representation by default.
     parser_t parser("{thread}");
@@ -0,0 +1,149 @@
+#include <gtest/gtest.h>
+
+#include <blackhole/detail/formatter/string/program.hpp>
+#include <blackhole/detail/process.hpp>
+#include <blackhole/detail/procname.hpp>
+#include <blackhole/stdext/string_view.hpp>
+
+namespace blackhole {
+inline namespace v1 {
+namespace detail {
+namespace formatter {
+namespace string {
+namespace {
+
+using ph::generic;
+using ph::host;
+using ph::message_t;
+using ph::process;
+using ph::severity;
+
+TEST(spec_t, ParsePlain) {
+    EXPECT_EQ(spec_t::kind_t::plain, parse("{}").kind);
+    EXPECT_EQ(spec_t::kind_t::plain, parse("{:}").kind);
+    EXPECT_EQ(spec_t::kind_t::plain, parse("{:s}").kind);
+}
+
+TEST(spec_t, ParseAlign) {
+    const auto spec = parse("{:*^10s}");
+
+    EXPECT_EQ(spec_t::kind_t::align, spec.kind);
+    EXPECT_EQ('*', spec.fill);
+    EXPECT_EQ('^', spec.align);
+    EXPECT_EQ('s', spec.type);
+    EXPECT_EQ(10, spec.width);
+}
+
+TEST(spec_t, ParseWidthOnly) {
+    const auto spec = parse("{:8}");
+
+    EXPECT_EQ(spec_t::kind_t::align, spec.kind);
+    EXPECT_EQ(' ', spec.fill);
+    EXPECT_EQ(0, spec.align);
+    EXPECT_EQ(8, spec.width);
+}
+
+TEST(spec_t, ParseCustom) {
+    EXPECT_EQ(spec_t::kind_t::custom, parse("{:.3f}").kind);
+    EXPECT_EQ(spec_t::kind_t::custom, parse("{:08d}").kind);
+    EXPECT_EQ(spec_t::kind_t::custom, parse("{:#x}").kind);
+    EXPECT_EQ(spec_t::kind_t::custom, parse("{:+d}").kind);
+    EXPECT_EQ("{:+d}", parse("{:+d}").pattern);
+}
+
+TEST(program_t, MergesAdjacentLiterals) {
+    const auto program = compile({literal_t("["), literal_t("]"), message_t(), literal_t("!")});
+
+    ASSERT_EQ(3, program.code.size());
+    EXPECT_EQ(opcode_t::literal, program.code[0].opcode);
+    EXPECT_EQ(2, program.code[0].size);
+    EXPECT_EQ(opcode_t::message, program.code[1].opcode);
+    EXPECT_EQ(opcode_t::literal, program.code[2].opcode);
+    EXPECT_EQ("[]!", program.arena);
+}
+
+TEST(program_t, InternsGenericNames) {
+    const auto program = compile({
+        generic<required>("id"),
+        literal_t(" "),
+        generic<required>("name"),
+        literal_t(" "),
+        generic<required>("id")
+    });
+
+    ASSERT_EQ(2, program.names.size());
+    EXPECT_EQ("id", program.names[0].name);
+    EXPECT_EQ("name", program.names[1].name);
+    EXPECT_EQ(interned_t::hash_of("id", 2), program.names[0].hash);
+    EXPECT_EQ(program.code[0].operand, program.code[4].operand);
+}
+
+TEST(program_t, StoresOptionalPrefixAndSuffix) {
+    const auto program = compile({generic<optional>(generic<required>("id"), "<", ">")});
+
+    ASSERT_EQ(1, program.code.size());
+
+    const auto& instruction = program.code[0];
+    EXPECT_EQ(opcode_t::optional, instruction.opcode);
+    EXPECT_EQ("<", program.arena.substr(instruction.offset, instruction.size));
+    EXPECT_EQ(">", program.arena.substr(instruction.offset + instruction.size, instruction.suffix));
+}
+
+TEST(program_t, RendersConstantsIntoLiterals) {
+    const auto program = compile({
+        host<name>(),
+        literal_t(" "),
+        process<name>(),
+        literal_t("["),
+        process<id>(),
+        literal_t("]: "),
+        message_t()
+    });
+
+    ASSERT_EQ(2, program.code.size());
+    EXPECT_EQ(opcode_t::literal, program.code[0].opcode);
+    EXPECT_EQ(opcode_t::message, program.code[1].opcode);
+    EXPECT_EQ(this_process::host().to_string() + " " + procname().to_string() + "[" +
+        std::to_string(this_process::id()) + "]: ", program.arena);
+    EXPECT_EQ(this_process::id(), program.pid);
+}
+
+TEST(program_t, KeepsProcessIdUnlessFolded) {
+    const auto program = compile({process<name>(), process<id>()}, false);
+
+    ASSERT_EQ(2, program.code.size());
+    EXPECT_EQ(opcode_t::literal, program.code[0].opcode);
+    EXPECT_EQ(opcode_t::process_id, program.code[1].opcode);
+    EXPECT_EQ(0, program.pid);
+}
+
+TEST(program_t, KeepsConstantsWithInapplicableSpecifications) {
+    const auto program = compile({host<name>("{:d}")});
+
+    ASSERT_EQ(1, program.code.size());
+    EXPECT_EQ(opcode_t::host_name, program.code[0].opcode);
+}
+
+TEST(program_t, RendersSeverityNames) {
+    auto program = compile({severity<user>("{:>6}"), literal_t(" "), severity<user>("{:d}")});
+
+    render(program, {"debug", "info"});
+
+    ASSERT_EQ(3, program.code.size());
+
+    const auto& instruction = program.code[0];
+    EXPECT_EQ(2, instruction.size);
+    ASSERT_EQ(3, program.bounds.size());
+    EXPECT_EQ(" debug", program.arena.substr(program.bounds[instruction.offset], 6));
+    EXPECT_EQ("  info", program.arena.substr(program.bounds[instruction.offset + 1], 6));
+
+    // Strings can't be formatted as numbers, so the names are left to be formatted.
+    EXPECT_EQ(0, program.code[2].size);
+}
+
+}  // namespace
+}  // namespace string
+}  // namespace formatter
+}  // namespace detail
+}  // namespace v1
+}  // namespace blackhole
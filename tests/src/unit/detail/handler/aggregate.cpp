@@ -0,0 +1,267 @@
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <boost/variant/apply_visitor.hpp>
+
+#include <blackhole/attribute.hpp>
+#include <blackhole/attributes.hpp>
+#include <blackhole/extensions/writer.hpp>
+#include <blackhole/handler/aggregate.hpp>
+#include <blackhole/record.hpp>
+#include <blackhole/detail/attribute.hpp>
+
+#include "mocks/handler.hpp"
+#include "mocks/registry.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace handler {
+namespace {
+
+using ::testing::Invoke;
+using ::testing::_;
+
+using namespace testing;
+
+typedef aggregate_t::metric_t metric_t;
+
+/// Emitted record with its attributes formatted as strings.
+struct emitted_t {
+    std::string name;
+    int severity;
+    std::map<std::string, std::string> attributes;
+};
+
+struct stringify_t : public boost::static_visitor<std::string> {
+    template<typename T>
+    auto operator()(const T& value) const -> std::string {
+        writer_t writer;
+        writer.write("{}", value);
+        return writer.result().to_string();
+    }
+
+    auto operator()(const attribute::view_t::null_type&) const -> std::string {
+        return "null";
+    }
+
+    auto operator()(const attribute::view_t::string_type& value) const -> std::string {
+        return value.to_string();
+    }
+
+    auto operator()(const attribute::view_t::function_type&) const -> std::string {
+        return "function";
+    }
+};
+
+/// Returns a wrapped mock handler, which appends all handled records to the output.
+auto capture(std::vector<emitted_t>& output, std::mutex& mutex) -> std::unique_ptr<handler_t> {
+    std::unique_ptr<mock::handler_t> handler(new mock::handler_t);
+    EXPECT_CALL(*handler, handle(_))
+        .WillRepeatedly(Invoke([&](const record_t& record) {
+            emitted_t emitted{record.message().to_string(), record.severity(), {}};
+            for (const auto& list : record.attributes()) {
+                for (const auto& kv : list.get()) {
+                    emitted.attributes[kv.first.to_string()] =
+                        boost::apply_visitor(stringify_t(), kv.second.inner().value);
+                }
+            }
+
+            std::lock_guard<std::mutex> lock(mutex);
+            output.push_back(emitted);
+        }));
+
+    return std::move(handler);
+}
+
+auto log(handler_t& handler, int severity, const attribute_list& attributes = {}) -> void {
+    const string_view message("-");
+    const attribute_pack pack{attributes};
+    record_t record(severity, message, pack);
+    handler.handle(record);
+}
+
+TEST(aggregate_t, ThrowsWithoutMetrics) {
+    EXPECT_THROW(aggregate_t(nullptr, {}), std::invalid_argument);
+}
+
+TEST(aggregate_t, ThrowsOnDecreasingBuckets) {
+    EXPECT_THROW(aggregate_t(nullptr, {metric_t::histogram("latency", "elapsed", {10, 5})}),
+        std::invalid_argument);
+}
+
+TEST(aggregate_t, CountsByLabels) {
+    std::mutex mutex;
+    std::vector<emitted_t> output;
+
+    aggregate_t handler(capture(output, mutex),
+        {metric_t::counter("requests", {"severity", "endpoint"})},
+        std::chrono::milliseconds(0), 7);
+
+    log(handler, 1, {{"endpoint", "/"}});
+    log(handler, 1, {{"endpoint", "/"}});
+    log(handler, 3, {{"endpoint", "/"}});
+    log(handler, 1, {{"endpoint", "/api"}});
+    log(handler, 1);
+
+    handler.emit();
+
+    ASSERT_EQ(4, output.size());
+
+    EXPECT_EQ("requests", output[0].name);
+    EXPECT_EQ(7, output[0].severity);
+
+    EXPECT_EQ("1", output[0].attributes["severity"]);
+    EXPECT_EQ("", output[0].attributes["endpoint"]);
+    EXPECT_EQ("1", output[0].attributes["count"]);
+
+    EXPECT_EQ("/", output[1].attributes["endpoint"]);
+    EXPECT_EQ("2", output[1].attributes["count"]);
+    EXPECT_EQ("/api", output[2].attributes["endpoint"]);
+    EXPECT_EQ("1", output[2].attributes["count"]);
+    EXPECT_EQ("3", output[3].attributes["severity"]);
+    EXPECT_EQ("1", output[3].attributes["count"]);
+}
+
+TEST(aggregate_t, EmitsDeltas) {
+    std::mutex mutex;
+    std::vector<emitted_t> output;
+
+    aggregate_t handler(capture(output, mutex), {metric_t::counter("records")},
+        std::chrono::milliseconds(0));
+
+    log(handler, 0);
+    handler.emit();
+    handler.emit();
+
+    ASSERT_EQ(1, output.size());
+
+    log(handler, 0);
+    log(handler, 0);
+    handler.emit();
+
+    ASSERT_EQ(2, output.size());
+    EXPECT_EQ("2", output[1].attributes["count"]);
+}
+
+TEST(aggregate_t, IgnoresRecordsBelowThreshold) {
+    std::mutex mutex;
+    std::vector<emitted_t> output;
+
+    auto metric = metric_t::counter("errors");
+    metric.threshold = 3;
+
+    aggregate_t handler(capture(output, mutex), {metric}, std::chrono::milliseconds(0));
+
+    log(handler, 2);
+    log(handler, 3);
+    log(handler, 4);
+    handler.emit();
+
+    ASSERT_EQ(1, output.size());
+    EXPECT_EQ("2", output[0].attributes["count"]);
+}
+
+TEST(aggregate_t, Histogram) {
+    std::mutex mutex;
+    std::vector<emitted_t> output;
+
+    aggregate_t handler(capture(output, mutex),
+        {metric_t::histogram("latency", "elapsed", {1, 10, 100})},
+        std::chrono::milliseconds(0));
+
+    log(handler, 0, {{"elapsed", 1}});
+    log(handler, 0, {{"elapsed", 5.5}});
+    log(handler, 0, {{"elapsed", 50U}});
+    log(handler, 0, {{"elapsed", 500}});
+    // Records without a numeric value are not observed.
+    log(handler, 0, {{"elapsed", "slow"}});
+    log(handler, 0);
+
+    handler.emit();
+
+    ASSERT_EQ(1, output.size());
+
+    auto& attributes = output[0].attributes;
+    EXPECT_EQ("4", attributes["count"]);
+    EXPECT_EQ("556.5", attributes["sum"]);
+    EXPECT_EQ("1", attributes["le_1"]);
+    EXPECT_EQ("2", attributes["le_10"]);
+    EXPECT_EQ("3", attributes["le_100"]);
+}
+
+TEST(aggregate_t, MergesThreads) {
+    std::mutex mutex;
+    std::vector<emitted_t> output;
+
+    aggregate_t handler(capture(output, mutex), {metric_t::counter("records")},
+        std::chrono::milliseconds(0));
+
+    std::vector<std::thread> threads;
+    for (int id = 0; id < 4; ++id) {
+        threads.emplace_back([&] {
+            for (int i = 0; i < 1000; ++i) {
+                log(handler, 0);
+            }
+        });
+    }
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    handler.emit();
+
+    ASSERT_EQ(1, output.size());
+    EXPECT_EQ("4000", output[0].attributes["count"]);
+}
+
+TEST(aggregate_t, EmitsPeriodically) {
+    std::mutex mutex;
+    std::vector<emitted_t> output;
+
+    aggregate_t handler(capture(output, mutex), {metric_t::counter("records")},
+        std::chrono::milliseconds(1));
+
+    log(handler, 0);
+
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (std::chrono::steady_clock::now() < deadline) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!output.empty()) {
+            break;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    ASSERT_EQ(1, output.size());
+    EXPECT_EQ("1", output[0].attributes["count"]);
+}
+
+TEST(aggregate_t, EmitsOnDestruction) {
+    std::mutex mutex;
+    std::vector<emitted_t> output;
+
+    {
+        aggregate_t handler(capture(output, mutex), {metric_t::counter("records")});
+        log(handler, 0);
+    }
+
+    ASSERT_EQ(1, output.size());
+}
+
+TEST(aggregate_t, FactoryType) {
+    EXPECT_EQ(std::string("aggregate"), factory<aggregate_t>(mock_registry_t()).type());
+}
+
+}  // namespace
+}  // namespace handler
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,452 @@
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <blackhole/attribute.hpp>
+#include <blackhole/extensions/writer.hpp>
+#include <blackhole/handler/asynchronous.hpp>
+#include <blackhole/record.hpp>
+#include <src/handler/asynchronous.hpp>
+
+#include "mocks/formatter.hpp"
+#include "mocks/registry.hpp"
+#include "mocks/sink.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace handler {
+namespace {
+
+using ::testing::Invoke;
+using ::testing::_;
+
+using namespace testing;
+
+TEST(asynchronous_handler_t, FormatsAndEmitsOnWorkerThread) {
+    std::unique_ptr<mock::formatter_t> formatter_(new mock::formatter_t);
+    mock::formatter_t& formatter = *formatter_;
+
+    std::unique_ptr<mock::sink_t> sink_(new mock::sink_t);
+    mock::sink_t& sink = *sink_;
+
+    std::vector<std::unique_ptr<sink_t>> sinks;
+    sinks.emplace_back(std::move(sink_));
+
+    const auto caller = std::this_thread::get_id();
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool emitted = false;
+
+    EXPECT_CALL(formatter, format(_, _))
+        .Times(1)
+        .WillOnce(Invoke([&](const record_t& record, writer_t& writer) {
+            EXPECT_NE(caller, std::this_thread::get_id());
+            EXPECT_EQ(42, record.severity());
+            EXPECT_EQ("-", record.message().to_string());
+            ASSERT_EQ(1, record.attributes().size());
+            EXPECT_EQ((attribute_list{{"key#1", "value#1"}}), record.attributes().at(0).get());
+
+            writer.write("---");
+        }));
+
+    EXPECT_CALL(sink, emit(_, string_view("---")))
+        .Times(1)
+        .WillOnce(Invoke([&](const record_t&, const string_view&) {
+            std::lock_guard<std::mutex> lock(mutex);
+            emitted = true;
+            cv.notify_one();
+        }));
+
+    asynchronous_t handler(std::move(formatter_), std::move(sinks));
+
+    {
+        // The handler must not keep references to the record, which is destroyed right after
+        // handling.
+        const std::string value("value#1");
+        const attribute_list attributes{{"key#1", value}};
+        const attribute_pack pack{attributes};
+        const string_view message("-");
+        record_t record(42, message, pack);
+
+        handler.handle(record);
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    EXPECT_TRUE(cv.wait_for(lock, std::chrono::seconds(5), [&] { return emitted; }));
+}
+
+TEST(asynchronous_handler_t, EmitsInOrderWithSingleWorker) {
+    std::unique_ptr<mock::formatter_t> formatter(new mock::formatter_t);
+    std::unique_ptr<mock::sink_t> sink(new mock::sink_t);
+
+    std::vector<std::string> messages;
+
+    EXPECT_CALL(*formatter, format(_, _))
+        .Times(100)
+        .WillRepeatedly(Invoke([&](const record_t& record, writer_t& writer) {
+            writer.write("{}", record.severity());
+        }));
+
+    EXPECT_CALL(*sink, emit(_, _))
+        .Times(100)
+        .WillRepeatedly(Invoke([&](const record_t&, const string_view& message) {
+            messages.push_back(message.to_string());
+        }));
+
+    std::vector<std::unique_ptr<sink_t>> sinks;
+    sinks.emplace_back(std::move(sink));
+
+    {
+        asynchronous_t handler(std::move(formatter), std::move(sinks), 4);
+
+        const string_view message("-");
+        const attribute_pack pack;
+
+        for (int i = 0; i < 100; ++i) {
+            record_t record(i, message, pack);
+            handler.handle(record);
+        }
+    }
+
+    ASSERT_EQ(100, messages.size());
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_EQ(std::to_string(i), messages[static_cast<std::size_t>(i)]);
+    }
+}
+
+TEST(asynchronous_handler_t, EmitsAllWithSeveralWorkers) {
+    std::unique_ptr<mock::formatter_t> formatter(new mock::formatter_t);
+    std::unique_ptr<mock::sink_t> sink(new mock::sink_t);
+
+    std::mutex mutex;
+    std::vector<int> severities;
+
+    EXPECT_CALL(*formatter, format(_, _))
+        .Times(1000);
+
+    EXPECT_CALL(*sink, emit(_, _))
+        .Times(1000)
+        .WillRepeatedly(Invoke([&](const record_t& record, const string_view&) {
+            std::lock_guard<std::mutex> lock(mutex);
+            severities.push_back(record.severity());
+        }));
+
+    std::vector<std::unique_ptr<sink_t>> sinks;
+    sinks.emplace_back(std::move(sink));
+
+    {
+        asynchronous_t handler(std::move(formatter), std::move(sinks), 4, 4);
+
+        const string_view message("-");
+        const attribute_pack pack;
+
+        for (int i = 0; i < 1000; ++i) {
+            record_t record(i, message, pack);
+            handler.handle(record);
+        }
+    }
+
+    std::sort(severities.begin(), severities.end());
+
+    ASSERT_EQ(1000, severities.size());
+    for (int i = 0; i < 1000; ++i) {
+        EXPECT_EQ(i, severities[static_cast<std::size_t>(i)]);
+    }
+}
+
+TEST(asynchronous_handler_t, EmitsBatchesInOrder) {
+    std::unique_ptr<mock::formatter_t> formatter(new mock::formatter_t);
+    std::unique_ptr<mock::sink_t> sink(new mock::sink_t);
+
+    std::vector<std::string> messages;
+
+    EXPECT_CALL(*formatter, format(_, _))
+        .Times(100)
+        .WillRepeatedly(Invoke([&](const record_t& record, writer_t& writer) {
+            writer.write("{}", record.severity());
+        }));
+
+    EXPECT_CALL(*sink, emit(_, _))
+        .Times(100)
+        .WillRepeatedly(Invoke([&](const record_t&, const string_view& message) {
+            messages.push_back(message.to_string());
+        }));
+
+    std::vector<std::unique_ptr<sink_t>> sinks;
+    sinks.emplace_back(std::move(sink));
+
+    {
+        // The queue is smaller than the number of records, but not than the number of batches.
+        asynchronous_t handler(std::move(formatter), std::move(sinks), 2, 1, nullptr, 16);
+
+        const string_view message("-");
+        const attribute_pack pack;
+
+        for (int i = 0; i < 100; ++i) {
+            record_t record(i, message, pack);
+            handler.handle(record);
+        }
+    }
+
+    ASSERT_EQ(100, messages.size());
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_EQ(std::to_string(i), messages[static_cast<std::size_t>(i)]);
+    }
+}
+
+TEST(asynchronous_handler_t, FlushEnqueuesPendingBatches) {
+    std::unique_ptr<mock::formatter_t> formatter(new mock::formatter_t);
+    std::unique_ptr<mock::sink_t> sink(new mock::sink_t);
+    mock::sink_t& view = *sink;
+
+    EXPECT_CALL(*formatter, format(_, _))
+        .Times(10);
+    EXPECT_CALL(view, emit(_, _))
+        .Times(10);
+
+    std::vector<std::unique_ptr<sink_t>> sinks;
+    sinks.emplace_back(std::move(sink));
+
+    asynchronous_t handler(std::move(formatter), std::move(sinks), 4, 1, nullptr, 64,
+        std::chrono::seconds(60));
+
+    const string_view message("-");
+    const attribute_pack pack;
+
+    for (int i = 0; i < 10; ++i) {
+        record_t record(i, message, pack);
+        handler.handle(record);
+    }
+
+    EXPECT_TRUE(handler.flush(std::chrono::steady_clock::now() + std::chrono::seconds(5)));
+    ::testing::Mock::VerifyAndClearExpectations(&view);
+}
+
+TEST(asynchronous_handler_t, EnqueuesLingeringBatches) {
+    std::unique_ptr<mock::formatter_t> formatter(new mock::formatter_t);
+    std::unique_ptr<mock::sink_t> sink(new mock::sink_t);
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    int emitted = 0;
+
+    EXPECT_CALL(*formatter, format(_, _))
+        .Times(3);
+
+    EXPECT_CALL(*sink, emit(_, _))
+        .Times(3)
+        .WillRepeatedly(Invoke([&](const record_t&, const string_view&) {
+            std::lock_guard<std::mutex> lock(mutex);
+            ++emitted;
+            cv.notify_one();
+        }));
+
+    std::vector<std::unique_ptr<sink_t>> sinks;
+    sinks.emplace_back(std::move(sink));
+
+    asynchronous_t handler(std::move(formatter), std::move(sinks), 4, 1, nullptr, 64,
+        std::chrono::milliseconds(1));
+
+    const string_view message("-");
+    const attribute_pack pack;
+
+    for (int i = 0; i < 3; ++i) {
+        record_t record(i, message, pack);
+        handler.handle(record);
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    EXPECT_TRUE(cv.wait_for(lock, std::chrono::seconds(5), [&] { return emitted == 3; }));
+}
+
+TEST(asynchronous_handler_t, EnqueuesPendingBatchesOnThreadExit) {
+    std::unique_ptr<mock::formatter_t> formatter(new mock::formatter_t);
+    std::unique_ptr<mock::sink_t> sink(new mock::sink_t);
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    int emitted = 0;
+
+    EXPECT_CALL(*formatter, format(_, _))
+        .Times(5);
+
+    EXPECT_CALL(*sink, emit(_, _))
+        .Times(5)
+        .WillRepeatedly(Invoke([&](const record_t&, const string_view&) {
+            std::lock_guard<std::mutex> lock(mutex);
+            ++emitted;
+            cv.notify_one();
+        }));
+
+    std::vector<std::unique_ptr<sink_t>> sinks;
+    sinks.emplace_back(std::move(sink));
+
+    asynchronous_t handler(std::move(formatter), std::move(sinks), 4, 1, nullptr, 64,
+        std::chrono::seconds(60));
+
+    std::thread([&] {
+        const string_view message("-");
+        const attribute_pack pack;
+
+        for (int i = 0; i < 5; ++i) {
+            record_t record(i, message, pack);
+            handler.handle(record);
+        }
+    }).join();
+
+    std::unique_lock<std::mutex> lock(mutex);
+    EXPECT_TRUE(cv.wait_for(lock, std::chrono::seconds(5), [&] { return emitted == 5; }));
+}
+
+TEST(asynchronous_handler_t, FormatsBatchSlicesInParallel) {
+    std::unique_ptr<mock::formatter_t> formatter(new mock::formatter_t);
+    std::unique_ptr<mock::sink_t> sink(new mock::sink_t);
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::set<std::thread::id> threads;
+    std::vector<std::string> messages;
+
+    // Each thread waits for all of them to start formatting, so slices can't share a thread.
+    EXPECT_CALL(*formatter, format(_, _))
+        .Times(256)
+        .WillRepeatedly(Invoke([&](const record_t& record, writer_t& writer) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                if (threads.insert(std::this_thread::get_id()).second) {
+                    cv.notify_all();
+                    cv.wait_for(lock, std::chrono::seconds(5), [&] {
+                        return threads.size() == 4;
+                    });
+                }
+            }
+
+            writer.write("{}", record.severity());
+        }));
+
+    EXPECT_CALL(*sink, emit(_, _))
+        .Times(256)
+        .WillRepeatedly(Invoke([&](const record_t&, const string_view& message) {
+            messages.push_back(message.to_string());
+        }));
+
+    std::vector<std::unique_ptr<sink_t>> sinks;
+    sinks.emplace_back(std::move(sink));
+
+    {
+        asynchronous_t handler(std::move(formatter), std::move(sinks), 4, 1, nullptr, 256,
+            std::chrono::seconds(60), 4);
+
+        const string_view message("-");
+        const attribute_pack pack;
+
+        for (int i = 0; i < 256; ++i) {
+            record_t record(i, message, pack);
+            handler.handle(record);
+        }
+    }
+
+    EXPECT_EQ(4, threads.size());
+
+    ASSERT_EQ(256, messages.size());
+    for (int i = 0; i < 256; ++i) {
+        EXPECT_EQ(std::to_string(i), messages[static_cast<std::size_t>(i)]);
+    }
+}
+
+TEST(asynchronous_handler_t, SkipsFailedRecordsOfParallelBatches) {
+    std::unique_ptr<mock::formatter_t> formatter(new mock::formatter_t);
+    std::unique_ptr<mock::sink_t> sink(new mock::sink_t);
+
+    std::vector<std::string> messages;
+
+    EXPECT_CALL(*formatter, format(_, _))
+        .Times(200)
+        .WillRepeatedly(Invoke([&](const record_t& record, writer_t& writer) {
+            if (record.severity() % 10 == 0) {
+                throw std::runtime_error("failed");
+            }
+
+            if (record.severity() % 10 == 1) {
+                writer.skip();
+                return;
+            }
+
+            writer.write("{}", record.severity());
+        }));
+
+    EXPECT_CALL(*sink, emit(_, _))
+        .Times(160)
+        .WillRepeatedly(Invoke([&](const record_t& record, const string_view& message) {
+            EXPECT_EQ(std::to_string(record.severity()), message.to_string());
+            messages.push_back(message.to_string());
+        }));
+
+    std::vector<std::unique_ptr<sink_t>> sinks;
+    sinks.emplace_back(std::move(sink));
+
+    {
+        asynchronous_t handler(std::move(formatter), std::move(sinks), 4, 1, nullptr, 200,
+            std::chrono::seconds(60), 3);
+
+        const string_view message("-");
+        const attribute_pack pack;
+
+        for (int i = 0; i < 200; ++i) {
+            record_t record(i, message, pack);
+            handler.handle(record);
+        }
+    }
+
+    ASSERT_EQ(160, messages.size());
+    EXPECT_TRUE(std::is_sorted(messages.begin(), messages.end(),
+        [](const std::string& lhs, const std::string& rhs) {
+            return std::stoi(lhs) < std::stoi(rhs);
+        }));
+}
+
+TEST(asynchronous_handler_t, ThrowsOnZeroParallel) {
+    std::unique_ptr<mock::formatter_t> formatter(new mock::formatter_t);
+
+    EXPECT_THROW(asynchronous_t(std::move(formatter), {}, 4, 1, nullptr, 1,
+        asynchronous_t::default_linger, 0), std::invalid_argument);
+}
+
+TEST(asynchronous_handler_t, ThrowsOnZeroBatch) {
+    std::unique_ptr<mock::formatter_t> formatter(new mock::formatter_t);
+
+    EXPECT_THROW(asynchronous_t(std::move(formatter), {}, 4, 1, nullptr, 0),
+        std::invalid_argument);
+}
+
+TEST(asynchronous_handler_t, ThrowsOnZeroWorkers) {
+    std::unique_ptr<mock::formatter_t> formatter(new mock::formatter_t);
+
+    EXPECT_THROW(asynchronous_t(std::move(formatter), {}, 4, 0), std::invalid_argument);
+}
+
+TEST(asynchronous_handler_t, ThrowsOnInvalidFactor) {
+    std::unique_ptr<mock::formatter_t> formatter(new mock::formatter_t);
+
+    EXPECT_THROW(asynchronous_t(std::move(formatter), {}, 21), std::invalid_argument);
+}
+
+TEST(asynchronous_handler_t, FactoryType) {
+    mock_registry_t registry;
+    factory<asynchronous_t> factory(registry);
+
+    EXPECT_EQ(std::string("asynchronous"), factory.type());
+}
+
+}  // namespace
+}  // namespace handler
+}  // namespace v1
+}  // namespace blackhole
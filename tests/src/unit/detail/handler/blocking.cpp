@@ -1,9 +1,16 @@
+#include <stdexcept>
+#include <string>
+#include <vector>
+
 #include <gtest/gtest.h>
 
 #include <blackhole/attribute.hpp>
+#include <blackhole/filter.hpp>
 #include <blackhole/extensions/writer.hpp>
 #include <blackhole/handler/blocking.hpp>
 #include <blackhole/record.hpp>
+#include <src/filter/sample.hpp>
+#include <src/filter/severity.hpp>
 #include <src/handler/blocking.hpp>
 
 #include "mocks/formatter.hpp"
@@ -51,6 +58,556 @@ TEST(blocking_t, Handle) {
     handler.handle(record);
 }
 
+TEST(blocking_t, DropsRecordsSkippedByFormatter) {
+    std::unique_ptr<mock::formatter_t> formatter_(new mock::formatter_t);
+    mock::formatter_t& formatter = *formatter_;
+
+    std::unique_ptr<mock::sink_t> sink_(new mock::sink_t);
+    mock::sink_t& sink = *sink_;
+
+    std::vector<std::unique_ptr<sink_t>> sinks;
+    sinks.emplace_back(std::move(sink_));
+
+    blocking_t handler(std::move(formatter_), std::move(sinks));
+
+    EXPECT_CALL(formatter, format(_, _))
+        .Times(4)
+        .WillRepeatedly(Invoke([](const record_t& record, writer_t& writer) {
+            writer.write("{}", record.severity());
+
+            if (record.severity() == 0) {
+                writer.skip();
+            }
+        }));
+
+    // The reused writer must not keep skipping, neither in single nor in batch mode.
+    EXPECT_CALL(sink, emit(_, string_view("1")))
+        .Times(2);
+
+    const string_view message("-");
+    const attribute_pack pack;
+    const record_t records[] = {record_t(0, message, pack), record_t(1, message, pack)};
+
+    handler.handle(records[0]);
+    handler.handle(records[1]);
+    handler.handle_batch(records, 2);
+}
+
+TEST(blocking_t, ReusesWriterBuffer) {
+    std::unique_ptr<mock::formatter_t> formatter_(new mock::formatter_t);
+    mock::formatter_t& formatter = *formatter_;
+
+    std::vector<std::unique_ptr<sink_t>> sinks;
+    sinks.emplace_back(new ::testing::NiceMock<mock::sink_t>);
+    blocking_t handler(std::move(formatter_), std::move(sinks));
+
+    const char* data = nullptr;
+    EXPECT_CALL(formatter, format(_, _))
+        .Times(2)
+        .WillOnce(Invoke([&](const record_t&, writer_t& writer) {
+            writer.write(std::string(4096, 'x'));
+            data = writer.inner.data();
+        }))
+        .WillOnce(Invoke([&](const record_t&, writer_t& writer) {
+            EXPECT_EQ(0, writer.inner.size());
+            EXPECT_EQ(data, writer.inner.data());
+        }));
+
+    const string_view message("-");
+    const attribute_pack pack;
+    record_t record(42, message, pack);
+
+    handler.handle(record);
+    handler.handle(record);
+}
+
+TEST(blocking_t, ReleasesWriterBufferOverCapacity) {
+    std::unique_ptr<mock::formatter_t> formatter_(new mock::formatter_t);
+    mock::formatter_t& formatter = *formatter_;
+
+    std::vector<std::unique_ptr<sink_t>> sinks;
+    sinks.emplace_back(new ::testing::NiceMock<mock::sink_t>);
+    blocking_t handler(std::move(formatter_), std::move(sinks), 1024);
+
+    const char* data = nullptr;
+    EXPECT_CALL(formatter, format(_, _))
+        .Times(2)
+        .WillOnce(Invoke([&](const record_t&, writer_t& writer) {
+            writer.write(std::string(4096, 'x'));
+            data = writer.inner.data();
+        }))
+        .WillOnce(Invoke([&](const record_t&, writer_t& writer) {
+            EXPECT_EQ(0, writer.inner.size());
+            EXPECT_NE(data, writer.inner.data());
+        }));
+
+    const string_view message("-");
+    const attribute_pack pack;
+    record_t record(42, message, pack);
+
+    handler.handle(record);
+    handler.handle(record);
+}
+
+TEST(blocking_t, ReentrantHandleUsesSeparateWriter) {
+    std::unique_ptr<mock::formatter_t> formatter_(new mock::formatter_t);
+    mock::formatter_t& formatter = *formatter_;
+
+    std::unique_ptr<mock::sink_t> sink_(new mock::sink_t);
+    mock::sink_t& sink = *sink_;
+
+    std::vector<std::unique_ptr<sink_t>> sinks;
+    sinks.emplace_back(std::move(sink_));
+
+    blocking_t handler(std::move(formatter_), std::move(sinks));
+
+    EXPECT_CALL(formatter, format(_, _))
+        .Times(2)
+        .WillRepeatedly(Invoke([](const record_t& record, writer_t& writer) {
+            writer.write("{}", record.severity());
+        }));
+
+    const string_view message("-");
+    const attribute_pack pack;
+    record_t outer(1, message, pack);
+    record_t inner(2, message, pack);
+
+    std::vector<std::string> emitted;
+    EXPECT_CALL(sink, emit(_, _))
+        .Times(2)
+        .WillRepeatedly(Invoke([&](const record_t& record, const string_view& formatted) {
+            if (record.severity() == 1) {
+                handler.handle(inner);
+            }
+
+            emitted.push_back(formatted.to_string());
+        }));
+
+    handler.handle(outer);
+
+    EXPECT_EQ((std::vector<std::string>{"2", "1"}), emitted);
+}
+
+/// Sink lending regions of its own buffer.
+class lending_t : public sink_t {
+public:
+    std::vector<char> buffer;
+    std::vector<std::string> committed;
+    std::vector<std::string> emitted;
+    std::size_t cancelled;
+    std::size_t requested;
+
+    explicit lending_t(std::size_t size) :
+        buffer(size),
+        cancelled(0),
+        requested(0)
+    {}
+
+    auto emit(const record_t&, const string_view& message) -> void override {
+        emitted.push_back(message.to_string());
+    }
+
+    auto lend(const record_t&, std::size_t size) -> region_t override {
+        requested = size;
+        return region_t{buffer.data(), buffer.size()};
+    }
+
+    auto commit(const record_t&, std::size_t size) -> void override {
+        committed.emplace_back(buffer.data(), size);
+    }
+
+    auto cancel() noexcept -> void override {
+        ++cancelled;
+    }
+};
+
+TEST(blocking_t, FormatsIntoLentRegion) {
+    std::unique_ptr<mock::formatter_t> formatter_(new mock::formatter_t);
+    mock::formatter_t& formatter = *formatter_;
+
+    std::unique_ptr<lending_t> sink_(new lending_t(64));
+    lending_t& sink = *sink_;
+
+    std::vector<std::unique_ptr<sink_t>> sinks;
+    sinks.emplace_back(std::move(sink_));
+
+    blocking_t handler(std::move(formatter_), std::move(sinks));
+
+    EXPECT_CALL(formatter, format(_, _))
+        .Times(1)
+        .WillOnce(Invoke([&](const record_t&, writer_t& writer) {
+            writer.write("le message");
+            EXPECT_EQ(sink.buffer.data(), writer.inner.data());
+        }));
+
+    const string_view message("-");
+    const attribute_pack pack;
+    record_t record(0, message, pack);
+    record.activate(message);
+
+    handler.handle(record);
+
+    EXPECT_EQ(101, sink.requested);
+    EXPECT_EQ((std::vector<std::string>{"le message"}), sink.committed);
+    EXPECT_TRUE(sink.emitted.empty());
+    EXPECT_EQ(0, sink.cancelled);
+}
+
+TEST(blocking_t, EmitsRecordsOutgrowingLentRegion) {
+    std::unique_ptr<mock::formatter_t> formatter_(new mock::formatter_t);
+    mock::formatter_t& formatter = *formatter_;
+
+    std::unique_ptr<lending_t> sink_(new lending_t(4));
+    lending_t& sink = *sink_;
+
+    std::vector<std::unique_ptr<sink_t>> sinks;
+    sinks.emplace_back(std::move(sink_));
+
+    blocking_t handler(std::move(formatter_), std::move(sinks));
+
+    EXPECT_CALL(formatter, format(_, _))
+        .Times(2)
+        .WillRepeatedly(Invoke([](const record_t&, writer_t& writer) {
+            writer.write("le message");
+        }));
+
+    const string_view message("-");
+    const attribute_pack pack;
+    record_t record(0, message, pack);
+
+    handler.handle(record);
+
+    EXPECT_TRUE(sink.committed.empty());
+    EXPECT_EQ((std::vector<std::string>{"le message"}), sink.emitted);
+    EXPECT_EQ(1, sink.cancelled);
+
+    // The writer keeps its own memory for the next record.
+    handler.handle(record);
+    EXPECT_EQ(2, sink.emitted.size());
+}
+
+/// Sink keeping slices of gathered records.
+class gathering_t : public sink_t {
+public:
+    std::vector<std::string> emitted;
+    std::vector<std::vector<std::string>> gathered;
+    std::vector<const char*> pointers;
+
+    auto emit(const record_t&, const string_view& message) -> void override {
+        emitted.push_back(message.to_string());
+    }
+
+    auto emit_gathered(const record_t&, const string_view* slices, std::size_t count) ->
+        void override
+    {
+        gathered.emplace_back();
+
+        for (std::size_t id = 0; id < count; ++id) {
+            gathered.back().push_back(slices[id].to_string());
+            pointers.push_back(slices[id].data());
+        }
+    }
+};
+
+TEST(blocking_t, GathersLargeStrings) {
+    std::unique_ptr<mock::formatter_t> formatter_(new mock::formatter_t);
+    mock::formatter_t& formatter = *formatter_;
+
+    std::unique_ptr<gathering_t> sink_(new gathering_t);
+    gathering_t& sink = *sink_;
+
+    std::vector<std::unique_ptr<sink_t>> sinks;
+    sinks.emplace_back(std::move(sink_));
+
+    blocking_t handler(std::move(formatter_), std::move(sinks), 0, 8);
+
+    EXPECT_CALL(formatter, format(_, _))
+        .Times(2)
+        .WillRepeatedly(Invoke([](const record_t& record, writer_t& writer) {
+            writer.write("[");
+            writer.reference(record.message());
+            writer.write("]");
+        }));
+
+    const string_view large("le large message");
+    const string_view small("le msg");
+    const attribute_pack pack;
+
+    handler.handle(record_t(0, large, pack));
+    handler.handle(record_t(0, small, pack));
+
+    ASSERT_EQ(1, sink.gathered.size());
+    EXPECT_EQ((std::vector<std::string>{"[", "le large message", "]"}), sink.gathered[0]);
+    EXPECT_EQ(large.data(), sink.pointers[1]);
+
+    EXPECT_EQ((std::vector<std::string>{"[le msg]"}), sink.emitted);
+}
+
+TEST(blocking_t, ConcatenatesGatheredRecordsByDefault) {
+    std::unique_ptr<mock::formatter_t> formatter_(new mock::formatter_t);
+    mock::formatter_t& formatter = *formatter_;
+
+    std::unique_ptr<lending_t> sink_(new lending_t(4));
+    lending_t& sink = *sink_;
+
+    std::vector<std::unique_ptr<sink_t>> sinks;
+    sinks.emplace_back(std::move(sink_));
+
+    blocking_t handler(std::move(formatter_), std::move(sinks), 0, 8);
+
+    EXPECT_CALL(formatter, format(_, _))
+        .Times(1)
+        .WillOnce(Invoke([](const record_t& record, writer_t& writer) {
+            writer.reference(record.message());
+            writer.write(" at {}", 42);
+            writer.reference(record.message());
+        }));
+
+    const string_view message("le large message");
+    const attribute_pack pack;
+
+    handler.handle(record_t(0, message, pack));
+
+    // Records that large are not formatted into lent regions.
+    EXPECT_TRUE(sink.committed.empty());
+    EXPECT_EQ(0, sink.cancelled);
+    EXPECT_EQ((std::vector<std::string>{"le large message at 42le large message"}),
+        sink.emitted);
+}
+
+TEST(blocking_t, CancelsLentRegionOnSkipAndThrow) {
+    std::unique_ptr<mock::formatter_t> formatter_(new mock::formatter_t);
+    mock::formatter_t& formatter = *formatter_;
+
+    std::unique_ptr<lending_t> sink_(new lending_t(64));
+    lending_t& sink = *sink_;
+
+    std::vector<std::unique_ptr<sink_t>> sinks;
+    sinks.emplace_back(std::move(sink_));
+
+    blocking_t handler(std::move(formatter_), std::move(sinks));
+
+    EXPECT_CALL(formatter, format(_, _))
+        .Times(2)
+        .WillOnce(Invoke([](const record_t&, writer_t& writer) {
+            writer.skip();
+        }))
+        .WillOnce(Invoke([](const record_t&, writer_t&) {
+            throw std::runtime_error("failed");
+        }));
+
+    const string_view message("-");
+    const attribute_pack pack;
+    record_t record(0, message, pack);
+
+    handler.handle(record);
+    EXPECT_THROW(handler.handle(record), std::runtime_error);
+
+    EXPECT_TRUE(sink.committed.empty());
+    EXPECT_TRUE(sink.emitted.empty());
+    EXPECT_EQ(2, sink.cancelled);
+}
+
+TEST(blocking_t, CopiesIntoMultipleSinks) {
+    std::unique_ptr<mock::formatter_t> formatter_(new mock::formatter_t);
+    mock::formatter_t& formatter = *formatter_;
+
+    std::unique_ptr<lending_t> first_(new lending_t(64));
+    std::unique_ptr<lending_t> second_(new lending_t(64));
+    lending_t& first = *first_;
+    lending_t& second = *second_;
+
+    std::vector<std::unique_ptr<sink_t>> sinks;
+    sinks.emplace_back(std::move(first_));
+    sinks.emplace_back(std::move(second_));
+
+    blocking_t handler(std::move(formatter_), std::move(sinks));
+
+    EXPECT_CALL(formatter, format(_, _))
+        .Times(1)
+        .WillOnce(Invoke([](const record_t&, writer_t& writer) {
+            writer.write("le message");
+        }));
+
+    const string_view message("-");
+    const attribute_pack pack;
+    record_t record(0, message, pack);
+
+    handler.handle(record);
+
+    EXPECT_EQ(0, first.requested);
+    EXPECT_EQ((std::vector<std::string>{"le message"}), first.emitted);
+    EXPECT_EQ((std::vector<std::string>{"le message"}), second.emitted);
+}
+
+class deny_odd_t : public filter_t {
+public:
+    auto filter(const record_t& record) -> filter_t::action_t override {
+        return record.severity() % 2 ? filter_t::action_t::deny : filter_t::action_t::neutral;
+    }
+};
+
+TEST(blocking_t, ThrowsOnFiltersCountMismatch) {
+    std::vector<std::unique_ptr<sink_t>> sinks;
+    sinks.emplace_back(new mock::sink_t);
+    sinks.emplace_back(new mock::sink_t);
+
+    std::vector<std::unique_ptr<filter_t>> filters;
+    filters.emplace_back(new filter::severity_t(1));
+
+    EXPECT_THROW(blocking_t(std::unique_ptr<formatter_t>(new mock::formatter_t), std::move(sinks),
+        std::move(filters)), std::invalid_argument);
+}
+
+TEST(blocking_t, SeverityFilterPerSink) {
+    std::unique_ptr<mock::formatter_t> formatter_(new mock::formatter_t);
+    mock::formatter_t& formatter = *formatter_;
+
+    std::unique_ptr<mock::sink_t> s1_(new mock::sink_t);
+    std::unique_ptr<mock::sink_t> s2_(new mock::sink_t);
+    mock::sink_t& s1 = *s1_;
+    mock::sink_t& s2 = *s2_;
+
+    std::vector<std::unique_ptr<sink_t>> sinks;
+    sinks.emplace_back(std::move(s1_));
+    sinks.emplace_back(std::move(s2_));
+
+    std::vector<std::unique_ptr<filter_t>> filters;
+    filters.emplace_back(nullptr);
+    filters.emplace_back(new filter::severity_t(10));
+
+    blocking_t handler(std::move(formatter_), std::move(sinks), std::move(filters));
+
+    EXPECT_CALL(formatter, format(_, _))
+        .Times(2);
+    EXPECT_CALL(s1, emit(_, _))
+        .Times(2);
+    EXPECT_CALL(s2, emit(_, _))
+        .Times(1)
+        .WillOnce(Invoke([](const record_t& record, const string_view&) {
+            EXPECT_EQ(10, record.severity());
+        }));
+
+    const string_view message("-");
+    const attribute_pack pack;
+    record_t r1(5, message, pack);
+    record_t r2(10, message, pack);
+
+    handler.handle(r1);
+    handler.handle(r2);
+}
+
+TEST(blocking_t, SkipsFormattingWhenAllSinksDeny) {
+    std::unique_ptr<mock::formatter_t> formatter_(new mock::formatter_t);
+    mock::formatter_t& formatter = *formatter_;
+
+    std::unique_ptr<mock::sink_t> s1_(new mock::sink_t);
+    std::unique_ptr<mock::sink_t> s2_(new mock::sink_t);
+    mock::sink_t& s1 = *s1_;
+    mock::sink_t& s2 = *s2_;
+
+    std::vector<std::unique_ptr<sink_t>> sinks;
+    sinks.emplace_back(std::move(s1_));
+    sinks.emplace_back(std::move(s2_));
+
+    std::vector<std::unique_ptr<filter_t>> filters;
+    filters.emplace_back(new filter::severity_t(3));
+    filters.emplace_back(new filter::severity_t(100));
+
+    blocking_t handler(std::move(formatter_), std::move(sinks), std::move(filters));
+
+    EXPECT_CALL(formatter, format(_, _))
+        .Times(1);
+    EXPECT_CALL(s1, emit(_, _))
+        .Times(1);
+    EXPECT_CALL(s2, emit(_, _))
+        .Times(0);
+
+    const string_view message("-");
+    const attribute_pack pack;
+
+    for (int severity : {-1000, -1, 0, 1, 2, 3}) {
+        record_t record(severity, message, pack);
+        handler.handle(record);
+    }
+}
+
+TEST(blocking_t, CustomFilterIsCheckedBeforeFormatting) {
+    std::unique_ptr<mock::formatter_t> formatter_(new mock::formatter_t);
+    mock::formatter_t& formatter = *formatter_;
+
+    std::unique_ptr<mock::sink_t> sink_(new mock::sink_t);
+    mock::sink_t& sink = *sink_;
+
+    std::vector<std::unique_ptr<sink_t>> sinks;
+    sinks.emplace_back(std::move(sink_));
+
+    std::vector<std::unique_ptr<filter_t>> filters;
+    filters.emplace_back(new deny_odd_t);
+
+    blocking_t handler(std::move(formatter_), std::move(sinks), std::move(filters));
+
+    EXPECT_CALL(formatter, format(_, _))
+        .Times(2);
+    EXPECT_CALL(sink, emit(_, _))
+        .Times(2);
+
+    const string_view message("-");
+    const attribute_pack pack;
+
+    for (int severity = 0; severity < 4; ++severity) {
+        record_t record(severity, message, pack);
+        handler.handle(record);
+    }
+}
+
+TEST(blocking_t, EmitsSuppressedSummary) {
+    std::unique_ptr<mock::formatter_t> formatter_(new mock::formatter_t);
+    mock::formatter_t& formatter = *formatter_;
+
+    std::unique_ptr<mock::sink_t> sink_(new mock::sink_t);
+    mock::sink_t& sink = *sink_;
+
+    std::vector<std::unique_ptr<sink_t>> sinks;
+    sinks.emplace_back(std::move(sink_));
+
+    std::vector<std::unique_ptr<filter_t>> filters;
+    filters.emplace_back(new filter::sample_t(2, 1.0, "", std::chrono::nanoseconds(0)));
+
+    blocking_t handler(std::move(formatter_), std::move(sinks), std::move(filters));
+
+    EXPECT_CALL(formatter, format(_, _))
+        .Times(3)
+        .WillRepeatedly(Invoke([](const record_t& record, writer_t& writer) {
+            writer.write("{}", record.formatted().to_string());
+        }));
+
+    std::vector<std::string> emitted;
+    EXPECT_CALL(sink, emit(_, _))
+        .Times(3)
+        .WillRepeatedly(Invoke([&](const record_t& record, const string_view& message) {
+            emitted.push_back(message.to_string());
+
+            if (message == string_view("suppressed 1 messages")) {
+                const auto& attributes = record.attributes().back().get();
+                ASSERT_EQ(2, attributes.size());
+                EXPECT_EQ(attribute::view_t(std::uint64_t(1)), attributes[0].second);
+                EXPECT_EQ(attribute::view_t("-"), attributes[1].second);
+            }
+        }));
+
+    const string_view message("-");
+    const attribute_pack pack;
+
+    for (int id = 0; id < 3; ++id) {
+        record_t record(0, message, pack);
+        record.activate(message);
+        handler.handle(record);
+    }
+
+    EXPECT_EQ((std::vector<std::string>{"-", "suppressed 1 messages", "-"}), emitted);
+}
+
 }  // namespace
 }  // namespace handler
 }  // namespace v1
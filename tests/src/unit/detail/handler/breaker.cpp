@@ -0,0 +1,164 @@
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <blackhole/attribute.hpp>
+#include <blackhole/attributes.hpp>
+#include <blackhole/handler/breaker.hpp>
+#include <blackhole/metrics.hpp>
+#include <blackhole/record.hpp>
+
+#include "mocks/handler.hpp"
+#include "mocks/registry.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace handler {
+namespace {
+
+using ::testing::Return;
+using ::testing::Throw;
+using ::testing::_;
+
+using namespace testing;
+
+auto log(handler_t& handler) -> void {
+    const string_view message("GET /porn.png HTTP/1.1");
+    const attribute_pack pack;
+    record_t record(0, message, pack);
+    handler.handle(record);
+}
+
+auto collect(const handler_t& handler) -> std::string {
+    metrics::snapshot_t snapshot;
+    metrics::collector_t collector(snapshot);
+    handler.collect(collector);
+
+    return metrics::prometheus(snapshot);
+}
+
+TEST(breaker_t, PassesRecords) {
+    std::unique_ptr<mock::handler_t> inner(new mock::handler_t);
+    EXPECT_CALL(*inner, handle(_))
+        .Times(2);
+
+    breaker_t breaker(std::move(inner));
+
+    log(breaker);
+    log(breaker);
+
+    EXPECT_FALSE(breaker.open());
+}
+
+TEST(breaker_t, OpensAfterConsecutiveFailures) {
+    std::unique_ptr<mock::handler_t> inner(new mock::handler_t);
+    EXPECT_CALL(*inner, handle(_))
+        .Times(3)
+        .WillRepeatedly(Throw(std::runtime_error("disk full")));
+
+    breaker_t breaker(std::move(inner), 3, std::chrono::hours(1));
+
+    EXPECT_THROW(log(breaker), std::runtime_error);
+    EXPECT_THROW(log(breaker), std::runtime_error);
+    EXPECT_FALSE(breaker.open());
+    EXPECT_THROW(log(breaker), std::runtime_error);
+    EXPECT_TRUE(breaker.open());
+
+    EXPECT_NO_THROW(log(breaker));
+    EXPECT_NO_THROW(log(breaker));
+
+    EXPECT_EQ(
+        "# TYPE blackhole_breaker_bypassed_total counter\n"
+        "blackhole_breaker_bypassed_total 2\n"
+        "# TYPE blackhole_breaker_opened_total counter\n"
+        "blackhole_breaker_opened_total 1\n", collect(breaker));
+}
+
+TEST(breaker_t, SuccessResetsFailures) {
+    std::unique_ptr<mock::handler_t> inner(new mock::handler_t);
+    EXPECT_CALL(*inner, handle(_))
+        .Times(4)
+        .WillOnce(Throw(std::runtime_error("disk full")))
+        .WillOnce(Return())
+        .WillOnce(Throw(std::runtime_error("disk full")))
+        .WillOnce(Return());
+
+    breaker_t breaker(std::move(inner), 2, std::chrono::hours(1));
+
+    EXPECT_THROW(log(breaker), std::runtime_error);
+    log(breaker);
+    EXPECT_THROW(log(breaker), std::runtime_error);
+    log(breaker);
+
+    EXPECT_FALSE(breaker.open());
+}
+
+TEST(breaker_t, ClosesOnSuccessfulProbe) {
+    std::unique_ptr<mock::handler_t> inner(new mock::handler_t);
+    EXPECT_CALL(*inner, handle(_))
+        .Times(3)
+        .WillOnce(Throw(std::runtime_error("disk full")))
+        .WillRepeatedly(Return());
+
+    breaker_t breaker(std::move(inner), 1, std::chrono::milliseconds(10));
+
+    EXPECT_THROW(log(breaker), std::runtime_error);
+    EXPECT_TRUE(breaker.open());
+    log(breaker);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+    log(breaker);
+    EXPECT_FALSE(breaker.open());
+    log(breaker);
+}
+
+TEST(breaker_t, ReopensOnFailedProbe) {
+    std::unique_ptr<mock::handler_t> inner(new mock::handler_t);
+    EXPECT_CALL(*inner, handle(_))
+        .Times(2)
+        .WillRepeatedly(Throw(std::runtime_error("disk full")));
+
+    breaker_t breaker(std::move(inner), 1, std::chrono::milliseconds(10));
+
+    EXPECT_THROW(log(breaker), std::runtime_error);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+    EXPECT_THROW(log(breaker), std::runtime_error);
+    EXPECT_TRUE(breaker.open());
+    EXPECT_NO_THROW(log(breaker));
+}
+
+TEST(breaker_t, ThrowsOnZeroThreshold) {
+    EXPECT_THROW(breaker_t(std::unique_ptr<handler_t>(new mock::handler_t), 0),
+        std::invalid_argument);
+}
+
+TEST(breaker_t, Builder) {
+    std::unique_ptr<mock::handler_t> inner(new mock::handler_t);
+    EXPECT_CALL(*inner, handle(_))
+        .Times(1)
+        .WillOnce(Throw(std::runtime_error("disk full")));
+
+    auto breaker = builder<breaker_t>(std::move(inner))
+        .threshold(1)
+        .cooldown(std::chrono::hours(1))
+        .build();
+
+    EXPECT_THROW(log(*breaker), std::runtime_error);
+    EXPECT_NO_THROW(log(*breaker));
+}
+
+TEST(breaker_t, FactoryType) {
+    EXPECT_EQ(std::string("breaker"), factory<breaker_t>(mock_registry_t()).type());
+}
+
+}  // namespace
+}  // namespace handler
+}  // namespace v1
+}  // namespace blackhole
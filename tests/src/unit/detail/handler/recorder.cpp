@@ -0,0 +1,214 @@
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <blackhole/attribute.hpp>
+#include <blackhole/attributes.hpp>
+#include <blackhole/handler/recorder.hpp>
+#include <blackhole/metrics.hpp>
+#include <blackhole/record.hpp>
+
+#include "mocks/handler.hpp"
+#include "mocks/registry.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace handler {
+namespace {
+
+using ::testing::Invoke;
+using ::testing::_;
+
+using namespace testing;
+
+/// Returns a wrapped mock handler, which appends messages of all handled records to the output.
+auto capture(std::vector<std::string>& output) -> std::unique_ptr<handler_t> {
+    std::unique_ptr<mock::handler_t> handler(new mock::handler_t);
+    EXPECT_CALL(*handler, handle(_))
+        .WillRepeatedly(Invoke([&](const record_t& record) {
+            output.push_back(record.message().to_string());
+        }));
+
+    return std::move(handler);
+}
+
+auto log(handler_t& handler, int severity, const string_view& message) -> void {
+    const attribute_pack pack;
+    record_t record(severity, message, pack);
+    handler.handle(record);
+}
+
+TEST(recorder_t, DumpsOnTrigger) {
+    std::vector<std::string> output;
+    recorder_t recorder(capture(output), 3, 3);
+
+    log(recorder, 0, "a");
+    log(recorder, 1, "b");
+    log(recorder, 2, "c");
+
+    EXPECT_TRUE(output.empty());
+
+    log(recorder, 3, "d");
+
+    EXPECT_EQ((std::vector<std::string>{"a", "b", "c", "d"}), output);
+
+    // The ring is empty after dumping.
+    log(recorder, 4, "e");
+
+    EXPECT_EQ((std::vector<std::string>{"a", "b", "c", "d", "e"}), output);
+}
+
+TEST(recorder_t, KeepsMostRecentRecords) {
+    std::vector<std::string> output;
+    recorder_t recorder(capture(output), 3, 3, 2);
+
+    log(recorder, 0, "a");
+    log(recorder, 0, "b");
+    log(recorder, 0, "c");
+    log(recorder, 3, "d");
+
+    EXPECT_EQ((std::vector<std::string>{"b", "c", "d"}), output);
+}
+
+TEST(recorder_t, PassesRecordsAboveThreshold) {
+    std::vector<std::string> output;
+    recorder_t recorder(capture(output), 1, 3);
+
+    log(recorder, 0, "a");
+    log(recorder, 1, "b");
+    log(recorder, 2, "c");
+
+    EXPECT_EQ((std::vector<std::string>{"b", "c"}), output);
+
+    log(recorder, 3, "d");
+
+    EXPECT_EQ((std::vector<std::string>{"b", "c", "a", "d"}), output);
+}
+
+TEST(recorder_t, KeepsRecordsNotFittingSlots) {
+    std::unique_ptr<mock::handler_t> handler(new mock::handler_t);
+
+    std::vector<std::string> output;
+    EXPECT_CALL(*handler, handle(_))
+        .Times(2)
+        .WillRepeatedly(Invoke([&](const record_t& record) {
+            output.push_back(record.message().to_string());
+
+            for (const auto& attributes : record.attributes()) {
+                for (const auto& attribute : attributes.get()) {
+                    output.push_back(attribute.first.to_string());
+                }
+            }
+        }));
+
+    recorder_t recorder(std::move(handler), 3, 3, 4, 16);
+
+    const string_view message("message");
+    const attribute_list attributes{{"key", {"value"}}};
+    const attribute_pack pack{attributes};
+    record_t record(0, message, pack);
+    recorder.handle(record);
+
+    log(recorder, 3, "trigger");
+
+    EXPECT_EQ((std::vector<std::string>{"message", "key", "trigger"}), output);
+}
+
+TEST(recorder_t, Dump) {
+    std::vector<std::string> output;
+    recorder_t recorder(capture(output), 3, 3);
+
+    log(recorder, 0, "a");
+    recorder.dump();
+
+    EXPECT_EQ((std::vector<std::string>{"a"}), output);
+
+    recorder.dump();
+
+    EXPECT_EQ((std::vector<std::string>{"a"}), output);
+}
+
+TEST(recorder_t, RingsArePerThread) {
+    std::vector<std::string> output;
+    recorder_t recorder(capture(output), 3, 3);
+
+    log(recorder, 0, "a");
+
+    std::thread([&] {
+        log(recorder, 0, "b");
+        log(recorder, 3, "c");
+    }).join();
+
+    EXPECT_EQ((std::vector<std::string>{"b", "c"}), output);
+
+    std::thread([&] {
+        log(recorder, 0, "d");
+    }).join();
+
+    recorder.dump_all();
+
+    ASSERT_EQ(4, output.size());
+    EXPECT_EQ("a", output[2]);
+    EXPECT_EQ("d", output[3]);
+}
+
+TEST(recorder_t, ReusesRingsOfFinishedThreads) {
+    std::vector<std::string> output;
+    recorder_t recorder(capture(output), 3, 3);
+
+    std::thread([&] {
+        log(recorder, 0, "a");
+    }).join();
+
+    std::thread([&] {
+        log(recorder, 0, "b");
+        log(recorder, 3, "c");
+    }).join();
+
+    EXPECT_EQ((std::vector<std::string>{"b", "c"}), output);
+
+    metrics::snapshot_t snapshot;
+    metrics::collector_t collector(snapshot);
+    recorder.collect(collector);
+
+    EXPECT_EQ("# TYPE blackhole_recorder_records_total counter\n"
+        "blackhole_recorder_records_total 2\n"
+        "# TYPE blackhole_recorder_dumped_total counter\n"
+        "blackhole_recorder_dumped_total 1\n"
+        "# TYPE blackhole_recorder_overwritten_total counter\n"
+        "blackhole_recorder_overwritten_total 1\n"
+        "# TYPE blackhole_recorder_dumps_total counter\n"
+        "blackhole_recorder_dumps_total 1\n", metrics::prometheus(snapshot));
+}
+
+TEST(recorder_t, ThrowsOnZeroCapacity) {
+    std::vector<std::string> output;
+    EXPECT_THROW(recorder_t(capture(output), 3, 3, 0), std::invalid_argument);
+}
+
+TEST(recorder_t, Builder) {
+    std::vector<std::string> output;
+    auto recorder = builder<recorder_t>(capture(output), 3)
+        .threshold(2)
+        .capacity(1)
+        .build();
+
+    log(*recorder, 0, "a");
+    log(*recorder, 1, "b");
+    log(*recorder, 2, "c");
+    log(*recorder, 3, "d");
+
+    EXPECT_EQ((std::vector<std::string>{"c", "b", "d"}), output);
+}
+
+TEST(recorder_t, FactoryType) {
+    EXPECT_EQ(std::string("recorder"), factory<recorder_t>(mock_registry_t()).type());
+}
+
+}  // namespace
+}  // namespace handler
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,68 @@
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <blackhole/detail/mutex.hpp>
+
+namespace blackhole {
+inline namespace v1 {
+namespace detail {
+namespace {
+
+TEST(null_mutex_t, Lock) {
+    null_mutex_t mutex;
+    std::lock_guard<null_mutex_t> lock(mutex);
+}
+
+TEST(null_mutex_t, TryLockFails) {
+    null_mutex_t mutex;
+    std::unique_lock<null_mutex_t> lock(mutex, std::try_to_lock);
+
+    EXPECT_FALSE(lock.owns_lock());
+}
+
+TEST(adaptive_mutex_t, TryLock) {
+    adaptive_mutex_t mutex;
+
+    {
+        std::unique_lock<adaptive_mutex_t> lock(mutex, std::try_to_lock);
+        EXPECT_TRUE(lock.owns_lock());
+
+        std::unique_lock<adaptive_mutex_t> other(mutex, std::try_to_lock);
+        EXPECT_FALSE(other.owns_lock());
+    }
+
+    std::unique_lock<adaptive_mutex_t> lock(mutex, std::try_to_lock);
+    EXPECT_TRUE(lock.owns_lock());
+}
+
+TEST(adaptive_mutex_t, ExcludesUnderContention) {
+    adaptive_mutex_t mutex;
+    std::uint64_t counter = 0;
+
+    // More threads than cores make some of them park while holders are descheduled.
+    const auto count = 4 * std::max(1u, std::thread::hardware_concurrency());
+
+    std::vector<std::thread> threads;
+    for (unsigned int id = 0; id < count; ++id) {
+        threads.emplace_back([&] {
+            for (int i = 0; i < 10000; ++i) {
+                std::lock_guard<adaptive_mutex_t> lock(mutex);
+                ++counter;
+            }
+        });
+    }
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_EQ(10000 * static_cast<std::uint64_t>(count), counter);
+}
+
+}  // namespace
+}  // namespace detail
+}  // namespace v1
+}  // namespace blackhole
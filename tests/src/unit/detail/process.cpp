@@ -0,0 +1,131 @@
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cstdlib>
+#include <string>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include <blackhole/detail/process.hpp>
+
+namespace blackhole {
+inline namespace v1 {
+namespace detail {
+namespace {
+
+auto rename(const char* name) -> void {
+#ifdef __linux__
+    ::pthread_setname_np(::pthread_self(), name);
+#elif __APPLE__
+    ::pthread_setname_np(name);
+#endif
+}
+
+TEST(this_process, Id) {
+    EXPECT_EQ(static_cast<std::uint64_t>(::getpid()), this_process::id());
+}
+
+/// Forks, returning whether both caches are refreshed in the child.
+auto refreshed_after_fork() -> bool {
+    // Only the thread id cache is primed before forking, which must register the fork handler on
+    // its own.
+    const auto lwp = this_thread::lwp();
+
+    const auto pid = ::fork();
+    if (pid == -1) {
+        return false;
+    }
+
+    if (pid == 0) {
+        const bool ok = this_thread::lwp() != lwp &&
+            this_process::id() == static_cast<std::uint64_t>(::getpid());
+        ::_exit(ok ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+
+    int status = 0;
+    return ::waitpid(pid, &status, 0) == pid && WIFEXITED(status) &&
+        WEXITSTATUS(status) == EXIT_SUCCESS;
+}
+
+TEST(this_process, IdRefreshedAfterFork) {
+    // Runs in a re-executed test binary, so that no cache has been used by other tests yet. The
+    // style is restored afterwards to leave other death tests as they are.
+    const std::string style = ::testing::FLAGS_gtest_death_test_style;
+    ::testing::FLAGS_gtest_death_test_style = "threadsafe";
+
+    EXPECT_EXIT(::_exit(refreshed_after_fork() ? EXIT_SUCCESS : EXIT_FAILURE),
+        ::testing::ExitedWithCode(EXIT_SUCCESS), "");
+
+    ::testing::FLAGS_gtest_death_test_style = style;
+}
+
+TEST(this_thread, NativeHandle) {
+    EXPECT_EQ(::pthread_self(), this_thread::native_handle());
+}
+
+#ifdef __linux__
+TEST(this_thread, Hex) {
+    EXPECT_EQ("0x0", this_thread::hex(0).to_string());
+    EXPECT_EQ("0xdeadbeef", this_thread::hex(0xdeadbeef).to_string());
+    EXPECT_EQ("0x7f0123456789", this_thread::hex(0x7f0123456789).to_string());
+    EXPECT_EQ("0x7f0123456789", this_thread::hex(0x7f0123456789).to_string());
+}
+#endif
+
+TEST(this_thread, Lwp) {
+    const auto lwp = this_thread::lwp();
+
+    EXPECT_NE(0, lwp);
+    EXPECT_EQ(lwp, this_thread::lwp());
+}
+
+TEST(this_thread, LwpDiffersBetweenThreads) {
+    std::uint64_t other = 0;
+
+    std::thread thread([&] {
+        other = this_thread::lwp();
+    });
+    thread.join();
+
+    EXPECT_NE(0, other);
+    EXPECT_NE(this_thread::lwp(), other);
+}
+
+TEST(this_thread, NameIsCachedUntilInvalidated) {
+    rename("name#1");
+    this_thread::invalidate_names();
+
+    EXPECT_EQ("name#1", this_thread::name(::pthread_self()).to_string());
+
+    rename("name#2");
+    EXPECT_EQ("name#1", this_thread::name(::pthread_self()).to_string());
+
+    this_thread::invalidate_names();
+    EXPECT_EQ("name#2", this_thread::name(::pthread_self()).to_string());
+
+    rename("");
+    this_thread::invalidate_names();
+}
+
+TEST(this_thread, NameOfOtherThread) {
+    std::thread::native_handle_type self = ::pthread_self();
+    rename("main#1");
+    this_thread::invalidate_names();
+
+    std::string name;
+    std::thread thread([&] {
+        name = this_thread::name(self).to_string();
+    });
+    thread.join();
+
+    EXPECT_EQ("main#1", name);
+
+    rename("");
+    this_thread::invalidate_names();
+}
+
+}  // namespace
+}  // namespace detail
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,131 @@
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include <blackhole/detail/rcu.hpp>
+
+namespace blackhole {
+inline namespace v1 {
+namespace detail {
+namespace rcu {
+namespace {
+
+TEST(rcu, SynchronizeWithoutReaders) {
+    synchronize();
+}
+
+TEST(rcu, ReadLockMarksReader) {
+    EXPECT_EQ(0, reader().epoch.load());
+
+    {
+        read_lock_t lock;
+        EXPECT_NE(0, reader().epoch.load());
+        EXPECT_EQ(1, reader().nesting);
+    }
+
+    EXPECT_EQ(0, reader().epoch.load());
+    EXPECT_EQ(0, reader().nesting);
+}
+
+TEST(rcu, NestedReadLock) {
+    read_lock_t lock1;
+    const auto epoch = reader().epoch.load();
+
+    {
+        read_lock_t lock2;
+        EXPECT_EQ(2, reader().nesting);
+        EXPECT_EQ(epoch, reader().epoch.load());
+    }
+
+    EXPECT_EQ(1, reader().nesting);
+    EXPECT_EQ(epoch, reader().epoch.load());
+}
+
+TEST(rcu, SynchronizeWaitsForReaders) {
+    std::atomic<bool> entered(false);
+    std::atomic<bool> leave(false);
+    std::atomic<bool> left(false);
+
+    std::thread reader([&] {
+        read_lock_t lock;
+        entered = true;
+
+        while (!leave) {
+            std::this_thread::yield();
+        }
+
+        left = true;
+    });
+
+    while (!entered) {
+        std::this_thread::yield();
+    }
+
+    std::thread writer([&] {
+        synchronize();
+        EXPECT_TRUE(left.load());
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    leave = true;
+
+    writer.join();
+    reader.join();
+}
+
+TEST(rcu, RegistersReadersWhileSynchronizing) {
+    std::atomic<bool> entered(false);
+    std::atomic<bool> leave(false);
+    std::atomic<bool> synchronized(false);
+
+    std::thread reader([&] {
+        read_lock_t lock;
+        entered = true;
+
+        while (!leave) {
+            std::this_thread::yield();
+        }
+    });
+
+    while (!entered) {
+        std::this_thread::yield();
+    }
+
+    std::thread writer([&] {
+        synchronize();
+        synchronized = true;
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    // A thread entering its first critical section must not wait for the grace period to end.
+    std::atomic<bool> registered(false);
+    std::thread other([&] {
+        read_lock_t lock;
+        registered = true;
+    });
+
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+    while (!registered && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::yield();
+    }
+
+    EXPECT_TRUE(registered.load());
+    EXPECT_FALSE(synchronized.load());
+
+    leave = true;
+
+    other.join();
+    writer.join();
+    reader.join();
+
+    EXPECT_TRUE(synchronized.load());
+}
+
+}  // namespace
+}  // namespace rcu
+}  // namespace detail
+}  // namespace v1
+}  // namespace blackhole
@@ -1,9 +1,58 @@
 #include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <blackhole/attribute.hpp>
+#include <blackhole/attributes.hpp>
+#include <blackhole/extensions/writer.hpp>
+#include <blackhole/record.hpp>
 
 #include <blackhole/detail/recordbuf.hpp>
 
 #include <gtest/gtest.h>
 
+namespace {
+
+struct version_t {
+    int major;
+    int minor;
+};
+
+struct counter_t {
+    int value;
+
+    static int formatted;
+};
+
+int counter_t::formatted = 0;
+
+}  // namespace
+
+namespace blackhole {
+inline namespace v1 {
+
+template<>
+struct display_traits<version_t> {
+    static auto apply(const version_t& version, writer_t& wr) -> void {
+        wr.write("{}.{}", version.major, version.minor);
+    }
+};
+
+template<>
+struct display_traits<counter_t> {
+    static auto apply(const counter_t& counter, writer_t& wr) -> void {
+        ++counter_t::formatted;
+        wr.write("#{}", counter.value);
+    }
+};
+
+template<>
+struct deferred_display<counter_t> : std::true_type {};
+
+}  // namespace v1
+}  // namespace blackhole
+
 namespace blackhole {
 inline namespace v1 {
 namespace detail {
@@ -88,6 +137,22 @@ TEST(owned, FromRecordThreadId) {
     EXPECT_EQ(::pthread_self(), result->into_view().tid());
 }
 
+TEST(owned, FromRecordLwp) {
+    std::unique_ptr<recordbuf_t> result;
+    std::uint64_t lwp = 0;
+
+    {
+        const string_view message("");
+        const attribute_pack pack;
+        const record_t record(0, message, pack);
+        lwp = record.lwp();
+
+        result.reset(new recordbuf_t(record));
+    }
+
+    EXPECT_EQ(lwp, result->into_view().lwp());
+}
+
 TEST(owned, FromRecordAttributes) {
     std::unique_ptr<recordbuf_t> result;
 
@@ -203,6 +268,221 @@ TEST(recordbuf_t, DefaultMove) {
     destroyer = std::move(recordbuf);
 }
 
+TEST(recordbuf_t, FromRecordFunctionAttributes) {
+    std::unique_ptr<recordbuf_t> result;
+
+    {
+        const version_t version{1, 2};
+        const string_view message("");
+        const attribute_list attributes{{"version", version}, {"key", "value"},
+            {"patch", version_t{3, 4}}};
+        const attribute_pack pack{attributes};
+        const record_t record(0, message, pack);
+
+        result.reset(new recordbuf_t(record));
+    }
+
+    const attribute_list attributes{{"version", "1.2"}, {"key", "value"}, {"patch", "3.4"}};
+    ASSERT_EQ(1, result->into_view().attributes().size());
+    EXPECT_EQ(attributes, result->into_view().attributes().at(0).get());
+}
+
+TEST(recordbuf_t, FlattensManyAttributesPreservingOrder) {
+    std::unique_ptr<recordbuf_t> result;
+
+    std::vector<std::string> keys;
+    for (int id = 0; id < 40; ++id) {
+        keys.push_back("key#" + std::to_string(id));
+    }
+
+    {
+        const string_view message("");
+        attribute_list first;
+        attribute_list second;
+
+        for (int id = 0; id < 40; ++id) {
+            (id < 10 ? first : second).emplace_back(keys[id], std::int64_t(id));
+        }
+
+        const attribute_pack pack{first, second};
+        const record_t record(0, message, pack);
+
+        result.reset(new recordbuf_t(record));
+    }
+
+    std::vector<std::string> actual;
+    std::int64_t expected = 0;
+
+    for (const auto& list : result->into_view().attributes()) {
+        EXPECT_LE(list.get().size(), 16);
+
+        for (const auto& kv : list.get()) {
+            actual.push_back(kv.first.to_string());
+            EXPECT_EQ(attribute::view_t(expected++), kv.second);
+        }
+    }
+
+    EXPECT_EQ(keys, actual);
+}
+
+TEST(recordbuf_t, ReferToImmortalStrings) {
+    const std::string host("localhost");
+    const string_view message("GET");
+    const attribute_list attributes{{"method", "GET"}, {"host", host}};
+    const attribute_pack pack{attributes};
+    const record_t record(42, message, pack);
+
+    const recordbuf_t result(record);
+    const auto view = result.into_view();
+    const auto& captured = view.attributes().at(0).get();
+
+    EXPECT_EQ(message.data(), view.message().data());
+    EXPECT_EQ(attributes[0].first.data(), captured[0].first.data());
+    EXPECT_EQ(attribute::get<string_view>(attributes[0].second).data(),
+        attribute::get<string_view>(captured[0].second).data());
+
+    EXPECT_EQ("localhost", attribute::get<string_view>(captured[1].second).to_string());
+    EXPECT_NE(host.data(), attribute::get<string_view>(captured[1].second).data());
+}
+
+TEST(recordbuf_t, PlacedIntoProvidedMemory) {
+    std::aligned_storage<4096, alignof(std::max_align_t)>::type memory;
+    std::unique_ptr<recordbuf_t> result;
+
+    {
+        // Literals are immortal, so they would be referred to instead of being placed.
+        const std::string pattern("GET");
+        const string_view message(pattern);
+        const attribute_list attributes{{"key#1", "value#1"}};
+        const attribute_pack pack{attributes};
+        const record_t record(42, message, pack);
+
+        result.reset(new recordbuf_t(record, &memory, sizeof(memory)));
+    }
+
+    EXPECT_FALSE(result->allocated());
+
+    const auto begin = reinterpret_cast<const char*>(&memory);
+    const auto data = result->into_view().message().data();
+    EXPECT_TRUE(data >= begin && data < begin + sizeof(memory));
+    EXPECT_EQ(string_view("GET"), result->into_view().message());
+
+    const attribute_list attributes{{"key#1", "value#1"}};
+    EXPECT_EQ(attributes, result->into_view().attributes().at(0).get());
+}
+
+TEST(recordbuf_t, AllocatedWhenProvidedMemoryIsTooSmall) {
+    std::aligned_storage<16, alignof(std::max_align_t)>::type memory;
+
+    const string_view message("GET");
+    const attribute_pack pack;
+    const record_t record(42, message, pack);
+
+    recordbuf_t result(record, &memory, sizeof(memory));
+
+    EXPECT_TRUE(result.allocated());
+    EXPECT_EQ(string_view("GET"), result.into_view().message());
+}
+
+TEST(recordbuf_t, PlacedIntoMemoryOfProvidedSize) {
+    struct provider_t {
+        std::aligned_storage<4096, alignof(std::max_align_t)>::type memory;
+        std::size_t requested;
+
+        static auto allocate(std::size_t size, void* context) -> void* {
+            auto& self = *static_cast<provider_t*>(context);
+            self.requested = size;
+            return &self.memory;
+        }
+    } provider;
+    provider.requested = 0;
+
+    const std::string pattern("GET");
+    const string_view message(pattern);
+    const attribute_pack pack;
+    const record_t record(42, message, pack);
+
+    recordbuf_t result(record, &provider_t::allocate, &provider);
+
+    EXPECT_FALSE(result.allocated());
+    EXPECT_EQ(provider.requested, result.size());
+
+    const auto begin = reinterpret_cast<const char*>(&provider.memory);
+    const auto data = result.into_view().message().data();
+    EXPECT_TRUE(data >= begin && data < begin + provider.requested);
+}
+
+TEST(recordbuf_t, AllocatedWhenProviderFails) {
+    const string_view message("GET");
+    const attribute_pack pack;
+    const record_t record(42, message, pack);
+
+    recordbuf_t result(record, [](std::size_t, void*) -> void* { return nullptr; }, nullptr);
+
+    EXPECT_TRUE(result.allocated());
+    EXPECT_EQ(string_view("GET"), result.into_view().message());
+}
+
+TEST(recordbuf_t, MoveTransfersBlock) {
+    const string_view message("GET");
+    const attribute_list attributes{{"key#1", "value#1"}};
+    const attribute_pack pack{attributes};
+    const record_t record(42, message, pack);
+
+    recordbuf_t own(record);
+    const auto data = own.into_view().message().data();
+
+    recordbuf_t moved(std::move(own));
+    EXPECT_EQ(data, moved.into_view().message().data());
+
+    recordbuf_t assigned;
+    assigned = std::move(moved);
+    EXPECT_EQ(data, assigned.into_view().message().data());
+}
+
+TEST(recordbuf_t, CopiesDeferredFunctionAttributes) {
+    std::unique_ptr<recordbuf_t> result;
+    counter_t::formatted = 0;
+
+    {
+        const counter_t counter{42};
+        const string_view message("");
+        const attribute_list attributes{{"version", version_t{1, 2}}, {"counter", counter},
+            {"key", "value"}, {"other", counter_t{7}}};
+        const attribute_pack pack{attributes};
+        const record_t record(0, message, pack);
+
+        result.reset(new recordbuf_t(record));
+    }
+
+    EXPECT_EQ(0, counter_t::formatted);
+
+    const auto& attributes = result->into_view().attributes().at(0).get();
+    ASSERT_EQ(4, attributes.size());
+    EXPECT_EQ(attribute::view_t("1.2"), attributes[0].second);
+    EXPECT_EQ(attribute::view_t("value"), attributes[2].second);
+
+    writer_t wr;
+    attribute::get<attribute::view_t::function_type>(attributes[1].second)(wr);
+    attribute::get<attribute::view_t::function_type>(attributes[3].second)(wr);
+
+    EXPECT_EQ("#42#7", wr.result().to_string());
+    EXPECT_EQ(2, counter_t::formatted);
+}
+
+TEST(recordbuf_t, FormatsDeferredFunctionAttributesOutsideCapture) {
+    counter_t::formatted = 0;
+
+    const counter_t counter{42};
+    const attribute::view_t value(counter);
+
+    writer_t wr;
+    attribute::get<attribute::view_t::function_type>(value)(wr);
+
+    EXPECT_EQ("#42", wr.result().to_string());
+    EXPECT_EQ(1, counter_t::formatted);
+}
+
 }  // namespace
 }  // namespace detail
 }  // namespace v1
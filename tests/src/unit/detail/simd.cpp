@@ -0,0 +1,161 @@
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <blackhole/attribute.hpp>
+#include <blackhole/attribute/table.hpp>
+#include <blackhole/attributes.hpp>
+#include <blackhole/extensions/writer.hpp>
+#include <blackhole/formatter.hpp>
+#include <blackhole/formatter/logfmt.hpp>
+#include <blackhole/record.hpp>
+#include <blackhole/detail/formatter/json/escape.hpp>
+#include <blackhole/detail/simd.hpp>
+
+namespace blackhole {
+inline namespace v1 {
+namespace detail {
+namespace simd {
+namespace {
+
+const isa_t isas[] = {isa_t::scalar, isa_t::sse2, isa_t::avx2, isa_t::avx512, isa_t::neon};
+
+/// Restores the instruction set selected before the test.
+class selection_t {
+    isa_t previous;
+
+public:
+    selection_t() :
+        previous(selected())
+    {}
+
+    ~selection_t() {
+        select(previous);
+    }
+};
+
+/// Strings with a special character at every position of several SIMD chunks.
+auto samples(char special) -> std::vector<std::string> {
+    std::vector<std::string> result;
+
+    for (std::size_t size : {0, 1, 15, 16, 17, 63, 64, 65, 150}) {
+        result.emplace_back(size, 'a');
+
+        for (std::size_t pos = 0; pos < size; ++pos) {
+            std::string value(size, 'a');
+            value[pos] = special;
+            result.push_back(value);
+        }
+    }
+
+    return result;
+}
+
+auto escaped(const std::string& value) -> std::string {
+    writer_t writer;
+    formatter::json::escape(string_view(value), writer);
+    return writer.result().to_string();
+}
+
+auto logfmt(const std::string& value) -> std::string {
+    const attribute_list attributes{{"key", {value}}};
+    const attribute_pack pack{attributes};
+    const string_view message(value);
+    record_t record(0, message, pack);
+
+    writer_t writer;
+    builder<blackhole::formatter::logfmt_t>().build()->format(record, writer);
+
+    const auto result = writer.result().to_string();
+    return result.substr(result.find(" message="));
+}
+
+TEST(simd, ScalarIsAlwaysSupported) {
+    EXPECT_TRUE(supported(isa_t::scalar));
+    EXPECT_TRUE(supported(selected()));
+    EXPECT_STREQ("avx2", name(isa_t::avx2));
+}
+
+TEST(simd, RejectsUnsupported) {
+    selection_t selection;
+
+    for (auto isa : isas) {
+        if (!supported(isa)) {
+            EXPECT_FALSE(select(isa));
+        }
+    }
+
+#if defined(BLACKHOLE_SIMD_X86)
+    EXPECT_FALSE(supported(isa_t::neon));
+#endif
+}
+
+TEST(simd, EscapesTheSameOnEveryIsa) {
+    selection_t selection;
+
+    ASSERT_TRUE(select(isa_t::scalar));
+
+    std::vector<std::string> values;
+    for (char special : {'"', '\\', '\n', '\x7f', '\x80', '='}) {
+        for (auto& value : samples(special)) {
+            values.push_back(std::move(value));
+        }
+    }
+
+    std::vector<std::string> expected;
+    std::vector<std::string> expected_logfmt;
+    for (const auto& value : values) {
+        expected.push_back(escaped(value));
+        expected_logfmt.push_back(logfmt(value));
+    }
+
+    for (auto isa : isas) {
+        if (!select(isa)) {
+            continue;
+        }
+
+        for (std::size_t id = 0; id < values.size(); ++id) {
+            EXPECT_EQ(expected[id], escaped(values[id])) << name(isa);
+            EXPECT_EQ(expected_logfmt[id], logfmt(values[id])) << name(isa);
+        }
+    }
+}
+
+TEST(simd, FindsAttributesOnEveryIsa) {
+    selection_t selection;
+
+    std::vector<std::string> names;
+    for (int id = 0; id < 40; ++id) {
+        names.push_back("key#" + std::to_string(id));
+    }
+
+    view_of<attributes_t>::type attributes;
+    for (int id = 0; id < 40; ++id) {
+        attributes.emplace_back(names[id], attribute::view_t(id));
+    }
+
+    const attribute_pack pack{attributes};
+    const unique_attributes_t unique(pack);
+
+    for (auto isa : isas) {
+        if (!select(isa)) {
+            continue;
+        }
+
+        const attribute::table_t table(unique);
+
+        for (int id = 0; id < 40; ++id) {
+            ASSERT_NE(nullptr, table.find(names[id])) << name(isa);
+            EXPECT_EQ(attribute::view_t(id), *table.find(names[id])) << name(isa);
+        }
+
+        EXPECT_EQ(nullptr, table.find("key#40")) << name(isa);
+    }
+}
+
+}  // namespace
+}  // namespace simd
+}  // namespace detail
+}  // namespace v1
+}  // namespace blackhole
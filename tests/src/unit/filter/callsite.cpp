@@ -0,0 +1,144 @@
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <blackhole/attribute.hpp>
+#include <blackhole/attributes.hpp>
+#include <blackhole/filter/callsite.hpp>
+#include <blackhole/record.hpp>
+
+#include <src/filter/callsite.hpp>
+
+#include "mocks/node.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace filter {
+namespace {
+
+using ::testing::Return;
+using ::testing::StrictMock;
+
+auto enabled(callsite_t& filter, const string_view& pattern) -> bool {
+    const attribute_pack pack;
+    const record_t record(0, pattern, pack);
+
+    return filter.enabled(record);
+}
+
+TEST(callsite_t, Default) {
+    callsite_t f1;
+    callsite_t f2(false);
+
+    const string_view pattern("cache miss for {}");
+
+    EXPECT_TRUE(enabled(f1, pattern));
+    EXPECT_FALSE(enabled(f2, pattern));
+}
+
+TEST(callsite_t, Rules) {
+    callsite_t filter(false);
+    filter.set("cache", true);
+    filter.set("cache hit", false);
+
+    const string_view miss("cache miss for {}");
+    const string_view hit("cache hit for {}");
+    const string_view other("connection refused");
+
+    EXPECT_TRUE(enabled(filter, miss));
+    EXPECT_FALSE(enabled(filter, hit));
+    EXPECT_FALSE(enabled(filter, other));
+}
+
+TEST(callsite_t, CachedDecisionIsInvalidatedOnRulesChange) {
+    callsite_t filter;
+
+    const string_view pattern("cache miss for {}");
+
+    EXPECT_TRUE(enabled(filter, pattern));
+    EXPECT_TRUE(enabled(filter, pattern));
+
+    filter.set("miss", false);
+    EXPECT_FALSE(enabled(filter, pattern));
+    EXPECT_FALSE(enabled(filter, pattern));
+
+    filter.clear();
+    EXPECT_TRUE(enabled(filter, pattern));
+}
+
+TEST(callsite_t, DistinguishesPatternsByAddress) {
+    callsite_t filter;
+    filter.set("{}", false);
+
+    // Both views share the address, but their content differs, which is caught by the size tag.
+    const char* data = "disabled {} or not";
+    const string_view p1(data, 11);
+    const string_view p2(data, 8);
+
+    EXPECT_FALSE(enabled(filter, p1));
+    EXPECT_TRUE(enabled(filter, p2));
+    EXPECT_FALSE(enabled(filter, p1));
+}
+
+TEST(callsite_t, Filter) {
+    callsite_t filter;
+    filter.set("debug", false);
+
+    const string_view p1("debug: {}");
+    const string_view p2("info: {}");
+    const attribute_pack pack;
+
+    EXPECT_EQ(filter_t::action_t::deny, filter.filter(record_t(0, p1, pack)));
+    EXPECT_EQ(filter_t::action_t::neutral, filter.filter(record_t(0, p2, pack)));
+}
+
+TEST(callsite_t, ConcurrentLookups) {
+    callsite_t filter;
+    filter.set("odd", false);
+
+    const string_view p1("odd {}");
+    const string_view p2("even {}");
+
+    std::vector<std::thread> threads;
+    for (int id = 0; id < 4; ++id) {
+        threads.emplace_back([&] {
+            for (int i = 0; i < 10000; ++i) {
+                EXPECT_FALSE(enabled(filter, p1));
+                EXPECT_TRUE(enabled(filter, p2));
+            }
+        });
+    }
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+TEST(callsite_t, FactoryType) {
+    EXPECT_EQ(std::string("callsite"), factory<callsite_t>().type());
+}
+
+TEST(callsite_t, FactoryWithoutRules) {
+    StrictMock<config::testing::mock::node_t> config;
+
+    EXPECT_CALL(config, subscript_key("default"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+    EXPECT_CALL(config, subscript_key("rules"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
+    auto filter = factory<callsite_t>().from(config);
+
+    const string_view pattern("-");
+    const attribute_pack pack;
+    EXPECT_EQ(filter_t::action_t::neutral, filter->filter(record_t(0, pattern, pack)));
+}
+
+}  // namespace
+}  // namespace filter
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,217 @@
+#include <string>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <blackhole/attribute.hpp>
+#include <blackhole/attributes.hpp>
+#include <blackhole/filter/expression.hpp>
+#include <blackhole/record.hpp>
+
+#include <src/filter/expression.hpp>
+
+#include "mocks/node.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace filter {
+namespace {
+
+using ::testing::Return;
+using ::testing::StrictMock;
+
+auto evaluate(const std::string& expression, int severity, const attribute_list& attributes) ->
+    bool
+{
+    const string_view message("GET /porn.png HTTP/1.1");
+    const attribute_pack pack{attributes};
+    const record_t record(severity, message, pack);
+
+    return expression_t(expression).evaluate(record);
+}
+
+TEST(expression_t, Severity) {
+    EXPECT_TRUE(evaluate("severity >= 3", 3, {}));
+    EXPECT_TRUE(evaluate("severity >= 3", 4, {}));
+    EXPECT_FALSE(evaluate("severity >= 3", 2, {}));
+    EXPECT_TRUE(evaluate("severity == -1", -1, {}));
+}
+
+TEST(expression_t, Message) {
+    EXPECT_TRUE(evaluate(R"(message == "GET /porn.png HTTP/1.1")", 0, {}));
+    EXPECT_FALSE(evaluate(R"(message != "GET /porn.png HTTP/1.1")", 0, {}));
+}
+
+TEST(expression_t, Attributes) {
+    const attribute_list attributes{{"component", "db"}, {"latency_ms", 150}};
+
+    EXPECT_TRUE(evaluate(R"(component == "db")", 0, attributes));
+    EXPECT_TRUE(evaluate("latency_ms > 100", 0, attributes));
+    EXPECT_FALSE(evaluate("latency_ms < 100", 0, attributes));
+    EXPECT_TRUE(evaluate(R"(severity >= 3 || (component == "db" && latency_ms > 100))", 0,
+        attributes));
+    EXPECT_FALSE(evaluate(R"(severity >= 3 || (component == "db" && latency_ms > 200))", 0,
+        attributes));
+}
+
+TEST(expression_t, QuotedAttributeName) {
+    EXPECT_TRUE(evaluate(R"(`user-agent` == "curl")", 0, {{"user-agent", "curl"}}));
+}
+
+TEST(expression_t, StringEscapes) {
+    EXPECT_TRUE(evaluate(R"(path == "C:\\\"dir\"")", 0, {{"path", "C:\\\"dir\""}}));
+}
+
+TEST(expression_t, Exists) {
+    EXPECT_TRUE(evaluate("trace", 0, {{"trace", 1}}));
+    EXPECT_FALSE(evaluate("trace", 0, {{"span", 1}}));
+    EXPECT_TRUE(evaluate("!trace", 0, {{"span", 1}}));
+}
+
+TEST(expression_t, MissingAttributeComparisonIsFalse) {
+    EXPECT_FALSE(evaluate("latency_ms > 100", 0, {}));
+    EXPECT_FALSE(evaluate("latency_ms <= 100", 0, {}));
+    EXPECT_FALSE(evaluate("latency_ms != 100", 0, {}));
+}
+
+TEST(expression_t, IncompatibleTypesComparisonIsFalse) {
+    EXPECT_FALSE(evaluate(R"(latency_ms == "100")", 0, {{"latency_ms", 100}}));
+    EXPECT_FALSE(evaluate(R"(latency_ms != "100")", 0, {{"latency_ms", 100}}));
+    EXPECT_FALSE(evaluate("enabled == 1", 0, {{"enabled", true}}));
+}
+
+TEST(expression_t, MixedNumericComparison) {
+    EXPECT_TRUE(evaluate("value > -1", 0, {{"value", 0u}}));
+    EXPECT_TRUE(evaluate("value < 0", 0, {{"value", -1}}));
+    EXPECT_TRUE(evaluate("value == 42", 0, {{"value", 42.0}}));
+    EXPECT_TRUE(evaluate("value < 42.5", 0, {{"value", 42}}));
+    EXPECT_TRUE(evaluate("value == 18446744073709551615", 0,
+        {{"value", std::numeric_limits<std::uint64_t>::max()}}));
+    EXPECT_FALSE(evaluate("value == -1", 0,
+        {{"value", std::numeric_limits<std::uint64_t>::max()}}));
+}
+
+TEST(expression_t, Booleans) {
+    EXPECT_TRUE(evaluate("enabled == true", 0, {{"enabled", true}}));
+    EXPECT_TRUE(evaluate("enabled != false", 0, {{"enabled", true}}));
+    EXPECT_TRUE(evaluate("true", 0, {}));
+    EXPECT_FALSE(evaluate("false", 0, {}));
+}
+
+TEST(expression_t, Negation) {
+    EXPECT_TRUE(evaluate("!(severity > 2)", 1, {}));
+    EXPECT_FALSE(evaluate("!!(severity > 2)", 1, {}));
+}
+
+TEST(expression_t, Precedence) {
+    // Conjunction binds tighter than disjunction.
+    EXPECT_TRUE(evaluate("severity == 1 || severity == 2 && false", 1, {}));
+    EXPECT_FALSE(evaluate("(severity == 1 || severity == 2) && false", 1, {}));
+}
+
+TEST(expression_t, CompilesShortCircuitJumps) {
+    typedef expression_t::opcode_t opcode_t;
+
+    expression_t filter("severity >= 3 || a && b");
+    const auto& program = filter.instructions();
+
+    ASSERT_EQ(5, program.size());
+    EXPECT_EQ(opcode_t::compare, program[0].opcode);
+    EXPECT_EQ(opcode_t::jump_true, program[1].opcode);
+    EXPECT_EQ(5, program[1].target);
+    EXPECT_EQ(opcode_t::exists, program[2].opcode);
+    EXPECT_EQ(opcode_t::jump_false, program[3].opcode);
+    EXPECT_EQ(5, program[3].target);
+    EXPECT_EQ(opcode_t::exists, program[4].opcode);
+}
+
+TEST(expression_t, FilterAction) {
+    expression_t filter("severity >= 3");
+
+    const string_view message("");
+    const attribute_pack pack;
+
+    EXPECT_EQ(filter_t::action_t::neutral, filter.filter(record_t(3, message, pack)));
+    EXPECT_EQ(filter_t::action_t::deny, filter.filter(record_t(2, message, pack)));
+}
+
+TEST(expression_t, ThrowsOnMalformedExpression) {
+    EXPECT_THROW(expression_t(""), std::invalid_argument);
+    EXPECT_THROW(expression_t("severity >="), std::invalid_argument);
+    EXPECT_THROW(expression_t("severity"), std::invalid_argument);
+    EXPECT_THROW(expression_t("(severity > 1"), std::invalid_argument);
+    EXPECT_THROW(expression_t("severity > 1)"), std::invalid_argument);
+    EXPECT_THROW(expression_t("a && "), std::invalid_argument);
+    EXPECT_THROW(expression_t(R"(a == "unterminated)"), std::invalid_argument);
+    EXPECT_THROW(expression_t("a == 99999999999999999999"), std::invalid_argument);
+    EXPECT_THROW(expression_t("a = 1"), std::invalid_argument);
+}
+
+TEST(expression_t, ThrowsWithPosition) {
+    try {
+        expression_t("severity > 1)");
+        FAIL();
+    } catch (const std::invalid_argument& err) {
+        EXPECT_STREQ("invalid filter expression at position 12: unexpected character", err.what());
+    }
+}
+
+TEST(expression_t, ThrowsOnSeverityComparedWithBareName) {
+    EXPECT_THROW(expression_t("severity >= warn"), std::invalid_argument);
+    EXPECT_THROW(expression_t("info < severity"), std::invalid_argument);
+
+    try {
+        expression_t("a && severity >= warn");
+        FAIL();
+    } catch (const std::invalid_argument& err) {
+        EXPECT_STREQ("invalid filter expression at position 17: severity can't be compared with a "
+            "bare name, use its number instead", err.what());
+    }
+}
+
+TEST(expression_t, SeverityComparedWithQuotedAttribute) {
+    EXPECT_TRUE(evaluate("severity >= `level`", 3, {{"level", 2}}));
+    EXPECT_FALSE(evaluate("severity >= `level`", 1, {{"level", 2}}));
+}
+
+TEST(expression_t, FactoryType) {
+    EXPECT_EQ(std::string("expression"), factory<expression_t>().type());
+}
+
+TEST(expression_t, FactoryThrowsIfExpressionIsMissing) {
+    StrictMock<config::testing::mock::node_t> config;
+
+    EXPECT_CALL(config, subscript_key("expression"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
+    EXPECT_THROW(factory<expression_t>().from(config), std::invalid_argument);
+}
+
+TEST(expression_t, Factory) {
+    using config::testing::mock::node_t;
+
+    StrictMock<node_t> config;
+
+    auto n1 = new node_t;
+    EXPECT_CALL(config, subscript_key("expression"))
+        .Times(1)
+        .WillOnce(Return(n1));
+
+    EXPECT_CALL(*n1, to_string())
+        .Times(1)
+        .WillOnce(Return("severity >= 3"));
+
+    auto filter = factory<expression_t>().from(config);
+
+    const string_view message("");
+    const attribute_pack pack;
+
+    EXPECT_EQ(filter_t::action_t::neutral, filter->filter(record_t(3, message, pack)));
+    EXPECT_EQ(filter_t::action_t::deny, filter->filter(record_t(2, message, pack)));
+}
+
+}  // namespace
+}  // namespace filter
+}  // namespace v1
+}  // namespace blackhole
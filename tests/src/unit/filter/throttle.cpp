@@ -0,0 +1,274 @@
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <blackhole/attribute.hpp>
+#include <blackhole/attributes.hpp>
+#include <blackhole/filter/dedup.hpp>
+#include <blackhole/filter/limit.hpp>
+#include <blackhole/filter/sample.hpp>
+#include <blackhole/record.hpp>
+
+#include <src/filter/dedup.hpp>
+#include <src/filter/limit.hpp>
+#include <src/filter/sample.hpp>
+
+#include "mocks/node.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace filter {
+namespace {
+
+using ::testing::Return;
+using ::testing::StrictMock;
+
+auto pass(filter_t& filter, const string_view& message, const attribute_list& attributes = {}) ->
+    bool
+{
+    const attribute_pack pack{attributes};
+    const record_t record(0, message, pack);
+
+    return filter.filter(record) == filter_t::action_t::neutral;
+}
+
+auto pass(filter_t& filter,
+          const string_view& pattern,
+          const string_view& formatted,
+          const attribute_list& attributes = {}) -> bool
+{
+    const attribute_pack pack{attributes};
+    record_t record(0, pattern, pack);
+    record.activate(formatted);
+
+    return filter.filter(record) == filter_t::action_t::neutral;
+}
+
+TEST(limit_t, PassesBurst) {
+    limit_t filter(0.001, 3);
+
+    const string_view message("-");
+
+    EXPECT_TRUE(pass(filter, message));
+    EXPECT_TRUE(pass(filter, message));
+    EXPECT_TRUE(pass(filter, message));
+    EXPECT_FALSE(pass(filter, message));
+    EXPECT_FALSE(pass(filter, message));
+
+    EXPECT_EQ(2, filter.suppressed());
+}
+
+TEST(limit_t, Refills) {
+    limit_t filter(1000.0, 1);
+
+    const string_view message("-");
+
+    EXPECT_TRUE(pass(filter, message));
+    EXPECT_FALSE(pass(filter, message));
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+    EXPECT_TRUE(pass(filter, message));
+}
+
+TEST(limit_t, KeysByCallSite) {
+    limit_t filter(0.001, 1);
+
+    const string_view m1("GET /porn.png HTTP/1.1");
+    const string_view m2("POST /upload HTTP/1.1");
+
+    EXPECT_TRUE(pass(filter, m1));
+    EXPECT_TRUE(pass(filter, m2));
+    EXPECT_FALSE(pass(filter, m1));
+    EXPECT_FALSE(pass(filter, m2));
+}
+
+TEST(limit_t, KeysByAttribute) {
+    limit_t filter(0.001, 1, "user");
+
+    const string_view message("-");
+
+    EXPECT_TRUE(pass(filter, message, {{"user", 1}}));
+    EXPECT_TRUE(pass(filter, message, {{"user", 2}}));
+    EXPECT_FALSE(pass(filter, message, {{"user", 1}}));
+    EXPECT_TRUE(pass(filter, message, {{"user", "esafronov"}}));
+    EXPECT_FALSE(pass(filter, message, {{"user", "esafronov"}}));
+}
+
+TEST(limit_t, ThrowsOnInvalidArguments) {
+    EXPECT_THROW(limit_t(0.0, 1), std::invalid_argument);
+    EXPECT_THROW(limit_t(-1.0, 1), std::invalid_argument);
+    EXPECT_THROW(limit_t(1.0, 0), std::invalid_argument);
+}
+
+TEST(limit_t, FactoryType) {
+    EXPECT_EQ(std::string("limit"), factory<limit_t>().type());
+}
+
+TEST(limit_t, FactoryThrowsIfRateIsMissing) {
+    StrictMock<config::testing::mock::node_t> config;
+
+    EXPECT_CALL(config, subscript_key("rate"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
+    EXPECT_THROW(factory<limit_t>().from(config), std::invalid_argument);
+}
+
+TEST(sample_t, PassesEveryNth) {
+    sample_t filter(3);
+
+    const string_view message("-");
+
+    std::vector<bool> result;
+    for (int id = 0; id < 7; ++id) {
+        result.push_back(pass(filter, message));
+    }
+
+    EXPECT_EQ((std::vector<bool>{true, false, false, true, false, false, true}), result);
+    EXPECT_EQ(4, filter.suppressed());
+}
+
+TEST(sample_t, PassesWithProbability) {
+    sample_t filter(1, 0.5);
+
+    const string_view message("-");
+
+    int passed = 0;
+    for (int id = 0; id < 10000; ++id) {
+        passed += pass(filter, message) ? 1 : 0;
+    }
+
+    EXPECT_GT(passed, 4000);
+    EXPECT_LT(passed, 6000);
+}
+
+TEST(sample_t, ThrowsOnInvalidArguments) {
+    EXPECT_THROW(sample_t(0), std::invalid_argument);
+    EXPECT_THROW(sample_t(1, 0.0), std::invalid_argument);
+    EXPECT_THROW(sample_t(1, 1.5), std::invalid_argument);
+}
+
+TEST(sample_t, FactoryType) {
+    EXPECT_EQ(std::string("sample"), factory<sample_t>().type());
+}
+
+TEST(sample_t, FactoryThrowsIfNeitherPeriodNorProbabilityIsSpecified) {
+    StrictMock<config::testing::mock::node_t> config;
+
+    EXPECT_CALL(config, subscript_key("every"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+    EXPECT_CALL(config, subscript_key("probability"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
+    EXPECT_THROW(factory<sample_t>().from(config), std::invalid_argument);
+}
+
+TEST(throttle_t, ReportsSuppressed) {
+    sample_t filter(3, 1.0, "", std::chrono::nanoseconds(0));
+
+    std::vector<std::uint64_t> reports;
+    filter.report([&](const record_t& record, std::uint64_t suppressed) {
+        EXPECT_EQ("-", record.message().to_string());
+        reports.push_back(suppressed);
+    });
+
+    const string_view message("-");
+    for (int id = 0; id < 7; ++id) {
+        pass(filter, message);
+    }
+
+    EXPECT_EQ((std::vector<std::uint64_t>{2, 2}), reports);
+}
+
+TEST(throttle_t, ReportsAtMostOncePerInterval) {
+    sample_t filter(3, 1.0, "", std::chrono::hours(1));
+
+    std::vector<std::uint64_t> reports;
+    filter.report([&](const record_t&, std::uint64_t suppressed) {
+        reports.push_back(suppressed);
+    });
+
+    const string_view message("-");
+    for (int id = 0; id < 7; ++id) {
+        pass(filter, message);
+    }
+
+    EXPECT_EQ((std::vector<std::uint64_t>{2}), reports);
+    EXPECT_EQ(4, filter.suppressed());
+}
+
+TEST(dedup_t, CollapsesRepeats) {
+    dedup_t filter(std::chrono::hours(1));
+
+    const string_view m1("connection refused");
+    const string_view m2("connected");
+
+    EXPECT_TRUE(pass(filter, m1, m1));
+    EXPECT_FALSE(pass(filter, m1, m1));
+    EXPECT_FALSE(pass(filter, m1, m1));
+    EXPECT_TRUE(pass(filter, m2, m2));
+
+    EXPECT_EQ(2, filter.suppressed());
+}
+
+TEST(dedup_t, KeysByFormattedMessage) {
+    dedup_t filter(std::chrono::hours(1));
+
+    const string_view pattern("{}");
+
+    EXPECT_TRUE(pass(filter, pattern, string_view("1")));
+    EXPECT_TRUE(pass(filter, pattern, string_view("2")));
+    EXPECT_FALSE(pass(filter, pattern, string_view("1")));
+}
+
+TEST(dedup_t, KeysByAttributes) {
+    dedup_t filter(std::chrono::hours(1), {"user"});
+
+    const string_view message("-");
+
+    EXPECT_TRUE(pass(filter, message, message, {{"user", 1}}));
+    EXPECT_TRUE(pass(filter, message, message, {{"user", 2}}));
+    EXPECT_FALSE(pass(filter, message, message, {{"user", 1}, {"other", 42}}));
+}
+
+TEST(dedup_t, ReportsRepeatsWhenWindowCloses) {
+    dedup_t filter(std::chrono::milliseconds(1));
+
+    std::vector<std::uint64_t> reports;
+    filter.report([&](const record_t&, std::uint64_t suppressed) {
+        reports.push_back(suppressed);
+    });
+
+    const string_view message("connection refused");
+
+    EXPECT_TRUE(pass(filter, message, message));
+    EXPECT_FALSE(pass(filter, message, message));
+    EXPECT_FALSE(pass(filter, message, message));
+    EXPECT_TRUE(reports.empty());
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+    EXPECT_TRUE(pass(filter, message, message));
+    EXPECT_EQ((std::vector<std::uint64_t>{2}), reports);
+    EXPECT_EQ(std::string("last message repeated {} times"), filter.summary());
+}
+
+TEST(dedup_t, ThrowsOnZeroWindow) {
+    EXPECT_THROW(dedup_t(std::chrono::nanoseconds(0)), std::invalid_argument);
+}
+
+TEST(dedup_t, FactoryType) {
+    EXPECT_EQ(std::string("dedup"), factory<dedup_t>().type());
+}
+
+}  // namespace
+}  // namespace filter
+}  // namespace v1
+}  // namespace blackhole
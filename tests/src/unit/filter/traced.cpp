@@ -0,0 +1,189 @@
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <blackhole/attribute.hpp>
+#include <blackhole/attributes.hpp>
+#include <blackhole/filter/traced.hpp>
+#include <blackhole/record.hpp>
+#include <blackhole/scope/span.hpp>
+#include <blackhole/trace.hpp>
+
+#include <src/filter/traced.hpp>
+
+#include "mocks/node.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace filter {
+namespace {
+
+using ::testing::Return;
+using ::testing::StrictMock;
+
+auto pass(filter_t& filter, std::uint64_t lo, std::int64_t severity = 0) -> bool {
+    const trace_t trace{0x4bf92f3577b34da6ull, lo, 1};
+    scope::span_t span(trace);
+
+    const string_view message("-");
+    const attribute_pack pack;
+    const record_t record(severity, message, pack);
+
+    return filter.filter(record) == filter_t::action_t::neutral;
+}
+
+auto pass(filter_t& filter, const attribute_list& attributes) -> bool {
+    const string_view message("-");
+    const attribute_pack pack{attributes};
+    const record_t record(0, message, pack);
+
+    return filter.filter(record) == filter_t::action_t::neutral;
+}
+
+/// Spreads trace ids over the randomness bits like random ones.
+auto id(std::uint64_t value) -> std::uint64_t {
+    return value * 0x9e3779b97f4a7c15ull;
+}
+
+TEST(traced_t, KeepsRateOfTraces) {
+    traced_t filter(0.25);
+
+    std::size_t kept = 0;
+    for (std::uint64_t value = 0; value < 10000; ++value) {
+        if (pass(filter, id(value))) {
+            ++kept;
+        }
+    }
+
+    EXPECT_LT(2250, kept);
+    EXPECT_GT(2750, kept);
+}
+
+TEST(traced_t, DecidesConsistently) {
+    traced_t f1(0.5);
+    traced_t f2(0.5);
+    traced_t lower(0.1);
+
+    for (std::uint64_t value = 0; value < 1000; ++value) {
+        const auto kept = pass(f1, id(value));
+
+        // Other services using the same rate keep the same traces, lower rates keep a subset.
+        EXPECT_EQ(kept, pass(f1, id(value)));
+        EXPECT_EQ(kept, pass(f2, id(value)));
+
+        if (pass(lower, id(value))) {
+            EXPECT_TRUE(kept);
+        }
+    }
+}
+
+TEST(traced_t, UsesLowest56BitsOfTraceId) {
+    traced_t filter(0.5);
+
+    // The highest byte carries no randomness.
+    EXPECT_FALSE(pass(filter, 0xff00000000000000ull));
+    EXPECT_TRUE(pass(filter, 0x00ffffffffffffffull));
+    EXPECT_TRUE(pass(filter, 0x0080000000000000ull));
+    EXPECT_FALSE(pass(filter, 0x007fffffffffffffull));
+}
+
+TEST(traced_t, MatchesHexTraceIdsOfAttributes) {
+    for (auto rate : {0.1, 0.3, 0.5, 0.7, 0.9}) {
+        traced_t inline_(rate);
+        traced_t attribute(rate, "trace_id");
+
+        for (std::uint64_t value = 0; value < 100; ++value) {
+            char hex[33];
+            std::snprintf(hex, sizeof(hex), "4bf92f3577b34da6%016llx",
+                static_cast<unsigned long long>(id(value)));
+
+            EXPECT_EQ(pass(inline_, id(value)), pass(attribute, {{"trace_id", hex}}));
+        }
+    }
+}
+
+TEST(traced_t, HashesOtherAttributeValues) {
+    traced_t filter(0.5, "request");
+
+    std::size_t kept = 0;
+    for (std::uint64_t value = 0; value < 1000; ++value) {
+        const auto strings = pass(filter, {{"request", "request-" + std::to_string(value)}});
+        EXPECT_EQ(strings, pass(filter, {{"request", "request-" + std::to_string(value)}}));
+
+        if (pass(filter, {{"request", value}})) {
+            ++kept;
+        }
+    }
+
+    // Sequential integers are mixed first.
+    EXPECT_LT(400, kept);
+    EXPECT_GT(600, kept);
+}
+
+TEST(traced_t, KeepsUntracedRecordsIfRequested) {
+    traced_t kept(0.0);
+    traced_t dropped(0.0, {}, false);
+    traced_t attribute(0.0, "trace_id", false);
+
+    EXPECT_TRUE(pass(kept, attribute_list()));
+    EXPECT_FALSE(pass(dropped, attribute_list()));
+    EXPECT_FALSE(pass(attribute, attribute_list()));
+    EXPECT_FALSE(pass(attribute, {{"trace_id", "4bf92f3577b34da6a3ce929d0e0e4736"}}));
+}
+
+TEST(traced_t, SeverityOverrides) {
+    traced_t filter(0.0, {}, false, {{3, 1.0}, {2, 0.5}});
+
+    EXPECT_FALSE(pass(filter, 0x00ffffffffffffffull, 1));
+    EXPECT_TRUE(pass(filter, 0x00ffffffffffffffull, 2));
+    EXPECT_FALSE(pass(filter, 0x0000000000000001ull, 2));
+
+    // Errors are kept regardless of their trace, even untraced ones.
+    EXPECT_TRUE(pass(filter, 0x0000000000000001ull, 3));
+    EXPECT_TRUE(pass(filter, 0, 4));
+}
+
+TEST(traced_t, ChangesRateAtRuntime) {
+    traced_t filter(1.0);
+    EXPECT_DOUBLE_EQ(1.0, filter.rate());
+    EXPECT_TRUE(pass(filter, 1));
+
+    filter.rate(0.5);
+    EXPECT_DOUBLE_EQ(0.5, filter.rate());
+    EXPECT_FALSE(pass(filter, 1));
+    EXPECT_TRUE(pass(filter, 0x00ffffffffffffffull));
+
+    filter.rate(0.0);
+    EXPECT_FALSE(pass(filter, 0x00ffffffffffffffull));
+
+    EXPECT_THROW(filter.rate(1.5), std::invalid_argument);
+    EXPECT_DOUBLE_EQ(0.0, filter.rate());
+}
+
+TEST(traced_t, ThrowsOnInvalidRates) {
+    EXPECT_THROW(traced_t(-0.1), std::invalid_argument);
+    EXPECT_THROW(traced_t(1.1), std::invalid_argument);
+    EXPECT_THROW(traced_t(0.5, {}, true, {{3, 2.0}}), std::invalid_argument);
+}
+
+TEST(traced_t, FactoryType) {
+    EXPECT_EQ(std::string("traced"), factory<traced_t>().type());
+}
+
+TEST(traced_t, FactoryThrowsIfRateIsNotSpecified) {
+    StrictMock<config::testing::mock::node_t> config;
+
+    EXPECT_CALL(config, subscript_key("rate"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
+    EXPECT_THROW(factory<traced_t>().from(config), std::invalid_argument);
+}
+
+}  // namespace
+}  // namespace filter
+}  // namespace v1
+}  // namespace blackhole
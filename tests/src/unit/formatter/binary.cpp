@@ -0,0 +1,118 @@
+#include <cstring>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include <blackhole/attribute.hpp>
+#include <blackhole/attributes.hpp>
+#include <blackhole/extensions/writer.hpp>
+#include <blackhole/formatter.hpp>
+#include <blackhole/formatter/binary.hpp>
+#include <blackhole/record.hpp>
+#include <blackhole/scope/span.hpp>
+#include <blackhole/detail/formatter/binary/frame.hpp>
+
+namespace blackhole {
+inline namespace v1 {
+namespace formatter {
+namespace {
+
+namespace frame = detail::formatter::binary;
+
+auto format(formatter_t& formatter, const attribute_pack& pack) -> std::string {
+    const string_view message("value {}");
+    record_t record(3, message, pack);
+    record.activate(string_view("value 42"));
+
+    writer_t writer;
+    formatter.format(record, writer);
+
+    return writer.result().to_string();
+}
+
+TEST(binary_t, WritesFrames) {
+    auto formatter = builder<binary_t>().build();
+
+    const attribute_list attributes{{"key", {"le value"}}, {"counter", {42}}};
+    const attribute_pack pack{attributes};
+    const auto result = format(*formatter, pack);
+
+    sink::ring_t::slot_t slot;
+    ASSERT_TRUE(frame::parse(result.data(), result.size(), 0, slot));
+    EXPECT_EQ(result.size(), sizeof(frame::frame_t) + slot.size);
+    EXPECT_EQ(result.size(), frame::next(result.data(), result.size(), slot));
+
+    sink::ring::decoded_t decoded;
+    decoded.decode(slot);
+
+    const auto& record = decoded.record();
+    EXPECT_EQ(3, record.severity());
+    EXPECT_EQ("value {}", record.message().to_string());
+    EXPECT_EQ("value 42", record.formatted().to_string());
+    EXPECT_EQ(0, decoded.output().size());
+
+    ASSERT_EQ(1, record.attributes().size());
+    const auto& decoded_attributes = record.attributes()[0].get();
+    ASSERT_EQ(2, decoded_attributes.size());
+    EXPECT_EQ("key", decoded_attributes[0].first.to_string());
+    EXPECT_EQ(attribute::view_t("le value"), decoded_attributes[0].second);
+    EXPECT_EQ(attribute::view_t(42), decoded_attributes[1].second);
+}
+
+TEST(binary_t, KeepsTraceContext) {
+    auto formatter = builder<binary_t>().build();
+
+    const trace_t trace{1, 2, 3};
+    scope::span_t span(trace);
+
+    const attribute_pack pack;
+    const auto result = format(*formatter, pack);
+
+    sink::ring_t::slot_t slot;
+    ASSERT_TRUE(frame::parse(result.data(), result.size(), 0, slot));
+
+    sink::ring::decoded_t decoded;
+    decoded.decode(slot);
+
+    EXPECT_EQ(1, decoded.record().trace().hi);
+    EXPECT_EQ(2, decoded.record().trace().lo);
+    EXPECT_EQ(3, decoded.record().trace().span);
+}
+
+TEST(binary_t, RejectsCorruptedFrames) {
+    auto formatter = builder<binary_t>().build();
+
+    const attribute_pack pack;
+    auto result = format(*formatter, pack);
+
+    sink::ring_t::slot_t slot;
+    EXPECT_FALSE(frame::parse(result.data(), result.size() - 1, 0, slot));
+    EXPECT_FALSE(frame::parse(result.data(), result.size(), 1, slot));
+
+    result[result.size() - 1] ^= 0x1;
+    EXPECT_FALSE(frame::parse(result.data(), result.size(), 0, slot));
+}
+
+TEST(binary_t, SkipsTrailingNewline) {
+    auto formatter = builder<binary_t>().build();
+
+    const attribute_pack pack;
+    const auto line = format(*formatter, pack) + "\n";
+    const auto data = line + line;
+
+    sink::ring_t::slot_t slot;
+    ASSERT_TRUE(frame::parse(data.data(), data.size(), 0, slot));
+
+    const auto next = frame::next(data.data(), data.size(), slot);
+    EXPECT_EQ(line.size(), next);
+    EXPECT_TRUE(frame::parse(data.data(), data.size(), next, slot));
+}
+
+TEST(binary_t, FactoryType) {
+    EXPECT_EQ(std::string("binary"), factory<binary_t>().type());
+}
+
+}  // namespace
+}  // namespace formatter
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,168 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <blackhole/attribute.hpp>
+#include <blackhole/attributes.hpp>
+#include <blackhole/extensions/writer.hpp>
+#include <blackhole/formatter.hpp>
+#include <blackhole/formatter/cbor.hpp>
+#include <blackhole/record.hpp>
+
+#include "mocks/node.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace formatter {
+namespace {
+
+using ::testing::Return;
+using ::testing::StartsWith;
+using ::testing::StrictMock;
+
+/// Makes a string from the given literal including embedded null characters.
+template<std::size_t N>
+auto bin(const char(&data)[N]) -> std::string {
+    return std::string(data, N - 1);
+}
+
+auto format(formatter_t& formatter, int severity, const attribute_pack& pack) -> std::string {
+    const string_view message("value");
+    record_t record(severity, message, pack);
+    writer_t writer;
+    formatter.format(record, writer);
+
+    return writer.result().to_string();
+}
+
+auto builtins() -> std::vector<std::string> {
+    return {"message", "thread", "process", "severity", "timestamp"};
+}
+
+TEST(cbor_t, AttributeTypes) {
+    auto formatter = builder<cbor_t>()
+        .route("/fields", builtins())
+        .build();
+
+    const attribute_list attributes{
+        {"null", {nullptr}},
+        {"bool", {true}},
+        {"sint", {-42}},
+        {"uint", {42u}},
+        {"double", {1.5}},
+        {"string", {"value"}},
+        {"u16", {300u}},
+        {"i16", {-200}},
+        {"u32", {70000u}},
+        {"u64", {5000000000ull}},
+        {"i32", {-70000}}
+    };
+    const attribute_pack pack{attributes};
+
+    EXPECT_THAT(format(*formatter, 0, pack), StartsWith(bin(
+        "\xac"
+        "\x64" "null" "\xf6"
+        "\x64" "bool" "\xf5"
+        "\x64" "sint" "\x38\x29"
+        "\x64" "uint" "\x18\x2a"
+        "\x66" "double" "\xfb\x3f\xf8\x00\x00\x00\x00\x00\x00"
+        "\x66" "string" "\x65" "value"
+        "\x63" "u16" "\x19\x01\x2c"
+        "\x63" "i16" "\x38\xc7"
+        "\x63" "u32" "\x1a\x00\x01\x11\x70"
+        "\x63" "u64" "\x1b\x00\x00\x00\x01\x2a\x05\xf2\x00"
+        "\x63" "i32" "\x3a\x00\x01\x11\x6f"
+        "\x66" "fields" "\xa5" "\x67" "message" "\x65" "value" "\x66" "thread")));
+}
+
+TEST(cbor_t, NestedRoutes) {
+    auto formatter = builder<cbor_t>()
+        .route("/fields", builtins())
+        .route("/a/b", {"key"})
+        .build();
+
+    const attribute_list attributes{{"other", {1}}, {"key", {42}}};
+    const attribute_pack pack{attributes};
+
+    EXPECT_THAT(format(*formatter, 0, pack), StartsWith(bin(
+        "\xa3"
+        "\x65" "other" "\x01"
+        "\x61" "a" "\xa1" "\x61" "b" "\xa1" "\x63" "key" "\x18\x2a"
+        "\x66" "fields" "\xa5" "\x67" "message")));
+}
+
+TEST(cbor_t, RenamesAndMapsSeverity) {
+    auto formatter = builder<cbor_t>()
+        .route("/fields", {"message", "thread", "process", "timestamp"})
+        .rename("severity", "level")
+        .severity({"debug", "info"})
+        .build();
+
+    const attribute_pack pack;
+
+    EXPECT_THAT(format(*formatter, 1, pack), StartsWith(bin(
+        "\xa2" "\x65" "level" "\x64" "info" "\x66" "fields" "\xa4")));
+    EXPECT_THAT(format(*formatter, 2, pack), StartsWith(bin(
+        "\xa2" "\x65" "level" "\x02" "\x66" "fields" "\xa4")));
+}
+
+TEST(cbor_t, Strings) {
+    auto formatter = builder<cbor_t>()
+        .route("/fields", builtins())
+        .build();
+
+    const attribute_list attributes{
+        {"invalid", {"\xff"}},
+        {"long", {"0123456789abcdef0123456789abcdef"}}
+    };
+    const attribute_pack pack{attributes};
+
+    EXPECT_THAT(format(*formatter, 0, pack), StartsWith(bin(
+        "\xa3"
+        "\x67" "invalid" "\x63\xef\xbf\xbd"
+        "\x64" "long" "\x78\x20" "0123456789abcdef0123456789abcdef")));
+}
+
+TEST(cbor_t, ThrowsOnInvalidRoute) {
+    EXPECT_THROW(builder<cbor_t>().route("fields", {"key"}).build(), std::invalid_argument);
+}
+
+TEST(cbor_t, FactoryType) {
+    EXPECT_EQ(std::string("cbor"), factory<cbor_t>().type());
+}
+
+TEST(cbor_t, Factory) {
+    using config::testing::mock::node_t;
+
+    StrictMock<node_t> config;
+
+    auto unique = new node_t;
+    EXPECT_CALL(config, subscript_key("unique"))
+        .Times(1)
+        .WillOnce(Return(unique));
+
+    EXPECT_CALL(*unique, to_bool())
+        .Times(1)
+        .WillOnce(Return(true));
+
+    EXPECT_CALL(config, subscript_key("mapping"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
+    EXPECT_CALL(config, subscript_key("routing"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
+    EXPECT_CALL(config, subscript_key("mutate"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
+    auto formatter = factory<cbor_t>().from(config);
+
+    const attribute_pack pack;
+    EXPECT_THAT(format(*formatter, 0, pack), StartsWith(bin("\xa5" "\x67" "message")));
+}
+
+}  // namespace
+}  // namespace formatter
+}  // namespace v1
+}  // namespace blackhole
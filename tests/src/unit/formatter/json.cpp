@@ -63,6 +63,29 @@ TEST(json_t, FormatMessage) {
     EXPECT_STREQ("value", doc["message"].GetString());
 }
 
+TEST(json_t, FormatLongMessage) {
+    auto formatter = builder<json_t>()
+        .build();
+
+    std::string value;
+    for (int id = 0; id < 1000; ++id) {
+        value += "line #" + std::to_string(id) + "\n";
+    }
+
+    const string_view message(value);
+    const attribute_pack pack;
+    record_t record(0, message, pack);
+    writer_t writer;
+    formatter->format(record, writer);
+
+    rapidjson::Document doc;
+    doc.Parse<0>(writer.result().to_string().c_str());
+    ASSERT_FALSE(doc.HasParseError());
+    ASSERT_TRUE(doc.HasMember("message"));
+    ASSERT_TRUE(doc["message"].IsString());
+    EXPECT_EQ(value, doc["message"].GetString());
+}
+
 TEST(json_t, FormatFormattedMessage) {
     auto formatter = builder<json_t>()
         .build();
@@ -553,6 +576,48 @@ TEST(builder_t, Unique) {
     EXPECT_TRUE(cast.unique());
 }
 
+TEST(json_t, StreamingDisabledByDefault) {
+    EXPECT_FALSE(json_t().streaming());
+}
+
+TEST(builder_t, Streaming) {
+    auto layout = builder<json_t>()
+        .streaming()
+        .build();
+
+    const auto& cast = dynamic_cast<const json_t&>(*layout);
+    EXPECT_TRUE(cast.streaming());
+}
+
+TEST(json_t, StreamingFormatsNestedRouting) {
+    auto formatter = builder<json_t>()
+        .route("/fields/external", {"endpoint"})
+        .rename("message", "@message")
+        .streaming()
+        .newline()
+        .build();
+
+    const string_view message("value");
+    const attribute_list attributes{{"endpoint", "127.0.0.1:8080"}, {"id", 42}};
+    const attribute_pack pack{attributes};
+    record_t record(0, message, pack);
+    writer_t writer;
+    formatter->format(record, writer);
+
+    const auto result = writer.result().to_string();
+    ASSERT_EQ('\n', result.back());
+
+    rapidjson::Document doc;
+    doc.Parse<0>(result.c_str());
+    ASSERT_FALSE(doc.HasParseError());
+    ASSERT_TRUE(doc.HasMember("@message"));
+    EXPECT_STREQ("value", doc["@message"].GetString());
+    ASSERT_TRUE(doc.HasMember("id"));
+    EXPECT_EQ(42, doc["id"].GetInt());
+    ASSERT_TRUE(doc["fields"]["external"].HasMember("endpoint"));
+    EXPECT_STREQ("127.0.0.1:8080", doc["fields"]["external"]["endpoint"].GetString());
+}
+
 TEST(json_t, FactoryType) {
     EXPECT_EQ(std::string("json"), factory<json_t>().type());
 }
@@ -0,0 +1,205 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <blackhole/attribute.hpp>
+#include <blackhole/attributes.hpp>
+#include <blackhole/extensions/writer.hpp>
+#include <blackhole/formatter.hpp>
+#include <blackhole/formatter/logfmt.hpp>
+#include <blackhole/record.hpp>
+
+#include "mocks/node.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace formatter {
+namespace {
+
+using ::testing::EndsWith;
+using ::testing::HasSubstr;
+using ::testing::Invoke;
+using ::testing::MatchesRegex;
+using ::testing::Return;
+using ::testing::StrictMock;
+using ::testing::_;
+
+auto format(formatter_t& formatter, int severity, const string_view& message,
+    const attribute_pack& pack) -> std::string
+{
+    record_t record(severity, message, pack);
+    writer_t writer;
+    formatter.format(record, writer);
+
+    return writer.result().to_string();
+}
+
+TEST(logfmt_t, Plain) {
+    auto formatter = builder<logfmt_t>()
+        .build();
+
+    const attribute_list attributes{{"key", {42}}};
+    const attribute_pack pack{attributes};
+
+    EXPECT_THAT(format(*formatter, 2, "value", pack), MatchesRegex(
+        "timestamp=[0-9]{4}-[0-9]{2}-[0-9]{2}T[0-9]{2}:[0-9]{2}:[0-9]{2}\\.[0-9]{6}Z "
+        "severity=2 message=value process=[0-9]+ thread=0x[0-9a-f]+ key=42"));
+}
+
+TEST(logfmt_t, AttributeTypes) {
+    auto formatter = builder<logfmt_t>()
+        .build();
+
+    const attribute_list attributes{
+        {"null", {nullptr}},
+        {"bool", {true}},
+        {"sint", {-42}},
+        {"uint", {42u}},
+        {"double", {3.5}},
+        {"string", {"value"}}
+    };
+    const attribute_pack pack{attributes};
+
+    EXPECT_THAT(format(*formatter, 0, "-", pack),
+        EndsWith(" null=null bool=true sint=-42 uint=42 double=3.5 string=value"));
+}
+
+TEST(logfmt_t, QuotesValues) {
+    auto formatter = builder<logfmt_t>()
+        .build();
+
+    const attribute_list attributes{
+        {"space", {"GET /porn.png"}},
+        {"equal", {"a=b"}},
+        {"quote", {"say \"hi\""}},
+        {"backslash", {"C:\\"}},
+        {"newline", {"line\n"}},
+        {"unicode", {"\xd0\xbf\xd1\x80"}},
+        {"empty", {""}},
+        {"long", {"0123456789abcdef0123456789abcdef"}}
+    };
+    const attribute_pack pack{attributes};
+
+    EXPECT_THAT(format(*formatter, 0, "GET /porn.png HTTP/1.1", pack), EndsWith(
+        " space=\"GET /porn.png\" equal=\"a=b\" quote=\"say \\\"hi\\\"\" backslash=\"C:\\\\\""
+        " newline=\"line\\n\" unicode=\"\xd0\xbf\xd1\x80\" empty="
+        " long=0123456789abcdef0123456789abcdef"));
+    EXPECT_THAT(format(*formatter, 0, "GET /porn.png HTTP/1.1", pack),
+        HasSubstr(" message=\"GET /porn.png HTTP/1.1\" "));
+}
+
+TEST(logfmt_t, ReplacesInvalidKeyCharacters) {
+    auto formatter = builder<logfmt_t>()
+        .rename("message", "my msg")
+        .build();
+
+    const attribute_list attributes{{"a key=\"1\"", {1}}, {"", {2}}};
+    const attribute_pack pack{attributes};
+
+    const auto result = format(*formatter, 0, "-", pack);
+
+    EXPECT_THAT(result, HasSubstr(" my_msg=- "));
+    EXPECT_THAT(result, EndsWith(" a_key__1_=1 _=2"));
+}
+
+TEST(logfmt_t, RenamesAndMapsSeverity) {
+    auto formatter = builder<logfmt_t>()
+        .rename("timestamp", "ts")
+        .rename("severity", "level")
+        .rename("message", "msg")
+        .severity({"debug", "info", "warning level"})
+        .timestamp("%Y")
+        .build();
+
+    const attribute_pack pack;
+
+    EXPECT_THAT(format(*formatter, 1, "-", pack), MatchesRegex("ts=[0-9]{4} level=info msg=- .*"));
+    EXPECT_THAT(format(*formatter, 2, "-", pack), HasSubstr(" level=\"warning level\" "));
+    EXPECT_THAT(format(*formatter, 3, "-", pack), HasSubstr(" level=3 "));
+}
+
+TEST(logfmt_t, ThrowsOnRenamingNonReservedField) {
+    EXPECT_THROW(builder<logfmt_t>().rename("key", "other").build(), std::invalid_argument);
+}
+
+TEST(logfmt_t, Unique) {
+    auto formatter = builder<logfmt_t>()
+        .unique()
+        .build();
+
+    const attribute_list a1{{"key", {1}}};
+    const attribute_list a2{{"key", {2}}};
+    const attribute_pack pack{a1, a2};
+
+    const auto result = format(*formatter, 0, "-", pack);
+
+    EXPECT_THAT(result, EndsWith(" key=1"));
+    EXPECT_EQ(result.find(" key="), result.rfind(" key="));
+}
+
+TEST(logfmt_t, FactoryType) {
+    EXPECT_EQ(std::string("logfmt"), factory<logfmt_t>().type());
+}
+
+TEST(logfmt_t, Factory) {
+    using config::testing::mock::node_t;
+
+    StrictMock<node_t> config;
+
+    auto mapping = new node_t;
+    EXPECT_CALL(config, subscript_key("mapping"))
+        .Times(1)
+        .WillOnce(Return(mapping));
+
+    node_t to;
+    EXPECT_CALL(*mapping, each_map(_))
+        .Times(1)
+        .WillOnce(Invoke([&](const node_t::member_function& fn) {
+            fn("message", to);
+        }));
+
+    EXPECT_CALL(to, to_string())
+        .Times(1)
+        .WillOnce(Return("msg"));
+
+    auto sevmap = new node_t;
+    EXPECT_CALL(config, subscript_key("sevmap"))
+        .Times(1)
+        .WillOnce(Return(sevmap));
+
+    node_t item;
+    EXPECT_CALL(*sevmap, each(_))
+        .Times(1)
+        .WillOnce(Invoke([&](const node_t::each_function& fn) {
+            fn(item);
+            fn(item);
+        }));
+
+    EXPECT_CALL(item, to_string())
+        .Times(2)
+        .WillOnce(Return("debug"))
+        .WillOnce(Return("info"));
+
+    auto timestamp = new node_t;
+    EXPECT_CALL(config, subscript_key("timestamp"))
+        .Times(1)
+        .WillOnce(Return(timestamp));
+
+    EXPECT_CALL(*timestamp, to_string())
+        .Times(1)
+        .WillOnce(Return("%Y"));
+
+    EXPECT_CALL(config, subscript_key("unique"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
+    auto formatter = factory<logfmt_t>().from(config);
+
+    const attribute_pack pack;
+    EXPECT_THAT(format(*formatter, 1, "-", pack), MatchesRegex(
+        "timestamp=[0-9]{4} severity=info msg=- .*"));
+}
+
+}  // namespace
+}  // namespace formatter
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,168 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <blackhole/attribute.hpp>
+#include <blackhole/attributes.hpp>
+#include <blackhole/extensions/writer.hpp>
+#include <blackhole/formatter.hpp>
+#include <blackhole/formatter/msgpack.hpp>
+#include <blackhole/record.hpp>
+
+#include "mocks/node.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace formatter {
+namespace {
+
+using ::testing::Return;
+using ::testing::StartsWith;
+using ::testing::StrictMock;
+
+/// Makes a string from the given literal including embedded null characters.
+template<std::size_t N>
+auto bin(const char(&data)[N]) -> std::string {
+    return std::string(data, N - 1);
+}
+
+auto format(formatter_t& formatter, int severity, const attribute_pack& pack) -> std::string {
+    const string_view message("value");
+    record_t record(severity, message, pack);
+    writer_t writer;
+    formatter.format(record, writer);
+
+    return writer.result().to_string();
+}
+
+auto builtins() -> std::vector<std::string> {
+    return {"message", "thread", "process", "severity", "timestamp"};
+}
+
+TEST(msgpack_t, AttributeTypes) {
+    auto formatter = builder<msgpack_t>()
+        .route("/fields", builtins())
+        .build();
+
+    const attribute_list attributes{
+        {"null", {nullptr}},
+        {"bool", {true}},
+        {"sint", {-42}},
+        {"uint", {42u}},
+        {"double", {1.5}},
+        {"string", {"value"}},
+        {"u16", {300u}},
+        {"i16", {-200}},
+        {"u32", {70000u}},
+        {"u64", {5000000000ull}},
+        {"i32", {-70000}}
+    };
+    const attribute_pack pack{attributes};
+
+    EXPECT_THAT(format(*formatter, 0, pack), StartsWith(bin(
+        "\x8c"
+        "\xa4" "null" "\xc0"
+        "\xa4" "bool" "\xc3"
+        "\xa4" "sint" "\xd0\xd6"
+        "\xa4" "uint" "\x2a"
+        "\xa6" "double" "\xcb\x3f\xf8\x00\x00\x00\x00\x00\x00"
+        "\xa6" "string" "\xa5" "value"
+        "\xa3" "u16" "\xcd\x01\x2c"
+        "\xa3" "i16" "\xd1\xff\x38"
+        "\xa3" "u32" "\xce\x00\x01\x11\x70"
+        "\xa3" "u64" "\xcf\x00\x00\x00\x01\x2a\x05\xf2\x00"
+        "\xa3" "i32" "\xd2\xff\xfe\xee\x90"
+        "\xa6" "fields" "\x85" "\xa7" "message" "\xa5" "value" "\xa6" "thread")));
+}
+
+TEST(msgpack_t, NestedRoutes) {
+    auto formatter = builder<msgpack_t>()
+        .route("/fields", builtins())
+        .route("/a/b", {"key"})
+        .build();
+
+    const attribute_list attributes{{"other", {1}}, {"key", {42}}};
+    const attribute_pack pack{attributes};
+
+    EXPECT_THAT(format(*formatter, 0, pack), StartsWith(bin(
+        "\x83"
+        "\xa5" "other" "\x01"
+        "\xa1" "a" "\x81" "\xa1" "b" "\x81" "\xa3" "key" "\x2a"
+        "\xa6" "fields" "\x85" "\xa7" "message")));
+}
+
+TEST(msgpack_t, RenamesAndMapsSeverity) {
+    auto formatter = builder<msgpack_t>()
+        .route("/fields", {"message", "thread", "process", "timestamp"})
+        .rename("severity", "level")
+        .severity({"debug", "info"})
+        .build();
+
+    const attribute_pack pack;
+
+    EXPECT_THAT(format(*formatter, 1, pack), StartsWith(bin(
+        "\x82" "\xa5" "level" "\xa4" "info" "\xa6" "fields" "\x84")));
+    EXPECT_THAT(format(*formatter, 2, pack), StartsWith(bin(
+        "\x82" "\xa5" "level" "\x02" "\xa6" "fields" "\x84")));
+}
+
+TEST(msgpack_t, Strings) {
+    auto formatter = builder<msgpack_t>()
+        .route("/fields", builtins())
+        .build();
+
+    const attribute_list attributes{
+        {"invalid", {"\xff"}},
+        {"long", {"0123456789abcdef0123456789abcdef"}}
+    };
+    const attribute_pack pack{attributes};
+
+    EXPECT_THAT(format(*formatter, 0, pack), StartsWith(bin(
+        "\x83"
+        "\xa7" "invalid" "\xa3\xef\xbf\xbd"
+        "\xa4" "long" "\xd9\x20" "0123456789abcdef0123456789abcdef")));
+}
+
+TEST(msgpack_t, ThrowsOnInvalidRoute) {
+    EXPECT_THROW(builder<msgpack_t>().route("fields", {"key"}).build(), std::invalid_argument);
+}
+
+TEST(msgpack_t, FactoryType) {
+    EXPECT_EQ(std::string("msgpack"), factory<msgpack_t>().type());
+}
+
+TEST(msgpack_t, Factory) {
+    using config::testing::mock::node_t;
+
+    StrictMock<node_t> config;
+
+    auto unique = new node_t;
+    EXPECT_CALL(config, subscript_key("unique"))
+        .Times(1)
+        .WillOnce(Return(unique));
+
+    EXPECT_CALL(*unique, to_bool())
+        .Times(1)
+        .WillOnce(Return(true));
+
+    EXPECT_CALL(config, subscript_key("mapping"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
+    EXPECT_CALL(config, subscript_key("routing"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
+    EXPECT_CALL(config, subscript_key("mutate"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
+    auto formatter = factory<msgpack_t>().from(config);
+
+    const attribute_pack pack;
+    EXPECT_THAT(format(*formatter, 0, pack), StartsWith(bin("\x85" "\xa7" "message")));
+}
+
+}  // namespace
+}  // namespace formatter
+}  // namespace v1
+}  // namespace blackhole
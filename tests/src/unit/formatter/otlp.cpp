@@ -0,0 +1,286 @@
+#include <cstring>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <blackhole/attribute.hpp>
+#include <blackhole/attributes.hpp>
+#include <blackhole/extensions/writer.hpp>
+#include <blackhole/formatter.hpp>
+#include <blackhole/formatter/otlp.hpp>
+#include <blackhole/record.hpp>
+#include <blackhole/scope/span.hpp>
+
+#include "mocks/node.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace formatter {
+namespace {
+
+using ::testing::Invoke;
+using ::testing::Return;
+using ::testing::StrictMock;
+using ::testing::_;
+
+struct field_t {
+    std::uint32_t number;
+    std::uint32_t wire;
+    std::uint64_t value;
+    std::string bytes;
+};
+
+/// Decodes top level fields of the given protobuf message.
+auto parse(const std::string& message) -> std::vector<field_t> {
+    std::vector<field_t> result;
+
+    std::size_t pos = 0;
+    const auto varint = [&]() -> std::uint64_t {
+        std::uint64_t value = 0;
+        for (int shift = 0; pos < message.size(); shift += 7) {
+            const auto byte = static_cast<unsigned char>(message[pos++]);
+            value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+            if ((byte & 0x80) == 0) {
+                break;
+            }
+        }
+
+        return value;
+    };
+
+    while (pos < message.size()) {
+        const auto key = varint();
+        field_t field{static_cast<std::uint32_t>(key >> 3), static_cast<std::uint32_t>(key & 7), 0, {}};
+
+        switch (field.wire) {
+        case 0:
+            field.value = varint();
+            break;
+        case 1:
+            std::memcpy(&field.value, message.data() + pos, 8);
+            pos += 8;
+            break;
+        case 2: {
+            const auto size = static_cast<std::size_t>(varint());
+            field.bytes = message.substr(pos, size);
+            pos += size;
+            break;
+        }
+        default:
+            ADD_FAILURE() << "unexpected wire type " << field.wire;
+            return result;
+        }
+
+        result.push_back(field);
+    }
+
+    return result;
+}
+
+/// Decodes `KeyValue` attributes of the log record into keys and `AnyValue` fields.
+auto key_values(const std::vector<field_t>& fields) ->
+    std::vector<std::pair<std::string, std::vector<field_t>>>
+{
+    std::vector<std::pair<std::string, std::vector<field_t>>> result;
+
+    for (const auto& field : fields) {
+        if (field.number == 6) {
+            const auto kv = parse(field.bytes);
+            EXPECT_EQ(2, kv.size());
+            result.emplace_back(kv.at(0).bytes, parse(kv.at(1).bytes));
+        }
+    }
+
+    return result;
+}
+
+auto format(formatter_t& formatter, int severity, const attribute_pack& pack) -> std::string {
+    const string_view message("value");
+    record_t record(severity, message, pack);
+    writer_t writer;
+    formatter.format(record, writer);
+
+    return writer.result().to_string();
+}
+
+TEST(otlp_t, Plain) {
+    auto formatter = builder<otlp_t>()
+        .build();
+
+    const attribute_list attributes{{"key", {42}}};
+    const attribute_pack pack{attributes};
+
+    const auto fields = parse(format(*formatter, 1, pack));
+    ASSERT_EQ(7, fields.size());
+
+    EXPECT_EQ(1, fields[0].number);
+    EXPECT_EQ(1, fields[0].wire);
+    EXPECT_EQ(0, fields[0].value);
+
+    EXPECT_EQ(2, fields[1].number);
+    EXPECT_EQ(9, fields[1].value);
+
+    EXPECT_EQ(3, fields[2].number);
+    EXPECT_EQ("INFO", fields[2].bytes);
+
+    EXPECT_EQ(5, fields[3].number);
+    const auto body = parse(fields[3].bytes);
+    ASSERT_EQ(1, body.size());
+    EXPECT_EQ(1, body[0].number);
+    EXPECT_EQ("value", body[0].bytes);
+
+    const auto kvs = key_values(fields);
+    ASSERT_EQ(3, kvs.size());
+    EXPECT_EQ("process.pid", kvs[0].first);
+    EXPECT_EQ(3, kvs[0].second.at(0).number);
+    EXPECT_EQ("thread.id", kvs[1].first);
+    EXPECT_EQ("key", kvs[2].first);
+    EXPECT_EQ(3, kvs[2].second.at(0).number);
+    EXPECT_EQ(42, kvs[2].second.at(0).value);
+}
+
+TEST(otlp_t, AttributeTypes) {
+    auto formatter = builder<otlp_t>()
+        .build();
+
+    const attribute_list attributes{
+        {"null", {nullptr}},
+        {"bool", {true}},
+        {"sint", {-42}},
+        {"uint", {18446744073709551615ull}},
+        {"double", {1.5}},
+        {"string", {"\xd0\xbf\xff"}}
+    };
+    const attribute_pack pack{attributes};
+
+    const auto kvs = key_values(parse(format(*formatter, 0, pack)));
+    ASSERT_EQ(8, kvs.size());
+
+    EXPECT_EQ("null", kvs[2].first);
+    EXPECT_TRUE(kvs[2].second.empty());
+
+    ASSERT_EQ(1, kvs[3].second.size());
+    EXPECT_EQ(2, kvs[3].second[0].number);
+    EXPECT_EQ(1, kvs[3].second[0].value);
+
+    ASSERT_EQ(1, kvs[4].second.size());
+    EXPECT_EQ(3, kvs[4].second[0].number);
+    EXPECT_EQ(-42, static_cast<std::int64_t>(kvs[4].second[0].value));
+
+    ASSERT_EQ(1, kvs[5].second.size());
+    EXPECT_EQ(1, kvs[5].second[0].number);
+    EXPECT_EQ("18446744073709551615", kvs[5].second[0].bytes);
+
+    ASSERT_EQ(1, kvs[6].second.size());
+    EXPECT_EQ(4, kvs[6].second[0].number);
+    double value;
+    std::memcpy(&value, &kvs[6].second[0].value, sizeof(value));
+    EXPECT_EQ(1.5, value);
+
+    ASSERT_EQ(1, kvs[7].second.size());
+    EXPECT_EQ(1, kvs[7].second[0].number);
+    EXPECT_EQ("\xd0\xbf\xef\xbf\xbd", kvs[7].second[0].bytes);
+}
+
+TEST(otlp_t, SeverityNumbers) {
+    auto formatter = builder<otlp_t>()
+        .severity({"trace", "Debug2", "FATAL4", "custom"})
+        .build();
+
+    const attribute_pack pack;
+
+    const auto severity = [&](int severity) -> std::vector<field_t> {
+        auto fields = parse(format(*formatter, severity, pack));
+        fields.erase(fields.begin());
+        fields.resize(fields.front().number == 2 ? 2 : 1);
+        return fields;
+    };
+
+    EXPECT_EQ(1, severity(0)[0].value);
+    EXPECT_EQ("trace", severity(0)[1].bytes);
+    EXPECT_EQ(6, severity(1)[0].value);
+    EXPECT_EQ(24, severity(2)[0].value);
+
+    ASSERT_EQ(1, severity(3).size());
+    EXPECT_EQ(3, severity(3)[0].number);
+    EXPECT_EQ("custom", severity(3)[0].bytes);
+
+    ASSERT_EQ(1, severity(4).size());
+    EXPECT_EQ("4", severity(4)[0].bytes);
+}
+
+TEST(otlp_t, Unique) {
+    auto formatter = builder<otlp_t>()
+        .unique()
+        .build();
+
+    const attribute_list a1{{"key", {1}}};
+    const attribute_list a2{{"key", {2}}};
+    const attribute_pack pack{a1, a2};
+
+    const auto kvs = key_values(parse(format(*formatter, 0, pack)));
+    ASSERT_EQ(3, kvs.size());
+    EXPECT_EQ(1, kvs[2].second.at(0).value);
+}
+
+TEST(otlp_t, TraceContext) {
+    auto formatter = builder<otlp_t>()
+        .build();
+
+    const trace_t trace{0x0102030405060708ull, 0x090a0b0c0d0e0f10ull, 0x1112131415161718ull};
+    scope::span_t span(trace);
+
+    const attribute_pack pack;
+    const auto fields = parse(format(*formatter, 1, pack));
+    ASSERT_EQ(8, fields.size());
+
+    EXPECT_EQ(9, fields[6].number);
+    EXPECT_EQ("\x01\x02\x03\x04\x05\x06\x07\x08\x09\x0a\x0b\x0c\x0d\x0e\x0f\x10",
+        fields[6].bytes);
+    EXPECT_EQ(10, fields[7].number);
+    EXPECT_EQ("\x11\x12\x13\x14\x15\x16\x17\x18", fields[7].bytes);
+}
+
+TEST(otlp_t, FactoryType) {
+    EXPECT_EQ(std::string("otlp"), factory<otlp_t>().type());
+}
+
+TEST(otlp_t, Factory) {
+    using config::testing::mock::node_t;
+
+    StrictMock<node_t> config;
+
+    auto sevmap = new node_t;
+    EXPECT_CALL(config, subscript_key("sevmap"))
+        .Times(1)
+        .WillOnce(Return(sevmap));
+
+    node_t item;
+    EXPECT_CALL(*sevmap, each(_))
+        .Times(1)
+        .WillOnce(Invoke([&](const node_t::each_function& fn) {
+            fn(item);
+        }));
+
+    EXPECT_CALL(item, to_string())
+        .Times(1)
+        .WillOnce(Return("ERROR"));
+
+    EXPECT_CALL(config, subscript_key("unique"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
+    auto formatter = factory<otlp_t>().from(config);
+
+    const attribute_pack pack;
+    const auto fields = parse(format(*formatter, 0, pack));
+    ASSERT_LE(3, fields.size());
+    EXPECT_EQ(17, fields[1].value);
+    EXPECT_EQ("ERROR", fields[2].bytes);
+}
+
+}  // namespace
+}  // namespace formatter
+}  // namespace v1
+}  // namespace blackhole
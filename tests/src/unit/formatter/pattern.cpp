@@ -0,0 +1,155 @@
+#include <stdexcept>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include <blackhole/attribute.hpp>
+#include <blackhole/attributes.hpp>
+#include <blackhole/stdext/string_view.hpp>
+#include <blackhole/extensions/writer.hpp>
+#include <blackhole/formatter.hpp>
+#include <blackhole/formatter/pattern.hpp>
+#include <blackhole/formatter/string.hpp>
+#include <blackhole/record.hpp>
+#include <blackhole/scope/span.hpp>
+
+namespace blackhole {
+inline namespace v1 {
+namespace formatter {
+namespace {
+
+/// Formats the given record with both compile-time and runtime versions of the pattern, which must
+/// produce the same result.
+template<typename Pattern>
+auto format(const record_t& record) -> std::string {
+    pattern_t<Pattern> formatter;
+    writer_t writer;
+    formatter.format(record, writer);
+
+    auto expected = builder<string_t>(Pattern::value)
+        .build();
+    writer_t wr;
+    expected->format(record, wr);
+
+    EXPECT_EQ(wr.result().to_string(), writer.result().to_string());
+
+    return writer.result().to_string();
+}
+
+TEST(pattern_t, Message) {
+    const string_view message("value");
+    const attribute_pack pack;
+    record_t record(0, message, pack);
+
+    typedef BLACKHOLE_PATTERN("[{message}]") pattern_type;
+
+    EXPECT_EQ("[value]", format<pattern_type>(record));
+}
+
+TEST(pattern_t, EscapedBraces) {
+    const string_view message("value");
+    const attribute_pack pack;
+    record_t record(0, message, pack);
+
+    typedef BLACKHOLE_PATTERN("{{{message}}}") pattern_type;
+
+    EXPECT_EQ("{value}", format<pattern_type>(record));
+}
+
+TEST(pattern_t, Specifications) {
+    const string_view message("value");
+    const attribute_pack pack;
+    record_t record(2, message, pack);
+
+    typedef BLACKHOLE_PATTERN("[{message:*^9}] [{severity:>3d}] [{severity}]") pattern_type;
+
+    EXPECT_EQ("[**value**] [  2] [2]", format<pattern_type>(record));
+}
+
+TEST(pattern_t, SeverityMapping) {
+    const string_view message("-");
+    const attribute_pack pack;
+    record_t record(1, message, pack);
+
+    pattern_t<BLACKHOLE_PATTERN("[{severity}] [{severity:d}]")> formatter(
+        [](int severity, const std::string& spec, writer_t& writer) {
+            writer.write(spec, severity == 1 ? "info" : "?");
+        });
+
+    writer_t writer;
+    formatter.format(record, writer);
+
+    EXPECT_EQ("[info] [1]", writer.result().to_string());
+}
+
+TEST(pattern_t, Timestamp) {
+    const string_view message("-");
+    const attribute_pack pack;
+    record_t record(0, message, pack);
+    record.activate();
+
+    typedef BLACKHOLE_PATTERN("{timestamp} {timestamp:d} {timestamp:{%Y-%m}s} {timestamp:{%H}l}")
+        pattern_type;
+
+    format<pattern_type>(record);
+}
+
+TEST(pattern_t, ProcessAndThread) {
+    const string_view message("-");
+    const attribute_pack pack;
+    record_t record(0, message, pack);
+
+    typedef BLACKHOLE_PATTERN("{process} {process:s} {thread} {thread:d} {thread:s}") pattern_type;
+
+    format<pattern_type>(record);
+}
+
+TEST(pattern_t, Host) {
+    const string_view message("-");
+    const attribute_pack pack;
+    record_t record(0, message, pack);
+
+    typedef BLACKHOLE_PATTERN("{host}|{host:fqdn}|{host:>64}") pattern_type;
+
+    EXPECT_FALSE(format<pattern_type>(record).empty());
+}
+
+TEST(pattern_t, TraceContext) {
+    const string_view message("-");
+    const attribute_pack pack;
+
+    const trace_t trace{0x0af7651916cd43ddull, 0x8448eb211c80319cull, 0xb7ad6b7169203331ull};
+    scope::span_t span(trace);
+    record_t record(0, message, pack);
+
+    typedef BLACKHOLE_PATTERN("{trace_id}/{span_id:>17}") pattern_type;
+
+    EXPECT_EQ("0af7651916cd43dd8448eb211c80319c/ b7ad6b7169203331", format<pattern_type>(record));
+}
+
+TEST(pattern_t, Attributes) {
+    const string_view message("-");
+    const view_of<attributes_t>::type attributes{{"id", {42}}, {"name", {"value"}}};
+    const attribute_pack pack{attributes};
+    record_t record(0, message, pack);
+
+    typedef BLACKHOLE_PATTERN("{name}:{id:>5}") pattern_type;
+
+    EXPECT_EQ("value:   42", format<pattern_type>(record));
+}
+
+TEST(pattern_t, ThrowsOnMissingAttribute) {
+    const string_view message("-");
+    const attribute_pack pack;
+    record_t record(0, message, pack);
+
+    pattern_t<BLACKHOLE_PATTERN("{id}")> formatter;
+    writer_t writer;
+
+    EXPECT_THROW(formatter.format(record, writer), std::logic_error);
+}
+
+}  // namespace
+}  // namespace formatter
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,135 @@
+#include <gtest/gtest.h>
+
+#include <blackhole/attribute.hpp>
+#include <blackhole/extensions/writer.hpp>
+#include <blackhole/record.hpp>
+#include <src/formatter/shared.hpp>
+
+#include "mocks/formatter.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace formatter {
+namespace {
+
+using ::testing::Invoke;
+using ::testing::_;
+
+auto make_formatter(int& calls) -> std::unique_ptr<formatter_t> {
+    std::unique_ptr<testing::mock::formatter_t> formatter(new testing::mock::formatter_t);
+
+    EXPECT_CALL(*formatter, format(_, _))
+        .WillRepeatedly(Invoke([&](const record_t& record, writer_t& writer) {
+            ++calls;
+            writer.write("{}: {}", record.severity(), record.message().to_string());
+        }));
+
+    return std::move(formatter);
+}
+
+TEST(shared_t, FormatsOncePerDispatch) {
+    int calls = 0;
+
+    shared_t shared(make_formatter(calls));
+    auto f1 = shared.share();
+    auto f2 = shared.share();
+
+    const string_view message("GET /porn.png HTTP/1.1");
+    const attribute_pack pack;
+    record_t record(42, message, pack);
+
+    writer_t w1;
+    writer_t w2;
+    w2.write("> ");
+
+    {
+        const dispatch_t dispatch;
+        f1->format(record, w1);
+        f2->format(record, w2);
+    }
+
+    EXPECT_EQ(1, calls);
+    EXPECT_EQ("42: GET /porn.png HTTP/1.1", w1.result().to_string());
+    EXPECT_EQ("> 42: GET /porn.png HTTP/1.1", w2.result().to_string());
+}
+
+TEST(shared_t, FormatsAgainInNextDispatch) {
+    int calls = 0;
+
+    shared_t shared(make_formatter(calls));
+    auto f1 = shared.share();
+    auto f2 = shared.share();
+
+    const string_view message("GET /porn.png HTTP/1.1");
+    const attribute_pack pack;
+
+    for (int severity = 0; severity < 2; ++severity) {
+        record_t record(severity, message, pack);
+
+        const dispatch_t dispatch;
+
+        writer_t w1;
+        writer_t w2;
+        f1->format(record, w1);
+        f2->format(record, w2);
+
+        EXPECT_EQ(w1.result().to_string(), w2.result().to_string());
+        EXPECT_EQ(std::to_string(severity) + ": GET /porn.png HTTP/1.1", w2.result().to_string());
+    }
+
+    EXPECT_EQ(2, calls);
+}
+
+TEST(shared_t, FormatsDirectlyOutsideOfDispatch) {
+    int calls = 0;
+
+    shared_t shared(make_formatter(calls));
+    auto f1 = shared.share();
+    auto f2 = shared.share();
+
+    const string_view message("GET /porn.png HTTP/1.1");
+    const attribute_pack pack;
+    record_t record(42, message, pack);
+
+    writer_t w1;
+    writer_t w2;
+    f1->format(record, w1);
+    f2->format(record, w2);
+
+    EXPECT_EQ(2, calls);
+}
+
+TEST(shared_t, NestedDispatchDoesNotLeakIntoOuter) {
+    int calls = 0;
+
+    shared_t shared(make_formatter(calls));
+    auto f1 = shared.share();
+    auto f2 = shared.share();
+
+    const string_view message("GET /porn.png HTTP/1.1");
+    const attribute_pack pack;
+    record_t outer(1, message, pack);
+    record_t inner(2, message, pack);
+
+    const dispatch_t dispatch;
+
+    writer_t w1;
+    f1->format(outer, w1);
+
+    {
+        const dispatch_t nested;
+
+        writer_t wr;
+        f1->format(inner, wr);
+        EXPECT_EQ("2: GET /porn.png HTTP/1.1", wr.result().to_string());
+    }
+
+    writer_t w2;
+    f2->format(outer, w2);
+    EXPECT_EQ("1: GET /porn.png HTTP/1.1", w2.result().to_string());
+}
+
+}  // namespace
+}  // namespace formatter
+}  // namespace v1
+}  // namespace blackhole
@@ -1,15 +1,24 @@
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cstdlib>
+#include <cstring>
+
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
 #include <boost/algorithm/string/predicate.hpp>
 
 #include <blackhole/attribute.hpp>
+#include <blackhole/attribute/key.hpp>
 #include <blackhole/attributes.hpp>
 #include <blackhole/stdext/string_view.hpp>
 #include <blackhole/extensions/writer.hpp>
 #include <blackhole/formatter.hpp>
 #include <blackhole/formatter/string.hpp>
 #include <blackhole/record.hpp>
+#include <blackhole/scope/span.hpp>
+#include <blackhole/thread.hpp>
 
 namespace {
 
@@ -54,6 +63,32 @@ TEST(string_t, Message) {
     EXPECT_EQ("[value]", writer.result().to_string());
 }
 
+TEST(string_t, MessageWithFillAndAlignment) {
+    auto formatter = builder<string_t>("[{message:*^9}] [{message:>7}] [{message:6}]")
+        .build();
+
+    const string_view message("value");
+    const attribute_pack pack;
+    record_t record(0, message, pack);
+    writer_t writer;
+    formatter->format(record, writer);
+
+    EXPECT_EQ("[**value**] [  value] [value ]", writer.result().to_string());
+}
+
+TEST(string_t, SeverityNumWithWidth) {
+    auto formatter = builder<string_t>("[{severity:>4d}] [{severity:<3d}] [{severity:+d}]")
+        .build();
+
+    const string_view message("-");
+    const attribute_pack pack;
+    record_t record(2, message, pack);
+    writer_t writer;
+    formatter->format(record, writer);
+
+    EXPECT_EQ("[   2] [2  ] [+2]", writer.result().to_string());
+}
+
 TEST(string_t, Severity) {
     // NOTE: No severity mapping provided, formatter falls back to the numeric case.
     auto formatter = builder<string_t>("[{severity}]")
@@ -158,6 +193,27 @@ TEST(string_t, SeverityUserWithSpec) {
     EXPECT_EQ("[DEBUG  ]", writer.result().to_string());
 }
 
+TEST(string_t, SeverityNames) {
+    auto formatter = builder<string_t>("[{severity:<7}] [{severity:s}] [{severity:.2s}]")
+        .mapping(std::vector<std::string>{"DEBUG", "INFO"})
+        .build();
+
+    const string_view message("-");
+    const attribute_pack pack;
+
+    const auto format = [&](int severity) -> std::string {
+        record_t record(severity, message, pack);
+        writer_t writer;
+        formatter->format(record, writer);
+        return writer.result().to_string();
+    };
+
+    EXPECT_EQ("[DEBUG  ] [DEBUG] [DE]", format(0));
+    EXPECT_EQ("[INFO   ] [INFO] [IN]", format(1));
+    EXPECT_EQ("[2      ] [2] [2]", format(2));
+    EXPECT_EQ("[-1     ] [-1] [-1]", format(-1));
+}
+
 TEST(string_t, CombinedSeverityNumWithMessage) {
     auto formatter = builder<string_t>("[{severity:d}]: {message}")
         .build();
@@ -229,6 +285,57 @@ TEST(string_t, GenericDuplicated) {
     EXPECT_EQ("TCP/1", writer.result().to_string());
 }
 
+TEST(string_t, GenericRepeatedPlaceholder) {
+    auto formatter = builder<string_t>("{id}:{id:>4}")
+        .build();
+
+    const string_view message("-");
+    const attribute_list attributes{{"id", {42}}};
+    const attribute_pack pack{attributes};
+    record_t record(0, message, pack);
+    writer_t writer;
+    formatter->format(record, writer);
+
+    EXPECT_EQ("42:  42", writer.result().to_string());
+}
+
+TEST(string_t, GenericInternedKeys) {
+    auto formatter = builder<string_t>("{protocol}/{version}")
+        .build();
+
+    BH_ATTR_KEY(protocol);
+    BH_ATTR_KEY(version);
+
+    const string_view message("-");
+    const attribute_list scoped{{"protocol", {"FTP"}}, {"version", {42}}};
+    const attribute_list user{{protocol, {"HTTP"}}, {version, {1}}};
+    const attribute_pack pack{user, scoped};
+    record_t record(0, message, pack);
+    writer_t writer;
+    formatter->format(record, writer);
+
+    EXPECT_EQ("HTTP/1", writer.result().to_string());
+}
+
+TEST(string_t, GenericSameLengthNames) {
+    auto formatter = builder<string_t>("{addr}:{port}/{path}")
+        .build();
+
+    const string_view message("-");
+    const attribute_list attributes{
+        {"adds", {"-"}},
+        {"path", {"index.html"}},
+        {"port", {8080}},
+        {"addr", {"localhost"}}
+    };
+    const attribute_pack pack{attributes};
+    record_t record(0, message, pack);
+    writer_t writer;
+    formatter->format(record, writer);
+
+    EXPECT_EQ("localhost:8080/index.html", writer.result().to_string());
+}
+
 TEST(string_t, ThrowsIfGenericAttributeNotFound) {
     auto formatter = builder<string_t>("{protocol}/{version:.1f}")
         .build();
@@ -242,6 +349,72 @@ TEST(string_t, ThrowsIfGenericAttributeNotFound) {
     EXPECT_THROW(formatter->format(record, writer), std::logic_error);
 }
 
+TEST(string_t, RendersFallbackIfGenericAttributeNotFound) {
+    auto formatter = builder<string_t>("{protocol}/{version:.1f}")
+        .missing(missing_t::fallback, "-")
+        .build();
+
+    const string_view message("-");
+    const attribute_list attributes{{"protocol", {"HTTP"}}};
+    const attribute_pack pack{attributes};
+    record_t record(0, message, pack);
+    writer_t writer;
+    formatter->format(record, writer);
+
+    EXPECT_EQ("HTTP/-", writer.result().to_string());
+    EXPECT_FALSE(writer.skipped());
+}
+
+TEST(string_t, SkipsIfGenericAttributeNotFound) {
+    auto formatter = builder<string_t>("{protocol}/{version:.1f}")
+        .missing(missing_t::skip)
+        .build();
+
+    const string_view message("-");
+    const attribute_list attributes{{"protocol", {"HTTP"}}};
+    const attribute_pack pack{attributes};
+    record_t record(0, message, pack);
+    writer_t writer;
+    formatter->format(record, writer);
+
+    EXPECT_TRUE(writer.skipped());
+}
+
+TEST(string_t, FormatBatch) {
+    auto formatter = builder<string_t>("{protocol}/{version:.1f} {message}")
+        .missing(missing_t::skip)
+        .build();
+
+    const string_view message("-");
+    const attribute_list full{{"protocol", {"HTTP"}}, {"version", {1.1}}};
+    const attribute_list partial{{"protocol", {"HTTP"}}};
+    const attribute_pack pack1{full};
+    const attribute_pack pack2{partial};
+
+    record_t records[] = {{0, message, pack1}, {0, message, pack2}, {0, message, pack1}};
+    for (auto& record : records) {
+        record.activate();
+    }
+
+    std::size_t offsets[4];
+    bool skipped[3];
+
+    writer_t writer;
+    formatter->format_batch(records, 3, writer, offsets, skipped);
+
+    EXPECT_EQ("HTTP/1.1 -HTTP/1.1 -", writer.result().to_string());
+    EXPECT_FALSE(writer.skipped());
+
+    EXPECT_EQ(0, offsets[0]);
+    EXPECT_EQ(10, offsets[1]);
+    EXPECT_EQ(10, offsets[2]);
+    EXPECT_EQ(20, offsets[3]);
+
+    EXPECT_FALSE(skipped[0]);
+    EXPECT_TRUE(skipped[1]);
+    EXPECT_FALSE(skipped[2]);
+}
+
 TEST(DISABLED_string_t, GenericOptional) {
     auto formatter = builder<string_t>("{protocol}{version:{ - REQUIRED:u}.1f}")
         .build();
@@ -327,6 +500,86 @@ TEST(string_t, ProcessName) {
     EXPECT_TRUE(writer.result().to_string().size() > 0);
 }
 
+TEST(string_t, ProcessInForkedChild) {
+    auto formatter = builder<string_t>("[{process}]")
+        .build();
+
+    const auto pid = ::fork();
+    ASSERT_NE(-1, pid);
+
+    if (pid == 0) {
+        const string_view message("-");
+        const attribute_pack pack;
+        record_t record(0, message, pack);
+        writer_t writer;
+        formatter->format(record, writer);
+
+        const auto ok = writer.result().to_string() == "[" + std::to_string(::getpid()) + "]";
+        ::_exit(ok ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+
+    int status = 0;
+    ASSERT_EQ(pid, ::waitpid(pid, &status, 0));
+    EXPECT_TRUE(WIFEXITED(status));
+    EXPECT_EQ(EXIT_SUCCESS, WEXITSTATUS(status));
+}
+
+TEST(string_t, Host) {
+    auto formatter = builder<string_t>("{host}|{host:fqdn}|{host:->64}")
+        .build();
+
+    const string_view message("-");
+    const attribute_pack pack;
+    record_t record(0, message, pack);
+    writer_t writer;
+    formatter->format(record, writer);
+
+    char host[256] = {};
+    ::gethostname(host, sizeof(host) - 1);
+
+    const auto result = writer.result().to_string();
+    const auto first = result.find('|');
+    const auto last = result.rfind('|');
+
+    EXPECT_EQ(host, result.substr(0, first));
+    EXPECT_FALSE(result.substr(first + 1, last - first - 1).empty());
+    EXPECT_EQ(std::string(64 - std::strlen(host), '-') + host, result.substr(last + 1));
+}
+
+TEST(string_t, TraceContext) {
+    auto formatter = builder<string_t>("{trace_id}/{span_id:>20}")
+        .build();
+
+    const string_view message("-");
+    const attribute_pack pack;
+
+    const auto format = [&]() -> std::string {
+        record_t record(0, message, pack);
+        writer_t writer;
+        formatter->format(record, writer);
+        return writer.result().to_string();
+    };
+
+    EXPECT_EQ(std::string(32, '0') + "/    " + std::string(16, '0'), format());
+
+    const trace_t trace{0x0af7651916cd43ddull, 0x8448eb211c80319cull, 0xb7ad6b7169203331ull};
+    scope::span_t span(trace);
+    EXPECT_EQ("0af7651916cd43dd8448eb211c80319c/    b7ad6b7169203331", format());
+}
+
+TEST(string_t, ThreadId) {
+    auto formatter = builder<string_t>("{thread:d}")
+        .build();
+
+    const string_view message("-");
+    const attribute_pack pack;
+    record_t record(0, message, pack);
+    writer_t writer;
+    formatter->format(record, writer);
+
+    EXPECT_EQ(std::to_string(record.lwp()), writer.result().to_string());
+}
+
 TEST(string_t, Thread) {
     auto formatter = builder<string_t>("{thread}")
         .build();
@@ -394,6 +647,8 @@ struct threadname_guard {
         #else
         #error "Not implemented. Please write an implementation for your OS."
         #endif
+
+        thread::invalidate_names();
     }
 
     ~threadname_guard() {
@@ -404,6 +659,8 @@ struct threadname_guard {
         #else
         #error "Not implemented. Please write an implementation for your OS."
         #endif
+
+        thread::invalidate_names();
     }
 };
 
@@ -512,6 +769,32 @@ TEST(string_t, TimestampExplicitWithType) {
     EXPECT_EQ(wr.str(), writer.result().to_string());
 }
 
+TEST(string_t, TimestampMicrosecondsWithinSameSecond) {
+    auto formatter = builder<string_t>("[{timestamp:{%H:%M:%S.%f|%f}s}]")
+        .build();
+    auto other = builder<string_t>("[{timestamp:{%S.%f}s}]")
+        .build();
+
+    const string_view message("-");
+    const attribute_pack pack;
+    const auto epoch = record_t::clock_type::from_time_t(1000000000);
+
+    const auto format = [&](formatter_t& formatter, std::chrono::microseconds usec) -> std::string {
+        record_t record(0, message, pack);
+        record.activate("", epoch + usec);
+
+        writer_t writer;
+        formatter.format(record, writer);
+        return writer.result().to_string();
+    };
+
+    EXPECT_EQ("[01:46:40.123456|123456]", format(*formatter, std::chrono::microseconds(123456)));
+    EXPECT_EQ("[01:46:40.000042|000042]", format(*formatter, std::chrono::microseconds(42)));
+    EXPECT_EQ("[40.999999]", format(*other, std::chrono::microseconds(999999)));
+    EXPECT_EQ("[01:46:41.000007|000007]", format(*formatter, std::chrono::microseconds(1000007)));
+    EXPECT_EQ("[41.000001]", format(*other, std::chrono::microseconds(1000001)));
+}
+
 TEST(string_t, TimestampSpec) {
     auto formatter = builder<string_t>("[{timestamp:>30s}]")
         .build();
@@ -716,6 +999,27 @@ TEST(string_t, LeftoverWithPattern) {
     ));
 }
 
+TEST(string_t, LeftoverNumbers) {
+    const auto format = [](const std::string& pattern, const attribute_list& attributes) {
+        auto formatter = builder<string_t>(pattern)
+            .build();
+
+        const string_view message("-");
+        const attribute_pack pack{attributes};
+        record_t record(0, message, pack);
+        writer_t writer;
+        formatter->format(record, writer);
+
+        return writer.result().to_string();
+    };
+
+    EXPECT_EQ("key=-42", format("{...:{{name}={value}:p}s}", {{"key", {-42}}}));
+    EXPECT_EQ("key=42", format("{...:{{name}={value}:p}s}", {{"key", {42u}}}));
+    EXPECT_EQ("key=3.5", format("{...:{{name}={value}:p}s}", {{"key", {3.5}}}));
+    EXPECT_EQ("key=  -42", format("{...:{{name}={value:>5d}:p}s}", {{"key", {-42}}}));
+    EXPECT_EQ("key=42   ", format("{...:{{name}={value:<5d}:p}s}", {{"key", {42u}}}));
+}
+
 TEST(string_t, LeftoverWithSeparator) {
     auto formatter = builder<string_t>("{...:{ | :s}s}")
         .build();
@@ -733,6 +1037,49 @@ TEST(string_t, LeftoverWithSeparator) {
     ));
 }
 
+TEST(string_t, LeftoverWithAlignment) {
+    auto formatter = builder<string_t>("[{...:{{name}={value}:p}>8s}] [{...:{{name}={value}:p}^9s}]")
+        .build();
+
+    const string_view message("-");
+    const attribute_list attributes{{"key", {42}}};
+    const attribute_pack pack{attributes};
+    record_t record(0, message, pack);
+    writer_t writer;
+    formatter->format(record, writer);
+
+    EXPECT_EQ("[  key=42] [ key=42  ]", writer.result().to_string());
+}
+
+TEST(string_t, LeftoverWithWidthNotLessThanLength) {
+    auto formatter = builder<string_t>("[{...:{{name}={value}:p}<6s}] [{...:{{name}={value}:p}4s}]")
+        .build();
+
+    const string_view message("-");
+    const attribute_list attributes{{"key", {42}}};
+    const attribute_pack pack{attributes};
+    record_t record(0, message, pack);
+    writer_t writer;
+    formatter->format(record, writer);
+
+    EXPECT_EQ("[key=42] [key=42]", writer.result().to_string());
+}
+
+TEST(string_t, LeftoverSkipsShadowedAttributes) {
+    auto formatter = builder<string_t>("{...}")
+        .build();
+
+    const string_view message("-");
+    const attribute_list a1{{"key#1", {42}}};
+    const attribute_list a2{{"key#1", {100}}};
+    const attribute_pack pack{a1, a2};
+    record_t record(0, message, pack);
+    writer_t writer;
+    formatter->format(record, writer);
+
+    EXPECT_EQ("key#1: 42", writer.result().to_string());
+}
+
 TEST(string_t, FactoryType) {
     EXPECT_EQ(std::string("string"), factory<string_t>().type());
 }
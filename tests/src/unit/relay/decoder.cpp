@@ -0,0 +1,158 @@
+#include <stdexcept>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include <blackhole/attribute.hpp>
+#include <blackhole/attributes.hpp>
+#include <blackhole/record.hpp>
+#include <blackhole/detail/sink/ring.hpp>
+
+#include <relay/decoder.hpp>
+
+namespace blackhole {
+inline namespace v1 {
+namespace relay {
+namespace {
+
+auto frame(const std::string& message) -> std::string {
+    const auto size = message.size();
+    std::string result;
+    result.push_back(static_cast<char>(size >> 24));
+    result.push_back(static_cast<char>(size >> 16));
+    result.push_back(static_cast<char>(size >> 8));
+    result.push_back(static_cast<char>(size));
+    return result + message;
+}
+
+TEST(decoder_t, Text) {
+    const decoder_t decoder(encoding_t::text, 3, 1024);
+    batch_t batch;
+
+    const std::string data("first\nsecond\r\n\nthi");
+    EXPECT_EQ(15, decoder.stream(data.data(), data.size(), batch));
+
+    ASSERT_EQ(2, batch.size());
+    EXPECT_EQ("first", batch.data()[0].message().to_string());
+    EXPECT_EQ("first", batch.data()[0].formatted().to_string());
+    EXPECT_EQ(3, batch.data()[0].severity());
+    EXPECT_EQ("second", batch.data()[1].message().to_string());
+
+    // Records are views over the received bytes.
+    EXPECT_EQ(data.data(), batch.data()[0].message().data());
+}
+
+TEST(decoder_t, ThrowsOnLongLine) {
+    const decoder_t decoder(encoding_t::text, 0, 4);
+    batch_t batch;
+
+    const std::string data("1234\n12345");
+    EXPECT_THROW(decoder.stream(data.data(), data.size(), batch), std::runtime_error);
+    EXPECT_EQ(1, batch.size());
+}
+
+TEST(decoder_t, Framed) {
+    const decoder_t decoder(encoding_t::framed, 0, 1024);
+    batch_t batch;
+
+    const auto data = frame("multi\nline") + frame("") + frame("next").substr(0, 6);
+    EXPECT_EQ(18, decoder.stream(data.data(), data.size(), batch));
+
+    ASSERT_EQ(2, batch.size());
+    EXPECT_EQ("multi\nline", batch.data()[0].message().to_string());
+    EXPECT_EQ("", batch.data()[1].message().to_string());
+}
+
+TEST(decoder_t, ThrowsOnLargeFrame) {
+    const decoder_t decoder(encoding_t::framed, 0, 4);
+    batch_t batch;
+
+    const auto data = frame("12345");
+    EXPECT_THROW(decoder.stream(data.data(), 4, batch), std::runtime_error);
+}
+
+TEST(decoder_t, Binary) {
+    const string_view message("GET {}");
+    const attribute_list attributes{{"status", 200}};
+    const attribute_pack pack{attributes};
+
+    record_t record(4, message, pack);
+    record.activate("GET /");
+
+    const auto data = frame(sink::ring::encode(record, "[4] GET /").to_string());
+
+    const decoder_t decoder(encoding_t::binary, 0, 1024);
+    batch_t batch;
+    EXPECT_EQ(data.size(), decoder.stream(data.data(), data.size(), batch));
+
+    ASSERT_EQ(1, batch.size());
+
+    const auto& result = batch.data()[0];
+    EXPECT_EQ(4, result.severity());
+    EXPECT_EQ("GET {}", result.message().to_string());
+    EXPECT_EQ("GET /", result.formatted().to_string());
+    EXPECT_EQ(record.timestamp(), result.timestamp());
+    EXPECT_EQ(attributes, result.attributes().at(0).get());
+}
+
+TEST(decoder_t, ThrowsOnMalformedBinary) {
+    const decoder_t decoder(encoding_t::binary, 0, 1024);
+    batch_t batch;
+
+    const auto data = frame("garbage");
+    EXPECT_THROW(decoder.stream(data.data(), data.size(), batch), std::runtime_error);
+    EXPECT_EQ(0, batch.size());
+}
+
+TEST(decoder_t, TextDatagram) {
+    const decoder_t decoder(encoding_t::text, 0, 1024);
+    batch_t batch;
+
+    const std::string data("first\nsecond");
+    decoder.datagram(data.data(), data.size(), batch);
+
+    ASSERT_EQ(2, batch.size());
+    EXPECT_EQ("second", batch.data()[1].message().to_string());
+}
+
+TEST(decoder_t, ThrowsOnIncompleteDatagram) {
+    const decoder_t decoder(encoding_t::framed, 0, 1024);
+    batch_t batch;
+
+    const auto data = frame("message");
+    EXPECT_THROW(decoder.datagram(data.data(), data.size() - 1, batch), std::runtime_error);
+}
+
+TEST(batch_t, Retain) {
+    batch_t batch;
+    batch.text("first", 0);
+    batch.text("second", 1);
+    batch.text("third", 2);
+
+    batch.retain([](const record_t& record) {
+        return record.severity() != 1;
+    });
+
+    // Entries of dropped records are not reused until the batch is cleared.
+    batch.text("fourth", 3);
+
+    ASSERT_EQ(3, batch.size());
+    EXPECT_EQ("first", batch.data()[0].message().to_string());
+    EXPECT_EQ("third", batch.data()[1].message().to_string());
+    EXPECT_EQ("fourth", batch.data()[2].message().to_string());
+
+    batch.clear();
+    EXPECT_EQ(0, batch.size());
+}
+
+TEST(encoding, Parse) {
+    EXPECT_EQ(encoding_t::text, encoding("text"));
+    EXPECT_EQ(encoding_t::framed, encoding("framed"));
+    EXPECT_EQ(encoding_t::binary, encoding("binary"));
+    EXPECT_THROW(encoding("xml"), std::invalid_argument);
+}
+
+}  // namespace
+}  // namespace relay
+}  // namespace v1
+}  // namespace blackhole
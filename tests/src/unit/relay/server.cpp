@@ -0,0 +1,210 @@
+#include <unistd.h>
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <boost/asio/connect.hpp>
+#include <boost/asio/io_service.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/ip/udp.hpp>
+#include <boost/asio/local/stream_protocol.hpp>
+#include <boost/asio/write.hpp>
+
+#include <blackhole/handler.hpp>
+#include <blackhole/record.hpp>
+#include <blackhole/root.hpp>
+
+#include <relay/server.hpp>
+
+namespace blackhole {
+inline namespace v1 {
+namespace relay {
+namespace {
+
+/// Handler copying formatted messages of handled records.
+class collector_t : public handler_t {
+    mutable std::mutex mutex;
+    std::vector<std::string> messages;
+
+public:
+    auto handle(const record_t& record) -> void override {
+        std::lock_guard<std::mutex> lock(mutex);
+        messages.push_back(record.formatted().to_string());
+    }
+
+    auto size() const -> std::size_t {
+        std::lock_guard<std::mutex> lock(mutex);
+        return messages.size();
+    }
+
+    auto contains(const std::string& message) const -> bool {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const auto& value : messages) {
+            if (value == message) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    auto wait(std::size_t size) const -> bool {
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (this->size() < size) {
+            if (std::chrono::steady_clock::now() > deadline) {
+                return false;
+            }
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        return true;
+    }
+};
+
+struct relay_t {
+    collector_t* collector;
+    root_logger_t logger;
+
+    relay_t() :
+        collector(new collector_t),
+        logger(handlers(collector))
+    {}
+
+    static auto handlers(collector_t* collector) -> std::vector<std::unique_ptr<handler_t>> {
+        std::vector<std::unique_ptr<handler_t>> result;
+        result.emplace_back(collector);
+        return result;
+    }
+};
+
+auto listener(protocol_t protocol, encoding_t encoding, std::string path = "") -> listener_t {
+    return {protocol, "127.0.0.1", 0, std::move(path), encoding, 2};
+}
+
+TEST(server_t, ThrowsWithoutListeners) {
+    relay_t relay;
+    EXPECT_THROW(server_t(options_t{{}, 1, 1024}, relay.logger), std::invalid_argument);
+}
+
+TEST(server_t, ThrowsWithoutThreads) {
+    relay_t relay;
+    EXPECT_THROW(server_t(options_t{{listener(protocol_t::tcp, encoding_t::text)}, 0, 1024},
+        relay.logger), std::invalid_argument);
+}
+
+TEST(server_t, ReceivesTcp) {
+    relay_t relay;
+    server_t server(options_t{{listener(protocol_t::tcp, encoding_t::text)}, 2, 1024},
+        relay.logger);
+
+    boost::asio::io_service io_service;
+    std::vector<std::unique_ptr<boost::asio::ip::tcp::socket>> sockets;
+
+    // Connections are sharded between workers by the kernel.
+    for (int id = 0; id < 4; ++id) {
+        std::unique_ptr<boost::asio::ip::tcp::socket> socket(
+            new boost::asio::ip::tcp::socket(io_service));
+        socket->connect({boost::asio::ip::address::from_string("127.0.0.1"), server.port(0)});
+
+        const auto data = "first#" + std::to_string(id) + "\nsecond#" + std::to_string(id);
+        boost::asio::write(*socket, boost::asio::buffer(data));
+        sockets.push_back(std::move(socket));
+    }
+
+    for (int id = 0; id < 4; ++id) {
+        boost::asio::write(*sockets[id], boost::asio::buffer(std::string("\n")));
+    }
+
+    ASSERT_TRUE(relay.collector->wait(8));
+    EXPECT_TRUE(relay.collector->contains("first#0"));
+    EXPECT_TRUE(relay.collector->contains("second#3"));
+    EXPECT_EQ(8, server.received());
+}
+
+TEST(server_t, ReceivesUdp) {
+    relay_t relay;
+    server_t server(options_t{{listener(protocol_t::udp, encoding_t::text)}, 2, 1024},
+        relay.logger);
+
+    boost::asio::io_service io_service;
+    boost::asio::ip::udp::socket socket(io_service, boost::asio::ip::udp::v4());
+    socket.send_to(boost::asio::buffer(std::string("datagram")),
+        {boost::asio::ip::address::from_string("127.0.0.1"), server.port(0)});
+
+    ASSERT_TRUE(relay.collector->wait(1));
+    EXPECT_TRUE(relay.collector->contains("datagram"));
+}
+
+TEST(server_t, ReceivesUnix) {
+    const auto path = "/tmp/blackhole-relay-" + std::to_string(::getpid()) + ".sock";
+
+    relay_t relay;
+    server_t server(options_t{{listener(protocol_t::local, encoding_t::framed, path)}, 2, 1024},
+        relay.logger);
+
+    boost::asio::io_service io_service;
+    boost::asio::local::stream_protocol::socket socket(io_service);
+    socket.connect(boost::asio::local::stream_protocol::endpoint(path));
+
+    boost::asio::write(socket, boost::asio::buffer(std::string("\0\0\0\x05hello", 9)));
+
+    ASSERT_TRUE(relay.collector->wait(1));
+    EXPECT_TRUE(relay.collector->contains("hello"));
+
+    ::unlink(path.c_str());
+}
+
+TEST(server_t, DropsRecordsBelowThreshold) {
+    relay_t relay;
+    relay.logger.threshold(3);
+
+    server_t server(options_t{{listener(protocol_t::tcp, encoding_t::text)}, 1, 1024},
+        relay.logger);
+
+    boost::asio::io_service io_service;
+    boost::asio::ip::tcp::socket socket(io_service);
+    socket.connect({boost::asio::ip::address::from_string("127.0.0.1"), server.port(0)});
+    boost::asio::write(socket, boost::asio::buffer(std::string("ignored\n")));
+
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (server.received() == 0 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    EXPECT_EQ(1, server.received());
+    EXPECT_EQ(0, relay.collector->size());
+}
+
+TEST(server_t, RejectsMalformedMessages) {
+    relay_t relay;
+    server_t server(options_t{{listener(protocol_t::tcp, encoding_t::framed)}, 1, 4},
+        relay.logger);
+
+    boost::asio::io_service io_service;
+    boost::asio::ip::tcp::socket socket(io_service);
+    socket.connect({boost::asio::ip::address::from_string("127.0.0.1"), server.port(0)});
+    boost::asio::write(socket, boost::asio::buffer(std::string("\0\0\0\x02ok\0\0\0\x05large", 15)));
+
+    ASSERT_TRUE(relay.collector->wait(1));
+
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (server.rejected() == 0 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    EXPECT_EQ(1, server.rejected());
+    EXPECT_TRUE(relay.collector->contains("ok"));
+}
+
+}  // namespace
+}  // namespace relay
+}  // namespace v1
+}  // namespace blackhole
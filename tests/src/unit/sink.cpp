@@ -0,0 +1,42 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <blackhole/attribute.hpp>
+#include <blackhole/record.hpp>
+#include <blackhole/sink.hpp>
+
+#include "mocks/sink.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace {
+
+using ::testing::InSequence;
+using ::testing::_;
+
+namespace mock = testing::mock;
+
+TEST(sink_t, EmitBatchFallsBackToEmit) {
+    mock::sink_t sink;
+
+    const string_view message("");
+    const attribute_pack pack;
+    const record_t record(0, message, pack);
+
+    const string_view messages[] = {"#1", "#2"};
+    const sink_t::event_t events[] = {{&record, &messages[0]}, {&record, &messages[1]}};
+
+    {
+        InSequence sequence;
+        EXPECT_CALL(sink, emit(_, string_view("#1")))
+            .Times(1);
+        EXPECT_CALL(sink, emit(_, string_view("#2")))
+            .Times(1);
+    }
+
+    sink.emit_batch(events, 2);
+}
+
+}  // namespace
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,416 @@
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <blackhole/attribute.hpp>
+#include <blackhole/attributes.hpp>
+#include <blackhole/record.hpp>
+#include <blackhole/sink/arrow.hpp>
+#include <blackhole/detail/flatbuffers.hpp>
+#include <blackhole/detail/sink/arrow.hpp>
+
+#include "mocks/registry.hpp"
+#include "temporary.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+namespace {
+
+template<typename T>
+auto load(const char* data) -> T {
+    T value;
+    std::memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+/// Minimal FlatBuffers table reader.
+struct table_t {
+    const char* base;
+    std::uint32_t position;
+
+    static auto root(const char* base) -> table_t {
+        return table_t{base, load<std::uint32_t>(base)};
+    }
+
+    auto offset(std::uint16_t field) const -> std::uint16_t {
+        const auto vtable = position - load<std::int32_t>(base + position);
+        const auto size = load<std::uint16_t>(base + vtable);
+
+        if (4u + 2u * field >= size) {
+            return 0;
+        }
+
+        return load<std::uint16_t>(base + vtable + 4 + 2 * field);
+    }
+
+    auto has(std::uint16_t field) const -> bool {
+        return offset(field) != 0;
+    }
+
+    template<typename T>
+    auto scalar(std::uint16_t field) const -> T {
+        return has(field) ? load<T>(base + position + offset(field)) : T();
+    }
+
+    /// Returns the position of the object referenced by the given field.
+    auto deref(std::uint16_t field) const -> std::uint32_t {
+        const auto at = position + offset(field);
+        return at + load<std::uint32_t>(base + at);
+    }
+
+    auto table(std::uint16_t field) const -> table_t {
+        return table_t{base, deref(field)};
+    }
+
+    auto string(std::uint16_t field) const -> std::string {
+        const auto at = deref(field);
+        return std::string(base + at + 4, load<std::uint32_t>(base + at));
+    }
+
+    auto size(std::uint16_t field) const -> std::uint32_t {
+        return load<std::uint32_t>(base + deref(field));
+    }
+
+    /// Returns the table referenced by the given element of the vector of tables.
+    auto element(std::uint16_t field, std::uint32_t id) const -> table_t {
+        const auto at = deref(field) + 4 + 4 * id;
+        return table_t{base, at + load<std::uint32_t>(base + at)};
+    }
+
+    /// Returns the given 64-bit integer of the vector of structs.
+    auto integer(std::uint16_t field, std::uint32_t id) const -> std::int64_t {
+        return load<std::int64_t>(base + deref(field) + 4 + 8 * id);
+    }
+};
+
+/// Encapsulated IPC message.
+struct message_t {
+    std::string metadata;
+    std::string body;
+
+    auto root() const -> table_t {
+        return table_t::root(metadata.data());
+    }
+
+    auto type() const -> std::uint8_t {
+        return root().scalar<std::uint8_t>(1);
+    }
+
+    auto header() const -> table_t {
+        return root().table(2);
+    }
+
+    /// Returns the body buffer with the given index of the record batch header.
+    auto buffer(const table_t& batch, std::uint32_t id) const -> std::string {
+        const auto offset = batch.integer(2, 2 * id);
+        const auto length = batch.integer(2, 2 * id + 1);
+        return body.substr(static_cast<std::size_t>(offset), static_cast<std::size_t>(length));
+    }
+};
+
+/// Splits the stream into messages, which is either complete, i.e. ends with the end-of-stream
+/// marker, or still being written.
+auto parse(const std::string& stream) -> std::vector<message_t> {
+    std::vector<message_t> result;
+
+    std::size_t position = 0;
+    while (position < stream.size()) {
+        if (stream.size() < position + 8 || load<std::uint32_t>(&stream[position]) != 0xffffffff) {
+            throw std::runtime_error("malformed stream");
+        }
+
+        const auto size = load<std::int32_t>(&stream[position + 4]);
+        position += 8;
+
+        if (size == 0) {
+            break;
+        }
+
+        if (size % 8 != 0) {
+            throw std::runtime_error("unaligned metadata");
+        }
+
+        message_t message;
+        message.metadata = stream.substr(position, static_cast<std::size_t>(size));
+        position += static_cast<std::size_t>(size);
+
+        const auto body = message.root().scalar<std::int64_t>(3);
+        message.body = stream.substr(position, static_cast<std::size_t>(body));
+        position += static_cast<std::size_t>(body);
+
+        result.push_back(message);
+    }
+
+    if (position != stream.size()) {
+        throw std::runtime_error("trailing data");
+    }
+
+    return result;
+}
+
+auto strings(const std::string& offsets, const std::string& data) -> std::vector<std::string> {
+    std::vector<std::string> result;
+    for (std::size_t id = 0; id + 1 < offsets.size() / 4; ++id) {
+        const auto begin = load<std::int32_t>(&offsets[4 * id]);
+        const auto end = load<std::int32_t>(&offsets[4 * id + 4]);
+        result.push_back(data.substr(static_cast<std::size_t>(begin),
+            static_cast<std::size_t>(end - begin)));
+    }
+
+    return result;
+}
+
+class arrow_sink : public ::testing::Test {
+protected:
+    const blackhole::testing::temporary_file_t temporary{"arrow"};
+    const std::string filename{temporary.path()};
+
+    auto read() const -> std::vector<message_t> {
+        std::ifstream stream(filename);
+        return parse(std::string{std::istreambuf_iterator<char>(stream),
+            std::istreambuf_iterator<char>()});
+    }
+
+    auto complete() const -> bool {
+        std::ifstream stream(filename);
+        const std::string content{std::istreambuf_iterator<char>(stream),
+            std::istreambuf_iterator<char>()};
+
+        return content.size() >= 8 && content.substr(content.size() - 8) == arrow::batch_t::eos();
+    }
+
+    auto options() const -> arrow_t::options_t {
+        arrow_t::options_t options;
+        options.path = filename;
+        options.interval = std::chrono::milliseconds(0);
+        options.columns = {
+            {"tenant", arrow::type_t::string, true},
+            {"elapsed", arrow::type_t::sint64, false}
+        };
+
+        return options;
+    }
+};
+
+TEST(flatbuffers, Table) {
+    detail::flatbuffers::builder_t builder;
+
+    const auto name = builder.string("le name");
+
+    builder.begin();
+    builder.add<std::uint8_t>(0, 42);
+    builder.reference(2, name);
+    builder.add<std::int64_t>(3, -1);
+    const auto buffer = builder.finish(builder.end());
+
+    const auto root = table_t::root(buffer.data());
+    EXPECT_EQ(42, root.scalar<std::uint8_t>(0));
+    EXPECT_FALSE(root.has(1));
+    EXPECT_EQ("le name", root.string(2));
+    EXPECT_EQ(-1, root.scalar<std::int64_t>(3));
+    EXPECT_FALSE(root.has(4));
+
+    // 64-bit fields must be naturally aligned.
+    EXPECT_EQ(0, (root.position + root.offset(3)) % 8);
+}
+
+TEST_F(arrow_sink, ThrowsOnZeroLimits) {
+    auto options = this->options();
+    options.rows = 0;
+
+    EXPECT_THROW(arrow_t{options}, std::invalid_argument);
+}
+
+TEST_F(arrow_sink, ThrowsOnDuplicateColumns) {
+    auto options = this->options();
+    options.columns.push_back({"severity", arrow::type_t::string, false});
+
+    EXPECT_THROW(arrow_t{options}, std::invalid_argument);
+}
+
+TEST_F(arrow_sink, WritesSchema) {
+    { arrow_t sink(options()); }
+
+    const auto messages = read();
+    EXPECT_TRUE(complete());
+    ASSERT_EQ(1, messages.size());
+    ASSERT_EQ(1, messages[0].type());
+
+    const auto schema = messages[0].header();
+    ASSERT_EQ(7, schema.size(1));
+
+    const char* names[] = {"timestamp", "severity", "message", "pid", "lwp", "tenant", "elapsed"};
+    const std::uint8_t types[] = {10, 2, 5, 2, 2, 5, 2};
+
+    for (std::uint32_t id = 0; id < 7; ++id) {
+        const auto field = schema.element(1, id);
+        EXPECT_EQ(names[id], field.string(0));
+        EXPECT_EQ(types[id], field.scalar<std::uint8_t>(2));
+        EXPECT_EQ(0, field.size(5));
+        EXPECT_EQ(id == 5, field.has(4));
+    }
+
+    // Nanosecond UTC timestamps.
+    const auto timestamp = schema.element(1, 0).table(3);
+    EXPECT_EQ(3, timestamp.scalar<std::int16_t>(0));
+    EXPECT_EQ("UTC", timestamp.string(1));
+
+    // Unsigned 64-bit process id.
+    const auto pid = schema.element(1, 3).table(3);
+    EXPECT_EQ(64, pid.scalar<std::int32_t>(0));
+    EXPECT_FALSE(pid.scalar<bool>(1));
+
+    const auto dictionary = schema.element(1, 5).table(4);
+    EXPECT_EQ(5, dictionary.scalar<std::int64_t>(0));
+    EXPECT_EQ(32, dictionary.table(1).scalar<std::int32_t>(0));
+}
+
+TEST_F(arrow_sink, WritesBatches) {
+    const string_view message("-");
+
+    {
+        arrow_t sink(options());
+
+        const attribute_list first{{"tenant", "alpha"}, {"elapsed", 10}};
+        const attribute_list second{{"tenant", "beta"}};
+        const attribute_list third{{"tenant", "alpha"}, {"elapsed", 30U}};
+
+        const attribute_pack packs[] = {{first}, {second}, {third}};
+        for (int id = 0; id < 3; ++id) {
+            record_t record(id, message, packs[id]);
+            record.activate(message, record_t::time_point(std::chrono::seconds(id)));
+            sink.emit(record, "#" + std::to_string(id));
+        }
+    }
+
+    const auto messages = read();
+    ASSERT_EQ(3, messages.size());
+
+    // The dictionary of the "tenant" column precedes the record batch.
+    ASSERT_EQ(2, messages[1].type());
+    const auto dictionary = messages[1].header();
+    EXPECT_EQ(5, dictionary.scalar<std::int64_t>(0));
+
+    const auto values = dictionary.table(1);
+    EXPECT_EQ(2, values.scalar<std::int64_t>(0));
+    EXPECT_EQ((std::vector<std::string>{"alpha", "beta"}),
+        strings(messages[1].buffer(values, 1), messages[1].buffer(values, 2)));
+
+    ASSERT_EQ(3, messages[2].type());
+    const auto batch = messages[2].header();
+    EXPECT_EQ(3, batch.scalar<std::int64_t>(0));
+    ASSERT_EQ(7, batch.size(1));
+    ASSERT_EQ(2 + 2 + 3 + 2 + 2 + 2 + 2, batch.size(2));
+
+    // Buffers are 8-byte aligned.
+    for (std::uint32_t id = 0; id < batch.size(2); ++id) {
+        EXPECT_EQ(0, batch.integer(2, 2 * id) % 8);
+    }
+
+    // Timestamps.
+    const auto timestamps = messages[2].buffer(batch, 1);
+    ASSERT_EQ(24, timestamps.size());
+    EXPECT_EQ(2000000000, load<std::int64_t>(&timestamps[16]));
+
+    // Severities.
+    const auto severities = messages[2].buffer(batch, 3);
+    ASSERT_EQ(12, severities.size());
+    EXPECT_EQ(2, load<std::int32_t>(&severities[8]));
+
+    // Messages.
+    EXPECT_EQ((std::vector<std::string>{"#0", "#1", "#2"}),
+        strings(messages[2].buffer(batch, 5), messages[2].buffer(batch, 6)));
+
+    // Dictionary codes without nulls.
+    EXPECT_EQ(0, batch.integer(1, 2 * 5 + 1));
+    EXPECT_TRUE(messages[2].buffer(batch, 11).empty());
+
+    const auto codes = messages[2].buffer(batch, 12);
+    ASSERT_EQ(12, codes.size());
+    EXPECT_EQ(0, load<std::int32_t>(&codes[0]));
+    EXPECT_EQ(1, load<std::int32_t>(&codes[4]));
+    EXPECT_EQ(0, load<std::int32_t>(&codes[8]));
+
+    // Elapsed values with the missing one being null.
+    EXPECT_EQ(1, batch.integer(1, 2 * 6 + 1));
+    EXPECT_EQ(std::string(1, '\x05'), messages[2].buffer(batch, 13));
+
+    const auto elapsed = messages[2].buffer(batch, 14);
+    ASSERT_EQ(24, elapsed.size());
+    EXPECT_EQ(10, load<std::int64_t>(&elapsed[0]));
+    EXPECT_EQ(30, load<std::int64_t>(&elapsed[16]));
+}
+
+TEST_F(arrow_sink, WritesBatchOnRowsLimit) {
+    auto options = this->options();
+    options.rows = 2;
+
+    const string_view message("-");
+    const attribute_pack pack;
+    const record_t record(0, message, pack);
+
+    arrow_t sink(options);
+    sink.emit(record, "#1");
+    EXPECT_EQ(1, read().size());
+
+    sink.emit(record, "#2");
+    EXPECT_EQ(3, read().size());
+    EXPECT_FALSE(complete());
+}
+
+TEST_F(arrow_sink, WritesBatchOnFlush) {
+    const string_view message("-");
+    const attribute_pack pack;
+    const record_t record(0, message, pack);
+
+    arrow_t sink(options());
+    sink.emit(record, "#1");
+    EXPECT_EQ(1, read().size());
+
+    sink.flush(std::chrono::steady_clock::now());
+
+    // The dictionary of nulls only is empty, but still sent.
+    EXPECT_EQ(3, read().size());
+}
+
+TEST_F(arrow_sink, WritesBatchOnInterval) {
+    auto options = this->options();
+    options.interval = std::chrono::milliseconds(10);
+
+    const string_view message("-");
+    const attribute_pack pack;
+    const record_t record(0, message, pack);
+
+    arrow_t sink(options);
+    sink.emit(record, "#1");
+
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (read().size() == 1 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    EXPECT_EQ(3, read().size());
+}
+
+TEST(arrow_t, Type) {
+    EXPECT_EQ(arrow::type_t::boolean, arrow::type("bool"));
+    EXPECT_EQ(arrow::type_t::float64, arrow::type("double"));
+    EXPECT_THROW(arrow::type("decimal"), std::invalid_argument);
+}
+
+TEST(arrow_t, FactoryType) {
+    EXPECT_EQ(std::string("arrow"), factory<arrow_t>(mock_registry_t()).type());
+}
+
+}  // namespace
+}  // namespace sink
+}  // namespace v1
+}  // namespace blackhole
@@ -1,7 +1,23 @@
+#include <blackhole/pressure.hpp>
 #include <blackhole/registry.hpp>
 #include <blackhole/sink/asynchronous.hpp>
 #include <blackhole/detail/sink/asynchronous.hpp>
 
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <limits>
+#include <mutex>
+#include <thread>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
@@ -39,6 +55,1179 @@ TEST(asynchronous_t, DelegatesEmit) {
     sink.emit(record, "formatted message");
 }
 
+TEST(asynchronous_t, DelegatesEmitInOrderForEachPolicy) {
+    for (const auto& name : {"sleep", "wait"}) {
+        std::unique_ptr<mock::sink_t> wrapped(new mock::sink_t);
+
+        std::vector<std::string> messages;
+        EXPECT_CALL(*wrapped, emit(_, _))
+            .Times(100)
+            .WillRepeatedly(Invoke([&](const record_t&, string_view message) {
+                messages.push_back(message.to_string());
+            }));
+
+        {
+            asynchronous_t sink(std::move(wrapped), 4,
+                overflow_policy_factory_t().create("wait"),
+                underflow_policy_factory_t().create(name), 8);
+
+            const string_view message("-");
+            const attribute_pack pack;
+            record_t record(0, message, pack);
+
+            for (int i = 0; i < 100; ++i) {
+                sink.emit(record, std::to_string(i));
+            }
+        }
+
+        ASSERT_EQ(100, messages.size());
+        for (int i = 0; i < 100; ++i) {
+            EXPECT_EQ(std::to_string(i), messages[static_cast<std::size_t>(i)]);
+        }
+    }
+}
+
+TEST(asynchronous_t, DelegatesEmitInOrderInRingMode) {
+    std::unique_ptr<mock::sink_t> wrapped(new mock::sink_t);
+
+    std::vector<std::string> messages;
+    std::vector<severity_t> severities;
+    std::vector<std::string> attributes;
+    EXPECT_CALL(*wrapped, emit(_, _))
+        .Times(100)
+        .WillRepeatedly(Invoke([&](const record_t& record, string_view message) {
+            messages.push_back(message.to_string());
+            severities.push_back(record.severity());
+
+            // Records are views over the ring memory, which is reused after emitting.
+            const auto& attribute = record.attributes().at(0).get().at(0);
+            attributes.push_back(attribute.first.to_string() + "=" +
+                attribute::get<string_view>(attribute.second).to_string());
+        }));
+
+    {
+        asynchronous_t sink(std::move(wrapped), 4,
+            overflow_policy_factory_t().create("wait"),
+            underflow_policy_factory_t().create("wait"), 8, asynchronous_t::mode_t::ring);
+
+        const string_view message("-");
+        const attribute_list list{{"key#1", "value#1"}};
+        const attribute_pack pack{list};
+
+        for (int i = 0; i < 100; ++i) {
+            record_t record(i, message, pack);
+            sink.emit(record, std::to_string(i));
+        }
+    }
+
+    ASSERT_EQ(100, messages.size());
+    for (int i = 0; i < 100; ++i) {
+        const auto id = static_cast<std::size_t>(i);
+        EXPECT_EQ(std::to_string(i), messages[id]);
+        EXPECT_EQ(i, severities[id]);
+        EXPECT_EQ("key#1=value#1", attributes[id]);
+    }
+}
+
+TEST(asynchronous_t, EnqueuesLentRegion) {
+    std::unique_ptr<mock::sink_t> wrapped(new mock::sink_t);
+
+    std::vector<std::string> messages;
+    EXPECT_CALL(*wrapped, emit(_, _))
+        .Times(2)
+        .WillRepeatedly(Invoke([&](const record_t& record, string_view message) {
+            EXPECT_EQ(42, record.severity());
+            messages.push_back(message.to_string());
+        }));
+
+    {
+        asynchronous_t sink(std::move(wrapped));
+
+        const string_view message("-");
+        const attribute_pack pack;
+        record_t record(42, message, pack);
+
+        const auto region = sink.lend(record, 16);
+        ASSERT_NE(nullptr, region.data);
+        EXPECT_LE(16, region.size);
+
+        // Only a single region is lent by the thread at a time.
+        EXPECT_EQ(nullptr, sink.lend(record, 16).data);
+
+        std::memcpy(region.data, "#1", 2);
+        sink.commit(record, 2);
+
+        sink.lend(record, 16);
+        sink.cancel();
+
+        sink.emit(record, "#2");
+    }
+
+    EXPECT_EQ((std::vector<std::string>{"#1", "#2"}), messages);
+}
+
+TEST(asynchronous_t, LendsNothingInRingMode) {
+    std::unique_ptr<mock::sink_t> wrapped(new mock::sink_t);
+
+    asynchronous_t sink(std::move(wrapped), 4, overflow_policy_factory_t().create("wait"),
+        underflow_policy_factory_t().create("wait"), 8, asynchronous_t::mode_t::ring);
+
+    const string_view message("-");
+    const attribute_pack pack;
+    record_t record(0, message, pack);
+
+    EXPECT_EQ(nullptr, sink.lend(record, 16).data);
+}
+
+TEST(asynchronous_t, WakesUpParkedConsumer) {
+    std::unique_ptr<mock::sink_t> wrapped(new mock::sink_t);
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool emitted = false;
+
+    EXPECT_CALL(*wrapped, emit(_, string_view("formatted message")))
+        .Times(1)
+        .WillOnce(Invoke([&](const record_t&, string_view) {
+            std::lock_guard<std::mutex> lock(mutex);
+            emitted = true;
+            cv.notify_one();
+        }));
+
+    asynchronous_t sink(std::move(wrapped), 4,
+        overflow_policy_factory_t().create("wait"),
+        underflow_policy_factory_t().create("wait"));
+
+    // Let the consumer thread to be parked.
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    const string_view message("unformatted message");
+    const attribute_pack pack;
+    record_t record(42, message, pack);
+
+    sink.emit(record, "formatted message");
+
+    std::unique_lock<std::mutex> lock(mutex);
+    EXPECT_TRUE(cv.wait_for(lock, std::chrono::seconds(5), [&] { return emitted; }));
+}
+
+class batch_sink_t : public mock::sink_t {
+    std::vector<std::size_t>& sizes;
+    std::vector<std::string>& messages;
+
+public:
+    batch_sink_t(std::vector<std::size_t>& sizes, std::vector<std::string>& messages) :
+        sizes(sizes),
+        messages(messages)
+    {}
+
+    auto emit_batch(const event_t* events, std::size_t size) -> void override {
+        sizes.push_back(size);
+        for (std::size_t id = 0; id < size; ++id) {
+            messages.push_back(events[id].message->to_string());
+        }
+    }
+};
+
+TEST(asynchronous_t, EmitsBatches) {
+    std::vector<std::size_t> sizes;
+    std::vector<std::string> messages;
+
+    std::unique_ptr<batch_sink_t> wrapped(new batch_sink_t(sizes, messages));
+
+    EXPECT_CALL(*wrapped, emit(_, _))
+        .Times(0);
+
+    {
+        asynchronous_t sink(std::move(wrapped), 6,
+            overflow_policy_factory_t().create("wait"),
+            underflow_policy_factory_t().create("wait"), 4);
+
+        const string_view message("-");
+        const attribute_pack pack;
+        record_t record(0, message, pack);
+
+        for (int i = 0; i < 32; ++i) {
+            sink.emit(record, std::to_string(i));
+        }
+    }
+
+    ASSERT_EQ(32, messages.size());
+    for (std::size_t id = 0; id < messages.size(); ++id) {
+        EXPECT_EQ(std::to_string(id), messages[id]);
+    }
+
+    for (auto size : sizes) {
+        EXPECT_TRUE(size >= 1 && size <= 4);
+    }
+}
+
+/// Records emitted messages along with whether each batch was ordered by timestamps.
+class ordered_sink_t : public mock::sink_t {
+    std::vector<std::string>& messages;
+    bool& ordered;
+
+public:
+    ordered_sink_t(std::vector<std::string>& messages, bool& ordered) :
+        messages(messages),
+        ordered(ordered)
+    {}
+
+    auto emit_batch(const event_t* events, std::size_t size) -> void override {
+        for (std::size_t id = 0; id < size; ++id) {
+            messages.push_back(events[id].message->to_string());
+
+            if (id > 0 && events[id].record->timestamp() < events[id - 1].record->timestamp()) {
+                ordered = false;
+            }
+        }
+    }
+};
+
+TEST(asynchronous_t, KeepsPerThreadOrderWithLanes) {
+    const int nthreads = 4;
+    const int count = 1000;
+
+    for (auto mode : {asynchronous_t::mode_t::queue, asynchronous_t::mode_t::ring}) {
+        for (auto ordered : {false, true}) {
+            std::vector<std::string> messages;
+            bool sorted = true;
+
+            std::unique_ptr<ordered_sink_t> wrapped(new ordered_sink_t(messages, sorted));
+
+            {
+                asynchronous_t sink(std::move(wrapped), 4,
+                    overflow_policy_factory_t().create("wait"),
+                    underflow_policy_factory_t().create("wait"), 16, mode, 4,
+                    asynchronous_t::sharding_t::thread, ordered);
+
+                std::vector<std::thread> threads;
+                for (int tid = 0; tid < nthreads; ++tid) {
+                    threads.emplace_back([&, tid] {
+                        const string_view message("-");
+                        const attribute_pack pack;
+
+                        for (int i = 0; i < count; ++i) {
+                            record_t record(0, message, pack);
+                            record.activate();
+                            sink.emit(record, std::to_string(tid) + ":" + std::to_string(i));
+                        }
+                    });
+                }
+
+                for (auto& thread : threads) {
+                    thread.join();
+                }
+            }
+
+            ASSERT_EQ(nthreads * count, messages.size());
+
+            std::vector<int> last(nthreads, -1);
+            for (const auto& message : messages) {
+                const auto pos = message.find(':');
+                const auto tid = static_cast<std::size_t>(std::stoi(message.substr(0, pos)));
+                const auto id = std::stoi(message.substr(pos + 1));
+
+                EXPECT_EQ(last[tid] + 1, id);
+                last[tid] = id;
+            }
+
+            if (ordered) {
+                EXPECT_TRUE(sorted);
+            }
+        }
+    }
+}
+
+/// Blocks on the first emitted message until released, recording all messages.
+class gate_sink_t : public mock::sink_t {
+    std::vector<std::string>& messages;
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool entered;
+    bool released;
+
+public:
+    explicit gate_sink_t(std::vector<std::string>& messages) :
+        messages(messages),
+        entered(false),
+        released(false)
+    {}
+
+    auto emit_batch(const event_t* events, std::size_t size) -> void override {
+        std::unique_lock<std::mutex> lock(mutex);
+        entered = true;
+        cv.notify_all();
+        cv.wait(lock, [&] { return released; });
+
+        for (std::size_t id = 0; id < size; ++id) {
+            messages.push_back(events[id].message->to_string());
+        }
+    }
+
+    auto wait() -> void {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [&] { return entered; });
+    }
+
+    auto release() -> void {
+        std::lock_guard<std::mutex> lock(mutex);
+        released = true;
+        cv.notify_all();
+    }
+};
+
+TEST(asynchronous_t, PriorityLanesBypassSaturatedQueue) {
+    for (auto mode : {asynchronous_t::mode_t::queue, asynchronous_t::mode_t::ring}) {
+        std::vector<std::string> messages;
+        auto wrapped = new gate_sink_t(messages);
+
+        std::vector<asynchronous_t::priority_t> priorities;
+        priorities.push_back({2, 2, nullptr});
+
+        {
+            asynchronous_t sink(std::unique_ptr<sink_t>(wrapped), 1,
+                overflow_policy_factory_t().create("drop"),
+                underflow_policy_factory_t().create("wait"), 16, mode, 1,
+                asynchronous_t::sharding_t::thread, false, std::move(priorities));
+
+            const string_view message("-");
+            const attribute_pack pack;
+            const record_t info(0, message, pack);
+            const record_t error(2, message, pack);
+
+            sink.emit(info, "first");
+            wrapped->wait();
+
+            // The consumer is blocked, so the sharded lane saturates and drops.
+            for (int i = 0; i < 8; ++i) {
+                sink.emit(info, "info");
+            }
+
+            sink.emit(error, "error");
+            wrapped->release();
+        }
+
+        ASSERT_LE(3, messages.size());
+        EXPECT_EQ("first", messages[0]);
+        EXPECT_EQ("error", messages[1]);
+        EXPECT_GT(10, messages.size());
+    }
+}
+
+auto fairness() -> asynchronous_t::fairness_t {
+    asynchronous_t::fairness_t fairness;
+    fairness.attribute = "tenant";
+    fairness.shares.push_back({"noisy", 3});
+    fairness.shares.push_back({"quiet", 1});
+
+    return fairness;
+}
+
+TEST(asynchronous_t, FairSharesIsolateNoisyTenants) {
+    for (auto mode : {asynchronous_t::mode_t::queue, asynchronous_t::mode_t::ring}) {
+        std::vector<std::string> messages;
+        auto wrapped = new gate_sink_t(messages);
+
+        {
+            asynchronous_t sink(std::unique_ptr<sink_t>(wrapped), 1,
+                overflow_policy_factory_t().create("drop"),
+                underflow_policy_factory_t().create("wait"), 16, mode, 1,
+                asynchronous_t::sharding_t::thread, false, {}, asynchronous_t::consumer_t(),
+                nullptr, nullptr, detail::paging_t(), fairness());
+
+            const string_view message("-");
+            const attribute_list noisy{{"tenant", "noisy"}};
+            const attribute_list quiet{{"tenant", "quiet"}};
+            const attribute_pack noisy_pack{noisy};
+            const attribute_pack quiet_pack{quiet};
+
+            sink.emit(record_t(0, message, noisy_pack), "first");
+            wrapped->wait();
+
+            // The consumer is blocked, so the noisy share saturates and drops.
+            for (int i = 0; i < 8; ++i) {
+                sink.emit(record_t(0, message, noisy_pack), "noisy");
+            }
+
+            sink.emit(record_t(0, message, quiet_pack), "quiet");
+            wrapped->release();
+        }
+
+        ASSERT_LE(3, messages.size());
+        EXPECT_EQ("first", messages[0]);
+        EXPECT_NE(messages.end(), std::find(messages.begin(), messages.end(), "quiet"));
+        EXPECT_GT(10, messages.size());
+    }
+}
+
+TEST(asynchronous_t, FairSharesFollowWeights) {
+    std::vector<std::string> messages;
+    auto wrapped = new gate_sink_t(messages);
+
+    auto fairness = sink::fairness();
+    fairness.quantum = 1;
+
+    {
+        asynchronous_t sink(std::unique_ptr<sink_t>(wrapped), 4,
+            overflow_policy_factory_t().create("wait"),
+            underflow_policy_factory_t().create("wait"), 16, asynchronous_t::mode_t::queue, 1,
+            asynchronous_t::sharding_t::thread, false, {}, asynchronous_t::consumer_t(),
+            nullptr, nullptr, detail::paging_t(), fairness);
+
+        const string_view message("-");
+        const attribute_list noisy{{"tenant", "noisy"}};
+        const attribute_list quiet{{"tenant", "quiet"}};
+        const attribute_pack none;
+        const attribute_pack noisy_pack{noisy};
+        const attribute_pack quiet_pack{quiet};
+
+        sink.emit(record_t(0, message, none), "first");
+        wrapped->wait();
+
+        for (int i = 0; i < 6; ++i) {
+            sink.emit(record_t(0, message, noisy_pack), "n");
+            sink.emit(record_t(0, message, quiet_pack), "q");
+        }
+
+        wrapped->release();
+    }
+
+    // Each round credits noisy tenant with three bytes and quiet one with a single byte.
+    const std::vector<std::string> expected{
+        "first", "n", "n", "n", "q", "n", "n", "n", "q", "q", "q", "q", "q"
+    };
+
+    EXPECT_EQ(expected, messages);
+}
+
+TEST(asynchronous_t, ThrowsOnInvalidFairness) {
+    auto make = [](asynchronous_t::fairness_t fairness, std::size_t lanes) {
+        asynchronous_t sink(std::unique_ptr<sink_t>(new mock::sink_t), 2,
+            overflow_policy_factory_t().create("drop"),
+            underflow_policy_factory_t().create("wait"), 16, asynchronous_t::mode_t::queue,
+            lanes, asynchronous_t::sharding_t::thread, false, {}, asynchronous_t::consumer_t(),
+            nullptr, nullptr, detail::paging_t(), std::move(fairness));
+    };
+
+    EXPECT_THROW(make(fairness(), 2), std::invalid_argument);
+
+    auto buckets = fairness();
+    buckets.buckets = 0;
+    EXPECT_THROW(make(buckets, 1), std::invalid_argument);
+
+    auto weight = fairness();
+    weight.shares[1].weight = 0;
+    EXPECT_THROW(make(weight, 1), std::invalid_argument);
+
+    auto duplicated = fairness();
+    duplicated.shares.push_back({"noisy", 1});
+    EXPECT_THROW(make(duplicated, 1), std::invalid_argument);
+}
+
+TEST(asynchronous_t, ExpiresStaleRecords) {
+    for (auto mode : {asynchronous_t::mode_t::queue, asynchronous_t::mode_t::ring}) {
+        for (auto summary : {false, true}) {
+            std::vector<std::string> messages;
+            auto wrapped = new gate_sink_t(messages);
+
+            asynchronous_t::expiry_t expiry;
+            expiry.max_age = std::chrono::milliseconds(50);
+            expiry.summary = summary;
+
+            asynchronous_t sink(std::unique_ptr<sink_t>(wrapped), 4,
+                overflow_policy_factory_t().create("wait"),
+                underflow_policy_factory_t().create("wait"), 16, mode, 1,
+                asynchronous_t::sharding_t::thread, false, {}, asynchronous_t::consumer_t(),
+                nullptr, nullptr, detail::paging_t(), asynchronous_t::fairness_t(), expiry);
+
+            const string_view message("-");
+            const attribute_pack pack;
+
+            record_t first(0, message, pack);
+            first.activate();
+            sink.emit(first, "first");
+            wrapped->wait();
+
+            for (int severity = 1; severity <= 3; ++severity) {
+                record_t stale(severity, message, pack);
+                stale.activate(message, record_t::clock_type::now() - std::chrono::seconds(1));
+                sink.emit(stale, "stale");
+            }
+
+            record_t fresh(0, message, pack);
+            fresh.activate();
+            sink.emit(fresh, "fresh");
+
+            wrapped->release();
+
+            EXPECT_TRUE(sink.flush(std::chrono::steady_clock::now() + std::chrono::seconds(5)));
+            EXPECT_EQ(3, sink.pressure().dropped);
+
+            std::vector<std::string> expected{"first", "fresh"};
+            if (summary) {
+                expected.push_back("3 records expired in queue, older than 50 ms");
+            }
+
+            EXPECT_EQ(expected, messages);
+        }
+    }
+}
+
+/// Records messages of batches and the number of messages emitted by the time of each flush.
+class flushed_sink_t : public mock::sink_t {
+    std::vector<std::string>& messages;
+    std::vector<std::size_t>& flushes;
+
+public:
+    flushed_sink_t(std::vector<std::string>& messages, std::vector<std::size_t>& flushes) :
+        messages(messages),
+        flushes(flushes)
+    {}
+
+    auto emit_batch(const event_t* events, std::size_t size) -> void override {
+        for (std::size_t id = 0; id < size; ++id) {
+            messages.push_back(events[id].message->to_string());
+        }
+    }
+
+    auto flush(std::chrono::steady_clock::time_point) -> bool override {
+        flushes.push_back(messages.size());
+        return true;
+    }
+};
+
+auto flushed_through(std::unique_ptr<sink_t> wrapped, asynchronous_t::mode_t mode,
+                     std::chrono::milliseconds timeout) -> std::unique_ptr<asynchronous_t>
+{
+    asynchronous_t::flush_through_t flush_through;
+    flush_through.threshold = 4;
+    flush_through.timeout = timeout;
+
+    return std::unique_ptr<asynchronous_t>(new asynchronous_t(std::move(wrapped), 10,
+        overflow_policy_factory_t().create("wait"),
+        underflow_policy_factory_t().create("wait"), 16, mode, 1,
+        asynchronous_t::sharding_t::thread, false, {}, asynchronous_t::consumer_t(), nullptr,
+        nullptr, detail::paging_t(), asynchronous_t::fairness_t(), asynchronous_t::expiry_t(),
+        false, flush_through));
+}
+
+TEST(asynchronous_t, FlushThroughWaitsUntilRecordIsFlushed) {
+    for (auto mode : {asynchronous_t::mode_t::queue, asynchronous_t::mode_t::ring}) {
+        std::vector<std::string> messages;
+        std::vector<std::size_t> flushes;
+
+        auto sink = flushed_through(std::unique_ptr<sink_t>(new flushed_sink_t(messages, flushes)),
+            mode, std::chrono::seconds(60));
+
+        const string_view message("-");
+        const attribute_pack pack;
+        const record_t record(0, message, pack);
+        const record_t critical(4, message, pack);
+
+        for (int i = 0; i < 100; ++i) {
+            sink->emit(record, std::to_string(i));
+        }
+
+        sink->emit(critical, "critical");
+
+        // Everything queued before is emitted, and the wrapped sink is flushed after the record.
+        ASSERT_EQ(101, messages.size());
+        EXPECT_EQ("critical", messages.back());
+        ASSERT_FALSE(flushes.empty());
+        EXPECT_EQ(101, flushes.back());
+    }
+}
+
+TEST(asynchronous_t, FlushThroughTimesOut) {
+    std::vector<std::string> messages;
+    auto wrapped = new gate_sink_t(messages);
+
+    auto sink = flushed_through(std::unique_ptr<sink_t>(wrapped), asynchronous_t::mode_t::queue,
+        std::chrono::milliseconds(20));
+
+    const string_view message("-");
+    const attribute_pack pack;
+    const record_t record(0, message, pack);
+    const record_t critical(4, message, pack);
+
+    sink->emit(record, "blocked");
+    wrapped->wait();
+
+    const auto start = std::chrono::steady_clock::now();
+    sink->emit(critical, "critical");
+    EXPECT_LE(std::chrono::milliseconds(20), std::chrono::steady_clock::now() - start);
+
+    wrapped->release();
+    EXPECT_TRUE(sink->flush(std::chrono::steady_clock::now() + std::chrono::seconds(60)));
+    EXPECT_EQ((std::vector<std::string>{"blocked", "critical"}), messages);
+}
+
+TEST(asynchronous_t, ElasticLanesGrowUnderBursts) {
+    std::vector<std::string> messages;
+    auto wrapped = new gate_sink_t(messages);
+
+    asynchronous_t::elastic_t elastic;
+    elastic.segments = 4;
+
+    asynchronous_t sink(std::unique_ptr<sink_t>(wrapped), 2,
+        overflow_policy_factory_t().create("drop"),
+        underflow_policy_factory_t().create("wait"), 1, asynchronous_t::mode_t::queue, 1,
+        asynchronous_t::sharding_t::thread, false, {}, asynchronous_t::consumer_t(), nullptr,
+        nullptr, detail::paging_t(), asynchronous_t::fairness_t(), asynchronous_t::expiry_t(),
+        false, asynchronous_t::flush_through_t(), elastic);
+
+    const string_view message("-");
+    const attribute_pack pack;
+    const record_t record(0, message, pack);
+
+    sink.emit(record, "blocked");
+    wrapped->wait();
+
+    // Records are dropped only once the lane is at four times its initial capacity.
+    for (int i = 0; i < 17; ++i) {
+        sink.emit(record, std::to_string(i));
+    }
+
+    wrapped->release();
+    EXPECT_TRUE(sink.flush(std::chrono::steady_clock::now() + std::chrono::seconds(60)));
+
+    ASSERT_EQ(17, messages.size());
+    EXPECT_EQ("0", messages[1]);
+    EXPECT_EQ("15", messages.back());
+}
+
+TEST(asynchronous_t, ThrowsOnElasticRings) {
+    asynchronous_t::elastic_t elastic;
+    elastic.segments = 4;
+
+    EXPECT_THROW(asynchronous_t(std::unique_ptr<sink_t>(new mock::sink_t), 4,
+        overflow_policy_factory_t().create("wait"),
+        underflow_policy_factory_t().create("wait"), 16, asynchronous_t::mode_t::ring, 1,
+        asynchronous_t::sharding_t::thread, false, {}, asynchronous_t::consumer_t(), nullptr,
+        nullptr, detail::paging_t(), asynchronous_t::fairness_t(), asynchronous_t::expiry_t(),
+        false, asynchronous_t::flush_through_t(), elastic), std::invalid_argument);
+}
+
+TEST(asynchronous_t, FlushWaitsForEmittedRecords) {
+    std::vector<std::size_t> sizes;
+    std::vector<std::string> messages;
+    std::unique_ptr<batch_sink_t> wrapped(new batch_sink_t(sizes, messages));
+
+    asynchronous_t sink(std::move(wrapped), 4,
+        overflow_policy_factory_t().create("wait"),
+        underflow_policy_factory_t().create("wait"), 4);
+
+    const string_view message("-");
+    const attribute_pack pack;
+    const record_t record(0, message, pack);
+
+    for (int i = 0; i < 64; ++i) {
+        sink.emit(record, std::to_string(i));
+    }
+
+    EXPECT_TRUE(sink.flush(std::chrono::steady_clock::now() + std::chrono::seconds(60)));
+    EXPECT_EQ(64, messages.size());
+}
+
+TEST(asynchronous_t, FlushTimesOut) {
+    std::vector<std::string> messages;
+    auto wrapped = new gate_sink_t(messages);
+
+    asynchronous_t sink{std::unique_ptr<sink_t>(wrapped)};
+
+    const string_view message("-");
+    const attribute_pack pack;
+    const record_t record(0, message, pack);
+
+    sink.emit(record, "first");
+    wrapped->wait();
+
+    EXPECT_FALSE(sink.flush(std::chrono::steady_clock::now() + std::chrono::milliseconds(5)));
+
+    wrapped->release();
+    EXPECT_TRUE(sink.flush(std::chrono::steady_clock::now() + std::chrono::seconds(60)));
+    EXPECT_EQ(1, messages.size());
+}
+
+TEST(asynchronous_t, ShutdownAbandonsRecordsAfterDeadline) {
+    std::vector<std::string> messages;
+    auto wrapped = new gate_sink_t(messages);
+
+    asynchronous_t sink(std::unique_ptr<sink_t>(wrapped), 4,
+        overflow_policy_factory_t().create("wait"),
+        underflow_policy_factory_t().create("wait"), 1);
+
+    const string_view message("-");
+    const attribute_pack pack;
+    const record_t record(0, message, pack);
+
+    sink.emit(record, "first");
+    wrapped->wait();
+
+    for (int i = 0; i < 8; ++i) {
+        sink.emit(record, "abandoned");
+    }
+
+    // The consumer is stuck inside of the wrapped sink, which is released after the deadline.
+    std::thread thread([&] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        wrapped->release();
+    });
+
+    EXPECT_FALSE(sink.shutdown(std::chrono::steady_clock::now() + std::chrono::milliseconds(5)));
+    thread.join();
+
+    EXPECT_EQ(std::vector<std::string>{"first"}, messages);
+
+    // Emitting after the shutdown drops records instead of blocking.
+    sink.emit(record, "dropped");
+    EXPECT_EQ(1, messages.size());
+}
+
+#ifdef __linux__
+
+/// Records properties of the thread emitting the first batch.
+class probe_sink_t : public mock::sink_t {
+public:
+    std::string name;
+    cpu_set_t cpus;
+    int policy;
+    int nice;
+
+    auto emit_batch(const event_t*, std::size_t) -> void override {
+        char data[16] = {};
+        ::pthread_getname_np(::pthread_self(), data, sizeof(data));
+        name = data;
+
+        CPU_ZERO(&cpus);
+        ::pthread_getaffinity_np(::pthread_self(), sizeof(cpus), &cpus);
+
+        policy = ::sched_getscheduler(0);
+        nice = ::getpriority(PRIO_PROCESS, static_cast<id_t>(::syscall(SYS_gettid)));
+    }
+};
+
+TEST(asynchronous_t, ConfiguresConsumerThread) {
+    auto wrapped = new probe_sink_t;
+
+    asynchronous_t::consumer_t consumer;
+    consumer.name = "blackhole-consumer";
+    consumer.cpus = {0};
+    consumer.policy = asynchronous_t::consumer_t::policy_t::batch;
+    consumer.nice = 19;
+
+    {
+        asynchronous_t sink(std::unique_ptr<sink_t>(wrapped), 4,
+            overflow_policy_factory_t().create("wait"),
+            underflow_policy_factory_t().create("wait"), 16, asynchronous_t::mode_t::queue, 1,
+            asynchronous_t::sharding_t::thread, false, {}, consumer);
+
+        const string_view message("-");
+        const attribute_pack pack;
+        sink.emit(record_t(0, message, pack), "-");
+        sink.flush(std::chrono::steady_clock::now() + std::chrono::seconds(60));
+
+        EXPECT_EQ("blackhole-consu", wrapped->name);
+        EXPECT_EQ(1, CPU_COUNT(&wrapped->cpus));
+        EXPECT_TRUE(CPU_ISSET(0, &wrapped->cpus));
+        EXPECT_EQ(SCHED_BATCH, wrapped->policy);
+        EXPECT_EQ(19, wrapped->nice);
+    }
+}
+
+TEST(asynchronous_t, ThrowsOnInvalidConsumerProperties) {
+    asynchronous_t::consumer_t consumer;
+    consumer.cpus = {-1};
+
+    EXPECT_THROW(asynchronous_t(std::unique_ptr<sink_t>(new mock::sink_t), 4,
+        overflow_policy_factory_t().create("wait"),
+        underflow_policy_factory_t().create("wait"), 16, asynchronous_t::mode_t::queue, 1,
+        asynchronous_t::sharding_t::thread, false, {}, consumer),
+        std::invalid_argument);
+}
+
+#endif
+
+TEST(asynchronous_t, ExecutorDrainsManySinksInOrder) {
+    const int nsinks = 8;
+    const int count = 1000;
+
+    auto executor = std::make_shared<executor_t>(2);
+
+    std::vector<std::size_t> sizes[nsinks];
+    std::vector<std::string> messages[nsinks];
+
+    {
+        std::vector<std::unique_ptr<asynchronous_t>> sinks;
+        for (int id = 0; id < nsinks; ++id) {
+            sinks.emplace_back(new asynchronous_t(
+                std::unique_ptr<sink_t>(new batch_sink_t(sizes[id], messages[id])), 4,
+                overflow_policy_factory_t().create("wait"),
+                underflow_policy_factory_t().create("wait"), 16, asynchronous_t::mode_t::queue, 1,
+                asynchronous_t::sharding_t::thread, false, {}, asynchronous_t::consumer_t(),
+                executor));
+        }
+
+        std::vector<std::thread> threads;
+        for (int id = 0; id < nsinks; ++id) {
+            threads.emplace_back([&, id] {
+                const string_view message("-");
+                const attribute_pack pack;
+                const record_t record(0, message, pack);
+
+                for (int i = 0; i < count; ++i) {
+                    sinks[id]->emit(record, std::to_string(i));
+                }
+            });
+        }
+
+        for (auto& thread : threads) {
+            thread.join();
+        }
+
+        for (auto& sink : sinks) {
+            EXPECT_TRUE(sink->flush(std::chrono::steady_clock::now() + std::chrono::seconds(60)));
+        }
+    }
+
+    for (int id = 0; id < nsinks; ++id) {
+        ASSERT_EQ(count, messages[id].size());
+
+        for (int i = 0; i < count; ++i) {
+            EXPECT_EQ(std::to_string(i), messages[id][i]);
+        }
+    }
+}
+
+TEST(asynchronous_t, ExecutorDrainsSinkOnDestruction) {
+    auto executor = std::make_shared<executor_t>(1);
+
+    std::vector<std::size_t> sizes;
+    std::vector<std::string> messages;
+
+    {
+        asynchronous_t sink(std::unique_ptr<sink_t>(new batch_sink_t(sizes, messages)), 10,
+            overflow_policy_factory_t().create("wait"),
+            underflow_policy_factory_t().create("wait"), 16, asynchronous_t::mode_t::ring, 1,
+            asynchronous_t::sharding_t::thread, false, {}, asynchronous_t::consumer_t(),
+            executor);
+
+        const string_view message("-");
+        const attribute_pack pack;
+        const record_t record(0, message, pack);
+
+        for (int i = 0; i < 100; ++i) {
+            sink.emit(record, std::to_string(i));
+        }
+    }
+
+    ASSERT_EQ(100, messages.size());
+    EXPECT_EQ("99", messages.back());
+}
+
+TEST(asynchronous_t, ThrowsOnConsumerPropertiesWithExecutor) {
+    asynchronous_t::consumer_t consumer;
+    consumer.name = "blackhole";
+
+    EXPECT_THROW(asynchronous_t(std::unique_ptr<sink_t>(new mock::sink_t), 4,
+        overflow_policy_factory_t().create("wait"),
+        underflow_policy_factory_t().create("wait"), 16, asynchronous_t::mode_t::queue, 1,
+        asynchronous_t::sharding_t::thread, false, {}, consumer, std::make_shared<executor_t>(1)),
+        std::invalid_argument);
+}
+
+#ifdef __linux__
+auto pumped(std::vector<std::size_t>& sizes, std::vector<std::string>& messages,
+            asynchronous_t::mode_t mode) -> std::unique_ptr<asynchronous_t>
+{
+    return std::unique_ptr<asynchronous_t>(new asynchronous_t(
+        std::unique_ptr<sink_t>(new batch_sink_t(sizes, messages)), 10,
+        overflow_policy_factory_t().create("wait"),
+        underflow_policy_factory_t().create("wait"), 16, mode, 1,
+        asynchronous_t::sharding_t::thread, false, {}, asynchronous_t::consumer_t(), nullptr,
+        nullptr, detail::paging_t(), asynchronous_t::fairness_t(), asynchronous_t::expiry_t(),
+        true));
+}
+
+auto readable(int fd) -> bool {
+    std::uint64_t value;
+    const auto rc = ::read(fd, &value, sizeof(value));
+
+    if (rc < 0) {
+        return false;
+    }
+
+    // Puts the signal back, so reading has no side effects.
+    const auto written = ::write(fd, &value, sizeof(value));
+    (void)written;
+    return true;
+}
+
+TEST(asynchronous_t, PumpDrainsBoundedBatchesOnCallingThread) {
+    for (auto mode : {asynchronous_t::mode_t::queue, asynchronous_t::mode_t::ring}) {
+        std::vector<std::size_t> sizes;
+        std::vector<std::string> messages;
+
+        auto sink = pumped(sizes, messages, mode);
+        ASSERT_GE(sink->descriptor(), 0);
+        EXPECT_FALSE(readable(sink->descriptor()));
+
+        const string_view message("-");
+        const attribute_pack pack;
+        const record_t record(0, message, pack);
+
+        for (int i = 0; i < 100; ++i) {
+            sink->emit(record, std::to_string(i));
+        }
+
+        // Nothing is emitted until pumped, since there is no consumer thread.
+        EXPECT_TRUE(readable(sink->descriptor()));
+        EXPECT_TRUE(messages.empty());
+
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(60);
+        EXPECT_EQ(32, sink->pump(32, deadline));
+        EXPECT_EQ(32, messages.size());
+        EXPECT_TRUE(readable(sink->descriptor()));
+
+        EXPECT_EQ(68, sink->pump(1000, deadline));
+        EXPECT_FALSE(readable(sink->descriptor()));
+        EXPECT_EQ(0, sink->pump(1000, deadline));
+
+        for (auto size : sizes) {
+            EXPECT_GE(16, size);
+        }
+
+        ASSERT_EQ(100, messages.size());
+        for (int i = 0; i < 100; ++i) {
+            EXPECT_EQ(std::to_string(i), messages[i]);
+        }
+
+        // Becomes readable again on the next record only.
+        sink->emit(record, "100");
+        EXPECT_TRUE(readable(sink->descriptor()));
+    }
+}
+
+TEST(asynchronous_t, PumpedSinkFlushesAndDrainsOnDestruction) {
+    std::vector<std::size_t> sizes;
+    std::vector<std::string> messages;
+
+    const string_view message("-");
+    const attribute_pack pack;
+    const record_t record(0, message, pack);
+
+    {
+        auto sink = pumped(sizes, messages, asynchronous_t::mode_t::queue);
+
+        sink->emit(record, "flushed");
+        EXPECT_TRUE(sink->flush(std::chrono::steady_clock::now() + std::chrono::seconds(60)));
+        EXPECT_EQ(std::vector<std::string>{"flushed"}, messages);
+
+        for (int i = 0; i < 100; ++i) {
+            sink->emit(record, std::to_string(i));
+        }
+    }
+
+    ASSERT_EQ(101, messages.size());
+    EXPECT_EQ("99", messages.back());
+}
+
+TEST(asynchronous_t, ThrowsOnPumpingSinkWithConsumer) {
+    asynchronous_t sink(std::unique_ptr<sink_t>(new mock::sink_t));
+
+    EXPECT_EQ(-1, sink.descriptor());
+    EXPECT_THROW(sink.pump(1, std::chrono::steady_clock::now()), std::logic_error);
+}
+
+TEST(asynchronous_t, ThrowsOnPumpedSinkWithExecutor) {
+    EXPECT_THROW(asynchronous_t(std::unique_ptr<sink_t>(new mock::sink_t), 4,
+        overflow_policy_factory_t().create("wait"),
+        underflow_policy_factory_t().create("wait"), 16, asynchronous_t::mode_t::queue, 1,
+        asynchronous_t::sharding_t::thread, false, {}, asynchronous_t::consumer_t(),
+        std::make_shared<executor_t>(1), nullptr, detail::paging_t(), asynchronous_t::fairness_t(),
+        asynchronous_t::expiry_t(), true), std::invalid_argument);
+}
+#endif
+
+TEST(executor_t, ThrowsOnZeroThreads) {
+    EXPECT_THROW(executor_t(0), std::invalid_argument);
+}
+
+/// Throws on the given number of first batches, recording messages of the following ones.
+class flaky_sink_t : public mock::sink_t {
+    int failures;
+
+public:
+    std::mutex mutex;
+    std::condition_variable cv;
+    int failed;
+    std::vector<std::string> messages;
+
+    explicit flaky_sink_t(int failures) :
+        failures(failures),
+        failed(0)
+    {}
+
+    auto emit_batch(const event_t* events, std::size_t size) -> void override {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        if (failed < failures) {
+            ++failed;
+            cv.notify_all();
+            throw std::runtime_error("unavailable");
+        }
+
+        for (std::size_t id = 0; id < size; ++id) {
+            messages.push_back(events[id].message->to_string());
+        }
+
+        cv.notify_all();
+    }
+};
+
+TEST(asynchronous_t, DropsFailedBatches) {
+    auto wrapped = new flaky_sink_t(std::numeric_limits<int>::max());
+
+    asynchronous_t sink{std::unique_ptr<sink_t>(wrapped)};
+
+    const string_view message("-");
+    const attribute_pack pack;
+    const record_t record(0, message, pack);
+
+    for (int i = 0; i < 10; ++i) {
+        sink.emit(record, std::to_string(i));
+    }
+
+    EXPECT_TRUE(sink.flush(std::chrono::steady_clock::now() + std::chrono::seconds(60)));
+
+    metrics::snapshot_t snapshot;
+    metrics::collector_t collector(snapshot);
+    sink.collect(collector);
+
+    bool found = false;
+    for (const auto& sample : snapshot) {
+        if (sample.name == "blackhole_queue_failed_total") {
+            EXPECT_EQ(10, sample.value);
+            found = true;
+        }
+    }
+
+    EXPECT_TRUE(found);
+}
+
+TEST(asynchronous_t, RetriesFailedBatches) {
+    auto wrapped = new flaky_sink_t(2);
+
+    asynchronous_t sink(std::unique_ptr<sink_t>(wrapped), 4,
+        overflow_policy_factory_t().create("wait"),
+        underflow_policy_factory_t().create("wait"), 16, asynchronous_t::mode_t::ring, 1,
+        asynchronous_t::sharding_t::thread, false, {}, asynchronous_t::consumer_t(), nullptr,
+        exception_policy_factory_t().retry(3, std::chrono::milliseconds(1)));
+
+    const string_view message("-");
+    const attribute_pack pack;
+    sink.emit(record_t(0, message, pack), "GET");
+
+    EXPECT_TRUE(sink.flush(std::chrono::steady_clock::now() + std::chrono::seconds(60)));
+
+    std::lock_guard<std::mutex> lock(wrapped->mutex);
+    EXPECT_EQ(2, wrapped->failed);
+    EXPECT_EQ(std::vector<std::string>{"GET"}, wrapped->messages);
+}
+
+TEST(asynchronous_t, RetriesDoNotStallQueue) {
+    auto wrapped = new flaky_sink_t(1);
+
+    asynchronous_t sink(std::unique_ptr<sink_t>(wrapped), 4,
+        overflow_policy_factory_t().create("wait"),
+        underflow_policy_factory_t().create("wait"), 16, asynchronous_t::mode_t::queue, 1,
+        asynchronous_t::sharding_t::thread, false, {}, asynchronous_t::consumer_t(), nullptr,
+        exception_policy_factory_t().retry(3, std::chrono::seconds(60)));
+
+    const string_view message("-");
+    const attribute_pack pack;
+    const record_t record(0, message, pack);
+
+    sink.emit(record, "first");
+
+    {
+        std::unique_lock<std::mutex> lock(wrapped->mutex);
+        ASSERT_TRUE(wrapped->cv.wait_for(lock, std::chrono::seconds(5), [&] {
+            return wrapped->failed == 1;
+        }));
+    }
+
+    sink.emit(record, "second");
+
+    std::unique_lock<std::mutex> lock(wrapped->mutex);
+    EXPECT_TRUE(wrapped->cv.wait_for(lock, std::chrono::seconds(5), [&] {
+        return wrapped->messages == std::vector<std::string>{"second"};
+    }));
+}
+
+TEST(asynchronous_t, EmitsFailedBatchesIntoFallback) {
+    auto fallback = new flaky_sink_t(0);
+
+    asynchronous_t sink(std::unique_ptr<sink_t>(new flaky_sink_t(1)), 4,
+        overflow_policy_factory_t().create("wait"),
+        underflow_policy_factory_t().create("wait"), 16, asynchronous_t::mode_t::queue, 1,
+        asynchronous_t::sharding_t::thread, false, {}, asynchronous_t::consumer_t(), nullptr,
+        exception_policy_factory_t().fallback(std::unique_ptr<sink_t>(fallback)));
+
+    const string_view message("-");
+    const attribute_pack pack;
+    sink.emit(record_t(0, message, pack), "GET");
+
+    EXPECT_TRUE(sink.flush(std::chrono::steady_clock::now() + std::chrono::seconds(60)));
+
+    std::lock_guard<std::mutex> lock(fallback->mutex);
+    EXPECT_EQ(std::vector<std::string>{"GET"}, fallback->messages);
+}
+
+TEST(asynchronous_t, ThrowsOnUnorderedPriorities) {
+    std::vector<asynchronous_t::priority_t> priorities;
+    priorities.push_back({1, 4, nullptr});
+    priorities.push_back({2, 4, nullptr});
+
+    EXPECT_THROW(asynchronous_t(std::unique_ptr<sink_t>(new mock::sink_t), 4,
+        overflow_policy_factory_t().create("wait"),
+        underflow_policy_factory_t().create("wait"), 16, asynchronous_t::mode_t::queue, 1,
+        asynchronous_t::sharding_t::thread, false, std::move(priorities)),
+        std::invalid_argument);
+}
+
+TEST(asynchronous_t, ThrowsOnZeroLanes) {
+    std::unique_ptr<mock::sink_t> wrapped(new mock::sink_t);
+
+    EXPECT_THROW(asynchronous_t(std::move(wrapped), 4,
+        overflow_policy_factory_t().create("wait"),
+        underflow_policy_factory_t().create("wait"), 16, asynchronous_t::mode_t::queue, 0),
+        std::invalid_argument);
+}
+
+TEST(asynchronous_t, ThrowsOnPagingInQueueMode) {
+    detail::paging_t paging;
+    paging.huge = true;
+
+    EXPECT_THROW(asynchronous_t(std::unique_ptr<sink_t>(new mock::sink_t), 4,
+        overflow_policy_factory_t().create("wait"),
+        underflow_policy_factory_t().create("wait"), 16, asynchronous_t::mode_t::queue, 1,
+        asynchronous_t::sharding_t::thread, false, {}, asynchronous_t::consumer_t(), nullptr,
+        nullptr, paging),
+        std::invalid_argument);
+}
+
+TEST(asynchronous_t, ReportsNoPressureWhenIdle) {
+    asynchronous_t sink(std::unique_ptr<sink_t>(new mock::sink_t), 4);
+
+    const auto pressure = sink.pressure();
+    EXPECT_DOUBLE_EQ(0.0, pressure.fill);
+    EXPECT_EQ(0, pressure.dropped);
+    EXPECT_EQ(pressure_t::level_t::normal, pressure.level);
+}
+
 TEST(asynchronous_t, FactoryType) {
     mock_registry_t registry;
     factory<asynchronous_t> factory(registry);
@@ -51,10 +1240,129 @@ TEST(overflow_policy_factory_t, CreatesRegisteredPolicies) {
     EXPECT_NO_THROW(overflow_policy_factory_t().create("wait"));
 }
 
+TEST(exception_policy_factory_t, ThrowsIfRequestedNonRegisteredPolicy) {
+    EXPECT_NO_THROW(exception_policy_factory_t().create("drop"));
+    EXPECT_THROW(exception_policy_factory_t().create("retry"), std::invalid_argument);
+}
+
 TEST(overflow_policy_factory_t, ThrowsIfRequestedNonRegisteredPolicy) {
     EXPECT_THROW(overflow_policy_factory_t().create(""), std::invalid_argument);
 }
 
+TEST(overflow_policy_t, TimeoutDropsAfterDeadline) {
+    auto policy = overflow_policy_factory_t().timeout(std::chrono::milliseconds(10));
+
+    const string_view message("GET");
+    const attribute_pack pack;
+    const record_t record(0, message, pack);
+
+    int attempts = 0;
+    const auto start = std::chrono::steady_clock::now();
+
+    EXPECT_FALSE(policy->resolve(record, [&]() -> bool {
+        ++attempts;
+        return false;
+    }));
+
+    EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(10));
+    // Not polling, there is no wakeup.
+    EXPECT_EQ(1, attempts);
+}
+
+TEST(overflow_policy_t, TimeoutRetriesOnWakeup) {
+    auto policy = overflow_policy_factory_t().timeout(std::chrono::seconds(60));
+
+    const string_view message("GET");
+    const attribute_pack pack;
+    const record_t record(0, message, pack);
+
+    std::atomic<bool> room(false);
+
+    std::thread consumer([&] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        room = true;
+        policy->wakeup();
+    });
+
+    EXPECT_TRUE(policy->resolve(record, [&]() -> bool {
+        return room.load();
+    }));
+
+    consumer.join();
+}
+
+TEST(overflow_policy_t, SeverityDropsLowSeverityImmediately) {
+    auto policy = overflow_policy_factory_t().severity(2, std::chrono::seconds(60));
+
+    const string_view message("GET");
+    const attribute_pack pack;
+    const record_t debug(1, message, pack);
+    const record_t error(2, message, pack);
+
+    int attempts = 0;
+    const auto enqueue = [&]() -> bool {
+        return ++attempts > 1;
+    };
+
+    EXPECT_FALSE(policy->resolve(debug, enqueue));
+    EXPECT_EQ(0, attempts);
+
+    std::thread consumer([&] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        policy->wakeup();
+    });
+
+    EXPECT_TRUE(policy->resolve(error, enqueue));
+    consumer.join();
+}
+
+TEST(underflow_policy_factory_t, CreatesRegisteredPolicies) {
+    EXPECT_NO_THROW(underflow_policy_factory_t().create("sleep"));
+    EXPECT_NO_THROW(underflow_policy_factory_t().create("wait"));
+}
+
+TEST(underflow_policy_factory_t, ThrowsIfRequestedNonRegisteredPolicy) {
+    EXPECT_THROW(underflow_policy_factory_t().create(""), std::invalid_argument);
+}
+
+TEST(eventcount_t, CancelledWait) {
+    eventcount_t event;
+
+    event.prepare();
+    event.cancel();
+    event.notify();
+}
+
+TEST(eventcount_t, WaitUntilTimesOut) {
+    eventcount_t event;
+
+    const auto key = event.prepare();
+    EXPECT_FALSE(event.wait_until(key, std::chrono::steady_clock::now() +
+        std::chrono::milliseconds(1)));
+}
+
+TEST(eventcount_t, NotifyWakesUpWaiter) {
+    eventcount_t event;
+    std::atomic<bool> ready(false);
+
+    std::thread thread([&] {
+        while (!ready) {
+            const auto key = event.prepare();
+
+            if (ready) {
+                event.cancel();
+            } else {
+                event.wait(key);
+            }
+        }
+    });
+
+    ready = true;
+    event.notify();
+
+    thread.join();
+}
+
 }  // namespace
 }  // namespace sink
 }  // namespace v1
@@ -1,3 +1,8 @@
+#include <chrono>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
@@ -82,6 +87,90 @@ TEST(console_t, NonColoredOutputToNonTTY) {
     EXPECT_EQ("expected\n", stream.str());
 }
 
+TEST(console_t, BufferedThrowsOnNonStandardStream) {
+    std::stringstream stream;
+
+    EXPECT_THROW(console_t(stream, [](const record_t&) -> termcolor_t {
+        return {};
+    }, {1024, std::chrono::milliseconds(0)}), std::invalid_argument);
+}
+
+TEST(console_t, BufferedThrowsOnZeroCapacity) {
+    EXPECT_THROW(console_t(std::cout, [](const record_t&) -> termcolor_t {
+        return {};
+    }, {0, std::chrono::milliseconds(0)}), std::invalid_argument);
+}
+
+TEST(console_t, BufferedWritesOnCapacity) {
+    const string_view message("");
+    const attribute_pack pack;
+    record_t record(42, message, pack);
+
+    CaptureStdout();
+
+    std::string before;
+    {
+        console_t sink(std::cout, [](const record_t&) -> termcolor_t {
+            return termcolor_t::red();
+        }, {16, std::chrono::milliseconds(0)});
+
+        sink.emit(record, "expected");
+        sink.emit(record, "expected");
+        sink.emit(record, "pending");
+
+        std::cout.flush();
+        before = GetCapturedStdout();
+        CaptureStdout();
+    }
+
+    // Captured output is not a terminal, so there must be no escape sequences.
+    EXPECT_EQ("expected\nexpected\n", before);
+    EXPECT_EQ("pending\n", GetCapturedStdout());
+}
+
+TEST(console_t, BufferedWritesOnInterval) {
+    const string_view message("");
+    const attribute_pack pack;
+    record_t record(42, message, pack);
+
+    CaptureStdout();
+
+    console_t sink(std::cout, [](const record_t&) -> termcolor_t {
+        return {};
+    }, {1024, std::chrono::milliseconds(10)});
+
+    sink.emit(record, "expected");
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    EXPECT_EQ("expected\n", GetCapturedStdout());
+}
+
+TEST(console_t, BufferedBatch) {
+    const string_view message("");
+    const attribute_pack pack;
+    record_t record(42, message, pack);
+
+    const string_view messages[] = {"first", "second", "third"};
+    const sink_t::event_t events[] = {
+        {&record, &messages[0]},
+        {&record, &messages[1]},
+        {&record, &messages[2]}
+    };
+
+    CaptureStdout();
+    {
+        auto sink = builder<console_t>()
+            .buffered(1024, std::chrono::milliseconds(0))
+            .build();
+
+        EXPECT_TRUE(dynamic_cast<const console_t&>(*sink).buffered());
+
+        sink->emit_batch(events, 3);
+    }
+
+    EXPECT_EQ("first\nsecond\nthird\n", GetCapturedStdout());
+}
+
 TEST(console_t, FactoryType) {
     EXPECT_EQ(std::string("console"), factory<sink::console_t>(mock_registry_t()).type());
 }
@@ -138,6 +138,33 @@ TEST(builder, ResetColorizeWithRvalue) {
     EXPECT_EQ(termcolor_t::red(), cast.mapping(record2));
 }
 
+TEST(builder, ColorizeOverridesFunctionPerSeverity) {
+    auto sink = builder<console_t>()
+        .colorize([](const record_t&) -> termcolor_t {
+            return termcolor_t::red();
+        })
+        .colorize(2, termcolor_t::blue())
+        .colorize(2, termcolor_t::green())
+        .colorize(-1, termcolor_t::yellow())
+        .build();
+    auto& cast = static_cast<console_t&>(*sink);
+
+    const string_view message("");
+    const attribute_pack pack;
+
+    record_t record1(0, message, pack);
+    EXPECT_EQ(termcolor_t::red(), cast.mapping(record1));
+
+    record_t record2(2, message, pack);
+    EXPECT_EQ(termcolor_t::green(), cast.mapping(record2));
+
+    record_t record3(-1, message, pack);
+    EXPECT_EQ(termcolor_t::yellow(), cast.mapping(record3));
+
+    record_t record4(1000, message, pack);
+    EXPECT_EQ(termcolor_t::red(), cast.mapping(record4));
+}
+
 }  // namespace
 }  // namespace sink
 }  // namespace v1
@@ -0,0 +1,167 @@
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <blackhole/detail/sink/elastic.hpp>
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+namespace {
+
+typedef elastic_queue_t<int> queue_type;
+
+auto push(queue_type& queue, int value) -> bool {
+    return queue.enqueue_with([&](int& item) {
+        item = value;
+    });
+}
+
+auto pop(queue_type& queue) -> int {
+    int result = -1;
+    queue.dequeue_with([&](int& item) {
+        result = item;
+    });
+
+    return result;
+}
+
+TEST(elastic_queue_t, ThrowsOnInvalidSegments) {
+    EXPECT_THROW(queue_type(4, 0), std::invalid_argument);
+    EXPECT_THROW(queue_type(4, 257), std::invalid_argument);
+}
+
+TEST(elastic_queue_t, SingleSegmentIsFullAtItsCapacity) {
+    queue_type queue(4);
+
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_TRUE(push(queue, i));
+    }
+
+    EXPECT_FALSE(push(queue, 4));
+    EXPECT_EQ(4, queue.capacity());
+    EXPECT_EQ(4, queue.reserved());
+    EXPECT_FALSE(queue.spare());
+}
+
+TEST(elastic_queue_t, GrowsUpToMaximumKeepingOrder) {
+    queue_type queue(4, 3);
+
+    EXPECT_EQ(12, queue.capacity());
+    EXPECT_EQ(4, queue.reserved());
+
+    for (int i = 0; i < 12; ++i) {
+        EXPECT_TRUE(push(queue, i));
+    }
+
+    EXPECT_FALSE(push(queue, 12));
+    EXPECT_EQ(12, queue.reserved());
+
+    for (int i = 0; i < 12; ++i) {
+        EXPECT_EQ(i, pop(queue));
+    }
+
+    EXPECT_EQ(-1, pop(queue));
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(elastic_queue_t, ReusesSegmentsLeftBehind) {
+    queue_type queue(2, 2, std::chrono::milliseconds(3600000));
+
+    for (int round = 0; round < 8; ++round) {
+        for (int i = 0; i < 4; ++i) {
+            EXPECT_TRUE(push(queue, round * 4 + i));
+        }
+
+        for (int i = 0; i < 4; ++i) {
+            EXPECT_EQ(round * 4 + i, pop(queue));
+        }
+    }
+
+    EXPECT_EQ(4, queue.reserved());
+}
+
+TEST(elastic_queue_t, KeepsSpareSegmentsUntilIdle) {
+    queue_type queue(2, 4, std::chrono::milliseconds(3600000));
+
+    for (int i = 0; i < 8; ++i) {
+        push(queue, i);
+    }
+
+    while (pop(queue) >= 0) {}
+
+    queue.trim();
+
+    EXPECT_TRUE(queue.spare());
+    EXPECT_EQ(8, queue.reserved());
+}
+
+TEST(elastic_queue_t, TrimsSpareSegmentsWhenIdle) {
+    queue_type queue(2, 4, std::chrono::milliseconds(0));
+
+    for (int i = 0; i < 8; ++i) {
+        push(queue, i);
+    }
+
+    // Segments still chained are kept.
+    queue.trim();
+    EXPECT_EQ(8, queue.reserved());
+
+    while (pop(queue) >= 0) {}
+
+    queue.trim();
+
+    EXPECT_FALSE(queue.spare());
+    EXPECT_EQ(2, queue.reserved());
+
+    for (int i = 0; i < 8; ++i) {
+        EXPECT_TRUE(push(queue, i));
+    }
+
+    EXPECT_EQ(0, pop(queue));
+}
+
+TEST(elastic_queue_t, KeepsOrderOfEachProducer) {
+    constexpr int threads = 4;
+    constexpr int count = 10000;
+
+    queue_type queue(16, 64, std::chrono::milliseconds(0));
+
+    std::vector<std::thread> producers;
+    for (int thread = 0; thread < threads; ++thread) {
+        producers.emplace_back([&, thread] {
+            for (int i = 0; i < count; ++i) {
+                while (!push(queue, thread * count + i)) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    std::vector<int> last(threads, -1);
+    for (int received = 0; received < threads * count;) {
+        const auto value = pop(queue);
+
+        if (value < 0) {
+            queue.trim();
+            std::this_thread::yield();
+            continue;
+        }
+
+        EXPECT_LT(last[value / count], value % count);
+        last[value / count] = value % count;
+        ++received;
+    }
+
+    for (auto& producer : producers) {
+        producer.join();
+    }
+
+    EXPECT_TRUE(queue.empty());
+}
+
+}  // namespace
+}  // namespace sink
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,413 @@
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/asio/buffers_iterator.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/read.hpp>
+#include <boost/asio/read_until.hpp>
+#include <boost/asio/streambuf.hpp>
+#include <boost/asio/write.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <blackhole/attribute.hpp>
+#include <blackhole/record.hpp>
+#include <blackhole/sink/elasticsearch.hpp>
+
+#include <blackhole/detail/sink/elasticsearch.hpp>
+
+#include "mocks/node.hpp"
+#include "mocks/registry.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+namespace {
+
+using ::testing::Return;
+using ::testing::StrictMock;
+
+/// Accepts a single connection and answers each bulk request with the body returned by the given
+/// function, recording request bodies.
+class server_t {
+    typedef std::function<std::string(std::size_t id)> respond_type;
+
+    boost::asio::io_service io_service;
+    boost::asio::ip::tcp::acceptor acceptor;
+    respond_type respond;
+
+    mutable std::mutex mutex;
+    std::vector<std::string> bodies;
+    std::string path;
+
+    std::thread thread;
+
+public:
+    explicit server_t(respond_type respond) :
+        acceptor(io_service, boost::asio::ip::tcp::endpoint(boost::asio::ip::tcp::v4(), 0)),
+        respond(std::move(respond))
+    {
+        thread = std::thread([this] {
+            run();
+        });
+    }
+
+    ~server_t() {
+        thread.join();
+    }
+
+    auto port() const -> std::uint16_t {
+        return acceptor.local_endpoint().port();
+    }
+
+    auto requests() const -> std::vector<std::string> {
+        std::lock_guard<std::mutex> lock(mutex);
+        return bodies;
+    }
+
+    auto target() const -> std::string {
+        std::lock_guard<std::mutex> lock(mutex);
+        return path;
+    }
+
+private:
+    auto run() -> void {
+        boost::asio::ip::tcp::socket socket(io_service);
+        acceptor.accept(socket);
+
+        boost::asio::streambuf buffer;
+        boost::system::error_code ec;
+
+        for (std::size_t id = 0; ; ++id) {
+            const auto size = boost::asio::read_until(socket, buffer, "\r\n\r\n", ec);
+            if (ec) {
+                return;
+            }
+
+            const auto begin = boost::asio::buffers_begin(buffer.data());
+            const std::string head(begin, begin + static_cast<std::ptrdiff_t>(size));
+            buffer.consume(size);
+
+            const auto pos = head.find("Content-Length: ");
+            const auto length = static_cast<std::size_t>(std::atoi(head.c_str() + pos + 16));
+
+            if (buffer.size() < length) {
+                boost::asio::read(socket, buffer, boost::asio::transfer_exactly(length - buffer.size()), ec);
+                if (ec) {
+                    return;
+                }
+            }
+
+            const auto data = boost::asio::buffers_begin(buffer.data());
+            const std::string body(data, data + static_cast<std::ptrdiff_t>(length));
+            buffer.consume(length);
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                bodies.push_back(body);
+                path = head.substr(0, head.find("\r\n"));
+            }
+
+            const auto response = respond(id);
+            const auto reply = "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n"
+                "Content-Length: " + std::to_string(response.size()) + "\r\n\r\n" + response;
+
+            boost::asio::write(socket, boost::asio::buffer(reply), ec);
+            if (ec) {
+                return;
+            }
+        }
+    }
+};
+
+auto bulk(const std::vector<int>& statuses) -> std::string {
+    std::string result = R"({"took":3,"errors":true,"items":[)";
+
+    for (std::size_t id = 0; id < statuses.size(); ++id) {
+        if (id > 0) {
+            result += ",";
+        }
+
+        result += R"({"index":{"_index":"logs","_id":"x","status":)" + std::to_string(statuses[id]);
+
+        if (statuses[id] >= 300) {
+            result += R"(,"error":{"type":"es_rejected_execution_exception","reason":"{\"status\":1}"})";
+        }
+
+        result += "}}";
+    }
+
+    return result + "]}";
+}
+
+template<typename F>
+auto wait(F&& predicate) -> bool {
+    for (int i = 0; i < 5000; ++i) {
+        if (predicate()) {
+            return true;
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    return false;
+}
+
+auto options(std::uint16_t port) -> elasticsearch_t::options_t {
+    elasticsearch_t::options_t options;
+    options.host = "127.0.0.1";
+    options.port = port;
+    options.connections = 1;
+    return options;
+}
+
+TEST(elasticsearch, ParsesStatuses) {
+    std::vector<int> statuses;
+
+    EXPECT_TRUE(elasticsearch::statuses(bulk({201, 429, 400, 200}), statuses));
+    EXPECT_EQ((std::vector<int>{201, 429, 400, 200}), statuses);
+}
+
+TEST(elasticsearch, ParsesStatusesIgnoringNestedOnes) {
+    std::vector<int> statuses;
+
+    const std::string body = R"({"items": [{"create": {"error": {"status": 1}, "status" : 409}}], )"
+        R"("took": 1, "errors": true})";
+
+    EXPECT_TRUE(elasticsearch::statuses(body, statuses));
+    EXPECT_EQ(std::vector<int>{409}, statuses);
+}
+
+TEST(elasticsearch, ParseRejectsMalformedResponses) {
+    std::vector<int> statuses;
+
+    EXPECT_FALSE(elasticsearch::statuses(R"({"error":"not found"})", statuses));
+    EXPECT_FALSE(elasticsearch::statuses(R"({"items":[{"index":{"status":201}})", statuses));
+    EXPECT_FALSE(elasticsearch::statuses(R"({"items":[]}]})", statuses));
+}
+
+TEST(elasticsearch, ThrowsOnZeroLimits) {
+    auto options = elasticsearch_t::options_t();
+    options.count = 0;
+
+    EXPECT_THROW(elasticsearch_t{options}, std::invalid_argument);
+}
+
+TEST(elasticsearch, SendsFullBulkRequest) {
+    server_t server([](std::size_t) {
+        return bulk({201, 201});
+    });
+
+    auto opts = options(server.port());
+    opts.count = 2;
+    opts.linger = std::chrono::milliseconds(60000);
+
+    elasticsearch_t sink(opts);
+
+    const string_view message("");
+    const attribute_pack pack;
+    const record_t record(0, message, pack);
+
+    sink.emit(record, R"({"message":"first"})");
+    sink.emit(record, R"({"message":"second"})");
+
+    ASSERT_TRUE(wait([&] { return sink.sent() == 2; }));
+
+    const auto requests = server.requests();
+    ASSERT_EQ(1, requests.size());
+    EXPECT_EQ("{\"index\":{}}\n{\"message\":\"first\"}\n{\"index\":{}}\n{\"message\":\"second\"}\n",
+        requests[0]);
+    EXPECT_EQ("POST /logs/_bulk HTTP/1.1", server.target());
+    EXPECT_EQ(0, sink.failed());
+}
+
+TEST(elasticsearch, SendsIncompleteRequestAfterLinger) {
+    server_t server([](std::size_t) {
+        return bulk({201});
+    });
+
+    auto opts = options(server.port());
+    opts.linger = std::chrono::milliseconds(10);
+
+    elasticsearch_t sink(opts);
+
+    const string_view message("");
+    const attribute_pack pack;
+    const record_t record(0, message, pack);
+
+    sink.emit(record, "{}");
+
+    ASSERT_TRUE(wait([&] { return sink.sent() == 1; }));
+    EXPECT_EQ(1, server.requests().size());
+}
+
+TEST(elasticsearch, SplitsRequestsByBytes) {
+    server_t server([](std::size_t) {
+        return bulk({201});
+    });
+
+    auto opts = options(server.port());
+    opts.bytes = 16;
+    opts.linger = std::chrono::milliseconds(10);
+
+    elasticsearch_t sink(opts);
+
+    const string_view message("");
+    const attribute_pack pack;
+    const record_t record(0, message, pack);
+
+    const string_view messages[] = {"{}", "{}"};
+    const sink_t::event_t events[] = {{&record, &messages[0]}, {&record, &messages[1]}};
+    sink.emit_batch(events, 2);
+
+    ASSERT_TRUE(wait([&] { return sink.sent() == 2; }));
+    EXPECT_EQ(2, server.requests().size());
+}
+
+TEST(elasticsearch, RetriesOnlyRejectedItems) {
+    server_t server([](std::size_t id) {
+        return id == 0 ? bulk({201, 429, 400}) : bulk({201});
+    });
+
+    auto opts = options(server.port());
+    opts.count = 3;
+    opts.linger = std::chrono::milliseconds(10);
+
+    elasticsearch_t sink(opts);
+
+    const string_view message("");
+    const attribute_pack pack;
+    const record_t record(0, message, pack);
+
+    sink.emit(record, R"({"id":1})");
+    sink.emit(record, R"({"id":2})");
+    sink.emit(record, R"({"id":3})");
+
+    ASSERT_TRUE(wait([&] { return sink.sent() == 2; }));
+
+    const auto requests = server.requests();
+    ASSERT_EQ(2, requests.size());
+    EXPECT_EQ("{\"index\":{}}\n{\"id\":2}\n", requests[1]);
+    EXPECT_EQ(1, sink.failed());
+}
+
+TEST(elasticsearch, CountsItemsFailedAfterRetries) {
+    server_t server([](std::size_t) {
+        return bulk({503});
+    });
+
+    auto opts = options(server.port());
+    opts.linger = std::chrono::milliseconds(1);
+    opts.retries = 1;
+
+    elasticsearch_t sink(opts);
+
+    const string_view message("");
+    const attribute_pack pack;
+    const record_t record(0, message, pack);
+
+    sink.emit(record, "{}");
+
+    ASSERT_TRUE(wait([&] { return sink.failed() == 1; }));
+    EXPECT_EQ(2, server.requests().size());
+    EXPECT_EQ(0, sink.sent());
+}
+
+TEST(elasticsearch_t, FactoryType) {
+    EXPECT_EQ(std::string("elasticsearch"), factory<elasticsearch_t>(mock_registry_t()).type());
+}
+
+TEST(elasticsearch_t, Factory) {
+    using config::testing::mock::node_t;
+
+    StrictMock<node_t> config;
+
+    auto n1 = new node_t;
+    EXPECT_CALL(config, subscript_key("host"))
+        .Times(1)
+        .WillOnce(Return(n1));
+
+    EXPECT_CALL(*n1, to_string())
+        .Times(1)
+        .WillOnce(Return("127.0.0.1"));
+
+    auto n2 = new node_t;
+    EXPECT_CALL(config, subscript_key("port"))
+        .Times(1)
+        .WillOnce(Return(n2));
+
+    EXPECT_CALL(*n2, to_uint64())
+        .Times(1)
+        .WillOnce(Return(1));
+
+    auto n3 = new node_t;
+    EXPECT_CALL(config, subscript_key("index"))
+        .Times(1)
+        .WillOnce(Return(n3));
+
+    EXPECT_CALL(*n3, to_string())
+        .Times(1)
+        .WillOnce(Return("events"));
+
+    auto n4 = new node_t;
+    EXPECT_CALL(config, subscript_key("count"))
+        .Times(1)
+        .WillOnce(Return(n4));
+
+    EXPECT_CALL(*n4, to_uint64())
+        .Times(1)
+        .WillOnce(Return(500));
+
+    EXPECT_CALL(config, subscript_key("bytes"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
+    auto n5 = new node_t;
+    EXPECT_CALL(config, subscript_key("linger"))
+        .Times(1)
+        .WillOnce(Return(n5));
+
+    EXPECT_CALL(*n5, to_uint64())
+        .Times(1)
+        .WillOnce(Return(250));
+
+    auto n6 = new node_t;
+    EXPECT_CALL(config, subscript_key("connections"))
+        .Times(1)
+        .WillOnce(Return(n6));
+
+    EXPECT_CALL(*n6, to_uint64())
+        .Times(1)
+        .WillOnce(Return(4));
+
+    EXPECT_CALL(config, subscript_key("retries"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
+    EXPECT_CALL(config, subscript_key("capacity"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
+    const auto sink = factory<elasticsearch_t>(mock_registry_t()).from(config);
+    const auto& cast = dynamic_cast<const elasticsearch_t&>(*sink);
+
+    EXPECT_EQ("127.0.0.1", cast.options().host);
+    EXPECT_EQ(1, cast.options().port);
+    EXPECT_EQ("events", cast.options().index);
+    EXPECT_EQ(500, cast.options().count);
+    EXPECT_EQ(5 * 1024 * 1024, cast.options().bytes);
+    EXPECT_EQ(std::chrono::milliseconds(250), cast.options().linger);
+    EXPECT_EQ(4, cast.options().connections);
+    EXPECT_EQ(3, cast.options().retries);
+}
+
+}  // namespace
+}  // namespace sink
+}  // namespace v1
+}  // namespace blackhole
@@ -1,4 +1,13 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
 #include <system_error>
+#include <thread>
+#include <vector>
 
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
@@ -6,10 +15,13 @@
 #include <blackhole/attribute.hpp>
 #include <blackhole/record.hpp>
 #include <blackhole/sink/file.hpp>
+#include <blackhole/sink/file/merge.hpp>
 #include <blackhole/detail/sink/file.hpp>
+#include <blackhole/detail/sink/file/flusher/repeat.hpp>
 
 #include "mocks/node.hpp"
 #include "mocks/registry.hpp"
+#include "temporary.hpp"
 
 namespace blackhole {
 inline namespace v1 {
@@ -46,6 +58,135 @@ TEST(backend_t, Write) {
     EXPECT_EQ("le message\n", stream_.str());
 }
 
+TEST(backend_t, WriteBatchFlushesOnce) {
+    std::unique_ptr<std::stringstream> stream(new std::stringstream);
+    std::unique_ptr<mock::flusher_t> flusher(new mock::flusher_t);
+
+    auto& stream_ = *stream;
+
+    // The flusher is updated once with the total number of bytes of the batch.
+    EXPECT_CALL(*flusher, update(9))
+        .Times(1)
+        .WillOnce(Return(flusher_t::result_t::flush));
+
+    const string_view message("");
+    const attribute_pack pack;
+    const record_t record(0, message, pack);
+
+    const string_view messages[] = {"#1", "#2", "#3"};
+    const sink_t::event_t events[] = {
+        {&record, &messages[0]},
+        {&record, &messages[1]},
+        {&record, &messages[2]}
+    };
+
+    backend_t backend(std::move(stream), std::move(flusher));
+    backend.write(events, 3);
+
+    EXPECT_EQ("#1\n#2\n#3\n", stream_.str());
+}
+
+class counting_factory_t : public stream_factory_t {
+public:
+    std::vector<std::string>& filenames;
+
+    explicit counting_factory_t(std::vector<std::string>& filenames) :
+        filenames(filenames)
+    {}
+
+    auto create(const std::string& filename, std::ios_base::openmode) const ->
+        std::unique_ptr<std::ostream> override
+    {
+        filenames.push_back(filename);
+        return std::unique_ptr<std::ostream>(new std::stringstream);
+    }
+};
+
+auto make_file(const std::string& path, std::vector<std::string>& filenames, std::size_t files) ->
+    std::unique_ptr<file_t>
+{
+    return std::unique_ptr<file_t>(new file_t(path,
+        std::unique_ptr<stream_factory_t>(new counting_factory_t(filenames)),
+        std::unique_ptr<flusher_factory_t>(new flusher::repeat_factory_t(0)),
+        files));
+}
+
+TEST(file_t, FilenameWithoutPlaceholders) {
+    std::vector<std::string> filenames;
+    auto sink = make_file("/tmp/blackhole.log", filenames, 1);
+
+    const string_view message("");
+    const attribute_pack pack;
+    const record_t record(0, message, pack);
+
+    EXPECT_EQ("/tmp/blackhole.log", sink->filename(record));
+}
+
+TEST(file_t, FilenameFromAttributes) {
+    std::vector<std::string> filenames;
+    auto sink = make_file("/tmp/{tenant}/{severity}.log", filenames, 1);
+
+    const string_view message("");
+    const attribute_list attributes{{"tenant", {"acme"}}};
+    const attribute_pack pack{attributes};
+    const record_t record(2, message, pack);
+
+    EXPECT_EQ("/tmp/acme/2.log", sink->filename(record));
+}
+
+TEST(file_t, FilenameThrowsOnMissingAttribute) {
+    std::vector<std::string> filenames;
+    auto sink = make_file("/tmp/{tenant}.log", filenames, 1);
+
+    const string_view message("");
+    const attribute_pack pack;
+    const record_t record(0, message, pack);
+
+    EXPECT_THROW(sink->filename(record), std::logic_error);
+}
+
+TEST(file_t, EvictsLeastRecentlyUsedBackends) {
+    std::vector<std::string> filenames;
+    auto sink = make_file("/tmp/{tenant}.log", filenames, 2);
+
+    const string_view message("");
+
+    for (const std::string tenant : {"a", "b", "a", "c", "a", "b"}) {
+        const attribute_list attributes{{"tenant", {tenant}}};
+        const attribute_pack pack{attributes};
+        const record_t record(0, message, pack);
+
+        sink->emit(record, "le message");
+    }
+
+    EXPECT_EQ((std::vector<std::string>{"/tmp/a.log", "/tmp/b.log", "/tmp/c.log", "/tmp/b.log"}),
+        filenames);
+}
+
+TEST(file_t, EmitBatchGroupsRunsByFilename) {
+    std::vector<std::string> filenames;
+    auto sink = make_file("/tmp/{tenant}.log", filenames, 1);
+
+    const string_view message("");
+    const attribute_list a{{"tenant", {"a"}}};
+    const attribute_list b{{"tenant", {"b"}}};
+    const attribute_pack pa{a};
+    const attribute_pack pb{b};
+    const record_t ra(0, message, pa);
+    const record_t rb(0, message, pb);
+
+    const string_view messages[] = {"#1", "#2", "#3"};
+    const sink_t::event_t events[] = {
+        {&ra, &messages[0]},
+        {&ra, &messages[1]},
+        {&rb, &messages[2]}
+    };
+
+    sink->emit_batch(events, 3);
+
+    EXPECT_EQ((std::vector<std::string>{"/tmp/a.log", "/tmp/b.log"}), filenames);
+}
+
 TEST(builder, Build) {
     builder<file_t> builder("/tmp/blackhole.log");
 
@@ -53,6 +194,139 @@ TEST(builder, Build) {
     std::move(builder).build();
 }
 
+TEST(builder, FlushInterval) {
+    builder<file_t>("/tmp/blackhole.log")
+        .flush_every(std::chrono::milliseconds(100))
+        .build();
+
+    builder<file_t>("/tmp/blackhole.log")
+        .flush_every(megabytes_t(1), std::chrono::milliseconds(100))
+        .build();
+}
+
+TEST(builder, Gzip) {
+    builder<file_t>("/tmp/blackhole.log")
+        .gzip(9)
+        .build();
+}
+
+TEST(builder, ThrowsOnInvalidGzipLevel) {
+    builder<file_t> builder("/tmp/blackhole.log");
+
+    EXPECT_THROW(builder.gzip(0), std::invalid_argument);
+    EXPECT_THROW(builder.gzip(10), std::invalid_argument);
+}
+
+TEST(builder, ThrowsOnThreadedGzip) {
+    EXPECT_THROW(builder<file_t>("/tmp/blackhole.log").threaded().gzip().build(),
+        std::invalid_argument);
+}
+
+TEST(builder, Uring) {
+    builder<file_t>("/tmp/blackhole.log")
+        .uring()
+        .build();
+}
+
+TEST(builder, ThrowsOnThreadedUring) {
+    EXPECT_THROW(builder<file_t>("/tmp/blackhole.log").threaded().uring().build(),
+        std::invalid_argument);
+}
+
+TEST(builder, ThrowsOnPagingWithoutBuffer) {
+    detail::paging_t paging;
+    paging.populate = true;
+
+    EXPECT_THROW(builder<file_t>("/tmp/blackhole.log").memory(paging).build(),
+        std::invalid_argument);
+}
+
+TEST(builder, ThrowsOnWritebackWithoutBuffer) {
+    EXPECT_THROW(builder<file_t>("/tmp/blackhole.log").writeback(megabytes_t(8)).build(),
+        std::invalid_argument);
+}
+
+TEST(builder, Writeback) {
+    builder<file_t>("/tmp/blackhole.log")
+        .buffer(kibibytes_t(64))
+        .writeback(megabytes_t(8))
+        .build();
+}
+
+TEST(builder, ThrowsOnPreallocationWithoutBuffer) {
+    EXPECT_THROW(builder<file_t>("/tmp/blackhole.log").preallocate(megabytes_t(64)).build(),
+        std::invalid_argument);
+}
+
+TEST(builder, Preallocate) {
+    builder<file_t>("/tmp/blackhole.log")
+        .buffer(kibibytes_t(64))
+        .preallocate(megabytes_t(64))
+        .build();
+}
+
+TEST(builder, Buffer) {
+    builder<file_t> builder("/tmp/blackhole.log");
+    builder.buffer(kibibytes_t(64));
+    std::move(builder).build();
+}
+
+TEST(builder, Threaded) {
+    builder<file_t> builder("/tmp/blackhole.log");
+    builder.threaded();
+    std::move(builder).build();
+}
+
+TEST(builder, Isolated) {
+    builder<file_t> builder("/tmp/blackhole.log");
+    builder.isolated();
+    std::move(builder).build();
+}
+
+TEST(builder, ThrowsOnIsolatedThreaded) {
+    EXPECT_THROW(builder<file_t>("/tmp/blackhole.log").isolated().threaded().build(),
+        std::invalid_argument);
+}
+
+TEST(builder, Rotation) {
+    builder<file_t> builder("/tmp/blackhole.log");
+    builder.rotate_every(megabytes_t(100));
+    builder.rotate_every(std::chrono::seconds(3600));
+    builder.backups(10);
+    builder.compress();
+    std::move(builder).build();
+}
+
+TEST(builder, Durable) {
+    builder<file_t> builder("/tmp/blackhole.log");
+    builder.durable();
+    std::move(builder).build();
+}
+
+TEST(builder, ThrowsOnDurableThreaded) {
+    builder<file_t> builder("/tmp/blackhole.log");
+    builder.durable();
+    builder.threaded();
+
+    EXPECT_THROW(std::move(builder).build(), std::invalid_argument);
+}
+
+TEST(builder, Index) {
+    builder<file_t>("/tmp/blackhole.log")
+        .index(std::chrono::milliseconds(100), kibibytes_t(64))
+        .build();
+}
+
+TEST(builder, ThrowsOnIndexWithGzip) {
+    EXPECT_THROW(builder<file_t>("/tmp/blackhole.log").gzip().index().build(),
+        std::invalid_argument);
+}
+
+TEST(builder, ThrowsOnThreadedIndex) {
+    EXPECT_THROW(builder<file_t>("/tmp/blackhole.log").threaded().index().build(),
+        std::invalid_argument);
+}
+
 TEST(builder, Chained) {
     auto sink = builder<file_t>("/tmp/blackhole.log")
         .flush_every(megabytes_t(1))
@@ -92,6 +366,54 @@ TEST(factory, PatternFromConfig) {
         .Times(1)
         .WillOnce(Return(nullptr));
 
+    EXPECT_CALL(config, subscript_key("buffer"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
+    EXPECT_CALL(config, subscript_key("memory"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
+    EXPECT_CALL(config, subscript_key("writeback"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
+    EXPECT_CALL(config, subscript_key("preallocate"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
+    EXPECT_CALL(config, subscript_key("threaded"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
+    EXPECT_CALL(config, subscript_key("uring"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
+    EXPECT_CALL(config, subscript_key("durable"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
+    EXPECT_CALL(config, subscript_key("isolated"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
+    EXPECT_CALL(config, subscript_key("files"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
+    EXPECT_CALL(config, subscript_key("rotation"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
+    EXPECT_CALL(config, subscript_key("compression"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
+    EXPECT_CALL(config, subscript_key("index"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
     auto sink = factory<file_t>(mock_registry_t()).from(config);
     const auto& cast = dynamic_cast<const file_t&>(*sink);
 
@@ -129,6 +451,54 @@ TEST(factory, FlushIntervalFromConfig) {
         .Times(1)
         .WillOnce(Return(false));
 
+    EXPECT_CALL(config, subscript_key("buffer"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
+    EXPECT_CALL(config, subscript_key("memory"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
+    EXPECT_CALL(config, subscript_key("writeback"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
+    EXPECT_CALL(config, subscript_key("preallocate"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
+    EXPECT_CALL(config, subscript_key("threaded"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
+    EXPECT_CALL(config, subscript_key("uring"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
+    EXPECT_CALL(config, subscript_key("durable"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
+    EXPECT_CALL(config, subscript_key("isolated"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
+    EXPECT_CALL(config, subscript_key("files"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
+    EXPECT_CALL(config, subscript_key("rotation"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
+    EXPECT_CALL(config, subscript_key("compression"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
+    EXPECT_CALL(config, subscript_key("index"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
     factory<file_t>(mock_registry_t()).from(config);
 }
 
@@ -163,9 +533,464 @@ TEST(factory, BinaryUnitFlushIntervalFromConfig) {
         .Times(1)
         .WillOnce(Return("100MB"));
 
+    EXPECT_CALL(config, subscript_key("buffer"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
+    EXPECT_CALL(config, subscript_key("memory"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
+    EXPECT_CALL(config, subscript_key("writeback"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
+    EXPECT_CALL(config, subscript_key("preallocate"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
+    EXPECT_CALL(config, subscript_key("threaded"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
+    EXPECT_CALL(config, subscript_key("uring"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
+    EXPECT_CALL(config, subscript_key("durable"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
+    EXPECT_CALL(config, subscript_key("isolated"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
+    EXPECT_CALL(config, subscript_key("files"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
+    EXPECT_CALL(config, subscript_key("rotation"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
+    EXPECT_CALL(config, subscript_key("compression"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
+    EXPECT_CALL(config, subscript_key("index"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
     factory<file_t>(mock_registry_t()).from(config);
 }
 
+TEST(factory, TimeUnitFlushIntervalFromConfig) {
+    using config::testing::mock::node_t;
+
+    StrictMock<node_t> config;
+
+    auto npath = new StrictMock<node_t>;
+    EXPECT_CALL(config, subscript_key("path"))
+        .Times(1)
+        .WillOnce(Return(npath));
+
+    EXPECT_CALL(*npath, to_string())
+        .Times(1)
+        .WillOnce(Return("/tmp/blackhole.log"));
+
+    auto nflush = new StrictMock<node_t>;
+    EXPECT_CALL(config, subscript_key("flush"))
+        .Times(1)
+        .WillOnce(Return(nflush));
+
+    EXPECT_CALL(*nflush, is_uint64_())
+        .Times(1)
+        .WillOnce(Return(false));
+
+    EXPECT_CALL(*nflush, is_string_())
+        .Times(1)
+        .WillOnce(Return(true));
+
+    EXPECT_CALL(*nflush, to_string())
+        .Times(1)
+        .WillOnce(Return("250ms"));
+
+    EXPECT_CALL(config, subscript_key("buffer"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
+    EXPECT_CALL(config, subscript_key("memory"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
+    EXPECT_CALL(config, subscript_key("writeback"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
+    EXPECT_CALL(config, subscript_key("preallocate"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
+    EXPECT_CALL(config, subscript_key("threaded"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
+    EXPECT_CALL(config, subscript_key("uring"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
+    EXPECT_CALL(config, subscript_key("durable"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
+    EXPECT_CALL(config, subscript_key("isolated"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
+    EXPECT_CALL(config, subscript_key("files"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
+    EXPECT_CALL(config, subscript_key("rotation"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
+    EXPECT_CALL(config, subscript_key("compression"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
+    EXPECT_CALL(config, subscript_key("index"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
+    factory<file_t>(mock_registry_t()).from(config);
+}
+
+TEST(factory, BufferFromConfig) {
+    using config::testing::mock::node_t;
+
+    StrictMock<node_t> config;
+
+    auto npath = new StrictMock<node_t>;
+    EXPECT_CALL(config, subscript_key("path"))
+        .Times(1)
+        .WillOnce(Return(npath));
+
+    EXPECT_CALL(*npath, to_string())
+        .Times(1)
+        .WillOnce(Return("/tmp/blackhole.log"));
+
+    EXPECT_CALL(config, subscript_key("flush"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
+    auto nbuffer = new StrictMock<node_t>;
+    EXPECT_CALL(config, subscript_key("buffer"))
+        .Times(1)
+        .WillOnce(Return(nbuffer));
+
+    EXPECT_CALL(*nbuffer, is_uint64_())
+        .Times(1)
+        .WillOnce(Return(false));
+
+    EXPECT_CALL(*nbuffer, is_string_())
+        .Times(1)
+        .WillOnce(Return(true));
+
+    EXPECT_CALL(*nbuffer, to_string())
+        .Times(1)
+        .WillOnce(Return("64KiB"));
+
+    EXPECT_CALL(config, subscript_key("memory"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
+    EXPECT_CALL(config, subscript_key("writeback"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
+    EXPECT_CALL(config, subscript_key("preallocate"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
+    EXPECT_CALL(config, subscript_key("threaded"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
+    EXPECT_CALL(config, subscript_key("uring"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
+    EXPECT_CALL(config, subscript_key("durable"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
+    EXPECT_CALL(config, subscript_key("isolated"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
+    EXPECT_CALL(config, subscript_key("files"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
+    EXPECT_CALL(config, subscript_key("rotation"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
+    EXPECT_CALL(config, subscript_key("compression"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
+    EXPECT_CALL(config, subscript_key("index"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
+    factory<file_t>(mock_registry_t()).from(config);
+}
+
+TEST(factory, CompressionFromConfig) {
+    using config::testing::mock::node_t;
+
+    StrictMock<node_t> config;
+
+    auto npath = new StrictMock<node_t>;
+    EXPECT_CALL(config, subscript_key("path"))
+        .Times(1)
+        .WillOnce(Return(npath));
+
+    EXPECT_CALL(*npath, to_string())
+        .Times(1)
+        .WillOnce(Return("/tmp/blackhole.log.gz"));
+
+    const auto keys = {"flush", "buffer", "memory", "writeback", "preallocate", "threaded",
+        "uring", "durable", "isolated", "files", "rotation"};
+    for (const auto& key : keys) {
+        EXPECT_CALL(config, subscript_key(key))
+            .Times(1)
+            .WillOnce(Return(nullptr));
+    }
+
+    auto ncompression = new StrictMock<node_t>;
+    EXPECT_CALL(config, subscript_key("compression"))
+        .Times(1)
+        .WillOnce(Return(ncompression));
+
+    EXPECT_CALL(*ncompression, is_string_())
+        .Times(1)
+        .WillOnce(Return(true));
+
+    EXPECT_CALL(*ncompression, to_string())
+        .Times(1)
+        .WillOnce(Return("gzip"));
+
+    EXPECT_CALL(config, subscript_key("index"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
+    factory<file_t>(mock_registry_t()).from(config);
+}
+
+TEST(file_t, LendsNothingWithoutDescriptorBuffer) {
+    std::vector<std::string> filenames;
+    auto sink = make_file("/tmp/blackhole.log", filenames, 1);
+
+    const string_view message("");
+    const attribute_pack pack;
+    const record_t record(0, message, pack);
+
+    EXPECT_EQ(nullptr, sink->lend(record, 16).data);
+
+    // The sink must not be left locked.
+    sink->emit(record, "le message");
+}
+
+TEST(file_t, CommitsLentRegion) {
+    const blackhole::testing::temporary_file_t temporary{"lend"};
+    const auto& path = temporary.path();
+
+    const string_view message("");
+    const attribute_pack pack;
+    const record_t record(0, message, pack);
+
+    {
+        file_t sink(path,
+            std::unique_ptr<stream_factory_t>(new fdstream_factory_t(4096)),
+            std::unique_ptr<flusher_factory_t>(new flusher::repeat_factory_t(0)));
+
+        sink.emit(record, "#1");
+
+        const auto region = sink.lend(record, 16);
+        ASSERT_NE(nullptr, region.data);
+        EXPECT_LE(16, region.size);
+
+        std::memcpy(region.data, "#2", 2);
+        sink.commit(record, 2);
+
+        EXPECT_EQ(nullptr, sink.lend(record, 1024 * 1024).data);
+        sink.emit(record, "#3");
+    }
+
+    std::ifstream stream(path);
+    const std::string content{std::istreambuf_iterator<char>(stream),
+        std::istreambuf_iterator<char>()};
+
+    EXPECT_EQ("#1\n#2\n#3\n", content);
+}
+
+TEST(file_t, WritesGatheredSlices) {
+    const blackhole::testing::temporary_file_t temporary{"gather"};
+    const auto& path = temporary.path();
+
+    const string_view message("");
+    const attribute_pack pack;
+    const record_t record(0, message, pack);
+
+    const std::string large(8192, 'x');
+    const string_view slices[] = {"#2 ", large, " #2"};
+
+    {
+        file_t sink(path,
+            std::unique_ptr<stream_factory_t>(new fdstream_factory_t(4096)),
+            std::unique_ptr<flusher_factory_t>(new flusher::repeat_factory_t(0)));
+
+        sink.emit(record, "#1");
+        sink.emit_gathered(record, slices, 3);
+        sink.emit(record, "#3");
+    }
+
+    std::ifstream stream(path);
+    const std::string content{std::istreambuf_iterator<char>(stream),
+        std::istreambuf_iterator<char>()};
+
+    EXPECT_EQ("#1\n#2 " + large + " #2\n#3\n", content);
+}
+
+TEST(file_t, IndexesWrittenLines) {
+    const blackhole::testing::temporary_file_t temporary{"index"};
+    const auto& path = temporary.path();
+
+    const string_view message("");
+    const attribute_pack pack;
+    record_t record(0, message, pack);
+
+    const auto timestamp = record_t::time_point(std::chrono::seconds(1000));
+
+    indexing_t indexing;
+    indexing.interval = std::chrono::seconds(1);
+
+    {
+        file_t sink(path,
+            std::unique_ptr<stream_factory_t>(new fdstream_factory_t(4096)),
+            std::unique_ptr<flusher_factory_t>(new flusher::repeat_factory_t(1)),
+            1, rotation_t(), indexing);
+
+        record.activate("#1", timestamp);
+        sink.emit(record, "#1");
+
+        record.activate("#2", timestamp + std::chrono::milliseconds(500));
+        sink.emit(record, "#2");
+
+        const string_view messages[] = {"#3", "#4"};
+        const record_t::time_point timestamps[] = {
+            timestamp + std::chrono::seconds(2),
+            timestamp + std::chrono::seconds(3)
+        };
+
+        record_t records[] = {record, record};
+        records[0].activate(messages[0], timestamps[0]);
+        records[1].activate(messages[1], timestamps[1]);
+
+        const sink_t::event_t events[] = {
+            {&records[0], &messages[0]},
+            {&records[1], &messages[1]}
+        };
+
+        sink.emit_batch(events, 2);
+    }
+
+    const auto entries = index_t::read(path);
+    std::remove(index_t::path(path).c_str());
+
+    ASSERT_EQ(3, entries.size());
+    EXPECT_EQ(0, entries[0].offset);
+    EXPECT_EQ(6, entries[1].offset);
+    EXPECT_EQ(9, entries[2].offset);
+}
+
+TEST(file_t, IsolatesFilenames) {
+    const auto isolate = [](const string_view& filename) -> std::string {
+        writer_t writer;
+        return file::isolate(filename, 42, writer).to_string();
+    };
+
+    EXPECT_EQ("app.42.log", isolate("app.log"));
+    EXPECT_EQ("/var/log/app.42.log", isolate("/var/log/app.log"));
+    EXPECT_EQ("app.log.42.gz", isolate("app.log.gz"));
+    EXPECT_EQ("/var/log.d/app.42", isolate("/var/log.d/app"));
+    EXPECT_EQ("/tmp/.app.42", isolate("/tmp/.app"));
+}
+
+TEST(file_t, WritesPerThreadFiles) {
+    const blackhole::testing::temporary_directory_t directory{"isolated"};
+    const auto path = directory.path() + "/app.log";
+
+    const string_view message("");
+    const attribute_pack pack;
+    const record_t record(0, message, pack);
+
+    {
+        file_t sink(path, isolated_t(),
+            std::unique_ptr<stream_factory_t>(new fdstream_factory_t(4096)),
+            std::unique_ptr<flusher_factory_t>(new flusher::repeat_factory_t(0)));
+
+        sink.emit(record, "2016-07-18 15:30:00 #1");
+        sink.emit(record, "2016-07-18 15:30:02 #3");
+
+        std::thread([&] {
+            sink.emit(record, "2016-07-18 15:30:01 #2");
+
+            const auto region = sink.lend(record, 32);
+            ASSERT_NE(nullptr, region.data);
+            std::memcpy(region.data, "2016-07-18 15:30:03 #4", 22);
+            sink.commit(record, 22);
+        }).join();
+    }
+
+    const auto files = isolated(path);
+    ASSERT_EQ(2, files.size());
+
+    std::ostringstream stream;
+    EXPECT_EQ(4, merge(files, stream));
+
+    EXPECT_EQ("2016-07-18 15:30:00 #1\n2016-07-18 15:30:01 #2\n2016-07-18 15:30:02 #3\n"
+              "2016-07-18 15:30:03 #4\n", stream.str());
+}
+
+TEST(merge, KeepsOrderOfEachFile) {
+    const blackhole::testing::temporary_file_t lhs{"merge"};
+    const blackhole::testing::temporary_file_t rhs{"merge"};
+
+    std::ofstream(lhs.path()) << "a 1\nb 3\nc 3\n";
+    std::ofstream(rhs.path()) << "d 2\ne 3\nf 0\n";
+
+    // Keys follow the first space, so lines with equal keys go in the order of files.
+    const auto key = [](const string_view& line) -> string_view {
+        const auto space = std::find(line.data(), line.data() + line.size(), ' ');
+        return line.substr(static_cast<std::size_t>(space - line.data()) + 1);
+    };
+
+    std::ostringstream stream;
+    const auto count = merge({lhs.path(), rhs.path()}, stream, key);
+
+    EXPECT_EQ(6, count);
+    EXPECT_EQ("a 1\nd 2\nb 3\nc 3\ne 3\nf 0\n", stream.str());
+}
+
+TEST(merge, ThrowsOnMissingFile) {
+    std::ostringstream stream;
+    EXPECT_THROW(merge({"/tmp/blackhole-merge-missing"}, stream), std::system_error);
+}
+
 }  // namespace
 }  // namespace file
 }  // namespace sink
@@ -0,0 +1,112 @@
+#include <fstream>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <unistd.h>
+
+#include <blackhole/attribute.hpp>
+#include <blackhole/record.hpp>
+#include <blackhole/detail/sink/file.hpp>
+#include <blackhole/detail/sink/file/committer.hpp>
+
+#include "temporary.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+namespace file {
+namespace {
+
+auto read(const std::string& filename) -> std::vector<std::string> {
+    std::ifstream stream(filename);
+    std::vector<std::string> lines;
+
+    for (std::string line; std::getline(stream, line);) {
+        lines.push_back(line);
+    }
+
+    return lines;
+}
+
+class committer : public ::testing::Test {
+protected:
+    const blackhole::testing::temporary_file_t temporary{"committer"};
+    const std::string filename{temporary.path()};
+
+};
+
+TEST_F(committer, WritesBeforeReturning) {
+    committer_t committer(filename);
+    committer.write("le message");
+
+    EXPECT_EQ(std::vector<std::string>{"le message"}, read(filename));
+}
+
+TEST_F(committer, WritesBatch) {
+    const string_view message("");
+    const attribute_pack pack;
+    const record_t record(0, message, pack);
+
+    const string_view messages[] = {"#1", "#2"};
+    const sink_t::event_t events[] = {
+        {&record, &messages[0]},
+        {&record, &messages[1]}
+    };
+
+    committer_t committer(filename);
+    committer.write(events, 2);
+
+    EXPECT_EQ((std::vector<std::string>{"#1", "#2"}), read(filename));
+}
+
+TEST_F(committer, ConcurrentWriters) {
+    const std::size_t threads = 16;
+    const std::size_t lines = 100;
+
+    committer_t committer(filename);
+
+    std::vector<std::thread> workers;
+    for (std::size_t id = 0; id < threads; ++id) {
+        workers.emplace_back([&, id] {
+            for (std::size_t line = 0; line < lines; ++line) {
+                committer.write(std::to_string(id) + ":" + std::to_string(line));
+            }
+        });
+    }
+
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    EXPECT_EQ(threads * lines, read(filename).size());
+}
+
+TEST(committer_t, ThrowsOnWriteFailure) {
+    if (::access("/dev/full", W_OK) != 0) {
+        return;
+    }
+
+    committer_t committer("/dev/full");
+    EXPECT_THROW(committer.write("le message"), std::system_error);
+}
+
+TEST_F(committer, DurableFile) {
+    const string_view message("");
+    const attribute_pack pack;
+    const record_t record(0, message, pack);
+
+    file_t sink(filename, durable_t());
+    sink.emit(record, "le message");
+
+    EXPECT_EQ(std::vector<std::string>{"le message"}, read(filename));
+}
+
+}  // namespace
+}  // namespace file
+}  // namespace sink
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,134 @@
+#include <fstream>
+#include <iterator>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include <zlib.h>
+
+#include <blackhole/detail/sink/file/deflate.hpp>
+
+#include "temporary.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+namespace file {
+namespace {
+
+auto read(const std::string& filename) -> std::string {
+    std::ifstream stream(filename, std::ios::binary);
+    return {std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>()};
+}
+
+/// Decompresses as much as possible of the given possibly incomplete sequence of gzip members.
+auto inflate(const std::string& data) -> std::string {
+    z_stream stream{};
+    EXPECT_EQ(Z_OK, ::inflateInit2(&stream, 15 + 16));
+
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+    stream.avail_in = static_cast<uInt>(data.size());
+
+    std::string result;
+    char buffer[4096];
+
+    while (stream.avail_in > 0) {
+        stream.next_out = reinterpret_cast<Bytef*>(buffer);
+        stream.avail_out = sizeof(buffer);
+
+        const auto rc = ::inflate(&stream, Z_NO_FLUSH);
+        result.append(buffer, sizeof(buffer) - stream.avail_out);
+
+        if (rc == Z_STREAM_END) {
+            ::inflateReset(&stream);
+        } else if (rc != Z_OK) {
+            break;
+        }
+    }
+
+    ::inflateEnd(&stream);
+    return result;
+}
+
+class deflate : public ::testing::Test {
+protected:
+    const blackhole::testing::temporary_file_t temporary{"deflate"};
+    const std::string filename{temporary.path()};
+
+    auto create(std::ios_base::openmode mode = std::ios_base::out | std::ios_base::app) const ->
+        std::unique_ptr<std::ostream>
+    {
+        deflate_factory_t factory(std::unique_ptr<stream_factory_t>(new ofstream_factory_t), 6);
+        return factory.create(filename, mode);
+    }
+};
+
+TEST_F(deflate, CompressesOnDestruction) {
+    {
+        auto stream = create();
+        *stream << "first line\n" << "second line\n";
+    }
+
+    EXPECT_EQ("first line\nsecond line\n", inflate(read(filename)));
+}
+
+TEST_F(deflate, FlushCompletesBlock) {
+    auto stream = create();
+    *stream << "first line\n";
+    stream->flush();
+
+    // The gzip member is not finished yet, but flushed data is already decompressible.
+    EXPECT_EQ("first line\n", inflate(read(filename)));
+
+    *stream << "second line\n";
+    stream->flush();
+
+    EXPECT_EQ("first line\nsecond line\n", inflate(read(filename)));
+}
+
+TEST_F(deflate, FlushWithoutDataWritesNothing) {
+    auto stream = create();
+    *stream << "line\n";
+    stream->flush();
+
+    const auto size = read(filename).size();
+    stream->flush();
+
+    EXPECT_EQ(size, read(filename).size());
+}
+
+TEST_F(deflate, AppendStartsNewMember) {
+    create()->write("first\n", 6);
+    create()->write("second\n", 7);
+
+    EXPECT_EQ("first\nsecond\n", inflate(read(filename)));
+}
+
+TEST_F(deflate, LargeWrites) {
+    std::string expected;
+    for (int id = 0; id < 100000; ++id) {
+        expected += "line #" + std::to_string(id) + "\n";
+    }
+
+    {
+        auto stream = create();
+        stream->write(expected.data(), static_cast<std::streamsize>(expected.size()));
+    }
+
+    const auto compressed = read(filename);
+
+    EXPECT_LT(compressed.size(), expected.size() / 4);
+    EXPECT_EQ(expected, inflate(compressed));
+}
+
+TEST_F(deflate, ThrowsOnInvalidLevel) {
+    deflate_factory_t factory(std::unique_ptr<stream_factory_t>(new ofstream_factory_t), 10);
+
+    EXPECT_THROW(factory.create(filename, std::ios_base::out), std::invalid_argument);
+}
+
+}  // namespace
+}  // namespace file
+}  // namespace sink
+}  // namespace v1
+}  // namespace blackhole
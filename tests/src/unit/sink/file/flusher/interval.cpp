@@ -0,0 +1,149 @@
+#include <condition_variable>
+#include <mutex>
+
+#include <gtest/gtest.h>
+
+#include <blackhole/detail/sink/file/flusher/interval.hpp>
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+namespace file {
+namespace flusher {
+namespace {
+
+TEST(interval_t, Default) {
+    std::uint64_t now = 0;
+    interval_t flusher(100, [&] { return now; });
+
+    EXPECT_EQ(100, flusher.threshold());
+    EXPECT_EQ(0, flusher.count());
+}
+
+TEST(interval_t, Zero) {
+    interval_t flusher(0, [] { return std::uint64_t(0); });
+
+    EXPECT_EQ(std::numeric_limits<std::uint64_t>::max(), flusher.threshold());
+}
+
+TEST(interval_t, Update) {
+    std::uint64_t now = 0;
+    interval_t flusher(100, [&] { return now; });
+
+    EXPECT_EQ(flusher_t::idle, flusher.update(10));
+    now = 99;
+    EXPECT_EQ(flusher_t::idle, flusher.update(10));
+    EXPECT_EQ(20, flusher.count());
+
+    now = 100;
+    EXPECT_EQ(flusher_t::flush, flusher.update(10));
+    EXPECT_EQ(0, flusher.count());
+
+    now = 150;
+    EXPECT_EQ(flusher_t::idle, flusher.update(10));
+}
+
+TEST(interval_t, PollFlushesPendingData) {
+    std::uint64_t now = 0;
+    interval_t flusher(100, [&] { return now; });
+
+    flusher.update(10);
+
+    now = 50;
+    EXPECT_EQ(flusher_t::idle, flusher.poll());
+
+    now = 120;
+    EXPECT_EQ(flusher_t::flush, flusher.poll());
+    EXPECT_EQ(0, flusher.count());
+}
+
+TEST(interval_t, PollIgnoresEmptyBuffers) {
+    std::uint64_t now = 0;
+    interval_t flusher(100, [&] { return now; });
+
+    now = 1000;
+    EXPECT_EQ(flusher_t::idle, flusher.poll());
+}
+
+TEST(interval_t, Reset) {
+    std::uint64_t now = 0;
+    interval_t flusher(100, [&] { return now; });
+
+    flusher.update(10);
+    now = 90;
+    flusher.reset();
+
+    now = 150;
+    flusher.update(10);
+    EXPECT_EQ(flusher_t::idle, flusher.poll());
+
+    now = 190;
+    EXPECT_EQ(flusher_t::flush, flusher.poll());
+}
+
+TEST(combined_t, FlushesByBytes) {
+    std::uint64_t now = 0;
+    combined_t flusher(bytecount_t(1024), interval_t(100, [&] { return now; }));
+
+    EXPECT_EQ(flusher_t::idle, flusher.update(1000));
+    EXPECT_EQ(flusher_t::flush, flusher.update(24));
+    EXPECT_EQ(flusher_t::idle, flusher.update(10));
+}
+
+TEST(combined_t, FlushesByTime) {
+    std::uint64_t now = 0;
+    combined_t flusher(bytecount_t(1024), interval_t(100, [&] { return now; }));
+
+    EXPECT_EQ(flusher_t::idle, flusher.update(10));
+
+    now = 100;
+    EXPECT_EQ(flusher_t::flush, flusher.poll());
+
+    // Bytes counter is reset together with the time.
+    EXPECT_EQ(flusher_t::idle, flusher.update(1020));
+}
+
+TEST(parse_tunit, Units) {
+    EXPECT_EQ(std::chrono::milliseconds(100), parse_tunit("100"));
+    EXPECT_EQ(std::chrono::milliseconds(100), parse_tunit("100ms"));
+    EXPECT_EQ(std::chrono::milliseconds(5000), parse_tunit("5s"));
+    EXPECT_EQ(std::chrono::milliseconds(120000), parse_tunit("2min"));
+}
+
+TEST(parse_tunit, ThrowsOnUnknownUnit) {
+    EXPECT_THROW(parse_tunit("100h"), std::invalid_argument);
+}
+
+TEST(timer_t, Shared) {
+    const auto timer = timer_t::instance();
+
+    EXPECT_EQ(timer, timer_t::instance());
+}
+
+TEST(timer_t, InvokesSubscribers) {
+    const auto timer = timer_t::instance();
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    int calls = 0;
+
+    const auto id = timer->subscribe([&] {
+        std::lock_guard<std::mutex> lock(mutex);
+        ++calls;
+        cv.notify_one();
+    });
+
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        EXPECT_TRUE(cv.wait_for(lock, std::chrono::seconds(5), [&] { return calls >= 2; }));
+    }
+
+    timer->unsubscribe(id);
+}
+
+}  // namespace
+}  // namespace flusher
+}  // namespace file
+}  // namespace sink
+}  // namespace v1
+}  // namespace blackhole
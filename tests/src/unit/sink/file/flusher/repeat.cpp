@@ -57,6 +57,19 @@ TEST(repeat_t, Reset) {
     EXPECT_EQ(0, flusher.count());
 }
 
+TEST(repeat_t, Batch) {
+    repeat_t flusher(3);
+
+    EXPECT_EQ(flusher_t::idle, flusher.batch(2, 20));
+    EXPECT_EQ(2, flusher.count());
+
+    EXPECT_EQ(flusher_t::flush, flusher.batch(2, 20));
+    EXPECT_EQ(1, flusher.count());
+
+    EXPECT_EQ(flusher_t::flush, flusher.batch(7, 70));
+    EXPECT_EQ(2, flusher.count());
+}
+
 TEST(repeat_t, ZeroWrite) {
     repeat_t flusher(3);
 
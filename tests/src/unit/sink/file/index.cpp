@@ -0,0 +1,236 @@
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <blackhole/detail/sink/file/index.hpp>
+
+#include "temporary.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+namespace file {
+namespace {
+
+typedef index_t::time_point time_point;
+
+auto at(int seconds, int milliseconds = 0) -> time_point {
+    return time_point(std::chrono::seconds(seconds) + std::chrono::milliseconds(milliseconds));
+}
+
+auto offsets(const std::vector<index_t::entry_t>& entries) -> std::vector<std::uint64_t> {
+    std::vector<std::uint64_t> result;
+    for (const auto& entry : entries) {
+        result.push_back(entry.offset);
+    }
+
+    return result;
+}
+
+class index : public ::testing::Test {
+protected:
+    const blackhole::testing::temporary_file_t temporary{"index"};
+    const std::string filename{temporary.path()};
+    indexing_t policy;
+
+    auto SetUp() -> void override {
+        policy.interval = std::chrono::seconds(1);
+    }
+
+    auto TearDown() -> void override {
+        std::remove(index_t::path(filename).c_str());
+    }
+
+    /// Appends the given number of bytes to the file, accounting them in the index.
+    auto write(index_t& index, time_point timestamp, std::size_t size) -> void {
+        index.update(timestamp);
+
+        std::ofstream stream(filename, std::ios_base::app);
+        stream << std::string(size, 'x');
+        index.advance(size);
+    }
+};
+
+TEST_F(index, Path) {
+    EXPECT_EQ("/var/log/app.log.idx", index_t::path("/var/log/app.log"));
+}
+
+TEST_F(index, IndexesByInterval) {
+    {
+        index_t index(filename, policy);
+        write(index, at(10), 10);
+        write(index, at(10, 999), 10);
+        write(index, at(11), 10);
+        write(index, at(11, 500), 10);
+        write(index, at(15), 10);
+    }
+
+    const auto entries = index_t::read(filename);
+
+    EXPECT_EQ((std::vector<std::uint64_t>{0, 20, 40}), offsets(entries));
+    EXPECT_EQ(std::chrono::nanoseconds(std::chrono::seconds(11)).count(), entries[1].timestamp);
+}
+
+TEST_F(index, IndexesBySize) {
+    policy.interval = std::chrono::milliseconds(0);
+    policy.size = 25;
+
+    {
+        index_t index(filename, policy);
+        for (int id = 0; id < 6; ++id) {
+            write(index, at(10), 10);
+        }
+    }
+
+    EXPECT_EQ((std::vector<std::uint64_t>{0, 30}), offsets(index_t::read(filename)));
+}
+
+TEST_F(index, KeepsTimestampsNonDecreasing) {
+    policy.size = 10;
+
+    {
+        index_t index(filename, policy);
+        write(index, at(10), 10);
+        write(index, at(5), 10);
+    }
+
+    const auto entries = index_t::read(filename);
+
+    ASSERT_EQ(2, entries.size());
+    EXPECT_EQ(entries[0].timestamp, entries[1].timestamp);
+}
+
+TEST_F(index, WritesOnFlushOnly) {
+    index_t index(filename, policy);
+    write(index, at(10), 10);
+
+    EXPECT_TRUE(index_t::read(filename).empty());
+
+    index.flush();
+    EXPECT_EQ(1, index_t::read(filename).size());
+}
+
+TEST_F(index, ContinuesAfterReopening) {
+    {
+        index_t index(filename, policy);
+        write(index, at(10), 10);
+    }
+
+    {
+        index_t index(filename, policy);
+        EXPECT_EQ(10, index.position());
+
+        // Still within the interval of the last entry.
+        write(index, at(10, 500), 10);
+        write(index, at(11), 10);
+    }
+
+    EXPECT_EQ((std::vector<std::uint64_t>{0, 20}), offsets(index_t::read(filename)));
+}
+
+TEST_F(index, DropsTruncatedEntry) {
+    {
+        index_t index(filename, policy);
+        write(index, at(10), 10);
+    }
+
+    {
+        std::ofstream stream(index_t::path(filename), std::ios_base::app);
+        stream << "torn";
+    }
+
+    {
+        index_t index(filename, policy);
+        write(index, at(11), 10);
+    }
+
+    EXPECT_EQ((std::vector<std::uint64_t>{0, 10}), offsets(index_t::read(filename)));
+}
+
+TEST_F(index, RestartsWhenFileReplaced) {
+    {
+        index_t index(filename, policy);
+        write(index, at(10), 10);
+        write(index, at(11), 10);
+    }
+
+    // Leaves the file shorter than the last entry offset.
+    std::ofstream(filename, std::ios_base::trunc);
+
+    {
+        index_t index(filename, policy);
+        write(index, at(12), 10);
+    }
+
+    EXPECT_EQ((std::vector<std::uint64_t>{0}), offsets(index_t::read(filename)));
+}
+
+TEST_F(index, Reset) {
+    index_t index(filename, policy);
+    write(index, at(10), 10);
+    index.flush();
+
+    index.reset();
+    EXPECT_EQ(0, index.position());
+    EXPECT_TRUE(index_t::read(filename).empty());
+
+    index.update(at(10));
+    index.flush();
+    EXPECT_EQ(1, index_t::read(filename).size());
+}
+
+TEST_F(index, ThrowsOnMalformedHeader) {
+    {
+        std::ofstream stream(index_t::path(filename));
+        stream << "malformed index";
+    }
+
+    EXPECT_THROW(index_t::read(filename), std::runtime_error);
+}
+
+TEST_F(index, ThrowsOnMissingIndex) {
+    EXPECT_THROW(index_t::read(filename), std::system_error);
+}
+
+TEST(index_t, Begin) {
+    const std::int64_t second = 1000000000;
+    const std::vector<index_t::entry_t> entries{
+        {10 * second, 0},
+        {11 * second, 100},
+        {12 * second, 200}
+    };
+
+    EXPECT_EQ(0, index_t::begin(entries, at(5)));
+    EXPECT_EQ(0, index_t::begin(entries, at(10)));
+    EXPECT_EQ(0, index_t::begin(entries, at(10, 500)));
+    EXPECT_EQ(100, index_t::begin(entries, at(12)));
+    EXPECT_EQ(200, index_t::begin(entries, at(20)));
+    EXPECT_EQ(0, index_t::begin({}, at(20)));
+}
+
+TEST(index_t, End) {
+    const std::int64_t second = 1000000000;
+    const std::vector<index_t::entry_t> entries{
+        {10 * second, 0},
+        {11 * second, 100},
+        {12 * second, 200}
+    };
+
+    EXPECT_EQ(0, index_t::end(entries, at(5)));
+    EXPECT_EQ(100, index_t::end(entries, at(10)));
+    EXPECT_EQ(200, index_t::end(entries, at(11, 500)));
+    EXPECT_EQ(std::numeric_limits<std::uint64_t>::max(), index_t::end(entries, at(12)));
+}
+
+}  // namespace
+}  // namespace file
+}  // namespace sink
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,149 @@
+#include <fstream>
+#include <set>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <blackhole/detail/sink/file/flusher/repeat.hpp>
+#include <blackhole/detail/sink/file/local.hpp>
+
+#include "temporary.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+namespace file {
+namespace {
+
+auto read(const std::string& filename) -> std::vector<std::string> {
+    std::ifstream stream(filename);
+    std::vector<std::string> lines;
+
+    for (std::string line; std::getline(stream, line);) {
+        lines.push_back(line);
+    }
+
+    return lines;
+}
+
+class locals : public ::testing::Test {
+protected:
+    const blackhole::testing::temporary_file_t temporary{"locals"};
+    const std::string filename{temporary.path()};
+
+    auto make(std::size_t capacity, std::size_t events = 0) -> std::unique_ptr<locals_t> {
+        return std::unique_ptr<locals_t>(new locals_t(capacity,
+            std::unique_ptr<flusher_factory_t>(new flusher::repeat_factory_t(events))));
+    }
+};
+
+TEST(descriptor_t, ThrowsIfUnableToOpen) {
+    EXPECT_THROW(descriptor_t("/__mythic/file.log"), std::system_error);
+}
+
+TEST_F(locals, BuffersUntilCommit) {
+    auto locals = make(4096);
+    locals->local().write(*locals, filename, "le message");
+
+    EXPECT_TRUE(read(filename).empty());
+
+    locals->commit();
+
+    EXPECT_EQ(std::vector<std::string>{"le message"}, read(filename));
+}
+
+TEST_F(locals, CommitsAtDestruction) {
+    auto locals = make(4096);
+    locals->local().write(*locals, filename, "#1");
+    locals->local().write(*locals, filename, "#2");
+    locals.reset();
+
+    EXPECT_EQ((std::vector<std::string>{"#1", "#2"}), read(filename));
+}
+
+TEST_F(locals, CommitsWhenFlusherFires) {
+    auto locals = make(4096, 2);
+    locals->local().write(*locals, filename, "#1");
+
+    EXPECT_TRUE(read(filename).empty());
+
+    locals->local().write(*locals, filename, "#2");
+
+    EXPECT_EQ((std::vector<std::string>{"#1", "#2"}), read(filename));
+}
+
+TEST_F(locals, WritesLargeMessagesDirectly) {
+    auto locals = make(16);
+    const std::string large(64, 'x');
+
+    locals->local().write(*locals, filename, "#1");
+    locals->local().write(*locals, filename, large);
+
+    EXPECT_EQ((std::vector<std::string>{"#1", large}), read(filename));
+}
+
+TEST_F(locals, SameBufferForSameThread) {
+    auto locals = make(4096);
+
+    EXPECT_EQ(&locals->local(), &locals->local());
+}
+
+TEST_F(locals, CommitsBuffersOfExitedThreads) {
+    auto locals = make(4096);
+
+    std::thread([&] {
+        locals->local().write(*locals, filename, "le message");
+    }).join();
+
+    locals->commit();
+
+    EXPECT_EQ(std::vector<std::string>{"le message"}, read(filename));
+}
+
+TEST_F(locals, KeepsLinesIntactFromConcurrentThreads) {
+    const std::size_t threads = 16;
+    const std::size_t lines = 1000;
+
+    auto locals = make(1024);
+
+    std::vector<std::thread> workers;
+    for (std::size_t id = 0; id < threads; ++id) {
+        workers.emplace_back([&, id] {
+            for (std::size_t line = 0; line < lines; ++line) {
+                const auto message = std::to_string(id) + ":" + std::to_string(line) + ":" +
+                    std::string(line % 64, '#');
+                locals->local().write(*locals, filename, message);
+            }
+        });
+    }
+
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    locals.reset();
+
+    const auto result = read(filename);
+    ASSERT_EQ(threads * lines, result.size());
+
+    std::set<std::string> unique(result.begin(), result.end());
+    EXPECT_EQ(threads * lines, unique.size());
+
+    for (const auto& line : result) {
+        const auto first = line.find(':');
+        const auto second = line.find(':', first + 1);
+        ASSERT_NE(std::string::npos, second);
+
+        const auto number = std::stoul(line.substr(first + 1, second - first - 1));
+        EXPECT_EQ(number % 64, line.size() - second - 1);
+    }
+}
+
+}  // namespace
+}  // namespace file
+}  // namespace sink
+}  // namespace v1
+}  // namespace blackhole
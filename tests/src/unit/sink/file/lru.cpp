@@ -0,0 +1,81 @@
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include <blackhole/detail/sink/file/lru.hpp>
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+namespace file {
+namespace {
+
+TEST(lru_t, CreatesOnMiss) {
+    lru_t<std::string> lru(2);
+
+    EXPECT_EQ("a!", lru.get("a", [](const string_view& name) {
+        return name.to_string() + "!";
+    }));
+
+    EXPECT_EQ(1, lru.size());
+    EXPECT_TRUE(lru.contains("a"));
+}
+
+TEST(lru_t, ReturnsExistingOnHit) {
+    lru_t<int> lru(2);
+
+    int calls = 0;
+    const auto factory = [&](const string_view&) {
+        return ++calls;
+    };
+
+    EXPECT_EQ(1, lru.get("a", factory));
+    EXPECT_EQ(1, lru.get("a", factory));
+    EXPECT_EQ(1, calls);
+}
+
+TEST(lru_t, EvictsLeastRecentlyUsed) {
+    lru_t<int> lru(2);
+
+    const auto factory = [](const string_view&) {
+        return 0;
+    };
+
+    lru.get("a", factory);
+    lru.get("b", factory);
+    lru.get("a", factory);
+    lru.get("c", factory);
+
+    EXPECT_EQ(2, lru.size());
+    EXPECT_TRUE(lru.contains("a"));
+    EXPECT_FALSE(lru.contains("b"));
+    EXPECT_TRUE(lru.contains("c"));
+}
+
+TEST(lru_t, ZeroCapacityKeepsOneEntry) {
+    lru_t<int> lru(0);
+
+    EXPECT_EQ(1, lru.capacity());
+}
+
+TEST(lru_t, FailedFactoryKeepsEntries) {
+    lru_t<std::unique_ptr<int>> lru(1);
+
+    lru.get("a", [](const string_view&) {
+        return std::unique_ptr<int>(new int(42));
+    });
+
+    EXPECT_THROW(lru.get("b", [](const string_view&) -> std::unique_ptr<int> {
+        throw std::runtime_error("failed");
+    }), std::runtime_error);
+
+    EXPECT_TRUE(lru.contains("a"));
+}
+
+}  // namespace
+}  // namespace file
+}  // namespace sink
+}  // namespace v1
+}  // namespace blackhole
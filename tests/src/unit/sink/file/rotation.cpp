@@ -0,0 +1,306 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <zlib.h>
+
+#include <blackhole/attribute.hpp>
+#include <blackhole/record.hpp>
+#include <blackhole/detail/sink/file.hpp>
+#include <blackhole/detail/sink/file/flusher/repeat.hpp>
+#include <blackhole/detail/sink/file/rotation.hpp>
+
+#include "temporary.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+namespace file {
+namespace {
+
+auto read(const std::string& filename) -> std::string {
+    std::ifstream stream(filename);
+    return {std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>()};
+}
+
+auto write(const std::string& filename, const std::string& content) -> void {
+    std::ofstream stream(filename);
+    stream << content;
+}
+
+/// Creates file streams, blocking each creation after the first one until opened.
+class gated_factory_t : public stream_factory_t {
+public:
+    mutable std::atomic<int> created;
+    std::atomic<bool> opened;
+
+    gated_factory_t() :
+        created(0),
+        opened(false)
+    {}
+
+    auto create(const std::string& filename, std::ios_base::openmode mode) const ->
+        std::unique_ptr<std::ostream> override
+    {
+        if (created++ > 0) {
+            while (!opened) {
+                std::this_thread::yield();
+            }
+        }
+
+        return ofstream_factory_t().create(filename, mode);
+    }
+};
+
+class rotation : public ::testing::Test {
+protected:
+    const blackhole::testing::temporary_directory_t temporary{"rotation"};
+    const std::string directory{temporary.path()};
+    const std::string filename{directory + "/app.log"};
+
+    /// Returns sorted names of files in the test directory.
+    auto list() const -> std::vector<std::string> {
+        return temporary.list();
+    }
+
+    /// Returns sorted names of archives.
+    auto archives() const -> std::vector<std::string> {
+        auto result = list();
+        result.erase(std::remove(result.begin(), result.end(), "app.log"), result.end());
+        return result;
+    }
+};
+
+TEST(rotation_t, DisabledByDefault) {
+    EXPECT_FALSE(rotation_t().enabled());
+}
+
+TEST(rotator_t, RotatesBySize) {
+    rotation_t policy;
+    policy.size = 10;
+
+    rotator_t rotator(policy);
+
+    EXPECT_FALSE(rotator.update(5));
+    EXPECT_TRUE(rotator.update(5));
+}
+
+TEST(rotator_t, RotatesOnceUntilReset) {
+    rotation_t policy;
+    policy.size = 10;
+
+    rotator_t rotator(policy);
+
+    EXPECT_TRUE(rotator.update(10));
+    EXPECT_FALSE(rotator.update(10));
+
+    rotator.reset();
+
+    EXPECT_FALSE(rotator.update(5));
+    EXPECT_TRUE(rotator.update(5));
+}
+
+TEST(rotator_t, NeverRotatesWithoutLimits) {
+    rotator_t rotator{rotation_t()};
+
+    EXPECT_FALSE(rotator.update(1 << 30));
+}
+
+TEST(archive_name, AppendsTimestamp) {
+    const auto time = std::chrono::system_clock::time_point() + std::chrono::microseconds(42);
+    const auto name = archive_name("/var/log/app.log", time);
+
+    EXPECT_EQ(0, name.find("/var/log/app.log."));
+    EXPECT_EQ(std::string("/var/log/app.log.YYYYmmdd-HHMMSS.000042").size(), name.size());
+    EXPECT_EQ(".000042", name.substr(name.size() - 7));
+}
+
+TEST_F(rotation, Compress) {
+    const std::string content("le message\nle message\n");
+    write(filename, content);
+
+    compress(filename);
+
+    EXPECT_EQ(std::vector<std::string>{"app.log.gz"}, list());
+
+    const auto file = ::gzopen((filename + ".gz").c_str(), "rb");
+    ASSERT_NE(nullptr, file);
+
+    char buffer[128];
+    const auto size = ::gzread(file, buffer, sizeof(buffer));
+    ::gzclose(file);
+
+    EXPECT_EQ(content, std::string(buffer, static_cast<std::size_t>(size)));
+}
+
+TEST_F(rotation, PruneKeepsNewestArchives) {
+    write(filename, "");
+    write(filename + ".20160101-000000.000000.gz", "");
+    write(filename + ".20160101-000000.000001", "");
+    write(filename + ".20160102-000000.000000", "");
+
+    prune(filename, 2);
+
+    EXPECT_EQ((std::vector<std::string>{
+        "app.log", "app.log.20160101-000000.000001", "app.log.20160102-000000.000000"
+    }), list());
+}
+
+TEST_F(rotation, ArchiverRenamesImmediately) {
+    rotation_t policy;
+    policy.size = 1;
+
+    archiver_t archiver(policy);
+
+    write(filename, "le message\n");
+    archiver.archive(filename);
+
+    const auto result = archives();
+    ASSERT_EQ(1, result.size());
+    EXPECT_EQ("le message\n", read(directory + "/" + result[0]));
+}
+
+TEST_F(rotation, ArchiverIgnoresMissingFile) {
+    rotation_t policy;
+    policy.size = 1;
+
+    archiver_t archiver(policy);
+
+    EXPECT_NO_THROW(archiver.archive(filename));
+}
+
+TEST_F(rotation, ArchiverCompressesInBackground) {
+    rotation_t policy;
+    policy.size = 1;
+    policy.compress = true;
+
+    {
+        archiver_t archiver(policy);
+
+        write(filename, "le message\n");
+        archiver.archive(filename);
+    }
+
+    const auto result = archives();
+    ASSERT_EQ(1, result.size());
+    EXPECT_EQ(".gz", result[0].substr(result[0].size() - 3));
+}
+
+TEST_F(rotation, FileRotatesBySize) {
+    rotation_t policy;
+    policy.size = 16;
+
+    const string_view message("");
+    const attribute_pack pack;
+    const record_t record(0, message, pack);
+
+    {
+        file_t sink(filename,
+            std::unique_ptr<stream_factory_t>(new ofstream_factory_t),
+            std::unique_ptr<flusher_factory_t>(new flusher::repeat_factory_t(0)),
+            1,
+            policy);
+
+        sink.emit(record, "#1 le message");
+        sink.emit(record, "#2 le message");
+        sink.emit(record, "#3");
+    }
+
+    const auto result = archives();
+    ASSERT_EQ(1, result.size());
+    EXPECT_EQ("#1 le message\n#2 le message\n", read(directory + "/" + result[0]));
+    EXPECT_EQ("#3\n", read(filename));
+}
+
+TEST_F(rotation, FileAcceptsWritesWhileRotating) {
+    rotation_t policy;
+    policy.size = 16;
+
+    const string_view message("");
+    const attribute_pack pack;
+    const record_t record(0, message, pack);
+
+    auto factory = new gated_factory_t;
+
+    {
+        file_t sink(filename,
+            std::unique_ptr<stream_factory_t>(factory),
+            std::unique_ptr<flusher_factory_t>(new flusher::repeat_factory_t(0)),
+            1,
+            policy);
+
+        sink.emit(record, "#1 le message");
+
+        // Rotates, waiting for the new stream to be opened.
+        std::thread rotating([&] {
+            sink.emit(record, "#2 le message");
+        });
+
+        while (factory->created < 2) {
+            std::this_thread::yield();
+        }
+
+        std::atomic<bool> emitted(false);
+        std::thread other([&] {
+            sink.emit(record, "#3");
+            emitted = true;
+        });
+
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+        while (!emitted && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::yield();
+        }
+
+        EXPECT_TRUE(emitted.load());
+
+        factory->opened = true;
+        other.join();
+        rotating.join();
+
+        sink.emit(record, "#4");
+    }
+
+    // Writes made during the rotation go to the archived file, which is still open.
+    const auto result = archives();
+    ASSERT_EQ(1, result.size());
+    EXPECT_EQ("#1 le message\n#2 le message\n#3\n", read(directory + "/" + result[0]));
+    EXPECT_EQ("#4\n", read(filename));
+}
+
+TEST_F(rotation, ThreadedFileRotatesBySize) {
+    rotation_t policy;
+    policy.size = 16;
+
+    const string_view message("");
+    const attribute_pack pack;
+    const record_t record(0, message, pack);
+
+    {
+        file_t sink(filename, 4096,
+            std::unique_ptr<flusher_factory_t>(new flusher::repeat_factory_t(1)),
+            1,
+            policy);
+
+        sink.emit(record, "#1 le message");
+        sink.emit(record, "#2 le message");
+        sink.emit(record, "#3");
+    }
+
+    const auto result = archives();
+    ASSERT_EQ(1, result.size());
+    EXPECT_EQ("#1 le message\n#2 le message\n", read(directory + "/" + result[0]));
+    EXPECT_EQ("#3\n", read(filename));
+}
+
+}  // namespace
+}  // namespace file
+}  // namespace sink
+}  // namespace v1
+}  // namespace blackhole
@@ -1,20 +1,259 @@
+#include <climits>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
 #include <system_error>
+#include <vector>
 
 #include <gtest/gtest.h>
 
+#include <sys/stat.h>
+#include <unistd.h>
+
 #include <blackhole/detail/sink/file/stream.hpp>
 
+#include "temporary.hpp"
+
 namespace blackhole {
 inline namespace v1 {
 namespace sink {
 namespace file {
 namespace {
 
+auto read(const std::string& filename) -> std::string {
+    std::ifstream stream(filename);
+    return {std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>()};
+}
+
+class fdbuf : public ::testing::Test {
+protected:
+    const blackhole::testing::temporary_file_t temporary{"fdbuf"};
+    const std::string filename{temporary.path()};
+
+};
+
 TEST(ofstream_factory_t, ThrowsIfUnableToOpenStream) {
     ofstream_factory_t factory;
     EXPECT_THROW(factory.create("/__mythic/file.log", std::ios_base::app), std::system_error);
 }
 
+TEST(fdstream_factory_t, ThrowsIfUnableToOpenStream) {
+    fdstream_factory_t factory(4096);
+    EXPECT_THROW(factory.create("/__mythic/file.log", std::ios_base::app), std::system_error);
+}
+
+TEST_F(fdbuf, CapacityIsRoundedUpToPageSize) {
+    const auto page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+
+    EXPECT_EQ(page, fdbuf_t(filename, std::ios_base::app, 0).capacity());
+    EXPECT_EQ(2 * page, fdbuf_t(filename, std::ios_base::app, page + 1).capacity());
+}
+
+TEST_F(fdbuf, BuffersUntilSync) {
+    fdbuf_t buf(filename, std::ios_base::app, 4096);
+    buf.sputn("le message\n", 11);
+
+    EXPECT_EQ("", read(filename));
+
+    buf.pubsync();
+
+    EXPECT_EQ("le message\n", read(filename));
+}
+
+TEST_F(fdbuf, BuffersIntoPrefaultedPages) {
+    detail::paging_t paging;
+    paging.populate = true;
+
+    fdbuf_t buf(filename, std::ios_base::app, 4096, paging);
+    buf.sputn("le message\n", 11);
+    buf.pubsync();
+
+    EXPECT_EQ("le message\n", read(filename));
+}
+
+TEST_F(fdbuf, WritesOverflowingDataAtOnce) {
+    fdbuf_t buf(filename, std::ios_base::app, 0);
+
+    const std::string prefix("prefix;");
+    const std::string large(buf.capacity() * 2 + 1, 'x');
+
+    buf.sputn(prefix.data(), static_cast<std::streamsize>(prefix.size()));
+    EXPECT_EQ(static_cast<std::streamsize>(large.size()),
+        buf.sputn(large.data(), static_cast<std::streamsize>(large.size())));
+
+    EXPECT_EQ(prefix + large, read(filename));
+}
+
+TEST_F(fdbuf, GathersSlicesIntoBuffer) {
+    fdbuf_t buf(filename, std::ios_base::app, 4096);
+
+    const ::iovec iov[] = {
+        {const_cast<char*>("#1"), 2},
+        {const_cast<char*>("\n"), 1},
+        {const_cast<char*>("#2"), 2},
+        {const_cast<char*>("\n"), 1}
+    };
+
+    EXPECT_TRUE(buf.gather(iov, 4));
+    EXPECT_EQ("", read(filename));
+
+    buf.pubsync();
+    EXPECT_EQ("#1\n#2\n", read(filename));
+}
+
+TEST_F(fdbuf, GathersOverflowingSlicesAtOnce) {
+    fdbuf_t buf(filename, std::ios_base::app, 0);
+
+    const std::string line(64, 'x');
+    const char newline = '\n';
+
+    // More slices than a single writev call accepts.
+    std::vector<::iovec> iov;
+    std::string expected;
+    for (int id = 0; id < IOV_MAX; ++id) {
+        iov.push_back({const_cast<char*>(line.data()), line.size()});
+        iov.push_back({const_cast<char*>(&newline), 1});
+        expected += line + "\n";
+    }
+
+    buf.sputn("prefix;", 7);
+    EXPECT_TRUE(buf.gather(iov.data(), iov.size()));
+
+    EXPECT_EQ("prefix;" + expected, read(filename));
+}
+
+TEST_F(fdbuf, ReservesFreeSpace) {
+    fdbuf_t buf(filename, std::ios_base::app, 4096);
+    buf.sputn("#1\n", 3);
+
+    ::iovec region;
+    EXPECT_TRUE(buf.reserve(3, region));
+    ASSERT_NE(nullptr, region.iov_base);
+    EXPECT_EQ(buf.capacity() - 3, region.iov_len);
+
+    std::memcpy(region.iov_base, "#2\n", 3);
+    buf.advance(3);
+    buf.pubsync();
+
+    EXPECT_EQ("#1\n#2\n", read(filename));
+}
+
+TEST_F(fdbuf, ReserveWritesPendingDataOut) {
+    fdbuf_t buf(filename, std::ios_base::app, 0);
+
+    const std::string line(buf.capacity() - 1, 'x');
+    buf.sputn(line.data(), static_cast<std::streamsize>(line.size()));
+
+    ::iovec region;
+    EXPECT_TRUE(buf.reserve(2, region));
+    EXPECT_EQ(buf.capacity(), region.iov_len);
+    EXPECT_EQ(line, read(filename));
+}
+
+TEST_F(fdbuf, ReservesNothingOverCapacity) {
+    fdbuf_t buf(filename, std::ios_base::app, 0);
+
+    ::iovec region;
+    EXPECT_TRUE(buf.reserve(buf.capacity() + 1, region));
+    EXPECT_EQ(nullptr, region.iov_base);
+    EXPECT_EQ(0, region.iov_len);
+}
+
+TEST_F(fdbuf, FlushesAtDestruction) {
+    {
+        fdbuf_t buf(filename, std::ios_base::app, 4096);
+        buf.sputc('#');
+    }
+
+    EXPECT_EQ("#", read(filename));
+}
+
+TEST_F(fdbuf, Appends) {
+    {
+        fdbuf_t buf(filename, std::ios_base::app, 4096);
+        buf.sputn("#1", 2);
+    }
+
+    {
+        fdbuf_t buf(filename, std::ios_base::app, 4096);
+        buf.sputn("#2", 2);
+    }
+
+    EXPECT_EQ("#1#2", read(filename));
+}
+
+TEST_F(fdbuf, TruncatesUnlessAppending) {
+    {
+        fdbuf_t buf(filename, std::ios_base::app, 4096);
+        buf.sputn("#1", 2);
+    }
+
+    {
+        fdbuf_t buf(filename, std::ios_base::out, 4096);
+        buf.sputn("#2", 2);
+    }
+
+    EXPECT_EQ("#2", read(filename));
+}
+
+TEST_F(fdbuf, DropsWrittenBackWindows) {
+    {
+        fdbuf_t buf(filename, std::ios_base::app, 0);
+        buf.sputn("#1", 2);
+    }
+
+    fdbuf_t buf(filename, std::ios_base::app, 0, detail::paging_t(), 4096);
+    EXPECT_EQ(2, buf.dropped());
+
+    const std::string chunk(buf.capacity(), 'x');
+    for (int id = 0; id < 3; ++id) {
+        buf.sputn(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+    }
+
+    buf.pubsync();
+
+#if defined(__linux__)
+    EXPECT_LT(2, buf.dropped());
+#endif
+    EXPECT_EQ("#1" + chunk + chunk + chunk, read(filename));
+}
+
+TEST_F(fdbuf, PreallocatesAheadKeepingSize) {
+    {
+        fdbuf_t buf(filename, std::ios_base::app, 0, detail::paging_t(), 0, 1 << 20);
+        buf.sputn("le message\n", 11);
+        buf.pubsync();
+
+        struct ::stat stat;
+        ASSERT_EQ(0, ::stat(filename.c_str(), &stat));
+        EXPECT_EQ(11, stat.st_size);
+
+        // File systems without preallocation support, like tmpfs on old kernels, disable it.
+        if (buf.allocated() != 0) {
+            EXPECT_EQ(1 << 20, buf.allocated());
+            EXPECT_LE(1 << 20, stat.st_blocks * 512);
+        }
+    }
+
+    struct ::stat stat;
+    ASSERT_EQ(0, ::stat(filename.c_str(), &stat));
+    EXPECT_EQ(11, stat.st_size);
+    EXPECT_GT(1 << 20, stat.st_blocks * 512);
+    EXPECT_EQ("le message\n", read(filename));
+}
+
+TEST_F(fdbuf, StreamFlush) {
+    auto stream = fdstream_factory_t(4096).create(filename, std::ios_base::app);
+    *stream << "le message";
+
+    EXPECT_EQ("", read(filename));
+
+    stream->flush();
+
+    EXPECT_EQ("le message", read(filename));
+}
+
 }  // namespace
 }  // namespace file
 }  // namespace sink
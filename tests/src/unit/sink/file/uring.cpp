@@ -0,0 +1,112 @@
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <system_error>
+
+#include <gtest/gtest.h>
+
+#include <unistd.h>
+
+#include <blackhole/detail/sink/file/stream.hpp>
+
+#include "temporary.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+namespace file {
+namespace {
+
+auto read(const std::string& filename) -> std::string {
+    std::ifstream stream(filename);
+    return {std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>()};
+}
+
+class uringbuf : public ::testing::Test {
+protected:
+    const blackhole::testing::temporary_file_t temporary{"uringbuf"};
+    const std::string filename{temporary.path()};
+
+};
+
+TEST(uringstream_factory_t, ThrowsIfUnableToOpenStream) {
+    uringstream_factory_t factory(4096);
+    EXPECT_THROW(factory.create("/non-existing/file.log", std::ios_base::app), std::system_error);
+}
+
+TEST_F(uringbuf, CapacityIsRoundedUpToPageSize) {
+    uringbuf_t buf(filename, std::ios_base::app, 1);
+
+    EXPECT_EQ(0, buf.capacity() % static_cast<std::size_t>(::sysconf(_SC_PAGESIZE)));
+}
+
+TEST_F(uringbuf, WritesOnDrain) {
+    uringbuf_t buf(filename, std::ios_base::app, 4096);
+    buf.sputn("le message\n", 11);
+
+    EXPECT_EQ("", read(filename));
+
+    EXPECT_TRUE(buf.drain());
+    EXPECT_EQ("le message\n", read(filename));
+}
+
+TEST_F(uringbuf, KeepsOrderAcrossBuffers) {
+    std::string expected;
+
+    {
+        uringbuf_t buf(filename, std::ios_base::app, 4096, 2);
+
+        // Spans many buffers, causing them to be reused while previous writes are in flight.
+        for (int id = 0; id < 10000; ++id) {
+            const auto line = "line #" + std::to_string(id) + "\n";
+            buf.sputn(line.data(), static_cast<std::streamsize>(line.size()));
+            expected += line;
+        }
+    }
+
+    EXPECT_EQ(expected, read(filename));
+}
+
+TEST_F(uringbuf, Appends) {
+    {
+        std::ofstream stream(filename);
+        stream << "first\n";
+    }
+
+    {
+        uringbuf_t buf(filename, std::ios_base::app, 4096);
+        buf.sputn("second\n", 7);
+    }
+
+    EXPECT_EQ("first\nsecond\n", read(filename));
+}
+
+TEST_F(uringbuf, TruncatesUnlessAppending) {
+    {
+        std::ofstream stream(filename);
+        stream << "first\n";
+    }
+
+    {
+        uringbuf_t buf(filename, std::ios_base::out, 4096);
+        buf.sputn("second\n", 7);
+    }
+
+    EXPECT_EQ("second\n", read(filename));
+}
+
+TEST_F(uringbuf, StreamFlushSubmits) {
+    uringstream_factory_t factory(4096);
+    auto stream = factory.create(filename, std::ios_base::app);
+
+    *stream << "le message" << std::endl;
+    stream.reset();
+
+    EXPECT_EQ("le message\n", read(filename));
+}
+
+}  // namespace
+}  // namespace file
+}  // namespace sink
+}  // namespace v1
+}  // namespace blackhole
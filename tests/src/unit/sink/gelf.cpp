@@ -0,0 +1,301 @@
+#include <zlib.h>
+
+#include <chrono>
+#include <cstring>
+#include <string>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <boost/array.hpp>
+#include <boost/asio/ip/udp.hpp>
+
+#include <blackhole/attribute.hpp>
+#include <blackhole/attributes.hpp>
+#include <blackhole/record.hpp>
+#include <blackhole/sink/socket/gelf.hpp>
+
+#include <src/sink/socket/gelf.hpp>
+
+#include "mocks/node.hpp"
+#include "mocks/registry.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+namespace socket {
+namespace {
+
+using ::testing::Return;
+using ::testing::StrictMock;
+
+auto inflate(const std::string& data) -> std::string {
+    z_stream stream;
+    std::memset(&stream, 0, sizeof(stream));
+    // Detects either zlib or gzip wrapper.
+    inflateInit2(&stream, 15 + 32);
+
+    std::string result(64 * 1024, '\0');
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+    stream.avail_in = static_cast<uInt>(data.size());
+    stream.next_out = reinterpret_cast<Bytef*>(&result[0]);
+    stream.avail_out = static_cast<uInt>(result.size());
+
+    EXPECT_EQ(Z_STREAM_END, ::inflate(&stream, Z_FINISH));
+    result.resize(result.size() - stream.avail_out);
+    inflateEnd(&stream);
+
+    return result;
+}
+
+struct server_t {
+    boost::asio::io_service io_service;
+    boost::asio::ip::udp::socket socket;
+
+    server_t() :
+        socket(io_service, boost::asio::ip::udp::endpoint(boost::asio::ip::udp::v4(), 0))
+    {}
+
+    auto port() const -> std::uint16_t {
+        return socket.local_endpoint().port();
+    }
+
+    auto receive() -> std::string {
+        boost::array<char, 2048> buffer;
+        boost::asio::ip::udp::endpoint remote;
+        const auto nread = socket.receive_from(boost::asio::buffer(buffer), remote, 0);
+        return std::string(buffer.data(), nread);
+    }
+};
+
+auto options(gelf_t::encoding_t encoding) -> gelf_t::options_t {
+    gelf_t::options_t options;
+    options.source = "localhost";
+    options.encoding = encoding;
+    return options;
+}
+
+TEST(gelf_t, SendsMessage) {
+    server_t server;
+
+    auto opts = options(gelf_t::encoding_t::none);
+    opts.levels = {7, 6, 5};
+    gelf_t sink("127.0.0.1", server.port(), opts);
+
+    const string_view message("");
+    const attribute_list attributes{
+        {"key", "value"},
+        {"count", 42},
+        {"flag", true},
+        {"id", 100},
+        {"bad name", 1.5}
+    };
+    const attribute_pack pack{attributes};
+    record_t record(2, message, pack);
+    record.activate("", record_t::time_point(std::chrono::microseconds(1500000000123456)));
+
+    sink.emit(record, "hello \"world\"");
+
+    EXPECT_EQ(R"({"version":"1.1","host":"localhost","short_message":"hello \"world\"",)"
+        R"("timestamp":1500000000.123456,"level":5,"_key":"value","_count":42,"_flag":"true",)"
+        R"("_bad_name":1.5})", server.receive());
+}
+
+TEST(gelf_t, MapsUnknownSeverityToError) {
+    server_t server;
+    gelf_t sink("127.0.0.1", server.port(), options(gelf_t::encoding_t::none));
+
+    const string_view message("");
+    const attribute_pack pack;
+    const record_t record(42, message, pack);
+
+    sink.emit(record, "");
+
+    EXPECT_NE(std::string::npos, server.receive().find(R"("level":3})"));
+}
+
+TEST(gelf_t, CompressesWithZlib) {
+    server_t server;
+    gelf_t sink("127.0.0.1", server.port(), options(gelf_t::encoding_t::zlib));
+
+    const string_view message("");
+    const attribute_pack pack;
+    const record_t record(0, message, pack);
+
+    sink.emit(record, "compressed");
+
+    const auto datagram = server.receive();
+    ASSERT_LE(2, datagram.size());
+    EXPECT_EQ(0x78, static_cast<unsigned char>(datagram[0]));
+
+    const auto json = inflate(datagram);
+    EXPECT_EQ(0, json.find(R"({"version":"1.1","host":"localhost","short_message":"compressed")"));
+}
+
+TEST(gelf_t, CompressesWithGzip) {
+    server_t server;
+    gelf_t sink("127.0.0.1", server.port(), options(gelf_t::encoding_t::gzip));
+
+    const string_view message("");
+    const attribute_pack pack;
+    const record_t record(0, message, pack);
+
+    sink.emit(record, "compressed");
+
+    const auto datagram = server.receive();
+    ASSERT_LE(2, datagram.size());
+    EXPECT_EQ(0x1f, static_cast<unsigned char>(datagram[0]));
+    EXPECT_EQ(0x8b, static_cast<unsigned char>(datagram[1]));
+
+    const auto json = inflate(datagram);
+    EXPECT_EQ(0, json.find(R"({"version":"1.1","host":"localhost","short_message":"compressed")"));
+}
+
+TEST(gelf_t, ChunksLargeMessages) {
+    server_t server;
+
+    auto opts = options(gelf_t::encoding_t::none);
+    opts.chunk = 100;
+    gelf_t sink("127.0.0.1", server.port(), opts);
+
+    const string_view message("");
+    const attribute_pack pack;
+    const record_t record(0, message, pack);
+
+    const std::string large(500, 'x');
+    const string_view messages[] = {"small", large};
+    const sink_t::event_t events[] = {{&record, &messages[0]}, {&record, &messages[1]}};
+
+    sink.emit_batch(events, 2);
+
+    std::string expected;
+    sink.encode(record, messages[0], expected);
+    EXPECT_EQ(expected, server.receive());
+
+    expected.clear();
+    sink.encode(record, messages[1], expected);
+    const auto count = (expected.size() + 87) / 88;
+
+    std::string id;
+    std::string reassembled;
+    for (std::size_t seq = 0; seq < count; ++seq) {
+        const auto chunk = server.receive();
+        ASSERT_LT(12, chunk.size());
+        ASSERT_GE(100, chunk.size());
+
+        EXPECT_EQ('\x1e', chunk[0]);
+        EXPECT_EQ('\x0f', chunk[1]);
+        if (seq == 0) {
+            id = chunk.substr(2, 8);
+        }
+        EXPECT_EQ(id, chunk.substr(2, 8));
+        EXPECT_EQ(seq, static_cast<std::size_t>(chunk[10]));
+        EXPECT_EQ(count, static_cast<std::size_t>(chunk[11]));
+
+        reassembled += chunk.substr(12);
+    }
+
+    EXPECT_EQ(expected, reassembled);
+}
+
+TEST(gelf_t, DropsMessagesRequiringTooManyChunks) {
+    server_t server;
+
+    auto opts = options(gelf_t::encoding_t::none);
+    opts.chunk = 13;
+    gelf_t sink("127.0.0.1", server.port(), opts);
+
+    const string_view message("");
+    const attribute_pack pack;
+    const record_t record(0, message, pack);
+
+    const std::string large(256, 'x');
+    sink.emit(record, large);
+
+    EXPECT_EQ(1, sink.dropped());
+}
+
+TEST(gelf_t, ThrowsIfChunkCanNotHoldHeader) {
+    auto opts = options(gelf_t::encoding_t::none);
+    opts.chunk = 12;
+
+    EXPECT_THROW(gelf_t("127.0.0.1", 12201, opts), std::invalid_argument);
+}
+
+TEST(gelf_t, FactoryType) {
+    EXPECT_EQ(std::string("gelf"), factory<gelf_t>(mock_registry_t()).type());
+}
+
+TEST(gelf_t, FactoryThrowsIfHostParameterIsMissing) {
+    StrictMock<config::testing::mock::node_t> config;
+
+    EXPECT_CALL(config, subscript_key("host"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
+    EXPECT_THROW(factory<gelf_t>(mock_registry_t()).from(config), std::invalid_argument);
+}
+
+TEST(gelf_t, FactoryConfig) {
+    using config::testing::mock::node_t;
+
+    StrictMock<node_t> config;
+
+    auto n1 = new node_t;
+    EXPECT_CALL(config, subscript_key("host"))
+        .Times(1)
+        .WillOnce(Return(n1));
+
+    EXPECT_CALL(*n1, to_string())
+        .Times(1)
+        .WillOnce(Return("127.0.0.1"));
+
+    auto n2 = new node_t;
+    EXPECT_CALL(config, subscript_key("port"))
+        .Times(1)
+        .WillOnce(Return(n2));
+
+    EXPECT_CALL(*n2, to_uint64())
+        .Times(1)
+        .WillOnce(Return(12201));
+
+    EXPECT_CALL(config, subscript_key("source"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
+    auto n3 = new node_t;
+    EXPECT_CALL(config, subscript_key("compression"))
+        .Times(1)
+        .WillOnce(Return(n3));
+
+    EXPECT_CALL(*n3, to_string())
+        .Times(1)
+        .WillOnce(Return("gzip"));
+
+    auto n4 = new node_t;
+    EXPECT_CALL(config, subscript_key("chunk"))
+        .Times(1)
+        .WillOnce(Return(n4));
+
+    EXPECT_CALL(*n4, to_uint64())
+        .Times(1)
+        .WillOnce(Return(8192));
+
+    for (const auto& key : {"level", "levels", "connect", "resolve"}) {
+        EXPECT_CALL(config, subscript_key(key))
+            .Times(1)
+            .WillOnce(Return(nullptr));
+    }
+
+    const auto sink = factory<gelf_t>(mock_registry_t()).from(config);
+    const auto& cast = dynamic_cast<const gelf_t&>(*sink);
+
+    EXPECT_EQ(gelf_t::encoding_t::gzip, cast.encoding());
+    EXPECT_EQ(8192, cast.chunk());
+}
+
+}  // namespace
+}  // namespace socket
+}  // namespace sink
+}  // namespace v1
+}  // namespace blackhole
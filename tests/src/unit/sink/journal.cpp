@@ -0,0 +1,220 @@
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <syslog.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <boost/lexical_cast.hpp>
+
+#include <blackhole/attribute.hpp>
+#include <blackhole/attributes.hpp>
+#include <blackhole/record.hpp>
+#include <blackhole/sink/journal.hpp>
+
+#include <blackhole/detail/procname.hpp>
+#include <blackhole/detail/sink/journal.hpp>
+
+#include "mocks/node.hpp"
+#include "mocks/registry.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+namespace {
+
+using ::testing::_;
+using ::testing::HasSubstr;
+using ::testing::Invoke;
+using ::testing::Return;
+using ::testing::StrictMock;
+
+/// Local datagram socket bound to a temporary path, like the journal one.
+class socket_t {
+    std::string path_;
+    int fd;
+
+public:
+    socket_t() :
+        path_("/tmp/blackhole-journal-" + boost::lexical_cast<std::string>(::getpid())),
+        fd(::socket(AF_UNIX, SOCK_DGRAM, 0))
+    {
+        ::unlink(path_.c_str());
+
+        struct sockaddr_un address;
+        std::memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        std::strcpy(address.sun_path, path_.c_str());
+
+        ::bind(fd, reinterpret_cast<struct sockaddr*>(&address), sizeof(address));
+    }
+
+    ~socket_t() {
+        ::close(fd);
+        ::unlink(path_.c_str());
+    }
+
+    auto path() const -> const std::string& {
+        return path_;
+    }
+
+    /// Receives a datagram, reading the passed memory file if any.
+    auto receive() -> std::string {
+        std::vector<char> buffer(64 * 1024);
+
+        struct iovec iov = {buffer.data(), buffer.size()};
+
+        union {
+            struct cmsghdr header;
+            char control[CMSG_SPACE(sizeof(int))];
+        } control;
+
+        struct msghdr header;
+        std::memset(&header, 0, sizeof(header));
+        header.msg_iov = &iov;
+        header.msg_iovlen = 1;
+        header.msg_control = &control;
+        header.msg_controllen = sizeof(control);
+
+        const auto size = ::recvmsg(fd, &header, 0);
+        if (size < 0) {
+            return {};
+        }
+
+        if (auto cmsg = CMSG_FIRSTHDR(&header)) {
+            int file;
+            std::memcpy(&file, CMSG_DATA(cmsg), sizeof(int));
+
+            std::string result;
+            char chunk[4096];
+            ssize_t rc;
+            while ((rc = ::pread(file, chunk, sizeof(chunk), static_cast<off_t>(result.size()))) > 0) {
+                result.append(chunk, static_cast<std::size_t>(rc));
+            }
+
+            ::close(file);
+            return result;
+        }
+
+        return std::string(buffer.data(), static_cast<std::size_t>(size));
+    }
+};
+
+TEST(journal_t, Type) {
+    EXPECT_EQ(std::string("journal"), factory<journal_t>(mock_registry_t()).type());
+}
+
+TEST(journal_t, ThrowsIfUnableToConnect) {
+    EXPECT_THROW(journal_t("/tmp/blackhole-journal-nonexisting"), std::system_error);
+}
+
+TEST(journal_t, SendsFields) {
+    socket_t socket;
+    journal_t sink(socket.path());
+    sink.priorities({LOG_DEBUG, LOG_INFO});
+
+    const string_view message("");
+    const attribute_list attributes{
+        {"source", "app/1.0"},
+        {"request-id", 42},
+        {"__trusted", true},
+        {"1", 1}
+    };
+    const attribute_pack pack{attributes};
+    const record_t record(1, message, pack);
+
+    sink.emit(record, "le message");
+
+    EXPECT_EQ(
+        "MESSAGE=le message\n"
+        "PRIORITY=6\n"
+        "SYSLOG_IDENTIFIER=" + detail::procname().to_string() + "\n"
+        "SOURCE=app/1.0\n"
+        "REQUEST_ID=42\n"
+        "TRUSTED=true\n",
+        socket.receive());
+}
+
+TEST(journal_t, SendsMultilineValuesInBinaryForm) {
+    socket_t socket;
+    journal_t sink(socket.path());
+
+    const string_view message("");
+    const attribute_pack pack;
+    const record_t record(0, message, pack);
+
+    sink.emit(record, "first\nsecond");
+
+    const auto datagram = socket.receive();
+    const std::string expected("MESSAGE\n\x0c\0\0\0\0\0\0\0first\nsecond\nPRIORITY=3\n", 36);
+
+    EXPECT_EQ(expected, datagram.substr(0, expected.size()));
+}
+
+TEST(journal_t, PassesLargeRecordsUsingMemoryFile) {
+    socket_t socket;
+    journal_t sink(socket.path());
+
+    const string_view message("");
+    const attribute_pack pack;
+    const record_t record(0, message, pack);
+
+    const std::string large(4 * 1024 * 1024, 'x');
+    sink.emit(record, large);
+
+    const auto datagram = socket.receive();
+
+    ASSERT_EQ(std::string("MESSAGE="), datagram.substr(0, 8));
+    EXPECT_EQ(large, datagram.substr(8, large.size()));
+    EXPECT_THAT(datagram, HasSubstr("\nPRIORITY=3\n"));
+}
+
+TEST(journal_t, Factory) {
+    using config::testing::mock::node_t;
+
+    socket_t socket;
+    StrictMock<node_t> config;
+
+    auto path = new node_t;
+    EXPECT_CALL(config, subscript_key("path"))
+        .Times(1)
+        .WillOnce(Return(path));
+
+    EXPECT_CALL(*path, to_string())
+        .Times(1)
+        .WillOnce(Return(socket.path()));
+
+    auto priorities = new node_t;
+    EXPECT_CALL(config, subscript_key("priorities"))
+        .Times(1)
+        .WillOnce(Return(priorities));
+
+    node_t item;
+    EXPECT_CALL(*priorities, each(_))
+        .Times(1)
+        .WillOnce(Invoke([&](const node_t::each_function& fn) {
+            fn(item);
+            fn(item);
+        }));
+
+    EXPECT_CALL(item, to_sint64())
+        .Times(2)
+        .WillOnce(Return(7))
+        .WillOnce(Return(6));
+
+    auto sink = factory<journal_t>(mock_registry_t()).from(config);
+    const auto& cast = dynamic_cast<const journal_t&>(*sink);
+
+    EXPECT_EQ(socket.path(), cast.path());
+    EXPECT_EQ((std::vector<int>{7, 6}), cast.priorities());
+}
+
+}  // namespace
+}  // namespace sink
+}  // namespace v1
+}  // namespace blackhole
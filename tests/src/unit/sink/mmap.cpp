@@ -0,0 +1,231 @@
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <unistd.h>
+
+#include <blackhole/attribute.hpp>
+#include <blackhole/record.hpp>
+#include <blackhole/sink/mmap.hpp>
+#include <blackhole/detail/sink/mmap.hpp>
+
+#include "mocks/node.hpp"
+#include "mocks/registry.hpp"
+#include "temporary.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+namespace {
+
+using ::testing::Return;
+using ::testing::StrictMock;
+
+class mmap : public ::testing::Test {
+protected:
+    const blackhole::testing::temporary_file_t temporary{"mmap"};
+    const std::string path{temporary.path()};
+    std::size_t page;
+
+    auto SetUp() -> void override {
+        page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+    }
+
+    /// Returns the data ring content.
+    auto ring() const -> std::string {
+        std::ifstream stream(path, std::ios::binary);
+        const std::string content{std::istreambuf_iterator<char>(stream),
+            std::istreambuf_iterator<char>()};
+
+        return content.substr(page);
+    }
+};
+
+TEST_F(mmap, CapacityIsRoundedUpToPageSize) {
+    mmap_t sink(path, page + 1, std::chrono::milliseconds(0));
+
+    EXPECT_EQ(2 * page, sink.capacity());
+    EXPECT_EQ(0, sink.tail());
+}
+
+TEST_F(mmap, Emit) {
+    const string_view message("");
+    const attribute_pack pack;
+    const record_t record(0, message, pack);
+
+    {
+        mmap_t sink(path, page, std::chrono::milliseconds(0));
+        sink.emit(record, "#1");
+        sink.emit(record, "#2");
+
+        EXPECT_EQ(6, sink.tail());
+    }
+
+    EXPECT_EQ("#1\n#2\n", ring().substr(0, 6));
+}
+
+TEST_F(mmap, WrapsAround) {
+    const string_view message("");
+    const attribute_pack pack;
+    const record_t record(0, message, pack);
+
+    const std::string prefix(page - 2, 'x');
+
+    {
+        mmap_t sink(path, page, std::chrono::milliseconds(0));
+        sink.emit(record, prefix);
+        sink.emit(record, "#1");
+    }
+
+    const auto content = ring();
+    ASSERT_EQ(page, content.size());
+    EXPECT_EQ("1\n", content.substr(0, 2));
+    EXPECT_EQ("\n#", content.substr(page - 2));
+}
+
+TEST_F(mmap, TruncatesLargeMessages) {
+    const string_view message("");
+    const attribute_pack pack;
+    const record_t record(0, message, pack);
+
+    const std::string large(page * 2, 'x');
+
+    mmap_t sink(path, page, std::chrono::milliseconds(0));
+    sink.emit(record, large);
+
+    EXPECT_EQ(page, sink.tail());
+}
+
+TEST_F(mmap, ContinuesExistingRing) {
+    const string_view message("");
+    const attribute_pack pack;
+    const record_t record(0, message, pack);
+
+    {
+        mmap_t sink(path, page, std::chrono::milliseconds(0));
+        sink.emit(record, "#1");
+    }
+
+    {
+        mmap_t sink(path, page, std::chrono::milliseconds(0));
+        EXPECT_EQ(3, sink.tail());
+
+        sink.emit(record, "#2");
+    }
+
+    EXPECT_EQ("#1\n#2\n", ring().substr(0, 6));
+}
+
+TEST_F(mmap, ReinitializesRingOfDifferentCapacity) {
+    const string_view message("");
+    const attribute_pack pack;
+    const record_t record(0, message, pack);
+
+    {
+        mmap_t sink(path, page, std::chrono::milliseconds(0));
+        sink.emit(record, "#1");
+    }
+
+    mmap_t sink(path, 2 * page, std::chrono::milliseconds(0));
+    EXPECT_EQ(0, sink.tail());
+}
+
+TEST_F(mmap, ConcurrentEmit) {
+    const string_view message("");
+    const attribute_pack pack;
+    const record_t record(0, message, pack);
+
+    mmap_t sink(path, 1024 * 1024, std::chrono::milliseconds(1));
+
+    std::vector<std::thread> threads;
+    for (int id = 0; id < 8; ++id) {
+        threads.emplace_back([&] {
+            for (int i = 0; i < 1000; ++i) {
+                sink.emit(record, "le message");
+            }
+        });
+    }
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_EQ(8 * 1000 * 11, sink.tail());
+}
+
+TEST(mmap_t, ThrowsIfUnableToOpen) {
+    EXPECT_THROW(mmap_t("/__mythic/file.log", 4096, std::chrono::milliseconds(0)), std::system_error);
+}
+
+TEST_F(mmap, Builder) {
+    auto sink = builder<mmap_t>(path)
+        .capacity(kibibytes_t(64))
+        .sync_every(std::chrono::milliseconds(10))
+        .build();
+
+    EXPECT_EQ(64 * 1024, dynamic_cast<const mmap_t&>(*sink).capacity());
+}
+
+TEST(factory, MmapType) {
+    EXPECT_EQ(std::string("mmap"), factory<mmap_t>(mock_registry_t()).type());
+}
+
+TEST(factory, MmapRequiresPath) {
+    StrictMock<config::testing::mock::node_t> config;
+
+    EXPECT_CALL(config, subscript_key("path"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
+    EXPECT_THROW(factory<mmap_t>(mock_registry_t()).from(config), std::invalid_argument);
+}
+
+TEST_F(mmap, FactoryFromConfig) {
+    using config::testing::mock::node_t;
+
+    StrictMock<node_t> config;
+
+    auto npath = new StrictMock<node_t>;
+    EXPECT_CALL(config, subscript_key("path"))
+        .Times(1)
+        .WillOnce(Return(npath));
+
+    EXPECT_CALL(*npath, to_string())
+        .Times(1)
+        .WillOnce(Return(path));
+
+    auto ncapacity = new StrictMock<node_t>;
+    EXPECT_CALL(config, subscript_key("capacity"))
+        .Times(1)
+        .WillOnce(Return(ncapacity));
+
+    EXPECT_CALL(*ncapacity, is_uint64_())
+        .Times(1)
+        .WillOnce(Return(false));
+
+    EXPECT_CALL(*ncapacity, is_string_())
+        .Times(1)
+        .WillOnce(Return(true));
+
+    EXPECT_CALL(*ncapacity, to_string())
+        .Times(1)
+        .WillOnce(Return("1MiB"));
+
+    EXPECT_CALL(config, subscript_key("sync"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
+    auto sink = factory<mmap_t>(mock_registry_t()).from(config);
+
+    EXPECT_EQ(1024 * 1024, dynamic_cast<const mmap_t&>(*sink).capacity());
+}
+
+}  // namespace
+}  // namespace sink
+}  // namespace v1
+}  // namespace blackhole
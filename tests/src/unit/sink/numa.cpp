@@ -0,0 +1,100 @@
+#include <stdexcept>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <blackhole/attribute.hpp>
+#include <blackhole/attributes.hpp>
+#include <blackhole/metrics.hpp>
+#include <blackhole/record.hpp>
+#include <blackhole/detail/sink/numa.hpp>
+
+#include "mocks/sink.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+namespace {
+
+using ::testing::_;
+
+using namespace blackhole::testing;
+
+/// Returns nodes where the second one has all CPUs, so every thread is routed to it.
+auto nodes() -> std::vector<numa_t::node_t> {
+    std::vector<int> cpus;
+    for (int cpu = 0; cpu < 1024; ++cpu) {
+        cpus.push_back(cpu);
+    }
+
+    return {{0, {}}, {1, cpus}};
+}
+
+TEST(numa_t, ThrowsOnNoNodes) {
+    EXPECT_THROW(numa_t({}, [](const numa_t::node_t&) -> std::unique_ptr<sink_t> {
+        return std::unique_ptr<sink_t>(new mock::sink_t);
+    }), std::invalid_argument);
+}
+
+TEST(numa_t, Topology) {
+    const auto nodes = numa_t::topology();
+
+    ASSERT_FALSE(nodes.empty());
+
+    for (std::size_t id = 1; id < nodes.size(); ++id) {
+        EXPECT_LT(nodes[id - 1].id, nodes[id].id);
+    }
+}
+
+TEST(numa_t, CreatesSinkForEachNode) {
+    std::vector<int> ids;
+    numa_t sink(nodes(), [&](const numa_t::node_t& node) -> std::unique_ptr<sink_t> {
+        ids.push_back(node.id);
+        return std::unique_ptr<sink_t>(new mock::sink_t);
+    });
+
+    EXPECT_EQ((std::vector<int>{0, 1}), ids);
+}
+
+TEST(numa_t, EmitsIntoLocalNodeSink) {
+    std::vector<mock::sink_t*> sinks;
+    numa_t sink(nodes(), [&](const numa_t::node_t&) -> std::unique_ptr<sink_t> {
+        sinks.push_back(new mock::sink_t);
+        return std::unique_ptr<sink_t>(sinks.back());
+    });
+
+    EXPECT_CALL(*sinks[0], emit(_, _))
+        .Times(0);
+    EXPECT_CALL(*sinks[1], emit(_, _))
+        .Times(1);
+
+    const string_view message("-");
+    const attribute_pack pack;
+    record_t record(0, message, pack);
+    sink.emit(record, message);
+}
+
+TEST(numa_t, SharesDestination) {
+    std::shared_ptr<mock::sink_t> destination(new mock::sink_t);
+    std::shared_ptr<sink_t> shared(destination);
+
+    numa_t sink(nodes(), [&](const numa_t::node_t&) -> std::unique_ptr<sink_t> {
+        return numa_t::share(shared);
+    }, shared);
+
+    EXPECT_CALL(*destination, emit(_, _))
+        .Times(1);
+
+    const string_view message("-");
+    const attribute_pack pack;
+    record_t record(0, message, pack);
+    sink.emit(record, message);
+
+    EXPECT_TRUE(sink.flush(std::chrono::steady_clock::now()));
+}
+
+}  // namespace
+}  // namespace sink
+}  // namespace v1
+}  // namespace blackhole
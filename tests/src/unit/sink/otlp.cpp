@@ -0,0 +1,256 @@
+#include <chrono>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/asio/buffers_iterator.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/read.hpp>
+#include <boost/asio/read_until.hpp>
+#include <boost/asio/streambuf.hpp>
+#include <boost/asio/write.hpp>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <blackhole/attribute.hpp>
+#include <blackhole/record.hpp>
+#include <blackhole/sink/otlp.hpp>
+
+#include <blackhole/detail/sink/otlp.hpp>
+
+#include "mocks/node.hpp"
+#include "mocks/registry.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+namespace {
+
+using ::testing::HasSubstr;
+using ::testing::Invoke;
+using ::testing::Return;
+using ::testing::StrictMock;
+using ::testing::_;
+
+/// Accepts a single connection and accepts each export request with an empty response, recording
+/// request heads and bodies.
+class server_t {
+    boost::asio::io_service io_service;
+    boost::asio::ip::tcp::acceptor acceptor;
+
+    mutable std::mutex mutex;
+    std::vector<std::pair<std::string, std::string>> requests_;
+
+    std::thread thread;
+
+public:
+    server_t() :
+        acceptor(io_service, boost::asio::ip::tcp::endpoint(boost::asio::ip::tcp::v4(), 0))
+    {
+        thread = std::thread([this] {
+            run();
+        });
+    }
+
+    ~server_t() {
+        thread.join();
+    }
+
+    auto port() const -> std::uint16_t {
+        return acceptor.local_endpoint().port();
+    }
+
+    auto requests() const -> std::vector<std::pair<std::string, std::string>> {
+        std::lock_guard<std::mutex> lock(mutex);
+        return requests_;
+    }
+
+private:
+    auto run() -> void {
+        boost::asio::ip::tcp::socket socket(io_service);
+        acceptor.accept(socket);
+
+        boost::asio::streambuf buffer;
+        boost::system::error_code ec;
+
+        while (true) {
+            const auto size = boost::asio::read_until(socket, buffer, "\r\n\r\n", ec);
+            if (ec) {
+                return;
+            }
+
+            const auto begin = boost::asio::buffers_begin(buffer.data());
+            const std::string head(begin, begin + static_cast<std::ptrdiff_t>(size));
+            buffer.consume(size);
+
+            const auto pos = head.find("Content-Length: ");
+            const auto length = static_cast<std::size_t>(std::atoi(head.c_str() + pos + 16));
+
+            if (buffer.size() < length) {
+                boost::asio::read(socket, buffer, boost::asio::transfer_exactly(length - buffer.size()), ec);
+                if (ec) {
+                    return;
+                }
+            }
+
+            const auto data = boost::asio::buffers_begin(buffer.data());
+            const std::string body(data, data + static_cast<std::ptrdiff_t>(length));
+            buffer.consume(length);
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                requests_.emplace_back(head, body);
+            }
+
+            const std::string reply("HTTP/1.1 200 OK\r\n"
+                "Content-Type: application/x-protobuf\r\nContent-Length: 0\r\n\r\n");
+
+            boost::asio::write(socket, boost::asio::buffer(reply), ec);
+            if (ec) {
+                return;
+            }
+        }
+    }
+};
+
+template<typename F>
+auto wait(F&& predicate) -> bool {
+    for (int i = 0; i < 5000; ++i) {
+        if (predicate()) {
+            return true;
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    return false;
+}
+
+TEST(otlp, Envelope) {
+    EXPECT_EQ(std::string("\x0a\x08" "\x0a\x01" "R" "\x12\x03" "\x0a\x01" "S"),
+        otlp::envelope("R", "S", 0));
+
+    // Records are appended by the caller, so only the enclosing lengths grow.
+    EXPECT_EQ(std::string("\x0a\x89\x01" "\x0a\x01" "R" "\x12\x83\x01" "\x0a\x01" "S"),
+        otlp::envelope("R", "S", 128));
+}
+
+TEST(otlp, ThrowsOnZeroLimits) {
+    auto options = otlp_t::options_t();
+    options.count = 0;
+
+    EXPECT_THROW(otlp_t{options}, std::invalid_argument);
+}
+
+TEST(otlp, SendsExportRequest) {
+    server_t server;
+
+    otlp_t::options_t options;
+    options.host = "127.0.0.1";
+    options.port = server.port();
+    options.resource = {{"service.name", "test"}};
+    options.count = 2;
+    options.linger = std::chrono::milliseconds(60000);
+
+    otlp_t sink(options);
+
+    const string_view message("");
+    const attribute_pack pack;
+    const record_t record(0, message, pack);
+
+    sink.emit(record, "a");
+    sink.emit(record, "bc");
+
+    ASSERT_TRUE(wait([&] { return sink.sent() == 2; }));
+
+    const auto requests = server.requests();
+    ASSERT_EQ(1, requests.size());
+
+    EXPECT_THAT(requests[0].first, HasSubstr("POST /v1/logs HTTP/1.1\r\n"));
+    EXPECT_THAT(requests[0].first, HasSubstr("\r\nContent-Type: application/x-protobuf\r\n"));
+
+    const std::string resource("\x0a\x16" "\x0a\x0c" "service.name" "\x12\x06" "\x0a\x04" "test");
+    const std::string scope("\x0a\x09" "blackhole");
+
+    EXPECT_EQ(otlp::envelope(resource, scope, 7) + "\x12\x01" "a" "\x12\x02" "bc",
+        requests[0].second);
+    EXPECT_EQ(0, sink.failed());
+}
+
+TEST(otlp_t, FactoryType) {
+    EXPECT_EQ(std::string("otlp"), factory<otlp_t>(mock_registry_t()).type());
+}
+
+TEST(otlp_t, Factory) {
+    using config::testing::mock::node_t;
+
+    StrictMock<node_t> config;
+
+    auto n1 = new node_t;
+    EXPECT_CALL(config, subscript_key("host"))
+        .Times(1)
+        .WillOnce(Return(n1));
+
+    EXPECT_CALL(*n1, to_string())
+        .Times(1)
+        .WillOnce(Return("127.0.0.1"));
+
+    EXPECT_CALL(config, subscript_key("port"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
+    EXPECT_CALL(config, subscript_key("path"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
+    auto n2 = new node_t;
+    EXPECT_CALL(config, subscript_key("resource"))
+        .Times(1)
+        .WillOnce(Return(n2));
+
+    node_t value;
+    EXPECT_CALL(*n2, each_map(_))
+        .Times(1)
+        .WillOnce(Invoke([&](const node_t::member_function& fn) {
+            fn("service.name", value);
+        }));
+
+    EXPECT_CALL(value, to_string())
+        .Times(1)
+        .WillOnce(Return("storage"));
+
+    auto n3 = new node_t;
+    EXPECT_CALL(config, subscript_key("scope"))
+        .Times(1)
+        .WillOnce(Return(n3));
+
+    EXPECT_CALL(*n3, to_string())
+        .Times(1)
+        .WillOnce(Return("app"));
+
+    for (const auto& key : {"count", "bytes", "linger", "connections", "retries", "capacity"}) {
+        EXPECT_CALL(config, subscript_key(key))
+            .Times(1)
+            .WillOnce(Return(nullptr));
+    }
+
+    const auto sink = factory<otlp_t>(mock_registry_t()).from(config);
+    const auto& cast = dynamic_cast<const otlp_t&>(*sink);
+
+    EXPECT_EQ("127.0.0.1", cast.options().host);
+    EXPECT_EQ(4318, cast.options().port);
+    EXPECT_EQ("/v1/logs", cast.options().path);
+    ASSERT_EQ(1, cast.options().resource.size());
+    EXPECT_EQ("service.name", cast.options().resource[0].first);
+    EXPECT_EQ("storage", cast.options().resource[0].second);
+    EXPECT_EQ("app", cast.options().scope);
+    EXPECT_EQ(512, cast.options().count);
+}
+
+}  // namespace
+}  // namespace sink
+}  // namespace v1
+}  // namespace blackhole
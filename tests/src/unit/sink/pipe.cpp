@@ -0,0 +1,288 @@
+#include <cerrno>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <blackhole/attribute.hpp>
+#include <blackhole/record.hpp>
+#include <blackhole/sink/pipe.hpp>
+#include <blackhole/detail/sink/pipe.hpp>
+
+#include "mocks/node.hpp"
+#include "mocks/registry.hpp"
+#include "temporary.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+namespace {
+
+using ::testing::Return;
+using ::testing::StrictMock;
+
+class pipe : public ::testing::Test {
+protected:
+    const blackhole::testing::temporary_directory_t temporary{"pipe"};
+    const std::string path{temporary.path() + "/pipe"};
+    std::size_t page;
+    int reader;
+
+    auto SetUp() -> void override {
+        page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+        reader = -1;
+    }
+
+    auto TearDown() -> void override {
+        if (reader != -1) {
+            ::close(reader);
+        }
+    }
+
+    /// Creates the pipe and attaches a non-blocking reader to it.
+    auto attach() -> void {
+        ASSERT_EQ(0, ::mkfifo(path.c_str(), 0644));
+        reader = ::open(path.c_str(), O_RDONLY | O_NONBLOCK);
+        ASSERT_NE(-1, reader);
+    }
+
+    /// Reads everything written into the pipe so far.
+    auto read() const -> std::string {
+        std::string result;
+
+        char buffer[4096];
+        while (true) {
+            const auto rc = ::read(reader, buffer, sizeof(buffer));
+            if (rc <= 0) {
+                break;
+            }
+
+            result.append(buffer, static_cast<std::size_t>(rc));
+        }
+
+        return result;
+    }
+};
+
+TEST_F(pipe, BufferIsRoundedUpToPageSize) {
+    pipe_t sink(path, page + 1, 0);
+
+    EXPECT_EQ(path, sink.path());
+    EXPECT_EQ(2 * page, sink.buffer_size());
+    EXPECT_FALSE(sink.splicing());
+}
+
+TEST_F(pipe, ThrowsWithoutReader) {
+    const string_view message("");
+    const attribute_pack pack;
+    const record_t record(0, message, pack);
+
+    pipe_t sink(path, page, 0);
+
+    try {
+        sink.emit(record, "#1");
+        FAIL() << "emitting must fail without readers";
+    } catch (const std::system_error& err) {
+        EXPECT_EQ(ENXIO, err.code().value());
+    }
+
+    // The pipe is created anyway, so that readers are able to attach.
+    struct stat stat;
+    ASSERT_EQ(0, ::stat(path.c_str(), &stat));
+    EXPECT_TRUE(S_ISFIFO(stat.st_mode));
+}
+
+TEST_F(pipe, Emit) {
+    attach();
+
+    const string_view message("");
+    const attribute_pack pack;
+    const record_t record(0, message, pack);
+
+    pipe_t sink(path, page, 0);
+    sink.emit(record, "#1");
+    sink.emit(record, "#2");
+
+    EXPECT_EQ("#1\n#2\n", read());
+}
+
+TEST_F(pipe, EmitBatch) {
+    attach();
+
+    const string_view message("");
+    const attribute_pack pack;
+    const record_t record(0, message, pack);
+
+    // Messages span several buffers, each of which is gifted to the pipe.
+    const std::string line(99, 'x');
+    const string_view formatted(line);
+    std::vector<sink_t::event_t> events(100, sink_t::event_t{&record, &formatted});
+
+    pipe_t sink(path, page, 0);
+    sink.emit_batch(events.data(), events.size());
+    sink.emit_batch(events.data(), 1);
+
+#if defined(__linux__)
+    EXPECT_TRUE(sink.splicing());
+#endif
+
+    std::string expected;
+    for (std::size_t id = 0; id < events.size() + 1; ++id) {
+        expected += line + "\n";
+    }
+
+    EXPECT_EQ(expected, read());
+}
+
+TEST_F(pipe, EmitBatchWritesLargeMessagesDirectly) {
+    attach();
+
+    const string_view message("");
+    const attribute_pack pack;
+    const record_t record(0, message, pack);
+
+    const std::string large(2 * page, 'x');
+    const string_view small("#1");
+    const string_view huge(large);
+    const sink_t::event_t events[] = {{&record, &small}, {&record, &huge}, {&record, &small}};
+
+    pipe_t sink(path, page, 0);
+    sink.emit_batch(events, 3);
+
+    EXPECT_EQ("#1\n" + large + "\n#1\n", read());
+}
+
+TEST_F(pipe, FallsBackToWritevForRegularFiles) {
+    std::ofstream(path.c_str()).flush();
+
+    const string_view message("");
+    const attribute_pack pack;
+    const record_t record(0, message, pack);
+
+    const string_view formatted("#1");
+    const sink_t::event_t events[] = {{&record, &formatted}, {&record, &formatted}};
+
+    {
+        pipe_t sink(path, page, 0);
+        sink.emit_batch(events, 2);
+        sink.emit_batch(events, 1);
+
+        EXPECT_FALSE(sink.splicing());
+    }
+
+    std::ifstream stream(path);
+    const std::string content{std::istreambuf_iterator<char>(stream),
+        std::istreambuf_iterator<char>()};
+
+    EXPECT_EQ("#1\n#1\n#1\n", content);
+}
+
+TEST_F(pipe, ReopensAfterReaderGoesAway) {
+    attach();
+
+    const string_view message("");
+    const attribute_pack pack;
+    const record_t record(0, message, pack);
+
+    pipe_t sink(path, page, 0);
+    sink.emit(record, "#1");
+
+    ::close(reader);
+    reader = -1;
+
+    // Must fail with `EPIPE` instead of terminating the process with `SIGPIPE`.
+    try {
+        sink.emit(record, "#2");
+        FAIL() << "emitting must fail after the reader goes away";
+    } catch (const std::system_error& err) {
+        EXPECT_EQ(EPIPE, err.code().value());
+    }
+
+    reader = ::open(path.c_str(), O_RDONLY | O_NONBLOCK);
+    ASSERT_NE(-1, reader);
+
+    sink.emit(record, "#3");
+    EXPECT_EQ("#3\n", read());
+}
+
+TEST_F(pipe, Builder) {
+    auto sink = builder<pipe_t>(path)
+        .buffer(kibibytes_t(128))
+        .pipe_size(mibibytes_t(1))
+        .build();
+
+    EXPECT_EQ(128 * 1024, dynamic_cast<const pipe_t&>(*sink).buffer_size());
+}
+
+TEST(factory, PipeType) {
+    EXPECT_EQ(std::string("pipe"), factory<pipe_t>(mock_registry_t()).type());
+}
+
+TEST(factory, PipeRequiresPath) {
+    StrictMock<config::testing::mock::node_t> config;
+
+    EXPECT_CALL(config, subscript_key("path"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
+    EXPECT_THROW(factory<pipe_t>(mock_registry_t()).from(config), std::invalid_argument);
+}
+
+TEST_F(pipe, FactoryFromConfig) {
+    using config::testing::mock::node_t;
+
+    StrictMock<node_t> config;
+
+    auto npath = new StrictMock<node_t>;
+    EXPECT_CALL(config, subscript_key("path"))
+        .Times(1)
+        .WillOnce(Return(npath));
+
+    EXPECT_CALL(*npath, to_string())
+        .Times(1)
+        .WillOnce(Return(path));
+
+    auto nbuffer = new StrictMock<node_t>;
+    EXPECT_CALL(config, subscript_key("buffer"))
+        .Times(1)
+        .WillOnce(Return(nbuffer));
+
+    EXPECT_CALL(*nbuffer, is_string_())
+        .Times(1)
+        .WillOnce(Return(true));
+
+    EXPECT_CALL(*nbuffer, to_string())
+        .Times(1)
+        .WillOnce(Return("256KiB"));
+
+    auto nsize = new StrictMock<node_t>;
+    EXPECT_CALL(config, subscript_key("pipe_size"))
+        .Times(1)
+        .WillOnce(Return(nsize));
+
+    EXPECT_CALL(*nsize, is_string_())
+        .Times(1)
+        .WillOnce(Return(false));
+
+    EXPECT_CALL(*nsize, to_uint64())
+        .Times(1)
+        .WillOnce(Return(0));
+
+    auto sink = factory<pipe_t>(mock_registry_t()).from(config);
+
+    EXPECT_EQ(256 * 1024, dynamic_cast<const pipe_t&>(*sink).buffer_size());
+}
+
+}  // namespace
+}  // namespace sink
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,104 @@
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+
+#include <gtest/gtest.h>
+
+#include <boost/asio/deadline_timer.hpp>
+
+#include <src/sink/reactor.hpp>
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+namespace {
+
+TEST(reactor_t, ThrowsIfThereAreNoThreads) {
+    EXPECT_THROW(reactor_t(0), std::invalid_argument);
+}
+
+TEST(reactor_t, SharedIsReusedWhileReferenced) {
+    const auto reactor = reactor_t::shared();
+
+    EXPECT_EQ(reactor, reactor_t::shared());
+    EXPECT_EQ(1, reactor->size());
+}
+
+TEST(binding_t, JoinWaitsForPostedHandlers) {
+    std::atomic<int> counter(0);
+
+    binding_t io;
+    for (int id = 0; id < 100; ++id) {
+        io.post([&] {
+            ++counter;
+        });
+    }
+
+    io.join();
+
+    EXPECT_EQ(100, counter);
+}
+
+TEST(binding_t, JoinWaitsForPendingOperations) {
+    bool expired = false;
+
+    binding_t io;
+    boost::asio::deadline_timer timer(io.io_service());
+
+    timer.expires_from_now(boost::posix_time::milliseconds(20));
+    timer.async_wait(io.wrap([&](const boost::system::error_code& ec) {
+        expired = !ec;
+    }));
+
+    io.join();
+
+    EXPECT_TRUE(expired);
+}
+
+TEST(binding_t, JoinWaitsForHandlersPostedByHandlers) {
+    std::atomic<int> counter(0);
+
+    binding_t io;
+    io.post([&] {
+        io.post([&] {
+            ++counter;
+        });
+    });
+
+    io.join();
+
+    EXPECT_EQ(1, counter);
+}
+
+TEST(binding_t, SerializesHandlersOnSeveralThreads) {
+    const auto reactor = std::make_shared<reactor_t>(4);
+
+    int counter = 0;
+    bool inside = false;
+    std::atomic<bool> overlapped(false);
+
+    {
+        binding_t io(reactor);
+
+        for (int id = 0; id < 1000; ++id) {
+            io.post([&] {
+                if (inside) {
+                    overlapped = true;
+                }
+
+                inside = true;
+                ++counter;
+                inside = false;
+            });
+        }
+    }
+
+    EXPECT_EQ(1000, counter);
+    EXPECT_FALSE(overlapped);
+}
+
+}  // namespace
+}  // namespace sink
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,295 @@
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <blackhole/attribute.hpp>
+#include <blackhole/attributes.hpp>
+#include <blackhole/extensions/writer.hpp>
+#include <blackhole/record.hpp>
+#include <blackhole/detail/sink/ring.hpp>
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+namespace {
+
+auto push(ring_t& ring, const std::string& value) -> bool {
+    const auto reservation = ring.reserve(value.size());
+
+    if (reservation.data == nullptr) {
+        return false;
+    }
+
+    std::memcpy(reservation.data, value.data(), value.size());
+    ring.commit(reservation);
+    return true;
+}
+
+auto pop(ring_t& ring) -> std::string {
+    ring_t::slot_t slot;
+
+    if (ring.read(slot)) {
+        return std::string(slot.data, slot.size);
+    }
+
+    return "<empty>";
+}
+
+TEST(ring_t, ThrowsOnInvalidCapacity) {
+    EXPECT_THROW(ring_t(100), std::invalid_argument);
+    EXPECT_THROW(ring_t(32), std::invalid_argument);
+}
+
+TEST(ring_t, Empty) {
+    ring_t ring(64);
+
+    EXPECT_TRUE(ring.empty());
+    EXPECT_EQ("<empty>", pop(ring));
+}
+
+TEST(ring_t, PushPop) {
+    ring_t ring(64);
+
+    EXPECT_TRUE(push(ring, "le message"));
+    EXPECT_FALSE(ring.empty());
+    EXPECT_EQ("le message", pop(ring));
+    EXPECT_TRUE(ring.empty());
+}
+
+TEST(ring_t, PushPopWithPrefaultedPages) {
+    detail::paging_t paging;
+    paging.populate = true;
+
+    ring_t ring(64, paging);
+
+    EXPECT_TRUE(ring.empty());
+    EXPECT_TRUE(push(ring, "le message"));
+    EXPECT_EQ("le message", pop(ring));
+    EXPECT_TRUE(ring.empty());
+}
+
+TEST(ring_t, UncommittedSlotBlocksReading) {
+    ring_t ring(64);
+
+    const auto reservation = ring.reserve(4);
+    ASSERT_NE(nullptr, reservation.data);
+
+    EXPECT_TRUE(push(ring, "#2"));
+    EXPECT_EQ("<empty>", pop(ring));
+
+    std::memcpy(reservation.data, "#1__", 4);
+    ring.commit(reservation);
+
+    EXPECT_EQ("#1__", pop(ring));
+    EXPECT_EQ("#2", pop(ring));
+}
+
+TEST(ring_t, Overflow) {
+    ring_t ring(64);
+
+    // Each slot takes 8 bytes of header and 24 bytes of payload.
+    EXPECT_TRUE(push(ring, std::string(24, 'a')));
+    EXPECT_TRUE(push(ring, std::string(24, 'b')));
+    EXPECT_FALSE(push(ring, "c"));
+
+    EXPECT_EQ(std::string(24, 'a'), pop(ring));
+    EXPECT_FALSE(push(ring, "c"));
+
+    ring.release();
+    EXPECT_TRUE(push(ring, "c"));
+}
+
+TEST(ring_t, NeverFits) {
+    ring_t ring(64);
+
+    EXPECT_TRUE(ring.fits(56));
+    EXPECT_FALSE(ring.fits(57));
+    EXPECT_FALSE(push(ring, std::string(57, 'a')));
+}
+
+TEST(ring_t, WrapsAround) {
+    ring_t ring(64);
+
+    for (int i = 0; i < 100; ++i) {
+        const auto value = std::to_string(i) + std::string(static_cast<std::size_t>(i % 20), '.');
+
+        ASSERT_TRUE(push(ring, value));
+        ASSERT_EQ(value, pop(ring));
+        ring.release();
+    }
+}
+
+TEST(ring_t, VisitsUnreleasedSlots) {
+    ring_t ring(64);
+
+    EXPECT_TRUE(push(ring, "#1"));
+    EXPECT_TRUE(push(ring, "#2"));
+    EXPECT_EQ("#1", pop(ring));
+
+    const auto reservation = ring.reserve(2);
+    ASSERT_NE(nullptr, reservation.data);
+    EXPECT_TRUE(push(ring, "#4"));
+
+    std::vector<std::string> visited;
+    ring.visit([](const ring_t::slot_t& slot, void* context) {
+        static_cast<std::vector<std::string>*>(context)->emplace_back(slot.data, slot.size);
+    }, &visited);
+
+    // Read slots are visited until released, while visiting stops at the uncommitted one.
+    EXPECT_EQ((std::vector<std::string>{"#1", "#2"}), visited);
+}
+
+TEST(ring_t, MultipleProducers) {
+    ring_t ring(1024);
+
+    const int nthreads = 4;
+    const int count = 10000;
+
+    std::vector<std::thread> threads;
+    for (int tid = 0; tid < nthreads; ++tid) {
+        threads.emplace_back([&, tid] {
+            for (int i = 0; i < count; ++i) {
+                const auto value = std::to_string(tid) + ":" + std::to_string(i);
+
+                while (!push(ring, value)) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    std::vector<int> last(nthreads, -1);
+
+    for (int nread = 0; nread < nthreads * count;) {
+        ring_t::slot_t slot;
+
+        if (ring.read(slot)) {
+            const std::string value(slot.data, slot.size);
+            const auto pos = value.find(':');
+            const auto tid = std::stoi(value.substr(0, pos));
+            const auto id = std::stoi(value.substr(pos + 1));
+
+            EXPECT_EQ(last[static_cast<std::size_t>(tid)] + 1, id);
+            last[static_cast<std::size_t>(tid)] = id;
+            ++nread;
+        } else {
+            ring.release();
+            std::this_thread::yield();
+        }
+    }
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+struct endpoint_t {
+    std::string host;
+    std::uint16_t port;
+};
+
+}  // namespace
+}  // namespace sink
+
+template<>
+struct display_traits<sink::endpoint_t> {
+    static auto apply(const sink::endpoint_t& value, writer_t& wr) -> void {
+        wr.write("{}:{}", value.host, value.port);
+    }
+};
+
+namespace sink {
+namespace ring {
+namespace {
+
+TEST(ring, EncodeDecode) {
+    const endpoint_t endpoint{"localhost", 8080};
+
+    const string_view message("GET /porn.png HTTP/1.1 - {}");
+    const attribute_list a1{{"null", nullptr}, {"bool", true}, {"sint64", -42}};
+    const attribute_list a2{
+        {"uint64", 42U},
+        {"double", 3.1415},
+        {"string", "value"},
+        {"endpoint", endpoint}
+    };
+    const attribute_pack pack{a1, a2};
+
+    record_t record(4, message, pack);
+    record.activate("GET /porn.png HTTP/1.1 - 200");
+
+    const auto encoded = encode(record, "[4] GET /porn.png HTTP/1.1 - 200");
+
+    decoded_t decoded;
+    decoded.decode({encoded.data(), encoded.size()});
+
+    const auto& result = decoded.record();
+
+    EXPECT_EQ(4, result.severity());
+    EXPECT_EQ("GET /porn.png HTTP/1.1 - {}", result.message().to_string());
+    EXPECT_EQ("GET /porn.png HTTP/1.1 - 200", result.formatted().to_string());
+    EXPECT_EQ(record.timestamp(), result.timestamp());
+    EXPECT_EQ(record.tid(), result.tid());
+    EXPECT_EQ(record.lwp(), result.lwp());
+    EXPECT_EQ("[4] GET /porn.png HTTP/1.1 - 200", decoded.output().to_string());
+
+    const attribute_list expected{
+        {"null", nullptr},
+        {"bool", true},
+        {"sint64", -42},
+        {"uint64", 42U},
+        {"double", 3.1415},
+        {"string", "value"},
+        {"endpoint", "localhost:8080"}
+    };
+
+    ASSERT_EQ(1, result.attributes().size());
+    EXPECT_EQ(expected, result.attributes().at(0).get());
+}
+
+TEST(ring, DecodeReusesStorage) {
+    const string_view message("-");
+    const attribute_list attributes{{"key#1", 42}};
+    const attribute_pack pack{attributes};
+    const attribute_pack empty;
+
+    const record_t r1(0, message, pack);
+    const record_t r2(1, message, empty);
+
+    decoded_t decoded;
+
+    auto encoded = encode(r1, "");
+    decoded.decode({encoded.data(), encoded.size()});
+    ASSERT_EQ(1, decoded.record().attributes().at(0).get().size());
+
+    encoded = encode(r2, "");
+    decoded.decode({encoded.data(), encoded.size()});
+    EXPECT_EQ(1, decoded.record().severity());
+    EXPECT_EQ(0, decoded.record().attributes().at(0).get().size());
+}
+
+TEST(ring, Valid) {
+    const string_view message("-");
+    const attribute_list attributes{{"key", "value"}, {"number", 42}};
+    const attribute_pack pack{attributes};
+
+    const record_t record(0, message, pack);
+    const auto encoded = encode(record, "-").to_string();
+
+    EXPECT_TRUE(valid({encoded.data(), encoded.size()}));
+
+    for (std::size_t size = 0; size < encoded.size(); ++size) {
+        EXPECT_FALSE(valid({encoded.data(), size}));
+    }
+
+    const auto extended = encoded + "x";
+    EXPECT_FALSE(valid({extended.data(), extended.size()}));
+}
+
+}  // namespace
+}  // namespace ring
+}  // namespace sink
+}  // namespace v1
+}  // namespace blackhole
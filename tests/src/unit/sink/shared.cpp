@@ -0,0 +1,174 @@
+#include <cstring>
+#include <string>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include <blackhole/attribute.hpp>
+#include <blackhole/attributes.hpp>
+#include <blackhole/record.hpp>
+#include <blackhole/detail/sink/shared.hpp>
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+namespace {
+
+TEST(shared_record_t, Capture) {
+    const string_view message("GET /porn.png HTTP/1.1");
+    const attribute_list attributes{{"key", {42}}};
+    const attribute_pack pack{attributes};
+    record_t record(4, message, pack);
+
+    const auto shared = shared_record_t::capture(record, "[4] GET /porn.png HTTP/1.1");
+
+    EXPECT_EQ(1, shared.use_count());
+    EXPECT_EQ("[4] GET /porn.png HTTP/1.1", shared.message().to_string());
+    EXPECT_EQ("GET /porn.png HTTP/1.1", shared.record().message().to_string());
+    EXPECT_EQ(4, shared.record().severity());
+    ASSERT_EQ(1, shared.record().attributes().size());
+    EXPECT_EQ(attributes, shared.record().attributes().at(0).get());
+}
+
+TEST(shared_record_t, CaptureOutsideOfScopeCopies) {
+    const string_view message("GET /porn.png HTTP/1.1");
+    const attribute_pack pack;
+    record_t record(0, message, pack);
+
+    const auto s1 = shared_record_t::capture(record, message);
+    const auto s2 = shared_record_t::capture(record, message);
+
+    EXPECT_EQ(1, s1.use_count());
+    EXPECT_EQ(1, s2.use_count());
+}
+
+TEST(shared_record_t, CaptureInsideOfScopeShares) {
+    const string_view message("GET /porn.png HTTP/1.1");
+    const attribute_pack pack;
+    record_t record(0, message, pack);
+
+    shared_record_t s1;
+    shared_record_t s2;
+
+    {
+        const sharing_t sharing;
+        s1 = shared_record_t::capture(record, message);
+        s2 = shared_record_t::capture(record, message);
+
+        // Includes the reference of the scope.
+        EXPECT_EQ(3, s1.use_count());
+    }
+
+    EXPECT_EQ(2, s1.use_count());
+    EXPECT_EQ(s1.message().data(), s2.message().data());
+}
+
+TEST(shared_record_t, CaptureInsideOfScopeCopiesDifferentMessages) {
+    const string_view message("GET /porn.png HTTP/1.1");
+    const attribute_pack pack;
+    record_t record(0, message, pack);
+
+    const sharing_t sharing;
+    const auto s1 = shared_record_t::capture(record, "#1");
+    const auto s2 = shared_record_t::capture(record, "#2");
+
+    EXPECT_EQ("#1", s1.message().to_string());
+    EXPECT_EQ("#2", s2.message().to_string());
+}
+
+TEST(shared_record_t, NestedScopesDoNotShare) {
+    // Literals are immortal, so they would be shared by any captured record.
+    const std::string pattern("GET /porn.png HTTP/1.1");
+    const string_view message(pattern);
+    const attribute_pack pack;
+    record_t record(0, message, pack);
+
+    const sharing_t outer;
+    const auto s1 = shared_record_t::capture(record, message);
+
+    {
+        const sharing_t inner;
+        const auto s2 = shared_record_t::capture(record, message);
+        EXPECT_NE(s1.message().data(), s2.message().data());
+    }
+
+    const auto s3 = shared_record_t::capture(record, message);
+    EXPECT_EQ(s1.message().data(), s3.message().data());
+}
+
+TEST(shared_record_t, CaptureLargeMessage) {
+    const string_view message("GET /porn.png HTTP/1.1");
+    const attribute_pack pack;
+    record_t record(0, message, pack);
+
+    // Both within and beyond size classes.
+    for (std::size_t size : {8192, 100000}) {
+        const std::string formatted(size, 'x');
+        const auto shared = shared_record_t::capture(record, formatted);
+
+        EXPECT_EQ(formatted, shared.message().to_string());
+    }
+}
+
+TEST(shared_record_t, ReserveLendsRoomForMessage) {
+    const string_view message("GET /porn.png HTTP/1.1");
+    const attribute_list attributes{{"key", {42}}};
+    const attribute_pack pack{attributes};
+    record_t record(4, message, pack);
+
+    auto shared = shared_record_t::reserve(record, 16);
+
+    const auto room = shared.room();
+    ASSERT_NE(nullptr, room.data);
+    EXPECT_LE(16, room.size);
+
+    std::memcpy(room.data, "[4] GET", 7);
+    shared.complete(7);
+
+    EXPECT_EQ("[4] GET", shared.message().to_string());
+    EXPECT_EQ(room.data, shared.message().data());
+    EXPECT_EQ("GET /porn.png HTTP/1.1", shared.record().message().to_string());
+    EXPECT_EQ(attributes, shared.record().attributes().at(0).get());
+}
+
+TEST(shared_record_t, ReserveLargeMessage) {
+    const string_view message("-");
+    const attribute_pack pack;
+    record_t record(0, message, pack);
+
+    const auto shared = shared_record_t::reserve(record, 1024 * 1024);
+    EXPECT_LE(1024 * 1024, shared.room().size);
+}
+
+TEST(shared_record_t, ReusesPooledBlocks) {
+    const string_view message("GET /porn.png HTTP/1.1");
+    const attribute_pack pack;
+    record_t record(0, message, pack);
+
+    const auto data = shared_record_t::capture(record, message).message().data();
+
+    EXPECT_EQ(data, shared_record_t::capture(record, message).message().data());
+}
+
+TEST(shared_record_t, ReturnsBlocksReleasedByOtherThreadsToOwner) {
+    const string_view message("GET /porn.png HTTP/1.1");
+    const attribute_pack pack;
+    record_t record(0, message, pack);
+
+    // The owning thread starts with an empty pool.
+    std::thread([&] {
+        auto value = shared_record_t::capture(record, message);
+        const auto data = value.message().data();
+
+        std::thread([&] {
+            value = shared_record_t();
+        }).join();
+
+        EXPECT_EQ(data, shared_record_t::capture(record, message).message().data());
+    }).join();
+}
+
+}  // namespace
+}  // namespace sink
+}  // namespace v1
+}  // namespace blackhole
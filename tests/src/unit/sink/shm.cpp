@@ -0,0 +1,248 @@
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <boost/lexical_cast.hpp>
+
+#include <blackhole/attribute.hpp>
+#include <blackhole/attributes.hpp>
+#include <blackhole/record.hpp>
+#include <blackhole/sink/shm.hpp>
+
+#include <blackhole/detail/sink/ring.hpp>
+#include <blackhole/detail/sink/shm.hpp>
+
+#include "mocks/node.hpp"
+#include "mocks/registry.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+namespace {
+
+using ::testing::Return;
+using ::testing::StrictMock;
+
+/// Unique shared memory object name, which is unlinked at the scope exit.
+class name_t {
+    std::string value;
+
+public:
+    name_t() :
+        value("/blackhole-test-" + boost::lexical_cast<std::string>(::getpid()))
+    {
+        ::shm_unlink(value.c_str());
+    }
+
+    ~name_t() {
+        ::shm_unlink(value.c_str());
+    }
+
+    auto get() const -> const std::string& {
+        return value;
+    }
+};
+
+auto pop(shm::reader_t& reader) -> std::string {
+    shm::reader_t::slot_type slot;
+
+    if (reader.read(slot)) {
+        return slot.to_string();
+    }
+
+    return "<empty>";
+}
+
+TEST(shm_t, ThrowsOnInvalidCapacity) {
+    name_t name;
+
+    EXPECT_THROW(shm_t(name.get(), 1000), std::invalid_argument);
+    EXPECT_THROW(shm_t(name.get(), 64), std::invalid_argument);
+}
+
+TEST(shm_t, ReaderThrowsOnMissingObject) {
+    name_t name;
+
+    EXPECT_THROW(shm::reader_t reader(name.get()), std::system_error);
+}
+
+TEST(shm_t, EmitText) {
+    name_t name;
+    shm_t sink(name.get(), 4096);
+    shm::reader_t reader(name.get());
+
+    EXPECT_EQ(4096, reader.capacity());
+    EXPECT_EQ(shm::format_t::text, reader.format());
+
+    const string_view message("");
+    const attribute_pack pack;
+    const record_t record(0, message, pack);
+
+    sink.emit(record, "first");
+    sink.emit(record, "second");
+
+    EXPECT_EQ("first", pop(reader));
+    EXPECT_EQ("second", pop(reader));
+    EXPECT_EQ("<empty>", pop(reader));
+}
+
+TEST(shm_t, EmitBinary) {
+    name_t name;
+    shm_t sink(name.get(), 4096, shm::format_t::binary);
+    shm::reader_t reader(name.get());
+
+    const string_view message("GET {}");
+    const attribute_list attributes{{"status", 200}};
+    const attribute_pack pack{attributes};
+    record_t record(3, message, pack);
+    record.activate("GET /");
+
+    sink.emit(record, "[3] GET /");
+
+    shm::reader_t::slot_type slot;
+    ASSERT_TRUE(reader.read(slot));
+
+    ring::decoded_t decoded;
+    decoded.decode({slot.data(), slot.size()});
+
+    EXPECT_EQ(3, decoded.record().severity());
+    EXPECT_EQ("GET /", decoded.record().formatted().to_string());
+    EXPECT_EQ("[3] GET /", decoded.output().to_string());
+    EXPECT_EQ(attributes, decoded.record().attributes().at(0).get());
+}
+
+TEST(shm_t, DropsWhenReaderFallsBehind) {
+    name_t name;
+    shm_t sink(name.get(), 4096);
+    shm::reader_t reader(name.get());
+
+    const string_view message("");
+    const attribute_pack pack;
+    const record_t record(0, message, pack);
+
+    const std::string value(1000, 'x');
+    for (int id = 0; id < 5; ++id) {
+        sink.emit(record, value);
+    }
+
+    EXPECT_EQ(1, sink.dropped());
+    EXPECT_EQ(1, reader.dropped());
+
+    for (int id = 0; id < 4; ++id) {
+        EXPECT_EQ(value, pop(reader));
+    }
+
+    reader.release();
+
+    // Released space is available again, wrapping around the ring end.
+    sink.emit(record, value);
+    sink.emit(record, value);
+
+    EXPECT_EQ(1, sink.dropped());
+    EXPECT_EQ(value, pop(reader));
+    EXPECT_EQ(value, pop(reader));
+}
+
+TEST(shm_t, DoorbellWakesReader) {
+    name_t name;
+    shm_t sink(name.get(), 4096);
+    shm::reader_t reader(name.get());
+
+    std::atomic<bool> woken(false);
+    std::thread thread([&] {
+        while (!reader.wait(std::chrono::milliseconds(5000))) {
+        }
+
+        woken = true;
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    const string_view message("");
+    const attribute_pack pack;
+    const record_t record(0, message, pack);
+
+    sink.emit(record, "wake up");
+
+    thread.join();
+
+    EXPECT_TRUE(woken);
+    EXPECT_EQ("wake up", pop(reader));
+}
+
+TEST(shm_t, ReattachContinues) {
+    name_t name;
+
+    const string_view message("");
+    const attribute_pack pack;
+    const record_t record(0, message, pack);
+
+    {
+        shm_t sink(name.get(), 4096);
+        sink.emit(record, "first");
+    }
+
+    shm_t sink(name.get(), 4096);
+    sink.emit(record, "second");
+
+    shm::reader_t reader(name.get());
+    EXPECT_EQ("first", pop(reader));
+    EXPECT_EQ("second", pop(reader));
+}
+
+TEST(shm_t, FactoryType) {
+    EXPECT_EQ(std::string("shm"), factory<shm_t>(mock_registry_t()).type());
+}
+
+TEST(shm_t, Factory) {
+    using config::testing::mock::node_t;
+
+    name_t name;
+    StrictMock<node_t> config;
+
+    auto n1 = new node_t;
+    EXPECT_CALL(config, subscript_key("name"))
+        .Times(1)
+        .WillOnce(Return(n1));
+
+    EXPECT_CALL(*n1, to_string())
+        .Times(1)
+        .WillOnce(Return(name.get()));
+
+    auto n2 = new node_t;
+    EXPECT_CALL(config, subscript_key("capacity"))
+        .Times(1)
+        .WillOnce(Return(n2));
+
+    EXPECT_CALL(*n2, to_uint64())
+        .Times(1)
+        .WillOnce(Return(8192));
+
+    auto n3 = new node_t;
+    EXPECT_CALL(config, subscript_key("format"))
+        .Times(1)
+        .WillOnce(Return(n3));
+
+    EXPECT_CALL(*n3, to_string())
+        .Times(1)
+        .WillOnce(Return("binary"));
+
+    const auto sink = factory<shm_t>(mock_registry_t()).from(config);
+    const auto& cast = dynamic_cast<const shm_t&>(*sink);
+
+    EXPECT_EQ(name.get(), cast.name());
+    EXPECT_EQ(8192, cast.capacity());
+    EXPECT_EQ(shm::format_t::binary, cast.format());
+}
+
+}  // namespace
+}  // namespace sink
+}  // namespace v1
+}  // namespace blackhole
@@ -0,0 +1,120 @@
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <zlib.h>
+
+#include <src/sink/socket/compression.hpp>
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+namespace socket {
+namespace {
+
+/// Decompresses as much as possible of the given possibly incomplete zlib stream.
+auto inflate(const std::string& data, const std::string& dictionary = "") -> std::string {
+    z_stream stream{};
+    EXPECT_EQ(Z_OK, ::inflateInit(&stream));
+
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+    stream.avail_in = static_cast<uInt>(data.size());
+
+    std::string result;
+    char buffer[4096];
+
+    while (true) {
+        stream.next_out = reinterpret_cast<Bytef*>(buffer);
+        stream.avail_out = sizeof(buffer);
+
+        auto rc = ::inflate(&stream, Z_NO_FLUSH);
+        if (rc == Z_NEED_DICT) {
+            EXPECT_EQ(Z_OK, ::inflateSetDictionary(&stream,
+                reinterpret_cast<const Bytef*>(dictionary.data()),
+                static_cast<uInt>(dictionary.size())));
+            rc = Z_OK;
+        }
+
+        result.append(buffer, sizeof(buffer) - stream.avail_out);
+
+        if (rc != Z_OK || (stream.avail_in == 0 && stream.avail_out != 0)) {
+            break;
+        }
+    }
+
+    ::inflateEnd(&stream);
+    return result;
+}
+
+TEST(compressor_t, ThrowsOnInvalidLevel) {
+    EXPECT_THROW(compressor_t(0, ""), std::invalid_argument);
+    EXPECT_THROW(compressor_t(10, ""), std::invalid_argument);
+}
+
+TEST(compressor_t, FlushedBatchesAreDecodableIncrementally) {
+    compressor_t compressor(6, "");
+
+    std::string output;
+    compressor.compress("first\n", 6, true, output);
+
+    EXPECT_EQ("first\n", inflate(output));
+
+    compressor.compress("second\n", 7, false, output);
+    compressor.compress(nullptr, 0, true, output);
+
+    EXPECT_EQ("first\nsecond\n", inflate(output));
+}
+
+TEST(compressor_t, DeclaresDictionary) {
+    const std::string dictionary(R"({"severity": "info", "message": ")");
+    compressor_t compressor(6, dictionary);
+
+    const std::string message(R"({"severity": "info", "message": "started"})");
+
+    std::string output;
+    compressor.compress(message.data(), message.size(), true, output);
+
+    // Header flags declare the dictionary.
+    ASSERT_GE(output.size(), 6);
+    EXPECT_NE(0, output[1] & 0x20);
+    EXPECT_EQ(message, inflate(output, dictionary));
+}
+
+TEST(compressor_t, ResetStartsNewStream) {
+    compressor_t compressor(6, "");
+
+    std::string output;
+    compressor.compress("first\n", 6, true, output);
+
+    compressor.reset();
+
+    output.clear();
+    compressor.compress("second\n", 7, true, output);
+
+    EXPECT_EQ("second\n", inflate(output));
+}
+
+TEST(train, ConcatenatesSmallSamples) {
+    EXPECT_EQ("ab", train({"a", "b"}, 1024));
+}
+
+TEST(train, PicksCommonSubstrings) {
+    std::vector<std::string> samples;
+    for (int id = 0; id < 1000; ++id) {
+        samples.push_back(R"({"service": "frontend", "request": )" + std::to_string(id * 7919) + "}");
+    }
+
+    const auto dictionary = train(samples, 256);
+
+    EXPECT_LE(dictionary.size(), 256);
+    EXPECT_NE(std::string::npos, dictionary.find(R"("service": "frontend")"));
+    EXPECT_EQ(dictionary, train(samples, 256));
+}
+
+}  // namespace
+}  // namespace socket
+}  // namespace sink
+}  // namespace v1
+}  // namespace blackhole
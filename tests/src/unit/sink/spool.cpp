@@ -0,0 +1,226 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <blackhole/attribute.hpp>
+#include <blackhole/record.hpp>
+#include <blackhole/sink/spool.hpp>
+
+#include <blackhole/detail/sink/spool.hpp>
+
+#include "mocks/node.hpp"
+#include "mocks/registry.hpp"
+#include "temporary.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+namespace {
+
+using ::testing::Return;
+using ::testing::StrictMock;
+
+/// Collects messages, failing while told to.
+class collector_t : public sink_t {
+public:
+    std::atomic<bool> failing;
+
+    mutable std::mutex mutex;
+    std::vector<std::string> messages;
+
+    collector_t() :
+        failing(false)
+    {}
+
+    auto emit(const record_t&, const string_view& message) -> void override {
+        if (failing) {
+            throw std::runtime_error("unavailable");
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        messages.push_back(message.to_string());
+    }
+
+    auto received() const -> std::vector<std::string> {
+        std::lock_guard<std::mutex> lock(mutex);
+        return messages;
+    }
+};
+
+/// Forwards records into the collector, which outlives the spool.
+class forward_t : public sink_t {
+    collector_t& collector;
+
+public:
+    explicit forward_t(collector_t& collector) :
+        collector(collector)
+    {}
+
+    auto emit(const record_t& record, const string_view& message) -> void override {
+        collector.emit(record, message);
+    }
+};
+
+auto deadline() -> std::chrono::steady_clock::time_point {
+    return std::chrono::steady_clock::now() + std::chrono::seconds(10);
+}
+
+auto expected(std::size_t size) -> std::vector<std::string> {
+    std::vector<std::string> result;
+    for (std::size_t id = 0; id < size; ++id) {
+        result.push_back("message #" + std::to_string(id));
+    }
+
+    return result;
+}
+
+class spool : public ::testing::Test {
+protected:
+    const blackhole::testing::temporary_directory_t temporary{"spool"};
+    const std::string directory{temporary.path()};
+    collector_t collector;
+
+    auto list() const -> std::vector<std::string> {
+        return temporary.list();
+    }
+
+    auto options() const -> spool_t::options_t {
+        spool_t::options_t options;
+        options.path = directory;
+        options.capacity = 4096;
+        options.segment = 1024;
+        options.backoff = std::chrono::milliseconds(10);
+        return options;
+    }
+
+    auto make(const spool_t::options_t& options) -> std::unique_ptr<spool_t> {
+        return std::unique_ptr<spool_t>(
+            new spool_t(std::unique_ptr<sink_t>(new forward_t(collector)), options));
+    }
+
+    auto emit(spool_t& sink, std::size_t size) -> void {
+        const string_view message("");
+        const attribute_pack pack;
+        const record_t record(0, message, pack);
+
+        for (const auto& value : expected(size)) {
+            sink.emit(record, value);
+        }
+    }
+};
+
+TEST_F(spool, EmitsIntoWrappedSink) {
+    auto sink = make(options());
+
+    emit(*sink, 10);
+
+    EXPECT_TRUE(sink->flush(deadline()));
+    EXPECT_EQ(expected(10), collector.received());
+    EXPECT_EQ(0, sink->spilled());
+}
+
+TEST_F(spool, SpillsWhileWrappedSinkFailsAndReplaysInOrder) {
+    auto sink = make(options());
+
+    collector.failing = true;
+    emit(*sink, 200);
+
+    EXPECT_LT(0, sink->spilled());
+    EXPECT_FALSE(list().empty());
+
+    collector.failing = false;
+
+    EXPECT_TRUE(sink->flush(deadline()));
+    EXPECT_EQ(expected(200), collector.received());
+    EXPECT_EQ(sink->spilled(), sink->replayed());
+    EXPECT_TRUE(list().empty());
+
+    // Records go through memory again once the spool is drained.
+    const auto spilled = sink->spilled();
+    emit(*sink, 1);
+
+    EXPECT_TRUE(sink->flush(deadline()));
+    EXPECT_EQ(spilled, sink->spilled());
+}
+
+TEST_F(spool, ReplaysSegmentsLeftByPreviousRun) {
+    collector.failing = true;
+
+    {
+        auto sink = make(options());
+        emit(*sink, 100);
+    }
+
+    EXPECT_TRUE(collector.received().empty());
+    EXPECT_FALSE(list().empty());
+
+    collector.failing = false;
+
+    auto sink = make(options());
+    EXPECT_TRUE(sink->flush(deadline()));
+
+    // Records left in memory are spilled after the others on destruction.
+    auto received = collector.received();
+    auto values = expected(100);
+    std::sort(received.begin(), received.end());
+    std::sort(values.begin(), values.end());
+
+    EXPECT_EQ(values, received);
+    EXPECT_TRUE(list().empty());
+}
+
+TEST_F(spool, DropsRecordsAboveDiskLimit) {
+    auto opts = options();
+    opts.limit = 256;
+
+    collector.failing = true;
+
+    auto sink = make(opts);
+    emit(*sink, 200);
+
+    EXPECT_LT(0, sink->dropped());
+
+    collector.failing = false;
+    EXPECT_TRUE(sink->flush(deadline()));
+    EXPECT_EQ(200, collector.received().size() + sink->dropped());
+}
+
+TEST_F(spool, ThrowsOnInvalidOptions) {
+    auto opts = options();
+    opts.path.clear();
+    EXPECT_THROW(make(opts), std::invalid_argument);
+
+    opts = options();
+    opts.watermark = 0.0;
+    EXPECT_THROW(make(opts), std::invalid_argument);
+
+    opts = options();
+    opts.capacity = 1000;
+    EXPECT_THROW(make(opts), std::invalid_argument);
+}
+
+TEST(spool_t, FactoryType) {
+    EXPECT_EQ(std::string("spool"), factory<spool_t>(mock_registry_t()).type());
+}
+
+TEST(spool_t, FactoryThrowsIfPathParameterIsMissing) {
+    StrictMock<config::testing::mock::node_t> config;
+
+    EXPECT_CALL(config, subscript_key("path"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
+    EXPECT_THROW(factory<spool_t>(mock_registry_t()).from(config), std::invalid_argument);
+}
+
+}  // namespace
+}  // namespace sink
+}  // namespace v1
+}  // namespace blackhole
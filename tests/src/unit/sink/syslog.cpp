@@ -1,8 +1,22 @@
+#include <sys/socket.h>
+#include <sys/un.h>
 #include <syslog.h>
+#include <unistd.h>
+
+#include <array>
+#include <cstdio>
+#include <cstring>
+
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/ip/udp.hpp>
+#include <boost/asio/read.hpp>
+#include <boost/lexical_cast.hpp>
 
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <blackhole/attribute.hpp>
+#include <blackhole/record.hpp>
 #include <blackhole/stdext/string_view.hpp>
 #include <blackhole/sink/syslog.hpp>
 
@@ -18,6 +32,8 @@ namespace sink {
 namespace {
 
 using ::testing::_;
+using ::testing::HasSubstr;
+using ::testing::StartsWith;
 using ::testing::Invoke;
 using ::testing::Return;
 using ::testing::StrictMock;
@@ -52,6 +68,14 @@ TEST(syslog_t, Factory) {
         .WillOnce(Return(5))
         .WillOnce(Return(9));
 
+    EXPECT_CALL(config, subscript_key("address"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
+    EXPECT_CALL(config, subscript_key("format"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
     auto sink = factory<syslog_t>(mock_registry_t()).from(config);
     const auto& cast = dynamic_cast<const syslog_t&>(*sink);
 
@@ -66,6 +90,231 @@ TEST(syslog_t, Default) {
     EXPECT_EQ(LOG_USER, syslog.facility());
 }
 
+/// Local datagram socket bound to a temporary path, like syslog daemon's "/dev/log".
+class local_t {
+    std::string path_;
+    int fd;
+
+public:
+    local_t() :
+        path_("/tmp/blackhole-syslog-" + boost::lexical_cast<std::string>(::getpid())),
+        fd(::socket(AF_UNIX, SOCK_DGRAM, 0))
+    {
+        ::unlink(path_.c_str());
+
+        struct sockaddr_un address;
+        std::memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        std::strcpy(address.sun_path, path_.c_str());
+
+        ::bind(fd, reinterpret_cast<struct sockaddr*>(&address), sizeof(address));
+    }
+
+    ~local_t() {
+        ::close(fd);
+        ::unlink(path_.c_str());
+    }
+
+    auto path() const -> const std::string& {
+        return path_;
+    }
+
+    auto receive() -> std::string {
+        std::array<char, 4096> buffer;
+        const auto size = ::recv(fd, buffer.data(), buffer.size(), 0);
+
+        return std::string(buffer.data(), size > 0 ? static_cast<std::size_t>(size) : 0);
+    }
+};
+
+TEST(syslog_t, NativeThrowsOnMalformedAddress) {
+    EXPECT_THROW(syslog_t("udp://localhost"), std::invalid_argument);
+    EXPECT_THROW(syslog_t("tcp://:514"), std::invalid_argument);
+    EXPECT_THROW(syslog_t(""), std::invalid_argument);
+}
+
+TEST(syslog_t, NativeThrowsIfUnableToConnect) {
+    EXPECT_THROW(syslog_t("/tmp/blackhole-syslog-nonexisting"), std::system_error);
+}
+
+TEST(syslog_t, NativeLocalRfc3164) {
+    local_t local;
+    syslog_t sink(local.path());
+
+    EXPECT_EQ(local.path(), sink.address());
+    EXPECT_EQ(syslog_t::format_t::rfc3164, sink.format());
+
+    const string_view message("");
+    const attribute_pack pack;
+    const record_t record(0, message, pack);
+
+    sink.emit(record, "le message");
+
+    const auto frame = local.receive();
+    const auto tag = " " + detail::procname().to_string() + "[" +
+        boost::lexical_cast<std::string>(::getpid()) + "]: le message";
+
+    // Priority of the error with user facility followed by "Mmm dd hh:mm:ss" time stamp.
+    EXPECT_THAT(frame, StartsWith("<11>"));
+    EXPECT_EQ(4 + 15 + tag.size(), frame.size());
+    EXPECT_EQ(tag, frame.substr(4 + 15));
+}
+
+TEST(syslog_t, NativeLocalRfc5424) {
+    local_t local;
+    syslog_t sink(local.path(), syslog_t::format_t::rfc5424);
+    sink.priorities({LOG_DEBUG, LOG_INFO});
+
+    const string_view message("");
+    const attribute_pack pack;
+    const record_t record(1, message, pack);
+
+    sink.emit(record, "le message");
+
+    const auto frame = local.receive();
+    const auto tail = " " + detail::procname().to_string() + " " +
+        boost::lexical_cast<std::string>(::getpid()) + " - - le message";
+
+    // The version follows the priority, then "YYYY-MM-DDThh:mm:ss.uuuuuuZ" time stamp.
+    EXPECT_THAT(frame, StartsWith("<14>1 "));
+    EXPECT_EQ('T', frame[6 + 10]);
+    EXPECT_EQ('.', frame[6 + 19]);
+    EXPECT_EQ('Z', frame[6 + 26]);
+    EXPECT_EQ(tail, frame.substr(frame.size() - tail.size()));
+}
+
+TEST(syslog_t, NativeLocalBatch) {
+    local_t local;
+    syslog_t sink(local.path());
+    sink.priorities({LOG_DEBUG, LOG_INFO, LOG_WARNING});
+
+    const string_view message("");
+    const attribute_pack pack;
+
+    std::vector<record_t> records;
+    std::vector<std::string> messages;
+    // Fits into the default receive queue of local datagram sockets.
+    for (int id = 0; id < 9; ++id) {
+        records.emplace_back(id % 3, message, pack);
+        messages.emplace_back("message #" + boost::lexical_cast<std::string>(id));
+    }
+
+    std::vector<string_view> views(messages.begin(), messages.end());
+    std::vector<sink_t::event_t> events;
+    for (std::size_t id = 0; id < records.size(); ++id) {
+        events.push_back({&records[id], &views[id]});
+    }
+
+    sink.emit_batch(events.data(), events.size());
+
+    const char* headers[] = {"<15>", "<14>", "<12>"};
+    for (std::size_t id = 0; id < messages.size(); ++id) {
+        const auto frame = local.receive();
+
+        EXPECT_THAT(frame, StartsWith(headers[id % 3]));
+        EXPECT_EQ(messages[id], frame.substr(frame.size() - messages[id].size()));
+    }
+}
+
+TEST(syslog_t, NativeUdp) {
+    boost::asio::io_service io_service;
+    boost::asio::ip::udp::socket socket(io_service,
+        boost::asio::ip::udp::endpoint(boost::asio::ip::address_v4::loopback(), 0));
+    const auto port = socket.local_endpoint().port();
+
+    syslog_t sink("udp://127.0.0.1:" + boost::lexical_cast<std::string>(port));
+
+    const string_view message("");
+    const attribute_pack pack;
+    const record_t record(0, message, pack);
+
+    sink.emit(record, "le message");
+
+    std::array<char, 4096> buffer;
+    boost::asio::ip::udp::endpoint remote;
+    const auto size = socket.receive_from(boost::asio::buffer(buffer), remote, 0);
+    const std::string frame(buffer.data(), size);
+
+    // Remote collectors require the host name.
+    char hostname[256] = {};
+    ::gethostname(hostname, sizeof(hostname) - 1);
+
+    EXPECT_THAT(frame, StartsWith("<11>"));
+    EXPECT_THAT(frame, HasSubstr(std::string(" ") + hostname + " "));
+    EXPECT_THAT(frame, HasSubstr("]: le message"));
+}
+
+TEST(syslog_t, NativeTcpUsesOctetCounting) {
+    boost::asio::io_service io_service;
+    boost::asio::ip::tcp::acceptor acceptor(io_service,
+        boost::asio::ip::tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0));
+    const auto port = acceptor.local_endpoint().port();
+
+    syslog_t sink("tcp://127.0.0.1:" + boost::lexical_cast<std::string>(port),
+        syslog_t::format_t::rfc5424);
+
+    boost::asio::ip::tcp::socket socket(io_service);
+    acceptor.accept(socket);
+
+    const string_view message("");
+    const attribute_pack pack;
+    const record_t record(0, message, pack);
+
+    const string_view messages[] = {"first", "second"};
+    const sink_t::event_t events[] = {{&record, &messages[0]}, {&record, &messages[1]}};
+
+    sink.emit_batch(events, 2);
+
+    for (const auto& expected : messages) {
+        std::string length;
+        char ch;
+        while (boost::asio::read(socket, boost::asio::buffer(&ch, 1)) && ch != ' ') {
+            length.push_back(ch);
+        }
+
+        std::string frame(boost::lexical_cast<std::size_t>(length), '\0');
+        boost::asio::read(socket, boost::asio::buffer(&frame[0], frame.size()));
+
+        EXPECT_THAT(frame, StartsWith("<11>1 "));
+        EXPECT_EQ(expected.to_string(), frame.substr(frame.size() - expected.size()));
+    }
+}
+
+TEST(syslog_t, FactoryNative) {
+    using config::testing::mock::node_t;
+
+    local_t local;
+    StrictMock<node_t> config;
+
+    EXPECT_CALL(config, subscript_key("priorities"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
+    auto address = new node_t;
+    EXPECT_CALL(config, subscript_key("address"))
+        .Times(1)
+        .WillOnce(Return(address));
+
+    EXPECT_CALL(*address, to_string())
+        .Times(1)
+        .WillOnce(Return(local.path()));
+
+    auto format = new node_t;
+    EXPECT_CALL(config, subscript_key("format"))
+        .Times(1)
+        .WillOnce(Return(format));
+
+    EXPECT_CALL(*format, to_string())
+        .Times(1)
+        .WillOnce(Return("rfc5424"));
+
+    auto sink = factory<syslog_t>(mock_registry_t()).from(config);
+    const auto& cast = dynamic_cast<const syslog_t&>(*sink);
+
+    EXPECT_EQ(local.path(), cast.address());
+    EXPECT_EQ(syslog_t::format_t::rfc5424, cast.format());
+}
+
 }  // namespace
 }  // namespace sink
 }  // namespace v1
@@ -1,20 +1,39 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
 #include <system_error>
+#include <thread>
 
 #include <boost/array.hpp>
 #include <boost/asio/ip/tcp.hpp>
 #include <boost/asio/read.hpp>
+#include <boost/asio/read_until.hpp>
+#include <boost/asio/streambuf.hpp>
 #include <boost/version.hpp>
 
+#include <zlib.h>
+
+#ifdef BLACKHOLE_HAS_TLS
+#   include <openssl/pem.h>
+#   include <openssl/ssl.h>
+#   include <openssl/x509v3.h>
+#endif
+
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
 #include <blackhole/attribute.hpp>
 #include <blackhole/record.hpp>
 #include <blackhole/sink/socket/tcp.hpp>
+#include <src/sink/socket/balanced.hpp>
 #include <src/sink/socket/tcp.hpp>
 
 #include "mocks/node.hpp"
 #include "mocks/registry.hpp"
+#include "temporary.hpp"
 
 namespace blackhole {
 inline namespace v1 {
@@ -62,6 +81,109 @@ TEST(tcp, SendsData) {
     EXPECT_EQ('}', buffer[1]);
 }
 
+TEST(tcp, SendsBatch) {
+    boost::asio::io_service io_service;
+    boost::asio::ip::tcp::acceptor acceptor(io_service,
+        boost::asio::ip::tcp::endpoint(boost::asio::ip::tcp::v4(), 0));
+    const auto endpoint = acceptor.local_endpoint();
+
+    tcp_t sink(endpoint.address().to_string(), endpoint.port());
+
+    const string_view message("");
+    const attribute_pack pack;
+    const record_t record(0, message, pack);
+
+    const string_view messages[] = {"{}", "[]"};
+    const sink_t::event_t events[] = {{&record, &messages[0]}, {&record, &messages[1]}};
+
+    sink.emit_batch(events, 2);
+
+    boost::asio::ip::tcp::socket socket(io_service);
+    acceptor.accept(socket);
+
+    boost::array<char, 4> buffer;
+    const auto nread = boost::asio::read(socket, boost::asio::buffer(buffer),
+        boost::asio::transfer_exactly(4));
+
+    ASSERT_EQ(4, nread);
+    EXPECT_EQ("{}[]", std::string(buffer.data(), buffer.size()));
+}
+
+TEST(tcp, FramesBatchWithNewlines) {
+    boost::asio::io_service io_service;
+    boost::asio::ip::tcp::acceptor acceptor(io_service,
+        boost::asio::ip::tcp::endpoint(boost::asio::ip::tcp::v4(), 0));
+    const auto endpoint = acceptor.local_endpoint();
+
+    tcp_t sink(endpoint.address().to_string(), endpoint.port(), framing_t::newline);
+
+    const string_view message("");
+    const attribute_pack pack;
+    const record_t record(0, message, pack);
+
+    const string_view messages[] = {"{}", "[]"};
+    const sink_t::event_t events[] = {{&record, &messages[0]}, {&record, &messages[1]}};
+
+    sink.emit_batch(events, 2);
+    sink.emit(record, "()");
+
+    boost::asio::ip::tcp::socket socket(io_service);
+    acceptor.accept(socket);
+
+    boost::array<char, 9> buffer;
+    boost::asio::read(socket, boost::asio::buffer(buffer), boost::asio::transfer_exactly(9));
+
+    EXPECT_EQ("{}\n[]\n()\n", std::string(buffer.data(), buffer.size()));
+}
+
+TEST(tcp, FramesWithLengthPrefix) {
+    boost::asio::io_service io_service;
+    boost::asio::ip::tcp::acceptor acceptor(io_service,
+        boost::asio::ip::tcp::endpoint(boost::asio::ip::tcp::v4(), 0));
+    const auto endpoint = acceptor.local_endpoint();
+
+    tcp_t sink(endpoint.address().to_string(), endpoint.port(), framing_t::length);
+
+    const string_view message("");
+    const attribute_pack pack;
+    const record_t record(0, message, pack);
+
+    sink.emit(record, "{}");
+
+    boost::asio::ip::tcp::socket socket(io_service);
+    acceptor.accept(socket);
+
+    boost::array<char, 6> buffer;
+    boost::asio::read(socket, boost::asio::buffer(buffer), boost::asio::transfer_exactly(6));
+
+    EXPECT_EQ(std::string("\0\0\0\2{}", 6), std::string(buffer.data(), buffer.size()));
+}
+
+TEST(tcp, NonBlockingFramesWithOctetCounting) {
+    boost::asio::io_service io_service;
+    boost::asio::ip::tcp::acceptor acceptor(io_service,
+        boost::asio::ip::tcp::endpoint(boost::asio::ip::tcp::v4(), 0));
+    const auto endpoint = acceptor.local_endpoint();
+
+    tcp_t sink(endpoint.address().to_string(), endpoint.port(),
+        {1024, nonblocking_t::overflow_t::wait}, framing_t::octet);
+
+    const string_view message("");
+    const attribute_pack pack;
+    const record_t record(0, message, pack);
+
+    sink.emit(record, "{}");
+    sink.emit(record, "le message");
+
+    boost::asio::ip::tcp::socket socket(io_service);
+    acceptor.accept(socket);
+
+    boost::array<char, 17> buffer;
+    boost::asio::read(socket, boost::asio::buffer(buffer), boost::asio::transfer_exactly(17));
+
+    EXPECT_EQ("2 {}10 le message", std::string(buffer.data(), buffer.size()));
+}
+
 TEST(tcp, ThrowsExceptionOnConnectionRefused) {
     tcp_t sink("127.0.0.1", 1023);
 
@@ -72,6 +194,536 @@ TEST(tcp, ThrowsExceptionOnConnectionRefused) {
     EXPECT_THROW(sink.emit(record, "{}"), std::system_error);
 }
 
+TEST(tcp, NonBlockingSendsData) {
+    boost::asio::io_service io_service;
+    boost::asio::ip::tcp::acceptor acceptor(io_service,
+        boost::asio::ip::tcp::endpoint(boost::asio::ip::tcp::v4(), 0));
+    const auto endpoint = acceptor.local_endpoint();
+
+    tcp_t sink(endpoint.address().to_string(), endpoint.port(),
+        {1024, nonblocking_t::overflow_t::wait});
+
+    const string_view message("");
+    const attribute_pack pack;
+    const record_t record(0, message, pack);
+
+    const string_view messages[] = {"[]", "()"};
+    const sink_t::event_t events[] = {{&record, &messages[0]}, {&record, &messages[1]}};
+
+    sink.emit(record, "{}");
+    sink.emit_batch(events, 2);
+
+    boost::asio::ip::tcp::socket socket(io_service);
+    acceptor.accept(socket);
+
+    boost::array<char, 6> buffer;
+    const auto nread = boost::asio::read(socket, boost::asio::buffer(buffer),
+        boost::asio::transfer_exactly(6));
+
+    ASSERT_EQ(6, nread);
+    EXPECT_EQ("{}[]()", std::string(buffer.data(), buffer.size()));
+}
+
+TEST(tcp, NonBlockingDoesNotThrowOnConnectionRefused) {
+    tcp_t sink("127.0.0.1", 1023, {1024, nonblocking_t::overflow_t::drop});
+
+    const string_view message("");
+    const attribute_pack pack;
+    const record_t record(0, message, pack);
+
+    EXPECT_NO_THROW(sink.emit(record, "{}"));
+}
+
+TEST(tcp, NonBlockingDropsOnOverflow) {
+    tcp_t sink("127.0.0.1", 1023, {4, nonblocking_t::overflow_t::drop});
+
+    const string_view message("");
+    const attribute_pack pack;
+    const record_t record(0, message, pack);
+
+    sink.emit(record, "{}");
+    sink.emit(record, "[]");
+    sink.emit(record, "()");
+
+    EXPECT_EQ(1, sink.dropped());
+}
+
+TEST(tcp, NonBlockingReconnects) {
+    boost::asio::io_service io_service;
+    boost::asio::ip::tcp::acceptor acceptor(io_service,
+        boost::asio::ip::tcp::endpoint(boost::asio::ip::tcp::v4(), 0));
+    const auto endpoint = acceptor.local_endpoint();
+
+    tcp_t sink(endpoint.address().to_string(), endpoint.port(),
+        {1024, nonblocking_t::overflow_t::wait});
+
+    const string_view message("");
+    const attribute_pack pack;
+    const record_t record(0, message, pack);
+
+    {
+        boost::asio::ip::tcp::socket socket(io_service);
+        acceptor.accept(socket);
+
+        sink.emit(record, "{}");
+
+        boost::array<char, 2> buffer;
+        boost::asio::read(socket, boost::asio::buffer(buffer), boost::asio::transfer_exactly(2));
+    }
+
+    // Writing into the closed connection fails sooner or later, data buffered afterwards must be
+    // delivered into the new one.
+    boost::asio::ip::tcp::socket socket(io_service);
+
+    for (int id = 0; id < 1000 && !socket.is_open(); ++id) {
+        sink.emit(record, "#");
+
+        acceptor.non_blocking(true);
+        boost::system::error_code ec;
+        acceptor.accept(socket, ec);
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    ASSERT_TRUE(socket.is_open());
+
+    acceptor.non_blocking(false);
+    socket.non_blocking(false);
+    sink.emit(record, "$");
+
+    boost::asio::streambuf buffer;
+    boost::asio::read_until(socket, buffer, '$');
+
+    const std::string received{
+        boost::asio::buffers_begin(buffer.data()), boost::asio::buffers_end(buffer.data())
+    };
+
+    EXPECT_EQ('$', received.back());
+}
+
+
+/// Decompresses the given complete or flushed part of a zlib stream.
+auto inflate(const std::string& data) -> std::string {
+    z_stream stream{};
+    ::inflateInit(&stream);
+
+    std::string result(64 * 1024, '\0');
+
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+    stream.avail_in = static_cast<uInt>(data.size());
+    stream.next_out = reinterpret_cast<Bytef*>(&result[0]);
+    stream.avail_out = static_cast<uInt>(result.size());
+
+    ::inflate(&stream, Z_SYNC_FLUSH);
+    result.resize(result.size() - stream.avail_out);
+
+    ::inflateEnd(&stream);
+    return result;
+}
+
+/// Reads from the socket, appending to the data received so far, until the zlib stream
+/// decompresses into the given size.
+auto receive(boost::asio::ip::tcp::socket& socket, std::string& received, std::size_t size) ->
+    std::string
+{
+    auto result = inflate(received);
+
+    while (result.size() < size) {
+        char buffer[256];
+        boost::system::error_code ec;
+        const auto nread = socket.read_some(boost::asio::buffer(buffer), ec);
+        if (ec) {
+            break;
+        }
+
+        received.append(buffer, nread);
+        result = inflate(received);
+    }
+
+    return result;
+}
+
+TEST(tcp, CompressesStream) {
+    boost::asio::io_service io_service;
+    boost::asio::ip::tcp::acceptor acceptor(io_service,
+        boost::asio::ip::tcp::endpoint(boost::asio::ip::tcp::v4(), 0));
+    const auto endpoint = acceptor.local_endpoint();
+
+    tcp_t sink(endpoint.address().to_string(), endpoint.port(), framing_t::newline, nullptr,
+        compression_t());
+
+    EXPECT_TRUE(sink.compressed());
+
+    const string_view message("");
+    const attribute_pack pack;
+    const record_t record(0, message, pack);
+
+    sink.emit(record, "{}");
+
+    boost::asio::ip::tcp::socket socket(io_service);
+    acceptor.accept(socket);
+
+    // The first message is decodable before the next one is sent.
+    std::string received;
+    EXPECT_EQ("{}\n", receive(socket, received, 3));
+
+    const string_view m1("[1]");
+    const string_view m2("[2]");
+    const sink_t::event_t events[] = {{&record, &m1}, {&record, &m2}};
+    sink.emit_batch(events, 2);
+
+    EXPECT_EQ("{}\n[1]\n[2]\n", receive(socket, received, 11));
+}
+
+TEST(tcp, NonBlockingCompressesWithLinger) {
+    boost::asio::io_service io_service;
+    boost::asio::ip::tcp::acceptor acceptor(io_service,
+        boost::asio::ip::tcp::endpoint(boost::asio::ip::tcp::v4(), 0));
+    const auto endpoint = acceptor.local_endpoint();
+
+    compression_t compression;
+    compression.linger = std::chrono::milliseconds(10);
+
+    tcp_t sink(endpoint.address().to_string(), endpoint.port(),
+        {1024, nonblocking_t::overflow_t::wait}, framing_t::newline, nullptr, compression);
+
+    const string_view message("");
+    const attribute_pack pack;
+    const record_t record(0, message, pack);
+
+    boost::asio::ip::tcp::socket socket(io_service);
+    acceptor.accept(socket);
+
+    sink.emit(record, "{}");
+    sink.emit(record, "[]");
+
+    std::string received;
+    EXPECT_EQ("{}\n[]\n", receive(socket, received, 6));
+}
+
+#ifdef BLACKHOLE_HAS_TLS
+
+/// TLS server with a self-signed certificate for "localhost", accepting a single connection.
+class tls_server_t {
+    boost::asio::io_service io_service;
+    boost::asio::ip::tcp::acceptor acceptor;
+    std::unique_ptr<SSL_CTX, void(*)(SSL_CTX*)> ctx;
+    const blackhole::testing::temporary_file_t pem{"certificate"};
+
+public:
+    /// Path to the certificate in PEM format, which clients trust.
+    std::string certificate;
+
+    tls_server_t() :
+        acceptor(io_service, boost::asio::ip::tcp::endpoint(boost::asio::ip::tcp::v4(), 0)),
+        ctx(SSL_CTX_new(TLS_server_method()), &SSL_CTX_free)
+    {
+        std::unique_ptr<EVP_PKEY_CTX, void(*)(EVP_PKEY_CTX*)> context(
+            EVP_PKEY_CTX_new_id(EVP_PKEY_EC, nullptr), &EVP_PKEY_CTX_free);
+        EVP_PKEY_keygen_init(context.get());
+        EVP_PKEY_CTX_set_ec_paramgen_curve_nid(context.get(), NID_X9_62_prime256v1);
+
+        EVP_PKEY* pkey = nullptr;
+        EVP_PKEY_keygen(context.get(), &pkey);
+        std::unique_ptr<EVP_PKEY, void(*)(EVP_PKEY*)> key(pkey, &EVP_PKEY_free);
+
+        std::unique_ptr<X509, void(*)(X509*)> x509(X509_new(), &X509_free);
+        X509_set_version(x509.get(), 2);
+        ASN1_INTEGER_set(X509_get_serialNumber(x509.get()), 1);
+        X509_gmtime_adj(X509_getm_notBefore(x509.get()), 0);
+        X509_gmtime_adj(X509_getm_notAfter(x509.get()), 3600);
+        X509_set_pubkey(x509.get(), key.get());
+
+        const auto name = X509_get_subject_name(x509.get());
+        X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC,
+            reinterpret_cast<const unsigned char*>("localhost"), -1, -1, 0);
+        X509_set_issuer_name(x509.get(), name);
+
+        const auto extension = X509V3_EXT_conf_nid(nullptr, nullptr, NID_subject_alt_name,
+            "DNS:localhost,IP:127.0.0.1");
+        X509_add_ext(x509.get(), extension, -1);
+        X509_EXTENSION_free(extension);
+
+        X509_sign(x509.get(), key.get(), EVP_sha256());
+
+        SSL_CTX_use_certificate(ctx.get(), x509.get());
+        SSL_CTX_use_PrivateKey(ctx.get(), key.get());
+
+        const auto file = std::fopen(pem.path().c_str(), "w");
+        PEM_write_X509(file, x509.get());
+        std::fclose(file);
+
+        certificate = pem.path();
+    }
+
+    auto port() const -> std::uint16_t {
+        return acceptor.local_endpoint().port();
+    }
+
+    /// Accepts a connection, reading exactly the given number of bytes of data from it.
+    auto read(std::size_t size) -> std::string {
+        boost::asio::ip::tcp::socket socket(io_service);
+        acceptor.accept(socket);
+
+        std::unique_ptr<SSL, void(*)(SSL*)> ssl(SSL_new(ctx.get()), &SSL_free);
+        SSL_set_fd(ssl.get(), socket.native_handle());
+
+        std::string result;
+        if (SSL_accept(ssl.get()) != 1) {
+            return result;
+        }
+
+        char buffer[256];
+        while (result.size() < size) {
+            const auto rc = SSL_read(ssl.get(), buffer, sizeof(buffer));
+            if (rc <= 0) {
+                break;
+            }
+
+            result.append(buffer, static_cast<std::size_t>(rc));
+        }
+
+        return result;
+    }
+};
+
+auto trusting(const std::string& certificate) -> std::shared_ptr<tls::context_t> {
+    tls::options_t options;
+    options.ca = certificate;
+    options.server_name = "localhost";
+    return std::make_shared<tls::context_t>(options);
+}
+
+TEST(tcp, TLSSendsData) {
+    tls_server_t server;
+    tcp_t sink("127.0.0.1", server.port(), framing_t::newline, trusting(server.certificate));
+
+    EXPECT_TRUE(sink.secure());
+
+    std::string received;
+    std::thread thread([&] {
+        received = server.read(6);
+    });
+
+    const string_view message("");
+    const attribute_pack pack;
+    const record_t record(0, message, pack);
+
+    sink.emit(record, "{}");
+
+    const string_view m1("[]");
+    const sink_t::event_t events[] = {{&record, &m1}};
+    sink.emit_batch(events, 1);
+
+    thread.join();
+
+    EXPECT_EQ("{}\n[]\n", received);
+}
+
+TEST(tcp, TLSVerifiesServerAddress) {
+    tls_server_t server;
+
+    tls::options_t options;
+    options.ca = server.certificate;
+    tcp_t sink("127.0.0.1", server.port(), framing_t::none,
+        std::make_shared<tls::context_t>(options));
+
+    std::string received;
+    std::thread thread([&] {
+        received = server.read(2);
+    });
+
+    const string_view message("");
+    const attribute_pack pack;
+    const record_t record(0, message, pack);
+
+    sink.emit(record, "{}");
+    thread.join();
+
+    EXPECT_EQ("{}", received);
+}
+
+TEST(tcp, TLSThrowsOnUntrustedServer) {
+    tls_server_t server;
+
+    tls::options_t options;
+    options.ca = server.certificate;
+    options.server_name = "collector";
+    tcp_t sink("127.0.0.1", server.port(), framing_t::none,
+        std::make_shared<tls::context_t>(options));
+
+    std::thread thread([&] {
+        server.read(2);
+    });
+
+    const string_view message("");
+    const attribute_pack pack;
+    const record_t record(0, message, pack);
+
+    EXPECT_THROW(sink.emit(record, "{}"), std::runtime_error);
+    thread.join();
+}
+
+TEST(tcp, TLSNonBlockingSendsData) {
+    tls_server_t server;
+    tcp_t sink("127.0.0.1", server.port(), {1024, nonblocking_t::overflow_t::wait},
+        framing_t::octet, trusting(server.certificate));
+
+    const string_view message("");
+    const attribute_pack pack;
+    const record_t record(0, message, pack);
+
+    sink.emit(record, "{}");
+    sink.emit(record, "[1]");
+
+    EXPECT_EQ("2 {}3 [1]", server.read(9));
+}
+
+TEST(tcp, TLSThrowsOnMissingCertificate) {
+    tls::options_t options;
+    options.certificate = "/nonexistent/certificate.pem";
+
+    EXPECT_THROW(tls::context_t{options}, std::invalid_argument);
+}
+
+#endif
+
+/// Accepts the connection if there is one and reads everything until the peer closes it.
+auto drain(boost::asio::io_service& io_service, boost::asio::ip::tcp::acceptor& acceptor) ->
+    std::string
+{
+    boost::asio::ip::tcp::socket socket(io_service);
+
+    boost::system::error_code ec;
+    acceptor.non_blocking(true);
+    acceptor.accept(socket, ec);
+
+    if (ec) {
+        return {};
+    }
+
+    socket.non_blocking(false);
+
+    boost::asio::streambuf buffer;
+    boost::asio::read(socket, buffer, boost::asio::transfer_all(), ec);
+
+    return std::string(boost::asio::buffers_begin(buffer.data()),
+        boost::asio::buffers_end(buffer.data()));
+}
+
+auto factory(framing_t framing) -> balanced_t::factory_type {
+    return [=](const endpoint_t& endpoint) {
+        return std::unique_ptr<tcp_t>(new tcp_t(endpoint.host, endpoint.port, framing));
+    };
+}
+
+TEST(balanced_t, DistributesRoundRobin) {
+    boost::asio::io_service io_service;
+    boost::asio::ip::tcp::acceptor first(io_service,
+        boost::asio::ip::tcp::endpoint(boost::asio::ip::tcp::v4(), 0));
+    boost::asio::ip::tcp::acceptor second(io_service,
+        boost::asio::ip::tcp::endpoint(boost::asio::ip::tcp::v4(), 0));
+
+    const string_view message("");
+    const attribute_pack pack;
+    const record_t record(0, message, pack);
+
+    {
+        balanced_t sink({
+            {"127.0.0.1", first.local_endpoint().port()},
+            {"127.0.0.1", second.local_endpoint().port()}
+        }, balancing_t(), factory(framing_t::newline));
+
+        sink.emit(record, "a");
+        sink.emit(record, "b");
+        sink.emit(record, "c");
+        sink.emit(record, "d");
+    }
+
+    EXPECT_EQ("a\nc\n", drain(io_service, first));
+    EXPECT_EQ("b\nd\n", drain(io_service, second));
+}
+
+TEST(balanced_t, TakesFailedEndpointsOutOfRotation) {
+    boost::asio::io_service io_service;
+    boost::asio::ip::tcp::acceptor acceptor(io_service,
+        boost::asio::ip::tcp::endpoint(boost::asio::ip::tcp::v4(), 0));
+
+    // Nothing listens on the port of a closed acceptor.
+    std::uint16_t port;
+    {
+        boost::asio::ip::tcp::acceptor closed(io_service,
+            boost::asio::ip::tcp::endpoint(boost::asio::ip::tcp::v4(), 0));
+        port = closed.local_endpoint().port();
+    }
+
+    const string_view message("");
+    const attribute_pack pack;
+    const record_t record(0, message, pack);
+
+    {
+        balanced_t sink({
+            {"127.0.0.1", port},
+            {"127.0.0.1", acceptor.local_endpoint().port()}
+        }, balancing_t(), factory(framing_t::newline));
+
+        sink.emit(record, "a");
+        sink.emit(record, "b");
+        sink.emit(record, "c");
+
+        EXPECT_FALSE(sink.healthy(0));
+        EXPECT_TRUE(sink.healthy(1));
+    }
+
+    EXPECT_EQ("a\nb\nc\n", drain(io_service, acceptor));
+}
+
+TEST(balanced_t, HashKeepsRecordsWithTheSameValueTogether) {
+    boost::asio::io_service io_service;
+    boost::asio::ip::tcp::acceptor first(io_service,
+        boost::asio::ip::tcp::endpoint(boost::asio::ip::tcp::v4(), 0));
+    boost::asio::ip::tcp::acceptor second(io_service,
+        boost::asio::ip::tcp::endpoint(boost::asio::ip::tcp::v4(), 0));
+
+    balancing_t balancing;
+    balancing.strategy = balancing_t::strategy_t::hash;
+    balancing.attribute = "tenant";
+
+    const string_view message("");
+    const attribute_list a{{"tenant", "a"}};
+    const attribute_list b{{"tenant", "b"}};
+    const attribute_pack pa{a};
+    const attribute_pack pb{b};
+
+    {
+        balanced_t sink({
+            {"127.0.0.1", first.local_endpoint().port()},
+            {"127.0.0.1", second.local_endpoint().port()}
+        }, balancing, factory(framing_t::newline));
+
+        for (int id = 0; id < 8; ++id) {
+            sink.emit(record_t(0, message, id % 2 == 0 ? pa : pb), id % 2 == 0 ? "a" : "b");
+        }
+    }
+
+    const std::string received[] = {drain(io_service, first), drain(io_service, second)};
+
+    // Each value is written in whole into one of collectors, whichever the hash chose.
+    for (auto value : {'a', 'b'}) {
+        const auto count = std::count(received[0].begin(), received[0].end(), value);
+        EXPECT_TRUE(count == 0 || count == 4);
+        EXPECT_EQ(4, count + std::count(received[1].begin(), received[1].end(), value));
+    }
+}
+
+TEST(balanced_t, ThrowsOnHashWithoutAttribute) {
+    balancing_t balancing;
+    balancing.strategy = balancing_t::strategy_t::hash;
+
+    EXPECT_THROW(balanced_t({{"127.0.0.1", 20000}}, balancing, factory(framing_t::none)),
+        std::invalid_argument);
+}
+
 }  // namespace
 }  // namespace socket
 
@@ -89,6 +741,10 @@ TEST(tcp_t, FactoryType) {
 TEST(tcp_t, FactoryThrowsIfHostParameterIsMissing) {
     StrictMock<config::testing::mock::node_t> config;
 
+    EXPECT_CALL(config, subscript_key("endpoints"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
     EXPECT_CALL(config, subscript_key("host"))
         .Times(1)
         .WillOnce(Return(nullptr));
@@ -106,6 +762,10 @@ TEST(tcp_t, FactoryThrowsIfPortParameterIsMissing) {
     StrictMock<node_t> config;
 
     auto n1 = new node_t;
+    EXPECT_CALL(config, subscript_key("endpoints"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
     EXPECT_CALL(config, subscript_key("host"))
         .Times(1)
         .WillOnce(Return(n1));
@@ -131,6 +791,10 @@ TEST(tcp_t, FactoryConfig) {
     StrictMock<node_t> config;
 
     auto n1 = new node_t;
+    EXPECT_CALL(config, subscript_key("endpoints"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
     EXPECT_CALL(config, subscript_key("host"))
         .Times(1)
         .WillOnce(Return(n1));
@@ -148,11 +812,33 @@ TEST(tcp_t, FactoryConfig) {
         .Times(1)
         .WillOnce(Return(20000));
 
+    EXPECT_CALL(config, subscript_key("framing"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
+    EXPECT_CALL(config, subscript_key("tls"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
+    EXPECT_CALL(config, subscript_key("compression"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
+    EXPECT_CALL(config, subscript_key("nonblocking"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
+    EXPECT_CALL(config, subscript_key("balancing"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
     const auto sink = factory<tcp_t>(mock_registry_t()).from(config);
     const auto& cast = dynamic_cast<const tcp_t&>(*sink);
 
     EXPECT_EQ("0.0.0.0", cast.host());
     EXPECT_EQ(20000, cast.port());
+    EXPECT_FALSE(cast.secure());
+    EXPECT_FALSE(cast.compressed());
 }
 
 }  // namespace
@@ -1,3 +1,8 @@
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
@@ -49,6 +54,185 @@ TEST(udp_t, SendsData) {
     EXPECT_EQ('}', buffer[1]);
 }
 
+TEST(udp_t, SendsDataConnected) {
+    boost::asio::io_service io_service;
+    boost::asio::ip::udp::socket socket(io_service,
+        boost::asio::ip::udp::endpoint(boost::asio::ip::udp::v4(), 0));
+    const auto endpoint = socket.local_endpoint();
+
+    udp_t::options_t options;
+    options.connect = true;
+    udp_t sink(endpoint.address().to_string(), endpoint.port(), options);
+
+    const string_view message("");
+    const attribute_pack pack;
+    const record_t record(0, message, pack);
+
+    sink.emit(record, "{}");
+
+    boost::array<char, 2> buffer;
+    boost::asio::ip::udp::endpoint remote;
+    socket.receive_from(boost::asio::buffer(buffer), remote, 0);
+
+    EXPECT_EQ('{', buffer[0]);
+    EXPECT_EQ('}', buffer[1]);
+}
+
+#ifdef __linux__
+TEST(udp_t, ConnectedSurfacesUnreachablePort) {
+    std::uint16_t port;
+    {
+        boost::asio::io_service io_service;
+        boost::asio::ip::udp::socket socket(io_service,
+            boost::asio::ip::udp::endpoint(boost::asio::ip::address_v4::loopback(), 0));
+        port = socket.local_endpoint().port();
+    }
+
+    udp_t::options_t options;
+    options.connect = true;
+    udp_t sink("127.0.0.1", port, options);
+
+    const string_view message("");
+    const attribute_pack pack;
+    const record_t record(0, message, pack);
+
+    // The first datagram triggers an ICMP port unreachable, which is reported on the next send.
+    sink.emit(record, "{}");
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    EXPECT_THROW(sink.emit(record, "{}"), boost::system::system_error);
+}
+#endif
+
+TEST(udp_t, SendsDataWhileResolvingPeriodically) {
+    boost::asio::io_service io_service;
+    boost::asio::ip::udp::socket socket(io_service,
+        boost::asio::ip::udp::endpoint(boost::asio::ip::address_v4::loopback(), 0));
+    const auto endpoint = socket.local_endpoint();
+
+    udp_t::options_t options;
+    options.connect = true;
+    options.resolve = std::chrono::seconds(1);
+    udp_t sink("localhost", endpoint.port(), options);
+
+    const string_view message("");
+    const attribute_pack pack;
+    const record_t record(0, message, pack);
+
+    // Spans at least one resolution round.
+    for (int id = 0; id < 3; ++id) {
+        sink.emit(record, "{}");
+
+        boost::array<char, 2> buffer;
+        boost::asio::ip::udp::endpoint remote;
+        socket.receive_from(boost::asio::buffer(buffer), remote, 0);
+
+        EXPECT_EQ('{', buffer[0]);
+        EXPECT_EQ('}', buffer[1]);
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(600));
+    }
+
+    EXPECT_EQ(endpoint, sink.endpoint());
+}
+
+TEST(udp_t, SendsBatch) {
+    boost::asio::io_service io_service;
+    boost::asio::ip::udp::socket socket(io_service,
+        boost::asio::ip::udp::endpoint(boost::asio::ip::udp::v4(), 0));
+    const auto endpoint = socket.local_endpoint();
+
+    udp_t sink(endpoint.address().to_string(), endpoint.port());
+
+    const string_view message("");
+    const attribute_pack pack;
+    const record_t record(0, message, pack);
+
+    const string_view messages[] = {"#1", "#22"};
+    const sink_t::event_t events[] = {{&record, &messages[0]}, {&record, &messages[1]}};
+
+    sink.emit_batch(events, 2);
+
+    boost::array<char, 8> buffer;
+    boost::asio::ip::udp::endpoint remote;
+
+    auto nread = socket.receive_from(boost::asio::buffer(buffer), remote, 0);
+    EXPECT_EQ("#1", std::string(buffer.data(), nread));
+
+    nread = socket.receive_from(boost::asio::buffer(buffer), remote, 0);
+    EXPECT_EQ("#22", std::string(buffer.data(), nread));
+}
+
+TEST(udp_t, SendsLargeBatchInChunks) {
+    boost::asio::io_service io_service;
+    boost::asio::ip::udp::socket socket(io_service,
+        boost::asio::ip::udp::endpoint(boost::asio::ip::udp::v4(), 0));
+    const auto endpoint = socket.local_endpoint();
+
+    udp_t sink(endpoint.address().to_string(), endpoint.port());
+
+    const string_view message("");
+    const attribute_pack pack;
+    const record_t record(0, message, pack);
+
+    std::vector<std::string> messages;
+    for (int id = 0; id < 150; ++id) {
+        messages.push_back("#" + std::to_string(id));
+    }
+
+    std::vector<string_view> views(messages.begin(), messages.end());
+    std::vector<sink_t::event_t> events;
+    for (const auto& view : views) {
+        events.push_back({&record, &view});
+    }
+
+    sink.emit_batch(events.data(), events.size());
+
+    boost::array<char, 8> buffer;
+    boost::asio::ip::udp::endpoint remote;
+
+    for (const auto& expected : messages) {
+        const auto nread = socket.receive_from(boost::asio::buffer(buffer), remote, 0);
+        EXPECT_EQ(expected, std::string(buffer.data(), nread));
+    }
+}
+
+TEST(udp_t, PacksBatchUpToMtu) {
+    boost::asio::io_service io_service;
+    boost::asio::ip::udp::socket socket(io_service,
+        boost::asio::ip::udp::endpoint(boost::asio::ip::udp::v4(), 0));
+    const auto endpoint = socket.local_endpoint();
+
+    udp_t sink(endpoint.address().to_string(), endpoint.port(), 8);
+
+    const string_view message("");
+    const attribute_pack pack;
+    const record_t record(0, message, pack);
+
+    const string_view messages[] = {"#1", "#22", "#333", "#123456789"};
+    const sink_t::event_t events[] = {
+        {&record, &messages[0]},
+        {&record, &messages[1]},
+        {&record, &messages[2]},
+        {&record, &messages[3]}
+    };
+
+    sink.emit_batch(events, 4);
+
+    boost::array<char, 16> buffer;
+    boost::asio::ip::udp::endpoint remote;
+
+    auto nread = socket.receive_from(boost::asio::buffer(buffer), remote, 0);
+    EXPECT_EQ("#1\n#22", std::string(buffer.data(), nread));
+
+    nread = socket.receive_from(boost::asio::buffer(buffer), remote, 0);
+    EXPECT_EQ("#333", std::string(buffer.data(), nread));
+
+    // Messages larger than MTU are sent as is.
+    nread = socket.receive_from(boost::asio::buffer(buffer), remote, 0);
+    EXPECT_EQ("#123456789", std::string(buffer.data(), nread));
+}
+
 TEST(udp_t, FactoryType) {
     EXPECT_EQ(std::string("udp"), factory<udp_t>(mock_registry_t()).type());
 }
@@ -115,6 +299,18 @@ TEST(udp_t, FactoryConfig) {
         .Times(1)
         .WillOnce(Return(20000));
 
+    EXPECT_CALL(config, subscript_key("mtu"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
+    EXPECT_CALL(config, subscript_key("connect"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
+    EXPECT_CALL(config, subscript_key("resolve"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
     const auto sink = factory<udp_t>(mock_registry_t()).from(config);
     const auto& cast = dynamic_cast<const udp_t&>(*sink);
 
@@ -0,0 +1,317 @@
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <system_error>
+#include <thread>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <blackhole/attribute.hpp>
+#include <blackhole/record.hpp>
+#include <blackhole/sink/socket/unix.hpp>
+#include <src/sink/socket/unix.hpp>
+
+#include "mocks/node.hpp"
+#include "mocks/registry.hpp"
+
+namespace blackhole {
+inline namespace v1 {
+namespace sink {
+namespace socket {
+namespace {
+
+using ::testing::Return;
+using ::testing::StrictMock;
+
+/// Listening socket of the given type bound to a unique path, removed on destruction.
+class listener_t {
+public:
+    const std::string path;
+    const bool abstract;
+    int fd;
+
+    explicit listener_t(int type, bool abstract = false) :
+        path(unique()),
+        abstract(abstract),
+        fd(::socket(AF_UNIX, type, 0))
+    {
+        ::sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        std::memcpy(address.sun_path + (abstract ? 1 : 0), path.data(), path.size());
+
+        const auto length =
+            static_cast<::socklen_t>(offsetof(::sockaddr_un, sun_path) + path.size() + 1);
+
+        if (::bind(fd, reinterpret_cast<const ::sockaddr*>(&address), length) != 0) {
+            throw std::system_error(errno, std::system_category(), "failed to bind");
+        }
+
+        if (type != SOCK_DGRAM && ::listen(fd, 1) != 0) {
+            throw std::system_error(errno, std::system_category(), "failed to listen");
+        }
+    }
+
+    ~listener_t() {
+        ::close(fd);
+
+        if (!abstract) {
+            ::unlink(path.c_str());
+        }
+    }
+
+    auto accept() -> int {
+        return ::accept(fd, nullptr, nullptr);
+    }
+
+    /// Reads exactly the given number of bytes from the stream socket.
+    static auto read(int fd, std::size_t size) -> std::string {
+        std::string result(size, '\0');
+
+        for (std::size_t nread = 0; nread < size;) {
+            const auto rc = ::recv(fd, &result[nread], size - nread, 0);
+            if (rc <= 0) {
+                return result.substr(0, nread);
+            }
+
+            nread += static_cast<std::size_t>(rc);
+        }
+
+        return result;
+    }
+
+    /// Receives a single message.
+    static auto receive(int fd) -> std::string {
+        char buffer[1024];
+        const auto rc = ::recv(fd, buffer, sizeof(buffer), 0);
+        return std::string(buffer, rc < 0 ? 0 : static_cast<std::size_t>(rc));
+    }
+
+private:
+    static auto unique() -> std::string {
+        static int counter = 0;
+        return "/tmp/blackhole-test-" + std::to_string(::getpid()) + "-" +
+            std::to_string(++counter) + ".sock";
+    }
+};
+
+auto options(unix_t::type_t type, framing_t framing = framing_t::none) -> unix_t::options_t {
+    unix_t::options_t result;
+    result.type = type;
+    result.framing = framing;
+    return result;
+}
+
+TEST(unix, Path) {
+    EXPECT_EQ("/tmp/log.sock", unix_t("/tmp/log.sock").path());
+}
+
+TEST(unix, ThrowsOnEmptyPath) {
+    EXPECT_THROW(unix_t(""), std::invalid_argument);
+}
+
+TEST(unix, ThrowsOnTooLongPath) {
+    EXPECT_THROW(unix_t(std::string(sizeof(::sockaddr_un::sun_path), 'x')),
+        std::invalid_argument);
+}
+
+TEST(unix, ThrowsOnFramingMessages) {
+    EXPECT_THROW(unix_t("/tmp/log.sock", options(unix_t::type_t::datagram, framing_t::newline)),
+        std::invalid_argument);
+}
+
+TEST(unix, SendsData) {
+    listener_t listener(SOCK_STREAM);
+    unix_t sink(listener.path);
+
+    const string_view message("");
+    const attribute_pack pack;
+    const record_t record(0, message, pack);
+
+    sink.emit(record, "{}");
+
+    const auto fd = listener.accept();
+    EXPECT_EQ("{}", listener_t::read(fd, 2));
+    ::close(fd);
+}
+
+TEST(unix, FramesBatchWithLengthPrefix) {
+    listener_t listener(SOCK_STREAM);
+    unix_t sink(listener.path, options(unix_t::type_t::stream, framing_t::length));
+
+    const string_view message("");
+    const attribute_pack pack;
+    const record_t record(0, message, pack);
+
+    const string_view m1("{}");
+    const string_view m2("[1]");
+    const sink_t::event_t events[] = {{&record, &m1}, {&record, &m2}};
+
+    sink.emit_batch(events, 2);
+
+    const auto fd = listener.accept();
+    EXPECT_EQ(std::string("\0\0\0\x02{}\0\0\0\x03[1]", 13), listener_t::read(fd, 13));
+    ::close(fd);
+}
+
+TEST(unix, SendsBatchAsDatagrams) {
+    listener_t listener(SOCK_DGRAM);
+    unix_t sink(listener.path, options(unix_t::type_t::datagram));
+
+    const string_view message("");
+    const attribute_pack pack;
+    const record_t record(0, message, pack);
+
+    const string_view m1("{}");
+    const string_view m2("[1]");
+    const sink_t::event_t events[] = {{&record, &m1}, {&record, &m2}};
+
+    sink.emit_batch(events, 2);
+
+    EXPECT_EQ("{}", listener_t::receive(listener.fd));
+    EXPECT_EQ("[1]", listener_t::receive(listener.fd));
+}
+
+TEST(unix, SendsSequencedPackets) {
+    listener_t listener(SOCK_SEQPACKET);
+    unix_t sink(listener.path, options(unix_t::type_t::seqpacket));
+
+    const string_view message("");
+    const attribute_pack pack;
+    const record_t record(0, message, pack);
+
+    sink.emit(record, "{}");
+    sink.emit(record, "[1]");
+
+    const auto fd = listener.accept();
+    EXPECT_EQ("{}", listener_t::receive(fd));
+    EXPECT_EQ("[1]", listener_t::receive(fd));
+    ::close(fd);
+}
+
+#ifdef __linux__
+TEST(unix, SendsIntoAbstractNamespace) {
+    listener_t listener(SOCK_DGRAM, true);
+
+    auto opts = options(unix_t::type_t::datagram);
+    opts.abstract = true;
+    unix_t sink(listener.path, opts);
+
+    const string_view message("");
+    const attribute_pack pack;
+    const record_t record(0, message, pack);
+
+    sink.emit(record, "{}");
+
+    EXPECT_EQ("{}", listener_t::receive(listener.fd));
+}
+#endif
+
+TEST(unix, ThrowsExceptionOnConnectionRefused) {
+    unix_t sink("/tmp/blackhole-test-missing.sock");
+
+    const string_view message("");
+    const attribute_pack pack;
+    const record_t record(0, message, pack);
+
+    EXPECT_THROW(sink.emit(record, "{}"), std::system_error);
+}
+
+TEST(unix, NonBlockingSendsData) {
+    listener_t listener(SOCK_STREAM);
+    unix_t sink(listener.path, options(unix_t::type_t::stream, framing_t::newline),
+        {1024, nonblocking_t::overflow_t::wait});
+
+    const string_view message("");
+    const attribute_pack pack;
+    const record_t record(0, message, pack);
+
+    sink.emit(record, "{}");
+    sink.emit(record, "[]");
+
+    const auto fd = listener.accept();
+    EXPECT_EQ("{}\n[]\n", listener_t::read(fd, 6));
+    ::close(fd);
+}
+
+TEST(unix, NonBlockingDropsOnOverflow) {
+    unix_t sink("/tmp/blackhole-test-missing.sock", unix_t::options_t(),
+        {4, nonblocking_t::overflow_t::drop});
+
+    const string_view message("");
+    const attribute_pack pack;
+    const record_t record(0, message, pack);
+
+    sink.emit(record, "{}");
+    sink.emit(record, "[]");
+    sink.emit(record, "()");
+
+    EXPECT_EQ(1, sink.dropped());
+}
+
+TEST(unix_t, FactoryType) {
+    EXPECT_EQ(std::string("unix"), factory<unix_t>(mock_registry_t()).type());
+}
+
+TEST(unix_t, FactoryThrowsIfPathParameterIsMissing) {
+    StrictMock<config::testing::mock::node_t> config;
+
+    EXPECT_CALL(config, subscript_key("path"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
+    EXPECT_THROW(factory<unix_t>(mock_registry_t()).from(config), std::invalid_argument);
+}
+
+TEST(unix_t, FactoryConfig) {
+    using config::testing::mock::node_t;
+
+    StrictMock<node_t> config;
+
+    auto n1 = new node_t;
+    EXPECT_CALL(config, subscript_key("path"))
+        .Times(1)
+        .WillOnce(Return(n1));
+
+    EXPECT_CALL(*n1, to_string())
+        .Times(1)
+        .WillOnce(Return("/dev/log"));
+
+    auto n2 = new node_t;
+    EXPECT_CALL(config, subscript_key("socket"))
+        .Times(1)
+        .WillOnce(Return(n2));
+
+    EXPECT_CALL(*n2, to_string())
+        .Times(1)
+        .WillOnce(Return("datagram"));
+
+    EXPECT_CALL(config, subscript_key("abstract"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
+    EXPECT_CALL(config, subscript_key("framing"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
+    EXPECT_CALL(config, subscript_key("nonblocking"))
+        .Times(1)
+        .WillOnce(Return(nullptr));
+
+    const auto sink = factory<unix_t>(mock_registry_t()).from(config);
+    const auto& cast = dynamic_cast<const unix_t&>(*sink);
+
+    EXPECT_EQ("/dev/log", cast.path());
+    EXPECT_EQ(unix_t::type_t::datagram, cast.type());
+    EXPECT_FALSE(cast.abstract());
+}
+
+}  // namespace
+}  // namespace socket
+}  // namespace sink
+}  // namespace v1
+}  // namespace blackhole
@@ -1,3 +1,5 @@
+#include <unordered_map>
+
 #include <gtest/gtest.h>
 
 #include <blackhole/stdext/string_view.hpp>
@@ -12,6 +14,23 @@ TEST(string_view, CompareWithString) {
     EXPECT_EQ(std::string("message"), string_view("message"));
 }
 
+TEST(string_view, HashEqualForEqualViews) {
+    const std::string value("message");
+    const std::hash<string_view> hash;
+
+    EXPECT_EQ(hash(string_view("message")), hash(string_view(value)));
+    EXPECT_NE(hash(string_view("message")), hash(string_view("massage")));
+}
+
+TEST(string_view, UnorderedMapKey) {
+    const std::string key("message");
+    std::unordered_map<string_view, int> map{{string_view(key), 42}};
+
+    ASSERT_EQ(1, map.count(string_view("message")));
+    EXPECT_EQ(42, map[string_view("message")]);
+    EXPECT_EQ(0, map.count(string_view("messag")));
+}
+
 }  // namespace
 }  // namespace stdext
 }  // namespace v1
@@ -18,6 +18,7 @@
 namespace blackhole {
 namespace testing {
 
+using ::testing::An;
 using ::testing::AtLeast;
 using ::testing::Invoke;
 using ::testing::Return;
@@ -41,6 +42,53 @@ TEST(Wrapper, Constructor) {
     EXPECT_EQ(expected, wrapper.attributes());
 }
 
+TEST(Wrapper, ConstructorFromOwnedAttributes) {
+    mock::logger_t logger;
+
+    const std::string value(64, 'x');
+    const attributes_t attributes{
+        {"key#0", {0}},
+        {"key#1", {value}}
+    };
+
+    wrapper_t wrapper(logger, attributes);
+
+    const view_of<attributes_t>::type expected = {
+        {"key#0", {0}},
+        {"key#1", {value}}
+    };
+
+    EXPECT_EQ(expected, wrapper.attributes());
+}
+
+TEST(Wrapper, ComposesNestedWrappers) {
+    mock::logger_t logger;
+
+    wrapper_t wrapper1(logger, {{"key#0", {0}}});
+    wrapper_t wrapper2(wrapper1, {{"key#1", {"value#1"}}});
+
+    const view_of<attributes_t>::type expected = {
+        {"key#1", {"value#1"}},
+        {"key#0", {0}}
+    };
+
+    EXPECT_EQ(expected, wrapper2.attributes());
+
+    attribute_pack actual;
+
+    EXPECT_CALL(logger, log(severity_t(0), An<const message_t&>(), _))
+        .Times(1)
+        .WillOnce(SaveArg<2>(&actual));
+
+    const attribute_list attributes{{"key#2", {42}}};
+    attribute_pack pack{attributes};
+    wrapper2.log(0, message_t("-"), pack);
+
+    ASSERT_EQ(2, actual.size());
+    EXPECT_EQ(&attributes, &actual[0].get());
+    EXPECT_EQ(expected, actual[1].get());
+}
+
 TEST(wrapper_t, DelegatesScopeManager) {
     mock::scope::manager_t manager;
 
@@ -70,5 +118,60 @@ TEST(wrapper_t, DelegatesScopeManager) {
     const scope::holder_t scoped(wrapper, {});
 }
 
+TEST(compact_wrapper_t, Constructor) {
+    mock::logger_t logger;
+
+    const std::string value(64, 'x');
+    compact_wrapper_t wrapper(logger, attributes_t{{"key#0", {0}}, {"key#1", {value}}});
+
+    const view_of<attributes_t>::type expected = {
+        {"key#0", {0}},
+        {"key#1", {value}}
+    };
+
+    EXPECT_EQ(expected, wrapper.attributes().attributes());
+}
+
+TEST(compact_wrapper_t, SharesParentBlock) {
+    mock::logger_t logger;
+
+    compact_wrapper_t parent(logger, {{"service", {"storage"}}});
+    compact_wrapper_t wrapper1(parent, {{"id", {1}}});
+    compact_wrapper_t wrapper2(parent, {{"id", {2}}});
+
+    EXPECT_EQ(parent.attributes().capacity(), wrapper1.attributes().parent().capacity());
+    EXPECT_EQ(parent.attributes().attributes()[0].first.data(),
+        wrapper2.attributes().attributes()[1].first.data());
+}
+
+TEST(compact_wrapper_t, ForwardsComposedAttributes) {
+    mock::logger_t logger;
+
+    compact_wrapper_t wrapper1(logger, {{"key#0", {0}}});
+    compact_wrapper_t wrapper2(wrapper1, {{"key#1", {"value#1"}}});
+
+    const view_of<attributes_t>::type expected = {
+        {"key#1", {"value#1"}},
+        {"key#0", {0}}
+    };
+
+    const attribute_list attributes{{"key#2", {42}}};
+
+    EXPECT_CALL(logger, log(severity_t(0), An<const message_t&>(), _))
+        .Times(1)
+        .WillOnce(Invoke([&](severity_t, const message_t&, attribute_pack& pack) {
+            ASSERT_EQ(2, pack.size());
+            EXPECT_EQ(&attributes, &pack[0].get());
+            EXPECT_EQ(expected, pack[1].get());
+        }));
+
+    attribute_pack pack{attributes};
+    wrapper2.log(0, message_t("-"), pack);
+}
+
+TEST(compact_wrapper_t, IsSmallerThanWrapper) {
+    EXPECT_LT(sizeof(compact_wrapper_t) * 10, sizeof(wrapper_t));
+}
+
 }  // namespace testing
 }  // namespace blackhole
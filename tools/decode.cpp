@@ -0,0 +1,122 @@
+/// Decodes files of records written by the binary formatter in parallel, printing them formatted
+/// by the formatter of the given JSON config.
+///
+/// The config is either a formatter object, like `{"type": "string", "pattern": "{message}"}`, or
+/// a logger config, whose formatter of the first handler of the given logger is used, so records
+/// are formatted offline exactly like production loggers would format them.
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include <boost/optional/optional.hpp>
+
+#include <blackhole/config/json.hpp>
+#include <blackhole/config/node.hpp>
+#include <blackhole/config/option.hpp>
+#include <blackhole/decoder.hpp>
+#include <blackhole/formatter.hpp>
+#include <blackhole/registry.hpp>
+
+namespace blackhole {
+inline namespace v1 {
+namespace {
+
+auto run(const std::string& path, const std::string& logger, std::size_t threads,
+    const std::vector<std::string>& filenames) -> int
+{
+    std::ifstream stream(path);
+    if (!stream) {
+        throw std::invalid_argument("failed to open config " + path);
+    }
+
+    const auto factory = config::factory_traits<config::json_t>::construct(stream);
+    const auto& config = factory->config();
+
+    // Keeps the logger formatter node alive.
+    const auto formatter = config[logger][0]["formatter"];
+
+    const config::node_t* node = &config;
+    if (!config["type"]) {
+        if (!formatter) {
+            throw std::invalid_argument("no formatter configured for logger '" + logger + "'");
+        }
+
+        node = &formatter.unwrap().get();
+    }
+
+    const auto type = (*node)["type"].to_string();
+    if (!type) {
+        throw std::invalid_argument("formatter requires 'type' field");
+    }
+
+    const auto registry = registry::configured();
+    const auto construct = registry->formatter(type.get());
+
+    decoder_t::options_t options;
+    options.threads = threads;
+
+    decoder_t::stats_t total{0, 0};
+    for (const auto& filename : filenames) {
+        const decoder_t decoder(filename);
+        const auto stats = decoder.decode([&] {
+            return construct(*node);
+        }, [](const string_view& data) {
+            std::fwrite(data.data(), 1, data.size(), stdout);
+        }, options);
+
+        total.records += stats.records;
+        total.skipped += stats.skipped;
+    }
+
+    std::fflush(stdout);
+
+    if (total.skipped > 0) {
+        std::cerr << "decode: " << total.records << " records decoded, " << total.skipped
+                  << " malformed bytes skipped" << std::endl;
+    }
+
+    return 0;
+}
+
+}  // namespace
+}  // namespace v1
+}  // namespace blackhole
+
+auto main(int argc, char** argv) -> int {
+    std::string logger = "root";
+    std::size_t threads = 0;
+
+    int option;
+    while ((option = ::getopt(argc, argv, "j:l:")) != -1) {
+        switch (option) {
+        case 'j':
+            threads = static_cast<std::size_t>(std::strtoul(optarg, nullptr, 10));
+            break;
+        case 'l':
+            logger = optarg;
+            break;
+        default:
+            argc = 0;
+        }
+    }
+
+    if (argc - optind < 2) {
+        std::cerr << "Usage: blackhole-decode [-j THREADS] [-l LOGGER] CONFIG FILE..." << std::endl;
+        return 1;
+    }
+
+    try {
+        return blackhole::run(argv[optind], logger, threads,
+            std::vector<std::string>(argv + optind + 1, argv + argc));
+    } catch (const std::exception& err) {
+        std::cerr << "decode: " << err.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,42 @@
+/// Merges files written by the file sink in isolated mode into a single stream ordered by line
+/// timestamps, which is printed to the standard output.
+///
+/// Given a single destination path, like `app.log`, merges all its per-thread files, like
+/// `app.<tid>.log`, otherwise merges the given files. Lines are compared as a whole, so they must
+/// start with fixed-width timestamps.
+#include <exception>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <blackhole/sink/file/merge.hpp>
+
+namespace blackhole {
+inline namespace v1 {
+namespace {
+
+auto run(const std::vector<std::string>& paths) -> int {
+    const auto files = paths.size() == 1 ? sink::file::isolated(paths.front()) : paths;
+
+    sink::file::merge(files, std::cout);
+    std::cout.flush();
+    return 0;
+}
+
+}  // namespace
+}  // namespace v1
+}  // namespace blackhole
+
+auto main(int argc, char** argv) -> int {
+    if (argc < 2) {
+        std::cerr << "Usage: blackhole-merge PATH | FILE FILE..." << std::endl;
+        return 1;
+    }
+
+    try {
+        return blackhole::run(std::vector<std::string>(argv + 1, argv + argc));
+    } catch (const std::exception& err) {
+        std::cerr << "merge: " << err.what() << std::endl;
+        return 1;
+    }
+}
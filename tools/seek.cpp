@@ -0,0 +1,90 @@
+/// Prints lines of a file written by the file sink with the time index enabled, which belong to
+/// the given time window, seeking directly to them using the index.
+///
+/// Times are either seconds since the epoch, possibly fractional, or UTC dates, like
+/// `2016-07-18T15:30:00`. The output is a superset of the window bounded by index entries, so
+/// lines slightly outside of it may be printed too, while the end defaults to the end of file.
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <ctime>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+#include <blackhole/detail/sink/file/index.hpp>
+
+namespace blackhole {
+inline namespace v1 {
+namespace {
+
+typedef sink::file::index_t index_t;
+
+auto parse(const std::string& value) -> index_t::time_point {
+    std::tm tm{};
+    const auto end = ::strptime(value.c_str(), "%Y-%m-%dT%H:%M:%S", &tm);
+
+    if (end != nullptr && (*end == '\0' || (end[0] == 'Z' && end[1] == '\0'))) {
+        return index_t::time_point(std::chrono::seconds(::timegm(&tm)));
+    }
+
+    char* tail = nullptr;
+    const auto seconds = std::strtod(value.c_str(), &tail);
+
+    if (tail == value.c_str() || *tail != '\0' || seconds < 0) {
+        throw std::invalid_argument("malformed time " + value);
+    }
+
+    return index_t::time_point(std::chrono::duration_cast<index_t::time_point::duration>(
+        std::chrono::duration<double>(seconds)));
+}
+
+auto run(const std::string& filename, const std::string& from, const std::string* until) -> int {
+    const auto entries = index_t::read(filename);
+
+    const auto begin = index_t::begin(entries, parse(from));
+    const auto end = until ? index_t::end(entries, parse(*until))
+                           : std::numeric_limits<std::uint64_t>::max();
+
+    std::ifstream stream(filename, std::ios_base::binary);
+    if (!stream) {
+        throw std::invalid_argument("failed to open " + filename);
+    }
+
+    stream.seekg(static_cast<std::streamoff>(begin));
+
+    char buffer[64 * 1024];
+    for (auto left = end - begin; left > 0 && stream;) {
+        const auto size = left < sizeof(buffer) ? left : sizeof(buffer);
+        stream.read(buffer, static_cast<std::streamsize>(size));
+
+        const auto nread = static_cast<std::uint64_t>(stream.gcount());
+        std::cout.write(buffer, static_cast<std::streamsize>(nread));
+        left -= nread;
+    }
+
+    std::cout.flush();
+    return 0;
+}
+
+}  // namespace
+}  // namespace v1
+}  // namespace blackhole
+
+auto main(int argc, char** argv) -> int {
+    if (argc != 3 && argc != 4) {
+        std::cerr << "Usage: blackhole-seek FILE FROM [UNTIL]" << std::endl;
+        return 1;
+    }
+
+    try {
+        const std::string until = argc == 4 ? argv[3] : "";
+        return blackhole::run(argv[1], argv[2], argc == 4 ? &until : nullptr);
+    } catch (const std::exception& err) {
+        std::cerr << "seek: " << err.what() << std::endl;
+        return 1;
+    }
+}